@@ -6,6 +6,7 @@
  */
 
 #include <syslog.h>
+#include <algorithm>
 #include <fstream>
 #include <stdexcept>
 
@@ -32,6 +33,8 @@
 #include <openr/common/BuildInfo.h>
 #include <openr/common/Constants.h>
 #include <openr/common/Flags.h>
+#include <openr/common/MemoryAccounting.h>
+#include <openr/common/StartupTimeline.h>
 #include <openr/common/ThriftUtil.h>
 #include <openr/common/Util.h>
 #include <openr/config-store/PersistentStore.h>
@@ -59,6 +62,7 @@ using namespace folly::gen;
 
 using apache::thrift::concurrency::ThreadManager;
 using openr::messaging::ReplicateQueue;
+using openr::messaging::RWQueueOptions;
 
 namespace {
 //
@@ -114,13 +118,15 @@ waitForFibService(const fbzmq::ZmqEventLoop& evl, int port) {
 
 /**
  * Start an EventBase in a thread, maintain order of thread creation and
- * returns raw pointer of Derived class.
+ * returns raw pointer of Derived class. Doesn't wait for the event base to
+ * run, so that modules start in parallel of construction of the next ones.
  */
 template <typename T>
 T*
 startEventBase(
     std::vector<std::thread>& allThreads,
     std::vector<std::unique_ptr<OpenrEventBase>>& orderedEvbs,
+    const Config& config,
     Watchdog* watchdog,
     const std::string& name,
     std::unique_ptr<T> evbT) {
@@ -130,13 +136,23 @@ startEventBase(
       reinterpret_cast<OpenrEventBase*>(evbT.release()));
 
   // Start a thread
-  allThreads.emplace_back(std::thread([evb = evb.get(), name]() noexcept {
-    LOG(INFO) << "Starting " << name << " thread ...";
-    folly::setThreadName(name);
-    evb->run();
-    LOG(INFO) << name << " thread got stopped.";
-  }));
-  evb->waitUntilRunning();
+  auto scheduling = config.getThreadSchedulingConfig(name);
+  allThreads.emplace_back(
+      std::thread([evb = evb.get(), name, scheduling]() noexcept {
+        LOG(INFO) << "Starting " << name << " thread ...";
+        folly::setThreadName(name);
+        bindThreadToModuleArena(name);
+        if (scheduling.has_value()) {
+          applyThreadScheduling(name, *scheduling);
+        }
+        evb->run();
+        LOG(INFO) << name << " thread got stopped.";
+      }));
+
+  // Module is constructed by now
+  std::string event = name + "_initialized";
+  std::transform(event.begin(), event.end(), event.begin(), ::tolower);
+  StartupTimeline::get().record(event);
 
   // Add to watchdog
   if (watchdog) {
@@ -152,6 +168,9 @@ startEventBase(
 
 int
 main(int argc, char** argv) {
+  // Start timeline of startup phases
+  auto& startupTimeline = StartupTimeline::get();
+
   // Register the signals to handle before anything else. This guarantees that
   // any threads created below will inherit the signal mask
   ZmqEventLoop mainEventLoop;
@@ -205,6 +224,7 @@ main(int argc, char** argv) {
     config = GflagConfig::createConfigFromGflag();
   }
   LOG(INFO) << config->getRunningConfig();
+  startupTimeline.record("config_loaded");
 
   // Sanity checks on Segment Routing labels
   const int32_t maxLabel = Constants::kMaxSrLabel;
@@ -239,14 +259,37 @@ main(int argc, char** argv) {
   // Set main thread name
   folly::setThreadName("openr");
 
-  // Queue for inter-module communication
-  ReplicateQueue<openr::thrift::RouteDatabaseDelta> routeUpdatesQueue;
-  ReplicateQueue<openr::thrift::InterfaceDatabase> interfaceUpdatesQueue;
-  ReplicateQueue<openr::thrift::SparkNeighborEvent> neighborUpdatesQueue;
-  ReplicateQueue<openr::thrift::PrefixUpdateRequest> prefixUpdateRequestQueue;
-  ReplicateQueue<openr::thrift::Publication> kvStoreUpdatesQueue;
-  ReplicateQueue<openr::thrift::PeerUpdateRequest> peerUpdatesQueue;
-  ReplicateQueue<openr::thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
+  // Module threads allocate from arenas of their own
+  if (FLAGS_enable_module_arenas) {
+    enableModuleArenas();
+  }
+
+  // Queue for inter-module communication. Every reader of the queue exports
+  // depth and latency counters with prefix `messaging.<queue>.<reader>`
+  auto getQueueOptions = [](std::string const& name) {
+    return RWQueueOptions{
+        0 /* unbounded */, "messaging." + name, Constants::kQueueSoftLimit};
+  };
+  ReplicateQueue<openr::thrift::RouteDatabaseDelta> routeUpdatesQueue(
+      getQueueOptions("route_updates"));
+  ReplicateQueue<openr::thrift::InterfaceDatabase> interfaceUpdatesQueue(
+      getQueueOptions("interface_updates"));
+  ReplicateQueue<openr::thrift::SparkNeighborEvent> neighborUpdatesQueue(
+      getQueueOptions("neighbor_updates"));
+  ReplicateQueue<openr::thrift::PrefixUpdateRequest> prefixUpdateRequestQueue(
+      getQueueOptions("prefix_updates"));
+  ReplicateQueue<openr::KvStorePublication> kvStoreUpdatesQueue(
+      getQueueOptions("kvstore_updates"));
+  ReplicateQueue<openr::thrift::PeerUpdateRequest> peerUpdatesQueue(
+      getQueueOptions("peer_updates"));
+  ReplicateQueue<openr::thrift::RouteDatabaseDelta> staticRoutesUpdateQueue(
+      getQueueOptions("static_routes_updates"));
+  ReplicateQueue<openr::thrift::RouteDatabaseDelta> fibUpdatesQueue(
+      getQueueOptions("fib_updates"));
+  ReplicateQueue<openr::thrift::DecisionDbsDelta> decisionDbsUpdatesQueue(
+      getQueueOptions("decision_dbs_updates"));
+  ReplicateQueue<std::shared_ptr<const Config>> configUpdatesQueue(
+      getQueueOptions("config_updates"));
 
   // structures to organize our modules
   std::vector<std::thread> allThreads;
@@ -258,6 +301,7 @@ main(int argc, char** argv) {
     watchdog = startEventBase(
         allThreads,
         orderedEvbs,
+        *config,
         nullptr /* watchdog won't monitor itself */,
         "Watchdog",
         std::make_unique<Watchdog>(config));
@@ -268,6 +312,7 @@ main(int argc, char** argv) {
 
   std::unique_ptr<OpenrEventBase> nlEvb{nullptr};
   std::unique_ptr<openr::fbnl::NetlinkProtocolSocket> nlSock{nullptr};
+  std::shared_ptr<openr::fbnl::NetlinkLinkCache> nlLinkCache{nullptr};
   std::unique_ptr<apache::thrift::ThriftServer> netlinkFibServer{nullptr};
   std::unique_ptr<apache::thrift::ThriftServer> netlinkSystemServer{nullptr};
   std::unique_ptr<std::thread> netlinkFibServerThread{nullptr};
@@ -288,11 +333,17 @@ main(int argc, char** argv) {
     allThreads.emplace_back([&]() {
       LOG(INFO) << "Starting NetlinkEvb thread ...";
       folly::setThreadName("NetlinkEvb");
+      if (auto scheduling = config->getThreadSchedulingConfig("NetlinkEvb")) {
+        applyThreadScheduling("NetlinkEvb", *scheduling);
+      }
       nlEvb->getEvb()->loopForever();
       LOG(INFO) << "NetlinkEvb thread got stopped.";
     });
     nlEvb->getEvb()->waitUntilRunning();
 
+    // Interface cache shared by handlers and event publisher
+    nlLinkCache = std::make_shared<openr::fbnl::NetlinkLinkCache>(nlSock.get());
+
     // Add netlink eventbase to watchdog
     if (watchdog) {
       watchdog->addEvb(nlEvb.get(), "NetlinkEvb");
@@ -300,7 +351,12 @@ main(int argc, char** argv) {
 
     // Create event publisher to handle event subscription
     eventPublisher = std::make_unique<PlatformPublisher>(
-        context, PlatformPublisherUrl{FLAGS_platform_pub_url}, nlSock.get());
+        context,
+        PlatformPublisherUrl{FLAGS_platform_pub_url},
+        nlSock.get(),
+        nlLinkCache,
+        Constants::kPlatformEventCoalesceWindow);
+    startupTimeline.record("netlink_initialized");
 
     // ATTN: intentionally set evl capacity to be 1e5 instead of default 1e2
     if (config->isNetlinkFibHandlerEnabled()) {
@@ -314,10 +370,13 @@ main(int argc, char** argv) {
       netlinkFibServer->setCpp2WorkerThreadName("FibTWorker");
       netlinkFibServer->setPort(config->getConfig().fib_port);
 
-      netlinkFibServerThread =
-          std::make_unique<std::thread>([&netlinkFibServer, &nlSock]() {
+      netlinkFibServerThread = std::make_unique<std::thread>(
+          [&netlinkFibServer, &nlSock, &nlLinkCache]() {
             folly::setThreadName("FibService");
-            auto fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+            auto fibHandler = std::make_shared<NetlinkFibHandler>(
+                nlSock.get(),
+                Constants::kPlatformRouteAuditInterval,
+                nlLinkCache);
             netlinkFibServer->setInterface(std::move(fibHandler));
 
             LOG(INFO) << "Starting NetlinkFib server...";
@@ -337,11 +396,11 @@ main(int argc, char** argv) {
       netlinkSystemServer->setCpp2WorkerThreadName("SystemTWorker");
       netlinkSystemServer->setPort(FLAGS_system_agent_port);
 
-      netlinkSystemServerThread =
-          std::make_unique<std::thread>([&netlinkSystemServer, &nlSock]() {
+      netlinkSystemServerThread = std::make_unique<std::thread>(
+          [&netlinkSystemServer, &nlSock, &nlLinkCache]() {
             folly::setThreadName("SystemService");
-            auto systemHandler =
-                std::make_unique<NetlinkSystemHandler>(nlSock.get());
+            auto systemHandler = std::make_unique<NetlinkSystemHandler>(
+                nlSock.get(), nlLinkCache);
             netlinkSystemServer->setInterface(std::move(systemHandler));
 
             LOG(INFO) << "Starting NetlinkSystem server...";
@@ -363,15 +422,22 @@ main(int argc, char** argv) {
   });
   mainEventLoop.waitUntilRunning();
 
-  if (FLAGS_enable_fib_service_waiting) {
-    waitForFibService(mainEventLoop, config->getConfig().fib_port);
-  }
+  // Only Fib depends on FibService, wait for it in parallel of starting other
+  // modules, so that e.g. Spark can discover neighbors meanwhile
+  std::thread fibServiceWaitThread([&]() noexcept {
+    if (FLAGS_enable_fib_service_waiting) {
+      folly::setThreadName("FibServiceWait");
+      waitForFibService(mainEventLoop, config->getConfig().fib_port);
+    }
+    startupTimeline.record("fib_service_ready");
+  });
 
   // Starting openrCtrlEvb for thrift handler
   OpenrEventBase ctrlEvb;
   std::thread ctrlEvbThread([&]() noexcept {
     LOG(INFO) << "Starting openrCtrl eventbase...";
     folly::setThreadName("openrCtrl");
+    bindThreadToModuleArena("OpenrCtrl");
     ctrlEvb.run();
     LOG(INFO) << "OpenrCtrl eventbase stopped...";
   });
@@ -381,6 +447,7 @@ main(int argc, char** argv) {
   auto configStore = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "ConfigStore",
       std::make_unique<PersistentStore>(
@@ -414,12 +481,13 @@ main(int argc, char** argv) {
   auto kvStore = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "KvStore",
       std::make_unique<KvStore>(
           context,
           kvStoreUpdatesQueue,
-          peerUpdatesQueue.getReader(),
+          peerUpdatesQueue.getReader("kvstore"),
           KvStoreGlobalCmdUrl{folly::sformat(
               "tcp://{}:{}",
               config->getConfig().listen_addr,
@@ -428,15 +496,24 @@ main(int argc, char** argv) {
           config,
           maybeIpTos,
           FLAGS_kvstore_zmq_hwm,
-          FLAGS_enable_kvstore_thrift));
+          FLAGS_enable_kvstore_thrift,
+          configStore,
+          configUpdatesQueue.getReader("kvstore")));
+  // Watch event loops of areas running on their own threads
+  if (watchdog) {
+    for (auto const& [area, evb] : kvStore->getAreaEvbs()) {
+      watchdog->addEvb(evb, folly::sformat("KvStore.{}", area));
+    }
+  }
 
   auto prefixManager = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "PrefixManager",
       std::make_unique<PrefixManager>(
-          prefixUpdateRequestQueue.getReader(),
+          prefixUpdateRequestQueue.getReader("prefix_manager"),
           config,
           configStore,
           kvStore,
@@ -449,6 +526,7 @@ main(int argc, char** argv) {
     startEventBase(
         allThreads,
         orderedEvbs,
+        *config,
         watchdog,
         "PrefixAllocator",
         std::make_unique<PrefixAllocator>(
@@ -466,16 +544,20 @@ main(int argc, char** argv) {
   startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "Spark",
       std::make_unique<Spark>(
           maybeIpTos,
-          interfaceUpdatesQueue.getReader(),
+          interfaceUpdatesQueue.getReader("spark"),
           neighborUpdatesQueue,
           KvStoreCmdPort{static_cast<uint16_t>(FLAGS_kvstore_rep_port)},
           OpenrCtrlThriftPort{static_cast<uint16_t>(FLAGS_openr_ctrl_port)},
           std::make_shared<IoProvider>(),
-          config));
+          config,
+          std::make_pair(
+              Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+          configUpdatesQueue.getReader("spark")));
 
   // Static list of prefixes to announce into the network as long as OpenR is
   // running.
@@ -508,6 +590,7 @@ main(int argc, char** argv) {
   auto linkMonitor = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "LinkMonitor",
       std::make_unique<LinkMonitor>(
@@ -519,7 +602,7 @@ main(int argc, char** argv) {
           FLAGS_enable_perf_measurement,
           interfaceUpdatesQueue,
           peerUpdatesQueue,
-          neighborUpdatesQueue.getReader(),
+          neighborUpdatesQueue.getReader("link_monitor"),
           monitorSubmitUrl,
           configStore,
           FLAGS_assume_drained,
@@ -535,6 +618,7 @@ main(int argc, char** argv) {
   auto decision = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "Decision",
       std::make_unique<Decision>(
@@ -543,27 +627,41 @@ main(int argc, char** argv) {
           not FLAGS_enable_bgp_route_programming,
           std::chrono::milliseconds(FLAGS_decision_debounce_min_ms),
           std::chrono::milliseconds(FLAGS_decision_debounce_max_ms),
-          kvStoreUpdatesQueue.getReader(),
-          staticRoutesUpdateQueue.getReader(),
+          kvStore->getKvStoreUpdatesReader(KvStoreFilters(
+              {Constants::kAdjDbMarker.toString(),
+               Constants::kPrefixDbMarker.toString(),
+               Constants::kFibTimeMarker.toString()},
+              {})),
+          staticRoutesUpdateQueue.getReader("decision"),
           routeUpdatesQueue,
+          decisionDbsUpdatesQueue,
           context));
 
   // Define and start Fib Module
+  fibServiceWaitThread.join();
   auto fib = startEventBase(
       allThreads,
       orderedEvbs,
+      *config,
       watchdog,
       "Fib",
       std::make_unique<Fib>(
           config,
           config->getConfig().fib_port,
           std::chrono::seconds(3 * sparkConf.keepalive_time_s),
-          routeUpdatesQueue.getReader(),
-          interfaceUpdatesQueue.getReader(),
+          routeUpdatesQueue.getReader("fib"),
+          interfaceUpdatesQueue.getReader("fib"),
+          fibUpdatesQueue,
           monitorSubmitUrl,
           kvStore,
           context));
 
+  // Modules start independently of each other, wait for all of them
+  for (auto const& evb : orderedEvbs) {
+    evb->waitUntilRunning();
+  }
+  startupTimeline.record("modules_running");
+
   // Start OpenrCtrl thrift server
   apache::thrift::ThriftServer thriftCtrlServer;
 
@@ -618,7 +716,8 @@ main(int argc, char** argv) {
         prefixManager,
         config,
         monitorSubmitUrl,
-        context);
+        context,
+        &configUpdatesQueue);
   });
 
   CHECK(ctrlHandler);
@@ -629,20 +728,33 @@ main(int argc, char** argv) {
   thriftCtrlServer.setNumCPUWorkerThreads(1);
   // Enable TOS reflection on the server socket
   thriftCtrlServer.setTosReflect(true);
-
-  // serve
-  allThreads.emplace_back(std::thread([&thriftCtrlServer]() noexcept {
-    LOG(INFO) << "Starting thriftCtrlServer thread ...";
-    folly::setThreadName("thriftCtrlServer");
-    thriftCtrlServer.serve();
-    LOG(INFO) << "thriftCtrlServer thread got stopped.";
-  }));
+  // Large responses, e.g. KvStore dumps, are compressed with the transforms
+  // negotiated by the client (zstd for breeze)
+  thriftCtrlServer.setMinCompressBytes(Constants::kCtrlMinCompressBytes);
+
+  // serve. IO and CPU worker threads of the server inherit its scheduling
+  auto ctrlServerScheduling =
+      config->getThreadSchedulingConfig("thriftCtrlServer");
+  allThreads.emplace_back(
+      std::thread([&thriftCtrlServer,
+                   &startupTimeline,
+                   ctrlServerScheduling]() noexcept {
+        LOG(INFO) << "Starting thriftCtrlServer thread ...";
+        folly::setThreadName("thriftCtrlServer");
+        if (ctrlServerScheduling.has_value()) {
+          applyThreadScheduling("thriftCtrlServer", *ctrlServerScheduling);
+        }
+        startupTimeline.record("ctrl_server_started");
+        thriftCtrlServer.serve();
+        LOG(INFO) << "thriftCtrlServer thread got stopped.";
+      }));
 
   // Call external module for platform specific implementations
   if (config->isBgpPeeringEnabled()) {
     pluginStart(PluginArgs{prefixUpdateRequestQueue,
                            staticRoutesUpdateQueue,
-                           routeUpdatesQueue.getReader(),
+                           routeUpdatesQueue.getReader("plugin"),
+                           kvStoreUpdatesQueue.getReader("plugin"),
                            config,
                            sslContext});
   }
@@ -657,7 +769,11 @@ main(int argc, char** argv) {
   neighborUpdatesQueue.close();
   prefixUpdateRequestQueue.close();
   kvStoreUpdatesQueue.close();
+  kvStore->closeKvStoreUpdatesReaders();
   staticRoutesUpdateQueue.close();
+  fibUpdatesQueue.close();
+  decisionDbsUpdatesQueue.close();
+  configUpdatesQueue.close();
 
   thriftCtrlServer.stop();
   ctrlHandler.reset();
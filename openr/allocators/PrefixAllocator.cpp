@@ -68,29 +68,43 @@ PrefixAllocator::PrefixAllocator(
       std::make_unique<KvStoreClientInternal>(this, myNodeName_, kvStore_);
 
   // Let the magic begin. Start allocation as per allocMode
+  const bool enablePrefixLease = config->getPrefixAllocationConfig()
+                                     .enable_prefix_lease_ref()
+                                     .value_or(false);
   switch (config->getPrefixAllocationConfig().prefix_allocation_mode) {
   case thrift::PrefixAllocationMode::DYNAMIC_LEAF_NODE:
+    if (enablePrefixLease) {
+      LOG(INFO) << "DYNAMIC_LEAF_NODE (lease)";
+      staticAllocation(Constants::kPrefixLeaseAllocParamKey.toString());
+      break;
+    }
     LOG(INFO) << "DYNAMIC_LEAF_NODE";
     dynamicAllocationLeafNode();
     break;
   case thrift::PrefixAllocationMode::DYNAMIC_ROOT_NODE:
+    if (enablePrefixLease) {
+      LOG(INFO) << "DYNAMIC_ROOT_NODE (lease)";
+      dynamicAllocationLeaseRootNode(config->getPrefixAllocationParams());
+      break;
+    }
     LOG(INFO) << "DYNAMIC_ROOT_NODE";
     dynamicAllocationRootNode(config->getPrefixAllocationParams());
     break;
   case thrift::PrefixAllocationMode::STATIC:
     LOG(INFO) << "STATIC";
-    staticAllocation();
+    staticAllocation(Constants::kStaticPrefixAllocParamKey.toString());
     break;
   }
 }
 
 void
-PrefixAllocator::staticAllocation() {
+PrefixAllocator::staticAllocation(std::string const& allocParamKey) {
   // subscribe for incremental updates of static prefix allocation key
   kvStoreClient_->subscribeKey(
-      Constants::kStaticPrefixAllocParamKey.toString(),
-      [&](std::string const& key, std::optional<thrift::Value> value) {
-        CHECK_EQ(Constants::kStaticPrefixAllocParamKey.toString(), key);
+      allocParamKey,
+      [this, allocParamKey](
+          std::string const& key, std::optional<thrift::Value> value) {
+        CHECK_EQ(allocParamKey, key);
         if (value.has_value()) {
           processStaticPrefixAllocUpdate(value.value());
         }
@@ -99,50 +113,49 @@ PrefixAllocator::staticAllocation() {
       area_);
 
   // get initial value if missed out in incremental updates (one time only)
-  initTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
-    // If we already have received initial value from KvStore then just skip
-    // this step
-    if (allocParams_.has_value()) {
-      return;
-    }
+  initTimer_ =
+      folly::AsyncTimeout::make(*getEvb(), [this, allocParamKey]() noexcept {
+        // If we already have received initial value from KvStore then just skip
+        // this step
+        if (allocParams_.has_value()) {
+          return;
+        }
 
-    // 1) Get initial value from KvStore!
-    auto maybeValue = kvStoreClient_->getKey(
-        Constants::kStaticPrefixAllocParamKey.toString(), area_);
-    if (!maybeValue.has_value()) {
-      LOG(ERROR) << "Failed to retrieve prefix alloc key: "
-                 << Constants::kStaticPrefixAllocParamKey.toString()
-                 << " from KvStore, area: " << area_;
-    } else {
-      processStaticPrefixAllocUpdate(maybeValue.value());
-      return;
-    }
+        // 1) Get initial value from KvStore!
+        auto maybeValue = kvStoreClient_->getKey(allocParamKey, area_);
+        if (!maybeValue.has_value()) {
+          LOG(ERROR) << "Failed to retrieve prefix alloc key: " << allocParamKey
+                     << " from KvStore, area: " << area_;
+        } else {
+          processStaticPrefixAllocUpdate(maybeValue.value());
+          return;
+        }
 
-    // 2) Start prefix allocator from previously configured params. Resume
-    // from where we left earlier!
-    auto maybeThriftAllocPrefix =
-        configStore_->loadThriftObj<thrift::AllocPrefix>(kConfigKey).get();
-    if (maybeThriftAllocPrefix.hasValue()) {
-      const auto oldAllocParams = std::make_pair(
-          toIPNetwork(maybeThriftAllocPrefix->seedPrefix),
-          static_cast<uint8_t>(maybeThriftAllocPrefix->allocPrefixLen));
-      allocParams_ = oldAllocParams;
-      applyMyPrefixIndex(maybeThriftAllocPrefix->allocPrefixIndex);
-      return;
-    }
+        // 2) Start prefix allocator from previously configured params. Resume
+        // from where we left earlier!
+        auto maybeThriftAllocPrefix =
+            configStore_->loadThriftObj<thrift::AllocPrefix>(kConfigKey).get();
+        if (maybeThriftAllocPrefix.hasValue()) {
+          const auto oldAllocParams = std::make_pair(
+              toIPNetwork(maybeThriftAllocPrefix->seedPrefix),
+              static_cast<uint8_t>(maybeThriftAllocPrefix->allocPrefixLen));
+          allocParams_ = oldAllocParams;
+          applyMyPrefixIndex(maybeThriftAllocPrefix->allocPrefixIndex);
+          return;
+        }
 
-    // If we weren't able to get alloc parameters so far, either from disk
-    // or kvstore then let's bail out, flush out previously elected address
-    // (from PrefixManager and loopback iface).
-    if (!allocParams_.has_value()) {
-      LOG(WARNING)
-          << "Clearing previous prefix allocation state on failure to load "
-          << "allocation parameters from disk as well as KvStore.";
-      applyState_ = std::make_pair(true, std::nullopt);
-      applyMyPrefix();
-      return;
-    }
-  });
+        // If we weren't able to get alloc parameters so far, either from disk
+        // or kvstore then let's bail out, flush out previously elected address
+        // (from PrefixManager and loopback iface).
+        if (!allocParams_.has_value()) {
+          LOG(WARNING)
+              << "Clearing previous prefix allocation state on failure to load "
+              << "allocation parameters from disk as well as KvStore.";
+          applyState_ = std::make_pair(true, std::nullopt);
+          applyMyPrefix();
+          return;
+        }
+      });
   initTimer_->scheduleTimeout(0ms);
 }
 
@@ -235,6 +248,106 @@ PrefixAllocator::dynamicAllocationRootNode(
   initTimer_->scheduleTimeout(0ms);
 }
 
+void
+PrefixAllocator::dynamicAllocationLeaseRootNode(
+    PrefixAllocationParams const& allocParams) {
+  // Some sanity checks
+  const auto& seedPrefix = allocParams.first;
+  const auto& allocPrefixLen = allocParams.second;
+  CHECK_GT(allocPrefixLen, seedPrefix.second)
+      << "Allocation prefix length must be greater than seed prefix length.";
+  leaseParams_ = allocParams;
+
+  // Hand out leases in batch as nodes join or leave the area
+  updatePrefixLeasesThrottled_ = std::make_unique<AsyncThrottle>(
+      getEvb(), syncInterval_, [this]() noexcept { updatePrefixLeases(); });
+  kvStoreClient_->setKvCallback(
+      [this](std::string const& key, std::optional<thrift::Value>) noexcept {
+        if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+          (*updatePrefixLeasesThrottled_)();
+        }
+      });
+
+  // Lease prefix to myself right away
+  initTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { updatePrefixLeases(); });
+  initTimer_->scheduleTimeout(0ms);
+}
+
+void
+PrefixAllocator::updatePrefixLeases() {
+  CHECK(leaseParams_.has_value());
+  const auto& seedPrefix = leaseParams_->first;
+  const auto& allocPrefixLen = leaseParams_->second;
+
+  // Resume from leases handed out by previous incarnation, if any
+  if (prefixLeases_.empty()) {
+    auto maybeValue = kvStoreClient_->getKey(
+        Constants::kPrefixLeaseAllocParamKey.toString(), area_);
+    if (maybeValue.has_value() and maybeValue->value_ref().has_value()) {
+      try {
+        const auto leases =
+            fbzmq::util::readThriftObjStr<thrift::StaticAllocation>(
+                *maybeValue->value_ref(), serializer_);
+        for (auto const& [node, prefix] : leases.nodePrefixes) {
+          const auto network = toIPNetwork(prefix);
+          if (network.second != allocPrefixLen or
+              not network.first.inSubnet(seedPrefix.first, seedPrefix.second)) {
+            continue;
+          }
+          prefixLeases_.emplace(
+              node,
+              bitStrValue(
+                  network.first, seedPrefix.second, allocPrefixLen - 1));
+        }
+      } catch (std::exception const& e) {
+        LOG(ERROR) << "Error parsing prefix leases. Error: "
+                   << folly::exceptionStr(e);
+      }
+    }
+  }
+
+  // Nodes in the area, learnt from their adjacency keys
+  std::set<std::string> nodes{myNodeName_};
+  const auto maybeAdjDbs = kvStoreClient_->dumpAllWithPrefix(
+      Constants::kAdjDbMarker.toString(), area_);
+  if (maybeAdjDbs.has_value()) {
+    for (auto const& [key, _] : *maybeAdjDbs) {
+      nodes.emplace(key.substr(Constants::kAdjDbMarker.size()));
+    }
+  } else {
+    LOG(ERROR) << "Failed to dump adjacency keys from KvStore, area: "
+               << area_;
+  }
+
+  prefixLeases_ = allocatePrefixLeases(
+      prefixLeases_, nodes, getPrefixIndexRange(*leaseParams_));
+
+  thrift::StaticAllocation staticAlloc;
+  for (auto const& [node, prefixIndex] : prefixLeases_) {
+    staticAlloc.nodePrefixes.emplace(
+        node,
+        toIpPrefix(getNthPrefix(seedPrefix, allocPrefixLen, prefixIndex)));
+  }
+  auto leasesStr = fbzmq::util::writeThriftObjStr(staticAlloc, serializer_);
+  if (leasesStr == advertisedPrefixLeases_) {
+    return;
+  }
+
+  LOG(INFO) << "Advertising " << prefixLeases_.size() << " prefix leases";
+  kvStoreClient_->persistKey(
+      Constants::kPrefixLeaseAllocParamKey.toString(),
+      leasesStr,
+      Constants::kTtlInfInterval,
+      area_);
+  advertisedPrefixLeases_ = leasesStr;
+
+  // Apply my own lease
+  thrift::Value leasesValue;
+  leasesValue.value_ref() = std::move(leasesStr);
+  processStaticPrefixAllocUpdate(leasesValue);
+}
+
 std::optional<uint32_t>
 PrefixAllocator::getMyPrefixIndex() {
   if (getEvb()->isInEventBaseThread()) {
@@ -392,6 +505,63 @@ PrefixAllocator::getPrefixCount(
   return (1 << std::min(31, allocPrefixLen - seedPrefix.second));
 }
 
+std::pair<uint32_t, uint32_t>
+PrefixAllocator::getPrefixIndexRange(
+    PrefixAllocationParams const& allocParams) noexcept {
+  const uint32_t prefixCount = getPrefixCount(allocParams);
+  uint32_t startIndex = 0;
+  uint32_t endIndex = prefixCount - 1;
+
+  // For IPv4, if the prefix length is 32
+  // then the first and last IP in that subnet are not valid host addresses.
+  if (allocParams.first.first.isV4() && allocParams.second == 32) {
+    startIndex += 1;
+    endIndex -= 1;
+  }
+  return std::make_pair(startIndex, endIndex);
+}
+
+std::unordered_map<std::string, uint32_t>
+PrefixAllocator::allocatePrefixLeases(
+    std::unordered_map<std::string, uint32_t> const& leases,
+    std::set<std::string> const& nodes,
+    std::pair<uint32_t, uint32_t> const& indexRange) {
+  std::unordered_map<std::string, uint32_t> newLeases;
+  std::unordered_set<uint32_t> leasedIndices;
+
+  // Retain leases of existing nodes
+  for (auto const& [node, prefixIndex] : leases) {
+    if (nodes.count(node) and prefixIndex >= indexRange.first and
+        prefixIndex <= indexRange.second and
+        leasedIndices.emplace(prefixIndex).second) {
+      newLeases.emplace(node, prefixIndex);
+    }
+  }
+
+  // Lease free indices to new nodes, preferring hash of node name
+  const uint64_t rangeSize =
+      static_cast<uint64_t>(indexRange.second) - indexRange.first + 1;
+  for (auto const& node : nodes) {
+    if (newLeases.count(node)) {
+      continue;
+    }
+    if (leasedIndices.size() == rangeSize) {
+      LOG(ERROR) << "Ran out of prefixes to lease. "
+                 << nodes.size() - newLeases.size() << " nodes left out";
+      break;
+    }
+    uint32_t prefixIndex =
+        indexRange.first + std::hash<std::string>{}(node) % rangeSize;
+    while (leasedIndices.count(prefixIndex)) {
+      prefixIndex = (prefixIndex < indexRange.second) ? (prefixIndex + 1)
+                                                      : indexRange.first;
+    }
+    leasedIndices.emplace(prefixIndex);
+    newLeases.emplace(node, prefixIndex);
+  }
+  return newLeases;
+}
+
 std::optional<uint32_t>
 PrefixAllocator::loadPrefixIndexFromKvStore() {
   VLOG(4) << "See if I am already allocated a prefix in kvstore";
@@ -541,19 +711,8 @@ PrefixAllocator::startAllocation(
             << folly::IPAddress::networkToString(allocParams_->first)
             << ", allocation prefix length: "
             << static_cast<int16_t>(allocParams_->second);
-  const uint32_t prefixCount = getPrefixCount(*allocParams_);
-  uint32_t startIndex = 0;
-  uint32_t endIndex = prefixCount - 1;
-
-  // For IPv4, if the prefix length is 32
-  // then the first and last IP in that subnet are not valid host addresses.
-  if (allocParams_->first.first.isV4() && allocParams_->second == 32) {
-    startIndex += 1;
-    endIndex -= 1;
-  }
-
   rangeAllocator_->startAllocator(
-      std::make_pair(startIndex, endIndex), getInitPrefixIndex());
+      getPrefixIndexRange(*allocParams_), getInitPrefixIndex());
 }
 
 void
@@ -9,7 +9,10 @@
 
 #include <chrono>
 #include <functional>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <fbzmq/async/ZmqTimeout.h>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
@@ -19,6 +22,7 @@
 #include <folly/io/async/EventBase.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include <openr/common/AsyncThrottle.h>
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/common/OpenrEventBase.h>
@@ -41,6 +45,9 @@ namespace openr {
  * The class assigns local node unique prefixes from a given seed prefix in
  * a distributed manner.
  *
+ * In lease mode, the root node instead hands out prefixes to all nodes of the
+ * area (learnt from their adjacency keys) in a single KvStore key, and leaf
+ * nodes use the prefix leased to them.
  */
 class PrefixAllocator : public OpenrEventBase {
  public:
@@ -68,15 +75,33 @@ class PrefixAllocator : public OpenrEventBase {
   static uint32_t getPrefixCount(
       PrefixAllocationParams const& allocParams) noexcept;
 
+  // Static function to get range of valid prefix indices from allocation
+  // params
+  static std::pair<uint32_t, uint32_t> getPrefixIndexRange(
+      PrefixAllocationParams const& allocParams) noexcept;
+
+  // Static function to lease prefix indices within range to the nodes. Leases
+  // of existing nodes are retained, and new nodes are handed out free indices
+  // deterministically in order of their names
+  static std::unordered_map<std::string, uint32_t> allocatePrefixLeases(
+      std::unordered_map<std::string, uint32_t> const& leases,
+      std::set<std::string> const& nodes,
+      std::pair<uint32_t, uint32_t> const& indexRange);
+
  private:
   //
   // Private methods
   //
 
-  // 3 different ways to initialize PrefixAllocator.
-  void staticAllocation();
+  // 3 different ways to initialize PrefixAllocator, plus lease mode of root
+  // node. Leaf nodes in lease mode use static allocation from lease key
+  void staticAllocation(std::string const& allocParamKey);
   void dynamicAllocationLeafNode();
   void dynamicAllocationRootNode(PrefixAllocationParams const&);
+  void dynamicAllocationLeaseRootNode(PrefixAllocationParams const&);
+
+  // Hand out prefix leases to nodes in the area and advertise them
+  void updatePrefixLeases();
 
   // Function to process static allocation update from kvstore
   void processStaticPrefixAllocUpdate(thrift::Value const& value);
@@ -176,6 +201,16 @@ class PrefixAllocator : public OpenrEventBase {
   // Allocation parameters e.g., fc00:cafe::/56, 64
   std::optional<PrefixAllocationParams> allocParams_;
 
+  // Allocation parameters of leases handed out by root node in lease mode
+  std::optional<PrefixAllocationParams> leaseParams_;
+
+  // Prefix index leased to each node, and serialized leases last advertised
+  std::unordered_map<std::string, uint32_t> prefixLeases_;
+  std::string advertisedPrefixLeases_;
+
+  // Throttle lease updates on node changes
+  std::unique_ptr<AsyncThrottle> updatePrefixLeasesThrottled_;
+
   // index of my currently claimed prefix within seed prefix
   std::optional<uint32_t> myPrefixIndex_;
 
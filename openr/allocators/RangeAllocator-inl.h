@@ -33,6 +33,32 @@ binaryToPrimitive(const std::string& s) {
   return t;
 }
 
+/**
+ * Find first unset bit at or after `start` in bitmap of `size` bits, wrapping
+ * around to the beginning. Scans a word at a time. Returns `size` if all bits
+ * are set.
+ */
+inline uint64_t
+findNextUnsetBit(
+    const std::vector<uint64_t>& bitmap, uint64_t size, uint64_t start) {
+  // scan [start, size) and then wrap around to [0, start)
+  const std::pair<uint64_t, uint64_t> ranges[] = {{start, size}, {0, start}};
+  for (auto const& [begin, end] : ranges) {
+    for (uint64_t idx = begin; idx < end; idx = (idx / 64 + 1) * 64) {
+      // mask out bits before idx in the word
+      const uint64_t unset = ~bitmap[idx / 64] & (~uint64_t{0} << (idx % 64));
+      if (unset) {
+        const uint64_t found = (idx / 64) * 64 + folly::findFirstSet(unset) - 1;
+        if (found < end) {
+          return found;
+        }
+        break;
+      }
+    }
+  }
+  return size;
+}
+
 } // namespace details
 
 template <typename T>
@@ -270,6 +296,46 @@ RangeAllocator<T>::scheduleAllocate(const T seedVal) noexcept {
   CHECK(maybeKeyMap.has_value())
       << "Failed to dump keys with prefix: " << keyPrefix_
       << " from kvstore in area: " << area_;
+
+  // look for a value I can own, skipping values in use with bitmap search
+  if (static_cast<uint64_t>(allocRangeSize_) <=
+      Constants::kRangeAllocBitmapMaxSize) {
+    const uint64_t rangeSize = allocRangeSize_;
+    usedValues_.assign((rangeSize + 63) / 64, 0);
+    for (auto const& [_, thriftVal] : *maybeKeyMap) {
+      const auto val =
+          details::binaryToPrimitive<T>(thriftVal.value_ref().value());
+      if (val < allocRange_.first or val > allocRange_.second) {
+        continue;
+      }
+      // owned by higher originator or override is not allowed
+      if (not overrideOwner_ or nodeName_ < thriftVal.originatorId) {
+        const uint64_t offset = val - allocRange_.first;
+        usedValues_[offset / 64] |= uint64_t{1} << (offset % 64);
+      }
+    }
+
+    uint64_t offset = newVal - allocRange_.first;
+    while ((offset = details::findNextUnsetBit(
+                usedValues_, rangeSize, offset)) < rangeSize) {
+      const T val = allocRange_.first + offset;
+      if (!checkValueInUseCb_ or !checkValueInUseCb_(val)) {
+        // found
+        newVal = val;
+        break;
+      }
+      usedValues_[offset / 64] |= uint64_t{1} << (offset % 64);
+    }
+    if (offset == rangeSize) {
+      LOG(ERROR) << "All values are owned by higher originatorIds";
+    }
+
+    // Schedule timeout to allocate new value
+    allocateValue_ = newVal;
+    timeout_->scheduleTimeout(backoff_.getTimeRemainingUntilRetry());
+    return;
+  }
+
   const auto valOwners =
       folly::gen::from(*maybeKeyMap) |
       folly::gen::map([](std::pair<std::string, thrift::Value> const& kv) {
@@ -10,12 +10,14 @@
 #include <chrono>
 #include <random>
 #include <string>
+#include <vector>
 
 #include <fbzmq/async/ZmqTimeout.h>
 #include <folly/Format.h>
 #include <folly/Optional.h>
 #include <folly/Random.h>
 #include <folly/gen/Base.h>
+#include <folly/lang/Bits.h>
 
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrEventBase.h>
@@ -155,6 +157,11 @@ class RangeAllocator {
   // Size of range
   T allocRangeSize_;
 
+  // Bitmap of values (offset from start of range) which can't be owned,
+  // rebuilt from KvStore on every allocation attempt. Reused across attempts
+  // to avoid reallocation
+  std::vector<uint64_t> usedValues_;
+
   // Currently allocated value
   std::optional<T> myValue_;
 
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/allocators/PrefixAllocator.h>
+#include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+
+namespace {
+
+// interval for periodic syncs
+const std::chrono::milliseconds kSyncInterval(10);
+
+// seed prefix with 256 sub-prefixes of allocated length
+const std::string kSeedPrefix{"fc00:cafe:babe::/120"};
+const int kAllocPrefixLen = 128;
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Simulate simultaneous boot of `numNodes` nodes sharing a KvStore, and
+ * measure time until all of them have been allocated a prefix. Nodes either
+ * claim prefixes on their own (one RangeAllocator per node), or first node is
+ * the root handing out leases to the rest.
+ */
+static void
+runSimultaneousBoot(uint32_t iters, size_t numNodes, bool enablePrefixLease) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  for (uint32_t iter = 0; iter < iters; ++iter) {
+    fbzmq::Context context;
+    auto store = std::make_unique<KvStoreWrapper>(
+        context, std::make_shared<Config>(getBasicOpenrConfig("store")));
+    store->run();
+
+    if (enablePrefixLease) {
+      // root node learns about nodes in the area from their adjacencies
+      for (size_t i = 0; i < numNodes; ++i) {
+        store->setKey(
+            folly::sformat("{}node-{}", Constants::kAdjDbMarker, i),
+            createThriftValue(1, folly::sformat("node-{}", i), std::string()));
+      }
+    } else {
+      store->setKey(
+          Constants::kSeedPrefixAllocParamKey.toString(),
+          createThriftValue(
+              1,
+              "store",
+              folly::sformat("{},{}", kSeedPrefix, kAllocPrefixLen)));
+    }
+
+    std::vector<std::shared_ptr<Config>> configs;
+    std::vector<std::unique_ptr<PersistentStore>> configStores;
+    std::vector<messaging::ReplicateQueue<thrift::PrefixUpdateRequest>>
+        prefixQueues(numNodes);
+    std::vector<std::unique_ptr<PrefixAllocator>> allocators;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numNodes; ++i) {
+      auto tConfig = getBasicOpenrConfig(folly::sformat("node-{}", i));
+      tConfig.enable_prefix_allocation_ref() = true;
+      thrift::PrefixAllocationConfig pfxAllocationConf;
+      pfxAllocationConf.loopback_interface = "";
+      pfxAllocationConf.prefix_allocation_mode =
+          thrift::PrefixAllocationMode::DYNAMIC_LEAF_NODE;
+      if (enablePrefixLease) {
+        pfxAllocationConf.enable_prefix_lease_ref() = true;
+        if (i == 0) {
+          pfxAllocationConf.prefix_allocation_mode =
+              thrift::PrefixAllocationMode::DYNAMIC_ROOT_NODE;
+          pfxAllocationConf.seed_prefix_ref() = kSeedPrefix;
+          pfxAllocationConf.allocate_prefix_len_ref() = kAllocPrefixLen;
+        }
+      }
+      tConfig.prefix_allocation_config_ref() = pfxAllocationConf;
+      configs.emplace_back(std::make_shared<Config>(tConfig));
+
+      auto configStore = std::make_unique<PersistentStore>(
+          folly::sformat("node-{}", i),
+          folly::sformat("/tmp/openr.{}.{}", tid, i),
+          context,
+          true /* dryrun */);
+      threads.emplace_back(
+          [configStore = configStore.get()]() noexcept { configStore->run(); });
+      configStore->waitUntilRunning();
+      configStores.emplace_back(std::move(configStore));
+    }
+
+    // Boot all nodes at once
+    suspender.dismiss();
+    for (size_t i = 0; i < numNodes; ++i) {
+      auto allocator = std::make_unique<PrefixAllocator>(
+          configs.at(i),
+          store->getKvStore(),
+          prefixQueues.at(i),
+          MonitorSubmitUrl{"inproc://monitor_submit"},
+          configStores.at(i).get(),
+          context,
+          0 /* system service port */,
+          kSyncInterval);
+      threads.emplace_back(
+          [allocator = allocator.get()]() noexcept { allocator->run(); });
+      allocators.emplace_back(std::move(allocator));
+    }
+    for (auto& allocator : allocators) {
+      while (not allocator->getMyPrefixIndex().has_value()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    suspender.rehire();
+
+    for (auto& allocator : allocators) {
+      allocator->stop();
+      allocator->waitUntilStopped();
+    }
+    for (auto& configStore : configStores) {
+      configStore->stop();
+      configStore->waitUntilStopped();
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    allocators.clear();
+    configStores.clear();
+    for (auto& queue : prefixQueues) {
+      queue.close();
+    }
+    store->stop();
+  }
+}
+
+static void
+BM_PrefixAllocatorClaim(uint32_t iters, size_t numNodes) {
+  runSimultaneousBoot(iters, numNodes, false /* enablePrefixLease */);
+}
+
+static void
+BM_PrefixAllocatorLease(uint32_t iters, size_t numNodes) {
+  runSimultaneousBoot(iters, numNodes, true /* enablePrefixLease */);
+}
+
+// The parameter is number of nodes booting simultaneously
+BENCHMARK_PARAM(BM_PrefixAllocatorClaim, 10);
+BENCHMARK_PARAM(BM_PrefixAllocatorClaim, 100);
+BENCHMARK_PARAM(BM_PrefixAllocatorClaim, 200);
+BENCHMARK_PARAM(BM_PrefixAllocatorLease, 10);
+BENCHMARK_PARAM(BM_PrefixAllocatorLease, 100);
+BENCHMARK_PARAM(BM_PrefixAllocatorLease, 200);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -1000,6 +1000,44 @@ TEST(PrefixAllocator, getPrefixCount) {
   }
 }
 
+TEST(PrefixAllocator, allocatePrefixLeases) {
+  const auto range = std::make_pair<uint32_t, uint32_t>(1, 4);
+
+  // All nodes get unique index within range
+  auto leases = PrefixAllocator::allocatePrefixLeases(
+      {}, {"node-1", "node-2", "node-3"}, range);
+  EXPECT_EQ(3, leases.size());
+  std::unordered_set<uint32_t> indices;
+  for (auto const& [_, prefixIndex] : leases) {
+    EXPECT_LE(range.first, prefixIndex);
+    EXPECT_GE(range.second, prefixIndex);
+    indices.emplace(prefixIndex);
+  }
+  EXPECT_EQ(3, indices.size());
+
+  // Same input, same leases
+  EXPECT_EQ(
+      leases,
+      PrefixAllocator::allocatePrefixLeases(
+          {}, {"node-1", "node-2", "node-3"}, range));
+
+  // Existing leases are retained, and leases of nodes gone are released
+  auto newLeases = PrefixAllocator::allocatePrefixLeases(
+      leases, {"node-1", "node-3", "node-4", "node-5"}, range);
+  EXPECT_EQ(4, newLeases.size());
+  EXPECT_EQ(leases.at("node-1"), newLeases.at("node-1"));
+  EXPECT_EQ(leases.at("node-3"), newLeases.at("node-3"));
+  EXPECT_EQ(0, newLeases.count("node-2"));
+
+  // Out of range leases are dropped, and nodes beyond range are left out
+  newLeases = PrefixAllocator::allocatePrefixLeases(
+      {{"node-1", 0}},
+      {"node-1", "node-2", "node-3", "node-4", "node-5"},
+      range);
+  EXPECT_EQ(4, newLeases.size());
+  EXPECT_EQ(0, newLeases.count("node-5"));
+}
+
 TEST(PrefixAllocator, parseParamsStr) {
   // Missing subnet specification in seed-prefix
   { EXPECT_ANY_THROW(auto p = PrefixAllocator::parseParamsStr("face::,64")); }
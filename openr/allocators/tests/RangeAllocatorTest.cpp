@@ -403,6 +403,27 @@ TEST_P(RangeAllocatorFixture, InsufficentRange) {
   }
 }
 
+TEST(RangeAllocatorTest, FindNextUnsetBit) {
+  // 130 bits spanning 3 words, all set except 5, 70 and 129
+  std::vector<uint64_t> bitmap(3, ~uint64_t{0});
+  for (uint64_t bit : {5, 70, 129}) {
+    bitmap[bit / 64] &= ~(uint64_t{1} << (bit % 64));
+  }
+  EXPECT_EQ(5, details::findNextUnsetBit(bitmap, 130, 0));
+  EXPECT_EQ(5, details::findNextUnsetBit(bitmap, 130, 5));
+  EXPECT_EQ(70, details::findNextUnsetBit(bitmap, 130, 6));
+  EXPECT_EQ(129, details::findNextUnsetBit(bitmap, 130, 71));
+  // wrap around
+  bitmap[2] |= uint64_t{1} << 1;
+  EXPECT_EQ(5, details::findNextUnsetBit(bitmap, 130, 71));
+
+  // bits beyond size are never returned
+  std::vector<uint64_t> full(3, ~uint64_t{0});
+  full[2] = 0x3;
+  EXPECT_EQ(130, details::findNextUnsetBit(full, 130, 0));
+  EXPECT_EQ(130, details::findNextUnsetBit(full, 130, 100));
+}
+
 } // namespace openr
 
 int
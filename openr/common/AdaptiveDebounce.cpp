@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "AdaptiveDebounce.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace {
+
+// weight of the latest interval in its moving average
+const double kEventIntervalWeight{0.25};
+
+} // namespace
+
+namespace openr {
+
+AdaptiveDebounce::AdaptiveDebounce(
+    std::chrono::milliseconds minDelay, std::chrono::milliseconds maxDelay)
+    : minDelay_(minDelay), maxDelay_(maxDelay) {
+  CHECK(minDelay <= maxDelay) << "Min delay must not exceed max delay";
+}
+
+bool
+AdaptiveDebounce::isIsolated(Clock::time_point now) const {
+  return not batchStartTime_.has_value() and
+      (not lastEventTime_.has_value() or now - *lastEventTime_ >= maxDelay_);
+}
+
+std::chrono::milliseconds
+AdaptiveDebounce::reportEvent(Clock::time_point now) {
+  if (lastEventTime_.has_value()) {
+    const std::chrono::duration<double, std::milli> interval =
+        now - *lastEventTime_;
+    eventIntervalMs_ = eventIntervalMs_.has_value()
+        ? (1 - kEventIntervalWeight) * *eventIntervalMs_ +
+            kEventIntervalWeight * interval.count()
+        : interval.count();
+  }
+  lastEventTime_ = now;
+
+  if (not batchStartTime_.has_value()) {
+    batchStartTime_ = now;
+    delay_ = std::clamp(lastCost_, minDelay_, maxDelay_);
+  } else if (*eventIntervalMs_ < std::max(lastCost_, minDelay_).count()) {
+    // events arrive faster than they can be processed, back off
+    delay_ = std::min(maxDelay_, 2 * delay_);
+  }
+
+  const auto deadline = *batchStartTime_ + delay_;
+  return deadline > now
+      ? std::chrono::ceil<std::chrono::milliseconds>(deadline - now)
+      : std::chrono::milliseconds(0);
+}
+
+void
+AdaptiveDebounce::reportProcessed(std::chrono::milliseconds cost) {
+  lastCost_ = cost;
+  batchStartTime_ = std::nullopt;
+}
+
+std::optional<std::chrono::milliseconds>
+AdaptiveDebounce::getEventInterval() const {
+  if (not eventIntervalMs_.has_value()) {
+    return std::nullopt;
+  }
+  return std::chrono::milliseconds(static_cast<int64_t>(*eventIntervalMs_));
+}
+
+} // namespace openr
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+namespace openr {
+
+/**
+ * Debounce of event processing adapting to the measured processing cost and
+ * to the rate of incoming events.
+ *
+ * First event of a batch is debounced for the cost of the last processing
+ * (bounded by min and max delay), so that processing can't take more than
+ * about half of the time. While events keep arriving faster than that, the
+ * delay of the batch is doubled on every event up to the max delay, as with
+ * exponential backoff. An event arriving after a quiet period of max delay is
+ * isolated, which callers can use to process it right away.
+ */
+class AdaptiveDebounce {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param minDelay  Minimum delay before processing a batch of events.
+   * @param maxDelay  Maximum delay before processing a batch of events, also
+   *                  the quiet period after which an event is isolated.
+   */
+  AdaptiveDebounce(
+      std::chrono::milliseconds minDelay, std::chrono::milliseconds maxDelay);
+
+  /**
+   * Is an event arriving at `now` isolated, i.e. there is no pending batch
+   * and no event has arrived within max delay?
+   */
+  bool isIsolated(Clock::time_point now = Clock::now()) const;
+
+  /**
+   * Report arrival of an event. Returns time remaining from `now` until the
+   * pending batch should be processed.
+   */
+  std::chrono::milliseconds reportEvent(Clock::time_point now = Clock::now());
+
+  /**
+   * Report processing of the pending batch, which took `cost`
+   */
+  void reportProcessed(std::chrono::milliseconds cost);
+
+  /**
+   * Delay chosen for the pending (or last) batch
+   */
+  std::chrono::milliseconds
+  getDelay() const {
+    return delay_;
+  }
+
+  /**
+   * Smoothed interval between events, if at least two have arrived
+   */
+  std::optional<std::chrono::milliseconds> getEventInterval() const;
+
+ private:
+  const std::chrono::milliseconds minDelay_;
+  const std::chrono::milliseconds maxDelay_;
+
+  // cost of the last processing
+  std::chrono::milliseconds lastCost_{0};
+
+  // delay of the pending batch, counted from its first event
+  std::chrono::milliseconds delay_{0};
+  std::optional<Clock::time_point> batchStartTime_;
+
+  // exponentially weighted moving average of interval between events
+  std::optional<double> eventIntervalMs_;
+  std::optional<Clock::time_point> lastEventTime_;
+};
+
+} // namespace openr
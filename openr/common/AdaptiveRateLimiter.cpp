@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "AdaptiveRateLimiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glog/logging.h>
+
+namespace openr {
+
+AdaptiveRateLimiter::AdaptiveRateLimiter(
+    double minRate,
+    double maxRate,
+    double initialRate,
+    double rateStep,
+    double burst,
+    std::chrono::milliseconds targetLatency,
+    Clock::time_point now)
+    : minRate_(minRate),
+      maxRate_(maxRate),
+      rateStep_(rateStep),
+      burst_(burst),
+      targetLatency_(targetLatency),
+      rate_(std::clamp(initialRate, minRate, maxRate)),
+      tokens_(burst),
+      refillTime_(now) {
+  CHECK_LT(0, minRate_);
+  CHECK_LE(minRate_, maxRate_);
+  CHECK_LT(0, burst_);
+}
+
+void
+AdaptiveRateLimiter::refill(Clock::time_point now) {
+  if (now <= refillTime_) {
+    return;
+  }
+  const std::chrono::duration<double> elapsed = now - refillTime_;
+  tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+  refillTime_ = now;
+}
+
+double
+AdaptiveRateLimiter::getTokens(Clock::time_point now) {
+  refill(now);
+  return tokens_;
+}
+
+std::chrono::milliseconds
+AdaptiveRateLimiter::getWaitTime(double tokens, Clock::time_point now) {
+  refill(now);
+  const auto missing = std::min(tokens, burst_) - tokens_;
+  if (missing <= 0) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(
+      static_cast<int64_t>(std::ceil(missing * 1000 / rate_)));
+}
+
+void
+AdaptiveRateLimiter::consume(double tokens, Clock::time_point now) {
+  refill(now);
+  tokens_ = std::max(-burst_, tokens_ - tokens);
+}
+
+void
+AdaptiveRateLimiter::reportSuccess(std::chrono::milliseconds latency) {
+  if (latency > targetLatency_) {
+    rate_ = std::max(minRate_, rate_ / 2);
+    return;
+  }
+  rate_ = std::min(maxRate_, rate_ + rateStep_);
+}
+
+void
+AdaptiveRateLimiter::reportFailure() {
+  rate_ = std::max(minRate_, rate_ / 2);
+}
+
+} // namespace openr
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace openr {
+
+/**
+ * Token bucket pacing work (e.g. routes) sent to a consumer, whose rate
+ * adapts to how fast the consumer acknowledges it, AIMD style. Rate grows by
+ * a fixed step for every unit of work acknowledged within target latency,
+ * and is halved when one is late or fails, within [minRate, maxRate]. Hence
+ * it converges to about the rate consumer sustains without queueing up.
+ *
+ * Tokens accumulate up to burst. Urgent work may be sent without waiting,
+ * borrowing up to burst tokens, which delays the paced work after it.
+ */
+class AdaptiveRateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param minRate       Minimum rate, in tokens per second.
+   * @param maxRate       Maximum rate, in tokens per second.
+   * @param initialRate   Rate until feedback is reported.
+   * @param rateStep      Rate increase on every unit of work acknowledged
+   *                      within target latency.
+   * @param burst         Maximum number of accumulated tokens.
+   * @param targetLatency Latency of acknowledgement beyond which consumer is
+   *                      considered overloaded.
+   */
+  AdaptiveRateLimiter(
+      double minRate,
+      double maxRate,
+      double initialRate,
+      double rateStep,
+      double burst,
+      std::chrono::milliseconds targetLatency,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Tokens available at `now`, negative if borrowed
+   */
+  double getTokens(Clock::time_point now = Clock::now());
+
+  /**
+   * Time remaining from `now` until `tokens` are available, capped to burst
+   */
+  std::chrono::milliseconds getWaitTime(
+      double tokens, Clock::time_point now = Clock::now());
+
+  /**
+   * Take `tokens` for work sent at `now`, borrowing them if not available
+   */
+  void consume(double tokens, Clock::time_point now = Clock::now());
+
+  /**
+   * Report acknowledgement of unit of work sent, after `latency`
+   */
+  void reportSuccess(std::chrono::milliseconds latency);
+
+  /**
+   * Report failure of unit of work sent
+   */
+  void reportFailure();
+
+  /**
+   * Current rate, in tokens per second
+   */
+  double
+  getRate() const {
+    return rate_;
+  }
+
+ private:
+  // accumulate tokens since the last refill
+  void refill(Clock::time_point now);
+
+  const double minRate_{0};
+  const double maxRate_{0};
+  const double rateStep_{0};
+  const double burst_{0};
+  const std::chrono::milliseconds targetLatency_;
+
+  double rate_{0};
+  double tokens_{0};
+  Clock::time_point refillTime_;
+};
+
+} // namespace openr
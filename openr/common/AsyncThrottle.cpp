@@ -12,10 +12,12 @@ namespace openr {
 AsyncThrottle::AsyncThrottle(
     folly::EventBase* eventBase,
     std::chrono::milliseconds timeout,
-    TimeoutCallback callback)
+    TimeoutCallback callback,
+    Edge edge)
     : AsyncTimeout(eventBase),
       timeout_(timeout),
-      callback_(std::move(callback)) {
+      callback_(std::move(callback)),
+      edge_(edge) {
   CHECK(callback_);
 }
 
@@ -23,6 +25,7 @@ void
 AsyncThrottle::operator()() noexcept {
   // Return immediately as callback is already scheduled.
   if (isScheduled()) {
+    pending_ = true;
     return;
   }
 
@@ -33,10 +36,22 @@ AsyncThrottle::operator()() noexcept {
   }
 
   scheduleTimeout(timeout_);
+  // window is open before callback, which may call again
+  if (edge_ == Edge::LEADING) {
+    pending_ = false;
+    callback_();
+  }
 }
 
 void
 AsyncThrottle::timeoutExpired() noexcept {
+  if (edge_ == Edge::LEADING) {
+    if (not pending_) {
+      return;
+    }
+    pending_ = false;
+    scheduleTimeout(timeout_);
+  }
   callback_();
 }
 
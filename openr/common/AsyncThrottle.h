@@ -29,13 +29,25 @@ using TimeoutCallback = folly::Function<void(void)>;
  *
  *  And then call `throttledSaveState()` on every `addKey` and `removeKey` but
  *  internally `saveState()` will be execute at max once per second.
+ *
+ * By default callback is executed on the trailing edge, i.e. `timeout` after
+ * the first call. With leading edge, callback is executed right away on a
+ * call made while idle, and the calls made within `timeout` after are
+ * coalesced into one execution at its end (which starts a new window), so
+ * isolated events are not delayed.
  */
 class AsyncThrottle final : private folly::AsyncTimeout {
  public:
+  enum class Edge {
+    TRAILING,
+    LEADING,
+  };
+
   AsyncThrottle(
       folly::EventBase* eventBase,
       std::chrono::milliseconds timeout,
-      TimeoutCallback callback);
+      TimeoutCallback callback,
+      Edge edge = Edge::TRAILING);
 
   ~AsyncThrottle() override = default;
 
@@ -46,18 +58,23 @@ class AsyncThrottle final : private folly::AsyncTimeout {
   void operator()() noexcept;
 
   /**
-   * Tells you if this is currently active ?
+   * Tells you if this is currently active, i.e. callback is scheduled ?
    */
   bool
   isActive() const {
-    return isScheduled();
+    return isScheduled() and (edge_ == Edge::TRAILING or pending_);
   }
 
   /**
-   * Cancel scheduled throttle
+   * Cancel scheduled throttle. With leading edge, window of the last
+   * execution is kept, calls within it are still coalesced
    */
   void
   cancel() {
+    if (edge_ == Edge::LEADING) {
+      pending_ = false;
+      return;
+    }
     cancelTimeout();
   }
 
@@ -69,6 +86,10 @@ class AsyncThrottle final : private folly::AsyncTimeout {
 
   const std::chrono::milliseconds timeout_{0};
   TimeoutCallback callback_{nullptr};
+  const Edge edge_{Edge::TRAILING};
+
+  // with leading edge, whether a call was made within current window
+  bool pending_{false};
 };
 
 } // namespace openr
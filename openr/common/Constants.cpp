@@ -13,6 +13,8 @@ constexpr double Constants::kRttChangeThreashold;
 constexpr folly::StringPiece Constants::kAdjDbMarker;
 constexpr folly::StringPiece Constants::kErrorResponse;
 constexpr folly::StringPiece Constants::kEventLogCategory;
+constexpr size_t Constants::kEventLogQueueCapacity;
+constexpr uint32_t Constants::kEventLogMaxEventsPerSec;
 constexpr folly::StringPiece Constants::kFibTimeMarker;
 constexpr folly::StringPiece Constants::kGlobalCmdLocalIdTemplate;
 constexpr folly::StringPiece Constants::kNodeLabelRangePrefix;
@@ -20,6 +22,7 @@ constexpr folly::StringPiece Constants::kOpenrCtrlSessionContext;
 constexpr folly::StringPiece Constants::kPlatformHost;
 constexpr folly::StringPiece Constants::kPrefixAllocMarker;
 constexpr folly::StringPiece Constants::kPrefixDbMarker;
+constexpr folly::StringPiece Constants::kPrefixLeaseAllocParamKey;
 constexpr folly::StringPiece Constants::kPrefixNameSeparator;
 constexpr folly::StringPiece Constants::kSeedPrefixAllocLenSeparator;
 constexpr folly::StringPiece Constants::kSeedPrefixAllocParamKey;
@@ -38,6 +41,7 @@ constexpr int32_t Constants::kMonitorPubPort;
 constexpr int32_t Constants::kMonitorRepPort;
 constexpr int32_t Constants::kOpenrSupportedVersion;
 constexpr int32_t Constants::kOpenrVersion;
+constexpr int32_t Constants::kSparkCompactHeartbeatVersion;
 constexpr int32_t Constants::kSparkMcastPort;
 constexpr int32_t Constants::kSystemAgentPort;
 constexpr int64_t Constants::kDefaultAdjWeight;
@@ -46,6 +50,7 @@ constexpr size_t Constants::kNumTimeSeries;
 constexpr std::chrono::milliseconds Constants::kFloodPendingPublication;
 constexpr std::chrono::milliseconds Constants::kInitialBackoff;
 constexpr std::chrono::milliseconds Constants::kKeepAliveCheckInterval;
+constexpr std::chrono::milliseconds Constants::kFibInflightBatchWaitInterval;
 constexpr std::chrono::milliseconds Constants::kKvStoreDbTtl;
 constexpr std::chrono::milliseconds Constants::kLinkImmediateTimeout;
 constexpr std::chrono::milliseconds Constants::kLinkThrottleTimeout;
@@ -61,23 +66,49 @@ constexpr std::chrono::milliseconds Constants::kPrefixAllocatorRetryInterval;
 constexpr std::chrono::milliseconds Constants::kPrefixAllocatorSyncInterval;
 constexpr std::chrono::milliseconds Constants::kPrefixMgrKvThrottleTimeout;
 constexpr std::chrono::milliseconds Constants::kRangeAllocTtl;
+constexpr uint64_t Constants::kRangeAllocBitmapMaxSize;
 constexpr std::chrono::milliseconds Constants::kReadTimeout;
 constexpr std::chrono::milliseconds Constants::kServiceConnTimeout;
 constexpr std::chrono::milliseconds Constants::kServiceProcTimeout;
 constexpr std::chrono::milliseconds Constants::kTtlDecrement;
 constexpr std::chrono::milliseconds Constants::kTtlInfInterval;
 constexpr std::chrono::milliseconds Constants::kTtlThreshold;
+constexpr size_t Constants::kKvStoreSnapshotShards;
+constexpr size_t Constants::kPersistKeyCheckChunkSize;
+constexpr size_t Constants::kParallelMergeMinKeys;
 constexpr std::chrono::milliseconds Constants::kLongPollReqHoldTime;
+constexpr std::chrono::milliseconds Constants::kCtrlResponseCacheTtl;
+constexpr size_t Constants::kCtrlResponseCacheMaxEntries;
+constexpr size_t Constants::kCtrlMaxTrackedCallers;
 constexpr std::chrono::seconds Constants::kConvergenceMaxDuration;
 constexpr std::chrono::seconds Constants::kKeepAliveIntvl;
 constexpr std::chrono::seconds Constants::kKeepAliveTime;
 constexpr std::chrono::seconds Constants::kMemoryThresholdTime;
+constexpr std::chrono::milliseconds Constants::kEvbLagProbeInterval;
+constexpr std::chrono::seconds Constants::kCpuProfileMaxDuration;
+constexpr uint32_t Constants::kCpuProfileMaxFrequencyHz;
 constexpr std::chrono::seconds Constants::kCounterSubmitInterval;
 constexpr std::chrono::seconds Constants::kNetlinkSyncThrottleInterval;
 constexpr std::chrono::seconds Constants::kPlatformSyncInterval;
+constexpr std::chrono::seconds Constants::kInterfaceDbSnapshotInterval;
+constexpr std::chrono::seconds Constants::kPlatformEventDrivenSyncInterval;
+constexpr std::chrono::milliseconds Constants::kPlatformEventCoalesceWindow;
+constexpr std::chrono::seconds Constants::kPlatformRouteAuditInterval;
 constexpr std::chrono::seconds Constants::kPlatformThriftIdleTimeout;
 constexpr std::chrono::seconds Constants::kStoreSyncInterval;
 constexpr size_t Constants::kMaxFullSyncPendingCountThreshold;
+constexpr size_t Constants::kFullSyncChunkBuckets;
+constexpr size_t Constants::kFullSyncChunksInFlight;
+constexpr size_t Constants::kFloodQueueMaxDepth;
+constexpr size_t Constants::kFloodMaxInFlight;
+constexpr std::chrono::milliseconds Constants::kFloodRetryInterval;
+constexpr size_t Constants::kFloodDedupCacheSize;
+constexpr std::chrono::milliseconds Constants::kFloodDedupWindow;
+constexpr size_t Constants::kFibProgrammingBatchSize;
+constexpr size_t Constants::kFibMaxInflightBatches;
+constexpr size_t Constants::kFibCompactSyncChunkSize;
+constexpr size_t Constants::kDecisionMinPrefixesPerShard;
+constexpr size_t Constants::kDecisionMaxComputedRouteDbs;
 constexpr std::pair<int32_t, int32_t> Constants::kSrGlobalRange;
 constexpr std::pair<int32_t, int32_t> Constants::kSrLocalRange;
 constexpr uint16_t Constants::kPerfBufferSize;
@@ -73,6 +73,13 @@ class Constants {
   // event log category
   static constexpr folly::StringPiece kEventLogCategory{"perfpipe_aquaman"};
 
+  // Bound on events queued for the background event logger, beyond which
+  // events are dropped
+  static constexpr size_t kEventLogQueueCapacity{4096};
+
+  // Max events of a type shipped by event logger per second
+  static constexpr uint32_t kEventLogMaxEventsPerSec{100};
+
   // ExponentialBackoff durations
   static constexpr std::chrono::milliseconds kInitialBackoff{64};
   static constexpr std::chrono::milliseconds kMaxBackoff{8192};
@@ -92,6 +99,42 @@ class Constants {
   // kMaxBackoff to send the next sync request
   static constexpr size_t kMaxFullSyncPendingCountThreshold{32};
 
+  // number of hash tree buckets requested from peer in one chunk of full-sync
+  // over thrift, and max number of chunk requests in flight per peer
+  static constexpr size_t kFullSyncChunkBuckets{64};
+  static constexpr size_t kFullSyncChunksInFlight{2};
+
+  // max number of flood requests queued for a peer, before giving up on
+  // flooding and full-syncing with it instead
+  static constexpr size_t kFloodQueueMaxDepth{1000};
+
+  // max number of flood requests in flight (not acked yet) to a thrift peer
+  static constexpr size_t kFloodMaxInFlight{16};
+
+  // interval to retry sending queued flood requests, when ZMQ socket is full
+  static constexpr std::chrono::milliseconds kFloodRetryInterval{10};
+
+  // number of recently flooded key-values remembered to drop duplicate
+  // deliveries of them (over redundant flooding paths) before merge
+  static constexpr size_t kFloodDedupCacheSize{10000};
+
+  // window within which a repeated delivery of a key-value is a duplicate
+  static constexpr std::chrono::milliseconds kFloodDedupWindow{1000};
+
+  //
+  // Decision specific
+
+  // minimum number of prefixes handed to each shard when unicast routes are
+  // built in parallel. Smaller prefix sets are built on the calling thread
+  static constexpr size_t kDecisionMinPrefixesPerShard{1024};
+
+  // max number of routeDbs computed from perspective of other nodes to cache
+  static constexpr size_t kDecisionMaxComputedRouteDbs{1024};
+
+  // number of journaled route updates after which Decision checks its cached
+  // routes against the full routes of all areas
+  static constexpr size_t kDecisionRouteDbCheckInterval{100};
+
   //
   // PrefixAllocator specific
 
@@ -110,6 +153,10 @@ class Constants {
   static constexpr folly::StringPiece kStaticPrefixAllocParamKey{
       "e2e-network-allocations"};
 
+  // kvstore key for prefixes leased to nodes by root node in lease mode
+  static constexpr folly::StringPiece kPrefixLeaseAllocParamKey{
+      "e2e-network-prefix-leases"};
+
   //
   // LinkMonitor specific
   //
@@ -155,9 +202,54 @@ class Constants {
   // time interval to sync between Open/R and Platform
   static constexpr std::chrono::seconds kPlatformSyncInterval{60};
 
+  // time interval to sync between Open/R and Platform when platform events
+  // carry sequence numbers. Sync is triggered right away on gap in sequence
+  // numbers, periodic sync is only a safety net
+  static constexpr std::chrono::seconds kPlatformEventDrivenSyncInterval{600};
+
+  // time interval of full snapshot of interfaces published by LinkMonitor.
+  // Only changed interfaces are published in between
+  static constexpr std::chrono::seconds kInterfaceDbSnapshotInterval{300};
+
+  // Window within which platform publisher coalesces bursts of link/address
+  // events (e.g. on linecard reset) into a single batch of latest states
+  static constexpr std::chrono::milliseconds kPlatformEventCoalesceWindow{10};
+
+  // Interval at which platform audits its shadow of programmed routes against
+  // the routes in kernel, on sync from Open/R
+  static constexpr std::chrono::seconds kPlatformRouteAuditInterval{600};
+
   // time interval for keep alive check between fib and switch agent
   static constexpr std::chrono::milliseconds kKeepAliveCheckInterval{1000};
 
+  // Maximum number of queued route deltas Fib coalesces before programming
+  static constexpr size_t kMaxRouteDeltaBatchSize{64};
+
+  // Maximum number of routes Fib programs with single batch of requests and
+  // maximum number of such batches outstanding with switch agent
+  static constexpr size_t kFibProgrammingBatchSize{1024};
+  static constexpr size_t kFibMaxInflightBatches{4};
+
+  // Bounds and initial value of the rate (routes per second) large backlogs
+  // of route updates are paced at. Rate grows by step for every batch
+  // programmed within target latency, and is halved otherwise
+  static constexpr double kFibMinProgrammingRate{1000};
+  static constexpr double kFibMaxProgrammingRate{200000};
+  static constexpr double kFibInitialProgrammingRate{20000};
+  static constexpr double kFibProgrammingRateStep{1000};
+  static constexpr std::chrono::milliseconds kFibTargetBatchLatency{500};
+
+  // Maximum number of routes sent with single chunk of compact route sync
+  static constexpr size_t kFibCompactSyncChunkSize{4096};
+
+  // Interval at which full sync of routes is retried while route batches are
+  // still being programmed
+  static constexpr std::chrono::milliseconds kFibInflightBatchWaitInterval{10};
+
+  // Soft limit on depth of inter-module queues. Beyond it readers consider
+  // themselves lagging, e.g. Fib coalesces all the queued route deltas
+  static constexpr size_t kQueueSoftLimit{256};
+
   // Timeout duration for which if a client connection has no activity, then it
   // will be dropped. We keep it 3 * kPlatformSyncInterval so that thrift
   // connection between OpenR and platform service remains up forever under
@@ -187,6 +279,11 @@ class Constants {
   // RangeAllocator keys TTLs
   static constexpr std::chrono::milliseconds kRangeAllocTtl{5min};
 
+  // Max size of range for which RangeAllocator tracks used values in bitmap
+  // (2MB of memory). Collisions in bigger ranges are rare, and values are
+  // probed one at a time instead
+  static constexpr uint64_t kRangeAllocBitmapMaxSize{1 << 24};
+
   // delimiter separating prefix and name in kvstore key
   static constexpr folly::StringPiece kPrefixNameSeparator{":"};
 
@@ -205,6 +302,13 @@ class Constants {
 
   // max interval to update TTL for each key in kvstore w/ finite TTL
   static constexpr std::chrono::milliseconds kMaxTtlUpdateInterval{2h};
+  // max jitter of TTL refresh interval of a key, as fraction of the interval,
+  // so that keys persisted together don't refresh in lockstep
+  static constexpr double kTtlRefreshJitter{0.25};
+  // max number of TTL refreshes advertised by a client into an area at once.
+  // Excess refreshes are deferred to the next batch after batch interval
+  static constexpr size_t kTtlRefreshMaxBatchSize{1000};
+  static constexpr std::chrono::milliseconds kTtlRefreshBatchInterval{100};
   // TTL infinity, never expires
   // int version
   static constexpr int64_t kTtlInfinity{INT32_MIN};
@@ -215,9 +319,27 @@ class Constants {
   // ms version
   static constexpr std::chrono::milliseconds kTtlInfInterval{kTtlInfinity};
 
+  // number of copy-on-write shards of KvStore snapshot for off-thread reads
+  static constexpr size_t kKvStoreSnapshotShards{64};
+
+  // max number of key-values returned in one page of paged KvStore dump
+  static constexpr size_t kKvStoreMaxDumpPageSize{10000};
+
+  // max number of persisted keys checked against KvStore in one request
+  static constexpr size_t kPersistKeyCheckChunkSize{1000};
+
+  // min number of key-values in publication merged in parallel by KvStore,
+  // if merge threads are configured
+  static constexpr size_t kParallelMergeMinKeys{10000};
+
   // adjacencies can have weights for weighted ecmp
   static constexpr int64_t kDefaultAdjWeight{1};
 
+  // max sum of UCMP nexthop weights of a route, i.e. size of its nexthop
+  // group once weights are expanded into members. Also keeps every weight
+  // within the 8 bit weight of kernel nexthops
+  static constexpr int64_t kMaxNextHopWeightSum{128};
+
   // buffer size to keep latest perf log
   static constexpr uint16_t kPerfBufferSize{10};
   static constexpr std::chrono::seconds kConvergenceMaxDuration{3s};
@@ -225,6 +347,23 @@ class Constants {
   // hold time for longPoll requests in openrCtrl thrift server
   static constexpr std::chrono::milliseconds kLongPollReqHoldTime{20000};
 
+  // max lifetime and count of cached responses of read APIs in openrCtrl
+  // thrift server. Responses are invalidated on module updates regardless
+  static constexpr std::chrono::milliseconds kCtrlResponseCacheTtl{1000};
+  static constexpr size_t kCtrlResponseCacheMaxEntries{64};
+
+  // max number of distinct callers of openrCtrl thrift server with their own
+  // counters, rest of callers are accounted as "other"
+  static constexpr size_t kCtrlMaxTrackedCallers{64};
+
+  // responses of openrCtrl thrift server of at least this size are zstd
+  // compressed, for clients requesting it. Smaller ones are not worth it
+  static constexpr uint32_t kCtrlMinCompressBytes{16 * 1024};
+
+  // threads of openrCtrl thrift server building and serializing large read
+  // responses, e.g. full KvStore and route dumps
+  static constexpr size_t kCtrlResponseThreads{2};
+
   //
   // Prefix manager specific
   //
@@ -232,6 +371,10 @@ class Constants {
   // the time we hold on to announce to KvStore
   static constexpr std::chrono::milliseconds kPrefixMgrKvThrottleTimeout{250};
 
+  // prefix update batches buffered by the sink of a prefix update stream,
+  // bounding batches in flight from the agent
+  static constexpr uint64_t kPrefixUpdateSinkBufferSize{16};
+
   // OpenR ports
 
   // Openr Ctrl thrift server port
@@ -256,10 +399,14 @@ class Constants {
   static constexpr int32_t kSparkMcastPort{6666};
 
   // Current OpenR version
+  // 20200825 - Spark compact heartbeat feature
   // 20200421 - Spark2 Area feature
   // 20191010 - Spark2 feature
   // 20190805 - per prefix key feature
-  static constexpr int32_t kOpenrVersion{20200421};
+  static constexpr int32_t kOpenrVersion{20200825};
+
+  // Lowest OpenR version supporting compact Spark heartbeat encoding
+  static constexpr int32_t kSparkCompactHeartbeatVersion{20200825};
 
   // Lowest Supported OpenR version
   static constexpr int32_t kOpenrSupportedVersion{20191010};
@@ -267,6 +414,13 @@ class Constants {
   // Threshold time in secs to crash after reaching critical memory
   static constexpr std::chrono::seconds kMemoryThresholdTime{600};
 
+  // Interval of probes measuring event-loop lag of monitored modules
+  static constexpr std::chrono::milliseconds kEvbLagProbeInterval{250};
+
+  // Bounds of CPU profiles taken through ctrl API
+  static constexpr std::chrono::seconds kCpuProfileMaxDuration{60};
+  static constexpr uint32_t kCpuProfileMaxFrequencyHz{1000};
+
   static const std::list<std::string>&
   getNextProtocolsForThriftServers() {
     static const std::list<std::string> result{
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "EventLogger.h"
+
+#include <fb303/ServiceData.h>
+#include <fbzmq/service/logging/LogSample.h>
+#include <folly/system/ThreadName.h>
+#include <glog/logging.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+// max samples shipped in a single EventLog
+const size_t kMaxSamplesPerLog{64};
+
+} // namespace
+
+namespace openr {
+
+EventLogger::EventLogger(
+    std::string const& counterPrefix, Sink sink, Options options)
+    : loggedCounter_(counterPrefix + ".event_log.logged"),
+      droppedCounter_(counterPrefix + ".event_log.dropped"),
+      rateLimitedCounter_(counterPrefix + ".event_log.rate_limited"),
+      sampledOutCounter_(counterPrefix + ".event_log.sampled_out"),
+      sink_(std::move(sink)),
+      options_(std::move(options)),
+      queue_(options_.queueCapacity) {
+  CHECK(sink_) << "Sink of event logs must be set";
+  fb303::fbData->addStatExportType(loggedCounter_, fb303::SUM);
+  fb303::fbData->addStatExportType(droppedCounter_, fb303::SUM);
+  fb303::fbData->addStatExportType(rateLimitedCounter_, fb303::SUM);
+  fb303::fbData->addStatExportType(sampledOutCounter_, fb303::SUM);
+
+  thread_ = std::thread([this, name = "EventLog." + counterPrefix]() {
+    folly::setThreadName(name);
+    run();
+  });
+}
+
+EventLogger::~EventLogger() {
+  stopping_ = true;
+  // event without type tells the background thread to stop, once it shipped
+  // all events queued before
+  queue_.blockingWrite(Event{});
+  thread_.join();
+}
+
+void
+EventLogger::log(Event&& event) {
+  if (event.event.empty() or stopping_) {
+    return;
+  }
+  event.time = std::chrono::system_clock::now();
+  if (not queue_.write(std::move(event))) {
+    fb303::fbData->addStatValue(droppedCounter_, 1, fb303::SUM);
+  }
+}
+
+bool
+EventLogger::admit(Event const& event) {
+  auto& state = typeStates_[event.event];
+  const auto seen = state.seen++;
+
+  auto rateIt = options_.sampleRates.find(event.event);
+  if (rateIt != options_.sampleRates.end() and rateIt->second > 1 and
+      seen % rateIt->second != 0) {
+    fb303::fbData->addStatValue(sampledOutCounter_, 1, fb303::SUM);
+    return false;
+  }
+
+  if (options_.maxEventsPerSec > 0) {
+    if (event.time - state.windowStart >= std::chrono::seconds(1)) {
+      state.windowStart = event.time;
+      state.windowCount = 0;
+    }
+    if (state.windowCount >= options_.maxEventsPerSec) {
+      fb303::fbData->addStatValue(rateLimitedCounter_, 1, fb303::SUM);
+      return false;
+    }
+    ++state.windowCount;
+  }
+  return true;
+}
+
+void
+EventLogger::run() {
+  bool stop{false};
+  while (not stop) {
+    Event event;
+    queue_.blockingRead(event);
+
+    // ship events queued meanwhile along in the same EventLog
+    std::vector<std::string> samples;
+    do {
+      if (event.event.empty()) {
+        stop = true;
+        break;
+      }
+      if (not admit(event)) {
+        continue;
+      }
+      fbzmq::LogSample sample(event.time);
+      sample.addString("event", event.event);
+      for (auto const& [key, value] : event.strings) {
+        sample.addString(key, value);
+      }
+      for (auto const& [key, value] : event.ints) {
+        sample.addInt(key, value);
+      }
+      for (auto const& [key, value] : event.stringVectors) {
+        sample.addStringVector(key, value);
+      }
+      samples.emplace_back(sample.toJson());
+    } while (samples.size() < kMaxSamplesPerLog and queue_.read(event));
+
+    if (samples.empty()) {
+      continue;
+    }
+    fb303::fbData->addStatValue(loggedCounter_, samples.size(), fb303::SUM);
+    sink_(fbzmq::thrift::EventLog(
+        apache::thrift::FRAGILE,
+        Constants::kEventLogCategory.toString(),
+        std::move(samples)));
+  }
+}
+
+} // namespace openr
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fbzmq/service/if/gen-cpp2/Monitor_types.h>
+#include <folly/MPMCQueue.h>
+
+#include <openr/common/Constants.h>
+
+namespace openr {
+
+/**
+ * Structured event logging off the module thread.
+ *
+ * Modules push compact events, field names being string literals, into a
+ * bounded lock-free queue. A background thread samples and rate limits them
+ * per event type, formats them into fbzmq::LogSample JSON and hands them to
+ * the sink, e.g. a ZmqMonitorClient which is then only used from that thread.
+ * Events pushed while the queue is full are dropped and counted.
+ *
+ * Counters, prefixed with the given name:
+ * - <prefix>.event_log.logged
+ * - <prefix>.event_log.dropped: queue was full
+ * - <prefix>.event_log.rate_limited
+ * - <prefix>.event_log.sampled_out
+ */
+class EventLogger {
+ public:
+  struct Event {
+    // event type, e.g. "KVSTORE_FULL_SYNC"
+    std::string event;
+    std::vector<std::pair<const char*, std::string>> strings;
+    std::vector<std::pair<const char*, int64_t>> ints;
+    std::vector<std::pair<const char*, std::vector<std::string>>>
+        stringVectors;
+    // set by log()
+    std::chrono::system_clock::time_point time;
+  };
+
+  struct Options {
+    size_t queueCapacity{Constants::kEventLogQueueCapacity};
+    // max events of a type shipped per second, 0 for unlimited
+    uint32_t maxEventsPerSec{Constants::kEventLogMaxEventsPerSec};
+    // ship one in N events of the type
+    std::unordered_map<std::string, uint32_t> sampleRates;
+  };
+
+  using Sink = std::function<void(fbzmq::thrift::EventLog&&)>;
+
+  EventLogger(std::string const& counterPrefix, Sink sink, Options options);
+
+  EventLogger(std::string const& counterPrefix, Sink sink)
+      : EventLogger(counterPrefix, std::move(sink), Options{}) {}
+
+  // ships events still queued before returning
+  ~EventLogger();
+
+  EventLogger(EventLogger const&) = delete;
+  EventLogger& operator=(EventLogger const&) = delete;
+
+  // push event for shipping, from any thread. Never blocks
+  void log(Event&& event);
+
+ private:
+  void run();
+
+  // whether event passes sampling and rate limit of its type
+  bool admit(Event const& event);
+
+  const std::string loggedCounter_;
+  const std::string droppedCounter_;
+  const std::string rateLimitedCounter_;
+  const std::string sampledOutCounter_;
+  const Sink sink_;
+  const Options options_;
+
+  folly::MPMCQueue<Event> queue_;
+  std::atomic<bool> stopping_{false};
+
+  // rate limit and sampling state of each event type, background thread only
+  struct TypeState {
+    uint64_t seen{0};
+    std::chrono::system_clock::time_point windowStart;
+    uint32_t windowCount{0};
+  };
+  std::unordered_map<std::string, TypeState> typeStates_;
+
+  std::thread thread_;
+};
+
+} // namespace openr
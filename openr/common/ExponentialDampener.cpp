@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ExponentialDampener.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glog/logging.h>
+
+namespace openr {
+
+ExponentialDampener::ExponentialDampener(
+    std::chrono::milliseconds halfLife,
+    double suppressThreshold,
+    double reuseThreshold,
+    std::chrono::milliseconds maxSuppressTime)
+    : halfLife_(halfLife),
+      suppressThreshold_(suppressThreshold),
+      reuseThreshold_(reuseThreshold),
+      maxPenalty_(
+          reuseThreshold *
+          std::exp2(
+              static_cast<double>(maxSuppressTime.count()) / halfLife.count())),
+      lastUpdateTime_(std::chrono::steady_clock::now()) {
+  CHECK(halfLife > std::chrono::milliseconds(0))
+      << "Half-life must be positive value";
+  CHECK(reuseThreshold > 0) << "Reuse threshold must be positive value";
+  CHECK(reuseThreshold < suppressThreshold)
+      << "Suppress threshold must be greater than reuse threshold";
+}
+
+bool
+ExponentialDampener::addPenalty(double penalty) {
+  penalty_ = std::min(maxPenalty_, getPenalty() + penalty);
+  lastUpdateTime_ = std::chrono::steady_clock::now();
+  if (penalty_ > suppressThreshold_) {
+    suppressed_ = true;
+  }
+  return isSuppressed();
+}
+
+bool
+ExponentialDampener::isSuppressed() {
+  if (suppressed_ and getPenalty() < reuseThreshold_) {
+    suppressed_ = false;
+  }
+  return suppressed_;
+}
+
+double
+ExponentialDampener::getPenalty() const {
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - lastUpdateTime_;
+  return penalty_ * std::exp2(-elapsed.count() / halfLife_.count());
+}
+
+std::chrono::milliseconds
+ExponentialDampener::getTimeRemainingUntilReuse() const {
+  const auto penalty = getPenalty();
+  if (not suppressed_ or penalty < reuseThreshold_) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(static_cast<int64_t>(
+      std::ceil(halfLife_.count() * std::log2(penalty / reuseThreshold_))));
+}
+
+} // namespace openr
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace openr {
+
+/**
+ * Exponential-decay dampening of flapping events, similar to BGP route flap
+ * damping (RFC 2439).
+ *
+ * Every event adds a penalty, which decays exponentially with configured
+ * half-life. Once the penalty exceeds suppress threshold, dampener becomes
+ * suppressed and stays so until the penalty decays below reuse threshold.
+ * Penalty is capped, so that dampener is never suppressed for longer than
+ * max suppress time after the last event.
+ */
+class ExponentialDampener {
+ public:
+  /**
+   * @param halfLife          Time for penalty to decay to half of its value.
+   * @param suppressThreshold Penalty above which dampener gets suppressed.
+   * @param reuseThreshold    Penalty below which suppression ends.
+   * @param maxSuppressTime   Maximum time to stay suppressed.
+   */
+  ExponentialDampener(
+      std::chrono::milliseconds halfLife,
+      double suppressThreshold,
+      double reuseThreshold,
+      std::chrono::milliseconds maxSuppressTime);
+
+  /**
+   * Add penalty of an event. Returns true if dampener is suppressed
+   */
+  bool addPenalty(double penalty);
+
+  /**
+   * Is dampener suppressed? Ends suppression if penalty has decayed below
+   * reuse threshold
+   */
+  bool isSuppressed();
+
+  /**
+   * Current (decayed) penalty
+   */
+  double getPenalty() const;
+
+  /**
+   * Get the time remaining until suppression ends. Returns 0 if not
+   * suppressed
+   */
+  std::chrono::milliseconds getTimeRemainingUntilReuse() const;
+
+ private:
+  const std::chrono::milliseconds halfLife_;
+  const double suppressThreshold_{0};
+  const double reuseThreshold_{0};
+
+  // penalty which decays to reuse threshold in max suppress time
+  const double maxPenalty_{0};
+
+  // penalty as of last update time
+  double penalty_{0};
+  std::chrono::steady_clock::time_point lastUpdateTime_;
+
+  bool suppressed_{false};
+};
+
+} // namespace openr
@@ -227,12 +227,32 @@ DEFINE_int32(
     250,
     "Decision debounce time to update spf in frequent adj db update "
     "(in milliseconds)");
+DEFINE_bool(
+    enable_incremental_spf,
+    false,
+    "Incrementally repair memoized SPF results on single link metric or "
+    "overload changes instead of rerunning full SPF");
+DEFINE_int32(
+    decision_route_build_threads,
+    0,
+    "Number of threads to build routes of different areas in parallel. Routes "
+    "are built on the Decision thread if 0");
+DEFINE_bool(
+    enable_nexthop_groups,
+    false,
+    "Publish unicast routes from Decision with references to shared nexthop "
+    "groups instead of their own nexthops");
 DEFINE_bool(
     enable_watchdog,
     true,
     "Enable watchdog thread to periodically check aliveness counters from each "
     "openr thread, if unhealthy thread is detected, force crash openr");
 DEFINE_int32(watchdog_interval_s, 20, "Watchdog thread healthcheck interval");
+DEFINE_bool(
+    enable_module_arenas,
+    true,
+    "Allocate memory of each module thread from a dedicated jemalloc arena, "
+    "so that allocation churn of one module doesn't fragment memory of others");
 DEFINE_int32(watchdog_threshold_s, 300, "Watchdog thread aliveness threshold");
 DEFINE_bool(
     enable_segment_routing, false, "Flag to disable/enable segment routing");
@@ -314,6 +334,15 @@ DEFINE_string(
     "will accept connections from any authenticated peer.");
 DEFINE_bool(enable_flood_optimization, false, "Enable flooding optimization");
 DEFINE_bool(is_flood_root, false, "set myself as flooding root or not");
+DEFINE_bool(
+    enable_kvstore_hash_tree_sync,
+    false,
+    "Exchange hash tree digests instead of all key hashes in KvStore "
+    "full-sync");
+DEFINE_bool(
+    enable_kvstore_value_compression,
+    false,
+    "Compress adjacency and prefix databases stored and flooded by KvStore");
 // TODO this option will be deprecated in near future, this is just for safely
 // rollout purpose
 DEFINE_bool(
@@ -79,9 +79,13 @@ DECLARE_bool(enable_rib_policy);
 
 DECLARE_int32(decision_debounce_min_ms);
 DECLARE_int32(decision_debounce_max_ms);
+DECLARE_bool(enable_incremental_spf);
+DECLARE_int32(decision_route_build_threads);
+DECLARE_bool(enable_nexthop_groups);
 
 DECLARE_bool(enable_watchdog);
 DECLARE_int32(watchdog_interval_s);
+DECLARE_bool(enable_module_arenas);
 DECLARE_int32(watchdog_threshold_s);
 
 DECLARE_bool(enable_segment_routing);
@@ -108,6 +112,8 @@ DECLARE_string(tls_ecc_curve_name);
 DECLARE_string(tls_acceptable_peers);
 
 DECLARE_bool(enable_flood_optimization);
+DECLARE_bool(enable_kvstore_hash_tree_sync);
+DECLARE_bool(enable_kvstore_value_compression);
 DECLARE_bool(is_flood_root);
 DECLARE_bool(use_flood_optimization);
 
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+
+namespace openr {
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr int64_t LatencyHistogram::kSubBuckets;
+
+LatencyHistogram::LatencyHistogram(int64_t maxValue)
+    : maxValue_(std::max<int64_t>(maxValue, 0)),
+      counts_(getBucketIndex(maxValue_) + 1, 0) {}
+
+size_t
+LatencyHistogram::getBucketIndex(int64_t value) {
+  // values below kSubBuckets are bucketed exactly
+  if (value < kSubBuckets) {
+    return value;
+  }
+  // keep the kSubBucketBits bits following the most significant bit
+  const int shift =
+      folly::findLastSet(static_cast<uint64_t>(value)) - 1 - kSubBucketBits;
+  const int64_t subBucket = (value >> shift) - kSubBuckets;
+  return kSubBuckets + shift * kSubBuckets + subBucket;
+}
+
+int64_t
+LatencyHistogram::getBucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const int shift = (index - kSubBuckets) / kSubBuckets;
+  const int64_t subBucket = (index - kSubBuckets) % kSubBuckets;
+  return ((kSubBuckets + subBucket) << shift) + (int64_t{1} << shift) - 1;
+}
+
+void
+LatencyHistogram::addValue(int64_t value) {
+  value = std::clamp<int64_t>(value, 0, maxValue_);
+  ++counts_.at(getBucketIndex(value));
+  ++count_;
+  max_ = std::max(max_, value);
+}
+
+int64_t
+LatencyHistogram::getPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto rank = std::max<uint64_t>(
+      1,
+      static_cast<uint64_t>(
+          std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * count_)));
+  uint64_t seen{0};
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(getBucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+} // namespace openr
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openr {
+
+/**
+ * Fixed-memory histogram of latencies (non-negative values, e.g. in ms), in
+ * the style of HDR histograms. Values are bucketed log-linearly: every power
+ * of two range is split into kSubBuckets linear buckets, so percentiles are
+ * within 1/kSubBuckets of the actual value, while number of buckets only
+ * grows with the log of the max value. Values above max are counted in the
+ * last bucket.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits{3};
+  static constexpr int64_t kSubBuckets{1 << kSubBucketBits};
+
+  explicit LatencyHistogram(int64_t maxValue);
+
+  void addValue(int64_t value);
+
+  uint64_t
+  getCount() const {
+    return count_;
+  }
+
+  int64_t
+  getMax() const {
+    return max_;
+  }
+
+  /**
+   * Value at or below which `percentile` (in [0, 100]) of the added values
+   * are, i.e. upper bound of the bucket holding it. Returns 0 if empty
+   */
+  int64_t getPercentile(double percentile) const;
+
+ private:
+  static size_t getBucketIndex(int64_t value);
+
+  static int64_t getBucketUpperBound(size_t index);
+
+  const int64_t maxValue_{0};
+
+  std::vector<uint64_t> counts_;
+
+  uint64_t count_{0};
+
+  int64_t max_{0};
+};
+
+} // namespace openr
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+#include <fb303/ServiceData.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
+#include <glog/logging.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+const folly::StringPiece kMemoryCounterPrefix{"memory."};
+const folly::StringPiece kMemoryCounterSuffix{"_bytes"};
+
+// heap bytes of a string, none if held inline by short string optimization
+size_t
+getHeapUsage(const std::string& str) {
+  return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+}
+
+std::atomic<bool> moduleArenasEnabled{false};
+
+// jemalloc arena index of each module
+folly::Synchronized<std::map<std::string, unsigned>> moduleArenas;
+
+size_t
+readArenaStat(unsigned arena, folly::StringPiece stat) {
+  size_t value{0};
+  folly::mallctlRead(
+      folly::sformat("stats.arenas.{}.{}", arena, stat).c_str(), &value);
+  return value;
+}
+
+} // namespace
+
+namespace openr {
+
+std::string
+getMemoryCounterName(folly::StringPiece module, folly::StringPiece structure) {
+  return folly::sformat(
+      "{}{}.{}{}",
+      kMemoryCounterPrefix,
+      module,
+      structure,
+      kMemoryCounterSuffix);
+}
+
+void
+setMemoryCounter(
+    folly::StringPiece module, folly::StringPiece structure, size_t bytes) {
+  fb303::fbData->setCounter(getMemoryCounterName(module, structure), bytes);
+}
+
+void
+clearMemoryCounter(folly::StringPiece module, folly::StringPiece structure) {
+  fb303::fbData->clearCounter(getMemoryCounterName(module, structure));
+}
+
+std::vector<std::pair<std::string, int64_t>>
+getTopMemoryConsumers(size_t count) {
+  std::map<std::string, int64_t> counters;
+  fb303::fbData->getCounters(counters);
+
+  std::vector<std::pair<std::string, int64_t>> consumers;
+  for (auto& [name, bytes] : counters) {
+    folly::StringPiece piece(name);
+    if (piece.startsWith(kMemoryCounterPrefix) and
+        piece.endsWith(kMemoryCounterSuffix)) {
+      consumers.emplace_back(name, bytes);
+    }
+  }
+
+  const auto numTop = std::min(count, consumers.size());
+  std::partial_sort(
+      consumers.begin(),
+      consumers.begin() + numTop,
+      consumers.end(),
+      [](auto const& lhs, auto const& rhs) { return lhs.second > rhs.second; });
+  consumers.resize(numTop);
+  return consumers;
+}
+
+bool
+enableModuleArenas() {
+  if (not folly::usingJEMalloc()) {
+    LOG(WARNING) << "Not running on jemalloc, module arenas are disabled";
+    return false;
+  }
+  moduleArenasEnabled = true;
+  return true;
+}
+
+void
+bindThreadToModuleArena(folly::StringPiece module) {
+  if (not moduleArenasEnabled) {
+    return;
+  }
+  try {
+    unsigned arena{0};
+    {
+      auto arenas = moduleArenas.wlock();
+      auto it = arenas->find(module.str());
+      if (it == arenas->end()) {
+        folly::mallctlRead("arenas.create", &arena);
+        arenas->emplace(module.str(), arena);
+      } else {
+        arena = it->second;
+      }
+    }
+    folly::mallctlWrite("thread.arena", arena);
+    // return cached allocations of the previous arena
+    folly::mallctlCall("thread.tcache.flush");
+    LOG(INFO) << "Thread of " << module << " bound to jemalloc arena "
+              << arena;
+  } catch (std::exception const& ex) {
+    LOG(ERROR) << "Failed to bind thread of " << module
+               << " to its arena: " << ex.what();
+  }
+}
+
+void
+updateModuleArenaCounters() {
+  if (not moduleArenasEnabled) {
+    return;
+  }
+  try {
+    // stats are snapshotted on epoch update
+    uint64_t epoch{1};
+    folly::mallctlReadWrite("epoch", &epoch, epoch);
+    size_t pageSize{0};
+    folly::mallctlRead("arenas.page", &pageSize);
+
+    auto arenas = moduleArenas.rlock();
+    for (auto const& [module, arena] : *arenas) {
+      const auto prefix = folly::sformat("jemalloc.arena.{}", module);
+      fb303::fbData->setCounter(
+          prefix + ".allocated_bytes",
+          readArenaStat(arena, "small.allocated") +
+              readArenaStat(arena, "large.allocated"));
+      fb303::fbData->setCounter(
+          prefix + ".active_bytes",
+          readArenaStat(arena, "pactive") * pageSize);
+      fb303::fbData->setCounter(
+          prefix + ".resident_bytes", readArenaStat(arena, "resident"));
+    }
+  } catch (std::exception const& ex) {
+    LOG(ERROR) << "Failed to read stats of module arenas: " << ex.what();
+  }
+}
+
+size_t
+getMemoryUsage(const std::string& str) {
+  return sizeof(str) + getHeapUsage(str);
+}
+
+size_t
+getMemoryUsage(const thrift::Value& value) {
+  size_t bytes = sizeof(value) + getHeapUsage(value.originatorId);
+  if (value.value_ref().has_value()) {
+    bytes += getHeapUsage(value.value_ref().value());
+  }
+  return bytes;
+}
+
+size_t
+getMemoryUsage(const thrift::IpPrefix& prefix) {
+  return sizeof(prefix) + getHeapUsage(prefix.prefixAddress.addr);
+}
+
+size_t
+getMemoryUsage(const thrift::NextHopThrift& nextHop) {
+  size_t bytes = sizeof(nextHop) + getHeapUsage(nextHop.address.addr);
+  if (nextHop.address.ifName_ref().has_value()) {
+    bytes += getHeapUsage(nextHop.address.ifName_ref().value());
+  }
+  if (nextHop.mplsAction_ref().has_value()) {
+    auto const& pushLabels = nextHop.mplsAction_ref()->pushLabels_ref();
+    if (pushLabels.has_value()) {
+      bytes += pushLabels->capacity() * sizeof(int32_t);
+    }
+  }
+  return bytes;
+}
+
+} // namespace openr
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/if/gen-cpp2/Network_types.h>
+
+namespace openr {
+
+/**
+ * Memory accounting of module structures. Modules report approximate number
+ * of bytes held by their major structures as counters
+ * `memory.<module>.<structure>_bytes`, along with their other counters. These
+ * are exported as is and used by Watchdog to tell which structures are
+ * responsible for the memory usage of the process.
+ */
+
+// name of the counter reporting memory usage of a structure of a module
+std::string getMemoryCounterName(
+    folly::StringPiece module, folly::StringPiece structure);
+
+// report approximate number of bytes held by a structure of a module
+void setMemoryCounter(
+    folly::StringPiece module, folly::StringPiece structure, size_t bytes);
+
+// stop reporting memory usage of a structure, e.g. once it is destroyed
+void clearMemoryCounter(
+    folly::StringPiece module, folly::StringPiece structure);
+
+// reported structures with most bytes held, largest first
+std::vector<std::pair<std::string, int64_t>> getTopMemoryConsumers(
+    size_t count);
+
+/**
+ * Estimates of bytes held by commonly stored objects, including their own
+ * size and heap allocations
+ */
+
+size_t getMemoryUsage(const std::string& str);
+
+size_t getMemoryUsage(const thrift::Value& value);
+
+size_t getMemoryUsage(const thrift::IpPrefix& prefix);
+
+size_t getMemoryUsage(const thrift::NextHopThrift& nextHop);
+
+/**
+ * Dedicated jemalloc arenas of modules, so that allocation churn of one
+ * module, e.g. short-lived key-values of KvStore, doesn't fragment memory
+ * held long by others. Stats of arenas are exported as counters
+ * `jemalloc.arena.<module>.{allocated,active,resident}_bytes`.
+ */
+
+// enable module arenas, at startup before module threads are started
+// @return: false if not running on jemalloc
+bool enableModuleArenas();
+
+// make calling thread allocate from the arena of the module, created on
+// first use. No-op unless module arenas are enabled
+void bindThreadToModuleArena(folly::StringPiece module);
+
+// refresh stats counters of module arenas
+void updateModuleArenaCounters();
+
+} // namespace openr
@@ -7,6 +7,8 @@
 
 #include "openr/common/NetworkUtil.h"
 
+#include <folly/hash/SpookyHashV2.h>
+
 namespace std {
 
 /**
@@ -64,6 +66,17 @@ hash<openr::thrift::NextHopThrift>::operator()(
   return res;
 }
 
+/**
+ * Make IpPrefixKey hashable
+ */
+size_t
+hash<openr::IpPrefixKey>::operator()(openr::IpPrefixKey const& key) const {
+  static_assert(
+      sizeof(openr::IpPrefixKey) == folly::IPAddressV6::byteCount() + 2,
+      "IpPrefixKey must not have padding");
+  return folly::hash::SpookyHashV2::Hash64(&key, sizeof(key), 0);
+}
+
 /**
  * Make UnicastRoute hashable
  */
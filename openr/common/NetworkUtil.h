@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 #include <folly/Format.h>
 #include <folly/IPAddress.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
@@ -17,6 +21,10 @@
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 
+namespace openr {
+class IpPrefixKey;
+} // namespace openr
+
 namespace std {
 
 /**
@@ -59,6 +67,14 @@ struct hash<openr::thrift::UnicastRoute> {
   size_t operator()(openr::thrift::UnicastRoute const&) const;
 };
 
+/**
+ * Make IpPrefixKey hashable
+ */
+template <>
+struct hash<openr::IpPrefixKey> {
+  size_t operator()(openr::IpPrefixKey const&) const;
+};
+
 } // namespace std
 
 namespace openr {
@@ -122,6 +138,62 @@ toIpPrefix(const std::string& prefix) {
   return toIpPrefix(folly::IPAddress::createNetwork(prefix));
 }
 
+/**
+ * Compact key of thrift::IpPrefix for large prefix tables. Address bytes are
+ * held inline instead of in a heap allocated string, hence keys are copied,
+ * hashed and compared without chasing pointers. Ordered the same way as
+ * thrift::IpPrefix (address bytes, then prefix length).
+ */
+class IpPrefixKey {
+ public:
+  IpPrefixKey() = default;
+
+  explicit IpPrefixKey(const thrift::IpPrefix& prefix)
+      : addrLen_(static_cast<uint8_t>(
+            std::min(prefix.prefixAddress.addr.size(), addr_.size()))),
+        prefixLength_(static_cast<uint8_t>(prefix.prefixLength)) {
+    std::memcpy(addr_.data(), prefix.prefixAddress.addr.data(), addrLen_);
+  }
+
+  thrift::IpPrefix
+  toIpPrefix() const {
+    thrift::IpPrefix prefix;
+    prefix.prefixAddress.addr.assign(
+        reinterpret_cast<const char*>(addr_.data()), addrLen_);
+    prefix.prefixLength = prefixLength_;
+    return prefix;
+  }
+
+  bool
+  operator==(const IpPrefixKey& other) const {
+    return std::memcmp(this, &other, sizeof(IpPrefixKey)) == 0;
+  }
+
+  bool
+  operator!=(const IpPrefixKey& other) const {
+    return not(*this == other);
+  }
+
+  bool
+  operator<(const IpPrefixKey& other) const {
+    const auto res = std::memcmp(
+        addr_.data(), other.addr_.data(), std::min(addrLen_, other.addrLen_));
+    if (res != 0) {
+      return res < 0;
+    }
+    if (addrLen_ != other.addrLen_) {
+      return addrLen_ < other.addrLen_;
+    }
+    return prefixLength_ < other.prefixLength_;
+  }
+
+ private:
+  // unused trailing bytes are zero, so that keys compare bytewise
+  std::array<uint8_t, folly::IPAddressV6::byteCount()> addr_{};
+  uint8_t addrLen_{0};
+  uint8_t prefixLength_{0};
+};
+
 inline std::string
 toString(const thrift::BinaryAddress& addr) {
   return addr.addr.empty() ? "" : toIPAddress(addr).str();
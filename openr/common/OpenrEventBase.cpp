@@ -37,6 +37,22 @@ getFmOptions() {
 }
 } // namespace
 
+const folly::RequestToken&
+EvbQueueTime::getToken() {
+  static const folly::RequestToken token("openr::EvbQueueTime");
+  return token;
+}
+
+EvbQueueTime*
+EvbQueueTime::get() {
+  auto* requestContext = folly::RequestContext::try_get();
+  if (not requestContext) {
+    return nullptr;
+  }
+  return dynamic_cast<EvbQueueTime*>(
+      requestContext->getContextData(getToken()));
+}
+
 EventBaseStopSignalHandler::EventBaseStopSignalHandler(folly::EventBase* evb)
     : folly::AsyncSignalHandler(evb) {}
 
@@ -144,12 +160,32 @@ OpenrEventBase::run() {
 
 void
 OpenrEventBase::stop() {
+  cancellationSource_.requestCancellation();
   for (auto& future : fiberTaskFutures_) {
     future.wait();
   }
+#if FOLLY_HAS_COROUTINES
+  for (auto& future : coroTaskFutures_) {
+    future.wait();
+  }
+  coroTaskFutures_.clear();
+#endif
+  // fresh token for tasks of next run
+  cancellationSource_ = folly::CancellationSource();
   evb_.terminateLoopSoon();
 }
 
+#if FOLLY_HAS_COROUTINES
+void
+OpenrEventBase::addCoroTask(folly::coro::Task<void>&& task) {
+  coroTaskFutures_.emplace_back(
+      folly::coro::co_withCancellation(
+          cancellationSource_.getToken(), std::move(task))
+          .scheduleOn(&evb_)
+          .start());
+}
+#endif
+
 bool
 OpenrEventBase::isRunning() const {
   return evb_.isRunning();
@@ -167,6 +203,28 @@ OpenrEventBase::waitUntilStopped() {
   }
 }
 
+void
+OpenrEventBase::runInEventBaseThread(folly::EventBase::Func callback) {
+  auto* queueTime = EvbQueueTime::get();
+  if (not queueTime) {
+    evb_.runInEventBaseThread(std::move(callback));
+    return;
+  }
+
+  // Account time spent in queue to the request. Context is held to keep the
+  // accumulator alive
+  evb_.runInEventBaseThread(
+      [callback = std::move(callback),
+       queueTime,
+       requestContext = folly::RequestContext::saveContext(),
+       enqueueTime = std::chrono::steady_clock::now()]() mutable {
+        queueTime->addQueueTime(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - enqueueTime));
+        callback();
+      });
+}
+
 void
 OpenrEventBase::scheduleTimeout(
     std::chrono::milliseconds timeout, folly::EventBase::Func callback) {
@@ -7,13 +7,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <csignal>
+#include <type_traits>
 
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <fbzmq/zmq/Socket.h>
+#include <folly/CancellationToken.h>
 #include <folly/fibers/FiberManager.h>
+#include <folly/io/async/Request.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/EventHandler.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
 namespace openr {
 
@@ -25,6 +32,38 @@ class EventBaseStopSignalHandler : public folly::AsyncSignalHandler {
   void signalReceived(int signum) noexcept override;
 };
 
+/**
+ * Accumulator of time a request spent queued on event-bases before being
+ * served. Attached to folly::RequestContext of the request (e.g. by
+ * ctrl-server), it gets updated by `runInEventBaseThread` of every module the
+ * request is dispatched onto.
+ */
+class EvbQueueTime : public folly::RequestData {
+ public:
+  static const folly::RequestToken& getToken();
+
+  // Accumulator of current request context if any
+  static EvbQueueTime* get();
+
+  bool
+  hasCallback() override {
+    return false;
+  }
+
+  std::chrono::microseconds
+  getQueueTime() const {
+    return std::chrono::microseconds(queueTimeUs_.load());
+  }
+
+  void
+  addQueueTime(std::chrono::microseconds queueTime) {
+    queueTimeUs_ += queueTime.count();
+  }
+
+ private:
+  std::atomic<int64_t> queueTimeUs_{0};
+};
+
 class OpenrEventBase {
  public:
   OpenrEventBase();
@@ -61,13 +100,45 @@ class OpenrEventBase {
   }
 
   /**
-   * EventBase API aliases
+   * Cancellation token of tasks of this event base. Cancellation is requested
+   * in `stop()`, before awaiting the tasks.
    */
-  void
-  runInEventBaseThread(folly::EventBase::Func callback) {
-    evb_.runInEventBaseThread(std::move(callback));
+  folly::CancellationToken
+  getCancellationToken() const {
+    return cancellationSource_.getToken();
   }
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Add a coroutine task running on this event base, with the cancellation
+   * token of the event base. All tasks will be awaited in `stop()`, so they
+   * must complete once cancellation is requested.
+   */
+  void addCoroTask(folly::coro::Task<void>&& task);
+
+  /**
+   * Run `func` in event base thread and await its result. When awaited from
+   * event base thread (e.g. by a coroutine task of this event base), `func`
+   * runs inline instead of hopping through the event base queue.
+   */
+  template <typename F>
+  folly::coro::Task<std::invoke_result_t<F>>
+  co_runInEventBaseThread(F func) {
+    if (evb_.isInEventBaseThread()) {
+      co_return func();
+    }
+    co_return co_await folly::coro::co_invoke(
+        [func = std::move(func)]() mutable
+        -> folly::coro::Task<std::invoke_result_t<F>> { co_return func(); })
+        .scheduleOn(&evb_);
+  }
+#endif
+
+  /**
+   * EventBase API aliases
+   */
+  void runInEventBaseThread(folly::EventBase::Func callback);
+
   /**
    * Get latest timestamp of health check timer
    */
@@ -152,6 +223,12 @@ class OpenrEventBase {
   folly::fibers::FiberManager& fiberManager_;
   std::vector<folly::Future<folly::Unit>> fiberTaskFutures_;
 
+  // Cancellation of fiber and coroutine tasks, requested in stop()
+  folly::CancellationSource cancellationSource_;
+#if FOLLY_HAS_COROUTINES
+  std::vector<folly::SemiFuture<folly::Unit>> coroTaskFutures_;
+#endif
+
   // Data structure to hold fd and their handlers
   std::unordered_map<int /* fd */, ZmqEventHandler> fdHandlers_;
 
@@ -0,0 +1,241 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <folly/IPAddress.h>
+#include <glog/logging.h>
+
+namespace openr {
+
+/*
+ * Path compressed binary (patricia) trie keyed on IP prefixes. IPv4 and IPv6
+ * prefixes are stored in separate tries. Every node stores the complete
+ * (masked) prefix it represents, and nodes with a single child and no value
+ * are never kept, so the number of nodes is bounded by twice the number of
+ * stored prefixes.
+ *
+ * Exact lookup, insert, erase and longest prefix match are O(prefix length)
+ * irrespective of the number of prefixes stored.
+ */
+template <typename T>
+class PrefixTrie {
+ public:
+  PrefixTrie() = default;
+
+  // Insert or replace value for the prefix. Returns true if prefix is new
+  bool
+  insert(const folly::CIDRNetwork& prefix, T value) {
+    const auto key = toKey(prefix);
+    const uint8_t len = prefix.second;
+    Node* node = root(prefix).get();
+
+    while (node->len < len) {
+      auto& slot = node->child[bit(key, node->len)];
+      if (!slot) {
+        // No node on this branch, create leaf
+        slot = std::make_unique<Node>(key, len);
+        slot->value = std::move(value);
+        ++size_;
+        return true;
+      }
+
+      const uint8_t common =
+          commonBits(key, slot->key, std::min(len, slot->len));
+      if (common == slot->len) {
+        // Child prefix covers the key, descend
+        node = slot.get();
+        continue;
+      }
+
+      // Key diverges from the child (or is covering it). Split the branch
+      // with intermediate node representing the common prefix.
+      auto split = std::make_unique<Node>(key, common);
+      split->child[bit(slot->key, common)] = std::move(slot);
+      if (common == len) {
+        split->value = std::move(value);
+      } else {
+        auto leaf = std::make_unique<Node>(key, len);
+        leaf->value = std::move(value);
+        split->child[bit(key, common)] = std::move(leaf);
+      }
+      slot = std::move(split);
+      ++size_;
+      return true;
+    }
+
+    CHECK_EQ(node->len, len);
+    const bool isNew = !node->value.has_value();
+    node->value = std::move(value);
+    size_ += isNew ? 1 : 0;
+    return isNew;
+  }
+
+  // Erase prefix. Returns true if prefix existed
+  bool
+  erase(const folly::CIDRNetwork& prefix) {
+    const auto key = toKey(prefix);
+    const uint8_t len = prefix.second;
+    auto& rootSlot = root(prefix);
+
+    // Slots of the nodes from root to the matched node. Root is never removed
+    std::vector<std::unique_ptr<Node>*> path;
+    Node* node = rootSlot.get();
+    while (node->len < len) {
+      auto& slot = node->child[bit(key, node->len)];
+      if (!slot || slot->len > len ||
+          commonBits(key, slot->key, slot->len) < slot->len) {
+        return false;
+      }
+      path.push_back(&slot);
+      node = slot.get();
+    }
+    if (!node->value.has_value()) {
+      return false;
+    }
+    node->value.reset();
+    --size_;
+
+    // Remove nodes which are no longer required. Valueless node with single
+    // child is replaced by the child, and one without children is removed.
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      Node* n = (*it)->get();
+      if (n->value.has_value() || (n->child[0] && n->child[1])) {
+        break;
+      }
+      auto only = std::move(n->child[0] ? n->child[0] : n->child[1]);
+      **it = std::move(only);
+    }
+    return true;
+  }
+
+  // Exact match lookup
+  T const*
+  get(const folly::CIDRNetwork& prefix) const {
+    const auto key = toKey(prefix);
+    const uint8_t len = prefix.second;
+    Node const* node = root(prefix).get();
+    while (node && node->len < len) {
+      node = node->child[bit(key, node->len)].get();
+      if (node && (node->len > len ||
+                   commonBits(key, node->key, node->len) < node->len)) {
+        return nullptr;
+      }
+    }
+    return node && node->value.has_value() ? &node->value.value() : nullptr;
+  }
+
+  // Longest prefix match. Returns value of the most specific stored prefix
+  // that covers the specified prefix (or address as full length prefix)
+  T const*
+  longestMatch(const folly::CIDRNetwork& prefix) const {
+    const auto key = toKey(prefix);
+    const uint8_t len = prefix.second;
+    T const* match{nullptr};
+    Node const* node = root(prefix).get();
+    while (node) {
+      if (node->value.has_value()) {
+        match = &node->value.value();
+      }
+      if (node->len >= len) {
+        break;
+      }
+      node = node->child[bit(key, node->len)].get();
+      if (node && (node->len > len ||
+                   commonBits(key, node->key, node->len) < node->len)) {
+        break;
+      }
+    }
+    return match;
+  }
+
+  size_t
+  size() const {
+    return size_;
+  }
+
+  bool
+  empty() const {
+    return size_ == 0;
+  }
+
+  void
+  clear() {
+    v4Root_ = std::make_unique<Node>();
+    v6Root_ = std::make_unique<Node>();
+    size_ = 0;
+  }
+
+ private:
+  using Key = std::array<uint8_t, 16>;
+
+  struct Node {
+    Node() = default;
+    Node(const Key& prefixKey, uint8_t prefixLen) : len(prefixLen) {
+      // Store masked prefix
+      const size_t bytes = (prefixLen + 7) / 8;
+      std::memcpy(key.data(), prefixKey.data(), bytes);
+      if (prefixLen % 8) {
+        key[bytes - 1] &= static_cast<uint8_t>(0xFF << (8 - prefixLen % 8));
+      }
+    }
+
+    Key key{};
+    uint8_t len{0};
+    std::optional<T> value;
+    std::unique_ptr<Node> child[2];
+  };
+
+  static Key
+  toKey(const folly::CIDRNetwork& prefix) {
+    Key key{};
+    const auto& addr = prefix.first;
+    std::memcpy(key.data(), addr.bytes(), addr.byteCount());
+    return key;
+  }
+
+  static uint8_t
+  bit(const Key& key, uint8_t pos) {
+    return (key[pos / 8] >> (7 - pos % 8)) & 1;
+  }
+
+  // Number of leading bits (upto maxBits) which are same in both keys
+  static uint8_t
+  commonBits(const Key& lhs, const Key& rhs, uint8_t maxBits) {
+    for (size_t i = 0; i * 8 < maxBits; ++i) {
+      const uint8_t diff = lhs[i] ^ rhs[i];
+      if (diff) {
+        const uint8_t bits = i * 8 + __builtin_clz(diff) - 24;
+        return std::min(bits, maxBits);
+      }
+    }
+    return maxBits;
+  }
+
+  std::unique_ptr<Node>&
+  root(const folly::CIDRNetwork& prefix) {
+    return prefix.first.isV4() ? v4Root_ : v6Root_;
+  }
+
+  const std::unique_ptr<Node>&
+  root(const folly::CIDRNetwork& prefix) const {
+    return prefix.first.isV4() ? v4Root_ : v6Root_;
+  }
+
+  std::unique_ptr<Node> v4Root_{std::make_unique<Node>()};
+  std::unique_ptr<Node> v6Root_{std::make_unique<Node>()};
+  size_t size_{0};
+};
+
+} // namespace openr
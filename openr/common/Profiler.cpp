@@ -0,0 +1,262 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "Profiler.h"
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Demangle.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
+#include <glog/logging.h>
+
+#include <openr/common/Constants.h>
+
+namespace {
+
+// frames of the signal handler and signal trampoline on top of all samples
+const int kSkipFrames{2};
+const int kMaxFrames{32};
+// bound on samples of a profile, later ones are dropped
+const size_t kMaxSamples{16384};
+
+struct Sample {
+  int depth{0};
+  std::array<void*, kMaxFrames> frames;
+};
+
+// serializes starting and stopping of profiles
+std::mutex profileMutex;
+// buffer of the current profile, from its start till it is stopped
+std::unique_ptr<Sample[]> sampleBuffer;
+bool signalHandlerInstalled{false};
+
+// state shared with signal handler. Samples are only recorded while set
+std::atomic<Sample*> samples{nullptr};
+std::atomic<size_t> numSamples{0};
+std::atomic<int64_t> deadlineNs{0};
+std::atomic<int> activeHandlers{0};
+
+int64_t
+getMonotonicTimeNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void
+setProfileTimer(std::chrono::microseconds interval) {
+  struct itimerval timer {};
+  timer.it_interval.tv_sec = interval.count() / 1000000;
+  timer.it_interval.tv_usec = interval.count() % 1000000;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+// only async-signal-safe calls in here. backtrace() is warmed up before the
+// first profile, as it may allocate when first called
+void
+handleProfileSignal(int /* signum */) {
+  const int savedErrno = errno;
+  activeHandlers.fetch_add(1);
+  auto* buffer = samples.load();
+  if (buffer != nullptr) {
+    if (getMonotonicTimeNs() >= deadlineNs.load()) {
+      setProfileTimer(std::chrono::microseconds(0));
+    } else {
+      const auto index = numSamples.fetch_add(1);
+      if (index < kMaxSamples) {
+        buffer[index].depth =
+            backtrace(buffer[index].frames.data(), kMaxFrames);
+      }
+    }
+  }
+  activeHandlers.fetch_sub(1);
+  errno = savedErrno;
+}
+
+// name of exported function, else module and offset for offline
+// symbolization, e.g. with addr2line
+std::string
+symbolize(void* address) {
+  Dl_info info;
+  if (dladdr(address, &info) == 0 or info.dli_fname == nullptr) {
+    return folly::sformat("0x{:x}", reinterpret_cast<uintptr_t>(address));
+  }
+  if (info.dli_sname != nullptr) {
+    return folly::demangle(info.dli_sname).toStdString();
+  }
+  folly::StringPiece module(info.dli_fname);
+  const auto slash = module.rfind('/');
+  if (slash != folly::StringPiece::npos) {
+    module.advance(slash + 1);
+  }
+  return folly::sformat(
+      "{}+0x{:x}",
+      module,
+      reinterpret_cast<uintptr_t>(address) -
+          reinterpret_cast<uintptr_t>(info.dli_fbase));
+}
+
+} // namespace
+
+namespace openr {
+
+void
+startCpuProfile(std::chrono::milliseconds duration, uint32_t frequencyHz) {
+  if (duration.count() <= 0 or frequencyHz == 0) {
+    throw std::runtime_error("Profile duration and frequency must be positive");
+  }
+  duration = std::min<std::chrono::milliseconds>(
+      duration, Constants::kCpuProfileMaxDuration);
+  frequencyHz = std::min(frequencyHz, Constants::kCpuProfileMaxFrequencyHz);
+
+  std::lock_guard<std::mutex> lock(profileMutex);
+  if (sampleBuffer) {
+    throw std::runtime_error("CPU profile is already being taken");
+  }
+
+  // Handler is never uninstalled, as a signal may still be pending once the
+  // profile is stopped and default action of SIGPROF is to terminate
+  if (not signalHandlerInstalled) {
+    std::array<void*, 1> frames;
+    backtrace(frames.data(), frames.size());
+
+    struct sigaction action {};
+    action.sa_handler = handleProfileSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      throw std::runtime_error(folly::sformat(
+          "Failed to install SIGPROF handler: {}", folly::errnoStr(errno)));
+    }
+    signalHandlerInstalled = true;
+  }
+
+  LOG(INFO) << "Starting CPU profile for " << duration.count() << "ms at "
+            << frequencyHz << "Hz";
+  sampleBuffer = std::make_unique<Sample[]>(kMaxSamples);
+  numSamples = 0;
+  deadlineNs = getMonotonicTimeNs() +
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  samples = sampleBuffer.get();
+  setProfileTimer(std::chrono::microseconds(1000000 / frequencyHz));
+}
+
+std::string
+stopCpuProfile() {
+  std::lock_guard<std::mutex> lock(profileMutex);
+  if (not sampleBuffer) {
+    throw std::runtime_error("No CPU profile is being taken");
+  }
+
+  setProfileTimer(std::chrono::microseconds(0));
+  samples = nullptr;
+  // wait for handlers which may still be recording into the buffer
+  while (activeHandlers.load() != 0) {
+    std::this_thread::yield();
+  }
+  auto buffer = std::move(sampleBuffer);
+  const auto total = numSamples.load();
+  if (total > kMaxSamples) {
+    LOG(WARNING) << "Dropped " << total - kMaxSamples
+                 << " samples of CPU profile";
+  }
+
+  // count unique stacks, root first
+  std::map<std::vector<void*>, size_t> stacks;
+  for (size_t i = 0; i < std::min(total, kMaxSamples); ++i) {
+    auto const& sample = buffer[i];
+    if (sample.depth <= kSkipFrames) {
+      continue;
+    }
+    std::vector<void*> stack(
+        sample.frames.rend() - sample.depth,
+        sample.frames.rend() - kSkipFrames);
+    ++stacks[std::move(stack)];
+  }
+
+  std::string profile;
+  std::unordered_map<void*, std::string> symbols;
+  for (auto const& [stack, count] : stacks) {
+    for (size_t i = 0; i < stack.size(); ++i) {
+      auto it = symbols.find(stack[i]);
+      if (it == symbols.end()) {
+        it = symbols.emplace(stack[i], symbolize(stack[i])).first;
+      }
+      if (i != 0) {
+        profile += ';';
+      }
+      profile += it->second;
+    }
+    profile += folly::sformat(" {}\n", count);
+  }
+  LOG(INFO) << "Stopped CPU profile with " << std::min(total, kMaxSamples)
+            << " samples of " << stacks.size() << " unique stacks";
+  return profile;
+}
+
+bool
+isCpuProfileRunning() {
+  return samples.load() != nullptr and getMonotonicTimeNs() < deadlineNs;
+}
+
+std::string
+dumpHeapProfile() {
+  if (not folly::usingJEMalloc()) {
+    throw std::runtime_error("Heap profile requires jemalloc");
+  }
+  bool enabled{false};
+  folly::mallctlRead("opt.prof", &enabled);
+  if (not enabled) {
+    throw std::runtime_error(
+        "Heap profiling of jemalloc is disabled, set MALLOC_CONF=prof:true");
+  }
+
+  char path[] = "/tmp/openr-heap-XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    throw std::runtime_error(folly::sformat(
+        "Failed to create heap profile file: {}", folly::errnoStr(errno)));
+  }
+  close(fd);
+  SCOPE_EXIT {
+    unlink(path);
+  };
+
+  folly::mallctlWrite<const char*>("prof.dump", path);
+  std::string profile;
+  if (not folly::readFile(path, profile)) {
+    throw std::runtime_error(folly::sformat(
+        "Failed to read heap profile: {}", folly::errnoStr(errno)));
+  }
+  return profile;
+}
+
+} // namespace openr
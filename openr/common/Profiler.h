@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace openr {
+
+/**
+ * In-process profiling, to look into hot spots of modules on the exact
+ * workload of a node without attaching external tools.
+ *
+ * CPU profile samples stacks of all threads of the process on SIGPROF, i.e.
+ * at the given frequency of consumed CPU time. Only one CPU profile can be
+ * taken at a time. Heap profile is dumped by jemalloc, and is only available
+ * if the process runs with jemalloc profiling enabled (MALLOC_CONF=prof:true).
+ *
+ * Errors are reported as std::runtime_error.
+ */
+
+// Start sampling CPU profile, which stops by itself after given duration.
+// Duration and frequency are capped by Constants::kCpuProfileMaxDuration and
+// Constants::kCpuProfileMaxFrequencyHz
+void startCpuProfile(
+    std::chrono::milliseconds duration, uint32_t frequencyHz);
+
+// Stop CPU profile if still running and return its sampled stacks in folded
+// format, one unique stack per line, root first: "root;...;leaf <count>".
+// Frames of functions not exported are reported as "<module>+0x<offset>"
+std::string stopCpuProfile();
+
+bool isCpuProfileRunning();
+
+// Snapshot of jemalloc heap profile, in jeprof format
+std::string dumpHeapProfile();
+
+} // namespace openr
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "StartupTimeline.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <glog/logging.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+StartupTimeline::StartupTimeline(Clock::time_point startTime)
+    : startTime_(startTime) {}
+
+StartupTimeline&
+StartupTimeline::get() {
+  static StartupTimeline timeline;
+  return timeline;
+}
+
+bool
+StartupTimeline::record(const std::string& event, Clock::time_point now) {
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime_);
+  {
+    auto events = events_.wlock();
+    for (auto const& [name, _] : *events) {
+      if (name == event) {
+        return false;
+      }
+    }
+    events->emplace_back(event, elapsed);
+  }
+
+  LOG(INFO) << "Startup: " << event << " after " << elapsed.count() << "ms";
+  fb303::fbData->setCounter(
+      folly::sformat("startup.{}_ms", event), elapsed.count());
+  return true;
+}
+
+std::optional<std::chrono::milliseconds>
+StartupTimeline::getEventTime(const std::string& event) const {
+  auto events = events_.rlock();
+  for (auto const& [name, elapsed] : *events) {
+    if (name == event) {
+      return elapsed;
+    }
+  }
+  return std::nullopt;
+}
+
+std::string
+StartupTimeline::toString() const {
+  std::vector<std::string> parts;
+  auto events = events_.rlock();
+  for (auto const& [name, elapsed] : *events) {
+    parts.emplace_back(folly::sformat("{}={}ms", name, elapsed.count()));
+  }
+  return folly::join(", ", parts);
+}
+
+} // namespace openr
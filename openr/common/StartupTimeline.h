@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Synchronized.h>
+
+namespace openr {
+
+/**
+ * Timeline of Open/R startup: time of initialization phases and of the first
+ * occurrence of events on the way to forwarding (first adjacency, first
+ * KvStore sync, first RIB, first FIB sync), since start of the process.
+ *
+ * Every event is recorded only the first time, exported as counter
+ * `startup.<event>_ms` and logged.
+ */
+class StartupTimeline {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit StartupTimeline(Clock::time_point startTime = Clock::now());
+
+  /**
+   * Timeline of this process, started on first use. Main uses it first thing
+   */
+  static StartupTimeline& get();
+
+  /**
+   * Record an event at `now`, unless recorded already. Returns whether it was
+   * recorded
+   */
+  bool record(const std::string& event, Clock::time_point now = Clock::now());
+
+  /**
+   * Time of an event since start, if recorded
+   */
+  std::optional<std::chrono::milliseconds> getEventTime(
+      const std::string& event) const;
+
+  /**
+   * One-line summary of events recorded so far, in order of their occurrence
+   */
+  std::string toString() const;
+
+ private:
+  const Clock::time_point startTime_;
+
+  // recorded events in order, with their time since start
+  folly::Synchronized<
+      std::vector<std::pair<std::string, std::chrono::milliseconds>>>
+      events_;
+};
+
+} // namespace openr
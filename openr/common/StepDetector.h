@@ -7,11 +7,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <stdexcept>
+#include <vector>
 
-#include <folly/stats/BucketedTimeSeries.h>
+#include <glog/logging.h>
 
 namespace openr {
 
@@ -32,6 +34,9 @@ namespace openr {
  * to catch this case.
  * Notes: we assume the underlying time series is stable for longer than slow
  * sliding window between steps.
+ * Sliding windows are fixed rings of per-sample-period buckets with running
+ * totals, hence adding a value is O(1) (amortized over sample periods skipped)
+ * and never allocates.
  */
 template <typename ValueType, typename TimeType>
 class StepDetector {
@@ -52,14 +57,15 @@ class StepDetector {
       // callback when step is detected
       std::function<void(const ValueType&)> stepCb)
       : slowWndSize_(slowWndSize),
-        fastSlideWindow_(fastWndSize, samplePeriod * fastWndSize),
-        slowSlideWindow_(slowWndSize, samplePeriod * slowWndSize),
+        fastSlideWindow_(samplePeriod, fastWndSize),
+        slowSlideWindow_(samplePeriod, slowWndSize),
         loThreshold_(loThreshold),
         hiThreshold_(hiThreshold),
         absThreshold_(absThreshold),
         stepCb_(std::move(stepCb)) {
     CHECK_LT(loThreshold, hiThreshold);
     CHECK_LT(fastWndSize, slowWndSize);
+    CHECK_GT(samplePeriod.count(), 0);
   }
 
   // add the value 'val' at time 'now' to both fast and slow sliding window
@@ -125,16 +131,90 @@ class StepDetector {
   StepDetector(StepDetector const&) = delete;
   StepDetector& operator=(StepDetector const&) = delete;
 
+  /*
+   * Sum and count of values over the last `numBuckets` sample periods. Same
+   * window as folly::BucketedTimeSeries with `numBuckets` buckets over
+   * `numBuckets * samplePeriod`: bucket of a value is its sample period
+   * number modulo `numBuckets`, and values older than the window are
+   * rejected. Buckets falling out of the window are subtracted from the
+   * running totals once, when time moves past them.
+   */
+  class SlidingWindow {
+   public:
+    SlidingWindow(TimeType samplePeriod, size_t numBuckets)
+        : samplePeriod_(samplePeriod), buckets_(numBuckets) {}
+
+    bool
+    addValue(TimeType now, const ValueType& val) {
+      const int64_t period = now.count() / samplePeriod_.count();
+      const int64_t numBuckets = buckets_.size();
+      if (not started_) {
+        latestPeriod_ = period;
+        started_ = true;
+      }
+      if (period > latestPeriod_) {
+        // clear buckets of the periods we moved past, all at most
+        const int64_t stale = std::min(period - latestPeriod_, numBuckets);
+        for (int64_t i = 1; i <= stale; ++i) {
+          auto& bucket = buckets_[(latestPeriod_ + i) % numBuckets];
+          sum_ -= bucket.sum;
+          count_ -= bucket.count;
+          bucket = Bucket{};
+        }
+        if (count_ == 0) {
+          // drop rounding errors accumulated by floating point values
+          sum_ = 0;
+        }
+        latestPeriod_ = period;
+      } else if (period <= latestPeriod_ - numBuckets) {
+        // older than the window
+        return false;
+      }
+      auto& bucket = buckets_[period % numBuckets];
+      bucket.sum += val;
+      bucket.count += 1;
+      sum_ += val;
+      count_ += 1;
+      return true;
+    }
+
+    double
+    avg() const {
+      return count_ ? static_cast<double>(sum_) / count_ : 0.0;
+    }
+
+    uint64_t
+    count() const {
+      return count_;
+    }
+
+   private:
+    struct Bucket {
+      ValueType sum{0};
+      uint64_t count{0};
+    };
+
+    const TimeType samplePeriod_;
+
+    std::vector<Bucket> buckets_;
+
+    // sample period number of the latest value added, once any is
+    bool started_{false};
+    int64_t latestPeriod_{0};
+
+    // totals of all the buckets
+    ValueType sum_{0};
+    uint64_t count_{0};
+  };
+
   // slow sliding window size
   size_t slowWndSize_{0};
 
   // fast sliding window
-  folly::BucketedTimeSeries<ValueType, folly::LegacyStatsClock<TimeType>>
-      fastSlideWindow_;
+  SlidingWindow fastSlideWindow_;
 
-  // slow sliding window size
-  folly::BucketedTimeSeries<ValueType, folly::LegacyStatsClock<TimeType>>
-      slowSlideWindow_;
+  // slow sliding window
+  SlidingWindow slowSlideWindow_;
 
   // lower threshold, in percentage
   const uint8_t loThreshold_{0};
@@ -10,10 +10,22 @@
 #include <ifaddrs.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include <folly/Random.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+
 namespace openr {
 
 // create RE2 set for the list of key prefixes
@@ -21,6 +33,30 @@ KeyPrefix::KeyPrefix(std::vector<std::string> const& keyPrefixList) {
   if (keyPrefixList.empty()) {
     return;
   }
+
+  std::vector<std::string> literalPrefixes;
+  for (auto const& keyPrefix : keyPrefixList) {
+    auto literalPrefix = getLiteralPrefix(keyPrefix);
+    if (not literalPrefix.has_value()) {
+      break;
+    }
+    literalPrefixes.emplace_back(std::move(*literalPrefix));
+  }
+  if (literalPrefixes.size() == keyPrefixList.size()) {
+    // prefix sorts right before the keys it is a prefix of, longer prefixes
+    // are covered by it and dropped
+    std::sort(literalPrefixes.begin(), literalPrefixes.end());
+    for (auto& literalPrefix : literalPrefixes) {
+      if (not literalPrefixes_.empty() and
+          folly::StringPiece(literalPrefix)
+              .startsWith(literalPrefixes_.back())) {
+        continue;
+      }
+      literalPrefixes_.emplace_back(std::move(literalPrefix));
+    }
+    return;
+  }
+
   re2::RE2::Options re2Options;
   re2Options.set_case_sensitive(true);
   keyPrefix_ =
@@ -43,11 +79,33 @@ KeyPrefix::KeyPrefix(std::vector<std::string> const& keyPrefixList) {
 // match the key with the list of prefixes
 bool
 KeyPrefix::keyMatch(std::string const& key) const {
+  if (not literalPrefixes_.empty()) {
+    // only the greatest prefix not greater than the key can be a prefix of it
+    auto it = std::upper_bound(
+        literalPrefixes_.begin(), literalPrefixes_.end(), key);
+    if (it == literalPrefixes_.begin()) {
+      return false;
+    }
+    --it;
+    return key.compare(0, it->size(), *it) == 0;
+  }
   if (!keyPrefix_) {
     return true;
   }
-  std::vector<int> matches;
-  return keyPrefix_->Match(key, &matches);
+  // indices of matched patterns aren't needed
+  return keyPrefix_->Match(key, nullptr);
+}
+
+std::optional<std::string>
+KeyPrefix::getLiteralPrefix(const std::string& keyPrefix) {
+  // RE2 meta characters
+  static const char* kMetaChars = "\\^$.|?*+()[]{}";
+  for (const char c : keyPrefix) {
+    if (std::strchr(kMetaChars, c) != nullptr) {
+      return std::nullopt;
+    }
+  }
+  return keyPrefix;
 }
 
 PrefixKey::PrefixKey(
@@ -112,6 +170,53 @@ PrefixKey::getIpPrefix() const {
   return toIpPrefix(prefix_);
 }
 
+PerAdjacencyKey::PerAdjacencyKey(
+    std::string const& node,
+    std::string const& otherNode,
+    std::string const& ifName)
+    : node_(node),
+      otherNode_(otherNode),
+      ifName_(ifName),
+      adjacencyKeyString_(folly::sformat(
+          "{}{}:[{}:{}]",
+          Constants::kAdjDbMarker.toString(),
+          node_,
+          otherNode_,
+          ifName_)) {}
+
+folly::Expected<PerAdjacencyKey, std::string>
+PerAdjacencyKey::fromStr(const std::string& key) {
+  std::string node{};
+  std::string otherNode{};
+  std::string ifName{};
+  auto patt =
+      RE2::FullMatch(key, getAdjacencyRE2(), &node, &otherNode, &ifName);
+  if (!patt) {
+    return folly::makeUnexpected(folly::sformat("Invalid key format {}", key));
+  }
+  return PerAdjacencyKey(node, otherNode, ifName);
+}
+
+std::string
+PerAdjacencyKey::getNodeName() const {
+  return node_;
+}
+
+std::string
+PerAdjacencyKey::getOtherNodeName() const {
+  return otherNode_;
+}
+
+std::string
+PerAdjacencyKey::getIfName() const {
+  return ifName_;
+}
+
+std::string
+PerAdjacencyKey::getAdjacencyKey() const {
+  return adjacencyKeyString_;
+}
+
 int
 executeShellCommand(const std::string& command) {
   int ret = system(command.c_str());
@@ -363,6 +468,11 @@ addPerfEvent(
     const std::string& eventDescr) noexcept {
   thrift::PerfEvent event(
       apache::thrift::FRAGILE, nodeName, eventDescr, getUnixTimeStampMs());
+  // First event originates the trace, all later hops carry its ID along
+  if (perfEvents.events.empty() and not perfEvents.traceId_ref()) {
+    perfEvents.traceId_ref() = folly::sformat(
+        "{}:{}:{:x}", nodeName, event.unixTs, folly::Random::rand32());
+  }
   perfEvents.events.emplace_back(std::move(event));
 }
 
@@ -433,17 +543,29 @@ getDurationBetweenPerfEvents(
   return std::chrono::milliseconds(second - first);
 }
 
+// SpookyHashV2 is fast on large values and, unlike std/boost hashes of
+// strings, stable across builds and platforms as required for comparing hashes
+// among nodes. Fields are length-prefixed to keep their boundaries unambiguous.
 template <class T>
 int64_t
 generateHashImpl(
     const int64_t version, const std::string& originatorId, const T& value) {
-  size_t seed = 0;
-  boost::hash_combine(seed, version);
-  boost::hash_combine(seed, originatorId);
+  folly::hash::SpookyHashV2 hasher;
+  hasher.Init(0, 0);
+  auto update = [&hasher](uint64_t data) {
+    data = folly::Endian::little(data);
+    hasher.Update(&data, sizeof(data));
+  };
+  update(version);
+  update(originatorId.size());
+  hasher.Update(originatorId.data(), originatorId.size());
   if (value.has_value()) {
-    boost::hash_combine(seed, value.value());
+    update(value.value().size());
+    hasher.Update(value.value().data(), value.value().size());
   }
-  return static_cast<int64_t>(seed);
+  uint64_t hash1, hash2;
+  hasher.Final(&hash1, &hash2);
+  return static_cast<int64_t>(hash1);
 }
 
 int64_t
@@ -470,6 +592,44 @@ getRemoteIfName(const thrift::Adjacency& adj) {
   return folly::sformat("neigh-{}", adj.ifName);
 }
 
+namespace {
+
+// Minimum cost of unicast nexthops
+int32_t
+getMinCostUnicast(std::vector<thrift::NextHopThrift> const& allNextHops) {
+  int32_t minCost = std::numeric_limits<int32_t>::max();
+  for (auto const& nextHop : allNextHops) {
+    minCost = std::min(minCost, nextHop.metric);
+  }
+  return minCost;
+}
+
+// Minimum cost of mpls nexthops and mpls action of best nexthops
+std::pair<int32_t, thrift::MplsActionCode>
+getMinCostMpls(std::vector<thrift::NextHopThrift> const& allNextHops) {
+  int32_t minCost = std::numeric_limits<int32_t>::max();
+  thrift::MplsActionCode mplsActionCode{thrift::MplsActionCode::SWAP};
+  for (auto const& nextHop : allNextHops) {
+    CHECK(nextHop.mplsAction_ref().has_value());
+    // Action can't be push (we don't push labels in MPLS routes)
+    // or POP with multiple nexthops
+    CHECK(thrift::MplsActionCode::PUSH != nextHop.mplsAction_ref()->action);
+    CHECK(
+        thrift::MplsActionCode::POP_AND_LOOKUP !=
+        nextHop.mplsAction_ref()->action);
+
+    if (nextHop.metric <= minCost) {
+      minCost = nextHop.metric;
+      if (nextHop.mplsAction_ref()->action == thrift::MplsActionCode::PHP) {
+        mplsActionCode = thrift::MplsActionCode::PHP;
+      }
+    }
+  }
+  return {minCost, mplsActionCode};
+}
+
+} // namespace
+
 std::vector<thrift::NextHopThrift>
 getBestNextHopsUnicast(std::vector<thrift::NextHopThrift> const& allNextHops) {
   // Optimization
@@ -477,10 +637,7 @@ getBestNextHopsUnicast(std::vector<thrift::NextHopThrift> const& allNextHops) {
     return allNextHops;
   }
   // Find minimum cost
-  int32_t minCost = std::numeric_limits<int32_t>::max();
-  for (auto const& nextHop : allNextHops) {
-    minCost = std::min(minCost, nextHop.metric);
-  }
+  const auto minCost = getMinCostUnicast(allNextHops);
 
   // Find nextHops with the minimum cost
   std::vector<thrift::NextHopThrift> bestNextHops;
@@ -493,6 +650,48 @@ getBestNextHopsUnicast(std::vector<thrift::NextHopThrift> const& allNextHops) {
   return bestNextHops;
 }
 
+std::vector<int32_t>
+normalizeNextHopWeights(
+    std::vector<int64_t> const& weights, int64_t maxWeightSum) {
+  std::vector<int64_t> reduced;
+  reduced.reserve(weights.size());
+  for (auto const weight : weights) {
+    reduced.emplace_back(std::max<int64_t>(weight, 1));
+  }
+
+  // returns sum of weights after dividing them by their gcd
+  auto divideByGcd = [&reduced]() {
+    int64_t gcd = 0;
+    for (auto const weight : reduced) {
+      gcd = std::gcd(gcd, weight);
+    }
+    int64_t sum = 0;
+    for (auto& weight : reduced) {
+      weight /= gcd;
+      sum += weight;
+    }
+    return sum;
+  };
+
+  auto sum = divideByGcd();
+  if (sum > maxWeightSum) {
+    // rounded down, sum only exceeds the max by weights raised to 1
+    for (auto& weight : reduced) {
+      weight = std::max<int64_t>(weight * maxWeightSum / sum, 1);
+    }
+    sum = divideByGcd();
+  }
+
+  // all weights are reduced to 1 if they are equal
+  const bool ecmp = sum == static_cast<int64_t>(reduced.size());
+  std::vector<int32_t> normalized;
+  normalized.reserve(reduced.size());
+  for (auto const weight : reduced) {
+    normalized.emplace_back(ecmp ? 0 : static_cast<int32_t>(weight));
+  }
+  return normalized;
+}
+
 std::vector<thrift::NextHopThrift>
 getBestNextHopsMpls(std::vector<thrift::NextHopThrift> const& allNextHops) {
   // Optimization for single nexthop case
@@ -500,24 +699,7 @@ getBestNextHopsMpls(std::vector<thrift::NextHopThrift> const& allNextHops) {
     return allNextHops;
   }
   // Find minimum cost and mpls action
-  int32_t minCost = std::numeric_limits<int32_t>::max();
-  thrift::MplsActionCode mplsActionCode{thrift::MplsActionCode::SWAP};
-  for (auto const& nextHop : allNextHops) {
-    CHECK(nextHop.mplsAction_ref().has_value());
-    // Action can't be push (we don't push labels in MPLS routes)
-    // or POP with multiple nexthops
-    CHECK(thrift::MplsActionCode::PUSH != nextHop.mplsAction_ref()->action);
-    CHECK(
-        thrift::MplsActionCode::POP_AND_LOOKUP !=
-        nextHop.mplsAction_ref()->action);
-
-    if (nextHop.metric <= minCost) {
-      minCost = nextHop.metric;
-      if (nextHop.mplsAction_ref()->action == thrift::MplsActionCode::PHP) {
-        mplsActionCode = thrift::MplsActionCode::PHP;
-      }
-    }
-  }
+  const auto [minCost, mplsActionCode] = getMinCostMpls(allNextHops);
 
   // Find nextHops with the minimum cost and required mpls action
   std::vector<thrift::NextHopThrift> bestNextHops;
@@ -987,6 +1169,48 @@ createMplsRoutesWithBestNextHops(const std::vector<thrift::MplsRoute>& routes) {
   return newRoutes;
 }
 
+void
+patchUnicastRoutesWithBestNexthops(std::vector<thrift::UnicastRoute>& routes) {
+  for (auto& route : routes) {
+    auto& nextHops = route.nextHops;
+    if (nextHops.size() > 1) {
+      const auto minCost = getMinCostUnicast(nextHops);
+      nextHops.erase(
+          std::remove_if(
+              nextHops.begin(),
+              nextHops.end(),
+              [minCost](auto const& nextHop) {
+                return nextHop.metric != minCost and
+                    not nextHop.useNonShortestRoute;
+              }),
+          nextHops.end());
+    }
+    // Same as created route, which carries just destination and nexthops
+    route = createUnicastRoute(std::move(route.dest), std::move(nextHops));
+  }
+}
+
+void
+patchMplsRoutesWithBestNextHops(std::vector<thrift::MplsRoute>& routes) {
+  for (auto& route : routes) {
+    auto& nextHops = route.nextHops;
+    if (nextHops.size() > 1) {
+      const auto [minCost, mplsActionCode] = getMinCostMpls(nextHops);
+      nextHops.erase(
+          std::remove_if(
+              nextHops.begin(),
+              nextHops.end(),
+              [minCost = minCost,
+               mplsActionCode = mplsActionCode](auto const& nextHop) {
+                return nextHop.metric != minCost or
+                    nextHop.mplsAction_ref()->action != mplsActionCode;
+              }),
+          nextHops.end());
+    }
+    route = createMplsRoute(route.topLabel, std::move(nextHops));
+  }
+}
+
 std::vector<thrift::UnicastRoute>
 createUnicastRoutesWithBestNextHopsMap(
     const std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute>&
@@ -1017,6 +1241,45 @@ createMplsRoutesWithBestNextHopsMap(
   return newRoutes;
 }
 
+thrift::CompactUnicastRoutes
+createCompactUnicastRoutes(const std::vector<thrift::UnicastRoute>& routes) {
+  thrift::CompactUnicastRoutes compactRoutes;
+  std::map<thrift::NextHopThrift, int32_t> nextHopIndices;
+  compactRoutes.routes.reserve(routes.size());
+  for (auto const& route : routes) {
+    thrift::CompactUnicastRoute compactRoute;
+    compactRoute.dest = route.dest;
+    compactRoute.nextHopIndices.reserve(route.nextHops.size());
+    for (auto const& nextHop : route.nextHops) {
+      auto [it, inserted] =
+          nextHopIndices.emplace(nextHop, compactRoutes.nextHops.size());
+      if (inserted) {
+        compactRoutes.nextHops.emplace_back(nextHop);
+      }
+      compactRoute.nextHopIndices.emplace_back(it->second);
+    }
+    compactRoutes.routes.emplace_back(std::move(compactRoute));
+  }
+  return compactRoutes;
+}
+
+std::vector<thrift::UnicastRoute>
+createUnicastRoutesFromCompact(
+    const thrift::CompactUnicastRoutes& compactRoutes) {
+  std::vector<thrift::UnicastRoute> routes;
+  routes.reserve(compactRoutes.routes.size());
+  for (auto const& compactRoute : compactRoutes.routes) {
+    std::vector<thrift::NextHopThrift> nextHops;
+    nextHops.reserve(compactRoute.nextHopIndices.size());
+    for (auto index : compactRoute.nextHopIndices) {
+      nextHops.emplace_back(compactRoutes.nextHops.at(index));
+    }
+    routes.emplace_back(
+        createUnicastRoute(compactRoute.dest, std::move(nextHops)));
+  }
+  return routes;
+}
+
 std::string
 getNodeNameFromKey(const std::string& key) {
   std::vector<std::string> split;
@@ -1032,6 +1295,52 @@ createPeerSyncId(const std::string& node, const std::string& area) {
   return folly::to<std::string>(node, "::TCP::SYNC::", area);
 };
 
+void
+applyThreadScheduling(
+    const std::string& threadName,
+    const thrift::ThreadSchedulingConfig& scheduling) {
+  if (not scheduling.cpus.empty()) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto const cpu : scheduling.cpus) {
+      CPU_SET(cpu, &cpuSet);
+    }
+    const auto err =
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (err != 0) {
+      LOG(ERROR) << "Failed to pin " << threadName << " thread to CPUs "
+                 << folly::join(",", scheduling.cpus) << ": "
+                 << folly::errnoStr(err);
+    } else {
+      LOG(INFO) << "Pinned " << threadName << " thread to CPUs "
+                << folly::join(",", scheduling.cpus);
+    }
+  }
+
+  if (auto priority = scheduling.realtime_priority_ref()) {
+    sched_param param{};
+    param.sched_priority = *priority;
+    const auto err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+      LOG(ERROR) << "Failed to set real-time priority " << *priority << " of "
+                 << threadName << " thread: " << folly::errnoStr(err);
+    } else {
+      LOG(INFO) << "Set real-time priority " << *priority << " of "
+                << threadName << " thread";
+    }
+  } else if (auto nice = scheduling.nice_ref()) {
+    // nice value applies to a single thread on Linux, given its tid
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, *nice) != 0) {
+      PLOG(ERROR) << "Failed to set nice value " << *nice << " of "
+                  << threadName << " thread";
+    } else {
+      LOG(INFO) << "Set nice value " << *nice << " of " << threadName
+                << " thread";
+    }
+  }
+}
+
 namespace MetricVectorUtils {
 
 std::optional<const openr::thrift::MetricEntity>
@@ -1209,6 +1518,146 @@ compareMetricVectors(
   return result;
 }
 
+CompiledMetricVector
+compileMetricVector(thrift::MetricVector const& mv) {
+  CompiledMetricVector compiled;
+  compiled.version = mv.version;
+  compiled.entities.reserve(mv.metrics.size());
+  size_t numMetrics = 0;
+  for (auto const& entity : mv.metrics) {
+    numMetrics += entity.metric.size();
+  }
+  compiled.metrics.reserve(numMetrics);
+  for (auto const& entity : mv.metrics) {
+    compiled.entities.push_back(CompiledMetricVector::Entity{
+        entity.type,
+        entity.priority,
+        entity.op,
+        entity.isBestPathTieBreaker,
+        static_cast<uint32_t>(compiled.metrics.size()),
+        static_cast<uint32_t>(entity.metric.size())});
+    compiled.metrics.insert(
+        compiled.metrics.end(), entity.metric.begin(), entity.metric.end());
+  }
+  std::stable_sort(
+      compiled.entities.begin(),
+      compiled.entities.end(),
+      [](auto const& l, auto const& r) { return l.priority > r.priority; });
+  return compiled;
+}
+
+bool
+hasMetricEntityOfType(CompiledMetricVector const& mv, int64_t type) {
+  return std::any_of(
+      mv.entities.begin(), mv.entities.end(), [type](auto const& entity) {
+        return entity.type == type;
+      });
+}
+
+void
+addMetricEntity(CompiledMetricVector& mv, thrift::MetricEntity const& entity) {
+  auto it = std::upper_bound(
+      mv.entities.begin(),
+      mv.entities.end(),
+      entity.priority,
+      [](int64_t priority, auto const& e) { return priority > e.priority; });
+  mv.entities.insert(
+      it,
+      CompiledMetricVector::Entity{
+          entity.type,
+          entity.priority,
+          entity.op,
+          entity.isBestPathTieBreaker,
+          static_cast<uint32_t>(mv.metrics.size()),
+          static_cast<uint32_t>(entity.metric.size())});
+  mv.metrics.insert(
+      mv.metrics.end(), entity.metric.begin(), entity.metric.end());
+}
+
+CompareResult
+compareMetrics(
+    int64_t const* l,
+    size_t lSize,
+    int64_t const* r,
+    size_t rSize,
+    bool tieBreaker) {
+  if (lSize != rSize) {
+    return CompareResult::ERROR;
+  }
+  // plain loop over contiguous arrays, which the compiler can vectorize
+  auto const [lIter, rIter] = std::mismatch(l, l + lSize, r);
+  if (lIter == l + lSize) {
+    return CompareResult::TIE;
+  }
+  if (*lIter > *rIter) {
+    return tieBreaker ? CompareResult::TIE_WINNER : CompareResult::WINNER;
+  }
+  return tieBreaker ? CompareResult::TIE_LOOSER : CompareResult::LOOSER;
+}
+
+CompareResult
+resultForLoner(CompiledMetricVector::Entity const& entity) {
+  if (thrift::CompareType::WIN_IF_PRESENT == entity.op) {
+    return entity.isBestPathTieBreaker ? CompareResult::TIE_WINNER
+                                       : CompareResult::WINNER;
+  } else if (thrift::CompareType::WIN_IF_NOT_PRESENT == entity.op) {
+    return entity.isBestPathTieBreaker ? CompareResult::TIE_LOOSER
+                                       : CompareResult::LOOSER;
+  }
+  // IGNORE_IF_NOT_PRESENT
+  return CompareResult::TIE;
+}
+
+CompareResult
+compareMetricVectors(
+    CompiledMetricVector const& l, CompiledMetricVector const& r) {
+  CompareResult result = CompareResult::TIE;
+
+  if (l.version != r.version) {
+    return CompareResult::ERROR;
+  }
+
+  auto lIter = l.entities.begin();
+  auto rIter = r.entities.begin();
+  while (!isDecisive(result) &&
+         (lIter != l.entities.end() && rIter != r.entities.end())) {
+    if (lIter->type == rIter->type) {
+      if (lIter->isBestPathTieBreaker != rIter->isBestPathTieBreaker) {
+        maybeUpdate(result, CompareResult::ERROR);
+      } else {
+        maybeUpdate(
+            result,
+            compareMetrics(
+                l.metrics.data() + lIter->offset,
+                lIter->size,
+                r.metrics.data() + rIter->offset,
+                rIter->size,
+                lIter->isBestPathTieBreaker));
+      }
+      ++lIter;
+      ++rIter;
+    } else if (lIter->priority > rIter->priority) {
+      maybeUpdate(result, resultForLoner(*lIter));
+      ++lIter;
+    } else if (lIter->priority < rIter->priority) {
+      maybeUpdate(result, !resultForLoner(*rIter));
+      ++rIter;
+    } else {
+      // priorities are the same but types are different
+      maybeUpdate(result, CompareResult::ERROR);
+    }
+  }
+  while (!isDecisive(result) && lIter != l.entities.end()) {
+    maybeUpdate(result, resultForLoner(*lIter));
+    ++lIter;
+  }
+  while (!isDecisive(result) && rIter != r.entities.end()) {
+    maybeUpdate(result, !resultForLoner(*rIter));
+    ++rIter;
+  }
+  return result;
+}
+
 } // namespace MetricVectorUtils
 
 } // namespace openr
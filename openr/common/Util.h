@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -36,6 +37,7 @@
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 #include <openr/if/gen-cpp2/OpenrConfig_types.h>
+#include <openr/if/gen-cpp2/Platform_types.h>
 
 /**
  * Helper macro function to log execution time of function.
@@ -79,14 +81,25 @@ struct MplsLabelAndNextHops {
 };
 
 /**
- * Class to store re2 objects, provides API to match string with regex
+ * Class to store re2 objects, provides API to match string with regex.
+ * Key prefixes are RE2 patterns anchored at the start of the key. If all of
+ * them are plain strings, as usual, keys are matched by a binary search over
+ * sorted prefixes instead of running RE2 set on every key
  */
 class KeyPrefix {
  public:
   explicit KeyPrefix(std::vector<std::string> const& keyPrefixList);
   bool keyMatch(std::string const& key) const;
 
+  // Return the pattern if it is a plain string, std::nullopt otherwise
+  static std::optional<std::string> getLiteralPrefix(
+      const std::string& keyPrefix);
+
  private:
+  // literal prefixes in sorted order, none of them being a prefix of another
+  // one. Only set if all prefixes are literal
+  std::vector<std::string> literalPrefixes_;
+
   std::unique_ptr<re2::RE2::Set> keyPrefix_;
 };
 
@@ -149,6 +162,60 @@ class PrefixKey {
   std::string prefixKeyString_;
 };
 
+/**
+ * PerAdjacencyKey class to form and parse per adjacency key of a node, i.e.
+ * `adj:<node>:[<otherNode>:<ifName>]`. Value of the key is an adjacency
+ * database carrying single adjacency, whereas node attributes are carried by
+ * `adj:<node>` key. This allows advertising a change of single adjacency
+ * without flooding whole adjacency database of the node.
+ */
+class PerAdjacencyKey {
+ public:
+  PerAdjacencyKey(
+      std::string const& node,
+      std::string const& otherNode,
+      std::string const& ifName);
+
+  // construct PerAdjacencyKey object from a given key string
+  static folly::Expected<PerAdjacencyKey, std::string> fromStr(
+      const std::string& key);
+
+  // return node name
+  std::string getNodeName() const;
+
+  // return node name of the other end of adjacency
+  std::string getOtherNodeName() const;
+
+  // return local interface name of adjacency
+  std::string getIfName() const;
+
+  // return adjacency key string to be used to flood to kvstore
+  std::string getAdjacencyKey() const;
+
+  static const RE2&
+  getAdjacencyRE2() {
+    static const RE2 adjacencyKeyPattern{folly::sformat(
+        "{}(?P<node>[a-zA-Z\\d\\.\\-\\_]+):"
+        "\\[(?P<otherNode>[a-zA-Z\\d\\.\\-\\_]+):"
+        "(?P<ifName>.+)\\]",
+        Constants::kAdjDbMarker.toString())};
+    return adjacencyKeyPattern;
+  }
+
+ private:
+  // node name
+  std::string node_{};
+
+  // node name of the other end
+  std::string otherNode_{};
+
+  // local interface name
+  std::string ifName_{};
+
+  // per adjacency key
+  std::string adjacencyKeyString_{};
+};
+
 /**
  * Utility function to execute shell command and return true/false as
  * indication of it's success
@@ -274,6 +341,16 @@ std::string getRemoteIfName(const thrift::Adjacency& adj);
 std::vector<thrift::NextHopThrift> getBestNextHopsUnicast(
     std::vector<thrift::NextHopThrift> const& nextHops);
 
+/**
+ * Reduce weights of UCMP nexthops keeping their ratio, by their greatest
+ * common divisor and if sum of them still exceeds `maxWeightSum` by scaling
+ * them down (min weight being 1). Non-positive weights count as 1. All
+ * weights are returned as 0, i.e. ECMP, if they are equal.
+ */
+std::vector<int32_t> normalizeNextHopWeights(
+    std::vector<int64_t> const& weights,
+    int64_t maxWeightSum = Constants::kMaxNextHopWeightSum);
+
 /**
  * Given list of nextHops for mpls route, validate nexthops and return
  * nextHops with lowest metric value and of same MplsActionCode.
@@ -512,6 +589,15 @@ std::vector<thrift::UnicastRoute> createUnicastRoutesWithBestNexthops(
 std::vector<thrift::MplsRoute> createMplsRoutesWithBestNextHops(
     const std::vector<thrift::MplsRoute>& routes);
 
+/**
+ * In-place versions of above, re-using routes and their nexthops instead of
+ * copying them
+ */
+void patchUnicastRoutesWithBestNexthops(
+    std::vector<thrift::UnicastRoute>& routes);
+
+void patchMplsRoutesWithBestNextHops(std::vector<thrift::MplsRoute>& routes);
+
 std::vector<thrift::UnicastRoute> createUnicastRoutesWithBestNextHopsMap(
     const std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute>&
         unicastRoutes);
@@ -519,10 +605,29 @@ std::vector<thrift::UnicastRoute> createUnicastRoutesWithBestNextHopsMap(
 std::vector<thrift::MplsRoute> createMplsRoutesWithBestNextHopsMap(
     const std::unordered_map<uint32_t, thrift::MplsRoute>& mplsRoutes);
 
+/**
+ * Convert unicast routes into compact form where nexthops shared among routes
+ * are stored once, and back. Conversion back throws std::out_of_range on
+ * invalid nexthop index.
+ */
+thrift::CompactUnicastRoutes createCompactUnicastRoutes(
+    const std::vector<thrift::UnicastRoute>& routes);
+
+std::vector<thrift::UnicastRoute> createUnicastRoutesFromCompact(
+    const thrift::CompactUnicastRoutes& compactRoutes);
+
 std::string getNodeNameFromKey(const std::string& key);
 
 std::string createPeerSyncId(const std::string& node, const std::string& area);
 
+/**
+ * Apply CPU affinity and priority to the calling thread. Failures are logged,
+ * thread keeps running with the scheduling it could get
+ */
+void applyThreadScheduling(
+    const std::string& threadName,
+    const thrift::ThreadSchedulingConfig& scheduling);
+
 namespace MetricVectorUtils {
 
 enum class CompareResult { WINNER, TIE_WINNER, TIE, TIE_LOOSER, LOOSER, ERROR };
@@ -557,6 +662,47 @@ void maybeUpdate(CompareResult& target, CompareResult update);
 
 CompareResult compareMetricVectors(
     thrift::MetricVector const& l, thrift::MetricVector const& r);
+
+// Metric vector flattened for fast comparison, built once per prefix entry.
+// Entities are sorted in decreasing order of priority and their metrics are
+// laid out in one contiguous array, so that comparing two vectors doesn't
+// chase per-entity allocations
+struct CompiledMetricVector {
+  struct Entity {
+    int64_t type{0};
+    int64_t priority{0};
+    thrift::CompareType op{thrift::CompareType::WIN_IF_PRESENT};
+    bool isBestPathTieBreaker{false};
+    // range of the entity's metric in metrics
+    uint32_t offset{0};
+    uint32_t size{0};
+  };
+
+  int64_t version{0};
+  std::vector<Entity> entities;
+  std::vector<int64_t> metrics;
+};
+
+CompiledMetricVector compileMetricVector(thrift::MetricVector const& mv);
+
+bool hasMetricEntityOfType(CompiledMetricVector const& mv, int64_t type);
+
+// add entity, keeping entities sorted in decreasing order of priority
+void addMetricEntity(
+    CompiledMetricVector& mv, thrift::MetricEntity const& entity);
+
+CompareResult compareMetrics(
+    int64_t const* l,
+    size_t lSize,
+    int64_t const* r,
+    size_t rSize,
+    bool tieBreaker);
+
+CompareResult resultForLoner(CompiledMetricVector::Entity const& entity);
+
+// same result as compareMetricVectors() on the original metric vectors
+CompareResult compareMetricVectors(
+    CompiledMetricVector const& l, CompiledMetricVector const& r);
 } // namespace MetricVectorUtils
 
 } // namespace openr
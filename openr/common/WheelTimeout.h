@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include <folly/Function.h>
+#include <folly/io/async/HHWheelTimer.h>
+
+namespace openr {
+
+/**
+ * Timeout scheduled on a shared folly::HHWheelTimer, with interface similar
+ * to folly::AsyncTimeout. Scheduling and cancellation are O(1) irrespective
+ * of the number of timeouts on the wheel, unlike libevent timers.
+ *
+ * Timeout can also be extended lazily with `extendTimeout`, which only
+ * records the new deadline. Timeout is rescheduled for the remaining time
+ * when it fires, hence extending hold timers on every keep-alive doesn't
+ * touch the wheel.
+ */
+class WheelTimeout : private folly::HHWheelTimer::Callback {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  WheelTimeout(folly::HHWheelTimer& timer, folly::Function<void()> callback)
+      : timer_(timer), callback_(std::move(callback)) {}
+
+  static std::unique_ptr<WheelTimeout>
+  make(folly::HHWheelTimer& timer, folly::Function<void()> callback) {
+    return std::make_unique<WheelTimeout>(timer, std::move(callback));
+  }
+
+  // (Re)schedule timeout to fire after `timeout` from now
+  void
+  scheduleTimeout(std::chrono::milliseconds timeout) {
+    deadline_ = Clock::now() + timeout;
+    timer_.scheduleTimeout(this, timeout);
+  }
+
+  // Make scheduled timeout fire no earlier than `timeout` from now, or
+  // schedule it if not scheduled
+  void
+  extendTimeout(std::chrono::milliseconds timeout) {
+    if (not isScheduled()) {
+      scheduleTimeout(timeout);
+      return;
+    }
+    deadline_ = std::max(deadline_, Clock::now() + timeout);
+  }
+
+  void
+  cancelTimeout() {
+    folly::HHWheelTimer::Callback::cancelTimeout();
+  }
+
+  bool
+  isScheduled() const {
+    return folly::HHWheelTimer::Callback::isScheduled();
+  }
+
+ private:
+  void
+  timeoutExpired() noexcept override {
+    // Reschedule if timeout has been extended (or wheel fired early)
+    const auto now = Clock::now();
+    if (deadline_ > now) {
+      timer_.scheduleTimeout(
+          this,
+          std::chrono::ceil<std::chrono::milliseconds>(deadline_ - now));
+      return;
+    }
+    // NOTE: callback may destroy this object
+    callback_();
+  }
+
+  void
+  callbackCanceled() noexcept override {}
+
+  folly::HHWheelTimer& timer_;
+  folly::Function<void()> callback_;
+  Clock::time_point deadline_;
+};
+
+} // namespace openr
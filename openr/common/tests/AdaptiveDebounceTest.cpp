@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/AdaptiveDebounce.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+const std::chrono::milliseconds kMinDelay{10};
+const std::chrono::milliseconds kMaxDelay{500};
+} // namespace
+
+TEST(AdaptiveDebounceTest, IsolatedEventTest) {
+  openr::AdaptiveDebounce debounce(kMinDelay, kMaxDelay);
+  const auto now = openr::AdaptiveDebounce::Clock::now();
+
+  // First event ever is isolated
+  EXPECT_TRUE(debounce.isIsolated(now));
+  EXPECT_EQ(kMinDelay, debounce.reportEvent(now));
+  EXPECT_FALSE(debounce.getEventInterval().has_value());
+
+  // Not isolated while batch is pending
+  EXPECT_FALSE(debounce.isIsolated(now + 1s));
+  debounce.reportProcessed(1ms);
+
+  // Not isolated within max delay of the last event
+  EXPECT_FALSE(debounce.isIsolated(now + kMaxDelay - 1ms));
+  EXPECT_TRUE(debounce.isIsolated(now + kMaxDelay));
+}
+
+TEST(AdaptiveDebounceTest, ProcessingCostTest) {
+  openr::AdaptiveDebounce debounce(kMinDelay, kMaxDelay);
+  auto now = openr::AdaptiveDebounce::Clock::now();
+
+  // Delay follows cost of the last processing, within bounds
+  debounce.reportEvent(now);
+  debounce.reportProcessed(100ms);
+  now += 1s;
+  EXPECT_EQ(100ms, debounce.reportEvent(now));
+  EXPECT_EQ(100ms, debounce.getDelay());
+
+  // Slower events within the batch don't extend it
+  EXPECT_EQ(50ms, debounce.reportEvent(now + 50ms));
+  debounce.reportProcessed(1s);
+  now += 2s;
+  EXPECT_EQ(kMaxDelay, debounce.reportEvent(now));
+  debounce.reportProcessed(0ms);
+  now += 2s;
+  EXPECT_EQ(kMinDelay, debounce.reportEvent(now));
+}
+
+TEST(AdaptiveDebounceTest, EventStormTest) {
+  openr::AdaptiveDebounce debounce(kMinDelay, kMaxDelay);
+  const auto start = openr::AdaptiveDebounce::Clock::now();
+
+  // Events every 1ms, faster than min delay, double the delay each time
+  EXPECT_EQ(kMinDelay, debounce.reportEvent(start));
+  EXPECT_EQ(19ms, debounce.reportEvent(start + 1ms));
+  EXPECT_EQ(38ms, debounce.reportEvent(start + 2ms));
+  ASSERT_TRUE(debounce.getEventInterval().has_value());
+  EXPECT_EQ(1ms, *debounce.getEventInterval());
+  for (int i = 3; i < 10; ++i) {
+    debounce.reportEvent(start + i * 1ms);
+  }
+  EXPECT_EQ(kMaxDelay, debounce.getDelay());
+  EXPECT_EQ(kMaxDelay - 10ms, debounce.reportEvent(start + 10ms));
+
+  // Deadline in the past is due right away
+  EXPECT_EQ(0ms, debounce.reportEvent(start + 1s));
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
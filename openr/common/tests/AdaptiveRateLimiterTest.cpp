@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/AdaptiveRateLimiter.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+const openr::AdaptiveRateLimiter::Clock::time_point kStart{};
+} // namespace
+
+TEST(AdaptiveRateLimiterTest, PacingTest) {
+  openr::AdaptiveRateLimiter limiter(10, 1000, 100, 10, 50, 100ms, kStart);
+  EXPECT_EQ(100, limiter.getRate());
+
+  // starts with burst of tokens
+  EXPECT_EQ(50, limiter.getTokens(kStart));
+  EXPECT_EQ(0ms, limiter.getWaitTime(50, kStart));
+
+  // refilled at rate
+  limiter.consume(50, kStart);
+  EXPECT_EQ(0, limiter.getTokens(kStart));
+  EXPECT_EQ(200ms, limiter.getWaitTime(20, kStart));
+  EXPECT_EQ(20, limiter.getTokens(kStart + 200ms));
+
+  // never beyond burst, and wait is capped to it
+  EXPECT_EQ(50, limiter.getTokens(kStart + 10s));
+  EXPECT_EQ(0ms, limiter.getWaitTime(100, kStart + 10s));
+
+  // borrowed tokens delay what follows, borrowing is bounded by burst
+  limiter.consume(200, kStart + 10s);
+  EXPECT_EQ(-50, limiter.getTokens(kStart + 10s));
+  EXPECT_EQ(1000ms, limiter.getWaitTime(50, kStart + 10s));
+}
+
+TEST(AdaptiveRateLimiterTest, FeedbackTest) {
+  openr::AdaptiveRateLimiter limiter(10, 150, 100, 10, 50, 100ms, kStart);
+
+  // additive increase on timely acks, up to max rate
+  limiter.reportSuccess(100ms);
+  EXPECT_EQ(110, limiter.getRate());
+  for (int i = 0; i < 10; ++i) {
+    limiter.reportSuccess(10ms);
+  }
+  EXPECT_EQ(150, limiter.getRate());
+
+  // multiplicative decrease on late acks and failures, down to min rate
+  limiter.reportSuccess(101ms);
+  EXPECT_EQ(75, limiter.getRate());
+  limiter.reportFailure();
+  EXPECT_EQ(37.5, limiter.getRate());
+  for (int i = 0; i < 10; ++i) {
+    limiter.reportFailure();
+  }
+  EXPECT_EQ(10, limiter.getRate());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -118,6 +118,59 @@ TEST(AsyncThrottleTest, ImmediateExecution) {
   LOG(INFO) << "Stopping event base.";
 }
 
+TEST(AsyncThrottleTest, LeadingEdgeTest) {
+  folly::EventBase evb;
+
+  int count = 0;
+  AsyncThrottle throttledFn(
+      &evb,
+      chrono::milliseconds(100),
+      [&count]() noexcept {
+        count++;
+        LOG(INFO) << "Incremented counter. New value: " << count;
+      },
+      AsyncThrottle::Edge::LEADING);
+
+  evb.runInLoop([&]() noexcept {
+    // First call is executed right away, following ones are coalesced
+    EXPECT_FALSE(throttledFn.isActive());
+    throttledFn();
+    EXPECT_EQ(1, count);
+    EXPECT_FALSE(throttledFn.isActive());
+    for (int i = 0; i < 100; i++) {
+      throttledFn();
+      EXPECT_EQ(1, count);
+      EXPECT_TRUE(throttledFn.isActive());
+    }
+  });
+
+  // Coalesced calls are executed once at the end of window, which starts a
+  // new one. Cancelled call within it is not executed
+  folly::AsyncTimeout::schedule(chrono::milliseconds(150), evb, [&]() noexcept {
+    EXPECT_EQ(2, count);
+    EXPECT_FALSE(throttledFn.isActive());
+    throttledFn();
+    EXPECT_EQ(2, count);
+    EXPECT_TRUE(throttledFn.isActive());
+    throttledFn.cancel();
+    EXPECT_FALSE(throttledFn.isActive());
+  });
+
+  // Call after quiet window is executed right away
+  folly::AsyncTimeout::schedule(chrono::milliseconds(400), evb, [&]() noexcept {
+    EXPECT_EQ(2, count);
+    throttledFn();
+    EXPECT_EQ(3, count);
+    evb.terminateLoopSoon();
+  });
+
+  // Loop thread
+  LOG(INFO) << "Starting event base.";
+  evb.loop();
+  EXPECT_EQ(3, count);
+  LOG(INFO) << "Stopping event base.";
+}
+
 } // namespace openr
 
 int
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fb303/ServiceData.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/EventLogger.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+// collects samples shipped by the logger
+openr::EventLogger::Sink
+collect(std::vector<std::string>& samples) {
+  return [&samples](fbzmq::thrift::EventLog&& log) {
+    EXPECT_EQ(openr::Constants::kEventLogCategory.toString(), log.category);
+    for (auto& sample : log.samples) {
+      samples.emplace_back(std::move(sample));
+    }
+  };
+}
+
+openr::EventLogger::Event
+makeEvent(std::string const& type, int64_t value) {
+  openr::EventLogger::Event event;
+  event.event = type;
+  event.strings.emplace_back("node_name", "node1");
+  event.ints.emplace_back("value", value);
+  return event;
+}
+
+} // namespace
+
+TEST(EventLoggerTest, ShipQueuedEventsTest) {
+  std::vector<std::string> samples;
+  {
+    openr::EventLogger logger("test_ship", collect(samples));
+    logger.log(makeEvent("EVENT_A", 1));
+    logger.log(makeEvent("EVENT_B", 2));
+    // events without type are ignored
+    logger.log(makeEvent("", 3));
+  }
+
+  // destruction ships everything queued before
+  ASSERT_EQ(2, samples.size());
+  EXPECT_NE(std::string::npos, samples.at(0).find("EVENT_A"));
+  EXPECT_NE(std::string::npos, samples.at(0).find("node1"));
+  EXPECT_NE(std::string::npos, samples.at(1).find("EVENT_B"));
+
+  const auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(2, counters.at("test_ship.event_log.logged.sum"));
+}
+
+TEST(EventLoggerTest, RateLimitTest) {
+  std::vector<std::string> samples;
+  openr::EventLogger::Options options;
+  options.maxEventsPerSec = 2;
+  {
+    openr::EventLogger logger("test_rate", collect(samples), options);
+    for (int i = 0; i < 5; ++i) {
+      logger.log(makeEvent("EVENT_A", i));
+    }
+    // limit applies per event type
+    logger.log(makeEvent("EVENT_B", 0));
+  }
+
+  EXPECT_EQ(3, samples.size());
+  const auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(3, counters.at("test_rate.event_log.rate_limited.sum"));
+}
+
+TEST(EventLoggerTest, SamplingTest) {
+  std::vector<std::string> samples;
+  openr::EventLogger::Options options;
+  options.sampleRates["EVENT_A"] = 3;
+  {
+    openr::EventLogger logger("test_sample", collect(samples), options);
+    for (int i = 0; i < 6; ++i) {
+      logger.log(makeEvent("EVENT_A", i));
+    }
+  }
+
+  EXPECT_EQ(2, samples.size());
+  const auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(4, counters.at("test_sample.event_log.sampled_out.sum"));
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <unistd.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/ExponentialDampener.h>
+
+namespace {
+const std::chrono::milliseconds kHalfLife{100};
+const double kSuppressThreshold{2000};
+const double kReuseThreshold{750};
+const std::chrono::milliseconds kMaxSuppressTime{400};
+} // namespace
+
+TEST(ExponentialDampenerTest, SuppressAndReuseTest) {
+  openr::ExponentialDampener dampener(
+      kHalfLife, kSuppressThreshold, kReuseThreshold, kMaxSuppressTime);
+  EXPECT_FALSE(dampener.isSuppressed());
+  EXPECT_EQ(0, dampener.getPenalty());
+  EXPECT_EQ(
+      std::chrono::milliseconds(0), dampener.getTimeRemainingUntilReuse());
+
+  // Penalty below suppress threshold
+  EXPECT_FALSE(dampener.addPenalty(1200));
+  EXPECT_LE(dampener.getPenalty(), 1200);
+  EXPECT_EQ(
+      std::chrono::milliseconds(0), dampener.getTimeRemainingUntilReuse());
+
+  // Penalty above suppress threshold, ~2400 decays to 750 in ~168ms
+  EXPECT_TRUE(dampener.addPenalty(1200));
+  EXPECT_TRUE(dampener.isSuppressed());
+  EXPECT_GT(dampener.getPenalty(), kSuppressThreshold);
+  EXPECT_GE(
+      dampener.getTimeRemainingUntilReuse(), std::chrono::milliseconds(100));
+  EXPECT_LE(
+      dampener.getTimeRemainingUntilReuse(), std::chrono::milliseconds(168));
+
+  // Penalty decays, but stays suppressed above reuse threshold
+  /* sleep override */
+  usleep(50000);
+  EXPECT_TRUE(dampener.isSuppressed());
+  EXPECT_LT(dampener.getPenalty(), kSuppressThreshold);
+
+  // Suppression ends once penalty decays below reuse threshold
+  /* sleep override */
+  usleep(150000);
+  EXPECT_FALSE(dampener.isSuppressed());
+  EXPECT_LT(dampener.getPenalty(), kReuseThreshold);
+  EXPECT_EQ(
+      std::chrono::milliseconds(0), dampener.getTimeRemainingUntilReuse());
+
+  // Penalty below suppress threshold doesn't suppress again
+  EXPECT_FALSE(dampener.addPenalty(1000));
+}
+
+TEST(ExponentialDampenerTest, MaxSuppressTimeTest) {
+  openr::ExponentialDampener dampener(
+      kHalfLife, kSuppressThreshold, kReuseThreshold, kMaxSuppressTime);
+
+  // Penalty is capped, so that suppression lasts at most max suppress time
+  EXPECT_TRUE(dampener.addPenalty(1000000));
+  EXPECT_LE(dampener.getPenalty(), kReuseThreshold * 16);
+  EXPECT_GE(
+      dampener.getTimeRemainingUntilReuse(), std::chrono::milliseconds(300));
+  EXPECT_LE(dampener.getTimeRemainingUntilReuse(), kMaxSuppressTime);
+}
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/Util.h>
+
+namespace {
+
+// number of keys matched per iteration
+const size_t kNumKeys{1000};
+
+// key prefixes of KvStore filters, e.g. of a leaf node
+std::vector<std::string>
+getKeyPrefixes(size_t numPrefixes, bool forceRegex) {
+  std::vector<std::string> prefixes{"prefix:", "allocprefix:", "nodeLabel:"};
+  for (size_t i = prefixes.size(); i < numPrefixes; ++i) {
+    prefixes.emplace_back(folly::sformat("adj:node{}:", i));
+  }
+  prefixes.resize(numPrefixes);
+  if (forceRegex) {
+    // empty group keeps the pattern but makes it non-literal
+    for (auto& prefix : prefixes) {
+      prefix += "(?:)";
+    }
+  }
+  return prefixes;
+}
+
+// mix of matching and non-matching keys
+std::vector<std::string>
+getKeys() {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    keys.emplace_back(
+        i % 2 ? folly::sformat("prefix:node{}:[fc00::{}/128]", i, i)
+              : folly::sformat("adj:node{}", i));
+  }
+  return keys;
+}
+
+} // namespace
+
+namespace openr {
+
+static void
+runKeyMatch(uint32_t iters, size_t numPrefixes, bool forceRegex) {
+  auto suspender = folly::BenchmarkSuspender();
+  const KeyPrefix keyPrefix(getKeyPrefixes(numPrefixes, forceRegex));
+  const auto keys = getKeys();
+  suspender.dismiss();
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    for (auto const& key : keys) {
+      folly::doNotOptimizeAway(keyPrefix.keyMatch(key));
+    }
+  }
+}
+
+/**
+ * Baseline: keys matched by RE2 set
+ */
+static void
+BM_KeyMatchRegex(uint32_t iters, size_t numPrefixes) {
+  runKeyMatch(iters, numPrefixes, true /* forceRegex */);
+}
+
+/**
+ * Keys matched by binary search over sorted literal prefixes
+ */
+static void
+BM_KeyMatchLiteral(uint32_t iters, size_t numPrefixes) {
+  runKeyMatch(iters, numPrefixes, false /* forceRegex */);
+}
+
+// The parameter is number of key prefixes
+BENCHMARK_PARAM(BM_KeyMatchRegex, 1);
+BENCHMARK_RELATIVE_PARAM(BM_KeyMatchLiteral, 1);
+BENCHMARK_PARAM(BM_KeyMatchRegex, 3);
+BENCHMARK_RELATIVE_PARAM(BM_KeyMatchLiteral, 3);
+BENCHMARK_PARAM(BM_KeyMatchRegex, 100);
+BENCHMARK_RELATIVE_PARAM(BM_KeyMatchLiteral, 100);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/LatencyHistogram.h>
+
+TEST(LatencyHistogramTest, EmptyTest) {
+  openr::LatencyHistogram histogram(1000);
+  EXPECT_EQ(0, histogram.getCount());
+  EXPECT_EQ(0, histogram.getMax());
+  EXPECT_EQ(0, histogram.getPercentile(50));
+}
+
+TEST(LatencyHistogramTest, PercentileTest) {
+  openr::LatencyHistogram histogram(3000);
+
+  // values below sub buckets count are exact
+  for (int64_t i = 0; i < openr::LatencyHistogram::kSubBuckets; ++i) {
+    histogram.addValue(i);
+  }
+  EXPECT_EQ(openr::LatencyHistogram::kSubBuckets, histogram.getCount());
+  EXPECT_EQ(3, histogram.getPercentile(50));
+  EXPECT_EQ(7, histogram.getPercentile(100));
+
+  // percentiles are within 1/kSubBuckets above the actual value
+  openr::LatencyHistogram uniform(3000);
+  for (int64_t i = 1; i <= 1000; ++i) {
+    uniform.addValue(i);
+  }
+  for (double percentile : {10.0, 50.0, 90.0, 99.0}) {
+    const auto actual = static_cast<int64_t>(percentile * 10);
+    EXPECT_LE(actual, uniform.getPercentile(percentile));
+    EXPECT_GE(
+        actual + actual / openr::LatencyHistogram::kSubBuckets,
+        uniform.getPercentile(percentile));
+  }
+  // never above the max value added
+  EXPECT_EQ(1000, uniform.getPercentile(100));
+  EXPECT_EQ(1000, uniform.getMax());
+}
+
+TEST(LatencyHistogramTest, OutOfRangeTest) {
+  openr::LatencyHistogram histogram(100);
+  histogram.addValue(-5);
+  histogram.addValue(100000);
+  EXPECT_EQ(2, histogram.getCount());
+  EXPECT_EQ(0, histogram.getPercentile(50));
+  EXPECT_EQ(100, histogram.getPercentile(100));
+  EXPECT_EQ(100, histogram.getMax());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+
+#include <fb303/ServiceData.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/MemoryAccounting.h>
+
+namespace fb303 = facebook::fb303;
+
+TEST(MemoryAccountingTest, TopConsumersTest) {
+  openr::setMemoryCounter("kvstore", "area1.kv_store", 300);
+  openr::setMemoryCounter("decision", "route_db", 100);
+  openr::setMemoryCounter("fib", "routes", 200);
+  // not a memory counter
+  fb303::fbData->setCounter("fib.num_routes", 1000);
+
+  EXPECT_EQ(100, fb303::fbData->getCounter("memory.decision.route_db_bytes"));
+
+  const auto top = openr::getTopMemoryConsumers(2);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ("memory.kvstore.area1.kv_store_bytes", top.at(0).first);
+  EXPECT_EQ(300, top.at(0).second);
+  EXPECT_EQ("memory.fib.routes_bytes", top.at(1).first);
+  EXPECT_EQ(200, top.at(1).second);
+
+  // cleared structures are no longer reported
+  openr::clearMemoryCounter("kvstore", "area1.kv_store");
+  EXPECT_EQ(2, openr::getTopMemoryConsumers(10).size());
+}
+
+TEST(MemoryAccountingTest, MemoryUsageTest) {
+  // short strings are held inline
+  EXPECT_EQ(sizeof(std::string), openr::getMemoryUsage(std::string("a")));
+  EXPECT_LT(1000, openr::getMemoryUsage(std::string(1000, 'a')));
+
+  openr::thrift::Value value;
+  const auto emptyBytes = openr::getMemoryUsage(value);
+  value.value_ref() = std::string(1000, 'a');
+  EXPECT_LE(emptyBytes + 1000, openr::getMemoryUsage(value));
+}
+
+TEST(MemoryAccountingTest, ModuleArenaTest) {
+  // no arena until module arenas are enabled
+  std::thread([]() { openr::bindThreadToModuleArena("module1"); }).join();
+  openr::updateModuleArenaCounters();
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(0, counters.count("jemalloc.arena.module1.allocated_bytes"));
+
+  if (not openr::enableModuleArenas()) {
+    LOG(INFO) << "Not running on jemalloc, skipping";
+    return;
+  }
+
+  // allocations of thread are accounted to the arena of its module
+  std::vector<std::string> strs;
+  std::thread([&strs]() {
+    openr::bindThreadToModuleArena("module1");
+    for (int i = 0; i < 100; ++i) {
+      strs.emplace_back(std::string(10000, 'a'));
+    }
+  }).join();
+  openr::updateModuleArenaCounters();
+  counters = fb303::fbData->getCounters();
+  EXPECT_LE(1000000, counters.at("jemalloc.arena.module1.allocated_bytes"));
+  EXPECT_LE(
+      counters.at("jemalloc.arena.module1.allocated_bytes"),
+      counters.at("jemalloc.arena.module1.active_bytes"));
+  EXPECT_LT(0, counters.at("jemalloc.arena.module1.resident_bytes"));
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
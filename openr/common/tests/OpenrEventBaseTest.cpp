@@ -12,6 +12,10 @@
 #include <folly/futures/Promise.h>
 #include <folly/init/Init.h>
 #include <folly/synchronization/Baton.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Sleep.h>
+#endif
 #include <gtest/gtest.h>
 
 #include <openr/common/OpenrEventBase.h>
@@ -73,6 +77,33 @@ TEST(OpenrEventBaseTest, FiberTest) {
   EXPECT_TRUE(f.hasValue());
 }
 
+TEST(OpenrEventBaseTest, EvbQueueTime) {
+  OpenrEventBase evb;
+  int calls{0};
+
+  // No accumulator outside of request context
+  EXPECT_EQ(nullptr, EvbQueueTime::get());
+  evb.runInEventBaseThread([&]() noexcept { ++calls; });
+
+  {
+    folly::RequestContextScopeGuard guard;
+    folly::RequestContext::get()->setContextData(
+        EvbQueueTime::getToken(), std::make_unique<EvbQueueTime>());
+    auto* queueTime = EvbQueueTime::get();
+    ASSERT_NE(nullptr, queueTime);
+
+    evb.runInEventBaseThread([&]() noexcept { ++calls; });
+    evb.runInEventBaseThread([&]() noexcept { ++calls; });
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    evb.getEvb()->loopOnce();
+    EXPECT_EQ(3, calls);
+
+    // Both callbacks of the request waited for at least 10ms
+    EXPECT_LE(std::chrono::milliseconds(20), queueTime->getQueueTime());
+  }
+}
+
 TEST(OpenrEventBaseTest, RunnableApi) {
   OpenrEventBase evb;
 
@@ -102,6 +133,71 @@ TEST(OpenrEventBaseTest, RunnableApi) {
   evbThread.join();
 }
 
+#if FOLLY_HAS_COROUTINES
+TEST(OpenrEventBaseTest, CoroTaskCancellation) {
+  OpenrEventBase evb;
+  std::atomic<bool> cancelled{false};
+  evb.addCoroTask(folly::coro::co_invoke(
+      [&cancelled]() -> folly::coro::Task<void> {
+        try {
+          co_await folly::coro::sleep(std::chrono::hours(1));
+        } catch (folly::OperationCancelled const&) {
+          cancelled = true;
+        }
+      }));
+
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  // stop() requests cancellation of the task and awaits it
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+  EXPECT_TRUE(cancelled);
+
+  // cancellation doesn't carry over to tasks of next run
+  EXPECT_FALSE(evb.getCancellationToken().isCancellationRequested());
+}
+
+TEST(OpenrEventBaseTest, CoroRunInEventBaseThread) {
+  OpenrEventBase evb1, evb2;
+  std::thread evbThread1([&]() { evb1.run(); });
+  std::thread evbThread2([&]() { evb2.run(); });
+  evb1.waitUntilRunning();
+  evb2.waitUntilRunning();
+
+  // awaited from another thread, runs in event base thread
+  EXPECT_TRUE(folly::coro::blockingWait(evb1.co_runInEventBaseThread(
+      [&]() { return evb1.getEvb()->isInEventBaseThread(); })));
+
+  // awaited from task of another event base, resumes on the awaiting one
+  folly::Baton baton;
+  evb2.addCoroTask(folly::coro::co_invoke(
+      [&]() -> folly::coro::Task<void> {
+        const auto value = co_await evb1.co_runInEventBaseThread([&]() {
+          EXPECT_TRUE(evb1.getEvb()->isInEventBaseThread());
+          return 1;
+        });
+        EXPECT_EQ(1, value);
+        EXPECT_TRUE(evb2.getEvb()->isInEventBaseThread());
+
+        // awaited on own event base thread, runs inline
+        bool ranInline{false};
+        co_await evb2.co_runInEventBaseThread([&]() { ranInline = true; });
+        EXPECT_TRUE(ranInline);
+        baton.post();
+      }));
+  baton.wait();
+
+  evb2.stop();
+  evb2.waitUntilStopped();
+  evbThread2.join();
+  evb1.stop();
+  evb1.waitUntilStopped();
+  evbThread1.join();
+}
+#endif
+
 TEST(OpenrEventBaseTest, DefaultConstructor) {
   OpenrEventBase evb;
   folly::Baton waitBaton;
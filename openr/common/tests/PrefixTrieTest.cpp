@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/PrefixTrie.h>
+
+namespace {
+folly::CIDRNetwork
+toNetwork(const std::string& prefix) {
+  return folly::IPAddress::createNetwork(prefix);
+}
+} // namespace
+
+TEST(PrefixTrieTest, InsertGetErase) {
+  openr::PrefixTrie<int> trie;
+  EXPECT_TRUE(trie.empty());
+
+  EXPECT_TRUE(trie.insert(toNetwork("10.0.0.0/8"), 1));
+  EXPECT_TRUE(trie.insert(toNetwork("10.1.0.0/16"), 2));
+  EXPECT_TRUE(trie.insert(toNetwork("10.2.0.0/16"), 3));
+  EXPECT_TRUE(trie.insert(toNetwork("fc00::/7"), 4));
+  EXPECT_FALSE(trie.insert(toNetwork("10.1.0.0/16"), 5)); // replace
+  EXPECT_EQ(4, trie.size());
+
+  ASSERT_NE(nullptr, trie.get(toNetwork("10.1.0.0/16")));
+  EXPECT_EQ(5, *trie.get(toNetwork("10.1.0.0/16")));
+  EXPECT_EQ(1, *trie.get(toNetwork("10.0.0.0/8")));
+  EXPECT_EQ(4, *trie.get(toNetwork("fc00::/7")));
+  // Intermediate node 10.0.0.0/14 is not a stored prefix
+  EXPECT_EQ(nullptr, trie.get(toNetwork("10.0.0.0/14")));
+  EXPECT_EQ(nullptr, trie.get(toNetwork("10.3.0.0/16")));
+  EXPECT_EQ(nullptr, trie.get(toNetwork("::/0")));
+
+  EXPECT_TRUE(trie.erase(toNetwork("10.0.0.0/8")));
+  EXPECT_FALSE(trie.erase(toNetwork("10.0.0.0/8")));
+  EXPECT_FALSE(trie.erase(toNetwork("10.0.0.0/14")));
+  EXPECT_EQ(3, trie.size());
+  EXPECT_EQ(nullptr, trie.get(toNetwork("10.0.0.0/8")));
+  EXPECT_EQ(5, *trie.get(toNetwork("10.1.0.0/16")));
+  EXPECT_EQ(3, *trie.get(toNetwork("10.2.0.0/16")));
+
+  trie.clear();
+  EXPECT_TRUE(trie.empty());
+  EXPECT_EQ(nullptr, trie.get(toNetwork("10.1.0.0/16")));
+}
+
+TEST(PrefixTrieTest, LongestMatch) {
+  openr::PrefixTrie<std::string> trie;
+  for (const auto& prefix : {"::/0",
+                             "192.168.0.0/16",
+                             "192.168.0.0/20",
+                             "192.168.0.0/24",
+                             "192.168.20.16/28",
+                             "fc00:cafe::/32",
+                             "fc00:cafe:1::/48"}) {
+    trie.insert(toNetwork(prefix), prefix);
+  }
+
+  auto lpm = [&](const std::string& prefix) -> std::string {
+    auto match = trie.longestMatch(toNetwork(prefix));
+    return match ? *match : "none";
+  };
+
+  EXPECT_EQ("192.168.20.16/28", lpm("192.168.20.19/32"));
+  EXPECT_EQ("192.168.20.16/28", lpm("192.168.20.16/28"));
+  EXPECT_EQ("192.168.0.0/24", lpm("192.168.0.0/32"));
+  EXPECT_EQ("192.168.0.0/16", lpm("192.168.0.0/18"));
+  EXPECT_EQ("192.168.0.0/20", lpm("192.168.0.0/22"));
+  EXPECT_EQ("192.168.0.0/16", lpm("192.168.128.1/32"));
+  // Less specific than any IPv4 prefix and IPv6 default doesn't apply to v4
+  EXPECT_EQ("none", lpm("192.168.0.0/14"));
+  EXPECT_EQ("none", lpm("10.0.0.1/32"));
+
+  EXPECT_EQ("fc00:cafe:1::/48", lpm("fc00:cafe:1::1/128"));
+  EXPECT_EQ("fc00:cafe::/32", lpm("fc00:cafe:2::1/128"));
+  EXPECT_EQ("::/0", lpm("fc00:cafe::/31"));
+  EXPECT_EQ("::/0", lpm("::/0"));
+
+  // Remove more specific route and match falls back to covering one
+  trie.erase(toNetwork("fc00:cafe:1::/48"));
+  EXPECT_EQ("fc00:cafe::/32", lpm("fc00:cafe:1::1/128"));
+  trie.erase(toNetwork("::/0"));
+  EXPECT_EQ("none", lpm("fc00:cafe::/31"));
+}
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Profiler.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// burn CPU for the duration
+uint64_t
+busyLoop(std::chrono::milliseconds duration) {
+  const auto deadline = std::chrono::steady_clock::now() + duration;
+  volatile uint64_t sum{0};
+  while (std::chrono::steady_clock::now() < deadline) {
+    for (int i = 0; i < 1000; ++i) {
+      sum = sum + i;
+    }
+  }
+  return sum;
+}
+
+} // namespace
+
+TEST(ProfilerTest, CpuProfileTest) {
+  openr::startCpuProfile(10s, 1000);
+  EXPECT_TRUE(openr::isCpuProfileRunning());
+
+  // one profile at a time
+  EXPECT_THROW(openr::startCpuProfile(1s, 100), std::runtime_error);
+
+  busyLoop(200ms);
+  const auto profile = openr::stopCpuProfile();
+  EXPECT_FALSE(openr::isCpuProfileRunning());
+  EXPECT_FALSE(profile.empty());
+  EXPECT_EQ('\n', profile.back());
+
+  // nothing left to stop
+  EXPECT_THROW(openr::stopCpuProfile(), std::runtime_error);
+}
+
+TEST(ProfilerTest, CpuProfileDurationTest) {
+  EXPECT_THROW(openr::startCpuProfile(0ms, 100), std::runtime_error);
+  EXPECT_THROW(openr::startCpuProfile(1s, 0), std::runtime_error);
+
+  // profile stops sampling by itself once duration elapses
+  openr::startCpuProfile(50ms, 1000);
+  busyLoop(200ms);
+  EXPECT_FALSE(openr::isCpuProfileRunning());
+  openr::stopCpuProfile();
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/IPAddress.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+
+namespace {
+
+// adjacencies of every adjacency database in the publication
+const size_t kAdjsPerPublicationValue = 16;
+
+// nexthops of every route in the route delta
+const size_t kNexthopsPerRoute = 4;
+
+} // namespace
+
+namespace openr {
+
+using apache::thrift::BinarySerializer;
+using apache::thrift::CompactSerializer;
+
+thrift::AdjacencyDatabase
+makeAdjDb(size_t numAdjs) {
+  std::vector<thrift::Adjacency> adjs;
+  for (size_t i = 0; i < numAdjs; ++i) {
+    adjs.emplace_back(createAdjacency(
+        folly::sformat("fsw{:03}.p{:03}.f01.ash6", i, i % 8),
+        folly::sformat("po{}", 1000 + i),
+        folly::sformat("po{}", 2000 + i),
+        folly::sformat("fe80::{:x}", i + 1),
+        folly::sformat("10.0.{}.{}", i / 256, i % 256),
+        10 /* metric */,
+        100000 + i /* adjLabel */));
+  }
+  return createAdjDb("rsw001.p001.f01.ash6", adjs, 1 /* nodeLabel */);
+}
+
+thrift::PrefixDatabase
+makePrefixDb(size_t numPrefixes) {
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  for (size_t i = 0; i < numPrefixes; ++i) {
+    prefixEntries.emplace_back(createPrefixEntry(toIpPrefix(
+        folly::sformat("fc00:{:x}:{:x}::/64", i / 0x10000, i % 0x10000))));
+  }
+  return createPrefixDb("rsw001.p001.f01.ash6", prefixEntries);
+}
+
+// KvStore publication of adjacency databases, as flooded on bring-up
+thrift::Publication
+makePublication(size_t numKeys) {
+  const auto adjDbStr = fbzmq::util::writeThriftObjStr(
+      makeAdjDb(kAdjsPerPublicationValue), CompactSerializer());
+  std::unordered_map<std::string, thrift::Value> keyVals;
+  for (size_t i = 0; i < numKeys; ++i) {
+    keyVals.emplace(
+        folly::sformat("adj:node-{}", i),
+        createThriftValue(
+            1, folly::sformat("node-{}", i), adjDbStr, 3600000, 1, i));
+  }
+  return createThriftPublication(keyVals, {});
+}
+
+thrift::RouteDatabaseDelta
+makeRouteDelta(size_t numRoutes) {
+  std::vector<thrift::NextHopThrift> nextHops;
+  for (size_t i = 0; i < kNexthopsPerRoute; ++i) {
+    nextHops.emplace_back(createNextHop(
+        toBinaryAddress(folly::IPAddress(folly::sformat("fe80::{:x}", i + 1))),
+        folly::sformat("po{}", 1000 + i),
+        10 /* metric */));
+  }
+  thrift::RouteDatabaseDelta delta;
+  delta.thisNodeName = "rsw001.p001.f01.ash6";
+  for (size_t i = 0; i < numRoutes; ++i) {
+    delta.unicastRoutesToUpdate.emplace_back(createUnicastRoute(
+        toIpPrefix(
+            folly::sformat("fc00:{:x}:{:x}::/64", i / 0x10000, i % 0x10000)),
+        nextHops));
+  }
+  return delta;
+}
+
+/**
+ * Register benchmarks of serializing the object, deserializing it from a
+ * string and deserializing it from an IOBuf wrapping the received bytes
+ * without copying them (as done for messages received over thrift)
+ */
+template <typename Serializer, typename T>
+void
+addProtocolBenchmarks(const std::string& name, std::shared_ptr<const T> obj) {
+  const auto data = std::make_shared<const std::string>(
+      Serializer::template serialize<std::string>(*obj));
+
+  folly::addBenchmark(
+      __FILE__,
+      name + "_serialize",
+      [obj, data](folly::UserCounters& counters, unsigned iters) {
+        size_t bytes{0};
+        for (unsigned i = 0; i < iters; ++i) {
+          bytes += Serializer::template serialize<std::string>(*obj).size();
+        }
+        folly::doNotOptimizeAway(bytes);
+        counters["bytes"] = data->size();
+        return iters;
+      });
+
+  folly::addBenchmark(
+      __FILE__,
+      name + "_deserialize",
+      [data](folly::UserCounters& counters, unsigned iters) {
+        for (unsigned i = 0; i < iters; ++i) {
+          auto decoded = Serializer::template deserialize<T>(*data);
+          folly::doNotOptimizeAway(decoded);
+        }
+        counters["bytes"] = data->size();
+        return iters;
+      });
+
+  folly::addBenchmark(
+      __FILE__,
+      name + "_deserialize_iobuf",
+      [data](folly::UserCounters& counters, unsigned iters) {
+        const auto buf = folly::IOBuf::wrapBuffer(data->data(), data->size());
+        for (unsigned i = 0; i < iters; ++i) {
+          auto decoded = Serializer::template deserialize<T>(buf.get());
+          folly::doNotOptimizeAway(decoded);
+        }
+        counters["bytes"] = data->size();
+        return iters;
+      });
+}
+
+/**
+ * Register benchmarks of the object created by `create` with each of the
+ * sizes, in Compact (used on the wire by Open/R) and Binary protocols
+ */
+template <typename T>
+void
+addSerializationBenchmarks(
+    const std::string& name,
+    T (*create)(size_t),
+    const std::vector<size_t>& sizes) {
+  for (auto size : sizes) {
+    const auto obj = std::make_shared<const T>(create(size));
+    addProtocolBenchmarks<CompactSerializer>(
+        folly::sformat("BM_{}_Compact_{}", name, size), obj);
+    addProtocolBenchmarks<BinarySerializer>(
+        folly::sformat("BM_{}_Binary_{}", name, size), obj);
+  }
+}
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  // The parameter is number of adjacencies, prefixes, keys and routes
+  // respectively
+  openr::addSerializationBenchmarks("AdjDb", &openr::makeAdjDb, {16, 256});
+  openr::addSerializationBenchmarks(
+      "PrefixDb", &openr::makePrefixDb, {10, 1000});
+  openr::addSerializationBenchmarks(
+      "Publication", &openr::makePublication, {100, 1000});
+  openr::addSerializationBenchmarks(
+      "RouteDelta", &openr::makeRouteDelta, {100, 10000});
+  folly::runBenchmarks();
+  return 0;
+}
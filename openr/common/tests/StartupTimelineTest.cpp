@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fb303/ServiceData.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/StartupTimeline.h>
+
+using namespace std::chrono_literals;
+
+namespace fb303 = facebook::fb303;
+
+TEST(StartupTimelineTest, RecordTest) {
+  const auto start = openr::StartupTimeline::Clock::now();
+  openr::StartupTimeline timeline(start);
+
+  EXPECT_TRUE(timeline.record("config_loaded", start + 10ms));
+  EXPECT_TRUE(timeline.record("first_adjacency", start + 2s));
+  EXPECT_EQ(10ms, timeline.getEventTime("config_loaded"));
+  EXPECT_EQ(2000, fb303::fbData->getCounter("startup.first_adjacency_ms"));
+  EXPECT_FALSE(timeline.getEventTime("first_rib").has_value());
+
+  // Only first occurrence is recorded
+  EXPECT_FALSE(timeline.record("first_adjacency", start + 5s));
+  EXPECT_EQ(2s, timeline.getEventTime("first_adjacency"));
+
+  EXPECT_EQ(
+      "config_loaded=10ms, first_adjacency=2000ms", timeline.toString());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
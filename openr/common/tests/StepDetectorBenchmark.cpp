@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/stats/BucketedTimeSeries.h>
+
+#include <openr/common/StepDetector.h>
+
+namespace {
+
+// Parameters of StepDetector of Spark neighbors
+const std::chrono::milliseconds kSamplePeriod{1000};
+const size_t kFastWndSize{10};
+const size_t kSlowWndSize{60};
+
+using TimeSeries = folly::BucketedTimeSeries<
+    int64_t,
+    folly::LegacyStatsClock<std::chrono::milliseconds>>;
+
+// RTT sample of a neighbor in microseconds, with some noise
+int64_t
+getRtt(uint32_t i) {
+  return 1000 + (i * 7919) % 50;
+}
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Baseline: fast and slow sliding windows as folly::BucketedTimeSeries, which
+ * StepDetector used to keep, updated and averaged on every sample
+ */
+static void
+BM_BucketedTimeSeriesWindows(uint32_t iters, size_t numNeighbors) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::vector<std::pair<TimeSeries, TimeSeries>> windows;
+  for (size_t i = 0; i < numNeighbors; ++i) {
+    windows.emplace_back(
+        TimeSeries(kFastWndSize, kSamplePeriod * kFastWndSize),
+        TimeSeries(kSlowWndSize, kSamplePeriod * kSlowWndSize));
+  }
+  suspender.dismiss();
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    // every neighbor gets a sample every 100ms
+    const std::chrono::milliseconds now(i / numNeighbors * 100);
+    auto& [fast, slow] = windows[i % numNeighbors];
+    fast.addValue(now, getRtt(i));
+    slow.addValue(now, getRtt(i));
+    folly::doNotOptimizeAway(fast.avg() - slow.avg());
+  }
+}
+
+/**
+ * StepDetector per neighbor, as kept by Spark
+ */
+static void
+BM_StepDetectorAddValue(uint32_t iters, size_t numNeighbors) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::vector<std::unique_ptr<StepDetector<int64_t, std::chrono::milliseconds>>>
+      detectors;
+  for (size_t i = 0; i < numNeighbors; ++i) {
+    detectors.emplace_back(
+        std::make_unique<StepDetector<int64_t, std::chrono::milliseconds>>(
+            kSamplePeriod,
+            kFastWndSize,
+            kSlowWndSize,
+            2 /* lower threshold */,
+            5 /* upper threshold */,
+            500 /* absolute threshold */,
+            [](const int64_t& rtt) { folly::doNotOptimizeAway(rtt); }));
+  }
+  suspender.dismiss();
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    const std::chrono::milliseconds now(i / numNeighbors * 100);
+    detectors[i % numNeighbors]->addValue(now, getRtt(i));
+  }
+}
+
+// The parameter is number of neighbors
+BENCHMARK_PARAM(BM_BucketedTimeSeriesWindows, 1);
+BENCHMARK_RELATIVE_PARAM(BM_StepDetectorAddValue, 1);
+BENCHMARK_PARAM(BM_BucketedTimeSeriesWindows, 1000);
+BENCHMARK_RELATIVE_PARAM(BM_StepDetectorAddValue, 1000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -161,6 +161,37 @@ TEST(StepDetectorTest, SlowBoiling) {
   }
 }
 
+// sliding windows only hold values of their last sample periods
+TEST(StepDetectorTest, SlidingWindow) {
+  std::vector<double> steps;
+  auto stepCb = [&](const double& avg) { steps.emplace_back(avg); };
+
+  openr::StepDetector<double, std::chrono::seconds> stepDetector(
+      std::chrono::seconds(1) /* sampling period */,
+      2 /* small window size */,
+      4 /* large window size */,
+      2 /* lower threshold */,
+      10 /* upper threshold */,
+      5 /* absolute threshold */,
+      stepCb /* callback function */);
+
+  // values within large window are accepted, even out of order
+  EXPECT_TRUE(stepDetector.addValue(std::chrono::seconds(10), 100));
+  EXPECT_TRUE(stepDetector.addValue(std::chrono::seconds(7), 100));
+  EXPECT_FALSE(stepDetector.addValue(std::chrono::seconds(6), 100));
+
+  for (int i = 11; i < 20; ++i) {
+    EXPECT_TRUE(stepDetector.addValue(std::chrono::seconds(i), 100));
+  }
+  EXPECT_TRUE(steps.empty());
+
+  // windows expire entirely over a gap in samples, new mean is right away
+  // detected as a gradual change
+  EXPECT_TRUE(stepDetector.addValue(std::chrono::seconds(100), 200));
+  ASSERT_EQ(1, steps.size());
+  EXPECT_EQ(200, steps.front());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
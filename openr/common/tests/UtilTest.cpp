@@ -125,6 +125,37 @@ TEST(UtilTest, NetworkUtilTest) {
   EXPECT_EQ("", toString(empty));
 }
 
+TEST(UtilTest, IpPrefixKeyTest) {
+  const std::vector<thrift::IpPrefix> prefixes{
+      toIpPrefix("10.0.0.0/8"),
+      toIpPrefix("10.0.0.0/24"),
+      toIpPrefix("10.1.0.0/16"),
+      toIpPrefix("::ffff:10.0.0.0/104"),
+      toIpPrefix("fc00::/7"),
+      toIpPrefix("fc00::1/128"),
+      thrift::IpPrefix(),
+  };
+
+  for (auto const& prefix : prefixes) {
+    const IpPrefixKey key(prefix);
+    EXPECT_EQ(prefix, key.toIpPrefix());
+    EXPECT_EQ(key, IpPrefixKey(key.toIpPrefix()));
+    EXPECT_EQ(std::hash<IpPrefixKey>()(key), std::hash<IpPrefixKey>()(key));
+    // ordered the same way as thrift prefixes
+    for (auto const& other : prefixes) {
+      EXPECT_EQ(prefix < other, key < IpPrefixKey(other));
+      EXPECT_EQ(prefix == other, key == IpPrefixKey(other));
+    }
+  }
+
+  // v4 prefix and its v4-mapped v6 counterpart are different keys
+  std::unordered_set<IpPrefixKey> keys;
+  for (auto const& prefix : prefixes) {
+    keys.emplace(prefix);
+  }
+  EXPECT_EQ(prefixes.size(), keys.size());
+}
+
 TEST(UtilTest, PrefixKeyTest) {
   std::vector<PrefixKeyEntry> strToItems;
 
@@ -271,6 +302,36 @@ TEST(UtilTest, PrefixKeyTest) {
   }
 }
 
+TEST(UtilTest, PerAdjacencyKeyTest) {
+  {
+    auto key = PerAdjacencyKey("node-1", "node-2", "po1001").getAdjacencyKey();
+    EXPECT_EQ("adj:node-1:[node-2:po1001]", key);
+    EXPECT_EQ("node-1", getNodeNameFromKey(key));
+
+    auto adjKey = PerAdjacencyKey::fromStr(key);
+    ASSERT_TRUE(adjKey.hasValue());
+    EXPECT_EQ("node-1", adjKey->getNodeName());
+    EXPECT_EQ("node-2", adjKey->getOtherNodeName());
+    EXPECT_EQ("po1001", adjKey->getIfName());
+    EXPECT_EQ(key, adjKey->getAdjacencyKey());
+  }
+
+  // interface name may contain ':'
+  {
+    auto adjKey = PerAdjacencyKey::fromStr("adj:node.1:[node_2:eth0:1]");
+    ASSERT_TRUE(adjKey.hasValue());
+    EXPECT_EQ("node.1", adjKey->getNodeName());
+    EXPECT_EQ("node_2", adjKey->getOtherNodeName());
+    EXPECT_EQ("eth0:1", adjKey->getIfName());
+  }
+
+  // adjacency database key of the node is not per adjacency key
+  EXPECT_FALSE(PerAdjacencyKey::fromStr("adj:node-1").hasValue());
+  EXPECT_FALSE(PerAdjacencyKey::fromStr("adj:node-1:[node-2]").hasValue());
+  EXPECT_FALSE(
+      PerAdjacencyKey::fromStr("prefix:node-1:[node-2:if]").hasValue());
+}
+
 TEST(UtilTest, GetNodeNameFromKeyTest) {
   const std::unordered_map<std::string, std::string> expectedIo = {
       {"prefix:node1", "node1"},
@@ -512,6 +573,21 @@ TEST(UtilTest, addPerfEventTest) {
     EXPECT_EQ(perfEvents.events[1].nodeName, "node2");
     EXPECT_EQ(perfEvents.events[1].eventDescr, "LINK_DOWN");
   }
+
+  // Trace ID is assigned by the first event and kept by later ones
+  {
+    thrift::PerfEvents perfEvents;
+    addPerfEvent(perfEvents, "node1", "LINK_UP");
+    ASSERT_TRUE(perfEvents.traceId_ref().has_value());
+    const auto traceId = *perfEvents.traceId_ref();
+    EXPECT_TRUE(folly::StringPiece(traceId).startsWith("node1:"));
+    addPerfEvent(perfEvents, "node2", "DECISION_RECEIVED");
+    EXPECT_EQ(traceId, *perfEvents.traceId_ref());
+
+    thrift::PerfEvents otherPerfEvents;
+    addPerfEvent(otherPerfEvents, "node1", "LINK_UP");
+    EXPECT_NE(traceId, *otherPerfEvents.traceId_ref());
+  }
 }
 
 TEST(UtilTest, sprintPerfEventsTest) {
@@ -662,6 +738,36 @@ TEST(UtilTest, getBestNextHopsMpls) {
   EXPECT_EQ(bestNextHops, std::vector<thrift::NextHopThrift>({path1_3_1_php}));
 }
 
+TEST(UtilTest, patchRoutesWithBestNexthops) {
+  auto path1_2_2_updated = path1_2_2;
+  path1_2_2_updated.useNonShortestRoute = true;
+  std::vector<thrift::UnicastRoute> unicastRoutes{
+      createUnicastRoute(prefix1, {path1_2_1, path1_2_2, path1_3_1}),
+      createUnicastRoute(prefix2, {path1_2_3, path1_2_2_updated, path1_2_1}),
+      createUnicastRoute(prefix3, {path1_2_2})};
+  unicastRoutes.at(0).doNotInstall = true;
+  unicastRoutes.at(0).prefixType_ref() = thrift::PrefixType::BGP;
+
+  // Patched in place as created with best nexthops
+  auto expectedUnicastRoutes =
+      createUnicastRoutesWithBestNexthops(unicastRoutes);
+  patchUnicastRoutesWithBestNexthops(unicastRoutes);
+  EXPECT_EQ(expectedUnicastRoutes, unicastRoutes);
+  EXPECT_EQ(
+      createUnicastRoute(prefix1, {path1_2_1, path1_3_1}),
+      unicastRoutes.at(0));
+
+  std::vector<thrift::MplsRoute> mplsRoutes{
+      createMplsRoute(
+          1, {path1_2_1_swap, path1_2_2_php, path1_3_1_swap, path1_3_2_php}),
+      createMplsRoute(2, {path1_2_1_swap, path1_3_1_php}),
+      createMplsRoute(3, {path1_2_2_pop})};
+  auto expectedMplsRoutes = createMplsRoutesWithBestNextHops(mplsRoutes);
+  patchMplsRoutesWithBestNextHops(mplsRoutes);
+  EXPECT_EQ(expectedMplsRoutes, mplsRoutes);
+  EXPECT_EQ(createMplsRoute(2, {path1_3_1_php}), mplsRoutes.at(1));
+}
+
 TEST(UtilTest, findDeltaRoutes) {
   thrift::RouteDatabase oldRouteDb;
   oldRouteDb.thisNodeName = "node-1";
@@ -966,6 +1072,179 @@ TEST(MetricVectorUtilsTest, compareMetricVectors) {
   EXPECT_EQ(CompareResult::TIE_LOOSER, compareMetricVectors(r, l));
 }
 
+TEST(MetricVectorUtilsTest, compareCompiledMetricVectors) {
+  // compiled vectors must order the same way as the original ones
+  auto expectSameResult = [](thrift::MetricVector const& l,
+                             thrift::MetricVector const& r) {
+    const auto compiledL = compileMetricVector(l);
+    const auto compiledR = compileMetricVector(r);
+    EXPECT_EQ(
+        compareMetricVectors(l, r), compareMetricVectors(compiledL, compiledR));
+    EXPECT_EQ(
+        compareMetricVectors(r, l), compareMetricVectors(compiledR, compiledL));
+  };
+
+  thrift::MetricVector l, r;
+  expectSameResult(l, r);
+
+  // entities are given in increasing order of priority to exercise sorting
+  int64_t numMetrics = 5;
+  l.metrics.resize(numMetrics);
+  for (int64_t i = 0; i < numMetrics; ++i) {
+    l.metrics[i].type = i;
+    l.metrics[i].priority = 2 * i;
+    l.metrics[i].op = thrift::CompareType::WIN_IF_PRESENT;
+    l.metrics[i].isBestPathTieBreaker = false;
+    l.metrics[i].metric = {i, -i};
+  }
+  r = l;
+  expectSameResult(l, r);
+
+  const auto compiled = compileMetricVector(l);
+  ASSERT_EQ(numMetrics, compiled.entities.size());
+  EXPECT_EQ(2 * numMetrics, compiled.metrics.size());
+  EXPECT_EQ(2 * (numMetrics - 1), compiled.entities.front().priority);
+  EXPECT_TRUE(hasMetricEntityOfType(compiled, 0));
+  EXPECT_FALSE(hasMetricEntityOfType(compiled, numMetrics));
+
+  r.metrics[numMetrics - 2].metric.back()--;
+  expectSameResult(l, r);
+  r.metrics[numMetrics - 2].metric.pop_back();
+  expectSameResult(l, r);
+
+  r.metrics[numMetrics - 2].isBestPathTieBreaker = true;
+  expectSameResult(l, r);
+  l.metrics[numMetrics - 2].isBestPathTieBreaker = true;
+  expectSameResult(l, r);
+
+  r.metrics.resize(numMetrics - 1);
+  expectSameResult(l, r);
+
+  l.metrics[0].type--;
+  expectSameResult(l, r);
+  l.metrics[0].type++;
+
+  l.metrics[numMetrics - 1].op = thrift::CompareType::WIN_IF_NOT_PRESENT;
+  expectSameResult(l, r);
+  l.metrics[numMetrics - 1].op = thrift::CompareType::IGNORE_IF_NOT_PRESENT;
+  expectSameResult(l, r);
+
+  // adding entity to compiled vector is same as compiling augmented vector
+  const auto entity = createMetricEntity(
+      numMetrics,
+      3,
+      thrift::CompareType::WIN_IF_NOT_PRESENT,
+      false /* isBestPathTieBreaker */,
+      {-10});
+  auto compiledL = compileMetricVector(l);
+  auto compiledR = compileMetricVector(r);
+  addMetricEntity(compiledL, entity);
+  EXPECT_TRUE(hasMetricEntityOfType(compiledL, numMetrics));
+  l.metrics.emplace_back(entity);
+  EXPECT_EQ(
+      compareMetricVectors(l, r), compareMetricVectors(compiledL, compiledR));
+  EXPECT_EQ(
+      compareMetricVectors(r, l), compareMetricVectors(compiledR, compiledL));
+}
+
+TEST(UtilTest, CompactUnicastRoutes) {
+  const auto nh1 = createNextHop(toBinaryAddress("fe80::1"), "eth1");
+  const auto nh2 = createNextHop(toBinaryAddress("fe80::2"), "eth2");
+  const std::vector<thrift::UnicastRoute> routes{
+      createUnicastRoute(toIpPrefix("fc00::1/128"), {nh1, nh2}),
+      createUnicastRoute(toIpPrefix("fc00::2/128"), {nh2}),
+      createUnicastRoute(toIpPrefix("fc00::3/128"), {}),
+  };
+
+  // Shared nexthops are stored once
+  const auto compactRoutes = createCompactUnicastRoutes(routes);
+  EXPECT_EQ(
+      std::vector<thrift::NextHopThrift>({nh1, nh2}), compactRoutes.nextHops);
+  ASSERT_EQ(3, compactRoutes.routes.size());
+  EXPECT_EQ(
+      std::vector<int32_t>({0, 1}), compactRoutes.routes.at(0).nextHopIndices);
+  EXPECT_EQ(
+      std::vector<int32_t>({1}), compactRoutes.routes.at(1).nextHopIndices);
+  EXPECT_TRUE(compactRoutes.routes.at(2).nextHopIndices.empty());
+
+  EXPECT_EQ(routes, createUnicastRoutesFromCompact(compactRoutes));
+
+  auto invalidRoutes = compactRoutes;
+  invalidRoutes.routes.at(1).nextHopIndices.emplace_back(2);
+  EXPECT_THROW(
+      createUnicastRoutesFromCompact(invalidRoutes), std::out_of_range);
+}
+
+TEST(UtilTest, KeyPrefixMatch) {
+  // no prefixes match all keys
+  EXPECT_TRUE(KeyPrefix({}).keyMatch("adj:node1"));
+
+  // literal prefixes, incl. ones covered by a shorter prefix
+  KeyPrefix literal({"prefix:", "adj:node1", "adj:", "allocprefix:"});
+  EXPECT_TRUE(literal.keyMatch("adj:node2"));
+  EXPECT_TRUE(literal.keyMatch("prefix:node1"));
+  EXPECT_TRUE(literal.keyMatch("allocprefix:"));
+  EXPECT_FALSE(literal.keyMatch("adj"));
+  EXPECT_FALSE(literal.keyMatch("ad"));
+  EXPECT_FALSE(literal.keyMatch("nodeLabel:1"));
+  EXPECT_FALSE(literal.keyMatch("aaa"));
+  EXPECT_FALSE(literal.keyMatch("zzz"));
+  EXPECT_FALSE(literal.keyMatch(""));
+
+  // any regex prefix falls back to RE2 for all of them
+  KeyPrefix regex({"adj:", "prefix:node[0-9]"});
+  EXPECT_TRUE(regex.keyMatch("adj:node2"));
+  EXPECT_TRUE(regex.keyMatch("prefix:node1"));
+  EXPECT_FALSE(regex.keyMatch("prefix:nodeA"));
+  EXPECT_FALSE(regex.keyMatch("xadj:node2"));
+
+  EXPECT_EQ("adj:", KeyPrefix::getLiteralPrefix("adj:"));
+  EXPECT_EQ(std::nullopt, KeyPrefix::getLiteralPrefix("adj:.*"));
+}
+
+TEST(UtilTest, NormalizeNextHopWeights) {
+  // reduced by gcd
+  EXPECT_EQ(
+      (std::vector<int32_t>{1, 3, 2}),
+      normalizeNextHopWeights({100, 300, 200}));
+
+  // equal weights are ECMP, non-positive weights count as 1
+  EXPECT_EQ((std::vector<int32_t>{0, 0}), normalizeNextHopWeights({40, 40}));
+  EXPECT_EQ((std::vector<int32_t>{0, 0}), normalizeNextHopWeights({0, 1}));
+
+  // scaled down to bound sum of weights, keeping min weight of 1
+  EXPECT_EQ(
+      (std::vector<int32_t>{1, 10}),
+      normalizeNextHopWeights({1000, 10001}, 11));
+  EXPECT_EQ(
+      (std::vector<int32_t>{1, 100}),
+      normalizeNextHopWeights({1, 100000}, 101));
+  auto weights = normalizeNextHopWeights({10000, 25000, 40000, 100000});
+  int64_t sum = 0;
+  for (auto const weight : weights) {
+    sum += weight;
+  }
+  EXPECT_LE(sum, Constants::kMaxNextHopWeightSum);
+  EXPECT_EQ((std::vector<int32_t>{2, 5, 8, 20}), weights);
+}
+
+TEST(UtilTest, GenerateHash) {
+  const std::string value{"value"};
+  const auto hash = generateHash(1, "node1", value);
+  EXPECT_EQ(hash, generateHash(1, "node1", std::string("value")));
+
+  // Every field is covered
+  EXPECT_NE(hash, generateHash(2, "node1", value));
+  EXPECT_NE(hash, generateHash(1, "node2", value));
+  EXPECT_NE(hash, generateHash(1, "node1", std::string("value2")));
+  EXPECT_NE(hash, generateHash(1, "node1", std::nullopt));
+
+  // Boundary between originatorId and value is not ambiguous
+  EXPECT_NE(
+      generateHash(1, "node1", std::string("value")),
+      generateHash(1, "node1v", std::string("alue")));
+}
+
 TEST(UtilTest, FunctionExecutionTime) {
   LOG_FN_EXECUTION_TIME;
 }
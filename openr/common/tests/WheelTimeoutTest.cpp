@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include <openr/common/WheelTimeout.h>
+
+using namespace openr;
+
+namespace {
+
+class WheelTimeoutFixture : public ::testing::Test {
+ protected:
+  folly::EventBase evb;
+  folly::HHWheelTimer::UniquePtr wheel{
+      folly::HHWheelTimer::newTimer(&evb, std::chrono::milliseconds(1))};
+};
+
+} // namespace
+
+TEST_F(WheelTimeoutFixture, ScheduleTest) {
+  int fired{0};
+  auto timeout = WheelTimeout::make(*wheel, [&]() noexcept { ++fired; });
+  EXPECT_FALSE(timeout->isScheduled());
+
+  const auto start = std::chrono::steady_clock::now();
+  timeout->scheduleTimeout(std::chrono::milliseconds(20));
+  EXPECT_TRUE(timeout->isScheduled());
+
+  evb.loop();
+  EXPECT_EQ(1, fired);
+  EXPECT_FALSE(timeout->isScheduled());
+  EXPECT_LE(
+      std::chrono::milliseconds(20), std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(WheelTimeoutFixture, ExtendTest) {
+  int fired{0};
+  auto timeout = WheelTimeout::make(*wheel, [&]() noexcept { ++fired; });
+
+  // Extending unscheduled timeout schedules it
+  const auto start = std::chrono::steady_clock::now();
+  timeout->extendTimeout(std::chrono::milliseconds(20));
+  EXPECT_TRUE(timeout->isScheduled());
+
+  // Extend before expiry. Shorter extension doesn't advance the deadline
+  evb.runAfterDelay(
+      [&]() {
+        EXPECT_EQ(0, fired);
+        timeout->extendTimeout(std::chrono::milliseconds(50));
+        timeout->extendTimeout(std::chrono::milliseconds(1));
+      },
+      10);
+
+  evb.loop();
+  EXPECT_EQ(1, fired);
+  EXPECT_FALSE(timeout->isScheduled());
+  EXPECT_LE(
+      std::chrono::milliseconds(60), std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(WheelTimeoutFixture, CancelTest) {
+  int fired{0};
+  auto timeout = WheelTimeout::make(*wheel, [&]() noexcept { ++fired; });
+
+  timeout->scheduleTimeout(std::chrono::milliseconds(20));
+  evb.runAfterDelay([&]() { timeout->cancelTimeout(); }, 5);
+  evb.runAfterDelay([&]() { EXPECT_EQ(0, fired); }, 40);
+
+  evb.loop();
+  EXPECT_EQ(0, fired);
+  EXPECT_FALSE(timeout->isScheduled());
+}
+
+TEST_F(WheelTimeoutFixture, RescheduleFromCallbackTest) {
+  int fired{0};
+  std::unique_ptr<WheelTimeout> timeout;
+  timeout = WheelTimeout::make(*wheel, [&]() noexcept {
+    if (++fired < 3) {
+      timeout->scheduleTimeout(std::chrono::milliseconds(5));
+    }
+  });
+  timeout->scheduleTimeout(std::chrono::milliseconds(5));
+
+  evb.loop();
+  EXPECT_EQ(3, fired);
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -7,9 +7,13 @@
 
 #include "PersistentStore.h"
 
+#include <fcntl.h>
 #include <chrono>
 
 #include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/hash/Checksum.h>
 #include <folly/io/IOBuf.h>
 
 #include <openr/common/Util.h>
@@ -20,6 +24,9 @@ namespace {
 
 static const long kDbFlushRatio = 10000;
 
+// Write-ahead log record header: payload length followed by its CRC32C
+static const size_t kWalRecordHeaderSize = 2 * sizeof(uint32_t);
+
 } // anonymous namespace
 
 namespace openr {
@@ -30,8 +37,14 @@ PersistentStore::PersistentStore(
     fbzmq::Context& /* context */, // TODO remove context argument
     bool dryrun,
     bool periodicallySaveToDisk)
-    : storageFilePath_(storageFilePath), dryrun_(dryrun) {
+    : storageFilePath_(storageFilePath),
+      walFilePath_(storageFilePath + ".wal"),
+      dryrun_(dryrun) {
   if (periodicallySaveToDisk) {
+    // Disk IO happens on a single thread, hence in order of submission
+    ioExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        1, std::make_shared<folly::NamedThreadFactory>("PersistentStoreIo"));
+
     // Create timer and backoff mechanism only if backoff is requested
     saveDbTimerBackoff_ =
         std::make_unique<ExponentialBackoff<std::chrono::milliseconds>>(
@@ -55,10 +68,16 @@ PersistentStore::PersistentStore(
   if (not loadDatabaseFromDisk()) {
     LOG(ERROR) << "Failed to load config-database from file: "
                << storageFilePath_;
+  } else if (not recoverFromWal()) {
+    LOG(ERROR) << "Failed to recover updates from file: " << walFilePath_;
   }
 }
 
 PersistentStore::~PersistentStore() {
+  // Drain pending disk IO before compacting the database one last time
+  if (ioExecutor_) {
+    ioExecutor_->join();
+  }
   saveDatabaseToDisk();
 }
 
@@ -76,6 +95,7 @@ PersistentStore::store(std::string key, std::string value) {
                  << " to config-store";
     // Override previous value if any
     database_.keyVals[key] = value;
+    lazyValueOffsets_.erase(key);
     auto pObject = toPersistentObject(ActionType::ADD, key, value);
     pObjects_.emplace_back(std::move(pObject));
     maybeSaveObjectToDisk();
@@ -91,7 +111,9 @@ PersistentStore::erase(std::string key) {
   runInEventBaseThread(
       [this, p = std::move(p), key = std::move(key)]() mutable noexcept {
         SYSLOG(INFO) << "Erase key: " << key << " from config-store";
-        if (database_.keyVals.erase(key) > 0) {
+        const auto numErased =
+            database_.keyVals.erase(key) + lazyValueOffsets_.erase(key);
+        if (numErased > 0) {
           auto pObject = toPersistentObject(ActionType::DEL, key, "");
           pObjects_.emplace_back(std::move(pObject));
           maybeSaveObjectToDisk();
@@ -110,7 +132,7 @@ PersistentStore::load(std::string key) {
   auto sf = p.getSemiFuture();
   runInEventBaseThread(
       [this, p = std::move(p), key = std::move(key)]() mutable {
-        auto it = database_.keyVals.find(key);
+        auto it = findValue(key);
         if (it != database_.keyVals.end()) {
           p.setValue(it->second);
         } else {
@@ -134,61 +156,92 @@ PersistentStore::maybeSaveObjectToDisk() noexcept {
 
 bool
 PersistentStore::savePersistentObjectToDisk() noexcept {
-  if (not dryrun_) {
-    // Write PersistentObject to ioBuf
-    std::vector<PersistentObject> newObjects;
-    newObjects = std::move(pObjects_);
+  if (dryrun_) {
+    VLOG(1) << "Skipping writing to disk in dryrun mode";
+    pObjects_.clear();
+    numOfWritesToDisk_++;
+    return true;
+  }
 
+  // All objects pending since the last flush are committed together
+  std::vector<PersistentObject> newObjects;
+  newObjects = std::move(pObjects_);
+  pObjects_.clear();
+
+  // Disk IO to perform. Returns true on success else marks database for
+  // compaction, which persists all updates regardless of the failed write.
+  folly::Function<bool()> ioFn;
+
+  // Compact the whole database periodically or after failed write
+  numOfNewWritesToDisk_++;
+  if (numOfNewWritesToDisk_ >= kDbFlushRatio or
+      compactionNeeded_.exchange(false)) {
+    numOfNewWritesToDisk_ = 0;
+    // Snapshot includes `newObjects` hence they are not appended to log
+    materializeDatabase();
+    ioFn = [this, database = database_]() noexcept {
+      const auto startTs = std::chrono::steady_clock::now();
+      if (not writeDatabaseToDisk(database)) {
+        compactionNeeded_ = true;
+        return false;
+      }
+      numOfCompactions_++;
+      LOG(INFO) << "Compacted database on disk. Took "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - startTs)
+                       .count()
+                << "ms";
+      return true;
+    };
+  } else {
+    // Encode PersistentObjects as log records into single ioBuf
     auto queue = folly::IOBufQueue(folly::IOBufQueue::cacheChainLength());
-
     for (auto& pObject : newObjects) {
-      auto buf = encodePersistentObject(pObject);
+      auto buf = encodeWalRecord(pObject);
       if (buf.hasError()) {
         LOG(ERROR) << "Failed to encode PersistentObject to ioBuf. Error: "
-                   << folly::exceptionStr(buf.error());
+                   << buf.error();
+        compactionNeeded_ = true;
         return false;
       }
-      queue.append(std::move(**buf));
-    }
-
-    // Append IoBuf to disk
-    auto ioBuf = queue.move();
-    auto success = writeIoBufToDisk(ioBuf, WriteType::APPEND);
-    if (success.hasError()) {
-      LOG(ERROR) << "Failed to write PersistentObject to file '"
-                 << storageFilePath_
-                 << "'. Error: " << folly::exceptionStr(success.error());
-      return false;
+      queue.append(std::move(*buf));
     }
-
-    numOfNewWritesToDisk_++;
-
-    // Write the whole database to disk periodically
-    if (numOfNewWritesToDisk_ >= kDbFlushRatio) {
-      numOfNewWritesToDisk_ = 0;
-      const auto startTs = std::chrono::steady_clock::now();
-      if (not saveDatabaseToDisk()) {
+    ioFn = [this, ioBuf = queue.move()]() noexcept {
+      auto success = appendToWal(ioBuf);
+      if (success.hasError()) {
+        LOG(ERROR) << "Failed to write PersistentObject to file '"
+                   << walFilePath_ << "'. Error: " << success.error();
+        compactionNeeded_ = true;
         return false;
       }
-      LOG(INFO) << "Updated database on disk. Took "
-                << std::chrono::duration_cast<std::chrono::milliseconds>(
-                       std::chrono::steady_clock::now() - startTs)
-                       .count()
-                << "ms";
+      return true;
+    };
+  }
+
+  if (not ioExecutor_) {
+    // Block the response till file is saved
+    if (not ioFn()) {
+      return false;
     }
   } else {
-    VLOG(1) << "Skipping writing to disk in dryrun mode";
+    ioExecutor_->add([ioFn = std::move(ioFn)]() mutable { ioFn(); });
   }
   numOfWritesToDisk_++;
-
   return true;
 }
 
 bool
 PersistentStore::saveDatabaseToDisk() noexcept {
+  materializeDatabase();
+  return writeDatabaseToDisk(database_);
+}
+
+bool
+PersistentStore::writeDatabaseToDisk(
+    const thrift::StoreDatabase& database) noexcept {
   std::unique_ptr<folly::IOBuf> ioBuf;
   // If database is empty, write 'kTlvFormatMarker' to disk and return
-  if (database_.keyVals.size() == 0) {
+  if (database.keyVals.size() == 0) {
     ioBuf = folly::IOBuf::copyBuffer(
         kTlvFormatMarker.data(), kTlvFormatMarker.size());
   } else {
@@ -196,8 +249,8 @@ PersistentStore::saveDatabaseToDisk() noexcept {
     auto queue = folly::IOBufQueue(folly::IOBufQueue::cacheChainLength());
     queue.append(kTlvFormatMarker.data(), kTlvFormatMarker.size());
 
-    // Encode database_ and append to queue
-    for (auto& keyPair : database_.keyVals) {
+    // Encode database and append to queue
+    for (auto& keyPair : database.keyVals) {
       PersistentObject pObject;
       pObject =
           toPersistentObject(ActionType::ADD, keyPair.first, keyPair.second);
@@ -220,6 +273,96 @@ PersistentStore::saveDatabaseToDisk() noexcept {
                << "'. Error: " << folly::exceptionStr(success.error());
     return false;
   }
+
+  // Database on disk includes all updates of the log now
+  std::error_code ec;
+  fs::remove(walFilePath_, ec);
+  if (ec) {
+    LOG(ERROR) << "Failed to remove log file '" << walFilePath_
+               << "'. Error: " << ec.message();
+    return false;
+  }
+  return true;
+}
+
+folly::Expected<folly::Unit, std::string>
+PersistentStore::appendToWal(
+    const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept {
+  const int fd = folly::openNoInt(
+      walFilePath_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    return folly::makeUnexpected<std::string>(folly::errnoStr(errno));
+  }
+  SCOPE_EXIT {
+    folly::closeNoInt(fd);
+  };
+
+  for (auto& range : *ioBuf) {
+    if (folly::writeFull(fd, range.data(), range.size()) < 0) {
+      return folly::makeUnexpected<std::string>(folly::errnoStr(errno));
+    }
+  }
+  // Single sync for all the records of the batch
+  if (folly::fdatasyncNoInt(fd) != 0) {
+    return folly::makeUnexpected<std::string>(folly::errnoStr(errno));
+  }
+  return folly::Unit();
+}
+
+bool
+PersistentStore::recoverFromWal() noexcept {
+  if (not fs::exists(walFilePath_)) {
+    return true;
+  }
+
+  std::string fileData{""};
+  if (not folly::readFile(walFilePath_.c_str(), fileData)) {
+    LOG(ERROR) << "Failed to read file contents from '" << walFilePath_
+               << "'. Error (" << errno << "): " << folly::errnoStr(errno);
+    return false;
+  }
+
+  auto ioBuf = folly::IOBuf::wrapBuffer(fileData.c_str(), fileData.size());
+  folly::io::Cursor cursor(ioBuf.get());
+  size_t numRecords{0};
+  size_t validLength{0};
+  while (true) {
+    auto optionalObject = decodeWalRecord(cursor);
+    if (optionalObject.hasError()) {
+      // Partially written or corrupted record, updates after it are lost
+      LOG(WARNING) << "Stopped replay of '" << walFilePath_ << "' after "
+                   << numRecords << " records. Error: "
+                   << optionalObject.error();
+      break;
+    }
+    if (not optionalObject->has_value()) {
+      break;
+    }
+    auto pObject = std::move(optionalObject->value());
+    if (pObject.type == ActionType::ADD) {
+      database_.keyVals[pObject.key] =
+          pObject.data.has_value() ? pObject.data.value() : "";
+    } else if (pObject.type == ActionType::DEL) {
+      database_.keyVals.erase(pObject.key);
+    }
+    lazyValueOffsets_.erase(pObject.key);
+    validLength = cursor.getCurrentPosition();
+    ++numRecords;
+  }
+  LOG(INFO) << "Recovered " << numRecords << " updates from '" << walFilePath_
+            << "'";
+
+  // Drop torn tail so that new records are appended after the valid ones.
+  // Log is left in place, avoiding decode of all values for compaction.
+  if (validLength < fileData.size()) {
+    std::error_code ec;
+    fs::resize_file(walFilePath_, validLength, ec);
+    if (ec) {
+      LOG(ERROR) << "Failed to truncate log file '" << walFilePath_
+                 << "'. Error: " << ec.message();
+      return false;
+    }
+  }
   return true;
 }
 
@@ -232,16 +375,19 @@ PersistentStore::loadDatabaseFromDisk() noexcept {
     return true;
   }
 
-  // Read data from file
-  std::string fileData{""};
-  if (not folly::readFile(storageFilePath_.c_str(), fileData)) {
-    LOG(ERROR) << "Failed to read file contents from '" << storageFilePath_
-               << "'. Error (" << errno << "): " << folly::errnoStr(errno);
+  // Map file instead of reading it, values are decoded on first access. File
+  // is only ever replaced (renamed over) hence mapping stays valid.
+  try {
+    mappedDatabase_ =
+        std::make_unique<folly::MemoryMapping>(storageFilePath_.c_str());
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to map file '" << storageFilePath_
+               << "'. Error: " << folly::exceptionStr(e);
     return false;
   }
 
   // Create IoBuf and cursor for loading data from disk
-  auto ioBuf = folly::IOBuf::wrapBuffer(fileData.c_str(), fileData.size());
+  auto ioBuf = folly::IOBuf::wrapBuffer(mappedDatabase_->range());
   folly::io::Cursor cursor(ioBuf.get());
 
   // Read 'kTlvFormatMarker' from ioBuf
@@ -249,6 +395,7 @@ PersistentStore::loadDatabaseFromDisk() noexcept {
       cursor.readFixedString(kTlvFormatMarker.size()) != kTlvFormatMarker) {
     // Load old Format and write TlvFormat
     auto oldSuccess = loadDatabaseOldFormat(ioBuf);
+    mappedDatabase_.reset();
     if (oldSuccess.hasError()) {
       LOG(ERROR) << "Failed to read old-format file contents from '"
                  << storageFilePath_
@@ -288,9 +435,10 @@ PersistentStore::loadDatabaseOldFormat(
 folly::Expected<folly::Unit, std::string>
 PersistentStore::loadDatabaseTlvFormat(
     const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept {
-  // Parse ioBuf to persistentObject and then to `database_`
+  // Parse ioBuf to index of persistentObject values. Same layout as
+  // decodePersistentObject, except that value is skipped.
   folly::io::Cursor cursor(ioBuf.get());
-  thrift::StoreDatabase newDatabase;
+  std::unordered_map<std::string, size_t> newValueOffsets;
   // Read 'kTlvFormatMarker'
   try {
     cursor.readFixedString(kTlvFormatMarker.size());
@@ -299,31 +447,67 @@ PersistentStore::loadDatabaseTlvFormat(
         folly::exceptionStr(e).toStdString());
   }
   // Iteratively read persistentObject from disk
-  while (true) {
-    // Read and decode into persistentObject
-    auto optionalObject = decodePersistentObject(cursor);
-    if (optionalObject.hasError()) {
-      return folly::makeUnexpected(optionalObject.error());
-    }
-
-    // Read finish
-    if (not optionalObject->has_value()) {
+  while (cursor.canAdvance(1)) {
+    try {
+      const auto type = ActionType(cursor.readBE<uint8_t>());
+      auto length = cursor.readBE<uint32_t>();
+      auto key = cursor.readFixedString(length);
+      const size_t offset = cursor.getCurrentPosition();
+      length = cursor.readBE<uint32_t>();
+      cursor.skip(length);
+
+      // Add/Delete persistentObject to/from index
+      if (type == ActionType::ADD) {
+        newValueOffsets[std::move(key)] = offset;
+      } else if (type == ActionType::DEL) {
+        newValueOffsets.erase(key);
+      }
+    } catch (std::out_of_range& e) {
+      // Records appended by previous versions may have a torn tail, keep the
+      // ones read so far.
+      LOG(WARNING) << "Stopped reading '" << storageFilePath_
+                   << "' at torn record. Error: " << folly::exceptionStr(e);
       break;
     }
-    auto pObject = std::move(optionalObject->value());
-
-    // Add/Delete persistentObject to/from 'newDatabase'
-    if (pObject.type == ActionType::ADD) {
-      newDatabase.keyVals[pObject.key] =
-          pObject.data.has_value() ? pObject.data.value() : "";
-    } else if (pObject.type == ActionType::DEL) {
-      newDatabase.keyVals.erase(pObject.key);
-    }
   }
-  database_ = std::move(newDatabase);
+  database_ = thrift::StoreDatabase();
+  lazyValueOffsets_ = std::move(newValueOffsets);
   return folly::Unit();
 }
 
+std::map<std::string, std::string>::iterator
+PersistentStore::findValue(const std::string& key) noexcept {
+  auto it = database_.keyVals.find(key);
+  if (it != database_.keyVals.end()) {
+    return it;
+  }
+  auto offsetIt = lazyValueOffsets_.find(key);
+  if (offsetIt == lazyValueOffsets_.end()) {
+    return it;
+  }
+
+  // Bounds of the value have been validated while building the index
+  folly::IOBuf buf(folly::IOBuf::WRAP_BUFFER, mappedDatabase_->range());
+  folly::io::Cursor cursor(&buf);
+  cursor.skip(offsetIt->second);
+  const auto length = cursor.readBE<uint32_t>();
+  it = database_.keyVals.emplace(key, cursor.readFixedString(length)).first;
+  lazyValueOffsets_.erase(offsetIt);
+  return it;
+}
+
+void
+PersistentStore::materializeDatabase() noexcept {
+  if (not mappedDatabase_) {
+    return;
+  }
+  while (not lazyValueOffsets_.empty()) {
+    const auto key = lazyValueOffsets_.begin()->first;
+    findValue(key);
+  }
+  mappedDatabase_.reset();
+}
+
 // Write over or append IoBuf to disk atomically
 folly::Expected<folly::Unit, std::string>
 PersistentStore::writeIoBufToDisk(
@@ -335,7 +519,11 @@ PersistentStore::writeIoBufToDisk(
 
     if (writeType == WriteType::WRITE) {
       // Write over
-      folly::writeFileAtomic(storageFilePath_.c_str(), fileData, 0666);
+      folly::writeFileAtomic(
+          storageFilePath_.c_str(),
+          fileData,
+          0666,
+          folly::SyncType::WITH_SYNC);
     } else {
       // Append to file
       folly::writeFile(
@@ -413,6 +601,63 @@ PersistentStore::decodePersistentObject(folly::io::Cursor& cursor) noexcept {
   }
 }
 
+folly::Expected<std::unique_ptr<folly::IOBuf>, std::string>
+PersistentStore::encodeWalRecord(const PersistentObject& pObject) noexcept {
+  auto payload = encodePersistentObject(pObject);
+  if (payload.hasError()) {
+    return folly::makeUnexpected(payload.error());
+  }
+  (*payload)->coalesce();
+
+  auto buf = folly::IOBuf::create(kWalRecordHeaderSize);
+  folly::io::Appender appender(buf.get(), 0);
+  try {
+    appender.writeBE<uint32_t>((*payload)->length());
+    appender.writeBE<uint32_t>(
+        folly::crc32c((*payload)->data(), (*payload)->length()));
+  } catch (const exception& e) {
+    return folly::makeUnexpected<std::string>(
+        folly::exceptionStr(e).toStdString());
+  }
+  buf->prependChain(std::move(*payload));
+  return buf;
+}
+
+folly::Expected<std::optional<PersistentObject>, std::string>
+PersistentStore::decodeWalRecord(folly::io::Cursor& cursor) noexcept {
+  // If nothing can be read, return
+  if (not cursor.canAdvance(1)) {
+    return std::nullopt;
+  }
+
+  std::string payload;
+  try {
+    auto length = cursor.readBE<uint32_t>();
+    auto checksum = cursor.readBE<uint32_t>();
+    payload = cursor.readFixedString(length);
+    if (folly::crc32c(
+            reinterpret_cast<const uint8_t*>(payload.data()),
+            payload.size()) != checksum) {
+      return folly::makeUnexpected<std::string>("Checksum mismatch");
+    }
+  } catch (std::out_of_range& e) {
+    return folly::makeUnexpected<std::string>(
+        folly::exceptionStr(e).toStdString());
+  }
+
+  // Record must hold exactly one PersistentObject
+  auto ioBuf = folly::IOBuf::wrapBuffer(payload.data(), payload.size());
+  folly::io::Cursor payloadCursor(ioBuf.get());
+  auto pObject = decodePersistentObject(payloadCursor);
+  if (pObject.hasError()) {
+    return pObject;
+  }
+  if (not pObject->has_value() or not payloadCursor.isAtEnd()) {
+    return folly::makeUnexpected<std::string>("Malformed record");
+  }
+  return pObject;
+}
+
 // Create a PersistentObject and assign value to it.
 PersistentObject
 PersistentStore::toPersistentObject(
@@ -16,9 +16,12 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 #include <string>
+#include <unordered_map>
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/system/MemoryMapping.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Constants.h>
@@ -52,6 +55,18 @@ struct PersistentObject {
  * `storageFilePath`: Describe the path of file in file system where data will
  * be stored/retrieved from (in binary format).
  *
+ * Updates are appended to a write-ahead log (`<storageFilePath>.wal`) of
+ * checksummed records. All updates pending at the time of flush are written
+ * with a single write and fsync (group commit). Every `kDbFlushRatio` flushes
+ * the database is compacted, i.e. written over `storageFilePath` atomically
+ * and the log is truncated. Disk IO happens on a dedicated thread so that
+ * requests are never blocked behind it, except without periodic save where
+ * updates are written inline. On load, log is replayed on top of the database
+ * until the first torn or corrupted record.
+ *
+ * Database file is memory mapped on load and only an index of key to value
+ * offsets is built, values are decoded on first access of the key.
+ *
  * You can interact with this module via ZMQ-Socket APIs described in
  * PersistentStore.thrift file via `REP` socket.
  *
@@ -82,6 +97,21 @@ class PersistentStore : public OpenrEventBase {
   static folly::Expected<std::optional<PersistentObject>, std::string>
   decodePersistentObject(folly::io::Cursor& cursor) noexcept;
 
+  /**
+   * Encode/Decode a PersistentObject as write-ahead log record, prefixed with
+   * length and CRC32C checksum of the object encoding. Decode returns error
+   * on truncated or corrupted record
+   */
+  static folly::Expected<std::unique_ptr<folly::IOBuf>, std::string>
+  encodeWalRecord(const PersistentObject& pObject) noexcept;
+  static folly::Expected<std::optional<PersistentObject>, std::string>
+  decodeWalRecord(folly::io::Cursor& cursor) noexcept;
+
+  uint64_t
+  getNumOfDbCompactions() const {
+    return numOfCompactions_;
+  }
+
   //
   // Public API
   //
@@ -129,14 +159,35 @@ class PersistentStore : public OpenrEventBase {
   bool saveDatabaseToDisk() noexcept;
   bool loadDatabaseFromDisk() noexcept;
 
+  // Write database over storage file and truncate write-ahead log. Thread
+  // safe as it only touches the files.
+  bool writeDatabaseToDisk(const thrift::StoreDatabase& database) noexcept;
+
+  // Append records to write-ahead log and fsync. Thread safe as above.
+  folly::Expected<folly::Unit, std::string> appendToWal(
+      const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept;
+
+  // Replay write-ahead log on top of `database_` till the first invalid
+  // record, and compact the database. Returns true on success else false.
+  bool recoverFromWal() noexcept;
+
   // Load old format file from disk, this is for compatible with the old version
   folly::Expected<folly::Unit, std::string> loadDatabaseOldFormat(
       const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept;
 
-  // Load TlvFormat from disk
+  // Load TlvFormat from disk. Builds `lazyValueOffsets_` index of values in
+  // `ioBuf`, which must be the memory mapped file
   folly::Expected<folly::Unit, std::string> loadDatabaseTlvFormat(
       const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept;
 
+  // Decode value of the key from memory mapped file into `database_` if it
+  // hasn't been accessed yet. Returns iterator to the value, or end.
+  std::map<std::string, std::string>::iterator findValue(
+      const std::string& key) noexcept;
+
+  // Decode all values not yet accessed and unmap the file
+  void materializeDatabase() noexcept;
+
   // Wrapper function to save persistent object to disk immediately or later
   void maybeSaveObjectToDisk() noexcept;
 
@@ -157,10 +208,24 @@ class PersistentStore : public OpenrEventBase {
   // Keeps track of number of writes of PersistentObject to disk
   std::atomic<std::uint64_t> numOfNewWritesToDisk_{0};
 
+  // Keeps track of number of compactions of database on disk
+  std::atomic<std::uint64_t> numOfCompactions_{0};
+
+  // Set by IO thread if write to disk failed. Database is compacted on next
+  // flush, which persists all updates irrespective of the failed write
+  std::atomic<bool> compactionNeeded_{false};
+
   // Location on disk where data will be synced up. A file will be created
   // if doesn't exists.
   const fs::path storageFilePath_;
 
+  // Location of write-ahead log of updates since last compaction
+  const fs::path walFilePath_;
+
+  // Single thread for disk IO, preserving order of appends and compactions.
+  // Only created with periodic save
+  std::unique_ptr<folly::CPUThreadPoolExecutor> ioExecutor_;
+
   // Dryrun to avoid disk writes in UTs
   bool dryrun_{false};
 
@@ -173,6 +238,11 @@ class PersistentStore : public OpenrEventBase {
   // layer (disk) in a file.
   thrift::StoreDatabase database_;
 
+  // Database file mapped on load, and offsets (of length field) of values in
+  // it for the keys not in `database_` yet
+  std::unique_ptr<folly::MemoryMapping> mappedDatabase_;
+  std::unordered_map<std::string, size_t> lazyValueOffsets_;
+
   // Serializer for encoding/decoding of thrift objects
   apache::thrift::CompactSerializer serializer_;
 
@@ -159,6 +159,42 @@ BM_PersistentStoreCreateDestroy(uint32_t iters, size_t numOfStringKeys) {
   }
 }
 
+/**
+ * Benchmark for cold start of a store with large database on disk
+ * 1. Write keys with values of given size to store
+ * 2. Create a store, loading database from disk, and load every 10th key
+ */
+void
+BM_PersistentStoreLoadFromDisk(
+    uint32_t iters, size_t numOfStringKeys, size_t valueSize) {
+  auto suspender = folly::BenchmarkSuspender();
+  fbzmq::Context context;
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  // Create storeWrapper and write large values to it
+  auto stringKeys = constructRandomVector(numOfStringKeys);
+  {
+    PersistentStoreWrapper store(context, tid + 2);
+    store.run();
+    for (auto const& key : stringKeys) {
+      store->store(key, std::string(valueSize, 'a' + key.size() % 26)).get();
+    }
+    // Destroy store, saving database to disk
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Start measuring benchmark time
+    suspender.dismiss();
+    PersistentStoreWrapper store(context, tid + 2);
+    store.run();
+    for (size_t index = 0; index < stringKeys.size(); index += 10) {
+      store->load(stringKeys[index]).get();
+    }
+    // Exclude time of saving database on destruction
+    suspender.rehire();
+  }
+}
+
 // The parameter is the number of keys already written to store
 // before benchmarking the time.
 BENCHMARK_PARAM(BM_PersistentStoreWrite, 10);
@@ -176,6 +212,12 @@ BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 100);
 BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 1000);
 BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 10000);
 
+// The parameters are the number of keys and the size of values
+BENCHMARK_NAMED_PARAM(
+    BM_PersistentStoreLoadFromDisk, 100000_X_1k, 100000, 1024);
+BENCHMARK_NAMED_PARAM(
+    BM_PersistentStoreLoadFromDisk, 10000_X_64k, 10000, 65536);
+
 } // namespace openr
 
 int
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cstdio>
 #include <thread>
 #include <utility>
 
@@ -218,6 +219,175 @@ TEST(PersistentStoreTest, BulkStoreLoad) {
   }
 }
 
+TEST(PersistentStoreTest, EncodeDecodeWalRecord) {
+  PersistentObject pObjectAdd;
+  pObjectAdd.type = ActionType::ADD;
+  pObjectAdd.key = "key1";
+  pObjectAdd.data = "val1";
+  auto bufAdd = PersistentStore::encodeWalRecord(pObjectAdd);
+  ASSERT_FALSE(bufAdd.hasError());
+
+  PersistentObject pObjectDel;
+  pObjectDel.type = ActionType::DEL;
+  pObjectDel.key = "key1";
+  auto bufDel = PersistentStore::encodeWalRecord(pObjectDel);
+  ASSERT_FALSE(bufDel.hasError());
+
+  // Second record is torn
+  (*bufAdd)->coalesce();
+  (*bufDel)->coalesce();
+  std::string data((*bufAdd)->moveToFbString().toStdString());
+  std::string dataDel((*bufDel)->moveToFbString().toStdString());
+  data.append(dataDel.substr(0, dataDel.size() - 1));
+
+  auto buf = folly::IOBuf::wrapBuffer(data.data(), data.size());
+  folly::io::Cursor cursor(buf.get());
+  auto optionalObject = PersistentStore::decodeWalRecord(cursor);
+  ASSERT_FALSE(optionalObject.hasError());
+  ASSERT_TRUE(optionalObject->has_value());
+  EXPECT_EQ("key1", optionalObject->value().key);
+  EXPECT_EQ("val1", optionalObject->value().data.value());
+
+  optionalObject = PersistentStore::decodeWalRecord(cursor);
+  EXPECT_TRUE(optionalObject.hasError());
+
+  // Corrupted record fails checksum
+  data[data.size() - dataDel.size()] ^= 0xff;
+  buf = folly::IOBuf::wrapBuffer(data.data(), data.size());
+  folly::io::Cursor corruptCursor(buf.get());
+  EXPECT_TRUE(PersistentStore::decodeWalRecord(corruptCursor).hasError());
+}
+
+TEST(PersistentStoreTest, WalRecovery) {
+  fbzmq::Context context;
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+  const auto filePath = folly::sformat("/tmp/aq_persistent_store_wal_{}", tid);
+  const auto walFilePath = filePath + ".wal";
+  std::remove(filePath.c_str());
+  std::remove(walFilePath.c_str());
+
+  //
+  // Updates are committed to log before response without periodic save
+  //
+  {
+    auto store = std::make_unique<PersistentStore>(
+        "node1", filePath, context, false, false /*periodicallySaveToDisk*/);
+    std::thread storeThread([&]() { store->run(); });
+    store->waitUntilRunning();
+
+    store->store("key1", "val1").get();
+    store->store("key2", "val2").get();
+    EXPECT_TRUE(store->erase("key1").get());
+    EXPECT_EQ(3, store->getNumOfDbWritesToDisk());
+
+    std::string walData;
+    ASSERT_TRUE(folly::readFile(walFilePath.c_str(), walData));
+    auto buf = folly::IOBuf::wrapBuffer(walData.data(), walData.size());
+    folly::io::Cursor cursor(buf.get());
+    size_t numRecords{0};
+    while (true) {
+      auto optionalObject = PersistentStore::decodeWalRecord(cursor);
+      ASSERT_FALSE(optionalObject.hasError());
+      if (not optionalObject->has_value()) {
+        break;
+      }
+      ++numRecords;
+    }
+    EXPECT_EQ(3, numRecords);
+
+    // Simulate crash while appending to log, after saving the log aside
+    store->stop();
+    storeThread.join();
+    ASSERT_TRUE(folly::readFile(walFilePath.c_str(), walData));
+    store.reset();
+    walData.append(walData.substr(0, 10));
+    ASSERT_TRUE(folly::writeFile(walData, walFilePath.c_str()));
+    std::remove(filePath.c_str());
+  }
+
+  //
+  // Log is replayed till torn tail and compacted into the database
+  //
+  {
+    auto store = std::make_unique<PersistentStore>(
+        "node1", filePath, context, false, false /*periodicallySaveToDisk*/);
+    std::thread storeThread([&]() { store->run(); });
+    store->waitUntilRunning();
+
+    EXPECT_FALSE(store->load("key1").get().has_value());
+    EXPECT_EQ("val2", store->load("key2").get().value());
+
+    // Torn tail is truncated
+    std::string walData;
+    ASSERT_TRUE(folly::readFile(walFilePath.c_str(), walData));
+    auto buf = folly::IOBuf::wrapBuffer(walData.data(), walData.size());
+    folly::io::Cursor cursor(buf.get());
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_FALSE(PersistentStore::decodeWalRecord(cursor).hasError());
+    }
+    EXPECT_TRUE(cursor.isAtEnd());
+
+    store->stop();
+    storeThread.join();
+  }
+
+  // Log is compacted into the database on destruction
+  thrift::StoreDatabase database;
+  database.keyVals["key2"] = "val2";
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+  EXPECT_FALSE(fs::exists(walFilePath));
+  std::remove(filePath.c_str());
+  std::remove(walFilePath.c_str());
+}
+
+TEST(PersistentStoreTest, LazyLoad) {
+  fbzmq::Context context;
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  thrift::StoreDatabase database;
+  for (auto index = 0; index < 10; index++) {
+    database.keyVals[folly::sformat("key-{}", index)] =
+        folly::sformat("val-{}", folly::Random::rand32());
+  }
+
+  // Start from empty database
+  const auto filePath =
+      folly::sformat("/tmp/aq_persistent_store_test_{}", tid);
+  std::remove(filePath.c_str());
+  std::remove((filePath + ".wal").c_str());
+  {
+    PersistentStoreWrapper store(context, tid);
+    store.run();
+    ASSERT_EQ(filePath, store.filePath);
+    for (auto const& [key, val] : database.keyVals) {
+      store->store(key, val).get();
+    }
+  }
+
+  //
+  // Reload from mapped file. Accessed, overridden, erased and untouched keys
+  // are all persisted correctly.
+  //
+  {
+    PersistentStoreWrapper store(context, tid);
+    store.run();
+
+    EXPECT_EQ(database.keyVals.at("key-0"), store->load("key-0").get());
+    EXPECT_EQ(database.keyVals.at("key-0"), store->load("key-0").get());
+
+    store->store("key-1", "new-val").get();
+    EXPECT_EQ("new-val", store->load("key-1").get());
+    database.keyVals["key-1"] = "new-val";
+
+    EXPECT_TRUE(store->erase("key-2").get());
+    EXPECT_FALSE(store->erase("key-2").get());
+    EXPECT_FALSE(store->load("key-2").get().has_value());
+    database.keyVals.erase("key-2");
+  }
+
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+}
+
 } // namespace openr
 
 int
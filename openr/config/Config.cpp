@@ -1,7 +1,10 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
+#include <sched.h>
+
 #include <folly/FileUtil.h>
 #include <glog/logging.h>
+#include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -45,6 +48,46 @@ Config::getRunningConfig() const {
   return contents;
 }
 
+void
+Config::checkReloadable(const Config& newConfig) const {
+  // reset reloadable fields of new config to the running values, anything
+  // still differing requires restart
+  auto config = newConfig.getConfig();
+  if (config.areas.size() == config_.areas.size()) {
+    for (size_t i = 0; i < config.areas.size(); ++i) {
+      config.areas[i].interface_regexes = config_.areas[i].interface_regexes;
+      config.areas[i].neighbor_regexes = config_.areas[i].neighbor_regexes;
+    }
+  }
+  if (auto eorTime = config_.eor_time_s_ref()) {
+    config.eor_time_s_ref() = *eorTime;
+  } else {
+    config.eor_time_s_ref().reset();
+  }
+
+  auto& sparkConfig = config.spark_config;
+  sparkConfig.hello_time_s = config_.spark_config.hello_time_s;
+  sparkConfig.fastinit_hello_time_ms =
+      config_.spark_config.fastinit_hello_time_ms;
+  sparkConfig.keepalive_time_s = config_.spark_config.keepalive_time_s;
+  sparkConfig.hold_time_s = config_.spark_config.hold_time_s;
+  sparkConfig.graceful_restart_time_s =
+      config_.spark_config.graceful_restart_time_s;
+
+  // flood rate can't be enabled or disabled at runtime
+  auto floodRate = config.kvstore_config.flood_rate_ref();
+  if (floodRate.has_value() and
+      config_.kvstore_config.flood_rate_ref().has_value()) {
+    floodRate = *config_.kvstore_config.flood_rate_ref();
+  }
+
+  if (config != config_) {
+    throw std::invalid_argument(
+        "Config changes other than area regexes, eor_time_s, Spark timers "
+        "and KvStore flood rate require restart");
+  }
+}
+
 PrefixAllocationParams
 Config::createPrefixAllocationParams(
     const std::string& seedPfxStr, uint8_t allocationPfxLen) {
@@ -77,6 +120,123 @@ Config::createPrefixAllocationParams(
   return {seedPfx, allocationPfxLen};
 }
 
+namespace {
+
+// max number of interfaces with memoized filter decision
+const size_t kMaxFilteredInterfaces{16384};
+
+re2::RE2::Options
+getAreaRegexOptions() {
+  re2::RE2::Options regexOpts;
+  regexOpts.set_case_sensitive(false);
+  return regexOpts;
+}
+
+} // namespace
+
+InterfaceFilter::InterfaceFilter(
+    std::shared_ptr<const re2::RE2::Set> includeRegexes,
+    std::shared_ptr<const re2::RE2::Set> excludeRegexes,
+    std::shared_ptr<const re2::RE2::Set> redistributeRegexes)
+    : includeRegexes_(std::move(includeRegexes)),
+      excludeRegexes_(std::move(excludeRegexes)),
+      redistributeRegexes_(std::move(redistributeRegexes)),
+      decisions_(kMaxFilteredInterfaces) {}
+
+bool
+InterfaceFilter::isIncluded(const std::string& ifName) const {
+  return getDecision(ifName).included;
+}
+
+bool
+InterfaceFilter::isRedistributed(const std::string& ifName) const {
+  return getDecision(ifName).redistributed;
+}
+
+InterfaceFilter::Decision
+InterfaceFilter::getDecision(const std::string& ifName) const {
+  std::lock_guard<std::mutex> lock(decisionsMutex_);
+  auto it = decisions_.find(ifName);
+  if (it != decisions_.end()) {
+    return it->second;
+  }
+  Decision decision;
+  decision.included =
+      checkIncludeExcludeRegex(ifName, includeRegexes_, excludeRegexes_);
+  decision.redistributed = matchRegexSet(ifName, redistributeRegexes_);
+  decisions_.set(ifName, decision);
+  return decision;
+}
+
+AreaMatcher::AreaMatcher()
+    : neighborRegexes_(std::make_shared<re2::RE2::Set>(
+          getAreaRegexOptions(), re2::RE2::ANCHOR_BOTH)),
+      interfaceRegexes_(std::make_shared<re2::RE2::Set>(
+          getAreaRegexOptions(), re2::RE2::ANCHOR_BOTH)) {}
+
+void
+AreaMatcher::addArea(
+    const std::string& areaId,
+    const std::vector<std::string>& neighborRegexes,
+    const std::vector<std::string>& interfaceRegexes) {
+  const size_t areaIdx = areas_.size();
+  areas_.push_back(
+      {areaId, not neighborRegexes.empty(), not interfaceRegexes.empty()});
+
+  std::string regexErr;
+  for (const auto& regexStr : neighborRegexes) {
+    CHECK_NE(-1, neighborRegexes_->Add(regexStr, &regexErr)) << regexErr;
+    neighborRegexArea_.emplace_back(areaIdx);
+  }
+  for (const auto& regexStr : interfaceRegexes) {
+    CHECK_NE(-1, interfaceRegexes_->Add(regexStr, &regexErr)) << regexErr;
+    interfaceRegexArea_.emplace_back(areaIdx);
+  }
+}
+
+void
+AreaMatcher::compile() {
+  // RE2::Set can't be compiled without any regex
+  if (not neighborRegexArea_.empty() and not neighborRegexes_->Compile()) {
+    throw std::invalid_argument("Neighbor regex compilation failed");
+  }
+  if (not interfaceRegexArea_.empty() and not interfaceRegexes_->Compile()) {
+    throw std::invalid_argument("Interface regex compilation failed");
+  }
+}
+
+std::vector<std::string>
+AreaMatcher::match(
+    const std::string& nodeName, const std::string& ifName) const {
+  std::vector<bool> neighborMatched(areas_.size(), false);
+  std::vector<bool> interfaceMatched(areas_.size(), false);
+  std::vector<int> matches;
+  if (not neighborRegexArea_.empty() and
+      neighborRegexes_->Match(nodeName, &matches)) {
+    for (auto idx : matches) {
+      neighborMatched.at(neighborRegexArea_.at(idx)) = true;
+    }
+  }
+  matches.clear();
+  if (not interfaceRegexArea_.empty() and
+      interfaceRegexes_->Match(ifName, &matches)) {
+    for (auto idx : matches) {
+      interfaceMatched.at(interfaceRegexArea_.at(idx)) = true;
+    }
+  }
+
+  std::vector<std::string> areaIds;
+  for (size_t i = 0; i < areas_.size(); ++i) {
+    const auto& area = areas_.at(i);
+    if ((area.hasNeighborRegex or area.hasInterfaceRegex) and
+        (not area.hasNeighborRegex or neighborMatched.at(i)) and
+        (not area.hasInterfaceRegex or interfaceMatched.at(i))) {
+      areaIds.emplace_back(area.areaId);
+    }
+  }
+  return areaIds;
+}
+
 void
 Config::addAreaRegex(
     const std::string& areaId,
@@ -137,6 +297,7 @@ Config::addAreaRegex(
       areaId,
       AreaConfiguration(
           areaId, std::move(neighborRegexList), std::move(interfaceRegexList)));
+  areaMatcher_.addArea(areaId, neighborRegexes, interfaceRegexes);
 }
 
 // parse openrConfig to initialize:
@@ -163,6 +324,10 @@ Config::populateAreaConfig() {
       throw std::invalid_argument(
           folly::sformat("Duplicate area config: area_id {}", area.area_id));
     }
+    // validate summary prefixes
+    for (const auto& prefix : area.summary_prefixes) {
+      folly::IPAddress::createNetwork(prefix);
+    }
   }
 
   for (const auto& areaConfig : config_.areas) {
@@ -171,6 +336,7 @@ Config::populateAreaConfig() {
         areaConfig.neighbor_regexes,
         areaConfig.interface_regexes);
   }
+  areaMatcher_.compile();
 }
 
 void
@@ -200,6 +366,25 @@ Config::populateInternalDb() {
         "enable_ordered_fib_programming only support single area config"));
   }
 
+  //
+  // Decision
+  //
+  if (getDecisionRouteBuildThreads() < 0) {
+    throw std::out_of_range(folly::sformat(
+        "decision_route_build_threads ({}) should be >= 0",
+        getDecisionRouteBuildThreads()));
+  }
+  if (config_.decision_spf_cache_mb_ref().value_or(0) < 0) {
+    throw std::out_of_range(folly::sformat(
+        "decision_spf_cache_mb ({}) should be >= 0",
+        *config_.decision_spf_cache_mb_ref()));
+  }
+  if (config_.decision_max_prefixes_per_originator_ref().value_or(0) < 0) {
+    throw std::out_of_range(folly::sformat(
+        "decision_max_prefixes_per_originator ({}) should be >= 0",
+        *config_.decision_max_prefixes_per_originator_ref()));
+  }
+
   //
   // Kvstore
   //
@@ -212,6 +397,39 @@ Config::populateInternalDb() {
       throw std::out_of_range("kvstore flood_msg_burst_size should be > 0");
     }
   }
+  if (const auto& subscriberRate = kvConf.subscriber_rate_ref()) {
+    if (subscriberRate->flood_msg_per_sec <= 0) {
+      throw std::out_of_range(
+          "kvstore subscriber_rate flood_msg_per_sec should be > 0");
+    }
+    if (subscriberRate->flood_msg_burst_size <= 0) {
+      throw std::out_of_range(
+          "kvstore subscriber_rate flood_msg_burst_size should be > 0");
+    }
+  }
+  if (kvConf.subscriber_max_buffered_keys <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore subscriber_max_buffered_keys ({}) should be > 0",
+        kvConf.subscriber_max_buffered_keys));
+  }
+  if (const auto& interval = kvConf.warm_start_snapshot_interval_s_ref()) {
+    if (*interval <= 0) {
+      throw std::out_of_range(folly::sformat(
+          "kvstore warm_start_snapshot_interval_s ({}) should be > 0",
+          *interval));
+    }
+  }
+  if (kvConf.max_keys_per_originator_ref().value_or(0) < 0 or
+      kvConf.max_bytes_per_originator_ref().value_or(0) < 0 or
+      kvConf.max_keys_per_area_ref().value_or(0) < 0 or
+      kvConf.max_bytes_per_area_ref().value_or(0) < 0) {
+    throw std::out_of_range("kvstore key and byte limits should be >= 0");
+  }
+  if (kvConf.flood_batch_ms_ref().value_or(0) < 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore flood_batch_ms ({}) should be >= 0",
+        *kvConf.flood_batch_ms_ref()));
+  }
 
   //
   // Spark
@@ -279,6 +497,28 @@ Config::populateInternalDb() {
         sparkConfig.keepalive_time_s));
   }
 
+  if (auto livenessConf = sparkConfig.fast_liveness_config_ref()) {
+    if (livenessConf->port <= 0 || livenessConf->port > 65535 ||
+        livenessConf->port == sparkConfig.neighbor_discovery_port) {
+      throw std::out_of_range(folly::sformat(
+          "fast_liveness_config.port ({}) should be in range [0, 65535] and "
+          "differ from neighbor_discovery_port",
+          livenessConf->port));
+    }
+    if (livenessConf->interval_ms < 10 ||
+        livenessConf->interval_ms > 1000 * sparkConfig.keepalive_time_s) {
+      throw std::out_of_range(folly::sformat(
+          "fast_liveness_config.interval_ms ({}) should be >= 10 and <= "
+          "keepalive_time_s * 1000",
+          livenessConf->interval_ms));
+    }
+    if (livenessConf->detect_multiplier < 2) {
+      throw std::out_of_range(folly::sformat(
+          "fast_liveness_config.detect_multiplier ({}) should be >= 2",
+          livenessConf->detect_multiplier));
+    }
+  }
+
   //
   // Link Monitor
   //
@@ -304,6 +544,37 @@ Config::populateInternalDb() {
         lmConf.linkflap_max_backoff_ms));
   }
 
+  // adjacency dampening validation
+  if (lmConf.enable_adj_dampening) {
+    const auto& dampConf = lmConf.adj_dampening_config;
+    if (dampConf.half_life_s <= 0) {
+      throw std::out_of_range(folly::sformat(
+          "adj_dampening_config.half_life_s ({}) should be > 0",
+          dampConf.half_life_s));
+    }
+    if (dampConf.rtt_change_penalty < 0 or dampConf.flap_penalty < 0) {
+      throw std::out_of_range(folly::sformat(
+          "adj_dampening_config penalties ({}, {}) should be >= 0",
+          dampConf.rtt_change_penalty,
+          dampConf.flap_penalty));
+    }
+    if (dampConf.reuse_threshold <= 0 or
+        dampConf.reuse_threshold >= dampConf.suppress_threshold) {
+      throw std::out_of_range(folly::sformat(
+          "adj_dampening_config.reuse_threshold ({}) should be > 0 and "
+          "< suppress_threshold ({})",
+          dampConf.reuse_threshold,
+          dampConf.suppress_threshold));
+    }
+    if (dampConf.max_suppress_time_s < dampConf.half_life_s) {
+      throw std::out_of_range(folly::sformat(
+          "adj_dampening_config.max_suppress_time_s ({}) should be >= "
+          "half_life_s ({})",
+          dampConf.max_suppress_time_s,
+          dampConf.half_life_s));
+    }
+  }
+
   // Construct the regular expressions to match interface names against
   re2::RE2::Options regexOpts;
   std::string regexErr;
@@ -357,6 +628,8 @@ Config::populateInternalDb() {
           folly::sformat("redistribute_interface_regexes compile failed"));
     }
   }
+  interfaceFilter_ = std::make_shared<InterfaceFilter>(
+      includeItfRegexes_, excludeItfRegexes_, redistributeItfRegexes_);
 
   //
   // Prefix Allocation
@@ -406,6 +679,12 @@ Config::populateInternalDb() {
       break;
     }
     }
+
+    if (paConf->enable_prefix_lease_ref().value_or(false) and
+        paConf->prefix_allocation_mode == PrefixAllocationMode::STATIC) {
+      throw std::invalid_argument(
+          "enable_prefix_lease = true, but prefix_allocation_mode is STATIC");
+    }
   } // if enable_prefix_allocation_ref()
 
   //
@@ -424,5 +703,45 @@ Config::populateInternalDb() {
         "enable_watchdog = true, but watchdog_config is empty");
   }
 
+  //
+  // thread scheduling
+  //
+  const auto schedulingConfig =
+      config_.thread_scheduling_config_ref().value_or(
+          std::map<std::string, thrift::ThreadSchedulingConfig>{});
+  for (auto const& [threadName, scheduling] : schedulingConfig) {
+    for (auto const cpu : scheduling.cpus) {
+      if (cpu < 0 or cpu >= CPU_SETSIZE) {
+        throw std::out_of_range(folly::sformat(
+            "thread_scheduling_config of {}: cpu ({}) should be in [0, {})",
+            threadName,
+            cpu,
+            CPU_SETSIZE));
+      }
+    }
+    auto nice = scheduling.nice_ref();
+    if (nice and (*nice < -20 or *nice > 19)) {
+      throw std::out_of_range(folly::sformat(
+          "thread_scheduling_config of {}: nice ({}) should be in [-20, 19]",
+          threadName,
+          *nice));
+    }
+    if (auto priority = scheduling.realtime_priority_ref()) {
+      if (*priority < 1 or *priority > 99) {
+        throw std::out_of_range(folly::sformat(
+            "thread_scheduling_config of {}: realtime_priority ({}) should be "
+            "in [1, 99]",
+            threadName,
+            *priority));
+      }
+      if (nice) {
+        throw std::invalid_argument(folly::sformat(
+            "thread_scheduling_config of {}: nice and realtime_priority are "
+            "exclusive",
+            threadName));
+      }
+    }
+  }
+
 } // namespace openr
 } // namespace openr
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <mutex>
+
 #include <folly/IPAddress.h>
+#include <folly/container/EvictingCacheMap.h>
 #include <re2/re2.h>
 #include <re2/set.h>
 
@@ -31,6 +34,75 @@ struct AreaConfiguration {
   std::shared_ptr<re2::RE2::Set> interfaceRegexList{nullptr};
 };
 
+// Regexes of all areas compiled into a single RE2::Set per dimension
+// (neighbor name, interface name), so that areas of a neighbor are deduced
+// with one match per dimension regardless of the number of areas. As with
+// AreaConfiguration, area with both regexes matches if both of them match.
+class AreaMatcher {
+ public:
+  AreaMatcher();
+
+  // add regexes of area, which must have been validated already
+  void addArea(
+      const std::string& areaId,
+      const std::vector<std::string>& neighborRegexes,
+      const std::vector<std::string>& interfaceRegexes);
+
+  // compile regexes, must be called once after all areas are added
+  void compile();
+
+  // areas matching the neighbor on the interface
+  std::vector<std::string> match(
+      const std::string& nodeName, const std::string& ifName) const;
+
+ private:
+  struct Area {
+    std::string areaId;
+    bool hasNeighborRegex{false};
+    bool hasInterfaceRegex{false};
+  };
+  std::vector<Area> areas_;
+
+  // combined regexes, with index of the area of each of them
+  std::shared_ptr<re2::RE2::Set> neighborRegexes_{nullptr};
+  std::shared_ptr<re2::RE2::Set> interfaceRegexes_{nullptr};
+  std::vector<size_t> neighborRegexArea_;
+  std::vector<size_t> interfaceRegexArea_;
+};
+
+// Interface filter of LinkMonitor, compiled from interface regexes. Decision
+// is memoized per interface name, as the same names are matched on every link
+// and address event. Config doesn't change at runtime, new config comes with
+// its own filter, hence memoized decisions are never stale.
+class InterfaceFilter {
+ public:
+  InterfaceFilter(
+      std::shared_ptr<const re2::RE2::Set> includeRegexes,
+      std::shared_ptr<const re2::RE2::Set> excludeRegexes,
+      std::shared_ptr<const re2::RE2::Set> redistributeRegexes);
+
+  // interface matches include regexes and doesn't match exclude regexes
+  bool isIncluded(const std::string& ifName) const;
+
+  // addresses of interface are redistributed
+  bool isRedistributed(const std::string& ifName) const;
+
+ private:
+  struct Decision {
+    bool included{false};
+    bool redistributed{false};
+  };
+  Decision getDecision(const std::string& ifName) const;
+
+  const std::shared_ptr<const re2::RE2::Set> includeRegexes_;
+  const std::shared_ptr<const re2::RE2::Set> excludeRegexes_;
+  const std::shared_ptr<const re2::RE2::Set> redistributeRegexes_;
+
+  // memoized decisions, filter can be shared by threads
+  mutable std::mutex decisionsMutex_;
+  mutable folly::EvictingCacheMap<std::string, Decision> decisions_;
+};
+
 class Config {
  public:
   explicit Config(const std::string& configFile);
@@ -50,6 +122,12 @@ class Config {
   }
   std::string getRunningConfig() const;
 
+  // Check that running config can be replaced with the new one at runtime,
+  // i.e. differences are limited to the reloadable fields: area regexes,
+  // eor_time_s, Spark timers and values of KvStore flood rate. Throws
+  // std::invalid_argument otherwise
+  void checkReloadable(const Config& newConfig) const;
+
   const std::string&
   getNodeName() const {
     return config_.node_name;
@@ -94,6 +172,65 @@ class Config {
     return config_.enable_rib_policy;
   }
 
+  bool
+  isIncrementalSpfEnabled() const {
+    return config_.enable_incremental_spf_ref().value_or(false);
+  }
+
+  //
+  // decision
+  //
+  int32_t
+  getDecisionRouteBuildThreads() const {
+    return config_.decision_route_build_threads_ref().value_or(0);
+  }
+
+  size_t
+  getDecisionSpfCacheBytes() const {
+    return static_cast<size_t>(config_.decision_spf_cache_mb_ref().value_or(0))
+        << 20;
+  }
+
+  size_t
+  getDecisionMaxPrefixesPerOriginator() const {
+    return static_cast<size_t>(
+        config_.decision_max_prefixes_per_originator_ref().value_or(0));
+  }
+
+  bool
+  isDecisionPhasePerfEventsEnabled() const {
+    return config_.enable_decision_phase_perf_events_ref().value_or(false);
+  }
+
+  bool
+  isAsyncRouteBuildEnabled() const {
+    return config_.enable_async_route_build_ref().value_or(false);
+  }
+
+  bool
+  isUcmpEnabled() const {
+    return config_.enable_ucmp_ref().value_or(false);
+  }
+
+  bool
+  isNextHopGroupsEnabled() const {
+    return config_.enable_nexthop_groups_ref().value_or(false);
+  }
+
+  //
+  // thread scheduling
+  //
+  std::optional<thrift::ThreadSchedulingConfig>
+  getThreadSchedulingConfig(const std::string& threadName) const {
+    if (auto schedulingConfig = config_.thread_scheduling_config_ref()) {
+      auto it = schedulingConfig->find(threadName);
+      if (it != schedulingConfig->end()) {
+        return it->second;
+      }
+    }
+    return std::nullopt;
+  }
+
   //
   // area
   //
@@ -119,6 +256,11 @@ class Config {
     return areaConfigs_;
   }
 
+  const AreaMatcher&
+  getAreaMatcher() const {
+    return areaMatcher_;
+  }
+
   //
   // spark
   //
@@ -145,6 +287,57 @@ class Config {
     return getKvStoreConfig().enable_flood_optimization_ref().value_or(false);
   }
 
+  bool
+  isKvStoreHashTreeSyncEnabled() const {
+    return getKvStoreConfig().enable_hash_tree_sync_ref().value_or(false);
+  }
+
+  bool
+  isKvStoreValueCompressionEnabled() const {
+    return getKvStoreConfig().enable_value_compression_ref().value_or(false);
+  }
+
+  bool
+  isKvStoreSnapshotReadsEnabled() const {
+    return getKvStoreConfig().enable_snapshot_reads_ref().value_or(false);
+  }
+
+  bool
+  isKvStoreMultiRootFloodingEnabled() const {
+    return getKvStoreConfig().enable_multi_root_flooding_ref().value_or(false);
+  }
+
+  bool
+  isKvStoreAreaThreadsEnabled() const {
+    return getKvStoreConfig().enable_area_threads_ref().value_or(false);
+  }
+
+  int32_t
+  getKvStoreMergeThreads() const {
+    return getKvStoreConfig().merge_threads_ref().value_or(0);
+  }
+
+  size_t
+  getKvStoreMaxParallelFullSyncs() const {
+    return getKvStoreConfig().max_parallel_full_syncs_ref().value_or(
+        Constants::kMaxFullSyncPendingCountThreshold);
+  }
+
+  std::chrono::milliseconds
+  getKvStoreFloodBatchInterval() const {
+    return std::chrono::milliseconds(
+        getKvStoreConfig().flood_batch_ms_ref().value_or(0));
+  }
+
+  std::optional<std::chrono::seconds>
+  getKvStoreWarmStartSnapshotInterval() const {
+    if (auto interval =
+            getKvStoreConfig().warm_start_snapshot_interval_s_ref()) {
+      return std::chrono::seconds(*interval);
+    }
+    return std::nullopt;
+  }
+
   //
   // link monitor
   //
@@ -153,6 +346,16 @@ class Config {
     return config_.link_monitor_config;
   }
 
+  bool
+  isAdjDampeningEnabled() const {
+    return getLinkMonitorConfig().enable_adj_dampening;
+  }
+
+  const thrift::AdjacencyDampeningConfig&
+  getAdjDampeningConfig() const {
+    return getLinkMonitorConfig().adj_dampening_config;
+  }
+
   std::shared_ptr<const re2::RE2::Set>
   getIncludeItfRegexes() const {
     return includeItfRegexes_;
@@ -168,6 +371,11 @@ class Config {
     return redistributeItfRegexes_;
   }
 
+  std::shared_ptr<const InterfaceFilter>
+  getInterfaceFilter() const {
+    return interfaceFilter_;
+  }
+
   //
   // prefix Allocation
   //
@@ -225,11 +433,15 @@ class Config {
   std::shared_ptr<re2::RE2::Set> includeItfRegexes_{nullptr};
   std::shared_ptr<re2::RE2::Set> excludeItfRegexes_{nullptr};
   std::shared_ptr<re2::RE2::Set> redistributeItfRegexes_{nullptr};
+  std::shared_ptr<const InterfaceFilter> interfaceFilter_{nullptr};
   // prefix allocation
   folly::Optional<PrefixAllocationParams> prefixAllocationParams_{folly::none};
 
   // areaId -> neighbor regex and interface regex mapped
   std::unordered_map<std::string /* areaId */, AreaConfiguration> areaConfigs_;
+
+  // all area regexes, compiled together
+  AreaMatcher areaMatcher_;
 };
 
 } // namespace openr
@@ -127,6 +127,12 @@ class GflagConfig final {
     if (auto v = FLAGS_is_flood_root) {
       kvstoreConf.is_flood_root_ref() = v;
     }
+    if (auto v = FLAGS_enable_kvstore_hash_tree_sync) {
+      kvstoreConf.enable_hash_tree_sync_ref() = v;
+    }
+    if (auto v = FLAGS_enable_kvstore_value_compression) {
+      kvstoreConf.enable_value_compression_ref() = v;
+    }
 
     // LinkMonitor
     auto& lmConf = config.link_monitor_config;
@@ -210,6 +216,17 @@ class GflagConfig final {
     // RibPolicy
     config.enable_rib_policy = FLAGS_enable_rib_policy;
 
+    // Decision
+    if (auto v = FLAGS_enable_incremental_spf) {
+      config.enable_incremental_spf_ref() = v;
+    }
+    if (auto v = FLAGS_decision_route_build_threads) {
+      config.decision_route_build_threads_ref() = v;
+    }
+    if (auto v = FLAGS_enable_nexthop_groups) {
+      config.enable_nexthop_groups_ref() = v;
+    }
+
     return std::make_shared<Config>(config);
   }
 
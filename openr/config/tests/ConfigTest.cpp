@@ -151,6 +151,20 @@ TEST(ConfigTest, PopulateAreaConfig) {
     EXPECT_THROW((Config(confInvalidArea)), std::invalid_argument);
   }
 
+  // summary prefixes
+  {
+    auto areaConfig = getAreaConfig("1");
+    areaConfig.summary_prefixes = {"10.0.0.0/8", "fc00::/48"};
+    auto confValidArea = getBasicOpenrConfig();
+    confValidArea.areas = {areaConfig};
+    EXPECT_NO_THROW((Config(confValidArea)));
+
+    areaConfig.summary_prefixes = {"10.0.0.0/33"};
+    auto confInvalidArea = getBasicOpenrConfig();
+    confInvalidArea.areas = {areaConfig};
+    EXPECT_ANY_THROW((Config(confInvalidArea)));
+  }
+
   // area config - empty neighbor and interfsace regexes
   {
     openr::thrift::AreaConfig area;
@@ -223,6 +237,36 @@ TEST(ConfigTest, PopulateAreaConfig) {
   }
 }
 
+TEST(ConfigTest, AreaMatcher) {
+  openr::thrift::AreaConfig spineArea;
+  spineArea.area_id = "spine";
+  spineArea.neighbor_regexes = {"ssw.*", "fa.*"};
+  openr::thrift::AreaConfig podArea;
+  podArea.area_id = "pod";
+  podArea.neighbor_regexes.emplace_back("rsw.*");
+  podArea.interface_regexes.emplace_back("po.*");
+  openr::thrift::AreaConfig mgmtArea;
+  mgmtArea.area_id = "mgmt";
+  mgmtArea.interface_regexes.emplace_back("eth0");
+  std::vector<openr::thrift::AreaConfig> vec = {spineArea, podArea, mgmtArea};
+  Config cfg(getBasicOpenrConfig(
+      "node-1",
+      "domain",
+      std::make_unique<std::vector<openr::thrift::AreaConfig>>(vec)));
+  const auto& matcher = cfg.getAreaMatcher();
+
+  using Areas = std::vector<std::string>;
+  EXPECT_EQ(Areas({"spine"}), matcher.match("SSW001", "po1"));
+  EXPECT_EQ(Areas({"spine"}), matcher.match("fa001", "et1"));
+  // area with both regexes requires both to match
+  EXPECT_EQ(Areas({"pod"}), matcher.match("rsw001", "po1"));
+  EXPECT_EQ(Areas({}), matcher.match("rsw001", "et1"));
+  EXPECT_EQ(Areas({"mgmt"}), matcher.match("rsw001", "eth0"));
+  // regexes are anchored on both ends
+  EXPECT_EQ(Areas({}), matcher.match("xssw001", "eth01"));
+  EXPECT_EQ(Areas({"spine", "mgmt"}), matcher.match("ssw001", "eth0"));
+}
+
 TEST(ConfigTest, PopulateInternalDb) {
   // features
 
@@ -251,6 +295,94 @@ TEST(ConfigTest, PopulateInternalDb) {
     EXPECT_TRUE(Config(conf).isRibPolicyEnabled());
   }
 
+  // decision
+
+  // decision_route_build_threads < 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.decision_route_build_threads_ref() = -1;
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  {
+    auto conf = getBasicOpenrConfig();
+    EXPECT_EQ(0, Config(conf).getDecisionRouteBuildThreads());
+    conf.decision_route_build_threads_ref() = 4;
+    EXPECT_EQ(4, Config(conf).getDecisionRouteBuildThreads());
+  }
+  // decision_spf_cache_mb < 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.decision_spf_cache_mb_ref() = -1;
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  {
+    auto conf = getBasicOpenrConfig();
+    EXPECT_EQ(0, Config(conf).getDecisionSpfCacheBytes());
+    conf.decision_spf_cache_mb_ref() = 2;
+    EXPECT_EQ(2 << 20, Config(conf).getDecisionSpfCacheBytes());
+  }
+  // decision_max_prefixes_per_originator < 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.decision_max_prefixes_per_originator_ref() = -1;
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  {
+    auto conf = getBasicOpenrConfig();
+    EXPECT_EQ(0, Config(conf).getDecisionMaxPrefixesPerOriginator());
+    conf.decision_max_prefixes_per_originator_ref() = 1000;
+    EXPECT_EQ(1000, Config(conf).getDecisionMaxPrefixesPerOriginator());
+  }
+
+  // thread scheduling
+
+  {
+    auto conf = getBasicOpenrConfig();
+    EXPECT_FALSE(Config(conf).getThreadSchedulingConfig("Spark").has_value());
+    thrift::ThreadSchedulingConfig scheduling;
+    scheduling.cpus = {0, 1};
+    scheduling.realtime_priority_ref() = 10;
+    conf.thread_scheduling_config_ref() = {{"Spark", scheduling}};
+    auto sparkScheduling = Config(conf).getThreadSchedulingConfig("Spark");
+    ASSERT_TRUE(sparkScheduling.has_value());
+    EXPECT_EQ(scheduling, *sparkScheduling);
+    EXPECT_FALSE(
+        Config(conf).getThreadSchedulingConfig("Decision").has_value());
+  }
+  // cpu < 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig scheduling;
+    scheduling.cpus = {-1};
+    confInvalid.thread_scheduling_config_ref() = {{"Spark", scheduling}};
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  // nice out of range
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig scheduling;
+    scheduling.nice_ref() = 20;
+    confInvalid.thread_scheduling_config_ref() = {{"Spark", scheduling}};
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  // realtime_priority out of range
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig scheduling;
+    scheduling.realtime_priority_ref() = 0;
+    confInvalid.thread_scheduling_config_ref() = {{"Spark", scheduling}};
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  // both nice and realtime_priority
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig scheduling;
+    scheduling.nice_ref() = -5;
+    scheduling.realtime_priority_ref() = 10;
+    confInvalid.thread_scheduling_config_ref() = {{"Spark", scheduling}};
+    EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
+  }
+
   // kvstore
 
   // flood_msg_per_sec <= 0
@@ -269,6 +401,40 @@ TEST(ConfigTest, PopulateInternalDb) {
         ->flood_msg_burst_size = 0;
     EXPECT_THROW((Config(confInvalidFloodMsgPerSec)), std::out_of_range);
   }
+  // subscriber_rate flood_msg_per_sec <= 0
+  {
+    auto confInvalidSubscriberRate = getBasicOpenrConfig();
+    confInvalidSubscriberRate.kvstore_config.subscriber_rate_ref() =
+        getFloodRate();
+    confInvalidSubscriberRate.kvstore_config.subscriber_rate_ref()
+        ->flood_msg_per_sec = 0;
+    EXPECT_THROW((Config(confInvalidSubscriberRate)), std::out_of_range);
+  }
+  // subscriber_max_buffered_keys <= 0
+  {
+    auto confInvalidMaxBuffered = getBasicOpenrConfig();
+    confInvalidMaxBuffered.kvstore_config.subscriber_max_buffered_keys = 0;
+    EXPECT_THROW((Config(confInvalidMaxBuffered)), std::out_of_range);
+  }
+  // warm_start_snapshot_interval_s <= 0
+  {
+    auto confInvalidWarmStart = getBasicOpenrConfig();
+    confInvalidWarmStart.kvstore_config.warm_start_snapshot_interval_s_ref() =
+        0;
+    EXPECT_THROW((Config(confInvalidWarmStart)), std::out_of_range);
+  }
+  // key and byte limits < 0
+  {
+    auto confInvalidLimits = getBasicOpenrConfig();
+    confInvalidLimits.kvstore_config.max_bytes_per_originator_ref() = -1;
+    EXPECT_THROW((Config(confInvalidLimits)), std::out_of_range);
+  }
+  // flood_batch_ms < 0
+  {
+    auto confInvalidFloodBatch = getBasicOpenrConfig();
+    confInvalidFloodBatch.kvstore_config.flood_batch_ms_ref() = -1;
+    EXPECT_THROW((Config(confInvalidFloodBatch)), std::out_of_range);
+  }
 
   // Spark
 
@@ -327,6 +493,35 @@ TEST(ConfigTest, PopulateInternalDb) {
     EXPECT_THROW(auto c = Config(confInvalidSpark), std::invalid_argument);
   }
 
+  // fast liveness
+  {
+    auto confValidSpark = getBasicOpenrConfig();
+    confValidSpark.spark_config.fast_liveness_config_ref() =
+        thrift::SparkFastLivenessConfig{};
+    EXPECT_NO_THROW(auto c = Config(confValidSpark));
+  }
+  // Exception: fast liveness port same as neighbor_discovery_port
+  {
+    auto confInvalidSpark = getBasicOpenrConfig();
+    thrift::SparkFastLivenessConfig livenessConf;
+    livenessConf.port = confInvalidSpark.spark_config.neighbor_discovery_port;
+    confInvalidSpark.spark_config.fast_liveness_config_ref() = livenessConf;
+    EXPECT_THROW(auto c = Config(confInvalidSpark), std::out_of_range);
+  }
+  // Exception: fast liveness interval_ms < 10 or detect_multiplier < 2
+  {
+    auto confInvalidSpark = getBasicOpenrConfig();
+    thrift::SparkFastLivenessConfig livenessConf;
+    livenessConf.interval_ms = 5;
+    confInvalidSpark.spark_config.fast_liveness_config_ref() = livenessConf;
+    EXPECT_THROW(auto c = Config(confInvalidSpark), std::out_of_range);
+
+    livenessConf.interval_ms = 20;
+    livenessConf.detect_multiplier = 1;
+    confInvalidSpark.spark_config.fast_liveness_config_ref() = livenessConf;
+    EXPECT_THROW(auto c = Config(confInvalidSpark), std::out_of_range);
+  }
+
   // link monitor
 
   // linkflap_initial_backoff_ms < 0
@@ -349,6 +544,28 @@ TEST(ConfigTest, PopulateInternalDb) {
     EXPECT_THROW(auto c = Config(confInvalidLm), std::out_of_range);
   }
 
+  // adj_dampening_config.half_life_s <= 0
+  {
+    auto confInvalidLm = getBasicOpenrConfig();
+    confInvalidLm.link_monitor_config.enable_adj_dampening = true;
+    confInvalidLm.link_monitor_config.adj_dampening_config.half_life_s = 0;
+    EXPECT_THROW(auto c = Config(confInvalidLm), std::out_of_range);
+  }
+  // adj_dampening_config.reuse_threshold >= suppress_threshold
+  {
+    auto confInvalidLm = getBasicOpenrConfig();
+    confInvalidLm.link_monitor_config.enable_adj_dampening = true;
+    confInvalidLm.link_monitor_config.adj_dampening_config.reuse_threshold =
+        3000;
+    EXPECT_THROW(auto c = Config(confInvalidLm), std::out_of_range);
+  }
+  // invalid adj_dampening_config is ignored when dampening is disabled
+  {
+    auto confLm = getBasicOpenrConfig();
+    confLm.link_monitor_config.adj_dampening_config.half_life_s = 0;
+    EXPECT_NO_THROW(auto c = Config(confLm));
+  }
+
   // invalid include_interface_regexes
   {
     auto confInvalidLm = getBasicOpenrConfig();
@@ -448,6 +665,16 @@ TEST(ConfigTest, PopulateInternalDb) {
         32;
     EXPECT_THROW((Config(confInvalidPa)), std::invalid_argument);
   }
+  // enable_prefix_lease = true with STATIC mode
+  {
+    auto confInvalidPa = getBasicOpenrConfig();
+    confInvalidPa.enable_prefix_allocation_ref() = true;
+    confInvalidPa.prefix_allocation_config_ref() =
+        getPrefixAllocationConfig(thrift::PrefixAllocationMode::STATIC);
+    confInvalidPa.prefix_allocation_config_ref()->enable_prefix_lease_ref() =
+        true;
+    EXPECT_THROW((Config(confInvalidPa)), std::invalid_argument);
+  }
 
   // bgp peering
 
@@ -547,6 +774,62 @@ TEST(ConfigTest, KvstoreGetter) {
   EXPECT_EQ(std::chrono::milliseconds(300000), config.getKvStoreKeyTtl());
 }
 
+TEST(ConfigTest, ReloadableTest) {
+  auto tConfig = getBasicOpenrConfig("node-1");
+  const auto config = Config(tConfig);
+
+  // same config
+  EXPECT_NO_THROW(config.checkReloadable(Config(tConfig)));
+
+  // reloadable fields
+  {
+    auto newConfig = tConfig;
+    newConfig.areas.at(0).interface_regexes = {"po.*"};
+    newConfig.areas.at(0).neighbor_regexes = {"rsw.*"};
+    newConfig.eor_time_s_ref() = 30;
+    newConfig.spark_config.hello_time_s = 4;
+    newConfig.spark_config.keepalive_time_s = 2;
+    newConfig.spark_config.hold_time_s = 6;
+    newConfig.spark_config.graceful_restart_time_s = 12;
+    EXPECT_NO_THROW(config.checkReloadable(Config(newConfig)));
+  }
+
+  // flood rate values are reloadable, enabling it isn't
+  {
+    auto rateConfig = tConfig;
+    thrift::KvstoreFloodRate floodRate;
+    floodRate.flood_msg_per_sec = 100;
+    floodRate.flood_msg_burst_size = 10;
+    rateConfig.kvstore_config.flood_rate_ref() = floodRate;
+    EXPECT_THROW(
+        config.checkReloadable(Config(rateConfig)), std::invalid_argument);
+
+    auto newConfig = rateConfig;
+    newConfig.kvstore_config.flood_rate_ref()->flood_msg_per_sec = 1000;
+    EXPECT_NO_THROW(Config(rateConfig).checkReloadable(Config(newConfig)));
+  }
+
+  // areas themselves and other fields require restart
+  {
+    auto newConfig = tConfig;
+    newConfig.areas.at(0).area_id = "1";
+    EXPECT_THROW(
+        config.checkReloadable(Config(newConfig)), std::invalid_argument);
+  }
+  {
+    auto newConfig = tConfig;
+    newConfig.spark_config.neighbor_discovery_port = 7777;
+    EXPECT_THROW(
+        config.checkReloadable(Config(newConfig)), std::invalid_argument);
+  }
+  {
+    auto newConfig = tConfig;
+    newConfig.node_name = "node-2";
+    EXPECT_THROW(
+        config.checkReloadable(Config(newConfig)), std::invalid_argument);
+  }
+}
+
 TEST(ConfigTest, LinkMonitorGetter) {
   auto tConfig = getBasicOpenrConfig();
   const auto& lmConf = getTestLinkMonitorConfig();
@@ -579,6 +862,17 @@ TEST(ConfigTest, LinkMonitorGetter) {
     EXPECT_TRUE(redistributeItfRegexes->Match("lo", &matches));
     EXPECT_FALSE(redistributeItfRegexes->Match("eth0", &matches));
   }
+
+  // getInterfaceFilter, decisions are same when memoized
+  auto interfaceFilter = config.getInterfaceFilter();
+  ASSERT_NE(nullptr, interfaceFilter);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(interfaceFilter->isIncluded("fboss10"));
+    EXPECT_FALSE(interfaceFilter->isIncluded("eth0"));
+    EXPECT_FALSE(interfaceFilter->isRedistributed("fboss10"));
+    EXPECT_TRUE(interfaceFilter->isRedistributed("lo"));
+    EXPECT_FALSE(interfaceFilter->isIncluded("lo"));
+  }
 }
 
 TEST(ConfigTest, PrefixAllocatorGetter) {
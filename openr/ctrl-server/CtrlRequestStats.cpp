@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/ctrl-server/CtrlRequestStats.h>
+
+#include <algorithm>
+
+#include <fb303/ServiceData.h>
+#include <folly/Format.h>
+#include <thrift/lib/cpp/transport/THeader.h>
+#include <thrift/lib/cpp2/server/Cpp2ConnContext.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/OpenrEventBase.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+namespace {
+// Histogram buckets of latencies, in microseconds
+constexpr int64_t kLatencyBucketWidthUs{1000};
+constexpr int64_t kLatencyMaxUs{1000000};
+
+std::string
+getCounterName(const std::string& method) {
+  return folly::sformat("ctrl.request.{}", method);
+}
+
+std::string
+getCounterName(const std::string& method, const char* name) {
+  return folly::sformat("ctrl.request.{}.{}", method, name);
+}
+} // namespace
+
+std::string
+CtrlRequestStats::getMethodName(const char* fnName) {
+  std::string method(fnName ? fnName : "unknown");
+  auto pos = method.rfind('.');
+  if (pos != std::string::npos) {
+    method.erase(0, pos + 1);
+  }
+  return method;
+}
+
+void
+CtrlRequestStats::registerMethod(const std::string& method) {
+  if (methods_.rlock()->count(method)) {
+    return;
+  }
+  if (not methods_.wlock()->emplace(method).second) {
+    return;
+  }
+  fb303::fbData->addStatExportType(getCounterName(method), fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      getCounterName(method, "errors"), fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      getCounterName(method, "response_bytes"), fb303::AVG);
+  fb303::fbData->addStatExportType(
+      getCounterName(method, "response_bytes"), fb303::SUM);
+  for (auto const& name : {"latency_us", "queue_us"}) {
+    fb303::fbData->addHistogram(
+        getCounterName(method, name), kLatencyBucketWidthUs, 0, kLatencyMaxUs);
+    fb303::fbData->exportHistogramPercentile(
+        getCounterName(method, name), 50, 95, 99);
+  }
+}
+
+std::string
+CtrlRequestStats::getCallerName(std::string caller) {
+  if (callers_.rlock()->count(caller)) {
+    return caller;
+  }
+  auto callers = callers_.wlock();
+  if (callers->count(caller)) {
+    return caller;
+  }
+  if (callers->size() >= Constants::kCtrlMaxTrackedCallers) {
+    return "other";
+  }
+  callers->emplace(caller);
+  return caller;
+}
+
+void*
+CtrlRequestStats::getContext(
+    const char* fnName, apache::thrift::TConnectionContext* connContext) {
+  auto ctx = std::make_unique<Context>();
+  ctx->method = getMethodName(fnName);
+  registerMethod(ctx->method);
+
+  std::string caller;
+  auto reqContext =
+      dynamic_cast<apache::thrift::Cpp2RequestContext*>(connContext);
+  if (reqContext and reqContext->getConnectionContext()) {
+    caller = reqContext->getConnectionContext()->getPeerCommonName();
+  }
+  if (caller.empty() and connContext and connContext->getPeerAddress()) {
+    caller = connContext->getPeerAddress()->getAddressStr();
+  }
+  ctx->caller = getCallerName(caller.empty() ? "unknown" : std::move(caller));
+
+  // Attach accumulator of event-base queue time to request context, so that
+  // modules the request is dispatched onto can account their queue time
+  folly::RequestContext::get()->overwriteContextData(
+      EvbQueueTime::getToken(), std::make_unique<EvbQueueTime>());
+  ctx->requestContext = folly::RequestContext::saveContext();
+  ctx->readTime = std::chrono::steady_clock::now();
+
+  fb303::fbData->addStatValue(getCounterName(ctx->method), 1, fb303::COUNT);
+  fb303::fbData->addStatValue(
+      folly::sformat("ctrl.caller.{}.requests", ctx->caller), 1, fb303::SUM);
+  return ctx.release();
+}
+
+void
+CtrlRequestStats::freeContext(void* ctx, const char* /* fnName */) {
+  delete static_cast<Context*>(ctx);
+}
+
+void
+CtrlRequestStats::postRead(
+    void* ctx,
+    const char* /* fnName */,
+    apache::thrift::transport::THeader* header,
+    uint32_t /* bytes */) {
+  if (not ctx) {
+    return;
+  }
+  auto* context = static_cast<Context*>(ctx);
+  // Exclude time of reading request from execution time
+  context->readTime = std::chrono::steady_clock::now();
+
+  // Response is written with the same transforms as the request
+  if (header) {
+    auto const& transforms = header->getTransforms();
+    context->zstd = std::find(
+                        transforms.begin(),
+                        transforms.end(),
+                        apache::thrift::transport::THeader::ZSTD_TRANSFORM) !=
+        transforms.end();
+  }
+}
+
+void
+CtrlRequestStats::preWrite(void* ctx, const char* /* fnName */) {
+  if (not ctx) {
+    return;
+  }
+  auto* context = static_cast<Context*>(ctx);
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - context->readTime);
+  fb303::fbData->addHistogramValue(
+      getCounterName(context->method, "latency_us"), latency.count());
+
+  auto* queueTime = context->requestContext
+      ? dynamic_cast<EvbQueueTime*>(context->requestContext->getContextData(
+            EvbQueueTime::getToken()))
+      : nullptr;
+  if (queueTime) {
+    fb303::fbData->addHistogramValue(
+        getCounterName(context->method, "queue_us"),
+        queueTime->getQueueTime().count());
+  }
+}
+
+void
+CtrlRequestStats::postWrite(
+    void* ctx, const char* /* fnName */, uint32_t bytes) {
+  if (not ctx) {
+    return;
+  }
+  auto* context = static_cast<Context*>(ctx);
+  fb303::fbData->addStatValue(
+      getCounterName(context->method, "response_bytes"), bytes);
+  fb303::fbData->addStatValue(
+      folly::sformat("ctrl.caller.{}.response_bytes", context->caller),
+      bytes,
+      fb303::SUM);
+  fb303::fbData->addStatValue(
+      context->zstd and bytes >= Constants::kCtrlMinCompressBytes
+          ? "ctrl.response_bytes.compressed"
+          : "ctrl.response_bytes.raw",
+      bytes,
+      fb303::SUM);
+}
+
+void
+CtrlRequestStats::userExceptionWrapped(
+    void* ctx,
+    const char* /* fnName */,
+    bool /* declared */,
+    const folly::exception_wrapper& /* ew */) {
+  if (not ctx) {
+    return;
+  }
+  fb303::fbData->addStatValue(
+      getCounterName(static_cast<Context*>(ctx)->method, "errors"),
+      1,
+      fb303::COUNT);
+}
+
+} // namespace openr
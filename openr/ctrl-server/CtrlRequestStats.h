@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include <folly/Synchronized.h>
+#include <folly/io/async/Request.h>
+#include <thrift/lib/cpp/TProcessorEventHandler.h>
+
+namespace openr {
+
+/**
+ * Thrift processor event handler recording cost of every request served by
+ * openrCtrl thrift server. Following counters are exported via fb303
+ *
+ * ctrl.request.<method> : Number of requests
+ * ctrl.request.<method>.errors : Number of requests failed with exception
+ * ctrl.request.<method>.latency_us : Histogram of time from request being
+ *    read to response being ready
+ * ctrl.request.<method>.queue_us : Histogram of time the request spent queued
+ *    on module event-bases, part of the above
+ * ctrl.request.<method>.response_bytes : Size of serialized responses
+ * ctrl.caller.<caller>.requests : Number of requests by the caller
+ * ctrl.caller.<caller>.response_bytes : Size of responses to the caller
+ * ctrl.response_bytes.compressed : Serialized size of responses sent zstd
+ *    compressed, i.e. requested by client and of at least
+ *    kCtrlMinCompressBytes
+ * ctrl.response_bytes.raw : Size of responses sent uncompressed
+ *
+ * Caller is identified by peer common name of secure connections, or by peer
+ * address otherwise.
+ */
+class CtrlRequestStats : public apache::thrift::TProcessorEventHandler {
+ public:
+  // Per request context
+  struct Context {
+    std::string method;
+    std::string caller;
+    std::chrono::steady_clock::time_point readTime;
+    std::shared_ptr<folly::RequestContext> requestContext;
+    // client requested zstd compression of the response
+    bool zstd{false};
+  };
+
+  void* getContext(
+      const char* fnName,
+      apache::thrift::TConnectionContext* connContext) override;
+
+  void freeContext(void* ctx, const char* fnName) override;
+
+  void postRead(
+      void* ctx,
+      const char* fnName,
+      apache::thrift::transport::THeader* header,
+      uint32_t bytes) override;
+
+  void preWrite(void* ctx, const char* fnName) override;
+
+  void postWrite(void* ctx, const char* fnName, uint32_t bytes) override;
+
+  void userExceptionWrapped(
+      void* ctx,
+      const char* fnName,
+      bool declared,
+      const folly::exception_wrapper& ew) override;
+
+  // Method name without service prefix,
+  // e.g. "OpenrCtrl.getMyNodeName" -> "getMyNodeName"
+  static std::string getMethodName(const char* fnName);
+
+ private:
+  // Register counters of the method if not yet
+  void registerMethod(const std::string& method);
+
+  // Caller name to account request to, bounded by kCtrlMaxTrackedCallers
+  std::string getCallerName(std::string caller);
+
+  folly::Synchronized<std::unordered_set<std::string>> methods_;
+  folly::Synchronized<std::unordered_set<std::string>> callers_;
+};
+
+} // namespace openr
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
+namespace openr {
+
+/**
+ * Cache of responses of read APIs, keyed by request parameters. Every entry
+ * is tagged with generation of the module data it was read from, and is only
+ * served while the module is at the same generation (and for at most `ttl`
+ * in case any change of the module is missed). Thread-safe.
+ */
+template <typename T>
+class CtrlResponseCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  CtrlResponseCache(std::chrono::milliseconds ttl, size_t maxEntries)
+      : ttl_(ttl), maxEntries_(maxEntries) {}
+
+  // Copy of the cached response if it is of the given generation
+  std::unique_ptr<T>
+  get(const std::string& key, int64_t generation) const {
+    auto entries = entries_.rlock();
+    auto it = entries->find(key);
+    if (it == entries->end() or it->second.generation != generation or
+        it->second.expiry < Clock::now()) {
+      return nullptr;
+    }
+    return std::make_unique<T>(*it->second.response);
+  }
+
+  void
+  put(const std::string& key, int64_t generation, const T& response) {
+    auto entries = entries_.wlock();
+    // Entries of older generations are useless, drop all of them at once
+    // rather than tracking usage of every entry
+    if (entries->size() >= maxEntries_ and not entries->count(key)) {
+      entries->clear();
+    }
+    auto& entry = (*entries)[key];
+    entry.generation = generation;
+    entry.expiry = Clock::now() + ttl_;
+    entry.response = std::make_shared<const T>(response);
+  }
+
+  size_t
+  size() const {
+    return entries_.rlock()->size();
+  }
+
+ private:
+  struct Entry {
+    int64_t generation{0};
+    Clock::time_point expiry;
+    std::shared_ptr<const T> response;
+  };
+
+  const std::chrono::milliseconds ttl_;
+  const size_t maxEntries_{0};
+
+  folly::Synchronized<std::unordered_map<std::string, Entry>> entries_;
+};
+
+} // namespace openr
@@ -9,12 +9,19 @@
 
 #include <re2/re2.h>
 
+#include <fb303/ServiceData.h>
 #include <folly/ExceptionString.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Task.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/ssl/OpenSSLUtils.h>
+#include <thrift/lib/cpp/util/EnumUtils.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/Profiler.h>
 #include <openr/common/Util.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/decision/Decision.h>
@@ -24,6 +31,8 @@
 #include <openr/link-monitor/LinkMonitor.h>
 #include <openr/prefix-manager/PrefixManager.h>
 
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
 OpenrCtrlHandler::OpenrCtrlHandler(
@@ -38,7 +47,9 @@ OpenrCtrlHandler::OpenrCtrlHandler(
     PrefixManager* prefixManager,
     std::shared_ptr<const Config> config,
     MonitorSubmitUrl const& monitorSubmitUrl,
-    fbzmq::Context& context)
+    fbzmq::Context& context,
+    messaging::ReplicateQueue<std::shared_ptr<const Config>>*
+        configUpdatesQueue)
     : facebook::fb303::BaseService("openr"),
       nodeName_(nodeName),
       acceptablePeerCommonNames_(acceptablePeerCommonNames),
@@ -48,11 +59,35 @@ OpenrCtrlHandler::OpenrCtrlHandler(
       linkMonitor_(linkMonitor),
       configStore_(configStore),
       prefixManager_(prefixManager),
-      config_(config) {
+      config_(config),
+      configUpdatesQueue_(configUpdatesQueue),
+      responseExecutor_(std::make_unique<folly::CPUThreadPoolExecutor>(
+          Constants::kCtrlResponseThreads,
+          std::make_shared<folly::NamedThreadFactory>("CtrlResponse"))) {
   // Create monitor client
   zmqMonitorClient_ =
       std::make_unique<fbzmq::ZmqMonitorClient>(context, monitorSubmitUrl);
 
+  // Add fiber task to stream publications buffered for rate-limited KvStore
+  // subscribers
+  if (kvStore_ and config and
+      config->getKvStoreConfig().subscriber_rate_ref().has_value()) {
+    flushTaskFuture_ = ctrlEvb->addFiberTaskFuture([this]() mutable noexcept {
+      LOG(INFO) << "Starting KvStore subscribers flushing fiber";
+      while (not stopFlushBaton_.try_wait_for(
+          Constants::kFloodPendingPublication)) {
+        SYNCHRONIZED(kvStorePublishers_) {
+          for (auto& kv : kvStorePublishers_) {
+            if (kv.second->hasBufferedKeys()) {
+              kv.second->flush();
+            }
+          }
+        }
+      }
+      LOG(INFO) << "Terminating KvStore subscribers flushing fiber";
+    });
+  }
+
   // Add fiber task to receive publication from KvStore
   if (kvStore_) {
     taskFuture_ = ctrlEvb->addFiberTaskFuture([
@@ -68,15 +103,40 @@ OpenrCtrlHandler::OpenrCtrlHandler(
           break;
         }
 
+        // invalidate cached KvStore responses
+        ++kvStoreGeneration_;
+
+        // NOTE: Slow subscribers are completed outside of lock, see dtor
+        std::vector<std::unique_ptr<KvStorePublisher>> slowPublishers;
         SYNCHRONIZED(kvStorePublishers_) {
-          for (auto& kv : kvStorePublishers_) {
-            kv.second->publish(maybePublication.value());
+          // Match publication once per distinct filter of subscribers
+          for (const auto clientToken :
+               kvStoreSubscriberIndex_.getMatchingSubscribers(
+                   *maybePublication.value())) {
+            auto it = kvStorePublishers_.find(clientToken);
+            if (it == kvStorePublishers_.end() or
+                it->second->publishMatched(*maybePublication.value())) {
+              continue;
+            }
+            LOG(WARNING) << "Disconnecting slow KvStore snoop stream-"
+                         << clientToken << " with "
+                         << it->second->getNumBufferedKeys()
+                         << " keys buffered.";
+            slowPublishers.emplace_back(std::move(it->second));
+            kvStorePublishers_.erase(it);
+            kvStoreSubscriberIndex_.removeSubscriber(clientToken);
           }
         }
+        for (auto& publisher : slowPublishers) {
+          fb303::fbData->addStatValue(
+              "ctrl.kvstore.slow_subscriber_disconnected", 1, fb303::COUNT);
+          publisher->complete(
+              "Too many publications buffered for slow KvStore subscriber");
+        }
 
         bool isAdjChanged = false;
         // check if any of KeyVal has 'adj' update
-        for (auto& kv : maybePublication.value().keyVals) {
+        for (auto& kv : maybePublication.value()->keyVals) {
           auto& key = kv.first;
           auto& val = kv.second;
           // check if we have any value update.
@@ -93,40 +153,96 @@ OpenrCtrlHandler::OpenrCtrlHandler(
           }
         }
 
-        if (isAdjChanged) {
-          // thrift::Publication contains "adj:*" key change.
-          // Clean ALL pending promises
-          longPollReqs_.withWLock([&](auto& longPollReqs) {
+        // check if any 'adj' key has expired
+        for (auto& key : maybePublication.value()->expiredKeys) {
+          if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+            VLOG(3) << "Adj key: " << key << " expiry received";
+            isAdjChanged = true;
+            break;
+          }
+        }
+
+        longPollReqs_.withWLock([&](auto& longPollReqs) {
+          if (isAdjChanged) {
+            // thrift::Publication contains "adj:*" key change. Every pending
+            // request waits for the next change, clean ALL of them
+            ++adjChangeSeqNum_;
             for (auto& kv : longPollReqs) {
-              auto& p = kv.second.first;
-              p.setValue(true);
+              kv.second.first.setValue(adjChangeSeqNum_);
             }
             longPollReqs.clear();
-          });
-        } else {
-          longPollReqs_.withWLock([&](auto& longPollReqs) {
-            auto now = getUnixTimeStampMs();
-            std::vector<int64_t> reqsToClean;
-            for (auto& kv : longPollReqs) {
-              auto& clientId = kv.first;
-              auto& req = kv.second;
-
-              auto& p = req.first;
-              auto& timeStamp = req.second;
-              if (now - timeStamp >= Constants::kLongPollReqHoldTime.count()) {
-                LOG(INFO) << "Elapsed time: " << now - timeStamp
-                          << " is over hold limit: "
-                          << Constants::kLongPollReqHoldTime.count();
-                reqsToClean.emplace_back(clientId);
-                p.setValue(false);
-              }
-            }
+            return;
+          }
 
-            // cleanup expired requests since no ADJ change observed
-            for (auto& clientId : reqsToClean) {
-              longPollReqs.erase(clientId);
+          // Requests are ordered by arrival, cleanup expired ones from the
+          // oldest since no ADJ change observed
+          auto now = getUnixTimeStampMs();
+          while (not longPollReqs.empty()) {
+            auto it = longPollReqs.begin();
+            auto& timeStamp = it->second.second;
+            if (now - timeStamp < Constants::kLongPollReqHoldTime.count()) {
+              break;
             }
-          });
+            LOG(INFO) << "Elapsed time: " << now - timeStamp
+                      << " is over hold limit: "
+                      << Constants::kLongPollReqHoldTime.count();
+            it->second.first.setValue(adjChangeSeqNum_);
+            longPollReqs.erase(it);
+          }
+        });
+      }
+    });
+  }
+
+  // Add fiber task to receive route updates from Fib
+  if (fib_) {
+    fibTaskFuture_ = ctrlEvb->addFiberTaskFuture([
+      q = std::move(fib_->getFibUpdatesReader()),
+      this
+    ]() mutable noexcept {
+      LOG(INFO) << "Starting Fib updates processing fiber";
+      while (true) {
+        auto maybeRouteDelta = q.get(); // perform read
+        VLOG(2) << "Received route updates from Fib";
+        if (maybeRouteDelta.hasError()) {
+          LOG(INFO) << "Terminating Fib route updates processing fiber";
+          break;
+        }
+
+        // invalidate cached Fib responses
+        ++fibGeneration_;
+
+        SYNCHRONIZED(fibPublishers_) {
+          for (auto& kv : fibPublishers_) {
+            kv.second.next(maybeRouteDelta.value());
+          }
+        }
+      }
+    });
+  }
+
+  // Add fiber task to receive adjacency/prefix database updates from Decision
+  if (decision_) {
+    decisionTaskFuture_ = ctrlEvb->addFiberTaskFuture([
+      q = std::move(decision_->getDecisionDbsUpdatesReader()),
+      this
+    ]() mutable noexcept {
+      LOG(INFO) << "Starting Decision updates processing fiber";
+      while (true) {
+        auto maybeDbsDelta = q.get(); // perform read
+        VLOG(2) << "Received database updates from Decision";
+        if (maybeDbsDelta.hasError()) {
+          LOG(INFO) << "Terminating Decision updates processing fiber";
+          break;
+        }
+
+        // invalidate cached Decision responses
+        ++decisionGeneration_;
+
+        SYNCHRONIZED(decisionDbsPublishers_) {
+          for (auto& kv : decisionDbsPublishers_) {
+            kv.second.next(maybeDbsDelta.value());
+          }
         }
       }
     });
@@ -152,11 +268,72 @@ OpenrCtrlHandler::~OpenrCtrlHandler() {
     publisher->complete();
   }
 
+  // NOTE: Same as above, complete fib publishers outside of lock
+  std::vector<apache::thrift::ServerStreamPublisher<thrift::RouteDatabaseDelta>>
+      fibPublishers;
+  SYNCHRONIZED(fibPublishers_) {
+    for (auto& kv : fibPublishers_) {
+      fibPublishers.emplace_back(std::move(kv.second));
+    }
+  }
+  LOG(INFO) << "Terminating " << fibPublishers.size()
+            << " active Fib snoop stream(s).";
+  for (auto& publisher : fibPublishers) {
+    std::move(publisher).complete();
+  }
+
+  std::vector<apache::thrift::ServerStreamPublisher<thrift::DecisionDbsDelta>>
+      decisionDbsPublishers;
+  SYNCHRONIZED(decisionDbsPublishers_) {
+    for (auto& kv : decisionDbsPublishers_) {
+      decisionDbsPublishers.emplace_back(std::move(kv.second));
+    }
+  }
+  LOG(INFO) << "Terminating " << decisionDbsPublishers.size()
+            << " active Decision snoop stream(s).";
+  for (auto& publisher : decisionDbsPublishers) {
+    std::move(publisher).complete();
+  }
+
+  if (flushTaskFuture_.valid()) {
+    LOG(INFO) << "Waiting for termination of KvStore subscribers flushing.";
+    stopFlushBaton_.post();
+    flushTaskFuture_.wait();
+  }
+
+  LOG(INFO) << "Waiting for termination of in-flight response(s).";
+  responseExecutor_->join();
+
   LOG(INFO) << "Cleanup all pending request(s).";
   longPollReqs_.withWLock([&](auto& longPollReqs) { longPollReqs.clear(); });
 
   LOG(INFO) << "Waiting for termination of kvStoreUpdatesQueue.";
   taskFuture_.wait();
+
+  if (fibTaskFuture_.valid()) {
+    LOG(INFO) << "Waiting for termination of fibUpdatesQueue.";
+    fibTaskFuture_.wait();
+  }
+
+  if (decisionTaskFuture_.valid()) {
+    LOG(INFO) << "Waiting for termination of decisionDbsUpdatesQueue.";
+    decisionTaskFuture_.wait();
+  }
+}
+
+template <typename F>
+folly::Future<typename folly::invoke_result_t<F>::value_type>
+OpenrCtrlHandler::offloadResponse(const char* api, F&& buildFn) {
+  fb303::fbData->addStatValue(
+      folly::sformat("ctrl.offloaded_responses.{}", api), 1, fb303::COUNT);
+  return folly::via(responseExecutor_.get(), std::forward<F>(buildFn));
+}
+
+std::unique_ptr<apache::thrift::AsyncProcessor>
+OpenrCtrlHandler::getProcessor() {
+  auto processor = thrift::OpenrCtrlCppSvIf::getProcessor();
+  processor->addEventHandler(requestStats_);
+  return processor;
 }
 
 void
@@ -305,14 +482,71 @@ OpenrCtrlHandler::dryrunConfig(
   }
 }
 
+void
+OpenrCtrlHandler::reloadConfig(
+    std::string& _return, std::unique_ptr<std::string> file) {
+  authorizeConnection();
+  if (not configUpdatesQueue_) {
+    throw thrift::OpenrError("Config reload is not supported");
+  }
+  auto config = config_.wlock();
+  std::shared_ptr<const Config> newConfig;
+  try {
+    newConfig = std::make_shared<const Config>(*file);
+    (*config)->checkReloadable(*newConfig);
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+  LOG(INFO) << "Reloading config from " << *file;
+  *config = newConfig;
+  configUpdatesQueue_->push(newConfig);
+  _return = newConfig->getRunningConfig();
+}
+
 void
 OpenrCtrlHandler::getRunningConfig(std::string& _return) {
-  _return = config_->getRunningConfig();
+  _return = (*config_.rlock())->getRunningConfig();
 }
 
 void
 OpenrCtrlHandler::getRunningConfigThrift(thrift::OpenrConfig& _config) {
-  _config = config_->getConfig();
+  _config = (*config_.rlock())->getConfig();
+}
+
+//
+// Profiling APIs
+//
+void
+OpenrCtrlHandler::startCpuProfile(int32_t durationMs, int32_t frequencyHz) {
+  authorizeConnection();
+  if (durationMs <= 0 or frequencyHz <= 0) {
+    throw thrift::OpenrError("Profile duration and frequency must be positive");
+  }
+  try {
+    openr::startCpuProfile(std::chrono::milliseconds(durationMs), frequencyHz);
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+}
+
+void
+OpenrCtrlHandler::stopCpuProfile(std::string& _return) {
+  authorizeConnection();
+  try {
+    _return = openr::stopCpuProfile();
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+}
+
+void
+OpenrCtrlHandler::getHeapProfile(std::string& _return) {
+  authorizeConnection();
+  try {
+    _return = dumpHeapProfile();
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
 }
 
 //
@@ -351,6 +585,67 @@ OpenrCtrlHandler::semifuture_syncPrefixesByType(
       .defer([](folly::Try<bool>&&) { return folly::Unit(); });
 }
 
+namespace {
+
+// Apply streamed batches as they arrive. Next batch is handed to
+// PrefixManager before waiting for the previous one, to keep PrefixManager
+// busy without queueing up batches beyond flow control of the sink
+folly::coro::Task<thrift::PrefixUpdateAck>
+consumePrefixUpdates(
+    PrefixManager* prefixManager,
+    thrift::PrefixType prefixType,
+    thrift::PrefixUpdateAck ack,
+    folly::coro::AsyncGenerator<thrift::PrefixUpdateBatch&&> batches) {
+  std::optional<folly::SemiFuture<int64_t>> pending;
+  while (auto batch = co_await batches.next()) {
+    auto next =
+        prefixManager->applyPrefixUpdateBatch(prefixType, std::move(*batch));
+    if (pending.has_value()) {
+      ack.seqNum = co_await std::move(*pending);
+    }
+    pending = std::move(next);
+  }
+  if (pending.has_value()) {
+    ack.seqNum = co_await std::move(*pending);
+  }
+  co_return ack;
+}
+
+} // namespace
+
+folly::SemiFuture<apache::thrift::ResponseAndSinkConsumer<
+    thrift::PrefixUpdateAck,
+    thrift::PrefixUpdateBatch,
+    thrift::PrefixUpdateAck>>
+OpenrCtrlHandler::semifuture_streamPrefixUpdates(
+    thrift::PrefixType prefixType) {
+  CHECK(prefixManager_);
+  return prefixManager_->getPrefixUpdateSeqNum(prefixType)
+      .deferValue([prefixManager = prefixManager_, prefixType](
+                      int64_t seqNum) {
+        LOG(INFO) << "Prefix update stream of type "
+                  << apache::thrift::util::enumNameSafe(prefixType)
+                  << " started, last applied batch " << seqNum;
+        thrift::PrefixUpdateAck ack;
+        ack.seqNum = seqNum;
+        auto consumer = [prefixManager, prefixType, ack](
+                            folly::coro::AsyncGenerator<
+                                thrift::PrefixUpdateBatch&&> batches) {
+          return consumePrefixUpdates(
+              prefixManager, prefixType, ack, std::move(batches));
+        };
+        return apache::thrift::ResponseAndSinkConsumer<
+            thrift::PrefixUpdateAck,
+            thrift::PrefixUpdateBatch,
+            thrift::PrefixUpdateAck>{
+            std::move(ack),
+            apache::thrift::SinkConsumer<
+                thrift::PrefixUpdateBatch,
+                thrift::PrefixUpdateAck>{
+                std::move(consumer), Constants::kPrefixUpdateSinkBufferSize}};
+      });
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::PrefixEntry>>>
 OpenrCtrlHandler::semifuture_getPrefixes() {
   CHECK(prefixManager_);
@@ -369,7 +664,16 @@ OpenrCtrlHandler::semifuture_getPrefixesByType(thrift::PrefixType prefixType) {
 folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
 OpenrCtrlHandler::semifuture_getRouteDb() {
   CHECK(fib_);
-  return fib_->getRouteDb();
+  const int64_t generation = fibGeneration_;
+  if (auto routeDb = routeDbCache_.get("", generation)) {
+    fb303::fbData->addStatValue("ctrl.cache.route_db.hit", 1, fb303::COUNT);
+    return folly::makeSemiFuture(std::move(routeDb));
+  }
+  return fib_->getRouteDb().deferValue(
+      [this, generation](std::unique_ptr<thrift::RouteDatabase> routeDb) {
+        routeDbCache_.put("", generation, *routeDb);
+        return routeDb;
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
@@ -399,12 +703,105 @@ OpenrCtrlHandler::semifuture_getMplsRoutesFiltered(
   return fib_->getMplsRoutes(std::move(*labels));
 }
 
+folly::Future<std::unique_ptr<thrift::RouteDatabase>>
+OpenrCtrlHandler::future_getRouteDb() {
+  return offloadResponse(
+      "route_db", [this]() { return semifuture_getRouteDb(); });
+}
+
+folly::Future<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
+OpenrCtrlHandler::future_getUnicastRoutesFiltered(
+    std::unique_ptr<std::vector<std::string>> prefixes) {
+  return offloadResponse(
+      "unicast_routes", [this, prefixes = std::move(prefixes)]() mutable {
+        return semifuture_getUnicastRoutesFiltered(std::move(prefixes));
+      });
+}
+
+folly::Future<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
+OpenrCtrlHandler::future_getUnicastRoutes() {
+  return offloadResponse(
+      "unicast_routes", [this]() { return semifuture_getUnicastRoutes(); });
+}
+
+folly::Future<std::unique_ptr<std::vector<thrift::MplsRoute>>>
+OpenrCtrlHandler::future_getMplsRoutesFiltered(
+    std::unique_ptr<std::vector<int32_t>> labels) {
+  return offloadResponse(
+      "mpls_routes", [this, labels = std::move(labels)]() mutable {
+        return semifuture_getMplsRoutesFiltered(std::move(labels));
+      });
+}
+
+folly::Future<std::unique_ptr<std::vector<thrift::MplsRoute>>>
+OpenrCtrlHandler::future_getMplsRoutes() {
+  return offloadResponse(
+      "mpls_routes", [this]() { return semifuture_getMplsRoutes(); });
+}
+
+apache::thrift::ServerStream<thrift::RouteDatabaseDelta>
+OpenrCtrlHandler::subscribeFib() {
+  // Get new client-ID (monotonically increasing)
+  auto clientToken = publisherToken_++;
+
+  auto streamAndPublisher =
+      apache::thrift::ServerStream<thrift::RouteDatabaseDelta>::createPublisher(
+          [this, clientToken]() {
+            SYNCHRONIZED(fibPublishers_) {
+              if (fibPublishers_.erase(clientToken)) {
+                LOG(INFO) << "Fib snoop stream-" << clientToken << " ended.";
+              } else {
+                LOG(ERROR) << "Can't remove unknown Fib snoop stream-"
+                           << clientToken;
+              }
+            }
+          });
+
+  SYNCHRONIZED(fibPublishers_) {
+    assert(fibPublishers_.count(clientToken) == 0);
+    LOG(INFO) << "Fib snoop stream-" << clientToken << " started.";
+    fibPublishers_.emplace(clientToken, std::move(streamAndPublisher.second));
+  }
+  return std::move(streamAndPublisher.first);
+}
+
+folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+    thrift::RouteDatabase,
+    thrift::RouteDatabaseDelta>>
+OpenrCtrlHandler::semifuture_subscribeAndGetFib() {
+  CHECK(fib_);
+  // Subscribe before retrieving snapshot so that no update is lost
+  auto stream = subscribeFib();
+  return fib_->getRouteDb().defer(
+      [stream = std::move(stream)](
+          folly::Try<std::unique_ptr<thrift::RouteDatabase>>&& db) mutable {
+        db.throwIfFailed();
+        return apache::thrift::ResponseAndServerStream<
+            thrift::RouteDatabase,
+            thrift::RouteDatabaseDelta>{std::move(*db.value()),
+                                        std::move(stream)};
+      });
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
 OpenrCtrlHandler::semifuture_getPerfDb() {
   CHECK(fib_);
   return fib_->getPerfDb();
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
+OpenrCtrlHandler::semifuture_getConvergenceTrace(
+    std::unique_ptr<std::string> traceId) {
+  CHECK(fib_);
+  return fib_->getConvergenceTrace(std::move(*traceId));
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::ConvergenceStats>>>
+OpenrCtrlHandler::semifuture_getConvergenceStats() {
+  CHECK(fib_);
+  return fib_->getConvergenceStats();
+}
+
 //
 // Decision APIs
 //
@@ -415,10 +812,28 @@ OpenrCtrlHandler::semifuture_getRouteDbComputed(
   return decision_->getDecisionRouteDb(*nodeName);
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::RouteDatabaseDelta>>
+OpenrCtrlHandler::semifuture_getRouteDbDeltaWhatIf(
+    std::unique_ptr<std::string> nodeName,
+    std::unique_ptr<std::vector<thrift::TopologyChange>> changes) {
+  CHECK(decision_);
+  return decision_->getDecisionRouteDbDeltaWhatIf(
+      std::move(*nodeName), std::move(*changes));
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>>
 OpenrCtrlHandler::semifuture_getDecisionAdjacencyDbs() {
   CHECK(decision_);
-  return decision_->getDecisionAdjacencyDbs();
+  const int64_t generation = decisionGeneration_;
+  if (auto adjDbs = adjDbsCache_.get("", generation)) {
+    fb303::fbData->addStatValue("ctrl.cache.adj_dbs.hit", 1, fb303::COUNT);
+    return folly::makeSemiFuture(std::move(adjDbs));
+  }
+  return decision_->getDecisionAdjacencyDbs().deferValue(
+      [this, generation](std::unique_ptr<thrift::AdjDbs> adjDbs) {
+        adjDbsCache_.put("", generation, *adjDbs);
+        return adjDbs;
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
@@ -433,6 +848,52 @@ OpenrCtrlHandler::semifuture_getDecisionPrefixDbs() {
   return decision_->getDecisionPrefixDbs();
 }
 
+apache::thrift::ServerStream<thrift::DecisionDbsDelta>
+OpenrCtrlHandler::subscribeDecisionDbs() {
+  // Get new client-ID (monotonically increasing)
+  auto clientToken = publisherToken_++;
+
+  auto streamAndPublisher =
+      apache::thrift::ServerStream<thrift::DecisionDbsDelta>::createPublisher(
+          [this, clientToken]() {
+            SYNCHRONIZED(decisionDbsPublishers_) {
+              if (decisionDbsPublishers_.erase(clientToken)) {
+                LOG(INFO) << "Decision snoop stream-" << clientToken
+                          << " ended.";
+              } else {
+                LOG(ERROR) << "Can't remove unknown Decision snoop stream-"
+                           << clientToken;
+              }
+            }
+          });
+
+  SYNCHRONIZED(decisionDbsPublishers_) {
+    assert(decisionDbsPublishers_.count(clientToken) == 0);
+    LOG(INFO) << "Decision snoop stream-" << clientToken << " started.";
+    decisionDbsPublishers_.emplace(
+        clientToken, std::move(streamAndPublisher.second));
+  }
+  return std::move(streamAndPublisher.first);
+}
+
+folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+    thrift::DecisionDbs,
+    thrift::DecisionDbsDelta>>
+OpenrCtrlHandler::semifuture_subscribeAndGetDecisionDbs() {
+  CHECK(decision_);
+  // Subscribe before retrieving snapshot so that no update is lost
+  auto stream = subscribeDecisionDbs();
+  return decision_->getDecisionDbs().defer(
+      [stream = std::move(stream)](
+          folly::Try<std::unique_ptr<thrift::DecisionDbs>>&& dbs) mutable {
+        dbs.throwIfFailed();
+        return apache::thrift::ResponseAndServerStream<
+            thrift::DecisionDbs,
+            thrift::DecisionDbsDelta>{std::move(*dbs.value()),
+                                      std::move(stream)};
+      });
+}
+
 //
 // KvStore APIs
 //
@@ -467,7 +928,20 @@ folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 OpenrCtrlHandler::semifuture_getKvStoreKeyValsFiltered(
     std::unique_ptr<thrift::KeyDumpParams> filter) {
   CHECK(kvStore_);
-  return kvStore_->dumpKvStoreKeys(std::move(*filter));
+  const int64_t generation = kvStoreGeneration_;
+  auto cacheKey =
+      apache::thrift::CompactSerializer::serialize<std::string>(*filter);
+  if (auto pub = kvStoreKeyValsCache_.get(cacheKey, generation)) {
+    fb303::fbData->addStatValue(
+        "ctrl.cache.kvstore_keys.hit", 1, fb303::COUNT);
+    return folly::makeSemiFuture(std::move(pub));
+  }
+  return kvStore_->dumpKvStoreKeys(std::move(*filter))
+      .deferValue([this, generation, cacheKey = std::move(cacheKey)](
+                      std::unique_ptr<thrift::Publication> pub) {
+        kvStoreKeyValsCache_.put(cacheKey, generation, *pub);
+        return pub;
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
@@ -478,6 +952,52 @@ OpenrCtrlHandler::semifuture_getKvStoreKeyValsFilteredArea(
   return kvStore_->dumpKvStoreKeys(std::move(*filter), std::move(*area));
 }
 
+folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::Publication>>>
+OpenrCtrlHandler::semifuture_getKvStoreKeyValsFilteredAreas(
+    std::unique_ptr<thrift::KeyDumpParams> filter,
+    std::unique_ptr<std::set<std::string>> areas) {
+  CHECK(kvStore_);
+  return kvStore_->dumpKvStoreKeysAreas(std::move(*filter), std::move(*areas));
+}
+
+//
+// NOTE: KvStore dumps are built on the executor only with snapshot reads
+// enabled, otherwise the dump is still built on the KvStore thread of the area
+// and only serialized on the executor
+//
+folly::Future<std::unique_ptr<thrift::Publication>>
+OpenrCtrlHandler::future_getKvStoreKeyValsFiltered(
+    std::unique_ptr<thrift::KeyDumpParams> filter) {
+  return offloadResponse(
+      "kvstore_keys", [this, filter = std::move(filter)]() mutable {
+        return semifuture_getKvStoreKeyValsFiltered(std::move(filter));
+      });
+}
+
+folly::Future<std::unique_ptr<thrift::Publication>>
+OpenrCtrlHandler::future_getKvStoreKeyValsFilteredArea(
+    std::unique_ptr<thrift::KeyDumpParams> filter,
+    std::unique_ptr<std::string> area) {
+  return offloadResponse(
+      "kvstore_keys",
+      [this, filter = std::move(filter), area = std::move(area)]() mutable {
+        return semifuture_getKvStoreKeyValsFilteredArea(
+            std::move(filter), std::move(area));
+      });
+}
+
+folly::Future<std::unique_ptr<std::map<std::string, thrift::Publication>>>
+OpenrCtrlHandler::future_getKvStoreKeyValsFilteredAreas(
+    std::unique_ptr<thrift::KeyDumpParams> filter,
+    std::unique_ptr<std::set<std::string>> areas) {
+  return offloadResponse(
+      "kvstore_keys",
+      [this, filter = std::move(filter), areas = std::move(areas)]() mutable {
+        return semifuture_getKvStoreKeyValsFilteredAreas(
+            std::move(filter), std::move(areas));
+      });
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 OpenrCtrlHandler::semifuture_getKvStoreHashFiltered(
     std::unique_ptr<thrift::KeyDumpParams> filter) {
@@ -498,7 +1018,37 @@ OpenrCtrlHandler::semifuture_setKvStoreKeyVals(
     std::unique_ptr<thrift::KeySetParams> setParams,
     std::unique_ptr<std::string> area) {
   CHECK(kvStore_);
-  return kvStore_->setKvStoreKeyVals(std::move(*setParams), std::move(*area));
+  return kvStore_->setKvStoreKeyVals(std::move(*setParams), std::move(*area))
+      .deferValue([this](folly::Unit) {
+        // reads after the write must not be served from cache
+        ++kvStoreGeneration_;
+      });
+}
+
+folly::SemiFuture<int64_t>
+OpenrCtrlHandler::waitForAdjChange(int64_t seqNum) {
+  folly::Promise<int64_t> p;
+  auto sf = p.getSemiFuture();
+
+  auto timeStamp = getUnixTimeStampMs();
+  auto requestId = pendingRequestId_++;
+
+  longPollReqs_.withWLock([&](auto& longPollReqs) {
+    // sequence number is stale (or from before restart)
+    if (seqNum != adjChangeSeqNum_) {
+      VLOG(3) << "AdjKey has changed. Notify immediately";
+      p.setValue(adjChangeSeqNum_);
+      return;
+    }
+    VLOG(3) << "Store req as pending request";
+    longPollReqs.emplace(requestId, std::make_pair(std::move(p), timeStamp));
+  });
+  return sf;
+}
+
+folly::SemiFuture<int64_t>
+OpenrCtrlHandler::semifuture_longPollKvStoreAdjChange(int64_t seqNum) {
+  return waitForAdjChange(seqNum);
 }
 
 folly::SemiFuture<bool>
@@ -507,8 +1057,8 @@ OpenrCtrlHandler::semifuture_longPollKvStoreAdj(
   folly::Promise<bool> p;
   auto sf = p.getSemiFuture();
 
-  auto timeStamp = getUnixTimeStampMs();
-  auto requestId = pendingRequestId_++;
+  // Adjacency changes after this point will wake up the request
+  const int64_t seqNum = adjChangeSeqNum_;
 
   thrift::KeyDumpParams params;
 
@@ -529,9 +1079,8 @@ OpenrCtrlHandler::semifuture_longPollKvStoreAdj(
   // Explicitly do SYNC call to KvStore
   std::unique_ptr<thrift::Publication> thriftPub{nullptr};
   try {
-    thriftPub = semifuture_getKvStoreKeyValsFiltered(
-                    std::make_unique<thrift::KeyDumpParams>(params))
-                    .get();
+    // NOTE: Bypass response cache, snapshot must be compared with latest
+    thriftPub = kvStore_->dumpKvStoreKeys(std::move(params)).get();
   } catch (std::exception const& ex) {
     p.setException(thrift::OpenrError(ex.what()));
     return sf;
@@ -549,10 +1098,9 @@ OpenrCtrlHandler::semifuture_longPollKvStoreAdj(
     // Client provided data is consistent with KvStore.
     // Store req for future processing when there is publication
     // from KvStore.
-    VLOG(3) << "No adj change detected. Store req as pending request";
-    longPollReqs_.withWLock([&](auto& longPollReq) {
-      longPollReq.emplace(requestId, std::make_pair(std::move(p), timeStamp));
-    });
+    VLOG(3) << "No adj change detected";
+    return waitForAdjChange(seqNum).deferValue(
+        [seqNum](int64_t newSeqNum) { return newSeqNum != seqNum; });
   }
   return sf;
 }
@@ -595,6 +1143,13 @@ OpenrCtrlHandler::semifuture_getKvStorePeersArea(
   return kvStore_->getKvStorePeers(std::move(*area));
 }
 
+folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::PeersMap>>>
+OpenrCtrlHandler::semifuture_getKvStorePeersAreas(
+    std::unique_ptr<std::set<std::string>> areas) {
+  CHECK(kvStore_);
+  return kvStore_->getKvStorePeersAreas(std::move(*areas));
+}
+
 apache::thrift::ServerStream<thrift::Publication>
 OpenrCtrlHandler::subscribeKvStoreFilter(
     std::unique_ptr<thrift::KvFilter> filter) {
@@ -605,6 +1160,7 @@ OpenrCtrlHandler::subscribeKvStoreFilter(
       apache::thrift::ServerStream<thrift::Publication>::createPublisher(
           [this, clientToken]() {
             SYNCHRONIZED(kvStorePublishers_) {
+              kvStoreSubscriberIndex_.removeSubscriber(clientToken);
               if (kvStorePublishers_.erase(clientToken)) {
                 LOG(INFO) << "KvStore snoop stream-" << clientToken
                           << " ended.";
@@ -618,8 +1174,22 @@ OpenrCtrlHandler::subscribeKvStoreFilter(
   SYNCHRONIZED(kvStorePublishers_) {
     assert(kvStorePublishers_.count(clientToken) == 0);
     LOG(INFO) << "KvStore snoop stream-" << clientToken << " started.";
+    std::optional<thrift::KvstoreFloodRate> rate;
+    size_t maxBufferedKeys{0};
+    if (auto config = *config_.rlock()) {
+      const auto& kvConf = config->getKvStoreConfig();
+      if (kvConf.subscriber_rate_ref().has_value()) {
+        rate = *kvConf.subscriber_rate_ref();
+      }
+      maxBufferedKeys = kvConf.subscriber_max_buffered_keys;
+    }
+    kvStoreSubscriberIndex_.addSubscriber(clientToken, *filter);
     auto kvStorePublisher = std::make_unique<KvStorePublisher>(
-        std::move(*filter), std::move(streamAndPublisher.second));
+        std::move(*filter),
+        std::move(streamAndPublisher.second),
+        clientToken,
+        rate,
+        maxBufferedKeys);
     kvStorePublishers_.emplace(clientToken, std::move(kvStorePublisher));
   }
   return std::move(streamAndPublisher.first);
@@ -638,6 +1208,7 @@ folly::SemiFuture<apache::thrift::ResponseAndServerStream<
     thrift::Publication>>
 OpenrCtrlHandler::semifuture_subscribeAndGetKvStoreFiltered(
     std::unique_ptr<thrift::KvFilter> filter) {
+  CHECK(kvStore_);
   thrift::KeyDumpParams params;
   if (filter->keys_ref().has_value() && (*filter->keys_ref()).size()) {
     folly::join(",", *filter->keys_ref(), params.prefix);
@@ -652,8 +1223,8 @@ OpenrCtrlHandler::semifuture_subscribeAndGetKvStoreFiltered(
     params.oper_ref() = std::move(*filter->oper_ref());
   }
 
-  return semifuture_getKvStoreKeyValsFiltered(
-             std::make_unique<thrift::KeyDumpParams>(params))
+  // NOTE: Bypass response cache, snapshot must be consistent with the stream
+  return kvStore_->dumpKvStoreKeys(std::move(params))
       .defer(
           [stream = subscribeKvStoreFilter(std::move(filter))](
               folly::Try<std::unique_ptr<thrift::Publication>>&& pub) mutable {
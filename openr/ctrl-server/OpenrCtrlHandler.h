@@ -10,15 +10,22 @@
 #include <fb303/BaseService.h>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/fibers/Baton.h>
+#include <openr/common/Constants.h>
 #include <openr/common/Types.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
+#include <openr/ctrl-server/CtrlRequestStats.h>
+#include <openr/ctrl-server/CtrlResponseCache.h>
 #include <openr/decision/Decision.h>
 #include <openr/fib/Fib.h>
 #include <openr/if/gen-cpp2/OpenrCtrlCpp.h>
 #include <openr/kvstore/KvStore.h>
 #include <openr/kvstore/KvStorePublisher.h>
+#include <openr/kvstore/KvStoreSubscriberIndex.h>
 #include <openr/link-monitor/LinkMonitor.h>
+#include <openr/messaging/ReplicateQueue.h>
 #include <openr/prefix-manager/PrefixManager.h>
 
 namespace openr {
@@ -41,10 +48,16 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       PrefixManager* prefixManager,
       std::shared_ptr<const Config> config,
       MonitorSubmitUrl const& monitorSubmitUrl,
-      fbzmq::Context& context);
+      fbzmq::Context& context,
+      // Queue for publishing reloaded config, reload is rejected without it
+      messaging::ReplicateQueue<std::shared_ptr<const Config>>*
+          configUpdatesQueue = nullptr);
 
   ~OpenrCtrlHandler() override;
 
+  // Processor instrumented with per request stats
+  std::unique_ptr<apache::thrift::AsyncProcessor> getProcessor() override;
+
   //
   // fb303 service APIs
   //
@@ -74,6 +87,19 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   void dryrunConfig(
       ::std::string& _return, std::unique_ptr<::std::string> file) override;
 
+  void reloadConfig(
+      ::std::string& _return, std::unique_ptr<::std::string> file) override;
+
+  //
+  // Profiling APIs
+  //
+
+  void startCpuProfile(int32_t durationMs, int32_t frequencyHz) override;
+
+  void stopCpuProfile(std::string& _return) override;
+
+  void getHeapProfile(std::string& _return) override;
+
   //
   // ZMQ Monitor APIs
   //
@@ -104,6 +130,12 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::PrefixEntry>>>
   semifuture_getPrefixesByType(thrift::PrefixType prefixType) override;
 
+  folly::SemiFuture<apache::thrift::ResponseAndSinkConsumer<
+      thrift::PrefixUpdateAck,
+      thrift::PrefixUpdateBatch,
+      thrift::PrefixUpdateAck>>
+  semifuture_streamPrefixUpdates(thrift::PrefixType prefixType) override;
+
   //
   // Fib APIs
   //
@@ -125,6 +157,15 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<std::vector<openr::thrift::MplsRoute>>>
   semifuture_getMplsRoutes() override;
 
+  // Intentionally not use SemiFuture as stream is async by nature and we will
+  // immediately create and return the stream handler
+  apache::thrift::ServerStream<thrift::RouteDatabaseDelta> subscribeFib();
+
+  folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+      thrift::RouteDatabase,
+      thrift::RouteDatabaseDelta>>
+  semifuture_subscribeAndGetFib() override;
+
   //
   // Performance stats APIs
   //
@@ -132,6 +173,12 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
   semifuture_getPerfDb() override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
+  semifuture_getConvergenceTrace(std::unique_ptr<std::string> traceId) override;
+
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::ConvergenceStats>>>
+  semifuture_getConvergenceStats() override;
+
   //
   // Decision APIs
   //
@@ -145,9 +192,23 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>>
   semifuture_getDecisionPrefixDbs() override;
 
+  // Intentionally not use SemiFuture as stream is async by nature and we will
+  // immediately create and return the stream handler
+  apache::thrift::ServerStream<thrift::DecisionDbsDelta> subscribeDecisionDbs();
+
+  folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+      thrift::DecisionDbs,
+      thrift::DecisionDbsDelta>>
+  semifuture_subscribeAndGetDecisionDbs() override;
+
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
   semifuture_getRouteDbComputed(std::unique_ptr<std::string> nodeName) override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::RouteDatabaseDelta>>
+  semifuture_getRouteDbDeltaWhatIf(
+      std::unique_ptr<std::string> nodeName,
+      std::unique_ptr<std::vector<thrift::TopologyChange>> changes) override;
+
   //
   // KvStore APIs
   //
@@ -172,6 +233,11 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       std::unique_ptr<thrift::KeyDumpParams> filter,
       std::unique_ptr<std::string> area) override;
 
+  folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::Publication>>>
+  semifuture_getKvStoreKeyValsFilteredAreas(
+      std::unique_ptr<thrift::KeyDumpParams> filter,
+      std::unique_ptr<std::set<std::string>> areas) override;
+
   folly::SemiFuture<std::unique_ptr<thrift::Publication>>
   semifuture_getKvStoreHashFiltered(
       std::unique_ptr<thrift::KeyDumpParams> filter) override;
@@ -202,6 +268,10 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::PeersMap>>
   semifuture_getKvStorePeersArea(std::unique_ptr<std::string> area) override;
 
+  folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::PeersMap>>>
+  semifuture_getKvStorePeersAreas(
+      std::unique_ptr<std::set<std::string>> areas) override;
+
   // Intentionally not use SemiFuture as stream is async by nature and we will
   // immediately create and return the stream handler
   apache::thrift::ServerStream<thrift::Publication> subscribeKvStoreFilter(
@@ -222,6 +292,9 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<bool> semifuture_longPollKvStoreAdj(
       std::unique_ptr<thrift::KeyVals> snapshot) override;
 
+  folly::SemiFuture<int64_t> semifuture_longPollKvStoreAdjChange(
+      int64_t seqNum) override;
+
   //
   // LinkMonitor APIs
   //
@@ -282,6 +355,42 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::RibPolicy>>
   semifuture_getRibPolicy() override;
 
+  //
+  // Large read APIs. Response is built from the module snapshot and
+  // serialized on responseExecutor_, off module and thrift worker threads
+  //
+
+  folly::Future<std::unique_ptr<thrift::RouteDatabase>> future_getRouteDb()
+      override;
+
+  folly::Future<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
+  future_getUnicastRoutesFiltered(
+      std::unique_ptr<std::vector<::std::string>> prefixes) override;
+
+  folly::Future<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
+  future_getUnicastRoutes() override;
+
+  folly::Future<std::unique_ptr<std::vector<thrift::MplsRoute>>>
+  future_getMplsRoutesFiltered(
+      std::unique_ptr<std::vector<int32_t>> labels) override;
+
+  folly::Future<std::unique_ptr<std::vector<thrift::MplsRoute>>>
+  future_getMplsRoutes() override;
+
+  folly::Future<std::unique_ptr<thrift::Publication>>
+  future_getKvStoreKeyValsFiltered(
+      std::unique_ptr<thrift::KeyDumpParams> filter) override;
+
+  folly::Future<std::unique_ptr<thrift::Publication>>
+  future_getKvStoreKeyValsFilteredArea(
+      std::unique_ptr<thrift::KeyDumpParams> filter,
+      std::unique_ptr<std::string> area) override;
+
+  folly::Future<std::unique_ptr<std::map<std::string, thrift::Publication>>>
+  future_getKvStoreKeyValsFilteredAreas(
+      std::unique_ptr<thrift::KeyDumpParams> filter,
+      std::unique_ptr<std::set<std::string>> areas) override;
+
   //
   // APIs to expose state of private variables
   //
@@ -291,6 +400,16 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
     return kvStorePublishers_.wlock()->size();
   }
 
+  inline size_t
+  getNumFibPublishers() {
+    return fibPublishers_.wlock()->size();
+  }
+
+  inline size_t
+  getNumDecisionDbsPublishers() {
+    return decisionDbsPublishers_.wlock()->size();
+  }
+
   inline size_t
   getNumPendingLongPollReqs() {
     return longPollReqs_->size();
@@ -307,6 +426,16 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
  private:
   void authorizeConnection();
 
+  // Wait for the next adjacency change. Resolved right away with current
+  // sequence number if given seqNum is not current
+  folly::SemiFuture<int64_t> waitForAdjChange(int64_t seqNum);
+
+  // Run `buildFn` on responseExecutor_ and complete its response there, so
+  // that thrift serializes the response on the same thread
+  template <typename F>
+  folly::Future<typename folly::invoke_result_t<F>::value_type>
+  offloadResponse(const char* api, F&& buildFn);
+
   const std::string nodeName_;
   const std::unordered_set<std::string> acceptablePeerCommonNames_;
 
@@ -317,7 +446,10 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   LinkMonitor* linkMonitor_{nullptr};
   PersistentStore* configStore_{nullptr};
   PrefixManager* prefixManager_{nullptr};
-  std::shared_ptr<const Config> config_;
+  // running config, replaced on reload
+  folly::Synchronized<std::shared_ptr<const Config>> config_;
+  messaging::ReplicateQueue<std::shared_ptr<const Config>>*
+      configUpdatesQueue_{nullptr};
 
   // client to interact with monitor
   std::unique_ptr<fbzmq::ZmqMonitorClient> zmqMonitorClient_;
@@ -328,15 +460,69 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       std::unordered_map<int64_t, std::unique_ptr<KvStorePublisher>>>
       kvStorePublishers_;
 
+  // Dispatch index of kvstore snoop publishers by their filters. Guarded by
+  // the lock of kvStorePublishers_
+  KvStoreSubscriberIndex kvStoreSubscriberIndex_;
+
+  // Active fib snoop publishers
+  folly::Synchronized<std::unordered_map<
+      int64_t,
+      apache::thrift::ServerStreamPublisher<thrift::RouteDatabaseDelta>>>
+      fibPublishers_;
+
+  // Active decision adjacency/prefix databases snoop publishers
+  folly::Synchronized<std::unordered_map<
+      int64_t,
+      apache::thrift::ServerStreamPublisher<thrift::DecisionDbsDelta>>>
+      decisionDbsPublishers_;
+
   // pending longPoll requests from clients, which consists of
-  // 1). promise; 2). timestamp when req received on server
+  // 1). promise fulfilled with adjacency change sequence number;
+  // 2). timestamp when req received on server.
+  // Ordered by arrival, hence by timestamp as well
   std::atomic<int64_t> pendingRequestId_{0};
   folly::Synchronized<
-      std::unordered_map<int64_t, std::pair<folly::Promise<bool>, int64_t>>>
+      std::map<int64_t, std::pair<folly::Promise<int64_t>, int64_t>>>
       longPollReqs_;
 
+  // sequence number of "adj:*" key changes observed in KvStore publications.
+  // Updated under the lock of longPollReqs_
+  std::atomic<int64_t> adjChangeSeqNum_{0};
+
   // fiber task future hold
   folly::Future<folly::Unit> taskFuture_;
+  folly::Future<folly::Unit> fibTaskFuture_;
+  folly::Future<folly::Unit> decisionTaskFuture_;
+
+  // fiber streaming publications buffered for rate-limited KvStore
+  // subscribers, stopped by posting the baton
+  folly::Future<folly::Unit> flushTaskFuture_;
+  folly::fibers::Baton stopFlushBaton_;
+
+  // generations of module data, bumped on every update received from the
+  // module. Cached responses are only served at the same generation
+  std::atomic<int64_t> kvStoreGeneration_{0};
+  std::atomic<int64_t> fibGeneration_{0};
+  std::atomic<int64_t> decisionGeneration_{0};
+
+  // cached responses of read APIs polled by monitoring
+  CtrlResponseCache<thrift::Publication> kvStoreKeyValsCache_{
+      Constants::kCtrlResponseCacheTtl,
+      Constants::kCtrlResponseCacheMaxEntries};
+  CtrlResponseCache<thrift::RouteDatabase> routeDbCache_{
+      Constants::kCtrlResponseCacheTtl,
+      Constants::kCtrlResponseCacheMaxEntries};
+  CtrlResponseCache<thrift::AdjDbs> adjDbsCache_{
+      Constants::kCtrlResponseCacheTtl,
+      Constants::kCtrlResponseCacheMaxEntries};
+
+  // latency, cost and caller stats of served requests
+  std::shared_ptr<CtrlRequestStats> requestStats_{
+      std::make_shared<CtrlRequestStats>()};
+
+  // executor building and serializing large read responses. Declared last to
+  // be joined before any state its tasks refer to is destroyed
+  std::unique_ptr<folly::CPUThreadPoolExecutor> responseExecutor_;
 
 }; // class OpenrCtrlHandler
 } // namespace openr
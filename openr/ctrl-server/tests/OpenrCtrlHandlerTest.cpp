@@ -91,6 +91,7 @@ class OpenrCtrlFixture : public ::testing::Test {
         kvStoreWrapper->getReader(),
         staticRoutesUpdatesQueue_.getReader(),
         routeUpdatesQueue_,
+        decisionDbsUpdatesQueue_,
         context_);
     decisionThread_ = std::thread([&]() { decision->run(); });
 
@@ -101,6 +102,7 @@ class OpenrCtrlFixture : public ::testing::Test {
         std::chrono::seconds(2),
         routeUpdatesQueue_.getReader(),
         interfaceUpdatesQueue_.getReader(),
+        fibUpdatesQueue_,
         MonitorSubmitUrl{"inproc://monitor-sub"},
         kvStoreWrapper->getKvStore(),
         context_);
@@ -179,6 +181,8 @@ class OpenrCtrlFixture : public ::testing::Test {
     routeUpdatesQueue_.close();
     staticRoutesUpdatesQueue_.close();
     interfaceUpdatesQueue_.close();
+    fibUpdatesQueue_.close();
+    decisionDbsUpdatesQueue_.close();
     peerUpdatesQueue_.close();
     neighborUpdatesQueue_.close();
     prefixUpdatesQueue_.close();
@@ -231,6 +235,8 @@ class OpenrCtrlFixture : public ::testing::Test {
 
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue_;
   messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue_;
   messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
   messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
@@ -273,6 +279,70 @@ TEST_F(OpenrCtrlFixture, getMyNodeName) {
   EXPECT_EQ(nodeName, res);
 }
 
+TEST_F(OpenrCtrlFixture, RequestStats) {
+  // Counters are process wide, verify increments only
+  std::map<std::string, int64_t> before;
+  openrCtrlThriftClient_->sync_getCounters(before);
+
+  std::string res;
+  openrCtrlThriftClient_->sync_getMyNodeName(res);
+  openrCtrlThriftClient_->sync_getMyNodeName(res);
+
+  thrift::PeersMap peers;
+  EXPECT_THROW(
+      openrCtrlThriftClient_->sync_getKvStorePeersArea(peers, "unknown"),
+      thrift::OpenrError);
+
+  std::map<std::string, int64_t> after;
+  openrCtrlThriftClient_->sync_getCounters(after);
+  auto delta = [&](const std::string& key) {
+    return after[key] - before[key];
+  };
+  EXPECT_EQ(2, delta("ctrl.request.getMyNodeName.count"));
+  EXPECT_EQ(0, delta("ctrl.request.getMyNodeName.errors.count"));
+  EXPECT_EQ(1, delta("ctrl.request.getKvStorePeersArea.count"));
+  EXPECT_EQ(1, delta("ctrl.request.getKvStorePeersArea.errors.count"));
+  EXPECT_LT(0, delta("ctrl.request.getMyNodeName.response_bytes.sum"));
+
+  // Requests are accounted to the (loopback) caller
+  int64_t callerRequests{0};
+  for (auto const& [key, value] : after) {
+    if (key.find("ctrl.caller.") == 0 and
+        key.find(".requests.sum") != std::string::npos) {
+      callerRequests += value - before[key];
+    }
+  }
+  EXPECT_LE(3, callerRequests);
+}
+
+TEST_F(OpenrCtrlFixture, OffloadedResponses) {
+  // Counters are process wide, verify increments only
+  std::map<std::string, int64_t> before;
+  openrCtrlThriftClient_->sync_getCounters(before);
+
+  thrift::RouteDatabase db;
+  openrCtrlThriftClient_->sync_getRouteDb(db);
+  EXPECT_EQ(nodeName, db.thisNodeName);
+
+  std::vector<thrift::UnicastRoute> unicastRoutes;
+  openrCtrlThriftClient_->sync_getUnicastRoutes(unicastRoutes);
+  EXPECT_EQ(0, unicastRoutes.size());
+
+  thrift::Publication pub;
+  thrift::KeyDumpParams params;
+  openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredArea(
+      pub, params, thrift::KvStore_constants::kDefaultArea());
+
+  std::map<std::string, int64_t> after;
+  openrCtrlThriftClient_->sync_getCounters(after);
+  auto delta = [&](const std::string& key) {
+    return after[key] - before[key];
+  };
+  EXPECT_EQ(1, delta("ctrl.offloaded_responses.route_db.count"));
+  EXPECT_EQ(1, delta("ctrl.offloaded_responses.unicast_routes.count"));
+  EXPECT_EQ(1, delta("ctrl.offloaded_responses.kvstore_keys.count"));
+}
+
 TEST_F(OpenrCtrlFixture, PrefixManagerApis) {
   {
     std::vector<thrift::PrefixEntry> prefixes{
@@ -372,6 +442,66 @@ TEST_F(OpenrCtrlFixture, RouteApis) {
   }
 }
 
+TEST_F(OpenrCtrlFixture, FibSubscription) {
+  const auto prefix = toIpPrefix("10.46.2.0/24");
+  const auto nextHop = createNextHop(toBinaryAddress("fe80::1"), "iface");
+
+  std::atomic<int> received{0};
+  auto handler = openrThriftServerWrapper_->getOpenrCtrlHandler();
+  auto responseAndSubscription = handler->semifuture_subscribeAndGetFib().get();
+  EXPECT_EQ(nodeName, responseAndSubscription.response.thisNodeName);
+  EXPECT_EQ(0, responseAndSubscription.response.unicastRoutes.size());
+
+  auto subscription =
+      std::move(responseAndSubscription.stream)
+          .toClientStream()
+          .subscribeExTry(folly::getEventBase(), [&](auto&& t) {
+            if (!t.hasValue()) {
+              return;
+            }
+            auto& delta = *t;
+            if (received == 0) {
+              ASSERT_EQ(1, delta.unicastRoutesToUpdate.size());
+              EXPECT_EQ(prefix, delta.unicastRoutesToUpdate.at(0).dest);
+            } else {
+              ASSERT_EQ(1, delta.unicastRoutesToDelete.size());
+              EXPECT_EQ(prefix, delta.unicastRoutesToDelete.at(0));
+            }
+            received++;
+          });
+  EXPECT_EQ(1, handler->getNumFibPublishers());
+
+  // Mimic Decision publishing route add and then delete
+  {
+    thrift::RouteDatabaseDelta routeDbDelta;
+    routeDbDelta.thisNodeName = nodeName;
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(
+        createUnicastRoute(prefix, {nextHop}));
+    routeUpdatesQueue_.push(std::move(routeDbDelta));
+  }
+  while (received < 1) {
+    std::this_thread::yield();
+  }
+  {
+    thrift::RouteDatabaseDelta routeDbDelta;
+    routeDbDelta.thisNodeName = nodeName;
+    routeDbDelta.unicastRoutesToDelete.emplace_back(prefix);
+    routeUpdatesQueue_.push(std::move(routeDbDelta));
+  }
+  while (received < 2) {
+    std::this_thread::yield();
+  }
+
+  // Cancel subscription
+  subscription.cancel();
+  std::move(subscription).detach();
+
+  // Wait until publisher is destroyed
+  while (handler->getNumFibPublishers() != 0) {
+    std::this_thread::yield();
+  }
+}
+
 TEST_F(OpenrCtrlFixture, PerfApis) {
   thrift::PerfDatabase db;
   openrCtrlThriftClient_->sync_getPerfDb(db);
@@ -481,6 +611,28 @@ TEST_F(OpenrCtrlFixture, KvStoreApis) {
     EXPECT_EQ(keyVals.at("key33"), pub.keyVals["key33"]);
     EXPECT_EQ(keyVals.at("key333"), pub.keyVals["key333"]);
   }
+  // repeated reads are served from cache, and never stale after a write
+  {
+    thrift::KeyDumpParams params;
+    params.prefix = "key1";
+    thrift::Publication pub1;
+    thrift::Publication pub2;
+    openrCtrlThriftClient_->sync_getKvStoreKeyValsFiltered(pub1, params);
+    openrCtrlThriftClient_->sync_getKvStoreKeyValsFiltered(pub2, params);
+    EXPECT_EQ(3, pub1.keyVals.size());
+    EXPECT_EQ(pub1.keyVals, pub2.keyVals);
+
+    thrift::KeySetParams setParams;
+    setParams.keyVals["key1"] =
+        createThriftValue(2, "node1", std::string("value1-v2"));
+    openrCtrlThriftClient_->sync_setKvStoreKeyVals(
+        setParams, thrift::KvStore_constants::kDefaultArea());
+
+    thrift::Publication pub3;
+    openrCtrlThriftClient_->sync_getKvStoreKeyValsFiltered(pub3, params);
+    EXPECT_EQ(3, pub3.keyVals.size());
+    EXPECT_EQ(2, pub3.keyVals.at("key1").version);
+  }
   // with areas
   {
     thrift::Publication pub;
@@ -494,6 +646,35 @@ TEST_F(OpenrCtrlFixture, KvStoreApis) {
     EXPECT_EQ(keyValsPlane.at("keyPlane1"), pub.keyVals["keyPlane1"]);
     EXPECT_EQ(keyValsPlane.at("keyPlane2"), pub.keyVals["keyPlane2"]);
   }
+  // with multiple areas
+  {
+    std::map<std::string, thrift::Publication> pubs;
+    thrift::KeyDumpParams params;
+    params.prefix = "keyP";
+    params.originatorIds.insert("node1");
+
+    openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredAreas(
+        pubs, params, {"plane", "pod"});
+    EXPECT_EQ(2, pubs.size());
+    EXPECT_EQ(2, pubs.at("plane").keyVals.size());
+    EXPECT_EQ(
+        keyValsPlane.at("keyPlane1"), pubs.at("plane").keyVals["keyPlane1"]);
+    EXPECT_EQ(2, pubs.at("pod").keyVals.size());
+    EXPECT_EQ(keyValsPod.at("keyPod1"), pubs.at("pod").keyVals["keyPod1"]);
+
+    // all areas
+    pubs.clear();
+    openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredAreas(
+        pubs, params, {});
+    EXPECT_EQ(3, pubs.size());
+    EXPECT_EQ(1, pubs.count(thrift::KvStore_constants::kDefaultArea()));
+
+    // unknown area fails whole request
+    EXPECT_THROW(
+        openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredAreas(
+            pubs, params, {"plane", "unknown"}),
+        thrift::OpenrError);
+  }
 
   {
     thrift::Publication pub;
@@ -611,6 +792,20 @@ TEST_F(OpenrCtrlFixture, KvStoreApis) {
     EXPECT_EQ(ret.count("peer21"), 0);
   }
 
+  {
+    std::map<std::string, thrift::PeersMap> ret;
+    openrCtrlThriftClient_->sync_getKvStorePeersAreas(ret, {});
+    EXPECT_EQ(3, ret.size());
+    EXPECT_EQ(2, ret.at(thrift::KvStore_constants::kDefaultArea()).size());
+    EXPECT_EQ(1, ret.at("pod").size());
+    EXPECT_EQ(0, ret.at("plane").size());
+
+    ret.clear();
+    openrCtrlThriftClient_->sync_getKvStorePeersAreas(ret, {"pod"});
+    EXPECT_EQ(1, ret.size());
+    EXPECT_EQ(peersPod.at("peer11"), ret.at("pod").at("peer11"));
+  }
+
   //
   // Subscribe and Get API
   //
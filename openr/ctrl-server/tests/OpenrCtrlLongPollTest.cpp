@@ -225,6 +225,49 @@ TEST_F(LongPollFixture, LongPollAdjModified) {
   ASSERT_TRUE(isAdjChanged);
 }
 
+TEST_F(LongPollFixture, LongPollAdjChangeSeqNum) {
+  //
+  // This UT mimicks long poll with adjacency change sequence number. Stale
+  // sequence number returns right away, current one waits for "adj:" key
+  // change and ignores other keys.
+  //
+  const auto seqNum = client1_->sync_longPollKvStoreAdjChange(-1);
+  EXPECT_EQ(0, seqNum);
+
+  std::chrono::steady_clock::time_point startTime;
+  evl_.scheduleTimeout(std::chrono::milliseconds(1000), [&]() noexcept {
+    LOG(INFO) << "Prefix key set...";
+    kvStoreWrapper_->setKey(
+        prefixKey_, createThriftValue(1, nodeName_, std::string("value1")));
+  });
+  evl_.scheduleTimeout(std::chrono::milliseconds(2000), [&]() noexcept {
+    LOG(INFO) << "AdjKey set...";
+    startTime = std::chrono::steady_clock::now();
+    kvStoreWrapper_->setKey(
+        adjKey_, createThriftValue(1, nodeName_, std::string("value1")));
+    evl_.stop();
+  });
+
+  std::thread evlThread([&]() { evl_.run(); });
+  evl_.waitUntilRunning();
+
+  LOG(INFO) << "Start long poll...";
+  const auto newSeqNum = client1_->sync_longPollKvStoreAdjChange(seqNum);
+  const auto endTime = std::chrono::steady_clock::now();
+  EXPECT_EQ(seqNum + 1, newSeqNum);
+  ASSERT_LE(endTime - startTime, std::chrono::milliseconds(50));
+  EXPECT_EQ(
+      0,
+      openrThriftServerWrapper_->getOpenrCtrlHandler()
+          ->getNumPendingLongPollReqs());
+
+  // stale sequence number returns right away
+  EXPECT_EQ(newSeqNum, client1_->sync_longPollKvStoreAdjChange(seqNum));
+
+  evl_.waitUntilStopped();
+  evlThread.join();
+}
+
 TEST_F(LongPollFixture, LongPollAdjUnchanged) {
   //
   // This UT mimicks the scenario that client already hold the same adj key.
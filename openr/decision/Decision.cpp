@@ -7,7 +7,11 @@
 
 #include "Decision.h"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -20,6 +24,8 @@
 #include <folly/Memory.h>
 #include <folly/Optional.h>
 #include <folly/String.h>
+#include <folly/executors/thread_factory/InitThreadFactory.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #if FOLLY_USE_SYMBOLIZER
 #include <folly/experimental/exception_tracer/ExceptionTracer.h>
@@ -27,7 +33,9 @@
 #include <gflags/gflags.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/StartupTimeline.h>
 #include <openr/common/Util.h>
 #include <openr/decision/PrefixState.h>
 #include <openr/decision/RibEntry.h>
@@ -45,6 +53,295 @@ using SpfResult = openr::LinkState::SpfResult;
 
 namespace openr {
 
+namespace {
+
+// Histogram buckets of route computation phase durations, in milliseconds
+constexpr int64_t kPhaseBucketWidthMs{5};
+constexpr int64_t kPhaseMaxMs{5000};
+
+// phases of processing pending updates, spf/ksp2/unicast_routes/mpls_routes
+// are of building routes of an area
+const std::vector<std::string> kDecisionPhases{
+    "deserialize",
+    "static_routes",
+    "route_build",
+    "spf",
+    "ksp2",
+    "unicast_routes",
+    "mpls_routes",
+    "rib_policy",
+    "route_delta",
+    "publish",
+};
+
+std::string
+getPhaseCounterName(std::string const& phase) {
+  return folly::sformat("decision.phase.{}_ms", phase);
+}
+
+/**
+ * Times a phase of route computation, exported as decision.phase.<phase>_ms
+ * histogram once the timer goes out of scope
+ */
+class ScopedPhaseTimer {
+ public:
+  explicit ScopedPhaseTimer(char const* phase)
+      : phase_(phase), startTime_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedPhaseTimer() {
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime_);
+    fb303::fbData->addHistogramValue(
+        getPhaseCounterName(phase_), duration.count());
+  }
+
+ private:
+  char const* phase_{nullptr};
+  const std::chrono::steady_clock::time_point startTime_;
+};
+
+// metric of the shortest nexthop of the route. Route without nexthops is
+// never preferred
+int64_t
+getBestNexthopMetric(RibUnicastEntry const& entry) {
+  int64_t bestMetric = std::numeric_limits<int64_t>::max();
+  for (auto const& nh : entry.nexthops) {
+    bestMetric = std::min<int64_t>(bestMetric, nh.metric);
+  }
+  return bestMetric;
+}
+
+// add route of prefix to entries, coalescing it with the route of prefix
+// computed in an area merged earlier. Route over the shorter path wins. On a
+// tie, nexthops of non-BGP routes are merged for ECMP across areas, otherwise
+// the route of the earlier area wins
+template <typename Entry>
+void
+addCoalescedUnicastEntry(
+    std::unordered_map<thrift::IpPrefix, RibUnicastEntry>& entries,
+    thrift::IpPrefix const& prefix,
+    Entry&& entry) {
+  auto it = entries.find(prefix);
+  if (it == entries.end()) {
+    entries.emplace(prefix, std::forward<Entry>(entry));
+    return;
+  }
+  auto& current = it->second;
+  const auto currentMetric = getBestNexthopMetric(current);
+  const auto metric = getBestNexthopMetric(entry);
+  if (metric < currentMetric) {
+    // entries are not assignable, replace the node instead
+    entries.erase(it);
+    entries.emplace(prefix, std::forward<Entry>(entry));
+  } else if (
+      metric == currentMetric and
+      current.bestPrefixEntry.type != thrift::PrefixType::BGP and
+      entry.bestPrefixEntry.type != thrift::PrefixType::BGP and
+      current.doNotInstall == entry.doNotInstall) {
+    for (auto const& nh : entry.nexthops) {
+      current.nexthops.emplace(nh);
+    }
+  }
+}
+
+// add routes of an area to db, coalescing unicast routes of prefixes with
+// routes in several areas (see addCoalescedUnicastEntry). MPLS routes of areas
+// merged earlier win
+void
+mergeAreaRouteDb(DecisionRouteDb& db, DecisionRouteDb const& areaDb) {
+  db.unicastEntries.reserve(
+      db.unicastEntries.size() + areaDb.unicastEntries.size());
+  for (auto const& [prefix, entry] : areaDb.unicastEntries) {
+    addCoalescedUnicastEntry(db.unicastEntries, prefix, entry);
+  }
+  db.mplsEntries.insert(areaDb.mplsEntries.begin(), areaDb.mplsEntries.end());
+  // TODO: Sort out how to combine perf events
+}
+
+// same as above, moving the routes out of areaDb instead of copying them
+void
+mergeAreaRouteDb(DecisionRouteDb& db, DecisionRouteDb&& areaDb) {
+  if (db.unicastEntries.empty()) {
+    db.unicastEntries = std::move(areaDb.unicastEntries);
+  } else {
+    for (auto& [prefix, entry] : areaDb.unicastEntries) {
+      addCoalescedUnicastEntry(db.unicastEntries, prefix, std::move(entry));
+    }
+  }
+  db.mplsEntries.merge(areaDb.mplsEntries);
+}
+
+// (neighbor, interface, metric, isUp) of all links of nodeName, sorted
+std::vector<std::tuple<std::string, std::string, LinkStateMetric, bool>>
+getLocalLinks(LinkState const& linkState, std::string const& nodeName) {
+  std::vector<std::tuple<std::string, std::string, LinkStateMetric, bool>>
+      localLinks;
+  for (auto const& link : linkState.linksFromNode(nodeName)) {
+    localLinks.emplace_back(
+        link->getOtherNodeName(nodeName),
+        link->getIfaceFromNode(nodeName),
+        link->getMetricFromNode(nodeName),
+        link->isUp());
+  }
+  std::sort(localLinks.begin(), localLinks.end());
+  return localLinks;
+}
+
+// add nodes whose metric or nexthops differ between two SPF results of the
+// same source
+void
+addChangedNodes(
+    SpfResult const& oldResult,
+    SpfResult const& newResult,
+    std::unordered_set<std::string>& changedNodes) {
+  for (auto const id : oldResult.reachableNodes()) {
+    auto const* oldNodeResult = oldResult.get(id);
+    auto const* newNodeResult = newResult.get(id);
+    if (not newNodeResult or
+        newNodeResult->metric() != oldNodeResult->metric() or
+        newResult.nextHops(*newNodeResult) !=
+            oldResult.nextHops(*oldNodeResult)) {
+      changedNodes.emplace(oldResult.nodeName(id));
+    }
+  }
+  for (auto const id : newResult.reachableNodes()) {
+    if (not oldResult.get(id)) {
+      changedNodes.emplace(newResult.nodeName(id));
+    }
+  }
+}
+
+// add node prefix database to the delta, database of node without any prefix
+// is deleted
+void
+addPrefixDbToDelta(
+    thrift::DecisionDbsDelta& dbsDelta, thrift::PrefixDatabase&& prefixDb) {
+  if (prefixDb.prefixEntries.empty()) {
+    dbsDelta.prefixDbsToDelete.emplace_back(prefixDb.thisNodeName);
+  } else {
+    dbsDelta.prefixDbsToUpdate.emplace_back(std::move(prefixDb));
+  }
+}
+
+// Approximate memory held by route db entries. Nexthops are interned,
+// entries only hold their ids
+size_t
+getNextHopIdsMemoryUsage(NextHopSet const& nexthops) {
+  auto const& ids = nexthops.ids();
+  return ids.capacity() > NextHopSet::kInlineIds
+      ? ids.capacity() * sizeof(NextHopTable::Id)
+      : 0;
+}
+
+size_t
+getEntriesMemoryUsage(
+    std::unordered_map<thrift::IpPrefix, RibUnicastEntry> const& entries) {
+  size_t bytes{0};
+  for (auto const& [prefix, entry] : entries) {
+    bytes += getMemoryUsage(prefix) + sizeof(entry) +
+        getNextHopIdsMemoryUsage(entry.nexthops);
+  }
+  return bytes;
+}
+
+size_t
+getEntriesMemoryUsage(
+    std::unordered_map<int32_t, RibMplsEntry> const& entries) {
+  size_t bytes{0};
+  for (auto const& [label, entry] : entries) {
+    bytes += sizeof(label) + sizeof(entry) +
+        getNextHopIdsMemoryUsage(entry.nexthops);
+  }
+  return bytes;
+}
+
+// factory of route build worker threads, applying their scheduling if any
+std::shared_ptr<folly::ThreadFactory>
+makeRouteBuildThreadFactory(
+    const std::string& namePrefix,
+    const std::optional<thrift::ThreadSchedulingConfig>& scheduling) {
+  auto threadFactory = std::make_shared<folly::NamedThreadFactory>(namePrefix);
+  if (not scheduling.has_value()) {
+    return threadFactory;
+  }
+  return std::make_shared<folly::InitThreadFactory>(
+      std::move(threadFactory), [namePrefix, scheduling]() {
+        applyThreadScheduling(namePrefix, *scheduling);
+      });
+}
+
+// apply topology change onto adjacency databases of an area. Returns nodes
+// whose database got updated or removed, none if the node or link isn't in
+// the area
+std::vector<std::string>
+applyTopologyChange(
+    thrift::TopologyChange const& change,
+    std::unordered_map<std::string, thrift::AdjacencyDatabase>& adjDbs) {
+  auto dbIt = adjDbs.find(change.nodeName);
+  if (dbIt == adjDbs.end()) {
+    return {};
+  }
+  switch (change.type) {
+  case thrift::TopologyChangeType::OVERLOAD_NODE:
+    dbIt->second.isOverloaded = true;
+    return {change.nodeName};
+  case thrift::TopologyChangeType::REMOVE_NODE:
+    adjDbs.erase(dbIt);
+    return {change.nodeName};
+  default:
+    break;
+  }
+
+  if (not change.ifName_ref().has_value()) {
+    thrift::OpenrError error;
+    error.message = "Link change requires ifName";
+    throw error;
+  }
+  if (change.type == thrift::TopologyChangeType::SET_LINK_METRIC and
+      not change.metric_ref().has_value()) {
+    thrift::OpenrError error;
+    error.message = "Link metric change requires metric";
+    throw error;
+  }
+  auto const& adjs = dbIt->second.adjacencies;
+  auto adjIt = std::find_if(adjs.begin(), adjs.end(), [&](auto const& adj) {
+    return adj.ifName == *change.ifName_ref();
+  });
+  if (adjIt == adjs.end()) {
+    return {};
+  }
+
+  // (node, ifName, otherNodeName) of both ends of the link
+  const std::vector<std::tuple<std::string, std::string, std::string>> ends{
+      {change.nodeName, adjIt->ifName, adjIt->otherNodeName},
+      {adjIt->otherNodeName, adjIt->otherIfName, change.nodeName}};
+  std::vector<std::string> changedNodes;
+  for (auto const& [node, ifName, otherNodeName] : ends) {
+    auto it = adjDbs.find(node);
+    if (it == adjDbs.end()) {
+      continue;
+    }
+    auto& nodeAdjs = it->second.adjacencies;
+    for (auto adj = nodeAdjs.begin(); adj != nodeAdjs.end(); ++adj) {
+      if (adj->ifName != ifName or adj->otherNodeName != otherNodeName) {
+        continue;
+      }
+      if (change.type == thrift::TopologyChangeType::REMOVE_LINK) {
+        nodeAdjs.erase(adj);
+      } else if (change.type == thrift::TopologyChangeType::OVERLOAD_LINK) {
+        adj->isOverloaded = true;
+      } else {
+        adj->metric = *change.metric_ref();
+      }
+      changedNodes.emplace_back(node);
+      break;
+    }
+  }
+  return changedNodes;
+}
+
+} // namespace
+
 thrift::RouteDatabaseDelta
 getRouteDelta(const DecisionRouteDb& newDb, const DecisionRouteDb& oldDb) {
   thrift::RouteDatabaseDelta delta;
@@ -96,13 +393,23 @@ class SpfSolver::SpfSolverImpl {
       bool computeLfaPaths,
       bool enableOrderedFib,
       bool bgpDryRun,
-      bool bgpUseIgpMetric)
+      bool bgpUseIgpMetric,
+      int32_t numRouteBuildThreads,
+      std::optional<thrift::ThreadSchedulingConfig> routeBuildScheduling,
+      bool enableUcmp)
       : myNodeName_(myNodeName),
         enableV4_(enableV4),
         computeLfaPaths_(computeLfaPaths),
         enableOrderedFib_(enableOrderedFib),
         bgpDryRun_(bgpDryRun),
-        bgpUseIgpMetric_(bgpUseIgpMetric) {
+        bgpUseIgpMetric_(bgpUseIgpMetric),
+        enableUcmp_(enableUcmp) {
+    if (numRouteBuildThreads > 0) {
+      routeBuildExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+          numRouteBuildThreads,
+          makeRouteBuildThreadFactory("SpfSolverShard", routeBuildScheduling));
+    }
+
     // Initialize stat keys
     fb303::fbData->addStatExportType("decision.adj_db_update", fb303::COUNT);
     fb303::fbData->addStatExportType(
@@ -113,6 +420,10 @@ class SpfSolver::SpfSolverImpl {
         "decision.no_route_to_label", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.no_route_to_prefix", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.lfa_unprotected_prefixes", fb303::COUNT);
+    fb303::fbData->addStatExportType("decision.ksp2_ms", fb303::AVG);
+    fb303::fbData->addStatExportType("decision.memo_evictions", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.path_build_ms", fb303::AVG);
     fb303::fbData->addStatExportType("decision.prefix_db_update", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.route_build_ms", fb303::AVG);
@@ -126,22 +437,45 @@ class SpfSolver::SpfSolverImpl {
     fb303::fbData->addStatExportType("decision.spf_ms", fb303::AVG);
     fb303::fbData->addStatExportType("decision.spf_runs", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.errors", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.incremental_route_build_runs", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.incremental_prefixes_recomputed", fb303::SUM);
+    fb303::fbData->addStatExportType(
+        "decision.incremental_labels_recomputed", fb303::SUM);
+    fb303::fbData->addStatExportType("decision.nexthop_memo_hits", fb303::SUM);
+    fb303::fbData->addStatExportType("decision.rejected_prefixes", fb303::SUM);
+    fb303::fbData->addStatExportType(
+        "decision.nexthop_memo_misses", fb303::SUM);
+    fb303::fbData->addStatExportType(
+        "decision.best_announcers_cache_hits", fb303::SUM);
+    fb303::fbData->addStatExportType(
+        "decision.best_announcers_cache_misses", fb303::SUM);
+    for (auto const& phase : kDecisionPhases) {
+      fb303::fbData->addHistogram(
+          getPhaseCounterName(phase), kPhaseBucketWidthMs, 0, kPhaseMaxMs);
+      fb303::fbData->exportHistogramPercentile(
+          getPhaseCounterName(phase), 50, 95, 99);
+    }
   }
 
   ~SpfSolverImpl() = default;
 
   //
-  // mpls static route
+  // mpls and unicast static routes
   //
 
   bool staticRoutesUpdated();
 
   void pushRoutesDeltaUpdates(thrift::RouteDatabaseDelta& staticRoutesDelta);
 
-  std::optional<thrift::RouteDatabaseDelta> processStaticRouteUpdates();
+  StaticRoutesUpdate processStaticRouteUpdates();
 
   thrift::StaticRoutes const& getStaticRoutes();
 
+  std::unordered_map<thrift::IpPrefix, RibUnicastEntry> const&
+  getStaticUnicastRoutes();
+
   //
   // best path calculation
   //
@@ -149,10 +483,15 @@ class SpfSolver::SpfSolverImpl {
   // Build route database using global prefix database and cached SPF
   // computation from perspective of a given router.
   // Returns std::nullopt if myNodeName doesn't have any prefix database
+  // If prefixes is set, only unicast routes of these prefixes are built. If
+  // labelNodes is set, only MPLS routes of node labels of these nodes are
+  // built, and none of adjacency labels
   std::optional<DecisionRouteDb> buildRouteDb(
       const std::string& myNodeName,
       LinkState const& linkState,
-      PrefixState const& prefixState);
+      PrefixState const& prefixState,
+      std::unordered_set<thrift::IpPrefix> const* prefixes = nullptr,
+      std::unordered_set<std::string> const* labelNodes = nullptr);
 
   // helpers used in best path calculation
   static std::pair<Metric, std::unordered_set<std::string>> getMinCostNodes(
@@ -166,6 +505,34 @@ class SpfSolver::SpfSolverImpl {
   SpfSolverImpl(SpfSolverImpl const&) = delete;
   SpfSolverImpl& operator=(SpfSolverImpl const&) = delete;
 
+  // Build unicast route for a single prefix and emplace it into
+  // unicastEntries if one can be computed
+  void buildUnicastRoute(
+      std::unordered_map<thrift::IpPrefix, RibUnicastEntry>& unicastEntries,
+      const std::string& myNodeName,
+      thrift::IpPrefix const& prefix,
+      std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
+      LinkState const& linkState,
+      PrefixState const& prefixState);
+
+  // Build unicast routes for all prefixes, split into numShards contiguous
+  // shards evaluated concurrently on routeBuildExecutor_
+  void buildUnicastRoutesSharded(
+      std::unordered_map<thrift::IpPrefix, RibUnicastEntry>& unicastEntries,
+      size_t numShards,
+      const std::string& myNodeName,
+      LinkState const& linkState,
+      PrefixState const& prefixState);
+
+  // Compute KSP2 paths towards all nodes announcing KSP2_ED_ECMP prefixes
+  // (only the given prefixes if set) up front, concurrently on
+  // routeBuildExecutor_ if any, so that selectKsp2() reads memoized paths
+  void precomputeKsp2Paths(
+      const std::string& myNodeName,
+      LinkState const& linkState,
+      PrefixState const& prefixState,
+      std::unordered_set<thrift::IpPrefix> const* prefixes);
+
   // Given prefixes and the nodes who announce it, get the ecmp routes.
   // emplace unicastEntry into unicastEntries if valid ecmp exists
   void selectEcmpOpenr(
@@ -174,7 +541,8 @@ class SpfSolver::SpfSolverImpl {
       thrift::IpPrefix const& prefix,
       std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
       bool const isV4,
-      LinkState const& linkState);
+      LinkState const& linkState,
+      PrefixState const& prefixState);
 
   // Given bgp prefixes and the nodes who announce it, get the ecmp routes.
   // emplace unicastEntry into unicastEntries if valid ecmp exists
@@ -203,15 +571,47 @@ class SpfSolver::SpfSolverImpl {
       std::string const& myNodeName,
       thrift::IpPrefix const& prefix,
       std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
-      LinkState const& linkState);
+      LinkState const& linkState,
+      PrefixState const& prefixState);
 
+  // Best announcing nodes of prefix. Successful results for this node are
+  // cached across route builds, see BestAnnouncersEntry
   BestPathCalResult getBestAnnouncingNodes(
       std::string const& myNodeName,
       thrift::IpPrefix const& prefix,
       std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
       bool const hasBgp,
       bool const useKsp2EdAlgo,
-      LinkState const& linkState);
+      LinkState const& linkState,
+      PrefixState const& prefixState);
+
+  BestPathCalResult computeBestAnnouncingNodes(
+      std::string const& myNodeName,
+      thrift::IpPrefix const& prefix,
+      std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
+      bool const hasBgp,
+      bool const useKsp2EdAlgo,
+      LinkState const& linkState,
+      PrefixState const& prefixState);
+
+  // state of an announcing node which selection of best announcing nodes
+  // depends on besides prefix entries: its overload bit and, for BGP
+  // selection only, SPF metric from myNodeName (std::nullopt if unreachable)
+  struct AnnouncerState {
+    bool overloaded{false};
+    std::optional<LinkStateMetric> metric;
+
+    bool
+    operator==(AnnouncerState const& other) const {
+      return overloaded == other.overloaded and metric == other.metric;
+    }
+  };
+
+  AnnouncerState getAnnouncerState(
+      std::string const& myNodeName,
+      std::string const& nodeName,
+      bool const hasBgp,
+      LinkState const& linkState) const;
 
   // helper to get min nexthop for a prefix, used in selectKsp2
   std::optional<int64_t> getMinNextHopThreshold(
@@ -239,8 +639,9 @@ class SpfSolver::SpfSolverImpl {
   // which can then be passed to FIB for programming. It considers LFA and
   // parallel link logic (tested by our UT)
   // If swap label is provided then it will be used to associate SWAP or PHP
-  // mpls action
-  std::unordered_set<thrift::NextHopThrift> getNextHopsThrift(
+  // mpls action. With UCMP, shortest path nexthops are weighted by weight of
+  // their adjacencies, normalized with normalizeNextHopWeights()
+  NextHopSet getNextHopsThrift(
       const std::string& myNodeName,
       const std::set<std::string>& dstNodeNames,
       bool isV4,
@@ -251,7 +652,56 @@ class SpfSolver::SpfSolverImpl {
       std::optional<int32_t> swapLabel,
       LinkState const& linkState) const;
 
+  // Nexthops of unicast route towards dstNodeNames, memoized during the route
+  // build of the area as many prefixes are announced by the same nodes.
+  // Returns nullptr if none of dstNodeNames is reachable
+  std::shared_ptr<const NextHopSet> getUnicastNextHops(
+      const std::string& myNodeName,
+      const std::set<std::string>& dstNodeNames,
+      bool isV4,
+      bool perDestination,
+      LinkState const& linkState);
+
   thrift::StaticRoutes staticRoutes_;
+  std::unordered_map<thrift::IpPrefix, RibUnicastEntry> staticUnicastRoutes_;
+
+  // memoized nexthops of unicast routes, keyed by announcing nodes, isV4 and
+  // perDestination (i.e. SR_MPLS forwarding type)
+  using NextHopsKey = std::tuple<std::set<std::string>, bool, bool>;
+  struct NextHopsMemo {
+    std::map<NextHopsKey, std::shared_ptr<const NextHopSet>> nextHops;
+    uint64_t hits{0};
+    uint64_t misses{0};
+  };
+
+  // nexthop memo of each area being built. Areas and shards of an area are
+  // built concurrently, nextHopsMutex_ guards the memos
+  std::mutex nextHopsMutex_;
+  std::unordered_map<std::string /* area */, NextHopsMemo> nextHopsMemos_;
+
+  // Cached best announcing nodes of a prefix, valid as long as entries of
+  // the prefix (i.e. their version in PrefixState) and state of each of its
+  // announcers are unchanged. Announcers are in iteration order of the
+  // prefix entries, which is stable while their version is
+  struct BestAnnouncersEntry {
+    uint64_t prefixVersion{0};
+    bool hasBgp{false};
+    bool useKsp2EdAlgo{false};
+    std::vector<AnnouncerState> announcers;
+    BestPathCalResult result;
+  };
+  struct BestAnnouncersCache {
+    std::unordered_map<IpPrefixKey, BestAnnouncersEntry> entries;
+    uint64_t hits{0};
+    uint64_t misses{0};
+  };
+
+  // best announcing nodes cache of each area, for routes of myNodeName_.
+  // Shards of an area look up distinct prefixes concurrently,
+  // bestAnnouncersMutex_ guards the caches
+  std::mutex bestAnnouncersMutex_;
+  std::unordered_map<std::string /* area */, BestAnnouncersCache>
+      bestAnnouncersCaches_;
 
   std::vector<thrift::RouteDatabaseDelta> staticRoutesUpdates_;
 
@@ -269,6 +719,14 @@ class SpfSolver::SpfSolverImpl {
 
   // Use IGP metric in metric vector comparision
   const bool bgpUseIgpMetric_{false};
+
+  // Weight shortest path nexthops by weight of their adjacencies
+  const bool enableUcmp_{false};
+
+  // pool used to build unicast routes of large prefix sets in shards. Kept
+  // apart from Decision's per-area pool so that a shard never waits on a
+  // thread that is itself blocked waiting for shards
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeBuildExecutor_;
 };
 
 bool
@@ -287,11 +745,18 @@ SpfSolver::SpfSolverImpl::getStaticRoutes() {
   return staticRoutes_;
 }
 
+std::unordered_map<thrift::IpPrefix, RibUnicastEntry> const&
+SpfSolver::SpfSolverImpl::getStaticUnicastRoutes() {
+  return staticUnicastRoutes_;
+}
+
 std::optional<DecisionRouteDb>
 SpfSolver::SpfSolverImpl::buildRouteDb(
     const std::string& myNodeName,
     LinkState const& linkState,
-    PrefixState const& prefixState) {
+    PrefixState const& prefixState,
+    std::unordered_set<thrift::IpPrefix> const* prefixes,
+    std::unordered_set<std::string> const* labelNodes) {
   if (not linkState.hasNode(myNodeName)) {
     return std::nullopt;
   }
@@ -299,107 +764,114 @@ SpfSolver::SpfSolverImpl::buildRouteDb(
   const auto startTime = std::chrono::steady_clock::now();
   fb303::fbData->addStatValue("decision.route_build_runs", 1, fb303::COUNT);
 
+  // no references into memoized results are held between route builds
+  linkState.evictMemoization();
+
+  // nexthops are memoized for the duration of this route build only
+  {
+    std::lock_guard<std::mutex> lock(nextHopsMutex_);
+    nextHopsMemos_[linkState.getArea()] = NextHopsMemo{};
+  }
+
   DecisionRouteDb routeDb{};
 
+  // SPF result of this node is used by all routes, compute it up front to
+  // time it on its own
+  {
+    ScopedPhaseTimer timer("spf");
+    linkState.getSpfResult(myNodeName);
+  }
+
   //
   // Calculate unicast route best paths: IP and IP2MPLS routes
   //
 
-  for (const auto& kv : prefixState.prefixes()) {
-    const auto& prefix = kv.first;
-    const auto& nodePrefixes = kv.second;
-
-    bool hasBGP = false, hasNonBGP = false, missingMv = false;
-    bool hasSpEcmp = false, hasKsp2EdEcmp = false;
-    for (auto const& npKv : nodePrefixes) {
-      bool isBGP = npKv.second.type == thrift::PrefixType::BGP;
-      hasBGP |= isBGP;
-      hasNonBGP |= !isBGP;
-      if (isBGP and not npKv.second.mv_ref().has_value()) {
-        missingMv = true;
-        LOG(ERROR) << "Prefix entry for prefix " << toString(npKv.second.prefix)
-                   << " advertised by " << npKv.first
-                   << " is of type BGP but does not contain a metric vector.";
-      }
-      hasSpEcmp |= npKv.second.forwardingAlgorithm ==
-          thrift::PrefixForwardingAlgorithm::SP_ECMP;
-      hasKsp2EdEcmp |= npKv.second.forwardingAlgorithm ==
-          thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
-    }
-
-    // skip adding route for BGP prefixes that have issues
-    if (hasBGP) {
-      if (hasNonBGP) {
-        LOG(ERROR) << "Skipping route for prefix " << toString(prefix)
-                   << " which is advertised with BGP and non-BGP type.";
-        fb303::fbData->addStatValue(
-            "decision.skipped_unicast_route", 1, fb303::COUNT);
-        continue;
-      }
-      if (missingMv) {
-        LOG(ERROR) << "Skipping route for prefix " << toString(prefix)
-                   << " at least one advertiser is missing its metric vector.";
-        fb303::fbData->addStatValue(
-            "decision.skipped_unicast_route", 1, fb303::COUNT);
+  auto const& allPrefixes = prefixState.prefixes();
+  const size_t numShards = routeBuildExecutor_ and not prefixes
+      ? std::min<size_t>(
+            routeBuildExecutor_->numThreads(),
+            allPrefixes.size() / Constants::kDecisionMinPrefixesPerShard)
+      : 1;
+  {
+    ScopedPhaseTimer timer("ksp2");
+    precomputeKsp2Paths(myNodeName, linkState, prefixState, prefixes);
+  }
+  std::optional<ScopedPhaseTimer> unicastTimer;
+  unicastTimer.emplace("unicast_routes");
+  if (prefixes) {
+    for (auto const& prefix : *prefixes) {
+      auto it = allPrefixes.find(IpPrefixKey(prefix));
+      if (it == allPrefixes.end()) {
+        // withdrawn by all nodes
         continue;
       }
-    }
-
-    // skip adding route for prefixes advertised by this node
-    if (nodePrefixes.count(myNodeName) and not hasBGP) {
-      continue;
-    }
-
-    // Check for enabledV4_
-    auto prefixStr = prefix.prefixAddress.addr;
-    bool isV4Prefix = prefixStr.size() == folly::IPAddressV4::byteCount();
-    if (isV4Prefix && !enableV4_) {
-      LOG(WARNING) << "Received v4 prefix while v4 is not enabled.";
-      fb303::fbData->addStatValue(
-          "decision.skipped_unicast_route", 1, fb303::COUNT);
-      continue;
-    }
-
-    if (hasSpEcmp and hasBGP) {
-      selectEcmpBgp(
+      buildUnicastRoute(
           routeDb.unicastEntries,
           myNodeName,
           prefix,
-          nodePrefixes,
-          isV4Prefix,
+          it->second,
           linkState,
           prefixState);
-    } else if (hasSpEcmp) {
-      selectEcmpOpenr(
-          routeDb.unicastEntries,
-          myNodeName,
-          prefix,
-          nodePrefixes,
-          isV4Prefix,
-          linkState);
-    } else {
-      const auto nodes = getBestAnnouncingNodes(
-          myNodeName, prefix, nodePrefixes, hasBGP, true, linkState);
-      if (not nodes.success or nodes.nodes.size() == 0) {
-        continue;
-      }
-      selectKsp2(
+    }
+  } else if (numShards <= 1) {
+    for (const auto& [_, nodePrefixes] : allPrefixes) {
+      buildUnicastRoute(
           routeDb.unicastEntries,
-          prefix,
           myNodeName,
-          nodes,
+          PrefixState::getPrefix(nodePrefixes),
           nodePrefixes,
-          hasBGP,
           linkState,
           prefixState);
     }
-  } // for prefixState.prefixes()
+  } else {
+    buildUnicastRoutesSharded(
+        routeDb.unicastEntries, numShards, myNodeName, linkState, prefixState);
+  }
+  unicastTimer.reset();
+  {
+    std::lock_guard<std::mutex> lock(nextHopsMutex_);
+    auto it = nextHopsMemos_.find(linkState.getArea());
+    fb303::fbData->addStatValue(
+        "decision.nexthop_memo_hits", it->second.hits, fb303::SUM);
+    fb303::fbData->addStatValue(
+        "decision.nexthop_memo_misses", it->second.misses, fb303::SUM);
+    nextHopsMemos_.erase(it);
+  }
+  {
+    std::lock_guard<std::mutex> lock(bestAnnouncersMutex_);
+    auto& cache = bestAnnouncersCaches_[linkState.getArea()];
+    fb303::fbData->addStatValue(
+        "decision.best_announcers_cache_hits", cache.hits, fb303::SUM);
+    fb303::fbData->addStatValue(
+        "decision.best_announcers_cache_misses", cache.misses, fb303::SUM);
+    cache.hits = 0;
+    cache.misses = 0;
+    // forget prefixes withdrawn by all nodes, in O(changes) on incremental
+    // builds
+    if (prefixes) {
+      for (auto const& prefix : *prefixes) {
+        IpPrefixKey key(prefix);
+        if (not allPrefixes.count(key)) {
+          cache.entries.erase(key);
+        }
+      }
+    } else {
+      for (auto it = cache.entries.begin(); it != cache.entries.end();) {
+        it = allPrefixes.count(it->first) ? std::next(it)
+                                          : cache.entries.erase(it);
+      }
+    }
+  }
 
   //
   // Create MPLS routes for all nodeLabel
   //
+  ScopedPhaseTimer mplsTimer("mpls_routes");
   std::unordered_map<int32_t, std::pair<std::string, RibMplsEntry>> labelToNode;
   for (const auto& kv : linkState.getAdjacencyDatabases()) {
+    if (labelNodes and not labelNodes->count(kv.first)) {
+      continue;
+    }
     const auto& adjDb = kv.second;
     const auto topLabel = adjDb.nodeLabel;
     // Top label is not set => Non-SR mode
@@ -483,32 +955,34 @@ SpfSolver::SpfSolverImpl::buildRouteDb(
   //
   // Create MPLS routes for all of our adjacencies
   //
-  for (const auto& link : linkState.linksFromNode(myNodeName)) {
-    const auto topLabel = link->getAdjLabelFromNode(myNodeName);
-    // Top label is not set => Non-SR mode
-    if (topLabel == 0) {
-      continue;
-    }
-    // If mpls label is not valid then ignore it
-    if (not isMplsLabelValid(topLabel)) {
-      LOG(ERROR) << "Ignoring invalid adjacency label " << topLabel
-                 << " of link " << link->directionalToString(myNodeName);
-      fb303::fbData->addStatValue(
-          "decision.skipped_mpls_route", 1, fb303::COUNT);
-      continue;
-    }
+  if (not labelNodes) {
+    for (const auto& link : linkState.linksFromNode(myNodeName)) {
+      const auto topLabel = link->getAdjLabelFromNode(myNodeName);
+      // Top label is not set => Non-SR mode
+      if (topLabel == 0) {
+        continue;
+      }
+      // If mpls label is not valid then ignore it
+      if (not isMplsLabelValid(topLabel)) {
+        LOG(ERROR) << "Ignoring invalid adjacency label " << topLabel
+                   << " of link " << link->directionalToString(myNodeName);
+        fb303::fbData->addStatValue(
+            "decision.skipped_mpls_route", 1, fb303::COUNT);
+        continue;
+      }
 
-    routeDb.mplsEntries.emplace(
-        topLabel,
-        RibMplsEntry(
-            topLabel,
-            {createNextHop(
-                link->getNhV6FromNode(myNodeName),
-                link->getIfaceFromNode(myNodeName),
-                link->getMetricFromNode(myNodeName),
-                createMplsAction(thrift::MplsActionCode::PHP),
-                false /* useNonShortestRoute */,
-                link->getArea())}));
+      routeDb.mplsEntries.emplace(
+          topLabel,
+          RibMplsEntry(
+              topLabel,
+              {createNextHop(
+                  link->getNhV6FromNode(myNodeName),
+                  link->getIfaceFromNode(myNodeName),
+                  link->getMetricFromNode(myNodeName),
+                  createMplsAction(thrift::MplsActionCode::PHP),
+                  false /* useNonShortestRoute */,
+                  link->getArea())}));
+    }
   }
 
   auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -519,50 +993,378 @@ SpfSolver::SpfSolverImpl::buildRouteDb(
   return routeDb;
 } // buildRouteDb
 
-BestPathCalResult
-SpfSolver::SpfSolverImpl::getBestAnnouncingNodes(
-    std::string const& myNodeName,
+void
+SpfSolver::SpfSolverImpl::buildUnicastRoute(
+    std::unordered_map<thrift::IpPrefix, RibUnicastEntry>& unicastEntries,
+    const std::string& myNodeName,
     thrift::IpPrefix const& prefix,
     std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
-    bool const hasBgp,
-    bool const useKsp2EdAlgo,
-    LinkState const& linkState) {
-  BestPathCalResult dstNodes;
-  if (useKsp2EdAlgo) {
-    for (const auto& nodePrefix : nodePrefixes) {
-      if (nodePrefix.second.forwardingType !=
-          thrift::PrefixForwardingType::SR_MPLS) {
-        LOG(ERROR) << nodePrefix.first << " has incompatible forwarding type "
-                   << TEnumTraits<thrift::PrefixForwardingType>::findName(
-                          nodePrefix.second.forwardingType)
-                   << " for algorithm KSP2_ED_ECMP;";
-        fb303::fbData->addStatValue(
-            "decision.incompatible_forwarding_type", 1, fb303::COUNT);
-        return dstNodes;
-      }
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
+  bool hasBGP = false, hasNonBGP = false, missingMv = false;
+  bool hasSpEcmp = false, hasKsp2EdEcmp = false;
+  for (auto const& npKv : nodePrefixes) {
+    bool isBGP = npKv.second.type == thrift::PrefixType::BGP;
+    hasBGP |= isBGP;
+    hasNonBGP |= !isBGP;
+    if (isBGP and not npKv.second.mv_ref().has_value()) {
+      missingMv = true;
+      LOG(ERROR) << "Prefix entry for prefix " << toString(npKv.second.prefix)
+                 << " advertised by " << npKv.first
+                 << " is of type BGP but does not contain a metric vector.";
     }
+    hasSpEcmp |= npKv.second.forwardingAlgorithm ==
+        thrift::PrefixForwardingAlgorithm::SP_ECMP;
+    hasKsp2EdEcmp |= npKv.second.forwardingAlgorithm ==
+        thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
   }
 
-  // if it is openr route, all nodes are considered as best nodes.
-  if (not hasBgp) {
-    for (const auto& kv : nodePrefixes) {
-      if (kv.first == myNodeName) {
-        dstNodes.nodes.clear();
-        return dstNodes;
-      }
-      dstNodes.nodes.insert(kv.first);
+  // skip adding route for BGP prefixes that have issues
+  if (hasBGP) {
+    if (hasNonBGP) {
+      LOG(ERROR) << "Skipping route for prefix " << toString(prefix)
+                 << " which is advertised with BGP and non-BGP type.";
+      fb303::fbData->addStatValue(
+          "decision.skipped_unicast_route", 1, fb303::COUNT);
+      return;
+    }
+    if (missingMv) {
+      LOG(ERROR) << "Skipping route for prefix " << toString(prefix)
+                 << " at least one advertiser is missing its metric vector.";
+      fb303::fbData->addStatValue(
+          "decision.skipped_unicast_route", 1, fb303::COUNT);
+      return;
     }
-    dstNodes.success = true;
-    return maybeFilterDrainedNodes(std::move(dstNodes), linkState);
   }
 
-  // for bgp route, we need to run best path calculation algorithm to get
-  // the nodes
-  auto bestPathCalRes =
-      runBestPathSelectionBgp(myNodeName, prefix, nodePrefixes, linkState);
+  // skip adding route for prefixes advertised by this node
+  if (nodePrefixes.count(myNodeName) and not hasBGP) {
+    return;
+  }
 
-  // best path calculation failure
-  if (not bestPathCalRes.success) {
+  // Check for enabledV4_
+  auto prefixStr = prefix.prefixAddress.addr;
+  bool isV4Prefix = prefixStr.size() == folly::IPAddressV4::byteCount();
+  if (isV4Prefix && !enableV4_) {
+    LOG(WARNING) << "Received v4 prefix while v4 is not enabled.";
+    fb303::fbData->addStatValue(
+        "decision.skipped_unicast_route", 1, fb303::COUNT);
+    return;
+  }
+
+  if (hasSpEcmp and hasBGP) {
+    selectEcmpBgp(
+        unicastEntries,
+        myNodeName,
+        prefix,
+        nodePrefixes,
+        isV4Prefix,
+        linkState,
+        prefixState);
+  } else if (hasSpEcmp) {
+    selectEcmpOpenr(
+        unicastEntries,
+        myNodeName,
+        prefix,
+        nodePrefixes,
+        isV4Prefix,
+        linkState,
+        prefixState);
+  } else {
+    const auto nodes = getBestAnnouncingNodes(
+        myNodeName,
+        prefix,
+        nodePrefixes,
+        hasBGP,
+        true,
+        linkState,
+        prefixState);
+    if (not nodes.success or nodes.nodes.size() == 0) {
+      return;
+    }
+    selectKsp2(
+        unicastEntries,
+        prefix,
+        myNodeName,
+        nodes,
+        nodePrefixes,
+        hasBGP,
+        linkState,
+        prefixState);
+  }
+}
+
+void
+SpfSolver::SpfSolverImpl::buildUnicastRoutesSharded(
+    std::unordered_map<thrift::IpPrefix, RibUnicastEntry>& unicastEntries,
+    size_t numShards,
+    const std::string& myNodeName,
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
+  // compute the SPF results every prefix needs up front, so that the shards
+  // mostly read memoized results instead of contending on computing them
+  linkState.getSpfResult(myNodeName);
+  if (computeLfaPaths_) {
+    for (auto const& link : linkState.linksFromNode(myNodeName)) {
+      if (link->isUp()) {
+        linkState.getSpfResult(link->getOtherNodeName(myNodeName));
+      }
+    }
+  }
+
+  std::vector<PrefixState::PrefixEntries const*> prefixes;
+  prefixes.reserve(prefixState.prefixes().size());
+  for (auto const& kv : prefixState.prefixes()) {
+    prefixes.emplace_back(&kv.second);
+  }
+
+  // each shard builds routes for a contiguous range of prefixes into its own
+  // map. Nothing else is written while shards run, linkState and prefixState
+  // are only read (LinkState guards its own memoization)
+  std::vector<std::unordered_map<thrift::IpPrefix, RibUnicastEntry>>
+      shardEntries(numShards);
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  futures.reserve(numShards);
+  const size_t shardSize = (prefixes.size() + numShards - 1) / numShards;
+  for (size_t shard = 0; shard < numShards; ++shard) {
+    auto task = [&, shard]() {
+      const size_t begin = shard * shardSize;
+      const size_t end = std::min(prefixes.size(), begin + shardSize);
+      for (size_t i = begin; i < end; ++i) {
+        buildUnicastRoute(
+            shardEntries[shard],
+            myNodeName,
+            PrefixState::getPrefix(*prefixes[i]),
+            *prefixes[i],
+            linkState,
+            prefixState);
+      }
+    };
+    futures.emplace_back(
+        folly::via(routeBuildExecutor_.get(), std::move(task)).semi());
+  }
+  // rethrows the first exception of any shard
+  folly::collect(std::move(futures)).get();
+
+  for (auto& entries : shardEntries) {
+    unicastEntries.merge(entries);
+  }
+}
+
+void
+SpfSolver::SpfSolverImpl::precomputeKsp2Paths(
+    const std::string& myNodeName,
+    LinkState const& linkState,
+    PrefixState const& prefixState,
+    std::unordered_set<thrift::IpPrefix> const* prefixes) {
+  std::unordered_set<std::string> nodeSet;
+  auto const addNodes =
+      [&](std::unordered_map<std::string, thrift::PrefixEntry> const&
+              nodePrefixes) {
+        for (auto const& [node, prefixEntry] : nodePrefixes) {
+          if (node != myNodeName and
+              prefixEntry.forwardingAlgorithm ==
+                  thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP) {
+            nodeSet.emplace(node);
+          }
+        }
+      };
+  auto const& allPrefixes = prefixState.prefixes();
+  if (prefixes) {
+    for (auto const& prefix : *prefixes) {
+      auto it = allPrefixes.find(IpPrefixKey(prefix));
+      if (it != allPrefixes.end()) {
+        addNodes(it->second);
+      }
+    }
+  } else {
+    for (auto const& kv : allPrefixes) {
+      addNodes(kv.second);
+    }
+  }
+  if (nodeSet.empty()) {
+    return;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  // interns myNodeName, so that paths can be computed concurrently
+  linkState.getSpfResult(myNodeName);
+
+  std::vector<std::string> nodes(nodeSet.begin(), nodeSet.end());
+  const size_t numTasks = routeBuildExecutor_
+      ? std::min(routeBuildExecutor_->numThreads(), nodes.size())
+      : 1;
+  auto const computePaths = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      linkState.getKthPaths(myNodeName, nodes[i], 2);
+    }
+  };
+  if (numTasks <= 1) {
+    computePaths(0, nodes.size());
+  } else {
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    futures.reserve(numTasks);
+    const size_t taskSize = (nodes.size() + numTasks - 1) / numTasks;
+    for (size_t task = 0; task < numTasks; ++task) {
+      const size_t begin = task * taskSize;
+      const size_t end = std::min(nodes.size(), begin + taskSize);
+      futures.emplace_back(
+          folly::via(routeBuildExecutor_.get(), [&, begin, end]() {
+            computePaths(begin, end);
+          }).semi());
+    }
+    // rethrows the first exception of any task
+    folly::collect(std::move(futures)).get();
+  }
+
+  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  VLOG(2) << "KSP2 paths towards " << nodes.size() << " nodes took "
+          << deltaTime.count() << "ms.";
+  fb303::fbData->addStatValue(
+      "decision.ksp2_ms", deltaTime.count(), fb303::AVG);
+}
+
+SpfSolver::SpfSolverImpl::AnnouncerState
+SpfSolver::SpfSolverImpl::getAnnouncerState(
+    std::string const& myNodeName,
+    std::string const& nodeName,
+    bool const hasBgp,
+    LinkState const& linkState) const {
+  AnnouncerState state;
+  state.overloaded = linkState.isNodeOverloaded(nodeName);
+  if (hasBgp) {
+    // reachability and IGP metric are only considered by BGP selection
+    auto const* nodeSpfResult =
+        linkState.getSpfResult(myNodeName).get(nodeName);
+    if (nodeSpfResult) {
+      state.metric = nodeSpfResult->metric();
+    }
+  }
+  return state;
+}
+
+BestPathCalResult
+SpfSolver::SpfSolverImpl::getBestAnnouncingNodes(
+    std::string const& myNodeName,
+    thrift::IpPrefix const& prefix,
+    std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
+    bool const hasBgp,
+    bool const useKsp2EdAlgo,
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
+  // routes of other nodes are built on demand only, don't cache them
+  if (myNodeName != myNodeName_) {
+    return computeBestAnnouncingNodes(
+        myNodeName,
+        prefix,
+        nodePrefixes,
+        hasBgp,
+        useKsp2EdAlgo,
+        linkState,
+        prefixState);
+  }
+
+  const IpPrefixKey key(prefix);
+  const auto prefixVersion = prefixState.getPrefixVersion(prefix);
+  {
+    std::lock_guard<std::mutex> lock(bestAnnouncersMutex_);
+    auto& cache = bestAnnouncersCaches_[linkState.getArea()];
+    auto it = cache.entries.find(key);
+    if (it != cache.entries.end() and
+        it->second.prefixVersion == prefixVersion and
+        it->second.hasBgp == hasBgp and
+        it->second.useKsp2EdAlgo == useKsp2EdAlgo) {
+      auto const& entry = it->second;
+      bool valid = entry.announcers.size() == nodePrefixes.size();
+      size_t i = 0;
+      for (auto nodeIt = nodePrefixes.begin();
+           valid and nodeIt != nodePrefixes.end();
+           ++nodeIt, ++i) {
+        valid = entry.announcers[i] ==
+            getAnnouncerState(myNodeName, nodeIt->first, hasBgp, linkState);
+      }
+      if (valid) {
+        ++cache.hits;
+        return entry.result;
+      }
+    }
+    ++cache.misses;
+  }
+
+  auto result = computeBestAnnouncingNodes(
+      myNodeName,
+      prefix,
+      nodePrefixes,
+      hasBgp,
+      useKsp2EdAlgo,
+      linkState,
+      prefixState);
+  // failures are logged and counted on every route build, don't cache them
+  if (not result.success) {
+    return result;
+  }
+
+  BestAnnouncersEntry entry;
+  entry.prefixVersion = prefixVersion;
+  entry.hasBgp = hasBgp;
+  entry.useKsp2EdAlgo = useKsp2EdAlgo;
+  entry.announcers.reserve(nodePrefixes.size());
+  for (auto const& [nodeName, _] : nodePrefixes) {
+    entry.announcers.emplace_back(
+        getAnnouncerState(myNodeName, nodeName, hasBgp, linkState));
+  }
+  entry.result = result;
+  std::lock_guard<std::mutex> lock(bestAnnouncersMutex_);
+  bestAnnouncersCaches_[linkState.getArea()].entries[key] = std::move(entry);
+  return result;
+}
+
+BestPathCalResult
+SpfSolver::SpfSolverImpl::computeBestAnnouncingNodes(
+    std::string const& myNodeName,
+    thrift::IpPrefix const& prefix,
+    std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
+    bool const hasBgp,
+    bool const useKsp2EdAlgo,
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
+  BestPathCalResult dstNodes;
+  if (useKsp2EdAlgo) {
+    for (const auto& nodePrefix : nodePrefixes) {
+      if (nodePrefix.second.forwardingType !=
+          thrift::PrefixForwardingType::SR_MPLS) {
+        LOG(ERROR) << nodePrefix.first << " has incompatible forwarding type "
+                   << TEnumTraits<thrift::PrefixForwardingType>::findName(
+                          nodePrefix.second.forwardingType)
+                   << " for algorithm KSP2_ED_ECMP;";
+        fb303::fbData->addStatValue(
+            "decision.incompatible_forwarding_type", 1, fb303::COUNT);
+        return dstNodes;
+      }
+    }
+  }
+
+  // if it is openr route, all nodes are considered as best nodes.
+  if (not hasBgp) {
+    for (const auto& kv : nodePrefixes) {
+      if (kv.first == myNodeName) {
+        dstNodes.nodes.clear();
+        return dstNodes;
+      }
+      dstNodes.nodes.insert(kv.first);
+    }
+    dstNodes.success = true;
+    return maybeFilterDrainedNodes(std::move(dstNodes), linkState);
+  }
+
+  // for bgp route, we need to run best path calculation algorithm to get
+  // the nodes
+  auto bestPathCalRes = runBestPathSelectionBgp(
+      myNodeName, prefix, nodePrefixes, linkState, prefixState);
+
+  // best path calculation failure
+  if (not bestPathCalRes.success) {
     LOG(WARNING) << "No route to BGP prefix " << toString(prefix);
     fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
     return dstNodes;
@@ -637,10 +1439,11 @@ SpfSolver::SpfSolverImpl::selectEcmpOpenr(
     thrift::IpPrefix const& prefix,
     std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
     bool const isV4,
-    LinkState const& linkState) {
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
   // Prepare list of nodes announcing the prefix
   const auto& ret = getBestAnnouncingNodes(
-      myNodeName, prefix, nodePrefixes, false, false, linkState);
+      myNodeName, prefix, nodePrefixes, false, false, linkState, prefixState);
   if (not ret.success) {
     return;
   }
@@ -650,9 +1453,9 @@ SpfSolver::SpfSolverImpl::selectEcmpOpenr(
   const bool perDestination = getPrefixForwardingType(nodePrefixes) ==
       thrift::PrefixForwardingType::SR_MPLS;
 
-  const auto metricNhs =
-      getNextHopsWithMetric(myNodeName, prefixNodes, perDestination, linkState);
-  if (metricNhs.second.empty()) {
+  const auto nextHops = getUnicastNextHops(
+      myNodeName, prefixNodes, isV4, perDestination, linkState);
+  if (not nextHops) {
     LOG(WARNING) << "No route to prefix " << toString(prefix)
                  << ", advertised by: " << folly::join(", ", prefixNodes);
     fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
@@ -660,15 +1463,21 @@ SpfSolver::SpfSolverImpl::selectEcmpOpenr(
   }
 
   RibUnicastEntry entry(toIPNetwork(prefix));
-  entry.nexthops = getNextHopsThrift(
-      myNodeName,
-      prefixNodes,
-      isV4,
-      perDestination,
-      metricNhs.first,
-      metricNhs.second,
-      std::nullopt,
-      linkState);
+  entry.nexthops = *nextHops;
+
+  // With LFAs, routes carry alternates along with the shortest nexthops, and
+  // Fib falls back to them locally on interface down. Report prefixes which
+  // can't survive failure of a single interface
+  if (computeLfaPaths_) {
+    std::unordered_set<std::string> ifNames;
+    for (auto const& nh : entry.nexthops) {
+      ifNames.emplace(nh.address.ifName_ref().value_or(""));
+    }
+    if (ifNames.size() < 2) {
+      fb303::fbData->addStatValue(
+          "decision.lfa_unprotected_prefixes", 1, fb303::COUNT);
+    }
+  }
   // TODO add openr bestPrefixEntry.
   unicastEntries.emplace(prefix, std::move(entry));
 }
@@ -678,25 +1487,34 @@ SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
     std::string const& myNodeName,
     thrift::IpPrefix const& prefix,
     std::unordered_map<std::string, thrift::PrefixEntry> const& nodePrefixes,
-    LinkState const& linkState) {
+    LinkState const& linkState,
+    PrefixState const& prefixState) {
   BestPathCalResult ret;
   auto const& mySpfResult = linkState.getSpfResult(myNodeName);
   for (auto const& kv : nodePrefixes) {
     auto const& nodeName = kv.first;
-    auto const& prefixEntry = kv.second;
 
     // Skip unreachable nodes
-    auto it = mySpfResult.find(nodeName);
-    if (it == mySpfResult.end()) {
+    auto const* nodeSpfResult = mySpfResult.get(nodeName);
+    if (!nodeSpfResult) {
       LOG(ERROR) << "No route to " << nodeName
                  << ". Skipping considering this.";
       // skip if no route to node
       continue;
     }
 
+    // metric vector compiled when prefix entry was received
+    auto const* compiledVector =
+        prefixState.getCompiledMetricVector(prefix, nodeName);
+    if (!compiledVector) {
+      LOG(ERROR) << "Missing metric vector for prefix " << toString(prefix)
+                 << " from node " << nodeName << ". Ignoring";
+      continue;
+    }
+
     // Sanity check that OPENR_IGP_COST shouldn't exist
-    if (MetricVectorUtils::getMetricEntityByType(
-            prefixEntry.mv_ref().value(),
+    if (MetricVectorUtils::hasMetricEntityOfType(
+            *compiledVector,
             static_cast<int64_t>(thrift::MetricEntityType::OPENR_IGP_COST))) {
       LOG(ERROR) << "Received unexpected metric entity OPENR_IGP_COST in metric"
                  << " vector for prefix " << toString(prefix) << " from node "
@@ -704,28 +1522,32 @@ SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
       continue;
     }
 
-    // Copy is intentional - As we will need to augment metric vector with
-    // IGP_COST
-    thrift::MetricVector metricVector = prefixEntry.mv_ref().value();
+    // Copy is only needed to augment metric vector with IGP_COST
+    std::optional<MetricVectorUtils::CompiledMetricVector> igpVector;
 
     // Associate IGP_COST to prefixEntry
     if (bgpUseIgpMetric_) {
-      const auto igpMetric = static_cast<int64_t>(it->second.metric());
+      const auto igpMetric = static_cast<int64_t>(nodeSpfResult->metric());
       if (not ret.bestIgpMetric.has_value() or
           *(ret.bestIgpMetric) > igpMetric) {
         ret.bestIgpMetric = igpMetric;
       }
-      metricVector.metrics.emplace_back(MetricVectorUtils::createMetricEntity(
-          static_cast<int64_t>(thrift::MetricEntityType::OPENR_IGP_COST),
-          static_cast<int64_t>(thrift::MetricEntityPriority::OPENR_IGP_COST),
-          thrift::CompareType::WIN_IF_NOT_PRESENT,
-          false, /* isBestPathTieBreaker */
-          /* lowest metric wins */
-          {-1 * igpMetric}));
+      igpVector = *compiledVector;
+      MetricVectorUtils::addMetricEntity(
+          *igpVector,
+          MetricVectorUtils::createMetricEntity(
+              static_cast<int64_t>(thrift::MetricEntityType::OPENR_IGP_COST),
+              static_cast<int64_t>(
+                  thrift::MetricEntityPriority::OPENR_IGP_COST),
+              thrift::CompareType::WIN_IF_NOT_PRESENT,
+              false, /* isBestPathTieBreaker */
+              /* lowest metric wins */
+              {-1 * igpMetric}));
       VLOG(2) << "Attaching IGP metric of " << igpMetric << " to prefix "
               << toString(prefix) << " for node " << nodeName;
     }
 
+    auto const& metricVector = igpVector ? *igpVector : *compiledVector;
     switch (ret.bestVector.has_value()
                 ? MetricVectorUtils::compareMetricVectors(
                       metricVector, *(ret.bestVector))
@@ -734,7 +1556,7 @@ SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
       ret.nodes.clear();
       FOLLY_FALLTHROUGH;
     case MetricVectorUtils::CompareResult::TIE_WINNER:
-      ret.bestVector = std::move(metricVector);
+      ret.bestVector = metricVector;
       ret.bestNode = nodeName;
       FOLLY_FALLTHROUGH;
     case MetricVectorUtils::CompareResult::TIE_LOOSER:
@@ -768,10 +1590,9 @@ SpfSolver::SpfSolverImpl::selectEcmpBgp(
   std::string bestNode;
   // order is intended to comply with API used later.
   std::set<std::string> nodes;
-  std::optional<thrift::MetricVector> bestVector{std::nullopt};
 
   const auto dstInfo = getBestAnnouncingNodes(
-      myNodeName, prefix, nodePrefixes, true, false, linkState);
+      myNodeName, prefix, nodePrefixes, true, false, linkState, prefixState);
   if (not dstInfo.success) {
     return;
   }
@@ -797,20 +1618,17 @@ SpfSolver::SpfSolverImpl::selectEcmpBgp(
     return;
   }
 
-  const auto nextHopsWithMetric =
-      getNextHopsWithMetric(myNodeName, dstInfo.nodes, false, linkState);
+  const auto nextHops =
+      getUnicastNextHops(myNodeName, dstInfo.nodes, isV4, false, linkState);
+  if (not nextHops) {
+    LOG(WARNING) << "No route to BGP prefix " << toString(prefix);
+    fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
+    return;
+  }
 
   RibUnicastEntry entry(
       toIPNetwork(prefix),
-      getNextHopsThrift(
-          myNodeName,
-          dstInfo.nodes,
-          isV4,
-          false,
-          nextHopsWithMetric.first,
-          nextHopsWithMetric.second,
-          std::nullopt,
-          linkState), // nexthops
+      *nextHops, // nexthops
       thrift::PrefixEntry(
           nodePrefixes.find(dstInfo.bestNode)->second), // bestPrefixEntry
       bgpDryRun_, // doNotInstall
@@ -820,46 +1638,84 @@ SpfSolver::SpfSolverImpl::selectEcmpBgp(
   unicastEntries.emplace(prefix, std::move(entry));
 }
 
-std::optional<thrift::RouteDatabaseDelta>
+StaticRoutesUpdate
 SpfSolver::SpfSolverImpl::processStaticRouteUpdates() {
-  std::unordered_map<int32_t, thrift::MplsRoute> routesToUpdate;
-  std::unordered_set<int32_t> routesToDel;
-
-  // squash the updates together.
-  for (const auto& staticRoutesUpdate : staticRoutesUpdates_) {
-    for (const auto& mplsRoutesToUpdate :
-         staticRoutesUpdate.mplsRoutesToUpdate) {
-      LOG(INFO) << "adding: " << mplsRoutesToUpdate.topLabel;
-      routesToUpdate[mplsRoutesToUpdate.topLabel] = mplsRoutesToUpdate;
-      routesToDel.erase(mplsRoutesToUpdate.topLabel);
+  // squash the updates together, routes are moved out of the updates. Last
+  // update of a label or prefix wins, std::nullopt marks a deletion
+  size_t numMplsUpdates = 0;
+  size_t numUnicastUpdates = 0;
+  for (auto const& update : staticRoutesUpdates_) {
+    numMplsUpdates +=
+        update.mplsRoutesToUpdate.size() + update.mplsRoutesToDelete.size();
+    numUnicastUpdates += update.unicastRoutesToUpdate.size() +
+        update.unicastRoutesToDelete.size();
+  }
+  std::unordered_map<int32_t, std::optional<thrift::MplsRoute>> mplsRoutes;
+  std::unordered_map<thrift::IpPrefix, std::optional<thrift::UnicastRoute>>
+      unicastRoutes;
+  mplsRoutes.reserve(numMplsUpdates);
+  unicastRoutes.reserve(numUnicastUpdates);
+  for (auto& update : staticRoutesUpdates_) {
+    for (auto& route : update.mplsRoutesToUpdate) {
+      const auto label = route.topLabel;
+      mplsRoutes.insert_or_assign(label, std::move(route));
     }
-
-    for (const auto& mplsRoutesToDelete :
-         staticRoutesUpdate.mplsRoutesToDelete) {
-      LOG(INFO) << "erasing: " << mplsRoutesToDelete;
-      routesToDel.insert(mplsRoutesToDelete);
-      routesToUpdate.erase(mplsRoutesToDelete);
+    for (const auto label : update.mplsRoutesToDelete) {
+      mplsRoutes.insert_or_assign(label, std::nullopt);
+    }
+    for (auto& route : update.unicastRoutesToUpdate) {
+      auto prefix = route.dest;
+      unicastRoutes.insert_or_assign(std::move(prefix), std::move(route));
+    }
+    for (auto const& prefix : update.unicastRoutesToDelete) {
+      unicastRoutes.insert_or_assign(prefix, std::nullopt);
     }
   }
   staticRoutesUpdates_.clear();
 
-  if (routesToUpdate.size() == 0 && routesToDel.size() == 0) {
-    return {};
-  }
-
-  thrift::RouteDatabaseDelta ret;
-  ret.thisNodeName = myNodeName_;
-  for (const auto& routeToUpdate : routesToUpdate) {
-    staticRoutes_.mplsRoutes[routeToUpdate.first] =
-        routeToUpdate.second.nextHops;
-    ret.mplsRoutesToUpdate.emplace_back(std::move(routeToUpdate.second));
+  StaticRoutesUpdate ret;
+  if (not mplsRoutes.empty()) {
+    thrift::RouteDatabaseDelta delta;
+    delta.thisNodeName = myNodeName_;
+    for (auto& [label, route] : mplsRoutes) {
+      if (route.has_value()) {
+        staticRoutes_.mplsRoutes[label] = route->nextHops;
+        delta.mplsRoutesToUpdate.emplace_back(std::move(route).value());
+      } else {
+        staticRoutes_.mplsRoutes.erase(label);
+        delta.mplsRoutesToDelete.push_back(label);
+      }
+    }
+    ret.mplsRoutesDelta = std::move(delta);
   }
 
-  for (const auto& routeToDel : routesToDel) {
-    staticRoutes_.mplsRoutes.erase(routeToDel);
-    ret.mplsRoutesToDelete.push_back(routeToDel);
+  ret.unicastChanges.reserve(unicastRoutes.size());
+  for (auto& [prefix, route] : unicastRoutes) {
+    // entries are not assignable, replace the node instead
+    const bool existed = staticUnicastRoutes_.erase(prefix);
+    if (route.has_value()) {
+      auto const& nexthops = route->nextHops;
+      staticUnicastRoutes_.emplace(
+          prefix,
+          RibUnicastEntry(
+              toIPNetwork(prefix),
+              NextHopSet(nexthops.begin(), nexthops.end())));
+    } else if (not existed) {
+      continue;
+    }
+    ret.unicastChanges.emplace(prefix);
   }
 
+  VLOG(1) << "Processed static route updates of " << mplsRoutes.size()
+          << " labels and " << unicastRoutes.size() << " prefixes. "
+          << staticRoutes_.mplsRoutes.size() << " MPLS and "
+          << staticUnicastRoutes_.size() << " unicast static routes in total";
+  fb303::fbData->addStatValue(
+      "decision.static_mpls_route_updates", mplsRoutes.size(), fb303::SUM);
+  fb303::fbData->addStatValue(
+      "decision.static_unicast_route_updates",
+      unicastRoutes.size(),
+      fb303::SUM);
   return ret;
 }
 
@@ -1017,11 +1873,11 @@ SpfSolver::SpfSolverImpl::getMinCostNodes(
   // find the set of the closest nodes to our destination
   std::unordered_set<std::string> minCostNodes;
   for (const auto& dstNode : dstNodeNames) {
-    auto it = spfResult.find(dstNode);
-    if (it == spfResult.end()) {
+    auto const* nodeSpfResult = spfResult.get(dstNode);
+    if (!nodeSpfResult) {
       continue;
     }
-    const auto nodeDistance = it->second.metric();
+    const auto nodeDistance = nodeSpfResult->metric();
     if (shortestMetric >= nodeDistance) {
       if (shortestMetric > nodeDistance) {
         shortestMetric = nodeDistance;
@@ -1065,7 +1921,9 @@ SpfSolver::SpfSolverImpl::getNextHopsWithMetric(
   // Add neighbors with shortest path to the prefix
   for (const auto& dstNode : minCostNodes) {
     const auto dstNodeRef = perDestination ? dstNode : "";
-    for (const auto& nhName : shortestPathsFromHere.at(dstNode).nextHops()) {
+    for (const auto nhId : shortestPathsFromHere.nextHops(
+             shortestPathsFromHere.at(dstNode))) {
+      auto const& nhName = shortestPathsFromHere.nodeName(nhId);
       nextHopNodes[std::make_pair(nhName, dstNodeRef)] = shortestMetric -
           linkState.getMetricFromAToB(myNodeName, nhName).value();
     }
@@ -1084,11 +1942,11 @@ SpfSolver::SpfSolverImpl::getNextHopsWithMetric(
       const auto neighborToHere =
           shortestPathsFromNeighbor.at(myNodeName).metric();
       for (const auto& dstNode : dstNodeNames) {
-        auto shortestPathItr = shortestPathsFromNeighbor.find(dstNode);
-        if (shortestPathItr == shortestPathsFromNeighbor.end()) {
+        auto const* shortestPath = shortestPathsFromNeighbor.get(dstNode);
+        if (!shortestPath) {
           continue;
         }
-        const auto distanceFromNeighbor = shortestPathItr->second.metric();
+        const auto distanceFromNeighbor = shortestPath->metric();
 
         // This is the LFA condition per RFC 5286
         if (distanceFromNeighbor < shortestMetric + neighborToHere) {
@@ -1108,7 +1966,7 @@ SpfSolver::SpfSolverImpl::getNextHopsWithMetric(
   return std::make_pair(shortestMetric, nextHopNodes);
 }
 
-std::unordered_set<thrift::NextHopThrift>
+NextHopSet
 SpfSolver::SpfSolverImpl::getNextHopsThrift(
     const std::string& myNodeName,
     const std::set<std::string>& dstNodeNames,
@@ -1121,7 +1979,10 @@ SpfSolver::SpfSolverImpl::getNextHopsThrift(
     LinkState const& linkState) const {
   CHECK(not nextHopNodes.empty());
 
-  std::unordered_set<thrift::NextHopThrift> nextHops;
+  std::vector<thrift::NextHopThrift> nextHops;
+  // adjacency weights of shortest path nexthops, by index into nextHops
+  std::vector<size_t> weightedNextHops;
+  std::vector<int64_t> weights;
   for (const auto& link : linkState.linksFromNode(myNodeName)) {
     for (const auto& dstNode :
          perDestination ? dstNodeNames : std::set<std::string>{""}) {
@@ -1179,7 +2040,7 @@ SpfSolver::SpfSolverImpl::getNextHopsThrift(
 
       // if we are computing LFA paths, any nexthop to the node will do
       // otherwise, we only want those nexthops along a shortest path
-      nextHops.emplace(createNextHop(
+      nextHops.emplace_back(createNextHop(
           isV4 ? link->getNhV4FromNode(myNodeName)
                : link->getNhV6FromNode(myNodeName),
           link->getIfaceFromNode(myNodeName),
@@ -1187,9 +2048,67 @@ SpfSolver::SpfSolverImpl::getNextHopsThrift(
           mplsAction,
           false /* useNonShortestRoute */,
           link->getArea()));
+      // LFA nexthops are kept unweighted
+      if (enableUcmp_ and distOverLink == minMetric) {
+        weightedNextHops.emplace_back(nextHops.size() - 1);
+        weights.emplace_back(link->getWeightFromNode(myNodeName));
+      }
     } // end for perDestination ...
   } // end for linkState ...
 
+  if (weights.size() > 1) {
+    const auto normalized = normalizeNextHopWeights(weights);
+    for (size_t i = 0; i < weightedNextHops.size(); ++i) {
+      nextHops.at(weightedNextHops.at(i)).weight = normalized.at(i);
+    }
+  }
+  return NextHopSet(nextHops.begin(), nextHops.end());
+}
+
+std::shared_ptr<const NextHopSet>
+SpfSolver::SpfSolverImpl::getUnicastNextHops(
+    const std::string& myNodeName,
+    const std::set<std::string>& dstNodeNames,
+    bool isV4,
+    bool perDestination,
+    LinkState const& linkState) {
+  NextHopsKey key{dstNodeNames, isV4, perDestination};
+  {
+    std::lock_guard<std::mutex> lock(nextHopsMutex_);
+    auto memoIt = nextHopsMemos_.find(linkState.getArea());
+    if (memoIt != nextHopsMemos_.end()) {
+      auto& memo = memoIt->second;
+      auto it = memo.nextHops.find(key);
+      if (it != memo.nextHops.end()) {
+        ++memo.hits;
+        return it->second;
+      }
+      ++memo.misses;
+    }
+  }
+
+  // computed without holding the lock, concurrent shards may compute the same
+  // nexthops in which case the first one is memoized
+  std::shared_ptr<const NextHopSet> nextHops;
+  const auto metricNhs = getNextHopsWithMetric(
+      myNodeName, dstNodeNames, perDestination, linkState);
+  if (not metricNhs.second.empty()) {
+    nextHops = std::make_shared<const NextHopSet>(getNextHopsThrift(
+        myNodeName,
+        dstNodeNames,
+        isV4,
+        perDestination,
+        metricNhs.first,
+        metricNhs.second,
+        std::nullopt,
+        linkState));
+  }
+
+  std::lock_guard<std::mutex> lock(nextHopsMutex_);
+  auto memoIt = nextHopsMemos_.find(linkState.getArea());
+  if (memoIt != nextHopsMemos_.end()) {
+    memoIt->second.nextHops.emplace(std::move(key), nextHops);
+  }
   return nextHops;
 }
 
@@ -1203,14 +2122,20 @@ SpfSolver::SpfSolver(
     bool computeLfaPaths,
     bool enableOrderedFib,
     bool bgpDryRun,
-    bool bgpUseIgpMetric)
+    bool bgpUseIgpMetric,
+    int32_t numRouteBuildThreads,
+    std::optional<thrift::ThreadSchedulingConfig> routeBuildScheduling,
+    bool enableUcmp)
     : impl_(new SpfSolver::SpfSolverImpl(
           myNodeName,
           enableV4,
           computeLfaPaths,
           enableOrderedFib,
           bgpDryRun,
-          bgpUseIgpMetric)) {}
+          bgpUseIgpMetric,
+          numRouteBuildThreads,
+          std::move(routeBuildScheduling),
+          enableUcmp)) {}
 
 SpfSolver::~SpfSolver() {}
 
@@ -1230,6 +2155,11 @@ SpfSolver::getStaticRoutes() {
   return impl_->getStaticRoutes();
 }
 
+std::unordered_map<thrift::IpPrefix, RibUnicastEntry> const&
+SpfSolver::getStaticUnicastRoutes() {
+  return impl_->getStaticUnicastRoutes();
+}
+
 std::optional<DecisionRouteDb>
 SpfSolver::buildRouteDb(
     const std::string& myNodeName,
@@ -1238,7 +2168,18 @@ SpfSolver::buildRouteDb(
   return impl_->buildRouteDb(myNodeName, linkState, prefixState);
 }
 
-std::optional<thrift::RouteDatabaseDelta>
+std::optional<DecisionRouteDb>
+SpfSolver::buildRouteDb(
+    const std::string& myNodeName,
+    LinkState const& linkState,
+    PrefixState const& prefixState,
+    std::unordered_set<thrift::IpPrefix> const& prefixes,
+    std::unordered_set<std::string> const& labelNodes) {
+  return impl_->buildRouteDb(
+      myNodeName, linkState, prefixState, &prefixes, &labelNodes);
+}
+
+StaticRoutesUpdate
 SpfSolver::processStaticRouteUpdates() {
   return impl_->processStaticRouteUpdates();
 }
@@ -1253,15 +2194,23 @@ Decision::Decision(
     bool bgpDryRun,
     std::chrono::milliseconds debounceMinDur,
     std::chrono::milliseconds debounceMaxDur,
-    messaging::RQueue<thrift::Publication> kvStoreUpdatesQueue,
+    messaging::RQueue<KvStorePublication> kvStoreUpdatesQueue,
     messaging::RQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue,
     messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& routeUpdatesQueue,
+    messaging::ReplicateQueue<thrift::DecisionDbsDelta>&
+        decisionDbsUpdatesQueue,
     // TODO: Remove unused zmqContext argument
     fbzmq::Context& /* zmqContext */)
     : config_(config),
-      processUpdatesBackoff_(debounceMinDur, debounceMaxDur),
+      processUpdatesDebounce_(debounceMinDur, debounceMaxDur),
       routeUpdatesQueue_(routeUpdatesQueue),
+      decisionDbsUpdatesQueue_(decisionDbsUpdatesQueue),
+      prefixState_(config->getDecisionMaxPrefixesPerOriginator()),
       myNodeName_(config->getConfig().node_name),
+      computeLfaPaths_(computeLfaPaths),
+      bgpDryRun_(bgpDryRun),
+      enableNextHopGroups_(config->isNextHopGroupsEnabled()),
+      enablePhasePerfEvents_(config->isDecisionPhasePerfEventsEnabled()),
       pendingUpdates_(config->getConfig().node_name) {
   auto tConfig = config->getConfig();
   processUpdatesTimer_ = folly::AsyncTimeout::make(
@@ -1272,12 +2221,53 @@ Decision::Decision(
       computeLfaPaths,
       tConfig.enable_ordered_fib_programming_ref().value_or(false),
       bgpDryRun,
-      tConfig.bgp_use_igp_metric_ref().value_or(false));
+      tConfig.bgp_use_igp_metric_ref().value_or(false),
+      config->getDecisionRouteBuildThreads(),
+      config->getThreadSchedulingConfig("DecisionRouteBuild"),
+      config->isUcmpEnabled());
+
+  if (auto numThreads = config->getDecisionRouteBuildThreads()) {
+    routeBuildExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        numThreads,
+        makeRouteBuildThreadFactory(
+            "DecisionRouteBuild",
+            config->getThreadSchedulingConfig("DecisionRouteBuild")));
+  }
+  if (config->isAsyncRouteBuildEnabled()) {
+    routeComputeExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        1,
+        makeRouteBuildThreadFactory(
+            "DecisionRouteCompute",
+            config->getThreadSchedulingConfig("DecisionRouteCompute")));
+  }
 
   coldStartTimer_ = folly::AsyncTimeout::make(
       *getEvb(), [this]() noexcept { coldStartUpdate(); });
+  routeDbComputationTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { processPendingRouteDbComputations(); });
+  fb303::fbData->addStatExportType(
+      "decision.computed_route_db.builds", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.computed_route_db.cache_hits", fb303::COUNT);
+  fb303::fbData->addStatExportType("decision.what_if.runs", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.skipped_deserializations", fb303::COUNT);
+  fb303::fbData->addStatExportType("decision.debounce_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "decision.journaled_route_updates", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.route_db_inconsistencies", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.debounce_fast_path", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.initial_sync_cold_start", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.async_route_builds", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.deferred_during_route_build", fb303::COUNT);
   if (auto eor = config->getConfig().eor_time_s_ref()) {
     coldStartTimer_->scheduleTimeout(std::chrono::seconds(*eor));
+    initialSyncAreas_ = config->getAreaIds();
   }
 
   // Schedule periodic timer for counter submission
@@ -1305,14 +2295,33 @@ Decision::Decision(
   addFiberTask([q = std::move(kvStoreUpdatesQueue), this]() mutable noexcept {
     LOG(INFO) << "Starting KvStore updates processing fiber";
     while (true) {
-      auto maybeThriftPub = q.get(); // perform read
-      VLOG(2) << "Received KvStore update";
-      if (maybeThriftPub.hasError()) {
+      // read all queued publications at once to compute routes once for the
+      // burst of updates
+      auto maybeThriftPubs = q.getBatch(); // perform read
+      if (maybeThriftPubs.hasError()) {
         LOG(INFO) << "Terminating KvStore updates processing fiber";
         break;
       }
+      VLOG(2) << "Received " << maybeThriftPubs.value().size()
+              << " KvStore update(s)";
+      fb303::fbData->addStatValue(
+          "decision.kvstore_update_batch_size",
+          maybeThriftPubs.value().size(),
+          fb303::AVG);
+      bool warmStart{false};
+      bool initialSyncDone{false};
       try {
-        processPublication(maybeThriftPub.value());
+        for (auto const& thriftPub : maybeThriftPubs.value()) {
+          processPublication(*thriftPub);
+          warmStart |= thriftPub->warmStart_ref().value_or(false);
+          if (thriftPub->initialSyncDone_ref().value_or(false) and
+              initialSyncAreas_.erase(thriftPub->area_ref().value_or(""))) {
+            initialSyncDone = initialSyncAreas_.empty();
+          }
+        }
+        if (pendingUpdates_.needsRouteUpdate()) {
+          invalidateComputedRouteDbs();
+        }
       } catch (const std::exception& e) {
 #if FOLLY_USE_SYMBOLIZER
         // collect stack strace then fail the process
@@ -1324,14 +2333,30 @@ Decision::Decision(
         LOG(FATAL) << "Exception occured in Decision::processPublication - "
                    << folly::exceptionStr(e);
       }
-      // compute routes with exponential backoff timer if needed
-      if (pendingUpdates_.needsRouteUpdate()) {
-        if (!processUpdatesBackoff_.atMaxBackoff()) {
-          processUpdatesBackoff_.reportError();
-          processUpdatesTimer_->scheduleTimeout(
-              processUpdatesBackoff_.getTimeRemainingUntilRetry());
+      // Program provisional routes computed from KvStore warm start snapshot
+      // right away, instead of waiting for cold start duration
+      if (warmStart and coldStartTimer_->isScheduled()) {
+        auto maybeRouteDb = rebuildRouteDb(true /* fullRebuild */);
+        if (maybeRouteDb.has_value()) {
+          sendRouteUpdate(
+              std::move(*maybeRouteDb),
+              thrift::PerfEvents{},
+              "WARM_START_UPDATE");
         }
-        CHECK(processUpdatesTimer_->isScheduled());
+      }
+      // KvStore is in sync in all areas, no need to wait for cold start
+      // duration any longer
+      if (initialSyncDone and coldStartTimer_->isScheduled()) {
+        LOG(INFO) << "KvStore initial sync done in all areas. Performing "
+                  << "cold start update before end of cold start duration";
+        fb303::fbData->addStatValue(
+            "decision.initial_sync_cold_start", 1, fb303::COUNT);
+        coldStartTimer_->cancelTimeout();
+        coldStartUpdate();
+      }
+      // compute routes with adaptive debounce if needed
+      if (pendingUpdates_.needsRouteUpdate() or not pendingKeyVals_.empty()) {
+        scheduleProcessPendingUpdates();
       }
     }
   });
@@ -1349,20 +2374,14 @@ Decision::Decision(
           }
           // Apply publication and update stored update status
           pushRoutesDeltaUpdates(maybeThriftPub.value());
-          if (!processUpdatesBackoff_.atMaxBackoff()) {
-            processUpdatesBackoff_.reportError();
-            processUpdatesTimer_->scheduleTimeout(
-                processUpdatesBackoff_.getTimeRemainingUntilRetry());
-          } else {
-            CHECK(processUpdatesTimer_->isScheduled());
-          }
+          scheduleProcessPendingUpdates();
         }
       });
 
   // Create RibPolicy timer to process routes on policy expiry
   ribPolicyTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     LOG(WARNING) << "RibPolicy is expired";
-    processRibPolicyUpdate();
+    processRibPolicyUpdate(ribPolicy_.get());
   });
 }
 
@@ -1371,79 +2390,301 @@ Decision::getDecisionRouteDb(std::string nodeName) {
   folly::Promise<std::unique_ptr<thrift::RouteDatabase>> p;
   auto sf = p.getSemiFuture();
   runInEventBaseThread([p = std::move(p), nodeName, this]() mutable {
-    thrift::RouteDatabase routeDb;
-
     if (nodeName.empty()) {
       nodeName = myNodeName_;
     }
-    auto maybeRouteDb = buildRouteDb(nodeName);
-    if (maybeRouteDb.has_value()) {
-      routeDb = maybeRouteDb->toThrift();
-    }
 
-    // static routes
-    for (const auto& [key, val] : spfSolver_->getStaticRoutes().mplsRoutes) {
-      routeDb.mplsRoutes.emplace_back(createMplsRoute(key, val));
+    processPendingPublications();
+    auto it = computedRouteDbs_.find(nodeName);
+    if (it != computedRouteDbs_.end()) {
+      fb303::fbData->addStatValue(
+          "decision.computed_route_db.cache_hits", 1, fb303::COUNT);
+      p.setValue(std::make_unique<thrift::RouteDatabase>(it->second));
+      return;
     }
 
-    routeDb.thisNodeName = nodeName;
-    p.setValue(std::make_unique<thrift::RouteDatabase>(std::move(routeDb)));
+    // Computation of the node is shared by all of its pending requests
+    auto& requests = pendingRouteDbRequests_[nodeName];
+    if (requests.empty()) {
+      pendingRouteDbNodes_.emplace_back(nodeName);
+    }
+    requests.emplace_back(std::move(p));
+    if (not routeDbComputationTimer_->isScheduled()) {
+      routeDbComputationTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+    }
   });
   return sf;
 }
 
-folly::SemiFuture<std::unique_ptr<thrift::StaticRoutes>>
-Decision::getDecisionStaticRoutes() {
-  folly::Promise<std::unique_ptr<thrift::StaticRoutes>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), this]() mutable {
-    auto staticRoutes = spfSolver_->getStaticRoutes();
-    p.setValue(std::make_unique<thrift::StaticRoutes>(std::move(staticRoutes)));
-  });
-  return sf;
+void
+Decision::processPendingRouteDbComputations() {
+  // resumed once computed routes are committed
+  if (pendingRouteDbNodes_.empty() or routeComputeInFlight_) {
+    return;
+  }
+  auto nodeName = std::move(pendingRouteDbNodes_.front());
+  pendingRouteDbNodes_.pop_front();
+  auto requests = std::move(pendingRouteDbRequests_.at(nodeName));
+  pendingRouteDbRequests_.erase(nodeName);
+
+  processPendingPublications();
+  fb303::fbData->addStatValue(
+      "decision.computed_route_db.builds", 1, fb303::COUNT);
+  thrift::RouteDatabase routeDb;
+  auto maybeRouteDb = buildRouteDb(nodeName);
+  if (maybeRouteDb.has_value()) {
+    if (nodeName == myNodeName_) {
+      applyStaticUnicastRoutes(*maybeRouteDb);
+    }
+    routeDb = maybeRouteDb->toThrift();
+  }
+
+  // static routes
+  for (const auto& [key, val] : spfSolver_->getStaticRoutes().mplsRoutes) {
+    routeDb.mplsRoutes.emplace_back(createMplsRoute(key, val));
+  }
+
+  routeDb.thisNodeName = nodeName;
+  for (auto& request : requests) {
+    request.setValue(std::make_unique<thrift::RouteDatabase>(routeDb));
+  }
+
+  // Bound the cache, e.g. against requests for non-existent nodes
+  if (computedRouteDbs_.size() >= Constants::kDecisionMaxComputedRouteDbs) {
+    computedRouteDbs_.clear();
+  }
+  computedRouteDbs_.emplace(std::move(nodeName), std::move(routeDb));
+
+  // Yield to other events before computing next one
+  if (not pendingRouteDbNodes_.empty()) {
+    routeDbComputationTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+  }
 }
 
-folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>>
-Decision::getDecisionAdjacencyDbs() {
-  folly::Promise<std::unique_ptr<thrift::AdjDbs>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), this]() mutable {
-    auto search =
-        areaLinkStates_.find(thrift::KvStore_constants::kDefaultArea());
-    p.setValue(std::make_unique<thrift::AdjDbs>(
-        search != areaLinkStates_.end() ? search->second.getAdjacencyDatabases()
-                                        : thrift::AdjDbs{}));
-  });
-  return sf;
+void
+Decision::invalidateComputedRouteDbs() {
+  computedRouteDbs_.clear();
 }
 
-folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
-Decision::getAllDecisionAdjacencyDbs() {
-  folly::Promise<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>> p;
+folly::SemiFuture<std::unique_ptr<thrift::RouteDatabaseDelta>>
+Decision::getDecisionRouteDbDeltaWhatIf(
+    std::string nodeName, std::vector<thrift::TopologyChange> changes) {
+  folly::Promise<std::unique_ptr<thrift::RouteDatabaseDelta>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), this]() mutable {
-    auto adjDbs = std::make_unique<std::vector<thrift::AdjacencyDatabase>>();
-    for (auto const& [_, linkState] : areaLinkStates_) {
-      for (auto const& [_, db] : linkState.getAdjacencyDatabases()) {
-        adjDbs->push_back(db);
-      }
+  runInEventBaseThread([p = std::move(p),
+                        nodeName = std::move(nodeName),
+                        changes = std::move(changes),
+                        this]() mutable {
+    if (nodeName.empty()) {
+      nodeName = myNodeName_;
     }
-    p.setValue(std::move(adjDbs));
-  });
-  return sf;
-}
+
+    // Snapshot of the databases, as live state keeps changing while the
+    // simulation runs. State is frozen while routes are computed on
+    // routeComputeExecutor_, hence safe to read
+    processPendingPublications();
+    AreaAdjacencyDbs areaAdjDbs;
+    for (auto const& [area, linkState] : areaLinkStates_) {
+      areaAdjDbs.emplace(area, linkState.getAdjacencyDatabases());
+    }
+    if (not whatIfExecutor_) {
+      whatIfExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+          1, makeRouteBuildThreadFactory("DecisionWhatIf", std::nullopt));
+    }
+    whatIfExecutor_->add([p = std::move(p),
+                          nodeName = std::move(nodeName),
+                          changes = std::move(changes),
+                          areaAdjDbs = std::move(areaAdjDbs),
+                          prefixState = prefixState_,
+                          this]() mutable {
+      p.setWith([&]() {
+        return std::make_unique<thrift::RouteDatabaseDelta>(
+            simulateTopologyChanges(
+                nodeName, changes, std::move(areaAdjDbs), prefixState));
+      });
+    });
+  });
+  return sf;
+}
+
+thrift::RouteDatabaseDelta
+Decision::simulateTopologyChanges(
+    std::string const& nodeName,
+    std::vector<thrift::TopologyChange> const& changes,
+    AreaAdjacencyDbs areaAdjDbs,
+    PrefixState const& prefixState) const {
+  const auto startTime = std::chrono::steady_clock::now();
+  fb303::fbData->addStatValue("decision.what_if.runs", 1, fb303::COUNT);
+
+  // Private solver, as route builds of the same area share memoized
+  // nexthops and best announcers within a solver
+  auto const& tConfig = config_->getConfig();
+  SpfSolver spfSolver(
+      nodeName,
+      tConfig.enable_v4_ref().value_or(false),
+      computeLfaPaths_,
+      tConfig.enable_ordered_fib_programming_ref().value_or(false),
+      bgpDryRun_,
+      tConfig.bgp_use_igp_metric_ref().value_or(false));
+
+  // Overlay of each area, replayed from the snapshot. Links of the live
+  // LinkState are updated in place and can't be shared with it. Areas are
+  // visited in name order, as in buildRouteDb()
+  std::map<std::string, LinkState> linkStates;
+  for (auto const& [area, adjDbs] : areaAdjDbs) {
+    auto& linkState = linkStates
+                          .emplace(
+                              std::piecewise_construct,
+                              std::forward_as_tuple(area),
+                              std::forward_as_tuple(
+                                  area,
+                                  true /* enableIncrementalSpf */,
+                                  config_->getDecisionSpfCacheBytes()))
+                          .first->second;
+    for (auto const& [_, adjDb] : adjDbs) {
+      linkState.updateAdjacencyDatabase(adjDb);
+    }
+  }
+
+  auto buildRouteDb = [&]() {
+    DecisionRouteDb db;
+    for (auto const& [_, linkState] : linkStates) {
+      auto maybeAreaDb =
+          spfSolver.buildRouteDb(nodeName, linkState, prefixState);
+      if (maybeAreaDb) {
+        mergeAreaRouteDb(db, std::move(maybeAreaDb).value());
+      }
+    }
+    return db;
+  };
+
+  // Baseline routes memoize SPF results, which are then repaired by each
+  // change instead of being recomputed from scratch
+  const auto oldDb = buildRouteDb();
+  for (auto const& change : changes) {
+    bool applied{false};
+    for (auto& [area, adjDbs] : areaAdjDbs) {
+      if (change.area_ref().has_value() and *change.area_ref() != area) {
+        continue;
+      }
+      auto& linkState = linkStates.at(area);
+      for (auto const& node : applyTopologyChange(change, adjDbs)) {
+        applied = true;
+        auto it = adjDbs.find(node);
+        if (it != adjDbs.end()) {
+          linkState.updateAdjacencyDatabase(it->second);
+        } else {
+          linkState.deleteAdjacencyDatabase(node);
+        }
+      }
+    }
+    if (not applied) {
+      thrift::OpenrError error;
+      error.message = folly::sformat(
+          "Unknown {} of topology change",
+          change.ifName_ref().has_value()
+              ? folly::sformat(
+                    "link {}:{}", change.nodeName, *change.ifName_ref())
+              : folly::sformat("node {}", change.nodeName));
+      throw error;
+    }
+  }
+
+  auto delta = getRouteDelta(buildRouteDb(), oldDb);
+  delta.thisNodeName = nodeName;
+
+  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "Simulated " << changes.size() << " topology changes for "
+            << nodeName << " in " << deltaTime.count() << "ms, "
+            << delta.unicastRoutesToUpdate.size() << " routes to update, "
+            << delta.unicastRoutesToDelete.size() << " to delete";
+  return delta;
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::StaticRoutes>>
+Decision::getDecisionStaticRoutes() {
+  folly::Promise<std::unique_ptr<thrift::StaticRoutes>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), this]() mutable {
+    auto staticRoutes = spfSolver_->getStaticRoutes();
+    auto const& unicastRoutes = spfSolver_->getStaticUnicastRoutes();
+    staticRoutes.unicastRoutes.reserve(unicastRoutes.size());
+    for (auto const& [_, entry] : unicastRoutes) {
+      staticRoutes.unicastRoutes.emplace_back(entry.toTUnicastRoute());
+    }
+    p.setValue(std::make_unique<thrift::StaticRoutes>(std::move(staticRoutes)));
+  });
+  return sf;
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>>
+Decision::getDecisionAdjacencyDbs() {
+  folly::Promise<std::unique_ptr<thrift::AdjDbs>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), this]() mutable {
+    processPendingPublications();
+    auto search =
+        areaLinkStates_.find(thrift::KvStore_constants::kDefaultArea());
+    p.setValue(std::make_unique<thrift::AdjDbs>(
+        search != areaLinkStates_.end() ? search->second.getAdjacencyDatabases()
+                                        : thrift::AdjDbs{}));
+  });
+  return sf;
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
+Decision::getAllDecisionAdjacencyDbs() {
+  folly::Promise<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), this]() mutable {
+    processPendingPublications();
+    auto adjDbs = std::make_unique<std::vector<thrift::AdjacencyDatabase>>();
+    for (auto const& [_, linkState] : areaLinkStates_) {
+      for (auto const& [_, db] : linkState.getAdjacencyDatabases()) {
+        adjDbs->push_back(db);
+      }
+    }
+    p.setValue(std::move(adjDbs));
+  });
+  return sf;
+}
 
 folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>>
 Decision::getDecisionPrefixDbs() {
   folly::Promise<std::unique_ptr<thrift::PrefixDbs>> p;
   auto sf = p.getSemiFuture();
   runInEventBaseThread([p = std::move(p), this]() mutable {
+    processPendingPublications();
     p.setValue(
         std::make_unique<thrift::PrefixDbs>(prefixState_.getPrefixDatabases()));
   });
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::DecisionDbs>>
+Decision::getDecisionDbs() {
+  folly::Promise<std::unique_ptr<thrift::DecisionDbs>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), this]() mutable {
+    processPendingPublications();
+    auto dbs = std::make_unique<thrift::DecisionDbs>();
+    for (auto const& [_, linkState] : areaLinkStates_) {
+      for (auto const& [_, db] : linkState.getAdjacencyDatabases()) {
+        dbs->adjDbs.push_back(db);
+      }
+    }
+    dbs->prefixDbs = prefixState_.getPrefixDatabases();
+    p.setValue(std::move(dbs));
+  });
+  return sf;
+}
+
+messaging::RQueue<thrift::DecisionDbsDelta>
+Decision::getDecisionDbsUpdatesReader() {
+  return decisionDbsUpdatesQueue_.getReader();
+}
+
 folly::SemiFuture<folly::Unit>
 Decision::setRibPolicy(thrift::RibPolicy const& ribPolicyThrift) {
   auto [p, sf] = folly::makePromiseContract<folly::Unit>();
@@ -1475,13 +2716,14 @@ Decision::setRibPolicy(thrift::RibPolicy const& ribPolicyThrift) {
         // Update local policy instance
         LOG(INFO) << "Updating RibPolicy with new instance. Validity "
                   << durationLeft.count() << "ms";
+        auto oldRibPolicy = std::move(ribPolicy_);
         ribPolicy_ = std::move(ribPolicy);
 
         // Schedule timer for processing routes on expiry
         ribPolicyTimer_->scheduleTimeout(durationLeft);
 
         // Trigger route computation
-        processRibPolicyUpdate();
+        processRibPolicyUpdate(oldRibPolicy.get());
 
         // Mark the policy update request to be done
         p.setValue();
@@ -1511,26 +2753,41 @@ Decision::getRibPolicy() {
   return std::move(sf);
 }
 
-thrift::PrefixDatabase
+std::unordered_set<thrift::IpPrefix>
 Decision::updateNodePrefixDatabase(
     const std::string& key, const thrift::PrefixDatabase& prefixDb) {
   auto const& nodeName = prefixDb.thisNodeName;
 
   auto prefixKey = PrefixKey::fromStr(key);
   if (prefixKey.hasValue()) {
-    // per prefix key
+    // per prefix key, apply change of the one prefix as delta
+    auto const& prefix = prefixKey.value().getIpPrefix();
+    PrefixState::PrefixDatabaseDelta delta;
+    delta.thisNodeName = nodeName;
+    delta.baseVersion = prefixState_.getNodeVersion(nodeName);
     if (prefixDb.deletePrefix) {
-      perPrefixPrefixEntries_[nodeName].erase(prefixKey.value().getIpPrefix());
+      perPrefixPrefixEntries_[nodeName].erase(prefix);
+      // entry of full prefix database takes over, if any
+      if (auto entry = folly::get_ptr(fullDbPrefixEntries_[nodeName], prefix)) {
+        delta.prefixEntriesToUpdate.emplace_back(*entry);
+      } else {
+        delta.prefixesToWithdraw.emplace_back(prefix);
+      }
     } else {
       if (prefixDb.prefixEntries.empty()) {
         LOG(ERROR) << "Received no entries for prefix db";
-      } else {
-        LOG_IF(ERROR, prefixDb.prefixEntries.size() > 1)
-            << "Received more than one prefix, only the first prefix is processed";
-        perPrefixPrefixEntries_[nodeName][prefixKey.value().getIpPrefix()] =
-            prefixDb.prefixEntries[0];
+        return {};
       }
+      LOG_IF(ERROR, prefixDb.prefixEntries.size() > 1)
+          << "Received more than one prefix, only the first prefix is processed";
+      perPrefixPrefixEntries_[nodeName][prefix] = prefixDb.prefixEntries[0];
+      delta.prefixEntriesToUpdate.emplace_back(prefixDb.prefixEntries[0]);
     }
+    if (auto changed = prefixState_.updatePrefixDatabaseDelta(delta)) {
+      return std::move(*changed);
+    }
+    fb303::fbData->addStatValue(
+        "decision.prefix_db_delta_fallback", 1, fb303::COUNT);
   } else {
     fullDbPrefixEntries_[nodeName].clear();
     for (auto const& entry : prefixDb.prefixEntries) {
@@ -1538,9 +2795,13 @@ Decision::updateNodePrefixDatabase(
     }
   }
 
+  return prefixState_.updatePrefixDatabase(getNodePrefixDatabase(nodeName));
+}
+
+thrift::PrefixDatabase
+Decision::getNodePrefixDatabase(const std::string& nodeName) {
   thrift::PrefixDatabase nodePrefixDb;
   nodePrefixDb.thisNodeName = nodeName;
-  nodePrefixDb.perfEvents_ref().copy_from(prefixDb.perfEvents_ref());
   nodePrefixDb.prefixEntries.reserve(perPrefixPrefixEntries_[nodeName].size());
   for (auto& kv : perPrefixPrefixEntries_[nodeName]) {
     nodePrefixDb.prefixEntries.emplace_back(kv.second);
@@ -1553,6 +2814,66 @@ Decision::updateNodePrefixDatabase(
   return nodePrefixDb;
 }
 
+thrift::AdjacencyDatabase
+Decision::updateNodeAdjacencyDatabase(
+    const std::string& key,
+    const std::string& area,
+    thrift::AdjacencyDatabase&& adjacencyDb) {
+  auto const& nodeName = adjacencyDb.thisNodeName;
+
+  auto adjacencyKey = PerAdjacencyKey::fromStr(key);
+  if (not adjacencyKey.hasValue()) {
+    // adjacency database key carries node attributes along with adjacencies
+    // not advertised with per adjacency keys
+    auto perKeyAdjacencies =
+        folly::get_ptr(perKeyAdjacencies_[area], nodeName);
+    if (perKeyAdjacencies) {
+      for (auto const& [_, adj] : *perKeyAdjacencies) {
+        adjacencyDb.adjacencies.emplace_back(adj);
+      }
+    }
+    return std::move(adjacencyDb);
+  }
+  auto& perKeyAdjacencies = perKeyAdjacencies_[area][nodeName];
+
+  // per adjacency key, apply it on top of current adjacency database of the
+  // node. No need to deserialize adjacency database key or other per
+  // adjacency keys again
+  thrift::AdjacencyDatabase nodeAdjacencyDb;
+  auto const& adjacencyDbs = areaLinkStates_.at(area).getAdjacencyDatabases();
+  auto it = adjacencyDbs.find(nodeName);
+  if (it != adjacencyDbs.end()) {
+    nodeAdjacencyDb = it->second;
+  } else {
+    nodeAdjacencyDb.thisNodeName = nodeName;
+    nodeAdjacencyDb.area_ref() = area;
+  }
+
+  auto& adjacencies = nodeAdjacencyDb.adjacencies;
+  adjacencies.erase(
+      std::remove_if(
+          adjacencies.begin(),
+          adjacencies.end(),
+          [&adjacencyKey](thrift::Adjacency const& adj) {
+            return adj.otherNodeName == adjacencyKey->getOtherNodeName() and
+                adj.ifName == adjacencyKey->getIfName();
+          }),
+      adjacencies.end());
+
+  // no adjacency signifies withdrawal of the key
+  if (adjacencyDb.adjacencies.empty()) {
+    perKeyAdjacencies.erase(key);
+  } else {
+    LOG_IF(ERROR, adjacencyDb.adjacencies.size() > 1)
+        << "Received more than one adjacency for key " << key
+        << ", only the first adjacency is processed";
+    perKeyAdjacencies[key] = adjacencyDb.adjacencies.front();
+    adjacencies.emplace_back(std::move(adjacencyDb.adjacencies.front()));
+  }
+  nodeAdjacencyDb.perfEvents_ref().move_from(adjacencyDb.perfEvents_ref());
+  return nodeAdjacencyDb;
+}
+
 ProcessPublicationResult
 Decision::processPublication(thrift::Publication const& thriftPub) {
   ProcessPublicationResult res;
@@ -1561,19 +2882,40 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
       ? thriftPub.area_ref().value()
       : thrift::KvStore_constants::kDefaultArea();
 
-  if (!areaLinkStates_.count(area)) {
-    areaLinkStates_.emplace(area, area);
+  // link state of new area is created once routes aren't being computed
+  if (not routeComputeInFlight_ and !areaLinkStates_.count(area)) {
+    areaLinkStates_.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(area),
+        std::forward_as_tuple(
+            area,
+            config_->isIncrementalSpfEnabled(),
+            config_->getDecisionSpfCacheBytes()));
   }
-  auto& areaLinkState = areaLinkStates_.at(area);
-
-  // LSDB addition/update
-  // deserialize contents of every LSDB key
 
   // Nothing to process if no adj/prefix db changes
   if (thriftPub.keyVals.empty() and thriftPub.expiredKeys.empty()) {
     return res;
   }
 
+  // Adjacency and prefix databases are only deserialized when pending updates
+  // are processed. Latest value of a key replaces the pending one, which then
+  // never gets deserialized
+  auto& pendingKeyVals = pendingKeyVals_[area];
+  auto const addPendingKeyVal = [&](std::string const& key,
+                                    std::optional<thrift::Value> value) {
+    auto it = pendingKeyVals.find(key);
+    if (it == pendingKeyVals.end()) {
+      pendingKeyVals.emplace(key, std::move(value));
+      return;
+    }
+    if (it->second.has_value()) {
+      fb303::fbData->addStatValue(
+          "decision.skipped_deserializations", 1, fb303::COUNT);
+    }
+    it->second = std::move(value);
+  };
+
   for (const auto& kv : thriftPub.keyVals) {
     const auto& key = kv.first;
     const auto& rawVal = kv.second;
@@ -1585,94 +2927,298 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
       continue;
     }
 
-    try {
-      if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
-        // update adjacencyDb
-        auto adjacencyDb =
-            fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
-                rawVal.value_ref().value(), serializer_);
-        CHECK_EQ(nodeName, adjacencyDb.thisNodeName);
-        LinkStateMetric holdUpTtl = 0, holdDownTtl = 0;
-        if (config_->getConfig().enable_ordered_fib_programming_ref().value_or(
-                false)) {
-          if (auto maybeHoldUpTtl = areaLinkState.getHopsFromAToB(
-                  myNodeName_, adjacencyDb.thisNodeName)) {
-            holdUpTtl = maybeHoldUpTtl.value();
-            holdDownTtl =
-                areaLinkState.getMaxHopsToNode(adjacencyDb.thisNodeName) -
-                holdUpTtl;
-          }
-        }
-        fb303::fbData->addStatValue("decision.adj_db_update", 1, fb303::COUNT);
-        pendingUpdates_.applyLinkStateChange(
-            adjacencyDb.thisNodeName,
-            areaLinkState.updateAdjacencyDatabase(
-                adjacencyDb, holdUpTtl, holdDownTtl),
-            castToStd(adjacencyDb.perfEvents_ref()));
-        if (areaLinkState.hasHolds() && orderedFibTimer_ != nullptr &&
-            !orderedFibTimer_->isScheduled()) {
-          orderedFibTimer_->scheduleTimeout(getMaxFib());
-        }
-        continue;
+    if (key.find(Constants::kAdjDbMarker.toString()) == 0 or
+        key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+      addPendingKeyVal(key, rawVal);
+      continue;
+    }
+
+    if (key.find(Constants::kFibTimeMarker.toString()) == 0) {
+      try {
+        std::chrono::milliseconds fibTime{stoll(rawVal.value_ref().value())};
+        fibTimes_[nodeName] = fibTime;
+      } catch (...) {
+        LOG(ERROR) << "Could not convert "
+                   << Constants::kFibTimeMarker.toString()
+                   << " value to int64";
       }
+      continue;
+    }
+  }
 
-      if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
-        // update prefixDb
-        auto prefixDb = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
-            rawVal.value_ref().value(), serializer_);
-        CHECK_EQ(nodeName, prefixDb.thisNodeName);
-        auto nodePrefixDb = updateNodePrefixDatabase(key, prefixDb);
-        VLOG(1) << "Updating prefix database for node " << nodeName;
-        fb303::fbData->addStatValue(
-            "decision.prefix_db_update", 1, fb303::COUNT);
-        pendingUpdates_.applyPrefixStateChange(
-            prefixState_.updatePrefixDatabase(nodePrefixDb)),
-            castToStd(nodePrefixDb.perfEvents_ref());
-        continue;
+  // LSDB deletion
+  for (const auto& key : thriftPub.expiredKeys) {
+    if (key.find(Constants::kAdjDbMarker.toString()) == 0 or
+        key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+      addPendingKeyVal(key, std::nullopt);
+    }
+  }
+  if (auto originators = thriftPub.expiredOriginators_ref()) {
+    pendingExpiredOriginators_[area].insert(
+        originators->begin(), originators->end());
+  }
+
+  return res;
+}
+
+void
+Decision::processPendingPublications() {
+  // state is frozen while routes are computed, publications are processed
+  // for the next computation
+  if (pendingKeyVals_.empty() or routeComputeInFlight_) {
+    return;
+  }
+  auto pendingKeyVals = std::move(pendingKeyVals_);
+  pendingKeyVals_.clear();
+  auto expiredOriginators = std::move(pendingExpiredOriginators_);
+  pendingExpiredOriginators_.clear();
+
+  for (auto const& [area, _] : pendingKeyVals) {
+    if (not areaLinkStates_.count(area)) {
+      areaLinkStates_.emplace(
+          std::piecewise_construct,
+          std::forward_as_tuple(area),
+          std::forward_as_tuple(
+              area,
+              config_->isIncrementalSpfEnabled(),
+              config_->getDecisionSpfCacheBytes()));
+    }
+  }
+
+  // Changes of databases to be published, only if anyone is subscribed
+  const bool publishDbsDelta = decisionDbsUpdatesQueue_.getNumReaders() > 0;
+
+  for (auto const& [area, keyVals] : pendingKeyVals) {
+    thrift::DecisionDbsDelta dbsDelta;
+    dbsDelta.area = area;
+
+    // Prefix databases aren't kept per area. Only with a single area, an
+    // originator left without keys has withdrawn all of its prefixes. They
+    // are withdrawn at once, before keys the node advertised again since
+    std::unordered_set<std::string> withdrawnNodes;
+    auto originatorsIt = expiredOriginators.find(area);
+    if (areaLinkStates_.size() == 1 and
+        originatorsIt != expiredOriginators.end()) {
+      withdrawnNodes = std::move(originatorsIt->second);
+      for (auto const& nodeName : withdrawnNodes) {
+        withdrawNodePrefixes(nodeName, publishDbsDelta, dbsDelta);
       }
+    }
 
-      if (key.find(Constants::kFibTimeMarker.toString()) == 0) {
-        try {
-          std::chrono::milliseconds fibTime{stoll(rawVal.value_ref().value())};
-          fibTimes_[nodeName] = fibTime;
-        } catch (...) {
-          LOG(ERROR) << "Could not convert "
-                     << Constants::kFibTimeMarker.toString()
-                     << " value to int64";
-        }
+    // prefixes of expired per prefix keys, withdrawn in one delta per node
+    std::unordered_map<std::string, std::vector<thrift::IpPrefix>>
+        expiredPrefixes;
+    for (auto const& [key, maybeVal] : keyVals) {
+      if (maybeVal.has_value()) {
+        processKeyVal(area, key, *maybeVal, publishDbsDelta, dbsDelta);
         continue;
       }
-    } catch (const std::exception& e) {
-      LOG(ERROR) << "Failed to deserialize info for key " << key
-                 << ". Exception: " << folly::exceptionStr(e);
+      if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+        auto nodeName = getNodeNameFromKey(key);
+        if (withdrawnNodes.count(nodeName)) {
+          continue;
+        }
+        if (auto prefixKey = PrefixKey::fromStr(key); prefixKey.hasValue()) {
+          expiredPrefixes[std::move(nodeName)].emplace_back(
+              prefixKey.value().getIpPrefix());
+          continue;
+        }
+      }
+      processExpiredKey(area, key, publishDbsDelta, dbsDelta);
+    }
+    for (auto const& [nodeName, prefixes] : expiredPrefixes) {
+      processExpiredPrefixes(nodeName, prefixes, publishDbsDelta, dbsDelta);
+    }
+
+    if (publishDbsDelta and
+        (not dbsDelta.adjDbsToUpdate.empty() or
+         not dbsDelta.adjDbsToDelete.empty() or
+         not dbsDelta.prefixDbsToUpdate.empty() or
+         not dbsDelta.prefixDbsToDelete.empty())) {
+      decisionDbsUpdatesQueue_.push(std::move(dbsDelta));
     }
   }
 
-  // LSDB deletion
-  for (const auto& key : thriftPub.expiredKeys) {
-    std::string nodeName = getNodeNameFromKey(key);
+  if (pendingUpdates_.needsRouteUpdate()) {
+    invalidateComputedRouteDbs();
+  }
+}
 
+void
+Decision::processKeyVal(
+    std::string const& area,
+    std::string const& key,
+    thrift::Value const& rawVal,
+    bool publishDbsDelta,
+    thrift::DecisionDbsDelta& dbsDelta) {
+  auto& areaLinkState = areaLinkStates_.at(area);
+  std::string nodeName = getNodeNameFromKey(key);
+
+  try {
     if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+      // update adjacencyDb
+      auto rawAdjacencyDb =
+          fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
+              rawVal.value_ref().value(), serializer_);
+      CHECK_EQ(nodeName, rawAdjacencyDb.thisNodeName);
+      auto adjacencyDb =
+          updateNodeAdjacencyDatabase(key, area, std::move(rawAdjacencyDb));
+      LinkStateMetric holdUpTtl = 0, holdDownTtl = 0;
+      if (config_->getConfig().enable_ordered_fib_programming_ref().value_or(
+              false)) {
+        if (auto maybeHoldUpTtl = areaLinkState.getHopsFromAToB(
+                myNodeName_, adjacencyDb.thisNodeName)) {
+          holdUpTtl = maybeHoldUpTtl.value();
+          holdDownTtl =
+              areaLinkState.getMaxHopsToNode(adjacencyDb.thisNodeName) -
+              holdUpTtl;
+        }
+      }
+      fb303::fbData->addStatValue("decision.adj_db_update", 1, fb303::COUNT);
+      auto perfEvents = castToStd(adjacencyDb.perfEvents_ref());
+      // database is moved into link state, copied out for dbs delta only
+      const bool hadNode = areaLinkState.hasNode(nodeName);
+      auto linkStateChange = areaLinkState.updateAdjacencyDatabase(
+          std::move(adjacencyDb), holdUpTtl, holdDownTtl);
+      updateNodeNumAreas(nodeName, hadNode, true);
       pendingUpdates_.applyLinkStateChange(
-          nodeName,
-          areaLinkState.deleteAdjacencyDatabase(nodeName),
-          castToStd(thrift::PrefixDatabase().perfEvents_ref()));
-      continue;
+          nodeName, linkStateChange, perfEvents);
+      if (publishDbsDelta) {
+        dbsDelta.adjDbsToUpdate.emplace_back(
+            areaLinkState.getAdjacencyDatabases().at(nodeName));
+      }
+      if (areaLinkState.hasHolds() && orderedFibTimer_ != nullptr &&
+          !orderedFibTimer_->isScheduled()) {
+        orderedFibTimer_->scheduleTimeout(getMaxFib());
+      }
+      return;
     }
 
     if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
-      // manually build delete prefix db to signal delete just as a client would
-      thrift::PrefixDatabase deletePrefixDb;
-      deletePrefixDb.thisNodeName = nodeName;
-      deletePrefixDb.deletePrefix = true;
-      auto nodePrefixDb = updateNodePrefixDatabase(key, deletePrefixDb);
+      // update prefixDb
+      auto prefixDb = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+          rawVal.value_ref().value(), serializer_);
+      CHECK_EQ(nodeName, prefixDb.thisNodeName);
+      VLOG(1) << "Updating prefix database for node " << nodeName;
+      fb303::fbData->addStatValue(
+          "decision.prefix_db_update", 1, fb303::COUNT);
       pendingUpdates_.applyPrefixStateChange(
-          prefixState_.updatePrefixDatabase(nodePrefixDb));
-      continue;
+          updateNodePrefixDatabase(key, prefixDb)),
+          castToStd(prefixDb.perfEvents_ref());
+      if (publishDbsDelta) {
+        auto nodePrefixDb = getNodePrefixDatabase(nodeName);
+        nodePrefixDb.perfEvents_ref().copy_from(prefixDb.perfEvents_ref());
+        addPrefixDbToDelta(dbsDelta, std::move(nodePrefixDb));
+      }
     }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to deserialize info for key " << key
+               << ". Exception: " << folly::exceptionStr(e);
   }
+}
 
-  return res;
+void
+Decision::processExpiredKey(
+    std::string const& area,
+    std::string const& key,
+    bool publishDbsDelta,
+    thrift::DecisionDbsDelta& dbsDelta) {
+  auto& areaLinkState = areaLinkStates_.at(area);
+  std::string nodeName = getNodeNameFromKey(key);
+
+  if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+    if (PerAdjacencyKey::fromStr(key).hasValue()) {
+      // expiry of per adjacency key withdraws the adjacency
+      thrift::AdjacencyDatabase withdrawnAdjacencyDb;
+      withdrawnAdjacencyDb.thisNodeName = nodeName;
+      withdrawnAdjacencyDb.area_ref() = area;
+      auto adjacencyDb = updateNodeAdjacencyDatabase(
+          key, area, std::move(withdrawnAdjacencyDb));
+      const bool hadNode = areaLinkState.hasNode(nodeName);
+      pendingUpdates_.applyLinkStateChange(
+          nodeName,
+          areaLinkState.updateAdjacencyDatabase(adjacencyDb),
+          castToStd(thrift::PrefixDatabase().perfEvents_ref()));
+      updateNodeNumAreas(nodeName, hadNode, true);
+      if (publishDbsDelta) {
+        dbsDelta.adjDbsToUpdate.emplace_back(std::move(adjacencyDb));
+      }
+      return;
+    }
+    perKeyAdjacencies_[area].erase(nodeName);
+    updateNodeNumAreas(nodeName, areaLinkState.hasNode(nodeName), false);
+    pendingUpdates_.applyLinkStateChange(
+        nodeName,
+        areaLinkState.deleteAdjacencyDatabase(nodeName),
+        castToStd(thrift::PrefixDatabase().perfEvents_ref()));
+    if (publishDbsDelta) {
+      dbsDelta.adjDbsToDelete.emplace_back(nodeName);
+    }
+    return;
+  }
+
+  if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+    // manually build delete prefix db to signal delete just as a client would
+    thrift::PrefixDatabase deletePrefixDb;
+    deletePrefixDb.thisNodeName = nodeName;
+    deletePrefixDb.deletePrefix = true;
+    pendingUpdates_.applyPrefixStateChange(
+        updateNodePrefixDatabase(key, deletePrefixDb));
+    if (publishDbsDelta) {
+      addPrefixDbToDelta(dbsDelta, getNodePrefixDatabase(nodeName));
+    }
+  }
+}
+
+void
+Decision::processExpiredPrefixes(
+    std::string const& nodeName,
+    std::vector<thrift::IpPrefix> const& prefixes,
+    bool publishDbsDelta,
+    thrift::DecisionDbsDelta& dbsDelta) {
+  PrefixState::PrefixDatabaseDelta delta;
+  delta.thisNodeName = nodeName;
+  delta.baseVersion = prefixState_.getNodeVersion(nodeName);
+  auto& perPrefixEntries = perPrefixPrefixEntries_[nodeName];
+  auto const& fullDbEntries = fullDbPrefixEntries_[nodeName];
+  for (auto const& prefix : prefixes) {
+    perPrefixEntries.erase(prefix);
+    // entry of full prefix database takes over, if any
+    if (auto entry = folly::get_ptr(fullDbEntries, prefix)) {
+      delta.prefixEntriesToUpdate.emplace_back(*entry);
+    } else {
+      delta.prefixesToWithdraw.emplace_back(prefix);
+    }
+  }
+  if (auto changed = prefixState_.updatePrefixDatabaseDelta(delta)) {
+    pendingUpdates_.applyPrefixStateChange(std::move(*changed));
+  } else {
+    fb303::fbData->addStatValue(
+        "decision.prefix_db_delta_fallback", 1, fb303::COUNT);
+    pendingUpdates_.applyPrefixStateChange(
+        prefixState_.updatePrefixDatabase(getNodePrefixDatabase(nodeName)));
+  }
+  if (publishDbsDelta) {
+    addPrefixDbToDelta(dbsDelta, getNodePrefixDatabase(nodeName));
+  }
+}
+
+void
+Decision::withdrawNodePrefixes(
+    std::string const& nodeName,
+    bool publishDbsDelta,
+    thrift::DecisionDbsDelta& dbsDelta) {
+  perPrefixPrefixEntries_.erase(nodeName);
+  fullDbPrefixEntries_.erase(nodeName);
+  auto changed = prefixState_.deleteNode(nodeName);
+  VLOG(1) << "Originator " << nodeName << " expired, withdrew "
+          << changed.size() << " prefixes";
+  fb303::fbData->addStatValue(
+      "decision.expired_originators", 1, fb303::COUNT);
+  pendingUpdates_.applyPrefixStateChange(std::move(changed));
+  if (publishDbsDelta) {
+    dbsDelta.prefixDbsToDelete.emplace_back(nodeName);
+  }
 }
 
 void
@@ -1681,12 +3227,54 @@ Decision::pushRoutesDeltaUpdates(
   spfSolver_->pushRoutesDeltaUpdates(staticRoutesDelta);
 }
 
+void
+Decision::scheduleProcessPendingUpdates() {
+  const bool isolated = processUpdatesDebounce_.isIsolated();
+  const auto delay = processUpdatesDebounce_.reportEvent();
+  if (isolated and not coldStartTimer_->isScheduled() and
+      isSingleAdjacencyUpdate()) {
+    fb303::fbData->addStatValue("decision.debounce_fast_path", 1, fb303::COUNT);
+    fb303::fbData->addStatValue("decision.debounce_ms", 0, fb303::AVG);
+    processPendingUpdates();
+    return;
+  }
+  fb303::fbData->addStatValue(
+      "decision.debounce_ms", delay.count(), fb303::AVG);
+  processUpdatesTimer_->scheduleTimeout(delay);
+}
+
+bool
+Decision::isSingleAdjacencyUpdate() const {
+  if (pendingUpdates_.needsRouteUpdate() or spfSolver_->staticRoutesUpdated() or
+      pendingKeyVals_.size() != 1) {
+    return false;
+  }
+  auto const& keyVals = pendingKeyVals_.begin()->second;
+  return keyVals.size() == 1 and
+      keyVals.begin()->first.find(Constants::kAdjDbMarker.toString()) == 0;
+}
+
 void
 Decision::processPendingUpdates() {
   if (coldStartTimer_->isScheduled()) {
+    // updates will be processed by cold start update
+    processUpdatesDebounce_.reportProcessed(std::chrono::milliseconds(0));
     return;
   }
 
+  if (routeComputeInFlight_) {
+    // updates are processed once computed routes are committed
+    fb303::fbData->addStatValue(
+        "decision.deferred_during_route_build", 1, fb303::COUNT);
+    return;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  {
+    ScopedPhaseTimer timer("deserialize");
+    processPendingPublications();
+  }
+
   pendingUpdates_.addEvent("DECISION_DEBOUNCE");
   VLOG(1) << "Decision: processing " << pendingUpdates_.getCount()
           << " accumulated updates.";
@@ -1700,59 +3288,252 @@ Decision::processPendingUpdates() {
     }
   }
   // we need to update  static route first, because there maybe routes
-  // depending on static routes.
-  bool staticRoutesUpdated{false};
+  // depending on static MPLS routes.
+  bool staticMplsRoutesUpdated{false};
   if (spfSolver_->staticRoutesUpdated()) {
-    staticRoutesUpdated = true;
-    if (auto maybeRouteDbDelta = spfSolver_->processStaticRouteUpdates()) {
-      routeUpdatesQueue_.push(std::move(maybeRouteDbDelta.value()));
+    ScopedPhaseTimer timer("static_routes");
+    invalidateComputedRouteDbs();
+    auto update = spfSolver_->processStaticRouteUpdates();
+    if (update.mplsRoutesDelta.has_value()) {
+      staticMplsRoutesUpdated = true;
+      routeUpdatesQueue_.push(std::move(update.mplsRoutesDelta).value());
     }
+    pendingStaticUnicastChanges_.merge(update.unicastChanges);
   }
 
   std::optional<DecisionRouteDb> maybeRouteDb = std::nullopt;
-  if (pendingUpdates_.needsRouteUpdate() || staticRoutesUpdated) {
-    // if only static routes gets updated, we still need to update routes
+  if (pendingUpdates_.needsRouteUpdate() || staticMplsRoutesUpdated) {
+    // if only static MPLS routes gets updated, we still need to update routes
     // because there maybe routes depended on static routes.
-    maybeRouteDb = buildRouteDb(myNodeName_);
+    const bool fullRebuild =
+        pendingUpdates_.needsFullRebuild() || staticMplsRoutesUpdated;
+    if (routeComputeExecutor_) {
+      fb303::fbData->addStatValue(
+          "decision.async_route_builds", 1, fb303::COUNT);
+      routeComputeInFlight_ = true;
+      routeComputeExecutor_->add([this, fullRebuild, startTime]() {
+        std::optional<DecisionRouteDb> routeDb;
+        {
+          ScopedPhaseTimer timer("route_build");
+          routeDb = computeRouteDb(fullRebuild);
+        }
+        runInEventBaseThread(
+            [this, startTime, routeDb = std::move(routeDb)]() mutable {
+              routeComputeInFlight_ = false;
+              commitRouteDb(std::move(routeDb), startTime);
+              processDeferredUpdates();
+            });
+      });
+      return;
+    }
+    ScopedPhaseTimer timer("route_build");
+    maybeRouteDb = computeRouteDb(fullRebuild);
+  } else if (not pendingStaticUnicastChanges_.empty()) {
+    // static unicast routes don't depend on SPF, only their prefixes change
+    ScopedPhaseTimer timer("static_routes");
+    maybeRouteDb = buildStaticUnicastRouteDb();
+  }
+  commitRouteDb(std::move(maybeRouteDb), startTime);
+}
+
+DecisionRouteDb
+Decision::buildStaticUnicastRouteDb() {
+  // journaled db of the changed prefixes, falling back to computed routes of
+  // the prefixes with their static route removed
+  std::vector<std::string> areas;
+  for (auto const& [area, _] : areaRouteStates_) {
+    areas.emplace_back(area);
+  }
+  std::sort(areas.begin(), areas.end());
+
+  DecisionRouteDb db;
+  db.unicastEntries.reserve(pendingStaticUnicastChanges_.size());
+  for (auto const& prefix : pendingStaticUnicastChanges_) {
+    for (auto const& area : areas) {
+      auto entry = folly::get_ptr(
+          areaRouteStates_.at(area).routeDb.unicastEntries, prefix);
+      if (entry) {
+        addCoalescedUnicastEntry(db.unicastEntries, prefix, *entry);
+      }
+    }
+  }
+  db.unicastChanges = std::move(pendingStaticUnicastChanges_);
+  pendingStaticUnicastChanges_.clear();
+  applyStaticUnicastRoutes(db);
+  // MPLS routes are unchanged, journaled db carries all of them
+  db.mplsEntries = routeDb_.mplsEntries;
+  fb303::fbData->addStatValue(
+      "decision.static_unicast_route_builds", 1, fb303::COUNT);
+  return db;
+}
+
+void
+Decision::applyStaticUnicastRoutes(DecisionRouteDb& db) const {
+  auto const& staticRoutes = spfSolver_->getStaticUnicastRoutes();
+  auto applyStaticRoute = [&](thrift::IpPrefix const& prefix,
+                              RibUnicastEntry const& entry) {
+    // entries are not assignable, replace the node instead
+    db.unicastEntries.erase(prefix);
+    db.unicastEntries.emplace(prefix, entry);
+  };
+  if (not db.unicastChanges.has_value()) {
+    for (auto const& [prefix, entry] : staticRoutes) {
+      applyStaticRoute(prefix, entry);
+    }
+    return;
+  }
+  // only the changed prefixes of a journaled db
+  for (auto const& prefix : *db.unicastChanges) {
+    if (auto entry = folly::get_ptr(staticRoutes, prefix)) {
+      applyStaticRoute(prefix, *entry);
+    }
+  }
+}
+
+void
+Decision::commitRouteDb(
+    std::optional<DecisionRouteDb>&& maybeRouteDb,
+    std::chrono::steady_clock::time_point startTime) {
+  if (enablePhasePerfEvents_) {
+    pendingUpdates_.addEvent("DECISION_ROUTE_BUILT");
   }
   if (maybeRouteDb.has_value()) {
+    const bool journaled = maybeRouteDb->unicastChanges.has_value();
     sendRouteUpdate(
         std::move(*maybeRouteDb),
         pendingUpdates_.moveOutEvents(),
         "ROUTE_UPDATE");
+    // full diff of journaled route updates is only done periodically
+    const auto checkInterval = Constants::kDecisionRouteDbCheckInterval;
+    if (journaled and ++numJournaledRouteUpdates_ % checkInterval == 0) {
+      checkRouteDbConsistency();
+    }
   } else {
     LOG(WARNING) << "processPendingUpdates incurred no routes";
   }
 
   pendingUpdates_.reset();
 
-  // update decision debounce flag
-  processUpdatesBackoff_.reportSuccess();
+  // update decision debounce with cost of this processing
+  processUpdatesDebounce_.reportProcessed(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - startTime));
   if (processUpdatesTimer_->isScheduled()) {
     processUpdatesTimer_->cancelTimeout();
   }
 }
 
 void
-Decision::processRibPolicyUpdate() {
+Decision::processDeferredUpdates() {
+  if (ribPolicyUpdateDeferred_) {
+    // old policy is gone, rebuild all routes with the active one
+    ribPolicyUpdateDeferred_ = false;
+    pendingUpdates_.setNeedsFullRebuild();
+  }
+  if (pendingUpdates_.needsRouteUpdate() or not pendingKeyVals_.empty() or
+      spfSolver_->staticRoutesUpdated()) {
+    scheduleProcessPendingUpdates();
+  }
+  if (not pendingRouteDbNodes_.empty() and
+      not routeDbComputationTimer_->isScheduled()) {
+    routeDbComputationTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+  }
+}
+
+RibPolicy const*
+Decision::getActiveRibPolicy() const {
+  return ribPolicy_ && ribPolicy_->isActive() ? ribPolicy_.get() : nullptr;
+}
+
+void
+Decision::processRibPolicyUpdate(RibPolicy const* oldRibPolicy) {
   if (coldStartTimer_->isScheduled()) {
     return;
   }
+  if (routeComputeInFlight_) {
+    fb303::fbData->addStatValue(
+        "decision.deferred_during_route_build", 1, fb303::COUNT);
+    ribPolicyUpdateDeferred_ = true;
+    return;
+  }
 
-  LOG(INFO) << "Decision: updating route db with RibPolicy change";
-  auto maybeRouteDb = buildRouteDb(myNodeName_);
-  if (not maybeRouteDb.has_value()) {
-    LOG(WARNING) << "Incurred no route updates";
+  processPendingPublications();
+
+  // Routes before policy are only up to date without pending updates
+  if (areaRouteStates_.empty() or pendingUpdates_.needsRouteUpdate()) {
+    LOG(INFO) << "Decision: updating route db with RibPolicy change";
+    auto maybeRouteDb = rebuildRouteDb(true /* fullRebuild */);
+    if (not maybeRouteDb.has_value()) {
+      LOG(WARNING) << "Incurred no route updates";
+      return;
+    }
+
+    // Create empty list of perf events
+    sendRouteUpdate(
+        std::move(*maybeRouteDb), thrift::PerfEvents{}, "RIB_POLICY_UPDATE");
     return;
   }
 
-  // Create empty list of perf events
-  sendRouteUpdate(
-      std::move(*maybeRouteDb), thrift::PerfEvents{}, "RIB_POLICY_UPDATE");
+  auto const* ribPolicy = getActiveRibPolicy();
+  auto const prefixes =
+      RibPolicy::getChangedPrefixes(oldRibPolicy, ribPolicy);
+  LOG(INFO) << "Decision: re-applying RibPolicy change on " << prefixes.size()
+            << " prefixes";
+
+  // visit areas in the same order as buildAreaRouteDbs, which breaks ties
+  std::vector<std::string> areas;
+  for (auto const& [area, _] : areaRouteStates_) {
+    areas.emplace_back(area);
+  }
+  std::sort(areas.begin(), areas.end());
+
+  // old and new routes of the changed prefixes only
+  DecisionRouteDb oldDb, newDb;
+  newDb.unicastChanges.emplace();
+  for (auto const& network : prefixes) {
+    auto const prefix = toIpPrefix(network);
+    if (auto oldEntry = folly::get_ptr(routeDb_.unicastEntries, prefix)) {
+      oldDb.unicastEntries.emplace(prefix, *oldEntry);
+    }
+    for (auto const& area : areas) {
+      auto const& areaEntries =
+          areaRouteStates_.at(area).routeDb.unicastEntries;
+      auto entryIt = areaEntries.find(prefix);
+      if (entryIt != areaEntries.end()) {
+        addCoalescedUnicastEntry(newDb.unicastEntries, prefix, entryIt->second);
+      }
+    }
+    newDb.unicastChanges->emplace(prefix);
+  }
+  applyStaticUnicastRoutes(newDb);
+  applyRibPolicy(newDb);
+
+  auto delta = getRouteDelta(newDb, oldDb);
+  if (enableNextHopGroups_) {
+    assignNextHopGroups(delta, newDb, oldDb);
+  }
+  for (auto const& [prefix, _] : oldDb.unicastEntries) {
+    routeDb_.unicastEntries.erase(prefix);
+  }
+  routeDbBytes_ += getEntriesMemoryUsage(newDb.unicastEntries);
+  routeDbBytes_ -= getEntriesMemoryUsage(oldDb.unicastEntries);
+  routeDb_.unicastEntries.merge(newDb.unicastEntries);
+
+  thrift::PerfEvents perfEvents;
+  addPerfEvent(perfEvents, myNodeName_, "RIB_POLICY_UPDATE");
+  delta.thisNodeName = myNodeName_;
+  delta.perfEvents_ref() = std::move(perfEvents);
+  routeUpdatesQueue_.push(std::move(delta));
 }
 
 bool
 Decision::decrementOrderedFibHolds() {
+  // retried on next hold decrement
+  if (routeComputeInFlight_) {
+    fb303::fbData->addStatValue(
+        "decision.deferred_during_route_build", 1, fb303::COUNT);
+    return true;
+  }
   bool topoChanged = false;
   bool stillHasHolds = false;
   for (auto& [_, linkState] : areaLinkStates_) {
@@ -1760,7 +3541,7 @@ Decision::decrementOrderedFibHolds() {
     stillHasHolds |= linkState.hasHolds();
   }
   if (topoChanged && !coldStartTimer_->isScheduled()) {
-    auto maybeRouteDb = buildRouteDb(myNodeName_);
+    auto maybeRouteDb = rebuildRouteDb(true /* fullRebuild */);
     if (maybeRouteDb.has_value()) {
       // Create empty perfEvents list. In this case we don't this route update
       // to be inculded in the Fib time
@@ -1777,7 +3558,7 @@ Decision::decrementOrderedFibHolds() {
 
 void
 Decision::coldStartUpdate() {
-  auto maybeRouteDb = buildRouteDb(myNodeName_);
+  auto maybeRouteDb = rebuildRouteDb(true /* fullRebuild */);
   if (not maybeRouteDb.has_value()) {
     LOG(ERROR) << "SEVERE: No routes to program after cold start duration. "
                << "Sending empty route db to FIB";
@@ -1793,17 +3574,11 @@ Decision::coldStartUpdate() {
 
 std::optional<DecisionRouteDb>
 Decision::buildRouteDb(const std::string& nodeName) const {
+  auto areaDbs = buildAreaRouteDbs(nodeName);
   DecisionRouteDb db;
-  for (auto const& [area, linkState] : areaLinkStates_) {
-    if (auto maybeAreaDb =
-            spfSolver_->buildRouteDb(nodeName, linkState, prefixState_)) {
-      auto const& areaDb = maybeAreaDb.value();
-      // TODO: add colasecing/redistibution logic here instead of just appending
-      db.unicastEntries.insert(
-          areaDb.unicastEntries.begin(), areaDb.unicastEntries.end());
-      db.mplsEntries.insert(
-          areaDb.mplsEntries.begin(), areaDb.mplsEntries.end());
-      // TODO: Sort out how to combine perf events
+  for (auto& [area, maybeAreaDb] : areaDbs) {
+    if (maybeAreaDb) {
+      mergeAreaRouteDb(db, std::move(maybeAreaDb).value());
     } else {
       LOG(WARNING) << "No routes for area: " << area;
     }
@@ -1816,6 +3591,293 @@ Decision::buildRouteDb(const std::string& nodeName) const {
   }
 }
 
+std::vector<std::pair<std::string, std::optional<DecisionRouteDb>>>
+Decision::buildAreaRouteDbs(
+    std::string const& nodeName,
+    std::unordered_map<std::string, AffectedRoutes> const* areaRoutes) const {
+  // visit areas in a fixed order so the coalesced routes do not depend on the
+  // iteration order of areaLinkStates_
+  std::vector<std::pair<std::string, LinkState const*>> areas;
+  areas.reserve(areaLinkStates_.size());
+  for (auto const& [area, linkState] : areaLinkStates_) {
+    areas.emplace_back(area, &linkState);
+  }
+  std::sort(areas.begin(), areas.end());
+
+  auto buildAreaRouteDb = [this, &nodeName, areaRoutes](
+                              std::string const& area,
+                              LinkState const& linkState) {
+    if (areaRoutes) {
+      auto const& affected = areaRoutes->at(area);
+      return spfSolver_->buildRouteDb(
+          nodeName,
+          linkState,
+          prefixState_,
+          affected.prefixes,
+          affected.labelNodes);
+    }
+    return spfSolver_->buildRouteDb(nodeName, linkState, prefixState_);
+  };
+
+  // each area only touches its own LinkState (including the memoized SPF
+  // results) and reads the shared PrefixState, so areas can be computed
+  // concurrently
+  std::vector<std::pair<std::string, std::optional<DecisionRouteDb>>> areaDbs;
+  areaDbs.reserve(areas.size());
+  for (auto const& [area, _] : areas) {
+    areaDbs.emplace_back(area, std::nullopt);
+  }
+  if (routeBuildExecutor_ and areas.size() > 1) {
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    futures.reserve(areas.size());
+    for (size_t i = 0; i < areas.size(); ++i) {
+      auto task = [&buildAreaRouteDb, &areas, &areaDbs, i]() {
+        areaDbs[i].second = buildAreaRouteDb(areas[i].first, *areas[i].second);
+      };
+      futures.emplace_back(
+          folly::via(routeBuildExecutor_.get(), std::move(task)).semi());
+    }
+    // rethrows the first exception of any area
+    folly::collect(std::move(futures)).get();
+  } else {
+    for (size_t i = 0; i < areas.size(); ++i) {
+      areaDbs[i].second = buildAreaRouteDb(areas[i].first, *areas[i].second);
+    }
+  }
+  return areaDbs;
+}
+
+std::optional<DecisionRouteDb>
+Decision::rebuildRouteDb(bool fullRebuild) {
+  processPendingPublications();
+  return computeRouteDb(fullRebuild);
+}
+
+std::optional<DecisionRouteDb>
+Decision::computeRouteDb(bool fullRebuild) {
+  // BGP routes carry the loopback of their best node
+  fullRebuild |=
+      (prefixState_.getNodeHostLoopbacksV4() != routeHostLoopbacksV4_ or
+       prefixState_.getNodeHostLoopbacksV6() != routeHostLoopbacksV6_);
+
+  std::unordered_map<std::string, AffectedRoutes> areaRoutes;
+  for (auto const& [area, linkState] : areaLinkStates_) {
+    if (fullRebuild) {
+      break;
+    }
+    std::optional<AffectedRoutes> affected;
+    auto stateIt = areaRouteStates_.find(area);
+    if (stateIt != areaRouteStates_.end()) {
+      affected = getAffectedRoutes(linkState, stateIt->second);
+    }
+    if (not affected) {
+      fullRebuild = true;
+      break;
+    }
+    areaRoutes.emplace(area, std::move(affected).value());
+  }
+
+  auto areaDbs =
+      buildAreaRouteDbs(myNodeName_, fullRebuild ? nullptr : &areaRoutes);
+
+  size_t numPrefixesRecomputed = 0;
+  size_t numLabelsRecomputed = 0;
+  DecisionRouteDb db;
+  // prefixes whose routes may have changed, if not fullRebuild
+  std::unordered_set<thrift::IpPrefix> changedPrefixes;
+  changedPrefixes.swap(pendingStaticUnicastChanges_);
+  for (auto& [area, maybeAreaDb] : areaDbs) {
+    if (not maybeAreaDb) {
+      // we are not part of this area (yet), start over once we are
+      auto stateIt = areaRouteStates_.find(area);
+      if (stateIt != areaRouteStates_.end()) {
+        for (auto const& [prefix, _] : stateIt->second.routeDb.unicastEntries) {
+          changedPrefixes.emplace(prefix);
+        }
+        areaRouteStates_.erase(stateIt);
+      }
+      LOG(WARNING) << "No routes for area: " << area;
+      continue;
+    }
+    auto& state = areaRouteStates_[area];
+    if (fullRebuild) {
+      state.routeDb = std::move(maybeAreaDb).value();
+    } else {
+      auto const& affected = areaRoutes.at(area);
+      auto const& prefixes = affected.prefixes;
+      numPrefixesRecomputed += prefixes.size();
+      for (auto const& prefix : prefixes) {
+        state.routeDb.unicastEntries.erase(prefix);
+      }
+      state.routeDb.unicastEntries.merge(maybeAreaDb->unicastEntries);
+      numLabelsRecomputed += affected.labels.size();
+      for (auto const label : affected.labels) {
+        state.routeDb.mplsEntries.erase(label);
+      }
+      state.routeDb.mplsEntries.merge(maybeAreaDb->mplsEntries);
+      changedPrefixes.insert(prefixes.begin(), prefixes.end());
+    }
+    recordAreaRouteState(areaLinkStates_.at(area), state);
+    if (fullRebuild) {
+      mergeAreaRouteDb(db, state.routeDb);
+    } else {
+      db.mplsEntries.insert(
+          state.routeDb.mplsEntries.begin(), state.routeDb.mplsEntries.end());
+    }
+  }
+
+  // only carry unicast routes of the changed prefixes, coalesced over areas
+  if (not fullRebuild) {
+    db.unicastEntries.reserve(changedPrefixes.size());
+    for (auto const& prefix : changedPrefixes) {
+      for (auto const& [area, _] : areaDbs) {
+        auto stateIt = areaRouteStates_.find(area);
+        if (stateIt == areaRouteStates_.end()) {
+          continue;
+        }
+        auto entry =
+            folly::get_ptr(stateIt->second.routeDb.unicastEntries, prefix);
+        if (entry) {
+          addCoalescedUnicastEntry(db.unicastEntries, prefix, *entry);
+        }
+      }
+    }
+    db.unicastChanges = std::move(changedPrefixes);
+  }
+  applyStaticUnicastRoutes(db);
+  routeHostLoopbacksV4_ = prefixState_.getNodeHostLoopbacksV4();
+  routeHostLoopbacksV6_ = prefixState_.getNodeHostLoopbacksV6();
+
+  if (not fullRebuild) {
+    fb303::fbData->addStatValue(
+        "decision.incremental_route_build_runs", 1, fb303::COUNT);
+    fb303::fbData->addStatValue(
+        "decision.incremental_prefixes_recomputed",
+        numPrefixesRecomputed,
+        fb303::SUM);
+    fb303::fbData->addStatValue(
+        "decision.incremental_labels_recomputed",
+        numLabelsRecomputed,
+        fb303::SUM);
+  }
+
+  const bool hasUnicastRoutes = std::any_of(
+      areaRouteStates_.begin(), areaRouteStates_.end(), [](auto const& kv) {
+        return not kv.second.routeDb.unicastEntries.empty();
+      });
+  if (not hasUnicastRoutes && db.unicastEntries.empty() &&
+      db.mplsEntries.empty()) {
+    return std::nullopt;
+  } else {
+    return db;
+  }
+}
+
+std::optional<Decision::AffectedRoutes>
+Decision::getAffectedRoutes(
+    LinkState const& linkState, AreaRouteState const& state) const {
+  AffectedRoutes affected;
+  auto& prefixes = affected.prefixes;
+  prefixes = pendingUpdates_.updatedPrefixes();
+  if (not pendingUpdates_.topologyChanged()) {
+    return affected;
+  }
+
+  // nexthops of every route are built from our own links
+  if (getLocalLinks(linkState, myNodeName_) != state.localLinks) {
+    return std::nullopt;
+  }
+
+  // nodes whose shortest paths or drain state changed
+  std::unordered_set<std::string> changedNodes;
+  for (auto const& [nodeName, oldSpfResult] : state.spfResults) {
+    addChangedNodes(
+        oldSpfResult, linkState.getSpfResult(nodeName), changedNodes);
+  }
+  for (auto const& [nodeName, _] : linkState.getAdjacencyDatabases()) {
+    if (linkState.isNodeOverloaded(nodeName) !=
+        (state.overloadedNodes.count(nodeName) > 0)) {
+      changedNodes.emplace(nodeName);
+    }
+  }
+  for (auto const& nodeName : state.overloadedNodes) {
+    if (not linkState.hasNode(nodeName)) {
+      changedNodes.emplace(nodeName);
+    }
+  }
+
+  // the distance from a neighbor back to us is part of the LFA condition of
+  // every prefix
+  if (changedNodes.count(myNodeName_)) {
+    return std::nullopt;
+  }
+
+  auto const& nodeToPrefixes = prefixState_.nodeToPrefixes();
+  for (auto const& nodeName : changedNodes) {
+    if (auto nodePrefixes = folly::get_ptr(nodeToPrefixes, nodeName)) {
+      for (auto const& key : *nodePrefixes) {
+        prefixes.emplace(key.toIpPrefix());
+      }
+    }
+  }
+
+  // KSP2 second shortest paths avoid the links of the first ones and can be
+  // moved by a change of any link, recompute them all
+  for (auto const& kv : prefixState_.prefixes()) {
+    for (auto const& [_, prefixEntry] : kv.second) {
+      if (prefixEntry.forwardingAlgorithm ==
+          thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP) {
+        prefixes.emplace(PrefixState::getPrefix(kv.second));
+        break;
+      }
+    }
+  }
+
+  // node label routes lead to the node holding the label, like its prefixes.
+  // Node labels themselves only change with a full rebuild, yet a node may
+  // have left the area since
+  for (auto const& nodeName : changedNodes) {
+    if (auto label = folly::get_ptr(state.nodeLabels, nodeName)) {
+      affected.labels.emplace(*label);
+    }
+  }
+  for (auto const& [nodeName, adjDb] : linkState.getAdjacencyDatabases()) {
+    if (affected.labels.count(adjDb.nodeLabel)) {
+      affected.labelNodes.emplace(nodeName);
+    }
+  }
+  return affected;
+}
+
+void
+Decision::recordAreaRouteState(
+    LinkState const& linkState, AreaRouteState& state) const {
+  state.spfResults.clear();
+  state.spfResults.emplace(myNodeName_, linkState.getSpfResult(myNodeName_));
+  if (computeLfaPaths_) {
+    for (auto const& link : linkState.linksFromNode(myNodeName_)) {
+      if (link->isUp()) {
+        auto const& neighbor = link->getOtherNodeName(myNodeName_);
+        state.spfResults.try_emplace(
+            neighbor, linkState.getSpfResult(neighbor));
+      }
+    }
+  }
+
+  state.localLinks = getLocalLinks(linkState, myNodeName_);
+
+  state.overloadedNodes.clear();
+  state.nodeLabels.clear();
+  for (auto const& [nodeName, adjDb] : linkState.getAdjacencyDatabases()) {
+    if (linkState.isNodeOverloaded(nodeName)) {
+      state.overloadedNodes.emplace(nodeName);
+    }
+    if (adjDb.nodeLabel != 0) {
+      state.nodeLabels.emplace(nodeName, adjDb.nodeLabel);
+    }
+  }
+}
+
 void
 Decision::sendRouteUpdate(
     DecisionRouteDb&& routeDb,
@@ -1826,9 +3888,74 @@ Decision::sendRouteUpdate(
   }
 
   //
-  // Apply RibPolicy to computed route db before sending out
+  // Apply RibPolicy to computed route db before sending out. Only the
+  // changed routes if the db is journaled, others have it applied already
   //
+  applyRibPolicy(routeDb);
+
+  if (enablePhasePerfEvents_ and perfEvents.has_value()) {
+    addPerfEvent(*perfEvents, myNodeName_, "DECISION_RIB_POLICY");
+  }
+
+  std::optional<ScopedPhaseTimer> deltaTimer;
+  deltaTimer.emplace("route_delta");
+  // TODO change this to publish RibUpdate directly
+  thrift::RouteDatabaseDelta delta;
+  if (routeDb.unicastChanges.has_value()) {
+    // diff and update cached routes of the changed prefixes only
+    DecisionRouteDb oldDb;
+    for (auto const& prefix : *routeDb.unicastChanges) {
+      if (auto oldEntry = folly::get_ptr(routeDb_.unicastEntries, prefix)) {
+        oldDb.unicastEntries.emplace(prefix, *oldEntry);
+      }
+    }
+    oldDb.mplsEntries = std::move(routeDb_.mplsEntries);
+    delta = getRouteDelta(routeDb, oldDb);
+    if (enableNextHopGroups_) {
+      assignNextHopGroups(delta, routeDb, oldDb);
+    }
+    for (auto const& [prefix, _] : oldDb.unicastEntries) {
+      routeDb_.unicastEntries.erase(prefix);
+    }
+    routeDbBytes_ += getEntriesMemoryUsage(routeDb.unicastEntries) +
+        getEntriesMemoryUsage(routeDb.mplsEntries);
+    routeDbBytes_ -= getEntriesMemoryUsage(oldDb.unicastEntries) +
+        getEntriesMemoryUsage(oldDb.mplsEntries);
+    routeDb_.unicastEntries.merge(routeDb.unicastEntries);
+    routeDb_.mplsEntries = std::move(routeDb.mplsEntries);
+    fb303::fbData->addStatValue(
+        "decision.journaled_route_updates", 1, fb303::COUNT);
+  } else {
+    delta = getRouteDelta(routeDb, routeDb_);
+    if (enableNextHopGroups_) {
+      assignNextHopGroups(delta, routeDb, routeDb_);
+    }
+
+    // update decision routeDb cache
+    routeDbBytes_ = getEntriesMemoryUsage(routeDb.unicastEntries) +
+        getEntriesMemoryUsage(routeDb.mplsEntries);
+    routeDb_ = std::move(routeDb);
+  }
+  deltaTimer.reset();
+  if (enablePhasePerfEvents_ and perfEvents.has_value()) {
+    addPerfEvent(*perfEvents, myNodeName_, "DECISION_ROUTE_DELTA");
+  }
+
+  // publish the new route state to fib
+  // TODO - remove thisNodeName from routeDelta
+  delta.thisNodeName = myNodeName_;
+  fromStdOptional(delta.perfEvents_ref(), perfEvents);
+  if (not routeDb_.unicastEntries.empty()) {
+    StartupTimeline::get().record("first_rib");
+  }
+  ScopedPhaseTimer timer("publish");
+  routeUpdatesQueue_.push(std::move(delta));
+}
+
+void
+Decision::applyRibPolicy(DecisionRouteDb& routeDb) const {
   if (ribPolicy_ && ribPolicy_->isActive()) {
+    ScopedPhaseTimer timer("rib_policy");
     auto i = routeDb.unicastEntries.begin();
     while (i != routeDb.unicastEntries.end()) {
       auto& entry = i->second;
@@ -1847,18 +3974,80 @@ Decision::sendRouteUpdate(
       ++i;
     }
   }
+}
 
-  // TODO change this to publish RibUpdate directly
-  auto delta = getRouteDelta(routeDb, routeDb_);
+void
+Decision::checkRouteDbConsistency() {
+  // visit areas in the same order as buildAreaRouteDbs, which breaks ties
+  std::vector<std::string> areas;
+  for (auto const& [area, _] : areaRouteStates_) {
+    areas.emplace_back(area);
+  }
+  std::sort(areas.begin(), areas.end());
+  DecisionRouteDb db;
+  for (auto const& area : areas) {
+    mergeAreaRouteDb(db, areaRouteStates_.at(area).routeDb);
+  }
+  applyStaticUnicastRoutes(db);
+  auto expectedDb = db;
+  applyRibPolicy(expectedDb);
+
+  const auto delta = getRouteDelta(expectedDb, routeDb_);
+  if (delta.unicastRoutesToUpdate.empty() and
+      delta.unicastRoutesToDelete.empty() and
+      delta.mplsRoutesToUpdate.empty() and delta.mplsRoutesToDelete.empty()) {
+    return;
+  }
+  LOG(ERROR) << "Cached routes diverged from computed routes by "
+             << delta.unicastRoutesToUpdate.size() << " unicast updates, "
+             << delta.unicastRoutesToDelete.size() << " unicast deletes, "
+             << delta.mplsRoutesToUpdate.size() << " mpls updates, "
+             << delta.mplsRoutesToDelete.size() << " mpls deletes. Repairing";
+  fb303::fbData->addStatValue(
+      "decision.route_db_inconsistencies", 1, fb303::COUNT);
+  sendRouteUpdate(std::move(db), thrift::PerfEvents{}, "ROUTE_DB_REPAIR");
+}
 
-  // update decision routeDb cache
-  routeDb_ = std::move(routeDb);
+void
+Decision::assignNextHopGroups(
+    thrift::RouteDatabaseDelta& delta,
+    DecisionRouteDb const& newDb,
+    DecisionRouteDb const& oldDb) {
+  // take references for the new routes first, so that a group moving between
+  // routes is not withdrawn and announced again within the same delta
+  for (auto& route : delta.unicastRoutesToUpdate) {
+    auto const& nexthops = newDb.unicastEntries.at(route.dest).nexthops;
+    auto& group = nextHopGroups_[nexthops];
+    if (group.refCount++ == 0) {
+      group.id = ++lastNextHopGroupId_;
+      delta.nextHopGroupsToUpdate.emplace(group.id, std::move(route.nextHops));
+    }
+    route.nextHopGroupId_ref() = group.id;
+    route.nextHops.clear();
+  }
 
-  // publish the new route state to fib
-  // TODO - remove thisNodeName from routeDelta
-  delta.thisNodeName = myNodeName_;
-  fromStdOptional(delta.perfEvents_ref(), perfEvents);
-  routeUpdatesQueue_.push(std::move(delta));
+  // release the groups of replaced and deleted routes
+  auto releaseGroup = [&](thrift::IpPrefix const& prefix) {
+    auto const* oldEntry = folly::get_ptr(oldDb.unicastEntries, prefix);
+    if (not oldEntry) {
+      return;
+    }
+    auto it = nextHopGroups_.find(oldEntry->nexthops);
+    CHECK(it != nextHopGroups_.end());
+    if (--it->second.refCount == 0) {
+      delta.nextHopGroupsToDelete.emplace_back(it->second.id);
+      nextHopGroups_.erase(it);
+    }
+  };
+  for (auto const& route : delta.unicastRoutesToUpdate) {
+    releaseGroup(route.dest);
+  }
+  for (auto const& prefix : delta.unicastRoutesToDelete) {
+    releaseGroup(prefix);
+  }
+
+  fb303::fbData->setCounter(
+      "decision.num_nexthop_groups", nextHopGroups_.size());
 }
 
 std::chrono::milliseconds
@@ -1872,24 +4061,12 @@ Decision::getMaxFib() {
 
 void
 Decision::updateGlobalCounters() const {
+  // counts are maintained as link states and routes are updated, nothing is
+  // scanned or computed here
   size_t numAdjacencies = 0, numPartialAdjacencies = 0;
-  std::unordered_set<std::string> nodeSet;
   for (auto const& [_, linkState] : areaLinkStates_) {
     numAdjacencies += linkState.numLinks();
-    auto const& mySpfResult = linkState.getSpfResult(myNodeName_);
-    for (auto const& kv : linkState.getAdjacencyDatabases()) {
-      nodeSet.insert(kv.first);
-      const auto& adjDb = kv.second;
-      size_t numLinks = linkState.linksFromNode(kv.first).size();
-      // Consider partial adjacency only iff node is reachable from current node
-      if (mySpfResult.count(adjDb.thisNodeName) && 0 != numLinks) {
-        // only add to the count if this node is not completely disconnected
-        size_t diff = adjDb.adjacencies.size() - numLinks;
-        // Number of links (bi-directional) must be <= number of adjacencies
-        CHECK_GE(diff, 0);
-        numPartialAdjacencies += diff;
-      }
-    }
+    numPartialAdjacencies += linkState.numPartialAdjacencies();
   }
 
   // Add custom counters
@@ -1899,7 +4076,8 @@ Decision::updateGlobalCounters() const {
       "decision.num_complete_adjacencies", numAdjacencies);
   // When node has no adjacencies then linkState reports 0
   fb303::fbData->setCounter(
-      "decision.num_nodes", std::max(nodeSet.size(), static_cast<size_t>(1ul)));
+      "decision.num_nodes",
+      std::max(nodeNumAreas_.size(), static_cast<size_t>(1ul)));
   fb303::fbData->setCounter(
       "decision.num_prefixes", prefixState_.prefixes().size());
   fb303::fbData->setCounter(
@@ -1908,6 +4086,24 @@ Decision::updateGlobalCounters() const {
   fb303::fbData->setCounter(
       "decision.num_nodes_v6_loopbacks",
       prefixState_.getNodeHostLoopbacksV6().size());
+
+  setMemoryCounter("decision", "route_db", routeDbBytes_);
+}
+
+void
+Decision::updateNodeNumAreas(
+    const std::string& nodeName, bool hadNode, bool hasNode) {
+  if (hadNode == hasNode) {
+    return;
+  }
+  if (hasNode) {
+    ++nodeNumAreas_[nodeName];
+    return;
+  }
+  auto it = nodeNumAreas_.find(nodeName);
+  if (it != nodeNumAreas_.end() and --it->second == 0) {
+    nodeNumAreas_.erase(it);
+  }
 }
 
 } // namespace openr
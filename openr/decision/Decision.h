@@ -8,8 +8,13 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
+#include <map>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <boost/serialization/strong_typedef.hpp>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
@@ -18,13 +23,14 @@
 #include <folly/IPAddress.h>
 #include <folly/Memory.h>
 #include <folly/String.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <thrift/lib/cpp2/Thrift.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include <openr/common/AdaptiveDebounce.h>
 #include <openr/common/AsyncThrottle.h>
-#include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrEventBase.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
@@ -53,7 +59,8 @@ struct BestPathCalResult {
   std::string bestNode{""};
   std::set<std::string> nodes;
   std::optional<int64_t> bestIgpMetric{std::nullopt};
-  std::optional<thrift::MetricVector> bestVector{std::nullopt};
+  std::optional<MetricVectorUtils::CompiledMetricVector> bestVector{
+      std::nullopt};
 };
 
 struct DecisionRouteDb {
@@ -61,6 +68,11 @@ struct DecisionRouteDb {
       unicastEntries;
   std::unordered_map<int32_t /* label */, RibMplsEntry> mplsEntries;
 
+  // Journal of an incremental route build: if set, unicastEntries only holds
+  // routes of these prefixes, and prefixes without entry are withdrawn.
+  // Routes of other prefixes are unchanged
+  std::optional<std::unordered_set<thrift::IpPrefix>> unicastChanges;
+
   thrift::RouteDatabase
   toThrift() const {
     thrift::RouteDatabase tRouteDb;
@@ -105,9 +117,16 @@ class DecisionPendingUpdates {
     return needsFullRebuild_;
   }
 
+  // set if the topology of any area changed. Routes of prefixes that depend
+  // on changed parts of the topology need to be recomputed
+  bool
+  topologyChanged() const {
+    return topologyChanged_;
+  }
+
   bool
   needsRouteUpdate() const {
-    return needsFullRebuild() || !updatedPrefixes_.empty();
+    return needsFullRebuild() || topologyChanged() || !updatedPrefixes_.empty();
   }
 
   std::unordered_set<thrift::IpPrefix> const&
@@ -121,10 +140,13 @@ class DecisionPendingUpdates {
       LinkState::LinkStateChange const& change,
       std::optional<thrift::PerfEvents> const& perfEvents = std::nullopt) {
     needsFullRebuild_ |=
-        (change.topologyChanged || change.nodeLabelChanged ||
+        (change.nodeLabelChanged ||
+         // changes of our own adjacencies can alter the nexthops of any route
+         (change.topologyChanged && nodeName == myNodeName_) ||
          // we only need a full rebuild if link attributes change locally
          // this would be a nexthop on link label change
          (change.linkAttributesChanged && nodeName == myNodeName_));
+    topologyChanged_ |= change.topologyChanged;
     addUpdate(perfEvents);
   }
 
@@ -136,11 +158,18 @@ class DecisionPendingUpdates {
     addUpdate(perfEvents);
   }
 
+  // e.g. on change of RibPolicy while routes are being computed
+  void
+  setNeedsFullRebuild() {
+    needsFullRebuild_ = true;
+  }
+
   void
   reset() {
     count_ = 0;
     perfEvents_ = std::nullopt;
     needsFullRebuild_ = false;
+    topologyChanged_ = false;
     updatedPrefixes_.clear();
   }
 
@@ -197,6 +226,9 @@ class DecisionPendingUpdates {
   // set if we need to rebuild all routes
   bool needsFullRebuild_{false};
 
+  // see topologyChanged()
+  bool topologyChanged_{false};
+
   // track prefixes that have changed in this batch
   std::unordered_set<thrift::IpPrefix> updatedPrefixes_;
 
@@ -206,6 +238,15 @@ class DecisionPendingUpdates {
 
 } // namespace detail
 
+// Squashed static route updates, see SpfSolver::processStaticRouteUpdates
+struct StaticRoutesUpdate {
+  // delta of static MPLS routes, published to Fib as is
+  std::optional<thrift::RouteDatabaseDelta> mplsRoutesDelta;
+
+  // prefixes whose static unicast route was added, changed or removed
+  std::unordered_set<thrift::IpPrefix> unicastChanges;
+};
+
 // The class to compute shortest-paths using Dijkstra algorithm
 class SpfSolver {
  public:
@@ -217,7 +258,11 @@ class SpfSolver {
       bool computeLfaPaths,
       bool enableOrderedFib = false,
       bool bgpDryRun = false,
-      bool bgpUseIgpMetric = false);
+      bool bgpUseIgpMetric = false,
+      int32_t numRouteBuildThreads = 0,
+      std::optional<thrift::ThreadSchedulingConfig> routeBuildScheduling =
+          std::nullopt,
+      bool enableUcmp = false);
   ~SpfSolver();
 
   //
@@ -229,10 +274,16 @@ class SpfSolver {
 
   void pushRoutesDeltaUpdates(thrift::RouteDatabaseDelta& staticRoutesDelta);
 
-  std::optional<thrift::RouteDatabaseDelta> processStaticRouteUpdates();
+  // squash pending static route updates, latest update of a label or prefix
+  // wins, and apply them
+  StaticRoutesUpdate processStaticRouteUpdates();
 
+  // static MPLS routes. Static unicast routes are kept apart as RIB entries
   thrift::StaticRoutes const& getStaticRoutes();
 
+  std::unordered_map<thrift::IpPrefix, RibUnicastEntry> const&
+  getStaticUnicastRoutes();
+
   // Build route database using given prefix and link states for a given
   // router, myNodeName
   // Returns std::nullopt if myNodeName doesn't have any prefix database
@@ -241,6 +292,16 @@ class SpfSolver {
       LinkState const& linkState,
       PrefixState const& prefixState);
 
+  // Same as above, but only unicast routes for the given prefixes and MPLS
+  // routes for node labels of the given nodes are built. Adjacency label
+  // routes are not built, they only change with our own links
+  std::optional<DecisionRouteDb> buildRouteDb(
+      const std::string& myNodeName,
+      LinkState const& linkState,
+      PrefixState const& prefixState,
+      std::unordered_set<thrift::IpPrefix> const& prefixes,
+      std::unordered_set<std::string> const& labelNodes);
+
  private:
   // no-copy
   SpfSolver(SpfSolver const&) = delete;
@@ -276,20 +337,36 @@ class Decision : public OpenrEventBase {
       bool bgpDryRun,
       std::chrono::milliseconds debounceMinDur,
       std::chrono::milliseconds debounceMaxDur,
-      messaging::RQueue<thrift::Publication> kvStoreUpdatesQueue,
+      messaging::RQueue<KvStorePublication> kvStoreUpdatesQueue,
       messaging::RQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue,
       messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& routeUpdatesQueue,
+      messaging::ReplicateQueue<thrift::DecisionDbsDelta>&
+          decisionDbsUpdatesQueue,
       fbzmq::Context& zmqContext);
 
   virtual ~Decision() = default;
 
   /*
    * Retrieve routeDb from specified node.
-   * If empty nodename specified, will return routeDb of its own
+   * If empty nodename specified, will return routeDb of its own.
+   * Computed routeDbs are cached until link/prefix state or static routes
+   * change. Missing ones are computed one per event loop iteration, and
+   * concurrent requests for the same node share the computation
    */
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>> getDecisionRouteDb(
       std::string nodeName);
 
+  /*
+   * Change of routes of specified node (or of its own if empty) if the
+   * topology changes were applied, in order. Changes are applied onto a
+   * private copy of link state, on a worker thread, leaving the live
+   * computation untouched. Fails with thrift::OpenrError if a change refers
+   * to an unknown node or link
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::RouteDatabaseDelta>>
+  getDecisionRouteDbDeltaWhatIf(
+      std::string nodeName, std::vector<thrift::TopologyChange> changes);
+
   folly::SemiFuture<std::unique_ptr<thrift::StaticRoutes>>
   getDecisionStaticRoutes();
 
@@ -309,6 +386,19 @@ class Decision : public OpenrEventBase {
    */
   folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>> getDecisionPrefixDbs();
 
+  /*
+   * Retrieve AdjacencyDatabase of all nodes in all areas and PrefixDatabase
+   * of all nodes at once.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::DecisionDbs>> getDecisionDbs();
+
+  /*
+   * Reader of changes to adjacency and prefix databases, as applied by
+   * Decision on processing KvStore publications. Applying them in order onto
+   * `getDecisionDbs` snapshot gives the databases of Decision.
+   */
+  messaging::RQueue<thrift::DecisionDbsDelta> getDecisionDbsUpdatesReader();
+
   /*
    * Set new or replace existing RibPolicy. This will trigger the new policy
    * run against computed routes and delta will be published.
@@ -329,10 +419,46 @@ class Decision : public OpenrEventBase {
   Decision(Decision const&) = delete;
   Decision& operator=(Decision const&) = delete;
 
-  // process publication from KvStore
+  // account adjacency database of node being added to (or deleted from) the
+  // link state of an area, in nodeNumAreas_
+  void updateNodeNumAreas(
+      const std::string& nodeName, bool hadNode, bool hasNode);
+
+  // process publication from KvStore. Adjacency and prefix database keys are
+  // only queued in pendingKeyVals_
   ProcessPublicationResult processPublication(
       thrift::Publication const& thriftPub);
 
+  // deserialize and apply queued adjacency and prefix database keys. Called
+  // before anything reads link state or prefix state
+  void processPendingPublications();
+
+  void processKeyVal(
+      std::string const& area,
+      std::string const& key,
+      thrift::Value const& rawVal,
+      bool publishDbsDelta,
+      thrift::DecisionDbsDelta& dbsDelta);
+
+  // withdraw prefixes of expired per prefix keys of a node, in one delta
+  void processExpiredPrefixes(
+      std::string const& nodeName,
+      std::vector<thrift::IpPrefix> const& prefixes,
+      bool publishDbsDelta,
+      thrift::DecisionDbsDelta& dbsDelta);
+
+  // withdraw all prefixes of a node, in O(number of its prefixes)
+  void withdrawNodePrefixes(
+      std::string const& nodeName,
+      bool publishDbsDelta,
+      thrift::DecisionDbsDelta& dbsDelta);
+
+  void processExpiredKey(
+      std::string const& area,
+      std::string const& key,
+      bool publishDbsDelta,
+      thrift::DecisionDbsDelta& dbsDelta);
+
   void pushRoutesDeltaUpdates(thrift::RouteDatabaseDelta& staticRoutesDelta);
 
   // openr config
@@ -342,14 +468,28 @@ class Decision : public OpenrEventBase {
   // gracefulRestartDuration
   std::unique_ptr<folly::AsyncTimeout> coldStartTimer_{nullptr};
 
+  // areas yet to signal KvStore initial sync. Cold start update is done early
+  // once all areas are in sync, cold start timer being the upper bound
+  std::unordered_set<std::string> initialSyncAreas_;
+
   /**
    * Timer to schedule pending update processing
    * Refer to pendingUpdates_ to decide whether spf recalculation or
    * just route rebuilding is needed.
-   * Apply exponential backoff timeout to avoid churn
+   * Debounce adapts to the cost of the last processing and rate of updates
+   * to avoid churn
    */
   std::unique_ptr<folly::AsyncTimeout> processUpdatesTimer_;
-  ExponentialBackoff<std::chrono::milliseconds> processUpdatesBackoff_;
+  AdaptiveDebounce processUpdatesDebounce_;
+
+  /**
+   * Schedule processPendingUpdates for the update just received. Isolated
+   * change of a single adjacency is processed right away.
+   */
+  void scheduleProcessPendingUpdates();
+
+  // is the only pending update a change of single adjacency key?
+  bool isSingleAdjacencyUpdate() const;
 
   /**
    * Caller function of processPendingAdjUpdates and processPendingPrefixUpdates
@@ -359,10 +499,62 @@ class Decision : public OpenrEventBase {
    */
   void processPendingUpdates();
 
+  // publish routes built for pending updates and reset them, reporting the
+  // cost of processing since startTime
+  void commitRouteDb(
+      std::optional<DecisionRouteDb>&& maybeRouteDb,
+      std::chrono::steady_clock::time_point startTime);
+
+  // resume processing deferred while routes were computed on
+  // routeComputeExecutor_
+  void processDeferredUpdates();
+
   /**
-   * Function to process routes on RibPolicy update
+   * Computed routeDbs of getDecisionRouteDb requests
    */
-  void processRibPolicyUpdate();
+  // drop cached routeDbs as routing state has changed
+  void invalidateComputedRouteDbs();
+
+  // adjacency databases of each area
+  using AreaAdjacencyDbs = std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<std::string, thrift::AdjacencyDatabase>>;
+
+  // route delta of getDecisionRouteDbDeltaWhatIf, computed from snapshot of
+  // adjacency and prefix databases. Only reads immutable members, runs on
+  // whatIfExecutor_
+  thrift::RouteDatabaseDelta simulateTopologyChanges(
+      std::string const& nodeName,
+      std::vector<thrift::TopologyChange> const& changes,
+      AreaAdjacencyDbs areaAdjDbs,
+      PrefixState const& prefixState) const;
+
+  // compute routeDb of the oldest pending request, and reschedule itself if
+  // more requests are pending
+  void processPendingRouteDbComputations();
+
+  // node -> cached routeDb, of current routing state only
+  std::unordered_map<std::string, thrift::RouteDatabase> computedRouteDbs_;
+
+  // node -> pending requests, with nodes in arrival order
+  std::unordered_map<
+      std::string,
+      std::vector<folly::Promise<std::unique_ptr<thrift::RouteDatabase>>>>
+      pendingRouteDbRequests_;
+  std::deque<std::string> pendingRouteDbNodes_;
+
+  std::unique_ptr<folly::AsyncTimeout> routeDbComputationTimer_;
+
+  /**
+   * Function to process routes on RibPolicy update. Only routes of prefixes
+   * transformed differently by oldRibPolicy (last applied one, if any) and the
+   * active policy are re-derived, from routes computed before policy.
+   * Falls back to full rebuild if routing state has pending changes.
+   */
+  void processRibPolicyUpdate(RibPolicy const* oldRibPolicy);
+
+  // Active RibPolicy, nullptr if none or expired
+  RibPolicy const* getActiveRibPolicy() const;
 
   // decremnts holds and send any resulting output, returns true if any
   // linkstate has remaining holds
@@ -370,28 +562,156 @@ class Decision : public OpenrEventBase {
 
   void coldStartUpdate();
 
+  // publish delta of routeDb against routeDb_ and update routeDb_ with it.
+  // Journaled routeDb is diffed and applied on its changed prefixes only
   void sendRouteUpdate(
       DecisionRouteDb&& routeDb,
       std::optional<thrift::PerfEvents>&& perfEvents,
       std::string const& eventDescription);
 
+  // apply active RibPolicy to unicast routes, dropping the ones left without
+  // nexthops
+  void applyRibPolicy(DecisionRouteDb& routeDb) const;
+
+  // diff routeDb_ against routes of all areas and publish the difference, if
+  // any, as journaled updates are only diffed on their changed prefixes
+  void checkRouteDbConsistency();
+
+  // replace nexthops of unicast routes of the delta by references to shared
+  // nexthop groups. A group is announced along with the first route using it
+  // and withdrawn along with the last one
+  void assignNextHopGroups(
+      thrift::RouteDatabaseDelta& delta,
+      DecisionRouteDb const& newDb,
+      DecisionRouteDb const& oldDb);
+
   std::chrono::milliseconds getMaxFib();
 
-  // node to prefix entries database for nodes advertising per prefix keys
-  thrift::PrefixDatabase updateNodePrefixDatabase(
+  // update prefix entries of the node, composed of its full prefix database
+  // and per prefix keys, in prefixState_. Per prefix key is applied as a
+  // delta of one prefix, falling back to full replacement of the node's
+  // entries if the delta is not based on current version of them. Returns
+  // changed prefixes
+  std::unordered_set<thrift::IpPrefix> updateNodePrefixDatabase(
       const std::string& key, const thrift::PrefixDatabase& prefixDb);
 
+  // node to prefix entries database for nodes advertising per prefix keys
+  thrift::PrefixDatabase getNodePrefixDatabase(const std::string& nodeName);
+
+  // adjacency database of the node, composed of its adjacency database key
+  // and per adjacency keys, with update of the given key applied
+  thrift::AdjacencyDatabase updateNodeAdjacencyDatabase(
+      const std::string& key,
+      const std::string& area,
+      thrift::AdjacencyDatabase&& adjacencyDb);
+
   // build the route database for nodeName
-  // coalesces routes computed for all areas
+  // coalesces routes computed for all areas, in order of area name. Areas are
+  // computed in parallel on routeBuildExecutor_ if configured
   std::optional<DecisionRouteDb> buildRouteDb(
       std::string const& nodeName) const;
 
+  // routes of an area which need to be recomputed, see getAffectedRoutes
+  struct AffectedRoutes {
+    std::unordered_set<thrift::IpPrefix> prefixes;
+
+    // node labels whose MPLS routes may have changed, and all nodes holding
+    // them (the owner of a duplicate label is chosen among them)
+    std::unordered_set<int32_t> labels;
+    std::unordered_set<std::string> labelNodes;
+  };
+
+  // compute routes of nodeName for each area, in order of area name. Areas
+  // are computed in parallel on routeBuildExecutor_ if configured. If
+  // areaRoutes is set, only the routes listed as affected for an area are
+  // computed
+  std::vector<std::pair<std::string, std::optional<DecisionRouteDb>>>
+  buildAreaRouteDbs(
+      std::string const& nodeName,
+      std::unordered_map<std::string /* area */, AffectedRoutes> const*
+          areaRoutes = nullptr) const;
+
+  // Routes of myNodeName_ computed for an area before RibPolicy is applied,
+  // along with the state they were computed from. Any route depends only on
+  // the prefix entries of its prefix, our own links and, for each announcing
+  // node, its SPF results and drain state. Comparing these against the
+  // current state tells which routes need to be recomputed.
+  struct AreaRouteState {
+    // (neighbor, interface, metric, isUp) of links of myNodeName_, sorted
+    using LocalLinks = std::vector<
+        std::tuple<std::string, std::string, LinkStateMetric, bool>>;
+
+    DecisionRouteDb routeDb;
+
+    // SPF results from myNodeName_ and, with LFA, from its neighbors
+    std::unordered_map<std::string, LinkState::SpfResult> spfResults;
+
+    LocalLinks localLinks;
+
+    std::unordered_set<std::string> overloadedNodes;
+
+    // node label of every node with one set
+    std::unordered_map<std::string, int32_t> nodeLabels;
+  };
+
+  // build the route database for myNodeName_ and refresh areaRouteStates_.
+  // Unless fullRebuild is set, only routes of prefixes affected by
+  // pendingUpdates_ are recomputed
+  std::optional<DecisionRouteDb> rebuildRouteDb(bool fullRebuild);
+
+  // rebuildRouteDb without processing pending publications first. Only
+  // reads state which is left untouched while it runs on
+  // routeComputeExecutor_
+  std::optional<DecisionRouteDb> computeRouteDb(bool fullRebuild);
+
+  // journaled route database of pendingStaticUnicastChanges_ only, without
+  // any route computation
+  DecisionRouteDb buildStaticUnicastRouteDb();
+
+  // replace routes of db with static unicast routes, which take precedence
+  // over computed ones. Only routes of the changed prefixes of a journaled db
+  void applyStaticUnicastRoutes(DecisionRouteDb& db) const;
+
+  // routes in the area of linkState which may have changed since state was
+  // recorded. std::nullopt if any route may have changed
+  std::optional<AffectedRoutes> getAffectedRoutes(
+      LinkState const& linkState, AreaRouteState const& state) const;
+
+  // record the state the routes of the area of linkState are computed from
+  void recordAreaRouteState(
+      LinkState const& linkState, AreaRouteState& state) const;
+
   // cached routeDb
   DecisionRouteDb routeDb_;
 
+  // prefixes of static unicast routes changed since routes were last built
+  std::unordered_set<thrift::IpPrefix> pendingStaticUnicastChanges_;
+
+  // journaled route updates since start, see checkRouteDbConsistency
+  uint64_t numJournaledRouteUpdates_{0};
+
+  // nexthop groups used by unicast routes of routeDb_, keyed by nexthops
+  struct NextHopGroup {
+    int64_t id{0};
+    size_t refCount{0};
+  };
+  std::unordered_map<NextHopSet, NextHopGroup> nextHopGroups_;
+  int64_t lastNextHopGroupId_{0};
+
+  // per area routes before RibPolicy, see AreaRouteState
+  std::unordered_map<std::string, AreaRouteState> areaRouteStates_;
+
+  // host loopbacks the cached routes were computed with. BGP routes use them
+  // for their best nexthop
+  std::unordered_map<std::string, thrift::BinaryAddress> routeHostLoopbacksV4_,
+      routeHostLoopbacksV6_;
+
   // Queue to publish route changes
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& routeUpdatesQueue_;
 
+  // Queue to publish changes of adjacency and prefix databases
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta>& decisionDbsUpdatesQueue_;
+
   // Pointer to RibPolicy
   std::unique_ptr<RibPolicy> ribPolicy_;
 
@@ -433,11 +753,70 @@ class Decision : public OpenrEventBase {
       std::unordered_map<thrift::IpPrefix, thrift::PrefixEntry>>
       perPrefixPrefixEntries_, fullDbPrefixEntries_;
 
+  // adjacencies advertised with per adjacency keys, for nodes advertising
+  // them. Keyed by area, node name and then per adjacency key
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<
+          std::string /* node name */,
+          std::unordered_map<std::string /* key */, thrift::Adjacency>>>
+      perKeyAdjacencies_;
+
+  // number of areas with an adjacency database of the node, maintained as
+  // link states are updated so that counters don't scan them
+  std::unordered_map<std::string /* node name */, size_t> nodeNumAreas_;
+
+  // approximate memory held by routeDb_, maintained as it's updated
+  size_t routeDbBytes_{0};
+
+  // latest value of adjacency and prefix database keys received since last
+  // processing of pending updates, std::nullopt for expired keys. Keyed by
+  // area and then key
+  std::unordered_map<
+      std::string /* area */,
+      std::map<std::string /* key */, std::optional<thrift::Value>>>
+      pendingKeyVals_;
+
+  // originators left without any key-value in the area since last processing
+  // of pending updates, see Publication.expiredOriginators
+  std::unordered_map<std::string /* area */, std::unordered_set<std::string>>
+      pendingExpiredOriginators_;
+
   // this node's name and the key markers
   const std::string myNodeName_;
 
+  // whether routes include LFA nexthops
+  const bool computeLfaPaths_{false};
+
+  // whether BGP routes are computed without being programmed
+  const bool bgpDryRun_{false};
+
+  // whether unicast routes are published with shared nexthop groups
+  const bool enableNextHopGroups_{false};
+
+  // whether published route updates carry perf events of computation phases
+  const bool enablePhasePerfEvents_{false};
+
   // store update to-do status and perf events
   detail::DecisionPendingUpdates pendingUpdates_;
+
+  // optional workers that build the routes of each area in parallel. Declared
+  // last so that it is joined before any state the workers read is destroyed
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeBuildExecutor_;
+
+  // optional worker computing routes off the Decision thread. While routes
+  // are computed, link and prefix state is frozen: publications stay queued
+  // in pendingKeyVals_ for the next computation, and everything else which
+  // would touch the state (route db requests, RibPolicy and ordered FIB
+  // hold updates) is deferred until the computed routes are committed.
+  // Declared after routeBuildExecutor_ it uses, to be joined before it
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeComputeExecutor_;
+  bool routeComputeInFlight_{false};
+  bool ribPolicyUpdateDeferred_{false};
+
+  // worker of what-if simulations, created on first one. Declared last, to
+  // be joined before anything simulations read is destroyed
+  std::unique_ptr<folly::CPUThreadPoolExecutor> whatIfExecutor_;
 };
 
 } // namespace openr
@@ -9,10 +9,15 @@
 
 #include <algorithm>
 #include <functional>
+#include <queue>
+#include <string_view>
 #include <utility>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
+#include <folly/MapUtil.h>
+#include <folly/Synchronized.h>
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/Util.h>
 
 namespace fb303 = facebook::fb303;
@@ -51,6 +56,57 @@ std::hash<openr::LinkState::LinkSet>::operator()(
 
 namespace openr {
 
+namespace {
+
+// the "relax" step in the Dijkstra Algorithm pseudocode in CLRS. Offer
+// otherNodeId the path over link from recordedNodeId, whose shortest paths are
+// already known, and update otherNodeId in the queue if this path is no worse
+// than what it has so far
+void
+relaxEdge(
+    DijkstraQ& q,
+    LinkState::SpfResult& result,
+    LinkState::NodeId recordedNodeId,
+    LinkState::NodeSpfResult const& recordedNodeResult,
+    LinkState::NodeId otherNodeId,
+    std::shared_ptr<Link> const& link,
+    LinkStateMetric metric) {
+  auto const newMetric = recordedNodeResult.metric() + metric;
+  auto otherNode = q.get(otherNodeId);
+  if (!otherNode) {
+    otherNode = &q.insertNode(otherNodeId, newMetric);
+  }
+  if (otherNode->result.metric() >= newMetric) {
+    // recordedNodeName is either along an alternate shortest path towards
+    // otherNodeName or is along a new shorter path. In either case,
+    // otherNodeName should use recordedNodeName's nextHops until it finds
+    // some shorter path
+    if (otherNode->result.metric() > newMetric) {
+      // if this is strictly better, forget about any other paths
+      otherNode->result.reset(newMetric);
+      q.decreaseKey(*otherNode);
+    }
+    otherNode->result.addPath(link, recordedNodeId);
+    otherNode->result.addNextHops(recordedNodeResult.nextHopSet());
+    if (otherNode->result.nextHopSet().empty()) {
+      // directly connected node
+      otherNode->result.addNextHop(result.getOrAddFirstHop(otherNodeId));
+    }
+  }
+}
+
+// approximate number of bytes held by kth paths
+size_t
+pathsMemoryUsage(std::vector<LinkState::Path> const& paths) {
+  size_t bytes = sizeof(paths) + paths.capacity() * sizeof(LinkState::Path);
+  for (auto const& path : paths) {
+    bytes += path.capacity() * sizeof(std::shared_ptr<Link>);
+  }
+  return bytes;
+}
+
+} // namespace
+
 template <class T>
 HoldableValue<T>::HoldableValue(T val) : val_(val) {}
 
@@ -130,16 +186,18 @@ Link::Link(
     const std::string& if1,
     const std::string& nodeName2,
     const std::string& if2)
-    : area_(area),
-      n1_(nodeName1),
-      n2_(nodeName2),
-      if1_(if1),
-      if2_(if2),
-      orderedNames_(
-          std::minmax(std::make_pair(n1_, if1_), std::make_pair(n2_, if2_))),
+    : area_(internName(area)),
+      n1_(internName(nodeName1)),
+      n2_(internName(nodeName2)),
+      if1_(internName(if1)),
+      if2_(internName(if2)),
+      swapped_(std::tie(nodeName2, if2) < std::tie(nodeName1, if1)),
       hash(std::hash<std::pair<
                std::pair<std::string, std::string>,
-               std::pair<std::string, std::string>>>()(orderedNames_)) {}
+               std::pair<std::string, std::string>>>()(
+          std::minmax(
+              std::make_pair(nodeName1, if1),
+              std::make_pair(nodeName2, if2)))) {}
 
 Link::Link(
     const std::string& area,
@@ -154,50 +212,96 @@ Link::Link(
   overload2_ = adj2.isOverloaded;
   adjLabel1_ = adj1.adjLabel;
   adjLabel2_ = adj2.adjLabel;
-  nhV41_ = adj1.nextHopV4;
-  nhV42_ = adj2.nextHopV4;
-  nhV61_ = adj1.nextHopV6;
-  nhV62_ = adj2.nextHopV6;
+  weight1_ = adj1.weight;
+  weight2_ = adj2.weight;
+  nhV41_ = InlineAddress(adj1.nextHopV4);
+  nhV42_ = InlineAddress(adj2.nextHopV4);
+  nhV61_ = InlineAddress(adj1.nextHopV6);
+  nhV62_ = InlineAddress(adj2.nextHopV6);
+}
+
+const std::string*
+Link::internName(const std::string& name) {
+  // names are never forgotten, they are few compared to links: one per node,
+  // interface and area ever seen. Elements of unordered_set are stable
+  static folly::Synchronized<std::unordered_set<std::string>> names;
+  {
+    auto rlock = names.rlock();
+    auto it = rlock->find(name);
+    if (it != rlock->end()) {
+      return &*it;
+    }
+  }
+  return &*names.wlock()->emplace(name).first;
+}
+
+Link::InlineAddress::InlineAddress(const thrift::BinaryAddress& address)
+    : len(static_cast<uint8_t>(std::min(address.addr.size(), addr.size()))),
+      ifName(
+          address.ifName_ref().has_value()
+              ? internName(address.ifName_ref().value())
+              : nullptr) {
+  std::copy_n(address.addr.data(), len, addr.data());
+}
+
+thrift::BinaryAddress
+Link::InlineAddress::toThrift() const {
+  thrift::BinaryAddress address;
+  address.addr.assign(addr.data(), len);
+  if (ifName) {
+    address.ifName_ref() = *ifName;
+  }
+  return address;
+}
+
+std::tuple<
+    const std::string&,
+    const std::string&,
+    const std::string&,
+    const std::string&>
+Link::orderedNames() const {
+  return swapped_ ? std::tie(*n2_, *if2_, *n1_, *if1_)
+                  : std::tie(*n1_, *if1_, *n2_, *if2_);
 }
 
 const std::string&
 Link::getOtherNodeName(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
-    return n2_;
+  if (*n1_ == nodeName) {
+    return *n2_;
   }
-  if (n2_ == nodeName) {
-    return n1_;
+  if (*n2_ == nodeName) {
+    return *n1_;
   }
   throw std::invalid_argument(nodeName);
 }
 
 const std::string&
 Link::firstNodeName() const {
-  return orderedNames_.first.first;
+  return std::get<0>(orderedNames());
 }
 
 const std::string&
 Link::secondNodeName() const {
-  return orderedNames_.second.first;
+  return std::get<2>(orderedNames());
 }
 
 const std::string&
 Link::getIfaceFromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
-    return if1_;
+  if (*n1_ == nodeName) {
+    return *if1_;
   }
-  if (n2_ == nodeName) {
-    return if2_;
+  if (*n2_ == nodeName) {
+    return *if2_;
   }
   throw std::invalid_argument(nodeName);
 }
 
 LinkStateMetric
 Link::getMetricFromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     return metric1_.value();
   }
-  if (n2_ == nodeName) {
+  if (*n2_ == nodeName) {
     return metric2_.value();
   }
   throw std::invalid_argument(nodeName);
@@ -205,21 +309,32 @@ Link::getMetricFromNode(const std::string& nodeName) const {
 
 int32_t
 Link::getAdjLabelFromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     return adjLabel1_;
   }
-  if (n2_ == nodeName) {
+  if (*n2_ == nodeName) {
     return adjLabel2_;
   }
   throw std::invalid_argument(nodeName);
 }
 
+int64_t
+Link::getWeightFromNode(const std::string& nodeName) const {
+  if (*n1_ == nodeName) {
+    return weight1_;
+  }
+  if (*n2_ == nodeName) {
+    return weight2_;
+  }
+  throw std::invalid_argument(nodeName);
+}
+
 bool
 Link::getOverloadFromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     return overload1_.value();
   }
-  if (n2_ == nodeName) {
+  if (*n2_ == nodeName) {
     return overload2_.value();
   }
   throw std::invalid_argument(nodeName);
@@ -254,24 +369,24 @@ Link::hasHolds() const {
       overload1_.hasHold() || overload2_.hasHold();
 }
 
-const thrift::BinaryAddress&
+thrift::BinaryAddress
 Link::getNhV4FromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
-    return nhV41_;
+  if (*n1_ == nodeName) {
+    return nhV41_.toThrift();
   }
-  if (n2_ == nodeName) {
-    return nhV42_;
+  if (*n2_ == nodeName) {
+    return nhV42_.toThrift();
   }
   throw std::invalid_argument(nodeName);
 }
 
-const thrift::BinaryAddress&
+thrift::BinaryAddress
 Link::getNhV6FromNode(const std::string& nodeName) const {
-  if (n1_ == nodeName) {
-    return nhV61_;
+  if (*n1_ == nodeName) {
+    return nhV61_.toThrift();
   }
-  if (n2_ == nodeName) {
-    return nhV62_;
+  if (*n2_ == nodeName) {
+    return nhV62_.toThrift();
   }
   throw std::invalid_argument(nodeName);
 }
@@ -279,10 +394,10 @@ Link::getNhV6FromNode(const std::string& nodeName) const {
 void
 Link::setNhV4FromNode(
     const std::string& nodeName, const thrift::BinaryAddress& nhV4) {
-  if (n1_ == nodeName) {
-    nhV41_ = nhV4;
-  } else if (n2_ == nodeName) {
-    nhV42_ = nhV4;
+  if (*n1_ == nodeName) {
+    nhV41_ = InlineAddress(nhV4);
+  } else if (*n2_ == nodeName) {
+    nhV42_ = InlineAddress(nhV4);
   } else {
     throw std::invalid_argument(nodeName);
   }
@@ -291,10 +406,10 @@ Link::setNhV4FromNode(
 void
 Link::setNhV6FromNode(
     const std::string& nodeName, const thrift::BinaryAddress& nhV6) {
-  if (n1_ == nodeName) {
-    nhV61_ = nhV6;
-  } else if (n2_ == nodeName) {
-    nhV62_ = nhV6;
+  if (*n1_ == nodeName) {
+    nhV61_ = InlineAddress(nhV6);
+  } else if (*n2_ == nodeName) {
+    nhV62_ = InlineAddress(nhV6);
   } else {
     throw std::invalid_argument(nodeName);
   }
@@ -306,9 +421,9 @@ Link::setMetricFromNode(
     LinkStateMetric d,
     LinkStateMetric holdUpTtl,
     LinkStateMetric holdDownTtl) {
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     return metric1_.updateValue(d, holdUpTtl, holdDownTtl);
-  } else if (n2_ == nodeName) {
+  } else if (*n2_ == nodeName) {
     return metric2_.updateValue(d, holdUpTtl, holdDownTtl);
   }
   throw std::invalid_argument(nodeName);
@@ -316,15 +431,26 @@ Link::setMetricFromNode(
 
 void
 Link::setAdjLabelFromNode(const std::string& nodeName, int32_t adjLabel) {
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     adjLabel1_ = adjLabel;
-  } else if (n2_ == nodeName) {
+  } else if (*n2_ == nodeName) {
     adjLabel2_ = adjLabel;
   } else {
     throw std::invalid_argument(nodeName);
   }
 }
 
+void
+Link::setWeightFromNode(const std::string& nodeName, int64_t weight) {
+  if (*n1_ == nodeName) {
+    weight1_ = weight;
+  } else if (*n2_ == nodeName) {
+    weight2_ = weight;
+  } else {
+    throw std::invalid_argument(nodeName);
+  }
+}
+
 bool
 Link::setOverloadFromNode(
     const std::string& nodeName,
@@ -332,9 +458,9 @@ Link::setOverloadFromNode(
     LinkStateMetric holdUpTtl,
     LinkStateMetric holdDownTtl) {
   bool const wasUp = isUp();
-  if (n1_ == nodeName) {
+  if (*n1_ == nodeName) {
     overload1_.updateValue(overload, holdUpTtl, holdDownTtl);
-  } else if (n2_ == nodeName) {
+  } else if (*n2_ == nodeName) {
     overload2_.updateValue(overload, holdUpTtl, holdDownTtl);
   } else {
     throw std::invalid_argument(nodeName);
@@ -349,7 +475,7 @@ Link::operator<(const Link& other) const {
   if (this->hash != other.hash) {
     return this->hash < other.hash;
   }
-  return this->orderedNames_ < other.orderedNames_;
+  return orderedNames() < other.orderedNames();
 }
 
 bool
@@ -357,26 +483,215 @@ Link::operator==(const Link& other) const {
   if (this->hash != other.hash) {
     return false;
   }
-  return this->orderedNames_ == other.orderedNames_;
+  return orderedNames() == other.orderedNames();
 }
 
 std::string
 Link::toString() const {
-  return folly::sformat("{} - {}%{} <---> {}%{}", area_, n1_, if1_, n2_, if2_);
+  return folly::sformat(
+      "{} - {}%{} <---> {}%{}", *area_, *n1_, *if1_, *n2_, *if2_);
 }
 
 std::string
 Link::directionalToString(const std::string& fromNode) const {
   return folly::sformat(
       "{} - {}%{} ---> {}%{}",
-      area_,
+      *area_,
       fromNode,
       getIfaceFromNode(fromNode),
       getOtherNodeName(fromNode),
       getIfaceFromNode(getOtherNodeName(fromNode)));
 }
 
-LinkState::LinkState(const std::string& area) : area_(area) {}
+DijkstraQ::DijkstraQ(LinkState::NodeIdTable const& nodeIds)
+    : nodeIds_(nodeIds), index_(nodeIds.size(), kNone) {}
+
+DijkstraQNode&
+DijkstraQ::insertNode(NodeId nodeId, LinkStateMetric d) {
+  if (nodeId >= index_.size()) {
+    index_.resize(nodeId + 1, kNone);
+  }
+  CHECK_EQ(kNone, index_[nodeId]);
+  const uint32_t idx = nodes_.size();
+  index_[nodeId] = idx;
+  nodes_.emplace_back(nodeId, d);
+  heapPos_.push_back(heap_.size());
+  heap_.push_back(idx);
+  siftUp(heap_.size() - 1);
+  return nodes_.back();
+}
+
+DijkstraQNode*
+DijkstraQ::get(NodeId nodeId) {
+  if (nodeId >= index_.size() || kNone == index_[nodeId] ||
+      kNotInHeap == heapPos_[index_[nodeId]]) {
+    return nullptr;
+  }
+  return &nodes_[index_[nodeId]];
+}
+
+void
+DijkstraQ::decreaseKey(const DijkstraQNode& node) {
+  const auto idx = index_.at(node.nodeId);
+  CHECK_NE(kNotInHeap, heapPos_.at(idx)) << node.nodeId << " is not queued";
+  siftUp(heapPos_[idx]);
+}
+
+DijkstraQNode*
+DijkstraQ::extractMin() {
+  if (heap_.empty()) {
+    return nullptr;
+  }
+  const uint32_t min = heap_.front();
+  heapPos_[min] = kNotInHeap;
+  heap_.front() = heap_.back();
+  heap_.pop_back();
+  if (!heap_.empty()) {
+    heapPos_[heap_.front()] = 0;
+    siftDown(0);
+  }
+  return &nodes_[min];
+}
+
+bool
+DijkstraQ::lessThan(uint32_t a, uint32_t b) const {
+  auto const& nodeA = nodes_[a];
+  auto const& nodeB = nodes_[b];
+  if (nodeA.result.metric() != nodeB.result.metric()) {
+    return nodeA.result.metric() < nodeB.result.metric();
+  }
+  return nodeIds_.name(nodeA.nodeId) < nodeIds_.name(nodeB.nodeId);
+}
+
+void
+DijkstraQ::siftUp(size_t pos) {
+  const uint32_t idx = heap_[pos];
+  while (pos > 0) {
+    const size_t parent = (pos - 1) / kArity;
+    if (!lessThan(idx, heap_[parent])) {
+      break;
+    }
+    heap_[pos] = heap_[parent];
+    heapPos_[heap_[pos]] = pos;
+    pos = parent;
+  }
+  heap_[pos] = idx;
+  heapPos_[idx] = pos;
+}
+
+void
+DijkstraQ::siftDown(size_t pos) {
+  const uint32_t idx = heap_[pos];
+  while (true) {
+    const size_t firstChild = pos * kArity + 1;
+    if (firstChild >= heap_.size()) {
+      break;
+    }
+    const size_t lastChild = std::min(firstChild + kArity, heap_.size());
+    size_t minChild = firstChild;
+    for (size_t child = firstChild + 1; child < lastChild; ++child) {
+      if (lessThan(heap_[child], heap_[minChild])) {
+        minChild = child;
+      }
+    }
+    if (!lessThan(heap_[minChild], idx)) {
+      break;
+    }
+    heap_[pos] = heap_[minChild];
+    heapPos_[heap_[pos]] = pos;
+    pos = minChild;
+  }
+  heap_[pos] = idx;
+  heapPos_[idx] = pos;
+}
+
+LinkState::LinkState(
+    const std::string& area, bool enableIncrementalSpf, size_t memoBudgetBytes)
+    : area_(area),
+      enableIncrementalSpf_(enableIncrementalSpf),
+      memoBudgetBytes_(memoBudgetBytes) {}
+
+LinkState::NodeId
+LinkState::NodeIdTable::getOrAdd(const std::string& nodeName) {
+  auto [it, inserted] = ids_.emplace(nodeName, names_.size());
+  if (inserted) {
+    names_.emplace_back(nodeName);
+  }
+  return it->second;
+}
+
+std::optional<LinkState::NodeId>
+LinkState::NodeIdTable::find(const std::string& nodeName) const {
+  auto search = ids_.find(nodeName);
+  if (search == ids_.end()) {
+    return std::nullopt;
+  }
+  return search->second;
+}
+
+LinkState::SpfResult::SpfResult(std::shared_ptr<NodeIdTable const> nodeIds)
+    : nodeIds_(std::move(nodeIds)) {
+  results_.resize(nodeIds_->size());
+}
+
+size_t
+LinkState::SpfResult::memoryUsage() const {
+  size_t bytes = sizeof(*this) +
+      results_.capacity() * sizeof(std::optional<NodeSpfResult>) +
+      reachableNodes_.capacity() * sizeof(NodeId) +
+      firstHops_.capacity() * sizeof(NodeId);
+  for (auto const id : reachableNodes_) {
+    auto const& result = *results_[id];
+    bytes += result.pathLinks().capacity() * sizeof(NodeSpfResult::PathLink) +
+        result.nextHopSet().externalBytes();
+  }
+  return bytes;
+}
+
+std::vector<LinkState::NodeId>
+LinkState::SpfResult::nextHops(NodeSpfResult const& nodeResult) const {
+  std::vector<NodeId> nextHops;
+  nodeResult.nextHopSet().forEach(
+      [&](size_t index) { nextHops.push_back(firstHops_.at(index)); });
+  std::sort(nextHops.begin(), nextHops.end());
+  return nextHops;
+}
+
+size_t
+LinkState::SpfResult::getOrAddFirstHop(NodeId id) {
+  // a handful of neighbors, only looked up when relaxing edges of the source
+  auto it = std::find(firstHops_.begin(), firstHops_.end(), id);
+  if (it != firstHops_.end()) {
+    return it - firstHops_.begin();
+  }
+  firstHops_.push_back(id);
+  return firstHops_.size() - 1;
+}
+
+LinkState::NodeSpfResult const*
+LinkState::SpfResult::get(std::string const& nodeName) const {
+  auto id = nodeIds_->find(nodeName);
+  return id ? get(*id) : nullptr;
+}
+
+LinkState::NodeSpfResult const&
+LinkState::SpfResult::at(std::string const& nodeName) const {
+  auto result = get(nodeName);
+  if (!result) {
+    throw std::out_of_range(nodeName);
+  }
+  return *result;
+}
+
+LinkState::NodeSpfResult&
+LinkState::SpfResult::emplace(NodeId id, NodeSpfResult&& result) {
+  if (id >= results_.size()) {
+    results_.resize(id + 1);
+  }
+  CHECK(!results_[id].has_value());
+  reachableNodes_.push_back(id);
+  return results_[id].emplace(std::move(result));
+}
 
 size_t
 LinkState::LinkPtrHash::operator()(const std::shared_ptr<Link>& l) const {
@@ -397,15 +712,16 @@ LinkState::LinkPtrEqual::operator()(
 
 std::optional<LinkState::Path>
 LinkState::traceOnePath(
-    std::string const& src,
-    std::string const& dest,
+    NodeId src,
+    NodeId dest,
     SpfResult const& result,
     LinkSet& linksToIgnore) const {
   if (src == dest) {
     return LinkState::Path{};
   }
-  auto const& nodeResult = result.at(dest);
-  for (auto const& pathLink : nodeResult.pathLinks()) {
+  auto const* nodeResult = result.get(dest);
+  CHECK(nodeResult);
+  for (auto const& pathLink : nodeResult->pathLinks()) {
     // only consider this link if we haven't yet
     if (linksToIgnore.insert(pathLink.link).second) {
       auto path = traceOnePath(src, pathLink.prevNode, result, linksToIgnore);
@@ -420,17 +736,39 @@ LinkState::traceOnePath(
 
 void
 LinkState::addLink(std::shared_ptr<Link> link) {
+  nodeIds_->getOrAdd(link->firstNodeName());
+  nodeIds_->getOrAdd(link->secondNodeName());
+  numPartialAdjacencies_ -= getNodePartialAdjacencies(link->firstNodeName()) +
+      getNodePartialAdjacencies(link->secondNodeName());
   CHECK(linkMap_[link->firstNodeName()].insert(link).second);
   CHECK(linkMap_[link->secondNodeName()].insert(link).second);
   CHECK(allLinks_.insert(link).second);
+  numPartialAdjacencies_ += getNodePartialAdjacencies(link->firstNodeName()) +
+      getNodePartialAdjacencies(link->secondNodeName());
+  csrDirty_ = true;
 }
 
 // throws std::out_of_range if links are not present
 void
 LinkState::removeLink(std::shared_ptr<Link> link) {
+  numPartialAdjacencies_ -= getNodePartialAdjacencies(link->firstNodeName()) +
+      getNodePartialAdjacencies(link->secondNodeName());
   CHECK(linkMap_.at(link->firstNodeName()).erase(link));
   CHECK(linkMap_.at(link->secondNodeName()).erase(link));
   CHECK(allLinks_.erase(link));
+  numPartialAdjacencies_ += getNodePartialAdjacencies(link->firstNodeName()) +
+      getNodePartialAdjacencies(link->secondNodeName());
+  heldLinks_.erase(link);
+  csrDirty_ = true;
+}
+
+void
+LinkState::updateHeldLink(std::shared_ptr<Link> const& link) {
+  if (link->hasHolds()) {
+    heldLinks_.insert(link);
+  } else {
+    heldLinks_.erase(link);
+  }
 }
 
 void
@@ -441,17 +779,39 @@ LinkState::removeNode(const std::string& nodeName) {
     return;
   }
 
+  // node contributes nothing once it has no links
+  numPartialAdjacencies_ -= getNodePartialAdjacencies(nodeName);
+
   // erase ptrs to these links from other nodes
   for (auto const& link : search->second) {
     try {
-      CHECK(linkMap_.at(link->getOtherNodeName(nodeName)).erase(link));
+      auto const& otherNodeName = link->getOtherNodeName(nodeName);
+      numPartialAdjacencies_ -= getNodePartialAdjacencies(otherNodeName);
+      CHECK(linkMap_.at(otherNodeName).erase(link));
+      numPartialAdjacencies_ += getNodePartialAdjacencies(otherNodeName);
       CHECK(allLinks_.erase(link));
+      heldLinks_.erase(link);
     } catch (std::out_of_range const& e) {
       LOG(FATAL) << "std::out_of_range for " << nodeName;
     }
   }
   linkMap_.erase(search);
   nodeOverloads_.erase(nodeName);
+  heldNodes_.erase(nodeName);
+  csrDirty_ = true;
+}
+
+int64_t
+LinkState::getNodePartialAdjacencies(const std::string& nodeName) const {
+  auto const* links = folly::get_ptr(linkMap_, nodeName);
+  auto const* adjacencyDb = folly::get_ptr(adjacencyDatabases_, nodeName);
+  // only count if this node is not completely disconnected
+  if (not links or links->empty() or not adjacencyDb) {
+    return 0;
+  }
+  // Number of links (bi-directional) must be <= number of adjacencies
+  return static_cast<int64_t>(adjacencyDb->adjacencies.size()) -
+      static_cast<int64_t>(links->size());
 }
 
 const LinkState::LinkSet&
@@ -464,28 +824,23 @@ LinkState::linksFromNode(const std::string& nodeName) const {
   return defaultEmptySet;
 }
 
-std::vector<std::shared_ptr<Link>>
-LinkState::orderedLinksFromNode(const std::string& nodeName) const {
-  std::vector<std::shared_ptr<Link>> links;
-  if (linkMap_.count(nodeName)) {
-    links.insert(
-        links.begin(),
-        linkMap_.at(nodeName).begin(),
-        linkMap_.at(nodeName).end());
-    std::sort(links.begin(), links.end(), LinkPtrLess{});
-  }
-  return links;
-}
-
 bool
 LinkState::updateNodeOverloaded(
     const std::string& nodeName,
     bool isOverloaded,
     LinkStateMetric holdUpTtl,
     LinkStateMetric holdDownTtl) {
-  if (nodeOverloads_.count(nodeName)) {
-    return nodeOverloads_.at(nodeName).updateValue(
-        isOverloaded, holdUpTtl, holdDownTtl);
+  csrDirty_ = true;
+  auto it = nodeOverloads_.find(nodeName);
+  if (it != nodeOverloads_.end()) {
+    const bool changed =
+        it->second.updateValue(isOverloaded, holdUpTtl, holdDownTtl);
+    if (it->second.hasHold()) {
+      heldNodes_.insert(nodeName);
+    } else {
+      heldNodes_.erase(nodeName);
+    }
+    return changed;
   }
   nodeOverloads_.emplace(nodeName, HoldableValue<bool>{isOverloaded});
   // don't indicate LinkState changed if this is a new node
@@ -500,32 +855,26 @@ LinkState::isNodeOverloaded(const std::string& nodeName) const {
 LinkState::LinkStateChange
 LinkState::decrementHolds() {
   LinkStateChange change;
-  for (auto& link : allLinks_) {
-    change.topologyChanged |= link->decrementHolds();
+  for (auto it = heldLinks_.begin(); it != heldLinks_.end();) {
+    change.topologyChanged |= (*it)->decrementHolds();
+    it = (*it)->hasHolds() ? std::next(it) : heldLinks_.erase(it);
   }
-  for (auto& kv : nodeOverloads_) {
-    change.topologyChanged |= kv.second.decrementTtl();
+  for (auto it = heldNodes_.begin(); it != heldNodes_.end();) {
+    auto& overload = nodeOverloads_.at(*it);
+    change.topologyChanged |= overload.decrementTtl();
+    it = overload.hasHold() ? std::next(it) : heldNodes_.erase(it);
   }
   if (change.topologyChanged) {
-    spfResults_.clear();
-    kthPathResults_.clear();
+    clearSpfResults();
+    clearKthPathResults();
+    csrDirty_ = true;
   }
   return change;
 }
 
 bool
 LinkState::hasHolds() const {
-  for (auto& link : allLinks_) {
-    if (link->hasHolds()) {
-      return true;
-    }
-  }
-  for (auto& kv : nodeOverloads_) {
-    if (kv.second.hasHold()) {
-      return true;
-    }
-  }
-  return false;
+  return not heldLinks_.empty() or not heldNodes_.empty();
 }
 
 std::shared_ptr<Link>
@@ -546,28 +895,13 @@ LinkState::maybeMakeLink(
   return nullptr;
 }
 
-std::vector<std::shared_ptr<Link>>
-LinkState::getOrderedLinkSet(const thrift::AdjacencyDatabase& adjDb) const {
-  std::vector<std::shared_ptr<Link>> links;
-  links.reserve(adjDb.adjacencies.size());
-  for (const auto& adj : adjDb.adjacencies) {
-    auto linkPtr = maybeMakeLink(adjDb.thisNodeName, adj);
-    if (nullptr != linkPtr) {
-      links.emplace_back(linkPtr);
-    }
-  }
-  links.shrink_to_fit();
-  std::sort(links.begin(), links.end(), LinkState::LinkPtrLess{});
-  return links;
-}
-
 LinkState::LinkStateChange
 LinkState::updateAdjacencyDatabase(
-    thrift::AdjacencyDatabase const& newAdjacencyDb,
+    thrift::AdjacencyDatabase newAdjacencyDb,
     LinkStateMetric holdUpTtl,
     LinkStateMetric holdDownTtl) {
   LinkStateChange change;
-  auto const& nodeName = newAdjacencyDb.thisNodeName;
+  const std::string nodeName = newAdjacencyDb.thisNodeName;
   VLOG(1) << "Updating adjacency database for node " << nodeName << ", area "
           << newAdjacencyDb.area_ref().value_or("N/A");
 
@@ -583,136 +917,198 @@ LinkState::updateAdjacencyDatabase(
   }
 
   // Default construct if it did not exist
-  thrift::AdjacencyDatabase priorAdjacencyDb(
-      std::move(adjacencyDatabases_[nodeName]));
+  numPartialAdjacencies_ -= getNodePartialAdjacencies(nodeName);
+  auto& adjacencyDb = adjacencyDatabases_[nodeName];
+  const auto priorNodeLabel = adjacencyDb.nodeLabel;
   // replace
-  adjacencyDatabases_[nodeName] = newAdjacencyDb;
-
-  // for comparing old and new state, we order the links based on the tuple
-  // <nodeName1, iface1, nodeName2, iface2>, this allows us to easily discern
-  // topology changes in the single loop below
-  auto oldLinks = orderedLinksFromNode(nodeName);
-  auto newLinks = getOrderedLinkSet(newAdjacencyDb);
-
-  // fill these sets with the appropriate links
-  std::unordered_set<Link> linksUp;
-  std::unordered_set<Link> linksDown;
-
-  change.topologyChanged |= updateNodeOverloaded(
-      nodeName, newAdjacencyDb.isOverloaded, holdUpTtl, holdDownTtl);
-
-  change.nodeLabelChanged =
-      priorAdjacencyDb.nodeLabel != newAdjacencyDb.nodeLabel;
-
-  auto newIter = newLinks.begin();
-  auto oldIter = oldLinks.begin();
-  while (newIter != newLinks.end() || oldIter != oldLinks.end()) {
-    if (newIter != newLinks.end() &&
-        (oldIter == oldLinks.end() || **newIter < **oldIter)) {
-      // newIter is pointing at a Link not currently present, record this as a
-      // link to add and advance newIter
-      (*newIter)->setHoldUpTtl(holdUpTtl);
-      change.topologyChanged |= (*newIter)->isUp();
+  adjacencyDb = std::move(newAdjacencyDb);
+  numPartialAdjacencies_ += getNodePartialAdjacencies(nodeName);
+
+  // adjacencies are diffed against existing links of the node in place,
+  // looked up by <local interface, other node> in a sorted index (no
+  // allocation per link). Link objects are only created for new adjacencies
+  std::vector<std::shared_ptr<Link>> oldLinks;
+  if (auto links = folly::get_ptr(linkMap_, nodeName)) {
+    oldLinks.assign(links->begin(), links->end());
+  }
+  std::vector<std::tuple<std::string_view, std::string_view, size_t>>
+      oldLinkIndex;
+  oldLinkIndex.reserve(oldLinks.size());
+  for (size_t i = 0; i < oldLinks.size(); ++i) {
+    oldLinkIndex.emplace_back(
+        oldLinks[i]->getIfaceFromNode(nodeName),
+        oldLinks[i]->getOtherNodeName(nodeName),
+        i);
+  }
+  std::sort(oldLinkIndex.begin(), oldLinkIndex.end());
+  std::vector<bool> oldLinkPresent(oldLinks.size(), false);
+
+  // links whose metric or overload changed in place, with their state before
+  // the change: <link, wasUp, oldMetric>. Memoized SPF results can be
+  // repaired incrementally if this is the only change to the topology
+  std::vector<std::tuple<std::shared_ptr<Link>, bool, LinkStateMetric>>
+      changedLinks;
+  bool canRepairSpf = enableIncrementalSpf_;
+
+  if (updateNodeOverloaded(
+          nodeName, adjacencyDb.isOverloaded, holdUpTtl, holdDownTtl)) {
+    change.topologyChanged = true;
+    canRepairSpf = false;
+  }
+
+  change.nodeLabelChanged = priorNodeLabel != adjacencyDb.nodeLabel;
+
+  for (auto const& adj : adjacencyDb.adjacencies) {
+    std::optional<size_t> oldLinkIdx;
+    const std::string_view ifName{adj.ifName};
+    const std::string_view otherNodeName{adj.otherNodeName};
+    for (auto it = std::lower_bound(
+             oldLinkIndex.begin(),
+             oldLinkIndex.end(),
+             std::make_tuple(ifName, otherNodeName, size_t{0}));
+         it != oldLinkIndex.end() and std::get<0>(*it) == ifName and
+         std::get<1>(*it) == otherNodeName;
+         ++it) {
+      // remote interface must match too
+      const auto idx = std::get<2>(*it);
+      if (oldLinks.at(idx)->getIfaceFromNode(adj.otherNodeName) ==
+          adj.otherIfName) {
+        oldLinkIdx = idx;
+        break;
+      }
+    }
+
+    if (not oldLinkIdx.has_value()) {
+      // adjacency of a Link not currently present, add it once the reverse
+      // adjacency is present too
+      auto newLink = maybeMakeLink(nodeName, adj);
+      if (nullptr == newLink) {
+        continue;
+      }
+      newLink->setHoldUpTtl(holdUpTtl);
+      if (newLink->isUp()) {
+        change.topologyChanged = true;
+        canRepairSpf = false;
+      }
       // even if we are holding a change, we apply the change to our link state
       // and check for holds when running spf. this ensures we don't add the
       // same hold twice
-      addLink(*newIter);
-      VLOG(1) << "addLink " << (*newIter)->toString();
-      ++newIter;
-      continue;
-    }
-    if (oldIter != oldLinks.end() &&
-        (newIter == newLinks.end() || **oldIter < **newIter)) {
-      // oldIter is pointing at a Link that is no longer present, record this
-      // as a link to remove and advance oldIter.
-      // If this link was previously overloaded or had a hold up, this does not
-      // change the topology.
-      change.topologyChanged |= (*oldIter)->isUp();
-      removeLink(*oldIter);
-      VLOG(1) << "removeLink " << (*oldIter)->toString();
-      ++oldIter;
+      addLink(newLink);
+      updateHeldLink(newLink);
+      VLOG(1) << "addLink " << newLink->toString();
       continue;
     }
-    // The newIter and oldIter point to the same link. This link did not go up
+
+    // The adjacency is of a link we already have. This link did not go up
     // or down. The topology may still have changed though if the link overlaod
     // or metric changed
-    auto& newLink = **newIter;
-    auto& oldLink = **oldIter;
+    oldLinkPresent.at(*oldLinkIdx) = true;
+    auto const& oldLinkPtr = oldLinks.at(*oldLinkIdx);
+    auto& oldLink = *oldLinkPtr;
+    const bool wasUp = oldLink.isUp();
+    const auto oldMetric = oldLink.getMetricFromNode(nodeName);
+    bool linkChanged = false;
 
     // change the metric on the link object we already have
-    if (newLink.getMetricFromNode(nodeName) !=
-        oldLink.getMetricFromNode(nodeName)) {
+    if (adj.metric != oldLink.getMetricFromNode(nodeName)) {
       LOG(INFO) << folly::sformat(
           "Metric change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
+          oldLink.directionalToString(nodeName),
           oldLink.getMetricFromNode(nodeName),
-          newLink.getMetricFromNode(nodeName));
-      change.topologyChanged |= oldLink.setMetricFromNode(
-          nodeName,
-          newLink.getMetricFromNode(nodeName),
-          holdUpTtl,
-          holdDownTtl);
+          adj.metric);
+      linkChanged |= oldLink.setMetricFromNode(
+          nodeName, adj.metric, holdUpTtl, holdDownTtl);
     }
 
-    if (newLink.getOverloadFromNode(nodeName) !=
-        oldLink.getOverloadFromNode(nodeName)) {
+    if (adj.isOverloaded != oldLink.getOverloadFromNode(nodeName)) {
       LOG(INFO) << folly::sformat(
           "Overload change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
+          oldLink.directionalToString(nodeName),
           oldLink.getOverloadFromNode(nodeName),
-          newLink.getOverloadFromNode(nodeName));
-      change.topologyChanged |= oldLink.setOverloadFromNode(
-          nodeName,
-          newLink.getOverloadFromNode(nodeName),
-          holdUpTtl,
-          holdDownTtl);
+          adj.isOverloaded);
+      linkChanged |= oldLink.setOverloadFromNode(
+          nodeName, adj.isOverloaded, holdUpTtl, holdDownTtl);
+    }
+
+    updateHeldLink(oldLinkPtr);
+
+    if (linkChanged) {
+      change.topologyChanged = true;
+      changedLinks.emplace_back(oldLinkPtr, wasUp, oldMetric);
     }
 
     // Check if adjacency label has changed
-    if (newLink.getAdjLabelFromNode(nodeName) !=
-        oldLink.getAdjLabelFromNode(nodeName)) {
+    if (adj.adjLabel != oldLink.getAdjLabelFromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "AdjLabel change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
+          oldLink.directionalToString(nodeName),
           oldLink.getAdjLabelFromNode(nodeName),
-          newLink.getAdjLabelFromNode(nodeName));
+          adj.adjLabel);
 
       change.linkAttributesChanged |= true;
 
       // change the adjLabel on the link object we already have
-      oldLink.setAdjLabelFromNode(
-          nodeName, newLink.getAdjLabelFromNode(nodeName));
+      oldLink.setAdjLabelFromNode(nodeName, adj.adjLabel);
+    }
+
+    // Check if adjacency weight has changed, it affects UCMP nexthops only
+    if (adj.weight != oldLink.getWeightFromNode(nodeName)) {
+      VLOG(1) << folly::sformat(
+          "Weight change on link {}: {} => {}",
+          oldLink.directionalToString(nodeName),
+          oldLink.getWeightFromNode(nodeName),
+          adj.weight);
+
+      change.linkAttributesChanged |= true;
+      oldLink.setWeightFromNode(nodeName, adj.weight);
     }
 
     // check if local nextHops Changed
-    if (newLink.getNhV4FromNode(nodeName) !=
-        oldLink.getNhV4FromNode(nodeName)) {
+    if (adj.nextHopV4 != oldLink.getNhV4FromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "V4-NextHop address change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
+          oldLink.directionalToString(nodeName),
           toString(oldLink.getNhV4FromNode(nodeName)),
-          toString(newLink.getNhV4FromNode(nodeName)));
+          toString(adj.nextHopV4));
 
       change.linkAttributesChanged |= true;
-      oldLink.setNhV4FromNode(nodeName, newLink.getNhV4FromNode(nodeName));
+      oldLink.setNhV4FromNode(nodeName, adj.nextHopV4);
     }
-    if (newLink.getNhV6FromNode(nodeName) !=
-        oldLink.getNhV6FromNode(nodeName)) {
+    if (adj.nextHopV6 != oldLink.getNhV6FromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "V4-NextHop address change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
+          oldLink.directionalToString(nodeName),
           toString(oldLink.getNhV6FromNode(nodeName)),
-          toString(newLink.getNhV6FromNode(nodeName)));
+          toString(adj.nextHopV6));
 
       change.linkAttributesChanged |= true;
-      oldLink.setNhV6FromNode(nodeName, newLink.getNhV6FromNode(nodeName));
+      oldLink.setNhV6FromNode(nodeName, adj.nextHopV6);
     }
-    ++newIter;
-    ++oldIter;
+  }
+
+  // Links without adjacency in the new database are no longer present.
+  // If this link was previously overloaded or had a hold up, this does not
+  // change the topology.
+  for (size_t i = 0; i < oldLinks.size(); ++i) {
+    if (oldLinkPresent.at(i)) {
+      continue;
+    }
+    if (oldLinks.at(i)->isUp()) {
+      change.topologyChanged = true;
+      canRepairSpf = false;
+    }
+    removeLink(oldLinks.at(i));
+    VLOG(1) << "removeLink " << oldLinks.at(i)->toString();
   }
   if (change.topologyChanged) {
-    spfResults_.clear();
-    kthPathResults_.clear();
+    clearKthPathResults();
+    csrDirty_ = true;
+    if (canRepairSpf && 1 == changedLinks.size()) {
+      auto const& [link, wasUp, oldMetric] = changedLinks.front();
+      repairSpfResults(*link, nodeName, wasUp, oldMetric);
+    } else {
+      clearSpfResults();
+    }
   }
   return change;
 }
@@ -726,8 +1122,9 @@ LinkState::deleteAdjacencyDatabase(const std::string& nodeName) {
   if (search != adjacencyDatabases_.end()) {
     removeNode(nodeName);
     adjacencyDatabases_.erase(search);
-    spfResults_.clear();
-    kthPathResults_.clear();
+    clearSpfResults();
+    clearKthPathResults();
+    csrDirty_ = true;
     change.topologyChanged = true;
   } else {
     LOG(WARNING) << "Trying to delete adjacency db for nonexisting node "
@@ -742,9 +1139,9 @@ LinkState::getMetricFromAToB(
   if (a == b) {
     return 0;
   }
-  auto const& spfResult = getSpfResult(a, useLinkMetric);
-  if (spfResult.count(b)) {
-    return spfResult.at(b).metric();
+  auto const* nodeResult = getSpfResult(a, useLinkMetric).get(b);
+  if (nodeResult) {
+    return nodeResult->metric();
   }
   return std::nullopt;
 }
@@ -752,8 +1149,9 @@ LinkState::getMetricFromAToB(
 LinkStateMetric
 LinkState::getMaxHopsToNode(const std::string& nodeName) const {
   LinkStateMetric max = 0;
-  for (auto const& pathsFromNode : getSpfResult(nodeName, false)) {
-    max = std::max(max, pathsFromNode.second.metric());
+  auto const& spfResult = getSpfResult(nodeName, false);
+  for (auto const id : spfResult.reachableNodes()) {
+    max = std::max(max, spfResult.get(id)->metric());
   }
   return max;
 }
@@ -763,42 +1161,175 @@ LinkState::getKthPaths(
     const std::string& src, const std::string& dest, size_t k) const {
   CHECK_GE(k, 1);
   std::tuple<std::string, std::string, size_t> key(src, dest, k);
-  auto entryIter = kthPathResults_.find(key);
-  if (kthPathResults_.end() == entryIter) {
-    LinkSet linksToIgnore;
-    for (size_t i = 1; i < k; ++i) {
-      for (auto const& path : getKthPaths(src, dest, i)) {
-        for (auto const& link : path) {
-          linksToIgnore.insert(link);
-        }
+  std::optional<NodeId> srcId;
+  std::optional<NodeId> destId;
+  {
+    std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+    auto entryIter = kthPathResults_.find(key);
+    if (kthPathResults_.end() != entryIter) {
+      entryIter->second.lastUse = ++memoTick_;
+      return entryIter->second.value;
+    }
+    srcId = nodeIds_->find(src);
+    destId = nodeIds_->find(dest);
+  }
+
+  // Paths are computed without holding the lock, so that paths towards
+  // different destinations can be computed concurrently
+  LinkSet linksToIgnore;
+  for (size_t i = 1; i < k; ++i) {
+    for (auto const& path : getKthPaths(src, dest, i)) {
+      for (auto const& link : path) {
+        linksToIgnore.insert(link);
       }
     }
-    std::vector<LinkState::Path> paths;
-    auto const& res = linksToIgnore.empty() ? getSpfResult(src, true)
-                                            : runSpf(src, true, linksToIgnore);
-    if (res.count(dest)) {
+  }
+  std::vector<LinkState::Path> paths;
+  if (srcId && destId) {
+    // Paths are traced back from dest through nodes closer to src only, so
+    // SPF without the links to ignore (which differ per dest) can stop as
+    // soon as dest is reached, instead of running over the whole area for
+    // every dest
+    std::optional<SpfResult> partialResult;
+    if (!linksToIgnore.empty()) {
+      partialResult = runSpf(src, true, linksToIgnore, *destId);
+    }
+    auto const& res = partialResult ? *partialResult : getSpfResult(src, true);
+    if (res.get(*destId)) {
       LinkSet visitedLinks;
-      auto path = traceOnePath(src, dest, res, visitedLinks);
+      auto path = traceOnePath(*srcId, *destId, res, visitedLinks);
       while (path && !path->empty()) {
         paths.push_back(std::move(*path));
-        path = traceOnePath(src, dest, res, visitedLinks);
+        path = traceOnePath(*srcId, *destId, res, visitedLinks);
       }
     }
-    entryIter = kthPathResults_.emplace(key, std::move(paths)).first;
   }
-  return entryIter->second;
+
+  // keep the paths of whoever computed them first, as their references may
+  // have been handed out already
+  std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+  const size_t bytes = pathsMemoryUsage(paths);
+  auto [entryIter, inserted] = kthPathResults_.emplace(
+      std::move(key), MemoEntry<std::vector<Path>>{std::move(paths), bytes});
+  if (inserted) {
+    kthPathResultsBytes_ += bytes;
+  }
+  entryIter->second.lastUse = ++memoTick_;
+  return entryIter->second.value;
 }
 
 LinkState::SpfResult const&
 LinkState::getSpfResult(
     const std::string& thisNodeName, bool useLinkMetric) const {
+  std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
   std::pair<std::string, bool> key{thisNodeName, useLinkMetric};
   auto entryIter = spfResults_.find(key);
   if (spfResults_.end() == entryIter) {
     auto res = runSpf(thisNodeName, useLinkMetric);
-    entryIter = spfResults_.emplace(std::move(key), std::move(res)).first;
+    const size_t bytes = res.memoryUsage();
+    entryIter = spfResults_
+                    .emplace(
+                        std::move(key),
+                        MemoEntry<SpfResult>{std::move(res), bytes})
+                    .first;
+    spfResultsBytes_ += bytes;
   }
-  return entryIter->second;
+  entryIter->second.lastUse = ++memoTick_;
+  return entryIter->second.value;
+}
+
+void
+LinkState::evictMemoization() const {
+  std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+  size_t numEvicted{0};
+  if (memoBudgetBytes_ and
+      spfResultsBytes_ + kthPathResultsBytes_ > memoBudgetBytes_) {
+    // evict across both structures in order of last use
+    std::vector<std::pair<uint64_t /* lastUse */, std::function<void()>>>
+        evictions;
+    evictions.reserve(spfResults_.size() + kthPathResults_.size());
+    for (auto it = spfResults_.begin(); it != spfResults_.end(); ++it) {
+      evictions.emplace_back(it->second.lastUse, [this, it]() {
+        spfResultsBytes_ -= it->second.bytes;
+        spfResults_.erase(it);
+      });
+    }
+    for (auto it = kthPathResults_.begin(); it != kthPathResults_.end();
+         ++it) {
+      evictions.emplace_back(it->second.lastUse, [this, it]() {
+        kthPathResultsBytes_ -= it->second.bytes;
+        kthPathResults_.erase(it);
+      });
+    }
+    std::sort(
+        evictions.begin(), evictions.end(), [](auto const& a, auto const& b) {
+          return a.first < b.first;
+        });
+    for (auto& [_, evict] : evictions) {
+      if (spfResultsBytes_ + kthPathResultsBytes_ <= memoBudgetBytes_) {
+        break;
+      }
+      evict();
+      ++numEvicted;
+    }
+  }
+
+  if (numEvicted) {
+    VLOG(2) << "Evicted " << numEvicted << " memoized results of area "
+            << area_;
+    fb303::fbData->addStatValue(
+        "decision.memo_evictions", numEvicted, fb303::COUNT);
+  }
+  fb303::fbData->setCounter(
+      folly::sformat("decision.{}.spf_results_bytes", area_),
+      spfResultsBytes_);
+  fb303::fbData->setCounter(
+      folly::sformat("decision.{}.kth_path_results_bytes", area_),
+      kthPathResultsBytes_);
+  setMemoryCounter("decision", area_ + ".spf_results", spfResultsBytes_);
+  setMemoryCounter(
+      "decision", area_ + ".kth_path_results", kthPathResultsBytes_);
+}
+
+void
+LinkState::clearSpfResults() {
+  spfResults_.clear();
+  spfResultsBytes_ = 0;
+}
+
+void
+LinkState::clearKthPathResults() {
+  kthPathResults_.clear();
+  kthPathResultsBytes_ = 0;
+}
+
+void
+LinkState::maybeBuildCsr() const {
+  if (!csrDirty_ && csrOffsets_.size() == nodeIds_->size() + 1) {
+    return;
+  }
+  const size_t numNodes = nodeIds_->size();
+  csrOffsets_.assign(numNodes + 1, 0);
+  csrEdges_.clear();
+  csrEdges_.reserve(2 * allLinks_.size());
+  csrNodeOverloaded_.assign(numNodes, false);
+  for (NodeId id = 0; id < numNodes; ++id) {
+    auto const& nodeName = nodeIds_->name(id);
+    csrOffsets_[id] = csrEdges_.size();
+    csrNodeOverloaded_[id] = isNodeOverloaded(nodeName);
+    for (auto const& link : linksFromNode(nodeName)) {
+      if (!link->isUp()) {
+        continue;
+      }
+      // both ends of every link are interned in addLink()
+      csrEdges_.push_back(CsrEdge{
+          nodeIds_->find(link->getOtherNodeName(nodeName)).value(),
+          link->getMetricFromNode(nodeName),
+          link});
+    }
+  }
+  csrOffsets_[numNodes] = csrEdges_.size();
+  csrDirty_ = false;
 }
 
 /**
@@ -808,27 +1339,45 @@ LinkState::SpfResult
 LinkState::runSpf(
     const std::string& thisNodeName,
     bool useLinkMetric,
-    const LinkState::LinkSet& linksToIgnore) const {
-  LinkState::SpfResult result;
-
+    const LinkState::LinkSet& linksToIgnore,
+    std::optional<NodeId> stopAtNode) const {
   fb303::fbData->addStatValue("decision.spf_runs", 1, fb303::COUNT);
   const auto startTime = std::chrono::steady_clock::now();
 
-  DijkstraQ q;
-  q.insertNode(thisNodeName, 0);
+  // the source may not be known yet, in which case it is the only node
+  // reachable from itself. Interning it and building the CSR snapshot are the
+  // only writes, the Dijkstra run below only reads them
+  NodeId thisNodeId;
+  {
+    std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+    thisNodeId = nodeIds_->getOrAdd(thisNodeName);
+    maybeBuildCsr();
+  }
+  const size_t numCsrNodes = csrOffsets_.size() - 1;
+
+  LinkState::SpfResult result(nodeIds_);
+
+  DijkstraQ q(*nodeIds_);
+  q.insertNode(thisNodeId, 0);
   uint64_t loop = 0;
   while (auto node = q.extractMin()) {
     ++loop;
     // we've found this node's shortest paths. record it
-    auto emplaceRc = result.emplace(node->nodeName, std::move(node->result));
-    CHECK(emplaceRc.second);
+    const NodeId recordedNodeId = node->nodeId;
+    auto const& recordedNodeResult =
+        result.emplace(recordedNodeId, std::move(node->result));
 
-    auto const& recordedNodeName = emplaceRc.first->first;
-    auto const recordedNodeMetric = emplaceRc.first->second.metric();
-    auto const& recordedNodeNextHops = emplaceRc.first->second.nextHops();
+    if (stopAtNode && recordedNodeId == *stopAtNode) {
+      // all equal cost paths to it were relaxed from nodes recorded before
+      break;
+    }
 
-    if (isNodeOverloaded(recordedNodeName) &&
-        recordedNodeName != thisNodeName) {
+    if (recordedNodeId >= numCsrNodes) {
+      // node without any links
+      continue;
+    }
+
+    if (csrNodeOverloaded_[recordedNodeId] && recordedNodeId != thisNodeId) {
       // no transit traffic through this node. we've recorded the nexthops to
       // this node, but will not consider any of it's adjancecies as offering
       // lower cost paths towards further away nodes. This effectively drains
@@ -838,38 +1387,22 @@ LinkState::runSpf(
     // we have the shortest path nexthops for recordedNodeName. Use these
     // nextHops for any node that is connected to recordedNodeName that doesn't
     // already have a lower cost path from thisNodeName
-    //
-    // this is the "relax" step in the Dijkstra Algorithm pseudocode in CLRS
-    for (const auto& link : linksFromNode(recordedNodeName)) {
-      auto& otherNodeName = link->getOtherNodeName(recordedNodeName);
-      if (!link->isUp() or result.count(otherNodeName) or
-          linksToIgnore.count(link)) {
+    for (size_t e = csrOffsets_[recordedNodeId];
+         e < csrOffsets_[recordedNodeId + 1];
+         ++e) {
+      auto const& edge = csrEdges_[e];
+      if (result.get(edge.otherNode) or
+          (!linksToIgnore.empty() and linksToIgnore.count(edge.link))) {
         continue;
       }
-      auto metric =
-          useLinkMetric ? link->getMetricFromNode(recordedNodeName) : 1;
-      auto otherNode = q.get(otherNodeName);
-      if (!otherNode) {
-        q.insertNode(otherNodeName, recordedNodeMetric + metric);
-        otherNode = q.get(otherNodeName);
-      }
-      if (otherNode->result.metric() >= recordedNodeMetric + metric) {
-        // recordedNodeName is either along an alternate shortest path towards
-        // otherNodeName or is along a new shorter path. In either case,
-        // otherNodeName should use recordedNodeName's nextHops until it finds
-        // some shorter path
-        if (otherNode->result.metric() > recordedNodeMetric + metric) {
-          // if this is strictly better, forget about any other paths
-          otherNode->result.reset(recordedNodeMetric + metric);
-          q.reMake();
-        }
-        otherNode->result.addPath(link, recordedNodeName);
-        otherNode->result.addNextHops(recordedNodeNextHops);
-        if (otherNode->result.nextHops().empty()) {
-          // directly connected node
-          otherNode->result.addNextHop(otherNodeName);
-        }
-      }
+      relaxEdge(
+          q,
+          result,
+          recordedNodeId,
+          recordedNodeResult,
+          edge.otherNode,
+          edge.link,
+          useLinkMetric ? edge.metric : 1);
     }
   }
   VLOG(3) << "Dijkstra loop count: " << loop;
@@ -880,4 +1413,245 @@ LinkState::runSpf(
   return result;
 }
 
+void
+LinkState::repairSpfResults(
+    Link const& link,
+    const std::string& nodeName,
+    bool wasUp,
+    LinkStateMetric oldMetric) const {
+  maybeBuildCsr();
+  const NodeId nodeId = nodeIds_->find(nodeName).value();
+  const NodeId otherNodeId =
+      nodeIds_->find(link.getOtherNodeName(nodeName)).value();
+  const bool isUp = link.isUp();
+  const auto newMetric = link.getMetricFromNode(nodeName);
+
+  for (auto& [key, entry] : spfResults_) {
+    auto const& [srcName, useLinkMetric] = key;
+    auto& result = entry.value;
+    size_t nodesTouched{0};
+    if (wasUp && isUp) {
+      // only the metric from nodeName's side changed, which is of no
+      // consequence for hop count SPF results
+      if (!useLinkMetric || newMetric == oldMetric) {
+        continue;
+      }
+      nodesTouched = repairSpfResult(
+          result,
+          nodeIds_->find(srcName).value(),
+          useLinkMetric,
+          link,
+          {{nodeId, otherNodeId}},
+          newMetric > oldMetric);
+    } else if (wasUp != isUp) {
+      // link went down or came up, affecting both directions
+      nodesTouched = repairSpfResult(
+          result,
+          nodeIds_->find(srcName).value(),
+          useLinkMetric,
+          link,
+          {{nodeId, otherNodeId}, {otherNodeId, nodeId}},
+          wasUp);
+    } else {
+      // link was and still is down
+      continue;
+    }
+    spfResultsBytes_ -= entry.bytes;
+    entry.bytes = result.memoryUsage();
+    spfResultsBytes_ += entry.bytes;
+    VLOG(3) << "Incremental SPF from " << srcName << " recomputed "
+            << nodesTouched << " nodes";
+    fb303::fbData->addStatValue("decision.ispf_runs", 1, fb303::COUNT);
+    fb303::fbData->addStatValue(
+        "decision.ispf_nodes_touched", nodesTouched, fb303::SUM);
+  }
+}
+
+size_t
+LinkState::repairSpfResult(
+    SpfResult& result,
+    NodeId src,
+    bool useLinkMetric,
+    Link const& link,
+    std::vector<std::pair<NodeId, NodeId>> const& changedEdges,
+    bool costIncreased) const {
+  const size_t numNodes = csrOffsets_.size() - 1;
+  auto const canTransit = [&](NodeId id) {
+    return id == src || !csrNodeOverloaded_[id];
+  };
+  auto const edgeCost = [&](CsrEdge const& edge) -> LinkStateMetric {
+    return useLinkMetric ? edge.metric : 1;
+  };
+
+  // 1. find the nodes whose shortest paths may go through a changed edge
+  std::vector<bool> affected(numNodes, false);
+  std::vector<NodeId> affectedNodes;
+  auto const markAffected = [&](NodeId id) {
+    if (!affected[id]) {
+      affected[id] = true;
+      affectedNodes.push_back(id);
+    }
+  };
+  if (costIncreased) {
+    // only nodes that used the edge can be worse off
+    for (auto const& [from, to] : changedEdges) {
+      if (auto const* toResult = result.get(to)) {
+        for (auto const& pathLink : toResult->pathLinks()) {
+          if (pathLink.prevNode == from && *pathLink.link == link) {
+            markAffected(to);
+            break;
+          }
+        }
+      }
+    }
+  } else {
+    // nodes that can be reached over the edge at no more than their current
+    // metric either get a better path or an additional equal cost one. Find
+    // them with a Dijkstra run that is pruned at every node where the edge
+    // does not help
+    std::vector<LinkStateMetric> best(
+        numNodes, std::numeric_limits<LinkStateMetric>::max());
+    using QueueEntry = std::pair<LinkStateMetric, NodeId>;
+    std::priority_queue<
+        QueueEntry,
+        std::vector<QueueEntry>,
+        std::greater<QueueEntry>>
+        q;
+    auto const maybePush = [&](NodeId id, LinkStateMetric metric) {
+      if (id == src || metric >= best[id]) {
+        return;
+      }
+      auto const* current = result.get(id);
+      if (!current || metric <= current->metric()) {
+        best[id] = metric;
+        q.emplace(metric, id);
+      }
+    };
+    for (auto const& [from, to] : changedEdges) {
+      auto const* fromResult = result.get(from);
+      if (fromResult && canTransit(from)) {
+        maybePush(
+            to,
+            fromResult->metric() +
+                (useLinkMetric
+                     ? link.getMetricFromNode(nodeIds_->name(from))
+                     : 1));
+      }
+    }
+    while (!q.empty()) {
+      auto const [metric, id] = q.top();
+      q.pop();
+      if (metric > best[id] || affected[id]) {
+        continue;
+      }
+      markAffected(id);
+      if (!canTransit(id)) {
+        continue;
+      }
+      for (size_t e = csrOffsets_[id]; e < csrOffsets_[id + 1]; ++e) {
+        maybePush(csrEdges_[e].otherNode, metric + edgeCost(csrEdges_[e]));
+      }
+    }
+  }
+  if (affectedNodes.empty()) {
+    return 0;
+  }
+
+  // 2. nexthops change for everything downstream of those nodes as well, so
+  // extend the affected set to its descendants in the shortest path DAG
+  std::vector<size_t> childOffsets(numNodes + 1, 0);
+  for (auto const id : result.reachableNodes()) {
+    for (auto const& pathLink : result.get(id)->pathLinks()) {
+      ++childOffsets[pathLink.prevNode + 1];
+    }
+  }
+  for (size_t i = 0; i < numNodes; ++i) {
+    childOffsets[i + 1] += childOffsets[i];
+  }
+  std::vector<NodeId> children(childOffsets[numNodes]);
+  {
+    auto fill = childOffsets;
+    for (auto const id : result.reachableNodes()) {
+      for (auto const& pathLink : result.get(id)->pathLinks()) {
+        children[fill[pathLink.prevNode]++] = id;
+      }
+    }
+  }
+  for (size_t i = 0; i < affectedNodes.size(); ++i) {
+    const NodeId id = affectedNodes[i];
+    for (size_t c = childOffsets[id]; c < childOffsets[id + 1]; ++c) {
+      markAffected(children[c]);
+    }
+  }
+
+  // 3. forget the affected nodes and recompute them. Unaffected nodes keep
+  // their shortest paths, so the ones bordering the affected region are
+  // queued with their final metric. Settling them in order with the affected
+  // nodes relaxes edges in the same order as a full SPF run would, keeping
+  // the repaired result identical to one computed from scratch
+  result.results_.resize(std::max(result.results_.size(), numNodes));
+  for (auto const id : affectedNodes) {
+    result.results_[id].reset();
+  }
+  auto& reachable = result.reachableNodes_;
+  reachable.erase(
+      std::remove_if(
+          reachable.begin(),
+          reachable.end(),
+          [&](NodeId id) { return affected[id]; }),
+      reachable.end());
+  const size_t numUnaffected = reachable.size();
+
+  DijkstraQ q(*nodeIds_);
+  for (auto const id : affectedNodes) {
+    for (size_t e = csrOffsets_[id]; e < csrOffsets_[id + 1]; ++e) {
+      const NodeId otherNodeId = csrEdges_[e].otherNode;
+      auto const* otherResult = result.get(otherNodeId);
+      if (otherResult && canTransit(otherNodeId) && !q.get(otherNodeId)) {
+        q.insertNode(otherNodeId, otherResult->metric());
+      }
+    }
+  }
+  while (auto node = q.extractMin()) {
+    const NodeId recordedNodeId = node->nodeId;
+    auto const& recordedNodeResult = affected[recordedNodeId]
+        ? result.emplace(recordedNodeId, std::move(node->result))
+        : *result.get(recordedNodeId);
+    if (!canTransit(recordedNodeId)) {
+      continue;
+    }
+    for (size_t e = csrOffsets_[recordedNodeId];
+         e < csrOffsets_[recordedNodeId + 1];
+         ++e) {
+      auto const& edge = csrEdges_[e];
+      if (!affected[edge.otherNode] || result.get(edge.otherNode)) {
+        continue;
+      }
+      relaxEdge(
+          q,
+          result,
+          recordedNodeId,
+          recordedNodeResult,
+          edge.otherNode,
+          edge.link,
+          edgeCost(edge));
+    }
+  }
+
+  // recomputed nodes were settled in order, merge them back into place
+  std::inplace_merge(
+      reachable.begin(),
+      reachable.begin() + numUnaffected,
+      reachable.end(),
+      [&](NodeId a, NodeId b) {
+        auto const metricA = result.get(a)->metric();
+        auto const metricB = result.get(b)->metric();
+        if (metricA != metricB) {
+          return metricA < metricB;
+        }
+        return nodeIds_->name(a) < nodeIds_->name(b);
+      });
+  return affectedNodes.size();
+}
+
 } // namespace openr
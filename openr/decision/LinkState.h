@@ -8,12 +8,21 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <folly/lang/Bits.h>
+#include <folly/small_vector.h>
+
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 
@@ -96,19 +105,46 @@ class Link {
       const openr::thrift::Adjacency& adj2);
 
  private:
-  const std::string area_;
-  const std::string n1_, n2_, if1_, if2_;
+  // Links are numerous (one per adjacency pair in the area), they are laid
+  // out compactly: area, node and interface names are interned, i.e. shared
+  // by all links, and nexthop addresses are held inline
+  static const std::string* internName(const std::string& name);
+
+  // nexthop address held inline, thrift::BinaryAddress is rebuilt on read
+  struct InlineAddress {
+    std::array<char, 16> addr{};
+    uint8_t len{0};
+    // interned ifName of the address, nullptr if unset
+    const std::string* ifName{nullptr};
+
+    InlineAddress() = default;
+    explicit InlineAddress(const thrift::BinaryAddress& address);
+
+    thrift::BinaryAddress toThrift() const;
+  };
+
+  // names of both ends of the link, ordered by (nodeName, ifName)
+  std::tuple<
+      const std::string&,
+      const std::string&,
+      const std::string&,
+      const std::string&>
+  orderedNames() const;
+
+  const std::string* const area_;
+  const std::string* const n1_;
+  const std::string* const n2_;
+  const std::string* const if1_;
+  const std::string* const if2_;
   HoldableValue<LinkStateMetric> metric1_{1}, metric2_{1};
   HoldableValue<bool> overload1_{false}, overload2_{false};
+  // (n2_, if2_) orders before (n1_, if1_)
+  const bool swapped_{false};
   int32_t adjLabel1_{0}, adjLabel2_{0};
-  thrift::BinaryAddress nhV41_, nhV42_, nhV61_, nhV62_;
+  int64_t weight1_{1}, weight2_{1};
+  InlineAddress nhV41_, nhV42_, nhV61_, nhV62_;
   LinkStateMetric holdUpTtl_{0};
 
-  const std::pair<
-      std::pair<std::string, std::string>,
-      std::pair<std::string, std::string>>
-      orderedNames_;
-
  public:
   const size_t hash{0};
 
@@ -122,7 +158,7 @@ class Link {
 
   const std::string&
   getArea() const {
-    return area_;
+    return *area_;
   }
 
   const std::string& getOtherNodeName(const std::string& nodeName) const;
@@ -137,13 +173,14 @@ class Link {
 
   int32_t getAdjLabelFromNode(const std::string& nodeName) const;
 
+  // weight of adjacency for UCMP, doesn't affect SPF
+  int64_t getWeightFromNode(const std::string& nodeName) const;
+
   bool getOverloadFromNode(const std::string& nodeName) const;
 
-  const thrift::BinaryAddress& getNhV4FromNode(
-      const std::string& nodeName) const;
+  thrift::BinaryAddress getNhV4FromNode(const std::string& nodeName) const;
 
-  const thrift::BinaryAddress& getNhV6FromNode(
-      const std::string& nodeName) const;
+  thrift::BinaryAddress getNhV6FromNode(const std::string& nodeName) const;
 
   void setNhV4FromNode(
       const std::string& nodeName, const thrift::BinaryAddress& nhV4);
@@ -159,6 +196,8 @@ class Link {
 
   void setAdjLabelFromNode(const std::string& nodeName, int32_t adjLabel);
 
+  void setWeightFromNode(const std::string& nodeName, int64_t weight);
+
   bool setOverloadFromNode(
       const std::string& nodeName,
       bool overload,
@@ -176,7 +215,14 @@ class Link {
 
 class LinkState {
  public:
-  explicit LinkState(const std::string& area);
+  // enableIncrementalSpf: on a change of metric or overload of a single link,
+  // repair memoized SPF results in place instead of invalidating them
+  // memoBudgetBytes: memory budget of memoized SPF results and kth paths
+  // enforced by evictMemoization(), 0 for unbounded
+  explicit LinkState(
+      const std::string& area,
+      bool enableIncrementalSpf = false,
+      size_t memoBudgetBytes = 0);
 
   struct LinkPtrHash {
     size_t operator()(const std::shared_ptr<Link>& l) const;
@@ -197,6 +243,90 @@ class LinkState {
   using LinkSet =
       std::unordered_set<std::shared_ptr<Link>, LinkPtrHash, LinkPtrEqual>;
 
+  // Dense integer id assigned to each node name seen by this LinkState. SPF
+  // runs entirely on these ids, names are only resolved at the API boundary.
+  using NodeId = uint32_t;
+
+  // Append-only interning table of node names. Ids are never reused, so any
+  // SpfResult computed on an older version of the link state can still be
+  // translated back to node names.
+  class NodeIdTable {
+   public:
+    NodeId getOrAdd(const std::string& nodeName);
+
+    std::optional<NodeId> find(const std::string& nodeName) const;
+
+    const std::string&
+    name(NodeId id) const {
+      return names_.at(id);
+    }
+
+    size_t
+    size() const {
+      return names_.size();
+    }
+
+   private:
+    std::unordered_map<std::string, NodeId> ids_;
+    // deque keeps references handed out by name() stable across growth
+    std::deque<std::string> names_;
+  };
+
+  // Set of first hops of an SpfResult, one bit per index into
+  // SpfResult::firstHops(). Held inline for up to 64 first hops, so nexthops
+  // are merged along the shortest path DAG without allocating
+  class FirstHopSet {
+   public:
+    void
+    insert(size_t index) {
+      if (index / 64 >= words_.size()) {
+        words_.resize(index / 64 + 1, 0);
+      }
+      words_[index / 64] |= uint64_t{1} << (index % 64);
+    }
+
+    void
+    merge(FirstHopSet const& other) {
+      if (other.words_.size() > words_.size()) {
+        words_.resize(other.words_.size(), 0);
+      }
+      for (size_t w = 0; w < other.words_.size(); ++w) {
+        words_[w] |= other.words_[w];
+      }
+    }
+
+    // words are only added along with a bit set in them or above
+    bool
+    empty() const {
+      return words_.empty();
+    }
+
+    void
+    clear() {
+      words_.clear();
+    }
+
+    // call f with every index in the set, in ascending order
+    template <typename F>
+    void
+    forEach(F&& f) const {
+      for (size_t w = 0; w < words_.size(); ++w) {
+        for (uint64_t bits = words_[w]; bits; bits &= bits - 1) {
+          f(w * 64 + folly::findFirstSet(bits) - 1);
+        }
+      }
+    }
+
+    // number of bytes allocated out of line
+    size_t
+    externalBytes() const {
+      return words_.capacity() > 1 ? words_.capacity() * sizeof(uint64_t) : 0;
+    }
+
+   private:
+    folly::small_vector<uint64_t, 1> words_;
+  };
+
   // Class holding a network node's SPF result. and useful apis to get and set
   //   - nexthops toward the node
   //   - ultimate link and previous nodes on shortest paths towards node
@@ -206,10 +336,10 @@ class LinkState {
     // these to trace paths back to the source from any connected node
     class PathLink {
      public:
-      PathLink(std::shared_ptr<Link> const& l, std::string const& n)
+      PathLink(std::shared_ptr<Link> const& l, NodeId n)
           : link(l), prevNode(n) {}
       std::shared_ptr<Link> const link;
-      std::string const prevNode;
+      NodeId const prevNode;
     };
 
     explicit NodeSpfResult(LinkStateMetric m) : metric_(m) {}
@@ -225,8 +355,11 @@ class LinkState {
     pathLinks() const {
       return pathLinks_;
     }
-    std::unordered_set<std::string> const&
-    nextHops() const {
+
+    // first hops used as nexthops. Use SpfResult::nextHops() to translate
+    // into node ids
+    FirstHopSet const&
+    nextHopSet() const {
       return nextHops_;
     }
 
@@ -236,28 +369,95 @@ class LinkState {
     }
 
     void
-    addPath(std::shared_ptr<Link> const& link, std::string const& prevNode) {
+    addPath(std::shared_ptr<Link> const& link, NodeId prevNode) {
       pathLinks_.emplace_back(link, prevNode);
     }
 
     void
-    addNextHops(std::unordered_set<std::string> const& toInsert) {
-      nextHops_.insert(toInsert.begin(), toInsert.end());
+    addNextHops(FirstHopSet const& toInsert) {
+      nextHops_.merge(toInsert);
     }
 
+    // firstHopIndex: see SpfResult::getOrAddFirstHop()
     void
-    addNextHop(std::string const& toInsert) {
-      nextHops_.insert(toInsert);
+    addNextHop(size_t firstHopIndex) {
+      nextHops_.insert(firstHopIndex);
     }
 
    private:
     LinkStateMetric metric_{std::numeric_limits<LinkStateMetric>::max()};
+    // predecessors in the shortest path DAG
     std::vector<PathLink> pathLinks_;
-    std::unordered_set<std::string> nextHops_;
+    FirstHopSet nextHops_;
   };
 
-  using SpfResult =
-      std::unordered_map<std::string /* otherNodeName */, NodeSpfResult>;
+  // Result of one SPF run. Node results are stored in a vector indexed by
+  // NodeId; the string based accessors are a thin translation layer on top.
+  class SpfResult {
+   public:
+    explicit SpfResult(std::shared_ptr<NodeIdTable const> nodeIds);
+
+    // returns nullptr if nodeName is not reachable
+    NodeSpfResult const* get(std::string const& nodeName) const;
+
+    NodeSpfResult const*
+    get(NodeId id) const {
+      return id < results_.size() && results_[id].has_value() ? &*results_[id]
+                                                              : nullptr;
+    }
+
+    // throws std::out_of_range if nodeName is not reachable
+    NodeSpfResult const& at(std::string const& nodeName) const;
+
+    size_t
+    count(std::string const& nodeName) const {
+      return get(nodeName) ? 1 : 0;
+    }
+
+    size_t
+    size() const {
+      return reachableNodes_.size();
+    }
+
+    // ids of all reachable nodes, in the order SPF settled them
+    std::vector<NodeId> const&
+    reachableNodes() const {
+      return reachableNodes_;
+    }
+
+    std::string const&
+    nodeName(NodeId id) const {
+      return nodeIds_->name(id);
+    }
+
+    NodeSpfResult& emplace(NodeId id, NodeSpfResult&& result);
+
+    // sorted ids of the neighbors used as nexthops towards a node of this
+    // result. Use nodeName() to translate
+    std::vector<NodeId> nextHops(NodeSpfResult const& nodeResult) const;
+
+    // neighbors of the source directly used as nexthops, indexed by the bits
+    // of FirstHopSet
+    std::vector<NodeId> const&
+    firstHops() const {
+      return firstHops_;
+    }
+
+    // index of neighbor among first hops, added if not a first hop yet
+    size_t getOrAddFirstHop(NodeId id);
+
+    // approximate number of bytes held by this result
+    size_t memoryUsage() const;
+
+   private:
+    // incremental SPF drops and re-emplaces the results of affected nodes
+    friend class LinkState;
+
+    std::shared_ptr<NodeIdTable const> nodeIds_;
+    std::vector<std::optional<NodeSpfResult>> results_;
+    std::vector<NodeId> reachableNodes_;
+    std::vector<NodeId> firstHops_;
+  };
 
   using Path = std::vector<std::shared_ptr<Link>>;
 
@@ -268,18 +468,69 @@ class LinkState {
   // each is memoized all params. memoization invalidated for any topolgy
   // altering calls, i.e. if decrementHolds(), updateAdjacencyDatabase(), or
   // deleteAdjacencyDatabase() returns with LinkState::topologyChanged set true
+  //
+  // Both may be called concurrently from several threads as long as no
+  // non-const method runs at the same time, e.g. by SpfSolver building routes
+  // of a large prefix set in shards. Returned references stay valid until the
+  // memoization is invalidated. getKthPaths() computes paths of different
+  // destinations in parallel, provided the source is already known (e.g. its
+  // getSpfResult() was called before).
   SpfResult const& getSpfResult(
       const std::string& nodeName, bool useLinkMetric = true) const;
 
+  // Evict least recently used memoized SPF results and kth paths until they
+  // fit the memory budget, and export their size as counters. Invalidates
+  // references returned before, hence must be called between route builds
+  void evictMemoization() const;
+
+  // approximate number of bytes held by memoized SPF results / kth paths
+  size_t
+  getSpfResultsBytes() const {
+    std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+    return spfResultsBytes_;
+  }
+
+  size_t
+  getKthPathResultsBytes() const {
+    std::lock_guard<std::recursive_mutex> lock(*memoMutex_);
+    return kthPathResultsBytes_;
+  }
+
  private:
   // LinkState belongs to a unique area
   const std::string area_;
 
+  // see LinkState()
+  const bool enableIncrementalSpf_{false};
+
+  // see LinkState()
+  const size_t memoBudgetBytes_{0};
+
+  // guards the memoization structures below, the CSR snapshot and the node
+  // interning table against concurrent const SPF calls. Recursive since
+  // getSpfResult() holds it while runSpf() takes it again. Held by pointer to
+  // keep LinkState movable
+  std::unique_ptr<std::recursive_mutex> memoMutex_{
+      std::make_unique<std::recursive_mutex>()};
+
+  // memoized value along with its size and last use, for LRU eviction
+  template <typename T>
+  struct MemoEntry {
+    T value;
+    size_t bytes{0};
+    // memoTick_ when value was last returned
+    uint64_t lastUse{0};
+  };
+
+  // incremented on every memoization lookup
+  mutable uint64_t memoTick_{0};
+
   // memoization structure for getSpfResult()
   mutable std::unordered_map<
       std::pair<std::string /* nodeName */, bool /* useLinkMetric */>,
-      SpfResult>
+      MemoEntry<SpfResult>>
       spfResults_;
+  mutable size_t spfResultsBytes_{0};
 
  public:
   // Trace edge-disjoint paths from dest to src.
@@ -297,8 +548,13 @@ class LinkState {
   // memoization structure for getKthPaths()
   mutable std::unordered_map<
       std::tuple<std::string /* src */, std::string /* dest */, size_t /* k */>,
-      std::vector<LinkState::Path>>
+      MemoEntry<std::vector<LinkState::Path>>>
       kthPathResults_;
+  mutable size_t kthPathResultsBytes_{0};
+
+  // drop all memoized results
+  void clearSpfResults();
+  void clearKthPathResults();
 
  public:
   // non-const public methods
@@ -326,9 +582,10 @@ class LinkState {
 
   LinkStateChange decrementHolds();
 
-  // update adjacencies for the given router
+  // update adjacencies for the given router. Database is moved into link
+  // state, pass rvalue to avoid a copy
   LinkStateChange updateAdjacencyDatabase(
-      thrift::AdjacencyDatabase const& adjacencyDb,
+      thrift::AdjacencyDatabase adjacencyDb,
       LinkStateMetric holdUpTtl = 0,
       LinkStateMetric holdDownTtl = 0);
 
@@ -379,6 +636,13 @@ class LinkState {
     return linkMap_.size();
   }
 
+  // adjacencies of nodes with at least one link which don't form a link,
+  // i.e. which are not reported back by the other node
+  size_t
+  numPartialAdjacencies() const {
+    return numPartialAdjacencies_;
+  }
+
   // get adjacency databases
   std::unordered_map<
       std::string /* nodeName */,
@@ -415,8 +679,8 @@ class LinkState {
   // find one path from dest to src for a given SpfResult
   // ingnore links already in linksToIgnore
   std::optional<Path> traceOnePath(
-      std::string const& src,
-      std::string const& dest,
+      NodeId src,
+      NodeId dest,
       SpfResult const& result,
       LinkSet& linksToIgnore) const;
 
@@ -426,6 +690,13 @@ class LinkState {
 
   void removeNode(const std::string& nodeName);
 
+  // contribution of node to numPartialAdjacencies_. Callers subtract it
+  // before changing adjacencies or links of the node, and add it back after
+  int64_t getNodePartialAdjacencies(const std::string& nodeName) const;
+
+  // track the link in heldLinks_ if it has a hold, untrack it otherwise
+  void updateHeldLink(std::shared_ptr<Link> const& link);
+
   bool updateNodeOverloaded(
       const std::string& nodeName,
       bool isOverloaded,
@@ -439,7 +710,9 @@ class LinkState {
                              weights as advertised from the adjacent nodes,
                              otherwise it will consider the graph unweighted */
       const LinkSet& linksToIgnore =
-          {} /* optionaly specify a set of links to not use when running */)
+          {}, /* optionaly specify a set of links to not use when running */
+      std::optional<NodeId> stopAtNode =
+          std::nullopt /* if set, stop once paths to this node are found */)
       const;
 
   // returns Link object if the reverse adjancency is present in
@@ -447,11 +720,46 @@ class LinkState {
   std::shared_ptr<Link> maybeMakeLink(
       const std::string& nodeName, const thrift::Adjacency& adj) const;
 
-  std::vector<std::shared_ptr<Link>> getOrderedLinkSet(
-      const thrift::AdjacencyDatabase& adjDb) const;
-
-  std::vector<std::shared_ptr<Link>> orderedLinksFromNode(
-      const std::string& nodeName) const;
+  // Incremental SPF. Called after the metric or overload of link changed
+  // from nodeName's side; wasUp and oldMetric describe the link before the
+  // change. Every memoized SpfResult is repaired in place by recomputing only
+  // the part of its shortest path DAG affected by the change.
+  void repairSpfResults(
+      Link const& link,
+      const std::string& nodeName,
+      bool wasUp,
+      LinkStateMetric oldMetric) const;
+
+  // repair one SpfResult rooted at src, given the directed edges <from, to>
+  // of link whose cost either all increased (incl. going down) or all
+  // decreased (incl. coming up). returns the number of nodes recomputed
+  size_t repairSpfResult(
+      SpfResult& result,
+      NodeId src,
+      bool useLinkMetric,
+      Link const& link,
+      std::vector<std::pair<NodeId, NodeId>> const& changedEdges,
+      bool costIncreased) const;
+
+  // (re)build the CSR snapshot of the graph used by runSpf() if needed
+  void maybeBuildCsr() const;
+
+  // interning table for node names, shared with the SpfResults we hand out
+  std::shared_ptr<NodeIdTable> nodeIds_{std::make_shared<NodeIdTable>()};
+
+  // Compressed sparse row snapshot of the up links in the graph. Outgoing
+  // edges of node id are csrEdges_[csrOffsets_[id], csrOffsets_[id + 1]).
+  // It is rebuilt lazily on the next SPF run after any change of topology.
+  struct CsrEdge {
+    NodeId otherNode;
+    // metric from the source side of the edge
+    LinkStateMetric metric;
+    std::shared_ptr<Link> link;
+  };
+  mutable bool csrDirty_{true};
+  mutable std::vector<size_t> csrOffsets_;
+  mutable std::vector<CsrEdge> csrEdges_;
+  mutable std::vector<bool> csrNodeOverloaded_;
 
   // this stores the same link object accessible from either nodeName
   std::unordered_map<std::string /* nodeName */, LinkSet> linkMap_;
@@ -459,9 +767,18 @@ class LinkState {
   // useful for iterating over all the links
   LinkSet allLinks_;
 
+  // sum of getNodePartialAdjacencies() over all nodes
+  int64_t numPartialAdjacencies_{0};
+
   std::unordered_map<std::string /* nodeName */, HoldableValue<bool>>
       nodeOverloads_;
 
+  // links and nodes (overloads) with an active hold for ordered FIB
+  // programming, so that holds are decremented and checked without scanning
+  // the whole topology
+  LinkSet heldLinks_;
+  std::unordered_set<std::string /* nodeName */> heldNodes_;
+
   // the latest AdjacencyDatabase we've received from each node
   std::unordered_map<std::string, thrift::AdjacencyDatabase>
       adjacencyDatabases_;
@@ -474,64 +791,77 @@ class LinkState {
 // nexthops.
 class DijkstraQNode {
  public:
-  DijkstraQNode(const std::string& n, LinkStateMetric m)
-      : nodeName(n), result(m) {}
-  const std::string nodeName;
+  DijkstraQNode(LinkState::NodeId n, LinkStateMetric m)
+      : nodeId(n), result(m) {}
+  const LinkState::NodeId nodeId;
   LinkState::NodeSpfResult result;
 };
 
+// Indexed d-ary min-heap keyed on <metric, nodeName>. The heap only holds
+// indices into a flat node vector and a position map tracks where each node
+// sits in the heap, which gives us a true O(log n) decrease-key instead of
+// rebuilding the whole heap every time a strictly better path is found.
+//
+// Pointers returned by get() / extractMin() are only valid until the next
+// insertNode() call.
 class DijkstraQ {
- private:
-  std::vector<std::shared_ptr<DijkstraQNode>> heap_;
-  std::unordered_map<std::string, std::shared_ptr<DijkstraQNode>> nameToNode_;
+ public:
+  using NodeId = LinkState::NodeId;
 
-  struct {
-    bool
-    operator()(
-        std::shared_ptr<DijkstraQNode> a,
-        std::shared_ptr<DijkstraQNode> b) const {
-      if (a->result.metric() != b->result.metric()) {
-        return a->result.metric() > b->result.metric();
-      }
-      return a->nodeName > b->nodeName;
-    }
-  } DijkstraQNodeGreater;
+  // nodeIds is used to size the queue and to break metric ties on node name
+  explicit DijkstraQ(LinkState::NodeIdTable const& nodeIds);
 
- public:
-  void
-  insertNode(const std::string& nodeName, LinkStateMetric d) {
-    heap_.push_back(std::make_shared<DijkstraQNode>(nodeName, d));
-    nameToNode_[nodeName] = heap_.back();
-    std::push_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
-  }
+  // insert a new node into the queue. nodeId must not have been inserted
+  // before
+  DijkstraQNode& insertNode(NodeId nodeId, LinkStateMetric d);
 
-  std::shared_ptr<DijkstraQNode>
-  get(const std::string& nodeName) {
-    if (nameToNode_.count(nodeName)) {
-      return nameToNode_.at(nodeName);
-    }
-    return nullptr;
-  }
+  // returns the node if it is currently queued, nullptr otherwise
+  DijkstraQNode* get(NodeId nodeId);
 
-  std::shared_ptr<DijkstraQNode>
-  extractMin() {
-    if (heap_.empty()) {
-      return nullptr;
-    }
-    auto min = heap_.at(0);
-    CHECK(nameToNode_.erase(min->nodeName));
-    std::pop_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
-    heap_.pop_back();
-    return min;
+  // restore the heap property after the metric of a queued node was lowered,
+  // i.e. after node.result.reset() was called with a smaller metric
+  void decreaseKey(const DijkstraQNode& node);
+
+  // pop the node with the lowest metric, nullptr if the queue is empty
+  DijkstraQNode* extractMin();
+
+  bool
+  empty() const {
+    return heap_.empty();
   }
 
-  void
-  reMake() {
-    // this is a bit slow but is rarely called in our application. In fact,
-    // in networks where the metric is hop count, this will never be called
-    // and the Dijkstra run is no different than BFS
-    std::make_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
+  size_t
+  size() const {
+    return heap_.size();
   }
+
+ private:
+  // 4-ary heap trades a slightly more expensive sift-down for a shallower
+  // tree, which pays off since decrease-key (sift-up) dominates in SPF
+  static constexpr size_t kArity{4};
+  static constexpr uint32_t kNone{std::numeric_limits<uint32_t>::max()};
+  static constexpr size_t kNotInHeap{std::numeric_limits<size_t>::max()};
+
+  bool lessThan(uint32_t a, uint32_t b) const;
+
+  void siftUp(size_t pos);
+
+  void siftDown(size_t pos);
+
+  LinkState::NodeIdTable const& nodeIds_;
+
+  // storage of all nodes ever inserted, in insertion order
+  std::vector<DijkstraQNode> nodes_;
+
+  // NodeId => index in nodes_, kNone if never inserted
+  std::vector<uint32_t> index_;
+
+  // heapPos_[i] is the position of nodes_[i] in heap_, kNotInHeap once
+  // extracted
+  std::vector<size_t> heapPos_;
+
+  // the heap of indices into nodes_
+  std::vector<uint32_t> heap_;
 };
 } // namespace openr
 
@@ -7,8 +7,15 @@
 
 #include "openr/decision/PrefixState.h"
 
+#include <algorithm>
+#include <iterator>
+
+#include <fb303/ServiceData.h>
+
 #include <openr/common/Util.h>
 
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
 void
@@ -31,92 +38,260 @@ PrefixState::deleteLoopbackPrefix(
   }
 }
 
+std::optional<thrift::IpPrefix>
+PrefixState::withdrawPrefix(
+    IpPrefixKey const& key, std::string const& nodeName) {
+  auto prefixIt = prefixes_.find(key);
+  if (prefixIt == prefixes_.end()) {
+    return std::nullopt;
+  }
+  auto& nodeList = prefixIt->second;
+  auto nodePrefixIt = nodeList.find(nodeName);
+  if (nodePrefixIt == nodeList.end()) {
+    return std::nullopt;
+  }
+  // NOTE explicit copy, entry is erased below
+  auto prefix = nodePrefixIt->second.prefix;
+  VLOG(1) << "Prefix " << toString(prefix) << " has been withdrawn by "
+          << nodeName;
+  nodeList.erase(nodePrefixIt);
+  if (nodeList.empty()) {
+    prefixes_.erase(prefixIt);
+    prefixVersions_.erase(key);
+  } else {
+    prefixVersions_[key] = ++lastPrefixVersion_;
+  }
+  updateCompiledMetricVector(key, nodeName, nullptr);
+  deleteLoopbackPrefix(prefix, nodeName);
+  return prefix;
+}
+
+bool
+PrefixState::updatePrefixEntry(
+    IpPrefixKey const& key,
+    std::string const& nodeName,
+    thrift::PrefixEntry const& prefixEntry) {
+  auto& nodeList = prefixes_[key];
+  auto nodePrefixIt = nodeList.find(nodeName);
+
+  // Add or Update prefix
+  if (nodePrefixIt == nodeList.end()) {
+    VLOG(1) << "Prefix " << toString(prefixEntry.prefix)
+            << " has been advertised by node " << nodeName;
+    nodeList.emplace(nodeName, prefixEntry);
+  } else if (nodePrefixIt->second != prefixEntry) {
+    VLOG(1) << "Prefix " << toString(prefixEntry.prefix)
+            << " has been updated by node " << nodeName;
+    nodePrefixIt->second = prefixEntry;
+  } else {
+    // This prefix has no change. Skip rest of code!
+    return false;
+  }
+  prefixVersions_[key] = ++lastPrefixVersion_;
+  updateCompiledMetricVector(
+      key,
+      nodeName,
+      prefixEntry.mv_ref().has_value() ? &prefixEntry.mv_ref().value()
+                                       : nullptr);
+
+  // Keep track of loopback addresses (v4 / v6) for each node
+  if (thrift::PrefixType::LOOPBACK == prefixEntry.type) {
+    auto addrSize = prefixEntry.prefix.prefixAddress.addr.size();
+    if (addrSize == folly::IPAddressV4::byteCount() &&
+        folly::IPAddressV4::bitCount() == prefixEntry.prefix.prefixLength) {
+      nodeHostLoopbacksV4_[nodeName] = prefixEntry.prefix.prefixAddress;
+    }
+    if (addrSize == folly::IPAddressV6::byteCount() &&
+        folly::IPAddressV6::bitCount() == prefixEntry.prefix.prefixLength) {
+      nodeHostLoopbacksV6_[nodeName] = prefixEntry.prefix.prefixAddress;
+    }
+  }
+  return true;
+}
+
 std::unordered_set<thrift::IpPrefix>
 PrefixState::updatePrefixDatabase(thrift::PrefixDatabase const& prefixDb) {
   std::unordered_set<thrift::IpPrefix> changed;
 
   auto const& nodeName = prefixDb.thisNodeName;
+  ++nodeVersions_[nodeName];
 
-  // Get old and new set of prefixes - NOTE explicit copy
-  const std::set<thrift::IpPrefix> oldPrefixSet = nodeToPrefixes_[nodeName];
-
-  // update the entry
-  auto& newPrefixSet = nodeToPrefixes_[nodeName];
-  newPrefixSet.clear();
+  // Get new set of prefixes
+  std::set<IpPrefixKey> newPrefixSet;
   for (const auto& prefixEntry : prefixDb.prefixEntries) {
     newPrefixSet.emplace(prefixEntry.prefix);
   }
 
+  // keep lowest prefixes of the node within the limit
+  size_t numRejected{0};
+  if (maxPrefixesPerNode_ and newPrefixSet.size() > maxPrefixesPerNode_) {
+    numRejected = newPrefixSet.size() - maxPrefixesPerNode_;
+    newPrefixSet.erase(
+        std::next(newPrefixSet.begin(), maxPrefixesPerNode_),
+        newPrefixSet.end());
+    LOG(WARNING) << "Ignoring " << numRejected << " prefixes of node "
+                 << nodeName << " over limit of " << maxPrefixesPerNode_;
+    fb303::fbData->addStatValue(
+        "decision.rejected_prefixes", numRejected, fb303::SUM);
+  }
+
+  // update the entry
+  auto& prefixSet = nodeToPrefixes_[nodeName];
+  std::vector<IpPrefixKey> withdrawnPrefixes;
+  std::set_difference(
+      prefixSet.begin(),
+      prefixSet.end(),
+      newPrefixSet.begin(),
+      newPrefixSet.end(),
+      std::back_inserter(withdrawnPrefixes));
+  prefixSet = std::move(newPrefixSet);
+
   // Remove old prefixes first
-  for (const auto& prefix : oldPrefixSet) {
-    if (newPrefixSet.count(prefix)) {
-      continue;
-    }
-    VLOG(1) << "Prefix " << toString(prefix) << " has been withdrawn by "
-            << nodeName;
-    auto& nodeList = prefixes_.at(prefix);
-    nodeList.erase(nodeName);
-    changed.insert(prefix);
-    if (nodeList.empty()) {
-      prefixes_.erase(prefix);
+  for (const auto& key : withdrawnPrefixes) {
+    if (auto prefix = withdrawPrefix(key, nodeName)) {
+      changed.insert(std::move(*prefix));
     }
-    deleteLoopbackPrefix(prefix, nodeName);
   }
   for (const auto& prefixEntry : prefixDb.prefixEntries) {
-    auto& nodeList = prefixes_[prefixEntry.prefix];
-    auto nodePrefixIt = nodeList.find(nodeName);
-
-    // Add or Update prefix
-    if (nodePrefixIt == nodeList.end()) {
-      VLOG(1) << "Prefix " << toString(prefixEntry.prefix)
-              << " has been advertised by node " << nodeName;
-      nodeList.emplace(nodeName, prefixEntry);
-      changed.insert(prefixEntry.prefix);
-    } else if (nodePrefixIt->second != prefixEntry) {
-      VLOG(1) << "Prefix " << toString(prefixEntry.prefix)
-              << " has been updated by node " << nodeName;
-      nodeList[nodeName] = prefixEntry;
-      changed.insert(prefixEntry.prefix);
-    } else {
-      // This prefix has no change. Skip rest of code!
+    const IpPrefixKey key(prefixEntry.prefix);
+    if (numRejected and not prefixSet.count(key)) {
       continue;
     }
+    if (updatePrefixEntry(key, nodeName, prefixEntry)) {
+      changed.insert(prefixEntry.prefix);
+    }
+  }
+
+  if (prefixSet.empty()) {
+    nodeToPrefixes_.erase(nodeName);
+  }
+
+  return changed;
+}
 
-    // Keep track of loopback addresses (v4 / v6) for each node
-    if (thrift::PrefixType::LOOPBACK == prefixEntry.type) {
-      auto addrSize = prefixEntry.prefix.prefixAddress.addr.size();
-      if (addrSize == folly::IPAddressV4::byteCount() &&
-          folly::IPAddressV4::bitCount() == prefixEntry.prefix.prefixLength) {
-        nodeHostLoopbacksV4_[nodeName] = prefixEntry.prefix.prefixAddress;
-      }
-      if (addrSize == folly::IPAddressV6::byteCount() &&
-          folly::IPAddressV6::bitCount() == prefixEntry.prefix.prefixLength) {
-        nodeHostLoopbacksV6_[nodeName] = prefixEntry.prefix.prefixAddress;
-      }
+std::optional<std::unordered_set<thrift::IpPrefix>>
+PrefixState::updatePrefixDatabaseDelta(PrefixDatabaseDelta const& delta) {
+  auto const& nodeName = delta.thisNodeName;
+  auto& version = nodeVersions_[nodeName];
+  if (delta.baseVersion != version) {
+    VLOG(1) << "Prefix database delta of node " << nodeName << " is based on "
+            << "version " << delta.baseVersion << " instead of " << version;
+    return std::nullopt;
+  }
+  ++version;
+
+  std::unordered_set<thrift::IpPrefix> changed;
+  auto& prefixSet = nodeToPrefixes_[nodeName];
+  for (const auto& prefix : delta.prefixesToWithdraw) {
+    const IpPrefixKey key(prefix);
+    if (not prefixSet.erase(key)) {
+      continue;
+    }
+    if (auto withdrawn = withdrawPrefix(key, nodeName)) {
+      changed.insert(std::move(*withdrawn));
     }
   }
+  size_t numRejected{0};
+  for (const auto& prefixEntry : delta.prefixEntriesToUpdate) {
+    const IpPrefixKey key(prefixEntry.prefix);
+    if (maxPrefixesPerNode_ and prefixSet.size() >= maxPrefixesPerNode_ and
+        not prefixSet.count(key)) {
+      ++numRejected;
+      continue;
+    }
+    prefixSet.emplace(key);
+    if (updatePrefixEntry(key, nodeName, prefixEntry)) {
+      changed.insert(prefixEntry.prefix);
+    }
+  }
+  if (numRejected) {
+    LOG(WARNING) << "Ignoring " << numRejected << " prefixes of node "
+                 << nodeName << " over limit of " << maxPrefixesPerNode_;
+    fb303::fbData->addStatValue(
+        "decision.rejected_prefixes", numRejected, fb303::SUM);
+  }
 
-  if (newPrefixSet.empty()) {
+  if (prefixSet.empty()) {
     nodeToPrefixes_.erase(nodeName);
   }
 
   return changed;
 }
 
+std::unordered_set<thrift::IpPrefix>
+PrefixState::deleteNode(std::string const& nodeName) {
+  std::unordered_set<thrift::IpPrefix> changed;
+  auto it = nodeToPrefixes_.find(nodeName);
+  if (it == nodeToPrefixes_.end()) {
+    return changed;
+  }
+  ++nodeVersions_[nodeName];
+  changed.reserve(it->second.size());
+  for (auto const& key : it->second) {
+    if (auto prefix = withdrawPrefix(key, nodeName)) {
+      changed.insert(std::move(*prefix));
+    }
+  }
+  nodeToPrefixes_.erase(it);
+  return changed;
+}
+
+uint64_t
+PrefixState::getNodeVersion(std::string const& nodeName) const {
+  auto it = nodeVersions_.find(nodeName);
+  return it == nodeVersions_.end() ? 0 : it->second;
+}
+
+uint64_t
+PrefixState::getPrefixVersion(thrift::IpPrefix const& prefix) const {
+  auto it = prefixVersions_.find(IpPrefixKey(prefix));
+  return it == prefixVersions_.end() ? 0 : it->second;
+}
+
 std::unordered_map<std::string /* nodeName */, thrift::PrefixDatabase>
 PrefixState::getPrefixDatabases() const {
   std::unordered_map<std::string, thrift::PrefixDatabase> prefixDatabases;
   for (auto const& kv : nodeToPrefixes_) {
     thrift::PrefixDatabase prefixDb;
     prefixDb.thisNodeName = kv.first;
-    for (auto const& prefix : kv.second) {
-      prefixDb.prefixEntries.emplace_back(prefixes_.at(prefix).at(kv.first));
+    for (auto const& key : kv.second) {
+      prefixDb.prefixEntries.emplace_back(prefixes_.at(key).at(kv.first));
     }
     prefixDatabases.emplace(kv.first, std::move(prefixDb));
   }
   return prefixDatabases;
 }
 
+void
+PrefixState::updateCompiledMetricVector(
+    IpPrefixKey const& prefix,
+    std::string const& nodeName,
+    thrift::MetricVector const* mv) {
+  if (mv) {
+    compiledMetricVectors_[prefix][nodeName] =
+        MetricVectorUtils::compileMetricVector(*mv);
+    return;
+  }
+  auto it = compiledMetricVectors_.find(prefix);
+  if (it != compiledMetricVectors_.end()) {
+    it->second.erase(nodeName);
+    if (it->second.empty()) {
+      compiledMetricVectors_.erase(it);
+    }
+  }
+}
+
+MetricVectorUtils::CompiledMetricVector const*
+PrefixState::getCompiledMetricVector(
+    thrift::IpPrefix const& prefix, std::string const& nodeName) const {
+  auto it = compiledMetricVectors_.find(IpPrefixKey(prefix));
+  if (it == compiledMetricVectors_.end()) {
+    return nullptr;
+  }
+  auto nodeIt = it->second.find(nodeName);
+  return nodeIt == it->second.end() ? nullptr : &nodeIt->second;
+}
+
 std::vector<thrift::NextHopThrift>
 PrefixState::getLoopbackVias(
     std::unordered_set<std::string> const& nodes,
@@ -7,36 +7,96 @@
 
 #pragma once
 
+#include <optional>
 #include <set>
 #include <unordered_map>
 #include <vector>
 
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 
 namespace openr {
 class PrefixState {
  public:
-  std::unordered_map<
-      thrift::IpPrefix,
-      std::unordered_map<std::string, thrift::PrefixEntry>> const&
+  // maxPrefixesPerNode: max number of prefixes accepted from a single node,
+  // so that a misbehaving node can't exhaust memory. 0 for unlimited
+  explicit PrefixState(size_t maxPrefixesPerNode = 0)
+      : maxPrefixesPerNode_(maxPrefixesPerNode) {}
+
+  // entries of a prefix, keyed by name of the node announcing it
+  using PrefixEntries = std::unordered_map<std::string, thrift::PrefixEntry>;
+
+  // entries of each prefix in the network. Prefixes are never left without
+  // any entry
+  std::unordered_map<IpPrefixKey, PrefixEntries> const&
   prefixes() const {
     return prefixes_;
   }
 
+  // thrift prefix of entries of a prefix in prefixes()
+  static thrift::IpPrefix const&
+  getPrefix(PrefixEntries const& entries) {
+    return entries.begin()->second.prefix;
+  }
+
+  // prefixes announced by each node
+  std::unordered_map<std::string, std::set<IpPrefixKey>> const&
+  nodeToPrefixes() const {
+    return nodeToPrefixes_;
+  }
+
+  // Change of prefix entries announced by a node, over given version of them
+  struct PrefixDatabaseDelta {
+    std::string thisNodeName;
+    // version of the node's entries, see getNodeVersion(), delta is based on
+    uint64_t baseVersion{0};
+    // entries advertised or updated by the node
+    std::vector<thrift::PrefixEntry> prefixEntriesToUpdate;
+    // prefixes withdrawn by the node
+    std::vector<thrift::IpPrefix> prefixesToWithdraw;
+  };
+
   // update loopback prefix deletes
   void deleteLoopbackPrefix(
       thrift::IpPrefix const& prefix, const std::string& nodename);
 
   // returns set of changed prefixes (i.e. a node started advertising or
-  // withdrew or any attributes changed)
+  // withdrew or any attributes changed). Beyond maxPrefixesPerNode, highest
+  // prefixes of the node are ignored
   std::unordered_set<thrift::IpPrefix> updatePrefixDatabase(
       thrift::PrefixDatabase const& prefixDb);
 
+  // apply delta in O(size of delta) and return set of changed prefixes.
+  // Returns std::nullopt without applying anything if delta is not based on
+  // current version of the node's entries; caller must then replace them
+  // with its full prefix database. Prefixes new to the node are ignored once
+  // it has maxPrefixesPerNode of them
+  std::optional<std::unordered_set<thrift::IpPrefix>>
+  updatePrefixDatabaseDelta(PrefixDatabaseDelta const& delta);
+
+  // withdraw all entries of the node in O(number of them), e.g. once all of
+  // its keys expired. Returns set of changed prefixes
+  std::unordered_set<thrift::IpPrefix> deleteNode(std::string const& nodeName);
+
+  // version of the node's entries, bumped on every update of them. Starts at
+  // 0 and never goes back, even when the node withdraws all of its prefixes
+  uint64_t getNodeVersion(std::string const& nodeName) const;
+
+  // version of the entries of a prefix, bumped whenever a node starts or
+  // stops announcing it or updates its entry. Versions are unique across
+  // prefixes and never reused, 0 if the prefix isn't announced
+  uint64_t getPrefixVersion(thrift::IpPrefix const& prefix) const;
+
   std::unordered_map<std::string /* nodeName */, thrift::PrefixDatabase>
   getPrefixDatabases() const;
 
+  // metric vector of the prefix entry announced by node, compiled when the
+  // entry was updated. nullptr if the entry has no metric vector
+  MetricVectorUtils::CompiledMetricVector const* getCompiledMetricVector(
+      thrift::IpPrefix const& prefix, std::string const& nodeName) const;
+
   std::vector<thrift::NextHopThrift> getLoopbackVias(
       std::unordered_set<std::string> const& nodes,
       bool const isV4,
@@ -53,12 +113,39 @@ class PrefixState {
   }
 
  private:
-  // For each prefix in the network, stores a set of nodes that advertise it
+  // compile mv of prefix entry announced by node, or forget it if nullptr
+  void updateCompiledMetricVector(
+      IpPrefixKey const& prefix,
+      std::string const& nodeName,
+      thrift::MetricVector const* mv);
+
+  // withdraw entry of node for prefix. Returns withdrawn prefix, if any
+  std::optional<thrift::IpPrefix> withdrawPrefix(
+      IpPrefixKey const& key, std::string const& nodeName);
+
+  // add or update entry of node for prefix. Returns true if it changed
+  bool updatePrefixEntry(
+      IpPrefixKey const& key,
+      std::string const& nodeName,
+      thrift::PrefixEntry const& prefixEntry);
+
+  // see PrefixState()
+  const size_t maxPrefixesPerNode_{0};
+
+  // For each prefix in the network, stores a set of nodes that advertise it.
+  // Keyed by IpPrefixKey, which is hashed and copied without allocating
+  std::unordered_map<IpPrefixKey, PrefixEntries> prefixes_;
+  std::unordered_map<std::string, std::set<IpPrefixKey>> nodeToPrefixes_;
+  // version of entries of each node which ever announced a prefix
+  std::unordered_map<std::string, uint64_t> nodeVersions_;
+  // version of entries of each prefix in prefixes_, see getPrefixVersion()
+  std::unordered_map<IpPrefixKey, uint64_t> prefixVersions_;
+  uint64_t lastPrefixVersion_{0};
+  // compiled metric vectors of prefix entries in prefixes_ which have one
   std::unordered_map<
-      thrift::IpPrefix,
-      std::unordered_map<std::string, thrift::PrefixEntry>>
-      prefixes_;
-  std::unordered_map<std::string, std::set<thrift::IpPrefix>> nodeToPrefixes_;
+      IpPrefixKey,
+      std::unordered_map<std::string, MetricVectorUtils::CompiledMetricVector>>
+      compiledMetricVectors_;
   std::unordered_map<std::string, thrift::BinaryAddress> nodeHostLoopbacksV4_;
   std::unordered_map<std::string, thrift::BinaryAddress> nodeHostLoopbacksV6_;
 }; // class PrefixState
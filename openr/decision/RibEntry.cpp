@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "openr/decision/RibEntry.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace openr {
+
+//
+// NextHopTable
+//
+
+NextHopTable&
+NextHopTable::get() {
+  // never destroyed, RIB entries may outlive static destruction order
+  static auto* table = new NextHopTable();
+  return *table;
+}
+
+NextHopTable::Id
+NextHopTable::acquire(thrift::NextHopThrift const& nexthop) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(nexthop);
+  if (it != ids_.end()) {
+    ++ownedChunks_[it->second >> kChunkBits][it->second & (kChunkSize - 1)]
+          .refCount;
+    return it->second;
+  }
+
+  Id id;
+  if (not freeIds_.empty()) {
+    id = freeIds_.back();
+    freeIds_.pop_back();
+  } else {
+    CHECK_LT(nextId_, kChunkSize * kMaxChunks) << "Too many nexthops";
+    id = nextId_++;
+    if ((id >> kChunkBits) == ownedChunks_.size()) {
+      ownedChunks_.emplace_back(std::make_unique<Slot[]>(kChunkSize));
+      chunks_[id >> kChunkBits].store(
+          ownedChunks_.back().get(), std::memory_order_release);
+    }
+  }
+  auto& slot = ownedChunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+  slot.nexthop = nexthop;
+  slot.refCount = 1;
+  ids_.emplace(nexthop, id);
+  return id;
+}
+
+void
+NextHopTable::addRefs(folly::Range<Id const*> ids) {
+  if (ids.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto id : ids) {
+    ++ownedChunks_[id >> kChunkBits][id & (kChunkSize - 1)].refCount;
+  }
+}
+
+void
+NextHopTable::release(folly::Range<Id const*> ids) {
+  if (ids.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto id : ids) {
+    auto& slot = ownedChunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+    CHECK_GT(slot.refCount, 0);
+    if (--slot.refCount == 0) {
+      ids_.erase(slot.nexthop);
+      freeIds_.emplace_back(id);
+    }
+  }
+}
+
+size_t
+NextHopTable::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ids_.size();
+}
+
+//
+// NextHopSet
+//
+
+NextHopSet::NextHopSet(std::initializer_list<thrift::NextHopThrift> nexthops) {
+  for (auto const& nexthop : nexthops) {
+    emplace(nexthop);
+  }
+}
+
+NextHopSet::NextHopSet(NextHopSet const& other) : ids_(other.ids_) {
+  NextHopTable::get().addRefs(folly::range(ids_));
+}
+
+NextHopSet::NextHopSet(NextHopSet&& other) noexcept
+    : ids_(std::move(other.ids_)) {
+  other.ids_.clear();
+}
+
+NextHopSet&
+NextHopSet::operator=(NextHopSet const& other) {
+  if (this != &other) {
+    // take the new references first, other may share ids with us
+    NextHopTable::get().addRefs(folly::range(other.ids_));
+    clear();
+    ids_ = other.ids_;
+  }
+  return *this;
+}
+
+NextHopSet&
+NextHopSet::operator=(NextHopSet&& other) noexcept {
+  if (this != &other) {
+    clear();
+    ids_ = std::move(other.ids_);
+    other.ids_.clear();
+  }
+  return *this;
+}
+
+NextHopSet::~NextHopSet() {
+  clear();
+}
+
+std::pair<NextHopSet::const_iterator, bool>
+NextHopSet::emplace(thrift::NextHopThrift const& nexthop) {
+  auto& table = NextHopTable::get();
+  auto const id = table.acquire(nexthop);
+  auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+  if (it != ids_.end() and *it == id) {
+    // drop the extra reference taken above
+    table.release(folly::range(&id, &id + 1));
+    return {const_iterator(it), false};
+  }
+  it = ids_.insert(it, id);
+  return {const_iterator(it), true};
+}
+
+void
+NextHopSet::clear() {
+  NextHopTable::get().release(folly::range(ids_));
+  ids_.clear();
+}
+
+std::vector<thrift::NextHopThrift>
+NextHopSet::toThrift() const {
+  return std::vector<thrift::NextHopThrift>(begin(), end());
+}
+
+} // namespace openr
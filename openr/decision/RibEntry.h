@@ -7,22 +7,197 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include <folly/IPAddress.h>
+#include <folly/Range.h>
+#include <folly/hash/Hash.h>
+#include <folly/small_vector.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 
 namespace openr {
 
+/**
+ * Process wide table interning the nexthops of all RIB entries. Routes only
+ * keep the ids of their nexthops, so that the many routes sharing the same
+ * nexthops don't each carry a copy of them. Ids are reference counted and
+ * recycled once no route refers to them anymore. Thread safe.
+ */
+class NextHopTable {
+ public:
+  using Id = uint32_t;
+
+  static NextHopTable& get();
+
+  // id of the nexthop, interning it if needed. Takes a reference on the id
+  Id acquire(thrift::NextHopThrift const& nexthop);
+
+  // take or drop one reference on each of the ids
+  void addRefs(folly::Range<Id const*> ids);
+  void release(folly::Range<Id const*> ids);
+
+  // nexthop of an id. Valid for as long as a reference on the id is held
+  thrift::NextHopThrift const&
+  at(Id id) const {
+    auto const* chunk =
+        chunks_[id >> kChunkBits].load(std::memory_order_acquire);
+    return chunk[id & (kChunkSize - 1)].nexthop;
+  }
+
+  // number of interned nexthops
+  size_t size() const;
+
+ private:
+  struct Slot {
+    thrift::NextHopThrift nexthop;
+    uint32_t refCount{0};
+  };
+
+  // slots are allocated in chunks which never move, so that `at()` can hand
+  // out references without holding the lock
+  static constexpr size_t kChunkBits{10};
+  static constexpr size_t kChunkSize{1 << kChunkBits};
+  static constexpr size_t kMaxChunks{1 << 14};
+
+  mutable std::mutex mutex_;
+  std::unordered_map<thrift::NextHopThrift, Id> ids_;
+  std::vector<Id> freeIds_;
+  Id nextId_{0};
+  std::vector<std::unique_ptr<Slot[]>> ownedChunks_;
+  std::array<std::atomic<Slot const*>, kMaxChunks> chunks_{};
+};
+
+/**
+ * Set of nexthops of a RIB entry, stored as a sorted vector of interned
+ * nexthop ids. ECMP groups of up to 16 nexthops are kept inline. Iteration
+ * yields the thrift nexthops.
+ */
+class NextHopSet {
+ public:
+  static constexpr size_t kInlineIds{16};
+  using Ids = folly::small_vector<NextHopTable::Id, kInlineIds>;
+  using value_type = thrift::NextHopThrift;
+  using size_type = size_t;
+  using reference = value_type const&;
+  using const_reference = value_type const&;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = thrift::NextHopThrift;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+
+    const_iterator() = default;
+    explicit const_iterator(Ids::const_iterator it) : it_(it) {}
+
+    reference
+    operator*() const {
+      return NextHopTable::get().at(*it_);
+    }
+    pointer
+    operator->() const {
+      return &NextHopTable::get().at(*it_);
+    }
+    const_iterator&
+    operator++() {
+      ++it_;
+      return *this;
+    }
+    const_iterator
+    operator++(int) {
+      auto it = *this;
+      ++it_;
+      return it;
+    }
+    bool
+    operator==(const_iterator const& other) const {
+      return it_ == other.it_;
+    }
+    bool
+    operator!=(const_iterator const& other) const {
+      return it_ != other.it_;
+    }
+
+   private:
+    Ids::const_iterator it_{};
+  };
+  using iterator = const_iterator;
+
+  NextHopSet() = default;
+  NextHopSet(std::initializer_list<thrift::NextHopThrift> nexthops);
+
+  template <typename Iterator>
+  NextHopSet(Iterator first, Iterator last) {
+    for (; first != last; ++first) {
+      emplace(*first);
+    }
+  }
+
+  NextHopSet(NextHopSet const& other);
+  NextHopSet(NextHopSet&& other) noexcept;
+  NextHopSet& operator=(NextHopSet const& other);
+  NextHopSet& operator=(NextHopSet&& other) noexcept;
+  ~NextHopSet();
+
+  // insert a nexthop, returns false if it was already in the set
+  std::pair<const_iterator, bool> emplace(thrift::NextHopThrift const& nexthop);
+
+  void clear();
+
+  const_iterator
+  begin() const {
+    return const_iterator(ids_.begin());
+  }
+  const_iterator
+  end() const {
+    return const_iterator(ids_.end());
+  }
+  size_t
+  size() const {
+    return ids_.size();
+  }
+  bool
+  empty() const {
+    return ids_.empty();
+  }
+  Ids const&
+  ids() const {
+    return ids_;
+  }
+
+  // equal nexthops always share their id, so comparing ids is enough
+  bool
+  operator==(NextHopSet const& other) const {
+    return ids_ == other.ids_;
+  }
+  bool
+  operator!=(NextHopSet const& other) const {
+    return ids_ != other.ids_;
+  }
+
+  // thrift nexthops, for handing routes out of Decision
+  std::vector<thrift::NextHopThrift> toThrift() const;
+
+ private:
+  Ids ids_;
+};
+
 struct RibEntry {
-  std::unordered_set<thrift::NextHopThrift> nexthops;
+  NextHopSet nexthops;
 
   // constructor
-  explicit RibEntry(std::unordered_set<thrift::NextHopThrift> nexthops)
+  explicit RibEntry(NextHopSet nexthops)
       : nexthops(std::move(nexthops)) {}
 
   RibEntry() = default;
@@ -44,14 +219,12 @@ struct RibUnicastEntry : RibEntry {
   // constructor
   explicit RibUnicastEntry(const folly::CIDRNetwork& prefix) : prefix(prefix) {}
 
-  RibUnicastEntry(
-      const folly::CIDRNetwork& prefix,
-      std::unordered_set<thrift::NextHopThrift> nexthops)
+  RibUnicastEntry(const folly::CIDRNetwork& prefix, NextHopSet nexthops)
       : RibEntry(std::move(nexthops)), prefix(prefix) {}
 
   RibUnicastEntry(
       const folly::CIDRNetwork& prefix,
-      std::unordered_set<thrift::NextHopThrift> nexthops,
+      NextHopSet nexthops,
       thrift::PrefixEntry bestPrefixEntry,
       bool doNotInstall,
       thrift::NextHopThrift bestNexthop)
@@ -72,8 +245,7 @@ struct RibUnicastEntry : RibEntry {
   toTUnicastRoute() const {
     thrift::UnicastRoute tUnicast;
     tUnicast.dest = toIpPrefix(prefix);
-    tUnicast.nextHops =
-        std::vector<thrift::NextHopThrift>(nexthops.begin(), nexthops.end());
+    tUnicast.nextHops = nexthops.toThrift();
     tUnicast.doNotInstall = doNotInstall;
     if (bestPrefixEntry.type == thrift::PrefixType::BGP) {
       tUnicast.prefixType_ref() = thrift::PrefixType::BGP;
@@ -90,8 +262,7 @@ struct RibMplsEntry : RibEntry {
   explicit RibMplsEntry(int32_t label) : label(label) {}
 
   // constructor
-  RibMplsEntry(
-      int32_t label, std::unordered_set<thrift::NextHopThrift> nexthops)
+  RibMplsEntry(int32_t label, NextHopSet nexthops)
       : RibEntry(std::move(nexthops)), label(label) {}
 
   bool
@@ -103,9 +274,21 @@ struct RibMplsEntry : RibEntry {
   toTMplsRoute() const {
     thrift::MplsRoute tMpls;
     tMpls.topLabel = label;
-    tMpls.nextHops =
-        std::vector<thrift::NextHopThrift>(nexthops.begin(), nexthops.end());
+    tMpls.nextHops = nexthops.toThrift();
     return tMpls;
   }
 };
 } // namespace openr
+
+namespace std {
+
+template <>
+struct hash<openr::NextHopSet> {
+  size_t
+  operator()(openr::NextHopSet const& nexthops) const {
+    return folly::hash::hash_range(
+        nexthops.ids().begin(), nexthops.ids().end());
+  }
+};
+
+} // namespace std
@@ -59,11 +59,16 @@ RibPolicyStatement::applyAction(RibUnicastEntry& route) const {
   if (not match(route)) {
     return false;
   }
+  transform(route);
+  return true;
+}
 
+void
+RibPolicyStatement::transform(RibUnicastEntry& route) const {
   // Iterate over all next-hops. NOTE that we iterate over rvalue
   CHECK(action_.set_weight_ref().has_value());
   auto const& weightAction = action_.set_weight_ref().value();
-  std::unordered_set<thrift::NextHopThrift> newNexthops;
+  NextHopSet newNexthops;
   for (auto& nh : route.nexthops) {
     auto new_weight = weightAction.default_weight;
     if (nh.area_ref()) {
@@ -80,8 +85,6 @@ RibPolicyStatement::applyAction(RibUnicastEntry& route) const {
     // We skip the next-hop with weight=0
   }
   route.nexthops = std::move(newNexthops);
-
-  return true;
 }
 
 //
@@ -102,6 +105,15 @@ RibPolicy::RibPolicy(thrift::RibPolicy const& policy)
   for (auto const& statement : policy.statements) {
     policyStatements_.emplace_back(RibPolicyStatement(statement));
   }
+
+  // Compile statements into index. Earlier statement takes precedence
+  for (size_t i = 0; i < policyStatements_.size(); ++i) {
+    for (auto const& prefix : policyStatements_.at(i).getPrefixes()) {
+      if (not statementIndex_.get(prefix)) {
+        statementIndex_.insert(prefix, i);
+      }
+    }
+  }
 }
 
 thrift::RibPolicy
@@ -132,24 +144,57 @@ RibPolicy::isActive() const {
   return getTtlDuration().count() > 0;
 }
 
+RibPolicyStatement const*
+RibPolicy::findStatement(const folly::CIDRNetwork& prefix) const {
+  auto index = statementIndex_.get(prefix);
+  return index ? &policyStatements_.at(*index) : nullptr;
+}
+
+RibPolicyStatement const*
+RibPolicy::findStatement(const RibUnicastEntry& route) const {
+  return findStatement(route.prefix);
+}
+
 bool
 RibPolicy::match(const RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.match(route)) {
-      return true;
-    }
-  }
-  return false;
+  return findStatement(route) != nullptr;
 }
 
 bool
 RibPolicy::applyAction(RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.applyAction(route)) {
-      return true;
-    }
+  auto statement = findStatement(route);
+  if (not statement) {
+    return false;
   }
-  return false;
+  statement->transform(route);
+  return true;
+}
+
+std::unordered_set<folly::CIDRNetwork>
+RibPolicy::getChangedPrefixes(
+    RibPolicy const* oldPolicy, RibPolicy const* newPolicy) {
+  std::unordered_set<folly::CIDRNetwork> prefixes;
+  auto addChangedPrefixes = [&prefixes](
+                                RibPolicy const* policy,
+                                RibPolicy const* otherPolicy) {
+    if (not policy) {
+      return;
+    }
+    for (auto const& statement : policy->policyStatements_) {
+      for (auto const& prefix : statement.getPrefixes()) {
+        auto const* otherStatement =
+            otherPolicy ? otherPolicy->findStatement(prefix) : nullptr;
+        if (not otherStatement or
+            not(otherStatement->getAction() ==
+                policy->findStatement(prefix)->getAction())) {
+          prefixes.emplace(prefix);
+        }
+      }
+    }
+  };
+  addChangedPrefixes(oldPolicy, newPolicy);
+  addChangedPrefixes(newPolicy, oldPolicy);
+  return prefixes;
 }
 
 } // namespace openr
@@ -8,6 +8,7 @@
 #include <chrono>
 
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/decision/RibEntry.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 #include <openr/if/gen-cpp2/OpenrCtrl_types.h>
@@ -42,6 +43,22 @@ class RibPolicyStatement {
    */
   bool applyAction(RibUnicastEntry& route) const;
 
+  /**
+   * Transform route irrespective of match criteria. Used by RibPolicy which
+   * already resolved the matching statement of the route.
+   */
+  void transform(RibUnicastEntry& route) const;
+
+  const std::unordered_set<folly::CIDRNetwork>&
+  getPrefixes() const {
+    return prefixSet_;
+  }
+
+  const thrift::RibRouteAction&
+  getAction() const {
+    return action_;
+  }
+
  private:
   const std::string name_;
 
@@ -93,10 +110,30 @@ class RibPolicy {
    */
   bool applyAction(RibUnicastEntry& route) const;
 
+  /**
+   * Prefixes whose routes may be transformed differently by the two policies,
+   * i.e. matched by only one of them or by statements of different actions.
+   * nullptr stands for no policy.
+   */
+  static std::unordered_set<folly::CIDRNetwork> getChangedPrefixes(
+      RibPolicy const* oldPolicy, RibPolicy const* newPolicy);
+
  private:
+  // First statement matching the prefix, nullptr if none
+  RibPolicyStatement const* findStatement(
+      const folly::CIDRNetwork& prefix) const;
+
+  // First statement matching the route, nullptr if none
+  RibPolicyStatement const* findStatement(const RibUnicastEntry& route) const;
+
   // List of policy statements
   std::vector<RibPolicyStatement> policyStatements_;
 
+  // Compiled matcher. Prefix -> index of the first statement matching it,
+  // so that route is matched with a single lookup irrespective of the number
+  // of statements
+  PrefixTrie<size_t> statementIndex_;
+
   // Validity
   const std::chrono::steady_clock::time_point validUntilTs_;
 };
@@ -18,6 +18,8 @@
 #include <openr/common/Util.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/decision/Decision.h>
+#include <openr/decision/RibPolicy.h>
+#include <openr/kvstore/KvStoreRecording.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 #include <thrift/lib/cpp2/Thrift.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -46,6 +48,34 @@
     name(counters, iters, ##__VA_ARGS__);                              \
   }
 
+/*
+ * Like BENCHMARK_COUNTERS_PARAM(), but builds the topology with non-uniform
+ * link metrics so that SPF has to do real decrease-key work.
+ */
+#define BENCHMARK_COUNTERS_PARAM_METRIC(name, counters, size, forwarding) \
+  BENCHMARK_COUNTERS_NAME_PARAM(                                          \
+      name,                                                               \
+      counters,                                                           \
+      FB_CONCATENATE(FB_CONCATENATE(size, forwarding), _METRIC),          \
+      size,                                                               \
+      forwarding,                                                         \
+      true)
+
+DEFINE_string(
+    decision_replay_recording,
+    "",
+    "KvStore recording (made by openr_kvstore_snooper) to replay into "
+    "Decision with BM_DecisionReplay");
+DEFINE_string(
+    decision_replay_node,
+    "",
+    "Node of the recording Decision computes routes of in BM_DecisionReplay");
+DEFINE_double(
+    decision_replay_speed,
+    0,
+    "Replay speed relative to the recorded one, 0 to replay as fast as "
+    "possible");
+
 namespace {
 // We have 24 SSWs per plane as of now and moving towards 36 per plane.
 const int kNumOfSswsPerPlane = 36;
@@ -54,6 +84,10 @@ const int kNumOfRswsPerPod = 48;
 const uint8_t kSswMarker = 1;
 const uint8_t kFswMarker = 2;
 const uint8_t kRswMarker = 3;
+// Upper bound of link metric when running with non-uniform metrics
+const int32_t kMaxLinkMetric = 100;
+// Max time to wait for route rebuild of the last replayed publication
+const std::chrono::seconds kReplaySettleTimeout{10};
 
 } // namespace
 
@@ -68,8 +102,10 @@ using apache::thrift::FRAGILE;
 //
 class DecisionWrapper {
  public:
-  explicit DecisionWrapper(const std::string& nodeName) {
+  explicit DecisionWrapper(
+      const std::string& nodeName, int32_t routeBuildThreads = 0) {
     auto tConfig = getBasicOpenrConfig(nodeName);
+    tConfig.decision_route_build_threads_ref() = routeBuildThreads;
     config = std::make_shared<Config>(tConfig);
 
     decision = std::make_shared<Decision>(
@@ -81,6 +117,7 @@ class DecisionWrapper {
         kvStoreUpdatesQueue.getReader(),
         staticRoutesUpdateQueue.getReader(),
         routeUpdatesQueue,
+        decisionDbsUpdatesQueue,
         zeromqContext);
 
     decisionThread = std::make_unique<std::thread>([this]() {
@@ -166,6 +203,16 @@ class DecisionWrapper {
     kvStoreUpdatesQueue.push(publication);
   }
 
+  // Receive RouteUpdates published by Decision so far, without blocking
+  std::vector<thrift::RouteDatabaseDelta>
+  recvAvailableRouteDbs() {
+    std::vector<thrift::RouteDatabaseDelta> routeDbs;
+    while (routeUpdatesQueueReader.size()) {
+      routeDbs.emplace_back(routeUpdatesQueueReader.get().value());
+    }
+    return routeDbs;
+  }
+
  private:
   //
   // private member methods
@@ -195,11 +242,12 @@ class DecisionWrapper {
   fbzmq::Context zeromqContext{};
 
   std::shared_ptr<Config> config;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<KvStorePublication> kvStoreUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
   messaging::RQueue<thrift::RouteDatabaseDelta> routeUpdatesQueueReader{
       routeUpdatesQueue.getReader()};
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue;
 
   // KvStore owned by this wrapper.
   std::shared_ptr<Decision> decision{nullptr};
@@ -221,6 +269,16 @@ nodeToPrefixV6(const uint32_t nodeId) {
       "fc00:{}::{}/128", toHex(nodeId >> 16), toHex(nodeId & 0xffff));
 }
 
+// Convert an integer and the index of one of its prefixes to prefix IPv6
+inline std::string
+nodeToPrefixV6(const uint32_t nodeId, const uint32_t prefixIdx) {
+  return folly::sformat(
+      "fc00:{}:{}::{}/128",
+      toHex(nodeId >> 16),
+      toHex(nodeId & 0xffff),
+      toHex(prefixIdx));
+}
+
 // Get a unique Id for adjacency-label
 inline uint32_t
 getId(const uint8_t swMarker, const int podId, const int swId) {
@@ -235,6 +293,23 @@ getNodeName(const uint8_t swMarker, const int podId, const int swId) {
   return folly::sformat("{}-{}-{}", swMarker, podId, swId);
 }
 
+// Get a deterministic link metric for the link between two nodes. The metric
+// is symmetric so both ends of the link agree on it, and stays the same across
+// updates of the same adjacency.
+inline int32_t
+getLinkMetric(
+    const std::string& nodeName,
+    const std::string& otherNodeName,
+    bool useRandomMetrics) {
+  if (!useRandomMetrics) {
+    return 1;
+  }
+  auto const& names = std::minmax(nodeName, otherNodeName);
+  return 1 +
+      std::hash<std::string>()(names.first + ":" + names.second) %
+      kMaxLinkMetric;
+}
+
 // Accumulate the time extracted from perfevent
 void
 accumulatePerfTimes(
@@ -285,7 +360,8 @@ createAdjacencyEntry(
     const uint32_t nodeId,
     const std::string& ifName,
     std::vector<thrift::Adjacency>& adjs,
-    const std::string& otherIfName) {
+    const std::string& otherIfName,
+    const int32_t metric = 1) {
   adjs.emplace_back(createThriftAdjacency(
       folly::sformat("{}", nodeId),
       ifName,
@@ -293,7 +369,7 @@ createAdjacencyEntry(
           "fe80:{}::{}", toHex(nodeId >> 16), toHex(nodeId & 0xffff)),
       folly::sformat(
           "10.{}.{}.{}", nodeId >> 16, (nodeId >> 8) & 0xff, nodeId & 0xff),
-      1,
+      metric,
       100001 + nodeId /* adjacency-label */,
       false /* overload-bit */,
       100,
@@ -318,7 +394,8 @@ createFabricAdjacency(
     const uint8_t swMarker,
     const int podId,
     const int swId,
-    std::vector<thrift::Adjacency>& adjs) {
+    std::vector<thrift::Adjacency>& adjs,
+    bool useRandomMetrics = false) {
   const auto otherName = getNodeName(swMarker, podId, swId);
   adjs.emplace_back(createThriftAdjacency(
       otherName,
@@ -327,7 +404,7 @@ createFabricAdjacency(
           "fe80:{}:{}::{}", toHex(swMarker), toHex(podId), toHex(swId)),
       folly::sformat(
           "{}.{}.{}.{}", swMarker, (podId >> 8), (podId & 0xff), swId),
-      1,
+      getLinkMetric(sourceNodeName, otherName, useRandomMetrics),
       getId(swMarker, podId, swId) /* adjacency-label */,
       false /* overload-bit */,
       100,
@@ -344,13 +421,14 @@ createGridAdjacency(
     const std::string& ifName,
     std::vector<thrift::Adjacency>& adjs,
     const int n,
-    const std::string& otherIfName) {
+    const std::string& otherIfName,
+    const int32_t metric = 1) {
   if (row < 0 || row >= n || col < 0 || col >= n) {
     return;
   }
 
   auto nodeId = row * n + col;
-  createAdjacencyEntry(nodeId, ifName, adjs, otherIfName);
+  createAdjacencyEntry(nodeId, ifName, adjs, otherIfName, metric);
 }
 
 // Get ifName
@@ -362,9 +440,20 @@ getIfName(const uint32_t id, const uint32_t otherId) {
 
 // Add all adjacencies to node at (row, col)
 inline std::vector<thrift::Adjacency>
-createGridAdjacencys(const int row, const int col, const uint32_t n) {
+createGridAdjacencys(
+    const int row,
+    const int col,
+    const uint32_t n,
+    bool useRandomMetrics = false) {
   std::vector<thrift::Adjacency> adjs;
   auto nodeId = row * n + col;
+  auto metric = [&](uint32_t otherId) {
+    return getLinkMetric(
+        folly::sformat("{}", nodeId),
+        folly::sformat("{}", otherId),
+        useRandomMetrics);
+  };
+
   auto otherId = row * n + col + 1;
   createGridAdjacency(
       row,
@@ -372,7 +461,8 @@ createGridAdjacencys(const int row, const int col, const uint32_t n) {
       getIfName(nodeId, otherId),
       adjs,
       n,
-      getIfName(otherId, nodeId));
+      getIfName(otherId, nodeId),
+      metric(otherId));
 
   otherId = row * n + col - 1;
   createGridAdjacency(
@@ -381,7 +471,8 @@ createGridAdjacencys(const int row, const int col, const uint32_t n) {
       getIfName(nodeId, otherId),
       adjs,
       n,
-      getIfName(otherId, nodeId));
+      getIfName(otherId, nodeId),
+      metric(otherId));
 
   otherId = (row - 1) * n + col;
   createGridAdjacency(
@@ -390,7 +481,8 @@ createGridAdjacencys(const int row, const int col, const uint32_t n) {
       getIfName(nodeId, otherId),
       adjs,
       n,
-      getIfName(otherId, nodeId));
+      getIfName(otherId, nodeId),
+      metric(otherId));
 
   otherId = (row + 1) * n + col;
   createGridAdjacency(
@@ -399,7 +491,8 @@ createGridAdjacencys(const int row, const int col, const uint32_t n) {
       getIfName(nodeId, otherId),
       adjs,
       n,
-      getIfName(otherId, nodeId));
+      getIfName(otherId, nodeId),
+      metric(otherId));
   return adjs;
 }
 
@@ -408,7 +501,9 @@ thrift::Publication
 createGrid(
     const std::shared_ptr<DecisionWrapper>& decisionWrapper,
     const int n,
-    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm,
+    bool useRandomMetrics = false,
+    uint32_t numPrefixesPerNode = 1) {
   LOG(INFO) << "grid: " << n << " by " << n;
   thrift::Publication initialPub;
 
@@ -418,17 +513,24 @@ createGrid(
       auto nodeId = row * n + col;
       auto nodeName = folly::sformat("{}", nodeId);
       // Add adjs
-      auto adjs = createGridAdjacencys(row, col, n);
+      auto adjs = createGridAdjacencys(row, col, n, useRandomMetrics);
       initialPub.keyVals.emplace(
           folly::sformat("adj:{}", nodeName),
           decisionWrapper->createAdjValue(nodeName, 1, adjs, std::nullopt));
 
-      // prefix
-      auto addrV6 = toIpPrefix(nodeToPrefixV6(nodeId));
+      // prefixes
+      std::vector<thrift::IpPrefix> prefixes;
+      if (numPrefixesPerNode == 1) {
+        prefixes.emplace_back(toIpPrefix(nodeToPrefixV6(nodeId)));
+      } else {
+        for (uint32_t i = 0; i < numPrefixesPerNode; ++i) {
+          prefixes.emplace_back(toIpPrefix(nodeToPrefixV6(nodeId, i)));
+        }
+      }
       initialPub.keyVals.emplace(
           folly::sformat("prefix:{}", nodeName),
           decisionWrapper->createPrefixValue(
-              nodeName, 1, {addrV6}, forwardingAlgorithm));
+              nodeName, 1, prefixes, forwardingAlgorithm));
     }
   }
   return initialPub;
@@ -447,7 +549,8 @@ createSswsAdjacencies(
     const uint8_t fswMarker,
     const int numOfPods,
     const int numOfPlanes,
-    const int numOfSswsPerPlane) {
+    const int numOfSswsPerPlane,
+    bool useRandomMetrics) {
   for (int planeId = 0; planeId < numOfPlanes; planeId++) {
     for (int sswIdInPlane = 0; sswIdInPlane < numOfSswsPerPlane;
          sswIdInPlane++) {
@@ -456,7 +559,8 @@ createSswsAdjacencies(
       for (int podId = 0; podId < numOfPods; podId++) {
         std::vector<thrift::Adjacency> adjs;
         auto otherName = getNodeName(fswMarker, podId, planeId);
-        createFabricAdjacency(nodeName, fswMarker, podId, planeId, adjs);
+        createFabricAdjacency(
+            nodeName, fswMarker, podId, planeId, adjs, useRandomMetrics);
 
         // Add to publication
         initialPub.keyVals.emplace(
@@ -481,7 +585,8 @@ createFswsAdjacencies(
     const int numOfPods,
     const int numOfFswsPerPod,
     const int numOfSswsPerPlane,
-    const int numOfRswsPerPod) {
+    const int numOfRswsPerPod,
+    bool useRandomMetrics) {
   for (int podId = 0; podId < numOfPods; podId++) {
     for (int swIdInPod = 0; swIdInPod < numOfFswsPerPod; swIdInPod++) {
       auto nodeName = getNodeName(fswMarker, podId, swIdInPod);
@@ -490,7 +595,8 @@ createFswsAdjacencies(
       auto planeId = swIdInPod;
       for (int otherId = 0; otherId < numOfSswsPerPlane; otherId++) {
         auto otherName = getNodeName(sswMarker, planeId, otherId);
-        createFabricAdjacency(nodeName, sswMarker, planeId, otherId, adjs);
+        createFabricAdjacency(
+            nodeName, sswMarker, planeId, otherId, adjs, useRandomMetrics);
       }
 
       // Add all rsws within the pod to adjacencies.
@@ -498,7 +604,8 @@ createFswsAdjacencies(
         auto otherName =
             getNodeName(rswMarker, podId, otherId); // folly::sformat("{}",
                                                     // otherId); //
-        createFabricAdjacency(nodeName, rswMarker, podId, otherId, adjs);
+        createFabricAdjacency(
+            nodeName, rswMarker, podId, otherId, adjs, useRandomMetrics);
       }
 
       // Add to publication
@@ -521,7 +628,8 @@ createRswsAdjacencies(
     const uint8_t rswMarker,
     const int numOfPods,
     const int numOfFswsPerPod,
-    const int numOfRswsPerPod) {
+    const int numOfRswsPerPod,
+    bool useRandomMetrics) {
   for (int podId = 0; podId < numOfPods; podId++) {
     for (int swIdInPod = 0; swIdInPod < numOfRswsPerPod; swIdInPod++) {
       auto nodeName = getNodeName(rswMarker, podId, swIdInPod);
@@ -529,7 +637,8 @@ createRswsAdjacencies(
       std::vector<thrift::Adjacency> adjs;
       for (int otherId = 0; otherId < numOfFswsPerPod; otherId++) {
         auto otherName = getNodeName(fswMarker, podId, otherId);
-        createFabricAdjacency(nodeName, fswMarker, podId, otherId, adjs);
+        createFabricAdjacency(
+            nodeName, fswMarker, podId, otherId, adjs, useRandomMetrics);
       }
 
       // Add to publication
@@ -549,7 +658,8 @@ createFabric(
     const int numOfPods,
     const int numOfSswsPerPlane,
     const int numOfFswsPerPod,
-    const int numOfRswsPerPod) {
+    const int numOfRswsPerPod,
+    bool useRandomMetrics = false) {
   LOG(INFO) << "Pods number: " << numOfPods;
   thrift::Publication initialPub;
 
@@ -562,7 +672,8 @@ createFabric(
       kFswMarker,
       numOfPods,
       numOfPlanes,
-      numOfSswsPerPlane);
+      numOfSswsPerPlane,
+      useRandomMetrics);
 
   // fsw: each fsw connects to all ssws within a plane,
   // each fsw also connects to all rsws within its pod
@@ -575,7 +686,8 @@ createFabric(
       numOfPods,
       numOfFswsPerPod,
       numOfSswsPerPlane,
-      numOfRswsPerPod);
+      numOfRswsPerPod,
+      useRandomMetrics);
 
   // rsw: each rsw connects to all fsws within the pod
   createRswsAdjacencies(
@@ -585,7 +697,8 @@ createFabric(
       kRswMarker,
       numOfPods,
       numOfFswsPerPod,
-      numOfRswsPerPod);
+      numOfRswsPerPod,
+      useRandomMetrics);
 
   return initialPub;
 }
@@ -601,7 +714,8 @@ updateRandomFabricAdjs(
     const int numOfPods,
     const int numOfFswsPerPod,
     const int numOfRswsPerPod,
-    std::vector<uint64_t>& processTimes) {
+    std::vector<uint64_t>& processTimes,
+    bool useRandomMetrics = false) {
   thrift::Publication newPub;
 
   // Choose a random pod
@@ -622,7 +736,8 @@ updateRandomFabricAdjs(
   std::vector<thrift::Adjacency> adjsRsw;
   for (int otherId = 0; otherId < numOfFswsPerPod; otherId += 1) {
     auto otherName = getNodeName(kFswMarker, podId, otherId);
-    createFabricAdjacency(rwsNodeName, kFswMarker, podId, otherId, adjsRsw);
+    createFabricAdjacency(
+        rwsNodeName, kFswMarker, podId, otherId, adjsRsw, useRandomMetrics);
   }
 
   auto overloadBit = (selectedNode.has_value()) ? false : true;
@@ -646,7 +761,8 @@ updateRandomGridAdjs(
     const std::shared_ptr<DecisionWrapper>& decisionWrapper,
     std::optional<std::pair<int, int>>& selectedNode,
     const int n,
-    std::vector<uint64_t>& processTimes) {
+    std::vector<uint64_t>& processTimes,
+    bool useRandomMetrics = false) {
   thrift::Publication newPub;
 
   // If there has been an update, revert the update,
@@ -657,7 +773,7 @@ updateRandomGridAdjs(
                                       : folly::Random::rand32() % n;
 
   auto nodeName = folly::sformat("{}", row * n + col);
-  auto adjs = createGridAdjacencys(row, col, n);
+  auto adjs = createGridAdjacencys(row, col, n, useRandomMetrics);
   auto overloadBit = selectedNode.has_value() ? false : true;
   // Record the updated nodeId
   selectedNode = selectedNode.has_value()
@@ -695,12 +811,14 @@ BM_DecisionGrid(
     folly::UserCounters& counters,
     uint32_t iters,
     uint32_t numOfSws,
-    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm,
+    bool useRandomMetrics = false) {
   auto suspender = folly::BenchmarkSuspender();
   const std::string nodeName{"1"};
   auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
   int n = std::sqrt(numOfSws);
-  auto initialPub = createGrid(decisionWrapper, n, forwardingAlgorithm);
+  auto initialPub =
+      createGrid(decisionWrapper, n, forwardingAlgorithm, useRandomMetrics);
 
   //
   // Publish initial link state info to KvStore, This should trigger the
@@ -724,7 +842,8 @@ BM_DecisionGrid(
 
   for (uint32_t i = 0; i < iters; i++) {
     // Advertise adj update. This should trigger the SPF run.
-    updateRandomGridAdjs(decisionWrapper, selectedNode, n, processTimes);
+    updateRandomGridAdjs(
+        decisionWrapper, selectedNode, n, processTimes, useRandomMetrics);
   }
 
   suspender.rehire(); // Stop measuring time again
@@ -732,6 +851,47 @@ BM_DecisionGrid(
   insertUserCounters(counters, iters, processTimes);
 }
 
+//
+// Benchmark test for route build cost over many prefixes. Grid size is fixed
+// while the number of prefixes announced by each node varies. Route build
+// may be sharded over routeBuildThreads.
+//
+static void
+BM_DecisionPrefixScale(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numPrefixesPerNode,
+    int32_t routeBuildThreads) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  auto decisionWrapper =
+      std::make_shared<DecisionWrapper>(nodeName, routeBuildThreads);
+  int n = std::sqrt(numOfSws);
+  auto initialPub = createGrid(
+      decisionWrapper,
+      n,
+      thrift::PrefixForwardingAlgorithm::SP_ECMP,
+      false,
+      numPrefixesPerNode);
+
+  decisionWrapper->sendKvPublication(initialPub);
+  decisionWrapper->recvMyRouteDb();
+
+  std::optional<std::pair<int, int>> selectedNode = std::nullopt;
+  std::vector<uint64_t> processTimes{0, 0, 0};
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // every adj update triggers a full route build over all prefixes
+    updateRandomGridAdjs(decisionWrapper, selectedNode, n, processTimes);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  insertUserCounters(counters, iters, processTimes);
+  counters["prefixes"] = n * n * numPrefixesPerNode;
+}
+
 //
 // Benchmark test for fabric topology.
 //
@@ -740,7 +900,8 @@ BM_DecisionFabric(
     folly::UserCounters& counters,
     uint32_t iters,
     uint32_t numOfSws,
-    thrift::PrefixForwardingAlgorithm /* TODO use this */) {
+    thrift::PrefixForwardingAlgorithm /* TODO use this */,
+    bool useRandomMetrics = false) {
   auto suspender = folly::BenchmarkSuspender();
   const std::string nodeName = folly::sformat("{}-{}", kFswMarker, "0-0");
   auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
@@ -764,7 +925,8 @@ BM_DecisionFabric(
       numOfPods,
       numOfSswsPerPlane,
       numOfFswsPerPod,
-      numOfRswsPerPod);
+      numOfRswsPerPod,
+      useRandomMetrics);
 
   //
   // Publish initial link state info to KvStore, This should trigger the
@@ -795,7 +957,8 @@ BM_DecisionFabric(
         numOfPods,
         numOfFswsPerPod,
         numOfRswsPerPod,
-        processTimes);
+        processTimes,
+        useRandomMetrics);
   }
 
   suspender.rehire(); // Stop measuring time again
@@ -803,6 +966,312 @@ BM_DecisionFabric(
   insertUserCounters(counters, iters, processTimes);
 }
 
+//
+// Benchmark SPF for a single link flapping in the middle of a grid topology.
+// LinkState is driven directly so that only SPF is measured, either rerun
+// from scratch or repaired incrementally.
+//
+static void
+BM_LinkStateGridLinkFlap(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    bool enableIncrementalSpf) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string area{thrift::KvStore_constants::kDefaultArea()};
+  const std::string nodeName{"1"};
+  const int n = std::sqrt(numOfSws);
+  LinkState linkState(area, enableIncrementalSpf);
+  for (int row = 0; row < n; ++row) {
+    for (int col = 0; col < n; ++col) {
+      auto nodeId = row * n + col;
+      linkState.updateAdjacencyDatabase(createAdjDb(
+          folly::sformat("{}", nodeId),
+          createGridAdjacencys(row, col, n, true),
+          nodeId,
+          false,
+          area));
+    }
+  }
+  linkState.getSpfResult(nodeName);
+
+  // flap the first link of the node in the center of the grid by toggling
+  // its overload bit
+  const int row = n / 2, col = n / 2;
+  const auto flapNodeName = folly::sformat("{}", row * n + col);
+  auto adjs = createGridAdjacencys(row, col, n, true);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    adjs.at(0).isOverloaded = !adjs.at(0).isOverloaded;
+    linkState.updateAdjacencyDatabase(
+        createAdjDb(flapNodeName, adjs, row * n + col, false, area));
+    folly::doNotOptimizeAway(linkState.getSpfResult(nodeName).size());
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  counters["nodes"] = linkState.numNodes();
+}
+
+//
+// Benchmark republishing adjacency database of a spine with numOfAdjs
+// adjacencies (to as many leaves) where only RTT of an adjacency changed, as
+// happens on every RTT measurement change. LinkState is driven directly so
+// that only diffing of the adjacency database is measured.
+//
+static void
+BM_LinkStateSpineRttChange(
+    folly::UserCounters& counters, uint32_t iters, uint32_t numOfAdjs) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string area{thrift::KvStore_constants::kDefaultArea()};
+  const std::string spineName{"spine"};
+  LinkState linkState(area);
+  std::vector<thrift::Adjacency> spineAdjs;
+  for (uint32_t i = 0; i < numOfAdjs; ++i) {
+    const auto leafName = folly::sformat("leaf-{}", i);
+    spineAdjs.emplace_back(createAdjacency(
+        leafName,
+        folly::sformat("po{}", i),
+        "po0",
+        folly::sformat("fe80::{:x}", i + 2),
+        "",
+        10,
+        100000 + i));
+    linkState.updateAdjacencyDatabase(createAdjDb(
+        leafName,
+        {createAdjacency(
+            spineName, "po0", folly::sformat("po{}", i), "fe80::1", "", 10, 1)},
+        i + 2,
+        false,
+        area));
+  }
+  linkState.updateAdjacencyDatabase(
+      createAdjDb(spineName, spineAdjs, 1, false, area));
+  CHECK_EQ(numOfAdjs, linkState.linksFromNode(spineName).size());
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto& adj = spineAdjs.at(i % numOfAdjs);
+    ++adj.rtt;
+    auto change = linkState.updateAdjacencyDatabase(
+        createAdjDb(spineName, spineAdjs, 1, false, area));
+    folly::doNotOptimizeAway(change);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  counters["links"] = linkState.linksFromNode(spineName).size();
+}
+
+//
+// Benchmark ordered FIB programming in a grid topology: metric change on all
+// links of the node in the center of the grid is held for `holdTtl` ticks,
+// which are decremented until no hold is left, as Decision does on its
+// ordered FIB timer.
+//
+static void
+BM_LinkStateGridOrderedFib(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    LinkStateMetric holdTtl) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string area{thrift::KvStore_constants::kDefaultArea()};
+  const int n = std::sqrt(numOfSws);
+  LinkState linkState(area);
+  for (int row = 0; row < n; ++row) {
+    for (int col = 0; col < n; ++col) {
+      auto nodeId = row * n + col;
+      linkState.updateAdjacencyDatabase(createAdjDb(
+          folly::sformat("{}", nodeId),
+          createGridAdjacencys(row, col, n, false),
+          nodeId,
+          false,
+          area));
+    }
+  }
+
+  const int row = n / 2, col = n / 2;
+  const auto holdNodeName = folly::sformat("{}", row * n + col);
+  auto adjs = createGridAdjacencys(row, col, n, false);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto& adj : adjs) {
+      adj.metric = (adj.metric == 1) ? 2 : 1;
+    }
+    linkState.updateAdjacencyDatabase(
+        createAdjDb(holdNodeName, adjs, row * n + col, false, area),
+        holdTtl,
+        holdTtl);
+    while (linkState.hasHolds()) {
+      linkState.decrementHolds();
+    }
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  counters["links"] = linkState.numLinks();
+}
+
+//
+// Benchmark application of RibPolicy on a route database. Policy has
+// `numOfStatements` statements matching 10% of the routes between them
+//
+static void
+BM_RibPolicyApply(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfRoutes,
+    uint32_t numOfStatements) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto nh = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, false, "area1");
+  auto getPrefix = [](uint32_t i) {
+    return folly::IPAddress::createNetwork(folly::sformat(
+        "fc00:{:x}:{:x}::/64", (i >> 16) & 0xffff, i & 0xffff));
+  };
+
+  std::vector<RibUnicastEntry> routes;
+  routes.reserve(numOfRoutes);
+  for (uint32_t i = 0; i < numOfRoutes; ++i) {
+    routes.emplace_back(getPrefix(i), NextHopSet{nh});
+  }
+
+  thrift::RibPolicy tPolicy;
+  tPolicy.ttl_secs = 3600;
+  for (uint32_t s = 0; s < numOfStatements; ++s) {
+    thrift::RibPolicyStatement stmt;
+    stmt.name = folly::sformat("stmt{}", s);
+    stmt.matcher.prefixes_ref() = std::vector<thrift::IpPrefix>{};
+    for (uint32_t i = s; i < numOfRoutes / 10; i += numOfStatements) {
+      stmt.matcher.prefixes_ref()->emplace_back(toIpPrefix(getPrefix(i * 10)));
+    }
+    stmt.action.set_weight_ref() = thrift::RibRouteActionWeight{};
+    stmt.action.set_weight_ref()->default_weight = 2;
+    tPolicy.statements.emplace_back(std::move(stmt));
+  }
+  const RibPolicy policy(tPolicy);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  size_t numTransformed{0};
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto& route : routes) {
+      numTransformed += policy.applyAction(route);
+    }
+  }
+  folly::doNotOptimizeAway(numTransformed);
+
+  suspender.rehire(); // Stop measuring time again
+  counters["routes"] = numOfRoutes;
+}
+
+//
+// Load adjacency and prefix database updates of the KvStore recording, with
+// their recorded timestamps. Ttl refreshes are dropped as they don't trigger
+// route computation. All areas are replayed into the default area.
+//
+std::vector<std::pair<std::chrono::milliseconds, thrift::Publication>>
+loadReplayPublications(const std::string& path) {
+  KvStoreRecordingReader reader(path);
+  std::vector<std::pair<std::chrono::milliseconds, thrift::Publication>> pubs;
+  for (size_t i = 0; i < reader.size(); ++i) {
+    auto record = reader.getRecord(i);
+    thrift::Publication pub;
+    for (auto& [key, value] : record.publication.keyVals) {
+      if (value.value_ref().has_value() and
+          (key.find(Constants::kAdjDbMarker.toString()) == 0 or
+           key.find(Constants::kPrefixDbMarker.toString()) == 0)) {
+        pub.keyVals.emplace(key, std::move(value));
+      }
+    }
+    if (not pub.keyVals.empty()) {
+      pubs.emplace_back(record.timestamp, std::move(pub));
+    }
+  }
+  return pubs;
+}
+
+//
+// Benchmark replaying recorded KvStore churn into Decision at recorded (or
+// accelerated) timing. Rebuild latency is the time from the first
+// publication pending a route rebuild to receiving the resulting route delta.
+//
+static void
+BM_DecisionReplay(folly::UserCounters& counters, uint32_t iters) {
+  auto suspender = folly::BenchmarkSuspender();
+  CHECK(not FLAGS_decision_replay_node.empty())
+      << "Specify --decision_replay_node";
+  const auto pubs = loadReplayPublications(FLAGS_decision_replay_recording);
+  CHECK(not pubs.empty()) << "No adjacency or prefix updates recorded";
+
+  std::vector<uint64_t> rebuildMs;
+  std::vector<uint64_t> deltaSizes;
+  for (uint32_t i = 0; i < iters; i++) {
+    auto decisionWrapper =
+        std::make_shared<DecisionWrapper>(FLAGS_decision_replay_node);
+    std::optional<std::chrono::steady_clock::time_point> pendingSince;
+    auto recvRouteDbs = [&]() {
+      for (auto const& delta : decisionWrapper->recvAvailableRouteDbs()) {
+        if (pendingSince.has_value()) {
+          rebuildMs.emplace_back(
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - *pendingSince)
+                  .count());
+          pendingSince.reset();
+        }
+        deltaSizes.emplace_back(
+            delta.unicastRoutesToUpdate.size() +
+            delta.unicastRoutesToDelete.size() +
+            delta.mplsRoutesToUpdate.size() + delta.mplsRoutesToDelete.size());
+      }
+    };
+
+    suspender.dismiss();
+    const auto startTime = std::chrono::steady_clock::now();
+    for (auto const& [timestamp, pub] : pubs) {
+      if (FLAGS_decision_replay_speed > 0) {
+        const std::chrono::duration<double, std::milli> offset =
+            (timestamp - pubs.front().first) / FLAGS_decision_replay_speed;
+        const auto sendTime =
+            startTime + std::chrono::ceil<std::chrono::microseconds>(offset);
+        while (std::chrono::steady_clock::now() < sendTime) {
+          recvRouteDbs();
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+      if (not pendingSince.has_value()) {
+        pendingSince = std::chrono::steady_clock::now();
+      }
+      decisionWrapper->sendKvPublication(pub);
+      recvRouteDbs();
+    }
+
+    // wait for rebuild of the last publications
+    const auto deadline =
+        std::chrono::steady_clock::now() + kReplaySettleTimeout;
+    while (pendingSince.has_value() and
+           std::chrono::steady_clock::now() < deadline) {
+      recvRouteDbs();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    suspender.rehire();
+  }
+
+  auto percentile = [](std::vector<uint64_t>& values, size_t pct) {
+    if (values.empty()) {
+      return uint64_t{0};
+    }
+    std::sort(values.begin(), values.end());
+    return values.at((values.size() - 1) * pct / 100);
+  };
+  counters["publications"] = pubs.size();
+  counters["rebuilds"] = rebuildMs.size() / std::max<uint32_t>(iters, 1);
+  counters["rebuild_p50_ms"] = percentile(rebuildMs, 50);
+  counters["rebuild_p99_ms"] = percentile(rebuildMs, 99);
+  counters["rebuild_max_ms"] = percentile(rebuildMs, 100);
+  counters["delta_p50_routes"] = percentile(deltaSizes, 50);
+  counters["delta_max_routes"] = percentile(deltaSizes, 100);
+}
+
 auto SP_ECMP = thrift::PrefixForwardingAlgorithm::SP_ECMP;
 auto KSP2_ED_ECMP = thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
 
@@ -816,6 +1285,47 @@ BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 10, KSP2_ED_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 100, KSP2_ED_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 1000, KSP2_ED_ECMP);
 
+// Same grid topologies with non-uniform link metrics
+BENCHMARK_COUNTERS_PARAM_METRIC(BM_DecisionGrid, counters, 100, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM_METRIC(BM_DecisionGrid, counters, 1000, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM_METRIC(BM_DecisionGrid, counters, 10000, SP_ECMP);
+
+// Single link flap in a 1000 node grid, full vs. incremental SPF
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridLinkFlap, counters, 1000_SPF, 1000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridLinkFlap, counters, 1000_ISPF, 1000, true);
+
+// The parameter is number of adjacencies of the spine
+BENCHMARK_COUNTERS_PARAM(BM_LinkStateSpineRttChange, counters, 100);
+BENCHMARK_COUNTERS_PARAM(BM_LinkStateSpineRttChange, counters, 500);
+BENCHMARK_COUNTERS_PARAM(BM_LinkStateSpineRttChange, counters, 2000);
+
+// Hold of metric change decremented in 1000 and 10000 node grids
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridOrderedFib, counters, 1000_HOLD_10, 1000, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridOrderedFib, counters, 10000_HOLD_10, 10000, 10);
+
+// 100 node grid with a growing number of prefixes per node, route build on
+// the decision thread vs. sharded over 4 threads
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionPrefixScale, counters, 100_X_10, 100, 10, 0);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionPrefixScale, counters, 100_X_100, 100, 100, 0);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionPrefixScale, counters, 100_X_1000, 100, 1000, 0);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionPrefixScale, counters, 100_X_100_4_THREADS, 100, 100, 4);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionPrefixScale, counters, 100_X_1000_4_THREADS, 100, 1000, 4);
+
+// RibPolicy over 200k routes, single vs. many statements
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_RibPolicyApply, counters, 200000_X_1, 200000, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_RibPolicyApply, counters, 200000_X_100, 200000, 100);
+
 // The integer parameter is numOfGivenNodes in topology,
 // which >= numOfActualNodesInTopo.
 // numOfPods = (numOfGivenNodes - numOfSsws) / numOfFswsAndRswsPerPod
@@ -826,11 +1336,25 @@ BENCHMARK_COUNTERS_PARAM(BM_DecisionFabric, counters, 344, SP_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionFabric, counters, 1000, SP_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionFabric, counters, 5000, SP_ECMP);
 
+// Same fabric topologies with non-uniform link metrics
+BENCHMARK_COUNTERS_PARAM_METRIC(BM_DecisionFabric, counters, 1000, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM_METRIC(BM_DecisionFabric, counters, 5000, SP_ECMP);
+
 } // namespace openr
 
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
+  // replay benchmark runs only on a given recording
+  if (not FLAGS_decision_replay_recording.empty()) {
+    folly::addBenchmark(
+        __FILE__,
+        "BM_DecisionReplay",
+        [](folly::UserCounters& counters, unsigned iters) {
+          openr::BM_DecisionReplay(counters, iters);
+          return iters;
+        });
+  }
   folly::runBenchmarks();
   return 0;
 }
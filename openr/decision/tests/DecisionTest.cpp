@@ -610,6 +610,63 @@ TEST(SpfSolver, AdjacencyUpdate) {
   }
 }
 
+//
+// Node-1 connects to 2 over two parallel links of unequal weight. With UCMP,
+// nexthops are weighted in reduced ratio of their adjacency weights
+//
+TEST(SpfSolver, UcmpNextHops) {
+  auto adj12_1 = createAdjacency(
+      "2", "1/2-1", "2/1-1", "fe80::2", "192.168.0.2", 10, 0, 100);
+  auto adj12_2 = createAdjacency(
+      "2", "1/2-2", "2/1-2", "fe80::2", "192.168.0.2", 10, 0, 300);
+  auto adj21_1 =
+      createAdjacency("1", "2/1-1", "1/2-1", "fe80::1", "192.168.0.1", 10, 0);
+  auto adj21_2 =
+      createAdjacency("1", "2/1-2", "1/2-2", "fe80::1", "192.168.0.1", 10, 0);
+  auto adjacencyDb1 = createAdjDb("1", {adj12_1, adj12_2}, 1);
+  auto adjacencyDb2 = createAdjDb("2", {adj21_1, adj21_2}, 2);
+
+  SpfSolver spfSolver(
+      "1",
+      false /* disable v4 */,
+      false /* disable LFA */,
+      false /* enableOrderedFib */,
+      false /* bgpDryRun */,
+      false /* bgpUseIgpMetric */,
+      0 /* numRouteBuildThreads */,
+      std::nullopt /* routeBuildScheduling */,
+      true /* enableUcmp */);
+
+  LinkState linkState(kDefaultArea);
+  PrefixState prefixState;
+  linkState.updateAdjacencyDatabase(adjacencyDb1);
+  linkState.updateAdjacencyDatabase(adjacencyDb2);
+  prefixState.updatePrefixDatabase(prefixDb2);
+
+  auto getWeights = [&]() {
+    auto routeDb = spfSolver.buildRouteDb("1", linkState, prefixState);
+    std::map<std::string, int32_t> weights;
+    for (auto const& nh : routeDb->unicastEntries.at(addr2).nexthops) {
+      weights.emplace(*nh.address.ifName_ref(), nh.weight);
+    }
+    return weights;
+  };
+  EXPECT_EQ(
+      (std::map<std::string, int32_t>{{"1/2-1", 1}, {"1/2-2", 3}}),
+      getWeights());
+
+  // equal weights fall back to ECMP
+  adjacencyDb1.adjacencies[1].weight = 100;
+  {
+    auto res = linkState.updateAdjacencyDatabase(adjacencyDb1);
+    EXPECT_FALSE(res.topologyChanged);
+    EXPECT_TRUE(res.linkAttributesChanged);
+  }
+  EXPECT_EQ(
+      (std::map<std::string, int32_t>{{"1/2-1", 0}, {"1/2-2", 0}}),
+      getWeights());
+}
+
 //
 // Node-1 connects to 2 but 2 doesn't report bi-directionality
 // Node-2 and Node-3 are bi-directionally connected
@@ -1151,6 +1208,135 @@ TEST(ConnectivityTest, OverloadNodeTest) {
   validateAdjLabelRoutes(routeMap, "3", adjacencyDb3.adjacencies);
 }
 
+//
+// Nexthops are computed once per set of announcing nodes in a route build
+//
+// 1<--->2<--->3
+//   10     10
+//
+TEST(ConnectivityTest, NextHopMemoizationTest) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(
+      nodeName, false /* disable v4 */, false /* disable LFA */);
+
+  LinkState linkState(kDefaultArea);
+  PrefixState prefixState;
+
+  EXPECT_FALSE(linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12}, 1))
+                   .topologyChanged);
+  EXPECT_TRUE(
+      linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21, adj23}, 2))
+          .topologyChanged);
+  EXPECT_TRUE(linkState.updateAdjacencyDatabase(createAdjDb("3", {adj32}, 3))
+                  .topologyChanged);
+
+  // node-2 announces addr2, node-3 announces addr3, addr5 and addr6
+  EXPECT_FALSE(prefixState.updatePrefixDatabase(prefixDb2).empty());
+  EXPECT_FALSE(prefixState
+                   .updatePrefixDatabase(createPrefixDb(
+                       "3",
+                       {createPrefixEntry(addr3),
+                        createPrefixEntry(addr5),
+                        createPrefixEntry(addr6)}))
+                   .empty());
+
+  auto countersBefore = fb303::fbData->getCounters();
+  auto routeDb = spfSolver.buildRouteDb(nodeName, linkState, prefixState);
+  ASSERT_TRUE(routeDb.has_value());
+  EXPECT_EQ(4, routeDb->unicastEntries.size());
+  for (auto const& prefix : {addr3, addr5, addr6}) {
+    auto const& nexthops = routeDb->unicastEntries.at(prefix).nexthops;
+    EXPECT_EQ(
+        NextHops({createNextHopFromAdj(adj12, false, 20)}),
+        NextHops(nexthops.begin(), nexthops.end()));
+  }
+
+  // one miss per set of announcing nodes, hits for the rest of the prefixes
+  auto countersAfter = fb303::fbData->getCounters();
+  EXPECT_EQ(
+      2,
+      countersAfter.at("decision.nexthop_memo_misses.sum") -
+          countersBefore.at("decision.nexthop_memo_misses.sum"));
+  EXPECT_EQ(
+      2,
+      countersAfter.at("decision.nexthop_memo_hits.sum") -
+          countersBefore.at("decision.nexthop_memo_hits.sum"));
+
+  // memo doesn't outlive the route build, topology change is picked up
+  EXPECT_TRUE(
+      linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21}, 2))
+          .topologyChanged);
+  routeDb = spfSolver.buildRouteDb(nodeName, linkState, prefixState);
+  ASSERT_TRUE(routeDb.has_value());
+  EXPECT_EQ(1, routeDb->unicastEntries.size());
+  EXPECT_EQ(1, routeDb->unicastEntries.count(addr2));
+}
+
+//
+// Best announcing nodes of anycast prefix are cached across route builds,
+// until its entries or state of one of its announcers change
+//
+// 2<--->1<--->3
+//   10     10
+//
+TEST(ConnectivityTest, BestAnnouncersCacheTest) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(
+      nodeName, false /* disable v4 */, false /* disable LFA */);
+
+  LinkState linkState(kDefaultArea);
+  PrefixState prefixState;
+
+  linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12, adj13}, 1));
+  linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21}, 2));
+  linkState.updateAdjacencyDatabase(createAdjDb("3", {adj31}, 3));
+
+  // node-2 and node-3 announce anycast addr5
+  prefixState.updatePrefixDatabase(
+      createPrefixDb("2", {createPrefixEntry(addr5)}));
+  prefixState.updatePrefixDatabase(
+      createPrefixDb("3", {createPrefixEntry(addr5)}));
+
+  auto buildAndCount = [&](int64_t expectedHits, int64_t expectedMisses) {
+    auto countersBefore = fb303::fbData->getCounters();
+    auto routeDb = spfSolver.buildRouteDb(nodeName, linkState, prefixState);
+    auto countersAfter = fb303::fbData->getCounters();
+    EXPECT_EQ(
+        expectedHits,
+        countersAfter.at("decision.best_announcers_cache_hits.sum") -
+            countersBefore.at("decision.best_announcers_cache_hits.sum"));
+    EXPECT_EQ(
+        expectedMisses,
+        countersAfter.at("decision.best_announcers_cache_misses.sum") -
+            countersBefore.at("decision.best_announcers_cache_misses.sum"));
+    EXPECT_TRUE(routeDb.has_value());
+    auto const& nexthops = routeDb->unicastEntries.at(addr5).nexthops;
+    return NextHops(nexthops.begin(), nexthops.end());
+  };
+
+  const auto bothNextHops = NextHops(
+      {createNextHopFromAdj(adj12, false, 10),
+       createNextHopFromAdj(adj13, false, 10)});
+  EXPECT_EQ(bothNextHops, buildAndCount(0, 1));
+
+  // nothing changed, cached result is used
+  EXPECT_EQ(bothNextHops, buildAndCount(1, 0));
+
+  // draining node-3 invalidates the cached result
+  linkState.updateAdjacencyDatabase(createAdjDb("3", {adj31}, 3, true));
+  EXPECT_EQ(
+      NextHops({createNextHopFromAdj(adj12, false, 10)}), buildAndCount(0, 1));
+  EXPECT_EQ(
+      NextHops({createNextHopFromAdj(adj12, false, 10)}), buildAndCount(1, 0));
+
+  // so does update of an entry of the prefix
+  linkState.updateAdjacencyDatabase(createAdjDb("3", {adj31}, 3));
+  prefixState.updatePrefixDatabase(createPrefixDb(
+      "2",
+      {createPrefixEntry(addr5, thrift::PrefixType::LOOPBACK, "updated")}));
+  EXPECT_EQ(bothNextHops, buildAndCount(0, 1));
+}
+
 //
 // AdjacencyDb compatibility test in a circle topology with shortest path
 // calculation
@@ -3958,15 +4144,96 @@ TEST(GridTopology, StressTest) {
   spfSolver.buildRouteDb("523", linkState, prefixState);
 }
 
+// routes built in parallel shards must match the ones built serially
+TEST(GridTopology, ShardedRouteBuild) {
+  const int n = 10;
+  const int numPrefixesPerNode = 30;
+  LinkState linkState(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, n);
+
+  // announce enough prefixes to be split into several shards
+  for (int node = 0; node < n * n; ++node) {
+    auto nodeName = folly::sformat("{}", node);
+    std::vector<thrift::PrefixEntry> prefixEntries{
+        createPrefixEntry(toIpPrefix(nodeToPrefixV6(node)))};
+    for (int i = 0; i < numPrefixesPerNode; ++i) {
+      prefixEntries.emplace_back(createPrefixEntry(
+          toIpPrefix(folly::sformat("fc01:{}::{}/128", node, i))));
+    }
+    prefixState.updatePrefixDatabase(createPrefixDb(nodeName, prefixEntries));
+  }
+  ASSERT_LT(
+      2 * Constants::kDecisionMinPrefixesPerShard,
+      prefixState.prefixes().size());
+
+  const std::string nodeName("55");
+  SpfSolver serialSolver(nodeName, false, true);
+  SpfSolver shardedSolver(nodeName, false, true, false, false, false, 4);
+
+  auto serialRouteDb =
+      serialSolver.buildRouteDb(nodeName, linkState, prefixState);
+  auto shardedRouteDb =
+      shardedSolver.buildRouteDb(nodeName, linkState, prefixState);
+  ASSERT_TRUE(serialRouteDb.has_value());
+  ASSERT_TRUE(shardedRouteDb.has_value());
+  EXPECT_EQ(
+      (n * n - 1) * (numPrefixesPerNode + 1),
+      shardedRouteDb->unicastEntries.size());
+  EXPECT_EQ(serialRouteDb->unicastEntries, shardedRouteDb->unicastEntries);
+  EXPECT_EQ(serialRouteDb->mplsEntries, shardedRouteDb->mplsEntries);
+}
+
+// KSP2 paths computed concurrently must yield the routes built serially
+TEST(GridTopology, ParallelKsp2RouteBuild) {
+  const int n = 6;
+  auto const createKsp2Grid = [&](LinkState& linkState,
+                                  PrefixState& prefixState) {
+    createGrid(linkState, prefixState, n);
+    for (int node = 0; node < n * n; ++node) {
+      auto nodeName = folly::sformat("{}", node);
+      prefixState.updatePrefixDatabase(createPrefixDbWithKspfAlgo(
+          createPrefixDb(
+              nodeName,
+              {createPrefixEntry(toIpPrefix(nodeToPrefixV6(node)))})));
+    }
+  };
+  LinkState serialLinkState(kDefaultArea);
+  PrefixState serialPrefixState;
+  createKsp2Grid(serialLinkState, serialPrefixState);
+  LinkState parallelLinkState(kDefaultArea);
+  PrefixState parallelPrefixState;
+  createKsp2Grid(parallelLinkState, parallelPrefixState);
+
+  const std::string nodeName("14");
+  SpfSolver serialSolver(nodeName, false, true);
+  SpfSolver parallelSolver(nodeName, false, true, false, false, false, 4);
+
+  auto serialRouteDb = serialSolver.buildRouteDb(
+      nodeName, serialLinkState, serialPrefixState);
+  auto parallelRouteDb = parallelSolver.buildRouteDb(
+      nodeName, parallelLinkState, parallelPrefixState);
+  ASSERT_TRUE(serialRouteDb.has_value());
+  ASSERT_TRUE(parallelRouteDb.has_value());
+  EXPECT_EQ(n * n - 1, parallelRouteDb->unicastEntries.size());
+  EXPECT_EQ(serialRouteDb->unicastEntries, parallelRouteDb->unicastEntries);
+}
+
 //
 // Start the decision thread and simulate KvStore communications
 // Expect proper RouteDatabase publications to appear
 //
 class DecisionTestFixture : public ::testing::Test {
  protected:
+  // config decision is started with, override to change knobs
+  virtual thrift::OpenrConfig
+  createConfig() {
+    return getBasicOpenrConfig("1");
+  }
+
   void
   SetUp() override {
-    auto tConfig = getBasicOpenrConfig("1");
+    auto tConfig = createConfig();
     config = std::make_shared<Config>(tConfig);
 
     decision = make_shared<Decision>(
@@ -3978,6 +4245,7 @@ class DecisionTestFixture : public ::testing::Test {
         kvStoreUpdatesQueue.getReader(),
         staticRoutesUpdateQueue.getReader(),
         routeUpdatesQueue,
+        decisionDbsUpdatesQueue,
         zeromqContext);
 
     decisionThread = std::make_unique<std::thread>([this]() {
@@ -4046,9 +4314,9 @@ class DecisionTestFixture : public ::testing::Test {
       int64_t version,
       const vector<thrift::Adjacency>& adjs,
       bool overloaded = false,
-      int32_t nodeId = 0) {
-    auto adjDB = createAdjDb(node, adjs, nodeId);
-    adjDB.isOverloaded = overloaded;
+      int32_t nodeId = 0,
+      const std::string& area = kDefaultArea) {
+    auto adjDB = createAdjDb(node, adjs, nodeId, overloaded, area);
     return thrift::Value(
         FRAGILE,
         version,
@@ -4141,11 +4409,12 @@ class DecisionTestFixture : public ::testing::Test {
   fbzmq::Context zeromqContext{};
 
   std::shared_ptr<Config> config;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<KvStorePublication> kvStoreUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
   messaging::RQueue<thrift::RouteDatabaseDelta> routeUpdatesQueueReader{
       routeUpdatesQueue.getReader()};
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue;
 
   // Decision owned by this wrapper.
   std::shared_ptr<Decision> decision{nullptr};
@@ -4420,6 +4689,133 @@ TEST_F(DecisionTestFixture, BasicOperations) {
       Contains(createMplsRoute(32012, {nh, nh1})));
 }
 
+//
+// Same Decision, but with routes of different areas built in parallel
+//
+class ParallelRouteBuildTestFixture : public DecisionTestFixture {
+ protected:
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = getBasicOpenrConfig("1");
+    tConfig.decision_route_build_threads_ref() = 2;
+    return tConfig;
+  }
+};
+
+// The following topology is used, with each link in its own area:
+//
+// 2---1---3
+//   A   B
+//
+// Routes towards 2 are only computable in area A and routes towards 3 only in
+// area B. Expect both to be present in the coalesced route database.
+//
+TEST_F(ParallelRouteBuildTestFixture, MultiAreaRoutes) {
+  const std::string areaA{"A"}, areaB{"B"};
+
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 0, areaA)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 0, areaA)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""),
+      areaA));
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(addr2, routeDbDelta.unicastRoutesToUpdate.at(0).dest);
+
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj13}, false, 0, areaB)},
+       {"adj:3", createAdjValue("3", 1, {adj31}, false, 0, areaB)},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""),
+      areaB));
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(addr3, routeDbDelta.unicastRoutesToUpdate.at(0).dest);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToDelete.size());
+
+  auto routeDb = dumpRouteDb({"1"})["1"];
+  RouteMap routeMap;
+  fillRouteMap("1", routeMap, routeDb);
+  EXPECT_EQ(2, routeDb.unicastRoutes.size());
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr2))],
+      NextHops({createNextHopFromAdj(
+          adj12, false, 10, std::nullopt, false, areaA)}));
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr3))],
+      NextHops({createNextHopFromAdj(
+          adj13, false, 10, std::nullopt, false, areaB)}));
+}
+
+// Same topology, with addr5 announced by both 2 and 3. Route towards addr5 is
+// computed in both areas, and coalesced into ECMP across areas while paths
+// are of equal cost. Otherwise route of the shorter path wins.
+//
+TEST_F(ParallelRouteBuildTestFixture, MultiAreaRouteCoalescing) {
+  const std::string areaA{"A"}, areaB{"B"};
+
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 0, areaA)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 0, areaA)},
+       {"prefix:2", createPrefixValue("2", 1, {addr2, addr5})}},
+      {},
+      {},
+      {},
+      std::string(""),
+      areaA));
+  recvMyRouteDb("1", serializer);
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj13}, false, 0, areaB)},
+       {"adj:3", createAdjValue("3", 1, {adj31}, false, 0, areaB)},
+       {"prefix:3", createPrefixValue("3", 1, {addr3, addr5})}},
+      {},
+      {},
+      {},
+      std::string(""),
+      areaB));
+  recvMyRouteDb("1", serializer);
+
+  auto routeDb = dumpRouteDb({"1"})["1"];
+  RouteMap routeMap;
+  fillRouteMap("1", routeMap, routeDb);
+  EXPECT_EQ(3, routeDb.unicastRoutes.size());
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr5))],
+      NextHops(
+          {createNextHopFromAdj(adj12, false, 10, std::nullopt, false, areaA),
+           createNextHopFromAdj(
+               adj13, false, 10, std::nullopt, false, areaB)}));
+
+  // path in area B gets longer, route of area A wins
+  auto adj13Heavy = adj13;
+  adj13Heavy.metric = 20;
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue("1", 2, {adj13Heavy}, false, 0, areaB)}},
+      {},
+      {},
+      {},
+      std::string(""),
+      areaB));
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  ASSERT_EQ(2, routeDbDelta.unicastRoutesToUpdate.size());
+
+  routeDb = dumpRouteDb({"1"})["1"];
+  routeMap.clear();
+  fillRouteMap("1", routeMap, routeDb);
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr5))],
+      NextHops({createNextHopFromAdj(
+          adj12, false, 10, std::nullopt, false, areaA)}));
+}
+
 /**
  * Exhaustively RibPolicy feature in Decision. The intention here is to
  * verify the functionality of RibPolicy in Decision module. RibPolicy
@@ -4434,6 +4830,68 @@ TEST_F(DecisionTestFixture, BasicOperations) {
  * - Set the policy with 0 weight. See that route dis-appears
  * - Expire policy. Verify it triggers the route database change (undo policy)
  */
+//
+// Static unicast routes take precedence over computed routes and are
+// injected without any SPF run
+//
+TEST_F(DecisionTestFixture, StaticUnicastRoutes) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+  const auto spfRuns = fb303::fbData->getCounters()["decision.spf_runs.count"];
+
+  // static routes of a new prefix, and of addr2 overriding its computed route
+  thrift::NextHopThrift nh, nh1;
+  nh.address = toBinaryAddress(folly::IPAddressV6("fe80::1"));
+  nh1.address = toBinaryAddress(folly::IPAddressV6("fe80::2"));
+  thrift::RouteDatabaseDelta input;
+  input.unicastRoutesToUpdate = {
+      createUnicastRoute(addr2, {nh}), createUnicastRoute(addr3, {nh})};
+  sendStaticRoutesUpdate(input);
+
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  ASSERT_EQ(2, routeDbDelta.unicastRoutesToUpdate.size());
+  for (auto const& route : routeDbDelta.unicastRoutesToUpdate) {
+    EXPECT_TRUE(route.dest == addr2 or route.dest == addr3);
+    EXPECT_THAT(route.nextHops, testing::UnorderedElementsAre(nh));
+  }
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToDelete.size());
+  EXPECT_EQ(0, routeDbDelta.mplsRoutesToUpdate.size());
+  EXPECT_EQ(0, routeDbDelta.mplsRoutesToDelete.size());
+  EXPECT_EQ(
+      2, decision->getDecisionStaticRoutes().get()->unicastRoutes.size());
+
+  // updates are squashed: addr3 is updated and withdrawn, and static route
+  // of addr2 removed, falling back to its computed route
+  input.unicastRoutesToUpdate = {createUnicastRoute(addr3, {nh1})};
+  sendStaticRoutesUpdate(input);
+  input.unicastRoutesToUpdate.clear();
+  input.unicastRoutesToDelete = {addr2, addr3};
+  sendStaticRoutesUpdate(input);
+
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(addr2, routeDbDelta.unicastRoutesToUpdate.at(0).dest);
+  EXPECT_THAT(
+      routeDbDelta.unicastRoutesToUpdate.at(0).nextHops,
+      testing::UnorderedElementsAre(createNextHopFromAdj(adj12, false, 10)));
+  EXPECT_THAT(
+      routeDbDelta.unicastRoutesToDelete, testing::UnorderedElementsAre(addr3));
+  EXPECT_EQ(
+      0, decision->getDecisionStaticRoutes().get()->unicastRoutes.size());
+
+  EXPECT_EQ(
+      spfRuns, fb303::fbData->getCounters()["decision.spf_runs.count"]);
+}
+
 TEST_F(DecisionTestFixture, RibPolicy) {
   // Setup topology and prefixes. 1 unicast route will be computed
   auto publication = createThriftPublication(
@@ -4508,6 +4966,70 @@ TEST_F(DecisionTestFixture, RibPolicy) {
   }
 }
 
+/**
+ * Verifies that policy change only re-derives routes of prefixes whose policy
+ * statement or action changed
+ */
+TEST_F(DecisionTestFixture, RibPolicyIncrementalUpdate) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2, addr5})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  EXPECT_EQ(2, recvMyRouteDb("1", serializer).unicastRoutesToUpdate.size());
+
+  auto createStatement = [](thrift::IpPrefix const& prefix, int32_t weight) {
+    thrift::RibRouteActionWeight actionWeight;
+    actionWeight.area_to_weight.emplace(kDefaultArea, weight);
+    thrift::RibPolicyStatement policyStatement;
+    policyStatement.matcher.prefixes_ref() =
+        std::vector<thrift::IpPrefix>({prefix});
+    policyStatement.action.set_weight_ref() = actionWeight;
+    return policyStatement;
+  };
+
+  thrift::RibPolicy policy;
+  policy.statements.emplace_back(createStatement(addr2, 2));
+  policy.ttl_secs = 10;
+  EXPECT_NO_THROW(decision->setRibPolicy(policy).get());
+  {
+    auto updates = recvMyRouteDb("1", serializer);
+    ASSERT_EQ(1, updates.unicastRoutesToUpdate.size());
+    EXPECT_EQ(addr2, updates.unicastRoutesToUpdate.at(0).dest);
+    EXPECT_EQ(2, updates.unicastRoutesToUpdate.at(0).nextHops.at(0).weight);
+  }
+
+  // Same action for addr2 in new policy, only addr5 is updated
+  policy.statements.emplace_back(createStatement(addr5, 3));
+  EXPECT_NO_THROW(decision->setRibPolicy(policy).get());
+  {
+    auto updates = recvMyRouteDb("1", serializer);
+    ASSERT_EQ(1, updates.unicastRoutesToUpdate.size());
+    EXPECT_EQ(addr5, updates.unicastRoutesToUpdate.at(0).dest);
+    EXPECT_EQ(3, updates.unicastRoutesToUpdate.at(0).nextHops.at(0).weight);
+    EXPECT_EQ(0, updates.unicastRoutesToDelete.size());
+  }
+
+  // Drop statement of addr2, only addr2 is reverted
+  policy.statements.erase(policy.statements.begin());
+  EXPECT_NO_THROW(decision->setRibPolicy(policy).get());
+  {
+    auto updates = recvMyRouteDb("1", serializer);
+    ASSERT_EQ(1, updates.unicastRoutesToUpdate.size());
+    EXPECT_EQ(addr2, updates.unicastRoutesToUpdate.at(0).dest);
+    EXPECT_EQ(0, updates.unicastRoutesToUpdate.at(0).nextHops.at(0).weight);
+  }
+
+  // Routes match full route computation with policy applied
+  auto routeDb = dumpRouteDb({"1"})["1"];
+  EXPECT_EQ(3, routeDb.unicastRoutes.size());
+}
+
 /**
  * Verifies that error is set if RibPolicy is invalid
  */
@@ -4531,9 +5053,10 @@ TEST(Decision, RibPolicyFeatureKnob) {
   auto config = std::make_shared<Config>(tConfig);
   ASSERT_FALSE(config->isRibPolicyEnabled());
 
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<KvStorePublication> kvStoreUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue;
   fbzmq::Context zeromqContext;
   auto decision = std::make_unique<Decision>(
       config,
@@ -4544,6 +5067,7 @@ TEST(Decision, RibPolicyFeatureKnob) {
       kvStoreUpdatesQueue.getReader(),
       staticRoutesUpdateQueue.getReader(),
       routeUpdatesQueue,
+      decisionDbsUpdatesQueue,
       zeromqContext);
 
   // SET
@@ -4580,32 +5104,339 @@ TEST(Decision, RibPolicyFeatureKnob) {
 
 // The following topology is used:
 //
-//         100
-//  1--- ---------- 2
-//   \_           _/
-//      \_ ____ _/
-//          800
-
-// We upload parallel link 1---2 with the initial sync and later bring down the
-// one with lower metric. We then verify updated route database is received
+//  1 ---- 2
+//  |      |
+//  4 ---- 3
+//
+// After the initial sync, the metric of the remote link 2---3 is increased.
+// Only routes of prefixes announced by nodes whose shortest paths (from us or
+// a LFA neighbor) changed are recomputed, and the result matches a full
+// rebuild.
 //
 
-TEST_F(DecisionTestFixture, ParallelLinks) {
-  auto adj12_1 =
-      createAdjacency("2", "1/2-1", "2/1-1", "fe80::2", "192.168.0.2", 100, 0);
-  auto adj12_2 =
-      createAdjacency("2", "1/2-2", "2/1-2", "fe80::2", "192.168.0.2", 800, 0);
-  auto adj21_1 =
-      createAdjacency("1", "2/1-1", "1/2-1", "fe80::1", "192.168.0.1", 100, 0);
-  auto adj21_2 =
-      createAdjacency("1", "2/1-2", "1/2-2", "fe80::1", "192.168.0.1", 800, 0);
-
+TEST_F(DecisionTestFixture, IncrementalRouteRebuild) {
   auto publication = createThriftPublication(
-      {{"adj:1", createAdjValue("1", 1, {adj12_1, adj12_2})},
-       {"adj:2", createAdjValue("2", 1, {adj21_1, adj21_2})},
+      {{"adj:1", createAdjValue("1", 1, {adj12, adj14}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23}, false, 2)},
+       {"adj:3", createAdjValue("3", 1, {adj32, adj34}, false, 3)},
+       {"adj:4", createAdjValue("4", 1, {adj41, adj43}, false, 4)},
        {"prefix:1", createPrefixValue("1", 1, {addr1})},
-       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
-      {},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})},
+       {"prefix:4", createPrefixValue("4", 1, {addr4})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(3, routeDbDelta.unicastRoutesToUpdate.size());
+
+  auto const countersBefore = fb303::fbData->getCounters();
+
+  auto const adj23Heavy =
+      createAdjacency("3", "2/3", "3/2", "fe80::3", "192.168.0.3", 100, 100003);
+  auto const adj32Heavy =
+      createAdjacency("2", "3/2", "2/3", "fe80::2", "192.168.0.2", 100, 100002);
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 2, {adj21, adj23Heavy}, false, 2)},
+       {"adj:3", createAdjValue("3", 2, {adj32Heavy, adj34}, false, 3)}},
+      {},
+      {},
+      {},
+      std::string(""));
+  auto routeDbBefore = dumpRouteDb({"1"})["1"];
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+
+  // only the route to addr3 loses its nexthop via 2, as does the one to the
+  // node label of 3
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(addr3, routeDbDelta.unicastRoutesToUpdate.at(0).dest);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToDelete.size());
+  ASSERT_EQ(1, routeDbDelta.mplsRoutesToUpdate.size());
+  EXPECT_EQ(3, routeDbDelta.mplsRoutesToUpdate.at(0).topLabel);
+  EXPECT_EQ(0, routeDbDelta.mplsRoutesToDelete.size());
+
+  auto routeDb = dumpRouteDb({"1"})["1"];
+  auto routeDelta = findDeltaRoutes(routeDb, routeDbBefore);
+  EXPECT_TRUE(checkEqualRoutesDelta(routeDbDelta, routeDelta));
+
+  RouteMap routeMap;
+  fillRouteMap("1", routeMap, routeDb);
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr3))],
+      NextHops({createNextHopFromAdj(adj14, false, 20)}));
+
+  // 3 changed for us, 3 and 4 for LFA neighbor 2 and 2 for LFA neighbor 4
+  auto const countersAfter = fb303::fbData->getCounters();
+  EXPECT_EQ(
+      1,
+      countersAfter.at("decision.incremental_route_build_runs.count.60") -
+          countersBefore.at("decision.incremental_route_build_runs.count.60"));
+  EXPECT_EQ(
+      3,
+      countersAfter.at("decision.incremental_prefixes_recomputed.sum.60") -
+          countersBefore.at("decision.incremental_prefixes_recomputed.sum.60"));
+  EXPECT_EQ(
+      3,
+      countersAfter.at("decision.incremental_labels_recomputed.sum.60") -
+          countersBefore.at("decision.incremental_labels_recomputed.sum.60"));
+
+  // delta is computed from the route journal only
+  EXPECT_EQ(
+      1,
+      countersAfter.at("decision.journaled_route_updates.count.60") -
+          countersBefore.at("decision.journaled_route_updates.count.60"));
+  EXPECT_EQ(
+      countersBefore.at("decision.route_db_inconsistencies.count.60"),
+      countersAfter.at("decision.route_db_inconsistencies.count.60"));
+}
+
+//
+// Same Decision, but with perf events of route computation phases
+//
+class PhasePerfEventsTestFixture : public DecisionTestFixture {
+ protected:
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = getBasicOpenrConfig("1");
+    tConfig.enable_decision_phase_perf_events_ref() = true;
+    return tConfig;
+  }
+};
+
+// Route update carries perf events of computation phases after the ones of
+// receiving and debouncing the update
+TEST_F(PhasePerfEventsTestFixture, PhasePerfEvents) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+
+  ASSERT_TRUE(routeDbDelta.perfEvents_ref().has_value());
+  std::vector<std::string> events;
+  for (auto const& event : routeDbDelta.perfEvents_ref()->events) {
+    events.emplace_back(event.eventDescr);
+  }
+  EXPECT_THAT(
+      events,
+      testing::ElementsAre(
+          "DECISION_RECEIVED",
+          "DECISION_DEBOUNCE",
+          "DECISION_ROUTE_BUILT",
+          "ROUTE_UPDATE",
+          "DECISION_RIB_POLICY",
+          "DECISION_ROUTE_DELTA"));
+}
+
+//
+// Same Decision, but waiting for cold start duration on startup
+//
+class ColdStartTestFixture : public DecisionTestFixture {
+ protected:
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = getBasicOpenrConfig("1");
+    tConfig.eor_time_s_ref() = 30;
+    return tConfig;
+  }
+};
+
+// Routes are published once KvStore signals initial sync of all areas,
+// without waiting for the whole cold start duration
+TEST_F(ColdStartTestFixture, InitialSyncColdStart) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  thrift::Publication initialSyncPub;
+  initialSyncPub.area_ref() = kDefaultArea;
+  initialSyncPub.initialSyncDone_ref() = true;
+  const auto startTime = std::chrono::steady_clock::now();
+  sendKvPublication(initialSyncPub);
+
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_GT(
+      std::chrono::seconds(30), std::chrono::steady_clock::now() - startTime);
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters.at("decision.initial_sync_cold_start.count"));
+}
+
+//
+// Same Decision, but computing routes on a worker thread
+//
+class AsyncRouteBuildTestFixture : public DecisionTestFixture {
+ protected:
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = getBasicOpenrConfig("1");
+    tConfig.enable_async_route_build_ref() = true;
+    return tConfig;
+  }
+};
+
+// Routes computed on the worker are published, and Decision keeps answering
+// queries and absorbing updates for the next computation
+TEST_F(AsyncRouteBuildTestFixture, AsyncRouteBuild) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+
+  // update absorbed while (or after) computing previous routes is processed
+  publication = createThriftPublication(
+      {{"prefix:2", createPrefixValue("2", 2, {addr2, addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  EXPECT_EQ(2, decision->getDecisionAdjacencyDbs().get()->size());
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+
+  auto routeDb = dumpRouteDb({"1"})["1"];
+  EXPECT_EQ(2, routeDb.unicastRoutes.size());
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_LE(2, counters.at("decision.async_route_builds.count"));
+}
+
+//
+// Same Decision, but publishing routes with shared nexthop groups
+//
+class NextHopGroupsTestFixture : public DecisionTestFixture {
+ protected:
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = getBasicOpenrConfig("1");
+    tConfig.enable_nexthop_groups_ref() = true;
+    return tConfig;
+  }
+};
+
+// The following topology is used:
+//
+// 2---1---3
+//
+// 2 announces addr2 and addr5, 3 announces addr3. Expect routes towards 2 to
+// share one group, announced once, and the group to be withdrawn along with
+// its last route.
+//
+TEST_F(NextHopGroupsTestFixture, SharedNextHopGroups) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12, adj13})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"adj:3", createAdjValue("3", 1, {adj31})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2, addr5})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+
+  ASSERT_EQ(3, routeDbDelta.unicastRoutesToUpdate.size());
+  ASSERT_EQ(2, routeDbDelta.nextHopGroupsToUpdate.size());
+  EXPECT_EQ(0, routeDbDelta.nextHopGroupsToDelete.size());
+  std::unordered_map<thrift::IpPrefix, int64_t> prefixToGroup;
+  for (auto const& route : routeDbDelta.unicastRoutesToUpdate) {
+    EXPECT_EQ(0, route.nextHops.size());
+    ASSERT_TRUE(route.nextHopGroupId_ref().has_value());
+    prefixToGroup.emplace(route.dest, *route.nextHopGroupId_ref());
+  }
+  EXPECT_EQ(prefixToGroup.at(addr2), prefixToGroup.at(addr5));
+  EXPECT_NE(prefixToGroup.at(addr2), prefixToGroup.at(addr3));
+  EXPECT_THAT(
+      routeDbDelta.nextHopGroupsToUpdate.at(prefixToGroup.at(addr2)),
+      testing::UnorderedElementsAre(createNextHopFromAdj(adj12, false, 10)));
+  EXPECT_THAT(
+      routeDbDelta.nextHopGroupsToUpdate.at(prefixToGroup.at(addr3)),
+      testing::UnorderedElementsAre(createNextHopFromAdj(adj13, false, 10)));
+
+  // withdraw addr5, the group is still used by addr2
+  publication = createThriftPublication(
+      {{"prefix:2", createPrefixValue("2", 2, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_THAT(
+      routeDbDelta.unicastRoutesToDelete, testing::ElementsAre(addr5));
+  EXPECT_EQ(0, routeDbDelta.nextHopGroupsToUpdate.size());
+  EXPECT_EQ(0, routeDbDelta.nextHopGroupsToDelete.size());
+
+  // withdraw addr2 as well, the group goes away with it
+  publication = createThriftPublication(
+      {{"prefix:2",
+        createPrefixValue("2", 3, std::vector<thrift::IpPrefix>{})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_THAT(
+      routeDbDelta.unicastRoutesToDelete, testing::ElementsAre(addr2));
+  EXPECT_EQ(0, routeDbDelta.nextHopGroupsToUpdate.size());
+  EXPECT_THAT(
+      routeDbDelta.nextHopGroupsToDelete,
+      testing::ElementsAre(prefixToGroup.at(addr2)));
+}
+
+// The following topology is used:
+//
+//         100
+//  1--- ---------- 2
+//   \_           _/
+//      \_ ____ _/
+//          800
+
+// We upload parallel link 1---2 with the initial sync and later bring down the
+// one with lower metric. We then verify updated route database is received
+//
+
+TEST_F(DecisionTestFixture, ParallelLinks) {
+  auto adj12_1 =
+      createAdjacency("2", "1/2-1", "2/1-1", "fe80::2", "192.168.0.2", 100, 0);
+  auto adj12_2 =
+      createAdjacency("2", "1/2-2", "2/1-2", "fe80::2", "192.168.0.2", 800, 0);
+  auto adj21_1 =
+      createAdjacency("1", "2/1-1", "1/2-1", "fe80::1", "192.168.0.1", 100, 0);
+  auto adj21_2 =
+      createAdjacency("1", "2/1-2", "1/2-2", "fe80::1", "192.168.0.1", 800, 0);
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12_1, adj12_2})},
+       {"adj:2", createAdjValue("2", 1, {adj21_1, adj21_2})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
       {},
       {},
       std::string(""));
@@ -4692,6 +5523,149 @@ TEST_F(DecisionTestFixture, ParallelLinks) {
       NextHops({createNextHopFromAdj(adj12_2, false, 800)}));
 }
 
+//
+// Node 2 advertises its parallel adjacencies with per adjacency keys, which
+// must be applied on top of its adjacency database key
+//
+TEST_F(DecisionTestFixture, PerAdjacencyKeys) {
+  auto adj12_1 =
+      createAdjacency("2", "1/2-1", "2/1-1", "fe80::2", "192.168.0.2", 100, 0);
+  auto adj12_2 =
+      createAdjacency("2", "1/2-2", "2/1-2", "fe80::2", "192.168.0.2", 800, 0);
+  auto adj21_1 =
+      createAdjacency("1", "2/1-1", "1/2-1", "fe80::1", "192.168.0.1", 100, 0);
+  auto adj21_2 =
+      createAdjacency("1", "2/1-2", "1/2-2", "fe80::1", "192.168.0.1", 800, 0);
+  const auto key21_1 = PerAdjacencyKey("2", "1", "2/1-1").getAdjacencyKey();
+  const auto key21_2 = PerAdjacencyKey("2", "1", "2/1-2").getAdjacencyKey();
+
+  auto getNextHopsToNode2 = [&]() {
+    RouteMap routeMap;
+    fillRouteMap("1", routeMap, dumpRouteDb({"1"})["1"]);
+    return routeMap[make_pair("1", toString(addr2))];
+  };
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12_1, adj12_2})},
+       {"adj:2", createAdjValue("2", 1, {})},
+       {key21_1, createAdjValue("2", 1, {adj21_1})},
+       {key21_2, createAdjValue("2", 1, {adj21_2})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      getNextHopsToNode2(),
+      NextHops({createNextHopFromAdj(adj12_1, false, 100),
+                createNextHopFromAdj(adj12_2, false, 800)}));
+
+  // withdraw adjacency with empty per adjacency key
+  publication = createThriftPublication(
+      {{key21_1, createAdjValue("2", 2, {})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      getNextHopsToNode2(),
+      NextHops({createNextHopFromAdj(adj12_2, false, 800)}));
+
+  // re-advertise adjacency
+  publication = createThriftPublication(
+      {{key21_1, createAdjValue("2", 3, {adj21_1})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      getNextHopsToNode2(),
+      NextHops({createNextHopFromAdj(adj12_1, false, 100),
+                createNextHopFromAdj(adj12_2, false, 800)}));
+
+  // update of adjacency database key keeps per key adjacencies, and expiry
+  // of per adjacency key withdraws the adjacency
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 2, {})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  publication =
+      createThriftPublication({}, {key21_2}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      getNextHopsToNode2(),
+      NextHops({createNextHopFromAdj(adj12_1, false, 100)}));
+
+  // expiry of adjacency database key deletes all adjacencies of the node
+  publication =
+      createThriftPublication({}, {"adj:2"}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToDelete.size());
+}
+
+//
+// Verify that changes of adjacency and prefix databases are published along
+// with the snapshot of databases
+//
+TEST_F(DecisionTestFixture, DecisionDbsUpdates) {
+  auto dbsUpdatesReader = decisionDbsUpdatesQueue.getReader();
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  auto dbsDelta = dbsUpdatesReader.get().value();
+  EXPECT_EQ(2, dbsDelta.adjDbsToUpdate.size());
+  EXPECT_EQ(0, dbsDelta.adjDbsToDelete.size());
+  EXPECT_EQ(2, dbsDelta.prefixDbsToUpdate.size());
+  EXPECT_EQ(0, dbsDelta.prefixDbsToDelete.size());
+
+  auto dbs = decision->getDecisionDbs().get();
+  EXPECT_EQ(2, dbs->adjDbs.size());
+  ASSERT_EQ(1, dbs->prefixDbs.count("2"));
+  EXPECT_EQ(1, dbs->prefixDbs.at("2").prefixEntries.size());
+
+  // expiry of keys of node 2 deletes its databases
+  publication = createThriftPublication(
+      {}, {"adj:2", "prefix:2"}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  dbsDelta = dbsUpdatesReader.get().value();
+  EXPECT_EQ(0, dbsDelta.adjDbsToUpdate.size());
+  EXPECT_EQ(std::vector<std::string>{"2"}, dbsDelta.adjDbsToDelete);
+  EXPECT_EQ(0, dbsDelta.prefixDbsToUpdate.size());
+  EXPECT_EQ(std::vector<std::string>{"2"}, dbsDelta.prefixDbsToDelete);
+
+  dbs = decision->getDecisionDbs().get();
+  EXPECT_EQ(1, dbs->adjDbs.size());
+  EXPECT_EQ("1", dbs->adjDbs.at(0).thisNodeName);
+}
+
 // The following topology is used:
 //
 // 1---2---3---4
@@ -4699,6 +5673,153 @@ TEST_F(DecisionTestFixture, ParallelLinks) {
 // We upload the link 1---2 with the initial sync and later publish
 // the 2---3 & 3---4 link information. We expect it to trigger SPF only once.
 //
+//
+// Verify on-demand route computation is cached until routing state changes
+//
+TEST_F(DecisionTestFixture, ComputedRouteDbCache) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  fb303::fbData->resetAllData();
+  auto routeDb = dumpRouteDb({"2"})["2"];
+  EXPECT_EQ(1, routeDb.unicastRoutes.size());
+  EXPECT_EQ(routeDb, dumpRouteDb({"2"})["2"]);
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters["decision.computed_route_db.builds.count"]);
+  EXPECT_EQ(1, counters["decision.computed_route_db.cache_hits.count"]);
+
+  // New prefix invalidates the cache
+  publication = createThriftPublication(
+      {{"prefix:1", createPrefixValue("1", 2, {addr1, addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  routeDb = dumpRouteDb({"2"})["2"];
+  EXPECT_EQ(2, routeDb.unicastRoutes.size());
+
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(2, counters["decision.computed_route_db.builds.count"]);
+  EXPECT_EQ(1, counters["decision.computed_route_db.cache_hits.count"]);
+}
+
+//
+// Ring 1---2---3---1. Simulated changes yield the route delta, leaving the
+// computed routes untouched
+//
+TEST_F(DecisionTestFixture, RouteDbDeltaWhatIf) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12, adj13})},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23})},
+       {"adj:3", createAdjValue("3", 1, {adj31, adj32})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+  const auto routeDb = dumpRouteDb({"1"})["1"];
+  EXPECT_EQ(2, routeDb.unicastRoutes.size());
+
+  auto findRoute = [](thrift::RouteDatabaseDelta const& delta,
+                      thrift::IpPrefix const& prefix) {
+    return std::find_if(
+        delta.unicastRoutesToUpdate.begin(),
+        delta.unicastRoutesToUpdate.end(),
+        [&prefix](auto const& route) { return route.dest == prefix; });
+  };
+
+  // removing link 1---2 moves route to 2 onto 3
+  {
+    thrift::TopologyChange change;
+    change.type = thrift::TopologyChangeType::REMOVE_LINK;
+    change.nodeName = "1";
+    change.ifName_ref() = "1/2";
+    auto delta = decision->getDecisionRouteDbDeltaWhatIf("", {change}).get();
+    EXPECT_EQ("1", delta->thisNodeName);
+    EXPECT_EQ(0, delta->unicastRoutesToDelete.size());
+    auto route = findRoute(*delta, addr2);
+    ASSERT_NE(delta->unicastRoutesToUpdate.end(), route);
+    ASSERT_EQ(1, route->nextHops.size());
+    EXPECT_EQ("1/3", route->nextHops.at(0).address.ifName_ref().value());
+  }
+
+  // removing node 2 withdraws its prefix
+  {
+    thrift::TopologyChange change;
+    change.type = thrift::TopologyChangeType::REMOVE_NODE;
+    change.nodeName = "2";
+    auto delta = decision->getDecisionRouteDbDeltaWhatIf("", {change}).get();
+    EXPECT_EQ(findRoute(*delta, addr2), delta->unicastRoutesToUpdate.end());
+    ASSERT_EQ(1, delta->unicastRoutesToDelete.size());
+    EXPECT_EQ(addr2, delta->unicastRoutesToDelete.at(0));
+  }
+
+  // changes of another node, applied in order
+  {
+    thrift::TopologyChange metricChange;
+    metricChange.type = thrift::TopologyChangeType::SET_LINK_METRIC;
+    metricChange.nodeName = "2";
+    metricChange.ifName_ref() = "2/3";
+    metricChange.metric_ref() = 100;
+    thrift::TopologyChange overloadChange;
+    overloadChange.type = thrift::TopologyChangeType::OVERLOAD_NODE;
+    overloadChange.nodeName = "1";
+    auto delta = decision
+                     ->getDecisionRouteDbDeltaWhatIf(
+                         "2", {metricChange, overloadChange})
+                     .get();
+    EXPECT_EQ("2", delta->thisNodeName);
+    // 3 is reached over the costlier direct link, 1 carries no transit
+    auto route = findRoute(*delta, addr3);
+    ASSERT_NE(delta->unicastRoutesToUpdate.end(), route);
+    auto nextHop = std::find_if(
+        route->nextHops.begin(), route->nextHops.end(), [](auto const& nh) {
+          return nh.address.ifName_ref().value() == "2/3";
+        });
+    ASSERT_NE(route->nextHops.end(), nextHop);
+    EXPECT_EQ(100, nextHop->metric);
+    EXPECT_EQ(0, delta->unicastRoutesToDelete.size());
+  }
+
+  // no change, no delta
+  {
+    auto delta = decision->getDecisionRouteDbDeltaWhatIf("", {}).get();
+    EXPECT_EQ(0, delta->unicastRoutesToUpdate.size());
+    EXPECT_EQ(0, delta->unicastRoutesToDelete.size());
+  }
+
+  // unknown link
+  {
+    thrift::TopologyChange change;
+    change.type = thrift::TopologyChangeType::OVERLOAD_LINK;
+    change.nodeName = "1";
+    change.ifName_ref() = "1/4";
+    EXPECT_THROW(
+        decision->getDecisionRouteDbDeltaWhatIf("", {change}).get(),
+        thrift::OpenrError);
+  }
+
+  // live routes are left untouched
+  EXPECT_EQ(routeDb, dumpRouteDb({"1"})["1"]);
+}
+
 TEST_F(DecisionTestFixture, PubDebouncing) {
   //
   // publish the link state info to KvStore
@@ -4922,6 +6043,59 @@ TEST_F(DecisionTestFixture, NoSpfOnDuplicatePublication) {
   EXPECT_EQ(2, counters["decision.spf_runs.count"]);
 }
 
+//
+// Isolated change of single adjacency is processed without debounce, while
+// burst of changes is debounced
+//
+TEST_F(DecisionTestFixture, DebounceFastPath) {
+  fb303::fbData->resetAllData();
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(0, counters["decision.debounce_fast_path.count"]);
+
+  // wait for quiet period, then change metric of single adjacency
+  auto adj21Metric20 = adj21;
+  adj21Metric20.metric = 20;
+  /* sleep override */
+  std::this_thread::sleep_for(2 * debounceTimeoutMax);
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 2, {adj21Metric20})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters["decision.debounce_fast_path.count"]);
+
+  // change right after is debounced
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 3, {adj21})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvMyRouteDb("1", serializer);
+
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters["decision.debounce_fast_path.count"]);
+  EXPECT_LT(0, counters["decision.debounce_ms.avg"]);
+}
+
 /**
  * Loop-alternate path testing. Topology is described as follows
  *          10
@@ -5359,7 +6533,12 @@ TEST_F(DecisionTestFixture, DecisionSubReliability) {
   auto counters = fb303::fbData->getCounters();
   EXPECT_EQ(4, counters["decision.spf_runs.count"]);
   EXPECT_EQ(adjUpdateCnt, counters["decision.adj_db_update.count"]);
-  EXPECT_EQ(prefixUpdateCnt, counters["decision.prefix_db_update.count"]);
+  // duplicates replacing a pending one are never deserialized
+  EXPECT_LT(0, counters["decision.skipped_deserializations.count"]);
+  EXPECT_EQ(
+      prefixUpdateCnt,
+      counters["decision.prefix_db_update.count"] +
+          counters["decision.skipped_deserializations.count"]);
 }
 
 /*
@@ -5464,6 +6643,53 @@ TEST_F(DecisionTestFixture, PerPrefixKeyExpiry) {
   EXPECT_EQ(addr5, routeDbDelta.unicastRoutesToDelete.at(0));
 }
 
+//
+// Expired per prefix keys are withdrawn per node, and all at once for an
+// originator left without keys
+//
+TEST_F(DecisionTestFixture, ExpiredOriginator) {
+  auto perPrefixKeyValue =
+      createPerPrefixKeyValue("2", 1, {addr2, addr5, addr6, addr1V4});
+  perPrefixKeyValue.emplace("adj:1", createAdjValue("1", 1, {adj12}));
+  perPrefixKeyValue.emplace("adj:2", createAdjValue("2", 1, {adj21}));
+  auto publication =
+      createThriftPublication(perPrefixKeyValue, {}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(4, routeDbDelta.unicastRoutesToUpdate.size());
+
+  std::vector<std::string> prefixKeys;
+  for (auto const& [key, _] : perPrefixKeyValue) {
+    if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+      prefixKeys.emplace_back(key);
+    }
+  }
+  ASSERT_EQ(4, prefixKeys.size());
+
+  // expiry of some per prefix keys withdraws their prefixes only
+  publication = createThriftPublication(
+      {}, {prefixKeys.at(0), prefixKeys.at(1)}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(2, routeDbDelta.unicastRoutesToDelete.size());
+
+  // expiry of all keys of an originator withdraws all of its prefixes
+  const auto numExpiredOriginators =
+      fb303::fbData->getCounters()["decision.expired_originators.count"];
+  publication = createThriftPublication(
+      {}, {prefixKeys.at(2), prefixKeys.at(3)}, {}, {}, std::string(""));
+  publication.expiredOriginators_ref() = std::vector<std::string>{"2"};
+  sendKvPublication(publication);
+  routeDbDelta = recvMyRouteDb("1", serializer);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(2, routeDbDelta.unicastRoutesToDelete.size());
+  EXPECT_EQ(
+      numExpiredOriginators + 1,
+      fb303::fbData->getCounters()["decision.expired_originators.count"]);
+  EXPECT_EQ(0, dumpRouteDb({"1"})["1"].unicastRoutes.size());
+}
+
 //
 // This test aims to verify counter reporting from Decision module
 //
@@ -5580,11 +6806,17 @@ TEST(DecisionPendingUpdates, needsFullRebuild) {
   EXPECT_FALSE(updates.needsFullRebuild());
   linkStateChange.linkAttributesChanged = false;
   linkStateChange.topologyChanged = true;
+  // remote topology changes only need affected routes to be rebuilt
   updates.applyLinkStateChange("node2", linkStateChange);
   EXPECT_TRUE(updates.needsRouteUpdate());
+  EXPECT_FALSE(updates.needsFullRebuild());
+  EXPECT_TRUE(updates.topologyChanged());
+  updates.applyLinkStateChange("node1", linkStateChange);
+  EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_TRUE(updates.needsFullRebuild());
 
   updates.reset();
+  EXPECT_FALSE(updates.topologyChanged());
   linkStateChange.topologyChanged = false;
   linkStateChange.nodeLabelChanged = true;
   updates.applyLinkStateChange("node2", linkStateChange);
@@ -5,6 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <random>
+
+#include <folly/Format.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -82,6 +85,81 @@ TEST(HoldableValueTest, BasicOperation) {
   EXPECT_EQ(5, hvLsm.value());
 }
 
+TEST(DijkstraQTest, DecreaseKey) {
+  openr::LinkState::NodeIdTable ids;
+  for (auto const& name : {"a", "b", "c", "d", "e", "f"}) {
+    ids.getOrAdd(name);
+  }
+  EXPECT_EQ(6, ids.size());
+  EXPECT_EQ(ids.getOrAdd("c"), ids.find("c"));
+  EXPECT_EQ("c", ids.name(*ids.find("c")));
+  EXPECT_FALSE(ids.find("g").has_value());
+
+  openr::DijkstraQ q(ids);
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(nullptr, q.extractMin());
+
+  openr::LinkStateMetric metric = 10;
+  for (auto const& name : {"a", "b", "c", "d", "e", "f"}) {
+    q.insertNode(*ids.find(name), metric);
+    metric += 10;
+  }
+  EXPECT_EQ(6, q.size());
+
+  // lower e below every other node
+  auto e = q.get(*ids.find("e"));
+  ASSERT_NE(nullptr, e);
+  e->result.reset(5);
+  q.decreaseKey(*e);
+
+  // tie with b should be broken on node name
+  auto f = q.get(*ids.find("f"));
+  ASSERT_NE(nullptr, f);
+  f->result.reset(20);
+  q.decreaseKey(*f);
+
+  std::vector<std::pair<std::string, openr::LinkStateMetric>> order;
+  while (auto node = q.extractMin()) {
+    order.emplace_back(ids.name(node->nodeId), node->result.metric());
+    // extracted nodes are no longer queued
+    EXPECT_EQ(nullptr, q.get(node->nodeId));
+  }
+  EXPECT_THAT(
+      order,
+      ElementsAre(
+          Pair("e", 5),
+          Pair("a", 10),
+          Pair("b", 20),
+          Pair("f", 20),
+          Pair("c", 30),
+          Pair("d", 40)));
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(FirstHopSetTest, BasicOperation) {
+  openr::LinkState::FirstHopSet set;
+  EXPECT_TRUE(set.empty());
+
+  set.insert(3);
+  set.insert(1);
+  EXPECT_FALSE(set.empty());
+  EXPECT_EQ(0, set.externalBytes());
+
+  // more than 64 first hops spill out of line
+  openr::LinkState::FirstHopSet other;
+  other.insert(100);
+  other.insert(3);
+  set.merge(other);
+  EXPECT_LT(0, set.externalBytes());
+
+  std::vector<size_t> indices;
+  set.forEach([&](size_t index) { indices.push_back(index); });
+  EXPECT_THAT(indices, ElementsAre(1, 3, 100));
+
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
 TEST(LinkTest, BasicOperation) {
   std::string n1 = "node1";
   auto adj1 =
@@ -136,6 +214,38 @@ TEST(LinkTest, BasicOperation) {
   EXPECT_TRUE(l1 < l3 || l3 < l1);
 }
 
+TEST(LinkTest, CompactLayout) {
+  std::string n1 = "node1";
+  auto adj1 =
+      openr::createAdjacency(n1, "if1", "if2", "fe80::2", "10.0.0.2", 1, 1, 1);
+  std::string n2 = "node2";
+  auto adj2 =
+      openr::createAdjacency(n2, "if2", "if1", "fe80::1", "10.0.0.1", 1, 2, 1);
+
+  // names are interned, i.e. shared by links
+  openr::Link l1(kDefaultArea, n1, adj1, n2, adj2);
+  openr::Link l2(kDefaultArea, n2, adj2, n1, adj1);
+  EXPECT_EQ(&l1.getArea(), &l2.getArea());
+  EXPECT_EQ(&l1.getIfaceFromNode(n1), &l2.getIfaceFromNode(n1));
+  EXPECT_EQ(&l1.getOtherNodeName(n1), &l2.getOtherNodeName(n1));
+  EXPECT_EQ(n1, l1.firstNodeName());
+  EXPECT_EQ(n1, l2.firstNodeName());
+  EXPECT_EQ(n2, l2.secondNodeName());
+  EXPECT_EQ(l1.hash, l2.hash);
+
+  // nexthop addresses held inline are read back as advertised
+  EXPECT_EQ(adj1.nextHopV4, l1.getNhV4FromNode(n1));
+  EXPECT_EQ(adj1.nextHopV6, l1.getNhV6FromNode(n1));
+  EXPECT_EQ(adj2.nextHopV4, l1.getNhV4FromNode(n2));
+  EXPECT_EQ(adj2.nextHopV6, l1.getNhV6FromNode(n2));
+
+  auto nhV6 = openr::toBinaryAddress("fe80::20");
+  nhV6.ifName_ref() = "if1";
+  l1.setNhV6FromNode(n1, nhV6);
+  EXPECT_EQ(nhV6, l1.getNhV6FromNode(n1));
+  EXPECT_THROW(l1.getNhV6FromNode("node3"), std::invalid_argument);
+}
+
 TEST(LinkStateTest, BasicOperation) {
   std::string n1 = "node1";
   std::string n2 = "node2";
@@ -176,6 +286,7 @@ TEST(LinkStateTest, BasicOperation) {
   EXPECT_THAT(
       state.linksFromNode(n3), UnorderedElementsAre(Pointee(l2), Pointee(l3)));
   EXPECT_THAT(state.linksFromNode("node4"), testing::IsEmpty());
+  EXPECT_EQ(0, state.numPartialAdjacencies());
 
   EXPECT_FALSE(state.isNodeOverloaded(n1));
   adjDb1.isOverloaded = true;
@@ -192,11 +303,103 @@ TEST(LinkStateTest, BasicOperation) {
   EXPECT_THAT(state.linksFromNode(n2), UnorderedElementsAre(Pointee(l2)));
   EXPECT_THAT(
       state.linksFromNode(n3), UnorderedElementsAre(Pointee(l2), Pointee(l3)));
+  // adj21 of node2 is not reported back anymore
+  EXPECT_EQ(1, state.numPartialAdjacencies());
 
   EXPECT_TRUE(state.deleteAdjacencyDatabase(n1).topologyChanged);
   EXPECT_THAT(state.linksFromNode(n1), testing::IsEmpty());
   EXPECT_THAT(state.linksFromNode(n2), UnorderedElementsAre(Pointee(l2)));
   EXPECT_THAT(state.linksFromNode(n3), UnorderedElementsAre(Pointee(l2)));
+  EXPECT_EQ(2, state.numPartialAdjacencies());
+
+  EXPECT_TRUE(state.deleteAdjacencyDatabase(n2).topologyChanged);
+  EXPECT_EQ(0, state.numPartialAdjacencies());
+}
+
+TEST(LinkStateTest, UpdateAdjacencyDatabaseInPlace) {
+  std::string n1 = "node1";
+  std::string n2 = "node2";
+  auto adj12 =
+      openr::createAdjacency(n2, "if2", "if1", "fe80::2", "10.0.0.2", 1, 1, 1);
+  auto adj21 =
+      openr::createAdjacency(n1, "if1", "if2", "fe80::1", "10.0.0.1", 1, 1, 1);
+
+  openr::LinkState state{kDefaultArea};
+  state.updateAdjacencyDatabase(openr::createAdjDb(n1, {adj12}, 1), 0, 0);
+  state.updateAdjacencyDatabase(openr::createAdjDb(n2, {adj21}, 2), 0, 0);
+  ASSERT_EQ(1, state.linksFromNode(n1).size());
+  const auto link = *state.linksFromNode(n1).begin();
+
+  // attributes of existing link are updated on the same Link object
+  adj12.metric = 5;
+  adj12.adjLabel = 100;
+  adj12.nextHopV6 = openr::toBinaryAddress("fe80::20");
+  auto change =
+      state.updateAdjacencyDatabase(openr::createAdjDb(n1, {adj12}, 1), 0, 0);
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_TRUE(change.linkAttributesChanged);
+  ASSERT_EQ(1, state.linksFromNode(n1).size());
+  EXPECT_EQ(link, *state.linksFromNode(n1).begin());
+  EXPECT_EQ(5, link->getMetricFromNode(n1));
+  EXPECT_EQ(100, link->getAdjLabelFromNode(n1));
+  EXPECT_EQ(openr::toBinaryAddress("fe80::20"), link->getNhV6FromNode(n1));
+  EXPECT_EQ(5, state.getAdjacencyDatabases().at(n1).adjacencies.at(0).metric);
+
+  // unchanged adjacency is no change
+  change =
+      state.updateAdjacencyDatabase(openr::createAdjDb(n1, {adj12}, 1), 0, 0);
+  EXPECT_FALSE(change.topologyChanged);
+  EXPECT_FALSE(change.linkAttributesChanged);
+
+  // adjacency to other remote interface is of another link, which is down
+  // until reverse adjacency shows up
+  adj12.otherIfName = "if3";
+  change =
+      state.updateAdjacencyDatabase(openr::createAdjDb(n1, {adj12}, 1), 0, 0);
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_THAT(state.linksFromNode(n1), testing::IsEmpty());
+  EXPECT_THAT(state.linksFromNode(n2), testing::IsEmpty());
+}
+
+TEST(LinkStateTest, Holds) {
+  std::string n1 = "node1";
+  std::string n2 = "node2";
+  auto adj12 =
+      openr::createAdjacency(n2, "if2", "if1", "fe80::2", "10.0.0.2", 1, 1, 1);
+  auto adj21 =
+      openr::createAdjacency(n1, "if1", "if2", "fe80::1", "10.0.0.1", 1, 1, 1);
+  auto adjDb1 = openr::createAdjDb(n1, {adj12}, 1);
+  auto adjDb2 = openr::createAdjDb(n2, {adj21}, 2);
+
+  openr::LinkState state{kDefaultArea};
+  state.updateAdjacencyDatabase(adjDb1, 0, 0);
+  state.updateAdjacencyDatabase(adjDb2, 0, 0);
+  EXPECT_FALSE(state.hasHolds());
+
+  // overload of node is held
+  adjDb1.isOverloaded = true;
+  EXPECT_FALSE(state.updateAdjacencyDatabase(adjDb1, 2, 2).topologyChanged);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_FALSE(state.decrementHolds().topologyChanged);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_TRUE(state.decrementHolds().topologyChanged);
+  EXPECT_FALSE(state.hasHolds());
+  EXPECT_TRUE(state.isNodeOverloaded(n1));
+
+  // metric change of link is held
+  adjDb1.adjacencies.at(0).metric = 2;
+  EXPECT_FALSE(state.updateAdjacencyDatabase(adjDb1, 1, 1).topologyChanged);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_TRUE(state.decrementHolds().topologyChanged);
+  EXPECT_FALSE(state.hasHolds());
+
+  // held link is released once removed
+  adjDb1.adjacencies.at(0).metric = 3;
+  state.updateAdjacencyDatabase(adjDb1, 5, 5);
+  EXPECT_TRUE(state.hasHolds());
+  state.deleteAdjacencyDatabase(n1);
+  EXPECT_FALSE(state.hasHolds());
+  EXPECT_FALSE(state.decrementHolds().topologyChanged);
 }
 
 TEST(LinkStateTest, pathAInPathB) {
@@ -313,6 +516,243 @@ TEST(LinkStateTest, getKthPaths) {
       }
     }
   }
+
+  {
+    // ring with nodes farther away from 1 than 2, metric is hop count. SPF
+    // for second paths stops at 2, before reaching 5 and 6
+    //
+    //   1---2---5
+    //   |   |   |
+    //   3---4---6
+    //
+    auto linkState = openr::getLinkState({
+        {1, {2, 3}},
+        {2, {1, 4, 5}},
+        {3, {1, 4}},
+        {4, {2, 3, 6}},
+        {5, {2, 6}},
+        {6, {4, 5}},
+    });
+
+    auto firstPaths = linkState.getKthPaths("1", "2", 1);
+    EXPECT_THAT(firstPaths, ElementsAre(SizeIs(1)));
+
+    auto secondPaths = linkState.getKthPaths("1", "2", 2);
+    EXPECT_THAT(secondPaths, ElementsAre(SizeIs(3)));
+    std::string nextNode = "1";
+    for (auto const& link : secondPaths.at(0)) {
+      nextNode = link->getOtherNodeName(nextNode);
+    }
+    EXPECT_EQ(nextNode, "2");
+  }
+}
+
+TEST(LinkStateTest, SpfResult) {
+  //      10
+  //   1------2
+  //   |      |
+  //  5|      | 1
+  //   |      |
+  //   3------4   5
+  //      20
+  auto linkState = openr::getLinkState({
+      {1, {{2, 10}, {3, 5}}},
+      {2, {{1, 10}, {4, 1}}},
+      {3, {{1, 5}, {4, 20}}},
+      {4, {{2, 1}, {3, 20}}},
+      {5, {}},
+  });
+
+  auto const& spfResult = linkState.getSpfResult("1");
+  EXPECT_EQ(4, spfResult.size());
+  EXPECT_EQ(1, spfResult.count("4"));
+  EXPECT_EQ(0, spfResult.count("5"));
+  EXPECT_EQ(nullptr, spfResult.get("5"));
+  EXPECT_EQ(nullptr, spfResult.get("unknown"));
+  EXPECT_THROW(spfResult.at("5"), std::out_of_range);
+
+  EXPECT_EQ(0, spfResult.at("1").metric());
+  EXPECT_EQ(10, spfResult.at("2").metric());
+  EXPECT_EQ(5, spfResult.at("3").metric());
+  EXPECT_EQ(11, spfResult.at("4").metric());
+
+  // nexthops are translated back to node names via the result
+  auto const nextHops = spfResult.nextHops(spfResult.at("4"));
+  ASSERT_EQ(1, nextHops.size());
+  EXPECT_EQ("2", spfResult.nodeName(nextHops.at(0)));
+
+  auto const& pathLinks = spfResult.at("4").pathLinks();
+  ASSERT_EQ(1, pathLinks.size());
+  EXPECT_EQ("2", spfResult.nodeName(pathLinks.at(0).prevNode));
+
+  // settle order is by metric
+  std::vector<std::string> settled;
+  for (auto const id : spfResult.reachableNodes()) {
+    settled.emplace_back(spfResult.nodeName(id));
+  }
+  EXPECT_THAT(settled, ElementsAre("1", "3", "2", "4"));
+
+  // unknown source only reaches itself
+  auto const& unknownResult = linkState.getSpfResult("unknown");
+  EXPECT_EQ(1, unknownResult.size());
+  EXPECT_EQ(0, unknownResult.at("unknown").metric());
+}
+
+namespace {
+
+void
+expectSameSpfResult(
+    openr::LinkState::SpfResult const& expected,
+    openr::LinkState::SpfResult const& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    auto const expectedId = expected.reachableNodes().at(i);
+    auto const actualId = actual.reachableNodes().at(i);
+    auto const& nodeName = expected.nodeName(expectedId);
+    ASSERT_EQ(nodeName, actual.nodeName(actualId));
+    auto const& expectedNode = *expected.get(expectedId);
+    auto const& actualNode = *actual.get(actualId);
+    EXPECT_EQ(expectedNode.metric(), actualNode.metric()) << nodeName;
+    EXPECT_EQ(expected.nextHops(expectedNode), actual.nextHops(actualNode))
+        << nodeName;
+    ASSERT_EQ(expectedNode.pathLinks().size(), actualNode.pathLinks().size())
+        << nodeName;
+    for (size_t j = 0; j < expectedNode.pathLinks().size(); ++j) {
+      auto const& expectedLink = expectedNode.pathLinks().at(j);
+      auto const& actualLink = actualNode.pathLinks().at(j);
+      EXPECT_EQ(*expectedLink.link, *actualLink.link) << nodeName;
+      EXPECT_EQ(
+          expected.nodeName(expectedLink.prevNode),
+          actual.nodeName(actualLink.prevNode))
+          << nodeName;
+    }
+  }
+}
+
+} // namespace
+
+TEST(LinkStateTest, IncrementalSpf) {
+  using folly::sformat;
+  const int kNumNodes = 30;
+  std::mt19937 gen(0x1234);
+  std::uniform_int_distribution<int> nodeDist(0, kNumNodes - 1);
+  std::uniform_int_distribution<int> metricDist(1, 4);
+
+  // ring with random chords, parallel links included. small metric range to
+  // get plenty of ECMP
+  std::vector<std::vector<openr::thrift::Adjacency>> adjs(kNumNodes);
+  int numLinks = 0;
+  auto addLink = [&](int a, int b, int metric) {
+    auto const num = numLinks++;
+    adjs[a].push_back(openr::createAdjacency(
+        sformat("{}", b),
+        sformat("{}/{}/{}", a, b, num),
+        sformat("{}/{}/{}", b, a, num),
+        "fe80::1",
+        "192.168.0.1",
+        metric,
+        0));
+    adjs[b].push_back(openr::createAdjacency(
+        sformat("{}", a),
+        sformat("{}/{}/{}", b, a, num),
+        sformat("{}/{}/{}", a, b, num),
+        "fe80::1",
+        "192.168.0.1",
+        metric,
+        0));
+  };
+  for (int i = 0; i < kNumNodes; ++i) {
+    addLink(i, (i + 1) % kNumNodes, metricDist(gen));
+  }
+  for (int i = 0; i < kNumNodes; ++i) {
+    auto const a = nodeDist(gen), b = nodeDist(gen);
+    if (a != b) {
+      addLink(a, b, metricDist(gen));
+    }
+  }
+  // one overloaded node, which is not used for transit
+  const int kOverloadedNode = 7;
+
+  openr::LinkState full{kDefaultArea};
+  openr::LinkState incremental{kDefaultArea, true};
+  auto publish = [&](int node) {
+    auto const adjDb = openr::createAdjDb(
+        sformat("{}", node), adjs[node], node, node == kOverloadedNode);
+    EXPECT_EQ(
+        full.updateAdjacencyDatabase(adjDb),
+        incremental.updateAdjacencyDatabase(adjDb));
+  };
+  for (int i = 0; i < kNumNodes; ++i) {
+    publish(i);
+  }
+
+  const std::vector<std::string> sources{"0", "7", "13"};
+  auto verify = [&]() {
+    for (auto const& src : sources) {
+      for (bool useLinkMetric : {true, false}) {
+        expectSameSpfResult(
+            full.getSpfResult(src, useLinkMetric),
+            incremental.getSpfResult(src, useLinkMetric));
+      }
+    }
+  };
+
+  for (int i = 0; i < 500; ++i) {
+    // memoize results to be repaired
+    verify();
+    auto const node = nodeDist(gen);
+    auto& adj = adjs[node].at(gen() % adjs[node].size());
+    if (gen() % 3) {
+      adj.metric = metricDist(gen);
+    } else {
+      adj.isOverloaded = !adj.isOverloaded;
+    }
+    publish(node);
+  }
+  verify();
+}
+
+TEST(LinkStateTest, MemoizationBudget) {
+  // ring of nodes, metric is hop count
+  auto unbounded = openr::getLinkState({
+      {1, {2, 4}},
+      {2, {1, 3}},
+      {3, {2, 4}},
+      {4, {3, 1}},
+  });
+  const auto spfBytes1 = unbounded.getSpfResult("1").memoryUsage();
+  const auto spfBytes2 = unbounded.getSpfResult("2").memoryUsage();
+  EXPECT_EQ(spfBytes1 + spfBytes2, unbounded.getSpfResultsBytes());
+  unbounded.getKthPaths("1", "3", 2);
+  EXPECT_LT(0, unbounded.getKthPathResultsBytes());
+
+  // nothing is evicted without a budget
+  unbounded.evictMemoization();
+  EXPECT_EQ(spfBytes1 + spfBytes2, unbounded.getSpfResultsBytes());
+
+  // budget only fits one of the results
+  openr::LinkState bounded{
+      kDefaultArea, false, std::max(spfBytes1, spfBytes2)};
+  for (auto const& [_, adjDb] : unbounded.getAdjacencyDatabases()) {
+    bounded.updateAdjacencyDatabase(adjDb, 0, 0);
+  }
+  bounded.getSpfResult("2");
+  bounded.getSpfResult("1");
+  // last used one is kept
+  bounded.getSpfResult("2");
+  bounded.evictMemoization();
+  EXPECT_EQ(spfBytes2, bounded.getSpfResultsBytes());
+
+  // evicted results are recomputed on demand
+  EXPECT_EQ(
+      unbounded.getSpfResult("1").at("3").metric(),
+      bounded.getSpfResult("1").at("3").metric());
+  EXPECT_EQ(spfBytes1 + spfBytes2, bounded.getSpfResultsBytes());
+
+  // memoization is dropped on topology change
+  bounded.deleteAdjacencyDatabase("4");
+  EXPECT_EQ(0, bounded.getSpfResultsBytes());
+  EXPECT_EQ(0, bounded.getKthPathResultsBytes());
 }
 
 TEST(LinkStateTest, getHopCounts) {
@@ -93,6 +93,156 @@ TEST_F(PrefixStateTestFixture, basicOperation) {
       testing::UnorderedElementsAreArray(affectedPrefixes));
 }
 
+TEST_F(PrefixStateTestFixture, compiledMetricVector) {
+  auto prefixDb = prefixDbs_.at("0");
+  auto& prefixEntry = prefixDb.prefixEntries.at(0);
+  EXPECT_EQ(nullptr, state_.getCompiledMetricVector(prefixEntry.prefix, "0"));
+
+  // metric vector is compiled when entry is updated
+  thrift::MetricVector mv;
+  mv.metrics.emplace_back(MetricVectorUtils::createMetricEntity(
+      1, 1, thrift::CompareType::WIN_IF_PRESENT, false, {10}));
+  prefixEntry.mv_ref() = mv;
+  EXPECT_FALSE(state_.updatePrefixDatabase(prefixDb).empty());
+  auto const* compiled =
+      state_.getCompiledMetricVector(prefixEntry.prefix, "0");
+  ASSERT_NE(nullptr, compiled);
+  EXPECT_EQ(
+      MetricVectorUtils::CompareResult::TIE,
+      MetricVectorUtils::compareMetricVectors(
+          *compiled, MetricVectorUtils::compileMetricVector(mv)));
+  EXPECT_EQ(nullptr, state_.getCompiledMetricVector(prefixEntry.prefix, "1"));
+
+  // and forgotten when entry is withdrawn
+  thrift::PrefixDatabase emptyPrefixDb;
+  emptyPrefixDb.thisNodeName = "0";
+  EXPECT_FALSE(state_.updatePrefixDatabase(emptyPrefixDb).empty());
+  EXPECT_EQ(nullptr, state_.getCompiledMetricVector(prefixEntry.prefix, "0"));
+}
+
+TEST_F(PrefixStateTestFixture, updatePrefixDatabaseDelta) {
+  const auto version = state_.getNodeVersion("0");
+  EXPECT_LT(0, version);
+  EXPECT_EQ(0, state_.getNodeVersion("unknown"));
+
+  auto prefixDb = prefixDbs_.at("0");
+  const auto newEntry = createPrefixEntry(getAddrFromSeed(100, false));
+  const auto withdrawnPrefix = prefixDb.prefixEntries.at(0).prefix;
+
+  // delta on stale version is not applied
+  PrefixState::PrefixDatabaseDelta delta;
+  delta.thisNodeName = "0";
+  delta.baseVersion = version - 1;
+  delta.prefixEntriesToUpdate.emplace_back(newEntry);
+  delta.prefixesToWithdraw.emplace_back(withdrawnPrefix);
+  EXPECT_FALSE(state_.updatePrefixDatabaseDelta(delta).has_value());
+  EXPECT_EQ(version, state_.getNodeVersion("0"));
+  EXPECT_EQ(state_.getPrefixDatabases(), prefixDbs_);
+
+  // same result as replacing the full database
+  delta.baseVersion = version;
+  auto changed = state_.updatePrefixDatabaseDelta(delta);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_THAT(
+      *changed,
+      testing::UnorderedElementsAre(newEntry.prefix, withdrawnPrefix));
+  EXPECT_EQ(version + 1, state_.getNodeVersion("0"));
+
+  PrefixState fullState;
+  prefixDb.prefixEntries.erase(prefixDb.prefixEntries.begin());
+  prefixDb.prefixEntries.emplace_back(newEntry);
+  fullState.updatePrefixDatabase(prefixDb);
+  fullState.updatePrefixDatabase(prefixDbs_.at("1"));
+  EXPECT_EQ(fullState.prefixes(), state_.prefixes());
+  EXPECT_EQ(fullState.nodeToPrefixes(), state_.nodeToPrefixes());
+
+  // unchanged entries and unknown withdrawals are no change
+  delta.baseVersion = state_.getNodeVersion("0");
+  delta.prefixesToWithdraw = {withdrawnPrefix};
+  changed = state_.updatePrefixDatabaseDelta(delta);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_TRUE(changed->empty());
+
+  // withdrawing all prefixes forgets the node, but not its version
+  delta.baseVersion = state_.getNodeVersion("0");
+  delta.prefixEntriesToUpdate.clear();
+  delta.prefixesToWithdraw.clear();
+  for (auto const& entry : prefixDb.prefixEntries) {
+    delta.prefixesToWithdraw.emplace_back(entry.prefix);
+  }
+  changed = state_.updatePrefixDatabaseDelta(delta);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_EQ(prefixDb.prefixEntries.size(), changed->size());
+  EXPECT_EQ(0, state_.nodeToPrefixes().count("0"));
+  EXPECT_EQ(version + 3, state_.getNodeVersion("0"));
+}
+
+TEST_F(PrefixStateTestFixture, deleteNode) {
+  const auto version = state_.getNodeVersion("0");
+  std::unordered_set<thrift::IpPrefix> prefixes;
+  for (auto const& entry : prefixDbs_.at("0").prefixEntries) {
+    prefixes.insert(entry.prefix);
+  }
+
+  // same result as withdrawing the full database
+  EXPECT_THAT(
+      state_.deleteNode("0"), testing::UnorderedElementsAreArray(prefixes));
+  EXPECT_EQ(0, state_.nodeToPrefixes().count("0"));
+  EXPECT_EQ(version + 1, state_.getNodeVersion("0"));
+  auto expectedPrefixDbs = prefixDbs_;
+  expectedPrefixDbs.erase("0");
+  EXPECT_EQ(expectedPrefixDbs, state_.getPrefixDatabases());
+
+  // unknown nodes are no change
+  EXPECT_TRUE(state_.deleteNode("0").empty());
+  EXPECT_TRUE(state_.deleteNode("unknown").empty());
+  EXPECT_EQ(version + 1, state_.getNodeVersion("0"));
+}
+
+TEST(PrefixStateTest, maxPrefixesPerNode) {
+  PrefixState state(2);
+  const auto addr1 = toIpPrefix("10.0.0.1/32");
+  const auto addr2 = toIpPrefix("10.0.0.2/32");
+  const auto addr3 = toIpPrefix("10.0.0.3/32");
+
+  // lowest prefixes are kept
+  EXPECT_THAT(
+      state.updatePrefixDatabase(createPrefixDb(
+          "0",
+          {createPrefixEntry(addr3),
+           createPrefixEntry(addr1),
+           createPrefixEntry(addr2)})),
+      testing::UnorderedElementsAre(addr1, addr2));
+  EXPECT_EQ(2, state.nodeToPrefixes().at("0").size());
+  EXPECT_EQ(0, state.prefixes().count(IpPrefixKey(addr3)));
+
+  // limit is per node
+  EXPECT_FALSE(state.updatePrefixDatabase(createPrefixDb(
+                                             "1",
+                                             {createPrefixEntry(addr1),
+                                              createPrefixEntry(addr3)}))
+                   .empty());
+  EXPECT_EQ(2, state.nodeToPrefixes().at("1").size());
+
+  // delta can't add prefixes over the limit, but can replace withdrawn ones
+  PrefixState::PrefixDatabaseDelta delta;
+  delta.thisNodeName = "0";
+  delta.baseVersion = state.getNodeVersion("0");
+  delta.prefixEntriesToUpdate.emplace_back(createPrefixEntry(addr3));
+  auto changed = state.updatePrefixDatabaseDelta(delta);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_TRUE(changed->empty());
+
+  delta.baseVersion = state.getNodeVersion("0");
+  delta.prefixesToWithdraw.emplace_back(addr1);
+  changed = state.updatePrefixDatabaseDelta(delta);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_THAT(*changed, testing::UnorderedElementsAre(addr1, addr3));
+  EXPECT_EQ(
+      (std::set<IpPrefixKey>{IpPrefixKey(addr2), IpPrefixKey(addr3)}),
+      state.nodeToPrefixes().at("0"));
+}
+
 class GetLoopbackViasTest : public PrefixStateTestFixture,
                             public ::testing::WithParamInterface<bool> {};
 
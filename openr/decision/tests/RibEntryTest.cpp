@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+
+#include <folly/Format.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Util.h>
+#include <openr/decision/RibEntry.h>
+
+using namespace openr;
+
+namespace {
+
+const auto nh1 = createNextHop(toBinaryAddress("fe80::1"), "iface1", 1);
+const auto nh2 = createNextHop(toBinaryAddress("fe80::2"), "iface2", 1);
+const auto nh3 = createNextHop(toBinaryAddress("fe80::3"), "iface3", 1);
+
+} // namespace
+
+TEST(NextHopSetTest, BasicOperations) {
+  auto& table = NextHopTable::get();
+  const auto initialSize = table.size();
+  {
+    NextHopSet nexthops{nh1, nh2, nh1};
+    EXPECT_EQ(2, nexthops.size());
+    EXPECT_EQ(initialSize + 2, table.size());
+    EXPECT_THAT(nexthops, testing::UnorderedElementsAre(nh1, nh2));
+
+    // duplicates are not inserted
+    EXPECT_FALSE(nexthops.emplace(nh2).second);
+    EXPECT_TRUE(nexthops.emplace(nh3).second);
+    EXPECT_EQ(3, nexthops.size());
+    EXPECT_THAT(
+        nexthops.toThrift(), testing::UnorderedElementsAre(nh1, nh2, nh3));
+
+    // equal sets share the same ids regardless of insertion order
+    NextHopSet other{nh3, nh2, nh1};
+    EXPECT_EQ(nexthops, other);
+    EXPECT_EQ(initialSize + 3, table.size());
+    other.clear();
+    EXPECT_TRUE(other.empty());
+    EXPECT_NE(nexthops, other);
+
+    // copies and moves
+    NextHopSet copy = nexthops;
+    EXPECT_EQ(nexthops, copy);
+    NextHopSet moved = std::move(copy);
+    EXPECT_EQ(nexthops, moved);
+    other = moved;
+    EXPECT_EQ(nexthops, other);
+
+    // modified nexthops are interned separately
+    auto nh1Weighted = nh1;
+    nh1Weighted.weight = 2;
+    other.emplace(nh1Weighted);
+    EXPECT_EQ(4, other.size());
+    EXPECT_EQ(initialSize + 4, table.size());
+  }
+
+  // nexthops are released once no set refers to them
+  EXPECT_EQ(initialSize, table.size());
+}
+
+TEST(NextHopSetTest, RibEntryEquality) {
+  const auto prefix = folly::IPAddress::createNetwork("fc00::/64");
+  RibUnicastEntry entry1(prefix, {nh1, nh2});
+  RibUnicastEntry entry2(prefix, {nh2, nh1});
+  EXPECT_EQ(entry1, entry2);
+
+  entry2.nexthops.emplace(nh3);
+  EXPECT_FALSE(entry1 == entry2);
+
+  auto const route = entry1.toTUnicastRoute();
+  EXPECT_THAT(route.nextHops, testing::UnorderedElementsAre(nh1, nh2));
+}
+
+TEST(NextHopSetTest, ConcurrentAccess) {
+  const auto initialSize = NextHopTable::get().size();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < 1000; ++j) {
+        NextHopSet nexthops;
+        for (int k = 0; k < 8; ++k) {
+          nexthops.emplace(createNextHop(
+              toBinaryAddress(folly::sformat("fe80::{}", (i + j + k) % 64)),
+              "iface",
+              1));
+        }
+        NextHopSet copy = nexthops;
+        for (auto const& nexthop : copy) {
+          EXPECT_EQ("iface", nexthop.address.ifName_ref().value());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(initialSize, NextHopTable::get().size());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
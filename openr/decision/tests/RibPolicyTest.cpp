@@ -230,6 +230,68 @@ TEST(RibPolicy, ApplyAction) {
   }
 }
 
+TEST(RibPolicy, ChangedPrefixes) {
+  const auto prefix1 = toIpPrefix("fc01::/64");
+  const auto prefix2 = toIpPrefix("fc02::/64");
+  const auto prefix3 = toIpPrefix("fc03::/64");
+  const auto oldPolicy = RibPolicy(createPolicy(
+      {createPolicyStatement({prefix1, prefix2}, 1, {{"area1", 10}})}, 10));
+
+  // No change
+  EXPECT_TRUE(RibPolicy::getChangedPrefixes(&oldPolicy, &oldPolicy).empty());
+
+  // Policy added or removed
+  const std::unordered_set<folly::CIDRNetwork> allPrefixes{
+      toIPNetwork(prefix1), toIPNetwork(prefix2)};
+  EXPECT_EQ(allPrefixes, RibPolicy::getChangedPrefixes(nullptr, &oldPolicy));
+  EXPECT_EQ(allPrefixes, RibPolicy::getChangedPrefixes(&oldPolicy, nullptr));
+
+  // prefix1 keeps its action under another statement, prefix2 gets new
+  // action and prefix3 is newly matched
+  const auto newPolicy = RibPolicy(createPolicy(
+      {createPolicyStatement({prefix1}, 1, {{"area1", 10}}),
+       createPolicyStatement({prefix2, prefix3}, 1, {{"area1", 20}})},
+      10));
+  const std::unordered_set<folly::CIDRNetwork> changedPrefixes{
+      toIPNetwork(prefix2), toIPNetwork(prefix3)};
+  EXPECT_EQ(
+      changedPrefixes, RibPolicy::getChangedPrefixes(&oldPolicy, &newPolicy));
+}
+
+TEST(RibPolicy, StatementPrecedence) {
+  // fc01::/64 is matched by both statements, first one must win. Covering
+  // prefix fc00::/16 doesn't match more specific routes
+  const auto stmt1 =
+      createPolicyStatement({toIpPrefix("fc01::/64")}, 1, {{"area1", 10}});
+  const auto stmt2 = createPolicyStatement(
+      {toIpPrefix("fc01::/64"), toIpPrefix("fc00::/16")}, 1, {{"area1", 20}});
+  auto policy = RibPolicy(createPolicy({stmt1, stmt2}, 1));
+
+  const auto nh1 = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, false, "area1");
+
+  {
+    RibUnicastEntry entry(folly::IPAddress::createNetwork("fc01::/64"), {nh1});
+    EXPECT_TRUE(policy.match(entry));
+    EXPECT_TRUE(policy.applyAction(entry));
+    ASSERT_EQ(1, entry.nexthops.size());
+    EXPECT_EQ(10, entry.nexthops.begin()->weight);
+  }
+
+  {
+    RibUnicastEntry entry(folly::IPAddress::createNetwork("fc00::/16"), {nh1});
+    EXPECT_TRUE(policy.applyAction(entry));
+    ASSERT_EQ(1, entry.nexthops.size());
+    EXPECT_EQ(20, entry.nexthops.begin()->weight);
+  }
+
+  {
+    RibUnicastEntry entry(folly::IPAddress::createNetwork("fc00::/64"), {nh1});
+    EXPECT_FALSE(policy.match(entry));
+    EXPECT_FALSE(policy.applyAction(entry));
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -340,6 +340,7 @@ Dual::addChild(const std::string& child) noexcept {
     return;
   }
   children_.emplace(child);
+  ++childrenVersion_;
 }
 
 void
@@ -349,6 +350,7 @@ Dual::removeChild(const std::string& child) noexcept {
     return;
   }
   children_.erase(child);
+  ++childrenVersion_;
 }
 
 std::unordered_set<std::string>
@@ -377,16 +379,37 @@ Dual::hasValidRoute() const noexcept {
       info_.nexthop.has_value());
 }
 
-std::unordered_set<std::string>
-Dual::sptPeers() const noexcept {
-  if (not hasValidRoute()) {
-    // route not ready
-    return {};
+void
+Dual::refreshSptPeers() const noexcept {
+  const bool validRoute = hasValidRoute();
+  if (sptPeersCache_.validRoute == validRoute and
+      sptPeersCache_.nexthop == info_.nexthop and
+      sptPeersCache_.childrenVersion == childrenVersion_) {
+    return;
   }
 
-  auto peers = children();
-  peers.emplace(*info_.nexthop);
-  return peers;
+  sptPeersCache_.validRoute = validRoute;
+  sptPeersCache_.nexthop = info_.nexthop;
+  sptPeersCache_.childrenVersion = childrenVersion_;
+  sptPeersCache_.peers.clear();
+  // empty peers if route not ready
+  if (validRoute) {
+    sptPeersCache_.peers = children_;
+    sptPeersCache_.peers.emplace(*info_.nexthop);
+  }
+  ++sptPeersVersion_;
+}
+
+const std::unordered_set<std::string>&
+Dual::sptPeers() const noexcept {
+  refreshSptPeers();
+  return sptPeersCache_.peers;
+}
+
+uint64_t
+Dual::sptPeersVersion() const noexcept {
+  refreshSptPeers();
+  return sptPeersVersion_;
 }
 
 int64_t
@@ -799,22 +822,49 @@ DualNode::getSptRootId() const noexcept {
   return std::nullopt;
 }
 
-std::unordered_set<std::string>
+std::vector<std::string>
+DualNode::getSptRootIds() const noexcept {
+  std::vector<std::string> rootIds;
+  for (const auto& kv : duals_) {
+    if (kv.second.hasValidRoute()) {
+      rootIds.emplace_back(kv.first);
+    }
+  }
+  return rootIds;
+}
+
+const std::unordered_set<std::string>&
 DualNode::getSptPeers(const std::optional<std::string>& rootId) const noexcept {
+  static const std::unordered_set<std::string> kEmptyPeers;
   if (not rootId.has_value()) {
     // none rootId, return empty peers
-    return {};
+    return kEmptyPeers;
   }
 
   const auto dual = duals_.find(*rootId);
   if (dual == duals_.end()) {
     // rootId not discovered yet, return empty peers
-    return {};
+    return kEmptyPeers;
   }
 
   return dual->second.sptPeers();
 }
 
+uint64_t
+DualNode::getSptPeersVersion(
+    const std::optional<std::string>& rootId) const noexcept {
+  if (not rootId.has_value()) {
+    return 0;
+  }
+
+  const auto dual = duals_.find(*rootId);
+  if (dual == duals_.end()) {
+    return 0;
+  }
+
+  return dual->second.sptPeersVersion();
+}
+
 void
 DualNode::processDualMessages(const thrift::DualMessages& messages) {
   std::unordered_map<std::string, thrift::DualMessages> msgsToSend;
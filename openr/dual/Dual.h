@@ -9,8 +9,11 @@
 
 #include <functional>
 #include <limits>
+#include <optional>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <folly/Format.h>
 
@@ -218,7 +221,13 @@ class Dual {
 
   // get current spt peers (nexthop + children)
   // return empty-set if dual has no valid route
-  std::unordered_set<std::string> sptPeers() const noexcept;
+  // peers are cached, and rebuilt only when route validity, nexthop or
+  // children change
+  const std::unordered_set<std::string>& sptPeers() const noexcept;
+
+  // version of spt peers, bumped whenever they change. Lets users cache
+  // information derived from spt peers
+  uint64_t sptPeersVersion() const noexcept;
 
   // my node id
   const std::string nodeId;
@@ -274,6 +283,9 @@ class Dual {
   // clear counters to zero for a given neighbor
   void clearCounters(const std::string& neighbor) noexcept;
 
+  // rebuild cached spt peers if route validity, nexthop or children changed
+  void refreshSptPeers() const noexcept;
+
   // route-info towards root
   RouteInfo info_;
 
@@ -289,8 +301,19 @@ class Dual {
       const std::optional<std::string>& newNh)>
       nexthopCb_{nullptr};
 
-  // spt children
+  // spt children, and version bumped on every change
   std::unordered_set<std::string> children_;
+  uint64_t childrenVersion_{0};
+
+  // cached spt peers, along with the state they are built from
+  struct SptPeersCache {
+    bool validRoute{false};
+    std::optional<std::string> nexthop{std::nullopt};
+    uint64_t childrenVersion{0};
+    std::unordered_set<std::string> peers;
+  };
+  mutable SptPeersCache sptPeersCache_;
+  mutable uint64_t sptPeersVersion_{0};
 };
 
 /**
@@ -357,9 +380,17 @@ class DualNode {
   // return none if no ready SPT found
   std::optional<std::string> getSptRootId() const noexcept;
 
+  // all root-ids who have a valid-route, in ascending order
+  std::vector<std::string> getSptRootIds() const noexcept;
+
   // get SPT-peers for a given root-id
   // return empty-set if dual for root-id is not ready
-  std::unordered_set<std::string> getSptPeers(
+  const std::unordered_set<std::string>& getSptPeers(
+      const std::optional<std::string>& rootId) const noexcept;
+
+  // get version of SPT-peers for a given root-id, 0 if root-id is not
+  // discovered yet
+  uint64_t getSptPeersVersion(
       const std::optional<std::string>& rootId) const noexcept;
 
   // get route-info for a given root-id
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <deque>
+#include <map>
+#include <memory>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/dual/Dual.h>
+
+namespace {
+
+// number of roots in the fabric
+const size_t kNumRoots = 4;
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Dual node exchanging messages through a shared in-memory queue, so that
+ * topology can be converged synchronously
+ */
+class DualBenchmarkNode final : public DualNode {
+ public:
+  DualBenchmarkNode(
+      const std::string& nodeId,
+      bool isRoot,
+      std::deque<std::pair<std::string, thrift::DualMessages>>& msgQueue)
+      : DualNode(nodeId, isRoot), msgQueue_(msgQueue) {}
+
+  bool
+  sendDualMessages(
+      const std::string& neighbor,
+      const thrift::DualMessages& msgs) noexcept override {
+    msgQueue_.emplace_back(neighbor, msgs);
+    return true;
+  }
+
+  void
+  processNexthopChange(
+      const std::string& /* rootId */,
+      const std::optional<std::string>& /* oldNh */,
+      const std::optional<std::string>& /* newNh */) noexcept override {}
+
+ private:
+  std::deque<std::pair<std::string, thrift::DualMessages>>& msgQueue_;
+};
+
+/**
+ * Fabric of kNumRoots roots (spines), each connected to all leaves
+ */
+class DualFabric {
+ public:
+  explicit DualFabric(size_t numLeaves) {
+    for (size_t i = 0; i < kNumRoots; ++i) {
+      addNode(getRootName(i), true);
+    }
+    for (size_t i = 0; i < numLeaves; ++i) {
+      addNode(folly::sformat("leaf-{}", i), false);
+    }
+    for (size_t i = 0; i < kNumRoots; ++i) {
+      rootUp(i);
+    }
+  }
+
+  static std::string
+  getRootName(size_t i) {
+    return folly::sformat("root-{}", i);
+  }
+
+  // bring all links of the root up and converge
+  void
+  rootUp(size_t i) {
+    const auto root = getRootName(i);
+    for (auto& [name, node] : nodes_) {
+      if (not node->isRoot) {
+        node->peerUp(root, 1);
+        nodes_.at(root)->peerUp(name, 1);
+      }
+    }
+    converge();
+  }
+
+  // bring all links of the root down and converge
+  void
+  rootDown(size_t i) {
+    const auto root = getRootName(i);
+    for (auto& [name, node] : nodes_) {
+      if (not node->isRoot) {
+        node->peerDown(root);
+        nodes_.at(root)->peerDown(name);
+      }
+    }
+    converge();
+  }
+
+  // add leaves using the root as nexthop as its SPT children
+  void
+  addChildren(size_t i) {
+    const auto root = getRootName(i);
+    auto& dual = nodes_.at(root)->getDual(root);
+    for (auto& [name, node] : nodes_) {
+      auto info = node->getInfo(root);
+      if (not node->isRoot and info.has_value() and info->nexthop == root) {
+        dual.addChild(name);
+      }
+    }
+  }
+
+  DualBenchmarkNode&
+  getNode(const std::string& name) {
+    return *nodes_.at(name);
+  }
+
+ private:
+  void
+  addNode(const std::string& name, bool isRoot) {
+    nodes_.emplace(
+        name, std::make_unique<DualBenchmarkNode>(name, isRoot, msgQueue_));
+  }
+
+  // deliver messages until there is none in flight
+  void
+  converge() {
+    while (not msgQueue_.empty()) {
+      auto [neighbor, msgs] = std::move(msgQueue_.front());
+      msgQueue_.pop_front();
+      auto& node = nodes_.at(neighbor);
+      // drop messages sent over link which went down since
+      if (node->neighborUp(msgs.srcId)) {
+        node->processDualMessages(msgs);
+      }
+    }
+  }
+
+  std::deque<std::pair<std::string, thrift::DualMessages>> msgQueue_;
+  std::map<std::string, std::unique_ptr<DualBenchmarkNode>> nodes_;
+};
+
+/**
+ * Benchmark DUAL re-convergence on failure of the flood root (smallest
+ * root-id) of the fabric
+ */
+static void
+BM_DualRootFailure(uint32_t iters, size_t numLeaves) {
+  auto suspender = folly::BenchmarkSuspender();
+  DualFabric fabric(numLeaves);
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    fabric.rootDown(0);
+    suspender.rehire();
+    fabric.rootUp(0);
+  }
+}
+
+/**
+ * Benchmark SPT-peers lookup done by KvStore on every flooding, on the flood
+ * root having all leaves as SPT children
+ */
+static void
+BM_DualGetSptPeers(uint32_t iters, size_t numLeaves) {
+  auto suspender = folly::BenchmarkSuspender();
+  DualFabric fabric(numLeaves);
+  fabric.addChildren(0);
+  auto& root = fabric.getNode(DualFabric::getRootName(0));
+  const auto rootId = root.getSptRootId();
+  CHECK(rootId.has_value());
+  CHECK_EQ(numLeaves + 1, root.getSptPeers(rootId).size());
+
+  suspender.dismiss();
+  size_t numPeers{0};
+  for (uint32_t i = 0; i < iters; ++i) {
+    numPeers += root.getSptPeers(rootId).size();
+  }
+  folly::doNotOptimizeAway(numPeers);
+}
+
+// The parameter is number of leaves in the fabric
+BENCHMARK_PARAM(BM_DualRootFailure, 100);
+BENCHMARK_PARAM(BM_DualRootFailure, 1000);
+BENCHMARK_PARAM(BM_DualGetSptPeers, 100);
+BENCHMARK_PARAM(BM_DualGetSptPeers, 1000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -15,6 +15,7 @@
 #include <folly/io/async/EventBase.h>
 #include <openr/dual/Dual.h>
 
+#include <unordered_set>
 #include <vector>
 
 using namespace openr;
@@ -222,6 +223,41 @@ TEST(Dual, StateMachine) {
   EXPECT_EQ(sm.state, DualState::ACTIVE3);
 }
 
+// Test spt-peers are cached and version is bumped only on changes
+TEST(Dual, SptPeersCache) {
+  // not the root, no valid route
+  {
+    Dual dual("node1", "root", {{"root", 1}}, nullptr);
+    const auto version = dual.sptPeersVersion();
+    dual.addChild("node2");
+    EXPECT_TRUE(dual.sptPeers().empty());
+    EXPECT_EQ(version, dual.sptPeersVersion());
+  }
+
+  // root, always has valid route with nexthop to itself
+  {
+    Dual dual("root", "root", {}, nullptr);
+    EXPECT_EQ(std::unordered_set<std::string>{"root"}, dual.sptPeers());
+    const auto version = dual.sptPeersVersion();
+    EXPECT_EQ(version, dual.sptPeersVersion());
+    const auto* peers = &dual.sptPeers();
+
+    dual.addChild("node1");
+    EXPECT_EQ(
+        (std::unordered_set<std::string>{"root", "node1"}), dual.sptPeers());
+    EXPECT_LT(version, dual.sptPeersVersion());
+    // cache is rebuilt in place
+    EXPECT_EQ(peers, &dual.sptPeers());
+
+    const auto newVersion = dual.sptPeersVersion();
+    dual.removeChild("node2"); // non-existing child
+    EXPECT_EQ(newVersion, dual.sptPeersVersion());
+    dual.removeChild("node1");
+    EXPECT_EQ(std::unordered_set<std::string>{"root"}, dual.sptPeers());
+    EXPECT_LT(newVersion, dual.sptPeersVersion());
+  }
+}
+
 // Dual Implementation Test Node
 class DualTestNode final : public DualNode {
  public:
@@ -1023,6 +1059,47 @@ TEST_P(DualFixture, GridTest) {
   EXPECT_TRUE(multiFailureTest(flap));
 }
 
+/**
+ * Fabric Topology (2 X 2), both spines are roots
+ * All nodes should report both roots as ready, and only remaining root once
+ * one of them is isolated
+ */
+TEST_F(DualBaseFixture, SptRootIdsTest) {
+  for (int i = 0; i < 4; ++i) {
+    addNode(folly::sformat("n{}", i), i < 2);
+  }
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 2; j < 4; ++j) {
+      addLink(folly::sformat("n{}", i), folly::sformat("n{}", j), 1);
+    }
+  }
+
+  /* sleep override */
+  std::this_thread::sleep_for(syncms);
+  EXPECT_TRUE(validate());
+  for (const auto& [nodeId, node] : nodes) {
+    evb->runInEventBaseThreadAndWait([&, node = node]() {
+      EXPECT_EQ(
+          std::vector<std::string>({"n0", "n1"}), node->getSptRootIds());
+      EXPECT_EQ("n0", node->getSptRootId());
+    });
+  }
+
+  // isolate n0
+  peerDown("n0", "n2");
+  peerDown("n0", "n3");
+
+  /* sleep override */
+  std::this_thread::sleep_for(syncms);
+  for (const auto& nodeId : {"n2", "n3"}) {
+    auto node = nodes.at(nodeId);
+    evb->runInEventBaseThreadAndWait([&, node]() {
+      EXPECT_EQ(std::vector<std::string>({"n1"}), node->getSptRootIds());
+      EXPECT_EQ("n1", node->getSptRootId());
+    });
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
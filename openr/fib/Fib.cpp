@@ -9,7 +9,6 @@
 
 #include <fb303/ServiceData.h>
 #include <fbzmq/service/if/gen-cpp2/Monitor_types.h>
-#include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/MapUtil.h>
 #include <thrift/lib/cpp/protocol/TProtocolTypes.h>
@@ -17,23 +16,182 @@
 #include <thrift/lib/cpp2/async/HeaderClientChannel.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/StartupTimeline.h>
 #include <openr/common/Util.h>
 
 namespace fb303 = facebook::fb303;
 
+namespace {
+
+// Histogram bucket width of end-to-end convergence durations, in milliseconds
+const int64_t kConvergenceBucketWidthMs{10};
+
+// Bound on types of originating events, and on stages of each, with
+// convergence latency histograms. Latencies of others are not recorded
+const size_t kMaxConvergenceHistograms{32};
+
+openr::thrift::LatencyStats
+getLatencyStats(const openr::LatencyHistogram& histogram) {
+  openr::thrift::LatencyStats stats;
+  stats.count = histogram.getCount();
+  stats.p50 = histogram.getPercentile(50);
+  stats.p90 = histogram.getPercentile(90);
+  stats.p99 = histogram.getPercentile(99);
+  stats.max = histogram.getMax();
+  return stats;
+}
+
+void
+exportLatencyStats(
+    const std::string& prefix, const openr::LatencyHistogram& histogram) {
+  const auto stats = getLatencyStats(histogram);
+  facebook::fb303::fbData->setCounter(prefix + ".p50", stats.p50);
+  facebook::fb303::fbData->setCounter(prefix + ".p90", stats.p90);
+  facebook::fb303::fbData->setCounter(prefix + ".p99", stats.p99);
+  facebook::fb303::fbData->setCounter(prefix + ".max", stats.max);
+}
+
+// Add route (or remove it) to the index of every interface its nexthops go
+// through
+template <typename Key>
+void
+updateIfNameIndex(
+    std::unordered_map<std::string, std::unordered_set<Key>>& index,
+    const Key& key,
+    const std::vector<openr::thrift::NextHopThrift>& nextHops,
+    bool add) {
+  for (auto const& nextHop : nextHops) {
+    auto const ifName = nextHop.address.ifName_ref();
+    if (not ifName.has_value()) {
+      continue;
+    }
+    if (add) {
+      index[*ifName].emplace(key);
+      continue;
+    }
+    auto it = index.find(*ifName);
+    if (it != index.end()) {
+      it->second.erase(key);
+      if (it->second.empty()) {
+        index.erase(it);
+      }
+    }
+  }
+}
+
+// Approximate memory held by a route stored in route state
+size_t
+getNextHopsMemoryUsage(
+    const std::vector<openr::thrift::NextHopThrift>& nextHops) {
+  size_t bytes{0};
+  for (auto const& nextHop : nextHops) {
+    bytes += openr::getMemoryUsage(nextHop);
+  }
+  return bytes;
+}
+
+size_t
+getRouteMemoryUsage(const openr::thrift::UnicastRoute& route) {
+  return openr::getMemoryUsage(route.dest) + sizeof(route) +
+      getNextHopsMemoryUsage(route.nextHops);
+}
+
+size_t
+getRouteMemoryUsage(const openr::thrift::MplsRoute& route) {
+  return sizeof(uint32_t) + sizeof(route) +
+      getNextHopsMemoryUsage(route.nextHops);
+}
+
+// Minimum metric of (non-empty) nexthops
+int32_t
+getMinMetric(const std::vector<openr::thrift::NextHopThrift>& nextHops) {
+  return std::min_element(
+             nextHops.begin(),
+             nextHops.end(),
+             [](auto const& a, auto const& b) { return a.metric < b.metric; })
+      ->metric;
+}
+
+// Nexthops with only the attributes programmed in agent (e.g. no metric or
+// area, which are not reported back), in a deterministic order
+std::vector<openr::thrift::NextHopThrift>
+getProgrammedNextHops(
+    const std::vector<openr::thrift::NextHopThrift>& nextHops) {
+  std::vector<openr::thrift::NextHopThrift> programmedNextHops;
+  programmedNextHops.reserve(nextHops.size());
+  for (auto const& nextHop : nextHops) {
+    openr::thrift::NextHopThrift programmedNextHop;
+    programmedNextHop.address = nextHop.address;
+    programmedNextHop.weight = nextHop.weight;
+    programmedNextHop.mplsAction_ref().copy_from(nextHop.mplsAction_ref());
+    programmedNextHops.emplace_back(std::move(programmedNextHop));
+  }
+  std::sort(programmedNextHops.begin(), programmedNextHops.end());
+  return programmedNextHops;
+}
+
+template <typename Key, typename Shard>
+size_t
+getRouteShardIndex(
+    const std::vector<std::shared_ptr<const Shard>>& shards, const Key& key) {
+  return std::hash<Key>{}(key) % shards.size();
+}
+
+// Copy shards of the keys on first write, and update routes of the keys in
+// them from `routes`
+template <typename Key, typename Route>
+void
+updateRouteShards(
+    std::vector<std::shared_ptr<
+        const std::unordered_map<Key, std::shared_ptr<const Route>>>>& shards,
+    const std::unordered_map<Key, Route>& routes,
+    const std::vector<Key>& keys) {
+  using Shard = std::unordered_map<Key, std::shared_ptr<const Route>>;
+  std::unordered_map<size_t, std::shared_ptr<Shard>> copiedShards;
+  for (auto const& key : keys) {
+    const size_t index = getRouteShardIndex(shards, key);
+    auto& shard = copiedShards[index];
+    if (not shard) {
+      shard = std::make_shared<Shard>(*shards.at(index));
+      shards.at(index) = shard;
+    }
+    auto it = routes.find(key);
+    if (it != routes.end()) {
+      (*shard)[key] = std::make_shared<const Route>(it->second);
+    } else {
+      shard->erase(key);
+    }
+  }
+}
+
+} // namespace
+
 namespace openr {
 
+constexpr size_t Fib::kNumRoutePriorities;
+constexpr size_t Fib::kNumRouteSnapshotShards;
+
+Fib::RouteSnapshot::RouteSnapshot() {
+  for (size_t i = 0; i < kNumRouteSnapshotShards; ++i) {
+    unicastShards.emplace_back(std::make_shared<const UnicastShard>());
+    mplsShards.emplace_back(std::make_shared<const MplsShard>());
+  }
+}
+
 Fib::Fib(
     std::shared_ptr<const Config> config,
     int32_t thriftPort,
     std::chrono::seconds coldStartDuration,
     messaging::RQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue,
     messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+    messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue,
     const MonitorSubmitUrl& monitorSubmitUrl,
     KvStore* kvStore,
     fbzmq::Context& zmqContext)
-    : myNodeName_(config->getConfig().node_name),
+    : fibUpdatesQueue_(fibUpdatesQueue),
+      myNodeName_(config->getConfig().node_name),
       thriftPort_(thriftPort),
       expBackoff_(
           std::chrono::milliseconds(8), std::chrono::milliseconds(4096)),
@@ -45,18 +203,32 @@ Fib::Fib(
       config->getConfig().enable_segment_routing_ref().value_or(false);
   enableOrderedFib_ =
       config->getConfig().enable_ordered_fib_programming_ref().value_or(false);
+  warmStartPending_ =
+      config->getConfig().enable_fib_warm_start_ref().value_or(false);
 
   syncRoutesTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
-    if (routeState_.hasRoutesFromDecision) {
-      if (syncRouteDb()) {
-        hasSyncedFib_ = true;
-        expBackoff_.reportSuccess();
-      } else {
-        // Apply exponential backoff and schedule next run
-        expBackoff_.reportError();
-        syncRoutesTimer_->scheduleTimeout(
-            expBackoff_.getTimeRemainingUntilRetry());
+    if (not inflightBatches_.empty()) {
+      // Full sync must not race with route batches in flight, wait for them
+      syncRoutesTimer_->scheduleTimeout(
+          Constants::kFibInflightBatchWaitInterval);
+    } else if (not routeState_.hasRoutesFromDecision) {
+      // Nothing to sync yet
+    } else if (not routeState_.dirtyRouteDb and hasSyncedFib_) {
+      // Only routes which failed to program need to be synced
+      resyncUnsyncedRoutes();
+    } else if (syncRouteDb()) {
+      hasSyncedFib_ = true;
+      expBackoff_.reportSuccess();
+      // Forwarding is up, startup is complete
+      auto& timeline = StartupTimeline::get();
+      if (timeline.record("first_fib_sync")) {
+        LOG(INFO) << "Startup timeline: " << timeline.toString();
       }
+    } else {
+      // Apply exponential backoff and schedule next run
+      expBackoff_.reportError();
+      syncRoutesTimer_->scheduleTimeout(
+          expBackoff_.getTimeRemainingUntilRetry());
     }
     fb303::fbData->setCounter(
         "fib.synced", syncRoutesTimer_->isScheduled() ? 0 : 1);
@@ -76,6 +248,9 @@ Fib::Fib(
     syncRoutesTimer_->scheduleTimeout(coldStartDuration);
   }
 
+  programRouteBatchesTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { programRouteBatches(); });
+
   keepAliveTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     // Make thrift calls to do real programming
     try {
@@ -99,15 +274,22 @@ Fib::Fib(
   // Fiber to process route updates from Decision
   addFiberTask([q = std::move(routeUpdatesQueue), this]() mutable noexcept {
     while (true) {
-      auto maybeThriftObj = q.get(); // perform read
-      VLOG(1) << "Received route updates";
-      if (maybeThriftObj.hasError()) {
+      // coalesce queued route deltas to program each route once. Entire
+      // backlog is coalesced if we are lagging behind Decision
+      const auto maxItems = q.isOverSoftLimit()
+          ? std::numeric_limits<size_t>::max()
+          : Constants::kMaxRouteDeltaBatchSize;
+      auto maybeThriftObjs = q.getBatch(maxItems, mergeRouteDatabaseDelta);
+      if (maybeThriftObjs.hasError()) {
         LOG(INFO) << "Terminating route delta processing fiber";
         break;
       }
+      VLOG(1) << "Received route updates";
 
-      CHECK_EQ(myNodeName_, maybeThriftObj.value().thisNodeName);
-      processRouteUpdates(std::move(maybeThriftObj).value());
+      for (auto& routeDelta : maybeThriftObjs.value()) {
+        CHECK_EQ(myNodeName_, routeDelta.thisNodeName);
+        processRouteUpdates(std::move(routeDelta));
+      }
     }
   });
 
@@ -128,13 +310,34 @@ Fib::Fib(
 
   zmqMonitorClient_ =
       std::make_unique<fbzmq::ZmqMonitorClient>(zmqContext, monitorSubmitUrl);
+  eventLogger_ = std::make_unique<EventLogger>(
+      "fib", [this](fbzmq::thrift::EventLog&& log) {
+        zmqMonitorClient_->addEventLog(std::move(log));
+      });
 
   // Initialize stats keys
   fb303::fbData->addStatExportType("fib.convergence_time_ms", fb303::AVG);
   fb303::fbData->addStatExportType(
       "fib.local_route_program_time_ms", fb303::AVG);
   fb303::fbData->addStatExportType("fib.num_of_route_updates", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.resync_routes", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.route_batches", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.route_updates_coalesced", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.warm_start.adopted_routes", fb303::SUM);
+  fb303::fbData->addHistogram("fib.route_batch_programming_ms", 10, 0, 1000);
+  for (size_t i = 0; i < kNumRoutePriorities; ++i) {
+    fb303::fbData->addStatExportType(
+        "fib.route_programming_latency_ms." +
+            getRoutePriorityName(static_cast<RoutePriority>(i)),
+        fb303::AVG);
+  }
+  fb303::fbData->exportHistogramPercentile(
+      "fib.route_batch_programming_ms", 50, 95, 99);
   fb303::fbData->addStatExportType("fib.process_interface_db", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "fib.interface_affected_routes", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.link_down_reaction_ms", fb303::AVG);
+  fb303::fbData->addStatExportType("fib.lfa_repairs", fb303::SUM);
   fb303::fbData->addStatExportType("fib.process_route_db", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.sync_fib_calls", fb303::COUNT);
   fb303::fbData->addStatExportType(
@@ -147,67 +350,175 @@ Fib::Fib(
 std::optional<thrift::IpPrefix>
 Fib::longestPrefixMatch(
     const folly::CIDRNetwork& inputPrefix,
-    const std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute>&
-        unicastRoutes) {
-  std::optional<thrift::IpPrefix> matchedPrefix;
-  int maxMask = -1;
-  const auto& inputIP = inputPrefix.first;
-  const auto& inputMask = inputPrefix.second;
+    const PrefixTrie<thrift::IpPrefix>& prefixTrie) {
+  auto matchedPrefix = prefixTrie.longestMatch(inputPrefix);
+  if (matchedPrefix) {
+    return *matchedPrefix;
+  }
+  return std::nullopt;
+}
 
-  // longest prefix matching
-  for (const auto& route : unicastRoutes) {
-    const auto& dbIP = toIPAddress(route.first.prefixAddress);
-    const auto& dbMask = route.first.prefixLength;
+Fib::RoutePriority
+Fib::getRoutePriority(const thrift::UnicastRoute& route) {
+  auto const prefixType = route.prefixType_ref();
+  if (prefixType.has_value() and
+      prefixType.value() == thrift::PrefixType::LOOPBACK) {
+    return RoutePriority::HIGH;
+  }
+  if ((prefixType.has_value() and
+       prefixType.value() == thrift::PrefixType::BGP) or
+      route.bestNexthop_ref().has_value()) {
+    return RoutePriority::LOW;
+  }
+  // Host prefixes are loopbacks of nodes
+  const auto& addr = route.dest.prefixAddress.addr;
+  if (route.dest.prefixLength == static_cast<int16_t>(addr.size() * 8)) {
+    return RoutePriority::HIGH;
+  }
+  return RoutePriority::DEFAULT;
+}
 
-    if (maxMask < dbMask && inputMask >= dbMask &&
-        inputIP.mask(dbMask) == dbIP) {
-      maxMask = dbMask;
-      matchedPrefix = route.first;
+std::string
+Fib::getRoutePriorityName(RoutePriority priority) {
+  switch (priority) {
+  case RoutePriority::HIGH:
+    return "high";
+  case RoutePriority::DEFAULT:
+    return "default";
+  case RoutePriority::LOW:
+    return "low";
+  }
+  return "unknown";
+}
+
+bool
+Fib::mergeRouteDatabaseDelta(
+    thrift::RouteDatabaseDelta& into, thrift::RouteDatabaseDelta& from) {
+  if (into.thisNodeName != from.thisNodeName) {
+    return false;
+  }
+  // Nexthop group withdrawn in `into` and re-announced in `from` can't be
+  // expressed in single delta
+  for (auto const& kv : from.nextHopGroupsToUpdate) {
+    if (std::find(
+            into.nextHopGroupsToDelete.begin(),
+            into.nextHopGroupsToDelete.end(),
+            kv.first) != into.nextHopGroupsToDelete.end()) {
+      return false;
     }
   }
-  return matchedPrefix;
+
+  // NOTE: Within a delta, routes are updated before being deleted. Hence
+  // delete wins over update of the same route.
+  std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastUpdates;
+  std::unordered_set<thrift::IpPrefix> unicastDeletes;
+  auto applyUnicast = [&](thrift::RouteDatabaseDelta& delta) {
+    for (auto& route : delta.unicastRoutesToUpdate) {
+      if (route.doNotInstall) {
+        // Never installed, previous route for the prefix stays as is
+        continue;
+      }
+      unicastDeletes.erase(route.dest);
+      auto dest = route.dest;
+      unicastUpdates.insert_or_assign(std::move(dest), std::move(route));
+    }
+    for (auto& dest : delta.unicastRoutesToDelete) {
+      unicastUpdates.erase(dest);
+      unicastDeletes.emplace(std::move(dest));
+    }
+  };
+  std::unordered_map<int32_t, thrift::MplsRoute> mplsUpdates;
+  std::unordered_set<int32_t> mplsDeletes;
+  auto applyMpls = [&](thrift::RouteDatabaseDelta& delta) {
+    for (auto& route : delta.mplsRoutesToUpdate) {
+      mplsDeletes.erase(route.topLabel);
+      mplsUpdates.insert_or_assign(route.topLabel, std::move(route));
+    }
+    for (auto const topLabel : delta.mplsRoutesToDelete) {
+      mplsUpdates.erase(topLabel);
+      mplsDeletes.emplace(topLabel);
+    }
+  };
+  applyUnicast(into);
+  applyUnicast(from);
+  applyMpls(into);
+  applyMpls(from);
+
+  into.unicastRoutesToUpdate.clear();
+  for (auto& kv : unicastUpdates) {
+    into.unicastRoutesToUpdate.emplace_back(std::move(kv.second));
+  }
+  into.unicastRoutesToDelete.assign(
+      unicastDeletes.begin(), unicastDeletes.end());
+  into.mplsRoutesToUpdate.clear();
+  for (auto& kv : mplsUpdates) {
+    into.mplsRoutesToUpdate.emplace_back(std::move(kv.second));
+  }
+  into.mplsRoutesToDelete.assign(mplsDeletes.begin(), mplsDeletes.end());
+
+  // Groups are learnt before and withdrawn after processing routes
+  for (auto& [groupId, nextHops] : from.nextHopGroupsToUpdate) {
+    into.nextHopGroupsToUpdate[groupId] = std::move(nextHops);
+  }
+  into.nextHopGroupsToDelete.insert(
+      into.nextHopGroupsToDelete.end(),
+      from.nextHopGroupsToDelete.begin(),
+      from.nextHopGroupsToDelete.end());
+
+  // Keep perf events of the earliest delta to measure convergence from it
+  if (not into.perfEvents_ref().has_value()) {
+    into.perfEvents_ref().copy_from(from.perfEvents_ref());
+  }
+  return true;
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
 Fib::getRouteDb() {
-  folly::Promise<std::unique_ptr<thrift::RouteDatabase>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), this]() mutable {
-    thrift::RouteDatabase routeDb;
-    routeDb.thisNodeName = myNodeName_;
-    for (const auto& route : routeState_.unicastRoutes) {
-      routeDb.unicastRoutes.emplace_back(route.second);
-    }
-    for (const auto& route : routeState_.mplsRoutes) {
-      routeDb.mplsRoutes.emplace_back(route.second);
-    }
-    p.setValue(std::make_unique<thrift::RouteDatabase>(std::move(routeDb)));
-  });
-  return sf;
+  const auto snapshot = getRouteSnapshot();
+  auto routeDb = std::make_unique<thrift::RouteDatabase>();
+  routeDb->thisNodeName = myNodeName_;
+  routeDb->unicastRoutes = getUnicastRoutesFiltered(*snapshot, {});
+  routeDb->mplsRoutes = getMplsRoutesFiltered(*snapshot, {});
+  return folly::makeSemiFuture(std::move(routeDb));
+}
+
+messaging::RQueue<thrift::RouteDatabaseDelta>
+Fib::getFibUpdatesReader() {
+  return fibUpdatesQueue_.getReader();
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
 Fib::getUnicastRoutes(std::vector<std::string> prefixes) {
-  folly::Promise<std::unique_ptr<std::vector<thrift::UnicastRoute>>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread(
-      [p = std::move(p), prefixes = std::move(prefixes), this]() mutable {
-        p.setValue(std::make_unique<std::vector<thrift::UnicastRoute>>(
-            getUnicastRoutesFiltered(std::move(prefixes))));
-      });
-  return sf;
+  return folly::makeSemiFuture(
+      std::make_unique<std::vector<thrift::UnicastRoute>>(
+          getUnicastRoutesFiltered(*getRouteSnapshot(), std::move(prefixes))));
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
 Fib::getMplsRoutes(std::vector<int32_t> labels) {
-  folly::Promise<std::unique_ptr<std::vector<thrift::MplsRoute>>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread(
-      [p = std::move(p), labels = std::move(labels), this]() mutable {
-        p.setValue(std::make_unique<std::vector<thrift::MplsRoute>>(
-            getMplsRoutesFiltered(std::move(labels))));
-      });
-  return sf;
+  return folly::makeSemiFuture(
+      std::make_unique<std::vector<thrift::MplsRoute>>(
+          getMplsRoutesFiltered(*getRouteSnapshot(), std::move(labels))));
+}
+
+std::shared_ptr<const Fib::RouteSnapshot>
+Fib::getRouteSnapshot() const {
+  return *routeSnapshot_.rlock();
+}
+
+void
+Fib::publishRouteSnapshot(
+    const std::vector<thrift::IpPrefix>& prefixes,
+    const std::vector<uint32_t>& labels) {
+  if (prefixes.empty() and labels.empty()) {
+    return;
+  }
+  // shards (and routes) of unchanged keys are shared with previous snapshot
+  auto snapshot = std::make_shared<RouteSnapshot>(*getRouteSnapshot());
+  updateRouteShards(
+      snapshot->unicastShards, routeState_.unicastRoutes, prefixes);
+  updateRouteShards(snapshot->mplsShards, routeState_.mplsRoutes, labels);
+  *routeSnapshot_.wlock() = std::move(snapshot);
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
@@ -220,17 +531,52 @@ Fib::getPerfDb() {
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>>
+Fib::getConvergenceTrace(std::string traceId) {
+  folly::Promise<std::unique_ptr<thrift::PerfDatabase>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [p = std::move(p), traceId = std::move(traceId), this]() mutable {
+        p.setValue(
+            std::make_unique<thrift::PerfDatabase>(dumpPerfDb(traceId)));
+      });
+  return sf;
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::ConvergenceStats>>>
+Fib::getConvergenceStats() {
+  folly::Promise<std::unique_ptr<std::vector<thrift::ConvergenceStats>>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), this]() mutable {
+    auto allStats = std::make_unique<std::vector<thrift::ConvergenceStats>>();
+    for (auto const& [eventType, histograms] : convergenceHistograms_) {
+      thrift::ConvergenceStats stats;
+      stats.eventType = eventType;
+      stats.endToEnd = getLatencyStats(histograms.endToEnd);
+      for (auto const& [stage, histogram] : histograms.stages) {
+        stats.stages.emplace(stage, getLatencyStats(histogram));
+      }
+      allStats->emplace_back(std::move(stats));
+    }
+    p.setValue(std::move(allStats));
+  });
+  return sf;
+}
+
 std::vector<thrift::UnicastRoute>
-Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
+Fib::getUnicastRoutesFiltered(
+    const RouteSnapshot& snapshot, std::vector<std::string> prefixes) {
   // return and send the vector<thrift::UnicastRoute>
   std::vector<thrift::UnicastRoute> retRouteVec;
   // the matched prefix after longest prefix matching and avoid duplicates
-  std::set<thrift::IpPrefix> matchPrefixSet;
+  std::map<thrift::IpPrefix, const thrift::UnicastRoute*> matchPrefixes;
 
   // if the params is empty, return all routes
   if (prefixes.empty()) {
-    for (const auto& routes : routeState_.unicastRoutes) {
-      retRouteVec.emplace_back(routes.second);
+    for (auto const& shard : snapshot.unicastShards) {
+      for (auto const& [_, route] : *shard) {
+        retRouteVec.emplace_back(*route);
+      }
     }
     return retRouteVec;
   }
@@ -246,31 +592,42 @@ Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
     }
     const auto inputPrefix = maybePrefix.value();
 
-    // do longest prefix match, add the matched prefix to the result set
-    const auto& matchedPrefix =
-        Fib::longestPrefixMatch(inputPrefix, routeState_.unicastRoutes);
-    if (matchedPrefix.has_value()) {
-      matchPrefixSet.insert(matchedPrefix.value());
+    // do longest prefix match by looking up the input prefix masked to
+    // decreasing lengths, add the matched prefix to the result set
+    for (int len = inputPrefix.second; len >= 0; --len) {
+      const auto prefix =
+          toIpPrefix(folly::CIDRNetwork(inputPrefix.first.mask(len), len));
+      auto const& shard =
+          *snapshot.unicastShards.at(getRouteShardIndex(
+              snapshot.unicastShards, prefix));
+      auto it = shard.find(prefix);
+      if (it != shard.end()) {
+        matchPrefixes.emplace(prefix, it->second.get());
+        break;
+      }
     }
   }
 
   // get the routes from the prefix set
-  for (const auto& prefix : matchPrefixSet) {
-    retRouteVec.emplace_back(routeState_.unicastRoutes.at(prefix));
+  for (const auto& [_, route] : matchPrefixes) {
+    retRouteVec.emplace_back(*route);
   }
 
   return retRouteVec;
 }
 
 std::vector<thrift::MplsRoute>
-Fib::getMplsRoutesFiltered(std::vector<int32_t> labels) {
+Fib::getMplsRoutesFiltered(
+    const RouteSnapshot& snapshot, std::vector<int32_t> labels) {
   // return and send the vector<thrift::MplsRoute>
   std::vector<thrift::MplsRoute> retRouteVec;
 
   // if the params is empty, return all MPLS routes
   if (labels.empty()) {
-    for (const auto& routes : routeState_.mplsRoutes) {
-      retRouteVec.emplace_back(routes.second);
+    for (auto const& shard : snapshot.mplsShards) {
+      for (auto const& [_, route] : *shard) {
+        retRouteVec.emplace_back(*route);
+      }
     }
     return retRouteVec;
   }
@@ -282,9 +639,12 @@ Fib::getMplsRoutesFiltered(std::vector<int32_t> labels) {
   }
 
   // get the filtered MPLS routes and avoid duplicates
-  for (const auto& routes : routeState_.mplsRoutes) {
-    if (labelFilterSet.find(routes.first) != labelFilterSet.end()) {
-      retRouteVec.emplace_back(routes.second);
+  for (const auto label : labelFilterSet) {
+    auto const& shard = *snapshot.mplsShards.at(getRouteShardIndex(
+        snapshot.mplsShards, static_cast<uint32_t>(label)));
+    auto it = shard.find(static_cast<uint32_t>(label));
+    if (it != shard.end()) {
+      retRouteVec.emplace_back(*it->second);
     }
   }
 
@@ -312,34 +672,162 @@ Fib::processRouteUpdates(thrift::RouteDatabaseDelta&& routeDelta) {
     }
   }
 
+  // Learn new nexthop groups and resolve nexthops of routes using them
+  for (auto& [groupId, nextHops] : routeDelta.nextHopGroupsToUpdate) {
+    auto& group = routeState_.nextHopGroups[groupId];
+    group.nextHops = std::move(nextHops);
+    group.withdrawn = false;
+  }
+  for (auto& route : routeDelta.unicastRoutesToUpdate) {
+    auto const groupId = route.nextHopGroupId_ref();
+    if (not groupId.has_value()) {
+      continue;
+    }
+    auto const* group = folly::get_ptr(routeState_.nextHopGroups, *groupId);
+    if (not group) {
+      LOG(ERROR) << "Unknown nexthop group " << *groupId << " for prefix "
+                 << toString(route.dest);
+      fb303::fbData->addStatValue(
+          "fib.unknown_nexthop_group", 1, fb303::COUNT);
+      route.nextHopGroupId_ref().reset();
+      continue;
+    }
+    route.nextHops = group->nextHops;
+  }
+
   // Add/Update unicast routes to update
   for (const auto& route : routeDelta.unicastRoutesToUpdate) {
-    routeState_.unicastRoutes[route.dest] = route;
+    // reference the new group before releasing the old one, they may be same
+    acquireNextHopGroup(route);
+    auto it = routeState_.unicastRoutes.find(route.dest);
+    if (it != routeState_.unicastRoutes.end()) {
+      releaseNextHopGroup(it->second);
+      updateIfNameIndex(
+          routeState_.ifNameToPrefixes, route.dest, it->second.nextHops, false);
+      updateRouteAggregates(it->second, false);
+      it->second = route;
+    } else {
+      routeState_.unicastRoutes.emplace(route.dest, route);
+    }
+    updateIfNameIndex(
+        routeState_.ifNameToPrefixes, route.dest, route.nextHops, true);
+    updateRouteAggregates(route, true);
     routeState_.dirtyPrefixes.erase(route.dest);
   }
 
   // Add mpls routes to update
   for (const auto& route : routeDelta.mplsRoutesToUpdate) {
-    routeState_.mplsRoutes[route.topLabel] = route;
-    routeState_.dirtyLabels.erase(route.topLabel);
+    const uint32_t label = route.topLabel;
+    auto it = routeState_.mplsRoutes.find(label);
+    if (it != routeState_.mplsRoutes.end()) {
+      updateIfNameIndex(
+          routeState_.ifNameToLabels, label, it->second.nextHops, false);
+      updateRouteAggregates(it->second, false);
+      it->second = route;
+    } else {
+      routeState_.mplsRoutes.emplace(label, route);
+    }
+    updateIfNameIndex(routeState_.ifNameToLabels, label, route.nextHops, true);
+    updateRouteAggregates(route, true);
+    routeState_.dirtyLabels.erase(label);
   }
 
   // Delete unicast routes
   for (const auto& dest : routeDelta.unicastRoutesToDelete) {
-    routeState_.unicastRoutes.erase(dest);
+    auto it = routeState_.unicastRoutes.find(dest);
+    if (it != routeState_.unicastRoutes.end()) {
+      releaseNextHopGroup(it->second);
+      updateIfNameIndex(
+          routeState_.ifNameToPrefixes, dest, it->second.nextHops, false);
+      updateRouteAggregates(it->second, false);
+      routeState_.unicastRoutes.erase(it);
+    }
     routeState_.dirtyPrefixes.erase(dest);
   }
 
   // Delete mpls routes
   for (const auto& topLabel : routeDelta.mplsRoutesToDelete) {
-    routeState_.mplsRoutes.erase(topLabel);
-    routeState_.dirtyLabels.erase(topLabel);
+    const uint32_t label = topLabel;
+    auto it = routeState_.mplsRoutes.find(label);
+    if (it != routeState_.mplsRoutes.end()) {
+      updateIfNameIndex(
+          routeState_.ifNameToLabels, label, it->second.nextHops, false);
+      updateRouteAggregates(it->second, false);
+      routeState_.mplsRoutes.erase(it);
+    }
+    routeState_.dirtyLabels.erase(label);
   }
 
+  // Withdraw nexthop groups, they are erased once no route uses them anymore
+  for (auto groupId : routeDelta.nextHopGroupsToDelete) {
+    auto it = routeState_.nextHopGroups.find(groupId);
+    if (it == routeState_.nextHopGroups.end()) {
+      continue;
+    }
+    it->second.withdrawn = true;
+    if (it->second.refCount == 0) {
+      routeState_.nextHopGroups.erase(it);
+    }
+  }
+
+  // Publish snapshot of the routes for the route APIs, before the delta
+  std::vector<thrift::IpPrefix> changedPrefixes;
+  std::vector<uint32_t> changedLabels;
+  changedPrefixes.reserve(
+      routeDelta.unicastRoutesToUpdate.size() +
+      routeDelta.unicastRoutesToDelete.size());
+  for (auto const& route : routeDelta.unicastRoutesToUpdate) {
+    changedPrefixes.emplace_back(route.dest);
+  }
+  changedPrefixes.insert(
+      changedPrefixes.end(),
+      routeDelta.unicastRoutesToDelete.begin(),
+      routeDelta.unicastRoutesToDelete.end());
+  for (auto const& route : routeDelta.mplsRoutesToUpdate) {
+    changedLabels.emplace_back(route.topLabel);
+  }
+  changedLabels.insert(
+      changedLabels.end(),
+      routeDelta.mplsRoutesToDelete.begin(),
+      routeDelta.mplsRoutesToDelete.end());
+  publishRouteSnapshot(changedPrefixes, changedLabels);
+
   // Add some counters
   fb303::fbData->addStatValue("fib.process_route_db", 1, fb303::COUNT);
+  // Publish route delta to subscribers, if any (e.g. OpenrCtrl streams). It
+  // is copied only for them, as route delta is consumed by programming
+  std::optional<thrift::RouteDatabaseDelta> publishedRouteDelta;
+  if (fibUpdatesQueue_.getNumReaders()) {
+    publishedRouteDelta = routeDelta;
+  }
+
   // Send request to agent
-  updateRoutes(routeDelta);
+  updateRoutes(std::move(routeDelta));
+
+  if (publishedRouteDelta.has_value()) {
+    fibUpdatesQueue_.push(std::move(publishedRouteDelta).value());
+  }
+}
+
+void
+Fib::acquireNextHopGroup(const thrift::UnicastRoute& route) {
+  if (auto groupId = route.nextHopGroupId_ref()) {
+    auto it = routeState_.nextHopGroups.find(*groupId);
+    CHECK(it != routeState_.nextHopGroups.end());
+    ++it->second.refCount;
+  }
+}
+
+void
+Fib::releaseNextHopGroup(const thrift::UnicastRoute& route) {
+  if (auto groupId = route.nextHopGroupId_ref()) {
+    auto it = routeState_.nextHopGroups.find(*groupId);
+    CHECK(it != routeState_.nextHopGroups.end());
+    CHECK_GT(it->second.refCount, 0);
+    if (--it->second.refCount == 0 and it->second.withdrawn) {
+      routeState_.nextHopGroups.erase(it);
+    }
+  }
 }
 
 void
@@ -351,9 +839,16 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
         *interfaceDb.perfEvents_ref(), myNodeName_, "FIB_INTF_DB_RECEIVED");
   }
 
+  const auto startTime = std::chrono::steady_clock::now();
+
   //
-  // Update interface states
+  // Update interface states, and collect routes using the interfaces which
+  // changed state. Only these routes can have nexthops shrunk or restored.
   //
+  bool anyInterfaceDown{false};
+  size_t numLfaRepairs{0};
+  std::unordered_set<thrift::IpPrefix> affectedPrefixes;
+  std::unordered_set<uint32_t> affectedLabels;
   for (auto const& kv : interfaceDb.interfaces) {
     const auto& ifName = kv.first;
     const auto isUp = kv.second.isUp;
@@ -362,6 +857,7 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
     // UP -> DOWN transition
     if (wasUp and not isUp) {
       LOG(INFO) << "Interface " << ifName << " transitioned from UP -> DOWN";
+      anyInterfaceDown = true;
     }
     // DOWN -> UP transition
     if (not wasUp and isUp) {
@@ -370,6 +866,17 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
 
     // Update new status
     interfaceStatusDb_[ifName] = isUp;
+
+    if (wasUp != isUp) {
+      auto prefixes = folly::get_ptr(routeState_.ifNameToPrefixes, ifName);
+      if (prefixes) {
+        affectedPrefixes.insert(prefixes->begin(), prefixes->end());
+      }
+      auto labels = folly::get_ptr(routeState_.ifNameToLabels, ifName);
+      if (labels) {
+        affectedLabels.insert(labels->begin(), labels->end());
+      }
+    }
   }
 
   thrift::RouteDatabaseDelta routeDbDelta;
@@ -378,8 +885,8 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
   //
   // Compute unicast route changes
   //
-  for (auto const& kv : routeState_.unicastRoutes) {
-    auto const& route = kv.second;
+  for (auto const& prefix : affectedPrefixes) {
+    auto const& route = routeState_.unicastRoutes.at(prefix);
 
     // Find valid nexthops for route
     std::vector<thrift::NextHopThrift> validNextHops;
@@ -411,6 +918,12 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
       VLOG(1) << "bestPaths group resize for prefix: " << toString(route.dest)
               << ", old: " << prevBestNextHops.size()
               << ", new: " << validBestNextHops.size();
+      // All primary nexthops are lost, and the precomputed loop-free
+      // alternates (nexthops with higher metric) take over right away
+      if (not prevBestNextHops.empty() and
+          getMinMetric(validBestNextHops) > getMinMetric(prevBestNextHops)) {
+        ++numLfaRepairs;
+      }
       thrift::UnicastRoute newRoute;
       newRoute.dest = route.dest;
       newRoute.nextHops = std::move(validBestNextHops);
@@ -421,13 +934,13 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
       routeDbDelta.unicastRoutesToUpdate.emplace_back(route);
       routeState_.dirtyPrefixes.erase(route.dest); // Remove from dirty list
     }
-  } // end for ... routeDb_.unicastRoutes
+  } // end for ... affectedPrefixes
 
   //
   // Compute MPLS route changes
   //
-  for (const auto& kv : routeState_.mplsRoutes) {
-    const auto& route = kv.second;
+  for (auto const& label : affectedLabels) {
+    const auto& route = routeState_.mplsRoutes.at(label);
 
     // Find valid nexthops for route
     std::vector<thrift::NextHopThrift> validNextHops;
@@ -470,23 +983,42 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
       routeDbDelta.mplsRoutesToUpdate.emplace_back(route);
       routeState_.dirtyLabels.erase(route.topLabel); // Remove from dirty list
     }
-  } // end for ... routeDb_.mplsRoutes
+  } // end for ... affectedLabels
 
-  updateRoutes(routeDbDelta);
+  fb303::fbData->addStatValue(
+      "fib.interface_affected_routes",
+      affectedPrefixes.size() + affectedLabels.size(),
+      fb303::SUM);
+  fb303::fbData->addStatValue("fib.lfa_repairs", numLfaRepairs, fb303::SUM);
+  updateRoutes(std::move(routeDbDelta));
+
+  // Time to react to link down, up to handing resized routes over for
+  // programming
+  if (anyInterfaceDown) {
+    fb303::fbData->addStatValue(
+        "fib.link_down_reaction_ms",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count(),
+        fb303::AVG);
+  }
 }
 
 thrift::PerfDatabase
-Fib::dumpPerfDb() const {
+Fib::dumpPerfDb(const std::optional<std::string>& traceId) const {
   thrift::PerfDatabase perfDb;
   perfDb.thisNodeName = myNodeName_;
   for (auto const& perf : perfDb_) {
+    if (traceId.has_value() and perf.traceId_ref().value_or("") != *traceId) {
+      continue;
+    }
     perfDb.eventInfo.emplace_back(perf);
   }
   return perfDb;
 }
 
 void
-Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
+Fib::updateRoutes(thrift::RouteDatabaseDelta&& routeDbDelta) {
   LOG(INFO) << "Processing route add/update for "
             << routeDbDelta.unicastRoutesToUpdate.size() << " unicast, "
             << routeDbDelta.mplsRoutesToUpdate.size() << " mpls, "
@@ -497,15 +1029,23 @@ Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
   // update flat counters here as they depend on routeState_ and its change
   updateGlobalCounters();
 
-  // Only for backward compatibility
-  auto const& patchedUnicastRoutesToUpdate =
-      createUnicastRoutesWithBestNexthops(routeDbDelta.unicastRoutesToUpdate);
+  // NOTE: priority is derived from route received from Decision as
+  // patched route only carries best nexthops
+  std::vector<RoutePriority> unicastPriorities;
+  unicastPriorities.reserve(routeDbDelta.unicastRoutesToUpdate.size());
+  for (auto const& route : routeDbDelta.unicastRoutesToUpdate) {
+    unicastPriorities.emplace_back(getRoutePriority(route));
+  }
+
+  // Only for backward compatibility. Route delta is ours, patch it in place
+  auto& unicastRoutesToUpdate = routeDbDelta.unicastRoutesToUpdate;
+  patchUnicastRoutesWithBestNexthops(unicastRoutesToUpdate);
 
-  auto const& mplsRoutesToUpdate =
-      createMplsRoutesWithBestNextHops(routeDbDelta.mplsRoutesToUpdate);
+  auto& mplsRoutesToUpdate = routeDbDelta.mplsRoutesToUpdate;
+  patchMplsRoutesWithBestNextHops(mplsRoutesToUpdate);
 
   VLOG(2) << "Unicast routes to add/update";
-  for (auto const& route : patchedUnicastRoutesToUpdate) {
+  for (auto const& route : unicastRoutesToUpdate) {
     VLOG(2) << "> " << toString(route.dest) << ", " << route.nextHops.size();
     for (auto const& nh : route.nextHops) {
       VLOG(2) << "  " << toString(nh);
@@ -541,15 +1081,14 @@ Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
     return;
   }
 
-  if (syncRoutesTimer_->isScheduled()) {
-    // Check if there's any full sync scheduled,
-    // if so, skip partial sync
-    LOG(INFO) << "Pending full sync is scheduled, skip delta sync for now...";
-    return;
-  } else if (routeState_.dirtyRouteDb or not hasSyncedFib_) {
-    if (hasSyncedFib_) {
-      LOG(INFO) << "Previous route programming failed or, skip delta sync to "
-                << "enforce full fib sync...";
+  if (routeState_.dirtyRouteDb or not hasSyncedFib_) {
+    if (syncRoutesTimer_->isScheduled()) {
+      // Check if there's any full sync scheduled,
+      // if so, skip partial sync
+      LOG(INFO) << "Pending full sync is scheduled, skip delta sync for now...";
+    } else if (hasSyncedFib_) {
+      LOG(INFO) << "Previous full sync failed or agent restarted, skip delta "
+                << "sync to enforce full fib sync...";
     } else {
       LOG(INFO) << "Syncing fib on startup...";
     }
@@ -557,40 +1096,360 @@ Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
     return;
   }
 
-  // Make thrift calls to do real programming
-  try {
-    uint32_t numOfRouteUpdates = 0;
-    createFibClient(evb_, socket_, client_, thriftPort_);
-    if (routeDbDelta.unicastRoutesToDelete.size()) {
-      numOfRouteUpdates += routeDbDelta.unicastRoutesToDelete.size();
-      client_->sync_deleteUnicastRoutes(
-          kFibId_, routeDbDelta.unicastRoutesToDelete);
+  if (syncRoutesTimer_->isScheduled()) {
+    // Resync of routes which failed to program is pending. Coalesce delta
+    // into it instead of programming it right away
+    LOG(INFO) << "Pending resync of routes is scheduled, coalescing delta...";
+    markRoutesUnsynced(routeDbDelta);
+    return;
+  }
+
+  // Queue route updates, superseding queued updates of the same routes, and
+  // program them in batches. Route delta is programmed once all of its
+  // updates are programmed.
+  const auto seqNum = ++routeDeltaSeqNum_;
+  size_t numCoalesced = 0;
+  auto queueUpdate = [&](auto& pendingUpdates,
+                         auto const& key,
+                         auto route,
+                         RoutePriority priority) {
+    ++outstandingRouteDeltas_[seqNum];
+    auto supersededSeqNum =
+        pendingUpdates.push(key, std::move(route), seqNum, priority);
+    if (supersededSeqNum.has_value()) {
+      ++numCoalesced;
+      releaseRouteDeltaSeqNum(*supersededSeqNum);
     }
-    if (patchedUnicastRoutesToUpdate.size()) {
-      numOfRouteUpdates += patchedUnicastRoutesToUpdate.size();
-      client_->sync_addUnicastRoutes(kFibId_, patchedUnicastRoutesToUpdate);
+  };
+  for (auto const& prefix : routeDbDelta.unicastRoutesToDelete) {
+    queueUpdate(
+        pendingUnicastUpdates_,
+        prefix,
+        std::optional<thrift::UnicastRoute>(std::nullopt),
+        getRoutePriority(createUnicastRoute(prefix, {})));
+  }
+  for (size_t i = 0; i < unicastRoutesToUpdate.size(); ++i) {
+    auto& route = unicastRoutesToUpdate.at(i);
+    auto const dest = route.dest;
+    queueUpdate(
+        pendingUnicastUpdates_,
+        dest,
+        std::optional<thrift::UnicastRoute>(std::move(route)),
+        unicastPriorities.at(i));
+  }
+  if (enableSegmentRouting_) {
+    for (auto const& label : routeDbDelta.mplsRoutesToDelete) {
+      queueUpdate(
+          pendingMplsUpdates_,
+          label,
+          std::optional<thrift::MplsRoute>(std::nullopt),
+          RoutePriority::HIGH);
     }
-    if (enableSegmentRouting_ && routeDbDelta.mplsRoutesToDelete.size()) {
-      numOfRouteUpdates += routeDbDelta.mplsRoutesToDelete.size();
-      client_->sync_deleteMplsRoutes(kFibId_, routeDbDelta.mplsRoutesToDelete);
+    for (auto& route : mplsRoutesToUpdate) {
+      auto const topLabel = route.topLabel;
+      queueUpdate(
+          pendingMplsUpdates_,
+          topLabel,
+          std::optional<thrift::MplsRoute>(std::move(route)),
+          RoutePriority::HIGH);
     }
-    if (enableSegmentRouting_ && mplsRoutesToUpdate.size()) {
-      numOfRouteUpdates += mplsRoutesToUpdate.size();
-      client_->sync_addMplsRoutes(kFibId_, mplsRoutesToUpdate);
+  }
+  fb303::fbData->addStatValue(
+      "fib.route_updates_coalesced", numCoalesced, fb303::SUM);
+
+  if (auto perfEvents = castToStd(routeDbDelta.perfEvents_ref())) {
+    addPerfEvent(*perfEvents, myNodeName_, "FIB_ROUTES_QUEUED");
+    pendingPerfEvents_.emplace_back(seqNum, std::move(perfEvents).value());
+  }
+
+  programRouteBatches();
+  logProgrammedPerfEvents();
+}
+
+void
+Fib::programRouteBatches() {
+  while (inflightBatches_.size() < Constants::kFibMaxInflightBatches) {
+    // Every batch carries updates of single priority, highest one first
+    auto unicastPriority = pendingUnicastUpdates_.getTopPriority();
+    auto mplsPriority = pendingMplsUpdates_.getTopPriority();
+    if (not unicastPriority.has_value() and not mplsPriority.has_value()) {
+      break; // Nothing more to program
     }
+    const auto priority = std::min(
+        unicastPriority.value_or(RoutePriority::LOW),
+        mplsPriority.value_or(RoutePriority::LOW));
+
+    // Wait for the rate to allow a full batch of non-urgent updates, unless
+    // all of the backlog fits in it
+    const auto backlog =
+        pendingUnicastUpdates_.size() + pendingMplsUpdates_.size();
+    const auto now = std::chrono::steady_clock::now();
+    if (priority != RoutePriority::HIGH and
+        backlog > Constants::kFibProgrammingBatchSize and
+        programmingRateLimiter_.getTokens(now) <
+            Constants::kFibProgrammingBatchSize) {
+      if (not programRouteBatchesTimer_->isScheduled()) {
+        programRouteBatchesTimer_->scheduleTimeout(
+            programmingRateLimiter_.getWaitTime(
+                Constants::kFibProgrammingBatchSize, now));
+        fb303::fbData->addStatValue("fib.route_batches_paced", 1, fb303::SUM);
+      }
+      break;
+    }
+
+    RouteBatch batch;
+    batch.priority = priority;
+    batch.queuedTs = std::chrono::steady_clock::now();
+    std::vector<thrift::UnicastRoute> unicastRoutesToUpdate;
+    std::vector<thrift::IpPrefix> unicastRoutesToDelete;
+    std::vector<thrift::MplsRoute> mplsRoutesToUpdate;
+    std::vector<int32_t> mplsRoutesToDelete;
+
+    auto numUpdates = pendingMplsUpdates_.pop(
+        priority, Constants::kFibProgrammingBatchSize, [&](auto&& update) {
+          batch.labels.emplace_back(update.key);
+          batch.seqNums.emplace_back(update.seqNum);
+          batch.queuedTs = std::min(batch.queuedTs, update.queuedTs);
+          if (update.route.has_value()) {
+            mplsRoutesToUpdate.emplace_back(std::move(*update.route));
+          } else {
+            mplsRoutesToDelete.emplace_back(update.key);
+          }
+        });
+    numUpdates += pendingUnicastUpdates_.pop(
+        priority,
+        Constants::kFibProgrammingBatchSize - numUpdates,
+        [&](auto&& update) {
+          batch.prefixes.emplace_back(update.key);
+          batch.seqNums.emplace_back(update.seqNum);
+          batch.queuedTs = std::min(batch.queuedTs, update.queuedTs);
+          if (update.route.has_value()) {
+            unicastRoutesToUpdate.emplace_back(std::move(*update.route));
+          } else {
+            unicastRoutesToDelete.emplace_back(std::move(update.key));
+          }
+        });
+    CHECK_LT(0, numUpdates);
+    programmingRateLimiter_.consume(numUpdates, now);
+
+    const auto batchId = nextBatchId_++;
+    batch.sendTs = std::chrono::steady_clock::now();
+    inflightBatches_.emplace(batchId, std::move(batch));
+
+    // Make thrift calls to do real programming. Requests of the batch are
+    // independent as every route appears once in the batch
+    std::vector<folly::SemiFuture<folly::Unit>> results;
+    try {
+      createFibClient(
+          *getEvb(), programmingSocket_, programmingClient_, thriftPort_);
+      if (unicastRoutesToDelete.size()) {
+        results.emplace_back(programmingClient_->semifuture_deleteUnicastRoutes(
+            kFibId_, unicastRoutesToDelete));
+      }
+      if (unicastRoutesToUpdate.size() and agentSupportsCompactRoutes_) {
+        results.emplace_back(
+            programmingClient_->semifuture_addUnicastRoutesCompact(
+                kFibId_, createCompactUnicastRoutes(unicastRoutesToUpdate)));
+      } else if (unicastRoutesToUpdate.size()) {
+        results.emplace_back(programmingClient_->semifuture_addUnicastRoutes(
+            kFibId_, unicastRoutesToUpdate));
+      }
+      if (mplsRoutesToDelete.size()) {
+        results.emplace_back(programmingClient_->semifuture_deleteMplsRoutes(
+            kFibId_, mplsRoutesToDelete));
+      }
+      if (mplsRoutesToUpdate.size()) {
+        results.emplace_back(programmingClient_->semifuture_addMplsRoutes(
+            kFibId_, mplsRoutesToUpdate));
+      }
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to make thrift call to FibAgent. Error: "
+                 << folly::exceptionStr(e);
+      results.emplace_back(folly::makeSemiFuture<folly::Unit>(
+          folly::exception_wrapper(std::current_exception())));
+    }
+    fb303::fbData->addStatValue("fib.route_batches", 1, fb303::SUM);
+
+    folly::collectAll(std::move(results))
+        .via(getEvb())
+        .thenValue([this, batchId](std::vector<folly::Try<folly::Unit>>&& res) {
+          bool success = true;
+          for (auto const& result : res) {
+            if (result.hasException()) {
+              LOG(ERROR) << "Failed to program routes with FibAgent. Error: "
+                         << folly::exceptionStr(result.exception());
+              success = false;
+            }
+          }
+          processRouteBatchResult(batchId, success);
+        });
+  }
+
+  fb303::fbData->setCounter(
+      "fib.route_backlog",
+      pendingUnicastUpdates_.size() + pendingMplsUpdates_.size());
+}
+
+void
+Fib::processRouteBatchResult(uint64_t batchId, bool success) {
+  auto it = inflightBatches_.find(batchId);
+  CHECK(it != inflightBatches_.end()) << "Unknown route batch " << batchId;
+  auto batch = std::move(it->second);
+  inflightBatches_.erase(it);
+
+  for (auto const& prefix : batch.prefixes) {
+    pendingUnicastUpdates_.inflight.erase(prefix);
+  }
+  for (auto const& label : batch.labels) {
+    pendingMplsUpdates_.inflight.erase(label);
+  }
+  for (auto seqNum : batch.seqNums) {
+    releaseRouteDeltaSeqNum(seqNum);
+  }
+  const auto now = std::chrono::steady_clock::now();
+  const auto programmingTime =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - batch.sendTs);
+  fb303::fbData->addHistogramValue(
+      "fib.route_batch_programming_ms", programmingTime.count());
+  // Time since oldest update of the batch got queued, per priority
+  fb303::fbData->addStatValue(
+      "fib.route_programming_latency_ms." +
+          getRoutePriorityName(batch.priority),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          now - batch.queuedTs)
+          .count(),
+      fb303::AVG);
+
+  // Learn rate agent sustains from its latency to program the batch
+  if (success) {
+    programmingRateLimiter_.reportSuccess(programmingTime);
+  } else {
+    programmingRateLimiter_.reportFailure();
+  }
+  fb303::fbData->setCounter(
+      "fib.programming_rate", programmingRateLimiter_.getRate());
+
+  if (success) {
+    expBackoff_.reportSuccess();
     fb303::fbData->addStatValue(
-        "fib.num_of_route_updates", numOfRouteUpdates, fb303::SUM);
-    routeState_.dirtyRouteDb = false;
-    logPerfEvents(castToStd(routeDbDelta.perfEvents_ref()));
-    LOG(INFO) << "Done processing route add/update";
-  } catch (const std::exception& e) {
-    fb303::fbData->addStatValue(
-        "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-    client_.reset();
-    routeState_.dirtyRouteDb = true;
-    syncRouteDbDebounced(); // Schedule future full sync of route DB
-    LOG(ERROR) << "Failed to make thrift call to FibAgent. Error: "
-               << folly::exceptionStr(e);
+        "fib.num_of_route_updates", batch.seqNums.size(), fb303::SUM);
+    LOG(INFO) << "Done programming batch of " << batch.seqNums.size()
+              << " route updates";
+    logProgrammedPerfEvents();
+    programRouteBatches();
+    return;
+  }
+
+  // State of routes of the batch isn't known anymore. Mark them, along with
+  // queued updates, unsynced and resync them after backoff. Route deltas
+  // received meanwhile are coalesced into the resync
+  fb303::fbData->addStatValue(
+      "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
+  programmingClient_.reset();
+  routeState_.unsyncedPrefixes.insert(
+      batch.prefixes.begin(), batch.prefixes.end());
+  routeState_.unsyncedLabels.insert(batch.labels.begin(), batch.labels.end());
+  pendingUnicastUpdates_.forEach([this](auto const& update) {
+    routeState_.unsyncedPrefixes.emplace(update.key);
+  });
+  pendingMplsUpdates_.forEach([this](auto const& update) {
+    routeState_.unsyncedLabels.emplace(update.key);
+  });
+  clearPendingRouteUpdates();
+  pendingPerfEvents_.clear();
+  if (not syncRoutesTimer_->isScheduled()) {
+    expBackoff_.reportError();
+    syncRoutesTimer_->scheduleTimeout(expBackoff_.getTimeRemainingUntilRetry());
+  }
+  fb303::fbData->setCounter("fib.synced", 0);
+}
+
+void
+Fib::markRoutesUnsynced(const thrift::RouteDatabaseDelta& routeDbDelta) {
+  for (auto const& route : routeDbDelta.unicastRoutesToUpdate) {
+    routeState_.unsyncedPrefixes.emplace(route.dest);
+  }
+  routeState_.unsyncedPrefixes.insert(
+      routeDbDelta.unicastRoutesToDelete.begin(),
+      routeDbDelta.unicastRoutesToDelete.end());
+  for (auto const& route : routeDbDelta.mplsRoutesToUpdate) {
+    routeState_.unsyncedLabels.emplace(route.topLabel);
+  }
+  routeState_.unsyncedLabels.insert(
+      routeDbDelta.mplsRoutesToDelete.begin(),
+      routeDbDelta.mplsRoutesToDelete.end());
+}
+
+void
+Fib::resyncUnsyncedRoutes() {
+  LOG(INFO) << "Resyncing " << routeState_.unsyncedPrefixes.size()
+            << " unicast and " << routeState_.unsyncedLabels.size()
+            << " mpls routes with fib-agent";
+
+  // Program current state of unsynced routes, delete ones which don't exist
+  // anymore. Resized nexthops of the routes are restored as on full sync
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = myNodeName_;
+  for (auto const& prefix : routeState_.unsyncedPrefixes) {
+    auto it = routeState_.unicastRoutes.find(prefix);
+    if (it != routeState_.unicastRoutes.end()) {
+      routeDbDelta.unicastRoutesToUpdate.emplace_back(it->second);
+    } else {
+      routeDbDelta.unicastRoutesToDelete.emplace_back(prefix);
+    }
+    routeState_.dirtyPrefixes.erase(prefix);
+  }
+  for (auto const& label : routeState_.unsyncedLabels) {
+    auto it = routeState_.mplsRoutes.find(label);
+    if (it != routeState_.mplsRoutes.end()) {
+      routeDbDelta.mplsRoutesToUpdate.emplace_back(it->second);
+    } else {
+      routeDbDelta.mplsRoutesToDelete.emplace_back(label);
+    }
+    routeState_.dirtyLabels.erase(label);
+  }
+  fb303::fbData->addStatValue(
+      "fib.resync_routes",
+      routeState_.unsyncedPrefixes.size() + routeState_.unsyncedLabels.size(),
+      fb303::SUM);
+  routeState_.unsyncedPrefixes.clear();
+  routeState_.unsyncedLabels.clear();
+
+  updateRoutes(std::move(routeDbDelta));
+}
+
+void
+Fib::clearPendingRouteUpdates() {
+  auto releaseUpdate = [this](auto const& update) {
+    releaseRouteDeltaSeqNum(update.seqNum);
+  };
+  pendingUnicastUpdates_.forEach(releaseUpdate);
+  pendingMplsUpdates_.forEach(releaseUpdate);
+  pendingUnicastUpdates_.clear();
+  pendingMplsUpdates_.clear();
+  fb303::fbData->setCounter("fib.route_backlog", 0);
+}
+
+void
+Fib::releaseRouteDeltaSeqNum(uint64_t seqNum) {
+  auto it = outstandingRouteDeltas_.find(seqNum);
+  CHECK(it != outstandingRouteDeltas_.end());
+  if (--it->second == 0) {
+    outstandingRouteDeltas_.erase(it);
+  }
+}
+
+void
+Fib::logProgrammedPerfEvents() {
+  // Deltas older than the oldest one with outstanding updates are programmed
+  const auto minOutstandingSeqNum = outstandingRouteDeltas_.empty()
+      ? std::numeric_limits<uint64_t>::max()
+      : outstandingRouteDeltas_.begin()->first;
+  while (not pendingPerfEvents_.empty() and
+         pendingPerfEvents_.front().first < minOutstandingSeqNum) {
+    auto perfEvents = std::move(pendingPerfEvents_.front().second);
+    pendingPerfEvents_.pop_front();
+    logPerfEvents(std::move(perfEvents));
   }
 }
 
@@ -599,8 +1458,23 @@ Fib::syncRouteDb() {
   LOG(INFO) << "Syncing latest routeDb with fib-agent with "
             << routeState_.unicastRoutes.size() << " routes";
 
-  const auto& unicastRoutes =
-      createUnicastRoutesWithBestNextHopsMap(routeState_.unicastRoutes);
+  // Order unicast routes by their priority, as agent programs them in order
+  std::array<std::vector<thrift::UnicastRoute>, kNumRoutePriorities>
+      routesByPriority;
+  for (auto& route :
+       createUnicastRoutesWithBestNextHopsMap(routeState_.unicastRoutes)) {
+    const auto priority =
+        getRoutePriority(routeState_.unicastRoutes.at(route.dest));
+    routesByPriority.at(static_cast<size_t>(priority))
+        .emplace_back(std::move(route));
+  }
+  const auto& highPriorityRoutes =
+      routesByPriority.at(static_cast<size_t>(RoutePriority::HIGH));
+  std::vector<thrift::UnicastRoute> unicastRoutes;
+  unicastRoutes.reserve(routeState_.unicastRoutes.size());
+  for (auto const& routes : routesByPriority) {
+    unicastRoutes.insert(unicastRoutes.end(), routes.begin(), routes.end());
+  }
   const auto& mplsRoutes =
       createMplsRoutesWithBestNextHopsMap(routeState_.mplsRoutes);
 
@@ -632,16 +1506,59 @@ Fib::syncRouteDb() {
     createFibClient(evb_, socket_, client_, thriftPort_);
     fb303::fbData->addStatValue("fib.sync_fib_calls", 1, fb303::COUNT);
 
-    // Sync unicast routes
-    client_->sync_syncFib(kFibId_, unicastRoutes);
-    routeState_.dirtyPrefixes.clear();
+    if (warmStartPending_) {
+      // Adopt routes programmed by previous incarnation on startup
+      warmStartPending_ = false;
+      syncRouteDbWarmStart(unicastRoutes, mplsRoutes);
+    } else {
+      // Program high priority routes (MPLS and loopbacks) ahead of large sync
+      // so that they don't wait behind rest of the routes
+      if (unicastRoutes.size() + mplsRoutes.size() >
+          Constants::kFibProgrammingBatchSize) {
+        if (enableSegmentRouting_ and mplsRoutes.size()) {
+          client_->sync_addMplsRoutes(kFibId_, mplsRoutes);
+        }
+        if (highPriorityRoutes.size()) {
+          client_->sync_addUnicastRoutes(kFibId_, highPriorityRoutes);
+        }
+      }
+
+      // Sync unicast routes. Stream them in compact form if supported by
+      // agent
+      if (agentSupportsCompactRoutes_) {
+        const int64_t syncId =
+            std::chrono::system_clock::now().time_since_epoch().count();
+        size_t start = 0;
+        do {
+          const size_t end = std::min(
+              start + Constants::kFibCompactSyncChunkSize,
+              unicastRoutes.size());
+          client_->sync_syncFibCompact(
+              kFibId_,
+              createCompactUnicastRoutes(std::vector<thrift::UnicastRoute>(
+                  unicastRoutes.begin() + start, unicastRoutes.begin() + end)),
+              syncId,
+              end == unicastRoutes.size() /* isLastChunk */);
+          start = end;
+        } while (start < unicastRoutes.size());
+      } else {
+        client_->sync_syncFib(kFibId_, unicastRoutes);
+      }
 
-    // Sync mpls routes
-    if (enableSegmentRouting_) {
-      client_->sync_syncMplsFib(kFibId_, mplsRoutes);
+      // Sync mpls routes
+      if (enableSegmentRouting_) {
+        client_->sync_syncMplsFib(kFibId_, mplsRoutes);
+      }
     }
+    routeState_.dirtyPrefixes.clear();
     routeState_.dirtyLabels.clear();
 
+    // Queued route updates and resync of routes are superseded by full sync
+    clearPendingRouteUpdates();
+    routeState_.unsyncedPrefixes.clear();
+    routeState_.unsyncedLabels.clear();
+    logProgrammedPerfEvents();
+
     routeState_.dirtyRouteDb = false;
     LOG(INFO) << "Done syncing latest routeDb with fib-agent";
     return true;
@@ -655,6 +1572,90 @@ Fib::syncRouteDb() {
   }
 }
 
+void
+Fib::syncRouteDbWarmStart(
+    const std::vector<thrift::UnicastRoute>& unicastRoutes,
+    const std::vector<thrift::MplsRoute>& mplsRoutes) {
+  size_t numAdopted{0};
+
+  // Unicast routes. Routes to add are in the order of their priority
+  std::vector<thrift::UnicastRoute> agentUnicastRoutes;
+  client_->sync_getRouteTableByClient(agentUnicastRoutes, kFibId_);
+  std::unordered_map<thrift::IpPrefix, std::vector<thrift::NextHopThrift>>
+      agentNextHops;
+  for (auto const& route : agentUnicastRoutes) {
+    agentNextHops.emplace(route.dest, getProgrammedNextHops(route.nextHops));
+  }
+  std::vector<thrift::UnicastRoute> unicastRoutesToAdd;
+  for (auto const& route : unicastRoutes) {
+    auto it = agentNextHops.find(route.dest);
+    if (it != agentNextHops.end() and
+        it->second == getProgrammedNextHops(route.nextHops)) {
+      ++numAdopted;
+    } else {
+      unicastRoutesToAdd.emplace_back(route);
+    }
+    if (it != agentNextHops.end()) {
+      agentNextHops.erase(it);
+    }
+  }
+  std::vector<thrift::IpPrefix> unicastRoutesToDelete;
+  for (auto const& [prefix, _] : agentNextHops) {
+    unicastRoutesToDelete.emplace_back(prefix);
+  }
+
+  // Mpls routes
+  std::vector<thrift::MplsRoute> mplsRoutesToAdd;
+  std::vector<int32_t> mplsRoutesToDelete;
+  if (enableSegmentRouting_) {
+    std::vector<thrift::MplsRoute> agentMplsRoutes;
+    client_->sync_getMplsRouteTableByClient(agentMplsRoutes, kFibId_);
+    std::unordered_map<int32_t, std::vector<thrift::NextHopThrift>>
+        agentMplsNextHops;
+    for (auto const& route : agentMplsRoutes) {
+      agentMplsNextHops.emplace(
+          route.topLabel, getProgrammedNextHops(route.nextHops));
+    }
+    for (auto const& route : mplsRoutes) {
+      auto it = agentMplsNextHops.find(route.topLabel);
+      if (it != agentMplsNextHops.end() and
+          it->second == getProgrammedNextHops(route.nextHops)) {
+        ++numAdopted;
+      } else {
+        mplsRoutesToAdd.emplace_back(route);
+      }
+      if (it != agentMplsNextHops.end()) {
+        agentMplsNextHops.erase(it);
+      }
+    }
+    for (auto const& [label, _] : agentMplsNextHops) {
+      mplsRoutesToDelete.emplace_back(label);
+    }
+  }
+
+  LOG(INFO) << "Warm start adopted " << numAdopted << " routes. Programming "
+            << unicastRoutesToAdd.size() + mplsRoutesToAdd.size()
+            << " routes and deleting "
+            << unicastRoutesToDelete.size() + mplsRoutesToDelete.size()
+            << " stale routes";
+  fb303::fbData->addStatValue(
+      "fib.warm_start.adopted_routes", numAdopted, fb303::SUM);
+
+  // Add before delete, stale routes may cover the added ones
+  if (mplsRoutesToAdd.size()) {
+    client_->sync_addMplsRoutes(kFibId_, mplsRoutesToAdd);
+  }
+  if (unicastRoutesToAdd.size()) {
+    client_->sync_addUnicastRoutes(kFibId_, unicastRoutesToAdd);
+  }
+  if (unicastRoutesToDelete.size()) {
+    client_->sync_deleteUnicastRoutes(kFibId_, unicastRoutesToDelete);
+  }
+  if (mplsRoutesToDelete.size()) {
+    client_->sync_deleteMplsRoutes(kFibId_, mplsRoutesToDelete);
+  }
+}
+
 void
 Fib::syncRouteDbDebounced() {
   if (!syncRoutesTimer_->isScheduled()) {
@@ -674,6 +1675,24 @@ Fib::keepAliveCheck() {
     // set dirty flag
     routeState_.dirtyRouteDb = true;
     expBackoff_.reportSuccess();
+
+    // Check support of compact routes by (re)started agent
+    agentSupportsCompactRoutes_ = false;
+    try {
+      std::vector<thrift::FibFeature> features;
+      client_->sync_getSupportedFeatures(features);
+      agentSupportsCompactRoutes_ =
+          std::find(
+              features.begin(),
+              features.end(),
+              thrift::FibFeature::COMPACT_UNICAST_ROUTES) != features.end();
+    } catch (std::exception const& e) {
+      LOG(INFO) << "FibAgent doesn't support querying of features. Error: "
+                << folly::exceptionStr(e);
+    }
+    LOG(INFO) << "FibAgent "
+              << (agentSupportsCompactRoutes_ ? "supports" : "doesn't support")
+              << " compact routes";
     syncRouteDbDebounced();
   }
   latestAliveSince_ = aliveSince;
@@ -729,15 +1748,83 @@ Fib::updateGlobalCounters() {
       "fib.num_dirty_prefixes", routeState_.dirtyPrefixes.size());
   fb303::fbData->setCounter(
       "fib.num_dirty_labels", routeState_.dirtyLabels.size());
+  fb303::fbData->setCounter(
+      "fib.num_nexthop_groups", routeState_.nextHopGroups.size());
+  fb303::fbData->setCounter(
+      "fib.num_unsynced_routes",
+      routeState_.unsyncedPrefixes.size() + routeState_.unsyncedLabels.size());
 
-  // Count the number of bgp routes
-  int64_t bgpCounter = 0;
-  for (const auto& route : routeState_.unicastRoutes) {
-    if (route.second.bestNexthop_ref().has_value()) {
-      bgpCounter++;
+  fb303::fbData->setCounter("fib.num_routes.BGP", routeState_.numBgpRoutes);
+
+  // Approximate memory held by programmed routes
+  setMemoryCounter("fib", "routes", routeState_.routesBytes);
+}
+
+void
+Fib::updateRouteAggregates(const thrift::UnicastRoute& route, bool add) {
+  const size_t numBgpRoutes = route.bestNexthop_ref().has_value() ? 1 : 0;
+  const size_t bytes = getRouteMemoryUsage(route);
+  if (add) {
+    routeState_.numBgpRoutes += numBgpRoutes;
+    routeState_.routesBytes += bytes;
+  } else {
+    routeState_.numBgpRoutes -= numBgpRoutes;
+    routeState_.routesBytes -= bytes;
+  }
+}
+
+void
+Fib::updateRouteAggregates(const thrift::MplsRoute& route, bool add) {
+  const size_t bytes = getRouteMemoryUsage(route);
+  if (add) {
+    routeState_.routesBytes += bytes;
+  } else {
+    routeState_.routesBytes -= bytes;
+  }
+}
+
+void
+Fib::updateConvergenceHistograms(const thrift::PerfEvents& perfEvents) {
+  auto const& events = perfEvents.events;
+  auto const& eventType = events.front().eventDescr;
+  auto it = convergenceHistograms_.find(eventType);
+  if (it == convergenceHistograms_.end()) {
+    if (convergenceHistograms_.size() >= kMaxConvergenceHistograms) {
+      return;
     }
+    it = convergenceHistograms_
+             .emplace(
+                 eventType,
+                 ConvergenceHistograms{
+                     LatencyHistogram(
+                         Constants::kConvergenceMaxDuration.count() * 1000),
+                     {}})
+             .first;
+  }
+  auto& histograms = it->second;
+  const auto counterPrefix = "fib.convergence_ms." + eventType;
+
+  histograms.endToEnd.addValue(getTotalPerfEventsDuration(perfEvents).count());
+  exportLatencyStats(counterPrefix + ".e2e", histograms.endToEnd);
+
+  // stage durations may be negative with clocks of nodes off, counted as 0
+  for (size_t i = 1; i < events.size(); ++i) {
+    auto const& stage = events[i].eventDescr;
+    auto stageIt = histograms.stages.find(stage);
+    if (stageIt == histograms.stages.end()) {
+      if (histograms.stages.size() >= kMaxConvergenceHistograms) {
+        continue;
+      }
+      stageIt = histograms.stages
+                    .emplace(
+                        stage,
+                        LatencyHistogram(
+                            Constants::kConvergenceMaxDuration.count() * 1000))
+                    .first;
+    }
+    stageIt->second.addValue(events[i].unixTs - events[i - 1].unixTs);
+    exportLatencyStats(counterPrefix + "." + stage, stageIt->second);
   }
-  fb303::fbData->setCounter("fib.num_routes.BGP", bgpCounter);
 }
 
 void
@@ -793,10 +1880,25 @@ Fib::logPerfEvents(std::optional<thrift::PerfEvents> perfEvents) {
     return;
   }
 
+  // Export end-to-end convergence by type of the originating event
+  const auto histName =
+      "convergence.e2e_ms." + perfEvents->events.front().eventDescr;
+  if (convergenceEventTypes_.emplace(histName).second) {
+    fb303::fbData->addHistogram(
+        histName,
+        kConvergenceBucketWidthMs,
+        0,
+        Constants::kConvergenceMaxDuration.count() * 1000);
+    fb303::fbData->exportHistogramPercentile(histName, 50, 95, 99);
+  }
+  fb303::fbData->addHistogramValue(histName, totalDuration.count());
+  updateConvergenceHistograms(*perfEvents);
+
   // Log event
   auto eventStrs = sprintPerfEvents(*perfEvents);
   LOG(INFO) << "OpenR convergence performance. "
-            << "Duration=" << totalDuration.count();
+            << "Duration=" << totalDuration.count() << ", TraceId="
+            << perfEvents->traceId_ref().value_or("");
   for (auto& str : eventStrs) {
     VLOG(2) << "  " << str;
   }
@@ -812,15 +1914,12 @@ Fib::logPerfEvents(std::optional<thrift::PerfEvents> perfEvents) {
       "fib.convergence_time_ms", totalDuration.count(), fb303::AVG);
 
   // Log via zmq monitor
-  fbzmq::LogSample sample{};
-  sample.addString("event", "ROUTE_CONVERGENCE");
-  sample.addString("node_name", myNodeName_);
-  sample.addStringVector("perf_events", eventStrs);
-  sample.addInt("duration_ms", totalDuration.count());
-  zmqMonitorClient_->addEventLog(fbzmq::thrift::EventLog(
-      apache::thrift::FRAGILE,
-      Constants::kEventLogCategory.toString(),
-      {sample.toJson()}));
+  EventLogger::Event event;
+  event.event = "ROUTE_CONVERGENCE";
+  event.strings.emplace_back("node_name", myNodeName_);
+  event.stringVectors.emplace_back("perf_events", std::move(eventStrs));
+  event.ints.emplace_back("duration_ms", totalDuration.count());
+  eventLogger_->log(std::move(event));
 }
 
 } // namespace openr
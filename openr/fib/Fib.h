@@ -7,16 +7,30 @@
 
 #pragma once
 
+#include <array>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
 #include <boost/serialization/strong_typedef.hpp>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/Synchronized.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include <openr/common/AdaptiveRateLimiter.h>
+#include <openr/common/EventLogger.h>
 #include <openr/common/ExponentialBackoff.h>
+#include <openr/common/LatencyHistogram.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/FibService.h>
@@ -25,6 +39,7 @@
 #include <openr/if/gen-cpp2/Platform_types.h>
 #include <openr/kvstore/KvStoreClientInternal.h>
 #include <openr/messaging/Queue.h>
+#include <openr/messaging/ReplicateQueue.h>
 
 namespace openr {
 
@@ -55,6 +70,7 @@ class Fib final : public OpenrEventBase {
       std::chrono::seconds coldStartDuration,
       messaging::RQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue,
       messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+      messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue,
       const MonitorSubmitUrl& monitorSubmitUrl,
       KvStore* kvStore,
       fbzmq::Context& zmqContext);
@@ -73,14 +89,37 @@ class Fib final : public OpenrEventBase {
   /**
    * Perform longest prefix match among all prefixes in route database.
    * @param inputPrefix - a prefix that need to be matched
-   * @param unicastRoutes - current unicast routes in RouteDatabase
+   * @param prefixTrie - trie of current unicast route prefixes in RouteDatabase
    *
    * @return the matched IpPrefix if prefix matching succeed.
    */
   static std::optional<thrift::IpPrefix> longestPrefixMatch(
       const folly::CIDRNetwork& inputPrefix,
-      const std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute>&
-          unicastRoutes);
+      const PrefixTrie<thrift::IpPrefix>& prefixTrie);
+
+  /**
+   * Coalesce route delta `from` into the preceding route delta `into`, such
+   * that processing the result is same as processing both in order.
+   *
+   * @return false if deltas can't be coalesced, both are left untouched then
+   */
+  static bool mergeRouteDatabaseDelta(
+      thrift::RouteDatabaseDelta& into, thrift::RouteDatabaseDelta& from);
+
+  /**
+   * Programming priority of routes. Routes of higher priority are programmed
+   * (and acknowledged) before any route of lower priority.
+   * - HIGH: MPLS routes and host (loopback) prefixes
+   * - DEFAULT: Rest of the routes
+   * - LOW: Routes redistributed from other protocols e.g. BGP
+   */
+  enum class RoutePriority : uint8_t { HIGH = 0, DEFAULT = 1, LOW = 2 };
+  static constexpr size_t kNumRoutePriorities{3};
+
+  static RoutePriority getRoutePriority(const thrift::UnicastRoute& route);
+
+  // Name of the priority, for counters
+  static std::string getRoutePriorityName(RoutePriority priority);
 
   /**
    * NOTE: DEPRECATED! Use getUnicastRoutes or getMplsRoutes.
@@ -106,6 +145,26 @@ class Fib final : public OpenrEventBase {
    */
   folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>> getPerfDb();
 
+  /**
+   * Retrieve perf events of the convergence traced by the `traceId`, as
+   * carried from its originating node through KvStore, Decision and Fib.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>> getConvergenceTrace(
+      std::string traceId);
+
+  /**
+   * Retrieve percentiles of convergence latencies, end-to-end and of every
+   * stage between perf events, by type of the originating event.
+   */
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::ConvergenceStats>>>
+  getConvergenceStats();
+
+  /**
+   * Reader of route deltas processed by Fib, with nexthops resolved. Applying
+   * them in order onto `getRouteDb` snapshot gives the routes of Fib.
+   */
+  messaging::RQueue<thrift::RouteDatabaseDelta> getFibUpdatesReader();
+
  private:
   // No-copy
   Fib(const Fib&) = delete;
@@ -116,6 +175,13 @@ class Fib final : public OpenrEventBase {
    */
   void processRouteUpdates(thrift::RouteDatabaseDelta&& routeDelta);
 
+  /**
+   * Take or drop a reference on the nexthop group of a route stored in
+   * routeState_, if it has one.
+   */
+  void acquireNextHopGroup(const thrift::UnicastRoute& route);
+  void releaseNextHopGroup(const thrift::UnicastRoute& route);
+
   /**
    * Process interface status information from LinkMonitor. We remove all
    * routes associated with interface if we detect that it just went down.
@@ -123,28 +189,105 @@ class Fib final : public OpenrEventBase {
   void processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb);
 
   /**
-   * Convert local perfDb_ into PerfDataBase
+   * Convert local perfDb_ into PerfDataBase, optionally only with the perf
+   * events of the given trace
+   */
+  thrift::PerfDatabase dumpPerfDb(
+      const std::optional<std::string>& traceId = std::nullopt) const;
+
+  /**
+   * Immutable snapshot of the unicast and MPLS routes of route state, read
+   * by the route APIs on the calling thread rather than on Fib thread.
+   * Routes are split in shards by key. New snapshot is published once route
+   * state is updated, and shares the shards (and routes) not changed by the
+   * update with the previous one, so publishing costs in the size of the
+   * update rather than of the routes.
+   */
+  template <typename Key, typename Route>
+  using RouteShard = std::unordered_map<Key, std::shared_ptr<const Route>>;
+  struct RouteSnapshot {
+    RouteSnapshot();
+
+    using UnicastShard = RouteShard<thrift::IpPrefix, thrift::UnicastRoute>;
+    using MplsShard = RouteShard<uint32_t, thrift::MplsRoute>;
+    std::vector<std::shared_ptr<const UnicastShard>> unicastShards;
+    std::vector<std::shared_ptr<const MplsShard>> mplsShards;
+  };
+  static constexpr size_t kNumRouteSnapshotShards{64};
+
+  std::shared_ptr<const RouteSnapshot> getRouteSnapshot() const;
+
+  /**
+   * Publish snapshot of route state, updating the routes of given keys
+   * (deleted if not in route state anymore) in the previous snapshot
    */
-  thrift::PerfDatabase dumpPerfDb() const;
+  void publishRouteSnapshot(
+      const std::vector<thrift::IpPrefix>& prefixes,
+      const std::vector<uint32_t>& labels);
 
   /**
    * Retrieve unicast routes with specified filters
    */
-  std::vector<thrift::UnicastRoute> getUnicastRoutesFiltered(
-      std::vector<std::string> prefixes);
+  static std::vector<thrift::UnicastRoute> getUnicastRoutesFiltered(
+      const RouteSnapshot& snapshot, std::vector<std::string> prefixes);
 
   /**
    * Retrieve mpls routes with specified filters
    */
-  std::vector<thrift::MplsRoute> getMplsRoutesFiltered(
-      std::vector<int32_t> labels);
+  static std::vector<thrift::MplsRoute> getMplsRoutesFiltered(
+      const RouteSnapshot& snapshot, std::vector<int32_t> labels);
 
   /**
-   * Trigger add/del routes thrift calls
+   * Queue add/del routes for programming via route programming pipeline
    * on success no action needed
-   * on failure invokes syncRouteDbDebounced
+   * on failure schedules resync of the routes failed to program. Routes of
+   * the delta are consumed.
+   */
+  void updateRoutes(thrift::RouteDatabaseDelta&& routeDbDelta);
+
+  /**
+   * Dispatch batches of queued route updates to switch agent, as long as
+   * number of batches in flight is below the limit. Backlog of more than a
+   * batch of non-urgent updates is paced at the rate learnt from latency of
+   * agent to program batches.
+   */
+  void programRouteBatches();
+
+  /**
+   * Process result of programming a batch of route updates. On failure
+   * routes of the batch and all queued updates are marked unsynced, and
+   * their resync is scheduled after backoff.
    */
-  void updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta);
+  void processRouteBatchResult(uint64_t batchId, bool success);
+
+  /**
+   * Drop all queued route updates, e.g. when full sync of routes supersedes
+   * them or on programming failure.
+   */
+  void clearPendingRouteUpdates();
+
+  /**
+   * Release reference of route delta on programming (or dropping) of one of
+   * its updates.
+   */
+  void releaseRouteDeltaSeqNum(uint64_t seqNum);
+
+  /**
+   * Log perf events of all the route deltas whose updates are completely
+   * programmed.
+   */
+  void logProgrammedPerfEvents();
+
+  /**
+   * Add routes of the delta to routes to be resynced with the switch agent
+   */
+  void markRoutesUnsynced(const thrift::RouteDatabaseDelta& routeDbDelta);
+
+  /**
+   * Re-program routes whose programming state with the switch agent is
+   * unknown, instead of syncing all the routes
+   */
+  void resyncUnsyncedRoutes();
 
   /**
    * Sync the current routeDb_ with the switch agent.
@@ -153,6 +296,16 @@ class Fib final : public OpenrEventBase {
    */
   bool syncRouteDb();
 
+  /**
+   * Program difference between routes read from the agent and given routes,
+   * adopting routes which are already programmed as is. Used for the first
+   * sync after startup instead of full sync if warm start is enabled.
+   * Throws on failure of thrift calls.
+   */
+  void syncRouteDbWarmStart(
+      const std::vector<thrift::UnicastRoute>& unicastRoutes,
+      const std::vector<thrift::MplsRoute>& mplsRoutes);
+
   /**
    * Asynchrounsly schedules the syncRouteDb call and returns immediately. All
    * APIs should call this function to sync-routes.
@@ -168,6 +321,11 @@ class Fib final : public OpenrEventBase {
   // set flat counter/stats
   void updateGlobalCounters();
 
+  // Account route (or its removal) in the aggregates of route state. Must be
+  // called with the route as stored, before it's replaced or erased
+  void updateRouteAggregates(const thrift::UnicastRoute& route, bool add);
+  void updateRouteAggregates(const thrift::MplsRoute& route, bool add);
+
   // log perf events
   void logPerfEvents(std::optional<thrift::PerfEvents> perfEvents);
 
@@ -178,6 +336,22 @@ class Fib final : public OpenrEventBase {
     std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastRoutes;
     std::unordered_map<uint32_t, thrift::MplsRoute> mplsRoutes;
 
+    // Aggregates of `unicastRoutes` and `mplsRoutes`, maintained as routes
+    // are added and removed so that counters are exported in constant time
+    size_t numBgpRoutes{0};
+    size_t routesBytes{0};
+
+    // Nexthop groups announced by Decision, along with the number of unicast
+    // routes using them. Nexthops of routes using a group are resolved when
+    // the route is received. A group withdrawn by Decision is erased once no
+    // route uses it anymore
+    struct NextHopGroup {
+      std::vector<thrift::NextHopThrift> nextHops;
+      size_t refCount{0};
+      bool withdrawn{false};
+    };
+    std::unordered_map<int64_t, NextHopGroup> nextHopGroups;
+
     // indicates we've received a decision route publication and therefore have
     // routes to sync. will not synce routes with system until this is set
     bool hasRoutesFromDecision{false};
@@ -192,20 +366,217 @@ class Fib final : public OpenrEventBase {
     std::unordered_set<thrift::IpPrefix> dirtyPrefixes;
     std::unordered_set<uint32_t> dirtyLabels;
 
-    // Flag to indicate the result of previous route programming attempt.
-    // If set, it means what currently cached in local routes has not been 100%
-    // successfully synced with agent, we have to trigger an enforced full fib
-    // sync with agent again
+    // Index of routes by interface of their nexthops, so that interface
+    // state change is handled in time of the routes using the interface
+    // rather than of all routes. Kept in sync with `unicastRoutes` and
+    // `mplsRoutes`
+    std::unordered_map<std::string, std::unordered_set<thrift::IpPrefix>>
+        ifNameToPrefixes;
+    std::unordered_map<std::string, std::unordered_set<uint32_t>>
+        ifNameToLabels;
+
+    // Flag to indicate that full fib sync with agent is required, e.g. on
+    // agent restart or failure of previous full sync. If set, it means what
+    // currently cached in local routes has not been 100% successfully synced
+    // with agent, we have to trigger an enforced full fib sync with agent
+    // again
     bool dirtyRouteDb{false};
+
+    // Routes whose programming state with agent is unknown after failure to
+    // program them. They are resynced incrementally, along with route deltas
+    // received in the meantime, unless full sync is required
+    std::unordered_set<thrift::IpPrefix> unsyncedPrefixes;
+    std::unordered_set<int32_t> unsyncedLabels;
   };
   RouteState routeState_;
 
+  // latest snapshot of routes of routeState_, read from other threads
+  folly::Synchronized<std::shared_ptr<const RouteSnapshot>> routeSnapshot_{
+      std::make_shared<const RouteSnapshot>()};
+
+  /**
+   * Route updates queued for programming, keyed on prefix or label. Update
+   * supersedes any update for same key which is still queued. Updates are
+   * dispatched in the order of their priority and then arrival, except
+   * updates whose key is already in flight, which are held back as replies
+   * of concurrent batches can arrive in any order.
+   */
+  template <typename Key, typename Route>
+  struct PendingRouteUpdates {
+    struct Update {
+      Key key;
+      // Route to add/update, std::nullopt for delete
+      std::optional<Route> route;
+      // Sequence number of route delta the update belongs to
+      uint64_t seqNum{0};
+      RoutePriority priority{RoutePriority::DEFAULT};
+      // Time at which update for the key got queued first
+      std::chrono::steady_clock::time_point queuedTs;
+    };
+    using Queue = std::list<Update>;
+
+    // Queue update. Returns sequence number of the superseded update if any
+    std::optional<uint64_t>
+    push(
+        const Key& key,
+        std::optional<Route> route,
+        uint64_t seqNum,
+        RoutePriority priority) {
+      auto& queue = queues.at(static_cast<size_t>(priority));
+      auto it = index.find(key);
+      if (it != index.end()) {
+        auto updateIt = it->second;
+        const auto supersededSeqNum = updateIt->seqNum;
+        updateIt->route = std::move(route);
+        updateIt->seqNum = seqNum;
+        if (updateIt->priority != priority) {
+          // Move update to the queue of its new priority
+          auto& oldQueue = queues.at(static_cast<size_t>(updateIt->priority));
+          updateIt->priority = priority;
+          queue.splice(queue.end(), oldQueue, updateIt);
+        }
+        return supersededSeqNum;
+      }
+      queue.push_back(Update{key,
+                             std::move(route),
+                             seqNum,
+                             priority,
+                             std::chrono::steady_clock::now()});
+      index.emplace(key, std::prev(queue.end()));
+      return std::nullopt;
+    }
+
+    // Highest priority with updates which can be dispatched
+    std::optional<RoutePriority>
+    getTopPriority() const {
+      for (size_t i = 0; i < queues.size(); ++i) {
+        for (auto const& update : queues[i]) {
+          if (not inflight.count(update.key)) {
+            return static_cast<RoutePriority>(i);
+          }
+        }
+      }
+      return std::nullopt;
+    }
+
+    // Pop up to `maxUpdates` updates of the priority whose key is not in
+    // flight, and mark their keys in flight
+    template <typename Fn>
+    size_t
+    pop(RoutePriority priority, size_t maxUpdates, Fn&& fn) {
+      auto& queue = queues.at(static_cast<size_t>(priority));
+      size_t numUpdates = 0;
+      for (auto it = queue.begin();
+           it != queue.end() and numUpdates < maxUpdates;) {
+        if (inflight.count(it->key)) {
+          ++it;
+          continue;
+        }
+        inflight.emplace(it->key);
+        index.erase(it->key);
+        fn(std::move(*it));
+        it = queue.erase(it);
+        ++numUpdates;
+      }
+      return numUpdates;
+    }
+
+    template <typename Fn>
+    void
+    forEach(Fn&& fn) const {
+      for (auto const& queue : queues) {
+        for (auto const& update : queue) {
+          fn(update);
+        }
+      }
+    }
+
+    void
+    clear() {
+      for (auto& queue : queues) {
+        queue.clear();
+      }
+      index.clear();
+    }
+
+    // Number of queued updates
+    size_t
+    size() const {
+      return index.size();
+    }
+
+    std::array<Queue, kNumRoutePriorities> queues;
+    std::unordered_map<Key, typename Queue::iterator> index;
+    // Keys of the updates in flight
+    std::unordered_set<Key> inflight;
+  };
+  PendingRouteUpdates<thrift::IpPrefix, thrift::UnicastRoute>
+      pendingUnicastUpdates_;
+  PendingRouteUpdates<int32_t, thrift::MplsRoute> pendingMplsUpdates_;
+
+  // Batch of route updates of same priority sent to switch agent
+  struct RouteBatch {
+    RoutePriority priority{RoutePriority::DEFAULT};
+    std::vector<thrift::IpPrefix> prefixes;
+    std::vector<int32_t> labels;
+    std::vector<uint64_t> seqNums;
+    std::chrono::steady_clock::time_point sendTs;
+    // Time at which oldest update of the batch got queued
+    std::chrono::steady_clock::time_point queuedTs;
+  };
+  std::unordered_map<uint64_t, RouteBatch> inflightBatches_;
+  uint64_t nextBatchId_{0};
+
+  // Pacing of route batches, to the rate switch agent sustains. Urgent
+  // updates and small deltas aren't paced, they borrow from it
+  AdaptiveRateLimiter programmingRateLimiter_{
+      Constants::kFibMinProgrammingRate,
+      Constants::kFibMaxProgrammingRate,
+      Constants::kFibInitialProgrammingRate,
+      Constants::kFibProgrammingRateStep,
+      static_cast<double>(
+          Constants::kFibProgrammingBatchSize *
+          Constants::kFibMaxInflightBatches),
+      Constants::kFibTargetBatchLatency};
+
+  // Timer to dispatch paced route batches once rate allows
+  std::unique_ptr<folly::AsyncTimeout> programRouteBatchesTimer_{nullptr};
+
+  // Sequence number of the latest route delta, and number of updates of the
+  // route deltas which are queued or in flight. Delta is programmed once it
+  // has no updates outstanding.
+  uint64_t routeDeltaSeqNum_{0};
+  std::map<uint64_t, size_t> outstandingRouteDeltas_;
+
+  // Perf events of route deltas to be logged once they are programmed
+  std::deque<std::pair<uint64_t, thrift::PerfEvents>> pendingPerfEvents_;
+
   // Events to capture and indicate performance of protocol convergence.
   std::deque<thrift::PerfEvents> perfDb_;
 
   // Create timestamp of recently logged perf event
   int64_t recentPerfEventCreateTs_{0};
 
+  // Types of originating events with exported end-to-end convergence
+  // histogram
+  std::unordered_set<std::string> convergenceEventTypes_;
+
+  // Histograms of convergence latencies since start, by type of originating
+  // event, end-to-end and of stages keyed by the perf event ending them.
+  // Number of types and stages is bounded, so is memory
+  struct ConvergenceHistograms {
+    LatencyHistogram endToEnd;
+    std::map<std::string, LatencyHistogram> stages;
+  };
+  std::map<std::string, ConvergenceHistograms> convergenceHistograms_;
+
+  // Record convergence latencies of perf events in convergenceHistograms_
+  // and export their percentiles as counters
+  void updateConvergenceHistograms(const thrift::PerfEvents& perfEvents);
+
+  // Queue to publish route deltas processed by Fib
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue_;
+
   // Interface status map
   std::unordered_map<std::string /* ifName*/, bool /* isUp */>
       interfaceStatusDb_;
@@ -225,6 +596,10 @@ class Fib final : public OpenrEventBase {
   // indicates that we should publish fib programming time to kvstore
   bool enableOrderedFib_{false};
 
+  // First sync adopts routes already programmed in agent, instead of full
+  // sync. Cleared once attempted, falling back to full sync on failure
+  bool warmStartPending_{false};
+
   apache::thrift::CompactSerializer serializer_;
 
   // Thrift client connection to switch FIB Agent using which we actually
@@ -233,6 +608,11 @@ class Fib final : public OpenrEventBase {
   std::shared_ptr<folly::AsyncSocket> socket_{nullptr};
   std::unique_ptr<thrift::FibServiceAsyncClient> client_{nullptr};
 
+  // Thrift client connection to switch FIB Agent on the event base of Fib
+  // for pipelined (asynchronous) route programming
+  std::shared_ptr<folly::AsyncSocket> programmingSocket_{nullptr};
+  std::unique_ptr<thrift::FibServiceAsyncClient> programmingClient_{nullptr};
+
   // Callback timer to sync routes to switch agent and scheduled on route-sync
   // failure. ExponentialBackoff timer to ease up things if they go wrong
   std::unique_ptr<folly::AsyncTimeout> syncRoutesTimer_{nullptr};
@@ -244,6 +624,9 @@ class Fib final : public OpenrEventBase {
   // client to interact with monitor
   std::unique_ptr<fbzmq::ZmqMonitorClient> zmqMonitorClient_;
 
+  // ships event logs to monitor off the Fib thread
+  std::unique_ptr<EventLogger> eventLogger_;
+
   // module ptr to refer to KvStore for KvStoreClientInternal usage
   KvStore* kvStore_{nullptr};
   std::unique_ptr<KvStoreClientInternal> kvStoreClient_;
@@ -252,6 +635,10 @@ class Fib final : public OpenrEventBase {
   // it means that FibAgent has restarted and we need to perform sync.
   int64_t latestAliveSince_{0};
 
+  // Whether FibAgent supports programming of routes in compact form. Queried
+  // whenever agent (re)starts
+  bool agentSupportsCompactRoutes_{false};
+
   // moves to true after initial sync
   bool hasSyncedFib_{false};
 
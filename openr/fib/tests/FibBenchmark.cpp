@@ -5,11 +5,21 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/async/StopEventLoopSignalHandler.h>
 #include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Subprocess.h>
 #include <folly/init/Init.h>
+#include <folly/system/Shell.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <thrift/lib/cpp2/util/ScopedServerThread.h>
@@ -20,8 +30,18 @@
 #include <openr/fib/tests/MockNetlinkFibHandler.h>
 #include <openr/fib/tests/PrefixGenerator.h>
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/nl/NetlinkProtocolSocket.h>
+#include <openr/platform/NetlinkFibHandler.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 
+DEFINE_bool(
+    fib_benchmark_netlink,
+    false,
+    "Program routes into kernel with NetlinkFibHandler instead of mock "
+    "handler. Must be run as root, preferably in a dedicated network "
+    "namespace (e.g. with `ip netns exec`) as veth interfaces are created. "
+    "MPLS benchmarks additionally require kernel MPLS support to be enabled");
+
 /**
  * Defines a benchmark that allows users to record customized counter during
  * benchmarking and passes a parameter to another one. This is common for
@@ -46,7 +66,8 @@
   }
 
 namespace {
-// Virtual interface
+// Virtual interfaces
+const std::string kVethNameX("vethTestX");
 const std::string kVethNameY("vethTestY");
 // Prefix length of a subnet
 static const long kBitMaskLen = 128;
@@ -54,28 +75,114 @@ static const long kBitMaskLen = 128;
 static const uint32_t kDeltaSize = 10;
 // Number of nexthops
 const uint8_t kNumOfNexthops = 128;
+// Prefix length of prefixes for longest prefix match lookups
+static const long kLpmPrefixLen = 64;
+// Fraction of routes updated with every delta of churn benchmarks
+const double kChurnRatio = 0.01;
+// Number of nexthops shared by ECMP routes of churn benchmarks
+const size_t kNumOfEcmpNexthops = 4;
+// First label of MPLS routes
+const int32_t kMplsLabelStart = 16;
+// Maximum time to wait for route delta to get programmed
+const std::chrono::seconds kProgrammingTimeout{60};
+
+// Number of heap allocations made by the benchmark process
+std::atomic<uint64_t> numAllocations{0};
 
 } // anonymous namespace
 
+// Count allocations, reported by allocation benchmarks
+void*
+operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /* size */) noexcept {
+  std::free(ptr);
+}
+
 namespace openr {
 
+using namespace folly::literals::shell_literals;
+
 using apache::thrift::ThriftServer;
 using apache::thrift::util::ScopedServerThread;
 
+namespace {
+
+void
+runCommand(std::vector<std::string> cmd, bool ignoreError = false) {
+  folly::Subprocess proc(std::move(cmd));
+  const auto status = proc.wait();
+  CHECK(ignoreError or status.exitStatus() == 0) << status.str();
+}
+
+// Create veth interface pair for routes to be programmed into kernel
+void
+createVethPair() {
+  runCommand("ip link del {}"_shellify(kVethNameX.c_str()), true);
+  runCommand("ip link add {} type veth peer name {}"_shellify(
+      kVethNameX.c_str(), kVethNameY.c_str()));
+  runCommand("ip link set dev {} up"_shellify(kVethNameX.c_str()));
+  runCommand("ip link set dev {} up"_shellify(kVethNameY.c_str()));
+}
+
+// Nexthops shared by the ECMP routes of churn benchmarks
+std::vector<thrift::NextHopThrift>
+getEcmpNexthops(std::optional<thrift::MplsAction> mplsAction = std::nullopt) {
+  std::vector<thrift::NextHopThrift> nextHops;
+  for (size_t i = 0; i < kNumOfEcmpNexthops; ++i) {
+    nextHops.emplace_back(createNextHop(
+        toBinaryAddress(folly::sformat("fe80::{}", i + 1)),
+        kVethNameY,
+        1,
+        mplsAction));
+  }
+  return nextHops;
+}
+
+} // namespace
+
+/**
+ * Fib module talking to FibService backed by either MockNetlinkFibHandler or
+ * (with --fib_benchmark_netlink) NetlinkFibHandler programming the kernel.
+ * Completion of route programming is tracked through perf events of route
+ * deltas, hence it is same for both the backends.
+ */
 class FibWrapper {
  public:
-  FibWrapper() {
+  explicit FibWrapper(bool enableSegmentRouting = false) {
     // Register Singleton
     folly::SingletonVault::singleton()->registrationComplete();
-    // Create MockNetlinkFibHandler
-    mockFibHandler = std::make_shared<MockNetlinkFibHandler>();
+    if (FLAGS_fib_benchmark_netlink) {
+      // Create NetlinkFibHandler programming kernel
+      createVethPair();
+      nlSock = std::make_unique<fbnl::NetlinkProtocolSocket>(&nlEvb);
+      nlEvbThread = std::thread([this]() { nlEvb.loopForever(); });
+      nlEvb.waitUntilRunning();
+      fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+    } else {
+      // Create MockNetlinkFibHandler
+      mockFibHandler = std::make_shared<MockNetlinkFibHandler>();
+      fibHandler = mockFibHandler;
+    }
 
     // Start ThriftServer
     server = std::make_shared<ThriftServer>();
     server->setNumIOWorkerThreads(1);
     server->setNumAcceptThreads(1);
     server->setPort(0);
-    server->setInterface(mockFibHandler);
+    server->setInterface(fibHandler);
     fibThriftThread.start(server);
 
     auto tConfig = getBasicOpenrConfig(
@@ -83,7 +190,7 @@ class FibWrapper {
         "domain",
         std::nullopt, /* area config */
         true, /* enableV4 */
-        false /*enableSegmentRouting*/,
+        enableSegmentRouting,
         false /*orderedFibProgramming*/,
         false /*dryrun*/);
     config = std::make_shared<Config>(tConfig);
@@ -96,6 +203,7 @@ class FibWrapper {
         std::chrono::seconds(2), // coldStartDuration
         routeUpdatesQueue.getReader(),
         interfaceUpdatesQueue.getReader(),
+        fibUpdatesQueue,
         MonitorSubmitUrl{"inproc://monitor-sub"},
         nullptr, /* KvStore module ptr */
         context);
@@ -130,14 +238,26 @@ class FibWrapper {
     // Close queue
     routeUpdatesQueue.close();
     interfaceUpdatesQueue.close();
+    fibUpdatesQueue.close();
 
     // This will be invoked before Fib's d-tor
     fib->stop();
     fibThread->join();
 
     // Stop mocked nl platform
-    mockFibHandler->stop();
+    if (mockFibHandler) {
+      mockFibHandler->stop();
+    }
     fibThriftThread.stop();
+
+    if (nlSock) {
+      fibHandler.reset();
+      nlEvb.terminateLoopSoon();
+      nlEvbThread.join();
+      nlSock.reset();
+      // Routes go away along with the interfaces
+      runCommand("ip link del {}"_shellify(kVethNameX.c_str()), true);
+    }
   }
 
   thrift::PerfDatabase
@@ -152,25 +272,52 @@ class FibWrapper {
     return perfDb;
   }
 
-  void
-  accumulatePerfTimes(std::vector<uint64_t>& processTimes) {
-    // Get perfDB
-    auto perfDB = getPerfDb();
-    // If get empty perfDB, just log it
-    if (perfDB.eventInfo.size() == 0 or
-        perfDB.eventInfo[0].events.size() == 0) {
-      LOG(INFO) << "perfDB is emtpy.";
-    } else {
-      // Accumulate time into processTimes
-      // Each time get the latest perf event.
-      auto perfDBInfoSize = perfDB.eventInfo.size();
-      auto eventInfo = perfDB.eventInfo[perfDBInfoSize - 1];
-      for (size_t index = 1; index < eventInfo.events.size(); index++) {
-        processTimes[index - 1] +=
-            (eventInfo.events[index].unixTs -
-             eventInfo.events[index - 1].unixTs);
+  /**
+   * Send route delta to Fib and wait until it is programmed. Returns perf
+   * events of the delta as logged by Fib
+   */
+  thrift::PerfEvents
+  programRouteDelta(thrift::RouteDatabaseDelta routeDbDelta) {
+    // Fib ignores perf events not newer than the last logged one, hence
+    // creation time of perf events of every delta must be unique
+    while (getUnixTimeStampMs() <= lastPerfEventTs_) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    thrift::PerfEvents perfEvents;
+    addPerfEvent(perfEvents, routeDbDelta.thisNodeName, "FIB_INIT_UPDATE");
+    lastPerfEventTs_ = perfEvents.events.at(0).unixTs;
+    routeDbDelta.perfEvents_ref() = std::move(perfEvents);
+    routeUpdatesQueue.push(std::move(routeDbDelta));
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + kProgrammingTimeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+      for (auto& eventInfo : getPerfDb().eventInfo) {
+        if (eventInfo.events.size() and
+            eventInfo.events.front().unixTs == lastPerfEventTs_) {
+          return std::move(eventInfo);
+        }
       }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    LOG(FATAL) << "Timed out waiting for route delta to get programmed";
+    return {};
+  }
+
+  /**
+   * Load initial routes, which get programmed with the initial sync of Fib,
+   * and wait until they're programmed
+   */
+  void
+  loadRoutes(thrift::RouteDatabaseDelta routeDbDelta) {
+    routeUpdatesQueue.push(std::move(routeDbDelta));
+    while (fb303::fbData->getCounters()["fib.synced"] != 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
+    // Empty delta is reported programmed only after all the previous ones
+    thrift::RouteDatabaseDelta emptyDelta;
+    emptyDelta.thisNodeName = "node-1";
+    programRouteDelta(std::move(emptyDelta));
   }
 
   int port{0};
@@ -179,6 +326,7 @@ class FibWrapper {
 
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
   messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue;
 
   fbzmq::Context context{};
 
@@ -186,11 +334,69 @@ class FibWrapper {
   std::shared_ptr<Fib> fib;
   std::unique_ptr<std::thread> fibThread;
 
+  std::shared_ptr<thrift::FibServiceSvIf> fibHandler;
   std::shared_ptr<MockNetlinkFibHandler> mockFibHandler;
   PrefixGenerator prefixGenerator;
 
+  // Netlink socket used by NetlinkFibHandler
+  folly::EventBase nlEvb;
+  std::thread nlEvbThread;
+  std::unique_ptr<fbnl::NetlinkProtocolSocket> nlSock;
+
   // thriftServer to talk to Fib
   std::shared_ptr<OpenrThriftServerWrapper> openrThriftServerWrapper_{nullptr};
+
+ private:
+  // Creation time of perf events of the last route delta
+  int64_t lastPerfEventTs_{0};
+};
+
+/**
+ * Latency of route deltas from Decision to programmed routes, based on perf
+ * events logged by Fib:
+ * FIB_INIT_UPDATE -> FIB_ROUTE_DB_RECVD -> FIB_ROUTES_QUEUED ->
+ * OPENR_FIB_ROUTES_PROGRAMMED
+ */
+class RouteDeltaLatency {
+ public:
+  void
+  add(const thrift::PerfEvents& perfEvents) {
+    CHECK_EQ(stageTimes_.size() + 1, perfEvents.events.size());
+    for (size_t index = 1; index < perfEvents.events.size(); index++) {
+      stageTimes_[index - 1] += perfEvents.events[index].unixTs -
+          perfEvents.events[index - 1].unixTs;
+    }
+    latencies_.emplace_back(
+        perfEvents.events.back().unixTs - perfEvents.events.front().unixTs);
+  }
+
+  // Add average time of stages and percentiles of end-to-end latency (in ms)
+  void
+  report(folly::UserCounters& counters) {
+    if (latencies_.empty()) {
+      return;
+    }
+    const int64_t count = latencies_.size();
+    counters["route_receive"] = stageTimes_[0] / count;
+    counters["route_process"] = stageTimes_[1] / count;
+    counters["route_install"] = stageTimes_[2] / count;
+
+    std::sort(latencies_.begin(), latencies_.end());
+    counters["latency_p50"] = percentile(50);
+    counters["latency_p90"] = percentile(90);
+    counters["latency_p99"] = percentile(99);
+    counters["latency_max"] = latencies_.back();
+  }
+
+ private:
+  int64_t
+  percentile(size_t p) const {
+    return latencies_.at(std::min(
+        latencies_.size() - 1, (latencies_.size() * p + 99) / 100 - 1));
+  }
+
+  std::array<int64_t, 3> stageTimes_{};
+  std::vector<int64_t> latencies_;
 };
 
 /**
@@ -206,9 +412,6 @@ BM_Fib(folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
   // Fib starts with clean route database
   auto fibWrapper = std::make_unique<FibWrapper>();
 
-  // Initial syncFib debounce
-  fibWrapper->mockFibHandler->waitForSyncFib();
-
   // Generate random prefixes
   auto prefixes = fibWrapper->prefixGenerator.ipv6PrefixGenerator(
       numOfPrefixes, kBitMaskLen);
@@ -221,14 +424,9 @@ BM_Fib(folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
             kNumOfNexthops, kVethNameY)));
   }
   // Send routeDB to Fib and wait for updating completing
-  fibWrapper->routeUpdatesQueue.push(routeDbDelta);
-  fibWrapper->mockFibHandler->waitForUpdateUnicastRoutes();
-
-  // Customized time counter
-  // processTimes[0] is the time of sending routDB from decision to Fib
-  // processTimes[1] is the time of processing DB within Fib
-  // processTimes[2] is the time of programming routs with Fib agent server
-  std::vector<uint64_t> processTimes{0, 0, 0};
+  fibWrapper->loadRoutes(routeDbDelta);
+
+  RouteDeltaLatency latency;
   // Maek sure deltaSize <= numOfPrefixes
   auto deltaSize = kDeltaSize <= numOfPrefixes ? kDeltaSize : numOfPrefixes;
   suspender.dismiss(); // Start measuring benchmark time
@@ -242,28 +440,13 @@ BM_Fib(folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
           fibWrapper->prefixGenerator.getRandomNextHopsUnicast(
               kNumOfNexthops, kVethNameY)));
     }
-    // Add perfevents
-    thrift::PerfEvents perfEvents;
-    addPerfEvent(perfEvents, routeDbDelta.thisNodeName, "FIB_INIT_UPDATE");
-    routeDbDelta.perfEvents_ref() = perfEvents;
 
     // Send routeDB to Fib for updates
-    fibWrapper->routeUpdatesQueue.push(routeDbDelta);
-    fibWrapper->mockFibHandler->waitForUpdateUnicastRoutes();
-
-    // Get time information from perf event
-    fibWrapper->accumulatePerfTimes(processTimes);
+    latency.add(fibWrapper->programRouteDelta(routeDbDelta));
   }
 
   suspender.rehire(); // Stop measuring time again
-  // Get average time for each itaration
-  for (auto& processTime : processTimes) {
-    processTime /= iters == 0 ? 1 : iters;
-  }
-
-  // Add customized counters to state.
-  counters["route_receive"] = processTimes[0];
-  counters["route_install"] = processTimes[2];
+  latency.report(counters);
 }
 
 // The parameter is the number of prefixes sent to fib
@@ -272,6 +455,297 @@ BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 100);
 BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 1000);
 BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 9000);
 
+namespace {
+
+/**
+ * Window of `kChurnRatio` of the routes updated by iteration of churn
+ * benchmarks. Every window is updated by two consecutive iterations, first
+ * of which applies the churn and second one reverts it.
+ */
+std::vector<size_t>
+getChurnWindow(uint32_t iter, size_t numOfRoutes) {
+  const size_t churnSize =
+      std::max<size_t>(1, static_cast<size_t>(numOfRoutes * kChurnRatio));
+  const size_t start = (iter / 2) * churnSize;
+  std::vector<size_t> window;
+  window.reserve(churnSize);
+  for (size_t i = 0; i < churnSize; i++) {
+    window.emplace_back((start + i) % numOfRoutes);
+  }
+  return window;
+}
+
+/**
+ * Initial ECMP unicast routes of churn benchmarks
+ */
+thrift::RouteDatabaseDelta
+createEcmpRouteDelta(const std::vector<thrift::IpPrefix>& prefixes) {
+  const auto nextHops = getEcmpNexthops();
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  routeDbDelta.unicastRoutesToUpdate.reserve(prefixes.size());
+  for (auto const& prefix : prefixes) {
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(
+        createUnicastRoute(prefix, nextHops));
+  }
+  return routeDbDelta;
+}
+
+} // namespace
+
+/**
+ * Benchmark for ECMP membership churn, e.g. on adjacency flaps
+ * 1. Program ECMP routes over shared set of nexthops
+ * 2. Remove a nexthop from a window of routes, and add it back with next
+ *    iteration
+ */
+static void
+BM_FibEcmpChurn(
+    folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto prefixes =
+      PrefixGenerator::ipv6PrefixGenerator(numOfPrefixes, kBitMaskLen);
+  const auto nextHops = getEcmpNexthops();
+  auto fibWrapper = std::make_unique<FibWrapper>();
+  fibWrapper->loadRoutes(createEcmpRouteDelta(prefixes));
+
+  RouteDeltaLatency latency;
+  for (uint32_t i = 0; i < iters; i++) {
+    thrift::RouteDatabaseDelta routeDbDelta;
+    routeDbDelta.thisNodeName = "node-1";
+    auto routeNextHops = nextHops;
+    if (i % 2 == 0) {
+      routeNextHops.erase(
+          routeNextHops.begin() + (i / 2) % routeNextHops.size());
+    }
+    for (auto index : getChurnWindow(i, prefixes.size())) {
+      routeDbDelta.unicastRoutesToUpdate.emplace_back(
+          createUnicastRoute(prefixes[index], routeNextHops));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    latency.add(fibWrapper->programRouteDelta(std::move(routeDbDelta)));
+    suspender.rehire(); // Stop measuring time again
+  }
+  latency.report(counters);
+}
+
+/**
+ * Benchmark for prefix add/withdraw storms, e.g. on partitioning of a remote
+ * part of the network
+ * 1. Program ECMP routes
+ * 2. Withdraw a window of routes, and add them back with next iteration
+ */
+static void
+BM_FibPrefixStorm(
+    folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto prefixes =
+      PrefixGenerator::ipv6PrefixGenerator(numOfPrefixes, kBitMaskLen);
+  const auto nextHops = getEcmpNexthops();
+  auto fibWrapper = std::make_unique<FibWrapper>();
+  fibWrapper->loadRoutes(createEcmpRouteDelta(prefixes));
+
+  RouteDeltaLatency latency;
+  for (uint32_t i = 0; i < iters; i++) {
+    thrift::RouteDatabaseDelta routeDbDelta;
+    routeDbDelta.thisNodeName = "node-1";
+    for (auto index : getChurnWindow(i, prefixes.size())) {
+      if (i % 2 == 0) {
+        routeDbDelta.unicastRoutesToDelete.emplace_back(prefixes[index]);
+      } else {
+        routeDbDelta.unicastRoutesToUpdate.emplace_back(
+            createUnicastRoute(prefixes[index], nextHops));
+      }
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    latency.add(fibWrapper->programRouteDelta(std::move(routeDbDelta)));
+    suspender.rehire(); // Stop measuring time again
+  }
+  latency.report(counters);
+}
+
+/**
+ * Benchmark for MPLS label swaps, e.g. on label re-allocation of remote nodes
+ * 1. Program MPLS routes swapping top label over ECMP nexthops
+ * 2. Change swap label of a window of routes, and restore it with next
+ *    iteration
+ */
+static void
+BM_FibMplsLabelSwap(
+    folly::UserCounters& counters, uint32_t iters, unsigned numOfLabels) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto createSwapRoute = [](int32_t topLabel, int32_t swapLabel) {
+    return createMplsRoute(
+        topLabel,
+        getEcmpNexthops(
+            createMplsAction(thrift::MplsActionCode::SWAP, swapLabel)));
+  };
+  thrift::RouteDatabaseDelta initialDelta;
+  initialDelta.thisNodeName = "node-1";
+  for (int32_t label = kMplsLabelStart;
+       label < kMplsLabelStart + static_cast<int32_t>(numOfLabels);
+       label++) {
+    initialDelta.mplsRoutesToUpdate.emplace_back(
+        createSwapRoute(label, label));
+  }
+  auto fibWrapper = std::make_unique<FibWrapper>(true /* segment routing */);
+  fibWrapper->loadRoutes(std::move(initialDelta));
+
+  RouteDeltaLatency latency;
+  for (uint32_t i = 0; i < iters; i++) {
+    thrift::RouteDatabaseDelta routeDbDelta;
+    routeDbDelta.thisNodeName = "node-1";
+    for (auto index : getChurnWindow(i, numOfLabels)) {
+      const int32_t label = kMplsLabelStart + static_cast<int32_t>(index);
+      // Swap to next label, or back to the original one
+      const int32_t swapLabel = i % 2 == 0
+          ? kMplsLabelStart + static_cast<int32_t>((index + 1) % numOfLabels)
+          : label;
+      routeDbDelta.mplsRoutesToUpdate.emplace_back(
+          createSwapRoute(label, swapLabel));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    latency.add(fibWrapper->programRouteDelta(std::move(routeDbDelta)));
+    suspender.rehire(); // Stop measuring time again
+  }
+  latency.report(counters);
+}
+
+namespace {
+
+/**
+ * Route delta of `numOfRoutes` unicast and mpls routes, half of nexthops of
+ * which aren't best ones and get dropped by best nexthop patching
+ */
+thrift::RouteDatabaseDelta
+createMixedMetricRouteDelta(size_t numOfRoutes) {
+  auto nextHops = getEcmpNexthops();
+  auto mplsNextHops =
+      getEcmpNexthops(createMplsAction(thrift::MplsActionCode::PHP));
+  for (size_t i = 0; i < nextHops.size() / 2; ++i) {
+    nextHops.at(i).metric += 1;
+    mplsNextHops.at(i).metric += 1;
+  }
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  for (const auto& prefix :
+       PrefixGenerator::ipv6PrefixGenerator(numOfRoutes, kBitMaskLen)) {
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(
+        createUnicastRoute(prefix, nextHops));
+  }
+  for (size_t i = 0; i < numOfRoutes; ++i) {
+    routeDbDelta.mplsRoutesToUpdate.emplace_back(createMplsRoute(
+        kMplsLabelStart + static_cast<int32_t>(i), mplsNextHops));
+  }
+  return routeDbDelta;
+}
+
+/**
+ * Patch routes of route delta with their best nexthops as Fib does on every
+ * route delta, either creating patched copies of the routes or patching them
+ * in place. Reports number of allocations per route.
+ */
+void
+runBestNexthopsPatching(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfRoutes,
+    bool inPlace) {
+  auto suspender = folly::BenchmarkSuspender();
+  uint64_t allocations{0};
+  for (uint32_t i = 0; i < iters; i++) {
+    auto routeDbDelta = createMixedMetricRouteDelta(numOfRoutes);
+
+    suspender.dismiss(); // Start measuring benchmark time
+    const auto allocationsBefore = numAllocations.load();
+    if (inPlace) {
+      patchUnicastRoutesWithBestNexthops(routeDbDelta.unicastRoutesToUpdate);
+      patchMplsRoutesWithBestNextHops(routeDbDelta.mplsRoutesToUpdate);
+    } else {
+      auto unicastRoutes = createUnicastRoutesWithBestNexthops(
+          routeDbDelta.unicastRoutesToUpdate);
+      auto mplsRoutes =
+          createMplsRoutesWithBestNextHops(routeDbDelta.mplsRoutesToUpdate);
+      folly::doNotOptimizeAway(unicastRoutes);
+      folly::doNotOptimizeAway(mplsRoutes);
+    }
+    allocations += numAllocations.load() - allocationsBefore;
+    suspender.rehire(); // Stop measuring time again
+
+    folly::doNotOptimizeAway(routeDbDelta);
+  }
+  counters["allocs_per_route"] = allocations / (2 * numOfRoutes * iters);
+}
+
+} // namespace
+
+/**
+ * Benchmark for best nexthop patching of routes received by Fib
+ * 1. Create route delta with unicast and mpls routes
+ * 2. Patch it with best nexthops, by copy or in place
+ */
+static void
+BM_FibBestNexthopsCopy(
+    folly::UserCounters& counters, uint32_t iters, unsigned numOfRoutes) {
+  runBestNexthopsPatching(counters, iters, numOfRoutes, false /* inPlace */);
+}
+
+static void
+BM_FibBestNexthopsInPlace(
+    folly::UserCounters& counters, uint32_t iters, unsigned numOfRoutes) {
+  runBestNexthopsPatching(counters, iters, numOfRoutes, true /* inPlace */);
+}
+
+// The parameter is the number of routes in route database
+BENCHMARK_COUNTERS_PARAM(BM_FibEcmpChurn, counters, 100000);
+BENCHMARK_COUNTERS_PARAM(BM_FibEcmpChurn, counters, 1000000);
+BENCHMARK_COUNTERS_PARAM(BM_FibPrefixStorm, counters, 100000);
+BENCHMARK_COUNTERS_PARAM(BM_FibPrefixStorm, counters, 1000000);
+BENCHMARK_COUNTERS_PARAM(BM_FibMplsLabelSwap, counters, 100000);
+BENCHMARK_COUNTERS_PARAM(BM_FibMplsLabelSwap, counters, 1000000);
+
+// The parameter is the number of unicast and mpls routes in route delta
+BENCHMARK_COUNTERS_PARAM(BM_FibBestNexthopsCopy, counters, 1000);
+BENCHMARK_COUNTERS_PARAM(BM_FibBestNexthopsCopy, counters, 100000);
+BENCHMARK_COUNTERS_PARAM(BM_FibBestNexthopsInPlace, counters, 1000);
+BENCHMARK_COUNTERS_PARAM(BM_FibBestNexthopsInPlace, counters, 100000);
+
+/**
+ * Benchmark for longest prefix match lookups in Fib
+ * 1. Generate random IpV6 prefixes and insert them in prefix trie
+ * 2. Measure longest prefix match of addresses covered by those prefixes
+ */
+static void
+BM_FibLongestPrefixMatch(uint32_t iters, size_t numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  PrefixGenerator prefixGenerator;
+  PrefixTrie<thrift::IpPrefix> prefixTrie;
+  std::vector<folly::CIDRNetwork> lookups;
+  for (const auto& prefix : prefixGenerator.ipv6PrefixGenerator(
+           numOfPrefixes, kLpmPrefixLen)) {
+    auto network = toIPNetwork(prefix);
+    prefixTrie.insert(network, prefix);
+    lookups.emplace_back(network.first, 128);
+  }
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto match =
+        Fib::longestPrefixMatch(lookups[i % lookups.size()], prefixTrie);
+    folly::doNotOptimizeAway(match);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+}
+
+// The parameter is the number of prefixes in route database
+BENCHMARK_PARAM(BM_FibLongestPrefixMatch, 1000);
+BENCHMARK_PARAM(BM_FibLongestPrefixMatch, 10000);
+BENCHMARK_PARAM(BM_FibLongestPrefixMatch, 150000);
+
 } // namespace openr
 
 int
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/async/StopEventLoopSignalHandler.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
@@ -29,6 +30,7 @@
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <thrift/lib/cpp2/util/ScopedServerThread.h>
 
+#include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
@@ -192,8 +194,8 @@ checkEqualMplsRoutes(thrift::RouteDatabase lhs, thrift::RouteDatabase rhs) {
 
 class FibTestFixture : public ::testing::Test {
  public:
-  explicit FibTestFixture(bool waitOnDecision = false)
-      : waitOnDecision_(waitOnDecision) {}
+  explicit FibTestFixture(bool waitOnDecision = false, bool warmStart = false)
+      : waitOnDecision_(waitOnDecision), warmStart_(warmStart) {}
   void
   SetUp() override {
     mockFibHandler = std::make_shared<MockNetlinkFibHandler>();
@@ -218,6 +220,9 @@ class FibTestFixture : public ::testing::Test {
     if (waitOnDecision_) {
       tConfig.eor_time_s_ref() = 1;
     }
+    if (warmStart_) {
+      tConfig.enable_fib_warm_start_ref() = true;
+    }
 
     config = make_shared<Config>(tConfig);
 
@@ -227,6 +232,7 @@ class FibTestFixture : public ::testing::Test {
         std::chrono::seconds(2), /* coldStartDuration */
         routeUpdatesQueue.getReader(),
         interfaceUpdatesQueue.getReader(),
+        fibUpdatesQueue,
         MonitorSubmitUrl{"inproc://monitor-sub"},
         nullptr, /* KvStore module ptr */
         context);
@@ -261,6 +267,7 @@ class FibTestFixture : public ::testing::Test {
 
     routeUpdatesQueue.close();
     interfaceUpdatesQueue.close();
+    fibUpdatesQueue.close();
 
     // this will be invoked before Fib's d-tor
     LOG(INFO) << "Stopping the Fib thread";
@@ -325,6 +332,7 @@ class FibTestFixture : public ::testing::Test {
 
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
   messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue;
 
   fbzmq::Context context{};
 
@@ -342,6 +350,7 @@ class FibTestFixture : public ::testing::Test {
   std::shared_ptr<OpenrThriftServerWrapper> openrThriftServerWrapper_{nullptr};
 
   bool waitOnDecision_{false};
+  bool warmStart_{false};
 };
 
 TEST_F(FibTestFixture, processRouteDb) {
@@ -446,7 +455,8 @@ TEST_F(FibTestFixture, processInterfaceDb) {
               createThriftInterfaceInfo(true, 122, {}),
           },
       },
-      thrift::PerfEvents());
+      thrift::PerfEvents(),
+      false /* isDelta */);
   intfDb.perfEvents_ref().reset();
   LOG(INFO) << "Pushing interface update";
   interfaceUpdatesQueue.push(intfDb);
@@ -482,8 +492,13 @@ TEST_F(FibTestFixture, processInterfaceDb) {
               createThriftInterfaceInfo(false, 121, {}),
           },
       },
-      thrift::PerfEvents());
+      thrift::PerfEvents(),
+      false /* isDelta */);
   intfChange_1.perfEvents_ref().reset();
+  const auto affectedRoutes = facebook::fb303::fbData->getCounters().at(
+      "fib.interface_affected_routes.sum");
+  const auto lfaRepairs =
+      facebook::fb303::fbData->getCounters().at("fib.lfa_repairs.sum");
   LOG(INFO) << "Pushing interface update";
   interfaceUpdatesQueue.push(intfChange_1);
 
@@ -491,6 +506,19 @@ TEST_F(FibTestFixture, processInterfaceDb) {
   mockFibHandler->waitForUpdateUnicastRoutes();
   mockFibHandler->waitForDeleteMplsRoutes();
   mockFibHandler->waitForUpdateMplsRoutes();
+  // only routes using the interface are looked at, all of them here
+  EXPECT_EQ(
+      affectedRoutes + 4,
+      facebook::fb303::fbData->getCounters().at(
+          "fib.interface_affected_routes.sum"));
+  // prefix2 loses its only shortest nexthop and falls back to the alternate
+  EXPECT_EQ(
+      lfaRepairs + 1,
+      facebook::fb303::fbData->getCounters().at("fib.lfa_repairs.sum"));
+  EXPECT_EQ(
+      1,
+      facebook::fb303::fbData->getCounters().count(
+          "fib.link_down_reaction_ms.avg"));
   EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 3);
   EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 1);
   EXPECT_EQ(mockFibHandler->getAddMplsRoutesCount(), 3);
@@ -530,7 +558,8 @@ TEST_F(FibTestFixture, processInterfaceDb) {
               createThriftInterfaceInfo(false, 122, {}),
           },
       },
-      thrift::PerfEvents());
+      thrift::PerfEvents(),
+      false /* isDelta */);
   intfChange_2.perfEvents_ref().reset();
   LOG(INFO) << "Pushing interface update";
   interfaceUpdatesQueue.push(intfChange_2);
@@ -589,7 +618,8 @@ TEST_F(FibTestFixture, processInterfaceDbWithNoIfnameNexthop) {
               createThriftInterfaceInfo(true, 121, {}),
           },
       },
-      thrift::PerfEvents());
+      thrift::PerfEvents(),
+      false /* isDelta */);
   intfDb.perfEvents_ref().reset();
   LOG(INFO) << "Pushing interface update";
   interfaceUpdatesQueue.push(intfDb);
@@ -619,7 +649,8 @@ TEST_F(FibTestFixture, processInterfaceDbWithNoIfnameNexthop) {
               createThriftInterfaceInfo(false, 121, {}),
           },
       },
-      thrift::PerfEvents());
+      thrift::PerfEvents(),
+      false /* isDelta */);
   intfChange_1.perfEvents_ref().reset();
   LOG(INFO) << "Pushing interface update";
   interfaceUpdatesQueue.push(intfChange_1);
@@ -718,6 +749,175 @@ TEST_F(FibTestFixture, basicAddAndDelete) {
   EXPECT_EQ(mockFibHandler->getDelMplsRoutesCount(), 2);
 }
 
+//
+// Routes of large route delta are programmed in multiple batches, with
+// several of them in flight, and end state matches route delta
+//
+TEST_F(FibTestFixture, routeProgrammingBatches) {
+  const size_t kNumRoutes = 3 * Constants::kFibProgrammingBatchSize + 1;
+  auto getCounter = [](const std::string& key) {
+    return facebook::fb303::fbData->getCounters()[key];
+  };
+
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  const auto numBatches = getCounter("fib.route_batches.sum");
+
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  for (size_t i = 0; i < kNumRoutes; ++i) {
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(createUnicastRoute(
+        toIpPrefix(folly::sformat("fc00:{}::/64", i + 1)), {path1_2_1}));
+  }
+  routeUpdatesQueue.push(routeDbDelta);
+
+  std::vector<thrift::UnicastRoute> routes;
+  while (routes.size() < kNumRoutes) {
+    mockFibHandler->waitForUpdateUnicastRoutes();
+    mockFibHandler->getRouteTableByClient(routes, kFibId);
+  }
+  EXPECT_EQ(kNumRoutes, routes.size());
+  EXPECT_EQ(kNumRoutes, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(numBatches + 4, getCounter("fib.route_batches.sum"));
+
+  // Delete all but one of the routes
+  routeDbDelta.unicastRoutesToUpdate.clear();
+  for (size_t i = 1; i < kNumRoutes; ++i) {
+    routeDbDelta.unicastRoutesToDelete.emplace_back(
+        toIpPrefix(folly::sformat("fc00:{}::/64", i + 1)));
+  }
+  routeUpdatesQueue.push(routeDbDelta);
+  while (routes.size() > 1) {
+    mockFibHandler->waitForDeleteUnicastRoutes();
+    mockFibHandler->getRouteTableByClient(routes, kFibId);
+  }
+  ASSERT_EQ(1, routes.size());
+  EXPECT_EQ(toIpPrefix("fc00:1::/64"), routes.at(0).dest);
+  EXPECT_EQ(kNumRoutes - 1, mockFibHandler->getDelRoutesCount());
+}
+
+//
+// Backlog of route updates beyond burst of the programming rate is paced,
+// and rate keeps growing while agent programs batches in time
+//
+TEST_F(FibTestFixture, routeProgrammingPacing) {
+  const size_t kNumRoutes = 8 * Constants::kFibProgrammingBatchSize;
+  auto getCounter = [](const std::string& key) {
+    return facebook::fb303::fbData->getCounters()[key];
+  };
+
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  const auto numPaced = getCounter("fib.route_batches_paced.sum");
+
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  for (size_t i = 0; i < kNumRoutes; ++i) {
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(createUnicastRoute(
+        toIpPrefix(folly::sformat("fc00:{}::/64", i + 1)), {path1_2_1}));
+  }
+  routeUpdatesQueue.push(routeDbDelta);
+
+  std::vector<thrift::UnicastRoute> routes;
+  while (routes.size() < kNumRoutes) {
+    mockFibHandler->waitForUpdateUnicastRoutes();
+    mockFibHandler->getRouteTableByClient(routes, kFibId);
+  }
+  EXPECT_EQ(kNumRoutes, routes.size());
+  EXPECT_LT(numPaced, getCounter("fib.route_batches_paced.sum"));
+  EXPECT_LT(
+      static_cast<int64_t>(Constants::kFibInitialProgrammingRate),
+      getCounter("fib.programming_rate"));
+  EXPECT_EQ(0, getCounter("fib.route_backlog"));
+}
+
+//
+// Routes which failed to program are resynced along with route deltas
+// received meanwhile, without full sync of routes
+//
+TEST_F(FibTestFixture, resyncUnsyncedRoutes) {
+  auto getCounter = [](const std::string& key) {
+    return facebook::fb303::fbData->getCounters()[key];
+  };
+
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  const auto numFibSyncs = mockFibHandler->getFibSyncCount();
+  const auto numFailures =
+      getCounter("fib.thrift.failure.add_del_route.count");
+
+  // Fail programming of routes
+  mockFibHandler->setUnicastRoutesError(true);
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  routeDbDelta.unicastRoutesToUpdate = {
+      createUnicastRoute(prefix1, {path1_2_1, path1_2_2})};
+  routeUpdatesQueue.push(routeDbDelta);
+  while (getCounter("fib.thrift.failure.add_del_route.count") == numFailures) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // Recover and send another route delta
+  mockFibHandler->setUnicastRoutesError(false);
+  routeDbDelta.unicastRoutesToUpdate = {
+      createUnicastRoute(prefix2, {path1_2_1})};
+  routeUpdatesQueue.push(routeDbDelta);
+
+  std::vector<thrift::UnicastRoute> routes;
+  while (routes.size() < 2) {
+    mockFibHandler->waitForUpdateUnicastRoutes();
+    mockFibHandler->getRouteTableByClient(routes, kFibId);
+  }
+  EXPECT_EQ(2, routes.size());
+  EXPECT_EQ(numFibSyncs, mockFibHandler->getFibSyncCount());
+}
+
+TEST_F(FibTestFixture, nextHopGroups) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+
+  // Mimic decision publishing two routes sharing one nexthop group
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  routeDbDelta.nextHopGroupsToUpdate = {{1, {path1_2_1, path1_2_3}}};
+  for (auto const& prefix : {prefix1, prefix2}) {
+    thrift::UnicastRoute route;
+    route.dest = prefix;
+    route.nextHopGroupId_ref() = 1;
+    routeDbDelta.unicastRoutesToUpdate.emplace_back(std::move(route));
+  }
+  routeUpdatesQueue.push(routeDbDelta);
+  mockFibHandler->waitForUpdateUnicastRoutes();
+
+  // routes are programmed with the nexthops of their group
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  ASSERT_EQ(routes.size(), 2);
+  for (auto const& route : routes) {
+    EXPECT_THAT(
+        route.nextHops, testing::UnorderedElementsAre(path1_2_1, path1_2_3));
+  }
+
+  // withdrawing the group along with one route keeps it for the other one
+  routeDbDelta.nextHopGroupsToUpdate.clear();
+  routeDbDelta.unicastRoutesToUpdate.clear();
+  routeDbDelta.unicastRoutesToDelete = {prefix1};
+  routeDbDelta.nextHopGroupsToDelete = {1};
+  routeUpdatesQueue.push(routeDbDelta);
+  mockFibHandler->waitForDeleteUnicastRoutes();
+
+  auto routeDb = getRouteDb();
+  ASSERT_EQ(routeDb.unicastRoutes.size(), 1);
+  EXPECT_EQ(routeDb.unicastRoutes.at(0).dest, prefix2);
+  EXPECT_THAT(
+      routeDb.unicastRoutes.at(0).nextHops,
+      testing::UnorderedElementsAre(path1_2_1, path1_2_3));
+}
+
 TEST_F(FibTestFixture, fibRestart) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -804,6 +1004,47 @@ TEST_F(FibTestFixtureWaitOnDecision, WaitOnDecision) {
   EXPECT_EQ(mockFibHandler->getDelMplsRoutesCount(), 0);
 }
 
+class FibTestFixtureWarmStart : public FibTestFixture {
+ public:
+  FibTestFixtureWarmStart() : FibTestFixture(false, true) {}
+};
+
+TEST_F(FibTestFixtureWarmStart, AdoptAgentRoutes) {
+  // Mimic routes programmed by previous instance of Open/R
+  mockFibHandler->addUnicastRoutes(
+      kFibId,
+      std::make_unique<std::vector<thrift::UnicastRoute>>(
+          std::vector<thrift::UnicastRoute>{
+              createUnicastRoute(prefix1, {path1_2_1, path1_2_2}),
+              createUnicastRoute(prefix3, {path1_2_1})}));
+  mockFibHandler->waitForUpdateUnicastRoutes();
+
+  // Mimic decision pub sock publishing RouteDatabaseDelta
+  thrift::RouteDatabaseDelta routeDbDelta;
+  routeDbDelta.thisNodeName = "node-1";
+  routeDbDelta.unicastRoutesToUpdate = {
+      createUnicastRoute(prefix1, {path1_2_1, path1_2_2}),
+      createUnicastRoute(prefix2, {path1_2_2})};
+  routeUpdatesQueue.push(routeDbDelta);
+
+  // Only new route is added and stale route is deleted, without full sync
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  mockFibHandler->waitForDeleteUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getFibSyncCount(), 0);
+  // 2 pre-programmed routes + 1 new route
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 3);
+  EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 1);
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  ASSERT_EQ(routes.size(), 2);
+  std::sort(routes.begin(), routes.end(), [](auto const& a, auto const& b) {
+    return a.dest < b.dest;
+  });
+  EXPECT_EQ(routes.at(0).dest, prefix1);
+  EXPECT_EQ(routes.at(1).dest, prefix2);
+}
+
 TEST_F(FibTestFixture, getMslpRoutesFilteredTest) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -955,17 +1196,16 @@ TEST_F(FibTestFixture, getUnicastRoutesFilteredTest) {
 }
 
 TEST_F(FibTestFixture, longestPrefixMatchTest) {
-  std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastRoutes;
+  PrefixTrie<thrift::IpPrefix> unicastRoutes;
   const auto& defaultRoute = toIpPrefix("::/0");
   const auto& dbPrefix1 = toIpPrefix("192.168.0.0/16");
   const auto& dbPrefix2 = toIpPrefix("192.168.0.0/20");
   const auto& dbPrefix3 = toIpPrefix("192.168.0.0/24");
   const auto& dbPrefix4 = toIpPrefix("192.168.20.16/28");
-  unicastRoutes[defaultRoute] = createUnicastRoute(defaultRoute, {});
-  unicastRoutes[dbPrefix1] = createUnicastRoute(dbPrefix1, {});
-  unicastRoutes[dbPrefix2] = createUnicastRoute(dbPrefix2, {});
-  unicastRoutes[dbPrefix3] = createUnicastRoute(dbPrefix3, {});
-  unicastRoutes[dbPrefix4] = createUnicastRoute(dbPrefix4, {});
+  for (const auto& prefix :
+       {defaultRoute, dbPrefix1, dbPrefix2, dbPrefix3, dbPrefix4}) {
+    unicastRoutes.insert(toIPNetwork(prefix), prefix);
+  }
 
   const auto inputdefaultRoute =
       folly::IPAddress::tryCreateNetwork("::/0").value();
@@ -1025,6 +1265,77 @@ TEST_F(FibTestFixture, longestPrefixMatchTest) {
   EXPECT_EQ(result7.value(), dbPrefix3);
 }
 
+TEST(Fib, getRoutePriorityTest) {
+  // Host prefixes are programmed first
+  EXPECT_EQ(
+      Fib::RoutePriority::HIGH,
+      Fib::getRoutePriority(createUnicastRoute(prefix1, {path1_2_1})));
+  EXPECT_EQ(
+      Fib::RoutePriority::HIGH,
+      Fib::getRoutePriority(
+          createUnicastRoute(toIpPrefix("10.1.1.1/32"), {path1_2_1})));
+
+  auto route = createUnicastRoute(toIpPrefix("fc00::/64"), {path1_2_1});
+  EXPECT_EQ(Fib::RoutePriority::DEFAULT, Fib::getRoutePriority(route));
+  route.prefixType_ref() = thrift::PrefixType::LOOPBACK;
+  EXPECT_EQ(Fib::RoutePriority::HIGH, Fib::getRoutePriority(route));
+
+  // Redistributed routes are programmed last
+  route.prefixType_ref() = thrift::PrefixType::BGP;
+  EXPECT_EQ(Fib::RoutePriority::LOW, Fib::getRoutePriority(route));
+  route.prefixType_ref().reset();
+  route.bestNexthop_ref() = path1_2_1;
+  EXPECT_EQ(Fib::RoutePriority::LOW, Fib::getRoutePriority(route));
+
+  EXPECT_EQ("high", Fib::getRoutePriorityName(Fib::RoutePriority::HIGH));
+  EXPECT_EQ("low", Fib::getRoutePriorityName(Fib::RoutePriority::LOW));
+}
+
+TEST(Fib, mergeRouteDatabaseDeltaTest) {
+  thrift::RouteDatabaseDelta into;
+  into.thisNodeName = "node-1";
+  into.unicastRoutesToUpdate = {
+      createUnicastRoute(prefix1, {path1_2_1}),
+      createUnicastRoute(prefix2, {path1_2_1})};
+  into.unicastRoutesToDelete = {prefix3};
+  into.mplsRoutesToUpdate = {createMplsRoute(label1, {mpls_path1_2_1})};
+  into.nextHopGroupsToDelete = {2};
+
+  // prefix1 is updated, prefix2 withdrawn, prefix3 re-announced and label1
+  // withdrawn by the later delta
+  thrift::RouteDatabaseDelta from;
+  from.thisNodeName = "node-1";
+  from.unicastRoutesToUpdate = {
+      createUnicastRoute(prefix1, {path1_2_2}),
+      createUnicastRoute(prefix3, {path1_3_1})};
+  from.unicastRoutesToDelete = {prefix2};
+  from.mplsRoutesToDelete = {label1};
+  from.nextHopGroupsToUpdate = {{1, {path1_2_1}}};
+  EXPECT_TRUE(Fib::mergeRouteDatabaseDelta(into, from));
+
+  EXPECT_THAT(
+      into.unicastRoutesToUpdate,
+      testing::UnorderedElementsAre(
+          createUnicastRoute(prefix1, {path1_2_2}),
+          createUnicastRoute(prefix3, {path1_3_1})));
+  EXPECT_THAT(into.unicastRoutesToDelete, testing::ElementsAre(prefix2));
+  EXPECT_TRUE(into.mplsRoutesToUpdate.empty());
+  EXPECT_THAT(into.mplsRoutesToDelete, testing::ElementsAre(label1));
+  EXPECT_EQ(1, into.nextHopGroupsToUpdate.size());
+  EXPECT_THAT(into.nextHopGroupsToDelete, testing::ElementsAre(2));
+
+  // Group withdrawn earlier can't be re-announced in same delta
+  from = thrift::RouteDatabaseDelta();
+  from.thisNodeName = "node-1";
+  from.nextHopGroupsToUpdate = {{2, {path1_2_1}}};
+  EXPECT_FALSE(Fib::mergeRouteDatabaseDelta(into, from));
+
+  // Deltas of different nodes are never merged
+  from = thrift::RouteDatabaseDelta();
+  from.thisNodeName = "node-2";
+  EXPECT_FALSE(Fib::mergeRouteDatabaseDelta(into, from));
+}
+
 TEST_F(FibTestFixture, doNotInstall) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
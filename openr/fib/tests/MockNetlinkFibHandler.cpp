@@ -70,6 +70,11 @@ MockNetlinkFibHandler::deleteUnicastRoute(
 void
 MockNetlinkFibHandler::addUnicastRoutes(
     int16_t, std::unique_ptr<std::vector<openr::thrift::UnicastRoute>> routes) {
+  if (unicastRoutesError_) {
+    thrift::PlatformError error;
+    error.message = "Injected failure to add routes";
+    throw error;
+  }
   SYNCHRONIZED(unicastRouteDb_) {
     for (auto const& route : *routes) {
       auto prefix = std::make_pair(
@@ -93,6 +98,11 @@ MockNetlinkFibHandler::addUnicastRoutes(
 void
 MockNetlinkFibHandler::deleteUnicastRoutes(
     int16_t, std::unique_ptr<std::vector<openr::thrift::IpPrefix>> prefixes) {
+  if (unicastRoutesError_) {
+    thrift::PlatformError error;
+    error.message = "Injected failure to delete routes";
+    throw error;
+  }
   SYNCHRONIZED(unicastRouteDb_) {
     for (auto const& prefix : *prefixes) {
       auto myPrefix = std::make_pair(
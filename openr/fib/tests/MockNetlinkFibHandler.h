@@ -120,6 +120,12 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
     return delMplsRoutesCount_;
   }
 
+  // Fail add/delete of unicast routes with an exception
+  void
+  setUnicastRoutesError(bool error) {
+    unicastRoutesError_ = error;
+  }
+
   void stop();
 
   void restart();
@@ -144,6 +150,9 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
   std::atomic<size_t> addMplsRoutesCount_{0};
   std::atomic<size_t> delMplsRoutesCount_{0};
 
+  // Fail add/delete of unicast routes if set
+  std::atomic<bool> unicastRoutesError_{false};
+
   // A baton for synchronization
   folly::Baton<> updateUnicastRoutesBaton_;
   folly::Baton<> deleteUnicastRoutesBaton_;
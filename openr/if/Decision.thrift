@@ -22,3 +22,45 @@ typedef map<string, Lsdb.AdjacencyDatabase>
 typedef map<string, Lsdb.PrefixDatabase>
   (cpp.type = "std::unordered_map<std::string, openr::thrift::PrefixDatabase>")
   PrefixDbs
+
+// Link state and prefix databases of all the nodes known to Decision
+struct DecisionDbs {
+  // adjacency databases of all nodes across all areas
+  1: list<Lsdb.AdjacencyDatabase> adjDbs
+  2: PrefixDbs prefixDbs
+}
+
+// Changes to DecisionDbs applied by Decision on processing a KvStore
+// publication of the area. Updated databases are complete databases of the
+// node, not the diff
+struct DecisionDbsDelta {
+  1: string area
+  2: list<Lsdb.AdjacencyDatabase> adjDbsToUpdate
+  3: list<string> adjDbsToDelete
+  4: list<Lsdb.PrefixDatabase> prefixDbsToUpdate
+  5: list<string> prefixDbsToDelete
+}
+
+enum TopologyChangeType {
+  // set overload bit of the node, i.e. drain it
+  OVERLOAD_NODE = 1
+  // withdraw adjacency database of the node
+  REMOVE_NODE = 2
+  // set overload bit of the link, in both directions
+  OVERLOAD_LINK = 3
+  // withdraw the link, in both directions
+  REMOVE_LINK = 4
+  // set metric of the link, in both directions
+  SET_LINK_METRIC = 5
+}
+
+// Hypothetical change of the topology seen by Decision. Link changes select
+// the link by node and its local interface name
+struct TopologyChange {
+  1: TopologyChangeType type
+  2: string nodeName
+  3: optional string ifName
+  4: optional i32 metric
+  // area of the change, all areas the node is in if unset
+  5: optional string area
+}
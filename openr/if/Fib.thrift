@@ -29,6 +29,13 @@ struct RouteDatabaseDelta {
   4: list<Network.MplsRoute> mplsRoutesToUpdate
   5: list<i32> mplsRoutesToDelete
   6: optional Lsdb.PerfEvents perfEvents;
+
+  // Nexthop groups shared by unicast routes, referred to by their
+  // `nextHopGroupId`. Groups are announced before their first use and
+  // withdrawn once no route uses them anymore. The nexthops of a group
+  // never change
+  7: map<i64, list<Network.NextHopThrift>> nextHopGroupsToUpdate
+  8: list<i64> nextHopGroupsToDelete
 }
 
 // Perf log buffer maintained by Fib
@@ -36,3 +43,23 @@ struct PerfDatabase {
   1: string thisNodeName
   2: list<Lsdb.PerfEvents> eventInfo
 }
+
+// Percentiles of latencies in milliseconds, since Fib started. They are
+// within 1/8 of the actual latency
+struct LatencyStats {
+  1: i64 count
+  2: i64 p50
+  3: i64 p90
+  4: i64 p99
+  5: i64 max
+}
+
+// Latencies of convergence triggered by events of a type, i.e. of the first
+// perf event of the convergence
+struct ConvergenceStats {
+  1: string eventType
+  // from the first perf event till routes are programmed by Fib
+  2: LatencyStats endToEnd
+  // from previous perf event, keyed by the perf event ending the stage
+  3: map<string, LatencyStats> stages
+}
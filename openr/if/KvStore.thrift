@@ -37,11 +37,29 @@ struct Value {
   // should leave it empty and as will be computed by KvStore on `KEY_SET`
   // operation.
   6: optional i64 hash;
+  // `value` is zstd compressed. `hash` is always computed over uncompressed
+  // value and must be set along with it. Set only by KvStore, and only sent
+  // to peers supporting compression
+  7: optional bool isCompressed;
 }
 
 typedef map<string, Value>
   (cpp.type = "std::unordered_map<std::string, openr::thrift::Value>") KeyVals
 
+// TTL refresh of a key. Equivalent to `Value` without `value` and `hash`
+struct TtlRefresh {
+  1: string key;
+  2: i64 version;
+  3: i64 ttlVersion;
+  4: i64 ttl;
+}
+
+// TTL refreshes of keys originated by the same node, so that originatorId
+// isn't repeated for every key
+struct TtlRefreshBatch {
+  1: string originatorId;
+  2: list<TtlRefresh> refreshes;
+}
 
 enum Command {
   // operations on keys in the store
@@ -89,6 +107,23 @@ struct KeySetParams {
   // optional attribute to indicate timestamp when request is sent. This is
   // system timestamp in milliseconds since epoch
   7: optional i64 timestamp_ms
+
+  // TTL refreshes in compact form. Applied in addition to TTL updates in
+  // `keyVals`. Only sent to peers supporting it
+  8: optional list<TtlRefreshBatch> ttlRefreshes
+
+  // Fixed-size bloom filter of nodes this publication has traversed (see
+  // KvStoreNodeIdsBloom). Only sent to peers supporting it, along with
+  // `nodeIds` truncated to the last node
+  9: optional binary nodeIdsBloom
+
+  // system timestamp in milliseconds since epoch when key-values were
+  // originated into the flood, carried unchanged across hops. Unlike
+  // `timestamp_ms` which is reset on every hop
+  10: optional i64 originTimestampMs
+
+  // number of KvStore hops the publication has traversed since origination
+  11: optional i32 floodHopCount
 }
 
 struct KeyGetParams {
@@ -104,6 +139,28 @@ struct KeyDumpParams {
   //  2) Otherwise, respond with flooding element to signal DB change;
   2: optional KeyVals keyValHashes
   4: optional FilterOperator oper
+
+  // optional attributes for hash-tree based full-sync (see KvStoreHashTree).
+  //  1) If `hashTreeRootDigest` is set and differs from the local root
+  //     digest, respond with `hashTreeBucketDigests` only. If it matches,
+  //     respond with empty `hashTreeBucketDigests`;
+  //  2) If `hashTreeBuckets` is set, `keyValHashes` only covers keys of these
+  //     buckets and difference is computed only for keys in these buckets;
+  5: optional i64 hashTreeRootDigest
+  6: optional list<i32> hashTreeBuckets
+
+  // requester supports compressed values. Values are decompressed in the
+  // response otherwise
+  7: optional bool supportValueCompression
+
+  // optional attributes for paged dump. If `pageSize` is set, at most
+  // `pageSize` key-values (capped by KvStore) are returned in key order,
+  // starting after `pageToken` (from the first key if not set). Response
+  // carries `nextPageToken` to pass in request of the next page, unless all
+  // matching keys are dumped. Keys added or removed in between pages might be
+  // missed or not. Not supported along with `keyValHashes` or hash-tree sync
+  8: optional i32 pageSize
+  9: optional string pageToken
 }
 
 // Peer's publication and command socket URLs
@@ -121,6 +178,18 @@ struct PeerSpec {
 
   // thrift port
   4: i32 ctrlPort = 0
+
+  // support hash-tree based full-sync or not
+  5: bool supportHashTreeSync = 0
+
+  // support compressed values or not
+  6: bool supportValueCompression = 0
+
+  // support TTL refreshes in compact form (KeySetParams.ttlRefreshes) or not
+  7: bool supportTtlRefreshBatch = 0
+
+  // support bloom filter of traversed nodes (KeySetParams.nodeIdsBloom) or not
+  8: bool supportNodeIdsBloom = 0
 }
 
 typedef map<string, PeerSpec>
@@ -145,6 +214,9 @@ struct PeerUpdateRequest {
   1: string area = kDefaultArea
   2: optional PeerAddParams peerAddParams
   3: optional PeerDelParams peerDelParams
+  // set by LinkMonitor once initial adjacencies are discovered, i.e. peers of
+  // the area added so far are the initial ones to full-sync with
+  4: optional bool initialPeersDiscovered
 }
 
 // set/unset flood-topo child
@@ -240,4 +312,51 @@ struct Publication {
 
   // area to which this publication belogs
   7: optional string area;
+
+  // bucket digests of responder's hash tree. Only set in response to
+  // full-sync request with `hashTreeRootDigest`
+  8: optional list<i64> hashTreeBucketDigests;
+
+  // TTL refreshes in compact form received in KEY_SET request. Never set in
+  // publications sent out by KvStore
+  9: optional list<TtlRefreshBatch> ttlRefreshes;
+
+  // set in publication of key-values restored from warm start snapshot on
+  // startup, before any full-sync with peers
+  10: optional bool warmStart;
+
+  // bloom filter of nodes this publication has traversed, in addition to
+  // `nodeIds` (see KeySetParams.nodeIdsBloom)
+  11: optional binary nodeIdsBloom;
+
+  // set in publication (without key-values) sent once to local subscribers
+  // when all initial peers of the area completed their first full-sync
+  12: optional bool initialSyncDone;
+
+  // origination time and hop count of flooded key-values (see
+  // KeySetParams.originTimestampMs). Carried along the flood
+  13: optional i64 originTimestampMs;
+  14: optional i32 floodHopCount;
+
+  // originators left without any key-value in the area by expiry of
+  // `expiredKeys`, e.g. ones of a node gone down. Their keys are listed in
+  // `expiredKeys` as well, consumers may drop all state of the originator
+  // in one go instead. Only set in publications of expired keys
+  15: optional list<string> expiredOriginators;
+
+  // continuation token of paged dump (see KeyDumpParams.pageSize). Opaque to
+  // the requester, not set on the last page
+  16: optional string nextPageToken;
+}
+
+//
+// Snapshot of KvStore persisted periodically in config-store, and restored
+// on startup for warm start
+//
+struct KvStoreWarmStartDb {
+  // wall clock time of the snapshot, for aging TTLs of restored key-values
+  1: i64 timestampMs;
+
+  // area -> key-values of the area with time-left as TTLs
+  2: map<string, Publication> areaPublications;
 }
@@ -27,6 +27,9 @@ struct PerfEvent {
 
 struct PerfEvents {
   1: list<PerfEvent> events;
+  // Identifies the originating event (adjacency or prefix change) across
+  // the nodes and modules its perf events are collected on
+  2: optional string traceId;
 }
 
 //
@@ -59,6 +62,11 @@ struct InterfaceDatabase {
 
   // Optional attribute to measure convergence performance
   3: optional PerfEvents perfEvents;
+
+  // `interfaces` only carries interfaces changed since the last publication.
+  // Removed interfaces are reported as down. Otherwise it is a full snapshot
+  // and interfaces not in it are no longer there.
+  4: bool isDelta = false;
 }
 
 //
@@ -127,6 +127,10 @@ struct UnicastRoute {
 
   41: optional NextHopThrift bestNexthop
 
+  // Nexthop group of the route, see `RouteDatabaseDelta`. Routes sent by
+  // Decision with a group set carry no `nextHops` of their own
+  42: optional i64 nextHopGroupId
+
   # DEPREDCATED - Use nextHops instead
   # 2: list<BinaryAddress> deprecatedNexthops
 }
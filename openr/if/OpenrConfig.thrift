@@ -30,6 +30,84 @@ struct KvstoreConfig {
   # flood optimization
   8: optional bool enable_flood_optimization
   9: optional bool is_flood_root
+
+  # full-sync exchanging hash tree digests instead of every key hash
+  10: optional bool enable_hash_tree_sync
+
+  # compress adjacency and prefix databases in memory and on the wire
+  11: optional bool enable_value_compression
+
+  # key markers of flooding priority classes, highest priority first. Keys
+  # matching none of them have the lowest priority. Only used along with
+  # flood_rate. Default is ["adj:", "prefix:"]
+  12: optional list<string> flood_priority_key_markers
+
+  # rate of publications streamed to every KvStore subscriber (e.g. breeze
+  # snoop). Updates over the rate are buffered and coalesced by key, keeping
+  # only the latest value. Subscriber with more than
+  # subscriber_max_buffered_keys keys buffered is disconnected. Unlimited rate
+  # if not set
+  13: optional KvstoreFloodRate subscriber_rate
+  14: i32 subscriber_max_buffered_keys = 100000
+
+  # serve key gets and filtered dumps (other than full-sync requests of
+  # peers) from copy-on-write snapshot of KvStore on the calling thread,
+  # instead of on KvStore event base. Costs a copy of every key-value
+  15: optional bool enable_snapshot_reads
+
+  # persist key-values in config-store every warm_start_snapshot_interval_s
+  # and restore them on startup, with TTLs aged by the time since snapshot,
+  # so that routes can be computed before full-sync with peers completes.
+  # Disabled if not set
+  16: optional i32 warm_start_snapshot_interval_s
+
+  # with flood optimization, split keys originated by this node across SPTs
+  # of all ready flood roots (by hash of key), instead of flooding all of
+  # them over SPT of smallest root-id. Spreads flooding load across roots
+  17: optional bool enable_multi_root_flooding
+
+  # run KvStoreDb of every area on its own thread (KvStore.<area>), so that
+  # full-sync or flooding storm in one area doesn't delay TTL processing and
+  # flooding in the others. All areas share the KvStore thread if not set
+  18: optional bool enable_area_threads
+
+  # number of worker threads (KvStoreMerge) deciding merge of large
+  # publications, e.g. full-sync responses, in parallel. Publications are
+  # merged on thread of the area only if not set or 0
+  19: optional i32 merge_threads
+
+  # max number of peers full-synced over thrift concurrently. Defaults to 32
+  20: optional i32 max_parallel_full_syncs
+
+  # limits of keys and of bytes (of keys and values) accepted into KvStore of
+  # each area, per originator and in total, so that a misbehaving node can't
+  # exhaust memory of every KvStore. Value updates growing over a limit are
+  # rejected and counted as kvstore.rejected_key_vals. Unlimited if not set
+  # or 0
+  21: optional i32 max_keys_per_originator
+  22: optional i64 max_bytes_per_originator
+  23: optional i32 max_keys_per_area
+  24: optional i64 max_bytes_per_area
+
+  # latency budget (ms) of flooding to thrift peers. Floods queued for a peer
+  # within it are coalesced into a single setKvStoreKeyVals request, which
+  # amortizes per-request cost during flooding storms. Floods still queued
+  # behind requests in flight are coalesced even if not set or 0
+  25: optional i32 flood_batch_ms
+}
+
+# Exponential-decay dampening of adjacency changes, similar to BGP route flap
+# damping. Every RTT metric change and adjacency flap adds a penalty to the
+# adjacency, which halves every half_life_s. Changes of the adjacency are held
+# back while its penalty is above suppress_threshold, until it decays below
+# reuse_threshold (or at most for max_suppress_time_s)
+struct AdjacencyDampeningConfig {
+  1: i32 half_life_s = 60
+  2: i32 rtt_change_penalty = 500
+  3: i32 flap_penalty = 1000
+  4: i32 suppress_threshold = 2000
+  5: i32 reuse_threshold = 750
+  6: i32 max_suppress_time_s = 300
 }
 
 struct LinkMonitorConfig {
@@ -39,6 +117,29 @@ struct LinkMonitorConfig {
   4: list<string> include_interface_regexes = []
   5: list<string> exclude_interface_regexes = []
   6: list<string> redistribute_interface_regexes = []
+
+  # Advertise every adjacency with its own key, `adj:<node>:[<nbr>:<if>]`,
+  # instead of whole adjacency database with `adj:<node>` key, which then
+  # carries only node attributes. Single adjacency change floods one small key.
+  # Disabled by default
+  7: bool enable_per_adjacency_keys = false
+
+  # Dampen RTT metric changes and flaps of adjacencies.
+  # Disabled by default
+  8: bool enable_adj_dampening = false
+  9: AdjacencyDampeningConfig adj_dampening_config
+}
+
+# Fast liveness detection of established neighbors. Compact heartbeats are
+# sent and checked on a dedicated SparkLiveness thread, independent of how
+# busy Spark event loop is. Its priority can be raised with
+# thread_scheduling_config of SparkLiveness. Used towards neighbors which have
+# it enabled as well, others are left to regular heartbeats
+struct SparkFastLivenessConfig {
+  1: i32 port = 6667
+  2: i32 interval_ms = 20
+  # neighbor is declared down after missing heartbeats for this many intervals
+  3: i32 detect_multiplier = 3
 }
 
 struct SparkConfig {
@@ -50,12 +151,28 @@ struct SparkConfig {
   4: i32 keepalive_time_s = 2
   5: i32 hold_time_s = 10
   6: i32 graceful_restart_time_s = 30
+
+  7: optional SparkFastLivenessConfig fast_liveness_config
+}
+
+# Scheduling of a module thread, applied once it starts. Threads it spawns
+# later inherit it
+struct ThreadSchedulingConfig {
+  # CPUs the thread may run on. Any CPU if empty
+  1: list<i32> cpus
+  # Nice value of the thread, from -20 (highest priority) to 19
+  2: optional i32 nice
+  # Run the thread with real-time SCHED_FIFO policy with this priority, from 1
+  # to 99. Exclusive with nice
+  3: optional i32 realtime_priority
 }
 
 struct WatchdogConfig {
   1: i32 interval_s = 20
   2: i32 thread_timeout_s = 300
   3: i32 max_memory_mb = 800
+  # Event-loop lag of a module above which its stack is logged, if set
+  4: optional i32 stall_threshold_ms
 }
 
 enum PrefixForwardingType {
@@ -92,6 +209,12 @@ struct PrefixAllocationConfig {
   4: PrefixAllocationMode prefix_allocation_mode
   5: optional string seed_prefix
   6: optional i32 allocate_prefix_len
+
+  // Lease mode. DYNAMIC_ROOT_NODE hands out sub-prefixes of seed prefix to
+  // all nodes in the area in a single batch, and DYNAMIC_LEAF_NODE uses the
+  // one leased to it instead of claiming one on its own via KvStore.
+  // Avoids allocation storms when many nodes boot simultaneously.
+  7: optional bool enable_prefix_lease
 }
 
 /**
@@ -122,6 +245,11 @@ struct AreaConfig {
   1: string area_id
   2: list<string> interface_regexes
   3: list<string> neighbor_regexes
+  # summary prefixes advertised into this area in place of the more specific
+  # prefixes of this node they cover, while any of them is advertised. Keeps
+  # key count and route table size of the area independent of the number of
+  # prefixes behind an area border node.
+  4: list<string> summary_prefixes = []
 }
 
 struct OpenrConfig {
@@ -141,7 +269,9 @@ struct OpenrConfig {
   # TODO: will be deprecated soon T66361115
   9: optional bool enable_netlink_system_handler
 
-  /* Hard wait time before decision start to compute routes
+  /* Max wait time before decision start to compute routes. Decision starts
+   * earlier, as soon as KvStore of every area completed initial sync with
+   * peers discovered by LinkMonitor.
    * if not set, first neighbor update will trigger route computation
    */
   10: optional i32 eor_time_s
@@ -171,6 +301,61 @@ struct OpenrConfig {
   # Disabled by default
   24: bool enable_rib_policy = 0
 
+  # Repair memoized SPF results incrementally when a single link changes its
+  # metric or overload bit, instead of recomputing SPF from scratch.
+  # Disabled by default
+  25: optional bool enable_incremental_spf
+
+  # Number of worker threads Decision uses to build routes of different areas
+  # in parallel. Routes are computed on the Decision thread if unset or 0
+  26: optional i32 decision_route_build_threads
+
+  # Publish unicast routes from Decision with references to shared nexthop
+  # groups instead of their own nexthops. Fib resolves the groups before
+  # programming. Other consumers of route updates must support groups.
+  # Disabled by default
+  27: optional bool enable_nexthop_groups
+
+  # On startup, read routes programmed by previous incarnation of Open/R from
+  # FibService and adopt the ones matching routes from Decision, instead of
+  # syncing the whole route table. Only the difference is programmed.
+  # Disabled by default
+  28: optional bool enable_fib_warm_start
+
+  # Memory budget in MB of SPF results and KSP2 paths Decision memoizes per
+  # area. Least recently used ones are evicted before every route build once
+  # exceeded. Unbounded if unset or 0
+  29: optional i32 decision_spf_cache_mb
+
+  # Add perf events of route computation phases (e.g. DECISION_ROUTE_BUILT)
+  # to route updates published by Decision. Durations of all phases are
+  # exported as decision.phase.<phase>_ms histograms regardless
+  30: optional bool enable_decision_phase_perf_events
+
+  # Scheduling of module threads, keyed by thread name (e.g. Spark, Decision,
+  # KvStore, Fib, LinkMonitor, PrefixManager, NetlinkEvb, thriftCtrlServer,
+  # and DecisionRouteBuild for route build worker threads). Threads without
+  # entry keep default scheduling
+  31: optional map<string, ThreadSchedulingConfig> thread_scheduling_config
+
+  # Max number of prefixes Decision accepts from a single originator. Excess
+  # prefixes of the originator (highest ones) are ignored and counted as
+  # decision.rejected_prefixes. Unlimited if not set or 0
+  32: optional i32 decision_max_prefixes_per_originator
+
+  # Compute routes on a worker thread (DecisionRouteCompute) against the
+  # link and prefix state of the last processed updates. Decision thread
+  # keeps queueing new updates, for the next computation, and answers
+  # queries from that state meanwhile. Disabled by default
+  33: optional bool enable_async_route_build
+
+  # Compute unequal-cost (UCMP) nexthops. Shortest path nexthops of a route
+  # are weighted in proportion to `weight` of their adjacencies (e.g. set
+  # after link bandwidth), reduced so that weights of a route sum up to at
+  # most 128. Nexthops of equal weight are kept as ECMP (weight 0).
+  # Disabled by default
+  34: optional bool enable_ucmp
+
   # bgp
   100: optional bool enable_bgp_peering
   102: optional BgpConfig.BgpConfig bgp_config
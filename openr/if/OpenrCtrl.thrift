@@ -29,6 +29,9 @@ exception OpenrError {
 
 struct StaticRoutes {
   1: map<i32,list<Network.NextHopThrift>> mplsRoutes;
+  // static unicast routes, taking precedence over computed routes of the
+  // same prefix
+  2: list<Network.UnicastRoute> unicastRoutes;
 }
 
 //
@@ -152,6 +155,40 @@ service OpenrCtrl extends fb303_core.BaseService {
   string dryrunConfig(1: string file)
     throws (1: OpenrError error)
 
+  /**
+   * Load file config, validate it and apply it without restart. Only area
+   * regexes, eor_time_s, Spark timers and KvStore flood rate can be changed
+   * at runtime, config differing in any other field is rejected. Throws
+   * exception upon error.
+   * Return - loaded config content, which is the running config afterwards.
+   */
+  string reloadConfig(1: string file)
+    throws (1: OpenrError error)
+
+  //
+  // Profiling APIs
+  //
+
+  /**
+   * Start sampling CPU profile of Open/R process at given frequency. Profile
+   * stops by itself after given duration, bounded by 60s. Only one profile
+   * can be taken at a time.
+   */
+  void startCpuProfile(1: i32 durationMs, 2: i32 frequencyHz)
+    throws (1: OpenrError error)
+
+  /**
+   * Stop CPU profile, if still running, and return sampled stacks in folded
+   * format ("root;...;leaf <count>" per line), e.g. for flame graphs
+   */
+  binary stopCpuProfile() throws (1: OpenrError error)
+
+  /**
+   * Snapshot of heap profile in jeprof format. Requires jemalloc heap
+   * profiling to be enabled (MALLOC_CONF=prof:true)
+   */
+  binary getHeapProfile() throws (1: OpenrError error)
+
   //
   // PrefixManager APIs
   //
@@ -214,6 +251,20 @@ service OpenrCtrl extends fb303_core.BaseService {
   Fib.RouteDatabase getRouteDbComputed(1: string nodeName)
     throws (1: OpenrError error)
 
+  /**
+   * What-if simulation: change of the routes of `nodeName` if the given
+   * topology changes were applied, e.g. before draining a node or a link.
+   * Routes are computed on a private copy of the topology, which leaves
+   * routes computed and programmed by Decision untouched. Changes are
+   * applied in order. Throws if a change refers to an unknown node or link.
+   *
+   * NOTE: Current node's routes are simulated if `nodeName` is empty.
+   * Static routes and RibPolicy are not part of the delta.
+   */
+  Fib.RouteDatabaseDelta getRouteDbDeltaWhatIf(
+    1: string nodeName,
+    2: list<Decision.TopologyChange> changes) throws (1: OpenrError error)
+
   /**
    * Get unicast routes after applying a list of prefix filter.
    * Perform longest prefix match for each input filter among the prefixes
@@ -255,6 +306,20 @@ service OpenrCtrl extends fb303_core.BaseService {
   Fib.PerfDatabase getPerfDb()
     throws (1: OpenrError error)
 
+  /**
+   * Get performance events of the convergence with given trace ID, with
+   * per-hop timestamps from its originating node up to local Fib.
+   */
+  Fib.PerfDatabase getConvergenceTrace(1: string traceId)
+    throws (1: OpenrError error)
+
+  /**
+   * Get percentiles of convergence latencies, end-to-end and of every stage,
+   * by type of the triggering event.
+   */
+  list<Fib.ConvergenceStats> getConvergenceStats()
+    throws (1: OpenrError error)
+
   //
   // Decision APIs
   //
@@ -310,7 +375,8 @@ service OpenrCtrl extends fb303_core.BaseService {
   ) throws (1: OpenrError error)
 
   /**
-   * Get raw key-values from KvStore with more control over filter
+   * Get raw key-values from KvStore with more control over filter. Large
+   * dumps can be fetched in pages, see KeyDumpParams.pageSize
    */
   KvStore.Publication getKvStoreKeyValsFiltered(1: KvStore.KeyDumpParams filter)
     throws (1: OpenrError error)
@@ -324,6 +390,15 @@ service OpenrCtrl extends fb303_core.BaseService {
     2: string area = KvStore.kDefaultArea
   ) throws (1: OpenrError error)
 
+  /**
+   * Get raw key-values of multiple areas (all areas if `areas` is empty) in
+   * one call, keyed by area
+   */
+  map<string, KvStore.Publication> getKvStoreKeyValsFilteredAreas(
+    1: KvStore.KeyDumpParams filter,
+    2: set<string> areas
+  ) throws (1: OpenrError error)
+
   /**
    * Get kvstore metadata (no values) with filter
    */
@@ -353,6 +428,15 @@ service OpenrCtrl extends fb303_core.BaseService {
   bool longPollKvStoreAdj(1: KvStore.KeyVals snapshot)
     throws (1: OpenrError error)
 
+  /**
+   * Long poll API to wait for adjacency changes of KvStore, cheaper than
+   * comparing snapshot. Returns sequence number of adjacency changes once it
+   * differs from the given one (right away if it already does), or the same
+   * sequence number on timeout. Pass -1 to learn the current one
+   */
+  i64 longPollKvStoreAdjChange(1: i64 seqNum)
+    throws (1: OpenrError error)
+
   /**
    * Send Dual message
    */
@@ -385,6 +469,14 @@ service OpenrCtrl extends fb303_core.BaseService {
     1: string area
   ) throws (1: OpenrError error)
 
+  /**
+   * Get KvStore peers of multiple areas (all areas if `areas` is empty) in
+   * one call, keyed by area
+   */
+  map<string, KvStore.PeersMap> getKvStorePeersAreas(
+    1: set<string> areas
+  ) throws (1: OpenrError error)
+
   //
   // LinkMonitor APIs
   //
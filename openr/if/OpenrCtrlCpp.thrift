@@ -8,8 +8,12 @@
 namespace cpp2 openr.thrift
 namespace py3 openr.thrift
 
+include "openr/if/Decision.thrift"
+include "openr/if/Fib.thrift"
 include "openr/if/KvStore.thrift"
+include "openr/if/Network.thrift"
 include "openr/if/OpenrCtrl.thrift"
+include "openr/if/PrefixManager.thrift"
 
 /**
  * Extends OpenrCtrl and implements stream APIs as streams are only
@@ -27,4 +31,39 @@ service OpenrCtrlCpp extends OpenrCtrl.OpenrCtrl {
 
   KvStore.Publication, stream<KvStore.Publication>
     subscribeAndGetKvStoreFiltered(1: KvStore.KvFilter filter)
+
+  /**
+   * Retrieve Fib snapshot and as well subscribe subsequent route updates
+   * processed by Fib. This allows external consumers to mirror the routes of
+   * the node without polling `getRouteDb`. No update between snapshot and
+   * stream is lost.
+   *
+   * There may be some replicated routes in stream that are also in snapshot.
+   */
+  Fib.RouteDatabase, stream<Fib.RouteDatabaseDelta> subscribeAndGetFib()
+
+  /**
+   * Retrieve adjacency and prefix databases of all nodes known to Decision
+   * and as well subscribe subsequent changes applied by Decision. This is
+   * useful for topology tooling instead of polling Decision databases. No
+   * update between snapshot and stream is lost.
+   *
+   * There may be some replicated databases in stream that are also in
+   * snapshot.
+   */
+  Decision.DecisionDbs, stream<Decision.DecisionDbsDelta>
+    subscribeAndGetDecisionDbs()
+
+  /**
+   * Push high rate prefix updates of the type into PrefixManager, e.g. from a
+   * BGP speaker, instead of a thrift call per change or full syncs of the
+   * type. Response carries seqNum of the last batch already applied for the
+   * type, for agent to resume from after reconnecting. Batches are applied
+   * incrementally as they arrive, with flow control of the sink bounding
+   * batches in flight. Final response acknowledges the last batch applied
+   * once agent completes the sink.
+   */
+  PrefixManager.PrefixUpdateAck,
+    sink<PrefixManager.PrefixUpdateBatch, PrefixManager.PrefixUpdateAck>
+    streamPrefixUpdates(1: Network.PrefixType type)
 }
@@ -88,6 +88,38 @@ enum SwitchRunState {
 struct PlatformEvent {
   1: PlatformEventType eventType;
   2: binary eventData;
+  // sequence number of the event, incremented per event type by publisher.
+  // Lets subscriber detect dropped events
+  3: optional i64 seqNum;
+  // events of the type coalesced by publisher within a short window, latest
+  // state of an interface (or address) wins. Set instead of `eventData`, and
+  // whole batch carries a single sequence number
+  4: optional list<binary> eventDataBatch;
+}
+
+/**
+ * Unicast routes in compact form for efficient transfer of large number of
+ * routes. Nexthops are sent once in a table and routes refer to them with
+ * their index in the table. Only destination and nexthops of the routes are
+ * carried.
+ */
+struct CompactUnicastRoute {
+  1: Network.IpPrefix dest
+  2: list<i32> nextHopIndices
+}
+
+struct CompactUnicastRoutes {
+  1: list<Network.NextHopThrift> nextHops
+  2: list<CompactUnicastRoute> routes
+}
+
+/**
+ * Optional features of FibService. Clients must check for support of the
+ * feature with `getSupportedFeatures` before using corresponding APIs.
+ */
+enum FibFeature {
+  // addUnicastRoutesCompact and syncFibCompact APIs
+  COMPACT_UNICAST_ROUTES = 1,
 }
 
 exception PlatformError {
@@ -162,6 +194,11 @@ service FibService extends fb303_core.BaseService {
   */
   SwitchRunState getSwitchRunState()
 
+  /*
+  * get optional features supported by the service
+  */
+  list<FibFeature> getSupportedFeatures()
+
   //
   // Unicast Routes API
   //
@@ -190,6 +227,22 @@ service FibService extends fb303_core.BaseService {
     2: list<Network.UnicastRoute> routes,
   ) throws (1: PlatformError error)
 
+  // Same as addUnicastRoutes with routes in compact form
+  void addUnicastRoutesCompact(
+    1: i16 clientId,
+    2: CompactUnicastRoutes routes,
+  ) throws (1: PlatformError error)
+
+  // Same as syncFib with routes in compact form, streamed in one or more
+  // chunks. Chunks of a sync carry same `syncId` and routes are synced on
+  // receiving the last chunk. Chunk of a new sync abandons previous one.
+  void syncFibCompact(
+    1: i16 clientId,
+    2: CompactUnicastRoutes routes,
+    3: i64 syncId,
+    4: bool isLastChunk,
+  ) throws (1: PlatformError error)
+
   // Retrieve list of unicast routes per client
   list<Network.UnicastRoute> getRouteTableByClient(
     1: i16 clientId
@@ -25,3 +25,22 @@ struct PrefixUpdateRequest {
   2: optional Network.PrefixType type
   3: list<Lsdb.PrefixEntry> prefixes
 }
+
+# Batch of prefix updates of a single type, pushed by an external agent (e.g.
+# BGP speaker) over `streamPrefixUpdates` sink. Batches of a type are applied
+# in order of seqNum, which must increase across batches. Batches with seqNum
+# not above the last applied one are ignored, so that agent can replay
+# unacknowledged batches after reconnecting.
+struct PrefixUpdateBatch {
+  1: i64 seqNum
+  # prefixes to add or update. Type of entries is set to type of the stream
+  2: list<Lsdb.PrefixEntry> addPrefixes
+  # prefixes to withdraw, unknown ones are ignored
+  3: list<Network.IpPrefix> withdrawPrefixes
+}
+
+# Acknowledgement of prefix update batches of the type
+struct PrefixUpdateAck {
+  # seqNum of the last batch applied, 0 if none
+  1: i64 seqNum
+}
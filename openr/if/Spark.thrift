@@ -104,6 +104,21 @@ struct SparkHandshakeMsg {
   // TODO: Remove optional qualifier after AREA negotiation
   //       is fully in use
   11: optional string neighborNodeName
+
+  // support hash-tree based KvStore full-sync or not
+  12: optional bool supportHashTreeSync
+
+  // support compressed KvStore values or not
+  13: optional bool supportValueCompression
+
+  // support compact KvStore TTL refreshes or not
+  14: optional bool supportTtlRefreshBatch
+
+  // support bloom filter of nodes traversed by KvStore publications or not
+  15: optional bool supportNodeIdsBloom
+
+  // interval of fast liveness heartbeats we send, if enabled
+  16: optional i32 fastLivenessIntervalMs
 }
 
 //
@@ -164,6 +179,14 @@ struct SparkNeighborEvent {
   6: bool supportFloodOptimization = 0
   // area ID
   7: string area = KvStore.kDefaultArea
+  // both ends support hash-tree based KvStore full-sync or not
+  8: bool supportHashTreeSync = 0
+  // both ends support compressed KvStore values or not
+  9: bool supportValueCompression = 0
+  // neighbor supports compact KvStore TTL refreshes or not
+  10: bool supportTtlRefreshBatch = 0
+  // neighbor supports bloom filter of nodes traversed by KvStore publications
+  11: bool supportNodeIdsBloom = 0
 }
 
 //
@@ -8,14 +8,20 @@
 #include "KvStore.h"
 
 #include <fb303/ServiceData.h>
-#include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
 #include <folly/GLog.h>
 #include <folly/Random.h>
 #include <folly/String.h>
+#include <folly/executors/thread_factory/InitThreadFactory.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
+#include <folly/system/ThreadName.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryAccounting.h>
+#include <openr/common/StartupTimeline.h>
 #include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 
@@ -24,6 +30,28 @@ using namespace std::chrono;
 namespace fb303 = facebook::fb303;
 
 namespace {
+// config-store key of warm start snapshot
+const std::string kWarmStartConfigKey{"kvstore-warm-start"};
+
+// classes of keys flood latency is tracked for
+const std::array<std::string, 3> kFloodKeyClasses{"adj", "prefix", "other"};
+
+// buckets of flood latency and hop count histograms
+const int64_t kFloodLatencyBucketWidthMs{10};
+const int64_t kFloodLatencyMaxMs{5000};
+const int64_t kFloodHopsMax{32};
+
+size_t
+getFloodKeyClass(std::string const& key) {
+  if (key.rfind(openr::Constants::kAdjDbMarker.toString(), 0) == 0) {
+    return 0;
+  }
+  if (key.rfind(openr::Constants::kPrefixDbMarker.toString(), 0) == 0) {
+    return 1;
+  }
+  return 2;
+}
+
 std::optional<openr::KvStoreFilters>
 getKvStoreFilters(std::shared_ptr<const openr::Config> config) {
   std::optional<openr::KvStoreFilters> kvFilters{std::nullopt};
@@ -49,6 +77,91 @@ getKvStoreFilters(std::shared_ptr<const openr::Config> config) {
   }
   return kvFilters;
 }
+
+std::optional<openr::KvStoreLimits>
+getKvStoreLimits(std::shared_ptr<const openr::Config> config) {
+  auto const& kvConfig = config->getKvStoreConfig();
+  openr::KvStoreLimits limits;
+  // validated to be non-negative by Config
+  limits.maxKeysPerOriginator =
+      kvConfig.max_keys_per_originator_ref().value_or(0);
+  limits.maxBytesPerOriginator =
+      kvConfig.max_bytes_per_originator_ref().value_or(0);
+  limits.maxKeys = kvConfig.max_keys_per_area_ref().value_or(0);
+  limits.maxBytes = kvConfig.max_bytes_per_area_ref().value_or(0);
+  if (not limits.maxKeysPerOriginator and not limits.maxBytesPerOriginator and
+      not limits.maxKeys and not limits.maxBytes) {
+    return std::nullopt;
+  }
+  return limits;
+}
+
+// Add key-value of snapshot to the publication with its time-left as ttl,
+// same as KvStoreDb::updatePublicationTtl does. Value about to expire is
+// skipped
+void
+addSnapshotEntry(
+    openr::thrift::Publication& thriftPub,
+    const std::string& key,
+    const openr::KvStoreSnapshot::Entry& entry,
+    std::chrono::steady_clock::time_point timeNow,
+    std::chrono::milliseconds ttlDecr) {
+  if (not entry.expiryTime.has_value()) {
+    thriftPub.keyVals.emplace(key, entry.value);
+    return;
+  }
+  auto timeLeft = duration_cast<milliseconds>(*entry.expiryTime - timeNow);
+  if (timeLeft <= ttlDecr) {
+    return;
+  }
+  auto& value = thriftPub.keyVals.emplace(key, entry.value).first->second;
+  value.ttl = timeLeft.count() - ttlDecr.count();
+}
+
+// Page size of paged dump request, capped to limit the response size.
+// std::nullopt if request isn't a paged one
+std::optional<size_t>
+getDumpPageSize(const openr::thrift::KeyDumpParams& keyDumpParams) {
+  if (not keyDumpParams.pageSize_ref().has_value()) {
+    return std::nullopt;
+  }
+  return std::min<size_t>(
+      std::max<int32_t>(*keyDumpParams.pageSize_ref(), 1),
+      openr::Constants::kKvStoreMaxDumpPageSize);
+}
+
+// Add key-value to the publication without its value, i.e. only version,
+// originatorId, hash and ttl of it
+void
+addHashEntry(
+    openr::thrift::Publication& thriftPub,
+    const std::string& key,
+    const openr::thrift::Value& val) {
+  DCHECK(val.hash_ref().has_value());
+  auto& value = thriftPub.keyVals[key];
+  value.version = val.version;
+  value.originatorId = val.originatorId;
+  value.hash_ref().copy_from(val.hash_ref());
+  value.ttl = val.ttl;
+  value.ttlVersion = val.ttlVersion;
+}
+
+// Fingerprint of a flooded key-value, same for all of its copies flooded over
+// different paths (ttl is decremented on every hop, hence not included).
+// Value is identified by its hash, value without one is never fingerprinted
+std::optional<uint64_t>
+getFloodFingerprint(const std::string& key, const openr::thrift::Value& value) {
+  if (value.value_ref().has_value() and not value.hash_ref().has_value()) {
+    return std::nullopt;
+  }
+  return folly::hash::hash_combine(
+      key,
+      value.version,
+      value.originatorId,
+      value.ttlVersion,
+      value.value_ref().has_value(),
+      value.hash_ref().value_or(0));
+}
 } // namespace
 
 namespace openr {
@@ -96,6 +209,11 @@ KvStoreFilters::keyMatchAll(
   return true;
 }
 
+bool
+KvStoreFilters::keyPrefixMatch(std::string const& key) const {
+  return keyPrefixList_.empty() or keyPrefixObjList_.keyMatch(key);
+}
+
 std::vector<std::string>
 KvStoreFilters::getKeyPrefixes() const {
   return keyPrefixList_;
@@ -123,14 +241,17 @@ KvStoreFilters::str() const {
 KvStore::KvStore(
     // initializers for immutable state
     fbzmq::Context& zmqContext,
-    messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+    messaging::ReplicateQueue<KvStorePublication>& kvStoreUpdatesQueue,
     messaging::RQueue<thrift::PeerUpdateRequest> peerUpdateQueue,
     KvStoreGlobalCmdUrl globalCmdUrl,
     MonitorSubmitUrl monitorSubmitUrl,
     std::shared_ptr<const Config> config,
     std::optional<int> maybeIpTos,
     int zmqHwm,
-    bool enableKvStoreThrift)
+    bool enableKvStoreThrift,
+    PersistentStore* configStore,
+    std::optional<messaging::RQueue<std::shared_ptr<const Config>>>
+        configUpdatesQueue)
     : kvParams_(
           config->getNodeName(),
           kvStoreUpdatesQueue,
@@ -154,14 +275,51 @@ KvStore::KvStore(
       areas_(config->getAreaIds()) {
   zmqMonitorClient_ =
       std::make_shared<fbzmq::ZmqMonitorClient>(zmqContext, monitorSubmitUrl);
-  kvParams_.zmqMonitorClient = zmqMonitorClient_;
+  kvParams_.eventLogger = std::make_shared<EventLogger>(
+      "kvstore",
+      [monitorClient = zmqMonitorClient_](fbzmq::thrift::EventLog&& log) {
+        monitorClient->addEventLog(std::move(log));
+      });
+  kvParams_.enableValueCompression =
+      config->isKvStoreValueCompressionEnabled();
+  kvParams_.enableSnapshotReads = config->isKvStoreSnapshotReadsEnabled();
+  kvParams_.enableMultiRootFlooding =
+      config->isKvStoreMultiRootFloodingEnabled();
+  if (auto markers =
+          config->getKvStoreConfig().flood_priority_key_markers_ref()) {
+    kvParams_.floodPriorityKeyMarkers = *markers;
+  }
+  if (const auto mergeThreads = config->getKvStoreMergeThreads();
+      mergeThreads > 0) {
+    const std::string name{"KvStoreMerge"};
+    std::shared_ptr<folly::ThreadFactory> threadFactory =
+        std::make_shared<folly::NamedThreadFactory>(name);
+    if (auto scheduling = config->getThreadSchedulingConfig(name)) {
+      threadFactory = std::make_shared<folly::InitThreadFactory>(
+          std::move(threadFactory), [name, scheduling]() {
+            applyThreadScheduling(name, *scheduling);
+          });
+    }
+    kvParams_.mergeExecutor = std::make_shared<folly::CPUThreadPoolExecutor>(
+        mergeThreads, std::move(threadFactory));
+  }
+  kvParams_.maxParallelFullSyncs =
+      std::max<size_t>(1, config->getKvStoreMaxParallelFullSyncs());
+  kvParams_.limits = getKvStoreLimits(config);
+  kvParams_.floodBatchInterval = config->getKvStoreFloodBatchInterval();
 
   // Schedule periodic timer for counters submission
   counterUpdateTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
-    for (auto& counter : getGlobalCounters()) {
-      fb303::fbData->setCounter(counter.first, counter.second);
-    }
-    counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
+    getCounters().via(getEvb()).thenTry(
+        [this](folly::Try<std::map<std::string, int64_t>>&& counters) {
+          if (counters.hasValue()) {
+            for (auto& counter : counters.value()) {
+              fb303::fbData->setCounter(counter.first, counter.second);
+            }
+          }
+          counterUpdateTimer_->scheduleTimeout(
+              Constants::kCounterSubmitInterval);
+        });
   });
   counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
 
@@ -194,6 +352,20 @@ KvStore::KvStore(
   // Add reader to process peer updates from LinkMonitor
   addFiberTask([q = std::move(peerUpdateQueue), this]() mutable noexcept {
     LOG(INFO) << "Starting peer updates processing fiber";
+    auto processBatch = [this](thrift::PeerUpdateRequest&& req) {
+      fb303::fbData->addStatValue(
+          "kvstore.peer_add_batch_size",
+          req.peerAddParams_ref().has_value()
+              ? req.peerAddParams_ref()->peers.size()
+              : 0,
+          fb303::AVG);
+      try {
+        processPeerUpdates(std::move(req));
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "Failed to process peer request. Exception: "
+                   << ex.what();
+      }
+    };
     while (true) {
       auto maybePeerUpdate = q.get(); // perform read
       VLOG(2) << "Received peer update...";
@@ -201,22 +373,52 @@ KvStore::KvStore(
         LOG(INFO) << "Terminating peer updates processing fiber";
         break;
       }
-      try {
-        processPeerUpdates(std::move(maybePeerUpdate).value());
-      } catch (const std::exception& ex) {
-        LOG(ERROR) << "Failed to process peer request. Exception: "
-                   << ex.what();
+      // Coalesce peer additions already queued (e.g. all ports of a linecard
+      // coming up) so that they are added, and their syncs scheduled, at once
+      auto batch = std::move(maybePeerUpdate).value();
+      while (q.size() > 0) {
+        auto maybeNext = q.get();
+        if (maybeNext.hasError()) {
+          break;
+        }
+        auto next = std::move(maybeNext).value();
+        if (not mergePeerAdditions(batch, next)) {
+          processBatch(std::move(batch));
+          batch = std::move(next);
+        }
       }
+      processBatch(std::move(batch));
     }
   });
 
-  // create KvStoreDb instances
+  // Add reader to apply reloaded config
+  if (configUpdatesQueue.has_value()) {
+    addFiberTask(
+        [q = std::move(*configUpdatesQueue), this]() mutable noexcept {
+          while (true) {
+            auto maybeConfig = q.get(); // perform read
+            if (maybeConfig.hasError()) {
+              LOG(INFO) << "Terminating config updates processing fiber";
+              break;
+            }
+            processConfigUpdate(maybeConfig.value());
+          }
+        });
+  }
+
+  // create KvStoreDb instances, on their own event bases if enabled
+  const bool enableAreaThreads = config->isKvStoreAreaThreadsEnabled();
   for (auto const& area : areas_) {
+    OpenrEventBase* evb = this;
+    if (enableAreaThreads) {
+      evb = areaEvbs_.emplace(area, std::make_unique<OpenrEventBase>())
+                .first->second.get();
+    }
     kvStoreDb_.emplace(
         std::piecewise_construct,
         std::forward_as_tuple(area),
         std::forward_as_tuple(
-            this,
+            evb,
             kvParams_,
             area,
             fbzmq::Socket<ZMQ_ROUTER, fbzmq::ZMQ_CLIENT>(
@@ -228,104 +430,343 @@ KvStore::KvStore(
             config->getKvStoreConfig().is_flood_root_ref().value_or(false),
             config->getNodeName()));
   }
+
+  // Warm start from snapshot and keep persisting it periodically
+  const auto warmStartInterval = config->getKvStoreWarmStartSnapshotInterval();
+  if (configStore and warmStartInterval.has_value()) {
+    configStore_ = configStore;
+    loadWarmStartSnapshot();
+    warmStartSnapshotTimer_ = folly::AsyncTimeout::make(
+        *getEvb(), [this, interval = *warmStartInterval]() noexcept {
+          saveWarmStartSnapshot();
+          warmStartSnapshotTimer_->scheduleTimeout(interval);
+        });
+    warmStartSnapshotTimer_->scheduleTimeout(*warmStartInterval);
+  }
+
+  // Start threads of the areas
+  for (auto& [area, evb] : areaEvbs_) {
+    const auto name = folly::sformat("KvStore.{}", area);
+    areaThreads_.emplace_back([evb = evb.get(),
+                               name,
+                               scheduling = config->getThreadSchedulingConfig(
+                                   name)]() noexcept {
+      LOG(INFO) << "Starting " << name << " thread ...";
+      folly::setThreadName(name);
+      // areas share the arena of KvStore
+      bindThreadToModuleArena("KvStore");
+      if (scheduling.has_value()) {
+        applyThreadScheduling(name, *scheduling);
+      }
+      evb->run();
+      LOG(INFO) << name << " thread got stopped.";
+    });
+  }
 }
 
-// static, public
-std::unordered_map<std::string, thrift::Value>
-KvStore::mergeKeyValues(
-    std::unordered_map<std::string, thrift::Value>& kvStore,
-    std::unordered_map<std::string, thrift::Value> const& keyVals,
-    std::optional<KvStoreFilters> const& filters) {
-  // the publication to build if we update our KV store
-  std::unordered_map<std::string, thrift::Value> kvUpdates;
+KvStore::~KvStore() {
+  stopAreaThreads();
+}
 
-  // Counters for logging
-  uint32_t ttlUpdateCnt{0}, valUpdateCnt{0};
+void
+KvStore::stop() {
+  closeKvStoreUpdatesReaders();
+  OpenrEventBase::stop();
+  stopAreaThreads();
+}
 
-  for (const auto& [key, value] : keyVals) {
-    if (filters.has_value() && not filters->keyMatch(key, value)) {
-      VLOG(4) << "key: " << key << " not adding from " << value.originatorId;
-      continue;
-    }
+void
+KvStore::stopAreaThreads() {
+  if (areaThreads_.empty()) {
+    return;
+  }
+  for (auto& [_, evb] : areaEvbs_) {
+    evb->stop();
+  }
+  for (auto& thread : areaThreads_) {
+    thread.join();
+  }
+  areaThreads_.clear();
+}
 
-    // versions must start at 1; setting this to zero here means
-    // we would be beaten by any version supplied by the setter
-    int64_t myVersion{0};
-    int64_t newVersion = value.version;
+std::vector<std::pair<std::string, OpenrEventBase*>>
+KvStore::getAreaEvbs() const {
+  std::vector<std::pair<std::string, OpenrEventBase*>> evbs;
+  for (auto const& [area, evb] : areaEvbs_) {
+    evbs.emplace_back(area, evb.get());
+  }
+  return evbs;
+}
 
-    // Check if TTL is valid. It must be infinite or positive number
-    // Skip if invalid!
-    if (value.ttl != Constants::kTtlInfinity && value.ttl <= 0) {
-      continue;
-    }
+OpenrEventBase*
+KvStore::getAreaEvb(const std::string& area) {
+  auto it = areaEvbs_.find(area);
+  return it != areaEvbs_.end() ? it->second.get() : this;
+}
 
-    // if key exist, compare values first
-    // if they are the same, no need to propagate changes
-    auto kvStoreIt = kvStore.find(key);
-    if (kvStoreIt != kvStore.end()) {
-      myVersion = kvStoreIt->second.version;
-    } else {
-      VLOG(4) << "(mergeKeyValues) key: '" << key << "' not found, adding";
-    }
+template <typename T, typename Func>
+folly::SemiFuture<std::map<std::string, T>>
+KvStore::collectFromAreas(std::set<std::string> const& areas, Func func) {
+  std::vector<folly::SemiFuture<std::pair<std::string, T>>> futures;
+  for (auto const& area : areas) {
+    auto pf = folly::makePromiseContract<std::pair<std::string, T>>();
+    getAreaEvb(area)->runInEventBaseThread(
+        [this, area, func, p = std::move(pf.first)]() mutable {
+          p.setWith([&]() {
+            return std::make_pair(area, func(kvStoreDb_.at(area)));
+          });
+        });
+    futures.emplace_back(std::move(pf.second));
+  }
+  return folly::collect(std::move(futures))
+      .deferValue([](std::vector<std::pair<std::string, T>>&& results) {
+        return std::map<std::string, T>(
+            std::make_move_iterator(results.begin()),
+            std::make_move_iterator(results.end()));
+      });
+}
 
-    // If we get an old value just skip it
-    if (newVersion < myVersion) {
+void
+KvStore::loadWarmStartSnapshot() {
+  folly::Expected<thrift::KvStoreWarmStartDb, folly::Unit> maybeDb;
+  try {
+    maybeDb = configStore_
+                  ->loadThriftObj<thrift::KvStoreWarmStartDb>(
+                      kWarmStartConfigKey)
+                  .get();
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to load warm start snapshot. Error: "
+               << folly::exceptionStr(e);
+    return;
+  }
+  if (maybeDb.hasError()) {
+    LOG(INFO) << "No warm start snapshot found";
+    return;
+  }
+
+  // Age TTLs by time since snapshot. Clock going back is treated as no time
+  // having passed
+  const int64_t elapsedMs =
+      std::max<int64_t>(0, getUnixTimeStampMs() - maybeDb->timestampMs);
+
+  size_t numRestored{0};
+  for (auto& [area, publication] : maybeDb->areaPublications) {
+    auto kvStoreDbIt = kvStoreDb_.find(area);
+    if (kvStoreDbIt == kvStoreDb_.end()) {
+      LOG(WARNING) << "Skipping warm start snapshot of unknown area: " << area;
       continue;
     }
+    thrift::Publication warmStartPub;
+    warmStartPub.warmStart_ref() = true;
+    for (auto& [key, value] : publication.keyVals) {
+      // Own key-values are re-advertised by their originating modules
+      if (value.originatorId == kvParams_.nodeId) {
+        continue;
+      }
+      if (value.ttl != Constants::kTtlInfinity) {
+        value.ttl -= elapsedMs;
+        if (value.ttl < Constants::kTtlThreshold.count()) {
+          continue;
+        }
+      }
+      warmStartPub.keyVals.emplace(key, std::move(value));
+    }
+    auto& kvStoreDb = kvStoreDbIt->second;
+    kvStoreDb.prepareKeyValsForMerge(warmStartPub.keyVals);
+    numRestored += kvStoreDb.mergePublication(warmStartPub);
+  }
 
-    bool updateAllNeeded{false};
-    bool updateTtlNeeded{false};
+  LOG(INFO) << "Restored " << numRestored << " key-values from warm start "
+            << "snapshot of " << elapsedMs << "ms ago";
+  fb303::fbData->addStatValue(
+      "kvstore.warm_start.restored_key_vals", numRestored, fb303::SUM);
+}
 
-    //
-    // Check updateAll and updateTtl
-    //
-    if (value.value_ref().has_value()) {
-      if (newVersion > myVersion) {
-        // Version is newer or
-        // kvStoreIt is NULL(myVersion is set to 0)
-        updateAllNeeded = true;
-      } else if (value.originatorId > kvStoreIt->second.originatorId) {
-        // versions are the same but originatorId is higher
+void
+KvStore::saveWarmStartSnapshot() {
+  collectFromAreas<thrift::Publication>(
+      resolveAreas({}),
+      [](KvStoreDb& kvStoreDb) { return kvStoreDb.dumpWarmStartPublication(); })
+      .via(getEvb())
+      .thenValue(
+          [this](std::map<std::string, thrift::Publication>&& publications) {
+            thrift::KvStoreWarmStartDb warmStartDb;
+            warmStartDb.timestampMs = getUnixTimeStampMs();
+            warmStartDb.areaPublications = std::move(publications);
+            // Not waiting for the write, config-store persists it
+            // asynchronously
+            configStore_->storeThriftObj(kWarmStartConfigKey, warmStartDb);
+            fb303::fbData->addStatValue(
+                "kvstore.warm_start.snapshots", 1, fb303::COUNT);
+          });
+}
+
+namespace {
+
+enum class MergeAction { SKIP, UPDATE_ALL, UPDATE_TTL };
+
+// Decide how key-value of a publication is merged into kvStore. Only reads
+// kvStore, so that decisions of different keys can be made concurrently
+MergeAction
+getMergeAction(
+    std::unordered_map<std::string, thrift::Value> const& kvStore,
+    std::string const& key,
+    thrift::Value const& value,
+    std::optional<openr::KvStoreFilters> const& filters) {
+  if (filters.has_value() && not filters->keyMatch(key, value)) {
+    VLOG(4) << "key: " << key << " not adding from " << value.originatorId;
+    return MergeAction::SKIP;
+  }
+
+  // versions must start at 1; setting this to zero here means
+  // we would be beaten by any version supplied by the setter
+  int64_t myVersion{0};
+  int64_t newVersion = value.version;
+
+  // Check if TTL is valid. It must be infinite or positive number
+  // Skip if invalid!
+  if (value.ttl != openr::Constants::kTtlInfinity && value.ttl <= 0) {
+    return MergeAction::SKIP;
+  }
+
+  // if key exist, compare values first
+  // if they are the same, no need to propagate changes
+  auto kvStoreIt = kvStore.find(key);
+  if (kvStoreIt != kvStore.end()) {
+    myVersion = kvStoreIt->second.version;
+  } else {
+    VLOG(4) << "(mergeKeyValues) key: '" << key << "' not found, adding";
+  }
+
+  // If we get an old value just skip it
+  if (newVersion < myVersion) {
+    return MergeAction::SKIP;
+  }
+
+  bool updateAllNeeded{false};
+  bool updateTtlNeeded{false};
+
+  //
+  // Check updateAll and updateTtl
+  //
+  if (value.value_ref().has_value()) {
+    if (newVersion > myVersion) {
+      // Version is newer or
+      // kvStoreIt is NULL(myVersion is set to 0)
+      updateAllNeeded = true;
+    } else if (value.originatorId > kvStoreIt->second.originatorId) {
+      // versions are the same but originatorId is higher
+      updateAllNeeded = true;
+    } else if (value.originatorId == kvStoreIt->second.originatorId) {
+      // This can occur after kvstore restarts or simply reconnects after
+      // disconnection. We let one of the two values win if they
+      // differ(higher in this case but can be lower as long as it's
+      // deterministic). Otherwise, local store can have new value while
+      // other stores have old value and they never sync.
+      int rc = (*value.value_ref()).compare(*kvStoreIt->second.value_ref());
+      if (rc > 0) {
+        // versions and orginatorIds are same but value is higher
+        VLOG(3) << "Previous incarnation reflected back for key " << key;
         updateAllNeeded = true;
-      } else if (value.originatorId == kvStoreIt->second.originatorId) {
-        // This can occur after kvstore restarts or simply reconnects after
-        // disconnection. We let one of the two values win if they
-        // differ(higher in this case but can be lower as long as it's
-        // deterministic). Otherwise, local store can have new value while
-        // other stores have old value and they never sync.
-        int rc = (*value.value_ref()).compare(*kvStoreIt->second.value_ref());
-        if (rc > 0) {
-          // versions and orginatorIds are same but value is higher
-          VLOG(3) << "Previous incarnation reflected back for key " << key;
-          updateAllNeeded = true;
-        } else if (rc == 0) {
-          // versions, orginatorIds, value are all same
-          // retain higher ttlVersion
-          if (value.ttlVersion > kvStoreIt->second.ttlVersion) {
-            updateTtlNeeded = true;
-          }
+      } else if (rc == 0) {
+        // versions, orginatorIds, value are all same
+        // retain higher ttlVersion
+        if (value.ttlVersion > kvStoreIt->second.ttlVersion) {
+          updateTtlNeeded = true;
         }
       }
     }
+  }
 
-    //
-    // Check updateTtl
-    //
-    if (not value.value_ref().has_value() and kvStoreIt != kvStore.end() and
-        value.version == kvStoreIt->second.version and
-        value.originatorId == kvStoreIt->second.originatorId and
-        value.ttlVersion > kvStoreIt->second.ttlVersion) {
-      updateTtlNeeded = true;
-    }
+  //
+  // Check updateTtl
+  //
+  if (not value.value_ref().has_value() and kvStoreIt != kvStore.end() and
+      value.version == kvStoreIt->second.version and
+      value.originatorId == kvStoreIt->second.originatorId and
+      value.ttlVersion > kvStoreIt->second.ttlVersion) {
+    updateTtlNeeded = true;
+  }
 
-    if (!updateAllNeeded and !updateTtlNeeded) {
-      VLOG(3) << "(mergeKeyValues) no need to update anything for key: '" << key
-              << "'";
-      continue;
+  if (updateAllNeeded) {
+    return MergeAction::UPDATE_ALL;
+  }
+  if (updateTtlNeeded) {
+    return MergeAction::UPDATE_TTL;
+  }
+  VLOG(3) << "(mergeKeyValues) no need to update anything for key: '" << key
+          << "'";
+  return MergeAction::SKIP;
+}
+
+// Would value update of key grow kvStore (accounted by keyIndex) beyond any
+// of the limits? Updates not growing usage over a limit are accepted, so that
+// originator already over the limit (e.g. limit lowered) can shrink
+bool
+exceedsLimits(
+    openr::KvStoreLimits const& limits,
+    openr::KvStoreKeyIndex const& keyIndex,
+    std::string const& key,
+    thrift::Value const& value,
+    thrift::Value const* oldValue) {
+  using openr::KvStoreKeyIndex;
+  auto const exceeds = [](size_t limit, size_t current, size_t updated) {
+    return limit and updated > limit and updated > current;
+  };
+  const size_t bytes = KvStoreKeyIndex::getKeyValueBytes(key, value);
+  const size_t oldBytes =
+      oldValue ? KvStoreKeyIndex::getKeyValueBytes(key, *oldValue) : 0;
+  const bool sameOriginator =
+      oldValue and oldValue->originatorId == value.originatorId;
+
+  const size_t originatorKeys =
+      keyIndex.getOriginatorKeyCount(value.originatorId);
+  const size_t originatorBytes =
+      keyIndex.getOriginatorBytes(value.originatorId);
+  return exceeds(
+             limits.maxKeysPerOriginator,
+             originatorKeys,
+             originatorKeys + (sameOriginator ? 0 : 1)) or
+      exceeds(
+             limits.maxBytesPerOriginator,
+             originatorBytes,
+             originatorBytes - (sameOriginator ? oldBytes : 0) + bytes) or
+      exceeds(limits.maxKeys, keyIndex.size(), keyIndex.size() + !oldValue) or
+      exceeds(
+             limits.maxBytes,
+             keyIndex.getBytes(),
+             keyIndex.getBytes() - oldBytes + bytes);
+}
+
+} // namespace
+
+// static, public
+std::unordered_map<std::string, thrift::Value>
+KvStore::mergeKeyValues(
+    std::unordered_map<std::string, thrift::Value>& kvStore,
+    std::unordered_map<std::string, thrift::Value> const& keyVals,
+    std::optional<KvStoreFilters> const& filters,
+    KvStoreHashTree* hashTree,
+    KvStoreKeyIndex* keyIndex,
+    folly::CPUThreadPoolExecutor* mergeExecutor,
+    std::optional<KvStoreLimits> const& limits) {
+  // the publication to build if we update our KV store
+  std::unordered_map<std::string, thrift::Value> kvUpdates;
+
+  // Counters for logging
+  uint32_t ttlUpdateCnt{0}, valUpdateCnt{0}, rejectedCnt{0};
+
+  auto const applyMergeAction = [&](std::string const& key,
+                                    thrift::Value const& value,
+                                    MergeAction action) {
+    if (action == MergeAction::SKIP) {
+      return;
     }
+    auto kvStoreIt = kvStore.find(key);
 
-    VLOG(3) << "Updating key: " << key << "\n  Version: " << myVersion << " -> "
-            << newVersion << "\n  Originator: "
+    VLOG(3) << "Updating key: " << key << "\n  Version: "
+            << (kvStoreIt != kvStore.end() ? kvStoreIt->second.version : 0)
+            << " -> " << value.version << "\n  Originator: "
             << (kvStoreIt != kvStore.end() ? kvStoreIt->second.originatorId
                                            : "null")
             << " -> " << value.originatorId << "\n  TtlVersion: "
@@ -334,19 +775,35 @@ KvStore::mergeKeyValues(
             << (kvStoreIt != kvStore.end() ? kvStoreIt->second.ttl : 0)
             << " -> " << value.ttl;
 
-    // grab the new value (this will copy, intended)
-    thrift::Value newValue = value;
+    if (action == MergeAction::UPDATE_ALL and limits.has_value() and
+        keyIndex and
+        exceedsLimits(
+            *limits,
+            *keyIndex,
+            key,
+            value,
+            kvStoreIt != kvStore.end() ? &kvStoreIt->second : nullptr)) {
+      // keep the existing value (if any), the update is neither stored nor
+      // flooded further
+      ++rejectedCnt;
+      FB_LOG_EVERY_MS(WARNING, 500)
+          << "Rejecting key: " << key << ", Originator: " << value.originatorId
+          << ", Version: " << value.version << " exceeding KvStore limits";
+      return;
+    }
 
-    if (updateAllNeeded) {
+    if (action == MergeAction::UPDATE_ALL) {
       ++valUpdateCnt;
       FB_LOG_EVERY_MS(INFO, 500)
           << "Updating key: " << key << ", Originator: " << value.originatorId
-          << ", Version: " << newVersion << ", TtlVersion: " << value.ttlVersion
-          << ", Ttl: " << value.ttl;
+          << ", Version: " << value.version
+          << ", TtlVersion: " << value.ttlVersion << ", Ttl: " << value.ttl;
       //
       // update everything for such key
       //
       CHECK(value.value_ref().has_value());
+      // grab the new value (this will copy, intended)
+      thrift::Value newValue = value;
       if (kvStoreIt == kvStore.end()) {
         // create new entry
         std::tie(kvStoreIt, std::ignore) = kvStore.emplace(
@@ -354,6 +811,12 @@ KvStore::mergeKeyValues(
             std::forward_as_tuple(key),
             std::forward_as_tuple(std::move(newValue)));
       } else {
+        if (hashTree) {
+          hashTree->remove(key, kvStoreIt->second);
+        }
+        if (keyIndex) {
+          keyIndex->remove(key, kvStoreIt->second);
+        }
         // update the entry in place, the old value will be destructed
         kvStoreIt->second = std::move(newValue);
       }
@@ -362,7 +825,14 @@ KvStore::mergeKeyValues(
         kvStoreIt->second.hash_ref() =
             generateHash(value.version, value.originatorId, value.value_ref());
       }
-    } else if (updateTtlNeeded) {
+      if (hashTree) {
+        hashTree->add(key, kvStoreIt->second);
+      }
+      if (keyIndex) {
+        // index references the key stored in kvStore
+        keyIndex->add(kvStoreIt->first, kvStoreIt->second);
+      }
+    } else {
       ++ttlUpdateCnt;
       //
       // update ttl,ttlVersion only
@@ -376,14 +846,134 @@ KvStore::mergeKeyValues(
 
     // announce the update
     kvUpdates.emplace(key, value);
+  };
+
+  const size_t numTasks = mergeExecutor and
+          keyVals.size() >= Constants::kParallelMergeMinKeys
+      ? std::min(mergeExecutor->numThreads(), keyVals.size())
+      : 1;
+  if (numTasks <= 1) {
+    for (const auto& [key, value] : keyVals) {
+      applyMergeAction(
+          key, value, getMergeAction(kvStore, key, value, filters));
+    }
+  } else {
+    // Decide on key-values in parallel, e.g. filter matching and value
+    // comparison, then apply the decisions to kvStore serially
+    std::vector<std::pair<const std::string, thrift::Value> const*> entries;
+    entries.reserve(keyVals.size());
+    for (auto const& entry : keyVals) {
+      entries.emplace_back(&entry);
+    }
+    std::vector<MergeAction> actions(entries.size(), MergeAction::SKIP);
+
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    futures.reserve(numTasks);
+    const size_t taskSize = (entries.size() + numTasks - 1) / numTasks;
+    for (size_t task = 0; task < numTasks; ++task) {
+      const size_t begin = task * taskSize;
+      const size_t end = std::min(entries.size(), begin + taskSize);
+      futures.emplace_back(folly::via(mergeExecutor, [&, begin, end]() {
+                             for (size_t i = begin; i < end; ++i) {
+                               actions[i] = getMergeAction(
+                                   kvStore,
+                                   entries[i]->first,
+                                   entries[i]->second,
+                                   filters);
+                             }
+                           }).semi());
+    }
+    // rethrows the first exception of any task
+    folly::collect(std::move(futures)).get();
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      applyMergeAction(entries[i]->first, entries[i]->second, actions[i]);
+    }
   }
 
   VLOG(4) << "(mergeKeyValues) updating " << kvUpdates.size()
           << " keyvals. ValueUpdates: " << valUpdateCnt
-          << ", TtlUpdates: " << ttlUpdateCnt;
+          << ", TtlUpdates: " << ttlUpdateCnt
+          << ", Rejected: " << rejectedCnt;
+  if (rejectedCnt) {
+    fb303::fbData->addStatValue(
+        "kvstore.rejected_key_vals", rejectedCnt, fb303::SUM);
+  }
   return kvUpdates;
 }
 
+// static, public
+std::unordered_map<std::string, thrift::Value>
+KvStore::mergeTtlRefreshes(
+    std::unordered_map<std::string, thrift::Value>& kvStore,
+    std::vector<thrift::TtlRefreshBatch> const& ttlRefreshes) {
+  std::unordered_map<std::string, thrift::Value> kvUpdates;
+
+  for (auto const& batch : ttlRefreshes) {
+    for (auto const& refresh : batch.refreshes) {
+      // Check if TTL is valid. It must be infinite or positive number
+      if (refresh.ttl != Constants::kTtlInfinity && refresh.ttl <= 0) {
+        continue;
+      }
+
+      auto kvStoreIt = kvStore.find(refresh.key);
+      if (kvStoreIt == kvStore.end() or
+          kvStoreIt->second.version != refresh.version or
+          kvStoreIt->second.originatorId != batch.originatorId or
+          kvStoreIt->second.ttlVersion >= refresh.ttlVersion) {
+        continue;
+      }
+
+      // update TTL only, nothing else
+      kvStoreIt->second.ttl = refresh.ttl;
+      kvStoreIt->second.ttlVersion = refresh.ttlVersion;
+
+      // announce the update
+      thrift::Value ttlUpdate;
+      ttlUpdate.version = refresh.version;
+      ttlUpdate.originatorId = batch.originatorId;
+      ttlUpdate.ttl = refresh.ttl;
+      ttlUpdate.ttlVersion = refresh.ttlVersion;
+      kvUpdates.insert_or_assign(refresh.key, std::move(ttlUpdate));
+    }
+  }
+
+  VLOG(4) << "(mergeTtlRefreshes) updating " << kvUpdates.size()
+          << " keyvals.";
+  return kvUpdates;
+}
+
+// static, public
+std::vector<thrift::TtlRefreshBatch>
+KvStore::batchTtlRefreshes(
+    std::unordered_map<std::string, thrift::Value>& keyVals) {
+  std::unordered_map<std::string, thrift::TtlRefreshBatch> batches;
+  for (auto it = keyVals.begin(); it != keyVals.end();) {
+    auto const& value = it->second;
+    if (value.value_ref().has_value()) {
+      ++it;
+      continue;
+    }
+
+    auto& batch = batches[value.originatorId];
+    batch.originatorId = value.originatorId;
+    thrift::TtlRefresh refresh;
+    refresh.key = it->first;
+    refresh.version = value.version;
+    refresh.ttlVersion = value.ttlVersion;
+    refresh.ttl = value.ttl;
+    batch.refreshes.emplace_back(std::move(refresh));
+    it = keyVals.erase(it);
+  }
+
+  std::vector<thrift::TtlRefreshBatch> ttlRefreshes;
+  ttlRefreshes.reserve(batches.size());
+  for (auto& [_, batch] : batches) {
+    ttlRefreshes.emplace_back(std::move(batch));
+  }
+  return ttlRefreshes;
+}
+
 /**
  * Compare two values to find out which value is better
  */
@@ -416,6 +1006,18 @@ KvStore::compareValues(const thrift::Value& v1, const thrift::Value& v2) {
   // can't use hash, either it's missing or they are different
   // compare values
   if (v1.value_ref().has_value() and v2.value_ref().has_value()) {
+    if (KvStoreValueCompression::isCompressed(v1) or
+        KvStoreValueCompression::isCompressed(v2)) {
+      // compare uncompressed content
+      auto uncompressedV1 = v1;
+      auto uncompressedV2 = v2;
+      if (not KvStoreValueCompression::decompress(uncompressedV1) or
+          not KvStoreValueCompression::decompress(uncompressedV2)) {
+        return -2; // unknown
+      }
+      return (*uncompressedV1.value_ref())
+          .compare(*uncompressedV2.value_ref());
+    }
     return (*v1.value_ref()).compare(*v2.value_ref());
   } else {
     // some value is missing
@@ -462,31 +1064,10 @@ KvStore::processCmdSocketRequest(std::vector<fbzmq::Message>&& req) noexcept {
     LOG(ERROR) << "Empty request received";
     return;
   }
-  auto maybeReply = processRequestMsg(
-      req.front().read<std::string>().value(), std::move(req.back()));
+  auto requestId = req.front().read<std::string>().value();
+  auto request = std::move(req.back());
   req.pop_back();
 
-  // All messages of the multipart request except the last are sent back as they
-  // are ids or empty delims. Add the response at the end of that list.
-  if (maybeReply.hasValue()) {
-    req.emplace_back(std::move(maybeReply.value()));
-  } else {
-    req.emplace_back(
-        fbzmq::Message::from(Constants::kErrorResponse.toString()).value());
-  }
-
-  if (not req.back().empty()) {
-    auto sndRet = kvParams_.globalCmdSock.sendMultiple(req);
-    if (sndRet.hasError()) {
-      LOG(ERROR) << "Error sending response. " << sndRet.error();
-    }
-  }
-  return;
-}
-
-folly::Expected<fbzmq::Message, fbzmq::Error>
-KvStore::processRequestMsg(
-    const std::string& requestId, fbzmq::Message&& request) {
   fb303::fbData->addStatValue(
       "kvstore.peers.bytes_received", request.size(), fb303::SUM);
   auto maybeThriftReq =
@@ -495,7 +1076,8 @@ KvStore::processRequestMsg(
   if (maybeThriftReq.hasError()) {
     LOG(ERROR) << "processRequest: failed reading thrift::processRequestMsg"
                << maybeThriftReq.error();
-    return {folly::makeUnexpected(fbzmq::Error())};
+    sendCmdSocketReply(std::move(req), folly::makeUnexpected(fbzmq::Error()));
+    return;
   }
 
   auto& thriftRequest = maybeThriftReq.value();
@@ -511,6 +1093,56 @@ KvStore::processRequestMsg(
     area = *areas_.begin();
   }
 
+  auto* evb = getAreaEvb(area);
+  if (evb == this) {
+    sendCmdSocketReply(
+        std::move(req), processRequestMsg(requestId, area, thriftRequest));
+    return;
+  }
+
+  // Serve on thread of the area, and reply from KvStore thread owning the
+  // socket
+  evb->runInEventBaseThread([this,
+                             req = std::move(req),
+                             requestId = std::move(requestId),
+                             area = std::move(area),
+                             thriftRequest =
+                                 std::move(thriftRequest)]() mutable {
+    auto maybeReply = processRequestMsg(requestId, area, thriftRequest);
+    runInEventBaseThread([this,
+                          req = std::move(req),
+                          maybeReply = std::move(maybeReply)]() mutable {
+      sendCmdSocketReply(std::move(req), std::move(maybeReply));
+    });
+  });
+}
+
+void
+KvStore::sendCmdSocketReply(
+    std::vector<fbzmq::Message>&& req,
+    folly::Expected<fbzmq::Message, fbzmq::Error>&& maybeReply) noexcept {
+  // All messages of the multipart request except the last are sent back as they
+  // are ids or empty delims. Add the response at the end of that list.
+  if (maybeReply.hasValue()) {
+    req.emplace_back(std::move(maybeReply.value()));
+  } else {
+    req.emplace_back(
+        fbzmq::Message::from(Constants::kErrorResponse.toString()).value());
+  }
+
+  if (not req.back().empty()) {
+    auto sndRet = kvParams_.globalCmdSock.sendMultiple(req);
+    if (sndRet.hasError()) {
+      LOG(ERROR) << "Error sending response. " << sndRet.error();
+    }
+  }
+}
+
+folly::Expected<fbzmq::Message, fbzmq::Error>
+KvStore::processRequestMsg(
+    const std::string& requestId,
+    const std::string& area,
+    thrift::KvStoreRequest& thriftRequest) {
   VLOG(2) << "Request received for area " << area;
   try {
     auto& kvStoreDb = kvStoreDb_.at(area);
@@ -528,11 +1160,45 @@ KvStore::processRequestMsg(
   return {folly::makeUnexpected(fbzmq::Error())};
 }
 
-messaging::RQueue<thrift::Publication>
+messaging::RQueue<KvStorePublication>
 KvStore::getKvStoreUpdatesReader() {
   return kvParams_.kvStoreUpdatesQueue.getReader();
 }
 
+messaging::RQueue<KvStorePublication>
+KvStore::getKvStoreUpdatesReader(
+    KvStoreFilters filters, std::unordered_set<std::string> const& areas) {
+  auto subscription =
+      std::make_unique<KvStoreSubscription>(std::move(filters), areas);
+  auto reader = subscription->updatesQueue.getReader();
+  kvParams_.subscriptions.wlock()->emplace_back(std::move(subscription));
+  return reader;
+}
+
+void
+KvStore::closeKvStoreUpdatesReaders() {
+  for (auto& subscription : *kvParams_.subscriptions.wlock()) {
+    subscription->updatesQueue.close();
+  }
+}
+
+void
+KvStore::processConfigUpdate(std::shared_ptr<const Config> const& config) {
+  auto floodRate = config->getKvStoreConfig().flood_rate_ref();
+  if (not floodRate.has_value()) {
+    return;
+  }
+  LOG(INFO) << "Applying reloaded flood rate of "
+            << floodRate->flood_msg_per_sec << " msgs/s, burst of "
+            << floodRate->flood_msg_burst_size;
+  for (auto const& area : areas_) {
+    getAreaEvb(area)->runInEventBaseThread(
+        [this, area, rate = *floodRate]() noexcept {
+          kvStoreDb_.at(area).setFloodRate(rate);
+        });
+  }
+}
+
 void
 KvStore::processPeerUpdates(thrift::PeerUpdateRequest&& req) {
   // Req can contain peerAdd/peerDel simultaneously
@@ -542,17 +1208,71 @@ KvStore::processPeerUpdates(thrift::PeerUpdateRequest&& req) {
   if (req.peerDelParams_ref().has_value()) {
     deleteKvStorePeers(req.peerDelParams_ref().value(), req.area).get();
   }
+  if (req.initialPeersDiscovered_ref().value_or(false)) {
+    getAreaEvb(req.area)->runInEventBaseThread([this, area = req.area]() {
+      auto it = kvStoreDb_.find(area);
+      if (it == kvStoreDb_.end()) {
+        LOG(ERROR) << "Initial peers discovered in invalid area: " << area;
+        return;
+      }
+      it->second.processInitialPeersDiscovered();
+    });
+  }
+}
+
+bool
+KvStore::mergePeerAdditions(
+    thrift::PeerUpdateRequest& batch, thrift::PeerUpdateRequest& req) {
+  auto isAddOnly = [](thrift::PeerUpdateRequest const& r) {
+    return r.peerAddParams_ref().has_value() and
+        not r.peerDelParams_ref().has_value() and
+        not r.initialPeersDiscovered_ref().value_or(false);
+  };
+  if (batch.area != req.area or not isAddOnly(batch) or not isAddOnly(req)) {
+    return false;
+  }
+  // later spec of a peer wins, as if requests were applied in order
+  for (auto& [peerName, peerSpec] : req.peerAddParams_ref()->peers) {
+    batch.peerAddParams_ref()->peers[peerName] = std::move(peerSpec);
+  }
+  return true;
+}
+
+std::shared_ptr<const KvStoreSnapshot::Snapshot>
+KvStore::getSnapshot(const std::string& area) const {
+  auto it = kvStoreDb_.find(area);
+  if (it == kvStoreDb_.end()) {
+    return nullptr;
+  }
+  return it->second.getSnapshot();
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 KvStore::getKvStoreKeyVals(
     thrift::KeyGetParams keyGetParams, std::string area) {
+  // Serve from snapshot on the calling thread if enabled
+  if (auto snapshot = getSnapshot(area)) {
+    fb303::fbData->addStatValue("kvstore.cmd_key_get", 1, fb303::COUNT);
+    fb303::fbData->addStatValue("kvstore.snapshot_reads", 1, fb303::COUNT);
+    auto thriftPub = std::make_unique<thrift::Publication>();
+    thriftPub->area_ref() = area;
+    const auto timeNow = std::chrono::steady_clock::now();
+    for (auto const& key : keyGetParams.keys) {
+      if (auto const* entry = snapshot->find(key)) {
+        addSnapshotEntry(*thriftPub, key, *entry, timeNow, kvParams_.ttlDecr);
+      }
+    }
+    KvStoreValueCompression::decompressAll(thriftPub->keyVals);
+    return folly::makeSemiFuture(std::move(thriftPub));
+  }
+
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyGetParams = std::move(keyGetParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyGetParams = std::move(keyGetParams),
+                             area]() mutable {
     VLOG(3) << "Get key requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -572,70 +1292,240 @@ KvStore::getKvStoreKeyVals(
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
-KvStore::dumpKvStoreKeys(
-    thrift::KeyDumpParams keyDumpParams, std::string area) {
+KvStore::getKvStoreKeyHashes(
+    thrift::KeyGetParams keyGetParams, std::string area) {
+  // Serve from snapshot on the calling thread if enabled
+  if (auto snapshot = getSnapshot(area)) {
+    fb303::fbData->addStatValue("kvstore.cmd_hash_get", 1, fb303::COUNT);
+    fb303::fbData->addStatValue("kvstore.snapshot_reads", 1, fb303::COUNT);
+    auto thriftPub = std::make_unique<thrift::Publication>();
+    thriftPub->area_ref() = area;
+    const auto timeNow = std::chrono::steady_clock::now();
+    for (auto const& key : keyGetParams.keys) {
+      if (auto const* entry = snapshot->find(key)) {
+        addSnapshotEntry(*thriftPub, key, *entry, timeNow, kvParams_.ttlDecr);
+      }
+    }
+    for (auto& [_, value] : thriftPub->keyVals) {
+      DCHECK(value.hash_ref().has_value());
+      value.value_ref().reset();
+    }
+    return folly::makeSemiFuture(std::move(thriftPub));
+  }
+
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyDumpParams = std::move(keyDumpParams),
-                        area]() mutable {
-    VLOG(3) << "Dump all keys requested for AREA: " << area;
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyGetParams = std::move(keyGetParams),
+                             area]() mutable {
+    VLOG(3) << "Get hash requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
       p.setException(
           thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
     } else {
-      fb303::fbData->addStatValue("kvstore.cmd_key_dump", 1, fb303::COUNT);
+      fb303::fbData->addStatValue("kvstore.cmd_hash_get", 1, fb303::COUNT);
 
       auto& kvStoreDb = kvStoreDb_.at(area);
-      std::vector<std::string> keyPrefixList;
-      folly::split(",", keyDumpParams.prefix, keyPrefixList, true);
-      const auto keyPrefixMatch =
-          KvStoreFilters(keyPrefixList, keyDumpParams.originatorIds);
+      auto thriftPub = kvStoreDb.getKeyHashes(keyGetParams.keys);
+      kvStoreDb.updatePublicationTtl(thriftPub);
 
-      thrift::FilterOperator oper = thrift::FilterOperator::OR;
-      if (keyDumpParams.oper_ref().has_value()) {
-        oper = *keyDumpParams.oper_ref();
-      }
+      p.setValue(std::make_unique<thrift::Publication>(std::move(thriftPub)));
+    }
+  });
+  return sf;
+}
 
-      auto thriftPub = kvStoreDb.dumpAllWithFilters(keyPrefixMatch, oper);
-      if (keyDumpParams.keyValHashes_ref().has_value()) {
-        thriftPub = kvStoreDb.dumpDifference(
-            thriftPub.keyVals, keyDumpParams.keyValHashes_ref().value());
-      }
-      kvStoreDb.updatePublicationTtl(thriftPub);
-      // I'm the initiator, set flood-root-id
-      fromStdOptional(thriftPub.floodRootId_ref(), kvStoreDb.getSptRootId());
-
-      if (keyDumpParams.keyValHashes_ref().has_value() and
-          keyDumpParams.prefix.empty()) {
-        // This usually comes from neighbor nodes
-        size_t numMissingKeys = 0;
-        if (thriftPub.tobeUpdatedKeys_ref().has_value()) {
-          numMissingKeys = thriftPub.tobeUpdatedKeys_ref()->size();
-        }
-        LOG(INFO) << "Processed full-sync request with "
-                  << keyDumpParams.keyValHashes_ref().value().size()
-                  << " keyValHashes item(s). Sending "
-                  << thriftPub.keyVals.size() << " key-vals and "
-                  << numMissingKeys << " missing keys";
+std::unique_ptr<thrift::Publication>
+KvStore::dumpKvStoreKeysFromSnapshot(
+    const thrift::KeyDumpParams& keyDumpParams, const std::string& area) const {
+  // Full-sync requests of peers are always served on KvStore thread
+  // Paged dumps need ordered key index of KvStore thread
+  auto snapshot = getSnapshot(area);
+  if (not snapshot or keyDumpParams.keyValHashes_ref().has_value() or
+      keyDumpParams.hashTreeBuckets_ref().has_value() or
+      keyDumpParams.hashTreeRootDigest_ref().has_value() or
+      keyDumpParams.pageSize_ref().has_value()) {
+    return nullptr;
+  }
+
+  fb303::fbData->addStatValue("kvstore.cmd_key_dump", 1, fb303::COUNT);
+  fb303::fbData->addStatValue("kvstore.snapshot_reads", 1, fb303::COUNT);
+  std::vector<std::string> keyPrefixList;
+  folly::split(",", keyDumpParams.prefix, keyPrefixList, true);
+  const auto keyPrefixMatch =
+      KvStoreFilters(keyPrefixList, keyDumpParams.originatorIds);
+  const bool matchAll = keyDumpParams.oper_ref().has_value() and
+      *keyDumpParams.oper_ref() == thrift::FilterOperator::AND;
+
+  auto thriftPub = std::make_unique<thrift::Publication>();
+  thriftPub->area_ref() = area;
+  const auto timeNow = std::chrono::steady_clock::now();
+  for (auto const& shard : snapshot->shards) {
+    for (auto const& [key, entry] : *shard) {
+      const bool match = matchAll ? keyPrefixMatch.keyMatchAll(key, entry.value)
+                                  : keyPrefixMatch.keyMatch(key, entry.value);
+      if (match) {
+        addSnapshotEntry(*thriftPub, key, entry, timeNow, kvParams_.ttlDecr);
       }
+    }
+  }
+  if (not keyDumpParams.supportValueCompression_ref().value_or(false)) {
+    KvStoreValueCompression::decompressAll(thriftPub->keyVals);
+  }
+  // I'm the initiator, set flood-root-id
+  fromStdOptional(thriftPub->floodRootId_ref(), snapshot->sptRootId);
+  return thriftPub;
+}
+
+thrift::Publication
+KvStore::dumpKvStoreKeysFromDb(
+    KvStoreDb& kvStoreDb, const thrift::KeyDumpParams& keyDumpParams) {
+  fb303::fbData->addStatValue("kvstore.cmd_key_dump", 1, fb303::COUNT);
+
+  std::vector<std::string> keyPrefixList;
+  folly::split(",", keyDumpParams.prefix, keyPrefixList, true);
+  const auto keyPrefixMatch =
+      KvStoreFilters(keyPrefixList, keyDumpParams.originatorIds);
+
+  thrift::FilterOperator oper = thrift::FilterOperator::OR;
+  if (keyDumpParams.oper_ref().has_value()) {
+    oper = *keyDumpParams.oper_ref();
+  }
+
+  thrift::Publication thriftPub;
+  const auto pageSize = getDumpPageSize(keyDumpParams);
+  if (auto hashTreePub = kvStoreDb.dumpHashTreeSync(keyDumpParams)) {
+    thriftPub = std::move(hashTreePub.value());
+  } else if (pageSize.has_value() and
+             not keyDumpParams.keyValHashes_ref().has_value()) {
+    fb303::fbData->addStatValue("kvstore.cmd_key_dump_page", 1, fb303::COUNT);
+    thriftPub = kvStoreDb.dumpPageWithFilters(
+        keyPrefixMatch,
+        oper,
+        keyDumpParams.pageToken_ref().value_or(""),
+        *pageSize,
+        false /* hashOnly */);
+  } else {
+    thriftPub = kvStoreDb.dumpAllWithFilters(keyPrefixMatch, oper);
+    if (keyDumpParams.keyValHashes_ref().has_value()) {
+      thriftPub = kvStoreDb.dumpDifference(
+          thriftPub.keyVals, keyDumpParams.keyValHashes_ref().value());
+    }
+  }
+  kvStoreDb.updatePublicationTtl(thriftPub);
+  if (not keyDumpParams.supportValueCompression_ref().value_or(false)) {
+    KvStoreValueCompression::decompressAll(thriftPub.keyVals);
+  }
+  // I'm the initiator, set flood-root-id
+  fromStdOptional(thriftPub.floodRootId_ref(), kvStoreDb.getSptRootId());
+
+  if (keyDumpParams.keyValHashes_ref().has_value() and
+      keyDumpParams.prefix.empty()) {
+    // This usually comes from neighbor nodes
+    size_t numMissingKeys = 0;
+    if (thriftPub.tobeUpdatedKeys_ref().has_value()) {
+      numMissingKeys = thriftPub.tobeUpdatedKeys_ref()->size();
+    }
+    LOG(INFO) << "Processed full-sync request with "
+              << keyDumpParams.keyValHashes_ref().value().size()
+              << " keyValHashes item(s). Sending " << thriftPub.keyVals.size()
+              << " key-vals and " << numMissingKeys << " missing keys";
+  }
+  return thriftPub;
+}
+
+std::set<std::string>
+KvStore::resolveAreas(std::set<std::string> areas) const {
+  if (areas.empty()) {
+    for (auto const& [area, _] : kvStoreDb_) {
+      areas.emplace(area);
+    }
+    return areas;
+  }
+  for (auto const& area : areas) {
+    if (not kvStoreDb_.count(area)) {
+      throw thrift::OpenrError(folly::sformat("Invalid area: {}", area));
+    }
+  }
+  return areas;
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::Publication>>
+KvStore::dumpKvStoreKeys(
+    thrift::KeyDumpParams keyDumpParams, std::string area) {
+  // Serve filtered dumps from snapshot on the calling thread if enabled
+  if (auto thriftPub = dumpKvStoreKeysFromSnapshot(keyDumpParams, area)) {
+    return folly::makeSemiFuture(std::move(thriftPub));
+  }
+
+  folly::Promise<std::unique_ptr<thrift::Publication>> p;
+  auto sf = p.getSemiFuture();
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyDumpParams = std::move(keyDumpParams),
+                             area]() mutable {
+    VLOG(3) << "Dump all keys requested for AREA: " << area;
+
+    if (!kvStoreDb_.count(area)) {
+      p.setException(
+          thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
+    } else {
+      auto thriftPub =
+          dumpKvStoreKeysFromDb(kvStoreDb_.at(area), keyDumpParams);
       p.setValue(std::make_unique<thrift::Publication>(std::move(thriftPub)));
     }
   });
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<KvStore::AreaPublications>>
+KvStore::dumpKvStoreKeysAreas(
+    thrift::KeyDumpParams keyDumpParams, std::set<std::string> areas) {
+  try {
+    areas = resolveAreas(std::move(areas));
+  } catch (thrift::OpenrError const& ex) {
+    return folly::makeSemiFuture<std::unique_ptr<AreaPublications>>(ex);
+  }
+
+  // Serve all areas from snapshots on the calling thread if possible
+  auto pubs = std::make_unique<AreaPublications>();
+  for (auto const& area : areas) {
+    auto thriftPub = dumpKvStoreKeysFromSnapshot(keyDumpParams, area);
+    if (not thriftPub) {
+      break;
+    }
+    pubs->emplace(area, std::move(*thriftPub));
+  }
+  if (pubs->size() == areas.size()) {
+    return folly::makeSemiFuture(std::move(pubs));
+  }
+
+  VLOG(3) << "Dump all keys requested for " << areas.size() << " areas";
+  return collectFromAreas<thrift::Publication>(
+             areas,
+             [this, keyDumpParams = std::move(keyDumpParams)](
+                 KvStoreDb& kvStoreDb) {
+               return dumpKvStoreKeysFromDb(kvStoreDb, keyDumpParams);
+             })
+      .deferValue([](AreaPublications&& pubs) {
+        return std::make_unique<AreaPublications>(std::move(pubs));
+      });
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 KvStore::dumpKvStoreHashes(
     thrift::KeyDumpParams keyDumpParams, std::string area) {
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyDumpParams = std::move(keyDumpParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyDumpParams = std::move(keyDumpParams),
+                             area]() mutable {
     VLOG(3) << "Dump all hashes requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -649,7 +1539,17 @@ KvStore::dumpKvStoreHashes(
       std::vector<std::string> keyPrefixList{};
       folly::split(",", keyDumpParams.prefix, keyPrefixList, true);
       KvStoreFilters kvFilters{keyPrefixList, originator};
-      auto thriftPub = kvStoreDb.dumpHashWithFilters(kvFilters);
+      thrift::Publication thriftPub;
+      if (auto pageSize = getDumpPageSize(keyDumpParams)) {
+        thriftPub = kvStoreDb.dumpPageWithFilters(
+            kvFilters,
+            thrift::FilterOperator::OR,
+            keyDumpParams.pageToken_ref().value_or(""),
+            *pageSize,
+            true /* hashOnly */);
+      } else {
+        thriftPub = kvStoreDb.dumpHashWithFilters(kvFilters);
+      }
       kvStoreDb.updatePublicationTtl(thriftPub);
       p.setValue(std::make_unique<thrift::Publication>(std::move(thriftPub)));
     }
@@ -662,44 +1562,18 @@ KvStore::setKvStoreKeyVals(
     thrift::KeySetParams keySetParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keySetParams = std::move(keySetParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keySetParams = std::move(keySetParams),
+                             area]() mutable {
     VLOG(3) << "Set key requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
       p.setException(
           thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
     } else {
-      // Update statistics
-      fb303::fbData->addStatValue("kvstore.cmd_key_set", 1, fb303::COUNT);
-      if (keySetParams.timestamp_ms_ref().has_value()) {
-        auto floodMs =
-            getUnixTimeStampMs() - keySetParams.timestamp_ms_ref().value();
-        if (floodMs > 0) {
-          fb303::fbData->addStatValue(
-              "kvstore.flood_duration_ms", floodMs, fb303::AVG);
-        }
-      }
-
-      // Update hash for key-values
-      auto& kvStoreDb = kvStoreDb_.at(area);
-      for (auto& kv : keySetParams.keyVals) {
-        auto& value = kv.second;
-        if (value.value_ref().has_value()) {
-          value.hash_ref() = generateHash(
-              value.version, value.originatorId, value.value_ref());
-        }
-      }
-
-      // Create publication and merge it with local KvStore
-      thrift::Publication rcvdPublication;
-      rcvdPublication.keyVals = std::move(keySetParams.keyVals);
-      rcvdPublication.nodeIds_ref().move_from(keySetParams.nodeIds_ref());
-      rcvdPublication.floodRootId_ref().move_from(
-          keySetParams.floodRootId_ref());
-      kvStoreDb.mergePublication(rcvdPublication);
+      setKeyVals(area, std::move(keySetParams));
 
       // ready to return
       p.setValue();
@@ -708,6 +1582,80 @@ KvStore::setKvStoreKeyVals(
   return sf;
 }
 
+folly::SemiFuture<folly::Unit>
+KvStore::setKvStoreKeyValsBatch(
+    std::map<std::string, thrift::KeySetParams> areaKeySetParams) {
+  // group areas by event base, to hop only once onto each of them
+  std::vector<std::string> invalidAreas;
+  std::map<OpenrEventBase*, std::map<std::string, thrift::KeySetParams>>
+      evbKeySetParams;
+  for (auto& [area, keySetParams] : areaKeySetParams) {
+    if (not areas_.count(area)) {
+      invalidAreas.emplace_back(area);
+      continue;
+    }
+    evbKeySetParams[getAreaEvb(area)].emplace(area, std::move(keySetParams));
+  }
+
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  for (auto& [evb, keySetParams] : evbKeySetParams) {
+    auto pf = folly::makePromiseContract<folly::Unit>();
+    evb->runInEventBaseThread([this,
+                               p = std::move(pf.first),
+                               keySetParams =
+                                   std::move(keySetParams)]() mutable {
+      for (auto& [area, params] : keySetParams) {
+        VLOG(3) << "Batched set key requested for AREA: " << area;
+        setKeyVals(area, std::move(params));
+      }
+      p.setValue();
+    });
+    futures.emplace_back(std::move(pf.second));
+  }
+  return folly::collect(std::move(futures))
+      .deferValue([invalidAreas = std::move(invalidAreas)](
+                      std::vector<folly::Unit>&&) {
+        if (not invalidAreas.empty()) {
+          throw thrift::OpenrError(folly::sformat(
+              "Invalid areas: {}", folly::join(", ", invalidAreas)));
+        }
+      });
+}
+
+void
+KvStore::setKeyVals(
+    std::string const& area, thrift::KeySetParams keySetParams) {
+  // Update statistics
+  fb303::fbData->addStatValue("kvstore.cmd_key_set", 1, fb303::COUNT);
+  if (keySetParams.timestamp_ms_ref().has_value()) {
+    auto floodMs =
+        getUnixTimeStampMs() - keySetParams.timestamp_ms_ref().value();
+    if (floodMs > 0) {
+      fb303::fbData->addStatValue(
+          "kvstore.flood_duration_ms", floodMs, fb303::AVG);
+    }
+  }
+
+  // Update hash for key-values
+  auto& kvStoreDb = kvStoreDb_.at(area);
+  kvStoreDb.prepareKeyValsForMerge(keySetParams.keyVals);
+
+  // Create publication and merge it with local KvStore
+  thrift::Publication rcvdPublication;
+  rcvdPublication.keyVals = std::move(keySetParams.keyVals);
+  rcvdPublication.nodeIds_ref().move_from(keySetParams.nodeIds_ref());
+  rcvdPublication.floodRootId_ref().move_from(keySetParams.floodRootId_ref());
+  rcvdPublication.ttlRefreshes_ref().move_from(
+      keySetParams.ttlRefreshes_ref());
+  rcvdPublication.nodeIdsBloom_ref().move_from(
+      keySetParams.nodeIdsBloom_ref());
+  rcvdPublication.originTimestampMs_ref().copy_from(
+      keySetParams.originTimestampMs_ref());
+  rcvdPublication.floodHopCount_ref().copy_from(
+      keySetParams.floodHopCount_ref());
+  kvStoreDb.mergePublication(rcvdPublication);
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::AreasConfig>>
 KvStore::getAreasConfig() {
   folly::Promise<std::unique_ptr<thrift::AreasConfig>> p;
@@ -725,7 +1673,8 @@ KvStore::getKvStorePeerState(
     std::string const& peerName, std::string const& area) {
   folly::Promise<std::optional<KvStorePeerState>> promise;
   auto sf = promise.getSemiFuture();
-  runInEventBaseThread(
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread(
       [this, p = std::move(promise), peerName, area]() mutable {
         if (!kvStoreDb_.count(area)) {
           p.setValue(std::nullopt);
@@ -742,7 +1691,8 @@ folly::SemiFuture<std::unique_ptr<thrift::PeersMap>>
 KvStore::getKvStorePeers(std::string area) {
   folly::Promise<std::unique_ptr<thrift::PeersMap>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this, p = std::move(p), area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this, p = std::move(p), area]() mutable {
     VLOG(2) << "Peer dump requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -758,15 +1708,37 @@ KvStore::getKvStorePeers(std::string area) {
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<KvStore::AreaPeersMaps>>
+KvStore::getKvStorePeersAreas(std::set<std::string> areas) {
+  try {
+    areas = resolveAreas(std::move(areas));
+  } catch (thrift::OpenrError const& ex) {
+    return folly::makeSemiFuture<std::unique_ptr<AreaPeersMaps>>(ex);
+  }
+
+  VLOG(2) << "Peer dump requested for " << areas.size() << " areas";
+  return collectFromAreas<thrift::PeersMap>(
+             areas,
+             [](KvStoreDb& kvStoreDb) {
+               fb303::fbData->addStatValue(
+                   "kvstore.cmd_peer_dump", 1, fb303::COUNT);
+               return kvStoreDb.dumpPeers();
+             })
+      .deferValue([](AreaPeersMaps&& peersMaps) {
+        return std::make_unique<AreaPeersMaps>(std::move(peersMaps));
+      });
+}
+
 folly::SemiFuture<folly::Unit>
 KvStore::addUpdateKvStorePeers(
     thrift::PeerAddParams peerAddParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        peerAddParams = std::move(peerAddParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             peerAddParams = std::move(peerAddParams),
+                             area]() mutable {
     VLOG(2) << "Peer addition requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -790,10 +1762,11 @@ KvStore::deleteKvStorePeers(
     thrift::PeerDelParams peerDelParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        peerDelParams = std::move(peerDelParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             peerDelParams = std::move(peerDelParams),
+                             area]() mutable {
     VLOG(2) << "Peer deletion requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -816,7 +1789,8 @@ folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
 KvStore::getSpanningTreeInfos(std::string area) {
   folly::Promise<std::unique_ptr<thrift::SptInfos>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this, p = std::move(p), area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this, p = std::move(p), area]() mutable {
     VLOG(3) << "FLOOD_TOPO_GET command requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -836,10 +1810,11 @@ KvStore::updateFloodTopologyChild(
     thrift::FloodTopoSetParams floodTopoSetParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        floodTopoSetParams = std::move(floodTopoSetParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             floodTopoSetParams = std::move(floodTopoSetParams),
+                             area]() mutable {
     VLOG(2) << "FLOOD_TOPO_SET command requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -859,10 +1834,11 @@ KvStore::processKvStoreDualMessage(
     thrift::DualMessages dualMessages, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        dualMessages = std::move(dualMessages),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             dualMessages = std::move(dualMessages),
+                             area]() mutable {
     VLOG(2) << "DUAL messages received for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -885,30 +1861,21 @@ KvStore::processKvStoreDualMessage(
 
 folly::SemiFuture<std::map<std::string, int64_t>>
 KvStore::getCounters() {
-  auto pf = folly::makePromiseContract<std::map<std::string, int64_t>>();
-  runInEventBaseThread([this, p = std::move(pf.first)]() mutable {
-    p.setValue(getGlobalCounters());
-  });
-  return std::move(pf.second);
-}
-
-std::map<std::string, int64_t>
-KvStore::getGlobalCounters() const {
-  std::map<std::string, int64_t> flatCounters;
-  for (auto& kvDb : kvStoreDb_) {
-    auto kvDbCounters = kvDb.second.getCounters();
-    // add up counters for same key from all kvStoreDb instances
-    flatCounters = std::accumulate(
-        kvDbCounters.begin(),
-        kvDbCounters.end(),
-        flatCounters,
-        [](std::map<std::string, int64_t>& flatCounters,
-           const std::pair<const std::string, int64_t>& kvDbcounter) {
-          flatCounters[kvDbcounter.first] += kvDbcounter.second;
-          return flatCounters;
-        });
-  }
-  return flatCounters;
+  return collectFromAreas<std::map<std::string, int64_t>>(
+             resolveAreas({}),
+             [](KvStoreDb& kvStoreDb) { return kvStoreDb.getCounters(); })
+      .deferValue(
+          [](std::map<std::string, std::map<std::string, int64_t>>&&
+                 areaCounters) {
+            // add up counters for same key from all kvStoreDb instances
+            std::map<std::string, int64_t> flatCounters;
+            for (auto const& [_, kvDbCounters] : areaCounters) {
+              for (auto const& [key, value] : kvDbCounters) {
+                flatCounters[key] += value;
+              }
+            }
+            return flatCounters;
+          });
 }
 
 //
@@ -1026,18 +1993,14 @@ KvStoreDb::KvStoreDb(
       peerSyncSock_(std::move(peersyncSock)),
       evb_(evb) {
   if (kvParams_.floodRate) {
-    floodLimiter_ = std::make_unique<folly::BasicTokenBucket<>>(
-        kvParams_.floodRate->flood_msg_per_sec,
-        kvParams_.floodRate->flood_msg_burst_size);
-    pendingPublicationTimer_ =
-        folly::AsyncTimeout::make(*evb_->getEvb(), [this]() noexcept {
-          if (!floodLimiter_->consume(1)) {
-            pendingPublicationTimer_->scheduleTimeout(
-                Constants::kFloodPendingPublication);
-            return;
-          }
-          floodBufferedUpdates();
-        });
+    floodPacer_ = std::make_unique<KvStoreFloodPacer>(
+        *kvParams_.floodRate, kvParams_.floodPriorityKeyMarkers);
+    pendingPublicationTimer_ = folly::AsyncTimeout::make(
+        *evb_->getEvb(), [this]() noexcept { floodBufferedUpdates(); });
+  }
+  if (kvParams_.enableSnapshotReads) {
+    snapshot_ =
+        std::make_unique<KvStoreSnapshot>(Constants::kKvStoreSnapshotShards);
   }
 
   LOG(INFO) << "Starting kvstore DB instance for node " << nodeId << " area "
@@ -1046,13 +2009,41 @@ KvStoreDb::KvStoreDb(
   // Attach socket callbacks/schedule events
   attachCallbacks();
 
+  // Flood requests are queued by sendPublicationToPeers() and sent out from
+  // this timer, off the merge of received publications
+  floodQueueTimer_ = folly::AsyncTimeout::make(
+      *evb_->getEvb(), [this]() noexcept { drainFloodQueues(); });
+
   // Hook up timer with cleanupTtlCountdownQueue(). The actual scheduling
   // happens within updateTtlCountdownQueue()
   ttlCountdownTimer_ = folly::AsyncTimeout::make(
       *evb_->getEvb(), [this]() noexcept { cleanupTtlCountdownQueue(); });
 
+  // DUAL output is queued and flushed from this timer, scheduled on the next
+  // event loop iteration
+  dualBatchTimer_ = folly::AsyncTimeout::make(
+      *evb_->getEvb(), [this]() noexcept { flushDualBatch(); });
+
+  for (size_t i = 0; i < kFloodKeyClasses.size(); ++i) {
+    floodLatencyHistograms_[i] = folly::sformat(
+        "kvstore.flood_latency_ms.{}.{}", kFloodKeyClasses[i], area_);
+    floodHopsHistograms_[i] = folly::sformat(
+        "kvstore.flood_hops.{}.{}", kFloodKeyClasses[i], area_);
+    fb303::fbData->addHistogram(
+        floodLatencyHistograms_[i],
+        kFloodLatencyBucketWidthMs,
+        0,
+        kFloodLatencyMaxMs);
+    fb303::fbData->exportHistogramPercentile(
+        floodLatencyHistograms_[i], 50, 95, 99);
+    fb303::fbData->addHistogram(floodHopsHistograms_[i], 1, 0, kFloodHopsMax);
+    fb303::fbData->exportHistogramPercentile(
+        floodHopsHistograms_[i], 50, 95, 99);
+  }
+
   // Initialize stats keys
   fb303::fbData->addStatExportType("kvstore.cmd_hash_dump", fb303::COUNT);
+  fb303::fbData->addStatExportType("kvstore.cmd_hash_get", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_dump", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_get", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_set", fb303::COUNT);
@@ -1060,8 +2051,11 @@ KvStoreDb::KvStoreDb(
   fb303::fbData->addStatExportType("kvstore.cmd_peer_dump", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_per_del", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.expired_key_vals", fb303::SUM);
+  fb303::fbData->addStatExportType("kvstore.expired_originators", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.flood_duration_ms", fb303::AVG);
   fb303::fbData->addStatExportType("kvstore.full_sync_duration_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "kvstore.flood.duplicates_suppressed", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.looped_publications", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.peers.bytes_received", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.peers.bytes_received", fb303::SUM);
@@ -1071,7 +2065,13 @@ KvStoreDb::KvStoreDb(
   fb303::fbData->addStatExportType("kvstore.rate_limit_suppress", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "kvstore.received_dual_messages", fb303::COUNT);
+  fb303::fbData->addStatExportType("kvstore.dual.batch_size", fb303::AVG);
+  fb303::fbData->addStatExportType("kvstore.peer_add_batch_size", fb303::AVG);
+  fb303::fbData->addStatExportType("kvstore.dual.batches_sent", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "kvstore.dual.coalesced_nexthop_changes", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.received_key_vals", fb303::SUM);
+  fb303::fbData->addStatExportType("kvstore.rejected_key_vals", fb303::SUM);
   fb303::fbData->addStatExportType(
       "kvstore.received_publications", fb303::COUNT);
   fb303::fbData->addStatExportType(
@@ -1087,25 +2087,30 @@ KvStoreDb::updateTtlCountdownQueue(const thrift::Publication& publication) {
     const auto& key = kv.first;
     const auto& value = kv.second;
 
-    if (value.ttl != Constants::kTtlInfinity) {
-      TtlCountdownQueueEntry queueEntry;
-      queueEntry.expiryTime = std::chrono::steady_clock::now() +
-          std::chrono::milliseconds(value.ttl);
-      queueEntry.key = key;
-      queueEntry.version = value.version;
-      queueEntry.ttlVersion = value.ttlVersion;
-      queueEntry.originatorId = value.originatorId;
-
-      if ((ttlCountdownQueue_.empty() or
-           (queueEntry.expiryTime <= ttlCountdownQueue_.top().expiryTime)) and
-          ttlCountdownTimer_) {
-        // Reschedule the shorter timeout
-        ttlCountdownTimer_->scheduleTimeout(
-            std::chrono::milliseconds(value.ttl));
-      }
+    if (value.ttl == Constants::kTtlInfinity) {
+      // Key doesn't expire anymore
+      ttlCountdownQueue_.remove(key);
+      continue;
+    }
 
-      ttlCountdownQueue_.push(std::move(queueEntry));
+    TtlCountdownQueueEntry queueEntry;
+    queueEntry.expiryTime = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(value.ttl);
+    queueEntry.key = key;
+    queueEntry.version = value.version;
+    queueEntry.ttlVersion = value.ttlVersion;
+    queueEntry.originatorId = value.originatorId;
+
+    const auto nextExpiryTime = ttlCountdownQueue_.nextExpiryTime();
+    if ((not nextExpiryTime.has_value() or
+         queueEntry.expiryTime <= *nextExpiryTime) and
+        ttlCountdownTimer_) {
+      // Reschedule the shorter timeout
+      ttlCountdownTimer_->scheduleTimeout(std::chrono::milliseconds(value.ttl));
     }
+
+    // Replaces the previous entry of the key (if any) in place
+    ttlCountdownQueue_.schedule(std::move(queueEntry));
   }
 }
 
@@ -1124,9 +2129,68 @@ KvStoreDb::getKeyVals(std::vector<std::string> const& keys) {
       thriftPub.keyVals[key] = it->second;
     }
   }
+  KvStoreValueCompression::decompressAll(thriftPub.keyVals);
   return thriftPub;
 }
 
+thrift::Publication
+KvStoreDb::getKeyHashes(std::vector<std::string> const& keys) {
+  thrift::Publication thriftPub;
+  thriftPub.area_ref() = area_;
+
+  for (auto const& key : keys) {
+    auto it = kvStore_.find(key);
+    if (it == kvStore_.end()) {
+      continue;
+    }
+    addHashEntry(thriftPub, key, it->second);
+  }
+  return thriftPub;
+}
+
+void
+KvStoreDb::prepareKeyValsForMerge(thrift::KeyVals& keyVals) const {
+  for (auto it = keyVals.begin(); it != keyVals.end();) {
+    auto& value = it->second;
+    if (not value.value_ref().has_value()) {
+      // TTL update
+      ++it;
+      continue;
+    }
+
+    if (KvStoreValueCompression::isCompressed(value)) {
+      // Hash of compressed value is computed by the originator. Fall back to
+      // uncompressed value if it is missing
+      if (value.hash_ref().has_value()) {
+        ++it;
+        continue;
+      }
+      if (not KvStoreValueCompression::decompress(value)) {
+        fb303::fbData->addStatValue(
+            "kvstore.value_compression.decompress_failure", 1, fb303::COUNT);
+        it = keyVals.erase(it);
+        continue;
+      }
+    }
+
+    value.hash_ref() =
+        generateHash(value.version, value.originatorId, value.value_ref());
+    if (kvParams_.enableValueCompression and
+        KvStoreValueCompression::shouldCompress(it->first, value)) {
+      const auto size = value.value_ref()->size();
+      if (KvStoreValueCompression::compress(value)) {
+        fb303::fbData->addStatValue(
+            "kvstore.value_compression.compressed", 1, fb303::COUNT);
+        fb303::fbData->addStatValue(
+            "kvstore.value_compression.saved_bytes",
+            size - value.value_ref()->size(),
+            fb303::SUM);
+      }
+    }
+    ++it;
+  }
+}
+
 // dump the entries of my KV store whose keys match the given prefix
 // if prefix is the empty string, the full KV store is dumped
 thrift::Publication
@@ -1135,6 +2199,19 @@ KvStoreDb::dumpAllWithFilters(
   thrift::Publication thriftPub;
   thriftPub.area_ref() = area_;
 
+  if (auto keys = getIndexedKeys(kvFilters, oper)) {
+    for (auto const* key : *keys) {
+      auto const& value = kvStore_.at(*key);
+      const bool match = oper == thrift::FilterOperator::AND
+          ? kvFilters.keyMatchAll(*key, value)
+          : kvFilters.keyMatch(*key, value);
+      if (match) {
+        thriftPub.keyVals.emplace(*key, value);
+      }
+    }
+    return thriftPub;
+  }
+
   switch (oper) {
   case thrift::FilterOperator::AND:
     for (auto const& kv : kvStore_) {
@@ -1152,28 +2229,122 @@ KvStoreDb::dumpAllWithFilters(
       thriftPub.keyVals[kv.first] = kv.second;
     }
   }
-  return thriftPub;
-}
+  return thriftPub;
+}
+
+// dump the hashes of my KV store whose keys match the given prefix
+// if prefix is the empty string, the full hash store is dumped
+thrift::Publication
+KvStoreDb::dumpHashWithFilters(KvStoreFilters const& kvFilters) const {
+  thrift::Publication thriftPub;
+  thriftPub.area_ref() = area_;
+  auto addHash = [&](std::string const& key, thrift::Value const& val) {
+    if (kvFilters.keyMatch(key, val)) {
+      addHashEntry(thriftPub, key, val);
+    }
+  };
+
+  if (auto keys = getIndexedKeys(kvFilters, thrift::FilterOperator::OR)) {
+    for (auto const* key : *keys) {
+      addHash(*key, kvStore_.at(*key));
+    }
+    return thriftPub;
+  }
+
+  for (auto const& kv : kvStore_) {
+    addHash(kv.first, kv.second);
+  }
+  return thriftPub;
+}
+
+thrift::Publication
+KvStoreDb::dumpPageWithFilters(
+    KvStoreFilters const& kvFilters,
+    thrift::FilterOperator oper,
+    std::string const& pageToken,
+    size_t pageSize,
+    bool hashOnly) const {
+  thrift::Publication thriftPub;
+  thriftPub.area_ref() = area_;
+
+  // walk keys in order from the token, one key past the page is looked up to
+  // tell whether next page exists
+  std::string const* lastKey{nullptr};
+  keyIndex_.forEachKeyAfter(pageToken, [&](std::string const& key) {
+    auto const& value = kvStore_.at(key);
+    const bool match = oper == thrift::FilterOperator::AND
+        ? kvFilters.keyMatchAll(key, value)
+        : kvFilters.keyMatch(key, value);
+    if (not match) {
+      return true;
+    }
+    if (thriftPub.keyVals.size() >= pageSize) {
+      thriftPub.nextPageToken_ref() = *lastKey;
+      return false;
+    }
+    if (hashOnly) {
+      addHashEntry(thriftPub, key, value);
+    } else {
+      thriftPub.keyVals.emplace(key, value);
+    }
+    lastKey = &key;
+    return true;
+  });
+  return thriftPub;
+}
+
+std::optional<std::vector<std::string const*>>
+KvStoreDb::getIndexedKeys(
+    KvStoreFilters const& kvFilters, thrift::FilterOperator oper) const {
+  const auto keyPrefixes = kvFilters.getKeyPrefixes();
+  const auto originatorIds = kvFilters.getOrigniatorIdList();
+  if (keyPrefixes.empty() and originatorIds.empty()) {
+    // nothing to narrow down, full scan is as good
+    return std::nullopt;
+  }
+
+  std::vector<std::string> literalPrefixes;
+  for (auto const& keyPrefix : keyPrefixes) {
+    auto literalPrefix = KvStoreKeyIndex::getLiteralPrefix(keyPrefix);
+    if (not literalPrefix.has_value()) {
+      break;
+    }
+    literalPrefixes.emplace_back(std::move(*literalPrefix));
+  }
+  const bool allLiteral = literalPrefixes.size() == keyPrefixes.size();
 
-// dump the hashes of my KV store whose keys match the given prefix
-// if prefix is the empty string, the full hash store is dumped
-thrift::Publication
-KvStoreDb::dumpHashWithFilters(KvStoreFilters const& kvFilters) const {
-  thrift::Publication thriftPub;
-  thriftPub.area_ref() = area_;
-  for (auto const& kv : kvStore_) {
-    if (not kvFilters.keyMatch(kv.first, kv.second)) {
-      continue;
+  std::vector<std::string const*> keys;
+  auto addKey = [&keys](std::string const& key) { keys.emplace_back(&key); };
+  auto addPrefixKeys = [&]() {
+    for (auto const& prefix : literalPrefixes) {
+      keyIndex_.forEachKeyWithPrefix(prefix, addKey);
     }
-    DCHECK(kv.second.hash_ref().has_value());
-    auto& value = thriftPub.keyVals[kv.first];
-    value.version = kv.second.version;
-    value.originatorId = kv.second.originatorId;
-    value.hash_ref().copy_from(kv.second.hash_ref());
-    value.ttl = kv.second.ttl;
-    value.ttlVersion = kv.second.ttlVersion;
+  };
+  auto addOriginatorKeys = [&]() {
+    for (auto const& originatorId : originatorIds) {
+      keyIndex_.forEachKeyWithOriginator(originatorId, addKey);
+    }
+  };
+
+  if (oper == thrift::FilterOperator::AND) {
+    // key must match every attribute, narrow down by any one of them
+    if (not originatorIds.empty()) {
+      addOriginatorKeys();
+    } else if (allLiteral) {
+      addPrefixKeys();
+    } else {
+      return std::nullopt;
+    }
+    return keys;
   }
-  return thriftPub;
+
+  // key can match any attribute, take union of all of them
+  if (not allLiteral) {
+    return std::nullopt;
+  }
+  addPrefixKeys();
+  addOriginatorKeys();
+  return keys;
 }
 
 // dump the keys on which hashes differ from given keyVals
@@ -1227,6 +2398,77 @@ KvStoreDb::dumpDifference(
   return thriftPub;
 }
 
+// Hash-tree based full-sync is done in two rounds:
+//  1) initiator sends its root digest. If it matches with mine, respond with
+//     empty bucket digests, otherwise with all my bucket digests;
+//  2) initiator sends key hashes of mismatched buckets only. Respond with
+//     difference computed against my keys of those buckets;
+std::optional<thrift::Publication>
+KvStoreDb::dumpHashTreeSync(thrift::KeyDumpParams const& params) const {
+  if (auto buckets = params.hashTreeBuckets_ref()) {
+    fb303::fbData->addStatValue(
+        "kvstore.hash_tree_sync.bucket_requests", 1, fb303::COUNT);
+    std::unordered_set<int32_t> bucketSet(buckets->begin(), buckets->end());
+    std::unordered_map<std::string, thrift::Value> myKeyVals;
+    for (auto const& [key, value] : kvStore_) {
+      if (bucketSet.count(KvStoreHashTree::getBucket(key))) {
+        myKeyVals.emplace(key, value);
+      }
+    }
+    if (auto keyValHashes = params.keyValHashes_ref()) {
+      return dumpDifference(myKeyVals, *keyValHashes);
+    }
+    return dumpDifference(myKeyVals, {});
+  }
+
+  if (auto rootDigest = params.hashTreeRootDigest_ref()) {
+    fb303::fbData->addStatValue(
+        "kvstore.hash_tree_sync.digest_requests", 1, fb303::COUNT);
+    thrift::Publication thriftPub;
+    thriftPub.area_ref() = area_;
+    thriftPub.hashTreeBucketDigests_ref() = std::vector<int64_t>{};
+    if (*rootDigest != hashTree_.getRootDigest()) {
+      thriftPub.hashTreeBucketDigests_ref() = hashTree_.getBucketDigests();
+    }
+    return thriftPub;
+  }
+
+  return std::nullopt;
+}
+
+thrift::Publication
+KvStoreDb::dumpWarmStartPublication() {
+  thrift::Publication thriftPub;
+  thriftPub.area_ref() = area_;
+  for (auto const& [key, value] : kvStore_) {
+    if (value.originatorId != kvParams_.nodeId) {
+      thriftPub.keyVals.emplace(key, value);
+    }
+  }
+  updatePublicationTtl(thriftPub, true /* removeAboutToExpire */);
+  return thriftPub;
+}
+
+thrift::Publication
+KvStoreDb::dumpHashInBuckets(std::vector<int32_t> const& buckets) const {
+  thrift::Publication thriftPub;
+  thriftPub.area_ref() = area_;
+  std::unordered_set<int32_t> bucketSet(buckets.begin(), buckets.end());
+  for (auto const& kv : kvStore_) {
+    if (not bucketSet.count(KvStoreHashTree::getBucket(kv.first))) {
+      continue;
+    }
+    DCHECK(kv.second.hash_ref().has_value());
+    auto& value = thriftPub.keyVals[kv.first];
+    value.version = kv.second.version;
+    value.originatorId = kv.second.originatorId;
+    value.hash_ref().copy_from(kv.second.hash_ref());
+    value.ttl = kv.second.ttl;
+    value.ttlVersion = kv.second.ttlVersion;
+  }
+  return thriftPub;
+}
+
 // This function serves the purpose of periodically scanning peers in
 // IDLE state and promote them to SYNCING state. The initial dump will
 // happen in async nature to unblock KvStore to process other requests.
@@ -1235,6 +2477,42 @@ KvStoreDb::requestThriftPeerSync() {
   // minimal timeout for next run
   auto timeout = std::chrono::milliseconds(Constants::kMaxBackoff);
 
+  // KeyDumpParam is built once for all peers of the same flavor, as it can
+  // carry hashes of all keys
+  std::array<std::optional<thrift::KeyDumpParams>, 4> dumpParamsFlavors;
+  auto getDumpParams =
+      [&](thrift::PeerSpec const& peerSpec) -> thrift::KeyDumpParams const& {
+    const bool hashTreeSync =
+        peerSpec.supportHashTreeSync and not kvParams_.filters.has_value();
+    auto& params = dumpParamsFlavors.at(
+        (hashTreeSync ? 2 : 0) + (peerSpec.supportValueCompression ? 1 : 0));
+    if (params.has_value()) {
+      return *params;
+    }
+
+    // build KeyDumpParam
+    params = thrift::KeyDumpParams{};
+    if (kvParams_.filters.has_value()) {
+      std::string keyPrefix =
+          folly::join(",", kvParams_.filters.value().getKeyPrefixes());
+      params->prefix = keyPrefix;
+      params->originatorIds = kvParams_.filters.value().getOrigniatorIdList();
+    }
+    params->supportValueCompression_ref() = peerSpec.supportValueCompression;
+    if (hashTreeSync) {
+      // exchange hash tree digests first, key hashes are sent only for
+      // mismatched buckets
+      params->hashTreeRootDigest_ref() = hashTree_.getRootDigest();
+    } else {
+      KvStoreFilters kvFilters(
+          std::vector<std::string>{}, /* keyPrefixList */
+          std::set<std::string>{} /* originator */);
+      params->keyValHashes_ref() =
+          std::move(dumpHashWithFilters(kvFilters).keyVals);
+    }
+    return *params;
+  };
+
   // Scan over thriftPeers to promote IDLE peers to SYNCING
   for (auto& kv : thriftPeers_) {
     auto& peerName = kv.first; // std::string
@@ -1246,6 +2524,15 @@ KvStoreDb::requestThriftPeerSync() {
       continue;
     }
 
+    // in case pending peer size reaches parallelSyncLimit,
+    // wait until kMaxBackoff before sending next round of sync
+    const auto syncLimit =
+        std::min(parallelSyncLimitOverThrift_, kvParams_.maxParallelFullSyncs);
+    if (thriftPeersInSync_.size() >= syncLimit) {
+      timeout = Constants::kMaxBackoff;
+      break;
+    }
+
     // update the global minimum timeout value for next try
     if (not thriftPeer.expBackoff.canTryNow()) {
       timeout =
@@ -1282,73 +2569,225 @@ KvStoreDb::requestThriftPeerSync() {
     KvStorePeerState oldState = thriftPeer.state;
     thriftPeer.state = getNextState(oldState, KvStorePeerEvent::PEER_ADD);
     logStateTransition(peerName, oldState, thriftPeer.state);
+    ++thriftPeer.syncId;
+    thriftPeer.pendingSyncChunks.clear();
+    thriftPeer.numSyncChunksInFlight = 0;
+    floodQueues_.erase(peerName);
+
+    // send request over thrift client and attach callback
+    sendThriftPeerSync(
+        peerName, getDumpParams(peerSpec), std::chrono::steady_clock::now());
+
+    // put peer into `inSync_` set
+    thriftPeersInSync_.emplace(peerName);
+  } // for loop
+
+  // process the rest after min timeout if NOT scheduled
+  if (not thriftSyncTimer_->isScheduled()) {
+    LOG(INFO) << "Scheduled thrift sync in: " << timeout.count() << " ms.";
+    thriftSyncTimer_->scheduleTimeout(std::chrono::milliseconds(timeout));
+  }
+}
+
+void
+KvStoreDb::sendThriftPeerSync(
+    std::string const& peerName,
+    thrift::KeyDumpParams const& params,
+    std::chrono::steady_clock::time_point startTime) {
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  CHECK(thriftPeer.client);
+
+  auto sf = thriftPeer.client->semifuture_getKvStoreKeyValsFilteredArea(
+      params, area_);
+  const bool isDigestRequest = params.hashTreeRootDigest_ref().has_value();
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this, peerName, startTime, isDigestRequest](
+                     thrift::Publication&& pub) {
+        if (isDigestRequest and pub.hashTreeBucketDigests_ref().has_value()) {
+          // peer stays `in-sync` till response of mismatched buckets
+          processHashTreeDigests(peerName, std::move(pub), startTime);
+          return;
+        }
+
+        // clean up `in-sync` peer collection
+        thriftPeersInSync_.erase(peerName);
+
+        // record time and process SUCCESS state transition
+        auto endTime = std::chrono::steady_clock::now();
+        processThriftSuccess(
+            peerName,
+            std::move(pub),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                endTime - startTime));
+      })
+      .thenError(
+          [this, peerName, startTime](const folly::exception_wrapper& ew) {
+            // clean up `in-sync` peer collection
+            thriftPeersInSync_.erase(peerName);
+
+            // record time and process FAILURE state transition
+            auto endTime = std::chrono::steady_clock::now();
+            processThriftFailure(
+                peerName,
+                ew.what(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    endTime - startTime));
+
+            // counter update
+            fb303::fbData->addStatValue(
+                "kvstore.full_dump_failure", 1, fb303::COUNT);
+          });
+}
+
+// This function will process the bucket digests from peers:
+//  1) Empty digests: both stores are same, full-sync is done;
+//  2) Otherwise send key hashes of mismatched buckets to peer;
+void
+KvStoreDb::processHashTreeDigests(
+    std::string const& peerName,
+    thrift::Publication&& pub,
+    std::chrono::steady_clock::time_point startTime) {
+  // check if it is valid peer(i.e. peer removed in process of syncing)
+  auto peerIt = thriftPeers_.find(peerName);
+  if (peerIt == thriftPeers_.end() or not peerIt->second.client) {
+    LOG(WARNING) << "Received hash tree digests from invalid peer: "
+                 << peerName << ". Ignore.";
+    thriftPeersInSync_.erase(peerName);
+    return;
+  }
+
+  auto const& peerDigests = pub.hashTreeBucketDigests_ref().value();
+  if (peerDigests.empty()) {
+    fb303::fbData->addStatValue(
+        "kvstore.hash_tree_sync.in_sync", 1, fb303::COUNT);
+    thriftPeersInSync_.erase(peerName);
+    pub.hashTreeBucketDigests_ref().reset();
+    processThriftSuccess(
+        peerName,
+        std::move(pub),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime));
+    return;
+  }
+
+  auto buckets = hashTree_.getMismatchedBuckets(peerDigests);
+  fb303::fbData->addStatValue(
+      "kvstore.hash_tree_sync.mismatched_buckets", buckets.size(), fb303::SUM);
+  LOG(INFO) << "[Thrift Sync] Hash tree of peer: " << peerName << " differs "
+            << "in " << buckets.size() << " of " << peerDigests.size()
+            << " buckets.";
+
+  // request mismatched buckets in chunks, so that responses stay bounded in
+  // size and are merged while the rest is transferred. There is always at
+  // least one chunk to complete the full-sync with
+  auto& peer = peerIt->second;
+  peer.pendingSyncChunks.clear();
+  peer.numSyncChunksInFlight = 0;
+  size_t begin = 0;
+  do {
+    const size_t end =
+        std::min(buckets.size(), begin + Constants::kFullSyncChunkBuckets);
+    peer.pendingSyncChunks.emplace_back(
+        buckets.begin() + begin, buckets.begin() + end);
+    begin = end;
+  } while (begin < buckets.size());
+  sendThriftPeerSyncChunks(peerName, startTime);
+}
+
+void
+KvStoreDb::sendThriftPeerSyncChunks(
+    std::string const& peerName,
+    std::chrono::steady_clock::time_point startTime) {
+  auto& peer = thriftPeers_.at(peerName);
+  CHECK(peer.client);
+
+  while (not peer.pendingSyncChunks.empty() and
+         peer.numSyncChunksInFlight < Constants::kFullSyncChunksInFlight) {
+    auto buckets = std::move(peer.pendingSyncChunks.front());
+    peer.pendingSyncChunks.pop_front();
+    ++peer.numSyncChunksInFlight;
 
-    // build KeyDumpParam
     thrift::KeyDumpParams params;
-    if (kvParams_.filters.has_value()) {
-      std::string keyPrefix =
-          folly::join(",", kvParams_.filters.value().getKeyPrefixes());
-      params.prefix = keyPrefix;
-      params.originatorIds = kvParams_.filters.value().getOrigniatorIdList();
-    }
-    KvStoreFilters kvFilters(
-        std::vector<std::string>{}, /* keyPrefixList */
-        std::set<std::string>{} /* originator */);
-    params.keyValHashes_ref() =
-        std::move(dumpHashWithFilters(kvFilters).keyVals);
+    params.keyValHashes_ref() = std::move(dumpHashInBuckets(buckets).keyVals);
+    params.hashTreeBuckets_ref() = std::move(buckets);
+    params.supportValueCompression_ref() =
+        peer.peerSpec.supportValueCompression;
 
-    // send request over thrift client and attach callback
-    auto sf = thriftPeer.client->semifuture_getKvStoreKeyValsFilteredArea(
-        params, area_);
-    auto startTime = std::chrono::steady_clock::now();
+    auto sf =
+        peer.client->semifuture_getKvStoreKeyValsFilteredArea(params, area_);
     std::move(sf)
         .via(evb_->getEvb())
-        .thenValue([this, peerName, startTime](thrift::Publication&& pub) {
+        .thenValue([this, peerName, startTime, syncId = peer.syncId](
+                       thrift::Publication&& pub) {
+          processThriftSyncChunk(peerName, syncId, std::move(pub), startTime);
+        })
+        .thenError([this, peerName, startTime, syncId = peer.syncId](
+                       const folly::exception_wrapper& ew) {
+          // ignore failure of chunks of previous full-sync, or of the rest of
+          // chunks once full-sync has failed
+          auto peerIt = thriftPeers_.find(peerName);
+          if (peerIt == thriftPeers_.end() or
+              peerIt->second.syncId != syncId) {
+            return;
+          }
+          ++peerIt->second.syncId;
+          peerIt->second.pendingSyncChunks.clear();
+          peerIt->second.numSyncChunksInFlight = 0;
+
           // clean up `in-sync` peer collection
           thriftPeersInSync_.erase(peerName);
 
-          // record time and process SUCCESS state transition
+          // record time and process FAILURE state transition
           auto endTime = std::chrono::steady_clock::now();
-          processThriftSuccess(
+          processThriftFailure(
               peerName,
-              std::move(pub),
+              ew.what(),
               std::chrono::duration_cast<std::chrono::milliseconds>(
                   endTime - startTime));
-        })
-        .thenError(
-            [this, peerName, startTime](const folly::exception_wrapper& ew) {
-              // clean up `in-sync` peer collection
-              thriftPeersInSync_.erase(peerName);
-
-              // record time and process FAILURE state transition
-              auto endTime = std::chrono::steady_clock::now();
-              processThriftFailure(
-                  peerName,
-                  ew.what(),
-                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                      endTime - startTime));
-
-              // counter update
-              fb303::fbData->addStatValue(
-                  "kvstore.full_dump_failure", 1, fb303::COUNT);
-            });
 
-    // put peer into `inSync_` set
-    thriftPeersInSync_.emplace(peerName);
+          // counter update
+          fb303::fbData->addStatValue(
+              "kvstore.full_dump_failure", 1, fb303::COUNT);
+        });
+  }
+}
 
-    // in case pending peer size is over parallelSyncLimit,
-    // wait until kMaxBackoff before sending next round of sync
-    if (thriftPeersInSync_.size() > parallelSyncLimitOverThrift_) {
-      timeout = Constants::kMaxBackoff;
-      break;
-    }
-  } // for loop
+void
+KvStoreDb::processThriftSyncChunk(
+    std::string const& peerName,
+    uint64_t syncId,
+    thrift::Publication&& pub,
+    std::chrono::steady_clock::time_point startTime) {
+  auto peerIt = thriftPeers_.find(peerName);
+  if (peerIt == thriftPeers_.end() or peerIt->second.syncId != syncId) {
+    LOG(WARNING) << "Received full-sync chunk of stale sync from peer: "
+                 << peerName << ". Ignore.";
+    return;
+  }
+  fb303::fbData->addStatValue(
+      "kvstore.thrift.full_sync_chunks", 1, fb303::COUNT);
 
-  // process the rest after min timeout if NOT scheduled
-  if (not thriftSyncTimer_->isScheduled()) {
-    LOG(INFO) << "Scheduled thrift sync in: " << timeout.count() << " ms.";
-    thriftSyncTimer_->scheduleTimeout(std::chrono::milliseconds(timeout));
+  auto& peer = peerIt->second;
+  --peer.numSyncChunksInFlight;
+  if (peer.pendingSyncChunks.empty() and peer.numSyncChunksInFlight == 0) {
+    // clean up `in-sync` peer collection
+    thriftPeersInSync_.erase(peerName);
+
+    // record time and process SUCCESS state transition
+    processThriftSuccess(
+        peerName,
+        std::move(pub),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime));
+    return;
   }
+
+  sendThriftPeerSyncChunks(peerName, startTime);
+  const auto kvUpdateCnt = mergePublication(pub);
+  VLOG(2) << "[Thrift Sync] Full-sync chunk received from: " << peerName
+          << " with " << pub.keyVals.size() << " key-vals. Incured "
+          << kvUpdateCnt << " key-value updates.";
 }
 
 // This function will process the full-dump response from peers:
@@ -1390,14 +2829,17 @@ KvStoreDb::processThriftSuccess(
   KvStorePeerState oldState = peer.state;
   peer.state = getNextState(oldState, KvStorePeerEvent::SYNC_RESP_RCVD);
   logStateTransition(peerName, oldState, peer.state);
+  StartupTimeline::get().record("first_kvstore_sync");
+  if (peer.state == KvStorePeerState::INITIALIZED) {
+    processInitialSyncPeer(peerName);
+  }
 
   // Successfully received full-sync response. Double the parallel
   // sync limit. This is to:
   //  1) accelerate the rest of pending full-syncs if any;
   //  2) assume subsequeny sync diff will be small in traffic amount;
   parallelSyncLimitOverThrift_ = std::min(
-      2 * parallelSyncLimitOverThrift_,
-      Constants::kMaxFullSyncPendingCountThreshold);
+      2 * parallelSyncLimitOverThrift_, kvParams_.maxParallelFullSyncs);
 
   // Schedule another round of `thriftSyncTimer_` in case it is
   // NOT scheduled.
@@ -1470,6 +2912,9 @@ KvStoreDb::addThriftPeers(
       peerIter->second.peerSpec = newPeerSpec; // update peerSpec
       peerIter->second.state = KvStorePeerState::IDLE; // set IDLE initially
       peerIter->second.client.reset(); // destruct thriftClient
+      ++peerIter->second.syncId; // ignore responses of ongoing sync
+      thriftPeersInSync_.erase(peerName);
+      floodQueues_.erase(peerName);
     } else {
       // case 2: found a new peer coming up
       LOG(INFO) << "[Peer Add]: " << peerName << " is added."
@@ -1609,6 +3054,9 @@ KvStoreDb::addPeers(
     fullSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
   }
 
+  // peers changed, flood-peers need to be recomputed
+  floodPeersCache_.clear();
+
   // process dual events if any
   if (kvParams_.enableFloodOptimization) {
     for (const auto& peer : dualPeersToAdd) {
@@ -1623,6 +3071,12 @@ folly::Expected<size_t, fbzmq::Error>
 KvStoreDb::sendMessageToPeer(
     const std::string& peerSocketId, const thrift::KvStoreRequest& request) {
   auto msg = fbzmq::Message::fromThriftObj(request, serializer_).value();
+  return sendMessageToPeer(peerSocketId, msg);
+}
+
+folly::Expected<size_t, fbzmq::Error>
+KvStoreDb::sendMessageToPeer(
+    const std::string& peerSocketId, const fbzmq::Message& msg) {
   fb303::fbData->addStatValue(
       "kvstore.peers.bytes_sent", msg.size(), fb303::SUM);
   return peerSyncSock_.sendMultiple(
@@ -1639,6 +3093,37 @@ KvStoreDb::getCounters() const {
   // Add up pending and in-flight full sync
   counters["kvstore.pending_full_sync"] =
       peersToSyncWith_.size() + latestSentPeerSync_.size();
+
+  // Approximate memory held by key-vals of the area
+  size_t kvStoreBytes{0};
+  for (auto const& [key, value] : kvStore_) {
+    kvStoreBytes += getMemoryUsage(key) + getMemoryUsage(value);
+  }
+  counters[getMemoryCounterName("kvstore", area_ + ".kv_store")] =
+      kvStoreBytes;
+  counters[getMemoryCounterName("kvstore", area_ + ".key_index")] =
+      keyIndex_.getMemoryUsage();
+
+  // Depth of flood queue of every peer, including requests in flight
+  auto const addFloodQueueDepth = [&](std::string const& peerName) {
+    auto queueIt = floodQueues_.find(peerName);
+    counters["kvstore.flood.peer_queue_depth." + peerName] =
+        queueIt == floodQueues_.end()
+        ? 0
+        : queueIt->second.requests.size() + queueIt->second.numInFlight;
+  };
+  for (auto const& [peerName, _] : peers_) {
+    addFloodQueueDepth(peerName);
+  }
+  for (auto const& [peerName, _] : thriftPeers_) {
+    addFloodQueueDepth(peerName);
+  }
+  size_t maxFloodQueueDepth{0};
+  for (auto const& [_, queue] : floodQueues_) {
+    maxFloodQueueDepth = std::max(
+        maxFloodQueueDepth, queue.requests.size() + queue.numInFlight);
+  }
+  counters["kvstore.flood.peer_queue_depth"] = maxFloodQueueDepth;
   return counters;
 }
 
@@ -1660,6 +3145,98 @@ KvStoreDb::delThriftPeers(std::vector<std::string> const& peers) {
     // destruct existing thrift client
     peerIter->second.client.reset();
     thriftPeers_.erase(peerIter);
+    thriftPeersInSync_.erase(peerName);
+    floodQueues_.erase(peerName);
+    processInitialSyncPeer(peerName);
+  }
+}
+
+void
+KvStoreDb::processInitialPeersDiscovered() {
+  if (initialSyncPeers_.has_value()) {
+    return;
+  }
+  initialSyncPeers_ = std::unordered_set<std::string>{};
+  if (kvParams_.enableKvStoreThrift) {
+    for (auto const& [peerName, peer] : thriftPeers_) {
+      if (peer.state != KvStorePeerState::INITIALIZED) {
+        initialSyncPeers_->emplace(peerName);
+      }
+    }
+  } else {
+    for (auto const& [peerName, peer] : peers_) {
+      if (peersToSyncWith_.count(peerName) or
+          latestSentPeerSync_.count(peer.second)) {
+        initialSyncPeers_->emplace(peerName);
+      }
+    }
+  }
+  LOG(INFO) << "Initial peers discovered in area: " << area_ << ". Waiting "
+            << "for initial sync with " << initialSyncPeers_->size()
+            << " peers.";
+  // signal right away if there is no peer to wait for
+  processInitialSyncPeer("");
+}
+
+void
+KvStoreDb::processInitialSyncPeer(std::string const& peerName) {
+  if (initialSyncDone_ or not initialSyncPeers_.has_value()) {
+    return;
+  }
+  initialSyncPeers_->erase(peerName);
+  if (not initialSyncPeers_->empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Initial sync completed for area: " << area_;
+  initialSyncDone_ = true;
+  StartupTimeline::get().record("kvstore_initial_sync");
+  thrift::Publication initialSyncPub;
+  initialSyncPub.area_ref() = area_;
+  initialSyncPub.initialSyncDone_ref() = true;
+  publishToSubscribers(initialSyncPub);
+}
+
+void
+KvStoreDb::publishToSubscribers(thrift::Publication const& publication) {
+  kvParams_.kvStoreUpdatesQueue.push(publication);
+
+  // split publication once per subscription, keeping attributes other than
+  // key-values as is
+  auto subscriptions = kvParams_.subscriptions.rlock();
+  for (auto const& subscription : *subscriptions) {
+    if (not subscription->areas.empty() and
+        not subscription->areas.count(area_)) {
+      continue;
+    }
+    thrift::Publication filteredPub;
+    filteredPub.area_ref() = area_;
+    filteredPub.nodeIds_ref().copy_from(publication.nodeIds_ref());
+    filteredPub.floodRootId_ref().copy_from(publication.floodRootId_ref());
+    filteredPub.warmStart_ref().copy_from(publication.warmStart_ref());
+    filteredPub.initialSyncDone_ref().copy_from(
+        publication.initialSyncDone_ref());
+    for (auto const& [key, value] : publication.keyVals) {
+      if (subscription->filters.keyMatch(key, value)) {
+        filteredPub.keyVals.emplace(key, value);
+      }
+    }
+    for (auto const& key : publication.expiredKeys) {
+      if (subscription->filters.keyPrefixMatch(key)) {
+        filteredPub.expiredKeys.emplace_back(key);
+      }
+    }
+    if (not filteredPub.expiredKeys.empty()) {
+      filteredPub.expiredOriginators_ref().copy_from(
+          publication.expiredOriginators_ref());
+    }
+    if (filteredPub.keyVals.empty() and filteredPub.expiredKeys.empty() and
+        not filteredPub.initialSyncDone_ref().value_or(false)) {
+      fb303::fbData->addStatValue(
+          "kvstore.subscription.filtered_publications", 1, fb303::SUM);
+      continue;
+    }
+    subscription->updatesQueue.push(std::move(filteredPub));
   }
 }
 
@@ -1694,13 +3271,18 @@ KvStoreDb::delPeers(std::vector<std::string> const& peers) {
     }
 
     peersToSyncWith_.erase(peerName);
+    floodQueues_.erase(peerName);
     auto const& peerCmdSocketId = it->second.second;
     if (latestSentPeerSync_.count(peerCmdSocketId)) {
       latestSentPeerSync_.erase(peerCmdSocketId);
     }
     peers_.erase(it);
+    processInitialSyncPeer(peerName);
   }
 
+  // peers changed, flood-peers need to be recomputed
+  floodPeersCache_.clear();
+
   // remove dual peers if any
   if (kvParams_.enableFloodOptimization) {
     for (const auto& peer : dualPeersToRemove) {
@@ -1716,22 +3298,16 @@ KvStoreDb::requestFullSyncFromPeers() {
   // minimal timeout for next run
   auto timeout = std::chrono::milliseconds(Constants::kMaxBackoff);
 
-  // Make requests
-  for (auto it = peersToSyncWith_.begin(); it != peersToSyncWith_.end();) {
-    auto& peerName = it->first;
-    auto& expBackoff = it->second;
-
-    if (not expBackoff.canTryNow()) {
-      timeout = std::min(timeout, expBackoff.getTimeRemainingUntilRetry());
-      ++it;
-      continue;
+  // Full-sync request carries hashes of all keys, hence it is built and
+  // serialized once for all peers, indexed by their support for compression
+  std::array<std::optional<fbzmq::Message>, 2> dumpRequestMsgs;
+  auto getDumpRequestMsg =
+      [&](bool supportValueCompression) -> fbzmq::Message const& {
+    auto& msg = dumpRequestMsgs.at(supportValueCompression ? 1 : 0);
+    if (msg.has_value()) {
+      return *msg;
     }
 
-    // Generate and send router-socket id of peer first. If the kvstore of
-    // peer is not connected over the router socket then it will error out
-    // exception and we will retry again.
-    auto const& peerCmdSocketId = peers_.at(peerName).second;
-
     // Build request
     thrift::KvStoreRequest dumpRequest;
     thrift::KeyDumpParams params;
@@ -1747,14 +3323,35 @@ KvStoreDb::requestFullSyncFromPeers() {
     KvStoreFilters kvFilters{keyPrefixList, originator};
     params.keyValHashes_ref() =
         std::move(dumpHashWithFilters(kvFilters).keyVals);
+    params.supportValueCompression_ref() = supportValueCompression;
 
     dumpRequest.cmd = thrift::Command::KEY_DUMP;
-    dumpRequest.keyDumpParams_ref() = params;
+    dumpRequest.keyDumpParams_ref() = std::move(params);
     dumpRequest.area_ref() = area_;
+    msg = fbzmq::Message::fromThriftObj(dumpRequest, serializer_).value();
+    return *msg;
+  };
+
+  // Make requests
+  for (auto it = peersToSyncWith_.begin(); it != peersToSyncWith_.end();) {
+    auto& peerName = it->first;
+    auto& expBackoff = it->second;
+
+    if (not expBackoff.canTryNow()) {
+      timeout = std::min(timeout, expBackoff.getTimeRemainingUntilRetry());
+      ++it;
+      continue;
+    }
+
+    // Generate and send router-socket id of peer first. If the kvstore of
+    // peer is not connected over the router socket then it will error out
+    // exception and we will retry again.
+    auto const& [peerSpec, peerCmdSocketId] = peers_.at(peerName);
 
     VLOG(1) << "Sending full-sync request to peer " << peerName << " using id "
             << peerCmdSocketId;
-    auto const ret = sendMessageToPeer(peerCmdSocketId, dumpRequest);
+    auto const ret = sendMessageToPeer(
+        peerCmdSocketId, getDumpRequestMsg(peerSpec.supportValueCompression));
 
     if (ret.hasError()) {
       // this could be pretty common on initial connection setup
@@ -1820,25 +3417,26 @@ void
 KvStoreDb::updatePublicationTtl(
     thrift::Publication& thriftPub, bool removeAboutToExpire) {
   auto timeNow = std::chrono::steady_clock::now();
-  for (const auto& qE : ttlCountdownQueue_) {
-    // Find key and ensure we are taking time from right entry from queue
-    auto kv = thriftPub.keyVals.find(qE.key);
-    if (kv == thriftPub.keyVals.end() or kv->second.version != qE.version or
-        kv->second.originatorId != qE.originatorId or
-        kv->second.ttlVersion != qE.ttlVersion) {
+  for (auto kv = thriftPub.keyVals.begin(); kv != thriftPub.keyVals.end();) {
+    // Find entry of the key and ensure we are taking time from right entry
+    auto const* qE = ttlCountdownQueue_.find(kv->first);
+    if (not qE or kv->second.version != qE->version or
+        kv->second.originatorId != qE->originatorId or
+        kv->second.ttlVersion != qE->ttlVersion) {
+      ++kv;
       continue;
     }
 
     // Compute timeLeft and do sanity check on it
-    auto timeLeft = duration_cast<milliseconds>(qE.expiryTime - timeNow);
+    auto timeLeft = duration_cast<milliseconds>(qE->expiryTime - timeNow);
     if (timeLeft <= kvParams_.ttlDecr) {
-      thriftPub.keyVals.erase(kv);
+      kv = thriftPub.keyVals.erase(kv);
       continue;
     }
 
     // filter key from publication if time left is below ttl threshold
     if (removeAboutToExpire and timeLeft < Constants::kTtlThreshold) {
-      thriftPub.keyVals.erase(kv);
+      kv = thriftPub.keyVals.erase(kv);
       continue;
     }
 
@@ -1846,6 +3444,7 @@ KvStoreDb::updatePublicationTtl(
     // deterministically whenever it is exchanged between KvStores. This will
     // avoid looping of updates between stores.
     kv->second.ttl = timeLeft.count() - kvParams_.ttlDecr.count();
+    ++kv;
   }
 }
 
@@ -1878,19 +3477,15 @@ KvStoreDb::processRequestMsgHelper(
     }
 
     auto& ketSetParamsVal = thriftReq.keySetParams_ref().value();
-    if (ketSetParamsVal.keyVals.empty()) {
+    if (ketSetParamsVal.keyVals.empty() and
+        (not ketSetParamsVal.ttlRefreshes_ref().has_value() or
+         ketSetParamsVal.ttlRefreshes_ref()->empty())) {
       LOG(ERROR) << "Malformed set request, ignoring";
       return folly::makeUnexpected(fbzmq::Error());
     }
 
     // Update hash for key-values
-    for (auto& kv : ketSetParamsVal.keyVals) {
-      auto& value = kv.second;
-      if (value.value_ref().has_value()) {
-        value.hash_ref() =
-            generateHash(value.version, value.originatorId, value.value_ref());
-      }
-    }
+    prepareKeyValsForMerge(ketSetParamsVal.keyVals);
 
     // Create publication and merge it with local KvStore
     thrift::Publication rcvdPublication;
@@ -1898,6 +3493,14 @@ KvStoreDb::processRequestMsgHelper(
     rcvdPublication.nodeIds_ref().move_from(ketSetParamsVal.nodeIds_ref());
     rcvdPublication.floodRootId_ref().move_from(
         ketSetParamsVal.floodRootId_ref());
+    rcvdPublication.ttlRefreshes_ref().move_from(
+        ketSetParamsVal.ttlRefreshes_ref());
+    rcvdPublication.nodeIdsBloom_ref().move_from(
+        ketSetParamsVal.nodeIdsBloom_ref());
+    rcvdPublication.originTimestampMs_ref().copy_from(
+        ketSetParamsVal.originTimestampMs_ref());
+    rcvdPublication.floodHopCount_ref().copy_from(
+        ketSetParamsVal.floodHopCount_ref());
     mergePublication(rcvdPublication);
 
     // respond to the client
@@ -1920,11 +3523,19 @@ KvStoreDb::processRequestMsgHelper(
     folly::split(",", keyDumpParamsVal.prefix, keyPrefixList, true);
     const auto keyPrefixMatch =
         KvStoreFilters(keyPrefixList, keyDumpParamsVal.originatorIds);
-    auto thriftPub = dumpAllWithFilters(keyPrefixMatch);
-    if (auto keyValHashes = keyDumpParamsVal.keyValHashes_ref()) {
-      thriftPub = dumpDifference(thriftPub.keyVals, *keyValHashes);
+    thrift::Publication thriftPub;
+    if (auto hashTreePub = dumpHashTreeSync(keyDumpParamsVal)) {
+      thriftPub = std::move(hashTreePub.value());
+    } else {
+      thriftPub = dumpAllWithFilters(keyPrefixMatch);
+      if (auto keyValHashes = keyDumpParamsVal.keyValHashes_ref()) {
+        thriftPub = dumpDifference(thriftPub.keyVals, *keyValHashes);
+      }
     }
     updatePublicationTtl(thriftPub);
+    if (not keyDumpParamsVal.supportValueCompression_ref().value_or(false)) {
+      KvStoreValueCompression::decompressAll(thriftPub.keyVals);
+    }
     // I'm the initiator, set flood-root-id
     fromStdOptional(thriftPub.floodRootId_ref(), DualNode::getSptRootId());
 
@@ -2101,6 +3712,25 @@ KvStoreDb::processNexthopChange(
   LOG(INFO) << "dual nexthop change: root-id (" << rootId << ") " << oldNhStr
             << " -> " << newNhStr;
 
+  auto it = pendingNexthopChanges_.find(rootId);
+  if (it == pendingNexthopChanges_.end()) {
+    pendingNexthopChanges_.emplace(rootId, std::make_pair(oldNh, newNh));
+  } else {
+    // nexthop changed again within the batch, keep the first old nexthop
+    it->second.second = newNh;
+    fb303::fbData->addStatValue(
+        "kvstore.dual.coalesced_nexthop_changes", 1, fb303::SUM);
+  }
+  if (not dualBatchTimer_->isScheduled()) {
+    dualBatchTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+  }
+}
+
+void
+KvStoreDb::applyNexthopChange(
+    const std::string& rootId,
+    const std::optional<std::string>& oldNh,
+    const std::optional<std::string>& newNh) noexcept {
   // set new parent if any
   if (newNh.has_value()) {
     // peers_ MUST have this new parent
@@ -2179,6 +3809,7 @@ KvStoreDb::processSyncResponse(
   LOG(INFO) << "full-sync response received from " << requestId << " with "
             << syncPub.keyVals.size() << " key-vals and " << numMissingKeys
             << " missing keys. Incured " << kvUpdateCnt << " key-value updates";
+  StartupTimeline::get().record("first_kvstore_sync");
 
   if (latestSentPeerSync_.count(requestId)) {
     auto syncDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -2191,6 +3822,16 @@ KvStoreDb::processSyncResponse(
     latestSentPeerSync_.erase(requestId);
   }
 
+  // thrift peers complete initial sync on their own state transition
+  if (not kvParams_.enableKvStoreThrift and initialSyncPeers_.has_value()) {
+    for (auto const& [peerName, peer] : peers_) {
+      if (peer.second == requestId) {
+        processInitialSyncPeer(peerName);
+        break;
+      }
+    }
+  }
+
   // We've received a full sync response. Double the parallel sync-request
   // limit. This is under assumption that, subsequent sync request will not
   // incur huge changes.
@@ -2361,25 +4002,49 @@ KvStoreDb::drainPeerSyncSock() {
   } // while
 }
 
+void
+KvStoreDb::updateSnapshot(const thrift::Publication& publication) {
+  if (not snapshot_) {
+    return;
+  }
+  for (auto const& [key, _] : publication.keyVals) {
+    auto it = kvStore_.find(key);
+    if (it == kvStore_.end()) {
+      snapshot_->remove(key);
+      continue;
+    }
+    KvStoreSnapshot::Entry entry{it->second, std::nullopt};
+    auto const* qE = ttlCountdownQueue_.find(key);
+    if (qE and qE->version == it->second.version and
+        qE->originatorId == it->second.originatorId and
+        qE->ttlVersion == it->second.ttlVersion) {
+      entry.expiryTime = qE->expiryTime;
+    }
+    snapshot_->update(key, std::move(entry));
+  }
+  for (auto const& key : publication.expiredKeys) {
+    snapshot_->remove(key);
+  }
+  snapshot_->publish(getSptRootId());
+}
+
 void
 KvStoreDb::cleanupTtlCountdownQueue() {
-  // record all expired keys
+  // record all expired keys, and number of them per originator. Keys of a
+  // node gone down all expire at about the same time
   std::vector<std::string> expiredKeys;
+  std::unordered_map<std::string, size_t> numExpiredKeys;
   auto now = std::chrono::steady_clock::now();
 
-  // Iterate through ttlCountdownQueue_ until the top expires in the future
-  while (not ttlCountdownQueue_.empty()) {
-    auto top = ttlCountdownQueue_.top();
-    if (top.expiryTime > now) {
-      // Nothing in queue worth evicting
-      break;
-    }
+  // Iterate through entries of ttlCountdownQueue_ expired by now
+  for (auto const& top : ttlCountdownQueue_.expire(now)) {
     auto it = kvStore_.find(top.key);
     if (it != kvStore_.end() and it->second.version == top.version and
         it->second.originatorId == top.originatorId and
         it->second.ttlVersion == top.ttlVersion) {
       expiredKeys.emplace_back(top.key);
-      LOG(WARNING)
+      ++numExpiredKeys[top.originatorId];
+      VLOG(2)
           << "Delete expired (key, version, originatorId, ttlVersion, ttl, "
           << "node, area) "
           << folly::sformat(
@@ -2392,16 +4057,27 @@ KvStoreDb::cleanupTtlCountdownQueue() {
                  kvParams_.nodeId,
                  area_);
       logKvEvent("KEY_EXPIRE", top.key);
+      hashTree_.remove(it->first, it->second);
+      keyIndex_.remove(it->first, it->second);
       kvStore_.erase(it);
     }
-    ttlCountdownQueue_.pop();
+  }
+
+  std::vector<std::string> expiredOriginators;
+  for (auto const& [originatorId, numKeys] : numExpiredKeys) {
+    const auto numKeysLeft = keyIndex_.getOriginatorKeyCount(originatorId);
+    LOG(WARNING) << "Deleted " << numKeys << " expired keys of originator "
+                 << originatorId << " in area " << area_ << ", "
+                 << numKeysLeft << " keys of it left";
+    if (numKeysLeft == 0) {
+      expiredOriginators.emplace_back(originatorId);
+    }
   }
 
   // Reschedule based on most recent timeout
-  if (not ttlCountdownQueue_.empty()) {
+  if (auto nextExpiryTime = ttlCountdownQueue_.nextExpiryTime()) {
     ttlCountdownTimer_->scheduleTimeout(
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            ttlCountdownQueue_.top().expiryTime - now));
+        std::chrono::ceil<std::chrono::milliseconds>(*nextExpiryTime - now));
   }
 
   if (expiredKeys.empty()) {
@@ -2410,65 +4086,96 @@ KvStoreDb::cleanupTtlCountdownQueue() {
   }
   fb303::fbData->addStatValue(
       "kvstore.expired_key_vals", expiredKeys.size(), fb303::SUM);
+  fb303::fbData->addStatValue(
+      "kvstore.expired_originators", expiredOriginators.size(), fb303::SUM);
   thrift::Publication expiredKeysPub{};
   expiredKeysPub.expiredKeys = std::move(expiredKeys);
+  if (not expiredOriginators.empty()) {
+    expiredKeysPub.expiredOriginators_ref() = std::move(expiredOriginators);
+  }
+  updateSnapshot(expiredKeysPub);
   floodPublication(std::move(expiredKeysPub));
 }
 
 void
-KvStoreDb::bufferPublication(thrift::Publication&& publication) {
+KvStoreDb::bufferPublication(
+    const std::string& peerName, const thrift::Publication& publication) {
   fb303::fbData->addStatValue("kvstore.rate_limit_suppress", 1, fb303::COUNT);
   fb303::fbData->addStatValue(
       "kvstore.rate_limit_keys", publication.keyVals.size(), fb303::AVG);
-  std::optional<std::string> floodRootId{std::nullopt};
-  if (publication.floodRootId_ref().has_value()) {
-    floodRootId = publication.floodRootId_ref().value();
-  }
-  // update or add keys
+
+  std::vector<size_t> numKeys(floodPacer_->getNumPriorityClasses(), 0);
   for (auto const& kv : publication.keyVals) {
-    publicationBuffer_[floodRootId].emplace(kv.first);
+    ++numKeys.at(floodPacer_->getPriorityClass(kv.first));
   }
-  for (auto const& key : publication.expiredKeys) {
-    publicationBuffer_[floodRootId].emplace(key);
+  for (size_t i = 0; i < numKeys.size(); ++i) {
+    if (numKeys[i]) {
+      fb303::fbData->addStatValue(
+          folly::sformat(
+              "kvstore.flood.{}.buffered_keys",
+              floodPacer_->getPriorityClassName(i)),
+          numKeys[i],
+          fb303::SUM);
+    }
+  }
+
+  floodPacer_->buffer(peerName, publication);
+  if (not pendingPublicationTimer_->isScheduled()) {
+    pendingPublicationTimer_->scheduleTimeout(
+        Constants::kFloodPendingPublication);
   }
 }
 
 void
-KvStoreDb::floodBufferedUpdates() {
-  if (!publicationBuffer_.size()) {
-    return;
+KvStoreDb::setFloodRate(thrift::KvstoreFloodRate const& floodRate) {
+  if (floodPacer_) {
+    floodPacer_->setFloodRate(floodRate);
   }
+}
 
-  // merged-publications to be sent
-  std::vector<thrift::Publication> publications;
+void
+KvStoreDb::floodBufferedUpdates() {
+  for (auto const& peerName : floodPacer_->getPendingPeers()) {
+    if (not peers_.count(peerName) and not thriftPeers_.count(peerName)) {
+      // peer is gone
+      floodPacer_->removePeer(peerName);
+      continue;
+    }
 
-  // merge publication per root-id
-  for (const auto& kv : publicationBuffer_) {
-    thrift::Publication publication{};
-    // convert from std::optional to std::optional
-    std::optional<std::string> floodRootId{std::nullopt};
-    if (kv.first.has_value()) {
-      floodRootId = kv.first.value();
-    }
-    fromStdOptional(publication.floodRootId_ref(), floodRootId);
-    for (const auto& key : kv.second) {
-      auto kvStoreIt = kvStore_.find(key);
-      if (kvStoreIt != kvStore_.end()) {
-        publication.keyVals.emplace(make_pair(key, kvStoreIt->second));
-      } else {
-        publication.expiredKeys.emplace_back(key);
+    // Send buffered keys of higher priority class first, as long as peer's
+    // rate limit allows
+    while (auto pendingKeys = floodPacer_->pop(peerName)) {
+      const auto& className =
+          floodPacer_->getPriorityClassName(pendingKeys->priorityClass);
+      fb303::fbData->addStatValue(
+          folly::sformat("kvstore.flood.{}.buffered_latency_ms", className),
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - pendingKeys->bufferedSince)
+              .count(),
+          fb303::AVG);
+
+      // Build publication out of latest values of the keys. We maintain
+      // orginal-root-id and act as a forwarder, NOT an initiator.
+      thrift::Publication publication{};
+      fromStdOptional(publication.floodRootId_ref(), pendingKeys->floodRootId);
+      for (const auto& key : pendingKeys->keys) {
+        auto kvStoreIt = kvStore_.find(key);
+        if (kvStoreIt != kvStore_.end()) {
+          publication.keyVals.emplace(key, kvStoreIt->second);
+        }
+      }
+      updatePublicationTtl(publication, true);
+      if (publication.keyVals.empty()) {
+        continue;
       }
+      publication.nodeIds_ref() = std::vector<std::string>{kvParams_.nodeId};
+      sendPublicationToPeers(publication, {peerName});
     }
-    publications.emplace_back(std::move(publication));
   }
 
-  publicationBuffer_.clear();
-
-  for (auto& pub : publications) {
-    // when sending out merged publication, we maintain orginal-root-id
-    // we act as a forwarder, NOT an initiator. Disable set-flood-root here
-    floodPublication(
-        std::move(pub), false /* rate-limit */, false /* set-flood-root */);
+  if (floodPacer_->hasPendingKeys()) {
+    pendingPublicationTimer_->scheduleTimeout(
+        Constants::kFloodPendingPublication);
   }
 }
 
@@ -2490,6 +4197,9 @@ KvStoreDb::finalizeFullSync(
   if (not updates.keyVals.size()) {
     return;
   }
+  // NOTE: senderId is socket-id of the peer, hence its support for
+  // compression is unknown
+  KvStoreValueCompression::decompressAll(updates.keyVals);
   VLOG(1) << "finalizeFullSync back to: " << senderId
           << " with keys: " << folly::join(",", keys);
 
@@ -2516,9 +4226,18 @@ KvStoreDb::finalizeFullSync(
   }
 }
 
-std::unordered_set<std::string>
+const std::unordered_set<std::string>&
 KvStoreDb::getFloodPeers(const std::optional<std::string>& rootId) {
-  auto sptPeers = DualNode::getSptPeers(rootId);
+  // reuse flood-peers computed for same SPT-peers (and same peers, cache is
+  // invalidated on peer add/delete)
+  const auto sptPeersVersion = DualNode::getSptPeersVersion(rootId);
+  auto cacheIt = floodPeersCache_.find(rootId);
+  if (cacheIt != floodPeersCache_.end() and
+      cacheIt->second.first == sptPeersVersion) {
+    return cacheIt->second.second;
+  }
+
+  const auto& sptPeers = DualNode::getSptPeers(rootId);
   bool floodToAll = false;
   if (not kvParams_.enableFloodOptimization or sptPeers.empty()) {
     // fall back to naive flooding if feature not enabled or can not find
@@ -2536,7 +4255,9 @@ KvStoreDb::getFloodPeers(const std::optional<std::string>& rootId) {
       floodPeers.emplace(peer);
     }
   }
-  return floodPeers;
+  auto& cache = floodPeersCache_[rootId];
+  cache = std::make_pair(sptPeersVersion, std::move(floodPeers));
+  return cache.second;
 }
 
 void
@@ -2551,18 +4272,6 @@ KvStoreDb::collectSendFailureStats(
 void
 KvStoreDb::floodPublication(
     thrift::Publication&& publication, bool rateLimit, bool setFloodRoot) {
-  // rate limit if configured
-  if (floodLimiter_ && rateLimit && !floodLimiter_->consume(1)) {
-    bufferPublication(std::move(publication));
-    pendingPublicationTimer_->scheduleTimeout(
-        Constants::kFloodPendingPublication);
-    return;
-  }
-  // merge with buffered publication and flood
-  if (publicationBuffer_.size()) {
-    bufferPublication(std::move(publication));
-    return floodBufferedUpdates();
-  }
   // Update ttl on keys we are trying to advertise. Also remove keys which
   // are about to expire.
   updatePublicationTtl(publication, true);
@@ -2584,8 +4293,25 @@ KvStoreDb::floodPublication(
   }
   publication.nodeIds_ref()->emplace_back(kvParams_.nodeId);
 
-  // Flood publication to internal subscribers
-  kvParams_.kvStoreUpdatesQueue.push(publication);
+  // Key-values not received through flood, i.e. set locally or learnt via
+  // full-sync, are originated into the flood by us
+  if (not senderId.has_value() and
+      not publication.originTimestampMs_ref().has_value()) {
+    publication.originTimestampMs_ref() = getUnixTimeStampMs();
+    publication.floodHopCount_ref() = 0;
+  }
+
+  // Flood publication to internal subscribers. Compressed values are
+  // handed over decompressed
+  const bool hasCompressedValues =
+      KvStoreValueCompression::hasCompressedValues(publication.keyVals);
+  if (hasCompressedValues) {
+    auto localPublication = publication;
+    KvStoreValueCompression::decompressAll(localPublication.keyVals);
+    publishToSubscribers(localPublication);
+  } else {
+    publishToSubscribers(publication);
+  }
 
   // Flood keyValue ONLY updates to external neighbors
   if (publication.keyVals.empty()) {
@@ -2594,9 +4320,81 @@ KvStoreDb::floodPublication(
 
   if (setFloodRoot and not senderId.has_value()) {
     // I'm the initiator, set flood-root-id
+    const auto rootIds = kvParams_.enableMultiRootFlooding
+        ? DualNode::getSptRootIds()
+        : std::vector<std::string>{};
+    if (rootIds.size() > 1) {
+      // Split keys across SPTs of all ready roots. Hash of key picks the
+      // root, so that updates of a key follow the same SPT
+      std::vector<thrift::Publication> rootPublications(rootIds.size());
+      for (auto& kv : publication.keyVals) {
+        const auto index = std::hash<std::string>{}(kv.first) % rootIds.size();
+        rootPublications[index].keyVals.emplace(kv.first, std::move(kv.second));
+      }
+      for (size_t i = 0; i < rootIds.size(); ++i) {
+        auto& rootPublication = rootPublications[i];
+        if (rootPublication.keyVals.empty()) {
+          continue;
+        }
+        rootPublication.nodeIds_ref().copy_from(publication.nodeIds_ref());
+        rootPublication.nodeIdsBloom_ref().copy_from(
+            publication.nodeIdsBloom_ref());
+        rootPublication.area_ref().copy_from(publication.area_ref());
+        rootPublication.originTimestampMs_ref().copy_from(
+            publication.originTimestampMs_ref());
+        rootPublication.floodHopCount_ref().copy_from(
+            publication.floodHopCount_ref());
+        rootPublication.floodRootId_ref() = rootIds[i];
+        floodPublicationToPeers(rootPublication, senderId, rateLimit);
+      }
+      return;
+    }
     fromStdOptional(publication.floodRootId_ref(), DualNode::getSptRootId());
   }
 
+  floodPublicationToPeers(publication, senderId, rateLimit);
+}
+
+void
+KvStoreDb::floodPublicationToPeers(
+    const thrift::Publication& publication,
+    const std::optional<std::string>& senderId,
+    bool rateLimit) {
+  std::optional<std::string> floodRootId{std::nullopt};
+  if (publication.floodRootId_ref().has_value()) {
+    floodRootId = publication.floodRootId_ref().value();
+    fb303::fbData->addStatValue(
+        folly::sformat("kvstore.flood_root.{}.num_keys", *floodRootId),
+        publication.keyVals.size(),
+        fb303::SUM);
+  }
+  std::vector<std::string> peers;
+  for (const auto& peerName : getFloodPeers(floodRootId)) {
+    if (senderId.has_value() && senderId.value() == peerName) {
+      // Do not flood towards senderId from whom we received this publication
+      continue;
+    }
+    // rate limit if configured. Publication is buffered for the peer
+    if (floodPacer_ && rateLimit && !floodPacer_->trySend(peerName)) {
+      bufferPublication(peerName, publication);
+      continue;
+    }
+    peers.emplace_back(peerName);
+  }
+
+  sendPublicationToPeers(publication, peers);
+}
+
+void
+KvStoreDb::sendPublicationToPeers(
+    const thrift::Publication& publication,
+    const std::vector<std::string>& floodPeers) {
+  if (floodPeers.empty()) {
+    return;
+  }
+  const bool hasCompressedValues =
+      KvStoreValueCompression::hasCompressedValues(publication.keyVals);
+
   // prepare thrift structure for flooding purpose
   thrift::KvStoreRequest floodRequest;
   thrift::KeySetParams params;
@@ -2607,20 +4405,102 @@ KvStoreDb::floodPublication(
   params.nodeIds_ref().copy_from(publication.nodeIds_ref());
   params.floodRootId_ref().copy_from(publication.floodRootId_ref());
   params.timestamp_ms_ref() = getUnixTimeStampMs();
+  params.originTimestampMs_ref().copy_from(publication.originTimestampMs_ref());
+  if (auto hops = publication.floodHopCount_ref()) {
+    params.floodHopCount_ref() = *hops + 1;
+  }
 
   floodRequest.cmd = thrift::Command::KEY_SET;
   floodRequest.keySetParams_ref() = params;
   floodRequest.area_ref() = area_;
 
-  std::optional<std::string> floodRootId{std::nullopt};
-  if (params.floodRootId_ref().has_value()) {
-    floodRootId = params.floodRootId_ref().value();
-  }
-  const auto& floodPeers = getFloodPeers(floodRootId);
+  // Flavors of flood request depending on the capabilities of the peer, built
+  // lazily. Compressed values are decompressed for peers not supporting them,
+  // TTL updates are batched for peers supporting compact TTL refreshes and
+  // traversed nodes are summarized in bloom filter for peers supporting it.
+  const bool hasTtlUpdates = std::any_of(
+      params.keyVals.cbegin(), params.keyVals.cend(), [](auto const& kv) {
+        return not kv.second.value_ref().has_value();
+      });
+  const bool hasNodeIds = params.nodeIds_ref().has_value() and
+      not params.nodeIds_ref()->empty();
+  std::array<std::optional<thrift::KeySetParams>, 8> paramsFlavors;
+  std::array<std::optional<thrift::KvStoreRequest>, 8> floodRequestFlavors;
+  auto getFlavor = [&](thrift::PeerSpec const& peerSpec) -> size_t {
+    const bool decompress =
+        hasCompressedValues and not peerSpec.supportValueCompression;
+    const bool batchTtl = hasTtlUpdates and peerSpec.supportTtlRefreshBatch;
+    const bool nodeIdsBloom = hasNodeIds and peerSpec.supportNodeIdsBloom;
+    return (nodeIdsBloom ? 4 : 0) + (decompress ? 2 : 0) + (batchTtl ? 1 : 0);
+  };
+  auto getParams =
+      [&](thrift::PeerSpec const& peerSpec) -> thrift::KeySetParams const& {
+    const auto flavor = getFlavor(peerSpec);
+    if (flavor == 0) {
+      return params;
+    }
+    auto& flavorParams = paramsFlavors.at(flavor);
+    if (not flavorParams.has_value()) {
+      flavorParams = params;
+      if (flavor & 2) {
+        KvStoreValueCompression::decompressAll(flavorParams->keyVals);
+      }
+      if (flavor & 1) {
+        flavorParams->ttlRefreshes_ref() =
+            KvStore::batchTtlRefreshes(flavorParams->keyVals);
+      }
+      if (flavor & 4) {
+        // bloom filter received along with the publication, if any, covers
+        // nodes before the ones in `nodeIds`. Peer only needs the last node
+        // in `nodeIds` to not flood back
+        auto& nodeIds = *flavorParams->nodeIds_ref();
+        auto bloom = publication.nodeIdsBloom_ref().value_or(
+            KvStoreNodeIdsBloom::create());
+        for (auto const& nodeId : nodeIds) {
+          KvStoreNodeIdsBloom::add(bloom, nodeId);
+        }
+        flavorParams->nodeIdsBloom_ref() = std::move(bloom);
+        nodeIds.erase(nodeIds.begin(), nodeIds.end() - 1);
+      }
+    }
+    return *flavorParams;
+  };
+  auto getFloodRequest =
+      [&](thrift::PeerSpec const& peerSpec) -> thrift::KvStoreRequest const& {
+    const auto flavor = getFlavor(peerSpec);
+    if (flavor == 0) {
+      return floodRequest;
+    }
+    auto& flavorRequest = floodRequestFlavors.at(flavor);
+    if (not flavorRequest.has_value()) {
+      flavorRequest = floodRequest;
+      flavorRequest->keySetParams_ref() = getParams(peerSpec);
+    }
+    return *flavorRequest;
+  };
+
+  // Flood requests are built once per flavor and shared by the peers:
+  //  1) Over thrift peer connection, as KeySetParams;
+  //  2) Over ZMQ socket, serialized once;
+  std::array<std::optional<PendingFlood>, 8> floodFlavors;
+  auto getFlood = [&](thrift::PeerSpec const& peerSpec) -> PendingFlood const& {
+    auto& flood = floodFlavors.at(getFlavor(peerSpec));
+    if (not flood.has_value()) {
+      flood = PendingFlood{};
+      flood->numKeyVals = publication.keyVals.size();
+      if (kvParams_.enableKvStoreThrift) {
+        flood->params =
+            std::make_shared<const thrift::KeySetParams>(getParams(peerSpec));
+      } else {
+        flood->msg = std::make_shared<const fbzmq::Message>(
+            fbzmq::Message::fromThriftObj(
+                getFloodRequest(peerSpec), serializer_)
+                .value());
+      }
+    }
+    return *flood;
+  };
 
-  // ATTN: KvStore maintains different ways of flooding mechanism.
-  //  1) Over thrift peer connection;
-  //  2) Over ZMQ socket;
   if (kvParams_.enableKvStoreThrift) {
     for (const auto& peerName : floodPeers) {
       auto peerIt = thriftPeers_.find(peerName);
@@ -2629,48 +4509,14 @@ KvStoreDb::floodPublication(
         continue;
       }
 
-      if (senderId.has_value() && senderId.value() == peerName) {
-        // Do not flood towards senderId from whom we received this publication
-        continue;
-      }
-
-      auto& thriftPeer = thriftPeers_.at(peerName);
+      auto& thriftPeer = peerIt->second;
       if (thriftPeer.state != KvStorePeerState::INITIALIZED or
           (not thriftPeer.client)) {
         // peer in thriftPeers can still in the process of initial full-sync.
         // Skip flooding to those peers.
         continue;
       }
-
-      auto sf = thriftPeer.client->semifuture_setKvStoreKeyVals(params, area_);
-      auto startTime = std::chrono::steady_clock::now();
-      std::move(sf)
-          .via(evb_->getEvb())
-          .thenValue([peerName, startTime](folly::Unit&&) {
-            VLOG(4) << "Flooding ack received from peer: " << peerName;
-
-            // record time and process SUCCESS state transition
-            auto endTime = std::chrono::steady_clock::now();
-            fb303::fbData->addStatValue(
-                "kvstore.flood_duration_ms_thrift",
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                    endTime - startTime)
-                    .count(),
-                fb303::AVG);
-          })
-          .thenError(
-              [this, peerName, startTime](const folly::exception_wrapper& ew) {
-                // record time and process SUCCESS state transition
-                auto endTime = std::chrono::steady_clock::now();
-                processThriftFailure(
-                    peerName,
-                    ew.what(),
-                    std::chrono::duration_cast<std::chrono::milliseconds>(
-                        endTime - startTime));
-
-                fb303::fbData->addStatValue(
-                    "kvstore.flood_thrift_failure", 1, fb303::COUNT);
-              });
+      enqueueFlood(peerName, getFlood(thriftPeer.peerSpec));
     }
 
     fb303::fbData->addStatValue(
@@ -2681,66 +4527,323 @@ KvStoreDb::floodPublication(
         fb303::SUM);
   } else {
     for (const auto& peer : floodPeers) {
-      if (senderId.has_value() && senderId.value() == peer) {
-        // Do not flood towards senderId from whom we received this publication
+      auto peerIt = peers_.find(peer);
+      if (peerIt == peers_.end()) {
+        LOG(ERROR) << "Invalid flooding peer: " << peer << ". Skip it.";
         continue;
       }
-      VLOG(4) << "Forwarding publication, received from: "
-              << (senderId.has_value() ? senderId.value() : "N/A")
-              << ", to: " << peer << ", via: " << kvParams_.nodeId;
+      enqueueFlood(peer, getFlood(peerIt->second.first));
+    }
+  }
+}
 
-      fb303::fbData->addStatValue("kvstore.sent_publications", 1, fb303::COUNT);
-      fb303::fbData->addStatValue(
-          "kvstore.sent_key_vals", publication.keyVals.size(), fb303::SUM);
-
-      // Send flood request
-      auto const& peerCmdSocketId = peers_.at(peer).second;
-      auto const ret = sendMessageToPeer(peerCmdSocketId, floodRequest);
-      if (ret.hasError()) {
-        // this could be pretty common on initial connection setup
-        LOG(ERROR) << "Failed to flood publication to peer " << peer
-                   << " using id " << peerCmdSocketId
-                   << ", error: " << ret.error();
-        collectSendFailureStats(ret.error(), peerCmdSocketId);
+void
+KvStoreDb::enqueueFlood(
+    std::string const& peerName, PendingFlood const& flood) {
+  auto& queue = floodQueues_[peerName];
+  if (queue.requests.size() >= Constants::kFloodQueueMaxDepth) {
+    // peer can't keep up with flooding. Drop its queued updates and full-sync
+    // with it instead, which covers them
+    LOG(WARNING) << "Flood queue of peer: " << peerName << " is full with "
+                 << queue.requests.size() << " requests. Full-sync instead.";
+    fb303::fbData->addStatValue(
+        "kvstore.flood.queue_overflows", 1, fb303::COUNT);
+    floodQueues_.erase(peerName);
+    if (kvParams_.enableKvStoreThrift) {
+      processThriftFailure(
+          peerName, "flood queue overflow", std::chrono::milliseconds(0));
+    } else {
+      peersToSyncWith_.emplace(
+          peerName,
+          ExponentialBackoff<std::chrono::milliseconds>(
+              Constants::kInitialBackoff, Constants::kMaxBackoff));
+      if (not fullSyncTimer_->isScheduled()) {
+        fullSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+      }
+    }
+    return;
+  }
+
+  queue.requests.emplace_back(flood);
+  // send out after the ongoing merge, from next event loop iteration. Thrift
+  // floods wait for the batch interval to be coalesced
+  if (not floodQueueTimer_->isScheduled()) {
+    floodQueueTimer_->scheduleTimeout(
+        kvParams_.enableKvStoreThrift ? kvParams_.floodBatchInterval
+                                      : std::chrono::milliseconds(0));
+  }
+}
+
+void
+KvStoreDb::drainFloodQueues() {
+  bool retry{false};
+  for (auto it = floodQueues_.begin(); it != floodQueues_.end();) {
+    auto const& peerName = it->first;
+    auto& queue = it->second;
+
+    if (kvParams_.enableKvStoreThrift) {
+      auto peerIt = thriftPeers_.find(peerName);
+      if (peerIt == thriftPeers_.end() or
+          peerIt->second.state != KvStorePeerState::INITIALIZED or
+          not peerIt->second.client) {
+        // queued updates are covered by the next full-sync with the peer
+        queue.requests.clear();
+      }
+      while (not queue.requests.empty() and
+             queue.numInFlight < Constants::kFloodMaxInFlight) {
+        ++queue.numInFlight;
+        sendFloodOverThrift(peerName, popCoalescedFlood(queue.requests));
+      }
+    } else {
+      auto peerIt = peers_.find(peerName);
+      if (peerIt == peers_.end()) {
+        LOG(ERROR) << "Invalid flooding peer: " << peerName << ". Skip it.";
+        queue.requests.clear();
+      }
+      while (not queue.requests.empty()) {
+        auto const& flood = queue.requests.front();
+        auto const& peerCmdSocketId = peerIt->second.second;
+        VLOG(4) << "Forwarding publication to: " << peerName
+                << ", via: " << kvParams_.nodeId;
+
+        // Send flood request
+        auto const ret = sendMessageToPeer(peerCmdSocketId, *flood.msg);
+        if (ret.hasError() and ret.error().errNum == EAGAIN) {
+          // socket is full, keep the rest queued
+          retry = true;
+          break;
+        }
+        fb303::fbData->addStatValue(
+            "kvstore.sent_publications", 1, fb303::COUNT);
+        fb303::fbData->addStatValue(
+            "kvstore.sent_key_vals", flood.numKeyVals, fb303::SUM);
+        if (ret.hasError()) {
+          // this could be pretty common on initial connection setup
+          LOG(ERROR) << "Failed to flood publication to peer " << peerName
+                     << " using id " << peerCmdSocketId
+                     << ", error: " << ret.error();
+          collectSendFailureStats(ret.error(), peerCmdSocketId);
+        }
+        queue.requests.pop_front();
+      }
+    }
+
+    if (queue.requests.empty() and queue.numInFlight == 0) {
+      it = floodQueues_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (retry and not floodQueueTimer_->isScheduled()) {
+    floodQueueTimer_->scheduleTimeout(Constants::kFloodRetryInterval);
+  }
+}
+
+KvStoreDb::PendingFlood
+KvStoreDb::popCoalescedFlood(std::deque<PendingFlood>& requests) {
+  auto flood = std::move(requests.front());
+  requests.pop_front();
+
+  std::optional<thrift::KeySetParams> coalesced;
+  size_t numCoalesced{0};
+  while (not requests.empty()) {
+    auto const& next = *requests.front().params;
+    auto const& params = coalesced.has_value() ? *coalesced : *flood.params;
+    // only requests flooded along the same path can be merged, as the path
+    // is what the peer uses to avoid flooding back
+    if (params.ttlRefreshes_ref().has_value() or
+        next.ttlRefreshes_ref().has_value() or
+        params.nodeIds_ref() != next.nodeIds_ref() or
+        params.nodeIdsBloom_ref() != next.nodeIdsBloom_ref() or
+        params.originTimestampMs_ref().has_value() !=
+            next.originTimestampMs_ref().has_value() or
+        params.floodRootId_ref() != next.floodRootId_ref()) {
+      break;
+    }
+    // TTL update of a key can only be merged into the same version of it
+    bool mergeable{true};
+    for (auto const& [key, value] : next.keyVals) {
+      auto it = params.keyVals.find(key);
+      if (it != params.keyVals.end() and not value.value_ref().has_value() and
+          (it->second.version != value.version or
+           it->second.originatorId != value.originatorId)) {
+        mergeable = false;
+        break;
+      }
+    }
+    if (not mergeable) {
+      break;
+    }
+
+    if (not coalesced.has_value()) {
+      coalesced = *flood.params;
+    }
+    for (auto const& [key, value] : next.keyVals) {
+      auto [it, inserted] = coalesced->keyVals.emplace(key, value);
+      if (inserted) {
+        continue;
+      }
+      if (value.value_ref().has_value()) {
+        it->second = value;
+      } else if (value.ttlVersion > it->second.ttlVersion) {
+        it->second.ttl = value.ttl;
+        it->second.ttlVersion = value.ttlVersion;
       }
     }
+    coalesced->timestamp_ms_ref().copy_from(next.timestamp_ms_ref());
+    // keep the earliest origination and the longest path, latency is then
+    // reported conservatively
+    if (auto origin = next.originTimestampMs_ref()) {
+      coalesced->originTimestampMs_ref() =
+          std::min(*coalesced->originTimestampMs_ref(), *origin);
+      coalesced->floodHopCount_ref() = std::max(
+          coalesced->floodHopCount_ref().value_or(0),
+          next.floodHopCount_ref().value_or(0));
+    }
+    requests.pop_front();
+    ++numCoalesced;
+  }
+
+  if (coalesced.has_value()) {
+    flood.numKeyVals = coalesced->keyVals.size();
+    flood.params =
+        std::make_shared<const thrift::KeySetParams>(std::move(*coalesced));
+    fb303::fbData->addStatValue(
+        "kvstore.flood.coalesced_requests", numCoalesced, fb303::SUM);
   }
+  return flood;
+}
+
+void
+KvStoreDb::sendFloodOverThrift(
+    std::string const& peerName, PendingFlood const& flood) {
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  auto sf = thriftPeer.client->semifuture_setKvStoreKeyVals(
+      *flood.params, area_);
+  auto startTime = std::chrono::steady_clock::now();
+
+  // ack of the request frees up its slot in flood queue of the peer, unless
+  // peer has been re-synced since
+  auto processAck = [this, peerName, syncId = thriftPeer.syncId]() {
+    auto peerIt = thriftPeers_.find(peerName);
+    auto queueIt = floodQueues_.find(peerName);
+    if (peerIt == thriftPeers_.end() or peerIt->second.syncId != syncId or
+        queueIt == floodQueues_.end() or queueIt->second.numInFlight == 0) {
+      return;
+    }
+    --queueIt->second.numInFlight;
+    if (not floodQueueTimer_->isScheduled()) {
+      floodQueueTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+    }
+  };
+
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([peerName, startTime, processAck](folly::Unit&&) {
+        VLOG(4) << "Flooding ack received from peer: " << peerName;
+        processAck();
+
+        // record time and process SUCCESS state transition
+        auto endTime = std::chrono::steady_clock::now();
+        fb303::fbData->addStatValue(
+            "kvstore.flood_duration_ms_thrift",
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                endTime - startTime)
+                .count(),
+            fb303::AVG);
+      })
+      .thenError([this, peerName, startTime, processAck](
+                     const folly::exception_wrapper& ew) {
+        processAck();
+
+        // record time and process SUCCESS state transition
+        auto endTime = std::chrono::steady_clock::now();
+        processThriftFailure(
+            peerName,
+            ew.what(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                endTime - startTime));
+
+        fb303::fbData->addStatValue(
+            "kvstore.flood_thrift_failure", 1, fb303::COUNT);
+      });
 }
 
 size_t
 KvStoreDb::mergePublication(
     const thrift::Publication& rcvdPublication,
     std::optional<std::string> senderId) {
+  size_t ttlRefreshCnt{0};
+  if (auto ttlRefreshes = rcvdPublication.ttlRefreshes_ref()) {
+    for (auto const& batch : *ttlRefreshes) {
+      ttlRefreshCnt += batch.refreshes.size();
+    }
+  }
+
   // Add counters
   fb303::fbData->addStatValue("kvstore.received_publications", 1, fb303::COUNT);
   fb303::fbData->addStatValue(
       "kvstore.received_key_vals", rcvdPublication.keyVals.size(), fb303::SUM);
+  fb303::fbData->addStatValue(
+      "kvstore.received_ttl_refreshes", ttlRefreshCnt, fb303::SUM);
 
   const bool needFinalizeFullSync = senderId.has_value() and
       rcvdPublication.tobeUpdatedKeys_ref().has_value() and
       not rcvdPublication.tobeUpdatedKeys_ref()->empty();
 
   // This can happen when KvStore is emitting expired-key updates
-  if (rcvdPublication.keyVals.empty() and not needFinalizeFullSync) {
+  if (rcvdPublication.keyVals.empty() and ttlRefreshCnt == 0 and
+      not needFinalizeFullSync) {
     return 0;
   }
 
   // Check for loop
   const auto nodeIds = rcvdPublication.nodeIds_ref();
-  if (nodeIds.has_value() and
-      std::find(nodeIds->begin(), nodeIds->end(), kvParams_.nodeId) !=
-          nodeIds->end()) {
+  const auto nodeIdsBloom = rcvdPublication.nodeIdsBloom_ref();
+  if ((nodeIds.has_value() and
+       std::find(nodeIds->begin(), nodeIds->end(), kvParams_.nodeId) !=
+           nodeIds->end()) or
+      (nodeIdsBloom.has_value() and
+       KvStoreNodeIdsBloom::mayContain(*nodeIdsBloom, kvParams_.nodeId))) {
     fb303::fbData->addStatValue("kvstore.looped_publications", 1, fb303::COUNT);
     return 0;
   }
 
+  // Drop duplicate deliveries of flooded key-values before merge
+  const auto dedupPublication = dedupFloodedPublication(rcvdPublication);
+  const auto& keyVals = dedupPublication.has_value()
+      ? dedupPublication->keyVals
+      : rcvdPublication.keyVals;
+
   // Generate delta with local KvStore
   thrift::Publication deltaPublication;
   deltaPublication.keyVals = KvStore::mergeKeyValues(
-      kvStore_, rcvdPublication.keyVals, kvParams_.filters);
+      kvStore_,
+      keyVals,
+      kvParams_.filters,
+      &hashTree_,
+      &keyIndex_,
+      kvParams_.mergeExecutor.get(),
+      kvParams_.limits);
+  if (ttlRefreshCnt) {
+    // TTL refreshes skip value comparison. They are announced as regular TTL
+    // updates
+    auto ttlUpdates = KvStore::mergeTtlRefreshes(
+        kvStore_, *rcvdPublication.ttlRefreshes_ref());
+    for (auto& [key, ttlUpdate] : ttlUpdates) {
+      auto [it, inserted] = deltaPublication.keyVals.emplace(key, ttlUpdate);
+      if (not inserted) {
+        // key is also updated through key-values
+        it->second.ttl = ttlUpdate.ttl;
+        it->second.ttlVersion = ttlUpdate.ttlVersion;
+      }
+    }
+  }
   deltaPublication.floodRootId_ref().copy_from(
       rcvdPublication.floodRootId_ref());
   deltaPublication.area_ref() = area_;
+  deltaPublication.warmStart_ref().copy_from(rcvdPublication.warmStart_ref());
 
   const size_t kvUpdateCnt = deltaPublication.keyVals.size();
   fb303::fbData->addStatValue(
@@ -2750,9 +4853,17 @@ KvStoreDb::mergePublication(
   if (rcvdPublication.nodeIds_ref().has_value()) {
     deltaPublication.nodeIds_ref().copy_from(rcvdPublication.nodeIds_ref());
   }
+  deltaPublication.nodeIdsBloom_ref().copy_from(
+      rcvdPublication.nodeIdsBloom_ref());
+  deltaPublication.originTimestampMs_ref().copy_from(
+      rcvdPublication.originTimestampMs_ref());
+  deltaPublication.floodHopCount_ref().copy_from(
+      rcvdPublication.floodHopCount_ref());
+  recordFloodLatency(rcvdPublication, deltaPublication.keyVals);
 
   // Update ttl values of keys
   updateTtlCountdownQueue(deltaPublication);
+  updateSnapshot(deltaPublication);
 
   if (not deltaPublication.keyVals.empty()) {
     // Flood change to all of our neighbors/subscribers
@@ -2772,34 +4883,97 @@ KvStoreDb::mergePublication(
   return kvUpdateCnt;
 }
 
+std::optional<thrift::Publication>
+KvStoreDb::dedupFloodedPublication(
+    const thrift::Publication& rcvdPublication) {
+  // Only flooded publications carry nodeIds, full-sync responses and local
+  // updates are always merged
+  const auto nodeIds = rcvdPublication.nodeIds_ref();
+  if (not nodeIds.has_value() or nodeIds->empty()) {
+    return std::nullopt;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<const std::string*> duplicateKeys;
+  for (const auto& [key, value] : rcvdPublication.keyVals) {
+    const auto fingerprint = getFloodFingerprint(key, value);
+    if (not fingerprint.has_value()) {
+      continue;
+    }
+    auto it = recentFloods_.find(*fingerprint);
+    if (it != recentFloods_.end() and
+        now - it->second < Constants::kFloodDedupWindow) {
+      duplicateKeys.emplace_back(&key);
+      continue;
+    }
+    recentFloods_.set(*fingerprint, now);
+  }
+  if (duplicateKeys.empty()) {
+    return std::nullopt;
+  }
+
+  fb303::fbData->addStatValue(
+      "kvstore.flood.duplicates_suppressed",
+      duplicateKeys.size(),
+      fb303::SUM);
+  fb303::fbData->addStatValue(
+      folly::sformat("kvstore.flood.duplicates_suppressed.{}", nodeIds->back()),
+      duplicateKeys.size(),
+      fb303::SUM);
+
+  thrift::Publication dedupPublication;
+  if (duplicateKeys.size() == rcvdPublication.keyVals.size()) {
+    return dedupPublication;
+  }
+  dedupPublication.keyVals = rcvdPublication.keyVals;
+  for (const auto* key : duplicateKeys) {
+    dedupPublication.keyVals.erase(*key);
+  }
+  return dedupPublication;
+}
+
+void
+KvStoreDb::recordFloodLatency(
+    const thrift::Publication& rcvdPublication,
+    const thrift::KeyVals& updatedKeyVals) {
+  const auto origin = rcvdPublication.originTimestampMs_ref();
+  if (not origin.has_value()) {
+    return;
+  }
+  // clocks of nodes are not in sync, clamp skew to zero latency
+  const auto latencyMs = std::max<int64_t>(0, getUnixTimeStampMs() - *origin);
+  const auto hops = rcvdPublication.floodHopCount_ref().value_or(0);
+  for (auto const& [key, value] : updatedKeyVals) {
+    // TTL updates don't change key-value, they are not what converges
+    if (not value.value_ref().has_value()) {
+      continue;
+    }
+    const auto keyClass = getFloodKeyClass(key);
+    fb303::fbData->addHistogramValue(
+        floodLatencyHistograms_[keyClass], latencyMs);
+    fb303::fbData->addHistogramValue(floodHopsHistograms_[keyClass], hops);
+  }
+}
+
 void
 KvStoreDb::logSyncEvent(
     const std::string& peerNodeName,
     const std::chrono::milliseconds syncDuration) {
-  fbzmq::LogSample sample{};
-  sample.addString("event", "KVSTORE_FULL_SYNC");
-  sample.addString("node_name", kvParams_.nodeId);
-  sample.addString("neighbor", peerNodeName);
-  sample.addInt("duration_ms", syncDuration.count());
-
-  fbzmq::thrift::EventLog eventLog;
-  eventLog.category = Constants::kEventLogCategory.toString();
-  eventLog.samples = {sample.toJson()};
-  kvParams_.zmqMonitorClient->addEventLog(std::move(eventLog));
+  EventLogger::Event event;
+  event.event = "KVSTORE_FULL_SYNC";
+  event.strings.emplace_back("node_name", kvParams_.nodeId);
+  event.strings.emplace_back("neighbor", peerNodeName);
+  event.ints.emplace_back("duration_ms", syncDuration.count());
+  kvParams_.eventLogger->log(std::move(event));
 }
 
 void
 KvStoreDb::logKvEvent(const std::string& event, const std::string& key) {
-  fbzmq::LogSample sample{};
-
-  sample.addString("event", event);
-  sample.addString("node_name", kvParams_.nodeId);
-  sample.addString("key", key);
-
-  fbzmq::thrift::EventLog eventLog;
-  eventLog.category = Constants::kEventLogCategory.toString();
-  eventLog.samples = {sample.toJson()};
-  kvParams_.zmqMonitorClient->addEventLog(std::move(eventLog));
+  EventLogger::Event kvEvent;
+  kvEvent.event = event;
+  kvEvent.strings.emplace_back("node_name", kvParams_.nodeId);
+  kvEvent.strings.emplace_back("key", key);
+  kvParams_.eventLogger->log(std::move(kvEvent));
 }
 
 bool
@@ -2809,25 +4983,62 @@ KvStoreDb::sendDualMessages(
     LOG(ERROR) << "fail to send dual messages to " << neighbor << ", not exist";
     return false;
   }
-  const auto& neighborCmdSocketId = peers_.at(neighbor).second;
-  thrift::KvStoreRequest dualRequest;
-  dualRequest.cmd = thrift::Command::DUAL;
-  dualRequest.dualMessages_ref() = msgs;
-  dualRequest.area_ref() = area_;
-  const auto ret = sendMessageToPeer(neighborCmdSocketId, dualRequest);
-  // NOTE: we rely on zmq (on top of tcp) to reliably deliver message,
-  // if we switch to other protocols, we need to make sure its reliability.
-  // Due to zmq async fashion, in case of failure (means the other side
-  // is going down), it's ok to lose this pending message since later on,
-  // neighor will inform us it's gone. and we will delete it from our dual
-  // peers.
-  if (ret.hasError()) {
-    LOG(ERROR) << "failed to send dual messages to " << neighbor << " using id "
-               << neighborCmdSocketId << ", error: " << ret.error();
-    collectSendFailureStats(ret.error(), neighborCmdSocketId);
-    return false;
+  auto& batch = pendingDualMessages_[neighbor];
+  batch.srcId = msgs.srcId;
+  batch.messages.insert(
+      batch.messages.end(), msgs.messages.begin(), msgs.messages.end());
+  if (not dualBatchTimer_->isScheduled()) {
+    dualBatchTimer_->scheduleTimeout(std::chrono::milliseconds(0));
   }
   return true;
 }
 
+void
+KvStoreDb::flushDualBatch() noexcept {
+  // nexthop changes first, as when they were applied right away while
+  // processing dual messages
+  auto nexthopChanges = std::move(pendingNexthopChanges_);
+  pendingNexthopChanges_.clear();
+  for (auto const& [rootId, change] : nexthopChanges) {
+    auto const& [oldNh, newNh] = change;
+    if (oldNh == newNh) {
+      // changed back within the batch
+      continue;
+    }
+    applyNexthopChange(rootId, oldNh, newNh);
+  }
+
+  auto dualMessages = std::move(pendingDualMessages_);
+  pendingDualMessages_.clear();
+  for (auto& [neighbor, msgs] : dualMessages) {
+    if (peers_.count(neighbor) == 0) {
+      // peer went down since, it's been removed from dual peers as well
+      LOG(ERROR) << "fail to send dual messages to " << neighbor
+                 << ", not exist";
+      continue;
+    }
+    const auto& neighborCmdSocketId = peers_.at(neighbor).second;
+    fb303::fbData->addStatValue(
+        "kvstore.dual.batch_size", msgs.messages.size(), fb303::AVG);
+    fb303::fbData->addStatValue("kvstore.dual.batches_sent", 1, fb303::COUNT);
+    thrift::KvStoreRequest dualRequest;
+    dualRequest.cmd = thrift::Command::DUAL;
+    dualRequest.dualMessages_ref() = std::move(msgs);
+    dualRequest.area_ref() = area_;
+    const auto ret = sendMessageToPeer(neighborCmdSocketId, dualRequest);
+    // NOTE: we rely on zmq (on top of tcp) to reliably deliver message,
+    // if we switch to other protocols, we need to make sure its reliability.
+    // Due to zmq async fashion, in case of failure (means the other side
+    // is going down), it's ok to lose this pending message since later on,
+    // neighor will inform us it's gone. and we will delete it from our dual
+    // peers.
+    if (ret.hasError()) {
+      LOG(ERROR) << "failed to send dual messages to " << neighbor
+                 << " using id " << neighborCmdSocketId
+                 << ", error: " << ret.error();
+      collectSendFailureStats(ret.error(), neighborCmdSocketId);
+    }
+  }
+}
+
 } // namespace openr
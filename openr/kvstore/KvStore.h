@@ -7,34 +7,49 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 
-#include <boost/heap/priority_queue.hpp>
 #include <boost/serialization/strong_typedef.hpp>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Optional.h>
-#include <folly/TokenBucket.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/EventLogger.h>
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrClient.h>
 #include <openr/common/OpenrEventBase.h>
 #include <openr/common/Types.h>
 #include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
 #include <openr/dual/Dual.h>
 #include <openr/if/gen-cpp2/Dual_types.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/if/gen-cpp2/OpenrConfig_types.h>
+#include <openr/kvstore/KvStoreFloodPacer.h>
+#include <openr/kvstore/KvStoreHashTree.h>
+#include <openr/kvstore/KvStoreKeyIndex.h>
+#include <openr/kvstore/KvStoreNodeIdsBloom.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
+#include <openr/kvstore/KvStoreTtlWheel.h>
+#include <openr/kvstore/KvStoreValueCompression.h>
 #include <openr/messaging/ReplicateQueue.h>
 
 namespace openr {
@@ -61,24 +76,6 @@ enum class KvStorePeerEvent {
   THRIFT_API_ERROR = 4,
 };
 
-struct TtlCountdownQueueEntry {
-  std::chrono::steady_clock::time_point expiryTime;
-  std::string key;
-  int64_t version{0};
-  int64_t ttlVersion{0};
-  std::string originatorId;
-  bool
-  operator>(TtlCountdownQueueEntry other) const {
-    return expiryTime > other.expiryTime;
-  }
-};
-
-using TtlCountdownQueue = boost::heap::priority_queue<
-    TtlCountdownQueueEntry,
-    // Always returns smallest first
-    boost::heap::compare<std::greater<TtlCountdownQueueEntry>>,
-    boost::heap::stable<true>>;
-
 class KvStoreFilters {
  public:
   // takes the list of comma separated key prefixes to match,
@@ -93,6 +90,10 @@ class KvStoreFilters {
   // Check if key matches all the filters
   bool keyMatchAll(std::string const& key, thrift::Value const& value) const;
 
+  // Check if key matches key prefixes, when value (and hence originator) is
+  // unknown e.g. for expired keys
+  bool keyPrefixMatch(std::string const& key) const;
+
   // return comma separeated string prefix
   std::vector<std::string> getKeyPrefixes() const;
 
@@ -113,13 +114,40 @@ class KvStoreFilters {
   KeyPrefix keyPrefixObjList_;
 };
 
+// Limits of key-values accepted into KvStoreDb of an area, per originator and
+// in total, so that a single misbehaving node can't exhaust memory of every
+// KvStore in the area. Bytes count keys and values. 0 means unlimited
+struct KvStoreLimits {
+  size_t maxKeysPerOriginator{0};
+  size_t maxBytesPerOriginator{0};
+  size_t maxKeys{0};
+  size_t maxBytes{0};
+};
+
+// KvStore updates are shared by all readers of KvStore updates queue instead
+// of being copied for each of them, as publication can be large on full-sync
+using KvStorePublication = std::shared_ptr<const thrift::Publication>;
+
+// Subscription of an internal reader to KvStore updates. It only gets
+// key-values matching filters, in given areas (all if empty), so that readers
+// caring for a few keys aren't woken up with copy of every publication
+struct KvStoreSubscription {
+  KvStoreSubscription(
+      KvStoreFilters filters, std::unordered_set<std::string> areas)
+      : filters(std::move(filters)), areas(std::move(areas)) {}
+
+  KvStoreFilters filters;
+  std::unordered_set<std::string> areas;
+  messaging::ReplicateQueue<KvStorePublication> updatesQueue;
+};
+
 // structure for common params across all instances of KvStoreDb
 struct KvStoreParams {
   // the name of this node (unique in domain)
   std::string nodeId;
 
   // Queue for publishing KvStore updates to other modules within a process
-  messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<KvStorePublication>& kvStoreUpdatesQueue;
 
   // socket for remote & local commands
   fbzmq::Socket<ZMQ_ROUTER, fbzmq::ZMQ_SERVER> globalCmdSock;
@@ -134,17 +162,40 @@ struct KvStoreParams {
   std::chrono::seconds dbSyncInterval;
   // KvStore key filters
   std::optional<KvStoreFilters> filters;
+  // limits of key-values accepted into KvStoreDb of each area
+  std::optional<KvStoreLimits> limits;
   // Kvstore flooding rate
   std::optional<thrift::KvstoreFloodRate> floodRate;
+  // key markers of flooding priority classes in priority order, when rate
+  // limited
+  std::vector<std::string> floodPriorityKeyMarkers{
+      Constants::kAdjDbMarker.toString(),
+      Constants::kPrefixDbMarker.toString()};
   // TTL decrement factor
   std::chrono::milliseconds ttlDecr{Constants::kTtlDecrement};
   bool enableFloodOptimization{false};
   bool isFloodRoot{false};
-  std::shared_ptr<fbzmq::ZmqMonitorClient> zmqMonitorClient{nullptr};
+  // split originated keys across SPTs of all ready flood roots
+  bool enableMultiRootFlooding{false};
+  // compress adjacency and prefix databases set on this KvStore
+  bool enableValueCompression{false};
+  // maintain snapshot of KvStoreDb for reads off KvStore thread
+  bool enableSnapshotReads{false};
+  // workers deciding merge of large publications, shared by all areas
+  std::shared_ptr<folly::CPUThreadPoolExecutor> mergeExecutor{nullptr};
+  // max number of peers full-synced over thrift concurrently
+  size_t maxParallelFullSyncs{Constants::kMaxFullSyncPendingCountThreshold};
+  // latency budget of coalescing floods to thrift peers
+  std::chrono::milliseconds floodBatchInterval{0};
+  // filtered subscriptions of internal readers to KvStore updates
+  folly::Synchronized<std::vector<std::unique_ptr<KvStoreSubscription>>>
+      subscriptions;
+  // ships event logs of all KvStoreDb instances off their threads
+  std::shared_ptr<EventLogger> eventLogger{nullptr};
 
   KvStoreParams(
       std::string nodeid,
-      messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+      messaging::ReplicateQueue<KvStorePublication>& kvStoreUpdatesQueue,
       fbzmq::Socket<ZMQ_ROUTER, fbzmq::ZMQ_SERVER> globalCmdSock,
       // ZMQ high water mark
       int zmqhwm,
@@ -196,9 +247,17 @@ class KvStoreDb : public DualNode {
   // Extracts the counters
   std::map<std::string, int64_t> getCounters() const;
 
-  // get multiple keys at once
+  // get multiple keys at once. Values are decompressed
   thrift::Publication getKeyVals(std::vector<std::string> const& keys);
 
+  // get hashes of multiple keys at once, without their values
+  thrift::Publication getKeyHashes(std::vector<std::string> const& keys);
+
+  // update hashes of key-values received in KEY_SET request and compress
+  // values if enabled. Hash of already compressed value is kept as it covers
+  // uncompressed content.
+  void prepareKeyValsForMerge(thrift::KeyVals& keyVals) const;
+
   // dump the entries of my KV store whose keys match the given prefix
   // if prefix is the empty sting, the full KV store is dumped
   thrift::Publication dumpAllWithFilters(
@@ -210,11 +269,47 @@ class KvStoreDb : public DualNode {
   thrift::Publication dumpHashWithFilters(
       KvStoreFilters const& kvFilters) const;
 
+  // dump one page of at most `pageSize` entries matching the filters (only
+  // hashes of them if `hashOnly`), in key order starting after `pageToken`.
+  // `nextPageToken` is set in the publication if matching keys are left
+  thrift::Publication dumpPageWithFilters(
+      KvStoreFilters const& kvFilters,
+      thrift::FilterOperator oper,
+      std::string const& pageToken,
+      size_t pageSize,
+      bool hashOnly) const;
+
   // dump the keys on which hashes differ from given keyVals
   thrift::Publication dumpDifference(
       std::unordered_map<std::string, thrift::Value> const& myKeyVal,
       std::unordered_map<std::string, thrift::Value> const& reqKeyVal) const;
 
+  // serve hash-tree based full-sync request (see KeyDumpParams). Returns
+  // std::nullopt if request is not a hash-tree based one
+  std::optional<thrift::Publication> dumpHashTreeSync(
+      thrift::KeyDumpParams const& params) const;
+
+  // dump the hashes of my KV store whose keys belong to given buckets
+  thrift::Publication dumpHashInBuckets(
+      std::vector<int32_t> const& buckets) const;
+
+  // dump key-values, except the ones originated by this node, with
+  // time-left as ttl for warm start snapshot
+  thrift::Publication dumpWarmStartPublication();
+
+  // snapshot of KV store readable from any thread, nullptr if snapshot
+  // reads are not enabled
+  std::shared_ptr<const KvStoreSnapshot::Snapshot>
+  getSnapshot() const {
+    return snapshot_ ? snapshot_->get() : nullptr;
+  }
+
+  // hash tree of KV store
+  KvStoreHashTree const&
+  getHashTree() const {
+    return hashTree_;
+  }
+
   // Merge received publication with local store and publish out the delta.
   // If senderId is set, will build <key:value> map from kvStore_ and
   // rcvdPublication.tobeUpdatedKeys and send back to senderId to update it
@@ -223,6 +318,18 @@ class KvStoreDb : public DualNode {
       thrift::Publication const& rcvdPublication,
       std::optional<std::string> senderId = std::nullopt);
 
+  // Drop key-values of flooded publication, which were flooded to us within
+  // Constants::kFloodDedupWindow already, and remember the rest.
+  // @return: publication with duplicates removed, if there were any
+  std::optional<thrift::Publication> dedupFloodedPublication(
+      thrift::Publication const& rcvdPublication);
+
+  // Record origination-to-merge latency and hop count of key-values of
+  // received publication which updated local store, per class of key
+  void recordFloodLatency(
+      thrift::Publication const& rcvdPublication,
+      thrift::KeyVals const& updatedKeyVals);
+
   // update Time to expire filed in Publication
   // removeAboutToExpire: knob to remove keys which are about to expire
   // and hence do not want to include them. Constants::kTtlThreshold
@@ -232,6 +339,9 @@ class KvStoreDb : public DualNode {
   // add new peers to sync with
   void addPeers(std::unordered_map<std::string, thrift::PeerSpec> const& peers);
 
+  // change flood rate of peers, if flooding is rate limited
+  void setFloodRate(thrift::KvstoreFloodRate const& floodRate);
+
   // thrift flavor of peer adding
   void addThriftPeers(
       std::unordered_map<std::string, thrift::PeerSpec> const& peers);
@@ -242,9 +352,18 @@ class KvStoreDb : public DualNode {
   // thrift flavor of peer deletion
   void delThriftPeers(std::vector<std::string> const& peers);
 
+  // peers added so far are the initial ones. Once all of them complete their
+  // first full-sync (or are removed), initial sync of the area is signaled to
+  // local subscribers with `initialSyncDone` publication
+  void processInitialPeersDiscovered();
+
   // dump all peers we are subscribed to
   thrift::PeersMap dumpPeers();
 
+  // Publish to internal readers of all KvStore updates, and filtered part
+  // of it to subscriptions
+  void publishToSubscribers(thrift::Publication const& publication);
+
   // util funtion to fetch KvStorePeerState
   std::optional<KvStorePeerState> getCurrentState(std::string const& peerName);
 
@@ -277,6 +396,40 @@ class KvStoreDb : public DualNode {
   // method to scan over thriftPeers to send full-dump request
   void requestThriftPeerSync();
 
+  // keys of kvStore_ which could match the filters, looked up from keyIndex_.
+  // Keys may repeat and must still be matched against the filters. Returns
+  // std::nullopt if filters can't be served from the index
+  std::optional<std::vector<std::string const*>> getIndexedKeys(
+      KvStoreFilters const& kvFilters, thrift::FilterOperator oper) const;
+
+  // send full-sync request to peer and attach callbacks to process response
+  void sendThriftPeerSync(
+      std::string const& peerName,
+      thrift::KeyDumpParams const& params,
+      std::chrono::steady_clock::time_point startTime);
+
+  // util function to process bucket digests received from peer in first
+  // round of hash-tree based full-sync
+  void processHashTreeDigests(
+      std::string const& peerName,
+      thrift::Publication&& pub,
+      std::chrono::steady_clock::time_point startTime);
+
+  // request pending bucket chunks of hash-tree based full-sync from peer, up
+  // to kFullSyncChunksInFlight at a time
+  void sendThriftPeerSyncChunks(
+      std::string const& peerName,
+      std::chrono::steady_clock::time_point startTime);
+
+  // util function to process chunk of hash-tree based full-sync. Next chunk
+  // is requested before merging this one, so that merge overlaps with its
+  // transfer. Full-sync succeeds with processing of the last chunk
+  void processThriftSyncChunk(
+      std::string const& peerName,
+      uint64_t syncId,
+      thrift::Publication&& pub,
+      std::chrono::steady_clock::time_point startTime);
+
   // util function to process when sync response received
   void processThriftSuccess(
       std::string const& peerName,
@@ -289,11 +442,21 @@ class KvStoreDb : public DualNode {
       folly::fbstring const& exceptionStr,
       std::chrono::milliseconds timeDelta);
 
-  // send dual messages over syncSock
+  // queue dual messages towards neighbor, sent out by flushDualBatch()
   bool sendDualMessages(
       const std::string& neighbor,
       const thrift::DualMessages& msgs) noexcept override;
 
+  // apply nexthop changes and send out dual messages queued during the event
+  // loop iteration: a single DUAL request per neighbor across all roots
+  void flushDualBatch() noexcept;
+
+  // set new spt-parent and unset old one for a given root-id
+  void applyNexthopChange(
+      const std::string& rootId,
+      const std::optional<std::string>& oldNh,
+      const std::optional<std::string>& newNh) noexcept;
+
   // send topology-set command to peer, peer will set/unset me as child
   // rootId: action will applied on given rootId
   // peerName: peer name
@@ -317,7 +480,8 @@ class KvStoreDb : public DualNode {
   // unset child on all rootIds
   void unsetChildAll(const std::string& peerName) noexcept;
 
-  // callbacks when nexthop changed for a given root-id
+  // callbacks when nexthop changed for a given root-id, applied by
+  // flushDualBatch() once per root
   void processNexthopChange(
       const std::string& rootId,
       const std::optional<std::string>& oldNh,
@@ -326,7 +490,8 @@ class KvStoreDb : public DualNode {
   // get flooding peers for a given spt-root-id
   // if rootId is none => flood to all physical peers
   // else only flood to formed SPT-peers for rootId
-  std::unordered_set<std::string> getFloodPeers(
+  // flood-peers are cached per root-id until SPT-peers or peers change
+  const std::unordered_set<std::string>& getFloodPeers(
       const std::optional<std::string>& rootId);
 
   // collect router-client send failure statistics in following form
@@ -346,6 +511,10 @@ class KvStoreDb : public DualNode {
   // and Reschedule ttl expiry timer if needed
   void updateTtlCountdownQueue(const thrift::Publication& publication);
 
+  // update snapshot with keys updated/expired in the publication, and
+  // publish it
+  void updateSnapshot(const thrift::Publication& publication);
+
   // periodically count down and purge expired keys from CountdownQueue
   void cleanupTtlCountdownQueue();
 
@@ -358,6 +527,13 @@ class KvStoreDb : public DualNode {
       bool rateLimit = true,
       bool setFloodRoot = true);
 
+  // flood publication to peers of its flood-root SPT (or all peers)
+  // senderId => peer from whom publication was received, if any
+  void floodPublicationToPeers(
+      const thrift::Publication& publication,
+      const std::optional<std::string>& senderId,
+      bool rateLimit);
+
   // perform last step as a 3-way full-sync request
   // full-sync initiator sends back key-val to senderId (where we made
   // full-sync request to) who need to update those keys
@@ -382,16 +558,53 @@ class KvStoreDb : public DualNode {
   // Submit events to monitor
   void logKvEvent(const std::string& event, const std::string& key);
 
-  // buffer publications blocked by the rate limiter
-  void bufferPublication(thrift::Publication&& publication);
+  // buffer publication blocked by the rate limiter of the peer
+  void bufferPublication(
+      const std::string& peerName, const thrift::Publication& publication);
 
-  // flood pending update blocked by rate limiter
+  // flood pending updates blocked by rate limiter, higher priority first
   void floodBufferedUpdates(void);
 
+  // Send publication to the given peers, in the flavor supported by each.
+  // Flood requests are queued per peer and sent out by drainFloodQueues()
+  void sendPublicationToPeers(
+      const thrift::Publication& publication,
+      const std::vector<std::string>& floodPeers);
+
+  // flood request queued for peers. Serialized (ZMQ) or built (thrift) once
+  // per flavor and shared by all peers it is queued for
+  struct PendingFlood {
+    std::shared_ptr<const fbzmq::Message> msg{nullptr};
+    std::shared_ptr<const thrift::KeySetParams> params{nullptr};
+    size_t numKeyVals{0};
+  };
+
+  // queue flood request for the peer and schedule sending it out. Peer is
+  // full-synced instead if its queue is full
+  void enqueueFlood(std::string const& peerName, PendingFlood const& flood);
+
+  // send queued flood requests to every peer, as many as the peer accepts:
+  // until its ZMQ socket is full, or up to kFloodMaxInFlight thrift requests
+  // not acked yet
+  void drainFloodQueues();
+
+  // pop flood requests from the front of the queue, coalesced into one as
+  // long as they carry the same flooding path and their key-values can be
+  // merged in order
+  PendingFlood popCoalescedFlood(std::deque<PendingFlood>& requests);
+
+  // send flood request to initialized thrift peer, and process its ack
+  void sendFloodOverThrift(
+      std::string const& peerName, PendingFlood const& flood);
+
   // Send message via socket
   folly::Expected<size_t, fbzmq::Error> sendMessageToPeer(
       const std::string& peerSocketId, const thrift::KvStoreRequest& request);
 
+  // Send request serialized once for multiple peers via socket
+  folly::Expected<size_t, fbzmq::Error> sendMessageToPeer(
+      const std::string& peerSocketId, const fbzmq::Message& msg);
+
   //
   // Private variables
   //
@@ -436,6 +649,14 @@ class KvStoreDb : public DualNode {
 
     // thrift client for this peer
     std::unique_ptr<thrift::OpenrCtrlCppAsyncClient> client{nullptr};
+
+    // id of the ongoing full-sync, responses of previous ones are ignored
+    uint64_t syncId{0};
+
+    // bucket chunks of hash-tree based full-sync yet to be requested, and
+    // number of chunk requests in flight
+    std::deque<std::vector<int32_t>> pendingSyncChunks;
+    size_t numSyncChunksInFlight{0};
   };
 
   // Thrift peers collection for KvStore to sync with
@@ -444,6 +665,15 @@ class KvStoreDb : public DualNode {
   // Pending thrift in-sync peers
   std::unordered_set<std::string> thriftPeersInSync_;
 
+  // initial peers yet to complete their first full-sync, known once initial
+  // peers are discovered, and whether initial sync has been signaled
+  std::optional<std::unordered_set<std::string>> initialSyncPeers_;
+  bool initialSyncDone_{false};
+
+  // peer completed full-sync or was removed, signal initial sync if it was
+  // the last initial peer
+  void processInitialSyncPeer(std::string const& peerName);
+
   // The peers we will be talking to: both PUB and CMD URLs for each. We use
   // peerAddCounter_ to uniquely identify a peering session's socket-id.
   uint64_t peerAddCounter_{0};
@@ -452,6 +682,15 @@ class KvStoreDb : public DualNode {
       std::pair<thrift::PeerSpec, std::string /* socket-id */>>
       peers_;
 
+  // cached flood-peers per flood-root-id, along with version of SPT-peers
+  // they are computed from
+  std::unordered_map<
+      std::optional<std::string> /* flood-root-id */,
+      std::pair<
+          uint64_t /* spt-peers-version */,
+          std::unordered_set<std::string>>>
+      floodPeersCache_;
+
   // set of peers to perform full sync from. We use exponential backoff to try
   // repetitively untill we succeeed (without overwhelming anyone with too
   // many requests).
@@ -467,8 +706,17 @@ class KvStoreDb : public DualNode {
   // store keys mapped to (version, originatoId, value)
   std::unordered_map<std::string, thrift::Value> kvStore_;
 
-  // TTL count down queue
-  TtlCountdownQueue ttlCountdownQueue_;
+  // hash tree summarizing kvStore_ for full-sync
+  KvStoreHashTree hashTree_;
+
+  // secondary index of kvStore_ keys for filtered dumps
+  KvStoreKeyIndex keyIndex_;
+
+  // TTL count down queue, with at most one entry per key
+  KvStoreTtlWheel ttlCountdownQueue_;
+
+  // copy-on-write snapshot of kvStore_ for reads off KvStore thread
+  std::unique_ptr<KvStoreSnapshot> snapshot_;
 
   // TTL count down timer
   std::unique_ptr<folly::AsyncTimeout> ttlCountdownTimer_;
@@ -481,12 +729,49 @@ class KvStoreDb : public DualNode {
       std::chrono::time_point<std::chrono::steady_clock>>
       latestSentPeerSync_;
 
-  // Kvstore rate limiter
-  std::unique_ptr<folly::BasicTokenBucket<>> floodLimiter_{nullptr};
+  // Kvstore rate limiter, pacing flooding towards each peer
+  std::unique_ptr<KvStoreFloodPacer> floodPacer_{nullptr};
+
+  // outbound flood requests of a peer, sent in order
+  struct FloodQueue {
+    std::deque<PendingFlood> requests;
+    // thrift flood requests not acked yet
+    size_t numInFlight{0};
+  };
+  std::unordered_map<std::string /* peerName */, FloodQueue> floodQueues_;
+
+  // key-values flooded to us recently, keyed by their flood fingerprint,
+  // with time of the last delivery. Used to drop duplicate deliveries
+  // received over redundant flooding paths without a full merge
+  folly::EvictingCacheMap<uint64_t, std::chrono::steady_clock::time_point>
+      recentFloods_{Constants::kFloodDedupCacheSize};
+
+  // timer to send out queued flood requests
+  std::unique_ptr<folly::AsyncTimeout> floodQueueTimer_{nullptr};
+
+  // names of flood latency and hop count histograms of this area, by class
+  // of key (see getFloodKeyClass())
+  std::array<std::string, 3> floodLatencyHistograms_;
+  std::array<std::string, 3> floodHopsHistograms_;
 
   // timer to send pending kvstore publication
   std::unique_ptr<folly::AsyncTimeout> pendingPublicationTimer_{nullptr};
 
+  // DUAL output of the current event loop iteration: dual messages towards
+  // each neighbor, and nexthop change (first old, last new nexthop) of each
+  // root-id. During a root failure, messages of all roots and neighbors are
+  // then sent as one batch per neighbor, and flood topology is set once per
+  // root
+  std::unordered_map<std::string /* neighbor */, thrift::DualMessages>
+      pendingDualMessages_;
+  std::unordered_map<
+      std::string /* rootId */,
+      std::pair<std::optional<std::string>, std::optional<std::string>>>
+      pendingNexthopChanges_;
+
+  // timer to flush the DUAL output, see flushDualBatch()
+  std::unique_ptr<folly::AsyncTimeout> dualBatchTimer_{nullptr};
+
   // timer for requesting full-sync
   std::unique_ptr<folly::AsyncTimeout> requestSyncTimer_{nullptr};
 
@@ -499,18 +784,13 @@ class KvStoreDb : public DualNode {
   // to thrift
   std::unique_ptr<folly::AsyncTimeout> drainPeerSyncSockTimer_{nullptr};
 
-  // pending keys to flood publication
-  // map<flood-root-id: set<keys>>
-  std::
-      unordered_map<std::optional<std::string>, std::unordered_set<std::string>>
-          publicationBuffer_{};
-
   // max parallel syncs allowed. It's initialized with '2' and doubles
   // up to a max value of kMaxFullSyncPendingCountThresholdfor each full sync
   // response received
   size_t parallelSyncLimit_{2};
 
-  // thrift version of "parallelSyncLimit_"
+  // thrift version of "parallelSyncLimit_", capped by
+  // kvParams_.maxParallelFullSyncs
   size_t parallelSyncLimitOverThrift_{2};
 
   // event loop
@@ -526,11 +806,15 @@ class KvStoreDb : public DualNode {
 
 class KvStore final : public OpenrEventBase {
  public:
+  // Results of multi-area requests, keyed by area
+  using AreaPublications = std::map<std::string, thrift::Publication>;
+  using AreaPeersMaps = std::map<std::string, thrift::PeersMap>;
+
   KvStore(
       // the zmq context to use for IO
       fbzmq::Context& zmqContext,
       // Queue for publishing kvstore updates
-      messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+      messaging::ReplicateQueue<KvStorePublication>& kvStoreUpdatesQueue,
       // Queue for receiving peer updates
       messaging::RQueue<thrift::PeerUpdateRequest> peerUpdateQueue,
       // the url to receive command from peer instances
@@ -543,15 +827,53 @@ class KvStore final : public OpenrEventBase {
       std::optional<int> ipTos,
       // ZMQ high water mark
       int zmqHwm = Constants::kHighWaterMark,
-      bool enableKvStoreThrift = false);
+      bool enableKvStoreThrift = false,
+      // config-store for warm start snapshot, if enabled in config
+      PersistentStore* configStore = nullptr,
+      // Queue for receiving reloaded config, if reload is supported
+      std::optional<messaging::RQueue<std::shared_ptr<const Config>>>
+          configUpdatesQueue = std::nullopt);
+
+  ~KvStore() override;
+
+  // Start or stop threads of the areas along with KvStore thread
+  void run() override;
+  void stop() override;
+
+  // Event bases running KvStoreDb of the areas on their own threads, if
+  // enabled in config. Empty otherwise
+  std::vector<std::pair<std::string /* area */, OpenrEventBase*>>
+  getAreaEvbs() const;
 
   // process the key-values publication, and attempt to
   // merge it in existing map (first argument)
   // Return a publication made out of the updated values
+  // If hashTree/keyIndex is provided, it is updated along with the existing
+  // map. If mergeExecutor is provided, merge of large updates is decided
+  // concurrently on its threads and applied on the calling thread
+  // If limits are provided (along with keyIndex accounting the existing map),
+  // value updates growing the map beyond any of them are rejected
   static std::unordered_map<std::string, thrift::Value> mergeKeyValues(
       std::unordered_map<std::string, thrift::Value>& kvStore,
       std::unordered_map<std::string, thrift::Value> const& update,
-      std::optional<KvStoreFilters> const& filters = std::nullopt);
+      std::optional<KvStoreFilters> const& filters = std::nullopt,
+      KvStoreHashTree* hashTree = nullptr,
+      KvStoreKeyIndex* keyIndex = nullptr,
+      folly::CPUThreadPoolExecutor* mergeExecutor = nullptr,
+      std::optional<KvStoreLimits> const& limits = std::nullopt);
+
+  // Fast path of mergeKeyValues for TTL refreshes in compact form. Refresh
+  // is applied only if key exists with the same version and originatorId and
+  // lower ttlVersion, hence values are never compared. Return TTL updates
+  // (values without `value`) for the applied refreshes
+  static std::unordered_map<std::string, thrift::Value> mergeTtlRefreshes(
+      std::unordered_map<std::string, thrift::Value>& kvStore,
+      std::vector<thrift::TtlRefreshBatch> const& ttlRefreshes);
+
+  // Move TTL updates out of key-values into compact TTL refreshes batched
+  // per originator
+  static std::vector<thrift::TtlRefreshBatch> batchTtlRefreshes(
+      std::unordered_map<std::string, thrift::Value>& keyVals);
 
   // compare two thrift::Values to figure out which value is better to
   // use, it will compare following attributes in order
@@ -570,10 +892,23 @@ class KvStore final : public OpenrEventBase {
       thrift::KeyGetParams keyGetParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
 
+  // Same as getKvStoreKeyVals, but values are left out of the response and
+  // only their version, originatorId, hash and ttl are returned
+  folly::SemiFuture<std::unique_ptr<thrift::Publication>> getKvStoreKeyHashes(
+      thrift::KeyGetParams keyGetParams,
+      std::string area = openr::thrift::KvStore_constants::kDefaultArea());
+
   folly::SemiFuture<folly::Unit> setKvStoreKeyVals(
       thrift::KeySetParams keySetParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
 
+  // Same as setKvStoreKeyVals, for many areas at once. Key-vals of each area
+  // are merged and flooded as one publication, with one hop per event base
+  // of the areas. Invalid areas are skipped, and reported as error once the
+  // valid ones are set
+  folly::SemiFuture<folly::Unit> setKvStoreKeyValsBatch(
+      std::map<std::string /* area */, thrift::KeySetParams> areaKeySetParams);
+
   folly::SemiFuture<std::unique_ptr<thrift::Publication>> dumpKvStoreKeys(
       thrift::KeyDumpParams keyDumpParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
@@ -585,6 +920,15 @@ class KvStore final : public OpenrEventBase {
   folly::SemiFuture<std::unique_ptr<thrift::PeersMap>> getKvStorePeers(
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
 
+  // Multi-area variants of the above, gathering results of the given areas
+  // (all areas if empty) from the threads of their KvStoreDb. Fails if any
+  // of the areas is unknown
+  folly::SemiFuture<std::unique_ptr<AreaPublications>> dumpKvStoreKeysAreas(
+      thrift::KeyDumpParams keyDumpParams, std::set<std::string> areas = {});
+
+  folly::SemiFuture<std::unique_ptr<AreaPeersMaps>> getKvStorePeersAreas(
+      std::set<std::string> areas = {});
+
   folly::SemiFuture<folly::Unit> addUpdateKvStorePeers(
       thrift::PeerAddParams peerAddParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
@@ -607,7 +951,18 @@ class KvStore final : public OpenrEventBase {
   folly::SemiFuture<std::map<std::string, int64_t>> getCounters();
 
   // API to get reader for kvStoreUpdatesQueue
-  messaging::RQueue<thrift::Publication> getKvStoreUpdatesReader();
+  messaging::RQueue<KvStorePublication> getKvStoreUpdatesReader();
+
+  // API to get reader of KvStore updates with only key-values matching
+  // filters, in given areas (all if empty). Publications left without
+  // key-values or expired keys are not delivered, except the initial sync
+  // signal. Reader gets closed with closeKvStoreUpdatesReaders()
+  messaging::RQueue<KvStorePublication> getKvStoreUpdatesReader(
+      KvStoreFilters filters,
+      std::unordered_set<std::string> const& areas = {});
+
+  // Close readers of filtered KvStore updates
+  void closeKvStoreUpdatesReaders();
 
   // API to fetch state of peerNode, used for unit-testing
   folly::SemiFuture<std::optional<KvStorePeerState>> getKvStorePeerState(
@@ -631,14 +986,70 @@ class KvStore final : public OpenrEventBase {
 
   void processCmdSocketRequest(std::vector<fbzmq::Message>&& req) noexcept;
 
-  // This function wraps `processRequestMsgHelper` and updates send/received
-  // bytes counters.
+  // This function wraps `processRequestMsgHelper` and updates sent bytes
+  // counters. Must be called on event base of the area
   folly::Expected<fbzmq::Message, fbzmq::Error> processRequestMsg(
-      const std::string& requestId, fbzmq::Message&& msg);
+      const std::string& requestId,
+      const std::string& area,
+      thrift::KvStoreRequest& thriftReq);
 
   void processPeerUpdates(thrift::PeerUpdateRequest&& req);
 
-  std::map<std::string, int64_t> getGlobalCounters() const;
+  // apply flood rate of reloaded config to the areas
+  void processConfigUpdate(std::shared_ptr<const Config> const& config);
+
+  // move peer additions of req into batch if both only add peers to the
+  // same area. Returns false, leaving both untouched, otherwise
+  static bool mergePeerAdditions(
+      thrift::PeerUpdateRequest& batch, thrift::PeerUpdateRequest& req);
+
+  // Event base running KvStoreDb of the area, KvStore itself unless areas
+  // run on their own threads. All access to the KvStoreDb must happen there
+  OpenrEventBase* getAreaEvb(const std::string& area);
+
+  // Merge key-vals into KvStoreDb of the area, on its event base
+  void setKeyVals(std::string const& area, thrift::KeySetParams keySetParams);
+
+  // Run `func(kvStoreDb)` for each of the areas on its event base, and
+  // gather the results keyed by area
+  template <typename T, typename Func>
+  folly::SemiFuture<std::map<std::string, T>> collectFromAreas(
+      std::set<std::string> const& areas, Func func);
+
+  // Stop event bases of the areas and join their threads, if running
+  void stopAreaThreads();
+
+  // Reply to request received on global command socket, on KvStore thread
+  void sendCmdSocketReply(
+      std::vector<fbzmq::Message>&& req,
+      folly::Expected<fbzmq::Message, fbzmq::Error>&& maybeReply) noexcept;
+
+  // Snapshot of the area if snapshot reads are enabled, nullptr otherwise.
+  // Safe to call from any thread, as areas are fixed on construction
+  std::shared_ptr<const KvStoreSnapshot::Snapshot> getSnapshot(
+      const std::string& area) const;
+
+  // Resolve requested areas, empty meaning all areas. Throws OpenrError on
+  // unknown area
+  std::set<std::string> resolveAreas(std::set<std::string> areas) const;
+
+  // Serve key dump from snapshot of the area. Returns nullptr if snapshot
+  // reads are disabled or the request needs KvStoreDb (e.g. full-sync)
+  std::unique_ptr<thrift::Publication> dumpKvStoreKeysFromSnapshot(
+      const thrift::KeyDumpParams& keyDumpParams,
+      const std::string& area) const;
+
+  // Serve key dump from KvStoreDb, must be called on KvStore thread
+  thrift::Publication dumpKvStoreKeysFromDb(
+      KvStoreDb& kvStoreDb, const thrift::KeyDumpParams& keyDumpParams);
+
+  // Restore key-values of warm start snapshot from config-store, with TTLs
+  // aged by the time since snapshot. Called on construction, before any peer
+  // is added
+  void loadWarmStartSnapshot();
+
+  // Persist key-values of all areas in config-store
+  void saveWarmStartSnapshot();
 
   //
   // Private variables
@@ -647,12 +1058,25 @@ class KvStore final : public OpenrEventBase {
   // Timer for updating and submitting counters periodically
   std::unique_ptr<folly::AsyncTimeout> counterUpdateTimer_{nullptr};
 
+  // config-store for warm start snapshot and timer for saving it
+  // periodically. Only set if warm start is enabled
+  PersistentStore* configStore_{nullptr};
+  std::unique_ptr<folly::AsyncTimeout> warmStartSnapshotTimer_{nullptr};
+
   // client to interact with monitor
   std::shared_ptr<fbzmq::ZmqMonitorClient> zmqMonitorClient_;
 
   // kvstore parameters common to all kvstoreDB
   KvStoreParams kvParams_;
 
+  // event bases and threads of the areas, if KvStoreDb of every area runs on
+  // its own thread. Destroyed after KvStoreDb instances
+  std::unordered_map<
+      std::string /* area ID */,
+      std::unique_ptr<OpenrEventBase>>
+      areaEvbs_;
+  std::vector<std::thread> areaThreads_;
+
   // map of area IDs and instance of KvStoreDb
   std::unordered_map<std::string /* area ID */, KvStoreDb> kvStoreDb_{};
 
@@ -10,11 +10,29 @@
 #include <openr/common/OpenrClient.h>
 #include <openr/common/Util.h>
 
+#include <fb303/ServiceData.h>
+#include <folly/Random.h>
 #include <folly/SharedMutex.h>
 #include <folly/String.h>
 
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
+namespace {
+
+// TTL refresh interval of a key, quarter of its TTL shortened by random
+// jitter of up to kTtlRefreshJitter of it
+std::chrono::milliseconds
+getTtlRefreshInterval(int64_t ttl) {
+  const int64_t interval = ttl / 4;
+  const auto jitter = static_cast<int64_t>(
+      interval * Constants::kTtlRefreshJitter * folly::Random::randDouble01());
+  return std::chrono::milliseconds(interval - jitter);
+}
+
+} // namespace
+
 KvStoreClientInternal::KvStoreClientInternal(
     OpenrEventBase* eventBase,
     std::string const& nodeId,
@@ -42,7 +60,7 @@ KvStoreClientInternal::KvStoreClientInternal(
         LOG(INFO) << "Terminating KvStore updates processing fiber";
         break;
       }
-      processPublication(maybePublication.value());
+      processPublication(*maybePublication.value());
     }
   });
 
@@ -59,6 +77,8 @@ KvStoreClientInternal::~KvStoreClientInternal() {
     advertiseKeyValsTimer_.reset();
     ttlTimer_.reset();
     checkPersistKeyTimer_.reset();
+    // abandon in-flight check of persisted keys
+    persistKeyCheckGuard_.reset();
   });
 
   // wait for fiber to be closed before destroy KvStoreClientInternal
@@ -100,56 +120,136 @@ KvStoreClientInternal::initTimers() {
 
 void
 KvStoreClientInternal::checkPersistKeyInStore() {
-  std::chrono::milliseconds timeout{checkPersistKeyPeriod_.value()};
+  // split persisted keys of each area into chunks to check in this period
+  persistKeyChunks_.clear();
+  for (auto const& [area, persistedKeyVals] : persistedKeyVals_) {
+    std::vector<std::string> keys;
+    for (auto const& [key, _] : persistedKeyVals) {
+      keys.emplace_back(key);
+      if (keys.size() == Constants::kPersistKeyCheckChunkSize) {
+        persistKeyChunks_.emplace_back(area, std::move(keys));
+        keys.clear();
+      }
+    }
+    if (not keys.empty()) {
+      persistKeyChunks_.emplace_back(area, std::move(keys));
+    }
+  }
+
+  checkNextPersistKeyChunk();
+}
 
-  // go through persisted keys map for each area
-  for (const auto& persistKeyValsEntry : persistedKeyVals_) {
-    const auto& area = persistKeyValsEntry.first;
-    auto& persistedKeyVals = persistKeyValsEntry.second;
+void
+KvStoreClientInternal::checkNextPersistKeyChunk() {
+  if (persistKeyChunks_.empty()) {
+    checkPersistKeyTimer_->scheduleTimeout(checkPersistKeyPeriod_.value());
+    return;
+  }
 
-    if (persistedKeyVals.empty()) {
+  auto [area, keys] = std::move(persistKeyChunks_.front());
+  persistKeyChunks_.pop_front();
+
+  // Continuations run on our evb, where the guard is released on destruction
+  std::weak_ptr<folly::Unit> guard = persistKeyCheckGuard_;
+  thrift::KeyGetParams params;
+  params.keys = keys;
+  kvStore_->getKvStoreKeyHashes(std::move(params), area)
+      .via(eventBase_->getEvb())
+      .thenValue([this, guard, area = area, keys = std::move(keys)](
+                     std::unique_ptr<thrift::Publication> hashes) {
+        if (guard.expired()) {
+          return;
+        }
+        auto staleKeys = processPersistKeyHashes(area, keys, *hashes);
+        if (staleKeys.empty()) {
+          checkNextPersistKeyChunk();
+          return;
+        }
+
+        // Fetch values only for the keys which differ
+        thrift::KeyGetParams staleParams;
+        staleParams.keys = std::move(staleKeys);
+        kvStore_->getKvStoreKeyVals(std::move(staleParams), area)
+            .via(eventBase_->getEvb())
+            .thenValue([this, guard](std::unique_ptr<thrift::Publication> pub) {
+              if (guard.expired()) {
+                return;
+              }
+              processPublication(*pub);
+              checkNextPersistKeyChunk();
+            })
+            .thenError([this, guard](const folly::exception_wrapper& ew) {
+              if (not guard.expired()) {
+                retryPersistKeyCheck(ew);
+              }
+            });
+      })
+      .thenError([this, guard](const folly::exception_wrapper& ew) {
+        if (not guard.expired()) {
+          retryPersistKeyCheck(ew);
+        }
+      });
+}
+
+std::vector<std::string>
+KvStoreClientInternal::processPersistKeyHashes(
+    std::string const& area,
+    std::vector<std::string> const& keys,
+    thrift::Publication const& hashes) {
+  // Persisted keys might have changed since the chunk was built
+  auto areaIt = persistedKeyVals_.find(area);
+  if (areaIt == persistedKeyVals_.end()) {
+    return {};
+  }
+  auto const& persistedKeyVals = areaIt->second;
+
+  std::unordered_map<std::string, thrift::Value> keyVals;
+  std::vector<std::string> staleKeys;
+  for (auto const& key : keys) {
+    auto it = persistedKeyVals.find(key);
+    if (it == persistedKeyVals.end()) {
       continue;
     }
+    auto const& persistedValue = it->second;
 
-    thrift::KeyGetParams params;
-    thrift::Publication pub;
-    for (auto const& key : persistedKeyVals) {
-      params.keys.emplace_back(key.first);
-    }
-
-    // Get KvStore response
-    try {
-      pub = *(kvStore_->getKvStoreKeyVals(params, area).get());
-    } catch (const std::exception& ex) {
-      LOG(ERROR) << "Failed to get keyvals from kvstore. Exception: "
-                 << ex.what();
-      // retry in 1 sec
-      timeout = 1000ms;
-      checkPersistKeyTimer_->scheduleTimeout(1000ms);
+    // Missing (expired) from KvStore, re-advertise
+    auto rxkey = hashes.keyVals.find(key);
+    if (rxkey == hashes.keyVals.end()) {
+      keyVals.emplace(key, persistedValue);
       continue;
     }
 
-    // Find expired keys from latest KvStore
-    std::unordered_map<std::string, thrift::Value> keyVals;
-    for (auto const& key : persistedKeyVals) {
-      auto rxkey = pub.keyVals.find(key.first);
-      if (rxkey == pub.keyVals.end()) {
-        keyVals.emplace(key.first, persistedKeyVals.at(key.first));
-      }
+    // Differs from what we persisted, or has a newer ttlVersion
+    auto const& rcvdValue = rxkey->second;
+    if (rcvdValue.version != persistedValue.version or
+        rcvdValue.originatorId != persistedValue.originatorId or
+        rcvdValue.ttlVersion > persistedValue.ttlVersion or
+        rcvdValue.hash_ref().value_or(0) !=
+            generateHash(
+                persistedValue.version,
+                persistedValue.originatorId,
+                persistedValue.value_ref())) {
+      staleKeys.emplace_back(key);
     }
+  }
 
-    // Advertise to KvStore
-    if (not keyVals.empty()) {
-      const auto ret = setKeysHelper(std::move(keyVals), area);
-      if (!ret.has_value()) {
-        LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
-      }
+  // Advertise to KvStore
+  if (not keyVals.empty()) {
+    const auto ret = setKeysHelper(std::move(keyVals), area);
+    if (!ret.has_value()) {
+      LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
     }
-    processPublication(pub);
   }
+  return staleKeys;
+}
 
-  timeout = std::min(timeout, checkPersistKeyPeriod_.value());
-  checkPersistKeyTimer_->scheduleTimeout(timeout);
+void
+KvStoreClientInternal::retryPersistKeyCheck(
+    folly::exception_wrapper const& ew) {
+  LOG(ERROR) << "Failed to get keyvals from kvstore. Exception: " << ew.what();
+  // retry in 1 sec
+  persistKeyChunks_.clear();
+  checkPersistKeyTimer_->scheduleTimeout(1000ms);
 }
 
 bool
@@ -238,8 +338,10 @@ KvStoreClientInternal::persistKey(
     keysToAdvertise.insert(key);
   }
 
-  // Best effort to advertise pending keys
-  advertisePendingKeys();
+  // Best effort to advertise pending keys, all at once when batching
+  if (not batching_) {
+    advertisePendingKeys();
+  }
 
   scheduleTtlUpdates(
       key,
@@ -252,6 +354,21 @@ KvStoreClientInternal::persistKey(
   return true;
 }
 
+void
+KvStoreClientInternal::startBatch() {
+  batching_ = true;
+}
+
+void
+KvStoreClientInternal::flushBatch() {
+  if (not batching_) {
+    return;
+  }
+  batching_ = false;
+  // pending keys are advertised along with the batched key-vals
+  advertisePendingKeys();
+}
+
 thrift::Value
 KvStoreClientInternal::buildThriftValue(
     std::string const& key,
@@ -356,13 +473,14 @@ KvStoreClientInternal::scheduleTtlUpdates(
   ttlThriftValue.value_ref().reset();
   CHECK(not ttlThriftValue.value_ref().has_value());
 
-  // renew before Ttl expires about every ttl/3, i.e., try twice
+  // renew before Ttl expires about every ttl/4, i.e., try thrice. Interval
+  // is jittered per key to spread refreshes of keys persisted together.
   // use ExponentialBackoff to track remaining time
+  const auto interval = getTtlRefreshInterval(ttl);
   keyTtlBackoffs[key] = std::make_pair(
       ttlThriftValue,
       ExponentialBackoff<std::chrono::milliseconds>(
-          std::chrono::milliseconds(ttl / 4),
-          std::chrono::milliseconds(ttl / 4 + 1)));
+          interval, interval + std::chrono::milliseconds(1)));
 
   // Delay first ttl advertisement by (ttl / 4). We have just advertised key or
   // update and would like to avoid sending unncessary immediate ttl update
@@ -679,6 +797,13 @@ void
 KvStoreClientInternal::advertisePendingKeys() {
   std::chrono::milliseconds timeout = Constants::kMaxBackoff;
 
+  // key-vals of all areas, and batched ones if any, are set at once. Pending
+  // keys override batched key-vals, as they are written last
+  auto areaKeyVals = std::move(batchedKeyVals_);
+  batchedKeyVals_.clear();
+  std::unordered_map<std::string /* area */, std::vector<std::string>>
+      areaKeys;
+
   // advertise pending key for each area
   for (auto& keysToAdvertiseEntry : keysToAdvertise_) {
     auto& keysToAdvertise = keysToAdvertiseEntry.second;
@@ -690,8 +815,8 @@ KvStoreClientInternal::advertisePendingKeys() {
     auto& persistedKeyVals = persistedKeyVals_[keysToAdvertiseEntry.first];
 
     // Build set of keys to advertise
-    std::unordered_map<std::string, thrift::Value> keyVals;
-    std::vector<std::string> keys;
+    auto& keyVals = areaKeyVals[area];
+    auto& keys = areaKeys[area];
     for (auto const& key : keysToAdvertise) {
       const auto& thriftValue = persistedKeyVals.at(key);
 
@@ -722,19 +847,22 @@ KvStoreClientInternal::advertisePendingKeys() {
 
       // Set in keyVals which is going to be advertise to the kvStore.
       DCHECK(thriftValue.value_ref());
-      keyVals.emplace(key, thriftValue);
+      keyVals.insert_or_assign(key, thriftValue);
       keys.push_back(key);
     }
+  }
 
-    // Advertise to KvStore
-    const auto ret = setKeysHelper(std::move(keyVals), area);
-    if (ret.has_value()) {
+  // Advertise to KvStore
+  const auto ret = setKeysHelper(std::move(areaKeyVals));
+  if (ret.has_value()) {
+    for (auto const& [area, keys] : areaKeys) {
+      auto& keysToAdvertise = keysToAdvertise_.at(area);
       for (auto const& key : keys) {
         keysToAdvertise.erase(key);
       }
-    } else {
-      LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
     }
+  } else {
+    LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
   }
 
   // Schedule next-timeout for processing/clearing backoffs
@@ -754,6 +882,7 @@ KvStoreClientInternal::advertiseTtlUpdates() {
     auto& area = keyTtlBackoffsEntry.first;
 
     std::unordered_map<std::string, thrift::Value> keyVals;
+    size_t numDeferred{0};
 
     for (auto& kv : keyTtlBackoffs) {
       const auto& key = kv.first;
@@ -763,6 +892,12 @@ KvStoreClientInternal::advertiseTtlUpdates() {
         timeout = std::min(timeout, backoff.getTimeRemainingUntilRetry());
         continue;
       }
+      if (keyVals.size() >= Constants::kTtlRefreshMaxBatchSize) {
+        // batch is full, refresh with the next one
+        timeout = std::min(timeout, Constants::kTtlRefreshBatchInterval);
+        ++numDeferred;
+        continue;
+      }
 
       // Apply backoff
       backoff.reportError();
@@ -794,8 +929,15 @@ KvStoreClientInternal::advertiseTtlUpdates() {
       keyVals.emplace(key, thriftValue);
     }
 
+    if (numDeferred) {
+      fb303::fbData->addStatValue(
+          "kvstore_client.ttl_refreshes_deferred", numDeferred, fb303::SUM);
+    }
+
     // Advertise to KvStore
     if (not keyVals.empty()) {
+      fb303::fbData->addStatValue(
+          "kvstore_client.ttl_refresh_batch_size", keyVals.size(), fb303::AVG);
       const auto ret = setKeysHelper(std::move(keyVals), area);
       if (!ret.has_value()) {
         LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
@@ -819,25 +961,64 @@ KvStoreClientInternal::setKeysHelper(
     return folly::Unit();
   }
 
-  // Debugging purpose print-out
-  for (auto const& kv : keyVals) {
-    VLOG(3)
-        << "Advertising key: " << kv.first << ", version: " << kv.second.version
-        << ", originatorId: " << kv.second.originatorId
-        << ", ttlVersion: " << kv.second.ttlVersion
-        << ", val: " << (kv.second.value_ref().has_value() ? "valid" : "null")
-        << ", area: " << area;
-    if (not kv.second.value_ref().has_value()) {
-      // avoid empty optinal exception
+  // Written along with the rest of the batch, later ones override
+  if (batching_) {
+    auto& batchedKeyVals = batchedKeyVals_[area];
+    for (auto& [key, value] : keyVals) {
+      batchedKeyVals.insert_or_assign(key, std::move(value));
+    }
+    return folly::Unit();
+  }
+
+  std::unordered_map<
+      std::string,
+      std::unordered_map<std::string, thrift::Value>>
+      areaKeyVals;
+  areaKeyVals.emplace(area, std::move(keyVals));
+  return setKeysHelper(std::move(areaKeyVals));
+}
+
+std::optional<folly::Unit>
+KvStoreClientInternal::setKeysHelper(
+    std::unordered_map<
+        std::string,
+        std::unordered_map<std::string, thrift::Value>> areaKeyVals) {
+  CHECK(kvStore_);
+
+  std::map<std::string, thrift::KeySetParams> areaKeySetParams;
+  for (auto& [area, keyVals] : areaKeyVals) {
+    // Skip areas with nothing to advertise.
+    if (keyVals.empty()) {
       continue;
     }
+
+    // Debugging purpose print-out
+    for (auto const& kv : keyVals) {
+      VLOG(3) << "Advertising key: " << kv.first
+              << ", version: " << kv.second.version
+              << ", originatorId: " << kv.second.originatorId
+              << ", ttlVersion: " << kv.second.ttlVersion << ", val: "
+              << (kv.second.value_ref().has_value() ? "valid" : "null")
+              << ", area: " << area;
+    }
+
+    thrift::KeySetParams params;
+    params.keyVals = std::move(keyVals);
+    // Send TTL updates in compact form
+    auto ttlRefreshes = KvStore::batchTtlRefreshes(params.keyVals);
+    if (not ttlRefreshes.empty()) {
+      params.ttlRefreshes_ref() = std::move(ttlRefreshes);
+    }
+    areaKeySetParams.emplace(area, std::move(params));
   }
 
-  thrift::KeySetParams params;
-  params.keyVals = std::move(keyVals);
+  // Return if nothing to advertise.
+  if (areaKeySetParams.empty()) {
+    return folly::Unit();
+  }
 
   try {
-    kvStore_->setKvStoreKeyVals(params, area).get();
+    kvStore_->setKvStoreKeyValsBatch(std::move(areaKeySetParams)).get();
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Failed to set key-val from KvStore. Exception: "
                << ex.what();
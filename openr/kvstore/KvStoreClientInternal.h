@@ -8,6 +8,8 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -93,6 +95,14 @@ class KvStoreClientInternal {
       thrift::Value const& value,
       std::string const& area = thrift::KvStore_constants::kDefaultArea());
 
+  /**
+   * Batch writes to KvStore of all the areas, e.g. of persistKey, setKey and
+   * clearKey, from startBatch() till flushBatch(), into one request. Writes
+   * are not visible in KvStore till flushed.
+   */
+  void startBatch();
+  void flushBatch();
+
   /**
    * Unset key from KvStore. It really doesn't delete the key from KvStore,
    * instead it just leave it as it is.
@@ -195,6 +205,10 @@ class KvStoreClientInternal {
   std::optional<folly::Unit> setKeysHelper(
       std::unordered_map<std::string, thrift::Value> keyVals,
       std::string const& area = thrift::KvStore_constants::kDefaultArea());
+  std::optional<folly::Unit> setKeysHelper(
+      std::unordered_map<
+          std::string /* area */,
+          std::unordered_map<std::string, thrift::Value>> areaKeyVals);
 
   /**
    * Helper function to advertise the pending keys considering the exponential
@@ -219,8 +233,35 @@ class KvStoreClientInternal {
    */
   void advertiseTtlUpdates();
 
+  /**
+   * Periodic check of persisted keys against KvStore. Overrides and expiry of
+   * persisted keys are pushed by KvStore updates, this only catches up on
+   * missed ones. Keys are checked asynchronously in chunks of
+   * kPersistKeyCheckChunkSize by their hashes, and values are fetched only
+   * for the keys which differ.
+   */
   void checkPersistKeyInStore();
 
+  /**
+   * Check next pending chunk of persisted keys. Schedules next period once
+   * all chunks are checked.
+   */
+  void checkNextPersistKeyChunk();
+
+  /**
+   * Re-advertise persisted keys of the chunk missing from KvStore, and
+   * return the ones whose value in KvStore differs from the persisted one
+   */
+  std::vector<std::string> processPersistKeyHashes(
+      std::string const& area,
+      std::vector<std::string> const& keys,
+      thrift::Publication const& hashes);
+
+  /**
+   * Abandon check of the current period on failure and retry it shortly
+   */
+  void retryPersistKeyCheck(folly::exception_wrapper const& ew);
+
   /*
    * Wrapper function to initialize timer
    */
@@ -246,6 +287,14 @@ class KvStoreClientInternal {
   // check persiste key timer event
   std::unique_ptr<folly::AsyncTimeout> checkPersistKeyTimer_;
 
+  // chunks of persisted keys pending check in the current period
+  std::deque<std::pair<std::string /* area */, std::vector<std::string>>>
+      persistKeyChunks_;
+
+  // held while the client is alive, for async checks to detect destruction
+  std::shared_ptr<folly::Unit> persistKeyCheckGuard_{
+      std::make_shared<folly::Unit>()};
+
   //
   // Mutable state
   //
@@ -287,6 +336,13 @@ class KvStoreClientInternal {
       std::unordered_set<std::string /* key */>>
       keysToAdvertise_;
 
+  // Whether writes are batched, and key-vals written in the batch so far
+  bool batching_{false};
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<std::string /* key */, thrift::Value>>
+      batchedKeyVals_;
+
   // Timer to advertised pending key-vals
   std::unique_ptr<folly::AsyncTimeout> advertiseKeyValsTimer_;
 
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreFloodPacer.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace openr {
+
+KvStoreFloodPacer::KvStoreFloodPacer(
+    const thrift::KvstoreFloodRate& floodRate,
+    std::vector<std::string> priorityKeyMarkers)
+    : rate_(floodRate.flood_msg_per_sec),
+      burstSize_(floodRate.flood_msg_burst_size),
+      priorityKeyMarkers_(std::move(priorityKeyMarkers)) {
+  for (auto const& marker : priorityKeyMarkers_) {
+    // "adj:" -> "adj"
+    auto name = marker;
+    while (not name.empty() and not std::isalnum(name.back())) {
+      name.pop_back();
+    }
+    classNames_.emplace_back(std::move(name));
+  }
+  classNames_.emplace_back("default");
+}
+
+size_t
+KvStoreFloodPacer::getPriorityClass(const std::string& key) const {
+  for (size_t i = 0; i < priorityKeyMarkers_.size(); ++i) {
+    auto const& marker = priorityKeyMarkers_[i];
+    if (key.compare(0, marker.size(), marker) == 0) {
+      return i;
+    }
+  }
+  return priorityKeyMarkers_.size();
+}
+
+const std::string&
+KvStoreFloodPacer::getPriorityClassName(size_t priorityClass) const {
+  return classNames_.at(priorityClass);
+}
+
+bool
+KvStoreFloodPacer::trySend(const std::string& peer) {
+  if (pendingPeers_.count(peer)) {
+    return false;
+  }
+  return getPeerState(peer).tokenBucket.consume(1);
+}
+
+void
+KvStoreFloodPacer::buffer(
+    const std::string& peer, const thrift::Publication& publication) {
+  auto& peerState = getPeerState(peer);
+  const auto now = std::chrono::steady_clock::now();
+  std::optional<std::string> floodRootId;
+  if (publication.floodRootId_ref().has_value()) {
+    floodRootId = publication.floodRootId_ref().value();
+  }
+
+  for (auto const& [key, _] : publication.keyVals) {
+    const auto priorityClass = getPriorityClass(key);
+    auto [it, inserted] =
+        peerState.pendingKeys.at(priorityClass).try_emplace(floodRootId);
+    auto& pendingKeys = it->second;
+    if (inserted) {
+      pendingKeys.priorityClass = priorityClass;
+      pendingKeys.floodRootId = floodRootId;
+      pendingKeys.bufferedSince = now;
+    }
+    pendingKeys.keys.emplace(key);
+  }
+  if (not publication.keyVals.empty()) {
+    pendingPeers_.emplace(peer);
+  }
+}
+
+std::optional<KvStoreFloodPacer::PendingKeys>
+KvStoreFloodPacer::pop(const std::string& peer) {
+  if (not pendingPeers_.count(peer)) {
+    return std::nullopt;
+  }
+  auto& peerState = getPeerState(peer);
+  if (not peerState.tokenBucket.consume(1)) {
+    return std::nullopt;
+  }
+
+  std::optional<PendingKeys> ret;
+  for (auto& pendingKeys : peerState.pendingKeys) {
+    if (not pendingKeys.empty()) {
+      auto it = pendingKeys.begin();
+      ret = std::move(it->second);
+      pendingKeys.erase(it);
+      break;
+    }
+  }
+  const bool hasMore = std::any_of(
+      peerState.pendingKeys.cbegin(),
+      peerState.pendingKeys.cend(),
+      [](auto const& pendingKeys) { return not pendingKeys.empty(); });
+  if (not hasMore) {
+    pendingPeers_.erase(peer);
+  }
+  return ret;
+}
+
+std::vector<std::string>
+KvStoreFloodPacer::getPendingPeers() const {
+  return std::vector<std::string>(pendingPeers_.begin(), pendingPeers_.end());
+}
+
+void
+KvStoreFloodPacer::removePeer(const std::string& peer) {
+  peers_.erase(peer);
+  pendingPeers_.erase(peer);
+}
+
+void
+KvStoreFloodPacer::setFloodRate(const thrift::KvstoreFloodRate& floodRate) {
+  rate_ = floodRate.flood_msg_per_sec;
+  burstSize_ = floodRate.flood_msg_burst_size;
+  for (auto& [_, peerState] : peers_) {
+    peerState.tokenBucket.reset(rate_, burstSize_);
+  }
+}
+
+KvStoreFloodPacer::PeerState&
+KvStoreFloodPacer::getPeerState(const std::string& peer) {
+  auto [it, inserted] = peers_.try_emplace(peer, rate_, burstSize_);
+  if (inserted) {
+    it->second.pendingKeys.resize(classNames_.size());
+  }
+  return it->second;
+}
+
+} // namespace openr
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <folly/TokenBucket.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/if/gen-cpp2/OpenrConfig_types.h>
+
+namespace openr {
+
+/**
+ * Rate limiter of KvStore flooding. Every peer has its own token bucket and
+ * send queue. Keys of publications which can't be sent to the peer right away
+ * are buffered per priority class, and keys of higher priority classes are
+ * flooded first once tokens are available, so that adjacency updates are
+ * never blocked behind bulk prefix updates.
+ *
+ * Priority class of a key is determined by the first key marker (in priority
+ * order) it starts with. Keys not matching any marker have the lowest
+ * priority.
+ */
+class KvStoreFloodPacer {
+ public:
+  // Keys buffered for a peer, of same priority class and flood-root-id
+  struct PendingKeys {
+    size_t priorityClass{0};
+    std::optional<std::string> floodRootId;
+    std::unordered_set<std::string> keys;
+    // time at which first of the keys got buffered
+    std::chrono::steady_clock::time_point bufferedSince;
+  };
+
+  KvStoreFloodPacer(
+      const thrift::KvstoreFloodRate& floodRate,
+      std::vector<std::string> priorityKeyMarkers);
+
+  // Priority class of the key, 0 being highest priority
+  size_t getPriorityClass(const std::string& key) const;
+
+  // Name of the priority class, for counters
+  const std::string& getPriorityClassName(size_t priorityClass) const;
+
+  size_t
+  getNumPriorityClasses() const {
+    return classNames_.size();
+  }
+
+  // Check if publication can be sent to the peer right away, and consume
+  // the token if so. Never allowed while keys are buffered for the peer, in
+  // order to preserve the ordering of updates
+  bool trySend(const std::string& peer);
+
+  // Buffer keys of the publication for the peer
+  void buffer(const std::string& peer, const thrift::Publication& publication);
+
+  // Pop buffered keys of the highest priority class for the peer if allowed
+  // by its rate limit
+  std::optional<PendingKeys> pop(const std::string& peer);
+
+  // Peers with buffered keys
+  std::vector<std::string> getPendingPeers() const;
+
+  // Drop state of the peer (e.g. on peer removal)
+  void removePeer(const std::string& peer);
+
+  // Change rate limit of all the peers, e.g. on config reload. Buffered keys
+  // are kept
+  void setFloodRate(const thrift::KvstoreFloodRate& floodRate);
+
+  bool
+  hasPendingKeys() const {
+    return not pendingPeers_.empty();
+  }
+
+ private:
+  struct PeerState {
+    PeerState(double rate, double burstSize) : tokenBucket(rate, burstSize) {}
+
+    folly::BasicTokenBucket<> tokenBucket;
+
+    // priority-class -> flood-root-id -> pending keys
+    std::vector<std::unordered_map<std::optional<std::string>, PendingKeys>>
+        pendingKeys;
+  };
+
+  PeerState& getPeerState(const std::string& peer);
+
+  double rate_{0};
+  double burstSize_{0};
+
+  // key markers in priority order
+  const std::vector<std::string> priorityKeyMarkers_;
+
+  // names of priority classes, last one for keys not matching any marker
+  std::vector<std::string> classNames_;
+
+  std::unordered_map<std::string, PeerState> peers_;
+
+  // peers with buffered keys
+  std::unordered_set<std::string> pendingPeers_;
+};
+
+} // namespace openr
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreHashTree.h>
+
+#include <algorithm>
+
+#include <folly/hash/Hash.h>
+#include <glog/logging.h>
+
+namespace openr {
+
+KvStoreHashTree::KvStoreHashTree() : buckets_(kNumBuckets, 0) {}
+
+size_t
+KvStoreHashTree::getBucket(const std::string& key) {
+  // NOTE: Must be stable across nodes and builds. Hence std::hash is avoided
+  return folly::hash::fnv64(key) % kNumBuckets;
+}
+
+uint64_t
+KvStoreHashTree::getDigest(
+    const std::string& key, const thrift::Value& value) {
+  DCHECK(value.hash_ref().has_value());
+  uint64_t digest = folly::hash::fnv64(key);
+  digest = folly::hash::fnv64(value.originatorId, digest);
+  digest = folly::hash::hash_128_to_64(digest, value.version);
+  return folly::hash::hash_128_to_64(digest, value.hash_ref().value_or(0));
+}
+
+void
+KvStoreHashTree::add(const std::string& key, const thrift::Value& value) {
+  const auto digest = getDigest(key, value);
+  buckets_[getBucket(key)] += digest;
+  root_ += digest;
+}
+
+void
+KvStoreHashTree::remove(const std::string& key, const thrift::Value& value) {
+  const auto digest = getDigest(key, value);
+  buckets_[getBucket(key)] -= digest;
+  root_ -= digest;
+}
+
+void
+KvStoreHashTree::clear() {
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  root_ = 0;
+}
+
+std::vector<int64_t>
+KvStoreHashTree::getBucketDigests() const {
+  return std::vector<int64_t>(buckets_.begin(), buckets_.end());
+}
+
+std::vector<int32_t>
+KvStoreHashTree::getMismatchedBuckets(
+    std::vector<int64_t> const& peerBucketDigests) const {
+  std::vector<int32_t> mismatched;
+  const bool sameSize = peerBucketDigests.size() == buckets_.size();
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    if (not sameSize or
+        static_cast<uint64_t>(peerBucketDigests[i]) != buckets_[i]) {
+      mismatched.emplace_back(i);
+    }
+  }
+  return mismatched;
+}
+
+} // namespace openr
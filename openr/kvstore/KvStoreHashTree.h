@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Two level hash tree (root and fixed number of buckets) summarizing content
+ * of KvStore. Keys are assigned to buckets based on hash of the key, and each
+ * bucket digest is sum of digests of its key-values. Root digest is sum of
+ * all bucket digests. Digests are order independent, hence the tree can be
+ * updated incrementally in O(1) on every key-value change.
+ *
+ * Digest of key-value covers key, version, originatorId and value-hash which
+ * are what full-sync compares. TTL and TTL-version are excluded as they are
+ * refreshed independently via flooding.
+ *
+ * Used by full-sync to find mismatched buckets against peer and exchange
+ * key-hashes of only those buckets instead of whole KvStore.
+ */
+class KvStoreHashTree {
+ public:
+  // Number of buckets. Must be same on peers for tree comparison to be valid
+  static constexpr size_t kNumBuckets{1024};
+
+  KvStoreHashTree();
+
+  // Bucket of the key
+  static size_t getBucket(const std::string& key);
+
+  // Digest of key-value. Value must have hash set
+  static uint64_t getDigest(const std::string& key, const thrift::Value& value);
+
+  // Account key-value into the tree
+  void add(const std::string& key, const thrift::Value& value);
+
+  // Remove previously accounted key-value from the tree
+  void remove(const std::string& key, const thrift::Value& value);
+
+  void clear();
+
+  int64_t
+  getRootDigest() const {
+    return static_cast<int64_t>(root_);
+  }
+
+  // Bucket digests in thrift friendly form
+  std::vector<int64_t> getBucketDigests() const;
+
+  // Buckets whose digest differs from the peer's bucket digests. All buckets
+  // are reported if peer's tree is of different size.
+  std::vector<int32_t> getMismatchedBuckets(
+      std::vector<int64_t> const& peerBucketDigests) const;
+
+ private:
+  std::vector<uint64_t> buckets_;
+  uint64_t root_{0};
+};
+
+} // namespace openr
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreKeyIndex.h>
+
+#include <algorithm>
+
+#include <openr/common/MemoryAccounting.h>
+#include <openr/common/Util.h>
+
+namespace {
+
+// node of red-black tree holds 3 pointers and color besides the element
+const size_t kSetNodeBytes = 4 * sizeof(void*) + sizeof(const std::string*);
+
+// node of hash table holds next pointer and cached hash besides the element
+const size_t kHashNodeBytes = 2 * sizeof(void*);
+
+} // namespace
+
+namespace openr {
+
+void
+KvStoreKeyIndex::add(const std::string& key, const thrift::Value& value) {
+  if (not keys_.emplace(&key).second) {
+    return;
+  }
+  originatorKeys_[value.originatorId].emplace(&key);
+  const auto bytes = getKeyValueBytes(key, value);
+  originatorBytes_[value.originatorId] += bytes;
+  bytes_ += bytes;
+}
+
+void
+KvStoreKeyIndex::remove(const std::string& key, const thrift::Value& value) {
+  // look up by key, `key` might be a copy of the referenced one
+  auto keyIt = keys_.find(key);
+  if (keyIt == keys_.end()) {
+    return;
+  }
+  keys_.erase(keyIt);
+  const auto bytes = getKeyValueBytes(key, value);
+  bytes_ -= bytes;
+  auto bytesIt = originatorBytes_.find(value.originatorId);
+  if (bytesIt != originatorBytes_.end()) {
+    bytesIt->second -= std::min(bytes, bytesIt->second);
+  }
+  auto it = originatorKeys_.find(value.originatorId);
+  if (it == originatorKeys_.end()) {
+    return;
+  }
+  auto originatorKeyIt = it->second.find(key);
+  if (originatorKeyIt != it->second.end()) {
+    it->second.erase(originatorKeyIt);
+  }
+  if (it->second.empty()) {
+    originatorKeys_.erase(it);
+    originatorBytes_.erase(value.originatorId);
+  }
+}
+
+void
+KvStoreKeyIndex::clear() {
+  keys_.clear();
+  originatorKeys_.clear();
+  originatorBytes_.clear();
+  bytes_ = 0;
+}
+
+size_t
+KvStoreKeyIndex::getOriginatorKeyCount(const std::string& originatorId) const {
+  auto it = originatorKeys_.find(originatorId);
+  return it == originatorKeys_.end() ? 0 : it->second.size();
+}
+
+size_t
+KvStoreKeyIndex::getOriginatorBytes(const std::string& originatorId) const {
+  auto it = originatorBytes_.find(originatorId);
+  return it == originatorBytes_.end() ? 0 : it->second;
+}
+
+size_t
+KvStoreKeyIndex::getMemoryUsage() const {
+  size_t bytes = sizeof(*this) + keys_.size() * kSetNodeBytes;
+  for (auto const& [originatorId, keys] : originatorKeys_) {
+    bytes += kHashNodeBytes + openr::getMemoryUsage(originatorId) +
+        sizeof(keys) + keys.size() * kSetNodeBytes;
+    // originatorBytes_ entry of the originator
+    bytes += kHashNodeBytes + openr::getMemoryUsage(originatorId) +
+        sizeof(size_t);
+  }
+  return bytes;
+}
+
+std::optional<std::string>
+KvStoreKeyIndex::getLiteralPrefix(const std::string& keyPrefix) {
+  return KeyPrefix::getLiteralPrefix(keyPrefix);
+}
+
+} // namespace openr
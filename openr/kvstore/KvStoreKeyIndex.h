@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Secondary index of KvStore keys. Keeps keys sorted, and keys grouped by
+ * originatorId, so that dumps filtered on (literal) key prefix or
+ * originatorId are proportional to the size of the result rather than the
+ * size of KvStore. Number of keys and bytes (of keys and values) are also
+ * accounted per originatorId, which limits of KvStore are enforced on.
+ *
+ * Index is updated along with KvStore on every insert, value update and key
+ * expiry. TTL updates don't affect the index.
+ *
+ * Index doesn't copy keys, it references the keys stored in KvStore instead,
+ * which must stay in place as long as they are accounted into the index.
+ */
+class KvStoreKeyIndex {
+ public:
+  // Account key-value into the index. `key` must be the one stored in KvStore
+  void add(const std::string& key, const thrift::Value& value);
+
+  // Remove previously accounted key-value from the index
+  void remove(const std::string& key, const thrift::Value& value);
+
+  void clear();
+
+  size_t
+  size() const {
+    return keys_.size();
+  }
+
+  // bytes of all accounted keys and values
+  size_t
+  getBytes() const {
+    return bytes_;
+  }
+
+  // number of keys originated by the given node
+  size_t getOriginatorKeyCount(const std::string& originatorId) const;
+
+  // bytes of keys and values originated by the given node
+  size_t getOriginatorBytes(const std::string& originatorId) const;
+
+  // bytes of the key-value accounted into the index
+  static size_t
+  getKeyValueBytes(const std::string& key, const thrift::Value& value) {
+    return key.size() + (value.value_ref() ? value.value_ref()->size() : 0);
+  }
+
+  // Approximate number of bytes held by the index, excluding referenced keys
+  size_t getMemoryUsage() const;
+
+  // Key prefix filters are RE2 patterns anchored at the start of the key.
+  // Return the pattern if it is a plain string which can be looked up in the
+  // index, std::nullopt otherwise. Same as KeyPrefix::getLiteralPrefix
+  static std::optional<std::string> getLiteralPrefix(
+      const std::string& keyPrefix);
+
+  // Invoke `func(key)` for every key starting with the given prefix
+  template <typename Func>
+  void
+  forEachKeyWithPrefix(const std::string& prefix, Func&& func) const {
+    for (auto it = keys_.lower_bound(prefix);
+         it != keys_.end() and (*it)->compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+      func(**it);
+    }
+  }
+
+  // Invoke `func(key)` for keys in sorted order, starting after `startAfter`
+  // (from the first key if empty), until `func` returns false
+  template <typename Func>
+  void
+  forEachKeyAfter(const std::string& startAfter, Func&& func) const {
+    auto it =
+        startAfter.empty() ? keys_.begin() : keys_.upper_bound(startAfter);
+    for (; it != keys_.end(); ++it) {
+      if (not func(**it)) {
+        return;
+      }
+    }
+  }
+
+  // Invoke `func(key)` for every key originated by the given node
+  template <typename Func>
+  void
+  forEachKeyWithOriginator(
+      const std::string& originatorId, Func&& func) const {
+    auto it = originatorKeys_.find(originatorId);
+    if (it == originatorKeys_.end()) {
+      return;
+    }
+    for (auto const* key : it->second) {
+      func(*key);
+    }
+  }
+
+ private:
+  // orders references to keys by the keys, and allows lookups by key
+  struct KeyLess {
+    using is_transparent = void;
+
+    bool
+    operator()(const std::string* lhs, const std::string* rhs) const {
+      return *lhs < *rhs;
+    }
+    bool
+    operator()(const std::string* lhs, const std::string& rhs) const {
+      return *lhs < rhs;
+    }
+    bool
+    operator()(const std::string& lhs, const std::string* rhs) const {
+      return lhs < *rhs;
+    }
+  };
+
+  using KeySet = std::set<const std::string*, KeyLess>;
+
+  // all keys in sorted order
+  KeySet keys_;
+
+  // originatorId -> keys originated by it
+  std::unordered_map<std::string, KeySet> originatorKeys_;
+
+  // originatorId -> bytes of keys and values originated by it
+  std::unordered_map<std::string, size_t> originatorBytes_;
+
+  // bytes of all keys and values
+  size_t bytes_{0};
+};
+
+} // namespace openr
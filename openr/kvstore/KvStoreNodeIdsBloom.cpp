@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreNodeIdsBloom.h>
+
+#include <array>
+
+#include <folly/hash/SpookyHashV2.h>
+
+namespace openr {
+
+namespace {
+
+constexpr size_t kNumBytes{KvStoreNodeIdsBloom::kNumBits / 8};
+
+// bit positions of the node, derived from two hashes (double hashing)
+std::array<size_t, KvStoreNodeIdsBloom::kNumHashes>
+getBits(const std::string& nodeId) {
+  uint64_t hash1{0}, hash2{0};
+  folly::hash::SpookyHashV2::Hash128(
+      nodeId.data(), nodeId.size(), &hash1, &hash2);
+  std::array<size_t, KvStoreNodeIdsBloom::kNumHashes> bits;
+  for (size_t i = 0; i < bits.size(); ++i) {
+    bits[i] = (hash1 + i * hash2) % KvStoreNodeIdsBloom::kNumBits;
+  }
+  return bits;
+}
+
+} // namespace
+
+std::string
+KvStoreNodeIdsBloom::create() {
+  return std::string(kNumBytes, '\0');
+}
+
+std::string
+KvStoreNodeIdsBloom::fromNodeIds(const std::vector<std::string>& nodeIds) {
+  auto bloom = create();
+  for (auto const& nodeId : nodeIds) {
+    add(bloom, nodeId);
+  }
+  return bloom;
+}
+
+void
+KvStoreNodeIdsBloom::add(std::string& bloom, const std::string& nodeId) {
+  if (bloom.size() != kNumBytes) {
+    bloom = create();
+  }
+  for (auto bit : getBits(nodeId)) {
+    bloom[bit / 8] |= static_cast<char>(1 << (bit % 8));
+  }
+}
+
+bool
+KvStoreNodeIdsBloom::mayContain(
+    const std::string& bloom, const std::string& nodeId) {
+  if (bloom.size() != kNumBytes) {
+    return false;
+  }
+  for (auto bit : getBits(nodeId)) {
+    if (not(bloom[bit / 8] & static_cast<char>(1 << (bit % 8)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace openr
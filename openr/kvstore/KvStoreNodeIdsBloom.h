@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace openr {
+
+/**
+ * Fixed-size bloom filter of nodes a publication has traversed, flooded
+ * alongside (or instead of) the list of `nodeIds` to peers supporting it
+ * (see `KeySetParams.nodeIdsBloom`). It keeps loop detection constant in size
+ * and cost, whatever the length of flooding path.
+ *
+ * False positive makes a publication look looped, hence dropped on merge.
+ * With kNumBits bits and kNumHashes hashes it stays below 1e-4 for paths up to
+ * 50 hops, and dropped updates are recovered by periodic full-sync.
+ */
+class KvStoreNodeIdsBloom {
+ public:
+  static constexpr size_t kNumBits{2048};
+  static constexpr size_t kNumHashes{4};
+
+  // Empty filter, all bits cleared
+  static std::string create();
+
+  // Filter of the given nodes
+  static std::string fromNodeIds(const std::vector<std::string>& nodeIds);
+
+  // Add node to the filter in place. Filter of unexpected size is reset first
+  static void add(std::string& bloom, const std::string& nodeId);
+
+  // Check if node may have been added to the filter. Never false for added
+  // nodes, false for filter of unexpected size
+  static bool mayContain(const std::string& bloom, const std::string& nodeId);
+};
+
+} // namespace openr
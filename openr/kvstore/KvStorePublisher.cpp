@@ -9,21 +9,33 @@
 
 #include <re2/re2.h>
 
+#include <fb303/ServiceData.h>
 #include <folly/ExceptionString.h>
+#include <folly/Format.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/ssl/OpenSSLUtils.h>
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/PersistentStore_types.h>
 #include <openr/kvstore/KvStore.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
 KvStorePublisher::KvStorePublisher(
     thrift::KvFilter filter,
-    apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher)
-    : filter_(filter), publisher_(std::move(publisher)) {
+    apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher,
+    int64_t subscriberId,
+    std::optional<thrift::KvstoreFloodRate> rate,
+    size_t maxBufferedKeys)
+    : filter_(filter),
+      publisher_(std::move(publisher)),
+      counterPrefix_(folly::sformat("kvstore.publisher.{}.", subscriberId)),
+      memoryStructure_(folly::sformat("publisher.{}.buffers", subscriberId)),
+      maxBufferedKeys_(maxBufferedKeys) {
   std::vector<std::string> keyPrefix;
   std::set<std::string> originatorIds;
 
@@ -36,14 +48,24 @@ KvStorePublisher::KvStorePublisher(
   }
 
   keyPrefixFilter_ = KvStoreFilters(keyPrefix, originatorIds);
+
+  if (rate.has_value()) {
+    tokenBucket_.emplace(rate->flood_msg_per_sec, rate->flood_msg_burst_size);
+  }
+  updateCounters();
 }
 
-void
-KvStorePublisher::publish(const thrift::Publication& pub) {
+KvStorePublisher::~KvStorePublisher() {
+  fb303::fbData->clearCounter(counterPrefix_ + "buffered_keys");
+  fb303::fbData->clearCounter(counterPrefix_ + "published");
+  fb303::fbData->clearCounter(counterPrefix_ + "coalesced_keys");
+  clearMemoryCounter("ctrl", memoryStructure_);
+}
+
+bool
+KvStorePublisher::matchFilter(const thrift::Publication& pub) const {
   if (!filter_.keys_ref() && !filter_.originatorIds_ref()) {
-    auto publication = std::make_unique<thrift::Publication>(pub);
-    publisher_.next(std::move(*publication));
-    return;
+    return true;
   }
 
   for (auto& kv : pub.keyVals) {
@@ -54,10 +76,123 @@ KvStorePublisher::publish(const thrift::Publication& pub) {
     }
 
     if (keyPrefixFilter_.keyMatch(key, val)) {
-      auto publication = std::make_unique<thrift::Publication>(pub);
-      publisher_.next(std::move(*publication));
-      return;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+KvStorePublisher::publish(const thrift::Publication& pub) {
+  if (not matchFilter(pub)) {
+    return true;
+  }
+  return publishMatched(pub);
+}
+
+bool
+KvStorePublisher::publishMatched(const thrift::Publication& pub) {
+  // stream right away unless over the rate or keys are buffered, in order to
+  // preserve the ordering of updates
+  if (not hasBufferedKeys() and
+      (not tokenBucket_.has_value() or tokenBucket_->consume(1))) {
+    publisher_.next(pub);
+    fb303::fbData->incrementCounter(counterPrefix_ + "published");
+    return true;
+  }
+
+  buffer(pub);
+  updateCounters();
+  return maxBufferedKeys_ == 0 or numBufferedKeys_ <= maxBufferedKeys_;
+}
+
+void
+KvStorePublisher::buffer(const thrift::Publication& pub) {
+  auto& pending = pendingPublications_[pub.area_ref().value_or(
+      thrift::KvStore_constants::kDefaultArea())];
+  size_t numCoalesced{0};
+  for (auto const& [key, val] : pub.keyVals) {
+    pending.expiredKeys.erase(key);
+    auto it = pending.keyVals.find(key);
+    if (it == pending.keyVals.end()) {
+      pending.keyVals.emplace(key, val);
+      continue;
     }
+    ++numCoalesced;
+    if (not val.value_ref().has_value() and
+        it->second.value_ref().has_value() and
+        it->second.version == val.version and
+        it->second.originatorId == val.originatorId) {
+      // ttl refresh of the buffered value
+      it->second.ttl = val.ttl;
+      it->second.ttlVersion = val.ttlVersion;
+    } else {
+      it->second = val;
+    }
+  }
+  for (auto const& key : pub.expiredKeys) {
+    numCoalesced += pending.keyVals.erase(key);
+    numCoalesced += pending.expiredKeys.count(key);
+    pending.expiredKeys.emplace(key);
+  }
+
+  numBufferedKeys_ = 0;
+  bufferedBytes_ = 0;
+  for (auto const& [_, pendingPub] : pendingPublications_) {
+    numBufferedKeys_ += pendingPub.keyVals.size();
+    numBufferedKeys_ += pendingPub.expiredKeys.size();
+    bufferedBytes_ += getMemoryUsage(pendingPub);
+  }
+  fb303::fbData->incrementCounter(
+      counterPrefix_ + "coalesced_keys", numCoalesced);
+}
+
+void
+KvStorePublisher::flush() {
+  while (not pendingPublications_.empty()) {
+    if (tokenBucket_.has_value() and not tokenBucket_->consume(1)) {
+      break;
+    }
+    auto it = pendingPublications_.begin();
+    bufferedBytes_ -= getMemoryUsage(it->second);
+    thrift::Publication pub;
+    pub.area_ref() = it->first;
+    for (auto& [key, val] : it->second.keyVals) {
+      pub.keyVals.emplace(key, std::move(val));
+    }
+    pub.expiredKeys.assign(
+        it->second.expiredKeys.begin(), it->second.expiredKeys.end());
+    numBufferedKeys_ -= pub.keyVals.size() + pub.expiredKeys.size();
+    pendingPublications_.erase(it);
+
+    publisher_.next(std::move(pub));
+    fb303::fbData->incrementCounter(counterPrefix_ + "published");
   }
+  updateCounters();
+}
+
+void
+KvStorePublisher::complete(const std::string& reason) {
+  thrift::OpenrError error;
+  error.message = reason;
+  std::move(publisher_).complete(folly::exception_wrapper(std::move(error)));
+}
+
+size_t
+KvStorePublisher::getMemoryUsage(const PendingPublication& pending) {
+  size_t bytes{0};
+  for (auto const& [key, val] : pending.keyVals) {
+    bytes += openr::getMemoryUsage(key) + openr::getMemoryUsage(val);
+  }
+  for (auto const& key : pending.expiredKeys) {
+    bytes += openr::getMemoryUsage(key);
+  }
+  return bytes;
+}
+
+void
+KvStorePublisher::updateCounters() {
+  fb303::fbData->setCounter(counterPrefix_ + "buffered_keys", numBufferedKeys_);
+  setMemoryCounter("ctrl", memoryStructure_, bufferedBytes_);
 }
 } // namespace openr
@@ -7,8 +7,14 @@
 
 #pragma once
 
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/TokenBucket.h>
 #include <openr/common/Types.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
@@ -17,25 +23,93 @@
 #include <openr/kvstore/KvStore.h>
 
 namespace openr {
+
+/**
+ * Publishes KvStore publications matching the filter to a stream subscriber.
+ *
+ * If rate is specified, publications are streamed at most at the rate. Any
+ * publication over the rate is buffered, coalesced by key with previously
+ * buffered ones (only the latest value of a key is kept), and streamed on
+ * `flush` once allowed by the rate. Subscriber with more than
+ * `maxBufferedKeys` keys buffered (if non-zero) is too far behind and must be
+ * disconnected.
+ */
 class KvStorePublisher {
  public:
   KvStorePublisher(
       thrift::KvFilter filter,
-      apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher);
+      apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher,
+      int64_t subscriberId = 0,
+      std::optional<thrift::KvstoreFloodRate> rate = std::nullopt,
+      size_t maxBufferedKeys = 0);
+
+  ~KvStorePublisher();
 
-  ~KvStorePublisher() {}
+  // Invoked whenever there is change. Apply filter and publish changes.
+  // Returns false if subscriber is too far behind and must be disconnected
+  bool publish(const thrift::Publication& pub);
 
-  // Invoked whenever there is change. Apply filter and publish changes
-  void publish(const thrift::Publication& pub);
+  // Same as above for publication already known to match the filter, e.g. by
+  // KvStoreSubscriberIndex
+  bool publishMatched(const thrift::Publication& pub);
+
+  // Stream buffered publications if allowed by rate
+  void flush();
+
+  bool
+  hasBufferedKeys() const {
+    return numBufferedKeys_ > 0;
+  }
+
+  size_t
+  getNumBufferedKeys() const {
+    return numBufferedKeys_;
+  }
 
   void
   complete() {
     std::move(publisher_).complete();
   }
 
+  // Disconnect subscriber with the reason
+  void complete(const std::string& reason);
+
  private:
+  // Publication pending to be streamed, of an area
+  struct PendingPublication {
+    std::unordered_map<std::string, thrift::Value> keyVals;
+    std::unordered_set<std::string> expiredKeys;
+  };
+
+  bool matchFilter(const thrift::Publication& pub) const;
+
+  // merge publication into buffered publication of its area
+  void buffer(const thrift::Publication& pub);
+
+  void updateCounters();
+
+  // approximate bytes held by a buffered publication
+  static size_t getMemoryUsage(const PendingPublication& pending);
+
   thrift::KvFilter filter_;
   KvStoreFilters keyPrefixFilter_{{}, {}};
   apache::thrift::ServerStreamPublisher<thrift::Publication> publisher_;
+
+  // prefix of counters of this publisher
+  const std::string counterPrefix_;
+
+  // name of buffers of this publisher in memory accounting
+  const std::string memoryStructure_;
+
+  // rate limit of publications streamed, if any
+  std::optional<folly::BasicTokenBucket<>> tokenBucket_;
+  const size_t maxBufferedKeys_{0};
+
+  // area -> buffered publication
+  std::unordered_map<std::string, PendingPublication> pendingPublications_;
+  size_t numBufferedKeys_{0};
+
+  // approximate bytes held by pendingPublications_
+  size_t bufferedBytes_{0};
 };
 } // namespace openr
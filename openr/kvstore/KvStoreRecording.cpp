@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "KvStoreRecording.h"
+
+#include <fcntl.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+namespace {
+
+// file header: magic followed by 32-bit format version and reserved word
+const folly::StringPiece kRecordingMagic{"OPENRKVR"};
+const uint32_t kRecordingVersion{1};
+const size_t kHeaderSize{16};
+
+// record header: 8-bit type, 64-bit timestamp, 32-bit size of publication
+const size_t kRecordHeaderSize{13};
+
+// index trailer: 64-bit number of records and index offset, then magic
+const folly::StringPiece kIndexMagic{"OPENRIDX"};
+const size_t kIndexEntrySize{16};
+const size_t kIndexTrailerSize{24};
+
+// size of buffered records written out at once
+const size_t kFlushSize{1 << 20};
+
+template <typename T>
+void
+appendInt(std::string& buf, T val) {
+  val = folly::Endian::little(val);
+  buf.append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template <typename T>
+T
+readInt(folly::ByteRange data, size_t offset) {
+  T val;
+  std::memcpy(&val, data.data() + offset, sizeof(T));
+  return folly::Endian::little(val);
+}
+
+} // namespace
+
+namespace openr {
+
+KvStoreRecorder::KvStoreRecorder(const std::string& path)
+    : file_(path, O_WRONLY | O_CREAT | O_TRUNC) {
+  buffer_.append(kRecordingMagic.data(), kRecordingMagic.size());
+  appendInt<uint32_t>(buffer_, kRecordingVersion);
+  appendInt<uint32_t>(buffer_, 0);
+}
+
+KvStoreRecorder::~KvStoreRecorder() {
+  try {
+    close();
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to close KvStore recording: " << e.what();
+  }
+}
+
+void
+KvStoreRecorder::addRecord(
+    KvStoreRecordType type,
+    const thrift::Publication& publication,
+    std::chrono::milliseconds timestamp) {
+  CHECK(not closed_) << "Recording is closed";
+  const auto payload =
+      apache::thrift::CompactSerializer::serialize<std::string>(publication);
+
+  index_.emplace_back(timestamp.count(), bufferOffset_ + buffer_.size());
+  appendInt<uint8_t>(buffer_, static_cast<uint8_t>(type));
+  appendInt<int64_t>(buffer_, timestamp.count());
+  appendInt<uint32_t>(buffer_, payload.size());
+  buffer_.append(payload);
+
+  if (buffer_.size() >= kFlushSize) {
+    flush();
+  }
+}
+
+void
+KvStoreRecorder::flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  if (folly::writeFull(file_.fd(), buffer_.data(), buffer_.size()) < 0) {
+    folly::throwSystemError("Failed to write KvStore recording");
+  }
+  bufferOffset_ += buffer_.size();
+  buffer_.clear();
+}
+
+void
+KvStoreRecorder::close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+
+  const uint64_t indexOffset = bufferOffset_ + buffer_.size();
+  for (auto const& [timestamp, offset] : index_) {
+    appendInt<int64_t>(buffer_, timestamp);
+    appendInt<uint64_t>(buffer_, offset);
+  }
+  appendInt<uint64_t>(buffer_, index_.size());
+  appendInt<uint64_t>(buffer_, indexOffset);
+  buffer_.append(kIndexMagic.data(), kIndexMagic.size());
+  flush();
+  file_.close();
+}
+
+KvStoreRecordingReader::KvStoreRecordingReader(const std::string& path)
+    : mapping_(path.c_str()), data_(mapping_.range()) {
+  if (data_.size() < kHeaderSize or
+      folly::StringPiece(data_.subpiece(0, kRecordingMagic.size())) !=
+          kRecordingMagic) {
+    throw std::runtime_error(
+        folly::sformat("{} is not a KvStore recording", path));
+  }
+  const auto version = readInt<uint32_t>(data_, kRecordingMagic.size());
+  if (version != kRecordingVersion) {
+    throw std::runtime_error(folly::sformat(
+        "Unsupported version {} of KvStore recording {}", version, path));
+  }
+  readIndex();
+}
+
+void
+KvStoreRecordingReader::readIndex() {
+  if (data_.size() < kHeaderSize + kIndexTrailerSize or
+      folly::StringPiece(data_.subpiece(data_.size() - kIndexMagic.size())) !=
+          kIndexMagic) {
+    scanRecords();
+    return;
+  }
+
+  const auto trailerOffset = data_.size() - kIndexTrailerSize;
+  const auto numRecords = readInt<uint64_t>(data_, trailerOffset);
+  const auto indexOffset = readInt<uint64_t>(data_, trailerOffset + 8);
+  if (indexOffset + numRecords * kIndexEntrySize != trailerOffset) {
+    LOG(WARNING) << "Corrupted index of KvStore recording, scanning records";
+    scanRecords();
+    return;
+  }
+
+  index_.reserve(numRecords);
+  for (uint64_t i = 0; i < numRecords; ++i) {
+    const auto entryOffset = indexOffset + i * kIndexEntrySize;
+    index_.emplace_back(
+        readInt<int64_t>(data_, entryOffset),
+        readInt<uint64_t>(data_, entryOffset + 8));
+  }
+}
+
+void
+KvStoreRecordingReader::scanRecords() {
+  index_.clear();
+  size_t offset = kHeaderSize;
+  while (offset + kRecordHeaderSize <= data_.size()) {
+    const auto size = readInt<uint32_t>(data_, offset + 9);
+    if (offset + kRecordHeaderSize + size > data_.size()) {
+      LOG(WARNING) << "Dropping truncated record at offset " << offset;
+      break;
+    }
+    index_.emplace_back(readInt<int64_t>(data_, offset + 1), offset);
+    offset += kRecordHeaderSize + size;
+  }
+}
+
+KvStoreRecord
+KvStoreRecordingReader::getRecord(size_t i) const {
+  const auto offset = index_.at(i).second;
+  const auto size = readInt<uint32_t>(data_, offset + 9);
+  return KvStoreRecord{
+      static_cast<KvStoreRecordType>(readInt<uint8_t>(data_, offset)),
+      std::chrono::milliseconds(readInt<int64_t>(data_, offset + 1)),
+      apache::thrift::CompactSerializer::deserialize<thrift::Publication>(
+          data_.subpiece(offset + kRecordHeaderSize, size))};
+}
+
+size_t
+KvStoreRecordingReader::seek(std::chrono::milliseconds timestamp) const {
+  auto it = std::lower_bound(
+      index_.begin(),
+      index_.end(),
+      timestamp.count(),
+      [](auto const& entry, int64_t ts) { return entry.first < ts; });
+  return it - index_.begin();
+}
+
+} // namespace openr
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/system/MemoryMapping.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+enum class KvStoreRecordType : uint8_t {
+  // full dump of KvStore, e.g. on subscription
+  SNAPSHOT = 0,
+  // publication following the snapshot
+  DELTA = 1,
+};
+
+struct KvStoreRecord {
+  KvStoreRecordType type;
+  // unix time of the publication, in milliseconds
+  std::chrono::milliseconds timestamp;
+  thrift::Publication publication;
+};
+
+/**
+ * Binary log of KvStore publications, for recording production churn and
+ * replaying it offline.
+ *
+ * File starts with a header, followed by records of compact serialized
+ * publications each prefixed with its type, timestamp and size. Records are
+ * buffered and written sequentially, so that recording keeps up with full
+ * flood rate. Index of record offsets and timestamps is appended on close.
+ */
+class KvStoreRecorder {
+ public:
+  // Create (truncate) recording at `path`. Throws std::system_error if file
+  // can't be opened.
+  explicit KvStoreRecorder(const std::string& path);
+
+  ~KvStoreRecorder();
+
+  void addRecord(
+      KvStoreRecordType type,
+      const thrift::Publication& publication,
+      std::chrono::milliseconds timestamp);
+
+  // Write out buffered records
+  void flush();
+
+  // Write out buffered records and the index. No record can be added after.
+  void close();
+
+  size_t
+  getNumRecords() const {
+    return index_.size();
+  }
+
+ private:
+  folly::File file_;
+  bool closed_{false};
+
+  // records not written out yet, and offset in the file where they start
+  std::string buffer_;
+  uint64_t bufferOffset_{0};
+
+  // timestamp and file offset of every record
+  std::vector<std::pair<int64_t, uint64_t>> index_;
+};
+
+/**
+ * Reader of the recording, memory mapping the file. Records are deserialized
+ * on access. Recording without index (e.g. recorder was killed) is indexed by
+ * scanning it, dropping a truncated last record.
+ */
+class KvStoreRecordingReader {
+ public:
+  // Throws std::runtime_error if file is not a recording
+  explicit KvStoreRecordingReader(const std::string& path);
+
+  size_t
+  size() const {
+    return index_.size();
+  }
+
+  KvStoreRecord getRecord(size_t i) const;
+
+  std::chrono::milliseconds
+  getTimestamp(size_t i) const {
+    return std::chrono::milliseconds(index_.at(i).first);
+  }
+
+  // Index of the first record at or after `timestamp`, size() if none
+  size_t seek(std::chrono::milliseconds timestamp) const;
+
+ private:
+  void readIndex();
+  void scanRecords();
+
+  folly::MemoryMapping mapping_;
+  folly::ByteRange data_;
+
+  // timestamp and file offset of every record
+  std::vector<std::pair<int64_t, uint64_t>> index_;
+};
+
+} // namespace openr
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreSnapshot.h>
+
+#include <glog/logging.h>
+
+namespace openr {
+
+namespace {
+
+size_t
+getShardIndex(const std::string& key, size_t numShards) {
+  return std::hash<std::string>{}(key) % numShards;
+}
+
+} // namespace
+
+KvStoreSnapshot::Entry const*
+KvStoreSnapshot::Snapshot::find(const std::string& key) const {
+  auto const& shard = *shards.at(getShardIndex(key, shards.size()));
+  auto it = shard.find(key);
+  return it == shard.end() ? nullptr : &it->second;
+}
+
+KvStoreSnapshot::KvStoreSnapshot(size_t numShards) {
+  CHECK_GT(numShards, 0);
+  for (size_t i = 0; i < numShards; ++i) {
+    shards_.emplace_back(std::make_shared<Shard>());
+  }
+  // NOTE: Published shards are shared, first update of every shard copies it
+  copied_.assign(numShards, false);
+  publish(std::nullopt);
+}
+
+KvStoreSnapshot::Shard&
+KvStoreSnapshot::getMutableShard(const std::string& key) {
+  const auto idx = getShardIndex(key, shards_.size());
+  if (not copied_[idx]) {
+    shards_[idx] = std::make_shared<Shard>(*shards_[idx]);
+    copied_[idx] = true;
+  }
+  return *shards_[idx];
+}
+
+void
+KvStoreSnapshot::update(const std::string& key, Entry entry) {
+  getMutableShard(key)[key] = std::move(entry);
+}
+
+void
+KvStoreSnapshot::remove(const std::string& key) {
+  getMutableShard(key).erase(key);
+}
+
+void
+KvStoreSnapshot::publish(std::optional<std::string> sptRootId) {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->shards.assign(shards_.begin(), shards_.end());
+  snapshot->sptRootId = std::move(sptRootId);
+  copied_.assign(shards_.size(), false);
+
+  // NOTE: Previous snapshot is released outside of lock by last reader
+  std::shared_ptr<const Snapshot> prev = std::move(snapshot);
+  published_.wlock()->swap(prev);
+}
+
+} // namespace openr
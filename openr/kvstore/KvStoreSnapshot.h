@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Synchronized.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Immutable snapshot of KvStoreDb, readable from any thread without hopping
+ * onto the KvStore event base.
+ *
+ * Keys are split into shards. KvStore thread updates shards copy-on-write
+ * and publishes a new snapshot (RCU-style) after every merge, which shares
+ * every untouched shard with the previous one. Readers grab the current
+ * snapshot under a short lock and read it at their own pace.
+ */
+class KvStoreSnapshot {
+ public:
+  struct Entry {
+    thrift::Value value;
+    // expiry time of the value, std::nullopt for infinite ttl
+    std::optional<std::chrono::steady_clock::time_point> expiryTime;
+  };
+
+  using Shard = std::unordered_map<std::string, Entry>;
+
+  struct Snapshot {
+    std::vector<std::shared_ptr<const Shard>> shards;
+    // flood-root-id at the time of publishing
+    std::optional<std::string> sptRootId;
+
+    Entry const* find(const std::string& key) const;
+  };
+
+  explicit KvStoreSnapshot(size_t numShards);
+
+  //
+  // Writer API, KvStore thread only
+  //
+
+  void update(const std::string& key, Entry entry);
+
+  void remove(const std::string& key);
+
+  // Make updates since last publish visible to readers
+  void publish(std::optional<std::string> sptRootId);
+
+  //
+  // Reader API, any thread
+  //
+
+  std::shared_ptr<const Snapshot>
+  get() const {
+    return *published_.rlock();
+  }
+
+ private:
+  Shard& getMutableShard(const std::string& key);
+
+  // shards being updated. Shard shared with a published snapshot is copied
+  // on first update after publish
+  std::vector<std::shared_ptr<Shard>> shards_;
+  std::vector<bool> copied_;
+
+  folly::Synchronized<std::shared_ptr<const Snapshot>> published_;
+};
+
+} // namespace openr
@@ -0,0 +1,214 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreSubscriberIndex.h>
+
+#include <glog/logging.h>
+
+#include <openr/kvstore/KvStoreKeyIndex.h>
+
+namespace openr {
+
+std::string
+KvStoreSubscriberIndex::getFilterKey(const thrift::KvFilter& filter) {
+  if (not filter.keys_ref().has_value() and
+      not filter.originatorIds_ref().has_value()) {
+    return "";
+  }
+  std::set<std::string> keys;
+  if (filter.keys_ref().has_value()) {
+    keys.insert(filter.keys_ref()->begin(), filter.keys_ref()->end());
+  }
+  // NOTE: '\0' separates patterns and can't appear in any of them
+  std::string filterKey{"k"};
+  for (auto const& key : keys) {
+    filterKey.append(key).push_back('\0');
+  }
+  filterKey.push_back('o');
+  if (filter.originatorIds_ref().has_value()) {
+    for (auto const& originatorId : *filter.originatorIds_ref()) {
+      filterKey.append(originatorId).push_back('\0');
+    }
+  }
+  return filterKey;
+}
+
+void
+KvStoreSubscriberIndex::addSubscriber(
+    int64_t subscriberId, const thrift::KvFilter& filter) {
+  removeSubscriber(subscriberId);
+
+  auto filterKey = getFilterKey(filter);
+  auto [it, inserted] = groups_.try_emplace(filterKey);
+  if (inserted) {
+    it->second.matchAll = filterKey.empty();
+    it->second.matchAnyKey = not filterKey.empty() and
+        (not filter.keys_ref().has_value() or filter.keys_ref()->empty()) and
+        (not filter.originatorIds_ref().has_value() or
+         filter.originatorIds_ref()->empty());
+    filters_.emplace(filterKey, filter);
+    needsRebuild_ = true;
+  }
+  it->second.subscribers.emplace(subscriberId);
+  subscriberGroups_.emplace(subscriberId, std::move(filterKey));
+}
+
+void
+KvStoreSubscriberIndex::removeSubscriber(int64_t subscriberId) {
+  auto it = subscriberGroups_.find(subscriberId);
+  if (it == subscriberGroups_.end()) {
+    return;
+  }
+  auto groupIt = groups_.find(it->second);
+  CHECK(groupIt != groups_.end());
+  groupIt->second.subscribers.erase(subscriberId);
+  if (groupIt->second.subscribers.empty()) {
+    groups_.erase(groupIt);
+    filters_.erase(it->second);
+    needsRebuild_ = true;
+  }
+  subscriberGroups_.erase(it);
+}
+
+void
+KvStoreSubscriberIndex::rebuild() {
+  trie_.clear();
+  trie_.emplace_back();
+  regexSet_.reset();
+  regexGroups_.clear();
+  originatorGroups_.clear();
+
+  re2::RE2::Options re2Options;
+  re2Options.set_case_sensitive(true);
+  auto regexSet =
+      std::make_unique<re2::RE2::Set>(re2Options, re2::RE2::ANCHOR_START);
+  // pattern -> index in RE2 set
+  std::unordered_map<std::string, size_t> regexIndices;
+
+  for (auto& [filterKey, group] : groups_) {
+    auto const& filter = filters_.at(filterKey);
+    if (filter.keys_ref().has_value()) {
+      for (auto const& keyPrefix : *filter.keys_ref()) {
+        if (auto literal = KvStoreKeyIndex::getLiteralPrefix(keyPrefix)) {
+          size_t node = 0;
+          for (const char c : *literal) {
+            auto childIt = trie_[node].children.find(c);
+            if (childIt == trie_[node].children.end()) {
+              trie_.emplace_back();
+              childIt =
+                  trie_[node].children.emplace(c, trie_.size() - 1).first;
+            }
+            node = childIt->second;
+          }
+          trie_[node].groups.emplace_back(&group);
+          continue;
+        }
+
+        auto [idxIt, inserted] =
+            regexIndices.try_emplace(keyPrefix, regexGroups_.size());
+        if (inserted) {
+          std::string re2AddError{};
+          if (regexSet->Add(keyPrefix, &re2AddError) < 0) {
+            LOG(FATAL) << "Failed to add prefixes to RE2 set: '" << keyPrefix
+                       << "', error: '" << re2AddError << "'";
+          }
+          regexGroups_.emplace_back();
+        }
+        regexGroups_.at(idxIt->second).emplace_back(&group);
+      }
+    }
+    if (filter.originatorIds_ref().has_value()) {
+      for (auto const& originatorId : *filter.originatorIds_ref()) {
+        originatorGroups_[originatorId].emplace_back(&group);
+      }
+    }
+  }
+
+  if (not regexGroups_.empty()) {
+    if (not regexSet->Compile()) {
+      LOG(FATAL) << "Failed to compile re2 set";
+    }
+    regexSet_ = std::move(regexSet);
+  }
+  needsRebuild_ = false;
+}
+
+std::vector<int64_t>
+KvStoreSubscriberIndex::getMatchingSubscribers(
+    const thrift::Publication& pub) {
+  if (needsRebuild_) {
+    rebuild();
+  }
+
+  std::unordered_set<const FilterGroup*> matched;
+  bool hasValue{false};
+  for (auto const& [_, group] : groups_) {
+    if (group.matchAll) {
+      matched.emplace(&group);
+    }
+  }
+
+  std::vector<int> regexMatches;
+  for (auto const& [key, value] : pub.keyVals) {
+    if (matched.size() == groups_.size()) {
+      break;
+    }
+    // ttl refreshes don't match any filter
+    if (not value.value_ref().has_value()) {
+      continue;
+    }
+    hasValue = true;
+
+    // literal key prefixes
+    size_t node = 0;
+    for (auto const group : trie_.at(0).groups) {
+      matched.emplace(group);
+    }
+    for (const char c : key) {
+      auto childIt = trie_[node].children.find(c);
+      if (childIt == trie_[node].children.end()) {
+        break;
+      }
+      node = childIt->second;
+      for (auto const group : trie_[node].groups) {
+        matched.emplace(group);
+      }
+    }
+
+    // rest of key prefixes
+    if (regexSet_) {
+      regexMatches.clear();
+      if (regexSet_->Match(key, &regexMatches)) {
+        for (const int idx : regexMatches) {
+          for (auto const group : regexGroups_.at(idx)) {
+            matched.emplace(group);
+          }
+        }
+      }
+    }
+
+    auto originatorIt = originatorGroups_.find(value.originatorId);
+    if (originatorIt != originatorGroups_.end()) {
+      for (auto const group : originatorIt->second) {
+        matched.emplace(group);
+      }
+    }
+  }
+
+  std::vector<int64_t> subscribers;
+  for (auto const& [_, group] : groups_) {
+    if (matched.count(&group) or (hasValue and group.matchAnyKey)) {
+      subscribers.insert(
+          subscribers.end(),
+          group.subscribers.begin(),
+          group.subscribers.end());
+    }
+  }
+  return subscribers;
+}
+
+} // namespace openr
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <re2/set.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Dispatch index of KvStore stream subscribers. Subscribers with identical
+ * filters are grouped together, and publication is matched once per group
+ * instead of once per subscriber.
+ *
+ * Key prefixes of all groups are combined, literal ones into a trie and the
+ * rest into a single RE2 set, so that every key of the publication is matched
+ * only once against filters of all groups.
+ *
+ * Matching semantics are same as of KvStorePublisher. Publication matches the
+ * filter if any key with value matches key prefixes or originatorIds of the
+ * filter (or the filter is not set at all).
+ */
+class KvStoreSubscriberIndex {
+ public:
+  void addSubscriber(int64_t subscriberId, const thrift::KvFilter& filter);
+
+  void removeSubscriber(int64_t subscriberId);
+
+  // Subscribers whose filter matches the publication
+  std::vector<int64_t> getMatchingSubscribers(const thrift::Publication& pub);
+
+  size_t
+  getNumSubscribers() const {
+    return subscriberGroups_.size();
+  }
+
+  size_t
+  getNumFilterGroups() const {
+    return groups_.size();
+  }
+
+ private:
+  // Subscribers with identical filter
+  struct FilterGroup {
+    // filter is not set, matches every publication
+    bool matchAll{false};
+    // filter is set but empty, matches every key with value
+    bool matchAnyKey{false};
+    std::unordered_set<int64_t> subscribers;
+  };
+
+  struct TrieNode {
+    std::map<char, size_t> children;
+    // groups having literal key prefix ending at this node
+    std::vector<FilterGroup*> groups;
+  };
+
+  // canonical representation of the filter
+  static std::string getFilterKey(const thrift::KvFilter& filter);
+
+  // rebuild combined key prefix matchers from filters of all groups
+  void rebuild();
+
+  // filter key -> group
+  std::unordered_map<std::string, FilterGroup> groups_;
+
+  // subscriber -> filter key of its group
+  std::unordered_map<int64_t, std::string> subscriberGroups_;
+
+  // filter key -> filter, of every group
+  std::unordered_map<std::string, thrift::KvFilter> filters_;
+
+  // combined matchers, rebuilt lazily when groups change
+  bool needsRebuild_{false};
+  std::vector<TrieNode> trie_;
+  std::unique_ptr<re2::RE2::Set> regexSet_;
+  // RE2 set pattern index -> groups having the pattern
+  std::vector<std::vector<FilterGroup*>> regexGroups_;
+  // originatorId -> groups having the originatorId
+  std::unordered_map<std::string, std::vector<FilterGroup*>> originatorGroups_;
+};
+
+} // namespace openr
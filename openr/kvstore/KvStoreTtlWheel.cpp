@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreTtlWheel.h>
+
+#include <tuple>
+
+namespace openr {
+
+constexpr std::chrono::milliseconds KvStoreTtlWheel::kTick;
+
+KvStoreTtlWheel::KvStoreTtlWheel(
+    std::chrono::steady_clock::time_point startTime)
+    : startTime_(startTime) {}
+
+void
+KvStoreTtlWheel::schedule(TtlCountdownQueueEntry entry) {
+  auto [it, inserted] = entries_.try_emplace(entry.key);
+  auto& node = it->second;
+  if (not inserted) {
+    unlink(node);
+  }
+  node.expiryTick = toTick(entry.expiryTime, true /* roundUp */);
+  node.entry = std::move(entry);
+  link(node);
+}
+
+bool
+KvStoreTtlWheel::remove(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  unlink(it->second);
+  entries_.erase(it);
+  return true;
+}
+
+TtlCountdownQueueEntry const*
+KvStoreTtlWheel::find(const std::string& key) const {
+  auto it = entries_.find(key);
+  return it == entries_.end() ? nullptr : &it->second.entry;
+}
+
+std::vector<TtlCountdownQueueEntry>
+KvStoreTtlWheel::expire(std::chrono::steady_clock::time_point now) {
+  std::vector<TtlCountdownQueueEntry> expired;
+  const auto targetTick = toTick(now, false /* roundUp */);
+
+  while (true) {
+    // Entries of current level-0 slot are all due
+    auto& level = levels_.at(0);
+    const size_t index = currentTick_ % kNumSlots;
+    auto& slot = level.slots.at(index);
+    while (not slot.empty()) {
+      auto& node = slot.front();
+      unlink(node);
+      auto it = entries_.find(node.entry.key);
+      expired.emplace_back(std::move(it->second.entry));
+      entries_.erase(it);
+    }
+
+    if (currentTick_ >= targetTick) {
+      break;
+    }
+    // Skip over empty slots, but never beyond `now`
+    currentTick_ = std::min(nextTick().value_or(targetTick), targetTick);
+    cascade();
+  }
+  return expired;
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+KvStoreTtlWheel::nextExpiryTime() const {
+  if (entries_.empty()) {
+    return std::nullopt;
+  }
+  auto tick = currentTick_;
+  if (levels_[0].slots[currentTick_ % kNumSlots].empty()) {
+    // NOTE: non-empty wheel always has next tick
+    tick = nextTick().value_or(currentTick_);
+  }
+  return startTime_ + static_cast<int64_t>(tick) * kTick;
+}
+
+void
+KvStoreTtlWheel::clear() {
+  for (auto& [_, node] : entries_) {
+    unlink(node);
+  }
+  entries_.clear();
+}
+
+uint64_t
+KvStoreTtlWheel::toTick(
+    std::chrono::steady_clock::time_point time, bool roundUp) const {
+  if (time <= startTime_) {
+    return 0;
+  }
+  const auto elapsed = time - startTime_;
+  const auto ticks = roundUp
+      ? std::chrono::ceil<std::chrono::milliseconds>(elapsed) / kTick
+      : std::chrono::floor<std::chrono::milliseconds>(elapsed) / kTick;
+  return static_cast<uint64_t>(ticks);
+}
+
+std::pair<size_t, size_t>
+KvStoreTtlWheel::getSlot(uint64_t expiryTick) const {
+  // Entries which are already due go to the current slot
+  expiryTick = std::max(expiryTick, currentTick_);
+  for (size_t level = 0; level < kNumLevels; ++level) {
+    const size_t shift = kSlotBits * level;
+    // Expiry falls in the current rotation of the level
+    if ((expiryTick >> (shift + kSlotBits)) ==
+        (currentTick_ >> (shift + kSlotBits))) {
+      return {level, (expiryTick >> shift) % kNumSlots};
+    }
+  }
+  return {kNumLevels, 0};
+}
+
+void
+KvStoreTtlWheel::link(Node& node) {
+  std::tie(node.level, node.index) = getSlot(node.expiryTick);
+  if (node.level == kNumLevels) {
+    overflow_.push_back(node);
+    return;
+  }
+  auto& level = levels_[node.level];
+  level.slots[node.index].push_back(node);
+  level.occupied[node.index / 64] |= (1ULL << (node.index % 64));
+}
+
+void
+KvStoreTtlWheel::unlink(Node& node) {
+  if (not node.hook.is_linked()) {
+    return;
+  }
+  node.hook.unlink();
+  if (node.level == kNumLevels) {
+    return;
+  }
+  auto& level = levels_[node.level];
+  if (level.slots[node.index].empty()) {
+    level.occupied[node.index / 64] &= ~(1ULL << (node.index % 64));
+  }
+}
+
+void
+KvStoreTtlWheel::cascade() {
+  // Highest level completing the rotation. Its slot needs to be cascaded
+  // first as entries may drop into current slots of lower levels
+  size_t topLevel = 0;
+  while (topLevel < kNumLevels and
+         (currentTick_ & ((1ULL << (kSlotBits * (topLevel + 1))) - 1)) == 0) {
+    ++topLevel;
+  }
+
+  for (size_t level = topLevel; level > 0; --level) {
+    Slot nodes;
+    if (level == kNumLevels) {
+      nodes.splice(nodes.end(), overflow_);
+    } else {
+      const size_t index = (currentTick_ >> (kSlotBits * level)) % kNumSlots;
+      auto& slot = levels_[level].slots[index];
+      nodes.splice(nodes.end(), slot);
+      levels_[level].occupied[index / 64] &= ~(1ULL << (index % 64));
+    }
+    while (not nodes.empty()) {
+      auto& node = nodes.front();
+      nodes.pop_front();
+      link(node);
+    }
+  }
+}
+
+std::optional<uint64_t>
+KvStoreTtlWheel::nextTick() const {
+  for (size_t level = 0; level < kNumLevels; ++level) {
+    const size_t shift = kSlotBits * level;
+    const size_t index = (currentTick_ >> shift) % kNumSlots;
+    if (index + 1 == kNumSlots) {
+      continue;
+    }
+    if (auto slot = findSlot(level, index + 1)) {
+      // start of the slot within current rotation of the level
+      const uint64_t rotation =
+          (currentTick_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+      return rotation + (static_cast<uint64_t>(*slot) << shift);
+    }
+  }
+  if (not overflow_.empty()) {
+    // next rotation of the top level
+    const size_t shift = kSlotBits * kNumLevels;
+    return ((currentTick_ >> shift) + 1) << shift;
+  }
+  return std::nullopt;
+}
+
+std::optional<size_t>
+KvStoreTtlWheel::findSlot(size_t level, size_t from) const {
+  auto const& occupied = levels_.at(level).occupied;
+  for (size_t word = from / 64; word < occupied.size(); ++word) {
+    auto bits = occupied[word];
+    if (word == from / 64) {
+      bits &= ~0ULL << (from % 64);
+    }
+    if (bits) {
+      return word * 64 + __builtin_ctzll(bits);
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace openr
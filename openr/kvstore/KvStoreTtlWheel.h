@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/IntrusiveList.h>
+
+namespace openr {
+
+struct TtlCountdownQueueEntry {
+  std::chrono::steady_clock::time_point expiryTime;
+  std::string key;
+  int64_t version{0};
+  int64_t ttlVersion{0};
+  std::string originatorId;
+};
+
+/**
+ * Hierarchical timing wheel tracking TTL expiry of KvStore keys. There is at
+ * most one entry per key and TTL refresh reschedules the entry in place,
+ * hence memory is bounded by number of keys (irrespective of refresh rate)
+ * and schedule/remove are O(1).
+ *
+ * Wheel has `kNumLevels` levels of `kNumSlots` slots, slots of level `l`
+ * spanning `kNumSlots ^ l` ticks. Entry is kept in the lowest level whose
+ * rotation contains its expiry tick and gets cascaded to lower levels as
+ * time advances. Entries beyond the range of the top level are kept in an
+ * overflow slot.
+ */
+class KvStoreTtlWheel {
+ public:
+  // Resolution of the wheel. Entries never expire before their expiryTime,
+  // and at most one tick after
+  static constexpr std::chrono::milliseconds kTick{1};
+
+  explicit KvStoreTtlWheel(
+      std::chrono::steady_clock::time_point startTime =
+          std::chrono::steady_clock::now());
+
+  // Not copyable as slots link to entries in place
+  KvStoreTtlWheel(const KvStoreTtlWheel&) = delete;
+  KvStoreTtlWheel& operator=(const KvStoreTtlWheel&) = delete;
+
+  // Schedule expiry of the key, replacing existing entry of the key if any
+  void schedule(TtlCountdownQueueEntry entry);
+
+  // Remove entry of the key. Returns true if key was scheduled
+  bool remove(const std::string& key);
+
+  // Entry of the key if scheduled, nullptr otherwise
+  TtlCountdownQueueEntry const* find(const std::string& key) const;
+
+  // Advance wheel to `now` and return all the entries expired by then
+  std::vector<TtlCountdownQueueEntry> expire(
+      std::chrono::steady_clock::time_point now);
+
+  // Time at which wheel needs to be advanced next, std::nullopt if empty.
+  // This is the expiry time of the earliest entries, or the time at which
+  // earliest entries get cascaded to lower levels
+  std::optional<std::chrono::steady_clock::time_point> nextExpiryTime() const;
+
+  void clear();
+
+  size_t
+  size() const {
+    return entries_.size();
+  }
+
+  bool
+  empty() const {
+    return entries_.empty();
+  }
+
+ private:
+  static constexpr size_t kSlotBits{8};
+  static constexpr size_t kNumSlots{1 << kSlotBits};
+  static constexpr size_t kNumLevels{4};
+
+  struct Node {
+    TtlCountdownQueueEntry entry;
+    uint64_t expiryTick{0};
+    // slot the node is linked into, level is kNumLevels for overflow
+    size_t level{0};
+    size_t index{0};
+    folly::IntrusiveListHook hook;
+  };
+
+  using Slot = folly::IntrusiveList<Node, &Node::hook>;
+
+  struct Level {
+    std::array<Slot, kNumSlots> slots;
+    // bitmap of non-empty slots
+    std::array<uint64_t, kNumSlots / 64> occupied{};
+  };
+
+  // Ticks elapsed since startTime_, optionally rounded up
+  uint64_t toTick(
+      std::chrono::steady_clock::time_point time, bool roundUp) const;
+
+  // Link node into the slot corresponding to its expiry tick
+  void link(Node& node);
+
+  // Unlink node from its slot
+  void unlink(Node& node);
+
+  // Re-link entries of the current slots of all the levels which completed
+  // a rotation at currentTick_
+  void cascade();
+
+  // Next tick greater than currentTick_ at which some slot needs processing
+  std::optional<uint64_t> nextTick() const;
+
+  // Level and slot index for the expiry tick
+  std::pair<size_t, size_t> getSlot(uint64_t expiryTick) const;
+
+  // First non-empty slot of the level at or after `from`
+  std::optional<size_t> findSlot(size_t level, size_t from) const;
+
+  const std::chrono::steady_clock::time_point startTime_;
+
+  // Ticks upto which wheel has been advanced
+  uint64_t currentTick_{0};
+
+  // key -> entry. Nodes are linked into the slots in place
+  std::unordered_map<std::string, Node> entries_;
+
+  std::array<Level, kNumLevels> levels_;
+
+  // entries beyond the range of top level
+  Slot overflow_;
+};
+
+} // namespace openr
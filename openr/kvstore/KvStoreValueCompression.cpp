@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreValueCompression.h>
+
+#include <folly/compression/Compression.h>
+#include <glog/logging.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/Util.h>
+
+namespace openr {
+
+namespace {
+
+// Codec is not thread-safe and expensive to create. Keep one per thread
+folly::io::Codec&
+getCodec() {
+  thread_local auto codec = folly::io::getCodec(folly::io::CodecType::ZSTD);
+  return *codec;
+}
+
+} // namespace
+
+bool
+KvStoreValueCompression::shouldCompress(
+    const std::string& key, const thrift::Value& value) {
+  if (isCompressed(value) or not value.value_ref().has_value() or
+      value.value_ref()->size() < kMinCompressSize) {
+    return false;
+  }
+  return key.find(Constants::kAdjDbMarker.toString()) == 0 or
+      key.find(Constants::kPrefixDbMarker.toString()) == 0;
+}
+
+bool
+KvStoreValueCompression::compress(thrift::Value& value) {
+  if (isCompressed(value) or not value.value_ref().has_value()) {
+    return false;
+  }
+
+  auto compressed = getCodec().compress(*value.value_ref());
+  if (compressed.size() >= value.value_ref()->size()) {
+    return false;
+  }
+
+  // Hash must cover uncompressed content
+  if (not value.hash_ref().has_value()) {
+    value.hash_ref() =
+        generateHash(value.version, value.originatorId, value.value_ref());
+  }
+  value.value_ref() = std::move(compressed);
+  value.isCompressed_ref() = true;
+  return true;
+}
+
+bool
+KvStoreValueCompression::decompress(thrift::Value& value) {
+  if (not isCompressed(value)) {
+    return true;
+  }
+  if (not value.value_ref().has_value()) {
+    // TTL update of compressed value
+    value.isCompressed_ref().reset();
+    return true;
+  }
+
+  try {
+    value.value_ref() = getCodec().uncompress(*value.value_ref());
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to decompress value from " << value.originatorId
+               << ", version " << value.version << ": " << e.what();
+    return false;
+  }
+  value.isCompressed_ref().reset();
+  return true;
+}
+
+bool
+KvStoreValueCompression::hasCompressedValues(const thrift::KeyVals& keyVals) {
+  for (auto const& kv : keyVals) {
+    if (isCompressed(kv.second)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+KvStoreValueCompression::decompressAll(thrift::KeyVals& keyVals) {
+  for (auto it = keyVals.begin(); it != keyVals.end();) {
+    if (decompress(it->second)) {
+      ++it;
+    } else {
+      it = keyVals.erase(it);
+    }
+  }
+}
+
+} // namespace openr
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Compression of KvStore values (see `thrift::Value.isCompressed`). Only
+ * adjacency and prefix databases are compressed, as they are large and highly
+ * repetitive. Hash of compressed value is always computed over uncompressed
+ * content, hence value comparison is unaffected by compression.
+ *
+ * KvStore keeps compressed values as they are, and decompresses them only
+ * when handing over to local consumers or to peers not supporting compression.
+ */
+class KvStoreValueCompression {
+ public:
+  // Values smaller than this are never compressed
+  static constexpr size_t kMinCompressSize{256};
+
+  // Check if value of the key should be compressed
+  static bool shouldCompress(
+      const std::string& key, const thrift::Value& value);
+
+  // Compress value in place. Hash is computed over uncompressed content if
+  // missing. Value is left as is and false is returned if compression
+  // doesn't shrink it.
+  static bool compress(thrift::Value& value);
+
+  // Decompress value in place. Returns false if compressed value is
+  // malformed, leaving value untouched.
+  static bool decompress(thrift::Value& value);
+
+  // Check if any of the values is compressed
+  static bool hasCompressedValues(const thrift::KeyVals& keyVals);
+
+  // Decompress all the values in place. Malformed values are removed
+  static void decompressAll(thrift::KeyVals& keyVals);
+
+  // Check if value is compressed
+  static bool
+  isCompressed(const thrift::Value& value) {
+    return value.isCompressed_ref().value_or(false);
+  }
+};
+
+} // namespace openr
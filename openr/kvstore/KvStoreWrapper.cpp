@@ -26,7 +26,8 @@ KvStoreWrapper::KvStoreWrapper(
     std::shared_ptr<const Config> config,
     std::optional<messaging::RQueue<thrift::PeerUpdateRequest>>
         peerUpdatesQueue,
-    bool enableKvStoreThrift)
+    bool enableKvStoreThrift,
+    PersistentStore* configStore)
     : nodeId(config->getNodeName()),
       globalCmdUrl(folly::sformat("inproc://{}-kvstore-global-cmd", nodeId)),
       enableFloodOptimization_(
@@ -44,7 +45,8 @@ KvStoreWrapper::KvStoreWrapper(
       config,
       std::nullopt /* ip-tos */,
       Constants::kHighWaterMark,
-      enableKvStoreThrift_);
+      enableKvStoreThrift_,
+      configStore);
 }
 
 void
@@ -180,8 +182,7 @@ KvStoreWrapper::recvPublication() {
   if (maybePublication.hasError()) {
     throw std::runtime_error(std::string("recvPublication failed"));
   }
-  auto pub = maybePublication.value();
-  return pub;
+  return *maybePublication.value();
 }
 
 thrift::SptInfos
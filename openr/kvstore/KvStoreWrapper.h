@@ -34,7 +34,8 @@ class KvStoreWrapper {
       std::shared_ptr<const Config> config,
       std::optional<messaging::RQueue<thrift::PeerUpdateRequest>>
           peerUpdatesQueue = std::nullopt,
-      bool enableKvStoreThrift = false);
+      bool enableKvStoreThrift = false,
+      PersistentStore* configStore = nullptr);
 
   ~KvStoreWrapper() {
     stop();
@@ -53,7 +54,7 @@ class KvStoreWrapper {
   /**
    * Get reader for KvStore updates queue
    */
-  messaging::RQueue<thrift::Publication>
+  messaging::RQueue<KvStorePublication>
   getReader() {
     return kvStoreUpdatesQueue_.getReader();
   }
@@ -123,6 +124,14 @@ class KvStoreWrapper {
    */
   thrift::Publication recvPublication();
 
+  /**
+   * Number of publications on PUB queue not received yet
+   */
+  size_t
+  getNumPendingPublications() {
+    return kvStoreUpdatesQueueReader_.size();
+  }
+
   /*
    * Get flooding topology information
    */
@@ -192,8 +201,8 @@ class KvStoreWrapper {
   apache::thrift::CompactSerializer serializer_;
 
   // Queue for streaming KvStore updates
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue_;
-  messaging::RQueue<thrift::Publication> kvStoreUpdatesQueueReader_{
+  messaging::ReplicateQueue<KvStorePublication> kvStoreUpdatesQueue_;
+  messaging::RQueue<KvStorePublication> kvStoreUpdatesQueueReader_{
       kvStoreUpdatesQueue_.getReader()};
 
   // Queue for streaming peer updates from LM
@@ -6,19 +6,26 @@
  */
 
 #include <folly/Benchmark.h>
+#include <sys/resource.h>
 #include <cstdlib>
+#include <thread>
 #include <unordered_set>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
 #include <folly/Random.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/init/Init.h>
 
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/kvstore/KvStore.h>
+#include <openr/kvstore/KvStoreKeyIndex.h>
+#include <openr/kvstore/KvStoreTtlWheel.h>
 #include <openr/kvstore/KvStoreWrapper.h>
 
 namespace {
@@ -47,6 +54,68 @@ genRandomStr(const int len) {
   }
   return s;
 }
+
+// topologies of stores in flooding benchmarks
+enum class FloodTopology {
+  RING,
+  FULL_MESH,
+  // two tiers, with a quarter of the nodes (at least one) being spines peered
+  // with every leaf
+  CLOS,
+};
+
+size_t
+getNumOfSpines(size_t numOfNodes) {
+  return std::max<size_t>(1, numOfNodes / 4);
+}
+
+// peers of each node of the topology
+std::vector<std::vector<size_t>>
+getTopologyPeers(FloodTopology topology, size_t numOfNodes) {
+  std::vector<std::vector<size_t>> peers(numOfNodes);
+  for (size_t i = 0; i < numOfNodes; i++) {
+    for (size_t j = 0; j < numOfNodes; j++) {
+      if (i == j) {
+        continue;
+      }
+      bool isPeer{false};
+      switch (topology) {
+      case FloodTopology::RING:
+        isPeer = (i + 1) % numOfNodes == j or (j + 1) % numOfNodes == i;
+        break;
+      case FloodTopology::FULL_MESH:
+        isPeer = true;
+        break;
+      case FloodTopology::CLOS:
+        isPeer = (i < getNumOfSpines(numOfNodes)) !=
+            (j < getNumOfSpines(numOfNodes));
+        break;
+      }
+      if (isPeer) {
+        peers[i].emplace_back(j);
+      }
+    }
+  }
+  return peers;
+}
+
+// CPU time of the process, i.e. of all stores
+std::chrono::microseconds
+getProcessCpuTime() {
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+      std::chrono::microseconds(
+          usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+// bytes sent by all stores to their peers
+int64_t
+getBytesSentToPeers() {
+  auto counters = fb303::fbData->getCounters();
+  auto it = counters.find("kvstore.peers.bytes_sent.sum");
+  return it != counters.end() ? it->second : 0;
+}
 } // namespace
 
 namespace openr {
@@ -73,15 +142,67 @@ class KvStoreTestFixture {
    * Retured raw pointer of an object will be freed as well.
    */
   KvStoreWrapper*
-  createKvStore(const std::string& nodeId) {
+  createKvStore(
+      const std::string& nodeId,
+      bool enableFloodOptimization = false,
+      bool isFloodRoot = false) {
     auto tConfig = getBasicOpenrConfig(nodeId);
     tConfig.kvstore_config.sync_interval_s = kDbSyncInterval.count();
+    if (enableFloodOptimization) {
+      tConfig.kvstore_config.enable_flood_optimization_ref() = true;
+      tConfig.kvstore_config.is_flood_root_ref() = isFloodRoot;
+    }
     config_ = std::make_shared<Config>(tConfig);
     auto ptr = std::make_unique<KvStoreWrapper>(context, config_);
     stores_.emplace_back(std::move(ptr));
     return stores_.back().get();
   }
 
+  /**
+   * Start stores peered in topology, and wait for their initial syncs. With
+   * flood optimization, spines of CLOS topology (first node otherwise) are
+   * flood roots, and flooding topology is converged too.
+   */
+  std::vector<KvStoreWrapper*>
+  createNetwork(
+      FloodTopology topology,
+      size_t numOfNodes,
+      bool enableFloodOptimization) {
+    const auto peers = getTopologyPeers(topology, numOfNodes);
+    const auto numOfRoots =
+        topology == FloodTopology::CLOS ? getNumOfSpines(numOfNodes) : 1;
+    std::vector<KvStoreWrapper*> stores;
+    for (size_t i = 0; i < numOfNodes; i++) {
+      stores.emplace_back(createKvStore(
+          folly::sformat("node-{}", i),
+          enableFloodOptimization,
+          i < numOfRoots /* isFloodRoot */));
+      stores.back()->run();
+    }
+    for (size_t i = 0; i < numOfNodes; i++) {
+      for (auto j : peers[i]) {
+        CHECK(stores[i]->addPeer(
+            stores[j]->getNodeId(), stores[j]->getPeerSpec()));
+      }
+    }
+
+    for (size_t i = 0; i < numOfNodes; i++) {
+      for (auto j : peers[i]) {
+        while (stores[i]->getPeerState(stores[j]->getNodeId()) !=
+               KvStorePeerState::INITIALIZED) {
+          /* sleep override */
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+      while (enableFloodOptimization and
+             not stores[i]->getFloodTopo().floodRootId_ref().has_value()) {
+        /* sleep override */
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    return stores;
+  }
+
  private:
   // Public member variables
   fbzmq::Context context;
@@ -96,13 +217,14 @@ class KvStoreTestFixture {
  * 1. Randomly choose #numOfUpdateKeys keys from kvStore
  * 2. Randomly choose a newValue for each key
  * 3. Insert (key, newValue)s into update
- * 4. Merge update with kvStore
+ * 4. Merge update with kvStore, deciding merge on mergeExecutor if provided
  */
 void
 updateKvStore(
     const uint32_t numOfUpdateKeys,
     uint64_t& version,
-    std::unordered_map<std::string, thrift::Value>& kvStore) {
+    std::unordered_map<std::string, thrift::Value>& kvStore,
+    folly::CPUThreadPoolExecutor* mergeExecutor = nullptr) {
   auto suspender = folly::BenchmarkSuspender();
   std::unordered_map<std::string, thrift::Value> update;
   // Randomly choose the start index of the keys to be updated
@@ -111,9 +233,9 @@ updateKvStore(
       ? kvStore.size() - numOfUpdateKeys
       : offsetIdx;
 
-  for (uint32_t idx = offsetIdx; idx < offsetIdx + numOfUpdateKeys; idx++) {
-    auto kvIt = kvStore.begin();
-    std::advance(kvIt, idx);
+  auto kvIt = kvStore.begin();
+  std::advance(kvIt, offsetIdx);
+  for (uint32_t idx = 0; idx < numOfUpdateKeys; idx++, kvIt++) {
     auto key = kvIt->first;
     auto newValue = genRandomStr(kSizeOfValue);
     thrift::Value thriftValue(
@@ -134,7 +256,8 @@ updateKvStore(
   suspender.dismiss(); // Start measuring benchmark time
 
   // Merge update with kvStore
-  KvStore::mergeKeyValues(kvStore, update);
+  KvStore::mergeKeyValues(
+      kvStore, update, std::nullopt, nullptr, nullptr, mergeExecutor);
 }
 
 /**
@@ -177,6 +300,52 @@ floodingUpdate(
   CHECK_EQ(numOfUpdateKeys, pub.keyVals.size());
 }
 
+/**
+ * Create keyVals of the keys, all of the given value and version
+ */
+std::vector<std::pair<std::string, thrift::Value>>
+createKeyVals(
+    const std::vector<std::string>& keys,
+    const std::string& value,
+    int64_t version) {
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  keyVals.reserve(keys.size());
+  for (auto const& key : keys) {
+    thrift::Value thriftVal(
+        apache::thrift::FRAGILE,
+        version /* version */,
+        "kvStore" /* originatorId */,
+        value /* value */,
+        Constants::kTtlInfinity /* ttl */,
+        0 /* ttl version */,
+        0 /* hash */);
+    thriftVal.hash_ref() = generateHash(
+        thriftVal.version, thriftVal.originatorId, thriftVal.value_ref());
+    keyVals.emplace_back(key, std::move(thriftVal));
+  }
+  return keyVals;
+}
+
+/**
+ * Receive publications of kvStore until all keys are received with at least
+ * the given version
+ */
+void
+waitForKeys(
+    KvStoreWrapper* kvStore,
+    const std::vector<std::string>& keys,
+    int64_t version) {
+  std::unordered_set<std::string> pendingKeys(keys.begin(), keys.end());
+  while (not pendingKeys.empty()) {
+    auto pub = kvStore->recvPublication();
+    for (auto const& [key, value] : pub.keyVals) {
+      if (value.value_ref().has_value() and value.version >= version) {
+        pendingKeys.erase(key);
+      }
+    }
+  }
+}
+
 /**
  * Benchmark for mergeKeyValues():
  * 1. Generate (key, value) pairs, and put them into kvStore
@@ -184,10 +353,18 @@ floodingUpdate(
  */
 static void
 BM_KvStoreMergeKeyValues(
-    uint32_t iters, uint32_t numOfKeysInStore, size_t numOfUpdateKeys) {
+    uint32_t iters,
+    uint32_t numOfKeysInStore,
+    size_t numOfUpdateKeys,
+    size_t numOfMergeThreads = 0) {
   CHECK_LE(numOfUpdateKeys, numOfKeysInStore);
   auto suspender = folly::BenchmarkSuspender();
   std::unordered_map<std::string, thrift::Value> kvStore;
+  std::unique_ptr<folly::CPUThreadPoolExecutor> mergeExecutor;
+  if (numOfMergeThreads > 0) {
+    mergeExecutor =
+        std::make_unique<folly::CPUThreadPoolExecutor>(numOfMergeThreads);
+  }
 
   // Insert (key, value)s into kvStore
   uint64_t version = 1;
@@ -213,7 +390,7 @@ BM_KvStoreMergeKeyValues(
   version++;
   suspender.dismiss(); // Start measuring benchmark time
   for (uint32_t i = 0; i < iters; i++) {
-    updateKvStore(numOfUpdateKeys, version, kvStore);
+    updateKvStore(numOfUpdateKeys, version, kvStore, mergeExecutor.get());
   }
 }
 
@@ -254,6 +431,51 @@ BM_KvStoreDumpAll(uint32_t iters, size_t numOfKeysInStore) {
   }
 }
 
+/**
+ * Benchmark for a filtered dump:
+ * 1. Start kvStore
+ * 2. Set (key, value)s into kvStore, 1% of them with filtered key prefix
+ * 3. Benchmark the time for dumpAll() with key prefix filter
+ */
+static void
+BM_KvStoreDumpFiltered(uint32_t iters, size_t numOfKeysInStore) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto kvStore = kvStoreTestFixture->createKvStore("kvStore");
+  kvStore->run();
+
+  const std::string keyPrefix{"adj:"};
+  size_t numOfMatchingKeys{0};
+  for (uint32_t idx = 0; idx < numOfKeysInStore; idx++) {
+    auto key = genRandomStr(kSizeOfKey);
+    if (idx % 100 == 0) {
+      key = keyPrefix + key;
+      ++numOfMatchingKeys;
+    }
+    auto value = genRandomStr(kSizeOfValue);
+    thrift::Value thriftVal(
+        apache::thrift::FRAGILE,
+        1 /* version */,
+        "kvStore" /* originatorId */,
+        value /* value */,
+        Constants::kTtlInfinity /* ttl */,
+        0 /* ttl version */,
+        0 /* hash */);
+    thriftVal.hash_ref() = generateHash(
+        thriftVal.version, thriftVal.originatorId, thriftVal.value_ref());
+
+    // Adding key to kvStore
+    kvStore->setKey(key, thriftVal);
+  }
+
+  const KvStoreFilters filters({keyPrefix}, {} /* originatorIds */);
+  suspender.dismiss(); // Start measuring benchmark time
+  for (uint32_t i = 0; i < iters; i++) {
+    auto keyVals = kvStore->dumpAll(filters);
+    CHECK_EQ(numOfMatchingKeys, keyVals.size());
+  }
+}
+
 /**
  * Benchmark for synchronizing update from a peer
  * 1. Start kvStore
@@ -284,6 +506,172 @@ BM_KvStoreFloodingUpdate(uint32_t iters, size_t numOfUpdateKeys) {
   }
 }
 
+/**
+ * Benchmark for flooding through a network of stores:
+ * 1. Start stores peered in topology, and wait for them to sync
+ * 2. Set keys into one store and wait until they appear in all stores
+ * 3. Log bytes flooded per key update, and CPU per node per update burst
+ */
+static void
+BM_KvStoreFloodingNetwork(
+    uint32_t iters,
+    FloodTopology topology,
+    size_t numOfNodes,
+    size_t numOfUpdateKeys,
+    bool enableFloodOptimization) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto stores = kvStoreTestFixture->createNetwork(
+      topology, numOfNodes, enableFloodOptimization);
+
+  std::vector<std::string> keys;
+  keys.reserve(numOfUpdateKeys);
+  for (uint32_t idx = 0; idx < numOfUpdateKeys; idx++) {
+    keys.emplace_back(genRandomStr(kSizeOfKey));
+  }
+  const auto value = genRandomStr(kSizeOfValue);
+
+  const auto bytesSentBefore = getBytesSentToPeers();
+  const auto cpuTimeBefore = getProcessCpuTime();
+  for (uint32_t i = 0; i < iters; i++) {
+    // Version starts with 1
+    const int64_t version = i + 1;
+    auto keyVals = createKeyVals(keys, value, version);
+    suspender.dismiss(); // Start measuring benchmark time
+    stores.back()->setKeys(keyVals);
+    for (auto kvStore : stores) {
+      waitForKeys(kvStore, keys, version);
+    }
+    suspender.rehire(); // Stop measuring time again
+  }
+
+  const auto bytesSent = getBytesSentToPeers() - bytesSentBefore;
+  const auto cpuTime = getProcessCpuTime() - cpuTimeBefore;
+  LOG(INFO) << "Flooded " << bytesSent / (iters * numOfUpdateKeys)
+            << " bytes per key update, "
+            << cpuTime.count() / (iters * numOfNodes)
+            << "us of CPU per node per update of " << numOfUpdateKeys
+            << " keys";
+}
+
+/**
+ * Benchmark for full sync of a newly joined peer:
+ * 1. Start stores peered in topology, holding keys set into one of them
+ * 2. Peer a new store with another one and wait until it received all keys
+ */
+static void
+BM_KvStoreFullSync(
+    uint32_t iters,
+    FloodTopology topology,
+    size_t numOfNodes,
+    size_t numOfKeys,
+    bool enableFloodOptimization) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto stores = kvStoreTestFixture->createNetwork(
+      topology, numOfNodes, enableFloodOptimization);
+
+  std::vector<std::string> keys;
+  keys.reserve(numOfKeys);
+  for (uint32_t idx = 0; idx < numOfKeys; idx++) {
+    keys.emplace_back(genRandomStr(kSizeOfKey));
+  }
+  stores.back()->setKeys(
+      createKeyVals(keys, genRandomStr(kSizeOfValue), 1 /* version */));
+  for (auto kvStore : stores) {
+    waitForKeys(kvStore, keys, 1 /* version */);
+  }
+
+  auto peer = stores.front();
+  for (uint32_t i = 0; i < iters; i++) {
+    auto newStore = kvStoreTestFixture->createKvStore(
+        folly::sformat("new-node-{}", i), enableFloodOptimization);
+    newStore->run();
+    suspender.dismiss(); // Start measuring benchmark time
+    newStore->addPeer(peer->getNodeId(), peer->getPeerSpec());
+    peer->addPeer(newStore->getNodeId(), newStore->getPeerSpec());
+    waitForKeys(newStore, keys, 1 /* version */);
+    suspender.rehire(); // Stop measuring time again
+    peer->delPeer(newStore->getNodeId());
+    newStore->stop();
+  }
+}
+
+/**
+ * Benchmark for TTL refresh and expiry tracking:
+ * 1. Schedule expiry of keys in TTL wheel
+ * 2. Refresh TTL of all the keys every ttl/4 (simulated time), and advance
+ *    the wheel to expire keys
+ */
+static void
+BM_KvStoreTtlRefresh(uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto ttl = Constants::kKvStoreDbTtl;
+  auto now = std::chrono::steady_clock::now();
+  KvStoreTtlWheel ttlWheel(now);
+
+  std::vector<TtlCountdownQueueEntry> entries(numOfKeys);
+  for (size_t idx = 0; idx < numOfKeys; idx++) {
+    entries[idx].key = genRandomStr(kSizeOfKey);
+    entries[idx].originatorId = "kvStore";
+    entries[idx].expiryTime = now + ttl;
+    ttlWheel.schedule(entries[idx]);
+  }
+
+  suspender.dismiss(); // Start measuring benchmark time
+  for (uint32_t i = 0; i < iters; i++) {
+    now += ttl / 4;
+    for (auto& entry : entries) {
+      entry.ttlVersion++;
+      entry.expiryTime = now + ttl;
+      ttlWheel.schedule(entry);
+    }
+    CHECK(ttlWheel.expire(now).empty());
+  }
+  CHECK_EQ(numOfKeys, ttlWheel.size());
+}
+
+/**
+ * Benchmark for building key index, and report of its memory:
+ * 1. Generate prefix keys of 1000 nodes into kvStore
+ * 2. Benchmark the time to index all the keys
+ * 3. Log approximate bytes held by kvStore and the index
+ */
+static void
+BM_KvStoreKeyIndex(uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::unordered_map<std::string, thrift::Value> kvStore;
+  for (size_t idx = 0; idx < numOfKeys; idx++) {
+    const auto nodeName = folly::sformat("node-{}", idx % 1000);
+    kvStore.emplace(
+        folly::sformat(
+            "{}{}:[0]:[fc00::{:x}:{:x}/128]",
+            Constants::kPrefixDbMarker,
+            nodeName,
+            idx >> 16,
+            idx & 0xffff),
+        createThriftValue(1, nodeName, genRandomStr(kSizeOfKey)));
+  }
+
+  KvStoreKeyIndex keyIndex;
+  for (uint32_t i = 0; i < iters; i++) {
+    keyIndex.clear();
+    suspender.dismiss(); // Start measuring benchmark time
+    for (auto const& [key, value] : kvStore) {
+      keyIndex.add(key, value);
+    }
+    suspender.rehire(); // Stop measuring time again
+  }
+  CHECK_EQ(numOfKeys, keyIndex.size());
+
+  size_t kvStoreBytes{0};
+  for (auto const& [key, value] : kvStore) {
+    kvStoreBytes += getMemoryUsage(key) + getMemoryUsage(value);
+  }
+  LOG(INFO) << "Memory of " << numOfKeys << " keys, kvStore: " << kvStoreBytes
+            << " bytes, key index: " << keyIndex.getMemoryUsage() << " bytes";
+}
+
 // The first integer parameter is number of keyVals already in store
 // The second integer parameter is the number of keyVals for update
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10_10, 10, 10);
@@ -293,6 +681,14 @@ BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_10, 10000, 10);
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_100, 10000, 100);
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_1000, 10000, 1000);
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_10000, 10000, 10000);
+BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 100000_100000, 100000, 100000);
+// The third integer parameter is the number of threads deciding merge
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreMergeKeyValues, 100000_100000_2, 100000, 100000, 2);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreMergeKeyValues, 100000_100000_4, 100000, 100000, 4);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreMergeKeyValues, 100000_100000_8, 100000, 100000, 8);
 
 // The parameter is number of keyVals already in store
 BENCHMARK_PARAM(BM_KvStoreDumpAll, 10);
@@ -300,12 +696,97 @@ BENCHMARK_PARAM(BM_KvStoreDumpAll, 100);
 BENCHMARK_PARAM(BM_KvStoreDumpAll, 1000);
 BENCHMARK_PARAM(BM_KvStoreDumpAll, 10000);
 
+// The parameter is number of keyVals already in store
+BENCHMARK_PARAM(BM_KvStoreDumpFiltered, 100);
+BENCHMARK_PARAM(BM_KvStoreDumpFiltered, 1000);
+BENCHMARK_PARAM(BM_KvStoreDumpFiltered, 10000);
+
+// The parameter is number of keys refreshed
+BENCHMARK_PARAM(BM_KvStoreTtlRefresh, 1000);
+BENCHMARK_PARAM(BM_KvStoreTtlRefresh, 10000);
+BENCHMARK_PARAM(BM_KvStoreTtlRefresh, 100000);
+
+// The parameter is number of keys in store
+BENCHMARK_PARAM(BM_KvStoreKeyIndex, 10000);
+BENCHMARK_PARAM(BM_KvStoreKeyIndex, 1000000);
+
 // The parameter is number of keyVals for update
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 10);
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 100);
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 1000);
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 10000);
 
+// The parameters are topology, number of nodes, number of keyVals for update
+// and whether flood optimization is enabled
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Ring_16_100,
+    FloodTopology::RING,
+    16,
+    100,
+    false);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Ring_16_100_FloodOpt,
+    FloodTopology::RING,
+    16,
+    100,
+    true);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    FullMesh_16_100,
+    FloodTopology::FULL_MESH,
+    16,
+    100,
+    false);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    FullMesh_16_100_FloodOpt,
+    FloodTopology::FULL_MESH,
+    16,
+    100,
+    true);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Clos_16_100,
+    FloodTopology::CLOS,
+    16,
+    100,
+    false);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Clos_16_100_FloodOpt,
+    FloodTopology::CLOS,
+    16,
+    100,
+    true);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Clos_64_100,
+    FloodTopology::CLOS,
+    64,
+    100,
+    false);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFloodingNetwork,
+    Clos_64_100_FloodOpt,
+    FloodTopology::CLOS,
+    64,
+    100,
+    true);
+
+// The parameters are topology, number of nodes, number of keyVals in store
+// and whether flood optimization is enabled
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFullSync, Clos_16_10000, FloodTopology::CLOS, 16, 10000, false);
+BENCHMARK_NAMED_PARAM(
+    BM_KvStoreFullSync,
+    Clos_16_10000_FloodOpt,
+    FloodTopology::CLOS,
+    16,
+    10000,
+    true);
+
 } // namespace openr
 
 int
@@ -676,6 +676,69 @@ TEST(KvStoreClientInternal, PersistKeyTest) {
   evbThread.join();
 }
 
+/**
+ * Test that TTL refreshes of keys persisted together are jittered, i.e.
+ * spread over multiple batches instead of a single one for all the keys
+ */
+TEST(KvStoreClientInternal, TtlRefreshSpreadTest) {
+  fbzmq::Context context;
+  folly::Baton waitBaton;
+  const std::string nodeId{"test_store"};
+  const size_t numKeys{100};
+  const std::chrono::milliseconds ttl{2000};
+
+  auto config = std::make_shared<Config>(getBasicOpenrConfig(nodeId));
+  auto store = std::make_shared<KvStoreWrapper>(context, config);
+  store->run();
+
+  OpenrEventBase evb;
+  auto client = std::make_shared<KvStoreClientInternal>(
+      &evb, nodeId, store->getKvStore());
+
+  evb.scheduleTimeout(std::chrono::milliseconds(0), [&]() noexcept {
+    for (size_t i = 0; i < numKeys; ++i) {
+      client->persistKey(folly::sformat("test_key{}", i), "test_value", ttl);
+    }
+  });
+
+  // first refreshes are due within [3/16, 1/4] of ttl, next ones not before
+  // 3/8 of ttl
+  evb.scheduleTimeout(ttl / 4 + std::chrono::milliseconds(100), [&]() {
+    waitBaton.post();
+  });
+
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+  waitBaton.wait();
+
+  // count publications of TTL refreshes, all keys refreshed once
+  size_t numRefreshBatches{0};
+  std::unordered_set<std::string> refreshedKeys;
+  while (store->getNumPendingPublications()) {
+    auto publication = store->recvPublication();
+    bool isRefresh{false};
+    for (auto const& [key, value] : publication.keyVals) {
+      if (not value.value_ref().has_value()) {
+        EXPECT_EQ(1, value.ttlVersion);
+        refreshedKeys.emplace(key);
+        isRefresh = true;
+      }
+    }
+    numRefreshBatches += isRefresh ? 1 : 0;
+  }
+  EXPECT_EQ(numKeys, refreshedKeys.size());
+  EXPECT_LT(1, numRefreshBatches);
+
+  store->closeQueue();
+  client.reset();
+  store->stop();
+  store.reset();
+
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+}
+
 /**
  * Test ttl change with persist key while keeping value and version same
  * - Set key with ttl 1s
@@ -1549,6 +1612,57 @@ TEST_F(MultipleAreaFixture, PersistKeyArea) {
   waitBaton.wait();
 }
 
+TEST_F(MultipleAreaFixture, BatchedWrites) {
+  folly::Baton waitBaton;
+
+  evb.scheduleTimeout(std::chrono::milliseconds(0), [&]() noexcept {
+    client2->setKey(
+        "test_clear_key",
+        "test_value",
+        1 /* version */,
+        Constants::kTtlInfInterval,
+        podArea);
+  });
+
+  evb.scheduleTimeout(std::chrono::milliseconds(10), [&]() noexcept {
+    client2->startBatch();
+    client2->persistKey(
+        "test_key_plane",
+        "test_value_plane",
+        Constants::kTtlInfInterval,
+        planeArea);
+    client2->persistKey(
+        "test_key_pod", "test_value_pod", Constants::kTtlInfInterval, podArea);
+    client2->clearKey(
+        "test_clear_key", "", Constants::kTtlInfInterval, podArea);
+
+    // nothing is written till batch is flushed
+    EXPECT_FALSE(client2->getKey("test_key_plane", planeArea).has_value());
+    EXPECT_FALSE(client2->getKey("test_key_pod", podArea).has_value());
+    EXPECT_EQ(1, client2->getKey("test_clear_key", podArea)->version);
+
+    client2->flushBatch();
+    auto planeValue = client2->getKey("test_key_plane", planeArea);
+    ASSERT_TRUE(planeValue.has_value());
+    EXPECT_EQ("test_value_plane", planeValue->value_ref().value());
+    auto podValue = client2->getKey("test_key_pod", podArea);
+    ASSERT_TRUE(podValue.has_value());
+    EXPECT_EQ("test_value_pod", podValue->value_ref().value());
+    auto clearedValue = client2->getKey("test_clear_key", podArea);
+    ASSERT_TRUE(clearedValue.has_value());
+    EXPECT_EQ(2, clearedValue->version);
+    EXPECT_EQ("", clearedValue->value_ref().value());
+    waitBaton.post();
+  });
+
+  // Start the event loop and wait until it is finished execution.
+  evbThread = std::thread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  // Synchronization primitive
+  waitBaton.wait();
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <thread>
 #include <tuple>
@@ -28,6 +29,7 @@
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/kvstore/KvStore.h>
 #include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/messaging/ReplicateQueue.h>
 
 using namespace openr;
 using apache::thrift::CompactSerializer;
@@ -365,6 +367,7 @@ TEST_F(KvStoreTestFixture, CounterReport) {
   // Verify the counter keys exist
   ASSERT_EQ(1, counters.count("kvstore.num_peers"));
   ASSERT_EQ(1, counters.count("kvstore.pending_full_sync"));
+  ASSERT_EQ(1, counters.count("kvstore.flood.peer_queue_depth"));
   ASSERT_EQ(1, counters.count("kvstore.cmd_peer_dump.count"));
   ASSERT_EQ(1, counters.count("kvstore.cmd_peer_add.count"));
   ASSERT_EQ(1, counters.count("kvstore.cmd_per_del.count"));
@@ -384,6 +387,7 @@ TEST_F(KvStoreTestFixture, CounterReport) {
   // Verify the value of counter keys
   EXPECT_EQ(0, counters.at("kvstore.num_peers"));
   EXPECT_EQ(0, counters.at("kvstore.pending_full_sync"));
+  EXPECT_EQ(0, counters.at("kvstore.flood.peer_queue_depth"));
   EXPECT_EQ(0, counters.at("kvstore.cmd_peer_dump.count"));
   EXPECT_EQ(0, counters.at("kvstore.cmd_peer_add.count"));
   EXPECT_EQ(0, counters.at("kvstore.cmd_per_del.count"));
@@ -475,6 +479,12 @@ TEST_F(KvStoreTestFixture, TtlVerification) {
     EXPECT_EQ(0, publication.keyVals.size());
     ASSERT_EQ(1, publication.expiredKeys.size());
     EXPECT_EQ(key, publication.expiredKeys.at(0));
+
+    // node1 has no keys left, so it is reported as an expired originator
+    ASSERT_TRUE(publication.expiredOriginators_ref().has_value());
+    EXPECT_EQ(
+        std::vector<std::string>{"node1"},
+        *publication.expiredOriginators_ref());
   }
 
   //
@@ -691,6 +701,67 @@ TEST_F(KvStoreTestFixture, TtlVerification) {
   kvStore->stop();
 }
 
+/**
+ * Verify key-values are restored from warm start snapshot in config-store
+ * with aged TTLs, and own key-values are not restored
+ */
+TEST_F(KvStoreTestFixture, WarmStart) {
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+  const auto filePath = folly::sformat("/tmp/kvstore_warm_start_{}", tid);
+  std::remove(filePath.c_str());
+  std::remove((filePath + ".wal").c_str());
+  PersistentStore configStore(
+      "node1", filePath, context, false, false /*periodicallySaveToDisk*/);
+  std::thread configStoreThread([&]() { configStore.run(); });
+  configStore.waitUntilRunning();
+
+  auto kvConf = getTestKvConf();
+  kvConf.warm_start_snapshot_interval_s_ref() = 1;
+  auto tConfig = getBasicOpenrConfig("node1");
+  tConfig.kvstore_config = kvConf;
+  auto config = std::make_shared<Config>(tConfig);
+
+  const int64_t ttl = 60000;
+  const auto remoteValue =
+      createThriftValue(1, "node2", std::string("value2"), ttl);
+  const auto ownValue =
+      createThriftValue(1, "node1", std::string("value1"), ttl);
+  {
+    KvStoreWrapper store(context, config, std::nullopt, false, &configStore);
+    store.run();
+    EXPECT_TRUE(store.setKey("key2", remoteValue));
+    EXPECT_TRUE(store.setKey("key1", ownValue));
+    // Wait for snapshot
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    store.stop();
+  }
+
+  {
+    KvStoreWrapper store(context, config, std::nullopt, false, &configStore);
+    store.run();
+
+    // Restored key-values are published as warm start before any peer sync
+    auto publication = store.recvPublication();
+    EXPECT_TRUE(publication.warmStart_ref().value_or(false));
+    ASSERT_EQ(1, publication.keyVals.size());
+    ASSERT_EQ(1, publication.keyVals.count("key2"));
+
+    auto maybeValue = store.getKey("key2");
+    ASSERT_TRUE(maybeValue.has_value());
+    EXPECT_EQ("value2", maybeValue->value_ref().value());
+    EXPECT_EQ(remoteValue.version, maybeValue->version);
+    EXPECT_EQ(remoteValue.originatorId, maybeValue->originatorId);
+    EXPECT_GT(ttl, maybeValue->ttl);
+    EXPECT_FALSE(store.getKey("key1").has_value());
+    store.stop();
+  }
+
+  configStore.stop();
+  configStoreThread.join();
+  std::remove(filePath.c_str());
+  std::remove((filePath + ".wal").c_str());
+}
+
 TEST_F(KvStoreTestFixture, LeafNode) {
   auto store0Conf = getTestKvConf();
   store0Conf.set_leaf_node_ref() = true;
@@ -1100,6 +1171,13 @@ TEST_F(KvStoreTestFixture, DualTest) {
   /* sleep override */
   std::this_thread::sleep_for(std::chrono::seconds(1));
 
+  // dual messages of all roots are sent in batches, one per neighbor
+  {
+    auto counters = fb303::fbData->getCounters();
+    EXPECT_LT(0, counters.at("kvstore.dual.batches_sent.count"));
+    EXPECT_LE(1, counters.at("kvstore.dual.batch_size.avg"));
+  }
+
   // helper function to validate all roots up case
   // everybody should pick r0 as spt root
   auto validateAllRootsUpCase = [&]() {
@@ -2017,6 +2095,151 @@ TEST_F(KvStoreTestFixture, DumpPrefix) {
   EXPECT_EQ(expectedKeyVals, myStore->dumpAll(std::move(kvFilters)));
 }
 
+/**
+ * Start two stores running every area on its own thread, peered in two areas.
+ * Verify that keys are synced within each area, and that counters and
+ * multi-area dumps gather all the areas.
+ */
+TEST_F(KvStoreTestFixture, AreaThreads) {
+  thrift::AreaConfig pod, plane;
+  pod.area_id = "pod-area";
+  pod.neighbor_regexes.emplace_back(".*");
+  plane.area_id = "plane-area";
+  plane.neighbor_regexes.emplace_back(".*");
+
+  auto kvConf = getTestKvConf();
+  kvConf.enable_area_threads_ref() = true;
+  auto storeA = createKvStore("storeA", kvConf, {pod, plane});
+  auto storeB = createKvStore("storeB", kvConf, {pod, plane});
+  storeA->run();
+  storeB->run();
+  EXPECT_EQ(2, storeA->getKvStore()->getAreaEvbs().size());
+
+  for (auto const& area : {pod.area_id, plane.area_id}) {
+    EXPECT_TRUE(storeA->addPeer("storeB", storeB->getPeerSpec(), area));
+    EXPECT_TRUE(storeB->addPeer("storeA", storeA->getPeerSpec(), area));
+  }
+
+  auto thriftVal = createThriftValue(
+      1 /* version */,
+      "storeA" /* originatorId */,
+      std::string("value") /* value */,
+      Constants::kTtlInfinity /* ttl */);
+  EXPECT_TRUE(storeA->setKey("pod-key", thriftVal, std::nullopt, pod.area_id));
+  EXPECT_TRUE(
+      storeA->setKey("plane-key", thriftVal, std::nullopt, plane.area_id));
+
+  // keys are synced in their own areas only
+  while (not storeB->getKey("pod-key", pod.area_id).has_value() or
+         not storeB->getKey("plane-key", plane.area_id).has_value()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(storeB->getKey("pod-key", plane.area_id).has_value());
+  EXPECT_FALSE(storeB->getKey("plane-key", pod.area_id).has_value());
+
+  EXPECT_EQ(2, storeB->getCounters().at("kvstore.num_keys"));
+  auto pubs = storeB->getKvStore()->dumpKvStoreKeysAreas({}).get();
+  ASSERT_EQ(2, pubs->size());
+  EXPECT_EQ(1, pubs->at(pod.area_id).keyVals.count("pod-key"));
+  EXPECT_EQ(1, pubs->at(plane.area_id).keyVals.count("plane-key"));
+}
+
+/**
+ * Start single testable store, and set key values. Verify that only hashes of
+ * requested keys are returned, without their values.
+ */
+TEST_F(KvStoreTestFixture, GetKeyHashes) {
+  auto store = createKvStore("test-store");
+  store->run();
+
+  thrift::Value thriftVal(
+      apache::thrift::FRAGILE,
+      1 /* version */,
+      "gotham_city" /* originatorId */,
+      "test-value",
+      Constants::kTtlInfinity /* ttl */,
+      0 /* ttl version */,
+      0 /* hash */);
+  store->setKey("test-key-1", thriftVal);
+  store->setKey("test-key-2", thriftVal);
+
+  thrift::KeyGetParams params;
+  params.keys = {"test-key-1", "test-key-3"};
+  auto pub = store->getKvStore()->getKvStoreKeyHashes(params).get();
+  ASSERT_EQ(1, pub->keyVals.size());
+  auto const& value = pub->keyVals.at("test-key-1");
+  EXPECT_FALSE(value.value_ref().has_value());
+  EXPECT_EQ(1, value.version);
+  EXPECT_EQ("gotham_city", value.originatorId);
+  EXPECT_EQ(
+      generateHash(
+          thriftVal.version, thriftVal.originatorId, thriftVal.value_ref()),
+      value.hash_ref().value());
+}
+
+/**
+ * Dump keys and hashes in pages. Every matching key is returned exactly once
+ * and in order, and last page carries no continuation token.
+ */
+TEST_F(KvStoreTestFixture, PagedDump) {
+  auto store = createKvStore("test-store");
+  store->run();
+
+  thrift::Value thriftVal(
+      apache::thrift::FRAGILE,
+      1 /* version */,
+      "gotham_city" /* originatorId */,
+      "test-value",
+      Constants::kTtlInfinity /* ttl */,
+      0 /* ttl version */,
+      0 /* hash */);
+  for (int i = 0; i < 5; ++i) {
+    store->setKey(folly::sformat("test-key-{}", i), thriftVal);
+  }
+  store->setKey("other-key", thriftVal);
+
+  auto dumpPages = [&](bool hashOnly) {
+    std::vector<std::vector<std::string>> pages;
+    thrift::KeyDumpParams params;
+    params.prefix = "test-key-";
+    params.pageSize_ref() = 2;
+    while (true) {
+      auto pub = hashOnly
+          ? store->getKvStore()->dumpKvStoreHashes(params).get()
+          : store->getKvStore()->dumpKvStoreKeys(params).get();
+      std::vector<std::string> keys;
+      for (auto const& [key, value] : pub->keyVals) {
+        EXPECT_EQ(hashOnly, not value.value_ref().has_value());
+        keys.emplace_back(key);
+      }
+      std::sort(keys.begin(), keys.end());
+      pages.emplace_back(std::move(keys));
+      if (not pub->nextPageToken_ref().has_value()) {
+        break;
+      }
+      params.pageToken_ref() = *pub->nextPageToken_ref();
+    }
+    return pages;
+  };
+
+  const std::vector<std::vector<std::string>> expected{
+      {"test-key-0", "test-key-1"},
+      {"test-key-2", "test-key-3"},
+      {"test-key-4"}};
+  EXPECT_EQ(expected, dumpPages(false /* hashOnly */));
+  EXPECT_EQ(expected, dumpPages(true /* hashOnly */));
+
+  // token of a key gone in between pages, dump resumes from next key
+  thrift::KeyDumpParams params;
+  params.pageSize_ref() = 10;
+  params.pageToken_ref() = "test-key-10";
+  auto pub = store->getKvStore()->dumpKvStoreKeys(params).get();
+  EXPECT_EQ(3, pub->keyVals.size());
+  EXPECT_EQ(0, pub->keyVals.count("test-key-1"));
+  EXPECT_EQ(1, pub->keyVals.count("test-key-2"));
+  EXPECT_FALSE(pub->nextPageToken_ref().has_value());
+}
+
 /**
  * Start single testable store, and set key values.
  * Try to request for KEY_DUMP with a few keyValHashes.
@@ -2146,6 +2369,169 @@ TEST_F(KvStoreTestFixture, OneWaySetKey) {
   EXPECT_EQ(expectedKeyVals, myStore->dumpAll());
 }
 
+/**
+ * Filtered subscriber only gets key-values matching its filters, and isn't
+ * woken up by publications without any
+ */
+TEST_F(KvStoreTestFixture, FilteredSubscription) {
+  auto myStore = createKvStore("test-node1");
+  myStore->run();
+  auto reader = myStore->getKvStore()->getKvStoreUpdatesReader(
+      KvStoreFilters({Constants::kAdjDbMarker.toString()}, {}));
+
+  const auto ttl = Constants::kTtlInfinity;
+  myStore->setKey(
+      "prefix:node2", createThriftValue(1, "node2", std::string("p"), ttl));
+  myStore->setKey(
+      "adj:node2", createThriftValue(1, "node2", std::string("a"), ttl));
+
+  auto maybePub = reader.get();
+  ASSERT_TRUE(maybePub.hasValue());
+  auto const& pub = *maybePub.value();
+  EXPECT_EQ(1, pub.keyVals.size());
+  EXPECT_EQ(1, pub.keyVals.count("adj:node2"));
+  EXPECT_EQ(0, reader.size());
+  EXPECT_EQ(
+      1,
+      fb303::fbData->getCounters().at(
+          "kvstore.subscription.filtered_publications.sum"));
+}
+
+/**
+ * Peer additions queued by LinkMonitor are coalesced and applied as a single
+ * batch
+ */
+TEST_F(KvStoreTestFixture, BatchedPeerAdditions) {
+  std::vector<KvStoreWrapper*> peerStores;
+  for (int i = 0; i < 3; ++i) {
+    peerStores.emplace_back(createKvStore(getNodeId("peer-node", i)));
+    peerStores.back()->run();
+  }
+
+  messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue;
+  auto config = std::make_shared<Config>(getBasicOpenrConfig("test-node1"));
+  auto myStore = std::make_unique<KvStoreWrapper>(
+      context, config, peerUpdatesQueue.getReader());
+
+  // one request per peer, queued before KvStore reads any of them
+  for (auto* peerStore : peerStores) {
+    thrift::PeerUpdateRequest req;
+    req.area = thrift::KvStore_constants::kDefaultArea();
+    thrift::PeerAddParams params;
+    params.peers.emplace(peerStore->getNodeId(), peerStore->getPeerSpec());
+    req.peerAddParams_ref() = std::move(params);
+    peerUpdatesQueue.push(std::move(req));
+  }
+  myStore->run();
+
+  // wait until all peers are added
+  while (myStore->getPeers().size() < peerStores.size()) {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(
+      3, fb303::fbData->getCounters().at("kvstore.peer_add_batch_size.avg"));
+
+  peerUpdatesQueue.close();
+  myStore->stop();
+}
+
+/**
+ * Same key-value flooded over redundant paths is dropped before merge as
+ * duplicate, while its newer version is merged
+ */
+TEST_F(KvStoreTestFixture, FloodDedup) {
+  auto myStore = createKvStore("test-node1");
+  myStore->run();
+
+  const std::string key{"test-key"};
+  auto thriftVal = createThriftValue(
+      1 /* version */, "node2" /* originatorId */, "value1" /* value */);
+  thriftVal.hash_ref() =
+      generateHash(thriftVal.version, "node2", thriftVal.value_ref());
+
+  // counters are shared by all stores of the process
+  const std::string kCounter{"kvstore.flood.duplicates_suppressed.sum"};
+  auto counters = fb303::fbData->getCounters();
+  const auto numDuplicates =
+      counters.count(kCounter) ? counters.at(kCounter) : 0;
+
+  // first delivery is merged, the same one over other path is duplicate
+  myStore->setKey(key, thriftVal, std::vector<std::string>{"node2", "peer1"});
+  myStore->setKey(key, thriftVal, std::vector<std::string>{"node2", "peer2"});
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(numDuplicates + 1, counters.at(kCounter));
+  EXPECT_EQ(1, counters.at("kvstore.flood.duplicates_suppressed.peer2.sum"));
+  EXPECT_EQ(0, counters.count("kvstore.flood.duplicates_suppressed.peer1.sum"));
+
+  // newer version isn't a duplicate
+  thriftVal.version = 2;
+  thriftVal.value_ref() = "value2";
+  thriftVal.hash_ref() =
+      generateHash(thriftVal.version, "node2", thriftVal.value_ref());
+  myStore->setKey(key, thriftVal, std::vector<std::string>{"node2", "peer2"});
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(numDuplicates + 1, counters.at(kCounter));
+  auto value = myStore->getKey(key);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(2, value->version);
+
+  // local update (without nodeIds) is never deduplicated
+  myStore->setKey(key, thriftVal);
+  counters = fb303::fbData->getCounters();
+  EXPECT_EQ(numDuplicates + 1, counters.at(kCounter));
+}
+
+/**
+ * Origination time of key-values is carried unchanged along the flood, and
+ * hop count is incremented on every hop
+ */
+TEST_F(KvStoreTestFixture, FloodOriginTimestamp) {
+  auto store0 = createKvStore("store0");
+  auto store1 = createKvStore("store1");
+  store0->run();
+  store1->run();
+  EXPECT_TRUE(store0->addPeer(store1->getNodeId(), store1->getPeerSpec()));
+  EXPECT_TRUE(store1->addPeer(store0->getNodeId(), store0->getPeerSpec()));
+
+  // received publication of the key, skipping the others
+  auto recvKey = [](KvStoreWrapper* store, std::string const& key) {
+    while (true) {
+      auto publication = store->recvPublication();
+      if (publication.keyVals.count(key)) {
+        return publication;
+      }
+    }
+  };
+
+  // wait for initial sync, key-values learnt through it are originated by
+  // the syncing store
+  auto thriftVal = createThriftValue(1, "store0", "marker");
+  thriftVal.hash_ref() =
+      generateHash(thriftVal.version, "store0", thriftVal.value_ref());
+  EXPECT_TRUE(store0->setKey("marker", thriftVal));
+  recvKey(store1, "marker");
+
+  const auto startTimeMs = getUnixTimeStampMs();
+  const std::string key{"adj:store0"};
+  thriftVal = createThriftValue(1, "store0", "value1");
+  thriftVal.hash_ref() =
+      generateHash(thriftVal.version, "store0", thriftVal.value_ref());
+  EXPECT_TRUE(store0->setKey(key, thriftVal));
+
+  // originated with no hops by store0
+  auto publication = recvKey(store0, key);
+  ASSERT_TRUE(publication.originTimestampMs_ref().has_value());
+  EXPECT_LE(startTimeMs, *publication.originTimestampMs_ref());
+  EXPECT_EQ(0, publication.floodHopCount_ref().value_or(-1));
+  const auto originTimestampMs = *publication.originTimestampMs_ref();
+
+  // flooded to store1 as is, one hop away
+  publication = recvKey(store1, key);
+  EXPECT_EQ(originTimestampMs, publication.originTimestampMs_ref().value_or(0));
+  EXPECT_EQ(1, publication.floodHopCount_ref().value_or(-1));
+}
+
 /*
  * check key value is decremented with the TTL decrement value provided,
  * and is not synced if remaining TTL is < TTL decrement value provided
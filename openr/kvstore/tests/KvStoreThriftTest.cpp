@@ -8,6 +8,7 @@
 #include <sodium.h>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
@@ -17,12 +18,15 @@
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/kvstore/KvStoreHashTree.h>
 #include <openr/kvstore/KvStoreUtil.h>
 #include <openr/kvstore/KvStoreWrapper.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 
 using namespace openr;
 
+namespace fb303 = facebook::fb303;
+
 class KvStoreThriftTestFixture : public ::testing::Test {
  public:
   void
@@ -55,8 +59,9 @@ class KvStoreThriftTestFixture : public ::testing::Test {
   }
 
   void
-  createKvStore(const std::string& nodeId) {
+  createKvStore(const std::string& nodeId, int32_t floodBatchMs = 0) {
     auto tConfig = getBasicOpenrConfig(nodeId);
+    tConfig.kvstore_config.flood_batch_ms_ref() = floodBatchMs;
     stores_.emplace_back(std::make_shared<KvStoreWrapper>(
         context_,
         std::make_shared<Config>(tConfig),
@@ -303,6 +308,114 @@ TEST_F(SimpleKvStoreThriftTestFixture, InitialThriftSync) {
   EXPECT_EQ(0, store2->getPeers().size());
 }
 
+//
+// Initial full-sync over thrift with hash tree digests exchanged first
+//
+// 1) Start 2 kvStores with common and mutually exclusive keys;
+// 2) Add peer to each other with hash-tree sync capability;
+// 3) Make sure full-sync is performed and hash trees are identical;
+//
+TEST_F(SimpleKvStoreThriftTestFixture, HashTreeThriftSync) {
+  // create 2 nodes topology for thrift peers
+  createSimpleThriftTestTopo();
+  auto store1 = stores_.front();
+  auto store2 = stores_.back();
+
+  // inject common keys to both stores
+  for (int i = 0; i < 10; ++i) {
+    const auto key = folly::sformat("common-key-{}", i);
+    auto thriftVal = createThriftValue(1, node1, std::string("value"));
+    EXPECT_TRUE(store1->setKey(key, thriftVal));
+    EXPECT_TRUE(store2->setKey(key, thriftVal));
+  }
+
+  auto peerSpec1 = createPeerSpec(
+      "inproc://dummy-spec-1", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  auto peerSpec2 = createPeerSpec(
+      "inproc://dummy-spec-2", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.front()->getOpenrCtrlThriftPort());
+  peerSpec1.supportHashTreeSync = true;
+  peerSpec2.supportHashTreeSync = true;
+
+  EXPECT_TRUE(store1->addPeer(store2->getNodeId(), peerSpec1));
+  EXPECT_TRUE(store2->addPeer(store1->getNodeId(), peerSpec2));
+
+  // verifying keys are exchanged between peers
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store1.get(), store2->getNodeId(), KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store2.get(), store1->getNodeId(), KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStoreKeyVal(store1.get(), key2, thriftVal2));
+  EXPECT_TRUE(verifyKvStoreKeyVal(store2.get(), key1, thriftVal1));
+
+  EXPECT_EQ(12, store1->dumpAll().size());
+  EXPECT_EQ(12, store2->dumpAll().size());
+
+  // request bucket digests with bogus root digest and compare them
+  auto getBucketDigests = [](KvStoreWrapper* store) {
+    thrift::KeyDumpParams params;
+    params.hashTreeRootDigest_ref() = 0;
+    auto pub = store->getKvStore()
+                   ->dumpKvStoreKeys(
+                       std::move(params),
+                       thrift::KvStore_constants::kDefaultArea())
+                   .get();
+    EXPECT_TRUE(pub->keyVals.empty());
+    EXPECT_TRUE(pub->hashTreeBucketDigests_ref().has_value());
+    return pub->hashTreeBucketDigests_ref().value();
+  };
+  const auto bucketDigests = getBucketDigests(store1.get());
+  EXPECT_EQ(KvStoreHashTree::kNumBuckets, bucketDigests.size());
+  EXPECT_EQ(bucketDigests, getBucketDigests(store2.get()));
+}
+
+//
+// Hash-tree based full-sync of keys spread over all buckets, requested from
+// peer in multiple chunks
+//
+TEST_F(SimpleKvStoreThriftTestFixture, ChunkedHashTreeThriftSync) {
+  // create 2 nodes topology for thrift peers
+  createSimpleThriftTestTopo();
+  auto store1 = stores_.front();
+  auto store2 = stores_.back();
+
+  // enough keys to mismatch more buckets than requested in one chunk
+  const size_t numKeys = 4 * Constants::kFullSyncChunkBuckets;
+  for (size_t i = 0; i < numKeys; ++i) {
+    EXPECT_TRUE(store1->setKey(
+        folly::sformat("store1-key-{}", i),
+        createThriftValue(1, node1, std::string("value"))));
+    EXPECT_TRUE(store2->setKey(
+        folly::sformat("store2-key-{}", i),
+        createThriftValue(1, node2, std::string("value"))));
+  }
+
+  auto peerSpec1 = createPeerSpec(
+      "inproc://dummy-spec-1", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  auto peerSpec2 = createPeerSpec(
+      "inproc://dummy-spec-2", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.front()->getOpenrCtrlThriftPort());
+  peerSpec1.supportHashTreeSync = true;
+  peerSpec2.supportHashTreeSync = true;
+
+  EXPECT_TRUE(store1->addPeer(store2->getNodeId(), peerSpec1));
+  EXPECT_TRUE(store2->addPeer(store1->getNodeId(), peerSpec2));
+
+  // all chunks are merged before peers are initialized
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store1.get(), store2->getNodeId(), KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store2.get(), store1->getNodeId(), KvStorePeerState::INITIALIZED));
+  EXPECT_EQ(2 * numKeys + 2, store1->dumpAll().size());
+  EXPECT_EQ(2 * numKeys + 2, store2->dumpAll().size());
+}
+
 //
 // Negative test case for initial full-sync over thrift
 //
@@ -409,6 +522,54 @@ TEST_F(SimpleKvStoreThriftTestFixture, BasicFloodingOverThrift) {
   EXPECT_EQ(3, store2->dumpAll().size());
 }
 
+//
+// Floods queued for thrift peer within the batch interval are coalesced into
+// a single request
+//
+TEST_F(SimpleKvStoreThriftTestFixture, FloodBatchingOverThrift) {
+  createKvStore(node1, 200 /* flood batch ms */);
+  createThriftServer(node1, stores_.back());
+  createKvStore(node2);
+  createThriftServer(node2, stores_.back());
+  auto store1 = stores_.front();
+  auto store2 = stores_.back();
+
+  auto peerSpec1 = createPeerSpec(
+      "inproc://dummy-spec-1", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  auto peerSpec2 = createPeerSpec(
+      "inproc://dummy-spec-2", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.front()->getOpenrCtrlThriftPort());
+  EXPECT_TRUE(store1->addPeer(store2->getNodeId(), peerSpec1));
+  EXPECT_TRUE(store2->addPeer(store1->getNodeId(), peerSpec2));
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store1.get(), store2->getNodeId(), KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store2.get(), store1->getNodeId(), KvStorePeerState::INITIALIZED));
+
+  const std::string counter{"kvstore.flood.coalesced_requests.sum"};
+  auto counters = fb303::fbData->getCounters();
+  const auto oldCoalesced = counters.count(counter) ? counters.at(counter) : 0;
+
+  // separate publications set within the batch interval
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  for (int i = 0; i < 5; ++i) {
+    keyVals.emplace_back(
+        folly::sformat("key-batch-{}", i),
+        createThriftValue(1, store1->getNodeId(), std::string("value")));
+    EXPECT_TRUE(store1->setKey(keyVals.back().first, keyVals.back().second));
+  }
+  for (auto const& [key, value] : keyVals) {
+    EXPECT_TRUE(verifyKvStoreKeyVal(store2.get(), key, value));
+  }
+
+  counters = fb303::fbData->getCounters();
+  ASSERT_EQ(1, counters.count(counter));
+  EXPECT_LT(oldCoalesced, counters.at(counter));
+}
+
 //
 // Test case for flooding publication over thrift.
 //
@@ -9,6 +9,9 @@
 #include <thread>
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/FileUtil.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/experimental/TestUtil.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
 #include <gmock/gmock.h>
@@ -17,7 +20,16 @@
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/kvstore/KvStoreFloodPacer.h>
+#include <openr/kvstore/KvStoreHashTree.h>
+#include <openr/kvstore/KvStoreKeyIndex.h>
+#include <openr/kvstore/KvStoreNodeIdsBloom.h>
+#include <openr/kvstore/KvStoreRecording.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
+#include <openr/kvstore/KvStoreSubscriberIndex.h>
+#include <openr/kvstore/KvStoreTtlWheel.h>
 #include <openr/kvstore/KvStoreUtil.h>
+#include <openr/kvstore/KvStoreValueCompression.h>
 #include <openr/kvstore/KvStoreWrapper.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 
@@ -265,6 +277,556 @@ TEST(KvStore, mergeKeyValuesTest) {
   }
 }
 
+//
+// validate hash tree is maintained along with mergeKeyValues
+//
+TEST(KvStore, mergeKeyValuesHashTreeTest) {
+  std::unordered_map<std::string, thrift::Value> myStore;
+  std::unordered_map<std::string, thrift::Value> peerStore;
+  KvStoreHashTree myTree;
+  KvStoreHashTree peerTree;
+
+  // rebuild tree from scratch for comparison against incremental one
+  auto buildTree =
+      [](std::unordered_map<std::string, thrift::Value> const& store) {
+        KvStoreHashTree tree;
+        for (auto const& [key, val] : store) {
+          tree.add(key, val);
+        }
+        return tree;
+      };
+
+  std::unordered_map<std::string, thrift::Value> update;
+  for (int i = 0; i < 100; ++i) {
+    update.emplace(
+        folly::sformat("key-{}", i),
+        createThriftValue(1, "node1", folly::sformat("value-{}", i)));
+  }
+  KvStore::mergeKeyValues(myStore, update, std::nullopt, &myTree);
+  KvStore::mergeKeyValues(peerStore, update, std::nullopt, &peerTree);
+  EXPECT_EQ(0, myTree.getMismatchedBuckets(peerTree.getBucketDigests()).size());
+  EXPECT_EQ(myTree.getRootDigest(), peerTree.getRootDigest());
+  EXPECT_EQ(myTree.getBucketDigests(), buildTree(myStore).getBucketDigests());
+
+  // ttl update doesn't change the tree
+  {
+    auto ttlUpdate = myStore.at("key-1");
+    ttlUpdate.value_ref().reset();
+    ttlUpdate.ttlVersion++;
+    const auto rootDigest = myTree.getRootDigest();
+    auto keyVals = KvStore::mergeKeyValues(
+        myStore, {{"key-1", ttlUpdate}}, std::nullopt, &myTree);
+    EXPECT_EQ(1, keyVals.size());
+    EXPECT_EQ(rootDigest, myTree.getRootDigest());
+  }
+
+  // value update changes only the bucket of the key
+  {
+    auto newVal = createThriftValue(2, "node1", std::string("value-new"));
+    auto keyVals = KvStore::mergeKeyValues(
+        myStore, {{"key-2", newVal}}, std::nullopt, &myTree);
+    EXPECT_EQ(1, keyVals.size());
+    EXPECT_NE(myTree.getRootDigest(), peerTree.getRootDigest());
+    EXPECT_EQ(
+        std::vector<int32_t>{static_cast<int32_t>(
+            KvStoreHashTree::getBucket("key-2"))},
+        myTree.getMismatchedBuckets(peerTree.getBucketDigests()));
+    EXPECT_EQ(myTree.getBucketDigests(), buildTree(myStore).getBucketDigests());
+
+    // same update on peer brings trees back in sync
+    KvStore::mergeKeyValues(
+        peerStore, {{"key-2", newVal}}, std::nullopt, &peerTree);
+    EXPECT_EQ(myTree.getRootDigest(), peerTree.getRootDigest());
+  }
+
+  // removal restores previous digest
+  {
+    const auto rootDigest = myTree.getRootDigest();
+    auto newVal = createThriftValue(1, "node1", std::string("value-100"));
+    KvStore::mergeKeyValues(
+        myStore, {{"key-100", newVal}}, std::nullopt, &myTree);
+    EXPECT_NE(rootDigest, myTree.getRootDigest());
+    myTree.remove("key-100", myStore.at("key-100"));
+    EXPECT_EQ(rootDigest, myTree.getRootDigest());
+  }
+
+  // trees of different size mismatch in all buckets
+  EXPECT_EQ(
+      KvStoreHashTree::kNumBuckets,
+      myTree.getMismatchedBuckets(std::vector<int64_t>{}).size());
+}
+
+//
+// validate TTL refreshes in compact form are equivalent to TTL updates
+//
+TEST(KvStore, mergeTtlRefreshesTest) {
+  std::unordered_map<std::string, thrift::Value> myStore;
+  myStore.emplace("key1", createThriftValue(5, "node1", "value1", 3600, 1));
+  myStore.emplace("key2", createThriftValue(5, "node1", "value2", 3600, 1));
+  myStore.emplace("key3", createThriftValue(5, "node2", "value3", 3600, 1));
+
+  // TTL updates along with a value update
+  std::unordered_map<std::string, thrift::Value> keyVals;
+  keyVals.emplace("key1", createThriftValue(5, "node1", std::nullopt, 100, 2));
+  keyVals.emplace("key2", createThriftValue(4, "node1", std::nullopt, 100, 2));
+  keyVals.emplace("key3", createThriftValue(5, "node2", std::nullopt, 100, 2));
+  keyVals.emplace("key4", createThriftValue(1, "node2", "value4", 100, 1));
+  for (auto& [key, value] : keyVals) {
+    if (not value.value_ref().has_value()) {
+      // hash is not carried in compact form
+      value.hash_ref().reset();
+    }
+  }
+  auto expectedStore = myStore;
+  const auto expectedUpdates =
+      KvStore::mergeKeyValues(expectedStore, keyVals);
+
+  // TTL updates are moved out and batched per originator
+  auto ttlRefreshes = KvStore::batchTtlRefreshes(keyVals);
+  ASSERT_EQ(1, keyVals.size());
+  EXPECT_EQ(1, keyVals.count("key4"));
+  ASSERT_EQ(2, ttlRefreshes.size());
+  size_t numRefreshes{0};
+  for (auto const& batch : ttlRefreshes) {
+    numRefreshes += batch.refreshes.size();
+  }
+  EXPECT_EQ(3, numRefreshes);
+
+  auto updates = KvStore::mergeKeyValues(myStore, keyVals);
+  auto ttlUpdates = KvStore::mergeTtlRefreshes(myStore, ttlRefreshes);
+  updates.insert(ttlUpdates.begin(), ttlUpdates.end());
+  EXPECT_EQ(expectedStore, myStore);
+  EXPECT_EQ(expectedUpdates, updates);
+
+  // stale refreshes are ignored
+  EXPECT_TRUE(KvStore::mergeTtlRefreshes(myStore, ttlRefreshes).empty());
+  EXPECT_EQ(expectedStore, myStore);
+}
+
+//
+// validate per peer pacing and priority of buffered flooding
+//
+TEST(KvStore, floodPacerTest) {
+  thrift::KvstoreFloodRate floodRate;
+  floodRate.flood_msg_per_sec = 10;
+  floodRate.flood_msg_burst_size = 1;
+  KvStoreFloodPacer pacer(floodRate, {"adj:", "prefix:"});
+
+  EXPECT_EQ(3, pacer.getNumPriorityClasses());
+  EXPECT_EQ(0, pacer.getPriorityClass("adj:node1"));
+  EXPECT_EQ(1, pacer.getPriorityClass("prefix:node1"));
+  EXPECT_EQ(2, pacer.getPriorityClass("key1"));
+  EXPECT_EQ("adj", pacer.getPriorityClassName(0));
+  EXPECT_EQ("prefix", pacer.getPriorityClassName(1));
+  EXPECT_EQ("default", pacer.getPriorityClassName(2));
+
+  // burst is consumed, peers are paced independently
+  EXPECT_TRUE(pacer.trySend("peer1"));
+  EXPECT_FALSE(pacer.trySend("peer1"));
+  EXPECT_TRUE(pacer.trySend("peer2"));
+
+  thrift::Publication publication;
+  publication.keyVals.emplace("key1", createThriftValue(1, "node1", "value"));
+  publication.keyVals.emplace(
+      "prefix:node1", createThriftValue(1, "node1", "value"));
+  publication.keyVals.emplace(
+      "adj:node1", createThriftValue(1, "node1", "value"));
+  pacer.buffer("peer1", publication);
+  EXPECT_TRUE(pacer.hasPendingKeys());
+  EXPECT_EQ(std::vector<std::string>{"peer1"}, pacer.getPendingPeers());
+  EXPECT_FALSE(pacer.pop("peer2").has_value());
+
+  // no tokens left yet
+  EXPECT_FALSE(pacer.pop("peer1").has_value());
+
+  // buffered keys are sent in priority order. Nothing can be sent to the
+  // peer right away while keys are buffered
+  for (auto const& key : {"adj:node1", "prefix:node1", "key1"}) {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_FALSE(pacer.trySend("peer1"));
+    auto pendingKeys = pacer.pop("peer1");
+    ASSERT_TRUE(pendingKeys.has_value());
+    EXPECT_EQ(std::unordered_set<std::string>{key}, pendingKeys->keys);
+  }
+  EXPECT_FALSE(pacer.hasPendingKeys());
+
+  pacer.buffer("peer2", publication);
+  pacer.removePeer("peer2");
+  EXPECT_FALSE(pacer.hasPendingKeys());
+
+  // reloaded rate applies to known and new peers, with full burst
+  floodRate.flood_msg_burst_size = 2;
+  pacer.setFloodRate(floodRate);
+  for (auto const& peer : {"peer1", "peer3"}) {
+    EXPECT_TRUE(pacer.trySend(peer));
+    EXPECT_TRUE(pacer.trySend(peer));
+    EXPECT_FALSE(pacer.trySend(peer));
+  }
+}
+
+//
+// validate grouping of identical subscriber filters and matching of
+// publications against combined filters
+//
+TEST(KvStore, subscriberIndexTest) {
+  KvStoreSubscriberIndex index;
+
+  auto getFilter = [](std::optional<std::vector<std::string>> keys,
+                      std::optional<std::set<std::string>> originatorIds) {
+    thrift::KvFilter filter;
+    if (keys.has_value()) {
+      filter.keys_ref() = *keys;
+    }
+    if (originatorIds.has_value()) {
+      filter.originatorIds_ref() = *originatorIds;
+    }
+    return filter;
+  };
+  auto getPublication = [](std::vector<std::pair<std::string, std::string>>
+                               keyOriginators) {
+    thrift::Publication publication;
+    for (auto const& [key, originator] : keyOriginators) {
+      publication.keyVals.emplace(key, createThriftValue(1, originator, "v"));
+    }
+    return publication;
+  };
+  auto getMatching = [&](const thrift::Publication& publication) {
+    auto subscribers = index.getMatchingSubscribers(publication);
+    return std::set<int64_t>(subscribers.begin(), subscribers.end());
+  };
+
+  // identical filters (irrespective of order) are grouped together
+  index.addSubscriber(1, getFilter({{"adj:", "prefix:"}}, std::nullopt));
+  index.addSubscriber(2, getFilter({{"prefix:", "adj:"}}, std::nullopt));
+  index.addSubscriber(3, getFilter({{"prefix:node[12]:"}}, std::nullopt));
+  index.addSubscriber(4, getFilter(std::nullopt, {{"node3"}}));
+  index.addSubscriber(5, getFilter(std::nullopt, std::nullopt));
+  index.addSubscriber(6, getFilter({{"adj:node1"}}, {{"node3"}}));
+  EXPECT_EQ(6, index.getNumSubscribers());
+  EXPECT_EQ(5, index.getNumFilterGroups());
+
+  EXPECT_EQ(
+      (std::set<int64_t>{1, 2, 5, 6}),
+      getMatching(getPublication({{"adj:node1", "node1"}})));
+  EXPECT_EQ(
+      (std::set<int64_t>{1, 2, 3, 5}),
+      getMatching(getPublication({{"prefix:node2:[::/0]", "node2"}})));
+  EXPECT_EQ(
+      (std::set<int64_t>{1, 2, 4, 5, 6}),
+      getMatching(getPublication(
+          {{"prefix:node3:[::/0]", "node3"}, {"key1", "node1"}})));
+  EXPECT_EQ(
+      (std::set<int64_t>{5}), getMatching(getPublication({{"key1", "node1"}})));
+
+  // ttl refreshes don't match filters
+  thrift::Publication ttlRefresh;
+  ttlRefresh.keyVals.emplace(
+      "adj:node1", createThriftValue(1, "node1", std::nullopt));
+  EXPECT_EQ((std::set<int64_t>{5}), getMatching(ttlRefresh));
+
+  // group is removed along with its last subscriber
+  index.removeSubscriber(1);
+  EXPECT_EQ(5, index.getNumFilterGroups());
+  index.removeSubscriber(2);
+  index.removeSubscriber(6);
+  EXPECT_EQ(3, index.getNumFilterGroups());
+  EXPECT_EQ(
+      (std::set<int64_t>{5}),
+      getMatching(getPublication({{"adj:node1", "node1"}})));
+}
+
+//
+// validate copy-on-write updates of KvStore snapshot. Published snapshot
+// never changes and untouched shards are shared with the next one
+//
+TEST(KvStore, snapshotTest) {
+  KvStoreSnapshot snapshot(4);
+  auto empty = snapshot.get();
+  ASSERT_NE(nullptr, empty);
+  EXPECT_EQ(4, empty->shards.size());
+  EXPECT_EQ(nullptr, empty->find("key1"));
+
+  snapshot.update("key1", {createThriftValue(1, "node1", "value1"), {}});
+  snapshot.update("key2", {createThriftValue(1, "node1", "value2"), {}});
+  // not visible until published
+  EXPECT_EQ(nullptr, snapshot.get()->find("key1"));
+  snapshot.publish(std::string("node1"));
+
+  auto snapshot1 = snapshot.get();
+  ASSERT_NE(nullptr, snapshot1->find("key1"));
+  EXPECT_EQ(1, snapshot1->find("key1")->value.version);
+  ASSERT_NE(nullptr, snapshot1->find("key2"));
+  EXPECT_EQ(std::string("node1"), snapshot1->sptRootId);
+  EXPECT_EQ(nullptr, empty->find("key1"));
+
+  snapshot.update("key1", {createThriftValue(2, "node1", "value1"), {}});
+  snapshot.remove("key2");
+  snapshot.publish(std::nullopt);
+
+  auto snapshot2 = snapshot.get();
+  ASSERT_NE(nullptr, snapshot2->find("key1"));
+  EXPECT_EQ(2, snapshot2->find("key1")->value.version);
+  EXPECT_EQ(nullptr, snapshot2->find("key2"));
+  // previous snapshot is intact
+  EXPECT_EQ(1, snapshot1->find("key1")->value.version);
+  ASSERT_NE(nullptr, snapshot1->find("key2"));
+
+  // shards without updates are shared
+  size_t numShared{0};
+  for (size_t i = 0; i < 4; ++i) {
+    numShared += snapshot1->shards.at(i) == snapshot2->shards.at(i);
+  }
+  EXPECT_LE(2, numShared);
+}
+
+//
+// validate TTL wheel expiry and in place rescheduling
+//
+TEST(KvStore, ttlWheelTest) {
+  using namespace std::chrono_literals;
+  const auto start = std::chrono::steady_clock::now();
+  KvStoreTtlWheel ttlWheel(start);
+  EXPECT_FALSE(ttlWheel.nextExpiryTime().has_value());
+
+  auto schedule = [&](std::string const& key, std::chrono::milliseconds ttl) {
+    TtlCountdownQueueEntry entry;
+    entry.key = key;
+    entry.expiryTime = start + ttl;
+    ttlWheel.schedule(std::move(entry));
+  };
+  auto expire = [&](std::chrono::milliseconds elapsed) {
+    std::set<std::string> keys;
+    for (auto const& entry : ttlWheel.expire(start + elapsed)) {
+      keys.emplace(entry.key);
+    }
+    return keys;
+  };
+
+  // keys spanning few levels of the wheel
+  schedule("key1", 10ms);
+  schedule("key2", 300ms);
+  schedule("key3", 100s);
+  schedule("key4", 30 * 24h);
+  EXPECT_EQ(4, ttlWheel.size());
+  EXPECT_EQ(start + 10ms, ttlWheel.nextExpiryTime());
+
+  // reschedule in place
+  schedule("key1", 20ms);
+  EXPECT_EQ(4, ttlWheel.size());
+  ASSERT_NE(nullptr, ttlWheel.find("key1"));
+  EXPECT_EQ(start + 20ms, ttlWheel.find("key1")->expiryTime);
+
+  EXPECT_TRUE(expire(19ms).empty());
+  EXPECT_EQ(std::set<std::string>({"key1"}), expire(20ms));
+  EXPECT_EQ(nullptr, ttlWheel.find("key1"));
+
+  // next expiry never goes beyond the earliest entry
+  EXPECT_GE(start + 300ms, ttlWheel.nextExpiryTime());
+  EXPECT_TRUE(expire(299ms).empty());
+  EXPECT_EQ(std::set<std::string>({"key2"}), expire(300ms));
+
+  EXPECT_TRUE(ttlWheel.remove("key3"));
+  EXPECT_FALSE(ttlWheel.remove("key3"));
+  EXPECT_TRUE(expire(200s).empty());
+
+  // key beyond the range of the wheel levels
+  EXPECT_TRUE(expire(30 * 24h - 1ms).empty());
+  EXPECT_EQ(std::set<std::string>({"key4"}), expire(30 * 24h));
+  EXPECT_TRUE(ttlWheel.empty());
+  EXPECT_FALSE(ttlWheel.nextExpiryTime().has_value());
+
+  // entries scheduled in the past are due immediately
+  schedule("key5", 1s);
+  EXPECT_EQ(std::set<std::string>({"key5"}), expire(30 * 24h));
+}
+
+//
+// validate key index is maintained along with mergeKeyValues
+//
+TEST(KvStore, mergeKeyValuesKeyIndexTest) {
+  std::unordered_map<std::string, thrift::Value> myStore;
+  KvStoreKeyIndex keyIndex;
+
+  auto getPrefixKeys = [&keyIndex](std::string const& prefix) {
+    std::vector<std::string> keys;
+    keyIndex.forEachKeyWithPrefix(
+        prefix, [&keys](std::string const& key) { keys.emplace_back(key); });
+    return keys;
+  };
+  auto getOriginatorKeys = [&keyIndex](std::string const& originatorId) {
+    std::vector<std::string> keys;
+    keyIndex.forEachKeyWithOriginator(
+        originatorId,
+        [&keys](std::string const& key) { keys.emplace_back(key); });
+    return keys;
+  };
+
+  KvStore::mergeKeyValues(
+      myStore,
+      {{"adj:node1", createThriftValue(1, "node1", std::string("adj1"))},
+       {"adj:node2", createThriftValue(1, "node2", std::string("adj2"))},
+       {"prefix:node1", createThriftValue(1, "node1", std::string("pfx1"))},
+       {"adk", createThriftValue(1, "node2", std::string("adk"))}},
+      std::nullopt,
+      nullptr,
+      &keyIndex);
+  EXPECT_EQ(4, keyIndex.size());
+  EXPECT_EQ(
+      (std::vector<std::string>{"adj:node1", "adj:node2"}),
+      getPrefixKeys("adj:"));
+  EXPECT_EQ(
+      (std::vector<std::string>{"adj:node1", "prefix:node1"}),
+      getOriginatorKeys("node1"));
+  EXPECT_EQ(4, getPrefixKeys("").size());
+  EXPECT_EQ(0, getPrefixKeys("zzz").size());
+
+  // originator change moves the key
+  KvStore::mergeKeyValues(
+      myStore,
+      {{"adj:node1", createThriftValue(1, "node3", std::string("adj1"))}},
+      std::nullopt,
+      nullptr,
+      &keyIndex);
+  EXPECT_EQ(4, keyIndex.size());
+  EXPECT_EQ(
+      (std::vector<std::string>{"prefix:node1"}), getOriginatorKeys("node1"));
+  EXPECT_EQ(
+      (std::vector<std::string>{"adj:node1"}), getOriginatorKeys("node3"));
+
+  // removal
+  keyIndex.remove("adj:node1", myStore.at("adj:node1"));
+  EXPECT_EQ(3, keyIndex.size());
+  EXPECT_EQ((std::vector<std::string>{"adj:node2"}), getPrefixKeys("adj:"));
+  EXPECT_EQ(0, getOriginatorKeys("node3").size());
+
+  // only plain strings can be looked up in the index
+  EXPECT_EQ("adj:", KvStoreKeyIndex::getLiteralPrefix("adj:"));
+  EXPECT_EQ(std::nullopt, KvStoreKeyIndex::getLiteralPrefix("adj:.*"));
+  EXPECT_EQ(std::nullopt, KvStoreKeyIndex::getLiteralPrefix("(adj|prefix)"));
+}
+
+//
+// validate value updates growing KvStore beyond limits are rejected
+//
+TEST(KvStore, mergeKeyValuesLimitsTest) {
+  std::unordered_map<std::string, thrift::Value> myStore;
+  KvStoreKeyIndex keyIndex;
+  KvStoreLimits limits;
+  limits.maxKeysPerOriginator = 2;
+  limits.maxBytes = 100;
+
+  auto merge = [&](std::unordered_map<std::string, thrift::Value> const& kvs) {
+    return KvStore::mergeKeyValues(
+        myStore, kvs, std::nullopt, nullptr, &keyIndex, nullptr, limits);
+  };
+
+  // third key of node1 is rejected, node2 is within its own limit
+  EXPECT_EQ(1, merge({{"k1", createThriftValue(1, "node1", "v1")}}).size());
+  EXPECT_EQ(1, merge({{"k2", createThriftValue(1, "node1", "v2")}}).size());
+  EXPECT_EQ(0, merge({{"k3", createThriftValue(1, "node1", "v3")}}).size());
+  EXPECT_EQ(1, merge({{"k4", createThriftValue(1, "node2", "v4")}}).size());
+  EXPECT_EQ(3, myStore.size());
+  EXPECT_EQ(0, myStore.count("k3"));
+  EXPECT_EQ(2, keyIndex.getOriginatorKeyCount("node1"));
+  EXPECT_EQ(12, keyIndex.getBytes());
+
+  // updates of existing keys are accepted as long as bytes fit
+  EXPECT_EQ(1, merge({{"k1", createThriftValue(2, "node1", "v1-2")}}).size());
+  EXPECT_EQ(14, keyIndex.getBytes());
+  EXPECT_EQ(10, keyIndex.getOriginatorBytes("node1"));
+  EXPECT_EQ(
+      0,
+      merge({{"k4", createThriftValue(2, "node2", std::string(100, 'x'))}})
+          .size());
+  EXPECT_EQ(1, myStore.at("k4").version);
+
+  // ttl updates are never rejected
+  auto ttlUpdate = myStore.at("k2");
+  ttlUpdate.value_ref().reset();
+  ttlUpdate.ttlVersion++;
+  EXPECT_EQ(1, merge({{"k2", ttlUpdate}}).size());
+
+  // shrinking an originator already over the limit is accepted
+  limits.maxKeysPerOriginator = 1;
+  EXPECT_EQ(1, merge({{"k2", createThriftValue(2, "node1", "v")}}).size());
+  EXPECT_EQ(0, merge({{"k5", createThriftValue(1, "node1", "v5")}}).size());
+
+  // no limits without key index
+  EXPECT_EQ(
+      1,
+      KvStore::mergeKeyValues(
+          myStore,
+          {{"k5", createThriftValue(1, "node1", "v5")}},
+          std::nullopt,
+          nullptr,
+          nullptr,
+          nullptr,
+          limits)
+          .size());
+}
+
+//
+// validate merge of large update decided in parallel matches serial merge
+//
+TEST(KvStore, mergeKeyValuesParallelTest) {
+  std::unordered_map<std::string, thrift::Value> serialStore;
+  std::unordered_map<std::string, thrift::Value> parallelStore;
+  KvStoreHashTree serialTree;
+  KvStoreHashTree parallelTree;
+  folly::CPUThreadPoolExecutor mergeExecutor(4);
+  const size_t numKeys = Constants::kParallelMergeMinKeys;
+
+  std::unordered_map<std::string, thrift::Value> update;
+  for (size_t i = 0; i < numKeys; ++i) {
+    update.emplace(
+        folly::sformat("key-{}", i),
+        createThriftValue(1, "node1", folly::sformat("value-{}", i)));
+  }
+  KvStore::mergeKeyValues(serialStore, update, std::nullopt, &serialTree);
+  KvStore::mergeKeyValues(
+      parallelStore,
+      update,
+      std::nullopt,
+      &parallelTree,
+      nullptr,
+      &mergeExecutor);
+  EXPECT_EQ(numKeys, parallelStore.size());
+
+  // mix of newer values, TTL updates, stale and filtered out values
+  update.clear();
+  for (size_t i = 0; i < numKeys; ++i) {
+    const auto key = folly::sformat("key-{}", i);
+    switch (i % 4) {
+    case 0:
+      update.emplace(key, createThriftValue(2, "node1", std::string("new")));
+      break;
+    case 1:
+      update.emplace(
+          key,
+          createThriftValue(
+              1, "node1", std::nullopt, Constants::kTtlInfinity, 1));
+      break;
+    case 2:
+      update.emplace(key, createThriftValue(0, "node1", std::string("old")));
+      break;
+    default:
+      update.emplace(
+          folly::sformat("filtered-{}", i),
+          createThriftValue(1, "node2", std::string("filtered")));
+    }
+  }
+  const KvStoreFilters filters({"key-"}, {});
+  auto serialUpdates = KvStore::mergeKeyValues(
+      serialStore, update, filters, &serialTree);
+  auto parallelUpdates = KvStore::mergeKeyValues(
+      parallelStore, update, filters, &parallelTree, nullptr, &mergeExecutor);
+  EXPECT_EQ(numKeys / 2, parallelUpdates.size());
+  EXPECT_EQ(serialUpdates, parallelUpdates);
+  EXPECT_EQ(serialStore, parallelStore);
+  EXPECT_EQ(serialTree.getRootDigest(), parallelTree.getRootDigest());
+}
+
 //
 // Test compareValues method
 //
@@ -345,6 +907,145 @@ TEST(KvStore, compareValuesTest) {
   }
 }
 
+TEST(KvStore, valueCompressionTest) {
+  const std::string data(1024, 'a');
+  const std::string adjKey = folly::sformat("{}node1", Constants::kAdjDbMarker);
+  auto value = createThriftValue(1, "node1", data, 3600, 1);
+  const auto hash = generateHash(
+      value.version, value.originatorId, value.value_ref());
+
+  // only large adjacency and prefix databases are compressed
+  EXPECT_TRUE(KvStoreValueCompression::shouldCompress(adjKey, value));
+  EXPECT_FALSE(KvStoreValueCompression::shouldCompress("test_key", value));
+  {
+    auto smallValue = createThriftValue(1, "node1", "dummyValue", 3600, 1);
+    EXPECT_FALSE(KvStoreValueCompression::shouldCompress(adjKey, smallValue));
+  }
+
+  // hash of compressed value covers uncompressed content
+  auto compressed = value;
+  EXPECT_TRUE(KvStoreValueCompression::compress(compressed));
+  EXPECT_TRUE(KvStoreValueCompression::isCompressed(compressed));
+  EXPECT_LT(compressed.value_ref()->size(), data.size());
+  EXPECT_EQ(hash, *compressed.hash_ref());
+  EXPECT_FALSE(KvStoreValueCompression::shouldCompress(adjKey, compressed));
+
+  // compressed and uncompressed values are same
+  value.hash_ref() = 1;
+  EXPECT_EQ(0, KvStore::compareValues(value, compressed));
+
+  auto decompressed = compressed;
+  EXPECT_TRUE(KvStoreValueCompression::decompress(decompressed));
+  EXPECT_FALSE(KvStoreValueCompression::isCompressed(decompressed));
+  EXPECT_EQ(data, *decompressed.value_ref());
+  EXPECT_EQ(hash, *decompressed.hash_ref());
+
+  // malformed values are removed
+  auto malformed = compressed;
+  malformed.value_ref() = "malformed";
+  EXPECT_FALSE(KvStoreValueCompression::decompress(malformed));
+  EXPECT_EQ(-2, KvStore::compareValues(value, malformed));
+
+  thrift::KeyVals keyVals{
+      {adjKey, compressed}, {"malformed", malformed}, {"test_key", value}};
+  EXPECT_TRUE(KvStoreValueCompression::hasCompressedValues(keyVals));
+  KvStoreValueCompression::decompressAll(keyVals);
+  EXPECT_FALSE(KvStoreValueCompression::hasCompressedValues(keyVals));
+  ASSERT_EQ(2, keyVals.size());
+  EXPECT_EQ(data, *keyVals.at(adjKey).value_ref());
+  EXPECT_EQ(0, keyVals.count("malformed"));
+}
+
+TEST(KvStore, nodeIdsBloomTest) {
+  std::vector<std::string> nodeIds;
+  for (int i = 0; i < 50; ++i) {
+    nodeIds.emplace_back(folly::sformat("node-{}", i));
+  }
+  auto bloom = KvStoreNodeIdsBloom::fromNodeIds(nodeIds);
+  EXPECT_EQ(KvStoreNodeIdsBloom::kNumBits / 8, bloom.size());
+
+  // added nodes are always found
+  for (auto const& nodeId : nodeIds) {
+    EXPECT_TRUE(KvStoreNodeIdsBloom::mayContain(bloom, nodeId));
+  }
+
+  // false positives are rare
+  int falsePositives{0};
+  for (int i = 0; i < 10000; ++i) {
+    falsePositives += KvStoreNodeIdsBloom::mayContain(
+        bloom, folly::sformat("other-node-{}", i));
+  }
+  EXPECT_GE(10, falsePositives);
+
+  // nothing is found in empty or malformed filter
+  EXPECT_FALSE(
+      KvStoreNodeIdsBloom::mayContain(KvStoreNodeIdsBloom::create(), "node-0"));
+  EXPECT_FALSE(KvStoreNodeIdsBloom::mayContain("malformed", "node-0"));
+
+  // malformed filter is reset on add
+  std::string malformed{"malformed"};
+  KvStoreNodeIdsBloom::add(malformed, "node-0");
+  EXPECT_EQ(KvStoreNodeIdsBloom::create().size(), malformed.size());
+  EXPECT_TRUE(KvStoreNodeIdsBloom::mayContain(malformed, "node-0"));
+}
+
+TEST(KvStore, recordingTest) {
+  folly::test::TemporaryFile file;
+  {
+    KvStoreRecorder recorder(file.path().string());
+    for (int i = 0; i < 10; ++i) {
+      thrift::Publication pub;
+      pub.keyVals.emplace(
+          folly::sformat("key-{}", i),
+          createThriftValue(i + 1, "node1", folly::sformat("value-{}", i)));
+      recorder.addRecord(
+          i ? KvStoreRecordType::DELTA : KvStoreRecordType::SNAPSHOT,
+          pub,
+          std::chrono::milliseconds(1000 + 10 * i));
+    }
+    EXPECT_EQ(10, recorder.getNumRecords());
+  }
+
+  // records are read back through the index
+  std::string data;
+  {
+    KvStoreRecordingReader reader(file.path().string());
+    ASSERT_EQ(10, reader.size());
+    auto record = reader.getRecord(0);
+    EXPECT_EQ(KvStoreRecordType::SNAPSHOT, record.type);
+    EXPECT_EQ(std::chrono::milliseconds(1000), record.timestamp);
+    record = reader.getRecord(9);
+    EXPECT_EQ(KvStoreRecordType::DELTA, record.type);
+    ASSERT_EQ(1, record.publication.keyVals.count("key-9"));
+    EXPECT_EQ("value-9", *record.publication.keyVals.at("key-9").value_ref());
+    EXPECT_EQ(10, record.publication.keyVals.at("key-9").version);
+
+    EXPECT_EQ(0, reader.seek(std::chrono::milliseconds(0)));
+    EXPECT_EQ(5, reader.seek(std::chrono::milliseconds(1045)));
+    EXPECT_EQ(5, reader.seek(std::chrono::milliseconds(1050)));
+    EXPECT_EQ(10, reader.seek(std::chrono::milliseconds(2000)));
+  }
+
+  // recording without index (and a truncated record) is scanned
+  ASSERT_TRUE(folly::readFile(file.path().c_str(), data));
+  const auto indexOffset = data.find("OPENRIDX") - 16 * 10 - 16;
+  data.resize(indexOffset - 5);
+  ASSERT_TRUE(folly::writeFile(data, file.path().c_str()));
+  {
+    KvStoreRecordingReader reader(file.path().string());
+    ASSERT_EQ(9, reader.size());
+    EXPECT_EQ(std::chrono::milliseconds(1080), reader.getTimestamp(8));
+    EXPECT_EQ(
+        "value-8",
+        *reader.getRecord(8).publication.keyVals.at("key-8").value_ref());
+  }
+
+  // not a recording
+  ASSERT_TRUE(folly::writeFile(std::string("garbage"), file.path().c_str()));
+  EXPECT_THROW(
+      KvStoreRecordingReader(file.path().string()), std::runtime_error);
+}
+
 //
 // Test dumpAllWithThriftClient API
 //
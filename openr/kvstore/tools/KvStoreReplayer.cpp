@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include <fb303/ServiceData.h>
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/Util.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/decision/Decision.h>
+#include <openr/kvstore/KvStoreRecording.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+
+DEFINE_string(recording, "", "KvStore recording made by openr_kvstore_snooper");
+DEFINE_string(
+    node_name,
+    "",
+    "Node to replay the recording on, Decision computes routes of this node. "
+    "Should be one of the recorded nodes.");
+DEFINE_double(
+    speed,
+    1.0,
+    "Replay speed relative to the recorded one, 0 to replay as fast as "
+    "possible");
+DEFINE_bool(with_decision, true, "Feed replayed publications to Decision");
+DEFINE_int32(
+    settle_time_ms,
+    2000,
+    "Time to wait after the last publication for Decision to settle");
+
+namespace fb303 = facebook::fb303;
+
+int
+main(int argc, char** argv) {
+  // Initialize all params
+  folly::init(&argc, &argv);
+  CHECK(not FLAGS_recording.empty()) << "Specify --recording";
+  CHECK(not FLAGS_node_name.empty()) << "Specify --node_name";
+
+  openr::KvStoreRecordingReader reader(FLAGS_recording);
+  LOG(INFO) << "Loaded " << reader.size() << " records from "
+            << FLAGS_recording;
+  if (reader.size() == 0) {
+    return 0;
+  }
+
+  fbzmq::Context context;
+  auto config =
+      std::make_shared<openr::Config>(getBasicOpenrConfig(FLAGS_node_name));
+  auto kvStore = std::make_unique<openr::KvStoreWrapper>(context, config);
+  kvStore->run();
+
+  // Decision consuming publications of the local KvStore
+  openr::messaging::ReplicateQueue<openr::thrift::RouteDatabaseDelta>
+      staticRoutesUpdateQueue;
+  openr::messaging::ReplicateQueue<openr::thrift::RouteDatabaseDelta>
+      routeUpdatesQueue;
+  openr::messaging::ReplicateQueue<openr::thrift::DecisionDbsDelta>
+      decisionDbsUpdatesQueue;
+  std::unique_ptr<openr::Decision> decision;
+  std::unique_ptr<std::thread> decisionThread;
+  std::atomic<size_t> numRouteUpdates{0};
+  std::unique_ptr<std::thread> routeUpdatesThread;
+  if (FLAGS_with_decision) {
+    decision = std::make_unique<openr::Decision>(
+        config,
+        true, /* computeLfaPaths */
+        false, /* bgpDryRun */
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(250),
+        kvStore->getReader(),
+        staticRoutesUpdateQueue.getReader(),
+        routeUpdatesQueue,
+        decisionDbsUpdatesQueue,
+        context);
+    decisionThread = std::make_unique<std::thread>([&]() { decision->run(); });
+    decision->waitUntilRunning();
+
+    routeUpdatesThread = std::make_unique<std::thread>(
+        [&numRouteUpdates, routeUpdates = routeUpdatesQueue.getReader()]() {
+          while (routeUpdates.get().hasValue()) {
+            ++numRouteUpdates;
+          }
+        });
+  }
+
+  // Replay records with their recorded spacing, scaled by speed. All areas
+  // are replayed into the default area of the local KvStore.
+  size_t numKeyVals{0};
+  const auto startTime = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < reader.size(); ++i) {
+    if (FLAGS_speed > 0 and i > 0) {
+      const auto gap = reader.getTimestamp(i) - reader.getTimestamp(i - 1);
+      std::this_thread::sleep_for(
+          std::chrono::duration<double, std::milli>(gap.count() / FLAGS_speed));
+    }
+    auto record = reader.getRecord(i);
+    std::vector<std::pair<std::string, openr::thrift::Value>> keyVals(
+        std::make_move_iterator(record.publication.keyVals.begin()),
+        std::make_move_iterator(record.publication.keyVals.end()));
+    if (keyVals.empty()) {
+      continue;
+    }
+    numKeyVals += keyVals.size();
+    kvStore->setKeys(keyVals);
+  }
+  const auto replayTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "Replayed " << reader.size() << " records with " << numKeyVals
+            << " key-vals in " << replayTime.count() << "ms";
+
+  if (FLAGS_with_decision) {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_settle_time_ms));
+    LOG(INFO) << "Decision published " << numRouteUpdates.load()
+              << " route updates";
+    for (auto const& [name, value] : fb303::fbData->getCounters()) {
+      if (folly::StringPiece(name).startsWith("decision.")) {
+        LOG(INFO) << "  " << name << ": " << value;
+      }
+    }
+
+    kvStore->closeQueue();
+    staticRoutesUpdateQueue.close();
+    decision->stop();
+    decisionThread->join();
+    routeUpdatesQueue.close();
+    routeUpdatesThread->join();
+  }
+  kvStore->stop();
+
+  return 0;
+}
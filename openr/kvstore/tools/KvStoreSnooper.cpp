@@ -5,17 +5,25 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <csignal>
 #include <iostream>
 
 #include <folly/init/Init.h>
 
 #include <openr/common/OpenrClient.h>
+#include <openr/common/OpenrEventBase.h>
 #include <openr/kvstore/KvStore.h>
+#include <openr/kvstore/KvStoreRecording.h>
 
 DEFINE_string(host, "::1", "Host to connect to");
 DEFINE_int32(port, openr::Constants::kOpenrCtrlPort, "OpenrCtrl server port");
 DEFINE_int32(connect_timeout_ms, 1000, "Connect timeout for client");
 DEFINE_int32(processing_timeout_ms, 5000, "Processing timeout for client");
+DEFINE_string(
+    record_file,
+    "",
+    "Record initial dump and publications into this file instead of printing "
+    "them. Recording is finalized on SIGINT/SIGTERM.");
 
 int
 main(int argc, char** argv) {
@@ -24,6 +32,9 @@ main(int argc, char** argv) {
 
   // Define and start event base
   folly::EventBase evb;
+  openr::EventBaseStopSignalHandler handler(&evb);
+  handler.registerSignalHandler(SIGINT);
+  handler.registerSignalHandler(SIGTERM);
   std::thread evbThread([&evb]() { evb.loopForever(); });
 
   // Create Open/R client
@@ -41,17 +52,35 @@ main(int argc, char** argv) {
             << " entries in initial dump.";
   LOG(INFO) << "";
 
+  std::unique_ptr<openr::KvStoreRecorder> recorder;
+  if (not FLAGS_record_file.empty()) {
+    recorder = std::make_unique<openr::KvStoreRecorder>(FLAGS_record_file);
+    recorder->addRecord(
+        openr::KvStoreRecordType::SNAPSHOT,
+        response.response,
+        std::chrono::milliseconds(openr::getUnixTimeStampMs()));
+    LOG(INFO) << "Recording into " << FLAGS_record_file;
+  }
+
   auto subscription =
       std::move(response.stream)
           .subscribeExTry(
               folly::Executor::getKeepAliveToken(&evb),
-              [&globalKeyVals](
+              [&globalKeyVals, &recorder](
                   folly::Try<openr::thrift::Publication>&& maybePub) mutable {
                 if (maybePub.hasException()) {
                   LOG(ERROR) << maybePub.exception().what();
                   return;
                 }
                 auto& pub = maybePub.value();
+                if (recorder) {
+                  recorder->addRecord(
+                      openr::KvStoreRecordType::DELTA,
+                      pub,
+                      std::chrono::milliseconds(openr::getUnixTimeStampMs()));
+                  return;
+                }
+
                 // Print expired key-vals
                 for (const auto& key : pub.expiredKeys) {
                   std::cout << "Expired Key: " << key << std::endl;
@@ -82,5 +111,10 @@ main(int argc, char** argv) {
   std::move(subscription).detach();
   client.reset();
 
+  if (recorder) {
+    LOG(INFO) << "Recorded " << recorder->getNumRecords() << " records";
+    recorder->close();
+  }
+
   return 0;
 }
@@ -11,7 +11,6 @@
 
 #include <fb303/ServiceData.h>
 #include <fbzmq/service/if/gen-cpp2/Monitor_types.h>
-#include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/MapUtil.h>
 #include <folly/Memory.h>
@@ -25,6 +24,7 @@
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/StartupTimeline.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/LinkMonitor_types.h>
@@ -96,14 +96,14 @@ LinkMonitor::LinkMonitor(
       prefixForwardingAlgorithm_(
           config->getConfig().prefix_forwarding_algorithm),
       useRttMetric_(config->getLinkMonitorConfig().use_rtt_metric),
+      perAdjacencyKeys_(
+          config->getLinkMonitorConfig().enable_per_adjacency_keys),
       linkflapInitBackoff_(std::chrono::milliseconds(
           config->getLinkMonitorConfig().linkflap_initial_backoff_ms)),
       linkflapMaxBackoff_(std::chrono::milliseconds(
           config->getLinkMonitorConfig().linkflap_max_backoff_ms)),
       ttlKeyInKvStore_(config->getKvStoreKeyTtl()),
-      includeItfRegexes_(config->getIncludeItfRegexes()),
-      excludeItfRegexes_(config->getExcludeItfRegexes()),
-      redistributeItfRegexes_(config->getRedistributeItfRegexes()),
+      interfaceFilter_(config->getInterfaceFilter()),
       areas_(config->getAreaIds()),
       interfaceUpdatesQueue_(intfUpdatesQueue),
       prefixUpdatesQueue_(prefixUpdatesQueue),
@@ -118,21 +118,41 @@ LinkMonitor::LinkMonitor(
   // initialize internal states with config
   // loadConfig(config);
 
+  if (config->isAdjDampeningEnabled()) {
+    adjDampeningConfig_ = config->getAdjDampeningConfig();
+  }
+
   // Schedule callback to advertise the initial set of adjacencies and prefixes
   adjHoldTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     LOG(INFO) << "Hold time expired. Advertising adjacencies and addresses";
     // Advertise adjacencies and addresses after hold-timeout
     advertiseAdjacencies();
     advertiseRedistAddrs();
+
+    // Peers discovered within hold time are the initial ones. Let KvStore
+    // signal initial sync once it is done with all of them.
+    for (const auto& area : areas_) {
+      thrift::PeerUpdateRequest req;
+      req.area = area;
+      req.initialPeersDiscovered_ref() = true;
+      peerUpdatesQueue_.push(std::move(req));
+    }
   });
 
-  // Create throttled adjacency advertiser
+  adjDampeningTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { processDampenedAdjacencies(); });
+
+  // Create throttled adjacency advertiser. Isolated change is advertised
+  // right away, changes following it are batched
   advertiseAdjacenciesThrottled_ = std::make_unique<AsyncThrottle>(
-      getEvb(), Constants::kLinkThrottleTimeout, [this]() noexcept {
+      getEvb(),
+      Constants::kLinkThrottleTimeout,
+      [this]() noexcept {
         // will advertise to all areas but will not trigger a adj key update
         // if nothing changed.
         advertiseAdjacencies();
-      });
+      },
+      AsyncThrottle::Edge::LEADING);
 
   // Create throttled interfaces and addresses advertiser
   advertiseIfaceAddrThrottled_ = std::make_unique<AsyncThrottle>(
@@ -146,6 +166,10 @@ LinkMonitor::LinkMonitor(
   LOG(INFO) << "Loading link-monitor state";
   zmqMonitorClient_ =
       std::make_unique<fbzmq::ZmqMonitorClient>(zmqContext, monitorSubmitUrl);
+  eventLogger_ = std::make_unique<EventLogger>(
+      "link_monitor", [this](fbzmq::thrift::EventLog&& log) {
+        zmqMonitorClient_->addEventLog(std::move(log));
+      });
 
   // Create config-store client
   auto state =
@@ -282,51 +306,71 @@ LinkMonitor::prepare() noexcept {
             static_cast<uint16_t>(eventType),
             eventHeader.read<uint16_t>().value());
 
-        switch (eventType) {
-        case thrift::PlatformEventType::LINK_EVENT: {
-          VLOG(3) << "Received Link Event from Platform....";
-          try {
-            const auto linkEvt =
-                fbzmq::util::readThriftObjStr<thrift::LinkEntry>(
-                    eventMsg.value().eventData, serializer_);
-            auto interfaceEntry = getOrCreateInterfaceEntry(linkEvt.ifName);
-            if (interfaceEntry) {
-              const bool wasUp = interfaceEntry->isUp();
-              interfaceEntry->updateAttrs(
-                  linkEvt.ifIndex, linkEvt.isUp, linkEvt.weight);
-              logLinkEvent(
-                  interfaceEntry->getIfName(),
-                  wasUp,
-                  interfaceEntry->isUp(),
-                  interfaceEntry->getBackoffDuration());
+        // Events in between have been dropped. Resync InterfaceDb right away
+        // unless backing off, and still apply this event
+        if (not checkPlatformEventSeqNum(eventMsg.value()) and
+            expBackoff_.canTryNow()) {
+          interfaceDbSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+        }
+
+        // Publisher may coalesce events of the type into a batch
+        std::vector<std::string> eventDatas;
+        auto& event = eventMsg.value();
+        if (event.eventDataBatch_ref().has_value()) {
+          eventDatas = std::move(event.eventDataBatch_ref().value());
+        } else {
+          eventDatas.emplace_back(std::move(event.eventData));
+        }
+
+        for (auto const& eventData : eventDatas) {
+          switch (eventType) {
+          case thrift::PlatformEventType::LINK_EVENT: {
+            VLOG(3) << "Received Link Event from Platform....";
+            try {
+              const auto linkEvt =
+                  fbzmq::util::readThriftObjStr<thrift::LinkEntry>(
+                      eventData, serializer_);
+              auto interfaceEntry =
+                  getOrCreateInterfaceEntry(linkEvt.ifName);
+              if (interfaceEntry) {
+                const bool wasUp = interfaceEntry->isUp();
+                interfaceEntry->updateAttrs(
+                    linkEvt.ifIndex, linkEvt.isUp, linkEvt.weight);
+                logLinkEvent(
+                    interfaceEntry->getIfName(),
+                    wasUp,
+                    interfaceEntry->isUp(),
+                    interfaceEntry->getBackoffDuration());
+              }
+            } catch (std::exception const& e) {
+              LOG(ERROR) << "Error parsing linkEvt. Reason: "
+                         << folly::exceptionStr(e);
             }
-          } catch (std::exception const& e) {
-            LOG(ERROR) << "Error parsing linkEvt. Reason: "
-                       << folly::exceptionStr(e);
-          }
-        } break;
-
-        case thrift::PlatformEventType::ADDRESS_EVENT: {
-          VLOG(3) << "Received Address Event from Platform....";
-          try {
-            const auto addrEvt =
-                fbzmq::util::readThriftObjStr<thrift::AddrEntry>(
-                    eventMsg.value().eventData, serializer_);
-            auto interfaceEntry = getOrCreateInterfaceEntry(addrEvt.ifName);
-            if (interfaceEntry) {
-              interfaceEntry->updateAddr(
-                  toIPNetwork(addrEvt.ipPrefix, false /* no masking */),
-                  addrEvt.isValid);
+          } break;
+
+          case thrift::PlatformEventType::ADDRESS_EVENT: {
+            VLOG(3) << "Received Address Event from Platform....";
+            try {
+              const auto addrEvt =
+                  fbzmq::util::readThriftObjStr<thrift::AddrEntry>(
+                      eventData, serializer_);
+              auto interfaceEntry =
+                  getOrCreateInterfaceEntry(addrEvt.ifName);
+              if (interfaceEntry) {
+                interfaceEntry->updateAddr(
+                    toIPNetwork(addrEvt.ipPrefix, false /* no masking */),
+                    addrEvt.isValid);
+              }
+            } catch (std::exception const& e) {
+              LOG(ERROR) << "Error parsing addrEvt. Reason: "
+                         << folly::exceptionStr(e);
             }
-          } catch (std::exception const& e) {
-            LOG(ERROR) << "Error parsing addrEvt. Reason: "
-                       << folly::exceptionStr(e);
-          }
-        } break;
+          } break;
 
-        default:
-          LOG(ERROR) << "Wrong eventType received on " << nodeId_
-                     << ", eventType: " << static_cast<uint16_t>(eventType);
+          default:
+            LOG(ERROR) << "Wrong eventType received on " << nodeId_
+                       << ", eventType: " << static_cast<uint16_t>(eventType);
+          }
         }
       });
 
@@ -336,7 +380,12 @@ LinkMonitor::prepare() noexcept {
     if (success) {
       VLOG(2) << "InterfaceDb Sync is successful";
       expBackoff_.reportSuccess();
-      interfaceDbSyncTimer_->scheduleTimeout(Constants::kPlatformSyncInterval);
+      // events are tracked reliably if publisher sends sequence numbers,
+      // hence periodic sync is needed less often
+      interfaceDbSyncTimer_->scheduleTimeout(
+          lastPlatformEventSeqNums_.empty()
+              ? Constants::kPlatformSyncInterval
+              : Constants::kPlatformEventDrivenSyncInterval);
     } else {
       fb303::fbData->addStatValue(
           "link_monitor.thrift.failure.getAllLinks", 1, fb303::SUM);
@@ -365,6 +414,7 @@ LinkMonitor::neighborUpEvent(const thrift::SparkNeighborEvent& event) {
   const int32_t kvStoreCmdPort = event.neighbor.kvStoreCmdPort;
   const int32_t openrCtrlThriftPort = event.neighbor.openrCtrlThriftPort;
   auto rttMetric = getRttMetric(event.rttUs);
+  StartupTimeline::get().record("first_adjacency");
   auto now = std::chrono::system_clock::now();
   // current unixtime in s
   int64_t timestamp =
@@ -423,9 +473,23 @@ LinkMonitor::neighborUpEvent(const thrift::SparkNeighborEvent& event) {
   peerSpec.peerAddr = peerAddr;
   peerSpec.ctrlPort = openrCtrlThriftPort;
   peerSpec.supportFloodOptimization = event.supportFloodOptimization;
-  adjacencies_[adjId] =
+  peerSpec.supportHashTreeSync = event.supportHashTreeSync;
+  peerSpec.supportValueCompression = event.supportValueCompression;
+  peerSpec.supportTtlRefreshBatch = event.supportTtlRefreshBatch;
+  peerSpec.supportNodeIdsBloom = event.supportNodeIdsBloom;
+  auto& adjValue = adjacencies_[adjId] =
       AdjacencyValue(peerSpec, std::move(newAdj), false, area);
 
+  // Hold back adjacency of flapping neighbor. KvStore peering is not dampened
+  if (isAdjacencySuppressed(adjId)) {
+    LOG(INFO) << "Adjacency to " << remoteNodeName << " on interface "
+              << ifName << " is dampened";
+    adjValue.isDampened = true;
+    fb303::fbData->addStatValue(
+        "link_monitor.dampening.neighbor_up_suppressed", 1, fb303::SUM);
+    scheduleAdjDampeningTimer();
+  }
+
   // Advertise KvStore peers immediately
   advertiseKvStorePeers(area, {{remoteNodeName, peerSpec}});
 
@@ -448,6 +512,10 @@ LinkMonitor::neighborDownEvent(const thrift::SparkNeighborEvent& event) {
   if (adjValueIt != adjacencies_.end()) {
     // remove such adjacencies
     adjacencies_.erase(adjValueIt);
+    // penalize the flap. Removal of adjacency is never held back
+    if (adjDampeningConfig_) {
+      dampenAdjacency(adjId, adjDampeningConfig_->flap_penalty);
+    }
   }
   // advertise both peers and adjacencies
   advertiseKvStorePeers(area);
@@ -485,13 +553,118 @@ LinkMonitor::neighborRttChangeEvent(const thrift::SparkNeighborEvent& event) {
 
   auto it = adjacencies_.find({remoteNodeName, ifName});
   if (it != adjacencies_.end()) {
+    if (adjDampeningConfig_ and
+        dampenAdjacency(it->first, adjDampeningConfig_->rtt_change_penalty)) {
+      VLOG(1) << "Metric change for neighbor " << remoteNodeName
+              << " is dampened";
+      it->second.dampenedRttUs = event.rttUs;
+      fb303::fbData->addStatValue(
+          "link_monitor.dampening.rtt_change_suppressed", 1, fb303::SUM);
+      return;
+    }
     auto& adj = it->second.adjacency;
     adj.metric = newRttMetric;
     adj.rtt = event.rttUs;
+    it->second.dampenedRttUs.reset();
     advertiseAdjacenciesThrottled_->operator()();
   }
 }
 
+bool
+LinkMonitor::dampenAdjacency(const AdjacencyKey& adjId, int32_t penalty) {
+  CHECK(adjDampeningConfig_);
+  auto it = adjDampeners_.find(adjId);
+  if (it == adjDampeners_.end()) {
+    it = adjDampeners_
+             .emplace(
+                 adjId,
+                 ExponentialDampener(
+                     std::chrono::seconds(adjDampeningConfig_->half_life_s),
+                     adjDampeningConfig_->suppress_threshold,
+                     adjDampeningConfig_->reuse_threshold,
+                     std::chrono::seconds(
+                         adjDampeningConfig_->max_suppress_time_s)))
+             .first;
+  }
+  const bool suppressed = it->second.addPenalty(penalty);
+  scheduleAdjDampeningTimer();
+  return suppressed;
+}
+
+bool
+LinkMonitor::isAdjacencySuppressed(const AdjacencyKey& adjId) {
+  auto it = adjDampeners_.find(adjId);
+  return it != adjDampeners_.end() and it->second.isSuppressed();
+}
+
+void
+LinkMonitor::processDampenedAdjacencies() {
+  bool released{false};
+  for (auto& [adjId, adjValue] : adjacencies_) {
+    if (not adjValue.isDampened and not adjValue.dampenedRttUs.has_value()) {
+      continue;
+    }
+    if (isAdjacencySuppressed(adjId)) {
+      continue;
+    }
+    LOG(INFO) << "Releasing dampened adjacency to " << adjId.first
+              << " on interface " << adjId.second;
+    if (adjValue.dampenedRttUs.has_value()) {
+      auto& adj = adjValue.adjacency;
+      adj.metric = getRttMetric(*adjValue.dampenedRttUs);
+      adj.rtt = *adjValue.dampenedRttUs;
+      adjValue.dampenedRttUs.reset();
+    }
+    adjValue.isDampened = false;
+    released = true;
+    fb303::fbData->addStatValue(
+        "link_monitor.dampening.released", 1, fb303::SUM);
+  }
+
+  // forget history of adjacencies once penalty decays to half of reuse
+  // threshold
+  for (auto it = adjDampeners_.begin(); it != adjDampeners_.end();) {
+    if (not it->second.isSuppressed() and
+        it->second.getPenalty() < adjDampeningConfig_->reuse_threshold / 2.0) {
+      it = adjDampeners_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  fb303::fbData->setCounter(
+      "link_monitor.dampening.adjacencies", adjDampeners_.size());
+
+  if (released) {
+    advertiseAdjacenciesThrottled_->operator()();
+  }
+  scheduleAdjDampeningTimer();
+}
+
+void
+LinkMonitor::scheduleAdjDampeningTimer() {
+  if (adjDampeners_.empty()) {
+    adjDampeningTimer_->cancelTimeout();
+    return;
+  }
+  // wake up at least every half-life to forget decayed dampeners, or as
+  // soon as held back adjacency can be released
+  std::chrono::milliseconds timeout =
+      std::chrono::seconds(adjDampeningConfig_->half_life_s);
+  for (const auto& [adjId, adjValue] : adjacencies_) {
+    if (not adjValue.isDampened and not adjValue.dampenedRttUs.has_value()) {
+      continue;
+    }
+    std::chrono::milliseconds timeUntilReuse{0};
+    auto it = adjDampeners_.find(adjId);
+    if (it != adjDampeners_.end()) {
+      timeUntilReuse = it->second.getTimeRemainingUntilReuse();
+    }
+    timeout = std::min(
+        timeout, std::max(timeUntilReuse, std::chrono::milliseconds(1)));
+  }
+  adjDampeningTimer_->scheduleTimeout(timeout);
+}
+
 std::unordered_map<std::string, thrift::PeerSpec>
 LinkMonitor::getPeersFromAdjacencies(
     const std::unordered_map<AdjacencyKey, AdjacencyValue>& adjacencies,
@@ -627,6 +800,10 @@ LinkMonitor::advertiseAdjacencies(const std::string& area) {
     if (adjKv.second.area != area) {
       continue;
     }
+    // held back by dampening
+    if (adjKv.second.isDampened) {
+      continue;
+    }
     // NOTE: copy on purpose
     auto adj = folly::copy(adjKv.second.adjacency);
 
@@ -658,6 +835,9 @@ LinkMonitor::advertiseAdjacencies(const std::string& area) {
 
   LOG(INFO) << "Updating adjacency database in KvStore with "
             << adjDb.adjacencies.size() << " entries in area: " << area;
+  if (perAdjacencyKeys_) {
+    advertisePerAdjacencyKeys(adjDb);
+  }
   const auto keyName = Constants::kAdjDbMarker.toString() + nodeId_;
   std::string adjDbStr = fbzmq::util::writeThriftObjStr(adjDb, serializer_);
   kvStoreClient_->persistKey(keyName, adjDbStr, ttlKeyInKvStore_, area);
@@ -675,6 +855,64 @@ LinkMonitor::advertiseAdjacencies(const std::string& area) {
         "link_monitor.metric." + adj.otherNodeName, adj.metric);
   }
 }
+
+void
+LinkMonitor::advertisePerAdjacencyKeys(thrift::AdjacencyDatabase& adjDb) {
+  auto const& area = adjDb.area_ref().value();
+  auto& advertisedAdjacencies = advertisedAdjacencies_[area];
+  std::unordered_map<std::string, thrift::Adjacency> nowAdvertising;
+
+  auto makePerKeyAdjDb = [&]() {
+    thrift::AdjacencyDatabase perKeyAdjDb;
+    perKeyAdjDb.thisNodeName = nodeId_;
+    perKeyAdjDb.area_ref() = area;
+    perKeyAdjDb.perfEvents_ref().copy_from(adjDb.perfEvents_ref());
+    return perKeyAdjDb;
+  };
+
+  // advertise new or changed adjacencies only
+  size_t numUpdated{0};
+  for (auto& adj : adjDb.adjacencies) {
+    auto key = PerAdjacencyKey(nodeId_, adj.otherNodeName, adj.ifName)
+                   .getAdjacencyKey();
+    auto it = advertisedAdjacencies.find(key);
+    if (it == advertisedAdjacencies.end() or not(it->second == adj)) {
+      auto perKeyAdjDb = makePerKeyAdjDb();
+      perKeyAdjDb.adjacencies.emplace_back(adj);
+      kvStoreClient_->persistKey(
+          key,
+          fbzmq::util::writeThriftObjStr(perKeyAdjDb, serializer_),
+          ttlKeyInKvStore_,
+          area);
+      ++numUpdated;
+    }
+    nowAdvertising.emplace(std::move(key), std::move(adj));
+  }
+
+  // one last key set without adjacency signifies withdrawal, then the key
+  // should ttl out
+  for (auto const& [key, _] : advertisedAdjacencies) {
+    if (nowAdvertising.count(key)) {
+      continue;
+    }
+    LOG(INFO) << "Withdrawing key: " << key << " from KvStore area: " << area;
+    kvStoreClient_->clearKey(
+        key,
+        fbzmq::util::writeThriftObjStr(makePerKeyAdjDb(), serializer_),
+        ttlKeyInKvStore_,
+        area);
+    ++numUpdated;
+  }
+  advertisedAdjacencies = std::move(nowAdvertising);
+  fb303::fbData->addStatValue(
+      "link_monitor.advertise_adjacency_keys", numUpdated, fb303::SUM);
+
+  // adjacency database key carries only node attributes. Perf events are
+  // carried by the updated adjacency keys
+  adjDb.adjacencies.clear();
+  adjDb.perfEvents_ref().reset();
+}
+
 void
 LinkMonitor::advertiseAdjacencies() {
   // advertise to all areas. Once area configuration per link is implemented
@@ -710,23 +948,59 @@ void
 LinkMonitor::advertiseInterfaces() {
   fb303::fbData->addStatValue("link_monitor.advertise_links", 1, fb303::SUM);
 
-  // Create interface database
+  const auto now = std::chrono::steady_clock::now();
+  const bool isSnapshot = not lastInterfaceSnapshot_.has_value() or
+      now - *lastInterfaceSnapshot_ >= Constants::kInterfaceDbSnapshotInterval;
+
+  // Create interface database with interfaces changed since the last
+  // advertisement, or all of them for snapshot
   thrift::InterfaceDatabase ifDb;
   ifDb.thisNodeName = nodeId_;
+  ifDb.isDelta = not isSnapshot;
   for (auto& kv : interfaces_) {
     auto& ifName = kv.first;
     auto& interface = kv.second;
-    // Perform regex match
-    if (not checkIncludeExcludeRegex(
-            ifName, includeItfRegexes_, excludeItfRegexes_)) {
+    if (not includedInterfaces_.count(ifName)) {
       continue;
     }
     // Get interface info and override active status
     auto interfaceInfo = interface.getInterfaceInfo();
     interfaceInfo.isUp = interface.isActive();
+    auto it = advertisedInterfaces_.find(ifName);
+    if (it == advertisedInterfaces_.end()) {
+      advertisedInterfaces_.emplace(ifName, interfaceInfo);
+    } else if (it->second != interfaceInfo) {
+      it->second = interfaceInfo;
+    } else if (not isSnapshot) {
+      continue;
+    }
     ifDb.interfaces.emplace(ifName, std::move(interfaceInfo));
   }
 
+  // Report removed interfaces as down in delta
+  for (auto it = advertisedInterfaces_.begin();
+       it != advertisedInterfaces_.end();) {
+    if (interfaces_.count(it->first)) {
+      ++it;
+      continue;
+    }
+    if (not isSnapshot) {
+      it->second.isUp = false;
+      ifDb.interfaces.emplace(it->first, std::move(it->second));
+    }
+    it = advertisedInterfaces_.erase(it);
+  }
+
+  if (isSnapshot) {
+    lastInterfaceSnapshot_ = now;
+  } else if (ifDb.interfaces.empty()) {
+    // nothing changed
+    return;
+  }
+
+  fb303::fbData->addStatValue(
+      "link_monitor.advertised_interfaces", ifDb.interfaces.size(), fb303::AVG);
+
   // publish new interface database to other modules (Fib & Spark)
   interfaceUpdatesQueue_.push(std::move(ifDb));
 }
@@ -758,7 +1032,7 @@ LinkMonitor::advertiseRedistAddrs() {
       continue;
     }
     // Perform regex match
-    if (not matchRegexSet(interface.getIfName(), redistributeItfRegexes_)) {
+    if (not interfaceFilter_->isRedistributed(interface.getIfName())) {
       continue;
     }
     // Add all prefixes of this interface
@@ -802,9 +1076,8 @@ LinkMonitor::getRetryTimeOnUnstableInterfaces() {
 InterfaceEntry* FOLLY_NULLABLE
 LinkMonitor::getOrCreateInterfaceEntry(const std::string& ifName) {
   // Return null if ifName doesn't quality regex match criteria
-  if (not checkIncludeExcludeRegex(
-          ifName, includeItfRegexes_, excludeItfRegexes_) and
-      not matchRegexSet(ifName, redistributeItfRegexes_)) {
+  if (not interfaceFilter_->isIncluded(ifName) and
+      not interfaceFilter_->isRedistributed(ifName)) {
     return nullptr;
   }
 
@@ -815,6 +1088,9 @@ LinkMonitor::getOrCreateInterfaceEntry(const std::string& ifName) {
   }
 
   // Create one and return it's reference
+  if (interfaceFilter_->isIncluded(ifName)) {
+    includedInterfaces_.emplace(ifName);
+  }
   auto res = interfaces_.emplace(
       ifName,
       InterfaceEntry(
@@ -860,6 +1136,33 @@ LinkMonitor::createNetlinkSystemHandlerClient() {
       std::make_unique<thrift::SystemServiceAsyncClient>(std::move(channel));
 }
 
+bool
+LinkMonitor::checkPlatformEventSeqNum(const thrift::PlatformEvent& event) {
+  if (not event.seqNum_ref().has_value()) {
+    // publisher doesn't support sequence numbers
+    return true;
+  }
+  const auto seqNum = event.seqNum_ref().value();
+  auto [it, inserted] =
+      lastPlatformEventSeqNums_.emplace(event.eventType, seqNum);
+  if (inserted) {
+    // first event, InterfaceDb is synced on start anyway
+    return true;
+  }
+  const auto lastSeqNum = std::exchange(it->second, seqNum);
+  if (seqNum == lastSeqNum + 1) {
+    return true;
+  }
+  // gap, or publisher restarted
+  LOG(WARNING) << "Gap in sequence numbers of "
+               << apache::thrift::util::enumNameSafe(event.eventType)
+               << " platform events, " << lastSeqNum << " -> " << seqNum
+               << ". Resyncing InterfaceDb";
+  fb303::fbData->addStatValue(
+      "link_monitor.platform_event_gaps", 1, fb303::SUM);
+  return false;
+}
+
 bool
 LinkMonitor::syncInterfaces() {
   VLOG(1) << "Syncing Interface DB from Netlink Platform";
@@ -1231,22 +1534,17 @@ LinkMonitor::getLinkMonitorAdjacencies() {
 
 void
 LinkMonitor::logNeighborEvent(thrift::SparkNeighborEvent const& event) {
-  fbzmq::LogSample sample{};
-  sample.addString(
-      "event",
+  EventLogger::Event logEvent;
+  logEvent.event =
       apache::thrift::TEnumTraits<thrift::SparkNeighborEventType>::findName(
-          event.eventType));
-  sample.addString("node_name", nodeId_);
-  sample.addString("neighbor", event.neighbor.nodeName);
-  sample.addString("interface", event.ifName);
-  sample.addString("remote_interface", event.neighbor.ifName);
-  sample.addString("area", event.area);
-  sample.addInt("rtt_us", event.rttUs);
-
-  zmqMonitorClient_->addEventLog(fbzmq::thrift::EventLog(
-      apache::thrift::FRAGILE,
-      Constants::kEventLogCategory.toString(),
-      {sample.toJson()}));
+          event.eventType);
+  logEvent.strings.emplace_back("node_name", nodeId_);
+  logEvent.strings.emplace_back("neighbor", event.neighbor.nodeName);
+  logEvent.strings.emplace_back("interface", event.ifName);
+  logEvent.strings.emplace_back("remote_interface", event.neighbor.ifName);
+  logEvent.strings.emplace_back("area", event.area);
+  logEvent.ints.emplace_back("rtt_us", event.rttUs);
+  eventLogger_->log(std::move(logEvent));
 }
 
 void
@@ -1260,18 +1558,14 @@ LinkMonitor::logLinkEvent(
     return;
   }
 
-  fbzmq::LogSample sample{};
   const std::string event = isUp ? "UP" : "DOWN";
 
-  sample.addString("event", folly::sformat("IFACE_{}", event));
-  sample.addString("node_name", nodeId_);
-  sample.addString("interface", iface);
-  sample.addInt("backoff_ms", backoffTime.count());
-
-  zmqMonitorClient_->addEventLog(fbzmq::thrift::EventLog(
-      apache::thrift::FRAGILE,
-      Constants::kEventLogCategory.toString(),
-      {sample.toJson()}));
+  EventLogger::Event logEvent;
+  logEvent.event = folly::sformat("IFACE_{}", event);
+  logEvent.strings.emplace_back("node_name", nodeId_);
+  logEvent.strings.emplace_back("interface", iface);
+  logEvent.ints.emplace_back("backoff_ms", backoffTime.count());
+  eventLogger_->log(std::move(logEvent));
 
   SYSLOG(INFO) << "Interface " << iface << " is " << event
                << " and has backoff of " << backoffTime.count() << "ms";
@@ -1282,17 +1576,12 @@ LinkMonitor::logPeerEvent(
     const std::string& event,
     const std::string& peerName,
     const thrift::PeerSpec& peerSpec) {
-  fbzmq::LogSample sample{};
-
-  sample.addString("event", event);
-  sample.addString("node_name", nodeId_);
-  sample.addString("peer_name", peerName);
-  sample.addString("cmd_url", peerSpec.cmdUrl);
-
-  zmqMonitorClient_->addEventLog(fbzmq::thrift::EventLog(
-      apache::thrift::FRAGILE,
-      Constants::kEventLogCategory.toString(),
-      {sample.toJson()}));
+  EventLogger::Event logEvent;
+  logEvent.event = event;
+  logEvent.strings.emplace_back("node_name", nodeId_);
+  logEvent.strings.emplace_back("peer_name", peerName);
+  logEvent.strings.emplace_back("cmd_url", peerSpec.cmdUrl);
+  eventLogger_->log(std::move(logEvent));
 }
 
 } // namespace openr
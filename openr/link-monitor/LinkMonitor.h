@@ -9,6 +9,7 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -29,8 +30,11 @@
 
 #include <openr/allocators/RangeAllocator.h>
 #include <openr/common/AsyncThrottle.h>
+#include <openr/common/EventLogger.h>
+#include <openr/common/ExponentialDampener.h>
 #include <openr/common/OpenrEventBase.h>
 #include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
@@ -53,6 +57,10 @@ struct AdjacencyValue {
   thrift::Adjacency adjacency;
   bool isRestarting{false};
   std::string area{};
+  // adjacency is held back from advertisement by dampening
+  bool isDampened{false};
+  // latest RTT measurement held back by dampening
+  std::optional<int64_t> dampenedRttUs;
   AdjacencyValue() {}
   AdjacencyValue(
       thrift::PeerSpec spec,
@@ -180,6 +188,11 @@ class LinkMonitor final : public OpenrEventBase {
   // return true if sync is successful
   bool syncInterfaces();
 
+  // Track sequence number of platform event. Returns false on gap in
+  // sequence numbers, i.e. if events have been dropped and InterfaceDb must
+  // be resynced
+  bool checkPlatformEventSeqNum(const thrift::PlatformEvent& event);
+
   // Create thrift client (client_) to NetlinkSystemHandler.
   // Can throw exception if it fails to open transport to client on specified
   // port. used by syncInterfaces()
@@ -247,10 +260,39 @@ class LinkMonitor final : public OpenrEventBase {
   void advertiseAdjacencies(const std::string& area);
   void advertiseAdjacencies(); // Advertise my adjacencies_ in to all areas
 
+  /*
+   * [Dampening] Hold back changes of flapping adjacencies
+   *
+   * Every RTT change and flap adds penalty to the adjacency. Changes of
+   * suppressed adjacency are held back until its penalty decays
+   */
+
+  // Add penalty to dampener of the adjacency. Returns true if changes of the
+  // adjacency must be held back
+  bool dampenAdjacency(const AdjacencyKey& adjId, int32_t penalty);
+
+  // Is adjacency suppressed by its dampener
+  bool isAdjacencySuppressed(const AdjacencyKey& adjId);
+
+  // Release held back changes of adjacencies which are no longer suppressed
+  // and forget dampeners whose penalty has decayed
+  void processDampenedAdjacencies();
+
+  // Schedule adjDampeningTimer_ for the earliest release of suppressed
+  // adjacency
+  void scheduleAdjDampeningTimer();
+
+  // Advertise adjacencies of the database with per adjacency keys, flooding
+  // only new or changed adjacencies and withdrawing removed ones. Adjacencies
+  // are moved out of the database, leaving node attributes in it
+  void advertisePerAdjacencyKeys(thrift::AdjacencyDatabase& adjDb);
+
   /*
    * [Spark/Fib] Advertise interfaces_ over interfaceUpdatesQueue_ to Spark/Fib
    *
-   * Called in advertiseIfaceAddr() upon interface changes
+   * Called in advertiseIfaceAddr() upon interface changes. Only interfaces
+   * changed since the last advertisement are published, with a full snapshot
+   * every Constants::kInterfaceDbSnapshotInterval
    */
   void advertiseInterfaces();
 
@@ -300,15 +342,17 @@ class LinkMonitor final : public OpenrEventBase {
   thrift::PrefixForwardingAlgorithm prefixForwardingAlgorithm_;
   // Use spark measured RTT to neighbor as link metric
   bool useRttMetric_{false};
+  // Advertise every adjacency with its own key
+  bool perAdjacencyKeys_{false};
+  // Adjacency dampening config, dampening is enabled if set
+  std::optional<thrift::AdjacencyDampeningConfig> adjDampeningConfig_;
   // link flap back offs
   std::chrono::milliseconds linkflapInitBackoff_;
   std::chrono::milliseconds linkflapMaxBackoff_;
   // TTL for a key in the key value store
   std::chrono::milliseconds ttlKeyInKvStore_;
-  // interface regexes
-  std::shared_ptr<const re2::RE2::Set> includeItfRegexes_;
-  std::shared_ptr<const re2::RE2::Set> excludeItfRegexes_;
-  std::shared_ptr<const re2::RE2::Set> redistributeItfRegexes_;
+  // interface filter compiled from interface regexes
+  std::shared_ptr<const InterfaceFilter> interfaceFilter_;
   // area ids
   std::unordered_set<std::string> areas_{};
 
@@ -344,6 +388,16 @@ class LinkMonitor final : public OpenrEventBase {
   // (we use the "min" interface) for tcp connection
   std::unordered_map<AdjacencyKey, AdjacencyValue> adjacencies_;
 
+  // Dampeners of adjacencies. They outlive adjacencies in order to track
+  // adjacency flaps
+  std::unordered_map<AdjacencyKey, ExponentialDampener> adjDampeners_;
+
+  // Adjacencies advertised with per adjacency keys, keyed by area and key
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<std::string /* key */, thrift::Adjacency>>
+      advertisedAdjacencies_;
+
   // Previously announced KvStore peers
   std::unordered_map<
       std::string /* area */,
@@ -354,6 +408,14 @@ class LinkMonitor final : public OpenrEventBase {
   // Keyed by interface Name
   std::unordered_map<std::string, InterfaceEntry> interfaces_;
 
+  // interfaces_ matching include regexes, evaluated once on entry creation
+  std::unordered_set<std::string> includedInterfaces_;
+
+  // interfaces last advertised to Spark/Fib, and time of the last full
+  // snapshot
+  std::unordered_map<std::string, thrift::InterfaceInfo> advertisedInterfaces_;
+  std::optional<std::chrono::steady_clock::time_point> lastInterfaceSnapshot_;
+
   // Throttled versions of "advertise<>" functions. It batches
   // up multiple calls and send them in one go!
   std::unique_ptr<AsyncThrottle> advertiseAdjacenciesThrottled_;
@@ -364,6 +426,10 @@ class LinkMonitor final : public OpenrEventBase {
 
   // Timer for resyncing InterfaceDb from netlink
   std::unique_ptr<folly::AsyncTimeout> interfaceDbSyncTimer_;
+
+  // Sequence numbers of last received platform events, per event type
+  std::unordered_map<thrift::PlatformEventType, int64_t>
+      lastPlatformEventSeqNums_;
   ExponentialBackoff<std::chrono::milliseconds> expBackoff_;
 
   // Thrift client connection to switch SystemService, which we actually use to
@@ -382,6 +448,9 @@ class LinkMonitor final : public OpenrEventBase {
   // client to interact with ZmqMonitor
   std::unique_ptr<fbzmq::ZmqMonitorClient> zmqMonitorClient_;
 
+  // ships event logs to ZmqMonitor off the LinkMonitor thread
+  std::unique_ptr<EventLogger> eventLogger_;
+
   // client to interact with ConfigStore
   PersistentStore* configStore_{nullptr};
 
@@ -393,6 +462,9 @@ class LinkMonitor final : public OpenrEventBase {
 
   // Timer for initial hold time expiry
   std::unique_ptr<folly::AsyncTimeout> adjHoldTimer_;
+
+  // Timer for releasing held back changes of dampened adjacencies
+  std::unique_ptr<folly::AsyncTimeout> adjDampeningTimer_;
 }; // LinkMonitor
 
 } // namespace openr
@@ -0,0 +1,337 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "MockNetlinkSystemHandler.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <thrift/lib/cpp2/server/ThriftServer.h>
+#include <thrift/lib/cpp2/util/ScopedServerThread.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/link-monitor/LinkMonitor.h>
+#include <openr/messaging/ReplicateQueue.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes parameters to another one, with a custom name for
+ * the parameters.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace {
+
+const std::string kNodeName{"node-1"};
+const std::string kConfigStorePath{"/tmp/lm_benchmark_config_store.bin"};
+const std::string kPlatformPubUrl{"inproc://lm-benchmark-platform-pub-url"};
+// Ports advertised by simulated neighbors
+const int64_t kKvStoreCmdPort{10001};
+const int64_t kOpenrCtrlThriftPort{2018};
+
+// Number of heap allocations made by the benchmark process
+std::atomic<uint64_t> numAllocations{0};
+
+} // anonymous namespace
+
+// Count allocations, reported by all the benchmarks
+void*
+operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /* size */) noexcept {
+  std::free(ptr);
+}
+
+namespace openr {
+
+using apache::thrift::ThriftServer;
+using apache::thrift::util::ScopedServerThread;
+
+namespace {
+
+std::string
+getInterfaceName(size_t index) {
+  return folly::sformat("iface_{}", index);
+}
+
+/**
+ * LinkMonitor with K interfaces up, fed with neighbor events of simulated
+ * Spark. Adjacency database published by KvStore tells when events reached
+ * KvStore
+ */
+class LinkMonitorBenchmarkFixture {
+ public:
+  explicit LinkMonitorBenchmarkFixture(size_t numOfInterfaces) {
+    mockNlHandler_ =
+        std::make_shared<MockNetlinkSystemHandler>(context_, kPlatformPubUrl);
+    server_ = std::make_shared<ThriftServer>();
+    server_->setNumIOWorkerThreads(1);
+    server_->setNumAcceptThreads(1);
+    server_->setPort(0);
+    server_->setInterface(mockNlHandler_);
+    systemThriftThread_.start(server_);
+
+    configStore_ = std::make_unique<PersistentStore>(
+        "1",
+        kConfigStorePath,
+        context_,
+        true /* dryrun */,
+        false /* periodicallySaveToDisk */);
+    configStoreThread_ = std::thread([this]() { configStore_->run(); });
+    configStore_->waitUntilRunning();
+
+    auto tConfig = getBasicOpenrConfig(kNodeName);
+    tConfig.link_monitor_config.use_rtt_metric = false;
+    tConfig.link_monitor_config.include_interface_regexes = {"iface.*"};
+    config_ = std::make_shared<Config>(tConfig);
+
+    kvStoreWrapper_ = std::make_unique<KvStoreWrapper>(
+        context_, config_, peerUpdatesQueue_.getReader());
+    kvStoreWrapper_->run();
+
+    linkMonitor_ = std::make_unique<LinkMonitor>(
+        context_,
+        config_,
+        systemThriftThread_.getAddress()->getPort(),
+        kvStoreWrapper_->getKvStore(),
+        std::vector<thrift::IpPrefix>{},
+        false /* enable perf measurement */,
+        interfaceUpdatesQueue_,
+        peerUpdatesQueue_,
+        neighborUpdatesQueue_.getReader(),
+        MonitorSubmitUrl{"inproc://lm-benchmark-monitor-rep"},
+        configStore_.get(),
+        false /* assumeDrained */,
+        prefixUpdatesQueue_,
+        PlatformPublisherUrl{kPlatformPubUrl},
+        std::chrono::seconds(0) /* adjHoldTime */);
+    linkMonitorThread_ = std::thread([this]() { linkMonitor_->run(); });
+    linkMonitor_->waitUntilRunning();
+
+    // bring up all the interfaces, and wait for LinkMonitor to report them
+    for (size_t i = 0; i < numOfInterfaces; ++i) {
+      mockNlHandler_->sendLinkEvent(getInterfaceName(i), i + 1, true);
+    }
+    std::map<std::string, thrift::InterfaceInfo> interfaces;
+    size_t numOfUpInterfaces{0};
+    while (numOfUpInterfaces != numOfInterfaces) {
+      auto ifDb = interfaceUpdatesReader_.get();
+      CHECK(ifDb.hasValue());
+      if (not ifDb->isDelta) {
+        interfaces.clear();
+      }
+      for (auto& [ifName, info] : ifDb->interfaces) {
+        interfaces[ifName] = std::move(info);
+      }
+      numOfUpInterfaces = 0;
+      for (auto const& [_, info] : interfaces) {
+        numOfUpInterfaces += info.isUp ? 1 : 0;
+      }
+    }
+  }
+
+  ~LinkMonitorBenchmarkFixture() {
+    interfaceUpdatesQueue_.close();
+    peerUpdatesQueue_.close();
+    neighborUpdatesQueue_.close();
+    prefixUpdatesQueue_.close();
+    kvStoreWrapper_->closeQueue();
+
+    linkMonitor_->stop();
+    linkMonitorThread_.join();
+    linkMonitor_.reset();
+
+    configStore_->stop();
+    configStoreThread_.join();
+    configStore_.reset();
+
+    kvStoreWrapper_->stop();
+    kvStoreWrapper_.reset();
+
+    mockNlHandler_->stop();
+    systemThriftThread_.stop();
+    mockNlHandler_.reset();
+  }
+
+  void
+  pushNeighborEvent(thrift::SparkNeighborEvent event) {
+    neighborUpdatesQueue_.push(std::move(event));
+  }
+
+  // Wait till KvStore publishes adjacency database of given size
+  void
+  waitForAdjacencies(size_t numOfAdjacencies) {
+    const auto adjKey = folly::sformat("adj:{}", kNodeName);
+    while (true) {
+      auto publication = kvStoreWrapper_->recvPublication();
+      auto it = publication.keyVals.find(adjKey);
+      if (it == publication.keyVals.end() or
+          not it->second.value_ref().has_value()) {
+        continue;
+      }
+      auto adjDb = fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
+          it->second.value_ref().value(), serializer_);
+      if (adjDb.adjacencies.size() == numOfAdjacencies) {
+        return;
+      }
+    }
+  }
+
+ private:
+  fbzmq::Context context_;
+  apache::thrift::CompactSerializer serializer_;
+
+  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
+  messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesReader_{
+      interfaceUpdatesQueue_.getReader()};
+
+  std::shared_ptr<MockNetlinkSystemHandler> mockNlHandler_;
+  std::shared_ptr<ThriftServer> server_;
+  ScopedServerThread systemThriftThread_;
+
+  std::shared_ptr<Config> config_;
+  std::unique_ptr<PersistentStore> configStore_;
+  std::thread configStoreThread_;
+  std::unique_ptr<KvStoreWrapper> kvStoreWrapper_;
+  std::unique_ptr<LinkMonitor> linkMonitor_;
+  std::thread linkMonitorThread_;
+};
+
+// Events of M neighbors spread round robin over K interfaces
+std::vector<thrift::SparkNeighborEvent>
+createNeighborEvents(
+    thrift::SparkNeighborEventType eventType,
+    size_t numOfNeighbors,
+    size_t numOfInterfaces) {
+  std::vector<thrift::SparkNeighborEvent> events;
+  events.reserve(numOfNeighbors);
+  for (size_t i = 0; i < numOfNeighbors; ++i) {
+    const auto ifName = getInterfaceName(i % numOfInterfaces);
+    const auto v4Addr = folly::IPAddress(folly::sformat(
+        "10.{}.{}.{}", (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff));
+    const auto v6Addr =
+        folly::IPAddress(folly::sformat("fe80::{:x}", i + 2));
+    events.emplace_back(createSparkNeighborEvent(
+        eventType,
+        ifName,
+        createSparkNeighbor(
+            folly::sformat("node-{}", i + 2),
+            toBinaryAddress(v4Addr),
+            toBinaryAddress(v6Addr),
+            kKvStoreCmdPort,
+            kOpenrCtrlThriftPort,
+            ""),
+        100 /* rttUs */,
+        i + 1 /* label */,
+        false /* supportFloodOptimization */));
+  }
+  return events;
+}
+
+/**
+ * Measure latency of M neighbors coming up over K interfaces, from events
+ * of Spark till adjacency database with all of them is published by KvStore.
+ * Neighbors are brought down between iterations, without measuring.
+ *
+ * NOTE: Latency includes the throttling of adjacency advertisement
+ * (kLinkThrottleTimeout), i.e. the one seen by rest of the network.
+ * Allocations are counted across all the threads, including KvStore ones.
+ */
+void
+BM_LinkMonitorNeighborUp(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfNeighbors,
+    size_t numOfInterfaces) {
+  auto suspender = folly::BenchmarkSuspender();
+  LinkMonitorBenchmarkFixture fixture(numOfInterfaces);
+  const auto upEvents = createNeighborEvents(
+      thrift::SparkNeighborEventType::NEIGHBOR_UP,
+      numOfNeighbors,
+      numOfInterfaces);
+  const auto downEvents = createNeighborEvents(
+      thrift::SparkNeighborEventType::NEIGHBOR_DOWN,
+      numOfNeighbors,
+      numOfInterfaces);
+
+  uint64_t allocations{0};
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    const auto allocationsBefore = numAllocations.load();
+    for (auto const& event : upEvents) {
+      fixture.pushNeighborEvent(event);
+    }
+    fixture.waitForAdjacencies(numOfNeighbors);
+    allocations += numAllocations.load() - allocationsBefore;
+    suspender.rehire();
+
+    for (auto const& event : downEvents) {
+      fixture.pushNeighborEvent(event);
+    }
+    fixture.waitForAdjacencies(0);
+  }
+
+  counters["allocs_per_neighbor"] = allocations / (iters * numOfNeighbors);
+}
+
+} // namespace
+
+// The parameters are number of neighbors, and number of interfaces
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkMonitorNeighborUp, counters, 100_10, 100, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkMonitorNeighborUp, counters, 1000_100, 1000, 100);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkMonitorNeighborUp, counters, 1000_1000, 1000, 1000);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkMonitorNeighborUp, counters, 5000_500, 5000, 500);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -367,7 +367,13 @@ class LinkMonitorTestFixture : public ::testing::Test {
   recvAndReplyIfUpdate() {
     auto ifDb = interfaceUpdatesReader.get();
     ASSERT_TRUE(ifDb.hasValue());
-    sparkIfDb = std::move(ifDb.value().interfaces);
+    if (ifDb.value().isDelta) {
+      for (auto& kv : ifDb.value().interfaces) {
+        sparkIfDb[kv.first] = std::move(kv.second);
+      }
+    } else {
+      sparkIfDb = std::move(ifDb.value().interfaces);
+    }
     LOG(INFO) << "----------- Interface Updates ----------";
     for (const auto& kv : sparkIfDb) {
       LOG(INFO) << "  Name=" << kv.first << ", Status=" << kv.second.isUp
@@ -1491,6 +1497,36 @@ TEST_F(LinkMonitorTestFixture, verifyLinkEventSubscription) {
   });
 }
 
+// Only changed interfaces are published after the initial snapshot
+TEST_F(LinkMonitorTestFixture, DeltaInterfaceUpdates) {
+  SetUp({openr::thrift::KvStore_constants::kDefaultArea()});
+  const std::string linkX = kTestVethNamePrefix + "X";
+  const std::string linkY = kTestVethNamePrefix + "Y";
+
+  mockNlHandler->sendLinkEvent(
+      linkX /* link name */,
+      kTestVethIfIndex[0] /* ifIndex */,
+      true /* is up */);
+  recvAndReplyIfUpdate();
+  mockNlHandler->sendLinkEvent(
+      linkY /* link name */,
+      kTestVethIfIndex[1] /* ifIndex */,
+      true /* is up */);
+  recvAndReplyIfUpdate();
+  EXPECT_TRUE(checkExpectedUPCount(sparkIfDb, 2));
+
+  // link X going down is published alone
+  mockNlHandler->sendLinkEvent(
+      linkX /* link name */,
+      kTestVethIfIndex[0] /* ifIndex */,
+      false /* is up */);
+  auto ifDb = interfaceUpdatesReader.get();
+  ASSERT_TRUE(ifDb.hasValue());
+  EXPECT_TRUE(ifDb->isDelta);
+  ASSERT_EQ(1, ifDb->interfaces.size());
+  EXPECT_FALSE(ifDb->interfaces.at(linkX).isUp);
+}
+
 TEST_F(LinkMonitorTestFixture, verifyAddrEventSubscription) {
   SetUp({openr::thrift::KvStore_constants::kDefaultArea()});
   const std::string linkX = kTestVethNamePrefix + "X";
@@ -31,6 +31,45 @@ RQueue<ValueType>::getCoro() {
 }
 #endif
 
+template <typename ValueType>
+folly::Expected<std::vector<ValueType>, QueueError>
+RQueue<ValueType>::getBatch(size_t maxItems) {
+  return queue_->getBatch(maxItems);
+}
+
+template <typename ValueType>
+template <typename MergeFn>
+folly::Expected<std::vector<ValueType>, QueueError>
+RQueue<ValueType>::getBatch(size_t maxItems, MergeFn&& mergeFn) {
+  auto maybeBatch = queue_->getBatch(maxItems);
+  if (maybeBatch.hasError()) {
+    return maybeBatch;
+  }
+
+  // Coalesce consecutive elements in place
+  auto& batch = maybeBatch.value();
+  size_t last = 0;
+  for (size_t i = 1; i < batch.size(); ++i) {
+    if (mergeFn(batch[last], batch[i])) {
+      continue;
+    }
+    if (++last != i) {
+      batch[last] = std::move(batch[i]);
+    }
+  }
+  batch.erase(batch.begin() + last + 1, batch.end());
+  return maybeBatch;
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename ValueType>
+folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+RQueue<ValueType>::getBatchCoro(size_t maxItems) {
+  auto val = co_await queue_->getBatchCoro(maxItems);
+  co_return val;
+}
+#endif
+
 template <typename ValueType>
 size_t
 RQueue<ValueType>::size() {
@@ -38,7 +77,57 @@ RQueue<ValueType>::size() {
 }
 
 template <typename ValueType>
-RWQueue<ValueType>::RWQueue() {}
+bool
+RQueue<ValueType>::isOverSoftLimit() {
+  return queue_->isOverSoftLimit();
+}
+
+namespace detail {
+
+// Buckets of the latency histogram (in milliseconds)
+constexpr int64_t kLatencyBucketWidthMs{50};
+constexpr int64_t kLatencyMaxMs{5000};
+
+inline std::string
+getCounterName(std::string const& prefix, std::string const& name) {
+  return prefix.empty() ? "" : prefix + "." + name;
+}
+
+} // namespace detail
+
+template <typename ValueType>
+RWQueue<ValueType>::RWQueue(RWQueueOptions options)
+    : capacity_(options.capacity),
+      softLimit_(options.softLimit),
+      sizeCounter_(detail::getCounterName(options.counterPrefix, "size")),
+      depthCounter_(detail::getCounterName(options.counterPrefix, "depth")),
+      highWatermarkCounter_(
+          detail::getCounterName(options.counterPrefix, "high_watermark")),
+      pushFullCounter_(
+          detail::getCounterName(options.counterPrefix, "push_full")),
+      softLimitCounter_(detail::getCounterName(
+          options.counterPrefix, "soft_limit_exceeded")),
+      latencyCounter_(
+          detail::getCounterName(options.counterPrefix, "latency_ms")) {
+  if (capacity_) {
+    ring_ = std::make_unique<folly::MPMCQueue<Entry>>(capacity_);
+  }
+  if (not depthCounter_.empty()) {
+    facebook::fb303::fbData->addStatExportType(
+        depthCounter_, facebook::fb303::AVG);
+    facebook::fb303::fbData->addStatExportType(
+        pushFullCounter_, facebook::fb303::COUNT);
+    facebook::fb303::fbData->addStatExportType(
+        softLimitCounter_, facebook::fb303::COUNT);
+    facebook::fb303::fbData->addHistogram(
+        latencyCounter_,
+        detail::kLatencyBucketWidthMs,
+        0,
+        detail::kLatencyMaxMs);
+    facebook::fb303::fbData->exportHistogramPercentile(
+        latencyCounter_, 50, 95, 99);
+  }
+}
 
 template <typename ValueType>
 RWQueue<ValueType>::~RWQueue() {
@@ -49,25 +138,69 @@ template <typename ValueType>
 template <typename ValueTypeT>
 bool
 RWQueue<ValueType>::push(ValueTypeT&& val) {
-  std::lock_guard<std::mutex> l(lock_);
+  return tryPush(std::forward<ValueTypeT>(val)).hasValue();
+}
 
-  // If queue is closed, don't enqueue
-  if (closed_) {
-    return false;
+template <typename ValueType>
+template <typename ValueTypeT>
+folly::Expected<folly::Unit, QueueError>
+RWQueue<ValueType>::tryPush(ValueTypeT&& val) {
+  const auto enqueueTime =
+      latencyCounter_.empty() ? Clock::time_point() : Clock::now();
+
+  if (ring_) {
+    // If queue is closed, don't enqueue
+    if (closed_) {
+      return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
+    }
+
+    // Add data into the ring buffer. Value is not consumed if it is full
+    if (not ring_->write(std::forward<ValueTypeT>(val), enqueueTime)) {
+      if (not pushFullCounter_.empty()) {
+        facebook::fb303::fbData->addStatValue(
+            pushFullCounter_, 1, facebook::fb303::COUNT);
+      }
+      return folly::makeUnexpected(QueueError::QUEUE_FULL);
+    }
+
+    // Pairs with the fence in getAnyImpl. Either we see the waiting reader or
+    // the reader sees the data in ring buffer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numWaiting_.load()) {
+      // Unblock pending read(s)
+      std::lock_guard<std::mutex> l(lock_);
+      handoffImpl();
+    }
+
+    updateCounters(size());
+    return folly::unit;
   }
 
-  if (pendingReads_.size()) {
-    // Unblock a pending read
-    auto& pendingRead = pendingReads_.front().get();
-    pendingRead.data = std::forward<ValueTypeT>(val);
-    pendingRead.baton.post();
-    pendingReads_.pop_front();
-  } else {
-    // Add data into the queue
-    queue_.emplace_back(std::forward<ValueTypeT>(val));
+  size_t depth{0};
+  {
+    std::lock_guard<std::mutex> l(lock_);
+
+    // If queue is closed, don't enqueue
+    if (closed_) {
+      return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
+    }
+
+    if (pendingReads_.size()) {
+      // Unblock a pending read
+      auto& pendingRead = pendingReads_.front().get();
+      pendingRead.data = std::forward<ValueTypeT>(val);
+      pendingRead.enqueueTime = enqueueTime;
+      pendingRead.baton.post();
+      pendingReads_.pop_front();
+    } else {
+      // Add data into the queue
+      queue_.emplace_back(std::forward<ValueTypeT>(val), enqueueTime);
+    }
+    depth = queue_.size();
   }
 
-  return true;
+  updateCounters(depth);
+  return folly::unit;
 }
 
 template <typename ValueType>
@@ -80,16 +213,11 @@ RWQueue<ValueType>::get() {
     return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
   }
 
-  // Post our own baton if read is immediate (for)
-  // XXX: This will evenly distribute elements between readers when queue
-  // and also ensures fiber-fairness
-  if (pendingRead.data) {
-    pendingRead.baton.post();
-  }
-
   // Wait for baton and read the data
   pendingRead.baton.wait();
   if (pendingRead.data) {
+    updateLatency(pendingRead.enqueueTime);
+    updateSizeCounter();
     return std::move(pendingRead.data).value();
   }
   return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
@@ -106,23 +234,108 @@ RWQueue<ValueType>::getCoro() {
     co_return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
   }
 
-  // Wait if there is no data
-  if (pendingRead.data) {
-    pendingRead.baton.post();
-  }
-
   // Wait for baton and read the data
   co_await pendingRead.baton;
   if (pendingRead.data) {
+    updateLatency(pendingRead.enqueueTime);
+    updateSizeCounter();
     co_return std::move(pendingRead.data).value();
   }
   co_return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
 }
 #endif
 
+template <typename ValueType>
+folly::Expected<std::vector<ValueType>, QueueError>
+RWQueue<ValueType>::getBatch(size_t maxItems) {
+  assert(maxItems > 0);
+
+  // Wait for the first element
+  auto maybeValue = get();
+  if (maybeValue.hasError()) {
+    return folly::makeUnexpected(maybeValue.error());
+  }
+
+  std::vector<ValueType> batch;
+  batch.emplace_back(std::move(maybeValue).value());
+  drainImpl(batch, maxItems);
+  updateSizeCounter();
+  return batch;
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename ValueType>
+folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+RWQueue<ValueType>::getBatchCoro(size_t maxItems) {
+  assert(maxItems > 0);
+
+  // Wait for the first element
+  auto maybeValue = co_await getCoro();
+  if (maybeValue.hasError()) {
+    co_return folly::makeUnexpected(maybeValue.error());
+  }
+
+  std::vector<ValueType> batch;
+  batch.emplace_back(std::move(maybeValue).value());
+  drainImpl(batch, maxItems);
+  updateSizeCounter();
+  co_return batch;
+}
+#endif
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::drainImpl(std::vector<ValueType>& batch, size_t maxItems) {
+  if (ring_) {
+    Entry entry;
+    while (batch.size() < maxItems and ring_->read(entry)) {
+      updateLatency(entry.enqueueTime);
+      batch.emplace_back(std::move(entry.value));
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(lock_);
+  while (batch.size() < maxItems and queue_.size()) {
+    updateLatency(queue_.front().enqueueTime);
+    batch.emplace_back(std::move(queue_.front().value));
+    queue_.pop_front();
+  }
+}
+
 template <typename ValueType>
 bool
 RWQueue<ValueType>::getAnyImpl(PendingRead& pendingRead) {
+  if (ring_) {
+    // If queue is closed, return immediately
+    if (closed_) {
+      return false;
+    }
+
+    // Perform immediate read without lock if data is available
+    Entry entry;
+    if (ring_->read(entry)) {
+      pendingRead.data = std::move(entry.value);
+      pendingRead.enqueueTime = entry.enqueueTime;
+      pendingRead.baton.post();
+      return true;
+    }
+
+    // Else enqueue read request
+    std::lock_guard<std::mutex> l(lock_);
+    if (closed_) {
+      return false;
+    }
+    pendingReads_.emplace_back(pendingRead);
+    numWaiting_.fetch_add(1);
+
+    // Pairs with the fence in tryPush. Writer could have missed us waiting,
+    // hence check for the data once again
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    handoffImpl();
+    return true;
+  }
+
   std::lock_guard<std::mutex> l(lock_);
 
   // If queue is closed, return immediately
@@ -130,10 +343,16 @@ RWQueue<ValueType>::getAnyImpl(PendingRead& pendingRead) {
     return false;
   }
 
-  // Perform immediate read if data is available
+  // Perform immediate read if data is available. Post our own baton before
+  // the read becomes visible to writers, as they post it as well once
+  // pending read is served.
+  // XXX: This will evenly distribute elements between readers when queue
+  // and also ensures fiber-fairness
   if (queue_.size()) {
-    pendingRead.data = std::move(queue_.front());
+    pendingRead.data = std::move(queue_.front().value);
+    pendingRead.enqueueTime = queue_.front().enqueueTime;
     queue_.pop_front();
+    pendingRead.baton.post();
     return true;
   }
 
@@ -157,20 +376,90 @@ RWQueue<ValueType>::close() {
       pendingRead.baton.post();
       pendingReads_.pop_front();
     }
+    numWaiting_ = 0;
     queue_.clear();
+    if (ring_) {
+      Entry entry;
+      while (ring_->read(entry)) {
+      }
+    }
   }
 }
 
+template <typename ValueType>
+void
+RWQueue<ValueType>::handoffImpl() {
+  while (pendingReads_.size()) {
+    Entry entry;
+    if (not ring_->read(entry)) {
+      break;
+    }
+    auto& pendingRead = pendingReads_.front().get();
+    pendingRead.data = std::move(entry.value);
+    pendingRead.enqueueTime = entry.enqueueTime;
+    pendingRead.baton.post();
+    pendingReads_.pop_front();
+    numWaiting_.fetch_sub(1);
+  }
+}
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::updateCounters(size_t depth) {
+  auto prevHighWatermark = highWatermark_.load(std::memory_order_relaxed);
+  while (depth > prevHighWatermark and
+         not highWatermark_.compare_exchange_weak(
+             prevHighWatermark, depth, std::memory_order_relaxed)) {
+  }
+
+  if (depthCounter_.empty()) {
+    return;
+  }
+  facebook::fb303::fbData->setCounter(sizeCounter_, depth);
+  facebook::fb303::fbData->addStatValue(
+      depthCounter_, depth, facebook::fb303::AVG);
+  if (depth > prevHighWatermark) {
+    facebook::fb303::fbData->setCounter(highWatermarkCounter_, depth);
+  }
+  if (softLimit_ and depth > softLimit_) {
+    facebook::fb303::fbData->addStatValue(
+        softLimitCounter_, 1, facebook::fb303::COUNT);
+  }
+}
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::updateLatency(Clock::time_point enqueueTime) {
+  if (latencyCounter_.empty()) {
+    return;
+  }
+  const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - enqueueTime);
+  facebook::fb303::fbData->addHistogramValue(latencyCounter_, latency.count());
+}
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::updateSizeCounter() {
+  if (sizeCounter_.empty()) {
+    return;
+  }
+  facebook::fb303::fbData->setCounter(sizeCounter_, size());
+}
+
 template <typename ValueType>
 bool
 RWQueue<ValueType>::isClosed() {
-  std::lock_guard<std::mutex> l(lock_);
   return closed_;
 }
 
 template <typename ValueType>
 size_t
 RWQueue<ValueType>::size() {
+  if (ring_) {
+    // Size guess can be transiently negative while read is in progress
+    return std::max<ssize_t>(0, ring_->sizeGuess());
+  }
   std::lock_guard<std::mutex> l(lock_);
   return queue_.size();
 }
@@ -182,5 +471,11 @@ RWQueue<ValueType>::numPendingReads() {
   return pendingReads_.size();
 }
 
+template <typename ValueType>
+bool
+RWQueue<ValueType>::isOverSoftLimit() {
+  return softLimit_ and size() > softLimit_;
+}
+
 } // namespace messaging
 } // namespace openr
@@ -8,12 +8,20 @@
 #pragma once
 
 #include <any>
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <fb303/ServiceData.h>
 #include <folly/Expected.h>
+#include <folly/MPMCQueue.h>
+#include <folly/Unit.h>
 #include <folly/fibers/Baton.h>
 #if FOLLY_HAS_COROUTINES
 #include <folly/experimental/coro/Task.h>
@@ -24,6 +32,32 @@ namespace messaging {
 
 enum class QueueError {
   QUEUE_CLOSED,
+  QUEUE_FULL,
+};
+
+/**
+ * Options for RWQueue
+ */
+struct RWQueueOptions {
+  // Capacity of the bounded lock-free ring buffer backing the queue. Zero
+  // (default) selects unbounded mutex protected queue. Push to full bounded
+  // queue fails with QUEUE_FULL. Bounded queue requires default constructible
+  // value type.
+  size_t capacity{0};
+
+  // If non-empty, queue exports below fb303 counters
+  // - `<counterPrefix>.size` (current queue depth)
+  // - `<counterPrefix>.depth` (avg of queue depth sampled on push)
+  // - `<counterPrefix>.high_watermark` (max queue depth seen)
+  // - `<counterPrefix>.push_full` (count of pushes rejected by full queue)
+  // - `<counterPrefix>.soft_limit_exceeded` (count of pushes beyond soft limit)
+  // - `<counterPrefix>.latency_ms` (histogram of enqueue to dequeue latency)
+  std::string counterPrefix;
+
+  // Soft limit on the queue depth. Zero (default) disables it. Pushes beyond
+  // the limit are not rejected, but reader can check `isOverSoftLimit()` to
+  // react on the backlog e.g. by coalescing the pending elements.
+  size_t softLimit{0};
 };
 
 template <typename ValueType>
@@ -51,9 +85,39 @@ class RQueue {
   folly::coro::Task<folly::Expected<ValueType, QueueError>> getCoro();
 #endif
 
+  /**
+   * Blocking batch read for native threads/fibers. Waits for at least one
+   * element and returns it along with all other elements already queued, upto
+   * `maxItems` in total. Useful for consumers to process burst of updates in
+   * one go.
+   */
+  folly::Expected<std::vector<ValueType>, QueueError> getBatch(
+      size_t maxItems = std::numeric_limits<size_t>::max());
+
+  /**
+   * Same as above, but consecutive elements of the batch are coalesced with
+   * `mergeFn(ValueType& into, ValueType& from) -> bool`. It must return true
+   * if it merged `from` into `into`, and false (leaving both untouched) if
+   * elements can't be coalesced.
+   */
+  template <typename MergeFn>
+  folly::Expected<std::vector<ValueType>, QueueError> getBatch(
+      size_t maxItems, MergeFn&& mergeFn);
+
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Batch read method for co-routines
+   */
+  folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+  getBatchCoro(size_t maxItems = std::numeric_limits<size_t>::max());
+#endif
+
   // Utility function to retrieve size of pending data in underlying queue
   size_t size();
 
+  // Utility function to check if underlying queue is beyond its soft limit
+  bool isOverSoftLimit();
+
  protected:
   // We only hold reference of above queue
   std::shared_ptr<RWQueue<ValueType>> queue_{nullptr};
@@ -64,6 +128,10 @@ class RQueue {
  * Code in critical path is minimal and ensures that readers/writers will never
  * block each other because of lock.
  *
+ * With bounded capacity, data is stored in lock-free ring buffer instead. Push
+ * then takes the lock only if there are readers waiting for the data, and push
+ * to full queue is rejected so that writer can apply back-pressure.
+ *
  * This is polymorphic queue which means, you can push any type of object. There
  * are various get (blocking and async) methods to retrieve typed object.
  *
@@ -73,7 +141,7 @@ class RQueue {
 template <typename ValueType>
 class RWQueue {
  public:
-  RWQueue();
+  explicit RWQueue(RWQueueOptions options = {});
   ~RWQueue();
 
   /**
@@ -83,6 +151,13 @@ class RWQueue {
   template <typename ValueTypeT>
   bool push(ValueTypeT&& val);
 
+  /**
+   * Same as above, but reports reason of failure i.e. QUEUE_CLOSED or
+   * QUEUE_FULL. Value is left untouched on failure.
+   */
+  template <typename ValueTypeT>
+  folly::Expected<folly::Unit, QueueError> tryPush(ValueTypeT&& val);
+
   /**
    * Blocking read for native threads/fibers. In-case of fibers, the fiber
    * performing blocking read will be suspended.
@@ -96,6 +171,21 @@ class RWQueue {
   folly::coro::Task<folly::Expected<ValueType, QueueError>> getCoro();
 #endif
 
+  /**
+   * Blocking batch read. Waits for at least one element and returns it along
+   * with all other queued elements, upto `maxItems` in total.
+   */
+  folly::Expected<std::vector<ValueType>, QueueError> getBatch(
+      size_t maxItems);
+
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Batch read method for co-routines
+   */
+  folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+  getBatchCoro(size_t maxItems);
+#endif
+
   /**
    * Close the queue. All new push will be ignored and pending data will be lost
    */
@@ -112,28 +202,116 @@ class RWQueue {
    */
   size_t numPendingReads();
 
+  /**
+   * Return true if queue has more elements than its soft limit
+   */
+  bool isOverSoftLimit();
+
+  /**
+   * Return maximum size of the queue seen so far
+   */
+  size_t
+  highWatermark() const {
+    return highWatermark_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Return capacity of the queue. Zero for unbounded queue
+   */
+  size_t
+  capacity() const {
+    return capacity_;
+  }
+
  private:
+  using Clock = std::chrono::steady_clock;
+
+  // Queued data along with the time it got enqueued. Time is recorded only if
+  // counters are exported
+  struct Entry {
+    Entry() = default;
+
+    template <typename ValueTypeT>
+    Entry(ValueTypeT&& val, Clock::time_point time)
+        : value(std::forward<ValueTypeT>(val)), enqueueTime(time) {}
+
+    ValueType value;
+    Clock::time_point enqueueTime;
+  };
+
   struct PendingRead {
     folly::fibers::Baton baton;
     std::optional<ValueType> data;
+    Clock::time_point enqueueTime;
   };
 
   /**
-   * Implementation for push
+   * Implementation for read. Baton of the read is posted as soon as data is
+   * available. Returns false if queue is closed.
    */
   bool getAnyImpl(PendingRead& pendingRead);
 
+  /**
+   * Move already queued elements into the batch, upto `maxItems` in total
+   */
+  void drainImpl(std::vector<ValueType>& batch, size_t maxItems);
+
+  /**
+   * Hand over data from ring buffer to pending reads, in order, till either
+   * runs out. Must be called with lock held.
+   */
+  void handoffImpl();
+
+  /**
+   * Update depth counters on push
+   */
+  void updateCounters(size_t depth);
+
+  /**
+   * Update latency counter on read
+   */
+  void updateLatency(Clock::time_point enqueueTime);
+
+  /**
+   * Update current queue depth counter on read
+   */
+  void updateSizeCounter();
+
+  // Capacity of bounded queue. Zero for unbounded
+  const size_t capacity_{0};
+
+  // Soft limit on queue depth. Zero if disabled
+  const size_t softLimit_{0};
+
+  // Names of the exported counters. Empty if not exported
+  const std::string sizeCounter_;
+  const std::string depthCounter_;
+  const std::string highWatermarkCounter_;
+  const std::string pushFullCounter_;
+  const std::string softLimitCounter_;
+  const std::string latencyCounter_;
+
+  // Max queue depth seen
+  std::atomic<size_t> highWatermark_{0};
+
+  // Lock-free ring buffer for bounded queue. nullptr for unbounded
+  std::unique_ptr<folly::MPMCQueue<Entry>> ring_;
+
+  // Number of pending reads. Lets writer of bounded queue skip the lock when
+  // nobody is waiting
+  std::atomic<size_t> numWaiting_{0};
+
   // Lock to protect below private variables
   std::mutex lock_;
 
-  // State of queue
-  bool closed_{false};
+  // State of queue. Written with lock held, but can be read without it
+  std::atomic<bool> closed_{false};
 
   // Pending reads - readers are actively waiting for data
   std::deque<std::reference_wrapper<PendingRead>> pendingReads_;
 
-  // Pending data
-  std::deque<ValueType> queue_;
+  // Pending data of unbounded queue
+  std::deque<Entry> queue_;
 };
 
 } // namespace messaging
@@ -11,7 +11,8 @@ namespace openr {
 namespace messaging {
 
 template <typename ValueType>
-ReplicateQueue<ValueType>::ReplicateQueue() {}
+ReplicateQueue<ValueType>::ReplicateQueue(RWQueueOptions readerOptions)
+    : readerOptions_(std::move(readerOptions)) {}
 
 template <typename ValueType>
 ReplicateQueue<ValueType>::~ReplicateQueue() {
@@ -22,6 +23,20 @@ template <typename ValueType>
 template <typename ValueTypeT>
 bool
 ReplicateQueue<ValueType>::push(ValueTypeT&& value) {
+  if constexpr (detail::isSharedElement<ValueType, ValueTypeT>()) {
+    // Wrap plain value once, readers will share it
+    using ElementType = typename detail::SharedValue<ValueType>::ElementType;
+    return replicate(ValueType(
+        std::make_shared<const ElementType>(std::forward<ValueTypeT>(value))));
+  } else {
+    return replicate(std::forward<ValueTypeT>(value));
+  }
+}
+
+template <typename ValueType>
+template <typename ValueTypeT>
+bool
+ReplicateQueue<ValueType>::replicate(ValueTypeT&& value) {
   std::vector<std::shared_ptr<RWQueue<ValueType>>> readers;
 
   // Copy reader information - and cleans up stale reader
@@ -59,12 +74,19 @@ ReplicateQueue<ValueType>::push(ValueTypeT&& value) {
  */
 template <typename ValueType>
 RQueue<ValueType>
-ReplicateQueue<ValueType>::getReader() {
+ReplicateQueue<ValueType>::getReader(std::string const& readerId) {
   auto lockedReaders = readers_.wlock();
   if (closed_) {
     throw std::runtime_error("queue is closed");
   }
-  lockedReaders->emplace_back(std::make_shared<RWQueue<ValueType>>());
+  auto options = readerOptions_;
+  if (not options.counterPrefix.empty()) {
+    options.counterPrefix += "." +
+        (readerId.empty() ? std::to_string(numReadersCreated_) : readerId);
+  }
+  ++numReadersCreated_;
+  lockedReaders->emplace_back(
+      std::make_shared<RWQueue<ValueType>>(std::move(options)));
   return RQueue<ValueType>(lockedReaders->back());
 }
 
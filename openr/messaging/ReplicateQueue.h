@@ -7,22 +7,62 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <type_traits>
+
 #include <openr/messaging/Queue.h>
 
 namespace openr {
 namespace messaging {
 
+namespace detail {
+
+// Trait to detect shared immutable value type i.e. std::shared_ptr<const T>
+template <typename ValueType>
+struct SharedValue : std::false_type {};
+
+template <typename T>
+struct SharedValue<std::shared_ptr<const T>> : std::true_type {
+  using ElementType = T;
+};
+
+// Check if plain value of type `ValueTypeT` is pushed to the queue of shared
+// immutable values
+template <typename ValueType, typename ValueTypeT>
+constexpr bool
+isSharedElement() {
+  if constexpr (SharedValue<ValueType>::value) {
+    return std::is_same_v<
+        std::decay_t<ValueTypeT>,
+        typename SharedValue<ValueType>::ElementType>;
+  } else {
+    return false;
+  }
+}
+
+} // namespace detail
+
 /**
  * Multiple writers and readers. Each reader gets every written element push by
  * every writer. Writer pays the cost of replicating data to all readers. If no
  * reader exists then all the messages are silently dropped.
  *
  * Pushed object must be copy constructible.
+ *
+ * For large values use `ReplicateQueue<std::shared_ptr<const T>>`. Readers
+ * then share single immutable copy of the value instead of getting a copy
+ * each. `push(T)` is supported on such queue and allocates the shared value
+ * exactly once irrespective of number of readers.
  */
 template <typename ValueType>
 class ReplicateQueue {
  public:
-  ReplicateQueue();
+  /**
+   * Options are applied to the queue of every reader. Counters of the reader
+   * are exported with prefix `<counterPrefix>.<readerId>`.
+   */
+  explicit ReplicateQueue(RWQueueOptions readerOptions = {});
 
   ~ReplicateQueue();
 
@@ -40,16 +80,21 @@ class ReplicateQueue {
 
   /**
    * Push any value into the queue. Will get replicated to all the readers.
-   * This also cleans up any lingering queue which has no active reader
+   * This also cleans up any lingering queue which has no active reader.
+   * Reader with full bounded queue misses the value.
+   *
+   * If queue is of shared immutable values, then plain value is accepted as
+   * well and wrapped into shared pointer before replication.
    */
   template <typename ValueTypeT>
   bool push(ValueTypeT&& value);
 
   /**
    * Get new reader stream of this queue. Stream will get closed automatically
-   * when reader is destructed.
+   * when reader is destructed. `readerId` identifies the reader in exported
+   * counters, and defaults to the index of the reader.
    */
-  RQueue<ValueType> getReader();
+  RQueue<ValueType> getReader(std::string const& readerId = "");
 
   /**
    * Number of replicated streams/readers
@@ -70,8 +115,18 @@ class ReplicateQueue {
   void close();
 
  private:
+  /**
+   * Replicate value to all the readers
+   */
+  template <typename ValueTypeT>
+  bool replicate(ValueTypeT&& value);
+
+  // Options for reader queues
+  RWQueueOptions readerOptions_;
+
   folly::Synchronized<std::list<std::shared_ptr<RWQueue<ValueType>>>> readers_;
   bool closed_{false}; // Protected by above Synchronized lock
+  size_t numReadersCreated_{0}; // Protected by above Synchronized lock
 };
 
 } // namespace messaging
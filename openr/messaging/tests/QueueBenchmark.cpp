@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <openr/messaging/Queue.h>
+
+namespace {
+
+// Number of elements pushed by every writer in one iteration
+const size_t kNumElements{10000};
+
+// Capacity of bounded queue
+const size_t kCapacity{1024};
+
+} // namespace
+
+namespace openr {
+namespace messaging {
+
+/**
+ * Benchmark for throughput of the queue with `numWriters` threads pushing
+ * into the queue and one thread reading from it. Writers retry pushes
+ * rejected by full bounded queue.
+ */
+static void
+runQueueBenchmark(uint32_t iters, size_t numWriters, size_t capacity) {
+  auto suspender = folly::BenchmarkSuspender();
+  for (uint32_t i = 0; i < iters; ++i) {
+    RWQueue<size_t> q(RWQueueOptions{capacity, ""});
+
+    suspender.dismiss(); // Start measuring benchmark time
+    std::vector<std::thread> writers;
+    for (size_t j = 0; j < numWriters; ++j) {
+      writers.emplace_back([&q]() {
+        for (size_t k = 0; k < kNumElements; ++k) {
+          while (not q.push(k)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (size_t j = 0; j < numWriters * kNumElements; ++j) {
+      CHECK(q.get().hasValue());
+    }
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+static void
+BM_RWQueueUnbounded(uint32_t iters, size_t numWriters) {
+  runQueueBenchmark(iters, numWriters, 0);
+}
+
+static void
+BM_RWQueueBounded(uint32_t iters, size_t numWriters) {
+  runQueueBenchmark(iters, numWriters, kCapacity);
+}
+
+// The parameter is number of writer threads
+BENCHMARK_PARAM(BM_RWQueueUnbounded, 1);
+BENCHMARK_RELATIVE_PARAM(BM_RWQueueBounded, 1);
+BENCHMARK_PARAM(BM_RWQueueUnbounded, 4);
+BENCHMARK_RELATIVE_PARAM(BM_RWQueueBounded, 4);
+BENCHMARK_PARAM(BM_RWQueueUnbounded, 16);
+BENCHMARK_RELATIVE_PARAM(BM_RWQueueBounded, 16);
+
+} // namespace messaging
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
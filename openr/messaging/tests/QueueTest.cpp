@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <fb303/ServiceData.h>
 #include <gtest/gtest.h>
 
 #include <folly/executors/ManualExecutor.h>
@@ -227,6 +228,117 @@ TEST(RWQueueTest, MultiThreadTest) {
   EXPECT_EQ(kNumWriters * kCountPerWriter, totalReads);
 }
 
+TEST(RWQueueTest, BoundedPushGet) {
+  RWQueue<int> q(RWQueueOptions{2, "test_bounded_queue"});
+  EXPECT_EQ(2, q.capacity());
+
+  // Push to full queue is rejected and value is not consumed
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.tryPush(2).hasValue());
+  EXPECT_FALSE(q.push(3));
+  EXPECT_EQ(QueueError::QUEUE_FULL, q.tryPush(3).error());
+  EXPECT_EQ(2, q.size());
+  EXPECT_EQ(2, q.highWatermark());
+  EXPECT_EQ(
+      2,
+      facebook::fb303::fbData->getCounter(
+          "test_bounded_queue.high_watermark"));
+
+  EXPECT_EQ(1, q.get().value());
+  EXPECT_EQ(2, q.get().value());
+  EXPECT_EQ(0, q.size());
+
+  // Pending reads are served in order
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&q]() mutable { EXPECT_EQ(3, q.get().value()); });
+  manager.addTask([&q]() mutable { EXPECT_EQ(4, q.get().value()); });
+  evb.loopOnce();
+  EXPECT_EQ(2, q.numPendingReads());
+
+  EXPECT_TRUE(q.push(3));
+  EXPECT_TRUE(q.push(4));
+  evb.loopOnce();
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(0, q.numPendingReads());
+  EXPECT_EQ(2, q.highWatermark());
+
+  // Closed queue
+  EXPECT_TRUE(q.push(5));
+  q.close();
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(QueueError::QUEUE_CLOSED, q.tryPush(6).error());
+  EXPECT_EQ(QueueError::QUEUE_CLOSED, q.get().error());
+}
+
+TEST(RWQueueTest, BoundedMultiThreadTest) {
+  const size_t kNumReaders{4};
+  const size_t kNumWriters{4};
+  const size_t kCountPerWriter{8192};
+  RWQueue<size_t> q(RWQueueOptions{64, ""});
+
+  // Readers perform blocking reads
+  std::atomic<size_t> totalReads{0};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumReaders; ++i) {
+    threads.emplace_back([&q, &totalReads]() {
+      while (true) {
+        auto maybeNums = q.getBatch(16);
+        if (maybeNums.hasError()) {
+          EXPECT_EQ(QueueError::QUEUE_CLOSED, maybeNums.error());
+          break;
+        }
+        totalReads += maybeNums.value().size();
+        if (totalReads == kNumWriters * kCountPerWriter) {
+          q.close();
+        }
+      }
+    });
+  }
+
+  // Writers retry on back-pressure
+  for (size_t i = 0; i < kNumWriters; ++i) {
+    threads.emplace_back([&q, i]() {
+      for (size_t j = 0; j < kCountPerWriter; ++j) {
+        while (q.tryPush(i * kCountPerWriter + j).hasError()) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(kNumWriters * kCountPerWriter, totalReads);
+  EXPECT_GE(64, q.highWatermark());
+}
+
+TEST(RWQueueTest, CountersAndSoftLimit) {
+  RWQueue<int> q(RWQueueOptions{0, "test_soft_limit_queue", 2});
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+  EXPECT_FALSE(q.isOverSoftLimit());
+
+  // Push beyond soft limit is accepted
+  EXPECT_TRUE(q.push(3));
+  EXPECT_TRUE(q.isOverSoftLimit());
+  EXPECT_EQ(
+      3, facebook::fb303::fbData->getCounter("test_soft_limit_queue.size"));
+  EXPECT_EQ(
+      3,
+      facebook::fb303::fbData->getCounter(
+          "test_soft_limit_queue.high_watermark"));
+
+  // Reads update current depth
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), q.getBatch(3).value());
+  EXPECT_FALSE(q.isOverSoftLimit());
+  EXPECT_EQ(
+      0, facebook::fb303::fbData->getCounter("test_soft_limit_queue.size"));
+  EXPECT_EQ(3, q.highWatermark());
+}
+
 #if FOLLY_HAS_COROUTINES
 TEST(RWQueueTest, CoroTest) {
   const size_t kNumReaders{16};
@@ -322,3 +434,50 @@ TEST(RQueueTest, ReadTest) {
   EXPECT_EQ(0, rwq->size());
 #endif
 }
+
+TEST(RQueueTest, BatchReadTest) {
+  auto rwq = std::make_shared<RWQueue<int>>();
+  RQueue<int> rq(rwq);
+
+  for (int i = 1; i <= 5; ++i) {
+    rwq->push(i);
+  }
+
+  // Read is limited by maxItems
+  EXPECT_EQ(std::vector<int>({1, 2}), rq.getBatch(2).value());
+  EXPECT_EQ(3, rwq->size());
+
+  // Read all of the rest
+  EXPECT_EQ(std::vector<int>({3, 4, 5}), rq.getBatch().value());
+  EXPECT_EQ(0, rwq->size());
+
+  // Consecutive elements are coalesced by merge functor. Merge only the ones
+  // with same parity
+  for (int i : {1, 3, 2, 4, 6, 5}) {
+    rwq->push(i);
+  }
+  auto mergeFn = [](int& into, int& from) {
+    if (into % 2 != from % 2) {
+      return false;
+    }
+    into += from;
+    return true;
+  };
+  EXPECT_EQ(std::vector<int>({4, 12, 5}), rq.getBatch(10, mergeFn).value());
+
+  // Blocking read is unblocked by push. Rest of the data is taken as well
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&rq]() mutable {
+    EXPECT_EQ(std::vector<int>({7}), rq.getBatch().value());
+  });
+  evb.loopOnce();
+  EXPECT_EQ(1, rwq->numPendingReads());
+  rwq->push(7);
+  evb.loopOnce();
+  EXPECT_EQ(0, rwq->numPendingReads());
+
+  // Closed queue
+  rwq->close();
+  EXPECT_TRUE(rq.getBatch().hasError());
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <openr/messaging/ReplicateQueue.h>
+
+namespace {
+
+// Number of entries and their size in the pushed value. Resembles large
+// publication of key-values.
+const size_t kNumEntries{10000};
+const size_t kSizeOfEntry{128};
+
+using LargeValue = std::vector<std::string>;
+
+LargeValue
+createLargeValue() {
+  return LargeValue(kNumEntries, std::string(kSizeOfEntry, 'x'));
+}
+
+} // namespace
+
+namespace openr {
+namespace messaging {
+
+/**
+ * Benchmark for push of large value to many readers where each reader gets
+ * its own copy of the value
+ */
+static void
+BM_ReplicateQueuePushCopy(uint32_t iters, size_t numReaders) {
+  auto suspender = folly::BenchmarkSuspender();
+  ReplicateQueue<LargeValue> q;
+  std::vector<RQueue<LargeValue>> readers;
+  for (size_t i = 0; i < numReaders; ++i) {
+    readers.emplace_back(q.getReader());
+  }
+  const auto value = createLargeValue();
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss(); // Start measuring benchmark time
+    q.push(value);
+    suspender.rehire(); // Stop measuring time again
+    for (auto& reader : readers) {
+      CHECK_EQ(kNumEntries, reader.get().value().size());
+    }
+  }
+}
+
+/**
+ * Benchmark for push of large value to many readers where readers share the
+ * single immutable copy of the value
+ */
+static void
+BM_ReplicateQueuePushShared(uint32_t iters, size_t numReaders) {
+  auto suspender = folly::BenchmarkSuspender();
+  ReplicateQueue<std::shared_ptr<const LargeValue>> q;
+  std::vector<RQueue<std::shared_ptr<const LargeValue>>> readers;
+  for (size_t i = 0; i < numReaders; ++i) {
+    readers.emplace_back(q.getReader());
+  }
+  const auto value = createLargeValue();
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss(); // Start measuring benchmark time
+    q.push(value);
+    suspender.rehire(); // Stop measuring time again
+    for (auto& reader : readers) {
+      CHECK_EQ(kNumEntries, reader.get().value()->size());
+    }
+  }
+}
+
+// The parameter is number of readers of the queue
+BENCHMARK_PARAM(BM_ReplicateQueuePushCopy, 1);
+BENCHMARK_RELATIVE_PARAM(BM_ReplicateQueuePushShared, 1);
+BENCHMARK_PARAM(BM_ReplicateQueuePushCopy, 4);
+BENCHMARK_RELATIVE_PARAM(BM_ReplicateQueuePushShared, 4);
+BENCHMARK_PARAM(BM_ReplicateQueuePushCopy, 16);
+BENCHMARK_RELATIVE_PARAM(BM_ReplicateQueuePushShared, 16);
+
+} // namespace messaging
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <fb303/ServiceData.h>
 #include <gtest/gtest.h>
 
 #include <folly/fibers/EventBaseLoopController.h>
@@ -84,3 +85,68 @@ TEST(ReplicateQueueTest, OpenQueueTest) {
 
   q.close();
 }
+
+TEST(ReplicateQueueTest, SharedValueTest) {
+  const size_t kNumReaders{4};
+
+  ReplicateQueue<std::shared_ptr<const std::string>> q;
+  std::vector<RQueue<std::shared_ptr<const std::string>>> readers;
+  for (size_t i = 0; i < kNumReaders; ++i) {
+    readers.emplace_back(q.getReader());
+  }
+
+  // Plain value is wrapped once and shared by all readers
+  const std::string value(1024, 'x');
+  EXPECT_TRUE(q.push(value));
+  EXPECT_TRUE(q.push(std::string("moved")));
+
+  // Shared value is pushed as is
+  auto sharedValue = std::make_shared<const std::string>("shared");
+  EXPECT_TRUE(q.push(sharedValue));
+
+  std::shared_ptr<const std::string> firstValue{nullptr};
+  for (auto& reader : readers) {
+    EXPECT_EQ(3, reader.size());
+
+    auto maybeValue = reader.get();
+    ASSERT_TRUE(maybeValue.hasValue());
+    EXPECT_EQ(value, *maybeValue.value());
+    if (not firstValue) {
+      firstValue = maybeValue.value();
+    }
+    EXPECT_EQ(firstValue.get(), maybeValue.value().get()); // no copies
+
+    maybeValue = reader.get();
+    ASSERT_TRUE(maybeValue.hasValue());
+    EXPECT_EQ("moved", *maybeValue.value());
+
+    maybeValue = reader.get();
+    ASSERT_TRUE(maybeValue.hasValue());
+    EXPECT_EQ(sharedValue.get(), maybeValue.value().get());
+  }
+
+  q.close();
+}
+
+TEST(ReplicateQueueTest, ReaderCountersTest) {
+  ReplicateQueue<int> q(RWQueueOptions{0, "test_replicate_queue"});
+  auto namedReader = q.getReader("named");
+  auto reader = q.getReader();
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+
+  // Counters are exported per reader
+  auto getSize = [](std::string const& readerId) {
+    return facebook::fb303::fbData->getCounter(
+        "test_replicate_queue." + readerId + ".size");
+  };
+  EXPECT_EQ(2, getSize("named"));
+  EXPECT_EQ(2, getSize("1"));
+
+  EXPECT_EQ(1, namedReader.get().value());
+  EXPECT_EQ(1, getSize("named"));
+  EXPECT_EQ(2, getSize("1"));
+
+  q.close();
+}
@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/nl/NetlinkLinkCache.h>
+
+#include <fb303/ServiceData.h>
+#include <glog/logging.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr::fbnl {
+
+NetlinkLinkCache::NetlinkLinkCache(NetlinkProtocolSocket* nlSock)
+    : nlSock_(nlSock) {
+  CHECK_NOTNULL(nlSock);
+  nlSock_->addLinkEventSubscriber(
+      [this](const Link& link) { updateLink(link); });
+}
+
+template <typename T>
+std::optional<T>
+NetlinkLinkCache::lookup(
+    std::function<std::optional<T>(const Snapshot&)> lookupFn) {
+  auto result = lookupFn(*getSnapshot());
+  if (result.has_value()) {
+    fb303::fbData->addStatValue("platform.link_cache.hits", 1, fb303::SUM);
+    return result;
+  }
+
+  // Update cache and lookup again
+  fb303::fbData->addStatValue("platform.link_cache.misses", 1, fb303::SUM);
+  refresh();
+  return lookupFn(*getSnapshot());
+}
+
+std::optional<int>
+NetlinkLinkCache::getIfIndex(const std::string& ifName) {
+  return lookup<int>([&ifName](const Snapshot& snapshot) -> std::optional<int> {
+    auto it = snapshot.ifNameToIndex.find(ifName);
+    if (it != snapshot.ifNameToIndex.end()) {
+      return it->second;
+    }
+    return std::nullopt;
+  });
+}
+
+std::optional<std::string>
+NetlinkLinkCache::getIfName(int ifIndex) {
+  return lookup<std::string>(
+      [ifIndex](const Snapshot& snapshot) -> std::optional<std::string> {
+        auto it = snapshot.ifIndexToName.find(ifIndex);
+        if (it != snapshot.ifIndexToName.end()) {
+          return it->second;
+        }
+        return std::nullopt;
+      });
+}
+
+std::optional<int>
+NetlinkLinkCache::getLoopbackIfIndex() {
+  return lookup<int>([](const Snapshot& snapshot) -> std::optional<int> {
+    if (snapshot.loopbackIfIndex < 0) {
+      return std::nullopt;
+    }
+    return snapshot.loopbackIfIndex;
+  });
+}
+
+std::optional<int>
+NetlinkLinkCache::findIfIndex(const std::string& ifName) const {
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifNameToIndex.find(ifName);
+  if (it == snapshot->ifNameToIndex.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::optional<std::string>
+NetlinkLinkCache::findIfName(int ifIndex) const {
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifIndexToName.find(ifIndex);
+  if (it == snapshot->ifIndexToName.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void
+NetlinkLinkCache::refresh() noexcept {
+  auto links = nlSock_->getAllLinks().get();
+  if (links.hasError()) {
+    LOG(ERROR) << "Failed fetching links. Error: " << links.error();
+    return;
+  }
+
+  // NOTE: We don't clear cache instead override entries
+  update([&links](Snapshot& snapshot) {
+    for (auto const& link : links.value()) {
+      // Update name <-> index mappings
+      snapshot.ifNameToIndex[link.getLinkName()] = link.getIfIndex();
+      snapshot.ifIndexToName[link.getIfIndex()] = link.getLinkName();
+
+      // Update loopbackIfIndex
+      if (link.isLoopback()) {
+        snapshot.loopbackIfIndex = link.getIfIndex();
+      }
+    }
+  });
+}
+
+void
+NetlinkLinkCache::updateLink(const Link& link) {
+  update([&link](Snapshot& snapshot) {
+    const auto ifIndex = link.getIfIndex();
+    const auto& ifName = link.getLinkName();
+
+    // Remove stale mapping of renamed interface or of re-used name
+    auto nameIt = snapshot.ifIndexToName.find(ifIndex);
+    if (nameIt != snapshot.ifIndexToName.end() and nameIt->second != ifName) {
+      snapshot.ifNameToIndex.erase(nameIt->second);
+    }
+    auto indexIt = snapshot.ifNameToIndex.find(ifName);
+    if (indexIt != snapshot.ifNameToIndex.end() and
+        indexIt->second != ifIndex) {
+      snapshot.ifIndexToName.erase(indexIt->second);
+    }
+
+    snapshot.ifNameToIndex[ifName] = ifIndex;
+    snapshot.ifIndexToName[ifIndex] = ifName;
+    if (link.isLoopback()) {
+      snapshot.loopbackIfIndex = ifIndex;
+    }
+  });
+  fb303::fbData->addStatValue("platform.link_cache.updates", 1, fb303::SUM);
+}
+
+void
+NetlinkLinkCache::update(std::function<void(Snapshot&)> update) {
+  std::lock_guard<std::mutex> g(updateMutex_);
+  auto snapshot = std::make_shared<Snapshot>(*std::atomic_load(&snapshot_));
+  update(*snapshot);
+  std::atomic_store(
+      &snapshot_, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+} // namespace openr::fbnl
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <openr/nl/NetlinkProtocolSocket.h>
+#include <openr/nl/NetlinkTypes.h>
+
+namespace openr::fbnl {
+
+/**
+ * Cache of interface index <-> name mapping, kept up to date with link events
+ * of NetlinkProtocolSocket. A single cache is meant to be shared by all users
+ * of the socket in a process (NetlinkFibHandler, NetlinkSystemHandler and
+ * PlatformPublisher) instead of each keeping its own copy.
+ *
+ * Readers load current immutable snapshot atomically without acquiring any
+ * lock, and updates publish a modified copy. Entries are initialized by
+ * querying `getAllLinks` on first cache miss (or with `refresh`).
+ *
+ * Cache must outlive event delivery of the socket, as it is subscribed to its
+ * link events for its lifetime.
+ *
+ * Counters
+ *   platform.link_cache.hits : Lookups served from cache
+ *   platform.link_cache.misses : Lookups querying links from kernel
+ *   platform.link_cache.updates : Link events applied to cache
+ */
+class NetlinkLinkCache final {
+ public:
+  explicit NetlinkLinkCache(NetlinkProtocolSocket* nlSock);
+
+  NetlinkLinkCache(const NetlinkLinkCache&) = delete;
+  NetlinkLinkCache& operator=(const NetlinkLinkCache&) = delete;
+
+  /**
+   * Lookup mapping in cache, querying all links from kernel on miss. Returns
+   * `std::nullopt` if mapping is not found.
+   *
+   * NOTE: Must not be invoked in event thread of the socket, as it waits for
+   * the query to complete. Use `find*` APIs there instead.
+   */
+  std::optional<int> getIfIndex(const std::string& ifName);
+  std::optional<std::string> getIfName(int ifIndex);
+  std::optional<int> getLoopbackIfIndex();
+
+  /**
+   * Lookup mapping in cache only
+   */
+  std::optional<int> findIfIndex(const std::string& ifName) const;
+  std::optional<std::string> findIfName(int ifIndex) const;
+
+  /**
+   * Query all links from kernel and update cache with them. Same threading
+   * restriction as for `get*` APIs applies.
+   */
+  void refresh() noexcept;
+
+ private:
+  /**
+   * Immutable snapshot of interface index <-> name mapping
+   */
+  struct Snapshot {
+    std::unordered_map<std::string, int> ifNameToIndex;
+    std::unordered_map<int, std::string> ifIndexToName;
+    // Loopback interface index. Initialized to negative number
+    int loopbackIfIndex{-1};
+  };
+
+  std::shared_ptr<const Snapshot>
+  getSnapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
+  // Update cache with the link on link event
+  void updateLink(const Link& link);
+
+  // Apply update on copy of current snapshot and publish it
+  void update(std::function<void(Snapshot&)> update);
+
+  // Lookup in cache, and on miss in refreshed cache
+  template <typename T>
+  std::optional<T> lookup(
+      std::function<std::optional<T>(const Snapshot&)> lookupFn);
+
+  NetlinkProtocolSocket* nlSock_{nullptr};
+
+  // Current snapshot. Must only be accessed with
+  // std::atomic_load/std::atomic_store
+  std::shared_ptr<const Snapshot> snapshot_{
+      std::make_shared<const Snapshot>()};
+
+  // Serializes updates of snapshot
+  std::mutex updateMutex_;
+};
+
+} // namespace openr::fbnl
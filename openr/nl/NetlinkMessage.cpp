@@ -7,13 +7,113 @@
 
 #include <openr/nl/NetlinkMessage.h>
 
+#include <cstring>
+
+#include <fb303/ServiceData.h>
+
+using facebook::fb303::fbData;
+namespace fb303 = facebook::fb303;
+
 namespace openr::fbnl {
 
+constexpr uint32_t NetlinkMessagePool::kMinBufferSize;
+constexpr size_t NetlinkMessagePool::kMaxCachedBuffers;
+
+NetlinkMessagePool&
+NetlinkMessagePool::getInstance() {
+  // NOTE: Intentionally leaked to stay valid for messages destroyed during
+  // static destruction
+  static auto* pool = new NetlinkMessagePool();
+  return *pool;
+}
+
+uint32_t
+NetlinkMessagePool::getBufferCapacity(uint32_t size) {
+  CHECK_LE(size, kMaxNlMessageSize);
+  uint32_t capacity = kMinBufferSize;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+size_t
+NetlinkMessagePool::getSizeClass(uint32_t capacity) {
+  CHECK_EQ(capacity, getBufferCapacity(capacity))
+      << "Invalid buffer capacity " << capacity;
+  size_t sizeClass = 0;
+  while ((kMinBufferSize << sizeClass) < capacity) {
+    ++sizeClass;
+  }
+  return sizeClass;
+}
+
+NetlinkMessagePool::Buffer
+NetlinkMessagePool::allocate(uint32_t capacity) {
+  const auto sizeClass = getSizeClass(capacity);
+  Buffer buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& freeBuffers = freeBuffers_.at(sizeClass);
+    if (not freeBuffers.empty()) {
+      buffer = std::move(freeBuffers.back());
+      freeBuffers.pop_back();
+      cachedBytes_ -= capacity;
+    }
+    inUseBytes_ += capacity;
+  }
+
+  if (buffer) {
+    fbData->addStatValue("netlink.msg_pool_reuses", 1, fb303::SUM);
+    std::memset(buffer.get(), 0, capacity);
+  } else {
+    fbData->addStatValue("netlink.msg_pool_allocs", 1, fb303::SUM);
+    buffer = std::make_unique<char[]>(capacity);
+  }
+  return buffer;
+}
+
+void
+NetlinkMessagePool::release(Buffer buffer, uint32_t capacity) {
+  const auto sizeClass = getSizeClass(capacity);
+  size_t inUseBytes{0};
+  size_t cachedBytes{0};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& freeBuffers = freeBuffers_.at(sizeClass);
+    if (freeBuffers.size() < kMaxCachedBuffers) {
+      freeBuffers.emplace_back(std::move(buffer));
+      cachedBytes_ += capacity;
+    }
+    inUseBytes_ -= capacity;
+    inUseBytes = inUseBytes_;
+    cachedBytes = cachedBytes_;
+  }
+  // NOTE: buffer (if not cached) gets freed outside of the lock
+
+  fbData->addStatValue(
+      "netlink.msg_pool_in_use_bytes", inUseBytes, fb303::AVG);
+  fbData->addStatValue(
+      "netlink.msg_pool_cached_bytes", cachedBytes, fb303::AVG);
+}
+
+size_t
+NetlinkMessagePool::getInUseBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return inUseBytes_;
+}
+
+size_t
+NetlinkMessagePool::getCachedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cachedBytes_;
+}
+
 NetlinkMessage::NetlinkMessage()
-    : msghdr(reinterpret_cast<struct nlmsghdr*>(msg.data())) {}
+    : buffer_(NetlinkMessagePool::getInstance().allocate(kMaxNlPayloadSize)),
+      msghdr(reinterpret_cast<struct nlmsghdr*>(buffer_.get())) {}
 
-NetlinkMessage::NetlinkMessage(int type)
-    : msghdr(reinterpret_cast<struct nlmsghdr*>(msg.data())) {
+NetlinkMessage::NetlinkMessage(int type) : NetlinkMessage() {
   // initialize netlink header
   msghdr->nlmsg_len = NLMSG_LENGTH(0);
   msghdr->nlmsg_type = type;
@@ -21,6 +121,7 @@ NetlinkMessage::NetlinkMessage(int type)
 
 NetlinkMessage::~NetlinkMessage() {
   CHECK(promise_.isFulfilled());
+  NetlinkMessagePool::getInstance().release(std::move(buffer_), capacity_);
 }
 
 struct nlmsghdr*
@@ -28,6 +129,48 @@ NetlinkMessage::getMessagePtr() {
   return msghdr;
 }
 
+const struct nlmsghdr*
+NetlinkMessage::getMessagePtr() const {
+  return msghdr;
+}
+
+void
+NetlinkMessage::compact() {
+  auto& pool = NetlinkMessagePool::getInstance();
+  const auto capacity = pool.getBufferCapacity(msghdr->nlmsg_len);
+  if (capacity >= capacity_) {
+    return;
+  }
+
+  auto buffer = pool.allocate(capacity);
+  std::memcpy(buffer.get(), buffer_.get(), msghdr->nlmsg_len);
+  pool.release(std::move(buffer_), capacity_);
+  buffer_ = std::move(buffer);
+  capacity_ = capacity;
+  msghdr = reinterpret_cast<struct nlmsghdr*>(buffer_.get());
+}
+
+int
+NetlinkMessage::reserve(uint32_t size) {
+  if (size <= capacity_) {
+    return 0;
+  }
+  if (size > kMaxNlMessageSize) {
+    LOG(ERROR) << "Message of " << size << " bytes exceeds maximum size";
+    return ENOBUFS;
+  }
+
+  auto& pool = NetlinkMessagePool::getInstance();
+  const auto capacity = pool.getBufferCapacity(size);
+  auto buffer = pool.allocate(capacity);
+  std::memcpy(buffer.get(), buffer_.get(), msghdr->nlmsg_len);
+  pool.release(std::move(buffer_), capacity_);
+  buffer_ = std::move(buffer);
+  capacity_ = capacity;
+  msghdr = reinterpret_cast<struct nlmsghdr*>(buffer_.get());
+  return 0;
+}
+
 uint16_t
 NetlinkMessage::getMessageType() const {
   return msghdr->nlmsg_type;
@@ -43,7 +186,7 @@ NetlinkMessage::addSubAttributes(
     struct rtattr* rta, int type, const void* data, uint32_t len) const {
   uint32_t subRtaLen = RTA_LENGTH(len);
 
-  if (RTA_ALIGN(rta->rta_len) + RTA_ALIGN(subRtaLen) > kMaxNlPayloadSize) {
+  if (RTA_ALIGN(rta->rta_len) + RTA_ALIGN(subRtaLen) > kMaxNlMessageSize) {
     LOG(ERROR) << "No buffer for adding attr: " << type << " length: " << len;
     return nullptr;
   }
@@ -73,7 +216,7 @@ NetlinkMessage::addAttributes(
   uint32_t rtaLen = (RTA_LENGTH(len));
   uint32_t nlmsgAlen = NLMSG_ALIGN((msghdr)->nlmsg_len);
 
-  if (nlmsgAlen + RTA_ALIGN(rtaLen) > kMaxNlPayloadSize) {
+  if (nlmsgAlen + RTA_ALIGN(rtaLen) > capacity_) {
     LOG(ERROR) << "Space not available to add attribute type " << type;
     return ENOBUFS;
   }
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 #include <limits.h>
 #include <linux/lwtunnel.h>
@@ -25,6 +28,67 @@ namespace openr::fbnl {
 
 constexpr uint16_t kMaxNlPayloadSize{4096};
 
+// Maximum size a message can grow to, e.g. route with wide ECMP. Same as the
+// largest datagram we receive, so that such routes can be dumped back too
+constexpr uint32_t kMaxNlMessageSize{32 * 1024};
+
+/**
+ * Process wide pool of netlink message buffers. Buffers are handed out in
+ * power of two size classes, from `kMinBufferSize` upto `kMaxNlMessageSize`,
+ * and released buffers are cached per size class (upto `kMaxCachedBuffers`)
+ * for re-use by subsequent messages instead of going back to the allocator.
+ *
+ * Messages are built in a buffer of maximum size, and then compacted into the
+ * smallest buffer fitting them before getting queued for transmission. This
+ * bounds memory of queued requests by their actual size, which is usually a
+ * few hundred bytes for a route.
+ *
+ * Pool is thread safe as messages are built and released on different
+ * threads.
+ */
+class NetlinkMessagePool {
+ public:
+  using Buffer = std::unique_ptr<char[]>;
+
+  static constexpr uint32_t kMinBufferSize{256};
+  static constexpr size_t kMaxCachedBuffers{1024};
+
+  static NetlinkMessagePool& getInstance();
+
+  // Capacity of the buffer handed out for the requested size
+  static uint32_t getBufferCapacity(uint32_t size);
+
+  // Get zeroed buffer of `capacity` which must be one of the size classes
+  Buffer allocate(uint32_t capacity);
+
+  // Return buffer of `capacity` to pool
+  void release(Buffer buffer, uint32_t capacity);
+
+  // Bytes of buffers handed out and not yet released
+  size_t getInUseBytes() const;
+
+  // Bytes of buffers cached for re-use
+  size_t getCachedBytes() const;
+
+ private:
+  NetlinkMessagePool() = default;
+
+  static size_t getSizeClass(uint32_t capacity);
+
+  static constexpr size_t kNumSizeClasses{8};
+  static_assert(
+      kMinBufferSize << (kNumSizeClasses - 1) == kMaxNlMessageSize,
+      "Largest size class must fit maximum message");
+
+  mutable std::mutex mutex_;
+
+  // size-class -> cached buffers
+  std::array<std::vector<Buffer>, kNumSizeClasses> freeBuffers_;
+
+  size_t inUseBytes_{0};
+  size_t cachedBytes_{0};
+};
+
 /**
  * Data structure representing a netlink message, either to be sent or received.
  * It wraps `struct nlmsghdr` and provides buffer for appending message payload.
@@ -34,7 +98,10 @@ constexpr uint16_t kMaxNlPayloadSize{4096};
  * Aim of the message is to faciliate serialization and deserialization of
  * C++ object (application) to/from bytes (kernel).
  *
- * Maximum size of message is limited by `kMaxNlPayloadSize` parameter.
+ * Message is built in a buffer of `kMaxNlPayloadSize`, which sub-classes can
+ * grow upto `kMaxNlMessageSize` with `reserve()` for large payloads. Buffer
+ * of the message is drawn from `NetlinkMessagePool` and returned to it on
+ * destruction of the message (i.e. after receipt of the ack).
  */
 class NetlinkMessage {
  public:
@@ -47,6 +114,7 @@ class NetlinkMessage {
 
   // get pointer to NLMSG Header
   struct nlmsghdr* getMessagePtr();
+  const struct nlmsghdr* getMessagePtr() const;
 
   // get underlying nlmsg_type
   uint16_t getMessageType() const;
@@ -54,8 +122,19 @@ class NetlinkMessage {
   // get current length
   uint32_t getDataLength() const;
 
-  // Buffer to create message
-  std::array<char, kMaxNlPayloadSize> msg = {};
+  // get capacity of the underlying buffer
+  uint32_t
+  getBufferCapacity() const {
+    return capacity_;
+  }
+
+  /**
+   * Move message into the smallest pooled buffer that fits it, releasing the
+   * maximum size buffer it was built in. Must be invoked only once message is
+   * fully built, as pointers into the old buffer (e.g. header pointers kept by
+   * sub-classes) are invalidated. `getMessagePtr()` remains valid.
+   */
+  void compact();
 
   /**
    * APIs for accumulating objects of `GET_<>` request. These APIs are invoked
@@ -108,7 +187,24 @@ class NetlinkMessage {
     return createTs_;
   }
 
+  // Timestamp when message was (last) sent to kernel
+  std::chrono::steady_clock::time_point
+  getSendTs() const {
+    return sendTs_;
+  }
+
+  void
+  setSendTs(std::chrono::steady_clock::time_point sendTs) {
+    sendTs_ = sendTs;
+  }
+
  protected:
+  // Grow buffer of the message to fit `size` bytes, upto kMaxNlMessageSize.
+  // As with `compact()`, pointers into the old buffer are invalidated and
+  // must be retrieved again from `getMessagePtr()`
+  // @returns 0 on success else ENOBUFS
+  int reserve(uint32_t size);
+
   // Add TLV attributes, specify the length and size of data returns ENOBUFS
   // if enough buffer is not available. Also updates the length field in
   // NLMSG header.
@@ -129,8 +225,12 @@ class NetlinkMessage {
   NetlinkMessage(NetlinkMessage const&) = delete;
   NetlinkMessage& operator=(NetlinkMessage const&) = delete;
 
+  // Buffer to create message, drawn from NetlinkMessagePool
+  NetlinkMessagePool::Buffer buffer_;
+  uint32_t capacity_{kMaxNlPayloadSize};
+
   // pointer to the netlink message header
-  struct nlmsghdr* const msghdr{nullptr};
+  struct nlmsghdr* msghdr{nullptr};
 
   // Promise to relay the status code received from kernel
   folly::Promise<int> promise_;
@@ -138,6 +238,9 @@ class NetlinkMessage {
   // Timestamp when message object was created
   const std::chrono::steady_clock::time_point createTs_{
       std::chrono::steady_clock::now()};
+
+  // Timestamp when message was sent to kernel
+  std::chrono::steady_clock::time_point sendTs_;
 };
 
 } // namespace openr::fbnl
@@ -8,15 +8,36 @@
 #include <thread>
 
 #include <fb303/ServiceData.h>
+#include <folly/Format.h>
 
 #include <openr/common/Util.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 
+// Available since Linux 4.20, not defined by older headers
+#ifndef SOL_NETLINK
+#define SOL_NETLINK 270
+#endif
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK 12
+#endif
+
 using facebook::fb303::fbData;
 namespace fb303 = facebook::fb303;
 
 namespace openr::fbnl {
 
+namespace {
+
+// latency of requests from send to ack (kernel time), from enqueue to send
+// (queueing time) and from enqueue to ack
+const std::string kAckLatencyCounter{"netlink.ack_latency_us"};
+const std::string kQueueLatencyCounter{"netlink.queue_latency_us"};
+const std::string kRequestLatencyCounter{"netlink.request_latency_us"};
+const int64_t kAckLatencyBucketWidthUs{500};
+const int64_t kAckLatencyMaxUs{500000};
+
+} // namespace
+
 NetlinkProtocolSocket::NetlinkProtocolSocket(
     folly::EventBase* evb, bool enableIPv6RouteReplaceSemantics)
     : EventHandler(evb),
@@ -24,6 +45,15 @@ NetlinkProtocolSocket::NetlinkProtocolSocket(
       enableIPv6RouteReplaceSemantics_(enableIPv6RouteReplaceSemantics) {
   CHECK_NOTNULL(evb_);
 
+  fbData->addStatExportType("netlink.inflight", fb303::AVG);
+  fbData->addStatExportType("netlink.send_window", fb303::AVG);
+  for (auto const& counter :
+       {kAckLatencyCounter, kQueueLatencyCounter, kRequestLatencyCounter}) {
+    fbData->addHistogram(
+        counter, kAckLatencyBucketWidthUs, 0, kAckLatencyMaxUs);
+    fbData->exportHistogramPercentile(counter, 50, 95, 99);
+  }
+
   nlMessageTimer_ = folly::AsyncTimeout::make(*evb_, [this]() noexcept {
     DCHECK(false) << "This shouldn't occur usually. Adding DCHECK to get "
                   << "attention in UTs";
@@ -56,7 +86,7 @@ NetlinkProtocolSocket::NetlinkProtocolSocket(
   // Create consumer for procesing netlink messages to be sent in an event loop
   notifConsumer_ = folly::NotificationQueue<std::unique_ptr<NetlinkMessage>>::
       Consumer::make([this](std::unique_ptr<NetlinkMessage> && nlmsg) noexcept {
-        msgQueue_.push(std::move(nlmsg));
+        msgQueue_.push_back(std::move(nlmsg));
         // Invoke send messages API if socket is initialized and no in flight
         // messages
         if (nlSock_ >= 0 && !nlMessageTimer_->isScheduled()) {
@@ -64,6 +94,10 @@ NetlinkProtocolSocket::NetlinkProtocolSocket(
         }
       });
 
+  // Retry sending messages rejected by kernel for lack of buffers
+  nlSendRetryTimer_ = folly::AsyncTimeout::make(
+      *evb_, [this]() noexcept { sendNetlinkMessage(); });
+
   // Initialize the socket in an event loop
   nlInitTimer_ = folly::AsyncTimeout::schedule(
       std::chrono::milliseconds(0), *evb_, [this]() noexcept {
@@ -110,6 +144,24 @@ NetlinkProtocolSocket::init() {
     LOG(FATAL) << "Netlink socket set recv buffer failed.";
   };
 
+  // Have kernel validate get requests strictly and apply the filters of dump
+  // requests, e.g. protocol and table of routes, rather than dumping every
+  // route to be filtered on receipt. Routes are still filtered on receipt,
+  // for kernels not supporting it
+  int strictCheck = 1;
+  if (setsockopt(
+          nlSock_,
+          SOL_NETLINK,
+          NETLINK_GET_STRICT_CHK,
+          &strictCheck,
+          sizeof(strictCheck)) < 0) {
+    LOG(WARNING) << "Netlink socket strict checking is not supported, route "
+                 << "dumps are filtered in user space: "
+                 << folly::errnoStr(errno);
+    strictCheck = 0;
+  }
+  fbData->setCounter("netlink.strict_check", strictCheck);
+
   // Bind on the source address. We let kernel chose the available port-ID
   struct sockaddr_nl saddr;
   ::memset(&saddr, 0, sizeof(saddr));
@@ -160,6 +212,26 @@ NetlinkProtocolSocket::setLinkEventCB(
   linkEventCB_ = linkEventCB;
 }
 
+void
+NetlinkProtocolSocket::addLinkEventSubscriber(
+    std::function<void(const fbnl::Link&)> linkEventSubscriber) {
+  CHECK(linkEventSubscriber);
+  linkEventSubscribers_.wlock()->emplace_back(std::move(linkEventSubscriber));
+}
+
+void
+NetlinkProtocolSocket::notifyLinkEvent(fbnl::Link link, bool runHandler) {
+  {
+    auto subscribers = linkEventSubscribers_.rlock();
+    for (auto const& subscriber : *subscribers) {
+      subscriber(link);
+    }
+  }
+  if (linkEventCB_) {
+    linkEventCB_(std::move(link), runHandler);
+  }
+}
+
 void
 NetlinkProtocolSocket::setAddrEventCB(
     std::function<void(fbnl::IfAddress, bool)> addrEventCB) {
@@ -182,15 +254,39 @@ NetlinkProtocolSocket::processAck(uint32_t ack, int status) {
   } else {
     fbData->addStatValue("netlink.requests.success", 1, fb303::SUM);
   }
+  // breakdown of failures, including the ones ignored by callers
+  if (status != 0) {
+    fbData->addStatValue(
+        folly::sformat("netlink.requests.errno.{}", std::abs(status)),
+        1,
+        fb303::SUM);
+  }
 
   auto it = nlSeqNumMap_.find(ack);
   if (it != nlSeqNumMap_.end()) {
     // Calculate and add the latency of the request in fb303
+    const auto now = std::chrono::steady_clock::now();
     auto requestLatency = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - it->second->getCreateTs());
+        now - it->second->getCreateTs());
     fbData->addStatValue(
         "netlink.requests.latency_ms", requestLatency.count(), fb303::AVG);
 
+    // Adapt send window on ack latency. Dump requests are excluded as their
+    // latency depends on the amount of data being dumped
+    const auto sendTs = it->second->getSendTs();
+    const auto ackLatency =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - sendTs);
+    fbData->addHistogramValue(kAckLatencyCounter, ackLatency.count());
+    fbData->addHistogramValue(
+        kRequestLatencyCounter,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            now - it->second->getCreateTs())
+            .count());
+    if ((it->second->getMessagePtr()->nlmsg_flags & NLM_F_DUMP) !=
+        NLM_F_DUMP) {
+      updateSendWindow(sendTs, ackLatency, status);
+    }
+
     // Set return status on promise
     it->second->setReturnStatus(status);
     nlSeqNumMap_.erase(it);
@@ -209,36 +305,95 @@ NetlinkProtocolSocket::processAck(uint32_t ack, int status) {
 
   // We've successfully completed at-least one message. Send more messages
   // if any pending. Here we add optimization to wait for some more acks and
-  // send pending message in batch of atleast `kMinIovMsg`
-  if (nlSeqNumMap_.empty() or (kMaxIovMsg - nlSeqNumMap_.size() > kMinIovMsg)) {
+  // send pending message in batch of atleast `kMinSendBatchRatio` of window
+  const auto sendWindow = getSendWindow();
+  if (nlSeqNumMap_.empty() or
+      (nlSeqNumMap_.size() < sendWindow and
+       sendWindow - nlSeqNumMap_.size() > sendWindow * kMinSendBatchRatio)) {
     sendNetlinkMessage();
   }
 }
 
+void
+NetlinkProtocolSocket::updateSendWindow(
+    std::chrono::steady_clock::time_point sendTs,
+    std::chrono::microseconds ackLatency,
+    int status) {
+  if (std::abs(status) == ENOBUFS or ackLatency > kAckLatencyTarget) {
+    // Decrease only once for messages in flight at the time of last decrease
+    if (sendTs > lastWindowDecreaseTs_) {
+      decreaseSendWindow();
+    }
+    return;
+  }
+
+  // Grow by one message per window worth of acks
+  sendWindow_ = std::min(
+      static_cast<double>(kMaxSendWindow), sendWindow_ + 1.0 / sendWindow_);
+}
+
+void
+NetlinkProtocolSocket::decreaseSendWindow() {
+  sendWindow_ = std::max(static_cast<double>(kMinSendWindow), sendWindow_ / 2);
+  lastWindowDecreaseTs_ = std::chrono::steady_clock::now();
+  fbData->addStatValue("netlink.send_window.decrease", 1, fb303::SUM);
+  VLOG(1) << "Decreased netlink send window to " << getSendWindow();
+}
+
 void
 NetlinkProtocolSocket::sendNetlinkMessage() {
   CHECK(evb_->isInEventBaseThread());
-  struct sockaddr_nl nladdr = {
-      .nl_family = AF_NETLINK, .nl_pad = 0, .nl_pid = 0, .nl_groups = 0};
-  CHECK_LE(nlSeqNumMap_.size(), kMaxIovMsg)
-      << "We must have capacity to send at-least one message!";
-  uint32_t count{0};
-  const uint32_t iovSize =
-      std::min(msgQueue_.size(), kMaxIovMsg - nlSeqNumMap_.size());
-
-  if (!iovSize) {
+  const auto sendWindow = getSendWindow();
+  if (nlSeqNumMap_.size() >= sendWindow) {
+    return;
+  }
+  size_t quota = std::min(msgQueue_.size(), sendWindow - nlSeqNumMap_.size());
+  if (!quota) {
     return;
   }
 
-  auto iov = std::make_unique<struct iovec[]>(iovSize);
+  // Send messages in batches bounded by iovec entries and bytes per `sendmsg`
+  std::vector<std::unique_ptr<NetlinkMessage>> batch;
+  size_t batchBytes{0};
+  while (quota && !msgQueue_.empty()) {
+    const uint32_t len = NLMSG_ALIGN(msgQueue_.front()->getDataLength());
+    if (!batch.empty() &&
+        (batch.size() == kMaxIovMsg ||
+         batchBytes + len > kMaxSendBatchBytes)) {
+      if (!sendNetlinkMessageBatch(batch)) {
+        break;
+      }
+      batchBytes = 0;
+    }
+    batch.emplace_back(std::move(msgQueue_.front()));
+    msgQueue_.pop_front();
+    batchBytes += len;
+    --quota;
+  }
+  if (!batch.empty()) {
+    sendNetlinkMessageBatch(batch);
+  }
+
+  fbData->addStatValue("netlink.inflight", nlSeqNumMap_.size(), fb303::AVG);
+  fbData->addStatValue("netlink.send_window", getSendWindow(), fb303::AVG);
 
-  while (count < iovSize && !msgQueue_.empty()) {
-    auto m = std::move(msgQueue_.front());
-    msgQueue_.pop();
+  // Schedule timer to wait for acks and send next set of messages
+  if (!nlSeqNumMap_.empty()) {
+    nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+  }
+}
+
+bool
+NetlinkProtocolSocket::sendNetlinkMessageBatch(
+    std::vector<std::unique_ptr<NetlinkMessage>>& batch) {
+  struct sockaddr_nl nladdr = {
+      .nl_family = AF_NETLINK, .nl_pad = 0, .nl_pid = 0, .nl_groups = 0};
+  std::vector<struct iovec> iov(batch.size());
 
-    struct nlmsghdr* nlmsg_hdr = m->getMessagePtr();
-    iov[count].iov_base = reinterpret_cast<void*>(m->getMessagePtr());
-    iov[count].iov_len = m->getDataLength();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    struct nlmsghdr* nlmsg_hdr = batch[i]->getMessagePtr();
+    iov[i].iov_base = reinterpret_cast<void*>(nlmsg_hdr);
+    iov[i].iov_len = batch[i]->getDataLength();
 
     // fill sequence number and PID
     nlmsg_hdr->nlmsg_pid = portId_;
@@ -254,10 +409,6 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
       fbData->addStatValue("netlink.errors", 1, fb303::SUM);
     }
 
-    // Add seq number -> netlink request mapping
-    auto res = nlSeqNumMap_.insert({nlmsg_hdr->nlmsg_seq, std::move(m)});
-    CHECK(res.second) << "Entry exists for " << nlmsg_hdr->nlmsg_seq;
-    count++;
     VLOG(2) << "Sending netlink request."
             << " seq=" << nlmsg_hdr->nlmsg_seq
             << ", type=" << nlmsg_hdr->nlmsg_type
@@ -265,36 +416,64 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
             << ", flags=" << nlmsg_hdr->nlmsg_flags;
   }
 
-  auto outMsg = std::make_unique<struct msghdr>();
-  outMsg->msg_name = &nladdr;
-  outMsg->msg_namelen = sizeof(nladdr);
-  outMsg->msg_iov = &iov[0];
-  outMsg->msg_iovlen = count;
+  struct msghdr outMsg = {};
+  outMsg.msg_name = &nladdr;
+  outMsg.msg_namelen = sizeof(nladdr);
+  outMsg.msg_iov = iov.data();
+  outMsg.msg_iovlen = iov.size();
 
   // `sendmsg` return -1 in case of error else number of bytes sent. `errno`
   // will be set to an appropriate code in case of error.
-  int bytesSent = sendmsg(nlSock_, outMsg.get(), 0);
+  int bytesSent = sendmsg(nlSock_, &outMsg, 0);
+  if (bytesSent < 0 && (errno == ENOBUFS || errno == EAGAIN)) {
+    // Kernel is out of buffers. Shrink window and re-queue messages in order
+    // to send them again on next ack (or after retry interval)
+    LOG(WARNING) << "Netlink socket out of buffers. Re-queuing "
+                 << batch.size() << " netlink requests";
+    decreaseSendWindow();
+    for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+      msgQueue_.push_front(std::move(*it));
+    }
+    batch.clear();
+    if (nlSeqNumMap_.empty()) {
+      nlSendRetryTimer_->scheduleTimeout(kSendRetryInterval);
+    }
+    return false;
+  }
+
   if (bytesSent < 0) {
     LOG(ERROR) << "Error sending on netlink socket. Error: "
                << folly::errnoStr(std::abs(errno)) << ", errno=" << errno
-               << ", fd=" << nlSock_ << ", num-messages=" << outMsg->msg_iovlen;
+               << ", fd=" << nlSock_ << ", num-messages=" << outMsg.msg_iovlen;
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
   } else {
     fbData->addStatValue("netlink.bytes.tx", bytesSent, fb303::SUM);
   }
-  fbData->addStatValue("netlink.requests", outMsg->msg_iovlen, fb303::SUM);
-  VLOG(2) << "Sent " << outMsg->msg_iovlen << " netlink requests on fd "
+  fbData->addStatValue("netlink.requests", outMsg.msg_iovlen, fb303::SUM);
+  VLOG(2) << "Sent " << outMsg.msg_iovlen << " netlink requests on fd "
           << nlSock_;
 
-  // Schedule timer to wait for acks and send next set of messages
-  nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+  // Add seq number -> netlink request mapping
+  const auto now = std::chrono::steady_clock::now();
+  for (auto& m : batch) {
+    m->setSendTs(now);
+    fbData->addHistogramValue(
+        kQueueLatencyCounter,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            now - m->getCreateTs())
+            .count());
+    const auto seq = m->getMessagePtr()->nlmsg_seq;
+    auto res = nlSeqNumMap_.emplace(seq, std::move(m));
+    CHECK(res.second) << "Entry exists for " << seq;
+  }
+  batch.clear();
+  return true;
 }
 
 void
-NetlinkProtocolSocket::processMessage(
-    const std::array<char, kMaxNlPayloadSize>& rxMsg, uint32_t bytesRead) {
+NetlinkProtocolSocket::processMessage(const char* rxMsg, uint32_t bytesRead) {
   // first netlink message header
-  struct nlmsghdr* nlh = (struct nlmsghdr*)rxMsg.data();
+  struct nlmsghdr* nlh = (struct nlmsghdr*)rxMsg;
   do {
     if (!NLMSG_OK(nlh, bytesRead)) {
       break;
@@ -336,9 +515,7 @@ NetlinkProtocolSocket::processMessage(
         // Link notification
         VLOG(2) << "Netlink link event. " << link.str();
         fbData->addStatValue("netlink.notifications.link", 1, fb303::SUM);
-        if (linkEventCB_) {
-          linkEventCB_(std::move(link), true);
-        }
+        notifyLinkEvent(std::move(link), true);
       }
     } break;
 
@@ -427,24 +604,49 @@ NetlinkProtocolSocket::processMessage(
 
 void
 NetlinkProtocolSocket::recvNetlinkMessage() {
-  // messages buffer
-  std::array<char, kMaxNlPayloadSize> recvMsg = {};
+  // Receive upto `kNlRecvBatchSize` datagrams with single system call. Large
+  // dump responses span many datagrams
+  std::array<struct iovec, kNlRecvBatchSize> iov;
+  std::array<struct mmsghdr, kNlRecvBatchSize> msgs;
+  ::memset(msgs.data(), 0, sizeof(msgs));
+  for (size_t i = 0; i < kNlRecvBatchSize; ++i) {
+    iov[i].iov_base = recvBuf_.get() + i * kMaxNlRecvSize;
+    iov[i].iov_len = kMaxNlRecvSize;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
 
-  int32_t bytesRead = ::recv(nlSock_, recvMsg.data(), kMaxNlPayloadSize, 0);
-  VLOG(4) << "Message received with size: " << bytesRead;
+  int numMsgs =
+      ::recvmmsg(nlSock_, msgs.data(), kNlRecvBatchSize, MSG_DONTWAIT, nullptr);
+  VLOG(4) << "Messages received: " << numMsgs;
 
-  if (bytesRead < 0) {
+  if (numMsgs < 0) {
     if (errno == EINTR || errno == EAGAIN) {
       return;
     }
-    LOG(ERROR) << "Error in netlink socket receive: " << bytesRead
+    LOG(ERROR) << "Error in netlink socket receive: " << numMsgs
                << " err: " << folly::errnoStr(std::abs(errno));
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    if (errno == ENOBUFS) {
+      // Receive buffer overflowed and responses are lost. Shrink window to
+      // limit outstanding responses
+      decreaseSendWindow();
+    }
     return;
-  } else {
+  }
+
+  for (int i = 0; i < numMsgs; ++i) {
+    const uint32_t bytesRead = msgs[i].msg_len;
+    VLOG(4) << "Message received with size: " << bytesRead;
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      LOG(ERROR) << "Truncated netlink message of size " << bytesRead;
+      fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    }
     fbData->addStatValue("netlink.bytes.rx", bytesRead, fb303::SUM);
+    processMessage(
+        reinterpret_cast<const char*>(iov[i].iov_base),
+        std::min(bytesRead, kMaxNlRecvSize));
   }
-  processMessage(recvMsg, static_cast<uint32_t>(bytesRead));
 }
 
 folly::SemiFuture<int>
@@ -498,6 +700,7 @@ NetlinkProtocolSocket::addRoute(const openr::fbnl::Route& route) {
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
+    rtmMsg->compact();
     notifQueue_.putMessage(std::move(rtmMsg));
   }
 
@@ -526,12 +729,69 @@ NetlinkProtocolSocket::deleteRoute(const openr::fbnl::Route& route) {
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
+    rtmMsg->compact();
     notifQueue_.putMessage(std::move(rtmMsg));
   }
 
   return future;
 }
 
+folly::SemiFuture<int>
+NetlinkProtocolSocket::addNexthop(
+    uint32_t id, const openr::fbnl::NextHop& nextHop, uint8_t protocolId) {
+  VLOG(1) << "Netlink add nexthop " << id << ". " << nextHop.str();
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->addNexthop(id, nextHop, protocolId);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    nhMsg->compact();
+    notifQueue_.putMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t protocolId) {
+  VLOG(1) << "Netlink add nexthop group " << id << " with " << members.size()
+          << " members";
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->addNexthopGroup(id, members, protocolId);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    nhMsg->compact();
+    notifQueue_.putMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::deleteNexthop(uint32_t id) {
+  VLOG(1) << "Netlink delete nexthop " << id;
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->deleteNexthop(id);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    nhMsg->compact();
+    notifQueue_.putMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
 folly::SemiFuture<int>
 NetlinkProtocolSocket::addIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   VLOG(1) << "Netlink add interface address. " << ifAddr.str();
@@ -543,6 +803,7 @@ NetlinkProtocolSocket::addIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   if (status != 0) {
     addrMsg->setReturnStatus(status);
   } else {
+    addrMsg->compact();
     notifQueue_.putMessage(std::move(addrMsg));
   }
 
@@ -560,6 +821,7 @@ NetlinkProtocolSocket::deleteIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   if (status != 0) {
     addrMsg->setReturnStatus(status);
   } else {
+    addrMsg->compact();
     notifQueue_.putMessage(std::move(addrMsg));
   }
 
@@ -574,6 +836,7 @@ NetlinkProtocolSocket::getAllLinks() {
 
   // Initialize message fields to get all links
   linkMsg->init(RTM_GETLINK, 0);
+  linkMsg->compact();
   notifQueue_.putMessage(std::move(linkMsg));
 
   return future;
@@ -587,6 +850,7 @@ NetlinkProtocolSocket::getAllIfAddresses() {
 
   // Initialize message fields to get all addresses
   addrMsg->init(RTM_GETADDR);
+  addrMsg->compact();
   notifQueue_.putMessage(std::move(addrMsg));
 
   return future;
@@ -600,6 +864,7 @@ NetlinkProtocolSocket::getAllNeighbors() {
 
   // Initialize message fields to get all neighbors
   neighMsg->init(RTM_GETNEIGH, 0);
+  neighMsg->compact();
   notifQueue_.putMessage(std::move(neighMsg));
 
   return future;
@@ -613,6 +878,23 @@ NetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
 
   // Initialize message fields to get all addresses
   routeMsg->init(RTM_GETROUTE, 0, filter);
+  routeMsg->compact();
+  notifQueue_.putMessage(std::move(routeMsg));
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::getRoutesStream(
+    const fbnl::Route& filter, RouteStreamCallback routeStreamCb) {
+  VLOG(1) << "Netlink stream routes with filter. " << filter.str();
+  auto routeMsg = std::make_unique<openr::fbnl::NetlinkRouteMessage>();
+  routeMsg->setRouteStreamCallback(std::move(routeStreamCb));
+  auto future = routeMsg->getSemiFuture();
+
+  // Initialize message fields to get all routes
+  routeMsg->init(RTM_GETROUTE, 0, filter);
+  routeMsg->compact();
   notifQueue_.putMessage(std::move(routeMsg));
 
   return future;
@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include <deque>
 #include <vector>
 
 #include <folly/IPAddress.h>
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
@@ -25,10 +27,37 @@ namespace openr::fbnl {
 // Receive socket buffer for netlink socket
 constexpr uint32_t kNetlinkSockRecvBuf{1 * 1024 * 1024};
 
-// Maximum number of in-flight messages. `kMinIovMsg` indicates the soft
-// requirement for sending bufferred messages.
-constexpr size_t kMaxIovMsg{500};
-constexpr size_t kMinIovMsg{200};
+// Buffer size for receiving a netlink datagram. Kernel sizes the parts of a
+// dump response upto the largest buffer application has received in (capped
+// at 32KB), hence a bigger buffer fetches more objects per datagram.
+constexpr uint32_t kMaxNlRecvSize{32 * 1024};
+
+// Maximum number of datagrams received with single `recvmmsg` call
+constexpr size_t kNlRecvBatchSize{8};
+
+// Window of in-flight messages. It is adapted with AIMD (additive increase,
+// multiplicative decrease) within [kMinSendWindow, kMaxSendWindow], starting
+// at kInitialSendWindow. Window grows by one message for every window worth of
+// acks received within kAckLatencyTarget of sending, and is halved (at most
+// once per round-trip) on slower acks or when kernel reports ENOBUFS.
+constexpr size_t kMinSendWindow{32};
+constexpr size_t kInitialSendWindow{500};
+constexpr size_t kMaxSendWindow{8000};
+constexpr std::chrono::microseconds kAckLatencyTarget{50000};
+
+// Buffered messages are sent once at-least this fraction of window is free,
+// so that messages are sent in batches rather than one per ack.
+constexpr double kMinSendBatchRatio{0.4};
+
+// Limits of a single `sendmsg` call. Kernel rejects more than UIO_MAXIOV
+// iovec entries, and datagram larger than the socket send buffer. Bigger
+// windows are sent in multiple batches.
+constexpr size_t kMaxIovMsg{1024};
+constexpr size_t kMaxSendBatchBytes{128 * 1024};
+
+// Interval to retry sending messages rejected with ENOBUFS when no ack is
+// pending to trigger it.
+constexpr std::chrono::milliseconds kSendRetryInterval{10};
 
 // Timeout for an ack from kernel for netlink messages we sent. The response for
 // big request (e.g. adding 5k routes or getting 10k routes) is sent back in
@@ -59,9 +88,10 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  * Above threading model allows multiple requests to be sent in parallel and
  * process their response asynchronously. Outstanding requests to kernel is
  * rate-limited to not overwhelm the socket buffers. Rate-limiting of requests
- * is governed by params kMaxIovMsg and kMinIovMsg. This allows adding 100k
- * routes in under 2 seconds. These performance benchmarks can be observed
- * by running associated UTs and it might vary on different systems.
+ * is governed by an adaptive send window (see kInitialSendWindow). This
+ * allows adding 100k routes in under 2 seconds. These performance benchmarks
+ * can be observed by running associated UTs and it might vary on different
+ * systems.
  *
  * NOTE Logging:
  * Netlink protocol is tricky when it comes to debugging. To faciliate debugging
@@ -82,12 +112,20 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  *   netlink.requests.success : Request that completed successfully
  *   netlink.requests.error : Request with non zero return code
  *   netlink.requests.latency_ms : Average latency of netlink request
+ *   netlink.ack_latency_us : Histogram of latency from send to ack
+ *   netlink.inflight : Number of in-flight requests
+ *   netlink.send_window : Current window of in-flight requests
+ *   netlink.send_window.decrease : Reductions of the send window
  *   netlink.bytes.rx : Bytes received over netlink socket
  *   netlink.bytes.tx : Bytes sent over netlink socket
  *   netlink.notifications.link : Received link notifications
  *   netlink.notifications.addr : Received address notifications
  *   netlink.notifications.neighbors : Received neighbor notifications
  *   netlink.notifications.route : Received route notifications
+ *   netlink.msg_pool_allocs : Message buffers allocated from heap
+ *   netlink.msg_pool_reuses : Message buffers re-used from pool
+ *   netlink.msg_pool_in_use_bytes : Bytes of message buffers in use
+ *   netlink.msg_pool_cached_bytes : Bytes of message buffers cached in pool
  */
 class NetlinkProtocolSocket : public folly::EventHandler {
  public:
@@ -96,9 +134,21 @@ class NetlinkProtocolSocket : public folly::EventHandler {
 
   virtual ~NetlinkProtocolSocket();
 
+  // Event base in which events are delivered to callbacks and subscribers
+  folly::EventBase*
+  getEvb() const {
+    return evb_;
+  }
+
   // Set netlinkSocket Link event callback
   void setLinkEventCB(std::function<void(fbnl::Link, bool)> linkEventCB);
 
+  // Subscribe to Link events in addition to the callback above. Unlike
+  // callback, any number of subscribers can be added (e.g. for caching
+  // interface state) and they are invoked before the callback.
+  void addLinkEventSubscriber(
+      std::function<void(const fbnl::Link&)> linkEventSubscriber);
+
   // Set netlinkSocket Addr event callback
   void setAddrEventCB(std::function<void(fbnl::IfAddress, bool)> addrEventCB);
 
@@ -136,6 +186,39 @@ class NetlinkProtocolSocket : public folly::EventHandler {
    */
   virtual folly::SemiFuture<int> deleteRoute(const openr::fbnl::Route& route);
 
+  /**
+   * Add or replace kernel nexthop object (RTM_NEWNEXTHOP) with specified id.
+   * Nexthop must have interface index and gateway. Routes can refer to the
+   * object with `RouteBuilder::setNextHopId(id)`. Requires kernel 5.3+
+   * `protocolId` is set as nexthop protocol, similar to route protocol.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> addNexthop(
+      uint32_t id,
+      const openr::fbnl::NextHop& nextHop,
+      uint8_t protocolId = fbnl::DEFAULT_PROTOCOL_ID);
+
+  /**
+   * Add or replace kernel nexthop group object. Members are specified as
+   * pair<nexthop-id, weight> and must already exist in kernel.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocolId = fbnl::DEFAULT_PROTOCOL_ID);
+
+  /**
+   * Delete kernel nexthop or nexthop group object. Kernel removes deleted
+   * nexthop from the groups referring it and deletes routes referring to
+   * the deleted object.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> deleteNexthop(uint32_t id);
+
   /**
    * Add an address to the interface
    *
@@ -182,6 +265,16 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   virtual folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
   getRoutes(const fbnl::Route& filter);
 
+  /**
+   * Streaming variant of `getRoutes` for large tables. Routes are delivered
+   * to the callback in batches as they're received from kernel, without
+   * materializing the whole table. Callback is invoked in netlink event
+   * thread. Returned future is fulfilled with the status of the request after
+   * all the routes have been delivered.
+   */
+  virtual folly::SemiFuture<int> getRoutesStream(
+      const fbnl::Route& filter, RouteStreamCallback routeStreamCb);
+
   /**
    * APIs to retrieve routes from default routing table.
    * std::vector<fbnl::Route> getAllRoutes();
@@ -214,6 +307,14 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   std::function<void(fbnl::IfAddress, bool)> addrEventCB_;
   std::function<void(fbnl::Neighbor, bool)> neighborEventCB_;
 
+  // Link event subscribers. Synchronized as subscribers can be added from
+  // any thread while events are being dispatched
+  folly::Synchronized<std::vector<std::function<void(const fbnl::Link&)>>>
+      linkEventSubscribers_;
+
+  // Invoke Link event callback and subscribers
+  void notifyLinkEvent(fbnl::Link link, bool runHandler);
+
  private:
   NetlinkProtocolSocket(NetlinkProtocolSocket const&) = delete;
   NetlinkProtocolSocket& operator=(NetlinkProtocolSocket const&) = delete;
@@ -224,19 +325,38 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Send a message batch to netlink socket from queue_
   void sendNetlinkMessage();
 
-  // Receive messages from netlink socket. Invoke `processMessage` for every
-  // message received.
+  // Receive messages from netlink socket in batches. Invoke `processMessage`
+  // for every message received.
   void recvNetlinkMessage();
 
   // Process received netlink message. Set return values for pending requests
   // or send notifications.
-  void processMessage(
-      const std::array<char, kMaxNlPayloadSize>& rxMsg, uint32_t bytesRead);
+  void processMessage(const char* rxMsg, uint32_t bytesRead);
 
   // Process ack message. Set return status on pending requests in nlSeqNumMap_
   // Resume sending messages from queue_ if any pending
   void processAck(uint32_t ack, int status);
 
+  // Send a batch of messages in single `sendmsg` call. Messages are moved
+  // to nlSeqNumMap_ on success and back to front of msgQueue_ if kernel is
+  // out of buffers. Returns false if batch couldn't be sent.
+  bool sendNetlinkMessageBatch(
+      std::vector<std::unique_ptr<NetlinkMessage>>& batch);
+
+  // Adapt send window on ack of the message sent at `sendTs`
+  void updateSendWindow(
+      std::chrono::steady_clock::time_point sendTs,
+      std::chrono::microseconds ackLatency,
+      int status);
+
+  // Halve the send window
+  void decreaseSendWindow();
+
+  size_t
+  getSendWindow() const {
+    return static_cast<size_t>(sendWindow_);
+  }
+
   // Event base for serializing read/write requests to netlink socket. Also
   // ensure thread safety of private member variables.
   folly::EventBase* evb_{nullptr};
@@ -277,17 +397,29 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   //    value of nlh->nlmsg_seq will set to 0.
   uint32_t nextNlSeqNum_{1};
 
+  // Buffers for receiving `kNlRecvBatchSize` datagrams of `kMaxNlRecvSize`
+  std::unique_ptr<char[]> recvBuf_{
+      std::make_unique<char[]>(kNlRecvBatchSize * kMaxNlRecvSize)};
+
   // Netlink message queue. Every add/del/get call for route/addr/neighbor/link
   // translates into one or more NetlinkMessages. These messages are first
   // stored in the queue and sent to kernel in rate limiting fashion. When ack
   // for in-flight messages is received, subsequent messages are sent.
-  std::queue<std::unique_ptr<NetlinkMessage>> msgQueue_;
+  std::deque<std::unique_ptr<NetlinkMessage>> msgQueue_;
+
+  // Adaptive window of in-flight messages. Fractional to allow increase of
+  // less than one message per ack.
+  double sendWindow_{kInitialSendWindow};
+
+  // Time of the last window decrease. Window is decreased only for acks of
+  // messages sent after it, i.e. once per round-trip
+  std::chrono::steady_clock::time_point lastWindowDecreaseTs_;
 
   // Sequence number to NetlinkMesage request mapping. Each in-flight message
   // sent to kernel, is assigned a unique sequence-number and stored in this
   // map. On receipt of ack from kernel (either success or error) we clear the
   // corresponding entry from this map.
-  std::unordered_map<uint32_t, std::shared_ptr<NetlinkMessage>> nlSeqNumMap_;
+  std::unordered_map<uint32_t, std::unique_ptr<NetlinkMessage>> nlSeqNumMap_;
 
   // Timer to help keep track of timeout of messages sent to kernel. It also
   // ensures the aliveness of the netlink socket-fd. Timer is
@@ -303,6 +435,9 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Timer for initializing this socket. This gets cancelled automatically if
   // event-base is never started
   std::unique_ptr<folly::AsyncTimeout> nlInitTimer_{nullptr};
+
+  // Timer to retry sending messages after kernel ran out of buffers
+  std::unique_ptr<folly::AsyncTimeout> nlSendRetryTimer_{nullptr};
 };
 
 } // namespace openr::fbnl
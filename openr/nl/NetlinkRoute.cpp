@@ -9,6 +9,19 @@
 
 namespace openr::fbnl {
 
+namespace {
+
+// Upper bound of space taken by a nexthop within RTA_MULTIPATH, for any of
+// the nexthop types (IP, MPLS push, swap, PHP or pop)
+constexpr size_t kMaxMultiPathNexthopLen = sizeof(struct rtnexthop) +
+    RTA_SPACE(sizeof(int)) /* RTA_OIF */ +
+    RTA_SPACE(sizeof(uint16_t) + 16) /* RTA_VIA or RTA_GATEWAY */ +
+    RTA_SPACE(RTA_SPACE(kMaxLabels * sizeof(struct mpls_label))) /* ENCAP */ +
+    RTA_SPACE(sizeof(uint16_t)) /* RTA_ENCAP_TYPE */ +
+    RTA_SPACE(kMaxLabels * sizeof(struct mpls_label)) /* RTA_NEWDST */;
+
+} // namespace
+
 NetlinkRouteMessage::NetlinkRouteMessage() {
   // get pointer to NLMSG header
   msghdr_ = getMessagePtr();
@@ -53,10 +66,20 @@ NetlinkRouteMessage::rcvdRoute(Route&& route) {
   }
 
   rcvdRoutes_.emplace_back(std::move(route));
+  if (routeStreamCb_ && rcvdRoutes_.size() >= kRouteStreamBatchSize) {
+    routeStreamCb_(std::move(rcvdRoutes_));
+    rcvdRoutes_.clear();
+  }
 }
 
 void
 NetlinkRouteMessage::setReturnStatus(int status) {
+  if (routeStreamCb_ && status == 0 && !rcvdRoutes_.empty()) {
+    // Deliver remaining routes before completing the request
+    routeStreamCb_(std::move(rcvdRoutes_));
+    rcvdRoutes_.clear();
+  }
+
   if (status == 0) {
     routePromise_.setValue(std::move(rcvdRoutes_));
   } else {
@@ -80,9 +103,9 @@ NetlinkRouteMessage::init(int type, uint32_t rtFlags, const Route& route) {
   if (type == RTM_GETROUTE) {
     // Get routes matching subsequent criteria specified below
     msghdr_->nlmsg_flags |= NLM_F_DUMP;
-    // NOTE - Only `rtmsg_->rtm_family` will be used by kernel as filter
-    // parameter. Other parameters such as table, protocol, scope, type will
-    // need to be filtered on user side.
+    // NOTE - Kernel filters on table, protocol and type only if strict
+    // checking is enabled on the socket (Linux 4.20+), else only on
+    // `rtmsg_->rtm_family`. They are filtered on user side as well.
     filters_.table = route.getRouteTable();
     filters_.type = route.getType();
     filters_.protocol = route.getProtocolId();
@@ -118,6 +141,18 @@ NetlinkRouteMessage::init(int type, uint32_t rtFlags, const Route& route) {
   if (rtFlag.has_value()) {
     rtmsg_->rtm_flags |= rtFlag.value();
   }
+
+  if (type == RTM_GETROUTE) {
+    // Strictly checked dump request is rejected unless header only carries
+    // the filters kernel supports. MPLS (or all families) dumps don't filter
+    // on table or type, which are left to the user side filters
+    rtmsg_->rtm_scope = 0;
+    rtmsg_->rtm_flags = 0;
+    if (rtmsg_->rtm_family != AF_INET and rtmsg_->rtm_family != AF_INET6) {
+      rtmsg_->rtm_table = 0;
+      rtmsg_->rtm_type = 0;
+    }
+  }
 }
 
 void
@@ -361,9 +396,12 @@ NetlinkRouteMessage::addPushNexthop(
 
 int
 NetlinkRouteMessage::addNextHops(const Route& route) {
-  std::array<char, kMaxNlPayloadSize> nhop = {};
   int status{0};
   if (route.getNextHops().size()) {
+    // nexthops are built in a buffer sized for them, wide ECMP routes can
+    // take more than the default buffer of the message
+    std::vector<char> nhop(
+        RTA_LENGTH(0) + route.getNextHops().size() * kMaxMultiPathNexthopLen);
     if ((status = addMultiPathNexthop(nhop, route))) {
       return status;
     }
@@ -372,6 +410,12 @@ NetlinkRouteMessage::addNextHops(const Route& route) {
     const char* const data = reinterpret_cast<const char*>(
         RTA_DATA(reinterpret_cast<struct rtattr*>(nhop.data())));
     int payloadLen = RTA_PAYLOAD(reinterpret_cast<struct rtattr*>(nhop.data()));
+    if ((status = reserve(
+             NLMSG_ALIGN(msghdr_->nlmsg_len) + RTA_SPACE(payloadLen)))) {
+      return status;
+    }
+    msghdr_ = getMessagePtr();
+    rtmsg_ = reinterpret_cast<struct rtmsg*>(NLMSG_DATA(msghdr_));
     if ((status = addAttributes(RTA_MULTIPATH, data, payloadLen, msghdr_))) {
       return status;
     };
@@ -381,7 +425,7 @@ NetlinkRouteMessage::addNextHops(const Route& route) {
 
 int
 NetlinkRouteMessage::addMultiPathNexthop(
-    std::array<char, kMaxNlPayloadSize>& nhop, const Route& route) const {
+    std::vector<char>& nhop, const Route& route) const {
   // Add [RTA_MULTIPATH - label, via, dev][RTA_ENCAP][RTA_ENCAP_TYPE]
   struct rtattr* rta = reinterpret_cast<struct rtattr*>(nhop.data());
 
@@ -615,6 +659,12 @@ NetlinkRouteMessage::parseMessage(const struct nlmsghdr* nlmsg) {
       routeBuilder.setPriority(*(reinterpret_cast<int*> RTA_DATA(routeAttr)));
     } break;
 
+    case RTA_NH_ID: {
+      // parse nexthop object id
+      routeBuilder.setNextHopId(
+          *(reinterpret_cast<uint32_t*> RTA_DATA(routeAttr)));
+    } break;
+
     // Nexthop attributes
     case RTA_GATEWAY:
     case RTA_OIF:
@@ -736,6 +786,17 @@ NetlinkRouteMessage::addRoute(const Route& route) {
     }
   }
 
+  // Route refers to nexthop object installed in kernel. Nexthops of the
+  // route are resolved by kernel from the nexthop object.
+  if (route.getNextHopId().has_value()) {
+    const uint32_t nhId = route.getNextHopId().value();
+    return addAttributes(
+        RTA_NH_ID,
+        reinterpret_cast<const char*>(&nhId),
+        sizeof(uint32_t),
+        msghdr_);
+  }
+
   return addNextHops(route);
 }
 
@@ -809,6 +870,176 @@ NetlinkRouteMessage::deleteLabelRoute(const Route& route) {
       msghdr_);
 }
 
+NetlinkNexthopMessage::NetlinkNexthopMessage() {
+  // get pointer to NLMSG header
+  msghdr_ = getMessagePtr();
+}
+
+NetlinkNexthopMessage::~NetlinkNexthopMessage() {}
+
+void
+NetlinkNexthopMessage::init(int type, uint8_t family, uint8_t protocol) {
+  if (type != RTM_NEWNEXTHOP && type != RTM_DELNEXTHOP) {
+    LOG(ERROR) << "Incorrect netlink message type";
+    return;
+  }
+  // initialize netlink header
+  msghdr_->nlmsg_len = NLMSG_LENGTH(sizeof(struct nhmsg));
+  msghdr_->nlmsg_type = type;
+  msghdr_->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+
+  if (type == RTM_NEWNEXTHOP) {
+    // We create new nexthop or replace existing
+    msghdr_->nlmsg_flags |= NLM_F_CREATE;
+    msghdr_->nlmsg_flags |= NLM_F_REPLACE;
+  }
+
+  // intialize the nexthop message header
+  auto nlmsgAlen = NLMSG_ALIGN(sizeof(struct nlmsghdr));
+  nhmsg_ = reinterpret_cast<struct nhmsg*>((char*)msghdr_ + nlmsgAlen);
+  nhmsg_->nh_family = family;
+  nhmsg_->nh_scope = 0;
+  nhmsg_->nh_protocol = protocol;
+  nhmsg_->nh_flags = 0;
+}
+
+int
+NetlinkNexthopMessage::addNexthop(
+    uint32_t id, const NextHop& nextHop, uint8_t protocol) {
+  auto const via = nextHop.getGateway();
+  if (!via.has_value()) {
+    LOG(ERROR) << "Nexthop IP not provided";
+    return EINVAL;
+  }
+  if (!nextHop.getIfIndex().has_value()) {
+    LOG(ERROR) << "Nexthop interface index not provided";
+    return EINVAL;
+  }
+  auto action = nextHop.getLabelAction();
+  if (action.has_value() && action.value() != thrift::MplsActionCode::PUSH) {
+    LOG(ERROR) << "Only PUSH label action is supported for nexthop object";
+    return EINVAL;
+  }
+
+  init(RTM_NEWNEXTHOP, via.value().isV4() ? AF_INET : AF_INET6, protocol);
+
+  int status{0};
+  if ((status = addAttributes(
+           NHA_ID, reinterpret_cast<const char*>(&id), sizeof(id), msghdr_))) {
+    return status;
+  }
+
+  const uint32_t oif = nextHop.getIfIndex().value();
+  if ((status = addAttributes(
+           NHA_OIF,
+           reinterpret_cast<const char*>(&oif),
+           sizeof(oif),
+           msghdr_))) {
+    return status;
+  }
+
+  if ((status = addAttributes(
+           NHA_GATEWAY,
+           reinterpret_cast<const char*>(via.value().bytes()),
+           via.value().byteCount(),
+           msghdr_))) {
+    return status;
+  }
+
+  if (!action.has_value()) {
+    return 0;
+  }
+
+  // NHA_ENCAP_TYPE
+  uint16_t encapType = LWTUNNEL_ENCAP_MPLS;
+  if ((status = addAttributes(
+           NHA_ENCAP_TYPE,
+           reinterpret_cast<const char*>(&encapType),
+           sizeof(encapType),
+           msghdr_))) {
+    return status;
+  }
+
+  // NHA_ENCAP with nested MPLS_IPTUNNEL_DST
+  auto labels = nextHop.getPushLabels();
+  if (!labels.has_value()) {
+    LOG(ERROR) << "Labels not provided for PUSH action";
+    return EINVAL;
+  }
+  // abort immediately to bring attention
+  CHECK(labels.value().size() <= kMaxLabels);
+  std::array<struct mpls_label, kMaxLabels> mplsLabel;
+  std::reverse(labels.value().begin(), labels.value().end());
+  size_t i = 0;
+  for (auto label : labels.value()) {
+    bool bos = i == labels.value().size() - 1;
+    mplsLabel[i++].entry = NetlinkRouteMessage::encodeLabel(label, bos);
+  }
+
+  std::array<char, kMaxNlPayloadSize> encap = {};
+  struct rtattr* rta = reinterpret_cast<struct rtattr*>(encap.data());
+  rta->rta_type = NHA_ENCAP;
+  rta->rta_len = RTA_LENGTH(0);
+  size_t totalSize = labels.value().size() * sizeof(struct mpls_label);
+  if (addSubAttributes(rta, MPLS_IPTUNNEL_DST, &mplsLabel, totalSize) ==
+      nullptr) {
+    return ENOBUFS;
+  }
+  return addAttributes(
+      NHA_ENCAP,
+      reinterpret_cast<const char*>(RTA_DATA(rta)),
+      RTA_PAYLOAD(rta),
+      msghdr_);
+}
+
+int
+NetlinkNexthopMessage::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t protocol) {
+  if (members.empty()) {
+    LOG(ERROR) << "Nexthop group must have at least one member";
+    return EINVAL;
+  }
+
+  // Group objects are family-less, family is derived from members
+  init(RTM_NEWNEXTHOP, AF_UNSPEC, protocol);
+
+  int status{0};
+  if ((status = addAttributes(
+           NHA_ID, reinterpret_cast<const char*>(&id), sizeof(id), msghdr_))) {
+    return status;
+  }
+
+  std::vector<struct nexthop_grp> group(members.size());
+  for (size_t i = 0; i < members.size(); ++i) {
+    group[i].id = members[i].first;
+    // kernel weight is 0 based i.e. weight 0 means 1
+    group[i].weight = members[i].second ? members[i].second - 1 : 0;
+    group[i].resvd1 = 0;
+    group[i].resvd2 = 0;
+  }
+  // wide groups don't fit the default buffer of the message
+  const uint32_t groupLen = group.size() * sizeof(struct nexthop_grp);
+  if ((status =
+           reserve(NLMSG_ALIGN(msghdr_->nlmsg_len) + RTA_SPACE(groupLen)))) {
+    return status;
+  }
+  msghdr_ = getMessagePtr();
+  return addAttributes(
+      NHA_GROUP,
+      reinterpret_cast<const char*>(group.data()),
+      groupLen,
+      msghdr_);
+}
+
+int
+NetlinkNexthopMessage::deleteNexthop(uint32_t id) {
+  init(RTM_DELNEXTHOP, AF_UNSPEC, 0);
+  return addAttributes(
+      NHA_ID, reinterpret_cast<const char*>(&id), sizeof(id), msghdr_);
+}
+
 NetlinkLinkMessage::NetlinkLinkMessage() {
   // get pointer to NLMSG header
   msghdr_ = getMessagePtr();
@@ -854,7 +1085,10 @@ NetlinkLinkMessage::init(int type, uint32_t linkFlags) {
   ifinfomsg_ = reinterpret_cast<struct ifinfomsg*>((char*)msghdr_ + nlmsgAlen);
 
   ifinfomsg_->ifi_flags = linkFlags;
-  ifinfomsg_->ifi_change = 0xffffffff;
+  // strictly checked dump request is rejected with change mask set
+  if (type != RTM_GETLINK) {
+    ifinfomsg_->ifi_change = 0xffffffff;
+  }
 }
 
 Link
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <linux/lwtunnel.h>
 #include <linux/mpls.h>
 #include <linux/rtnetlink.h>
@@ -27,6 +30,49 @@
 #define MPLS_IPTUNNEL_DST 1
 #endif
 
+// Nexthop objects (RTM_NEWNEXTHOP) were added in kernel 5.3. Provide the uapi
+// definitions if the build host headers are older than that.
+#if __has_include(<linux/nexthop.h>)
+#include <linux/nexthop.h>
+#else
+struct nhmsg {
+  unsigned char nh_family;
+  unsigned char nh_scope;
+  unsigned char nh_protocol;
+  unsigned char resvd;
+  unsigned int nh_flags;
+};
+
+struct nexthop_grp {
+  uint32_t id;
+  uint8_t weight;
+  uint8_t resvd1;
+  uint16_t resvd2;
+};
+
+enum {
+  NHA_UNSPEC,
+  NHA_ID,
+  NHA_GROUP,
+  NHA_GROUP_TYPE,
+  NHA_BLACKHOLE,
+  NHA_OIF,
+  NHA_GATEWAY,
+  NHA_ENCAP_TYPE,
+  NHA_ENCAP,
+};
+#endif
+
+#ifndef RTM_NEWNEXTHOP
+#define RTM_NEWNEXTHOP 104
+#define RTM_DELNEXTHOP 105
+#define RTM_GETNEXTHOP 106
+#endif
+
+#ifndef RTA_NH_ID
+#define RTA_NH_ID 30
+#endif
+
 namespace openr::fbnl {
 
 constexpr uint16_t kMaxLabels{16};
@@ -35,6 +81,12 @@ constexpr uint32_t kLabelShift{12};
 constexpr uint32_t kLabelMask{0xFFFFF000};
 constexpr uint32_t kLabelSizeBits{20};
 
+// Number of routes delivered per invocation of RouteStreamCallback
+constexpr size_t kRouteStreamBatchSize{1024};
+
+// Callback receiving routes of a dump request incrementally, in batches
+using RouteStreamCallback = std::function<void(std::vector<Route>&&)>;
+
 /**
  * Message specialization for ROUTE object
  */
@@ -56,13 +108,24 @@ class NetlinkRouteMessage final : public NetlinkMessage {
   // initiallize route message with default params
   void init(int type, uint32_t flags, const Route& route);
 
+  // Deliver routes received in response to GET request to the callback in
+  // batches of `kRouteStreamBatchSize`, instead of accumulating them for the
+  // routes future (which is then fulfilled with empty vector). Callback is
+  // invoked in netlink event thread, and for the last time before the
+  // return status is set.
+  void
+  setRouteStreamCallback(RouteStreamCallback routeStreamCb) {
+    routeStreamCb_ = std::move(routeStreamCb);
+  }
+
   friend std::ostream&
   operator<<(std::ostream& out, NetlinkRouteMessage const& msg) {
-    out << "\nMessage type:     " << msg.msghdr_->nlmsg_type
-        << "\nMessage length:   " << msg.msghdr_->nlmsg_len
-        << "\nMessage flags:    " << std::hex << msg.msghdr_->nlmsg_flags
-        << "\nMessage sequence: " << msg.msghdr_->nlmsg_seq
-        << "\nMessage pid:      " << msg.msghdr_->nlmsg_pid << std::endl;
+    auto const* msghdr = msg.getMessagePtr();
+    out << "\nMessage type:     " << msghdr->nlmsg_type
+        << "\nMessage length:   " << msghdr->nlmsg_len
+        << "\nMessage flags:    " << std::hex << msghdr->nlmsg_flags
+        << "\nMessage sequence: " << msghdr->nlmsg_seq
+        << "\nMessage pid:      " << msghdr->nlmsg_pid << std::endl;
     return out;
   }
 
@@ -121,9 +184,8 @@ class NetlinkRouteMessage final : public NetlinkMessage {
   // add set of nexthops
   int addNextHops(const Route& route);
 
-  // Add ECMP paths
-  int addMultiPathNexthop(
-      std::array<char, kMaxNlPayloadSize>& nhop, const Route& route) const;
+  // Add ECMP paths, into buffer fitting RTA_MULTIPATH attribute of them
+  int addMultiPathNexthop(std::vector<char>& nhop, const Route& route) const;
 
   // Add label encap
   int addPushNexthop(
@@ -169,6 +231,46 @@ class NetlinkRouteMessage final : public NetlinkMessage {
 
   folly::Promise<folly::Expected<std::vector<Route>, int>> routePromise_;
   std::vector<Route> rcvdRoutes_;
+
+  // Optional callback for streaming received routes
+  RouteStreamCallback routeStreamCb_{nullptr};
+};
+
+/**
+ * Message specialization for NEXTHOP object. Nexthops are installed once and
+ * referenced by id from any number of routes (RTA_NH_ID), so that changing a
+ * shared nexthop (group) doesn't require re-programming every route using it.
+ */
+class NetlinkNexthopMessage final : public NetlinkMessage {
+ public:
+  NetlinkNexthopMessage();
+
+  ~NetlinkNexthopMessage() override;
+
+  // initiallize nexthop message with default params
+  // type - RTM_NEWNEXTHOP or RTM_DELNEXTHOP
+  void init(int type, uint8_t family, uint8_t protocol);
+
+  // add or replace a single nexthop object. Nexthop must have interface index
+  // and gateway set. PUSH label action is encoded as MPLS lwtunnel encap.
+  int addNexthop(uint32_t id, const NextHop& nextHop, uint8_t protocol);
+
+  // add or replace a nexthop group object referring to existing nexthop
+  // objects as pair<id, weight>. Weight of 0 is treated as 1.
+  int addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocol);
+
+  // delete nexthop or nexthop group object
+  int deleteNexthop(uint32_t id);
+
+ private:
+  // pointer to nexthop message header
+  struct nhmsg* nhmsg_{nullptr};
+
+  // pointer to the netlink message header
+  struct nlmsghdr* msghdr_{nullptr};
 };
 
 /**
@@ -222,6 +222,17 @@ RouteBuilder::getNextHops() const {
   return nextHops_;
 }
 
+RouteBuilder&
+RouteBuilder::setNextHopId(uint32_t nextHopId) {
+  nextHopId_ = nextHopId;
+  return *this;
+}
+
+std::optional<uint32_t>
+RouteBuilder::getNextHopId() const {
+  return nextHopId_;
+}
+
 uint8_t
 RouteBuilder::getFamily() const {
   return family_;
@@ -252,6 +263,7 @@ RouteBuilder::reset() {
   advMss_.reset();
   nextHops_.clear();
   routeIfName_.reset();
+  nextHopId_.reset();
 }
 
 Route::Route(const RouteBuilder& builder)
@@ -269,7 +281,8 @@ Route::Route(const RouteBuilder& builder)
       nextHops_(builder.getNextHops()),
       dst_(builder.getDestination()),
       routeIfName_(builder.getRouteIfName()),
-      mplsLabel_(builder.getMplsLabel()) {}
+      mplsLabel_(builder.getMplsLabel()),
+      nextHopId_(builder.getNextHopId()) {}
 
 Route::~Route() {}
 
@@ -297,6 +310,7 @@ Route::operator=(Route&& other) noexcept {
   routeIfName_ = std::move(other.routeIfName_);
   family_ = std::move(other.family_);
   mplsLabel_ = std::move(other.mplsLabel_);
+  nextHopId_ = std::move(other.nextHopId_);
   return *this;
 }
 
@@ -324,6 +338,7 @@ Route::operator=(const Route& other) {
   routeIfName_ = other.routeIfName_;
   family_ = other.family_;
   mplsLabel_ = other.mplsLabel_;
+  nextHopId_ = other.nextHopId_;
   return *this;
 }
 
@@ -341,6 +356,7 @@ operator==(const Route& lhs, const Route& rhs) {
        lhs.getPriority() == rhs.getPriority() && lhs.getTos() == rhs.getTos() &&
        lhs.getMtu() == rhs.getMtu() && lhs.getAdvMss() == rhs.getAdvMss() &&
        lhs.getRouteIfName() == rhs.getRouteIfName() &&
+       lhs.getNextHopId() == rhs.getNextHopId() &&
        lhs.getFamily() == rhs.getFamily());
 
   if (!ret) {
@@ -422,6 +438,11 @@ Route::getNextHops() const {
   return nextHops_;
 }
 
+std::optional<uint32_t>
+Route::getNextHopId() const {
+  return nextHopId_;
+}
+
 std::optional<std::string>
 Route::getRouteIfName() const {
   return routeIfName_;
@@ -468,6 +489,9 @@ Route::str() const {
   if (advMss_) {
     result += folly::sformat(", advmss {}", advMss_.value());
   }
+  if (nextHopId_) {
+    result += folly::sformat(", nhid {}", nextHopId_.value());
+  }
   for (auto const& nextHop : nextHops_) {
     result += "\n  " + nextHop.str();
   }
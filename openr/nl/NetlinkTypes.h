@@ -259,6 +259,13 @@ class RouteBuilder {
 
   const NextHopSet& getNextHops() const;
 
+  // Optional kernel nexthop object id (RTA_NH_ID). When set the route refers
+  // to a nexthop (group) installed via RTM_NEWNEXTHOP instead of carrying
+  // its own nexthops
+  RouteBuilder& setNextHopId(uint32_t nextHopId);
+
+  std::optional<uint32_t> getNextHopId() const;
+
   uint8_t getFamily() const;
 
   void reset();
@@ -280,6 +287,7 @@ class RouteBuilder {
   std::optional<int> routeIfIndex_; // for multicast or link route
   std::optional<std::string> routeIfName_; // for multicast or linkroute
   std::optional<uint32_t> mplsLabel_;
+  std::optional<uint32_t> nextHopId_;
 };
 
 class Route final {
@@ -320,6 +328,8 @@ class Route final {
 
   const NextHopSet& getNextHops() const;
 
+  std::optional<uint32_t> getNextHopId() const;
+
   bool isValid() const;
 
   std::optional<std::string> getRouteIfName() const;
@@ -346,6 +356,7 @@ class Route final {
   folly::CIDRNetwork dst_;
   std::optional<std::string> routeIfName_;
   std::optional<uint32_t> mplsLabel_;
+  std::optional<uint32_t> nextHopId_;
 };
 
 bool operator==(const Route& lhs, const Route& rhs);
@@ -5,6 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "openr/nl/tests/FakeNetlinkProtocolSocket.h"
 
 namespace openr::fbnl {
@@ -48,6 +51,12 @@ folly::SemiFuture<int>
 FakeNetlinkProtocolSocket::addRoute(const fbnl::Route& route) {
   // Blindly replace existing route
   const auto proto = route.getProtocolId();
+  // Referred nexthop object must exist, similar to kernel
+  const auto nhId = route.getNextHopId();
+  if (nhId.has_value() and not nexthops_.count(nhId.value()) and
+      not nexthopGroups_.count(nhId.value())) {
+    return folly::SemiFuture<int>(-EINVAL);
+  }
   if (route.getFamily() == AF_MPLS) {
     mplsRoutes_[proto][route.getMplsLabel().value()] = route;
   } else {
@@ -70,6 +79,80 @@ FakeNetlinkProtocolSocket::deleteRoute(const fbnl::Route& route) {
   return folly::SemiFuture<int>(cnt ? 0 : ESRCH);
 }
 
+folly::SemiFuture<int>
+FakeNetlinkProtocolSocket::addNexthop(
+    uint32_t id, const fbnl::NextHop& nextHop, uint8_t /* protocolId */) {
+  if (!nextHop.getGateway().has_value() || !nextHop.getIfIndex().has_value() ||
+      nexthopGroups_.count(id)) {
+    return folly::SemiFuture<int>(-EINVAL);
+  }
+  // Blindly replace existing nexthop
+  nexthops_.insert_or_assign(id, nextHop);
+  return folly::SemiFuture<int>(0);
+}
+
+folly::SemiFuture<int>
+FakeNetlinkProtocolSocket::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t /* protocolId */) {
+  // All members must be existing nexthops
+  if (members.empty() || nexthops_.count(id)) {
+    return folly::SemiFuture<int>(-EINVAL);
+  }
+  for (auto const& [memberId, _] : members) {
+    if (not nexthops_.count(memberId)) {
+      return folly::SemiFuture<int>(-EINVAL);
+    }
+  }
+  nexthopGroups_[id] = members;
+  return folly::SemiFuture<int>(0);
+}
+
+folly::SemiFuture<int>
+FakeNetlinkProtocolSocket::deleteNexthop(uint32_t id) {
+  if (not nexthops_.erase(id) and not nexthopGroups_.erase(id)) {
+    // Return ESRCH (no such process) error code, same as deleteRoute
+    return folly::SemiFuture<int>(ESRCH);
+  }
+
+  // Remove deleted nexthop from groups. Empty groups are deleted
+  std::unordered_set<uint32_t> deletedIds{id};
+  for (auto it = nexthopGroups_.begin(); it != nexthopGroups_.end();) {
+    auto& members = it->second;
+    members.erase(
+        std::remove_if(
+            members.begin(),
+            members.end(),
+            [id](auto const& member) { return member.first == id; }),
+        members.end());
+    if (members.empty()) {
+      deletedIds.emplace(it->first);
+      it = nexthopGroups_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Remove all routes referring to the deleted objects
+  auto eraseRoutes = [&deletedIds](auto& routesByProto) {
+    for (auto& [_, routes] : routesByProto) {
+      for (auto it = routes.begin(); it != routes.end();) {
+        auto nhId = it->second.getNextHopId();
+        if (nhId.has_value() and deletedIds.count(nhId.value())) {
+          it = routes.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  };
+  eraseRoutes(unicastRoutes_);
+  eraseRoutes(mplsRoutes_);
+
+  return folly::SemiFuture<int>(0);
+}
+
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
 FakeNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
   const auto filterFamily = filter.getFamily();
@@ -113,6 +196,17 @@ FakeNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
   return result;
 }
 
+folly::SemiFuture<int>
+FakeNetlinkProtocolSocket::getRoutesStream(
+    const fbnl::Route& filter, fbnl::RouteStreamCallback routeStreamCb) {
+  auto routes = getRoutes(filter).get();
+  if (routes.hasError()) {
+    return folly::SemiFuture<int>(routes.error());
+  }
+  routeStreamCb(std::move(routes).value());
+  return folly::SemiFuture<int>(0);
+}
+
 folly::SemiFuture<int>
 FakeNetlinkProtocolSocket::addIfAddress(const fbnl::IfAddress& addr) {
   // Search for addr list of interface index (it must exists)
@@ -185,9 +279,7 @@ FakeNetlinkProtocolSocket::addLink(const fbnl::Link& link) {
   ifAddrs_.emplace(link.getIfIndex(), std::list<fbnl::IfAddress>());
 
   // Send link event
-  if (linkEventCB_) {
-    linkEventCB_(link, false);
-  }
+  notifyLinkEvent(link, false);
 
   return folly::SemiFuture<int>(0);
 }
@@ -56,6 +56,17 @@ class FakeNetlinkProtocolSocket : public NetlinkProtocolSocket {
   folly::SemiFuture<int> deleteRoute(const fbnl::Route& route) override;
   folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>> getRoutes(
       const fbnl::Route& filter) override;
+  folly::SemiFuture<int> getRoutesStream(
+      const fbnl::Route& filter,
+      fbnl::RouteStreamCallback routeStreamCb) override;
+
+  folly::SemiFuture<int> addNexthop(
+      uint32_t id, const fbnl::NextHop& nextHop, uint8_t protocolId) override;
+  folly::SemiFuture<int> addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocolId) override;
+  folly::SemiFuture<int> deleteNexthop(uint32_t id) override;
 
   folly::SemiFuture<int> addIfAddress(const fbnl::IfAddress&) override;
   folly::SemiFuture<int> deleteIfAddress(const fbnl::IfAddress&) override;
@@ -88,6 +99,10 @@ class FakeNetlinkProtocolSocket : public NetlinkProtocolSocket {
   std::unordered_map<uint8_t, std::map<folly::CIDRNetwork, fbnl::Route>>
       unicastRoutes_;
   std::unordered_map<uint8_t, std::map<uint32_t, fbnl::Route>> mplsRoutes_;
+
+  // map<nexthop-id -> NextHop> and map<group-id -> list<member-id, weight>>
+  std::map<uint32_t, fbnl::NextHop> nexthops_;
+  std::map<uint32_t, std::vector<std::pair<uint32_t, uint8_t>>> nexthopGroups_;
 };
 
 } // namespace openr::fbnl
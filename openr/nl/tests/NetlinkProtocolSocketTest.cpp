@@ -541,6 +541,159 @@ TEST(NetlinkRouteMessage, EncodeLabel) {
   }
 }
 
+TEST(NetlinkRouteMessage, DumpRequestFilters) {
+  // IP route dump carries table, protocol and type filters for kernel
+  {
+    NetlinkRouteMessage msg;
+    fbnl::RouteBuilder builder;
+    builder.setDestination({folly::IPAddressV6("::"), 0})
+        .setProtocolId(kRouteProtoId)
+        .setType(RTN_UNSPEC);
+    msg.init(RTM_GETROUTE, 0, builder.build());
+    auto const* rtm =
+        reinterpret_cast<struct rtmsg*>(NLMSG_DATA(msg.getMessagePtr()));
+    EXPECT_TRUE(msg.getMessagePtr()->nlmsg_flags & NLM_F_DUMP);
+    EXPECT_EQ(AF_INET6, rtm->rtm_family);
+    EXPECT_EQ(RT_TABLE_MAIN, rtm->rtm_table);
+    EXPECT_EQ(kRouteProtoId, rtm->rtm_protocol);
+    EXPECT_EQ(RTN_UNSPEC, rtm->rtm_type);
+    EXPECT_EQ(0, rtm->rtm_dst_len);
+    EXPECT_EQ(0, rtm->rtm_scope);
+    msg.setReturnStatus(0);
+  }
+
+  // MPLS route dump only carries protocol filter
+  {
+    NetlinkRouteMessage msg;
+    fbnl::RouteBuilder builder;
+    builder.setMplsLabel(0).setProtocolId(kRouteProtoId);
+    msg.init(RTM_GETROUTE, 0, builder.build());
+    auto const* rtm =
+        reinterpret_cast<struct rtmsg*>(NLMSG_DATA(msg.getMessagePtr()));
+    EXPECT_EQ(AF_MPLS, rtm->rtm_family);
+    EXPECT_EQ(0, rtm->rtm_table);
+    EXPECT_EQ(kRouteProtoId, rtm->rtm_protocol);
+    EXPECT_EQ(0, rtm->rtm_type);
+    msg.setReturnStatus(0);
+  }
+
+  // link dump request carries no change mask
+  {
+    fbnl::NetlinkLinkMessage msg;
+    msg.init(RTM_GETLINK, 0);
+    auto const* ifm =
+        reinterpret_cast<struct ifinfomsg*>(NLMSG_DATA(msg.getMessagePtr()));
+    EXPECT_EQ(0, ifm->ifi_change);
+    EXPECT_EQ(0, ifm->ifi_flags);
+    msg.setReturnStatus(0);
+  }
+}
+
+TEST(NetlinkMessagePool, BufferCapacity) {
+  using openr::fbnl::NetlinkMessagePool;
+  EXPECT_EQ(256, NetlinkMessagePool::getBufferCapacity(0));
+  EXPECT_EQ(256, NetlinkMessagePool::getBufferCapacity(256));
+  EXPECT_EQ(512, NetlinkMessagePool::getBufferCapacity(257));
+  EXPECT_EQ(2048, NetlinkMessagePool::getBufferCapacity(1500));
+  EXPECT_EQ(
+      openr::fbnl::kMaxNlPayloadSize,
+      NetlinkMessagePool::getBufferCapacity(openr::fbnl::kMaxNlPayloadSize));
+}
+
+/**
+ * Route message is built in maximum size buffer and compacted into the
+ * smallest fitting pooled buffer without altering its content. Buffers are
+ * returned to pool on destruction and re-used by subsequent messages.
+ */
+TEST(NetlinkMessagePool, CompactAndReuse) {
+  using openr::fbnl::NetlinkMessagePool;
+  auto& pool = NetlinkMessagePool::getInstance();
+  const auto inUseBytes = pool.getInUseBytes();
+
+  openr::fbnl::NextHopBuilder nhBuilder;
+  openr::fbnl::RouteBuilder rtBuilder;
+  auto route = rtBuilder.setDestination(ipPrefix1)
+                   .setProtocolId(kRouteProtoId)
+                   .addNextHop(nhBuilder.setGateway(ipAddrY1V6)
+                                   .setIfIndex(1)
+                                   .build())
+                   .build();
+
+  auto msg = std::make_unique<NetlinkRouteMessage>();
+  EXPECT_EQ(0, msg->addRoute(route));
+  EXPECT_EQ(openr::fbnl::kMaxNlPayloadSize, msg->getBufferCapacity());
+  EXPECT_EQ(
+      inUseBytes + openr::fbnl::kMaxNlPayloadSize, pool.getInUseBytes());
+
+  const auto len = msg->getDataLength();
+  const std::string content(
+      reinterpret_cast<const char*>(msg->getMessagePtr()), len);
+  msg->compact();
+  EXPECT_EQ(
+      NetlinkMessagePool::getBufferCapacity(len), msg->getBufferCapacity());
+  EXPECT_GT(openr::fbnl::kMaxNlPayloadSize, msg->getBufferCapacity());
+  EXPECT_EQ(inUseBytes + msg->getBufferCapacity(), pool.getInUseBytes());
+  EXPECT_EQ(len, msg->getDataLength());
+  EXPECT_EQ(
+      content,
+      std::string(reinterpret_cast<const char*>(msg->getMessagePtr()), len));
+
+  // Released buffers are cached and re-used
+  msg->setReturnStatus(0);
+  msg.reset();
+  EXPECT_EQ(inUseBytes, pool.getInUseBytes());
+  const auto cachedBytes = pool.getCachedBytes();
+  EXPECT_LE(openr::fbnl::kMaxNlPayloadSize, cachedBytes);
+
+  msg = std::make_unique<NetlinkRouteMessage>();
+  EXPECT_EQ(
+      cachedBytes - openr::fbnl::kMaxNlPayloadSize, pool.getCachedBytes());
+  msg->setReturnStatus(0);
+}
+
+/**
+ * Route with wide ECMP doesn't fit the default buffer. Message grows to fit
+ * all of its nexthops and parses back to the same route.
+ */
+TEST(NetlinkMessagePool, WideEcmpRoute) {
+  using openr::fbnl::NetlinkMessagePool;
+  const size_t numNexthops{512};
+
+  openr::fbnl::RouteBuilder rtBuilder;
+  rtBuilder.setDestination(ipPrefix1).setProtocolId(kRouteProtoId);
+  for (size_t i = 0; i < numNexthops; ++i) {
+    openr::fbnl::NextHopBuilder nhBuilder;
+    rtBuilder.addNextHop(
+        nhBuilder.setGateway(folly::IPAddress(folly::sformat("fe80::{:x}", i)))
+            .setIfIndex(1)
+            .setLabelAction(thrift::MplsActionCode::PUSH)
+            .setPushLabels({100, 200})
+            .build());
+  }
+  auto route = rtBuilder.build();
+
+  auto msg = std::make_unique<NetlinkRouteMessage>();
+  EXPECT_EQ(0, msg->addRoute(route));
+  EXPECT_LT(openr::fbnl::kMaxNlPayloadSize, msg->getDataLength());
+  EXPECT_GE(openr::fbnl::kMaxNlMessageSize, msg->getBufferCapacity());
+  EXPECT_EQ(
+      NetlinkMessagePool::getBufferCapacity(msg->getDataLength()),
+      msg->getBufferCapacity());
+
+  // Compact is a no-op on fitting buffer
+  const auto len = msg->getDataLength();
+  msg->compact();
+  EXPECT_EQ(len, msg->getDataLength());
+
+  const auto parsed = NetlinkRouteMessage::parseMessage(msg->getMessagePtr());
+  EXPECT_EQ(numNexthops, parsed.getNextHops().size());
+  for (const auto& nh : parsed.getNextHops()) {
+    ASSERT_TRUE(nh.getPushLabels().has_value());
+    EXPECT_EQ(std::vector<int32_t>({100, 200}), *nh.getPushLabels());
+  }
+  msg->setReturnStatus(0);
+}
+
 /**
  * This test intends to test the delayed looping of event-base. Request is
  * made before event loop is started. This will help ensuring that socket
@@ -696,6 +849,69 @@ TEST_F(NlMessageFixture, IpRouteMultipleNextHops) {
   EXPECT_FALSE(checkRouteInKernelRoutes(kernelRoutes, route));
 }
 
+TEST_F(NlMessageFixture, IpRouteNexthopGroup) {
+  // Add two nexthop objects and a group of them. Then add IPv6 route
+  // referring to the group by id instead of carrying its own nexthops
+  const uint32_t nhId1{101}, nhId2{102}, groupId{200};
+
+  uint32_t ackCount = getAckCount();
+  int ret = nlSock
+                ->addNexthop(
+                    nhId1,
+                    buildNextHop(
+                        folly::none,
+                        folly::none,
+                        folly::none,
+                        ipAddrY1V6,
+                        ifIndexX))
+                .get();
+  if (ret == -EOPNOTSUPP) {
+    LOG(WARNING) << "Kernel doesn't support nexthop objects. Skipping test";
+    return;
+  }
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(
+      0,
+      nlSock
+          ->addNexthop(
+              nhId2,
+              buildNextHop(
+                  folly::none, folly::none, folly::none, ipAddrY2V6, ifIndexX))
+          .get());
+  EXPECT_EQ(
+      0, nlSock->addNexthopGroup(groupId, {{nhId1, 1}, {nhId2, 2}}).get());
+
+  // Group with unknown member must be rejected
+  EXPECT_NE(0, nlSock->addNexthopGroup(groupId + 1, {{nhId1 + 10, 1}}).get());
+  EXPECT_EQ(1, getErrorCount());
+
+  fbnl::RouteBuilder rtBuilder;
+  auto route = rtBuilder.setDestination(ipPrefix1)
+                   .setProtocolId(kRouteProtoId)
+                   .setNextHopId(groupId)
+                   .setValid(true)
+                   .build();
+  EXPECT_EQ(0, nlSock->addRoute(route).get());
+  EXPECT_GE(getAckCount(), ackCount + 4);
+
+  // Kernel reports nexthop id along with the resolved nexthops
+  auto kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  ASSERT_EQ(1, kernelRoutes.size());
+  EXPECT_EQ(ipPrefix1, kernelRoutes.at(0).getDestination());
+  EXPECT_EQ(groupId, kernelRoutes.at(0).getNextHopId());
+  EXPECT_EQ(2, kernelRoutes.at(0).getNextHops().size());
+
+  // Deleting the group removes the route referring to it
+  EXPECT_EQ(0, nlSock->deleteNexthop(groupId).get());
+  kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  EXPECT_EQ(0, kernelRoutes.size());
+
+  EXPECT_EQ(0, nlSock->deleteNexthop(nhId1).get());
+  EXPECT_EQ(0, nlSock->deleteNexthop(nhId2).get());
+  EXPECT_NE(0, nlSock->deleteNexthop(nhId2).get());
+  EXPECT_EQ(2, getErrorCount());
+}
+
 TEST_F(NlMessageFixture, IPv4RouteSingleNextHop) {
   // Add IPv4 route with one next hop and no labels
   // outoing IF is vethTestY
@@ -838,14 +1054,14 @@ TEST_F(NlMessageFixture, IpRouteMultipleLabelNextHops) {
 }
 
 TEST_F(NlMessageFixture, MaxPayloadExceeded) {
-  // check for max payload handling. Add nexthops that exceeds payload size
-  // Should error out
+  // check for max payload handling. Add nexthops that exceeds maximum message
+  // size. Should error out
 
   std::vector<openr::fbnl::NextHop> paths;
   struct v6Addr addr6 {
     0
   };
-  for (uint32_t i = 0; i < 200; i++) {
+  for (uint32_t i = 0; i < 2000; i++) {
     addr6.u32_addr[0] = htonl(0xfe800000 + i);
     folly::IPAddress ipAddress = folly::IPAddress::fromBinary(folly::ByteRange(
         static_cast<const unsigned char*>(&addr6.u8_addr[0]), 16));
@@ -861,6 +1077,36 @@ TEST_F(NlMessageFixture, MaxPayloadExceeded) {
   EXPECT_EQ(ENOBUFS, nlSock->addRoute(route).get());
 }
 
+TEST_F(NlMessageFixture, WideEcmpLabelRoute) {
+  // label route with nexthops exceeding default payload size grows the
+  // message and gets programmed
+  std::vector<openr::fbnl::NextHop> paths;
+  struct v6Addr addr6 {
+    0
+  };
+  for (uint32_t i = 0; i < 200; i++) {
+    addr6.u32_addr[0] = htonl(0xfe800000 + i);
+    folly::IPAddress ipAddress = folly::IPAddress::fromBinary(folly::ByteRange(
+        static_cast<const unsigned char*>(&addr6.u8_addr[0]), 16));
+    paths.push_back(buildNextHop(
+        outLabel5,
+        folly::none,
+        thrift::MplsActionCode::PHP,
+        ipAddress,
+        ifIndexY));
+  }
+
+  auto route = buildRoute(kRouteProtoId, folly::none, inLabel4, paths);
+  EXPECT_EQ(0, nlSock->addRoute(route).get());
+
+  auto kernelRoutes = nlSock->getAllRoutes().get().value();
+  EXPECT_TRUE(checkRouteInKernelRoutes(kernelRoutes, route));
+
+  EXPECT_EQ(0, nlSock->deleteRoute(route).get());
+  kernelRoutes = nlSock->getAllRoutes().get().value();
+  EXPECT_FALSE(checkRouteInKernelRoutes(kernelRoutes, route));
+}
+
 TEST_F(NlMessageFixture, PopLabel) {
   // pop label to loopback i/f
 
@@ -1106,6 +1352,13 @@ TEST_F(NlMessageFixture, MultipleIpRoutesLabelNexthop) {
   // should have received acks with status = 0
   EXPECT_GE(getAckCount(), ackCount + count);
 
+  // Send window must have adapted within its bounds
+  auto counters = facebook::fb303::fbData->getCounters();
+  ASSERT_TRUE(counters.count("netlink.send_window.avg"));
+  EXPECT_LE(fbnl::kMinSendWindow, counters.at("netlink.send_window.avg"));
+  EXPECT_GE(fbnl::kMaxSendWindow, counters.at("netlink.send_window.avg"));
+  EXPECT_LT(0, counters.at("netlink.inflight.avg"));
+
   LOG(INFO) << "Getting all routes...";
   // verify Netlink getIPv6Routes at scale
   auto kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
@@ -1113,6 +1366,31 @@ TEST_F(NlMessageFixture, MultipleIpRoutesLabelNexthop) {
   EXPECT_EQ(kernelRoutes.size(), routes.size());
   EXPECT_EQ(findRoutesInKernelRoutes(kernelRoutes, routes), count);
 
+  // verify streaming of routes at scale
+  {
+    std::vector<fbnl::Route> streamedRoutes;
+    size_t numBatches{0};
+    fbnl::RouteBuilder filter;
+    filter.setDestination({folly::IPAddressV6("::"), 0})
+        .setProtocolId(kRouteProtoId)
+        .setType(RTN_UNSPEC);
+    auto status =
+        nlSock
+            ->getRoutesStream(
+                filter.build(),
+                [&](std::vector<fbnl::Route>&& batch) {
+                  EXPECT_GE(fbnl::kRouteStreamBatchSize, batch.size());
+                  ++numBatches;
+                  for (auto& route : batch) {
+                    streamedRoutes.emplace_back(std::move(route));
+                  }
+                })
+            .get();
+    EXPECT_EQ(0, status);
+    EXPECT_LE(count / fbnl::kRouteStreamBatchSize, numBatches);
+    EXPECT_EQ(findRoutesInKernelRoutes(streamedRoutes, routes), count);
+  }
+
   // delete routes
   ackCount = getAckCount();
   {
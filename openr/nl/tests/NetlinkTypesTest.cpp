@@ -348,6 +348,27 @@ TEST(NetlinkTypes, RouteOptionalParamTest) {
   EXPECT_EQ(RTN_UNICAST, route.getType());
 }
 
+TEST(NetlinkTypes, RouteNextHopIdTest) {
+  folly::CIDRNetwork dst{folly::IPAddress("fc00:cafe:3::3"), 128};
+  RouteBuilder rtbuilder;
+  auto route1 = rtbuilder.setDestination(dst)
+                    .setProtocolId(kProtocolId)
+                    .setNextHopId(10)
+                    .build();
+  EXPECT_TRUE(route1.getNextHopId().has_value());
+  EXPECT_EQ(10, route1.getNextHopId().value());
+  EXPECT_EQ(0, route1.getNextHops().size());
+
+  // Copy retains nexthop id. Routes with different id are not equal
+  auto route2 = route1;
+  EXPECT_EQ(route1, route2);
+  auto route3 = rtbuilder.setNextHopId(11).build();
+  EXPECT_FALSE(route1 == route3);
+
+  rtbuilder.reset();
+  EXPECT_FALSE(rtbuilder.getNextHopId().has_value());
+}
+
 TEST(NetlinkTypes, IfAddressMoveTest) {
   folly::CIDRNetwork prefix{folly::IPAddress("fc00:cafe:3::3"), 128};
   uint32_t flags = 0x01;
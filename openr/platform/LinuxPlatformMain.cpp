@@ -7,6 +7,7 @@
 
 #include <fbzmq/async/StopEventLoopSignalHandler.h>
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/Format.h>
 #include <folly/init/Init.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/system/ThreadName.h>
@@ -14,6 +15,7 @@
 #include <glog/logging.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
+#include <openr/nl/NetlinkLinkCache.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 #include <openr/platform/NetlinkFibHandler.h>
 #include <openr/platform/NetlinkSystemHandler.h>
@@ -35,6 +37,11 @@ DEFINE_bool(
     enable_netlink_system_handler,
     true,
     "If set, netlink system handler will be started");
+DEFINE_int32(
+    netlink_route_sockets,
+    1,
+    "Number of netlink sockets programming routes of the fib handler. With "
+    "more than one, IPv4, IPv6 and MPLS routes are spread over them");
 
 using openr::NetlinkFibHandler;
 using openr::NetlinkSystemHandler;
@@ -65,16 +72,23 @@ main(int argc, char** argv) {
   }));
   nlEvb->waitUntilRunning();
 
+  // Interface cache shared by handlers and event publisher
+  auto nlLinkCache =
+      std::make_shared<openr::fbnl::NetlinkLinkCache>(nlSock.get());
+
   // Create event publisher to handle event subscription
   auto eventPublisher = std::make_unique<openr::PlatformPublisher>(
       context,
       openr::PlatformPublisherUrl{FLAGS_platform_pub_url},
-      nlSock.get());
+      nlSock.get(),
+      nlLinkCache,
+      openr::Constants::kPlatformEventCoalesceWindow);
 
   apache::thrift::ThriftServer systemServiceServer;
   if (FLAGS_enable_netlink_system_handler) {
     // start NetlinkSystem thread
-    auto nlHandler = std::make_shared<NetlinkSystemHandler>(nlSock.get());
+    auto nlHandler =
+        std::make_shared<NetlinkSystemHandler>(nlSock.get(), nlLinkCache);
 
     auto systemThriftThread =
         std::thread([nlHandler, &systemServiceServer]() noexcept {
@@ -91,10 +105,32 @@ main(int argc, char** argv) {
     allThreads.emplace_back(std::move(systemThriftThread));
   }
 
+  // Additional sockets, each with its own event base, for programming routes
+  std::vector<std::unique_ptr<folly::EventBase>> routeEvbs;
+  std::vector<std::unique_ptr<openr::fbnl::NetlinkProtocolSocket>> routeSocks;
+  std::vector<openr::fbnl::NetlinkProtocolSocket*> routeSockPtrs;
+  if (FLAGS_enable_netlink_fib_handler and FLAGS_netlink_route_sockets > 1) {
+    for (int32_t i = 0; i < FLAGS_netlink_route_sockets; ++i) {
+      auto& evb = routeEvbs.emplace_back(std::make_unique<folly::EventBase>());
+      routeSocks.emplace_back(
+          std::make_unique<openr::fbnl::NetlinkProtocolSocket>(evb.get()));
+      routeSockPtrs.emplace_back(routeSocks.back().get());
+      allThreads.emplace_back(std::thread([evbPtr = evb.get(), i]() {
+        folly::setThreadName(folly::sformat("NetlinkRouteEvl{}", i));
+        evbPtr->loopForever();
+      }));
+      evb->waitUntilRunning();
+    }
+  }
+
   apache::thrift::ThriftServer linuxFibAgentServer;
   if (FLAGS_enable_netlink_fib_handler) {
     // start FibService thread
-    auto fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+    auto fibHandler = std::make_shared<NetlinkFibHandler>(
+        nlSock.get(),
+        openr::Constants::kPlatformRouteAuditInterval,
+        nlLinkCache,
+        routeSockPtrs);
 
     auto fibThriftThread = std::thread([fibHandler, &linuxFibAgentServer]() {
       folly::setThreadName("FibService");
@@ -116,6 +152,9 @@ main(int argc, char** argv) {
   LOG(INFO) << "Main event loop stopped.";
 
   nlEvb->terminateLoopSoon();
+  for (auto& evb : routeEvbs) {
+    evb->terminateLoopSoon();
+  }
 
   if (FLAGS_enable_netlink_fib_handler) {
     linuxFibAgentServer.stop();
@@ -130,6 +169,7 @@ main(int argc, char** argv) {
     }
   }
 
+  routeSocks.clear();
   if (nlSock) {
     nlSock.reset();
   }
@@ -10,11 +10,14 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <thread>
 #include <utility>
 
+#include <fb303/ServiceData.h>
 #include <folly/Format.h>
 #include <folly/gen/Base.h>
+#include <folly/hash/Hash.h>
 
 #include <openr/common/NetworkUtil.h>
 #include <openr/common/Util.h>
@@ -32,6 +35,15 @@ namespace {
 const uint8_t kMinRouteProtocolId = 17;
 const uint8_t kMaxRouteProtocolId = 253;
 
+// latency of route batches, from enqueue of netlink requests till all of
+// them are acked
+const std::string kRouteBatchLatencyCounter{"platform.route_batch_latency_ms"};
+const int64_t kRouteBatchLatencyBucketWidthMs{10};
+const int64_t kRouteBatchLatencyMaxMs{10000};
+
+// prefixes of counters exported by getCounters()
+const std::vector<std::string> kCounterPrefixes{"netlink.", "platform."};
+
 template <typename T>
 folly::SemiFuture<T>
 createSemiFutureWithClientIdError() {
@@ -40,14 +52,62 @@ createSemiFutureWithClientIdError() {
   return std::move(sf);
 }
 
+// Convert compact routes, throws PlatformError if they're malformed
+std::vector<thrift::UnicastRoute>
+fromCompactUnicastRoutes(const thrift::CompactUnicastRoutes& compactRoutes) {
+  try {
+    return createUnicastRoutesFromCompact(compactRoutes);
+  } catch (std::out_of_range const&) {
+    thrift::PlatformError error;
+    error.message = "Invalid nexthop index in compact unicast routes";
+    throw error;
+  }
+}
+
+// Filter for dumping unicast routes of the address family and protocol
+fbnl::Route
+buildUnicastRouteFilter(bool isV4, uint8_t protocolId) {
+  fbnl::RouteBuilder builder;
+  if (isV4) {
+    builder.setDestination({folly::IPAddressV4("0.0.0.0"), 0});
+  } else {
+    builder.setDestination({folly::IPAddressV6("::"), 0});
+  }
+  builder.setProtocolId(protocolId);
+  builder.setType(RTN_UNSPEC); // Explicitly set type to 0
+  return builder.build();
+}
+
 } // namespace
 
-NetlinkFibHandler::NetlinkFibHandler(fbnl::NetlinkProtocolSocket* nlSock)
+NetlinkFibHandler::NetlinkFibHandler(
+    fbnl::NetlinkProtocolSocket* nlSock,
+    std::chrono::milliseconds routeAuditInterval,
+    std::shared_ptr<fbnl::NetlinkLinkCache> linkCache,
+    std::vector<fbnl::NetlinkProtocolSocket*> routeSockets)
     : nlSock_(nlSock),
+      linkCache_(std::move(linkCache)),
+      routeSockets_(std::move(routeSockets)),
+      routeAuditInterval_(routeAuditInterval),
       startTime_(std::chrono::duration_cast<std::chrono::seconds>(
                      std::chrono::system_clock::now().time_since_epoch())
                      .count()) {
   CHECK_NOTNULL(nlSock);
+  facebook::fb303::fbData->addHistogram(
+      kRouteBatchLatencyCounter,
+      kRouteBatchLatencyBucketWidthMs,
+      0,
+      kRouteBatchLatencyMaxMs);
+  facebook::fb303::fbData->exportHistogramPercentile(
+      kRouteBatchLatencyCounter, 50, 95, 99);
+  facebook::fb303::fbData->addStatExportType(
+      "platform.route_batch_size", facebook::fb303::AVG);
+  facebook::fb303::fbData->addStatExportType(
+      "platform.route_batch_failures", facebook::fb303::SUM);
+  if (not linkCache_) {
+    linkCache_ = std::make_shared<fbnl::NetlinkLinkCache>(nlSock);
+  }
+
   // NOTE: This will mask off neighbor events publisher. It is okay because as
   // of now no one is using Neighbor Events.
   nlSock_->setNeighborEventCB([this](fbnl::Neighbor neighbor, bool) {
@@ -68,6 +128,35 @@ NetlinkFibHandler::NetlinkFibHandler(fbnl::NetlinkProtocolSocket* nlSock)
 
 NetlinkFibHandler::~NetlinkFibHandler() {}
 
+fbnl::NetlinkProtocolSocket*
+NetlinkFibHandler::getRouteSocket(uint8_t family) const {
+  if (routeSockets_.empty()) {
+    return nlSock_;
+  }
+  size_t index{0};
+  switch (family) {
+  case AF_INET:
+    index = 0;
+    break;
+  case AF_INET6:
+    index = 1;
+    break;
+  default:
+    index = 2; // AF_MPLS
+  }
+  return routeSockets_.at(index % routeSockets_.size());
+}
+
+folly::SemiFuture<int>
+NetlinkFibHandler::addRoute(const fbnl::Route& route) {
+  return getRouteSocket(route.getFamily())->addRoute(route);
+}
+
+folly::SemiFuture<int>
+NetlinkFibHandler::deleteRoute(const fbnl::Route& route) {
+  return getRouteSocket(route.getFamily())->deleteRoute(route);
+}
+
 std::optional<int16_t>
 NetlinkFibHandler::getProtocol(int16_t clientId) {
   auto ret = thrift::Platform_constants::clientIdtoProtocolId().find(clientId);
@@ -100,23 +189,93 @@ NetlinkFibHandler::protocolToPriority(const uint8_t protocol) {
   return openr::thrift::Platform_constants::kUnknowProtAdminDistance();
 }
 
+uint64_t
+NetlinkFibHandler::hashNextHops(
+    const std::vector<thrift::NextHopThrift>& nextHops) {
+  std::vector<uint64_t> hashes;
+  hashes.reserve(nextHops.size());
+  for (auto const& nextHop : nextHops) {
+    uint64_t hash = folly::hash::hash_combine(
+        nextHop.address.addr,
+        nextHop.address.ifName_ref().value_or(""),
+        nextHop.weight);
+    if (nextHop.mplsAction_ref().has_value()) {
+      auto const& mplsAction = nextHop.mplsAction_ref().value();
+      hash = folly::hash::hash_combine(
+          hash,
+          static_cast<int32_t>(mplsAction.action),
+          mplsAction.swapLabel_ref().value_or(-1));
+      if (mplsAction.pushLabels_ref().has_value()) {
+        auto const& pushLabels = mplsAction.pushLabels_ref().value();
+        hash = folly::hash::hash_range(
+            pushLabels.begin(), pushLabels.end(), hash);
+      }
+    }
+    hashes.emplace_back(hash);
+  }
+  // Nexthops are a set, make hash independent of their order
+  std::sort(hashes.begin(), hashes.end());
+  return folly::hash::hash_range(hashes.begin(), hashes.end());
+}
+
+folly::SemiFuture<folly::Unit>
+NetlinkFibHandler::invalidateShadowOnError(
+    folly::SemiFuture<folly::Unit> result, int16_t protocol) {
+  return std::move(result).defer(
+      [this, protocol](folly::Try<folly::Unit>&& res) {
+        if (res.hasException()) {
+          LOG(WARNING) << "Invalidating shadow of routes of protocol "
+                       << protocol << " on programming error";
+          routeShadows_.wlock()->erase(protocol);
+        }
+        return std::move(res).value();
+      });
+}
+
 folly::SemiFuture<folly::Unit>
 NetlinkFibHandler::collectAllResult(
     std::vector<folly::SemiFuture<int>>&& result,
     std::set<int> errorsToIgnore) {
+  const auto startTs = std::chrono::steady_clock::now();
+  facebook::fb303::fbData->addStatValue(
+      "platform.route_batch_size", result.size(), facebook::fb303::AVG);
   return folly::collectAll(std::move(result))
-      .deferValue([errorsToIgnore](std::vector<folly::Try<int>>&& retvals) {
+      .deferValue([errorsToIgnore,
+                   startTs](std::vector<folly::Try<int>>&& retvals) {
+        facebook::fb303::fbData->addHistogramValue(
+            kRouteBatchLatencyCounter,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTs)
+                .count());
         for (auto& retvalTry : retvals) {
+          if (retvalTry.hasException()) {
+            facebook::fb303::fbData->addStatValue(
+                "platform.route_batch_failures", 1, facebook::fb303::SUM);
+          }
           auto retval = std::abs(retvalTry.value()); // Throws exception if any
           if (retval == 0 or errorsToIgnore.count(retval)) {
             continue;
           }
+          facebook::fb303::fbData->addStatValue(
+              "platform.route_batch_failures", 1, facebook::fb303::SUM);
           throw fbnl::NlException("One or more netlink request failed", retval);
         }
         return folly::Unit();
       });
 }
 
+void
+NetlinkFibHandler::getCounters(std::map<std::string, int64_t>& counters) {
+  for (auto const& [key, value] : facebook::fb303::fbData->getCounters()) {
+    for (auto const& prefix : kCounterPrefixes) {
+      if (key.rfind(prefix, 0) == 0) {
+        counters.emplace(key, value);
+        break;
+      }
+    }
+  }
+}
+
 folly::SemiFuture<folly::Unit>
 NetlinkFibHandler::semifuture_addUnicastRoute(
     int16_t clientId, std::unique_ptr<thrift::UnicastRoute> route) {
@@ -145,12 +304,34 @@ NetlinkFibHandler::semifuture_addUnicastRoutes(
   LOG(INFO) << "Adding/Updating unicast routes of client "
             << getClientName(clientId) << ", numRoutes=" << routes->size();
 
+  // Update shadow of routes
+  {
+    auto shadows = routeShadows_.wlock();
+    auto& shadow = (*shadows)[protocol.value()];
+    for (auto const& route : *routes) {
+      shadow.routes[toIPNetwork(route.dest)] = hashNextHops(route.nextHops);
+    }
+  }
+
   // Add routes and return a collected semifuture
   std::vector<folly::SemiFuture<int>> result;
   for (auto& route : *routes) {
-    result.emplace_back(nlSock_->addRoute(buildRoute(route, protocol.value())));
+    result.emplace_back(addRoute(buildRoute(route, protocol.value())));
   }
-  return collectAllResult(std::move(result), {EEXIST});
+  return invalidateShadowOnError(
+      collectAllResult(std::move(result), {EEXIST}), protocol.value());
+}
+
+folly::SemiFuture<folly::Unit>
+NetlinkFibHandler::semifuture_addUnicastRoutesCompact(
+    int16_t clientId, std::unique_ptr<thrift::CompactUnicastRoutes> routes) {
+  auto unicastRoutes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+  try {
+    *unicastRoutes = fromCompactUnicastRoutes(*routes);
+  } catch (thrift::PlatformError const& error) {
+    return folly::makeSemiFuture<folly::Unit>(folly::exception_wrapper(error));
+  }
+  return semifuture_addUnicastRoutes(clientId, std::move(unicastRoutes));
 }
 
 folly::SemiFuture<folly::Unit>
@@ -164,15 +345,25 @@ NetlinkFibHandler::semifuture_deleteUnicastRoutes(
   LOG(INFO) << "Deleting unicast routes of client " << getClientName(clientId)
             << ", numRoutes=" << prefixes->size();
 
+  // Update shadow of routes
+  {
+    auto shadows = routeShadows_.wlock();
+    auto& shadow = (*shadows)[protocol.value()];
+    for (auto const& prefix : *prefixes) {
+      shadow.routes.erase(toIPNetwork(prefix));
+    }
+  }
+
   // Delete routes and return a collected semifuture
   std::vector<folly::SemiFuture<int>> result;
   for (auto& prefix : *prefixes) {
     fbnl::RouteBuilder rtBuilder;
     rtBuilder.setDestination(toIPNetwork(prefix));
     rtBuilder.setProtocolId(protocol.value());
-    result.emplace_back(nlSock_->deleteRoute(rtBuilder.build()));
+    result.emplace_back(deleteRoute(rtBuilder.build()));
   }
-  return collectAllResult(std::move(result), {ESRCH});
+  return invalidateShadowOnError(
+      collectAllResult(std::move(result), {ESRCH}), protocol.value());
 }
 
 folly::SemiFuture<folly::Unit>
@@ -189,8 +380,7 @@ NetlinkFibHandler::semifuture_addMplsRoutes(
   // Add routes and return a collected semifuture
   std::vector<folly::SemiFuture<int>> result;
   for (auto& route : *routes) {
-    result.emplace_back(
-        nlSock_->addRoute(buildMplsRoute(route, protocol.value())));
+    result.emplace_back(addRoute(buildMplsRoute(route, protocol.value())));
   }
   return collectAllResult(std::move(result), {EEXIST});
 }
@@ -212,7 +402,7 @@ NetlinkFibHandler::semifuture_deleteMplsRoutes(
     fbnl::RouteBuilder rtBuilder;
     rtBuilder.setMplsLabel(topLabel);
     rtBuilder.setProtocolId(protocol.value());
-    result.emplace_back(nlSock_->deleteRoute(rtBuilder.build()));
+    result.emplace_back(deleteRoute(rtBuilder.build()));
   }
   return collectAllResult(std::move(result), {ESRCH});
 }
@@ -229,62 +419,188 @@ NetlinkFibHandler::semifuture_syncFib(
   LOG(INFO) << "Syncing unicast FIB for client " << getClientName(clientId)
             << ", numRoutes=" << unicastRoutes->size();
 
-  // SemiFuture vector for collecting return values of all API calls
+  // Program difference against the shadow of routes if it is in sync with
+  // kernel, else against the routes in kernel
   std::vector<folly::SemiFuture<int>> result;
+  {
+    auto shadows = routeShadows_.wlock();
+    auto& shadow = (*shadows)[protocol.value()];
+    if (shadow.valid and
+        std::chrono::steady_clock::now() - shadow.lastAuditTs <
+            routeAuditInterval_) {
+      result = syncFibWithShadow(*unicastRoutes, protocol.value(), shadow);
+      // NOTE: Stale routes in shadow may not exist in kernel anymore. We're
+      // ignoring ESRCH error code as well
+      return invalidateShadowOnError(
+          collectAllResult(std::move(result), {EEXIST, ESRCH}),
+          protocol.value());
+    }
+  }
 
-  // Create set of existing route
-  // NOTE: Synchronous call to retrieve all the routes. We first make both
-  // requests to retrieve IPv4 and IPv6 routes. Subsequently we wait on them
-  // to complete and prepare the map of existing routes
-  std::unordered_map<folly::CIDRNetwork, fbnl::Route> existingRoutes;
+  LOG(INFO) << "Auditing unicast routes of client " << getClientName(clientId)
+            << " against kernel";
+  const auto auditTs = std::chrono::steady_clock::now();
+  result = syncFibWithKernel(*unicastRoutes, protocol.value());
   {
-    auto v4Routes = nlSock_->getIPv4Routes(protocol.value()).get();
-    auto v6Routes = nlSock_->getIPv6Routes(protocol.value()).get();
-    if (v4Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv4 routes", v4Routes.error());
+    auto shadows = routeShadows_.wlock();
+    auto& shadow = (*shadows)[protocol.value()];
+    shadow.routes.clear();
+    for (auto const& route : *unicastRoutes) {
+      shadow.routes[toIPNetwork(route.dest)] = hashNextHops(route.nextHops);
     }
-    if (v6Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv6 routes", v6Routes.error());
+    shadow.valid = true;
+    shadow.lastAuditTs = auditTs;
+  }
+
+  // Return collected result
+  // NOTE: We're ignoring EEXIST error code. ESRCH error code must not be
+  // raised because we're deleting route that already exist
+  return invalidateShadowOnError(
+      collectAllResult(std::move(result), {EEXIST}), protocol.value());
+}
+
+std::vector<folly::SemiFuture<int>>
+NetlinkFibHandler::syncFibWithShadow(
+    const std::vector<thrift::UnicastRoute>& unicastRoutes,
+    int16_t protocol,
+    RouteShadow& shadow) {
+  std::vector<folly::SemiFuture<int>> result;
+
+  // Go over the new routes. Add or update if nexthops differ from shadow
+  std::unordered_map<folly::CIDRNetwork, uint64_t> newRoutes;
+  newRoutes.reserve(unicastRoutes.size());
+  for (auto const& route : unicastRoutes) {
+    const auto prefix = toIPNetwork(route.dest);
+    const auto hash = hashNextHops(route.nextHops);
+    newRoutes[prefix] = hash;
+    auto it = shadow.routes.find(prefix);
+    if (it != shadow.routes.end() and it->second == hash) {
+      // Route is already programmed. SKIP
+      continue;
     }
-    for (auto& route : std::move(v4Routes).value()) {
-      const auto prefix = route.getDestination();
-      existingRoutes.emplace(prefix, std::move(route));
+    result.emplace_back(addRoute(buildRoute(route, protocol)));
+  }
+
+  // Go over the shadow to remove stale routes
+  for (auto const& [prefix, _] : shadow.routes) {
+    if (newRoutes.count(prefix)) {
+      continue;
+    }
+    fbnl::RouteBuilder rtBuilder;
+    rtBuilder.setDestination(prefix);
+    rtBuilder.setProtocolId(protocol);
+    result.emplace_back(deleteRoute(rtBuilder.build()));
+  }
+
+  VLOG(1) << "Synced " << unicastRoutes.size() << " unicast routes of "
+          << "protocol " << protocol << " against shadow with "
+          << result.size() << " updates";
+  shadow.routes = std::move(newRoutes);
+  return result;
+}
+
+std::vector<folly::SemiFuture<int>>
+NetlinkFibHandler::syncFibWithKernel(
+    const std::vector<thrift::UnicastRoute>& unicastRoutes, int16_t protocol) {
+  // SemiFuture vector for collecting return values of all API calls
+  std::vector<folly::SemiFuture<int>> result;
+
+  // Create map of new routes
+  std::unordered_map<folly::CIDRNetwork, fbnl::Route> newRoutes;
+  for (auto& route : unicastRoutes) {
+    newRoutes.insert_or_assign(
+        toIPNetwork(route.dest), buildRoute(route, protocol));
+  }
+
+  // Stream existing routes and compare them against new ones, instead of
+  // materializing the kernel table. Stale routes are deleted right away.
+  // NOTE: Callbacks of the requests are invoked in the event thread of their
+  // socket, possibly concurrently, and we wait for both of them to complete
+  // before proceeding
+  std::mutex streamMutex;
+  std::unordered_set<folly::CIDRNetwork> unchangedPrefixes;
+  auto streamCb = [&](std::vector<fbnl::Route>&& existingRoutes) {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    for (auto& nlRoute : existingRoutes) {
+      const auto& prefix = nlRoute.getDestination();
+      auto it = newRoutes.find(prefix);
+      if (it == newRoutes.end()) {
+        // Delete stale route
+        result.emplace_back(deleteRoute(nlRoute));
+      } else if (it->second == nlRoute) {
+        // Existing route is same as the one we're trying to add. SKIP
+        unchangedPrefixes.insert(prefix);
+      }
+    }
+  };
+  {
+    auto v4Status = getRouteSocket(AF_INET)->getRoutesStream(
+        buildUnicastRouteFilter(true, protocol), streamCb);
+    auto v6Status = getRouteSocket(AF_INET6)->getRoutesStream(
+        buildUnicastRouteFilter(false, protocol), streamCb);
+    const auto v4Ret = std::move(v4Status).get();
+    const auto v6Ret = std::move(v6Status).get();
+    if (v4Ret != 0) {
+      throw fbnl::NlException("Failed fetching IPv4 routes", v4Ret);
     }
-    for (auto& route : std::move(v6Routes).value()) {
-      const auto prefix = route.getDestination();
-      existingRoutes.emplace(prefix, std::move(route));
+    if (v6Ret != 0) {
+      throw fbnl::NlException("Failed fetching IPv6 routes", v6Ret);
     }
   }
 
   // Go over the new routes. Add or update
-  std::unordered_set<folly::CIDRNetwork> newPrefixes;
-  for (auto& route : *unicastRoutes) {
-    const auto network = toIPNetwork(route.dest);
-    newPrefixes.insert(network);
-    auto nlRoute = buildRoute(route, protocol.value());
-    auto it = existingRoutes.find(network);
-    if (it != existingRoutes.end() and it->second == nlRoute) {
-      // Existing route is same as the one we're trying to add. SKIP
+  for (auto& [prefix, nlRoute] : newRoutes) {
+    if (unchangedPrefixes.count(prefix)) {
       continue;
     }
     // Add new route or replace existing one
-    result.emplace_back(nlSock_->addRoute(nlRoute));
+    result.emplace_back(addRoute(nlRoute));
   }
 
-  // Go over the old routes to remove stale ones
-  for (auto& [prefix, nlRoute] : existingRoutes) {
-    if (newPrefixes.count(prefix)) {
-      // not a stale route
-      continue;
-    }
-    // Delete stale route
-    result.emplace_back(nlSock_->deleteRoute(nlRoute));
+  return result;
+}
+
+folly::SemiFuture<folly::Unit>
+NetlinkFibHandler::semifuture_syncFibCompact(
+    int16_t clientId,
+    std::unique_ptr<thrift::CompactUnicastRoutes> routes,
+    int64_t syncId,
+    bool isLastChunk) {
+  if (not getProtocol(clientId).has_value()) {
+    return createSemiFutureWithClientIdError<folly::Unit>();
   }
 
-  // Return collected result
-  // NOTE: We're ignoring EEXIST error code. ESRCH error code must not be
-  // raised because we're deleting route that already exist
-  return collectAllResult(std::move(result), {EEXIST});
+  std::vector<thrift::UnicastRoute> chunk;
+  try {
+    chunk = fromCompactUnicastRoutes(*routes);
+  } catch (thrift::PlatformError const& error) {
+    pendingCompactSyncs_.wlock()->erase(clientId);
+    return folly::makeSemiFuture<folly::Unit>(folly::exception_wrapper(error));
+  }
+
+  // Accumulate routes of the sync, chunk of a new sync abandons previous one
+  auto unicastRoutes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+  {
+    auto pendingSyncs = pendingCompactSyncs_.wlock();
+    auto& pendingSync = (*pendingSyncs)[clientId];
+    if (pendingSync.syncId != syncId) {
+      pendingSync.syncId = syncId;
+      pendingSync.routes.clear();
+    }
+    pendingSync.routes.insert(
+        pendingSync.routes.end(),
+        std::make_move_iterator(chunk.begin()),
+        std::make_move_iterator(chunk.end()));
+    VLOG(2) << "Received chunk of sync " << syncId << " for client "
+            << getClientName(clientId) << ", numRoutes=" << chunk.size()
+            << ", isLastChunk=" << isLastChunk;
+    if (not isLastChunk) {
+      return folly::makeSemiFuture();
+    }
+    *unicastRoutes = std::move(pendingSync.routes);
+    pendingSyncs->erase(clientId);
+  }
+  return semifuture_syncFib(clientId, std::move(unicastRoutes));
 }
 
 folly::SemiFuture<folly::Unit>
@@ -305,7 +621,8 @@ NetlinkFibHandler::semifuture_syncMplsFib(
   // Create set of existing route
   // NOTE: Synchronous call to retrieve all the routes
   std::unordered_map<int32_t, fbnl::Route> existingRoutes;
-  auto nlRoutes = nlSock_->getMplsRoutes(protocol.value()).get();
+  auto nlRoutes =
+      getRouteSocket(AF_MPLS)->getMplsRoutes(protocol.value()).get();
   if (nlRoutes.hasError()) {
     throw fbnl::NlException("Failed fetching IPv6 routes", nlRoutes.error());
   }
@@ -325,7 +642,7 @@ NetlinkFibHandler::semifuture_syncMplsFib(
       continue;
     }
     // Add new route or replace existing one
-    result.emplace_back(nlSock_->addRoute(nlRoute));
+    result.emplace_back(addRoute(nlRoute));
   }
 
   // Go over the old routes to remove stale ones
@@ -335,7 +652,7 @@ NetlinkFibHandler::semifuture_syncMplsFib(
       continue;
     }
     // Delete stale route
-    result.emplace_back(nlSock_->deleteRoute(nlRoute));
+    result.emplace_back(deleteRoute(nlRoute));
   }
 
   // Return collected result
@@ -357,6 +674,12 @@ NetlinkFibHandler::getSwitchRunState() {
   return openr::thrift::SwitchRunState::CONFIGURED;
 }
 
+void
+NetlinkFibHandler::getSupportedFeatures(
+    std::vector<openr::thrift::FibFeature>& features) {
+  features = {openr::thrift::FibFeature::COMPACT_UNICAST_ROUTES};
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<openr::thrift::UnicastRoute>>>
 NetlinkFibHandler::semifuture_getRouteTableByClient(int16_t clientId) {
   const auto protocol = getProtocol(clientId);
@@ -367,28 +690,36 @@ NetlinkFibHandler::semifuture_getRouteTableByClient(int16_t clientId) {
   CHECK(protocol.has_value());
   LOG(INFO) << "Get unicast routes for client " << getClientName(clientId);
 
-  auto v4Routes = nlSock_->getIPv4Routes(protocol.value());
-  auto v6Routes = nlSock_->getIPv6Routes(protocol.value());
-  return folly::collectAll(std::move(v4Routes), std::move(v6Routes))
+  // Convert routes to thrift as they're streamed from kernel.
+  // NOTE: Callbacks of the requests are invoked in the event thread of their
+  // socket, possibly concurrently
+  auto routes = std::make_shared<
+      folly::Synchronized<std::vector<thrift::UnicastRoute>>>();
+  auto streamCb = [this, routes](std::vector<fbnl::Route>&& nlRoutes) {
+    auto lockedRoutes = routes->wlock();
+    lockedRoutes->reserve(lockedRoutes->size() + nlRoutes.size());
+    for (auto& nlRoute : nlRoutes) {
+      thrift::UnicastRoute route;
+      route.dest = toIpPrefix(nlRoute.getDestination());
+      route.nextHops = toThriftNextHops(nlRoute.getNextHops());
+      lockedRoutes->emplace_back(std::move(route));
+    }
+  };
+  auto v4Status = getRouteSocket(AF_INET)->getRoutesStream(
+      buildUnicastRouteFilter(true, protocol.value()), streamCb);
+  auto v6Status = getRouteSocket(AF_INET6)->getRoutesStream(
+      buildUnicastRouteFilter(false, protocol.value()), streamCb);
+  return folly::collectAll(std::move(v4Status), std::move(v6Status))
       .deferValue(
-          [this](std::tuple<
-                 folly::Try<folly::Expected<std::vector<fbnl::Route>, int>>,
-                 folly::Try<folly::Expected<std::vector<fbnl::Route>, int>>>&&
-                     res) {
-            auto routes = std::make_unique<std::vector<thrift::UnicastRoute>>();
-            for (auto& nlRoutes : {std::get<0>(res), std::get<1>(res)}) {
-              if (nlRoutes.value().hasError()) {
+          [routes](std::tuple<folly::Try<int>, folly::Try<int>>&& res) {
+            for (auto& status : {std::get<0>(res), std::get<1>(res)}) {
+              if (status.value() != 0) {
                 throw fbnl::NlException(
-                    "Failed fetching routes", nlRoutes.value().error());
-              }
-              for (auto& nlRoute : nlRoutes.value().value()) {
-                thrift::UnicastRoute route;
-                route.dest = toIpPrefix(nlRoute.getDestination());
-                route.nextHops = toThriftNextHops(nlRoute.getNextHops());
-                routes->emplace_back(std::move(route));
+                    "Failed fetching routes", status.value());
               }
             }
-            return routes;
+            return std::make_unique<std::vector<thrift::UnicastRoute>>(
+                std::move(*routes->wlock()));
           });
 }
 
@@ -402,7 +733,8 @@ NetlinkFibHandler::semifuture_getMplsRouteTableByClient(int16_t clientId) {
   CHECK(protocol.has_value());
   LOG(INFO) << "Get mpls routes for client " << getClientName(clientId);
 
-  return nlSock_->getMplsRoutes(protocol.value())
+  return getRouteSocket(AF_MPLS)
+      ->getMplsRoutes(protocol.value())
       .deferValue(
           [this](folly::Expected<std::vector<fbnl::Route>, int>&& nlRoutes) {
             if (nlRoutes.hasError()) {
@@ -509,7 +841,9 @@ NetlinkFibHandler::buildNextHop(
     }
     nhBuilder.setGateway(toIPAddress(nh.address));
     buildMplsAction(nhBuilder, nh);
-    nhBuilder.setWeight(nh.weight);
+    // kernel nexthop weight is 8 bit, larger weights saturate
+    nhBuilder.setWeight(std::clamp<int32_t>(
+        nh.weight, 0, std::numeric_limits<uint8_t>::max()));
     rtBuilder.addNextHop(nhBuilder.build());
     nhBuilder.reset();
   }
@@ -560,83 +894,17 @@ NetlinkFibHandler::buildMplsRoute(
 
 std::optional<int>
 NetlinkFibHandler::getIfIndex(const std::string& ifName) {
-  // Lambda function to lookup ifName in cache
-  auto getCachedIndex = [this, &ifName]() -> std::optional<int> {
-    auto cache = ifNameToIndex_.rlock();
-    auto it = cache->find(ifName);
-    if (it != cache->end()) {
-      return it->second;
-    }
-    return std::nullopt;
-  };
-
-  // Lookup in cache. Return if exists
-  auto maybeIndex = getCachedIndex();
-  if (maybeIndex.has_value()) {
-    return maybeIndex;
-  }
-
-  // Update cache and return cached index
-  initializeInterfaceCache();
-  return getCachedIndex();
+  return linkCache_->getIfIndex(ifName);
 }
 
 std::optional<std::string>
 NetlinkFibHandler::getIfName(const int ifIndex) {
-  // Lambda function to lookup ifIndex in cache
-  auto getCachedName = [this, ifIndex]() -> std::optional<std::string> {
-    auto cache = ifIndexToName_.rlock();
-    auto it = cache->find(ifIndex);
-    if (it != cache->end()) {
-      return it->second;
-    }
-    return std::nullopt;
-  };
-
-  // Lookup in cache. Return if exists
-  auto maybeName = getCachedName();
-  if (maybeName.has_value()) {
-    return maybeName;
-  }
-
-  // Update cache and return cached index
-  initializeInterfaceCache();
-  return getCachedName();
+  return linkCache_->getIfName(ifIndex);
 }
 
 std::optional<int>
 NetlinkFibHandler::getLoopbackIfIndex() {
-  auto index = loopbackIfIndex_.load();
-  if (index < 0) {
-    initializeInterfaceCache();
-    index = loopbackIfIndex_.load();
-  }
-
-  if (index < 0) {
-    return std::nullopt;
-  }
-  return index;
-}
-
-void
-NetlinkFibHandler::initializeInterfaceCache() noexcept {
-  auto links = nlSock_->getAllLinks().get().value();
-
-  // Acquire locks on the cache
-  auto lockedIfNameToIndex = ifNameToIndex_.wlock();
-  auto lockedIfIndexToName = ifIndexToName_.wlock();
-
-  // NOTE: We don't clear cache instead override entries
-  for (auto const& link : links) {
-    // Update name <-> index mappings
-    (*lockedIfNameToIndex)[link.getLinkName()] = link.getIfIndex();
-    (*lockedIfIndexToName)[link.getIfIndex()] = link.getLinkName();
-
-    // Update loopbackIfIndex_
-    if (link.isLoopback()) {
-      loopbackIfIndex_.store(link.getIfIndex());
-    }
-  }
+  return linkCache_->getLoopbackIfIndex();
 }
 
 void
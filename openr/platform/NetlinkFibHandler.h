@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -15,15 +16,18 @@
 
 #include <fbzmq/async/ZmqTimeout.h>
 #include <folly/Expected.h>
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSocket.h>
 
+#include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/FibService.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/NeighborListenerClientForFibagent.h>
+#include <openr/nl/NetlinkLinkCache.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 #include <openr/nl/NetlinkTypes.h>
 
@@ -35,16 +39,34 @@ namespace openr {
  * - Translates netlink representation of routes to thrift for get* queries
  * - All APIs exposed are asynchronous. Sync API retries the existing routing
  *   state in synchronous way and program changes asynchrnously.
+ * - Unicast routes programmed by every protocol are shadowed (prefix -> hash
+ *   of nexthops). Sync API programs the difference against the shadow, and
+ *   retrieves the routing state from kernel only if shadow is not in sync
+ *   (initially or after a programming error) or on a periodic audit.
  */
 class NetlinkFibHandler : public thrift::FibServiceSvIf {
  public:
-  explicit NetlinkFibHandler(fbnl::NetlinkProtocolSocket* nlSock);
+  /**
+   * Interface mapping is looked up in `linkCache`, which is shared with other
+   * handlers of the socket. Handler creates its own if none is passed.
+   *
+   * Routes are programmed and retrieved through `nlSock`, unless
+   * `routeSockets` are passed. Then IPv4, IPv6 and MPLS routes are assigned
+   * to them round robin, so that programming of one address family doesn't
+   * queue behind the in-flight requests of another. Each socket should run
+   * on its own event base.
+   */
+  explicit NetlinkFibHandler(
+      fbnl::NetlinkProtocolSocket* nlSock,
+      std::chrono::milliseconds routeAuditInterval =
+          Constants::kPlatformRouteAuditInterval,
+      std::shared_ptr<fbnl::NetlinkLinkCache> linkCache = nullptr,
+      std::vector<fbnl::NetlinkProtocolSocket*> routeSockets = {});
   ~NetlinkFibHandler() override;
 
-  void
-  getCounters(std::map<std::string, int64_t>& /* counters */) override {
-    // No counters. Return empty
-  }
+  // Netlink and platform counters, e.g. kernel programming latency of route
+  // batches and netlink requests, and netlink failures per errno
+  void getCounters(std::map<std::string, int64_t>& counters) override;
 
   folly::SemiFuture<folly::Unit> semifuture_addUnicastRoute(
       int16_t clientId, std::unique_ptr<thrift::UnicastRoute> route) override;
@@ -60,6 +82,10 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
       int16_t clientId,
       std::unique_ptr<std::vector<thrift::IpPrefix>> prefixes) override;
 
+  folly::SemiFuture<folly::Unit> semifuture_addUnicastRoutesCompact(
+      int16_t clientId,
+      std::unique_ptr<thrift::CompactUnicastRoutes> routes) override;
+
   folly::SemiFuture<folly::Unit> semifuture_addMplsRoutes(
       int16_t clientId,
       std::unique_ptr<std::vector<thrift::MplsRoute>> mplsRoute) override;
@@ -72,6 +98,12 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
       int16_t clientId,
       std::unique_ptr<std::vector<thrift::UnicastRoute>> routes) override;
 
+  folly::SemiFuture<folly::Unit> semifuture_syncFibCompact(
+      int16_t clientId,
+      std::unique_ptr<thrift::CompactUnicastRoutes> routes,
+      int64_t syncId,
+      bool isLastChunk) override;
+
   folly::SemiFuture<folly::Unit> semifuture_syncMplsFib(
       int16_t clientId,
       std::unique_ptr<std::vector<thrift::MplsRoute>> routes) override;
@@ -88,6 +120,9 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
 
   openr::thrift::SwitchRunState getSwitchRunState() override;
 
+  void getSupportedFeatures(
+      std::vector<openr::thrift::FibFeature>& features) override;
+
   folly::SemiFuture<std::unique_ptr<std::vector<openr::thrift::UnicastRoute>>>
   semifuture_getRouteTableByClient(int16_t clientId) override;
 
@@ -109,9 +144,16 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
    */
   static uint8_t protocolToPriority(const uint8_t protocol);
 
+  /**
+   * Compact hash of nexthops of a unicast route, independent of their order
+   */
+  static uint64_t hashNextHops(
+      const std::vector<thrift::NextHopThrift>& nextHops);
+
   /**
    * Convert list<SemiFuture<int>> to SemiFuture<Unit>
-   * The first error if any will be converted to NlException
+   * The first error if any will be converted to NlException. Latency of the
+   * batch, from now till all requests are acked, is recorded
    */
   static folly::SemiFuture<folly::Unit> collectAllResult(
       std::vector<folly::SemiFuture<int>>&& result,
@@ -162,11 +204,7 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
 
   /**
    * APIs to convert ifName <-> ifIndex for thrift <-> netlink route conversions
-   * Returns `folly::none` if can't find the mapping.
-   *
-   * Cache is used for optimized response to subsequent query for same interface
-   * name or index. Entries in cache are lazily initialized on first instance by
-   * querying `getAllLinks`.
+   * Mapping is looked up in shared link cache, see `fbnl::NetlinkLinkCache`.
    *
    * Returns `std::nullopt` if mapping is not found
    */
@@ -175,13 +213,16 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
 
   /**
    * Get interface index of loopback interface. Lazily query it from netlink
-   * by querying `getAllLinks`
+   * by querying `getAllLinks` if not known from cache
    */
   std::optional<int> getLoopbackIfIndex();
 
   // Used to interact with Linux kernel routing table
   fbnl::NetlinkProtocolSocket* nlSock_{nullptr};
 
+  // Interface index <-> name mapping, shared with other handlers
+  std::shared_ptr<fbnl::NetlinkLinkCache> linkCache_;
+
  private:
   /**
    * Disable copy & assignment operators
@@ -190,17 +231,69 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf {
   NetlinkFibHandler& operator=(const NetlinkFibHandler&) = delete;
 
   /**
-   * Initialize cache related to interfaces. Especially loopbackIfIndex_
-   * and interface name <-> index mappings
+   * Shadow of unicast routes programmed by a protocol. Shadow is valid only
+   * once it has been synced against kernel.
+   */
+  struct RouteShadow {
+    // prefix -> hash of nexthops
+    std::unordered_map<folly::CIDRNetwork, uint64_t> routes;
+    bool valid{false};
+    std::chrono::steady_clock::time_point lastAuditTs;
+  };
+
+  /**
+   * Socket programming routes of the address family (AF_INET, AF_INET6 or
+   * AF_MPLS)
    */
-  void initializeInterfaceCache() noexcept;
+  fbnl::NetlinkProtocolSocket* getRouteSocket(uint8_t family) const;
+
+  /**
+   * Add or delete route through the socket of its address family
+   */
+  folly::SemiFuture<int> addRoute(const fbnl::Route& route);
+  folly::SemiFuture<int> deleteRoute(const fbnl::Route& route);
+
+  /**
+   * Program difference of the routes against the shadow. Shadow is updated
+   * to the new routes.
+   */
+  std::vector<folly::SemiFuture<int>> syncFibWithShadow(
+      const std::vector<thrift::UnicastRoute>& unicastRoutes,
+      int16_t protocol,
+      RouteShadow& shadow);
+
+  /**
+   * Program difference of the routes against the routes in kernel
+   */
+  std::vector<folly::SemiFuture<int>> syncFibWithKernel(
+      const std::vector<thrift::UnicastRoute>& unicastRoutes,
+      int16_t protocol);
+
+  /**
+   * Invalidate shadow of the protocol if result has an error, as state of
+   * kernel isn't known anymore. Next sync will retrieve it from kernel.
+   */
+  folly::SemiFuture<folly::Unit> invalidateShadowOnError(
+      folly::SemiFuture<folly::Unit> result, int16_t protocol);
+
+  // Routes received so far of a chunked syncFibCompact
+  struct PendingCompactSync {
+    int64_t syncId{0};
+    std::vector<thrift::UnicastRoute> routes;
+  };
+
+  // Sockets programming routes, see getRouteSocket
+  const std::vector<fbnl::NetlinkProtocolSocket*> routeSockets_;
+
+  // Interval at which shadow is audited against kernel on syncFib
+  const std::chrono::milliseconds routeAuditInterval_;
 
-  // Cache for interface index <-> name mapping
-  folly::Synchronized<std::unordered_map<std::string, int>> ifNameToIndex_;
-  folly::Synchronized<std::unordered_map<int, std::string>> ifIndexToName_;
+  // protocol -> shadow of its unicast routes
+  folly::Synchronized<std::unordered_map<int16_t, RouteShadow>> routeShadows_;
 
-  // Loopback interface index cache. Initialized to negative number
-  std::atomic<int> loopbackIfIndex_{-1};
+  // clientId -> in progress syncFibCompact
+  folly::Synchronized<std::unordered_map<int16_t, PendingCompactSync>>
+      pendingCompactSyncs_;
 
   // Time when service started, in number of seconds, since epoch
   const int64_t startTime_{0};
@@ -44,9 +44,14 @@ toString(std::vector<thrift::IpPrefix> const& prefixes) {
 
 } // namespace
 
-NetlinkSystemHandler::NetlinkSystemHandler(fbnl::NetlinkProtocolSocket* nlSock)
-    : nlSock_(nlSock) {
+NetlinkSystemHandler::NetlinkSystemHandler(
+    fbnl::NetlinkProtocolSocket* nlSock,
+    std::shared_ptr<fbnl::NetlinkLinkCache> linkCache)
+    : nlSock_(nlSock), linkCache_(std::move(linkCache)) {
   CHECK(nlSock);
+  if (not linkCache_) {
+    linkCache_ = std::make_shared<fbnl::NetlinkLinkCache>(nlSock);
+  }
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::Link>>>
@@ -246,13 +251,7 @@ NetlinkSystemHandler::semifuture_syncIfaceAddresses(
 
 std::optional<int>
 NetlinkSystemHandler::getIfIndex(const std::string& ifName) {
-  auto links = nlSock_->getAllLinks().get().value();
-  for (auto& link : links) {
-    if (link.getLinkName() == ifName) {
-      return link.getIfIndex();
-    }
-  }
-  return std::nullopt;
+  return linkCache_->getIfIndex(ifName);
 }
 
 } // namespace openr
@@ -23,6 +23,7 @@
 
 #include <openr/if/gen-cpp2/Platform_types.h>
 #include <openr/if/gen-cpp2/SystemService.h>
+#include <openr/nl/NetlinkLinkCache.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 
 namespace openr {
@@ -36,7 +37,13 @@ namespace openr {
 
 class NetlinkSystemHandler final : public thrift::SystemServiceSvIf {
  public:
-  explicit NetlinkSystemHandler(fbnl::NetlinkProtocolSocket* nlSock);
+  /**
+   * Interface index is looked up in `linkCache`, which is shared with other
+   * handlers of the socket. Handler creates its own if none is passed.
+   */
+  explicit NetlinkSystemHandler(
+      fbnl::NetlinkProtocolSocket* nlSock,
+      std::shared_ptr<fbnl::NetlinkLinkCache> linkCache = nullptr);
 
   NetlinkSystemHandler(const NetlinkSystemHandler&) = delete;
   NetlinkSystemHandler& operator=(const NetlinkSystemHandler&) = delete;
@@ -74,13 +81,15 @@ class NetlinkSystemHandler final : public thrift::SystemServiceSvIf {
       const std::vector<thrift::IpPrefix>& addrs);
 
   /**
-   * Synchronous API to query interface index from kernel.
-   * NOTE: We intentionally don't use cache to optimize this call as APIs of
-   * this handlers for add/remove/sync addresses are rarely invoked.
+   * Synchronous API to lookup interface index in link cache, querying kernel
+   * on cache miss.
    */
   std::optional<int> getIfIndex(const std::string& ifName);
 
   fbnl::NetlinkProtocolSocket* nlSock_{nullptr};
+
+  // Interface index <-> name mapping, shared with other handlers
+  std::shared_ptr<fbnl::NetlinkLinkCache> linkCache_;
 };
 
 } // namespace openr
@@ -7,18 +7,24 @@
 
 #include "PlatformPublisher.h"
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <glog/logging.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
 
 #include <openr/common/NetworkUtil.h>
 
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
 PlatformPublisher::PlatformPublisher(
     fbzmq::Context& context,
     const PlatformPublisherUrl& platformPubUrl,
-    fbnl::NetlinkProtocolSocket* nlSock) {
+    fbnl::NetlinkProtocolSocket* nlSock,
+    std::shared_ptr<fbnl::NetlinkLinkCache> linkCache,
+    std::chrono::milliseconds coalesceWindow)
+    : linkCache_(std::move(linkCache)), coalesceWindow_(coalesceWindow) {
   CHECK_NOTNULL(nlSock);
 
   // Initialize ZMQ sockets
@@ -34,31 +40,35 @@ PlatformPublisher::PlatformPublisher(
                << platformPub.error();
   }
 
-  // Initialize interface index to name mapping
-  auto nlLinks = nlSock->getAllLinks().get();
-  for (auto& link : nlLinks.value()) {
-    ifIndexToName_.emplace(link.getIfIndex(), link.getLinkName());
+  // Initialize interface index to name mapping. It can't be initialized
+  // lazily on address events, as they're received in netlink event thread
+  if (not linkCache_) {
+    linkCache_ = std::make_shared<fbnl::NetlinkLinkCache>(nlSock);
+  }
+  linkCache_->refresh();
+
+  if (coalesceWindow_.count() > 0) {
+    CHECK_NOTNULL(nlSock->getEvb());
+    coalesceTimer_ = folly::AsyncTimeout::make(
+        *nlSock->getEvb(), [this]() noexcept { publishPendingEvents(); });
   }
 
   // Attach callbacks for link events
   nlSock->setLinkEventCB([this](fbnl::Link link, bool /* ignore */) {
-    // Cache interface index name mapping
-    ifIndexToName_[link.getIfIndex()] = link.getLinkName();
-
     thrift::LinkEntry event;
     event.ifIndex = link.getIfIndex();
     event.ifName = link.getLinkName();
     event.isUp = link.isUp();
     event.weight = Constants::kDefaultAdjWeight;
     LOG(INFO) << "Link Event: " << link.str();
-    publishLinkEvent(event);
+    queueLinkEvent(std::move(event));
   });
 
   // Attach callbacks for address events
   nlSock->setAddrEventCB([this](fbnl::IfAddress addr, bool /* ignore */) {
     // Check for interface name
-    auto it = ifIndexToName_.find(addr.getIfIndex());
-    if (it == ifIndexToName_.end()) {
+    auto ifName = linkCache_->findIfName(addr.getIfIndex());
+    if (not ifName.has_value()) {
       LOG(ERROR) << "Address event for unknown interface " << addr.str();
       return;
     }
@@ -70,11 +80,11 @@ PlatformPublisher::PlatformPublisher(
     }
 
     thrift::AddrEntry event;
-    event.ifName = it->second;
+    event.ifName = std::move(ifName).value();
     event.ipPrefix = toIpPrefix(addr.getPrefix().value());
     event.isValid = addr.isValid();
     LOG(INFO) << "Address Event: " << addr.str();
-    publishAddrEvent(event);
+    queueAddrEvent(std::move(event));
   });
 }
 
@@ -85,6 +95,7 @@ PlatformPublisher::publishLinkEvent(const thrift::LinkEntry& link) {
   thrift::PlatformEvent msg;
   msg.eventType = thrift::PlatformEventType::LINK_EVENT;
   msg.eventData = fbzmq::util::writeThriftObjStr(link, serializer_);
+  msg.seqNum_ref() = ++linkEventSeqNum_;
   publishPlatformEvent(msg);
 }
 
@@ -95,9 +106,74 @@ PlatformPublisher::publishAddrEvent(const thrift::AddrEntry& address) {
   thrift::PlatformEvent msg;
   msg.eventType = thrift::PlatformEventType::ADDRESS_EVENT;
   msg.eventData = fbzmq::util::writeThriftObjStr(address, serializer_);
+  msg.seqNum_ref() = ++addrEventSeqNum_;
   publishPlatformEvent(msg);
 }
 
+void
+PlatformPublisher::queueLinkEvent(thrift::LinkEntry link) {
+  if (not coalesceTimer_) {
+    publishLinkEvent(link);
+    return;
+  }
+  auto ifName = link.ifName;
+  pendingLinkEvents_.insert_or_assign(std::move(ifName), std::move(link));
+  if (not coalesceTimer_->isScheduled()) {
+    coalesceTimer_->scheduleTimeout(coalesceWindow_);
+  }
+}
+
+void
+PlatformPublisher::queueAddrEvent(thrift::AddrEntry address) {
+  if (not coalesceTimer_) {
+    publishAddrEvent(address);
+    return;
+  }
+  auto key = std::make_pair(address.ifName, address.ipPrefix);
+  pendingAddrEvents_.insert_or_assign(std::move(key), std::move(address));
+  if (not coalesceTimer_->isScheduled()) {
+    coalesceTimer_->scheduleTimeout(coalesceWindow_);
+  }
+}
+
+void
+PlatformPublisher::publishPendingEvents() {
+  fb303::fbData->addStatValue(
+      "platform.publisher.coalesced_events",
+      pendingLinkEvents_.size() + pendingAddrEvents_.size(),
+      fb303::SUM);
+
+  // Publish link events first, so that addresses are applied to interfaces
+  // in their latest state
+  if (not pendingLinkEvents_.empty()) {
+    thrift::PlatformEvent msg;
+    msg.eventType = thrift::PlatformEventType::LINK_EVENT;
+    std::vector<std::string> eventDataBatch;
+    for (auto const& [_, link] : pendingLinkEvents_) {
+      eventDataBatch.emplace_back(
+          fbzmq::util::writeThriftObjStr(link, serializer_));
+    }
+    msg.eventDataBatch_ref() = std::move(eventDataBatch);
+    msg.seqNum_ref() = ++linkEventSeqNum_;
+    publishPlatformEvent(msg);
+    pendingLinkEvents_.clear();
+  }
+
+  if (not pendingAddrEvents_.empty()) {
+    thrift::PlatformEvent msg;
+    msg.eventType = thrift::PlatformEventType::ADDRESS_EVENT;
+    std::vector<std::string> eventDataBatch;
+    for (auto const& [_, address] : pendingAddrEvents_) {
+      eventDataBatch.emplace_back(
+          fbzmq::util::writeThriftObjStr(address, serializer_));
+    }
+    msg.eventDataBatch_ref() = std::move(eventDataBatch);
+    msg.seqNum_ref() = ++addrEventSeqNum_;
+    publishPlatformEvent(msg);
+    pendingAddrEvents_.clear();
+  }
+}
+
 void
 PlatformPublisher::publishPlatformEvent(const thrift::PlatformEvent& msg) {
   thrift::PlatformEventType eventType = msg.eventType;
@@ -10,15 +10,19 @@
 #include <syslog.h>
 #include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Types.h>
 #include <openr/if/gen-cpp2/Platform_types.h>
+#include <openr/nl/NetlinkLinkCache.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 #include <openr/nl/NetlinkTypes.h>
 
@@ -29,13 +33,24 @@ namespace openr {
  * message passing mechanism. Event will be sent over Zmq PUB socket which
  * OpenR modules can subscribe through SUB socket. The subscriber modules is
  * LinkMonitor from Open/R side.
+ *
+ * With non-zero coalesce window, events received within the window after the
+ * first one are coalesced (latest state of an interface or address wins) and
+ * published as a single batch per event type, in event base of the socket.
  */
 class PlatformPublisher final {
  public:
+  /**
+   * Interface names of address events are resolved with `linkCache`, which
+   * is shared with handlers of the socket. Publisher creates its own if none
+   * is passed.
+   */
   PlatformPublisher(
       fbzmq::Context& context,
       const PlatformPublisherUrl& platformPubUrl,
-      fbnl::NetlinkProtocolSocket* nlSock);
+      fbnl::NetlinkProtocolSocket* nlSock,
+      std::shared_ptr<fbnl::NetlinkLinkCache> linkCache = nullptr,
+      std::chrono::milliseconds coalesceWindow = std::chrono::milliseconds(0));
 
   ~PlatformPublisher() = default;
 
@@ -51,11 +66,33 @@ class PlatformPublisher final {
   void publishAddrEvent(const thrift::AddrEntry& address);
   void publishPlatformEvent(const thrift::PlatformEvent& msg);
 
+  // Queue events for coalescing, or publish them right away if disabled
+  void queueLinkEvent(thrift::LinkEntry link);
+  void queueAddrEvent(thrift::AddrEntry address);
+
+  // Publish coalesced events in batches
+  void publishPendingEvents();
+
+  // Window for coalescing events, zero if disabled
+  const std::chrono::milliseconds coalesceWindow_;
+
+  // Coalesced events pending publication, keyed by interface name and by
+  // interface name and address respectively
+  std::unordered_map<std::string, thrift::LinkEntry> pendingLinkEvents_;
+  std::map<std::pair<std::string, thrift::IpPrefix>, thrift::AddrEntry>
+      pendingAddrEvents_;
+
+  // Publishes pending events at the end of coalesce window
+  std::unique_ptr<folly::AsyncTimeout> coalesceTimer_;
+
   // Cache of interface index to name. Used for resolving ifIndex
-  // on address events
-  // NOTE: We're not assuming any lock. It is always invoked in the same
-  // event-loop as of NetlinkProtocolSocket via callback mechanism.
-  std::unordered_map<int, std::string> ifIndexToName_;
+  // on address events. Updated with link events before link callback.
+  std::shared_ptr<fbnl::NetlinkLinkCache> linkCache_;
+
+  // Sequence numbers of last published events, per event type. Subscribers
+  // subscribe to event types separately
+  int64_t linkEventSeqNum_{0};
+  int64_t addrEventSeqNum_{0};
 
   // publish our own events (link up/down, addr changes, etc)
   fbzmq::Socket<ZMQ_PUB, fbzmq::ZMQ_SERVER> platformPubSock_;
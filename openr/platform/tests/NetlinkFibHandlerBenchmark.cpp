@@ -22,6 +22,7 @@
 #include <folly/test/TestUtils.h>
 
 #include <openr/fib/tests/PrefixGenerator.h>
+#include <openr/nl/NetlinkRoute.h>
 #include <openr/nl/tests/FakeNetlinkProtocolSocket.h>
 #include <openr/platform/NetlinkFibHandler.h>
 
@@ -48,23 +49,39 @@ namespace openr {
 // which the Benchmark test can use to add routes (via interface)
 class NetlinkFibWrapper {
  public:
-  NetlinkFibWrapper() {
+  // Routes are programmed through numRouteSockets sockets if more than one
+  explicit NetlinkFibWrapper(size_t numRouteSockets = 1) {
     // Create NetlinkProtocolSocket
     nlSock = std::make_unique<FakeNetlinkProtocolSocket>(&evb);
     nlSock->addLink(utils::createLink(0, kVethNameX)).get();
     nlSock->addLink(utils::createLink(1, kVethNameY)).get();
 
+    std::vector<fbnl::NetlinkProtocolSocket*> routeSockPtrs;
+    if (numRouteSockets > 1) {
+      for (size_t i = 0; i < numRouteSockets; ++i) {
+        routeSocks.emplace_back(
+            std::make_unique<FakeNetlinkProtocolSocket>(&evb));
+        routeSockPtrs.emplace_back(routeSocks.back().get());
+      }
+    }
+
     // Start FibService thread
-    fibHandler = std::make_unique<NetlinkFibHandler>(nlSock.get());
+    fibHandler = std::make_unique<NetlinkFibHandler>(
+        nlSock.get(),
+        Constants::kPlatformRouteAuditInterval,
+        nullptr,
+        std::move(routeSockPtrs));
   }
 
   ~NetlinkFibWrapper() {
     fibHandler.reset();
+    routeSocks.clear();
     nlSock.reset();
   }
 
   folly::EventBase evb;
   std::unique_ptr<FakeNetlinkProtocolSocket> nlSock;
+  std::vector<std::unique_ptr<FakeNetlinkProtocolSocket>> routeSocks;
   std::unique_ptr<NetlinkFibHandler> fibHandler;
   PrefixGenerator prefixGenerator;
 };
@@ -113,6 +130,159 @@ BENCHMARK_PARAM(BM_NetlinkFibHandler, 100);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 1000);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 10000);
 
+/**
+ * Benchmark test to measure throughput of programming IPv6 and MPLS routes
+ * at the same time, depending on number of netlink sockets used
+ * 1. Create a NetlinkFibHandler with the given number of route sockets
+ * 2. Generate 1000 IPv6 routes and 1000 MPLS swap routes
+ * 3. Add both sets of routes and wait for completion of both
+ * NOTE: Fake sockets complete requests right away, so this measures the cost
+ * of dispatching over sockets rather than kernel acknowledgement latency
+ */
+static void
+BM_NetlinkFibHandlerSockets(uint32_t iters, size_t numSockets) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto netlinkFibWrapper = std::make_unique<NetlinkFibWrapper>(numSockets);
+  const size_t numOfRoutes = 1000;
+
+  auto prefixes = netlinkFibWrapper->prefixGenerator.ipv6PrefixGenerator(
+      numOfRoutes, kBitMaskLen);
+  const auto mplsNextHop = createNextHop(
+      toBinaryAddress(folly::IPAddress("fe80::2")),
+      kVethNameY,
+      0,
+      createMplsAction(thrift::MplsActionCode::SWAP, 1000));
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto routes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+    auto mplsRoutes = std::make_unique<std::vector<thrift::MplsRoute>>();
+    routes->reserve(numOfRoutes);
+    mplsRoutes->reserve(numOfRoutes);
+    for (size_t index = 0; index < numOfRoutes; index++) {
+      routes->emplace_back(createUnicastRoute(
+          prefixes[index],
+          netlinkFibWrapper->prefixGenerator.getRandomNextHopsUnicast(
+              kNumOfNexthops, kVethNameY)));
+      mplsRoutes->emplace_back(createMplsRoute(100 + index, {mplsNextHop}));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    folly::collectAll(
+        netlinkFibWrapper->fibHandler->semifuture_addUnicastRoutes(
+            kFibId, std::move(routes)),
+        netlinkFibWrapper->fibHandler->semifuture_addMplsRoutes(
+            kFibId, std::move(mplsRoutes)))
+        .wait();
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+// The parameter is the number of route sockets
+BENCHMARK_PARAM(BM_NetlinkFibHandlerSockets, 1);
+BENCHMARK_PARAM(BM_NetlinkFibHandlerSockets, 2);
+BENCHMARK_PARAM(BM_NetlinkFibHandlerSockets, 3);
+
+/**
+ * Benchmark test to measure the cost of building netlink route messages
+ * 1. Generate random IpV6 routes
+ * 2. Build and compact route messages, holding them as if queued for kernel
+ * 3. Complete and release the messages as if acked
+ * Repeated iterations re-use message buffers cached in NetlinkMessagePool
+ */
+static void
+BM_NetlinkRouteMessage(uint32_t iters, size_t numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  PrefixGenerator prefixGenerator;
+
+  // Randomly generate IPV6 routes
+  const auto prefixes =
+      prefixGenerator.ipv6PrefixGenerator(numOfPrefixes, kBitMaskLen);
+  std::vector<Route> routes;
+  routes.reserve(prefixes.size());
+  for (auto const& prefix : prefixes) {
+    RouteBuilder rtBuilder;
+    rtBuilder.setDestination(toIPNetwork(prefix)).setProtocolId(99);
+    for (uint8_t i = 0; i < 16; ++i) {
+      NextHopBuilder nhBuilder;
+      rtBuilder.addNextHop(
+          nhBuilder
+              .setGateway(folly::IPAddress(folly::sformat("fe80::{}", i + 1)))
+              .setIfIndex(1)
+              .build());
+    }
+    routes.emplace_back(rtBuilder.build());
+  }
+
+  std::vector<std::unique_ptr<NetlinkRouteMessage>> msgs;
+  msgs.reserve(routes.size());
+
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto const& route : routes) {
+      auto msg = std::make_unique<NetlinkRouteMessage>();
+      CHECK_EQ(0, msg->addRoute(route));
+      msg->compact();
+      msgs.emplace_back(std::move(msg));
+    }
+    for (auto& msg : msgs) {
+      msg->setReturnStatus(0);
+    }
+    msgs.clear();
+  }
+}
+
+// The parameter is the number of prefixes
+BENCHMARK_PARAM(BM_NetlinkRouteMessage, 100);
+BENCHMARK_PARAM(BM_NetlinkRouteMessage, 1000);
+BENCHMARK_PARAM(BM_NetlinkRouteMessage, 10000);
+BENCHMARK_PARAM(BM_NetlinkRouteMessage, 100000);
+
+/**
+ * Benchmark test to measure the cost of building route messages with wide
+ * ECMP and MPLS push on each nexthop, which grow beyond default buffer of the
+ * message
+ */
+static void
+BM_NetlinkWideEcmpRouteMessage(uint32_t iters, size_t numOfNexthops) {
+  auto suspender = folly::BenchmarkSuspender();
+  PrefixGenerator prefixGenerator;
+
+  const auto prefixes = prefixGenerator.ipv6PrefixGenerator(100, kBitMaskLen);
+  std::vector<Route> routes;
+  routes.reserve(prefixes.size());
+  for (auto const& prefix : prefixes) {
+    RouteBuilder rtBuilder;
+    rtBuilder.setDestination(toIPNetwork(prefix)).setProtocolId(99);
+    for (size_t i = 0; i < numOfNexthops; ++i) {
+      NextHopBuilder nhBuilder;
+      rtBuilder.addNextHop(
+          nhBuilder
+              .setGateway(folly::IPAddress(folly::sformat("fe80::{:x}", i + 1)))
+              .setIfIndex(1)
+              .setLabelAction(thrift::MplsActionCode::PUSH)
+              .setPushLabels({100, 200})
+              .build());
+    }
+    routes.emplace_back(rtBuilder.build());
+  }
+
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto const& route : routes) {
+      NetlinkRouteMessage msg;
+      CHECK_EQ(0, msg.addRoute(route));
+      msg.setReturnStatus(0);
+    }
+  }
+}
+
+// The parameter is the number of nexthops per route
+BENCHMARK_PARAM(BM_NetlinkWideEcmpRouteMessage, 64);
+BENCHMARK_PARAM(BM_NetlinkWideEcmpRouteMessage, 128);
+BENCHMARK_PARAM(BM_NetlinkWideEcmpRouteMessage, 512);
+
 } // namespace openr
 
 int
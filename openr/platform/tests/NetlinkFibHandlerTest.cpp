@@ -8,6 +8,7 @@
 #include <chrono>
 #include <stdexcept>
 
+#include <fb303/ServiceData.h>
 #include <folly/Format.h>
 #include <folly/IPAddress.h>
 #include <folly/Random.h>
@@ -409,6 +410,313 @@ TEST_P(FibHandlerFixture, UnicastSync) {
   EXPECT_EQ(rts, *routes);
 }
 
+//
+// Routes in compact form. Chunked sync is applied only on the last chunk, and
+// chunk of a new sync abandons the previous one
+//
+TEST_P(FibHandlerFixture, UnicastCompact) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+
+  std::vector<thrift::FibFeature> features;
+  handler.getSupportedFeatures(features);
+  EXPECT_EQ(
+      std::vector<thrift::FibFeature>{
+          thrift::FibFeature::COMPACT_UNICAST_ROUTES},
+      features);
+
+  // Add routes
+  auto rts = createUnicastRoutes(4, isV4);
+  handler
+      .semifuture_addUnicastRoutesCompact(
+          kClientId,
+          std::make_unique<thrift::CompactUnicastRoutes>(
+              createCompactUnicastRoutes(rts)))
+      .get();
+  auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  sortNextHops(*routes);
+  sortNextHops(rts);
+  EXPECT_EQ(rts, *routes);
+
+  // Start sync which gets abandoned
+  auto newRts = createUnicastRoutes(6, isV4);
+  sortNextHops(newRts);
+  const std::vector<thrift::UnicastRoute> chunk1(
+      newRts.begin(), newRts.begin() + 3);
+  const std::vector<thrift::UnicastRoute> chunk2(
+      newRts.begin() + 3, newRts.end());
+  handler
+      .semifuture_syncFibCompact(
+          kClientId,
+          std::make_unique<thrift::CompactUnicastRoutes>(
+              createCompactUnicastRoutes(chunk2)),
+          1 /* syncId */,
+          false /* isLastChunk */)
+      .get();
+
+  // Sync in two chunks. Routes are unchanged until the last chunk
+  handler
+      .semifuture_syncFibCompact(
+          kClientId,
+          std::make_unique<thrift::CompactUnicastRoutes>(
+              createCompactUnicastRoutes(chunk1)),
+          2 /* syncId */,
+          false /* isLastChunk */)
+      .get();
+  routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+
+  handler
+      .semifuture_syncFibCompact(
+          kClientId,
+          std::make_unique<thrift::CompactUnicastRoutes>(
+              createCompactUnicastRoutes(chunk2)),
+          2 /* syncId */,
+          true /* isLastChunk */)
+      .get();
+  routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  sortNextHops(*routes);
+  EXPECT_EQ(newRts, *routes);
+
+  // Invalid nexthop index
+  auto compactRoutes = createCompactUnicastRoutes(rts);
+  compactRoutes.routes.at(0).nextHopIndices.emplace_back(
+      compactRoutes.nextHops.size());
+  EXPECT_THROW(
+      handler
+          .semifuture_addUnicastRoutesCompact(
+              kClientId,
+              std::make_unique<thrift::CompactUnicastRoutes>(compactRoutes))
+          .get(),
+      thrift::PlatformError);
+}
+
+//
+// Test syncFib against shadow of programmed routes. Routes are programmed
+// from kernel state on first sync, while subsequent syncs program difference
+// against the shadow (hence a route removed out of band isn't noticed) until
+// the audit interval elapses.
+//
+TEST(NetlinkFibHandler, UnicastSyncShadow) {
+  const int16_t kClientId = 786;
+  const auto protocol = NetlinkFibHandler::getProtocol(kClientId).value();
+
+  for (auto auditInterval :
+       {std::chrono::milliseconds(3600 * 1000), std::chrono::milliseconds(0)}) {
+    folly::EventBase nlEvb;
+    fbnl::FakeNetlinkProtocolSocket nlSock(&nlEvb);
+    ASSERT_EQ(
+        0,
+        nlSock.addLink(fbnl::utils::createLink(0, "lo", true, true)).get());
+    for (size_t i = 0; i < kInterfaces.size(); ++i) {
+      ASSERT_EQ(
+          0,
+          nlSock
+              .addLink(fbnl::utils::createLink(
+                  i + 1, kInterfaces.at(i), true, false))
+              .get());
+    }
+    NetlinkFibHandler handler(&nlSock, auditInterval);
+    const bool expectAudit = auditInterval.count() == 0;
+
+    // Initial sync programs all the routes
+    auto rts = createUnicastRoutes(4, false);
+    handler
+        .semifuture_syncFib(
+            kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+        .get();
+    auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+    ASSERT_EQ(4, routes->size());
+
+    // Remove route out of band and sync again. Route is restored only if
+    // sync is audited against kernel
+    fbnl::RouteBuilder rtBuilder;
+    rtBuilder.setDestination(toIPNetwork(rts.at(0).dest))
+        .setProtocolId(protocol);
+    ASSERT_EQ(0, nlSock.deleteRoute(rtBuilder.build()).get());
+    handler
+        .semifuture_syncFib(
+            kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+        .get();
+    routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+    EXPECT_EQ(expectAudit ? 4 : 3, routes->size());
+
+    // Update nexthops of a route and remove another one
+    rts.at(1).nextHops.at(0).address.addr =
+        toBinaryAddress(folly::IPAddress("fe80::99")).addr;
+    rts.pop_back();
+    handler
+        .semifuture_syncFib(
+            kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+        .get();
+    routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+    sortNextHops(*routes);
+    sortNextHops(rts);
+    if (not expectAudit) {
+      rts.erase(rts.begin());
+    }
+    EXPECT_EQ(rts, *routes);
+  }
+}
+
+//
+// Interface cache is kept up to date with link events, including links added
+// or renamed after the handler is created, without falling back to querying
+// all links from netlink
+//
+TEST(NetlinkFibHandler, InterfaceCache) {
+  const int16_t kClientId = 786;
+  auto getCounter = [](const std::string& key) {
+    return facebook::fb303::fbData->getCounters()[key];
+  };
+
+  folly::EventBase nlEvb;
+  fbnl::FakeNetlinkProtocolSocket nlSock(&nlEvb);
+  NetlinkFibHandler handler(&nlSock);
+  ASSERT_EQ(
+      0, nlSock.addLink(fbnl::utils::createLink(0, "lo", true, true)).get());
+  ASSERT_EQ(
+      0, nlSock.addLink(fbnl::utils::createLink(1, "eth0", true, false)).get());
+  EXPECT_LE(2, getCounter("platform.link_cache.updates.sum"));
+
+  const auto misses = getCounter("platform.link_cache.misses.sum");
+  auto route = createUnicastRoute(0, 1, false);
+  route.nextHops.at(0).address.ifName_ref() = "eth0";
+  handler
+      .semifuture_addUnicastRoute(
+          kClientId, std::make_unique<thrift::UnicastRoute>(route))
+      .get();
+  auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(1, routes->size());
+  EXPECT_EQ(route, routes->at(0));
+
+  // Rename interface. Route is reported with new name of the interface
+  ASSERT_EQ(
+      0, nlSock.addLink(fbnl::utils::createLink(1, "eth9", true, false)).get());
+  route.nextHops.at(0).address.ifName_ref() = "eth9";
+  routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(1, routes->size());
+  EXPECT_EQ(route, routes->at(0));
+  EXPECT_EQ(misses, getCounter("platform.link_cache.misses.sum"));
+  EXPECT_LT(0, getCounter("platform.link_cache.hits.sum"));
+}
+
+//
+// Routes of each address family are programmed and retrieved through a socket
+// of their own if route sockets are given, here IPv4 and MPLS share the first
+// one
+//
+TEST(NetlinkFibHandler, RouteSockets) {
+  const int16_t kClientId = 786;
+  const auto protocol = NetlinkFibHandler::getProtocol(kClientId).value();
+
+  folly::EventBase nlEvb;
+  fbnl::FakeNetlinkProtocolSocket nlSock(&nlEvb);
+  ASSERT_EQ(
+      0, nlSock.addLink(fbnl::utils::createLink(0, "lo", true, true)).get());
+  for (size_t i = 0; i < kInterfaces.size(); ++i) {
+    ASSERT_EQ(
+        0,
+        nlSock
+            .addLink(fbnl::utils::createLink(
+                i + 1, kInterfaces.at(i), true, false))
+            .get());
+  }
+  fbnl::FakeNetlinkProtocolSocket routeSock1(&nlEvb);
+  fbnl::FakeNetlinkProtocolSocket routeSock2(&nlEvb);
+  NetlinkFibHandler handler(
+      &nlSock,
+      Constants::kPlatformRouteAuditInterval,
+      nullptr,
+      {&routeSock1, &routeSock2});
+
+  auto v4Routes = createUnicastRoutes(3, true);
+  auto v6Routes = createUnicastRoutes(4, false);
+  handler
+      .semifuture_addUnicastRoutes(
+          kClientId,
+          std::make_unique<std::vector<thrift::UnicastRoute>>(v4Routes))
+      .get();
+  handler
+      .semifuture_addUnicastRoutes(
+          kClientId,
+          std::make_unique<std::vector<thrift::UnicastRoute>>(v6Routes))
+      .get();
+  handler
+      .semifuture_addMplsRoutes(
+          kClientId,
+          std::make_unique<std::vector<thrift::MplsRoute>>(createMplsRoutes(
+              2, false, createMplsAction(thrift::MplsActionCode::PHP))))
+      .get();
+
+  EXPECT_EQ(3, routeSock1.getIPv4Routes(protocol).get()->size());
+  EXPECT_EQ(2, routeSock1.getMplsRoutes(protocol).get()->size());
+  EXPECT_EQ(0, routeSock1.getIPv6Routes(protocol).get()->size());
+  EXPECT_EQ(4, routeSock2.getIPv6Routes(protocol).get()->size());
+  EXPECT_EQ(0, routeSock2.getIPv4Routes(protocol).get()->size());
+  EXPECT_EQ(0, nlSock.getAllRoutes().get()->size());
+
+  // Routes of both address families are retrieved from their sockets
+  auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  EXPECT_EQ(7, routes->size());
+  auto mplsRoutes =
+      handler.semifuture_getMplsRouteTableByClient(kClientId).get();
+  EXPECT_EQ(2, mplsRoutes->size());
+}
+
+//
+// Latency and size of route batches are exposed through getCounters, along
+// with the other netlink and platform counters only
+//
+TEST(NetlinkFibHandler, RouteBatchCounters) {
+  const int16_t kClientId = 786;
+
+  folly::EventBase nlEvb;
+  fbnl::FakeNetlinkProtocolSocket nlSock(&nlEvb);
+  ASSERT_EQ(
+      0, nlSock.addLink(fbnl::utils::createLink(0, "lo", true, true)).get());
+  for (size_t i = 0; i < kInterfaces.size(); ++i) {
+    ASSERT_EQ(
+        0,
+        nlSock
+            .addLink(fbnl::utils::createLink(
+                i + 1, kInterfaces.at(i), true, false))
+            .get());
+  }
+  NetlinkFibHandler handler(&nlSock);
+  facebook::fb303::fbData->addStatValue(
+      "kvstore.test_counter", 1, facebook::fb303::SUM);
+
+  handler
+      .semifuture_addUnicastRoutes(
+          kClientId,
+          std::make_unique<std::vector<thrift::UnicastRoute>>(
+              createUnicastRoutes(4, true)))
+      .get();
+
+  std::map<std::string, int64_t> counters;
+  handler.getCounters(counters);
+  // counters are shared by all handlers of the process
+  ASSERT_EQ(1, counters.count("platform.route_batch_size.avg"));
+  EXPECT_LT(0, counters.at("platform.route_batch_size.avg"));
+  EXPECT_EQ(1, counters.count("platform.route_batch_failures.sum"));
+  EXPECT_EQ(0, counters.count("kvstore.test_counter.sum"));
+}
+
+//
+// Nexthop hash is independent of the order of nexthops
+//
+TEST(NetlinkFibHandler, hashNextHops) {
+  auto nhs = createNextHops(4, false);
+  const auto hash = NetlinkFibHandler::hashNextHops(nhs);
+  std::reverse(nhs.begin(), nhs.end());
+  EXPECT_EQ(hash, NetlinkFibHandler::hashNextHops(nhs));
+
+  nhs.pop_back();
+  EXPECT_NE(hash, NetlinkFibHandler::hashNextHops(nhs));
+}
+
 //
 // Test correctness of multiple client support. Incrementally add and remove
 // route for same prefix1 from client1 and client2. Verify that addition or
@@ -7,9 +7,12 @@
 
 #include <gtest/gtest.h>
 
+#include <fb303/ServiceData.h>
 #include <folly/io/async/EventBase.h>
 
+#include <openr/nl/NetlinkLinkCache.h>
 #include <openr/nl/tests/FakeNetlinkProtocolSocket.h>
+#include <openr/platform/NetlinkFibHandler.h>
 #include <openr/platform/NetlinkSystemHandler.h>
 
 using namespace ::testing;
@@ -88,6 +91,45 @@ TEST(SystemHandler, addRemoveIfaceAddresses) {
   }
 }
 
+//
+// Link cache shared by handlers is kept up to date with link events, and
+// interface index looked up by one handler is served from cache to others
+//
+TEST(SystemHandler, sharedLinkCache) {
+  auto getCounter = [](const std::string& key) {
+    return facebook::fb303::fbData->getCounters()[key];
+  };
+
+  folly::EventBase evb;
+  fbnl::FakeNetlinkProtocolSocket nlSock(&evb);
+  EXPECT_EQ(0, nlSock.addLink(utils::createLink(1, "eth0")).get());
+  auto linkCache = std::make_shared<fbnl::NetlinkLinkCache>(&nlSock);
+  NetlinkSystemHandler handler(&nlSock, linkCache);
+  NetlinkFibHandler fibHandler(
+      &nlSock, Constants::kPlatformRouteAuditInterval, linkCache);
+
+  // Link added before cache is queried on first miss. Cache only lookups
+  // don't query kernel
+  EXPECT_FALSE(linkCache->findIfIndex("eth0").has_value());
+  const auto misses = getCounter("platform.link_cache.misses.sum");
+  EXPECT_EQ(1, linkCache->getIfIndex("eth0"));
+  EXPECT_EQ(misses + 1, getCounter("platform.link_cache.misses.sum"));
+  EXPECT_EQ(1, linkCache->findIfIndex("eth0"));
+
+  // Link added after is learnt from link event
+  EXPECT_EQ(0, nlSock.addLink(utils::createLink(2, "eth1")).get());
+  EXPECT_EQ("eth1", linkCache->findIfName(2));
+  auto retval = handler.semifuture_addIfaceAddresses(
+      std::make_unique<std::string>(std::string("eth1")),
+      std::make_unique<std::vector<thrift::IpPrefix>>(
+          std::vector<thrift::IpPrefix>{toIpPrefix("192.168.0.3/31")}));
+  EXPECT_NO_THROW(std::move(retval).get());
+  auto addrs = nlSock.getAllIfAddresses().get().value();
+  ASSERT_EQ(1, addrs.size());
+  EXPECT_EQ(2, addrs.at(0).getIfIndex());
+  EXPECT_EQ(misses + 1, getCounter("platform.link_cache.misses.sum"));
+}
+
 TEST(SystemHandler, syncIfaceAddresses) {
   folly::EventBase evb;
   fbnl::FakeNetlinkProtocolSocket nlSock(&evb);
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <optional>
+#include <thread>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/io/async/EventBase.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/nl/tests/FakeNetlinkProtocolSocket.h>
+#include <openr/platform/PlatformPublisher.h>
+
+using namespace openr;
+
+namespace {
+
+const PlatformPublisherUrl kPlatformPubUrl{"inproc://platform-pub-test"};
+const std::chrono::milliseconds kCoalesceWindow{50};
+const std::chrono::milliseconds kRecvTimeout{1000};
+
+} // namespace
+
+class PlatformPublisherTestFixture : public ::testing::Test {
+ public:
+  void
+  SetUp() override {
+    publisher = std::make_unique<PlatformPublisher>(
+        context, kPlatformPubUrl, &nlSock, nullptr, kCoalesceWindow);
+    ASSERT_TRUE(subSock.setSockOpt(ZMQ_SUBSCRIBE, "", 0).hasValue());
+    ASSERT_TRUE(subSock.connect(fbzmq::SocketUrl{kPlatformPubUrl}).hasValue());
+    evbThread = std::thread([this]() { evb.loopForever(); });
+    evb.waitUntilRunning();
+
+    // Subscription is established asynchronously. Flap a link until its
+    // events are received
+    for (int i = 0;; ++i) {
+      evb.runInEventBaseThreadAndWait([this, i]() {
+        nlSock.addLink(fbnl::utils::createLink(9, "probe", i % 2 == 0)).get();
+      });
+      if (recvEvent(std::chrono::milliseconds(100)).has_value()) {
+        break;
+      }
+    }
+  }
+
+  void
+  TearDown() override {
+    publisher->stop();
+    evb.terminateLoopSoon();
+    evbThread.join();
+    publisher.reset();
+  }
+
+  std::optional<thrift::PlatformEvent>
+  recvEvent(std::chrono::milliseconds timeout = kRecvTimeout) {
+    auto header = subSock.recvOne(timeout);
+    if (header.hasError()) {
+      return std::nullopt;
+    }
+    auto data = subSock.recvOne(kRecvTimeout);
+    EXPECT_FALSE(data.hasError());
+    auto event = data.value().readThriftObj<thrift::PlatformEvent>(serializer);
+    EXPECT_FALSE(event.hasError());
+    EXPECT_EQ(
+        static_cast<uint16_t>(event.value().eventType),
+        header.value().read<uint16_t>().value());
+    return std::move(event).value();
+  }
+
+  template <typename T>
+  std::vector<T>
+  readBatch(const thrift::PlatformEvent& event) {
+    std::vector<T> entries;
+    EXPECT_TRUE(event.eventDataBatch_ref().has_value());
+    for (auto const& data : event.eventDataBatch_ref().value()) {
+      entries.emplace_back(fbzmq::util::readThriftObjStr<T>(data, serializer));
+    }
+    return entries;
+  }
+
+  fbzmq::Context context;
+  folly::EventBase evb;
+  std::thread evbThread;
+  fbnl::FakeNetlinkProtocolSocket nlSock{&evb};
+  std::unique_ptr<PlatformPublisher> publisher;
+  fbzmq::Socket<ZMQ_SUB, fbzmq::ZMQ_CLIENT> subSock{context};
+  apache::thrift::CompactSerializer serializer;
+};
+
+//
+// Burst of events is coalesced to latest state of every interface and
+// published as single batch per event type, carrying single sequence number
+//
+TEST_F(PlatformPublisherTestFixture, CoalesceEvents) {
+  // Drain events of probing
+  int64_t lastLinkSeqNum{0};
+  while (auto event = recvEvent(kCoalesceWindow * 4)) {
+    lastLinkSeqNum = event->seqNum_ref().value();
+  }
+
+  evb.runInEventBaseThreadAndWait([this]() {
+    using fbnl::utils::createLink;
+    EXPECT_EQ(0, nlSock.addLink(createLink(1, "eth0", false)).get());
+    EXPECT_EQ(0, nlSock.addLink(createLink(2, "eth1", true)).get());
+    EXPECT_EQ(0, nlSock.addLink(createLink(1, "eth0", true)).get());
+    EXPECT_EQ(
+        0,
+        nlSock.addIfAddress(fbnl::utils::createIfAddress(2, "192.168.0.3/31"))
+            .get());
+  });
+
+  // Link events first, latest state of eth0
+  auto event = recvEvent();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(thrift::PlatformEventType::LINK_EVENT, event->eventType);
+  EXPECT_EQ(lastLinkSeqNum + 1, event->seqNum_ref().value());
+  auto links = readBatch<thrift::LinkEntry>(*event);
+  ASSERT_EQ(2, links.size());
+  std::sort(links.begin(), links.end(), [](auto const& a, auto const& b) {
+    return a.ifName < b.ifName;
+  });
+  EXPECT_EQ("eth0", links.at(0).ifName);
+  EXPECT_TRUE(links.at(0).isUp);
+  EXPECT_EQ("eth1", links.at(1).ifName);
+
+  event = recvEvent();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(thrift::PlatformEventType::ADDRESS_EVENT, event->eventType);
+  auto addrs = readBatch<thrift::AddrEntry>(*event);
+  ASSERT_EQ(1, addrs.size());
+  EXPECT_EQ("eth1", addrs.at(0).ifName);
+  EXPECT_TRUE(addrs.at(0).isValid);
+
+  // Nothing more
+  EXPECT_FALSE(recvEvent(kCoalesceWindow * 4).has_value());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -15,16 +15,23 @@
 #include <openr/common/Types.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
+#include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/if/gen-cpp2/PrefixManager_types.h>
 #include <openr/messaging/Queue.h>
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/plugin/PluginEventDispatcher.h>
 
 namespace openr {
+// Readers of route and KvStore updates are released if plugin doesn't keep
+// them. Plugins consuming them should do so with PluginEventDispatcher, in
+// order to process events on their own executor
 struct PluginArgs {
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest>& prefixUpdatesQueue;
   messaging::ReplicateQueue<openr::thrift::RouteDatabaseDelta>&
       staticRoutesUpdateQueue;
   messaging::RQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
+  messaging::RQueue<std::shared_ptr<const thrift::Publication>>
+      kvStoreUpdatesQueue;
   std::shared_ptr<const Config> config;
   std::shared_ptr<wangle::SSLContextConfig> sslContext;
 };
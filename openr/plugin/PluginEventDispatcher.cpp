@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PluginEventDispatcher.h"
+
+#include <folly/system/ThreadName.h>
+#include <glog/logging.h>
+
+namespace openr {
+
+PluginEventDispatcher::PluginEventDispatcher(
+    std::shared_ptr<PluginEventHandler> handler,
+    folly::Executor::KeepAlive<> executor,
+    std::optional<messaging::RQueue<thrift::RouteDatabaseDelta>>
+        routeUpdatesQueue,
+    std::optional<messaging::RQueue<std::shared_ptr<const thrift::Publication>>>
+        kvStoreUpdatesQueue)
+    : handler_(std::move(handler)),
+      executor_(folly::SerialExecutor::create(std::move(executor))) {
+  CHECK(handler_);
+
+  if (routeUpdatesQueue.has_value()) {
+    evb_.addFiberTask(
+        [q = std::move(*routeUpdatesQueue), this]() mutable noexcept {
+          while (true) {
+            auto maybeRouteDelta = q.get(); // perform read
+            if (maybeRouteDelta.hasError()) {
+              LOG(INFO) << "Terminating plugin route updates fiber";
+              break;
+            }
+            // reader got its own copy from the queue, shared from here on
+            auto routeDelta =
+                std::make_shared<const thrift::RouteDatabaseDelta>(
+                    std::move(maybeRouteDelta).value());
+            executor_->add([handler = handler_,
+                            routeDelta = std::move(routeDelta)]() mutable {
+              handler->onRouteUpdate(std::move(routeDelta));
+            });
+          }
+        });
+  }
+
+  if (kvStoreUpdatesQueue.has_value()) {
+    evb_.addFiberTask(
+        [q = std::move(*kvStoreUpdatesQueue), this]() mutable noexcept {
+          while (true) {
+            auto maybePublication = q.get(); // perform read
+            if (maybePublication.hasError()) {
+              LOG(INFO) << "Terminating plugin KvStore updates fiber";
+              break;
+            }
+            executor_->add(
+                [handler = handler_,
+                 publication = std::move(maybePublication).value()]() mutable {
+                  handler->onKvStorePublication(std::move(publication));
+                });
+          }
+        });
+  }
+
+  thread_ = std::thread([this]() {
+    folly::setThreadName("PluginEvents");
+    evb_.run();
+  });
+  evb_.waitUntilRunning();
+}
+
+PluginEventDispatcher::~PluginEventDispatcher() {
+  evb_.stop();
+  evb_.waitUntilStopped();
+  thread_.join();
+}
+
+} // namespace openr
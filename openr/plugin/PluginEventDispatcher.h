@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include <folly/Executor.h>
+#include <folly/executors/SerialExecutor.h>
+
+#include <openr/common/OpenrEventBase.h>
+#include <openr/if/gen-cpp2/Fib_types.h>
+#include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/messaging/Queue.h>
+
+namespace openr {
+
+/**
+ * Typed interface of plugins interested in route and KvStore events, instead
+ * of polling ctrl APIs. Events are delivered as shared read-only references,
+ * no copy is made per plugin.
+ *
+ * Contract: handlers are invoked on the executor of the plugin, in order and
+ * one at a time, never on threads of core modules. Handlers may take as long
+ * as they need, events queue up for the plugin meanwhile, core modules are
+ * never blocked on them.
+ */
+class PluginEventHandler {
+ public:
+  virtual ~PluginEventHandler() = default;
+
+  // route updates computed by Decision
+  virtual void
+  onRouteUpdate(
+      std::shared_ptr<const thrift::RouteDatabaseDelta> /* routeDelta */) {}
+
+  // publications of KvStore
+  virtual void
+  onKvStorePublication(
+      std::shared_ptr<const thrift::Publication> /* publication */) {}
+};
+
+/**
+ * Reads the queues handed to plugin with PluginArgs on its own thread, and
+ * dispatches events to the handler on the given executor. Queues not given
+ * are not read. Dispatch stops once queues are closed, which must happen
+ * before destruction (i.e. before pluginStop()).
+ */
+class PluginEventDispatcher final {
+ public:
+  PluginEventDispatcher(
+      std::shared_ptr<PluginEventHandler> handler,
+      folly::Executor::KeepAlive<> executor,
+      std::optional<messaging::RQueue<thrift::RouteDatabaseDelta>>
+          routeUpdatesQueue,
+      std::optional<
+          messaging::RQueue<std::shared_ptr<const thrift::Publication>>>
+          kvStoreUpdatesQueue);
+
+  ~PluginEventDispatcher();
+
+ private:
+  PluginEventDispatcher(PluginEventDispatcher const&) = delete;
+  PluginEventDispatcher& operator=(PluginEventDispatcher const&) = delete;
+
+  const std::shared_ptr<PluginEventHandler> handler_;
+
+  // serializes handlers on executor of the plugin
+  const folly::Executor::KeepAlive<folly::SerialExecutor> executor_;
+
+  OpenrEventBase evb_;
+  std::thread thread_;
+};
+
+} // namespace openr
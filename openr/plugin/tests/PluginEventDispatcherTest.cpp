@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Format.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/synchronization/Baton.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/messaging/ReplicateQueue.h>
+#include <openr/plugin/PluginEventDispatcher.h>
+
+using namespace openr;
+
+namespace {
+
+class TestHandler : public PluginEventHandler {
+ public:
+  explicit TestHandler(size_t expectedEvents)
+      : expectedEvents_(expectedEvents) {}
+
+  void
+  onRouteUpdate(
+      std::shared_ptr<const thrift::RouteDatabaseDelta> routeDelta) override {
+    routeDeltas.emplace_back(std::move(routeDelta));
+    onEvent();
+  }
+
+  void
+  onKvStorePublication(
+      std::shared_ptr<const thrift::Publication> publication) override {
+    // slow handler doesn't hold back delivery to other readers of the queue
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    publications.emplace_back(std::move(publication));
+    onEvent();
+  }
+
+  void
+  onEvent() {
+    // handlers are serialized, no synchronization needed
+    if (++numEvents_ == expectedEvents_) {
+      done.post();
+    }
+  }
+
+  std::vector<std::shared_ptr<const thrift::RouteDatabaseDelta>> routeDeltas;
+  std::vector<std::shared_ptr<const thrift::Publication>> publications;
+  folly::Baton<> done;
+
+ private:
+  const size_t expectedEvents_{0};
+  size_t numEvents_{0};
+};
+
+} // namespace
+
+TEST(PluginEventDispatcherTest, DispatchTest) {
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue;
+  messaging::ReplicateQueue<std::shared_ptr<const thrift::Publication>>
+      kvStoreUpdatesQueue;
+  auto kvStoreReader = kvStoreUpdatesQueue.getReader();
+  folly::CPUThreadPoolExecutor executor(4);
+
+  auto handler = std::make_shared<TestHandler>(6);
+  auto dispatcher = std::make_unique<PluginEventDispatcher>(
+      handler,
+      folly::getKeepAliveToken(executor),
+      routeUpdatesQueue.getReader(),
+      kvStoreUpdatesQueue.getReader());
+
+  std::vector<std::shared_ptr<const thrift::Publication>> publications;
+  for (int i = 0; i < 3; ++i) {
+    thrift::RouteDatabaseDelta routeDelta;
+    routeDelta.thisNodeName = folly::sformat("node-{}", i);
+    routeUpdatesQueue.push(std::move(routeDelta));
+
+    thrift::Publication publication;
+    publication.area = folly::sformat("area-{}", i);
+    publications.emplace_back(
+        std::make_shared<const thrift::Publication>(std::move(publication)));
+    kvStoreUpdatesQueue.push(publications.back());
+  }
+
+  // other reader got all the publications before plugin handled them
+  EXPECT_EQ(3, kvStoreReader.size());
+
+  handler->done.wait();
+  ASSERT_EQ(3, handler->routeDeltas.size());
+  ASSERT_EQ(3, handler->publications.size());
+  for (int i = 0; i < 3; ++i) {
+    // in order
+    EXPECT_EQ(
+        folly::sformat("node-{}", i), handler->routeDeltas.at(i)->thisNodeName);
+    // publications are shared, not copied
+    EXPECT_EQ(publications.at(i).get(), handler->publications.at(i).get());
+  }
+
+  routeUpdatesQueue.close();
+  kvStoreUpdatesQueue.close();
+  dispatcher.reset();
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
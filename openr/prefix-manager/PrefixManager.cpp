@@ -7,6 +7,8 @@
 
 #include "PrefixManager.h"
 
+#include <algorithm>
+
 #include <fb303/ServiceData.h>
 #include <folly/futures/Future.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -33,6 +35,15 @@ getPrefixTypeName(thrift::PrefixType const& type) {
   return apache::thrift::TEnumTraits<thrift::PrefixType>::findName(type);
 }
 
+// is the network strictly more specific than the summary
+bool
+isMoreSpecific(
+    folly::CIDRNetwork const& network, folly::CIDRNetwork const& summary) {
+  return network.first.family() == summary.first.family() and
+      network.second > summary.second and
+      network.first.inSubnet(summary.first, summary.second);
+}
+
 } // namespace
 
 PrefixManager::PrefixManager(
@@ -54,6 +65,19 @@ PrefixManager::PrefixManager(
   CHECK(configStore_);
   CHECK(kvStore_);
 
+  // index summaries configured for areas
+  for (const auto& areaConfig : config->getAreas()) {
+    for (const auto& summaryStr : areaConfig.summary_prefixes) {
+      const auto network = folly::IPAddress::createNetwork(summaryStr);
+      const auto summaryPrefix = toIpPrefix(network);
+      auto& summary = summaries_[summaryPrefix];
+      summary.network = network;
+      if (summary.areas.emplace(areaConfig.area_id).second) {
+        areaSummaries_[areaConfig.area_id].emplace_back(summaryPrefix);
+      }
+    }
+  }
+
   // Create KvStore client
   kvStoreClient_ =
       std::make_unique<KvStoreClientInternal>(this, nodeId_, kvStore_);
@@ -74,6 +98,7 @@ PrefixManager::PrefixManager(
           toString(entry.prefix),
           getPrefixTypeName(entry.type));
       prefixMap_[entry.type][entry.prefix] = entry;
+      dirtyPrefixes_.emplace(entry.prefix);
       addPerfEventIfNotExist(
           addingEvents_[entry.type][entry.prefix], "LOADED_FROM_DISK");
     }
@@ -83,14 +108,21 @@ PrefixManager::PrefixManager(
   initialSyncKvStoreTimer_ = folly::AsyncTimeout::make(
       *getEvb(), [this]() noexcept { syncKvStore(); });
 
-  // Create throttled update state
+  // Create throttled update state. Isolated change is synced right away,
+  // changes following it are batched
   syncKvStoreThrottled_ = std::make_unique<AsyncThrottle>(
-      getEvb(), Constants::kPrefixMgrKvThrottleTimeout, [this]() noexcept {
+      getEvb(),
+      Constants::kPrefixMgrKvThrottleTimeout,
+      [this]() noexcept {
+        if (persistPrefixDbPending_) {
+          persistPrefixDb();
+        }
         if (initialSyncKvStoreTimer_->isScheduled()) {
           return;
         }
         syncKvStore();
-      });
+      },
+      AsyncThrottle::Edge::LEADING);
 
   // Schedule fiber to read prefix updates messages
   addFiberTask(
@@ -140,7 +172,8 @@ PrefixManager::PrefixManager(
           const auto prefixDb =
               fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
                   value.value().value_ref().value(), serializer_);
-          if (not prefixDb.deletePrefix && nodeId_ == prefixDb.thisNodeName) {
+          if (not prefixDb.deletePrefix && nodeId_ == prefixDb.thisNodeName &&
+              not advertisedKeys_.count(key)) {
             LOG(INFO) << "keysToClear_.emplace(" << key << ")";
             keysToClear_.emplace(key);
             syncKvStoreThrottled_->operator()();
@@ -180,6 +213,7 @@ PrefixManager::~PrefixManager() {
 
 void
 PrefixManager::persistPrefixDb() {
+  persistPrefixDbPending_ = false;
   // prefixDb persistent entries have changed,
   // save the newest persistent entries to disk.
   thrift::PrefixDatabase persistentPrefixDb;
@@ -198,7 +232,9 @@ PrefixManager::persistPrefixDb() {
 }
 
 std::string
-PrefixManager::updateKvStorePrefixEntry(thrift::PrefixEntry& prefixEntry) {
+PrefixManager::updateKvStorePrefixEntry(
+    thrift::PrefixEntry& prefixEntry,
+    const std::unordered_set<std::string>& areas) {
   thrift::PrefixDatabase prefixDb;
   prefixDb.thisNodeName = nodeId_;
   prefixDb.prefixEntries.emplace_back(prefixEntry);
@@ -212,78 +248,257 @@ PrefixManager::updateKvStorePrefixEntry(thrift::PrefixEntry& prefixEntry) {
           folly::IPAddress::createNetwork(toString(prefixEntry.prefix)),
           thrift::KvStore_constants::kDefaultArea())
           .getPrefixKey();
-  for (const auto& area : areas_) {
+  // serialized once, the same value is advertised to all areas
+  const auto prefixDbStr =
+      fbzmq::util::writeThriftObjStr(prefixDb, serializer_);
+  for (const auto& area : areas) {
     bool const changed = kvStoreClient_->persistKey(
-        prefixKey,
-        fbzmq::util::writeThriftObjStr(std::move(prefixDb), serializer_),
-        ttlKeyInKvStore_,
-        area);
+        prefixKey, prefixDbStr, ttlKeyInKvStore_, area);
     LOG_IF(INFO, changed) << "Advertising key: " << prefixKey
                           << " to KvStore area: " << area;
   }
   return prefixKey;
 }
 
+thrift::PrefixEntry*
+PrefixManager::getAdvertisedPrefixEntry(const thrift::IpPrefix& prefix) {
+  thrift::PrefixEntry* advertisedEntry{nullptr};
+  for (auto& kv : prefixMap_) {
+    auto it = kv.second.find(prefix);
+    if (it == kv.second.end()) {
+      continue;
+    }
+    if (nullptr == advertisedEntry) {
+      addPerfEventIfNotExist(
+          addingEvents_[kv.first][prefix], "UPDATE_KVSTORE_THROTTLED");
+      advertisedEntry = &it->second;
+    } else {
+      addPerfEventIfNotExist(
+          addingEvents_[kv.first][prefix], "COVERED_BY_HIGHER_TYPE");
+    }
+  }
+  return advertisedEntry;
+}
+
+void
+PrefixManager::updateSummaries(
+    const thrift::IpPrefix& prefix,
+    bool advertised,
+    std::unordered_set<thrift::IpPrefix>& dirtySummaries) {
+  if (summaries_.empty()) {
+    return;
+  }
+  const auto network = toIPNetwork(prefix);
+  for (auto& [summaryPrefix, summary] : summaries_) {
+    if (summaryPrefix == prefix) {
+      // advertised on its own, or not any more
+      dirtySummaries.emplace(summaryPrefix);
+      continue;
+    }
+    if (not isMoreSpecific(network, summary.network)) {
+      continue;
+    }
+    auto& covered = summary.coveredPrefixes;
+    const bool wasEmpty = covered.empty();
+    if (advertised) {
+      covered.emplace(prefix);
+    } else {
+      covered.erase(prefix);
+    }
+    if (wasEmpty != covered.empty()) {
+      dirtySummaries.emplace(summaryPrefix);
+    }
+  }
+}
+
+bool
+PrefixManager::isSummarized(
+    const thrift::IpPrefix& prefix, const std::string& area) const {
+  auto it = areaSummaries_.find(area);
+  if (it == areaSummaries_.end()) {
+    return false;
+  }
+  for (const auto& summaryPrefix : it->second) {
+    if (summaries_.at(summaryPrefix).coveredPrefixes.count(prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unordered_set<std::string>
+PrefixManager::getPrefixAreas(const thrift::IpPrefix& prefix) const {
+  std::unordered_set<std::string> areas;
+  for (const auto& area : areas_) {
+    if (not isSummarized(prefix, area)) {
+      areas.emplace(area);
+    }
+  }
+  return areas;
+}
+
+std::optional<thrift::PrefixEntry>
+PrefixManager::getSummaryPrefixEntry(const thrift::IpPrefix& summary) const {
+  if (summaries_.at(summary).coveredPrefixes.empty()) {
+    return std::nullopt;
+  }
+  if (isPrefixAdvertised(summary)) {
+    return std::nullopt;
+  }
+  return createPrefixEntry(summary, thrift::PrefixType::DEFAULT);
+}
+
+bool
+PrefixManager::isPrefixAdvertised(const thrift::IpPrefix& prefix) const {
+  for (const auto& kv : prefixMap_) {
+    if (kv.second.count(prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+thrift::PrefixDatabase
+PrefixManager::getAreaPrefixDb(const std::string& area) const {
+  auto prefixDb = advertisedPrefixDb_;
+  auto it = areaSummaries_.find(area);
+  if (it == areaSummaries_.end()) {
+    return prefixDb;
+  }
+  auto& entries = prefixDb.prefixEntries;
+  entries.erase(
+      std::remove_if(
+          entries.begin(),
+          entries.end(),
+          [&](const thrift::PrefixEntry& entry) {
+            return isSummarized(entry.prefix, area);
+          }),
+      entries.end());
+  for (const auto& summaryPrefix : it->second) {
+    auto summaryEntry = getSummaryPrefixEntry(summaryPrefix);
+    if (summaryEntry.has_value()) {
+      entries.emplace_back(std::move(*summaryEntry));
+    }
+  }
+  return prefixDb;
+}
+
 void
 PrefixManager::syncKvStore() {
-  std::vector<std::pair<std::string, std::string>> keyVals;
-  std::unordered_set<std::string> nowAdvertisingKeys;
-  std::unordered_set<thrift::IpPrefix> nowAdvertisingPrefixes;
+  // Only prefixes changed since last sync are looked at. Everything loaded
+  // from disk is marked dirty on startup, hence initial sync covers all.
+  auto dirtyPrefixes = std::move(dirtyPrefixes_);
+  dirtyPrefixes_.clear();
+  std::unordered_set<thrift::IpPrefix> dirtySummaries;
+  std::vector<thrift::PrefixEntry> summaryEntries;
+
+  // keys of all areas are written to KvStore at once, at the end of sync
+  kvStoreClient_->startBatch();
 
   if (perPrefixKeys_) {
-    for (auto& kv : prefixMap_) {
-      for (auto& kv2 : kv.second) {
-        if (not nowAdvertisingPrefixes.count(kv2.first)) {
-          addPerfEventIfNotExist(
-              addingEvents_[kv.first][kv2.first], "UPDATE_KVSTORE_THROTTLED");
-          auto const key = updateKvStorePrefixEntry(kv2.second);
-          nowAdvertisingKeys.emplace(key);
-          nowAdvertisingPrefixes.emplace(kv2.first);
+    for (auto const& prefix : dirtyPrefixes) {
+      auto* prefixEntry = getAdvertisedPrefixEntry(prefix);
+      updateSummaries(prefix, prefixEntry != nullptr, dirtySummaries);
+      if (prefixEntry) {
+        auto const key =
+            updateKvStorePrefixEntry(*prefixEntry, getPrefixAreas(prefix));
+        advertisedKeys_.emplace(key);
+        keysToClear_.erase(key);
+        continue;
+      }
+      // prefix is withdrawn by all types
+      auto const key =
+          PrefixKey(
+              nodeId_,
+              folly::IPAddress::createNetwork(toString(prefix)),
+              thrift::KvStore_constants::kDefaultArea())
+              .getPrefixKey();
+      if (advertisedKeys_.erase(key)) {
+        keysToClear_.emplace(key);
+      }
+    }
+
+    // summaries are advertised only into areas configuring them, once keys
+    // are cleared, as summary may replace its own prefix just withdrawn
+    for (auto const& summaryPrefix : dirtySummaries) {
+      auto summaryEntry = getSummaryPrefixEntry(summaryPrefix);
+      auto const key =
+          PrefixKey(
+              nodeId_,
+              toIPNetwork(summaryPrefix),
+              thrift::KvStore_constants::kDefaultArea())
+              .getPrefixKey();
+      if (summaryEntry.has_value()) {
+        summaryEntries.emplace_back(std::move(*summaryEntry));
+        advertisedKeys_.emplace(key);
+        if (not dirtyPrefixes.count(summaryPrefix)) {
           keysToClear_.erase(key);
-        } else {
-          addPerfEventIfNotExist(
-              addingEvents_[kv.first][kv2.first], "COVERED_BY_HIGHER_TYPE");
         }
+      } else if (
+          not isPrefixAdvertised(summaryPrefix) and
+          advertisedKeys_.erase(key)) {
+        keysToClear_.emplace(key);
       }
     }
   } else {
-    thrift::PrefixDatabase prefixDb;
-    prefixDb.thisNodeName = nodeId_;
+    const auto prefixDbKey =
+        folly::sformat("{}{}", Constants::kPrefixDbMarker.toString(), nodeId_);
     thrift::PerfEvents* mostRecentEvents = nullptr;
-    for (auto& kv : prefixMap_) {
-      for (auto& kv2 : kv.second) {
-        if (not nowAdvertisingPrefixes.count(kv2.first)) {
-          addPerfEventIfNotExist(
-              addingEvents_[kv.first][kv2.first], "UPDATE_KVSTORE_THROTTLED");
-          if (nullptr == mostRecentEvents or
-              addingEvents_[kv.first][kv2.first].events.back().unixTs >
-                  mostRecentEvents->events.back().unixTs) {
-            mostRecentEvents = &addingEvents_[kv.first][kv2.first];
-          }
-          prefixDb.prefixEntries.emplace_back(kv2.second);
-          nowAdvertisingPrefixes.emplace(kv2.first);
+    for (auto const& prefix : dirtyPrefixes) {
+      auto* prefixEntry = getAdvertisedPrefixEntry(prefix);
+      updateSummaries(prefix, prefixEntry != nullptr, dirtySummaries);
+      auto it = advertisedPrefixIndex_.find(prefix);
+      if (prefixEntry) {
+        auto& perfEvents = addingEvents_[prefixEntry->type][prefix];
+        if (nullptr == mostRecentEvents or
+            perfEvents.events.back().unixTs >
+                mostRecentEvents->events.back().unixTs) {
+          mostRecentEvents = &perfEvents;
+        }
+        if (it != advertisedPrefixIndex_.end()) {
+          advertisedPrefixDb_.prefixEntries.at(it->second) = *prefixEntry;
         } else {
-          addPerfEventIfNotExist(
-              addingEvents_[kv.first][kv2.first], "COVERED_BY_HIGHER_TYPE");
+          advertisedPrefixIndex_.emplace(
+              prefix, advertisedPrefixDb_.prefixEntries.size());
+          advertisedPrefixDb_.prefixEntries.emplace_back(*prefixEntry);
+        }
+      } else if (it != advertisedPrefixIndex_.end()) {
+        // withdrawn by all types, swap with last entry and pop it
+        auto& entries = advertisedPrefixDb_.prefixEntries;
+        const auto index = it->second;
+        advertisedPrefixIndex_.erase(it);
+        if (index != entries.size() - 1) {
+          entries.at(index) = std::move(entries.back());
+          advertisedPrefixIndex_.at(entries.at(index).prefix) = index;
         }
+        entries.pop_back();
       }
     }
-    if (enablePerfMeasurement_ and nullptr != mostRecentEvents) {
-      prefixDb.perfEvents_ref() = *mostRecentEvents;
-    }
-    const auto prefixDbKey =
-        folly::sformat("{}{}", Constants::kPrefixDbMarker.toString(), nodeId_);
-    for (const auto& area : areas_) {
-      bool const changed = kvStoreClient_->persistKey(
-          prefixDbKey,
-          fbzmq::util::writeThriftObjStr(std::move(prefixDb), serializer_),
-          ttlKeyInKvStore_,
-          area);
-      LOG_IF(INFO, changed)
-          << "Updating all " << prefixDb.prefixEntries.size()
-          << " prefixes in KvStore " << prefixDbKey << " area: " << area;
+
+    // re-serialize only if something changed, and only once for all areas
+    if (not dirtyPrefixes.empty() or not advertisedKeys_.count(prefixDbKey)) {
+      advertisedPrefixDb_.thisNodeName = nodeId_;
+      if (enablePerfMeasurement_ and nullptr != mostRecentEvents) {
+        advertisedPrefixDb_.perfEvents_ref() = *mostRecentEvents;
+      }
+      const auto prefixDbStr =
+          fbzmq::util::writeThriftObjStr(advertisedPrefixDb_, serializer_);
+      for (const auto& area : areas_) {
+        // areas with summaries get their own copy of the db
+        bool const changed = kvStoreClient_->persistKey(
+            prefixDbKey,
+            areaSummaries_.count(area)
+                ? fbzmq::util::writeThriftObjStr(
+                      getAreaPrefixDb(area), serializer_)
+                : prefixDbStr,
+            ttlKeyInKvStore_,
+            area);
+        LOG_IF(INFO, changed)
+            << "Updating all " << advertisedPrefixDb_.prefixEntries.size()
+            << " prefixes in KvStore " << prefixDbKey << " area: " << area;
+      }
+      advertisedKeys_.emplace(prefixDbKey);
     }
-    nowAdvertisingKeys.emplace(prefixDbKey);
     keysToClear_.erase(prefixDbKey);
   }
 
@@ -303,21 +518,22 @@ PrefixManager::syncKvStore() {
       entry.prefix = maybePerPrefixKey.value().getIpPrefix();
       deletedPrefixDb.prefixEntries = {entry};
     }
+    const auto deletedPrefixDbStr =
+        fbzmq::util::writeThriftObjStr(deletedPrefixDb, serializer_);
     for (const auto& area : areas_) {
       LOG(INFO) << "Withdrawing key: " << key << " from KvStore area: " << area;
       // one last key set with empty DB and deletePrefix set signifies withdraw
       // then the key should ttl out
-      kvStoreClient_->clearKey(
-          key,
-          fbzmq::util::writeThriftObjStr(
-              std::move(deletedPrefixDb), serializer_),
-          ttlKeyInKvStore_,
-          area);
+      kvStoreClient_->clearKey(key, deletedPrefixDbStr, ttlKeyInKvStore_, area);
     }
   }
+  keysToClear_.clear();
 
-  // anything we don't advertise next time, we need to clear
-  keysToClear_ = std::move(nowAdvertisingKeys);
+  for (auto& summaryEntry : summaryEntries) {
+    updateKvStorePrefixEntry(
+        summaryEntry, summaries_.at(summaryEntry.prefix).areas);
+  }
+  kvStoreClient_->flushBatch();
 
   // Update flat counters
   size_t num_prefixes = 0;
@@ -382,6 +598,35 @@ PrefixManager::syncPrefixesByType(
   return sf;
 }
 
+folly::SemiFuture<int64_t>
+PrefixManager::applyPrefixUpdateBatch(
+    thrift::PrefixType prefixType, thrift::PrefixUpdateBatch batch) {
+  folly::Promise<int64_t> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([
+    this,
+    p = std::move(p),
+    prefixType,
+    batch = std::move(batch)
+  ]() mutable noexcept {
+    applyPrefixUpdateBatchImpl(prefixType, batch);
+    p.setValue(prefixUpdateSeqNums_[prefixType]);
+  });
+  return sf;
+}
+
+folly::SemiFuture<int64_t>
+PrefixManager::getPrefixUpdateSeqNum(thrift::PrefixType prefixType) {
+  folly::Promise<int64_t> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [this, p = std::move(p), prefixType]() mutable noexcept {
+        auto it = prefixUpdateSeqNums_.find(prefixType);
+        p.setValue(it != prefixUpdateSeqNums_.end() ? it->second : 0);
+      });
+  return sf;
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::PrefixEntry>>>
 PrefixManager::getPrefixes() {
   folly::Promise<std::unique_ptr<std::vector<thrift::PrefixEntry>>> p;
@@ -431,6 +676,7 @@ PrefixManager::advertisePrefixesImpl(
     auto it = prefixes.find(prefixEntry.prefix);
     if (it == prefixes.end() or it->second != prefixEntry) {
       prefixes[prefixEntry.prefix] = prefixEntry;
+      dirtyPrefixes_.emplace(prefixEntry.prefix);
       addPerfEventIfNotExist(
           addingEvents_[prefixEntry.type][prefixEntry.prefix],
           it == prefixes.end() ? "ADD_PREFIX" : "UPDATE_PREFIX");
@@ -461,6 +707,7 @@ PrefixManager::withdrawPrefixesImpl(
   for (const auto& prefix : prefixes) {
     prefixMap_.at(prefix.type).erase(prefix.prefix);
     addingEvents_.at(prefix.type).erase(prefix.prefix);
+    dirtyPrefixes_.emplace(prefix.prefix);
     SYSLOG(INFO) << "Withdrawing prefix: " << toString(prefix.prefix)
                  << ", client: " << getPrefixTypeName(prefix.type);
     if (prefixMap_[prefix.type].empty()) {
@@ -508,6 +755,9 @@ PrefixManager::withdrawPrefixesByTypeImpl(thrift::PrefixType type) {
   auto const search = prefixMap_.find(type);
   if (search != prefixMap_.end()) {
     changed = true;
+    for (auto const& kv : search->second) {
+      dirtyPrefixes_.emplace(kv.first);
+    }
     prefixMap_.erase(search);
   }
   if (changed) {
@@ -517,6 +767,73 @@ PrefixManager::withdrawPrefixesByTypeImpl(thrift::PrefixType type) {
   return changed;
 }
 
+bool
+PrefixManager::applyPrefixUpdateBatchImpl(
+    thrift::PrefixType type, thrift::PrefixUpdateBatch& batch) {
+  auto& seqNum = prefixUpdateSeqNums_[type];
+  if (batch.seqNum <= seqNum) {
+    VLOG(1) << "Ignoring replayed batch " << batch.seqNum << " of type "
+            << getPrefixTypeName(type) << ", last applied " << seqNum;
+    fb303::fbData->addStatValue(
+        "prefix_manager.stream_batches_ignored", 1, fb303::SUM);
+    return false;
+  }
+  seqNum = batch.seqNum;
+
+  size_t numChanged{0};
+  bool persistentChanged{false};
+  auto& prefixes = prefixMap_[type];
+  auto& events = addingEvents_[type];
+  for (auto& prefixEntry : batch.addPrefixes) {
+    prefixEntry.type = type;
+    auto it = prefixes.find(prefixEntry.prefix);
+    const bool added = it == prefixes.end();
+    if (not added and it->second == prefixEntry) {
+      continue;
+    }
+    const bool ephemeral = prefixEntry.ephemeral_ref().value_or(false);
+    persistentChanged |= not ephemeral or
+        (not added and not it->second.ephemeral_ref().value_or(false));
+    dirtyPrefixes_.emplace(prefixEntry.prefix);
+    addPerfEventIfNotExist(
+        events[prefixEntry.prefix], added ? "ADD_PREFIX" : "UPDATE_PREFIX");
+    auto const prefix = prefixEntry.prefix;
+    prefixes.insert_or_assign(prefix, std::move(prefixEntry));
+    ++numChanged;
+  }
+  for (auto const& prefix : batch.withdrawPrefixes) {
+    auto it = prefixes.find(prefix);
+    if (it == prefixes.end()) {
+      continue;
+    }
+    persistentChanged |= not it->second.ephemeral_ref().value_or(false);
+    prefixes.erase(it);
+    events.erase(prefix);
+    dirtyPrefixes_.emplace(prefix);
+    ++numChanged;
+  }
+  if (prefixes.empty()) {
+    prefixMap_.erase(type);
+  }
+  if (events.empty()) {
+    addingEvents_.erase(type);
+  }
+
+  VLOG(1) << "Applied batch " << batch.seqNum << " of type "
+          << getPrefixTypeName(type) << ", " << batch.addPrefixes.size()
+          << " additions, " << batch.withdrawPrefixes.size()
+          << " withdrawals, " << numChanged << " changes";
+  fb303::fbData->addStatValue("prefix_manager.stream_batches", 1, fb303::SUM);
+  fb303::fbData->addStatValue(
+      "prefix_manager.stream_prefix_changes", numChanged, fb303::SUM);
+  if (numChanged == 0) {
+    return false;
+  }
+  persistPrefixDbPending_ |= persistentChanged;
+  syncKvStoreThrottled_->operator()();
+  return true;
+}
+
 void
 PrefixManager::addPerfEventIfNotExist(
     thrift::PerfEvents& perfEvents, std::string const& updateEvent) {
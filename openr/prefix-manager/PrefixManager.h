@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <boost/serialization/strong_typedef.hpp>
 #include <fbzmq/zmq/Zmq.h>
@@ -73,6 +75,15 @@ class PrefixManager final : public OpenrEventBase {
   folly::SemiFuture<bool> syncPrefixesByType(
       thrift::PrefixType prefixType, std::vector<thrift::PrefixEntry> prefixes);
 
+  // Apply batch of prefix updates streamed for the type, in O(batch size).
+  // @return seqNum of the last batch applied for the type
+  folly::SemiFuture<int64_t> applyPrefixUpdateBatch(
+      thrift::PrefixType prefixType, thrift::PrefixUpdateBatch batch);
+
+  // seqNum of the last batch applied for the type, 0 if none
+  folly::SemiFuture<int64_t> getPrefixUpdateSeqNum(
+      thrift::PrefixType prefixType);
+
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::PrefixEntry>>>
   getPrefixes();
 
@@ -93,6 +104,10 @@ class PrefixManager final : public OpenrEventBase {
   bool advertisePrefixesImpl(const std::vector<thrift::PrefixEntry>& prefixes);
   bool withdrawPrefixesImpl(const std::vector<thrift::PrefixEntry>& prefixes);
   bool withdrawPrefixesByTypeImpl(thrift::PrefixType type);
+  // unlike the calls above, neither logs every prefix nor persists prefix
+  // db right away, which is left to next throttled sync
+  bool applyPrefixUpdateBatchImpl(
+      thrift::PrefixType type, thrift::PrefixUpdateBatch& batch);
   bool syncPrefixesByTypeImpl(
       thrift::PrefixType type,
       const std::vector<thrift::PrefixEntry>& prefixes);
@@ -100,8 +115,41 @@ class PrefixManager final : public OpenrEventBase {
   // Update kvstore with both ephemeral and non-ephemeral prefixes
   void syncKvStore();
 
-  // add prefix entry in kvstore, return per prefix key name
-  std::string updateKvStorePrefixEntry(thrift::PrefixEntry& prefixEntry);
+  // Entry to be advertised for the prefix i.e. of lowest prefix-type, or
+  // nullptr if prefix is not advertised by any type
+  thrift::PrefixEntry* getAdvertisedPrefixEntry(const thrift::IpPrefix& prefix);
+
+  // add prefix entry in kvstore of the areas, return per prefix key name
+  std::string updateKvStorePrefixEntry(
+      thrift::PrefixEntry& prefixEntry,
+      const std::unordered_set<std::string>& areas);
+
+  // Track the prefix as (un)advertised in prefixes covered by summaries, and
+  // collect summaries whose advertisement may have changed
+  void updateSummaries(
+      const thrift::IpPrefix& prefix,
+      bool advertised,
+      std::unordered_set<thrift::IpPrefix>& dirtySummaries);
+
+  // Is the advertised prefix replaced in the area by a summary covering it
+  bool isSummarized(
+      const thrift::IpPrefix& prefix, const std::string& area) const;
+
+  // Areas the advertised prefix is not summarized in
+  std::unordered_set<std::string> getPrefixAreas(
+      const thrift::IpPrefix& prefix) const;
+
+  // Is the prefix advertised by any type
+  bool isPrefixAdvertised(const thrift::IpPrefix& prefix) const;
+
+  // Entry to be advertised for the summary i.e. if it covers any advertised
+  // prefix and it is not advertised by any type on its own
+  std::optional<thrift::PrefixEntry> getSummaryPrefixEntry(
+      const thrift::IpPrefix& summary) const;
+
+  // Prefix db advertised into the area when per prefix keys are disabled,
+  // with summarized prefixes replaced by their summaries
+  thrift::PrefixDatabase getAreaPrefixDb(const std::string& area) const;
 
   // Update persistent store with non-ephemeral prefix entries
   void persistPrefixDb();
@@ -123,6 +171,12 @@ class PrefixManager final : public OpenrEventBase {
   // keep track of prefixDB on disk
   thrift::PrefixDatabase diskState_;
 
+  // persistent prefixes changed by batches since prefix db was last persisted
+  bool persistPrefixDbPending_{false};
+
+  // seqNum of the last batch of prefix updates applied per type
+  std::unordered_map<thrift::PrefixType, int64_t> prefixUpdateSeqNums_;
+
   bool perPrefixKeys_{true};
 
   // enable convergence performance measurement for Adjacencies update
@@ -155,6 +209,17 @@ class PrefixManager final : public OpenrEventBase {
   // anything we no longer wish to advertise
   std::unordered_set<std::string> keysToClear_;
 
+  // prefixes changed (of any type) since last syncKvStore
+  std::unordered_set<thrift::IpPrefix> dirtyPrefixes_;
+
+  // keys currently advertised by us into KvStore
+  std::unordered_set<std::string> advertisedKeys_;
+
+  // prefix db advertised when per prefix keys are disabled, patched with
+  // dirty prefixes on every sync, and its index by prefix
+  thrift::PrefixDatabase advertisedPrefixDb_;
+  std::unordered_map<thrift::IpPrefix, size_t> advertisedPrefixIndex_;
+
   // perfEvents related to a given prefisEntry
   std::unordered_map<
       thrift::PrefixType,
@@ -163,6 +228,20 @@ class PrefixManager final : public OpenrEventBase {
 
   // area Id
   const std::unordered_set<std::string> areas_{};
+
+  // summary prefix configured for some of the areas
+  struct Summary {
+    folly::CIDRNetwork network;
+    // areas the summary is advertised into
+    std::unordered_set<std::string> areas;
+    // advertised prefixes strictly more specific than the summary
+    std::unordered_set<thrift::IpPrefix> coveredPrefixes;
+  };
+  std::unordered_map<thrift::IpPrefix, Summary> summaries_;
+
+  // summaries configured for each area, if any
+  std::unordered_map<std::string, std::vector<thrift::IpPrefix>>
+      areaSummaries_;
 }; // PrefixManager
 
 } // namespace openr
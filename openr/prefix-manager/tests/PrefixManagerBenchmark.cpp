@@ -0,0 +1,370 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <unordered_set>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/messaging/ReplicateQueue.h>
+#include <openr/prefix-manager/PrefixManager.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes parameters to another one, with a custom name for
+ * the parameters.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace {
+
+const std::string kNodeName{"node-1"};
+const std::string kConfigStorePath{"/tmp/pm_benchmark_config_store.bin"};
+// Type of all the prefixes advertised by benchmarks
+const openr::thrift::PrefixType kPrefixType{openr::thrift::PrefixType::BGP};
+// Fraction of prefixes replaced with every sync of sync benchmarks
+const double kSyncChurnRatio = 0.1;
+
+// Number of heap allocations made by the benchmark process
+std::atomic<uint64_t> numAllocations{0};
+
+} // anonymous namespace
+
+// Count allocations, reported by all the benchmarks
+void*
+operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /* size */) noexcept {
+  std::free(ptr);
+}
+
+namespace openr {
+
+namespace {
+
+enum class PrefixOperation {
+  ADVERTISE = 0,
+  WITHDRAW = 1,
+  SYNC_BY_TYPE = 2,
+};
+
+// Prefixes [offset, offset + numOfPrefixes) of kPrefixType
+std::vector<thrift::PrefixEntry>
+createPrefixEntries(size_t numOfPrefixes, size_t offset = 0) {
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  prefixEntries.reserve(numOfPrefixes);
+  for (size_t i = offset; i < offset + numOfPrefixes; ++i) {
+    prefixEntries.emplace_back(createPrefixEntry(
+        toIpPrefix(folly::sformat(
+            "fc00:{:x}:{:x}::/64", (i >> 16) & 0xffff, i & 0xffff)),
+        kPrefixType));
+  }
+  return prefixEntries;
+}
+
+/**
+ * PrefixManager advertising into KvStore, with the config store it persists
+ * prefixes into. KvStore publications tell when an operation reached KvStore
+ */
+class PrefixManagerBenchmarkFixture {
+ public:
+  explicit PrefixManagerBenchmarkFixture(bool perPrefixKeys)
+      : perPrefixKeys_(perPrefixKeys) {
+    configStore_ = std::make_unique<PersistentStore>(
+        "1",
+        kConfigStorePath,
+        context_,
+        true /* dryrun */,
+        false /* periodicallySaveToDisk */);
+    configStoreThread_ = std::thread([this]() { configStore_->run(); });
+    configStore_->waitUntilRunning();
+
+    config_ = std::make_shared<Config>(getBasicOpenrConfig(kNodeName));
+    kvStoreWrapper_ = std::make_unique<KvStoreWrapper>(context_, config_);
+    kvStoreWrapper_->run();
+
+    prefixManager_ = std::make_unique<PrefixManager>(
+        prefixUpdatesQueue_.getReader(),
+        config_,
+        configStore_.get(),
+        kvStoreWrapper_->getKvStore(),
+        false /* enablePerfMeasurement */,
+        std::chrono::seconds(0) /* prefixHoldTime */,
+        perPrefixKeys_);
+    prefixManagerThread_ = std::thread([this]() { prefixManager_->run(); });
+    prefixManager_->waitUntilRunning();
+
+    // empty prefix database gets advertised right away with single key
+    if (not perPrefixKeys_) {
+      waitForKeys({});
+    }
+  }
+
+  ~PrefixManagerBenchmarkFixture() {
+    prefixUpdatesQueue_.close();
+    kvStoreWrapper_->closeQueue();
+
+    prefixManager_->stop();
+    prefixManagerThread_.join();
+    prefixManager_.reset();
+
+    configStore_->stop();
+    configStoreThread_.join();
+    configStore_.reset();
+
+    kvStoreWrapper_->stop();
+    kvStoreWrapper_.reset();
+  }
+
+  PrefixManager*
+  getPrefixManager() {
+    return prefixManager_.get();
+  }
+
+  // Wait till KvStore publishes keys of all the prefixes, or the prefix
+  // database with single key
+  void
+  waitForKeys(std::vector<thrift::PrefixEntry> const& prefixEntries) {
+    std::unordered_set<std::string> pendingKeys;
+    if (perPrefixKeys_) {
+      for (auto const& prefixEntry : prefixEntries) {
+        pendingKeys.emplace(
+            PrefixKey(kNodeName, toIPNetwork(prefixEntry.prefix))
+                .getPrefixKey());
+      }
+    } else {
+      pendingKeys.emplace(folly::sformat(
+          "{}{}", Constants::kPrefixDbMarker.toString(), kNodeName));
+    }
+
+    while (not pendingKeys.empty()) {
+      auto publication = kvStoreWrapper_->recvPublication();
+      for (auto const& [key, value] : publication.keyVals) {
+        // skip ttl refreshes
+        if (value.value_ref().has_value()) {
+          pendingKeys.erase(key);
+        }
+      }
+    }
+  }
+
+ private:
+  const bool perPrefixKeys_{false};
+
+  fbzmq::Context context_;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
+
+  std::shared_ptr<Config> config_;
+  std::unique_ptr<PersistentStore> configStore_;
+  std::thread configStoreThread_;
+  std::unique_ptr<KvStoreWrapper> kvStoreWrapper_;
+  std::unique_ptr<PrefixManager> prefixManager_;
+  std::thread prefixManagerThread_;
+};
+
+/**
+ * Measure latency of a prefix operation, from API call till its keys are
+ * published by KvStore. Allocations are counted across all the threads, i.e.
+ * include the ones of KvStore and config store which the operation caused.
+ */
+void
+runPrefixOperation(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfPrefixes,
+    bool perPrefixKeys,
+    PrefixOperation operation) {
+  auto suspender = folly::BenchmarkSuspender();
+  PrefixManagerBenchmarkFixture fixture(perPrefixKeys);
+  auto prefixManager = fixture.getPrefixManager();
+  const auto prefixEntries = createPrefixEntries(numOfPrefixes);
+
+  // Syncs alternate between the prefixes and a copy with a fraction of them
+  // replaced, which is what gets updated in KvStore with every sync
+  const size_t numOfReplaced = numOfPrefixes * kSyncChurnRatio;
+  const auto newEntries = createPrefixEntries(numOfReplaced, numOfPrefixes);
+  auto churnedEntries = prefixEntries;
+  std::copy(newEntries.begin(), newEntries.end(), churnedEntries.begin());
+  auto replacedEntries = newEntries;
+  replacedEntries.insert(
+      replacedEntries.end(),
+      prefixEntries.begin(),
+      prefixEntries.begin() + numOfReplaced);
+
+  if (operation == PrefixOperation::SYNC_BY_TYPE) {
+    prefixManager->advertisePrefixes(prefixEntries).get();
+    fixture.waitForKeys(prefixEntries);
+  }
+
+  uint64_t allocations{0};
+  for (uint32_t i = 0; i < iters; ++i) {
+    if (operation == PrefixOperation::WITHDRAW) {
+      prefixManager->advertisePrefixes(prefixEntries).get();
+      fixture.waitForKeys(prefixEntries);
+    }
+
+    suspender.dismiss();
+    const auto allocationsBefore = numAllocations.load();
+    switch (operation) {
+    case PrefixOperation::ADVERTISE:
+      prefixManager->advertisePrefixes(prefixEntries).get();
+      fixture.waitForKeys(prefixEntries);
+      break;
+    case PrefixOperation::WITHDRAW:
+      // withdrawn prefix keys are published with deleted prefix entry
+      prefixManager->withdrawPrefixes(prefixEntries).get();
+      fixture.waitForKeys(prefixEntries);
+      break;
+    case PrefixOperation::SYNC_BY_TYPE:
+      prefixManager
+          ->syncPrefixesByType(
+              kPrefixType, i % 2 == 0 ? churnedEntries : prefixEntries)
+          .get();
+      fixture.waitForKeys(replacedEntries);
+      break;
+    }
+    allocations += numAllocations.load() - allocationsBefore;
+    suspender.rehire();
+
+    if (operation == PrefixOperation::ADVERTISE) {
+      prefixManager->withdrawPrefixes(prefixEntries).get();
+      fixture.waitForKeys(prefixEntries);
+    }
+  }
+
+  counters["allocs_per_prefix"] = allocations / (iters * numOfPrefixes);
+}
+
+void
+BM_PrefixManagerAdvertise(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfPrefixes,
+    bool perPrefixKeys) {
+  runPrefixOperation(
+      counters,
+      iters,
+      numOfPrefixes,
+      perPrefixKeys,
+      PrefixOperation::ADVERTISE);
+}
+
+void
+BM_PrefixManagerWithdraw(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfPrefixes,
+    bool perPrefixKeys) {
+  runPrefixOperation(
+      counters,
+      iters,
+      numOfPrefixes,
+      perPrefixKeys,
+      PrefixOperation::WITHDRAW);
+}
+
+void
+BM_PrefixManagerSyncByType(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfPrefixes,
+    bool perPrefixKeys) {
+  runPrefixOperation(
+      counters,
+      iters,
+      numOfPrefixes,
+      perPrefixKeys,
+      PrefixOperation::SYNC_BY_TYPE);
+}
+
+} // namespace
+
+// The parameters are number of prefixes, and whether prefixes are advertised
+// with a key per prefix
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 10000, 10000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 100000, 100000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 500000, 500000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 10000_PerPrefixKeys, 10000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 100000_PerPrefixKeys, 100000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerAdvertise, counters, 500000_PerPrefixKeys, 500000, true);
+
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 10000, 10000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 100000, 100000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 500000, 500000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 10000_PerPrefixKeys, 10000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 100000_PerPrefixKeys, 100000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerWithdraw, counters, 500000_PerPrefixKeys, 500000, true);
+
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 10000, 10000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 100000, 100000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 500000, 500000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 10000_PerPrefixKeys, 10000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 100000_PerPrefixKeys, 100000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixManagerSyncByType, counters, 500000_PerPrefixKeys, 500000, true);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -235,6 +235,45 @@ TEST_F(PrefixManagerTestFixture, AddRemovePrefix) {
   EXPECT_TRUE(prefixManager->withdrawPrefixes({ephemeralPrefixEntry9}).get());
 }
 
+TEST_F(PrefixManagerTestFixture, PrefixUpdateBatches) {
+  const auto type = thrift::PrefixType::BGP;
+  EXPECT_EQ(0, prefixManager->getPrefixUpdateSeqNum(type).get());
+
+  // type of entries is set to type of the batch
+  thrift::PrefixUpdateBatch batch;
+  batch.seqNum = 1;
+  batch.addPrefixes = {prefixEntry1, ephemeralPrefixEntry9};
+  EXPECT_EQ(1, prefixManager->applyPrefixUpdateBatch(type, batch).get());
+  auto prefixes = prefixManager->getPrefixesByType(type).get();
+  EXPECT_EQ(2, prefixes->size());
+  for (auto const& entry : *prefixes) {
+    EXPECT_EQ(type, entry.type);
+  }
+
+  // replayed batch is ignored
+  batch.addPrefixes = {prefixEntry3};
+  EXPECT_EQ(1, prefixManager->applyPrefixUpdateBatch(type, batch).get());
+  EXPECT_EQ(2, prefixManager->getPrefixesByType(type).get()->size());
+
+  // unknown withdrawals are ignored
+  batch.seqNum = 5;
+  batch.withdrawPrefixes = {addr1, addr2};
+  EXPECT_EQ(5, prefixManager->applyPrefixUpdateBatch(type, batch).get());
+  prefixes = prefixManager->getPrefixesByType(type).get();
+  ASSERT_EQ(2, prefixes->size());
+  std::unordered_set<thrift::IpPrefix> advertised;
+  for (auto const& entry : *prefixes) {
+    advertised.emplace(entry.prefix);
+  }
+  EXPECT_EQ((std::unordered_set<thrift::IpPrefix>{addr3, addr9}), advertised);
+  EXPECT_EQ(5, prefixManager->getPrefixUpdateSeqNum(type).get());
+
+  // sequence of other types is independent
+  EXPECT_EQ(
+      0,
+      prefixManager->getPrefixUpdateSeqNum(thrift::PrefixType::DEFAULT).get());
+}
+
 TEST_F(PrefixManagerTestFixture, RemoveUpdateType) {
   EXPECT_TRUE(prefixManager->advertisePrefixes({prefixEntry1}).get());
   EXPECT_TRUE(prefixManager->advertisePrefixes({prefixEntry2}).get());
@@ -372,13 +411,14 @@ TEST_F(PrefixManagerTestFixture, VerifyKvStore) {
       std::chrono::milliseconds(
           scheduleAt += Constants::kPrefixMgrKvThrottleTimeout.count() / 2),
       [&]() {
-        // Verify that before throttle expires, we don't see any update
+        // Verify that before throttle expires, we only see the first update
+        // (withdrawal), synced on leading edge of the throttle
         auto maybeValue1 = kvStoreClient->getKey(keyStr);
         EXPECT_TRUE(maybeValue1.has_value());
         auto db1 = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
             maybeValue1.value().value_ref().value(), serializer);
         auto prefixDb = getPrefixDb("prefix:node-1");
-        EXPECT_EQ(prefixDb.size(), 1);
+        EXPECT_EQ(prefixDb.size(), 0);
         ASSERT_TRUE(db.perfEvents_ref().has_value());
         ASSERT_FALSE(db.perfEvents_ref()->events.empty());
         {
@@ -1036,6 +1076,217 @@ TEST(PrefixManagerTest, HoldTimeout) {
   configStoreThread.join();
 }
 
+// Verify that single prefix db is patched with only the changed prefixes when
+// per prefix keys are disabled
+TEST(PrefixManagerTest, PrefixDbIncrementalUpdate) {
+  fbzmq::Context context;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue;
+
+  // spin up a config store
+  auto configStore = std::make_unique<PersistentStore>(
+      "1",
+      folly::sformat(
+          "/tmp/pm_ut_config_store.bin.{}",
+          std::hash<std::thread::id>{}(std::this_thread::get_id())),
+      context,
+      true);
+  std::thread configStoreThread([&]() noexcept {
+    LOG(INFO) << "ConfigStore thread starting";
+    configStore->run();
+    LOG(INFO) << "ConfigStore thread finishing";
+  });
+  configStore->waitUntilRunning();
+
+  // spin up a kvstore
+  auto tConfig = getBasicOpenrConfig("node-1");
+  tConfig.kvstore_config.sync_interval_s = 1;
+  auto config = std::make_shared<Config>(tConfig);
+  auto kvStoreWrapper = std::make_unique<KvStoreWrapper>(context, config);
+  kvStoreWrapper->run();
+  LOG(INFO) << "The test KV store is running";
+
+  auto prefixManager = std::make_unique<PrefixManager>(
+      prefixUpdatesQueue.getReader(),
+      config,
+      configStore.get(),
+      kvStoreWrapper->getKvStore(),
+      false /* prefix-mananger perf measurement */,
+      std::chrono::seconds{0},
+      false /* perPrefixKeys */);
+  std::thread prefixManagerThread([&]() {
+    LOG(INFO) << "PrefixManager thread starting";
+    prefixManager->run();
+    LOG(INFO) << "PrefixManager thread finishing";
+  });
+  prefixManager->waitUntilRunning();
+
+  CompactSerializer serializer;
+  // wait for prefix db with expected entries to be advertised
+  auto waitForPrefixDb =
+      [&](std::vector<thrift::PrefixEntry> const& expectedEntries) {
+        while (true) {
+          auto publication = kvStoreWrapper->recvPublication();
+          auto it = publication.keyVals.find("prefix:node-1");
+          if (it == publication.keyVals.end()) {
+            continue;
+          }
+          auto const prefixDb =
+              fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+                  it->second.value_ref().value(), serializer);
+          if (prefixDb.prefixEntries.size() == expectedEntries.size()) {
+            EXPECT_THAT(
+                prefixDb.prefixEntries,
+                testing::UnorderedElementsAreArray(expectedEntries));
+            return;
+          }
+        }
+      };
+
+  // initial sync advertises empty db
+  waitForPrefixDb({});
+
+  prefixManager
+      ->advertisePrefixes({prefixEntry1, prefixEntry2, prefixEntry3})
+      .get();
+  waitForPrefixDb({prefixEntry1, prefixEntry2, prefixEntry3});
+
+  // withdraw of first entry moves last entry in its place
+  prefixManager->withdrawPrefixes({prefixEntry1}).get();
+  waitForPrefixDb({prefixEntry2, prefixEntry3});
+
+  // update of existing entry is patched in place
+  auto prefixEntry3Updated = prefixEntry3;
+  prefixEntry3Updated.forwardingType = thrift::PrefixForwardingType::SR_MPLS;
+  prefixManager->advertisePrefixes({prefixEntry3Updated, prefixEntry4}).get();
+  waitForPrefixDb({prefixEntry2, prefixEntry3Updated, prefixEntry4});
+
+  prefixManager->withdrawPrefixesByType(thrift::PrefixType::PREFIX_ALLOCATOR)
+      .get();
+  waitForPrefixDb({prefixEntry3Updated});
+
+  // Stop the test
+  prefixUpdatesQueue.close();
+  kvStoreWrapper->closeQueue();
+  prefixManager->stop();
+  prefixManagerThread.join();
+  kvStoreWrapper->stop();
+  configStore->stop();
+  configStoreThread.join();
+}
+
+// Verify that prefixes covered by summary of an area are replaced by the
+// summary in that area only, for as long as any of them is advertised
+TEST(PrefixManagerTest, AreaSummaryPrefixes) {
+  fbzmq::Context context;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue;
+
+  // spin up a config store
+  auto configStore = std::make_unique<PersistentStore>(
+      "1",
+      folly::sformat(
+          "/tmp/pm_ut_config_store.bin.{}",
+          std::hash<std::thread::id>{}(std::this_thread::get_id())),
+      context,
+      true);
+  std::thread configStoreThread([&]() noexcept {
+    LOG(INFO) << "ConfigStore thread starting";
+    configStore->run();
+    LOG(INFO) << "ConfigStore thread finishing";
+  });
+  configStore->waitUntilRunning();
+
+  // spin up a kvstore with area "b" summarizing addr5 and addr6
+  const auto summary = toIpPrefix("ffff:10::/32");
+  thrift::AreaConfig areaA, areaB;
+  areaA.area_id = "a";
+  areaA.neighbor_regexes = {".*"};
+  areaB.area_id = "b";
+  areaB.neighbor_regexes = {".*"};
+  areaB.summary_prefixes = {toString(summary)};
+  auto tConfig = getBasicOpenrConfig(
+      "node-1",
+      "domain",
+      std::make_unique<std::vector<thrift::AreaConfig>>(
+          std::vector<thrift::AreaConfig>{areaA, areaB}));
+  tConfig.kvstore_config.sync_interval_s = 1;
+  auto config = std::make_shared<Config>(tConfig);
+  auto kvStoreWrapper = std::make_unique<KvStoreWrapper>(context, config);
+  kvStoreWrapper->run();
+  LOG(INFO) << "The test KV store is running";
+
+  auto prefixManager = std::make_unique<PrefixManager>(
+      prefixUpdatesQueue.getReader(),
+      config,
+      configStore.get(),
+      kvStoreWrapper->getKvStore(),
+      false /* prefix-mananger perf measurement */,
+      std::chrono::seconds{0});
+  std::thread prefixManagerThread([&]() {
+    LOG(INFO) << "PrefixManager thread starting";
+    prefixManager->run();
+    LOG(INFO) << "PrefixManager thread finishing";
+  });
+  prefixManager->waitUntilRunning();
+
+  CompactSerializer serializer;
+  auto isAdvertised = [&](thrift::IpPrefix const& prefix,
+                          std::string const& area) {
+    auto const key = PrefixKey(
+                         "node-1",
+                         toIPNetwork(prefix),
+                         thrift::KvStore_constants::kDefaultArea())
+                         .getPrefixKey();
+    auto value = kvStoreWrapper->getKey(key, area);
+    if (not value.has_value() or not value->value_ref().has_value()) {
+      return false;
+    }
+    return not fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+                   value->value_ref().value(), serializer)
+                   .deletePrefix;
+  };
+  // wait for advertised prefixes of the area to be exactly the expected ones
+  auto waitForPrefixes = [&](std::string const& area,
+                             std::vector<thrift::IpPrefix> const& expected) {
+    std::vector<thrift::IpPrefix> all{addr1, addr5, addr6, summary};
+    while (true) {
+      bool matched = true;
+      for (auto const& prefix : all) {
+        bool const shouldAdvertise =
+            std::count(expected.begin(), expected.end(), prefix);
+        matched &= (shouldAdvertise == isAdvertised(prefix, area));
+      }
+      if (matched) {
+        return;
+      }
+      kvStoreWrapper->recvPublication();
+    }
+  };
+
+  prefixManager
+      ->advertisePrefixes({prefixEntry1, prefixEntry5, prefixEntry6})
+      .get();
+  waitForPrefixes("a", {addr1, addr5, addr6});
+  waitForPrefixes("b", {addr1, summary});
+
+  // summary stays while any covered prefix is advertised
+  prefixManager->withdrawPrefixes({prefixEntry5}).get();
+  waitForPrefixes("a", {addr1, addr6});
+  waitForPrefixes("b", {addr1, summary});
+
+  prefixManager->withdrawPrefixes({prefixEntry6}).get();
+  waitForPrefixes("a", {addr1});
+  waitForPrefixes("b", {addr1});
+
+  // Stop the test
+  prefixUpdatesQueue.close();
+  kvStoreWrapper->closeQueue();
+  prefixManager->stop();
+  prefixManagerThread.join();
+  kvStoreWrapper->stop();
+  configStore->stop();
+  configStoreThread.join();
+}
+
 // Verify that persist store is updated only when
 // non-ephemeral types are effected
 TEST_F(PrefixManagerTestFixture, CheckPersistStoreUpdate) {
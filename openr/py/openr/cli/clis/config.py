@@ -19,6 +19,7 @@ class ConfigCli(object):
     def __init__(self):
         self.config.add_command(ConfigShowCli().show, name="show")
         self.config.add_command(ConfigDryRunCli().dryrun, name="dryrun")
+        self.config.add_command(ConfigReloadCli().reload, name="reload")
         self.config.add_command(ConfigCompareCli().compare, name="compare")
         self.config.add_command(
             ConfigPrefixAllocatorCli().config_prefix_allocator,
@@ -59,6 +60,18 @@ class ConfigDryRunCli(object):
         config.ConfigDryRunCmd(cli_opts).run(file)
 
 
+class ConfigReloadCli(object):
+    @click.command()
+    @click.argument("file")
+    @click.pass_obj
+    def reload(cli_opts, file):  # noqa: B902
+        """ Reload openr config without restart, output running config upon
+        success. Only area regexes, eor_time_s, Spark timers and KvStore flood
+        rate can be changed at runtime"""
+
+        config.ConfigReloadCmd(cli_opts).run(file)
+
+
 class ConfigCompareCli(object):
     @click.command()
     @click.argument("file")
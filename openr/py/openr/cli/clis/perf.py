@@ -18,6 +18,7 @@ from openr.cli.utils.options import breeze_option
 class PerfCli(object):
     def __init__(self):
         self.perf.add_command(ViewFibCli().fib)
+        self.perf.add_command(ViewConvergenceCli().convergence)
 
     @click.group()
     @click.pass_context
@@ -33,3 +34,12 @@ class ViewFibCli(object):
         """ View latest perf log of fib module from this node """
 
         perf.ViewFibCmd(cli_opts).run()
+
+
+class ViewConvergenceCli(object):
+    @click.command()
+    @click.pass_obj
+    def convergence(cli_opts):  # noqa: B902
+        """ View percentiles of convergence latencies of this node """
+
+        perf.ViewConvergenceCmd(cli_opts).run()
@@ -43,6 +43,19 @@ class ConfigDryRunCmd(OpenrCtrlCmd):
         utils.print_json(config)
 
 
+class ConfigReloadCmd(OpenrCtrlCmd):
+    def _run(self, client: OpenrCtrl.Client, file: str):
+        try:
+            file_conf = client.reloadConfig(file)
+        except OpenrError as ex:
+            click.echo(click.style("FAILED: {}".format(ex), fg="red"))
+            return
+
+        click.echo(click.style("RELOADED", fg="green"))
+        config = json.loads(file_conf)
+        utils.print_json(config)
+
+
 class ConfigCompareCmd(OpenrCtrlCmd):
     def _run(self, client: OpenrCtrl.Client, file: str):
         running_conf = client.getRunningConfig()
@@ -33,3 +33,27 @@ class ViewFibCmd(OpenrCtrlCmd):
             print("Perf Event Item: {}, total duration: {}ms".format(i, total_duration))
             print(tabulate.tabulate(rows, headers=headers))
             print()
+
+
+class ViewConvergenceCmd(OpenrCtrlCmd):
+    def _run(self, client: OpenrCtrl.Client) -> None:
+        resp = client.getConvergenceStats()
+        headers = ["Stage", "Count", "P50 (ms)", "P90 (ms)", "P99 (ms)", "Max (ms)"]
+        for stats in resp:
+            rows = []
+            for name, latency in [("END_TO_END", stats.endToEnd)] + sorted(
+                stats.stages.items()
+            ):
+                rows.append(
+                    [
+                        name,
+                        latency.count,
+                        latency.p50,
+                        latency.p90,
+                        latency.p99,
+                        latency.max,
+                    ]
+                )
+            print("Convergence triggered by: {}".format(stats.eventType))
+            print(tabulate.tabulate(rows, headers=headers))
+            print()
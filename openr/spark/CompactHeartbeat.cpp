@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CompactHeartbeat.h"
+
+#include <cstring>
+
+#include <folly/Bits.h>
+
+namespace {
+
+const uint8_t kCompactHeartbeatMarker = 0xFF;
+const uint8_t kCompactHeartbeatFormat = 1;
+const size_t kCompactHeartbeatHeaderSize = 12;
+
+} // namespace
+
+namespace openr {
+
+std::string
+encodeCompactHeartbeat(std::string const& nodeName, int64_t seqNum) {
+  std::string packet(kCompactHeartbeatHeaderSize + nodeName.size(), '\0');
+  auto data = reinterpret_cast<unsigned char*>(&packet[0]);
+  data[0] = kCompactHeartbeatMarker;
+  data[1] = kCompactHeartbeatFormat;
+  const uint16_t nameLen =
+      folly::Endian::big(static_cast<uint16_t>(nodeName.size()));
+  ::memcpy(data + 2, &nameLen, sizeof(nameLen));
+  const uint64_t seq = folly::Endian::big(static_cast<uint64_t>(seqNum));
+  ::memcpy(data + 4, &seq, sizeof(seq));
+  ::memcpy(
+      data + kCompactHeartbeatHeaderSize, nodeName.data(), nodeName.size());
+  return packet;
+}
+
+bool
+isCompactHeartbeat(const unsigned char* buf, size_t len) {
+  return len > 0 and buf[0] == kCompactHeartbeatMarker;
+}
+
+std::optional<thrift::SparkHeartbeatMsg>
+decodeCompactHeartbeat(const unsigned char* buf, size_t len) {
+  if (len < kCompactHeartbeatHeaderSize or
+      buf[1] != kCompactHeartbeatFormat) {
+    return std::nullopt;
+  }
+  uint16_t nameLen;
+  ::memcpy(&nameLen, buf + 2, sizeof(nameLen));
+  nameLen = folly::Endian::big(nameLen);
+  if (len != kCompactHeartbeatHeaderSize + nameLen) {
+    return std::nullopt;
+  }
+  uint64_t seq;
+  ::memcpy(&seq, buf + 4, sizeof(seq));
+
+  thrift::SparkHeartbeatMsg heartbeatMsg;
+  heartbeatMsg.nodeName.assign(
+      reinterpret_cast<const char*>(buf + kCompactHeartbeatHeaderSize),
+      nameLen);
+  heartbeatMsg.seqNum = static_cast<int64_t>(folly::Endian::big(seq));
+  return heartbeatMsg;
+}
+
+} // namespace openr
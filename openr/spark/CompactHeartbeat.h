@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <openr/if/gen-cpp2/Spark_types.h>
+
+namespace openr {
+
+/**
+ * Compact heartbeat encoding, used towards neighbors advertising version
+ * kSparkCompactHeartbeatVersion or later, and by fast liveness detection.
+ * Fixed layout, network byte order:
+ *
+ *   | marker (1) | format (1) | nodeName len (2) | seqNum (8) | nodeName |
+ *
+ * Marker can't be the first byte of thrift::SparkHelloPacket serialized with
+ * compact protocol (field header with invalid type), hence the first byte
+ * tells compact heartbeat apart from thrift packets.
+ */
+
+std::string encodeCompactHeartbeat(std::string const& nodeName, int64_t seqNum);
+
+bool isCompactHeartbeat(const unsigned char* buf, size_t len);
+
+// Returns std::nullopt for malformed packet
+std::optional<thrift::SparkHeartbeatMsg> decodeCompactHeartbeat(
+    const unsigned char* buf, size_t len);
+
+} // namespace openr
@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "FastLiveness.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <fb303/ServiceData.h>
+#include <folly/ExceptionString.h>
+#include <folly/String.h>
+#include <folly/system/ThreadName.h>
+#include <glog/logging.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/Util.h>
+
+#include "CompactHeartbeat.h"
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+// heartbeats are tiny, anything bigger is not a heartbeat
+const size_t kMaxPacketSize = 1280;
+
+// maximum number of packets read with single syscall
+const size_t kMaxPacketsPerRead = 32;
+
+// the acceptable hop limit, as heartbeats are sent with this TTL
+const int kHopLimit = 255;
+
+} // namespace
+
+namespace openr {
+
+FastLiveness::FastLiveness(
+    std::string const& myNodeName,
+    thrift::SparkFastLivenessConfig const& config,
+    std::optional<thrift::ThreadSchedulingConfig> scheduling,
+    std::shared_ptr<IoProvider> ioProvider,
+    DownCallback downCallback)
+    : myNodeName_(myNodeName),
+      port_(static_cast<uint16_t>(config.port)),
+      interval_(config.interval_ms),
+      detectMultiplier_(static_cast<uint32_t>(config.detect_multiplier)),
+      scheduling_(std::move(scheduling)),
+      ioProvider_(std::move(ioProvider)),
+      downCallback_(std::move(downCallback)),
+      recvBuffers_(kMaxPacketsPerRead, kMaxPacketSize) {
+  CHECK(interval_ > std::chrono::milliseconds(0))
+      << "Fast liveness interval can't be 0";
+  CHECK(ioProvider_) << "Got null IoProvider";
+
+  fb303::fbData->addStatExportType(
+      "spark.fast_liveness.packets_sent", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "spark.fast_liveness.packets_recv", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "spark.fast_liveness.neighbor_down", fb303::SUM);
+
+  prepareSocket();
+  thread_ = std::thread([this]() { run(); });
+}
+
+FastLiveness::~FastLiveness() {
+  stopped_ = true;
+  thread_.join();
+}
+
+void
+FastLiveness::prepareSocket() {
+  fd_ = ioProvider_->socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd_ < 0) {
+    LOG(FATAL) << "Failed creating fast liveness UDP socket. Error: "
+               << folly::errnoStr(errno);
+  }
+
+  if (ioProvider_->fcntl(fd_, F_SETFL, O_NONBLOCK) != 0) {
+    LOG(FATAL) << "Failed making the socket non-blocking. Error: "
+               << folly::errnoStr(errno);
+  }
+
+  const int enabled = 1;
+  if (ioProvider_->setsockopt(
+          fd_, IPPROTO_IPV6, IPV6_V6ONLY, &enabled, sizeof(enabled)) != 0 or
+      ioProvider_->setsockopt(
+          fd_, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled)) != 0 or
+      ioProvider_->setsockopt(
+          fd_, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enabled, sizeof(enabled)) !=
+          0 or
+      ioProvider_->setsockopt(
+          fd_, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &enabled, sizeof(enabled)) !=
+          0) {
+    LOG(FATAL) << "Failed setting options of fast liveness socket. Error: "
+               << folly::errnoStr(errno);
+  }
+
+  // set the TTL to maximum, so we can check for spoofed addresses, and don't
+  // loop heartbeats back to ourselves
+  const int ttl = kHopLimit;
+  const int loop = 0;
+  if (ioProvider_->setsockopt(
+          fd_, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &ttl, sizeof(ttl)) != 0 or
+      ioProvider_->setsockopt(
+          fd_, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &loop, sizeof(loop)) != 0) {
+    LOG(FATAL) << "Failed setting multicast options of fast liveness socket. "
+               << "Error: " << folly::errnoStr(errno);
+  }
+
+  auto sockAddr = folly::SocketAddress(folly::IPAddress("::"), port_);
+  sockaddr_storage addrStorage;
+  sockAddr.getAddress(&addrStorage);
+  if (ioProvider_->bind(
+          fd_,
+          reinterpret_cast<sockaddr*>(&addrStorage),
+          sockAddr.getActualSize()) != 0) {
+    LOG(FATAL) << "Failed binding fast liveness socket to port " << port_
+               << ". Error: " << folly::errnoStr(errno);
+  }
+  LOG(INFO) << "Created fast liveness socket on port " << port_
+            << ", interval: " << interval_.count()
+            << "ms, detect multiplier: " << detectMultiplier_;
+}
+
+void
+FastLiveness::addInterface(
+    std::string const& ifName,
+    int ifIndex,
+    folly::IPAddressV6 const& v6LinkLocalAddr) {
+  const auto mcastGroup =
+      folly::IPAddress(Constants::kSparkMcastAddr.toString());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = interfaces_.find(ifName);
+  if (it != interfaces_.end() and it->second.ifIndex != ifIndex) {
+    IoProvider::toggleMcastGroup(
+        fd_, mcastGroup, it->second.ifIndex, false, ioProvider_.get());
+  }
+  if (it == interfaces_.end() or it->second.ifIndex != ifIndex) {
+    if (not IoProvider::toggleMcastGroup(
+            fd_, mcastGroup, ifIndex, true, ioProvider_.get())) {
+      LOG(ERROR) << "Fast liveness failed joining multicast group on "
+                 << ifName << ": " << folly::errnoStr(errno);
+    }
+  }
+  interfaces_[ifName] = Interface{ifIndex, v6LinkLocalAddr};
+}
+
+void
+FastLiveness::removeInterface(std::string const& ifName) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = interfaces_.find(ifName);
+  if (it == interfaces_.end()) {
+    return;
+  }
+  IoProvider::toggleMcastGroup(
+      fd_,
+      folly::IPAddress(Constants::kSparkMcastAddr.toString()),
+      it->second.ifIndex,
+      false /* leave */,
+      ioProvider_.get());
+  interfaces_.erase(it);
+
+  // neighbors are ordered by interface first
+  auto neighborIt = neighbors_.lower_bound(NeighborKey{ifName, ""});
+  while (neighborIt != neighbors_.end() and neighborIt->first.first == ifName) {
+    neighborIt = neighbors_.erase(neighborIt);
+  }
+}
+
+void
+FastLiveness::addNeighbor(
+    std::string const& ifName,
+    std::string const& neighborName,
+    std::chrono::milliseconds remoteInterval) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& neighbor = neighbors_[NeighborKey{ifName, neighborName}];
+  neighbor.detectTime = detectMultiplier_ * std::max(interval_, remoteInterval);
+  neighbor.lastHeartbeatTime = std::chrono::steady_clock::now();
+  LOG(INFO) << "Fast liveness monitoring neighbor " << neighborName << " on "
+            << ifName << ", detect time: " << neighbor.detectTime.count()
+            << "ms";
+}
+
+void
+FastLiveness::removeNeighbor(
+    std::string const& ifName, std::string const& neighborName) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  neighbors_.erase(NeighborKey{ifName, neighborName});
+}
+
+bool
+FastLiveness::isMonitoring(
+    std::string const& ifName, std::string const& neighborName) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return neighbors_.count(NeighborKey{ifName, neighborName}) != 0;
+}
+
+void
+FastLiveness::run() {
+  folly::setThreadName(kThreadName.str());
+  if (scheduling_.has_value()) {
+    applyThreadScheduling(kThreadName.str(), *scheduling_);
+  }
+
+  auto nextSendTime = std::chrono::steady_clock::now();
+  while (not stopped_) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= nextSendTime) {
+      sendHeartbeats();
+      nextSendTime = now + interval_;
+    }
+    checkNeighbors();
+
+    // wake up for the next heartbeat to send, or as soon as any arrives.
+    // Neighbors are checked at least once per interval this way
+    struct pollfd pfd {};
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(
+        nextSendTime - std::chrono::steady_clock::now());
+    if (::poll(&pfd, 1, std::max<int>(0, timeout.count())) > 0 and
+        (pfd.revents & POLLIN)) {
+      try {
+        processPackets();
+      } catch (std::exception const& err) {
+        LOG(ERROR) << "Fast liveness: error receiving heartbeats "
+                   << folly::exceptionStr(err);
+      }
+    }
+  }
+}
+
+void
+FastLiveness::sendHeartbeats() {
+  std::vector<std::pair<int, folly::IPAddressV6>> ifaces;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& [ifName, iface] : interfaces_) {
+      // skip interfaces without any monitored neighbor
+      auto it = neighbors_.lower_bound(NeighborKey{ifName, ""});
+      if (it == neighbors_.end() or it->first.first != ifName) {
+        continue;
+      }
+      ifaces.emplace_back(iface.ifIndex, iface.v6LinkLocalAddr);
+    }
+  }
+  if (ifaces.empty()) {
+    return;
+  }
+
+  const folly::SocketAddress dstAddr(
+      folly::IPAddress(Constants::kSparkMcastAddr.toString()), port_);
+  const auto bytesSent = IoProvider::sendMessages(
+      fd_,
+      ifaces,
+      dstAddr,
+      encodeCompactHeartbeat(myNodeName_, seqNum_++),
+      ioProvider_.get());
+  const auto packetsSent =
+      std::count_if(bytesSent.cbegin(), bytesSent.cend(), [](ssize_t bytes) {
+        return bytes > 0;
+      });
+  fb303::fbData->addStatValue(
+      "spark.fast_liveness.packets_sent", packetsSent, fb303::SUM);
+}
+
+void
+FastLiveness::processPackets() {
+  const auto messages =
+      IoProvider::recvMessages(fd_, recvBuffers_, ioProvider_.get());
+  const auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < messages.size(); ++i) {
+    auto const& [bytesRead, ifIndex, srcAddr, hopLimit, recvTime, tsSource] =
+        messages.at(i);
+    if (bytesRead <= 0 or hopLimit < kHopLimit) {
+      continue;
+    }
+    auto const* buf = recvBuffers_.getData(i);
+    if (not isCompactHeartbeat(buf, bytesRead)) {
+      continue;
+    }
+    auto heartbeatMsg = decodeCompactHeartbeat(buf, bytesRead);
+    if (not heartbeatMsg.has_value()) {
+      continue;
+    }
+    fb303::fbData->addStatValue(
+        "spark.fast_liveness.packets_recv", 1, fb303::SUM);
+
+    auto ifIt = std::find_if(
+        interfaces_.cbegin(), interfaces_.cend(), [&](auto const& kv) {
+          return kv.second.ifIndex == ifIndex;
+        });
+    if (ifIt == interfaces_.cend()) {
+      continue;
+    }
+    auto it = neighbors_.find(NeighborKey{ifIt->first, heartbeatMsg->nodeName});
+    if (it != neighbors_.end()) {
+      it->second.lastHeartbeatTime = now;
+    }
+  }
+}
+
+void
+FastLiveness::checkNeighbors() {
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<NeighborKey> downNeighbors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = neighbors_.begin(); it != neighbors_.end();) {
+      if (now - it->second.lastHeartbeatTime <= it->second.detectTime) {
+        ++it;
+        continue;
+      }
+      downNeighbors.emplace_back(it->first);
+      it = neighbors_.erase(it);
+    }
+  }
+
+  for (auto const& [ifName, neighborName] : downNeighbors) {
+    LOG(INFO) << "Fast liveness detected neighbor " << neighborName << " on "
+              << ifName << " down";
+    fb303::fbData->addStatValue(
+        "spark.fast_liveness.neighbor_down", 1, fb303::SUM);
+    downCallback_(ifName, neighborName);
+  }
+}
+
+} // namespace openr
@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <folly/IPAddressV6.h>
+#include <folly/Range.h>
+
+#include <openr/if/gen-cpp2/OpenrConfig_types.h>
+#include <openr/spark/IoProvider.h>
+
+namespace openr {
+
+/**
+ * Fast liveness detection of established Spark neighbors, decoupled from
+ * Spark event loop. Compact heartbeats are multicast on every interface with
+ * monitored neighbors, and received on a dedicated port, by a dedicated
+ * thread. Neighbor is declared down once no heartbeat is received from it for
+ * detectMultiplier times the larger of the two heartbeat intervals.
+ *
+ * Detection is only as good as the scheduling of the thread, which is set
+ * with thread_scheduling_config of kThreadName, e.g. to run it with real-time
+ * priority on a dedicated CPU.
+ *
+ * All the public methods are thread safe. DownCallback is invoked from the
+ * liveness thread, once per neighbor, which is no longer monitored after.
+ */
+class FastLiveness final {
+ public:
+  static constexpr folly::StringPiece kThreadName{"SparkLiveness"};
+
+  using DownCallback = std::function<void(
+      std::string const& ifName, std::string const& neighborName)>;
+
+  FastLiveness(
+      std::string const& myNodeName,
+      thrift::SparkFastLivenessConfig const& config,
+      std::optional<thrift::ThreadSchedulingConfig> scheduling,
+      std::shared_ptr<IoProvider> ioProvider,
+      DownCallback downCallback);
+
+  ~FastLiveness();
+
+  std::chrono::milliseconds
+  getInterval() const {
+    return interval_;
+  }
+
+  // Start sending heartbeats on interface, or update its ifIndex/address
+  void addInterface(
+      std::string const& ifName,
+      int ifIndex,
+      folly::IPAddressV6 const& v6LinkLocalAddr);
+
+  // Stop sending heartbeats on interface, and monitoring its neighbors
+  void removeInterface(std::string const& ifName);
+
+  // Start monitoring neighbor, which sends heartbeats at given interval
+  void addNeighbor(
+      std::string const& ifName,
+      std::string const& neighborName,
+      std::chrono::milliseconds remoteInterval);
+
+  void removeNeighbor(
+      std::string const& ifName, std::string const& neighborName);
+
+  bool isMonitoring(
+      std::string const& ifName, std::string const& neighborName) const;
+
+ private:
+  FastLiveness(FastLiveness const&) = delete;
+  FastLiveness& operator=(FastLiveness const&) = delete;
+
+  struct Interface {
+    int ifIndex{0};
+    folly::IPAddressV6 v6LinkLocalAddr;
+  };
+
+  struct Neighbor {
+    std::chrono::milliseconds detectTime{0};
+    std::chrono::steady_clock::time_point lastHeartbeatTime;
+  };
+
+  using NeighborKey =
+      std::pair<std::string /* ifName */, std::string /* neighborName */>;
+
+  void prepareSocket();
+
+  // loop of liveness thread, till destruction
+  void run();
+
+  void sendHeartbeats();
+
+  void processPackets();
+
+  void checkNeighbors();
+
+  const std::string myNodeName_;
+
+  const uint16_t port_{0};
+
+  const std::chrono::milliseconds interval_{0};
+
+  const uint32_t detectMultiplier_{0};
+
+  const std::optional<thrift::ThreadSchedulingConfig> scheduling_;
+
+  std::shared_ptr<IoProvider> ioProvider_;
+
+  const DownCallback downCallback_;
+
+  int fd_{-1};
+
+  // buffers reused across reads of heartbeats
+  IoProvider::RecvBuffers recvBuffers_;
+
+  // Seq# of heartbeats, incremented on every send
+  int64_t seqNum_{0};
+
+  // protects interfaces and neighbors
+  mutable std::mutex mutex_;
+
+  std::unordered_map<std::string /* ifName */, Interface> interfaces_;
+
+  std::map<NeighborKey, Neighbor> neighbors_;
+
+  std::atomic<bool> stopped_{false};
+
+  std::thread thread_;
+};
+
+} // namespace openr
@@ -7,15 +7,200 @@
 
 #include "IoProvider.h"
 
+#include <linux/errqueue.h>
 #include <net/if.h>
+#include <netinet/in.h>
+
+#include <optional>
 
 #include <glog/logging.h>
 
+#include <folly/ExceptionString.h>
 #include <folly/Format.h>
 #include <folly/SocketAddress.h>
+#include <folly/String.h>
 
 namespace openr {
 
+namespace {
+
+// Convert kernel timestamp to microseconds since epoch
+std::chrono::microseconds
+toMicroseconds(struct timespec const& ts) {
+  // cast to int64_t since ts.tv_sec is 32 bits on some platforms like arm
+  return std::chrono::microseconds(
+      static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+}
+
+// Prepare message header for receiving data into the buffer along with the
+// control data and address of the sender
+template <typename CtrlBuf>
+void
+prepareRecvMsg(
+    struct msghdr& msg,
+    struct iovec& entry,
+    CtrlBuf& u,
+    sockaddr_storage& addrStorage,
+    unsigned char* buf,
+    size_t len) {
+  ::memset(&msg, 0, sizeof(msg));
+
+  // we only expect to receive one block of data, single entry
+  // in the vector
+  msg.msg_iov = &entry;
+  msg.msg_iovlen = 1;
+
+  // this part is important - if we don't zero the buffer,
+  // the CMSG_NXTHDR may burp, because it tries extracting
+  // fields from "next header" in the buffer
+  ::memset(&u.ctrlBuf[0], 0, sizeof(u.ctrlBuf));
+
+  // control message buffer used to receive dest IP from the kernel
+  msg.msg_control = u.ctrlBuf;
+  msg.msg_controllen = sizeof(u.ctrlBuf);
+
+  // prepare to receive either v4 or v6 addresses
+  ::memset(&addrStorage, 0, sizeof(addrStorage));
+  msg.msg_name = &addrStorage;
+  msg.msg_namelen = sizeof(sockaddr_storage);
+
+  // write the data here
+  entry.iov_base = buf;
+  entry.iov_len = len;
+}
+
+// Extract interface index, sender address, hop limit and timestamp of the
+// received message
+IoProvider::ReceivedMessage
+parseRecvMsg(struct msghdr& msg, ssize_t bytesRead) {
+  if (msg.msg_flags & MSG_TRUNC) {
+    throw std::runtime_error("Message truncated");
+  }
+
+  // grab the inIndex we received this packet on and the hopLimit
+  // those are available since we requested them via socket options
+  struct cmsghdr* cmsg{nullptr};
+  int ifIndex{-1};
+  int hopLimit{0};
+
+  // use user space timestamp if kernel timestamp is not found
+  std::chrono::microseconds recvTs{
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())};
+  auto recvTsSource = IoProvider::TimestampSource::USER;
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IPV6) {
+      if (cmsg->cmsg_type == IPV6_PKTINFO) {
+        struct in6_pktinfo pktinfo;
+        memcpy(
+            reinterpret_cast<void*>(&pktinfo),
+            CMSG_DATA(cmsg),
+            sizeof(pktinfo));
+        ifIndex = pktinfo.ipi6_ifindex;
+      } else if (cmsg->cmsg_type == IPV6_HOPLIMIT) {
+        memcpy(
+            reinterpret_cast<void*>(&hopLimit),
+            CMSG_DATA(cmsg),
+            sizeof(hopLimit));
+      }
+    }
+    if (cmsg->cmsg_level != SOL_SOCKET) {
+      continue;
+    }
+    std::optional<std::chrono::microseconds> kernelRecvTs;
+    if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+      struct timespec ts {
+        0, 0
+      };
+      memcpy(reinterpret_cast<void*>(&ts), CMSG_DATA(cmsg), sizeof(ts));
+      kernelRecvTs = toMicroseconds(ts);
+    } else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+      // software timestamp is the first one
+      struct scm_timestamping tss;
+      memcpy(reinterpret_cast<void*>(&tss), CMSG_DATA(cmsg), sizeof(tss));
+      if (tss.ts[0].tv_sec or tss.ts[0].tv_nsec) {
+        kernelRecvTs = toMicroseconds(tss.ts[0]);
+      }
+    }
+    if (kernelRecvTs.has_value()) {
+      // sanity check
+      DCHECK(recvTs >= *kernelRecvTs) << "Time anomaly";
+      VLOG(4) << "Got kernel-timestamp. It took "
+              << (recvTs - *kernelRecvTs).count()
+              << " us for the packet to get from kernel to user space";
+      recvTs = *kernelRecvTs;
+      recvTsSource = IoProvider::TimestampSource::KERNEL;
+    }
+  } // for
+
+  // build the source socket address from recvmsg data
+  folly::SocketAddress srcAddr{};
+  // this will throw if sender address was not filled in
+  srcAddr.setFromSockaddr(reinterpret_cast<struct sockaddr*>(msg.msg_name));
+
+  DCHECK(ifIndex != -1) << "ifIndex is not found";
+  DCHECK(hopLimit) << "hopLimit is not found";
+
+  return std::make_tuple(
+      bytesRead, ifIndex, srcAddr, hopLimit, recvTs, recvTsSource);
+}
+
+// control message buffer for sending, aligned by control message hdr
+union SendCtrlBuf {
+  char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+  struct cmsghdr align;
+};
+
+// Prepare message header for sending the packet to the destination address,
+// with source address and source if index set in ancilliary data
+void
+prepareSendMsg(
+    struct msghdr& msg,
+    struct iovec& entry,
+    SendCtrlBuf& u,
+    sockaddr_storage& addrStorage,
+    socklen_t addrLen,
+    int ifIndex,
+    folly::IPAddressV6 const& srcAddr,
+    std::string const& packet) {
+  ::memset(&msg, 0, sizeof(msg));
+  ::memset(&u, 0, sizeof(u));
+  msg.msg_name = reinterpret_cast<void*>(&addrStorage);
+  msg.msg_namelen = addrLen;
+
+  // set the source address and source if index for this message
+  // this goes into ancilliary data fields
+  msg.msg_control = u.cbuf;
+  msg.msg_controllen = sizeof(u.cbuf);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+
+  cmsg->cmsg_level = IPPROTO_IPV6;
+  cmsg->cmsg_type = IPV6_PKTINFO;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+
+  auto pktinfo = (struct in6_pktinfo*)CMSG_DATA(cmsg);
+  pktinfo->ipi6_ifindex = ifIndex;
+  ::memcpy(&pktinfo->ipi6_addr, srcAddr.bytes(), srcAddr.byteCount());
+
+  msg.msg_iov = &entry;
+  msg.msg_iovlen = 1;
+
+  // write the data here (we need to remove the const qualifier)
+  entry.iov_base = const_cast<char*>(packet.data());
+  entry.iov_len = packet.size();
+}
+
+} // namespace
+
+IoProvider::RecvBuffers::RecvBuffers(size_t maxMessages, size_t len)
+    : len_(len),
+      data_(maxMessages * len),
+      msgs_(maxMessages),
+      entries_(maxMessages),
+      ctrlBufs_(maxMessages),
+      addrStorages_(maxMessages) {}
+
 int
 IoProvider::socket(int domain, int type, int protocol) {
   return ::socket(domain, type, protocol);
@@ -65,17 +250,28 @@ IoProvider::recvmsg(int sockfd, struct msghdr* msg, int flags) {
   return ::recvmsg(sockfd, msg, flags);
 }
 
+int
+IoProvider::recvmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags,
+    struct timespec* timeout) {
+  return ::recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+}
+
 ssize_t
 IoProvider::sendmsg(int sockfd, const struct msghdr* msg, int flags) {
   return ::sendmsg(sockfd, msg, flags);
 }
 
-std::tuple<
-    ssize_t /* size */,
-    int /* ifIndex */,
-    folly::SocketAddress /* srcAddr */,
-    int /* hopLimit */,
-    std::chrono::microseconds /* kernel timestamp */>
+int
+IoProvider::sendmmsg(
+    int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  return ::sendmmsg(sockfd, msgvec, vlen, flags);
+}
+
+IoProvider::ReceivedMessage
 IoProvider::recvMessage(
     int fd, unsigned char* buf, int len, openr::IoProvider* ioProvider) {
   // the control message buffer
@@ -94,30 +290,7 @@ IoProvider::recvMessage(
   // for address of the sender
   sockaddr_storage addrStorage;
 
-  ::memset(&msg, 0, sizeof(msg));
-
-  // we only expect to receive one block of data, single entry
-  // in the vector
-  msg.msg_iov = &entry;
-  msg.msg_iovlen = 1;
-
-  // this part is important - if we don't zero the buffer,
-  // the CMSG_NXTHDR may burp, because it tries extracting
-  // fields from "next header" in the buffer
-  ::memset(&u.ctrlBuf[0], 0, sizeof(u.ctrlBuf));
-
-  // control message buffer used to receive dest IP from the kernel
-  msg.msg_control = u.ctrlBuf;
-  msg.msg_controllen = sizeof(u.ctrlBuf);
-
-  // prepare to receive either v4 or v6 addresses
-  ::memset(&addrStorage, 0, sizeof(addrStorage));
-  msg.msg_name = &addrStorage;
-  msg.msg_namelen = sizeof(sockaddr_storage);
-
-  // write the data here
-  entry.iov_base = buf;
-  entry.iov_len = len;
+  prepareRecvMsg(msg, entry, u, addrStorage, buf, len);
 
   ssize_t bytesRead = ioProvider->recvmsg(fd, &msg, MSG_DONTWAIT);
 
@@ -126,66 +299,113 @@ IoProvider::recvMessage(
         "Failed reading message on fd {}: {}", fd, folly::errnoStr(errno)));
   }
 
-  if (msg.msg_flags & MSG_TRUNC) {
-    throw std::runtime_error("Message truncated");
-  }
+  return parseRecvMsg(msg, bytesRead);
+}
 
-  // grab the inIndex we received this packet on and the hopLimit
-  // those are available since we requested them via socket options
-  struct cmsghdr* cmsg{nullptr};
-  int ifIndex{-1};
-  int hopLimit{0};
+std::vector<IoProvider::ReceivedMessage>
+IoProvider::recvMessages(
+    int fd, RecvBuffers& buffers, openr::IoProvider* ioProvider) {
+  const auto maxMessages = buffers.getMaxMessages();
+  for (size_t i = 0; i < maxMessages; ++i) {
+    buffers.msgs_[i].msg_len = 0;
+    prepareRecvMsg(
+        buffers.msgs_[i].msg_hdr,
+        buffers.entries_[i],
+        buffers.ctrlBufs_[i],
+        buffers.addrStorages_[i],
+        buffers.data_.data() + i * buffers.len_,
+        buffers.len_);
+  }
 
-  // use user space timestamp if kernel timestamp is not found
-  std::chrono::microseconds recvTs{
-      std::chrono::duration_cast<std::chrono::microseconds>(
-          std::chrono::system_clock::now().time_since_epoch())};
+  int numMessages = ioProvider->recvmmsg(
+      fd, buffers.msgs_.data(), maxMessages, MSG_DONTWAIT, nullptr);
 
-  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-    if (cmsg->cmsg_level == IPPROTO_IPV6) {
-      if (cmsg->cmsg_type == IPV6_PKTINFO) {
-        struct in6_pktinfo pktinfo;
-        memcpy(
-            reinterpret_cast<void*>(&pktinfo),
-            CMSG_DATA(cmsg),
-            sizeof(pktinfo));
-        ifIndex = pktinfo.ipi6_ifindex;
-      } else if (cmsg->cmsg_type == IPV6_HOPLIMIT) {
-        memcpy(
-            reinterpret_cast<void*>(&hopLimit),
-            CMSG_DATA(cmsg),
-            sizeof(hopLimit));
-      }
+  if (numMessages < 0) {
+    if (errno == EAGAIN or errno == EWOULDBLOCK) {
+      return {};
     }
-    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS) {
-      struct timespec ts {
-        0, 0
-      };
-      memcpy(reinterpret_cast<void*>(&ts), CMSG_DATA(cmsg), sizeof(ts));
-
-      // cast to int64_t since ts.tv_sec is 32 bits on some platforms like arm
-      const int64_t usecs =
-          static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
-      const std::chrono::microseconds kernelRecvTs(usecs);
+    throw std::runtime_error(folly::sformat(
+        "Failed reading messages on fd {}: {}", fd, folly::errnoStr(errno)));
+  }
 
-      // sanity check
-      DCHECK(recvTs >= kernelRecvTs) << "Time anomaly";
-      VLOG(4) << "Got kernel-timestamp. It took "
-              << (recvTs - kernelRecvTs).count()
-              << " us for the packet to get from kernel to user space";
-      recvTs = kernelRecvTs;
+  std::vector<ReceivedMessage> messages;
+  messages.reserve(numMessages);
+  for (int i = 0; i < numMessages; ++i) {
+    auto& msg = buffers.msgs_[i];
+    try {
+      messages.emplace_back(parseRecvMsg(msg.msg_hdr, msg.msg_len));
+    } catch (std::exception const& err) {
+      LOG(ERROR) << "Failed reading message on fd " << fd << ": "
+                 << folly::exceptionStr(err);
+      messages.emplace_back(
+          -1,
+          -1,
+          folly::SocketAddress(),
+          0,
+          std::chrono::microseconds(0),
+          TimestampSource::USER);
     }
-  } // for
-
-  // build the source socket address from recvmsg data
-  folly::SocketAddress srcAddr{};
-  // this will throw if sender address was not filled in
-  srcAddr.setFromSockaddr(reinterpret_cast<struct sockaddr*>(&addrStorage));
+  }
+  return messages;
+}
 
-  DCHECK(ifIndex != -1) << "ifIndex is not found";
-  DCHECK(hopLimit) << "hopLimit is not found";
+std::vector<IoProvider::TxTimestamp>
+IoProvider::recvTxTimestamps(
+    int fd, size_t maxTimestamps, openr::IoProvider* ioProvider) {
+  std::vector<TxTimestamp> timestamps;
+  while (timestamps.size() < maxTimestamps) {
+    // the control message buffer
+    union {
+      char ctrlBuf[CMSG_SPACE(1024)];
+      struct cmsghdr align;
+    } u;
+    ::memset(&u.ctrlBuf[0], 0, sizeof(u.ctrlBuf));
+
+    // no data is looped back with SOF_TIMESTAMPING_OPT_TSONLY
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof(msg));
+    msg.msg_control = u.ctrlBuf;
+    msg.msg_controllen = sizeof(u.ctrlBuf);
+
+    if (ioProvider->recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == EAGAIN or errno == EWOULDBLOCK) {
+        break;
+      }
+      throw std::runtime_error(folly::sformat(
+          "Failed reading error queue on fd {}: {}",
+          fd,
+          folly::errnoStr(errno)));
+    }
 
-  return std::make_tuple(bytesRead, ifIndex, srcAddr, hopLimit, recvTs);
+    std::optional<std::chrono::microseconds> txTs;
+    std::optional<uint32_t> id;
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET &&
+          cmsg->cmsg_type == SO_TIMESTAMPING) {
+        // software timestamp is the first one
+        struct scm_timestamping tss;
+        memcpy(reinterpret_cast<void*>(&tss), CMSG_DATA(cmsg), sizeof(tss));
+        if (tss.ts[0].tv_sec or tss.ts[0].tv_nsec) {
+          txTs = toMicroseconds(tss.ts[0]);
+        }
+      } else if (
+          (cmsg->cmsg_level == IPPROTO_IPV6 &&
+           cmsg->cmsg_type == IPV6_RECVERR) ||
+          (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)) {
+        struct sock_extended_err err;
+        memcpy(reinterpret_cast<void*>(&err), CMSG_DATA(cmsg), sizeof(err));
+        if (err.ee_errno == ENOMSG &&
+            err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+          id = err.ee_data;
+        }
+      }
+    }
+    if (txTs.has_value() and id.has_value()) {
+      timestamps.emplace_back(*id, *txTs);
+    }
+  }
+  return timestamps;
 }
 
 ssize_t
@@ -197,46 +417,124 @@ IoProvider::sendMessage(
     std::string const& packet,
     IoProvider* ioProvider) {
   struct msghdr msg;
-  struct cmsghdr* cmsg{nullptr};
 
   // pack control buffer, aligned by control message hdr
-  union {
-    char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
-    struct cmsghdr align;
-  } u;
+  SendCtrlBuf u;
 
   // Set the destination address for the message
   sockaddr_storage addrStorage;
   dstAddr.getAddress(&addrStorage);
 
-  ::memset(&msg, 0, sizeof(msg));
-  msg.msg_name = reinterpret_cast<void*>(&addrStorage);
-  msg.msg_namelen = dstAddr.getActualSize();
+  // the IO vector for data to be sent
+  struct iovec entry;
 
-  // set the source address and source if index for this message
-  // this goes into ancilliary data fields
-  msg.msg_control = u.cbuf;
-  msg.msg_controllen = sizeof(u.cbuf);
-  cmsg = CMSG_FIRSTHDR(&msg);
+  prepareSendMsg(
+      msg,
+      entry,
+      u,
+      addrStorage,
+      dstAddr.getActualSize(),
+      ifIndex,
+      srcAddr,
+      packet);
 
-  cmsg->cmsg_level = IPPROTO_IPV6;
-  cmsg->cmsg_type = IPV6_PKTINFO;
-  cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+  return ioProvider->sendmsg(fd, &msg, MSG_DONTWAIT);
+}
 
-  auto pktinfo = (struct in6_pktinfo*)CMSG_DATA(cmsg);
-  pktinfo->ipi6_ifindex = ifIndex;
-  ::memcpy(&pktinfo->ipi6_addr, srcAddr.bytes(), srcAddr.byteCount());
+std::vector<ssize_t>
+IoProvider::sendMessages(
+    int fd,
+    std::vector<std::pair<int, folly::IPAddressV6>> const& ifaces,
+    folly::SocketAddress dstAddr,
+    std::string const& packet,
+    IoProvider* ioProvider) {
+  const auto numMessages = ifaces.size();
+  std::vector<ssize_t> bytesSent(numMessages, -1);
+  if (numMessages == 0) {
+    return bytesSent;
+  }
 
-  // the IO vector for data to be sent
-  struct iovec entry;
-  msg.msg_iov = &entry;
-  msg.msg_iovlen = 1;
+  // Destination address is common to all the messages
+  sockaddr_storage addrStorage;
+  dstAddr.getAddress(&addrStorage);
 
-  // write the data here (we need to remove the const qualifier)
-  entry.iov_base = const_cast<char*>(packet.data());
-  entry.iov_len = packet.size();
+  std::vector<struct mmsghdr> msgs(numMessages);
+  std::vector<struct iovec> entries(numMessages);
+  std::vector<SendCtrlBuf> ctrlBufs(numMessages);
+  for (size_t i = 0; i < numMessages; ++i) {
+    msgs[i].msg_len = 0;
+    prepareSendMsg(
+        msgs[i].msg_hdr,
+        entries[i],
+        ctrlBufs[i],
+        addrStorage,
+        dstAddr.getActualSize(),
+        ifaces[i].first,
+        ifaces[i].second,
+        packet);
+  }
 
-  return ioProvider->sendmsg(fd, &msg, MSG_DONTWAIT);
+  // sendmmsg stops at the first message which fails to be sent. Skip it and
+  // send rest of the messages
+  size_t next{0};
+  while (next < numMessages) {
+    int numSent = ioProvider->sendmmsg(
+        fd, msgs.data() + next, numMessages - next, MSG_DONTWAIT);
+    if (numSent <= 0) {
+      // bytesSent of the message remains -1
+      ++next;
+      continue;
+    }
+    for (int i = 0; i < numSent; ++i, ++next) {
+      bytesSent[next] = msgs[next].msg_len;
+    }
+  }
+  return bytesSent;
+}
+
+bool
+IoProvider::toggleMcastGroup(
+    int fd,
+    folly::IPAddress mcastGroup,
+    int ifIndex,
+    bool join,
+    IoProvider* ioProvider) {
+  VLOG(2) << "Subscribing to link local multicast on ifIndex " << ifIndex;
+
+  if (!mcastGroup.isMulticast()) {
+    LOG(ERROR) << "IP address " << mcastGroup.str() << " is not multicast";
+    return false;
+  }
+
+  // Join multicast group on interface
+  struct ipv6_mreq mreq;
+  mreq.ipv6mr_interface = ifIndex;
+  ::memcpy(&mreq.ipv6mr_multiaddr, mcastGroup.bytes(), mcastGroup.byteCount());
+
+  if (join) {
+    if (ioProvider->setsockopt(
+            fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq)) != 0) {
+      LOG(ERROR) << "setsockopt ipv6_join_group failed "
+                 << folly::errnoStr(errno);
+      return false;
+    }
+
+    LOG(INFO) << "Joined multicast addr " << mcastGroup.str() << " on ifindex "
+              << ifIndex;
+    return true;
+  }
+
+  // Leave multicast group on interface
+  if (ioProvider->setsockopt(
+          fd, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &mreq, sizeof(mreq)) != 0) {
+    LOG(ERROR) << "setsockopt ipv6_leave_group failed "
+               << folly::errnoStr(errno);
+    return false;
+  }
+
+  LOG(INFO) << "Left multicast addr " << mcastGroup.str() << " on ifindex "
+            << ifIndex;
+  return true;
 }
 
 } // namespace openr
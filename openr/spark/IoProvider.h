@@ -13,6 +13,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <chrono>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <folly/IPAddress.h>
 #include <folly/SocketAddress.h>
@@ -57,24 +60,107 @@ class IoProvider {
 
   virtual ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags);
 
+  virtual int recvmmsg(
+      int sockfd,
+      struct mmsghdr* msgvec,
+      unsigned int vlen,
+      int flags,
+      struct timespec* timeout);
+
   virtual ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags);
 
+  virtual int sendmmsg(
+      int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
   virtual int setsockopt(
       int sockfd, int level, int optname, const void* optval, socklen_t optlen);
 
   // Utility functions that operate on sockets
 
-  /*
-   * Receive a message on fd, and return its size, interface index,
-   * and the source address
-   */
-  static std::tuple<
+  // Source of the timestamp of received/transmitted message
+  enum class TimestampSource {
+    // taken in user space on reading the message, includes event loop delay
+    USER = 0,
+    // taken by kernel on receiving/transmitting the message
+    KERNEL = 1,
+  };
+
+  using ReceivedMessage = std::tuple<
       ssize_t /* size */,
       int /* ifIndex */,
       folly::SocketAddress /* srcAddr */,
       int /* hopLimit */,
-      std::chrono::microseconds /* kernel timestamp */>
-  recvMessage(int fd, unsigned char* buf, int len, IoProvider* ioProvider);
+      std::chrono::microseconds /* kernel timestamp */,
+      TimestampSource /* source of timestamp */>;
+
+  // Transmit timestamp of the message, identified by the number of messages
+  // sent on the socket before it (SOF_TIMESTAMPING_OPT_ID)
+  using TxTimestamp =
+      std::pair<uint32_t /* id */, std::chrono::microseconds /* timestamp */>;
+
+  /*
+   * Buffers for receiving multiple messages with single recvMessages call.
+   * They're meant to be reused across the calls to avoid allocations on
+   * every read.
+   */
+  class RecvBuffers {
+   public:
+    RecvBuffers(size_t maxMessages, size_t len);
+
+    size_t
+    getMaxMessages() const {
+      return msgs_.size();
+    }
+
+    // Data of the i-th message received by the last recvMessages call
+    const unsigned char*
+    getData(size_t i) const {
+      return data_.data() + i * len_;
+    }
+
+   private:
+    friend class IoProvider;
+
+    // the control message buffer
+    // XXX: hardcoded, but this hardly should be a problem
+    union CtrlBuf {
+      char ctrlBuf[CMSG_SPACE(1024)];
+      struct cmsghdr align;
+    };
+
+    const size_t len_{0};
+    std::vector<unsigned char> data_;
+    std::vector<struct mmsghdr> msgs_;
+    std::vector<struct iovec> entries_;
+    std::vector<CtrlBuf> ctrlBufs_;
+    std::vector<sockaddr_storage> addrStorages_;
+  };
+
+  /*
+   * Receive a message on fd, and return its size, interface index,
+   * and the source address
+   */
+  static ReceivedMessage recvMessage(
+      int fd, unsigned char* buf, int len, IoProvider* ioProvider);
+
+  /*
+   * Receive upto `buffers.getMaxMessages()` messages on fd with single
+   * syscall. Returns size, interface index and source address of every
+   * received message (empty if there is no message to read), while data of
+   * the messages is in `buffers`. Message which couldn't be received properly
+   * (e.g. truncated) is reported with size -1.
+   */
+  static std::vector<ReceivedMessage> recvMessages(
+      int fd, RecvBuffers& buffers, IoProvider* ioProvider);
+
+  /*
+   * Read upto `maxTimestamps` transmit timestamps from the error queue of fd,
+   * for socket with SO_TIMESTAMPING enabled for transmitted messages
+   * (SOF_TIMESTAMPING_OPT_ID and SOF_TIMESTAMPING_OPT_TSONLY being set).
+   * Returns empty if there is none to read
+   */
+  static std::vector<TxTimestamp> recvTxTimestamps(
+      int fd, size_t maxTimestamps, IoProvider* ioProvider);
 
   /*
    * Send message on fd via given interface to the address provided
@@ -88,6 +174,30 @@ class IoProvider {
       std::string const& packet,
       IoProvider* ioProvider);
 
+  /*
+   * Send the same message on fd via each of the given interfaces (ifIndex,
+   * srcAddr) to the address provided, with as few syscalls as possible.
+   * Returns bytes sent for every interface in the same order, -1 if the
+   * message couldn't be sent via the interface.
+   */
+  static std::vector<ssize_t> sendMessages(
+      int fd,
+      std::vector<std::pair<int, folly::IPAddressV6>> const& ifaces,
+      folly::SocketAddress dstAddr,
+      std::string const& packet,
+      IoProvider* ioProvider);
+
+  /*
+   * Subscribe/unsubscribe fd to a multicast group on given interface.
+   * Returns false on failure, with errno set
+   */
+  static bool toggleMcastGroup(
+      int fd,
+      folly::IPAddress mcastGroup,
+      int ifIndex,
+      bool join,
+      IoProvider* ioProvider);
+
  private:
   IoProvider(IoProvider const&) = delete;
   IoProvider& operator=(IoProvider const&) = delete;
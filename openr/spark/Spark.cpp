@@ -8,6 +8,7 @@
 #include "Spark.h"
 
 #include <ifaddrs.h>
+#include <linux/net_tstamp.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <sodium.h>
@@ -37,6 +38,7 @@
 #include <openr/common/NetworkUtil.h>
 #include <openr/common/Util.h>
 
+#include "CompactHeartbeat.h"
 #include "IoProvider.h"
 
 namespace fb303 = facebook::fb303;
@@ -48,6 +50,21 @@ namespace {
 //
 const int kMinIpv6Mtu = 1280;
 
+//
+// Maximum number of packets read from multicast socket with single syscall
+//
+const size_t kMaxPacketsPerRead = 32;
+
+//
+// Maximum number of hello packets tracked for their transmit timestamps
+//
+const size_t kMaxPendingTxTimestamps = 256;
+
+//
+// Maximum number of <interface, neighbor> pairs with cached area
+//
+const size_t kMaxCachedNeighborAreas = 10000;
+
 //
 // The acceptable hop limit, assuming we send packets with this TTL
 //
@@ -82,54 +99,6 @@ getCurrentTimeInUs() {
       std::chrono::system_clock::now().time_since_epoch());
 }
 
-//
-// Subscribe/unsubscribe to a multicast group on given interface
-//
-bool
-toggleMcastGroup(
-    int fd,
-    folly::IPAddress mcastGroup,
-    int ifIndex,
-    bool join,
-    openr::IoProvider* ioProvider) {
-  VLOG(2) << "Subscribing to link local multicast on ifIndex " << ifIndex;
-
-  if (!mcastGroup.isMulticast()) {
-    LOG(ERROR) << "IP address " << mcastGroup.str() << " is not multicast";
-    return false;
-  }
-
-  // Join multicast group on interface
-  struct ipv6_mreq mreq;
-  mreq.ipv6mr_interface = ifIndex;
-  ::memcpy(&mreq.ipv6mr_multiaddr, mcastGroup.bytes(), mcastGroup.byteCount());
-
-  if (join) {
-    if (ioProvider->setsockopt(
-            fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq)) != 0) {
-      LOG(ERROR) << "setsockopt ipv6_join_group failed "
-                 << folly::errnoStr(errno);
-      return false;
-    }
-
-    LOG(INFO) << "Joined multicast addr " << mcastGroup.str() << " on ifindex "
-              << ifIndex;
-    return true;
-  }
-
-  // Leave multicast group on interface
-  if (ioProvider->setsockopt(
-          fd, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &mreq, sizeof(mreq)) != 0) {
-    LOG(ERROR) << "setsockopt ipv6_leave_group failed "
-               << folly::errnoStr(errno);
-    return false;
-  }
-
-  LOG(INFO) << "Left multicast addr " << mcastGroup.str() << " on ifindex "
-            << ifIndex;
-  return true;
-}
-
 } // namespace
 
 namespace openr {
@@ -255,7 +224,9 @@ Spark::Spark(
     OpenrCtrlThriftPort openrCtrlThriftPort,
     std::shared_ptr<IoProvider> ioProvider,
     std::shared_ptr<const Config> config,
-    std::pair<uint32_t, uint32_t> version)
+    std::pair<uint32_t, uint32_t> version,
+    std::optional<messaging::RQueue<std::shared_ptr<const Config>>>
+        configUpdatesQueue)
     : myDomainName_(config->getConfig().domain),
       myNodeName_(config->getNodeName()),
       neighborDiscoveryPort_(static_cast<uint16_t>(
@@ -278,8 +249,13 @@ Spark::Spark(
       kOpenrCtrlThriftPort_(openrCtrlThriftPort),
       kVersion_(apache::thrift::FRAGILE, version.first, version.second),
       enableFloodOptimization_(config->isFloodOptimizationEnabled()),
+      enableHashTreeSync_(config->isKvStoreHashTreeSyncEnabled()),
+      enableValueCompression_(config->isKvStoreValueCompressionEnabled()),
       ioProvider_(std::move(ioProvider)),
-      config_(std::move(config)) {
+      config_(std::move(config)),
+      recvBuffers_(kMaxPacketsPerRead, kMinIpv6Mtu),
+      helloTxTimestamps_(kMaxPendingTxTimestamps),
+      neighborAreas_(kMaxCachedNeighborAreas) {
   CHECK(gracefulRestartTime_ >= 3 * keepAliveTime_)
       << "Keep-alive-time must be less than hold-time.";
   CHECK(keepAliveTime_ > std::chrono::milliseconds(0))
@@ -292,6 +268,10 @@ Spark::Spark(
       << "fastInit helloMsg interval must be smaller than normal interval";
   CHECK(ioProvider_) << "Got null IoProvider";
 
+  // Timer wheel with 1ms resolution for timers of interfaces and neighbors
+  timerWheel_ =
+      folly::HHWheelTimer::newTimer(getEvb(), std::chrono::milliseconds(1));
+
   // Initialize list of BucketedTimeSeries
   const std::chrono::seconds sec{1};
   const int32_t numBuckets = Constants::kMaxAllowedPps / 3;
@@ -315,9 +295,39 @@ Spark::Spark(
     }
   });
 
+  // Fiber to apply reloaded config
+  if (configUpdatesQueue.has_value()) {
+    addFiberTask(
+        [q = std::move(*configUpdatesQueue), this]() mutable noexcept {
+          while (true) {
+            auto maybeConfig = q.get(); // perform read
+            if (maybeConfig.hasError()) {
+              LOG(INFO) << "Terminating config update processing fiber";
+              break;
+            }
+            processConfigUpdate(std::move(maybeConfig).value());
+          }
+        });
+  }
+
   // Initialize UDP socket for neighbor discovery
   prepareSocket(maybeIpTos);
 
+  // Fast liveness detection on its own thread, if enabled
+  if (auto livenessConfig =
+          config_->getSparkConfig().fast_liveness_config_ref()) {
+    fastLiveness_ = std::make_unique<FastLiveness>(
+        myNodeName_,
+        *livenessConfig,
+        config_->getThreadSchedulingConfig(FastLiveness::kThreadName.str()),
+        ioProvider_,
+        [this](std::string const& ifName, std::string const& neighborName) {
+          runInEventBaseThread([this, ifName, neighborName]() noexcept {
+            processFastLivenessTimeout(ifName, neighborName);
+          });
+        });
+  }
+
   // Initialize some stat keys
   fb303::fbData->addStatExportType(
       "spark.invalid_keepalive.different_domain", fb303::SUM);
@@ -425,6 +435,10 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
     }
   }
 
+  // drop in kernel packets we would reject anyway, before any is received
+  socketFilter_ = SparkSocketFilter::attach(
+      fd, ioProvider_.get(), kSparkHopLimit, 1, kMinIpv6Mtu);
+
   // bind the socket to receive any mcast packet
   {
     VLOG(2) << "Binding UDP socket to receive on any destination address";
@@ -470,13 +484,25 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
                << folly::errnoStr(errno);
   }
 
-  // enable timestamping for this socket
-  const int enabled = 1;
+  // enable kernel timestamping of received and transmitted packets for this
+  // socket, so that measured RTTs don't include event loop latency. Fallback
+  // to timestamping of received packets only if not supported
+  const int tsFlags = SOF_TIMESTAMPING_RX_SOFTWARE |
+      SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+      SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
   if (ioProvider_->setsockopt(
-          fd, SOL_SOCKET, SO_TIMESTAMPNS, &enabled, sizeof(enabled)) != 0) {
-    LOG(ERROR) << "Failed to enable kernel timestamping. Measured RTTs are "
-               << "likely to have more noise in them. Error: "
-               << folly::errnoStr(errno);
+          fd, SOL_SOCKET, SO_TIMESTAMPING, &tsFlags, sizeof(tsFlags)) == 0) {
+    txTimestampingEnabled_ = true;
+  } else {
+    LOG(WARNING) << "Failed to enable kernel tx timestamping. Error: "
+                 << folly::errnoStr(errno);
+    const int enabled = 1;
+    if (ioProvider_->setsockopt(
+            fd, SOL_SOCKET, SO_TIMESTAMPNS, &enabled, sizeof(enabled)) != 0) {
+      LOG(ERROR) << "Failed to enable kernel timestamping. Measured RTTs are "
+                 << "likely to have more noise in them. Error: "
+                 << folly::errnoStr(errno);
+    }
   }
 
   LOG(INFO) << "Spark thread attaching socket/events callbacks...";
@@ -484,9 +510,9 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
   // Listen for incoming messages on multicast FD
   addSocketFd(mcastFd_, ZMQ_POLLIN, [this](int) noexcept {
     try {
-      processPacket();
+      processPackets();
     } catch (std::exception const& err) {
-      LOG(ERROR) << "Spark: error processing hello packet "
+      LOG(ERROR) << "Spark: error receiving hello packets "
                  << folly::exceptionStr(err);
     }
   });
@@ -498,6 +524,10 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
     counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
   });
   counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
+
+  // send heartbeats queued by the interface timers in one go
+  heartbeatSendTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { sendPendingHeartbeatMsgs(); });
 }
 
 PacketValidationResult
@@ -555,19 +585,16 @@ Spark::shouldProcessHelloPacket(
 
 bool
 Spark::parsePacket(
+    const unsigned char* buf,
+    IoProvider::ReceivedMessage const& message,
     thrift::SparkHelloPacket& pkt,
-    std::string& ifName,
-    std::chrono::microseconds& recvTime) {
-  // the read buffer
-  uint8_t buf[kMinIpv6Mtu];
-
-  ssize_t bytesRead;
-  int ifIndex;
-  folly::SocketAddress clientAddr;
-  int hopLimit;
-
-  std::tie(bytesRead, ifIndex, clientAddr, hopLimit, recvTime) =
-      IoProvider::recvMessage(mcastFd_, buf, kMinIpv6Mtu, ioProvider_.get());
+    std::string& ifName) {
+  auto const& [bytesRead, ifIndex, clientAddr, hopLimit, recvTime, tsSource] =
+      message;
+  if (bytesRead < 0) {
+    // Failure is already logged by IoProvider
+    return false;
+  }
 
   if (hopLimit < kSparkHopLimit) {
     LOG(ERROR) << "Rejecting packet from " << clientAddr.getAddressStr()
@@ -603,19 +630,33 @@ Spark::parsePacket(
   }
 
   fb303::fbData->addStatValue("spark.hello_packet_processed", 1, fb303::SUM);
+  fb303::fbData->addStatValue(
+      tsSource == IoProvider::TimestampSource::KERNEL
+          ? "spark.rx_timestamp.kernel"
+          : "spark.rx_timestamp.user",
+      1,
+      fb303::SUM);
 
-  if (bytesRead >= 0) {
-    VLOG(4) << "Read a total of " << bytesRead << " bytes from fd " << mcastFd_;
+  VLOG(4) << "Read a total of " << bytesRead << " bytes from fd " << mcastFd_;
+
+  if (static_cast<size_t>(bytesRead) > kMinIpv6Mtu) {
+    LOG(ERROR) << "Message from " << clientAddr.getAddressStr()
+               << " has been truncated";
+    return false;
+  }
 
-    if (static_cast<size_t>(bytesRead) > kMinIpv6Mtu) {
-      LOG(ERROR) << "Message from " << clientAddr.getAddressStr()
-                 << " has been truncated";
+  // Fast-path for compact heartbeat, which is majority of the packets
+  if (isCompactHeartbeat(buf, bytesRead)) {
+    auto heartbeatMsg = decodeCompactHeartbeat(buf, bytesRead);
+    if (not heartbeatMsg.has_value()) {
+      LOG(ERROR) << "Failed parsing compact heartbeat packet from "
+                 << clientAddr.getAddressStr();
       return false;
     }
-  } else {
-    LOG(ERROR) << "Failed reading from fd " << mcastFd_ << " error "
-               << folly::errnoStr(errno);
-    return false;
+    fb303::fbData->addStatValue(
+        "spark.heartbeat.compact_packets_recv", 1, fb303::SUM);
+    pkt.heartbeatMsg_ref() = std::move(heartbeatMsg.value());
+    return true;
   }
 
   // Copy buffer into string object and parse it into helloPacket.
@@ -693,6 +734,51 @@ Spark::processRttChange(
       false);
 }
 
+void
+Spark::processTxTimestamps() {
+  if (not txTimestampingEnabled_) {
+    return;
+  }
+
+  auto timestamps = IoProvider::recvTxTimestamps(
+      mcastFd_, kMaxPendingTxTimestamps, ioProvider_.get());
+  for (auto const& [id, txTs] : timestamps) {
+    // drop hellos whose timestamp never came (id wraps around)
+    while (not pendingTxHellos_.empty() and
+           static_cast<int32_t>(id - pendingTxHellos_.front().first) > 0) {
+      pendingTxHellos_.pop_front();
+    }
+    if (pendingTxHellos_.empty() or pendingTxHellos_.front().first != id) {
+      // not a hello packet
+      continue;
+    }
+    const auto sentTs = pendingTxHellos_.front().second;
+    pendingTxHellos_.pop_front();
+
+    // packet can't be transmitted before it's built
+    if (txTs < sentTs) {
+      LOG(ERROR) << "Time anomaly. txTs: [" << txTs.count()
+                 << "] < sentTs: [" << sentTs.count() << "]";
+      continue;
+    }
+    helloTxTimestamps_.set(sentTs.count(), txTs);
+  }
+}
+
+std::chrono::microseconds
+Spark::getHelloTxTime(std::chrono::microseconds const& sentTime) {
+  // pick up tx timestamps which arrived since last read
+  processTxTimestamps();
+
+  auto it = helloTxTimestamps_.find(sentTime.count());
+  if (it == helloTxTimestamps_.end()) {
+    fb303::fbData->addStatValue("spark.tx_timestamp.user", 1, fb303::SUM);
+    return sentTime;
+  }
+  fb303::fbData->addStatValue("spark.tx_timestamp.kernel", 1, fb303::SUM);
+  return it->second;
+}
+
 void
 Spark::updateNeighborRtt(
     std::chrono::microseconds const& myRecvTime,
@@ -802,6 +888,14 @@ Spark::sendHandshakeMsg(
   handshakeMsg.kvStoreCmdPort = kKvStoreCmdPort_;
   handshakeMsg.area = neighborAreaId; // send neighborAreaId deduced locally
   handshakeMsg.neighborNodeName_ref() = neighborName;
+  handshakeMsg.supportHashTreeSync_ref() = enableHashTreeSync_;
+  handshakeMsg.supportValueCompression_ref() = enableValueCompression_;
+  handshakeMsg.supportTtlRefreshBatch_ref() = true;
+  handshakeMsg.supportNodeIdsBloom_ref() = true;
+  if (fastLiveness_) {
+    handshakeMsg.fastLivenessIntervalMs_ref() =
+        fastLiveness_->getInterval().count();
+  }
 
   thrift::SparkHelloPacket pkt;
   pkt.handshakeMsg_ref() = std::move(handshakeMsg);
@@ -831,66 +925,140 @@ Spark::sendHandshakeMsg(
   fb303::fbData->addStatValue(
       "spark.handshake.bytes_sent", packet.size(), fb303::SUM);
   fb303::fbData->addStatValue("spark.handshake.packets_sent", 1, fb303::SUM);
+  ++nextTxPacketId_;
 }
 
 void
 Spark::sendHeartbeatMsg(std::string const& ifName) {
+  pendingHeartbeatIfNames_.emplace(ifName);
+  if (not heartbeatSendTimer_->isScheduled()) {
+    heartbeatSendTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+  }
+}
+
+void
+Spark::sendPendingHeartbeatMsgs() {
+  auto ifNames = std::move(pendingHeartbeatIfNames_);
+  pendingHeartbeatIfNames_.clear();
+
   SCOPE_EXIT {
     // increment seq# after packet has been sent (even if it didnt go out)
     ++mySeqNum_;
   };
 
   SCOPE_FAIL {
-    LOG(ERROR) << "Failed sending Heartbeat packet on " << ifName;
+    LOG(ERROR) << "Failed sending Heartbeat packets";
   };
 
-  if (ifNameToActiveNeighbors_.find(ifName) == ifNameToActiveNeighbors_.end()) {
-    VLOG(3) << "Interface: " << ifName
-            << " hasn't have any active neighbor yet."
-            << " Skip sending out heartbeatMsg.";
-    return;
+  // interfaces to send heartbeat msg on, with thrift and compact encoding
+  std::vector<std::string> thriftIfNames, compactIfNames;
+  std::vector<std::pair<int, folly::IPAddressV6>> thriftIfaces, compactIfaces;
+  for (auto const& ifName : ifNames) {
+    if (ifNameToActiveNeighbors_.find(ifName) ==
+        ifNameToActiveNeighbors_.end()) {
+      VLOG(3) << "Interface: " << ifName
+              << " hasn't have any active neighbor yet."
+              << " Skip sending out heartbeatMsg.";
+      continue;
+    }
+
+    // interface may have been removed after heartbeat got queued
+    auto it = interfaceDb_.find(ifName);
+    if (it == interfaceDb_.end()) {
+      continue;
+    }
+    const auto& interfaceEntry = it->second;
+    auto iface = std::make_pair(
+        interfaceEntry.ifIndex, interfaceEntry.v6LinkLocalNetwork.first.asV6());
+    if (supportsCompactHeartbeat(ifName)) {
+      compactIfNames.emplace_back(ifName);
+      compactIfaces.emplace_back(std::move(iface));
+    } else {
+      thriftIfNames.emplace_back(ifName);
+      thriftIfaces.emplace_back(std::move(iface));
+    }
   }
 
-  // in some cases, getting link-local address may fail and throw
-  // e.g. when iface has not yet auto-configured it, or iface is removed but
-  // down event has not arrived yet
-  const auto& interfaceEntry = interfaceDb_.at(ifName);
-  const auto ifIndex = interfaceEntry.ifIndex;
-  const auto v6Addr = interfaceEntry.v6LinkLocalNetwork.first;
+  // build heartbeat msg. It doesn't carry anything interface specific, hence
+  // is serialized once and sent as is on all the interfaces
+  if (not thriftIfaces.empty()) {
+    thrift::SparkHeartbeatMsg heartbeatMsg;
+    heartbeatMsg.nodeName = myNodeName_;
+    heartbeatMsg.seqNum = mySeqNum_;
 
-  // build heartbeat msg
-  thrift::SparkHeartbeatMsg heartbeatMsg;
-  heartbeatMsg.nodeName = myNodeName_;
-  heartbeatMsg.seqNum = mySeqNum_;
+    thrift::SparkHelloPacket pkt;
+    pkt.heartbeatMsg_ref() = std::move(heartbeatMsg);
 
-  thrift::SparkHelloPacket pkt;
-  pkt.heartbeatMsg_ref() = std::move(heartbeatMsg);
+    sendHeartbeatPacket(
+        fbzmq::util::writeThriftObjStr(pkt, serializer_),
+        thriftIfNames,
+        thriftIfaces);
+  }
 
-  auto packet = fbzmq::util::writeThriftObjStr(pkt, serializer_);
+  if (not compactIfaces.empty()) {
+    sendHeartbeatPacket(
+        encodeCompactHeartbeat(myNodeName_, mySeqNum_),
+        compactIfNames,
+        compactIfaces);
+    fb303::fbData->addStatValue(
+        "spark.heartbeat.compact_packets_sent",
+        compactIfaces.size(),
+        fb303::SUM);
+  }
+}
 
+bool
+Spark::supportsCompactHeartbeat(std::string const& ifName) const {
+  if (static_cast<uint32_t>(kVersion_.version) <
+      static_cast<uint32_t>(Constants::kSparkCompactHeartbeatVersion)) {
+    return false;
+  }
+  // every neighbor on the interface receives the multicast heartbeat
+  auto const& ifNeighbors = sparkNeighbors_.at(ifName);
+  return std::all_of(
+      ifNeighbors.cbegin(), ifNeighbors.cend(), [](auto const& kv) {
+        return kv.second.remoteVersion >=
+            static_cast<uint32_t>(Constants::kSparkCompactHeartbeatVersion);
+      });
+}
+
+void
+Spark::sendHeartbeatPacket(
+    std::string const& packet,
+    std::vector<std::string> const& ifNames,
+    std::vector<std::pair<int, folly::IPAddressV6>> const& ifaces) {
   // send the pkt
   folly::SocketAddress dstAddr(
       folly::IPAddress(Constants::kSparkMcastAddr.toString()),
       neighborDiscoveryPort_);
 
   if (kMinIpv6Mtu < packet.size()) {
-    LOG(ERROR) << "Handshake packet is too big, can't send it out.";
+    LOG(ERROR) << "Heartbeat packet is too big, can't send it out.";
     return;
   }
 
-  auto bytesSent = IoProvider::sendMessage(
-      mcastFd_, ifIndex, v6Addr.asV6(), dstAddr, packet, ioProvider_.get());
+  auto bytesSent = IoProvider::sendMessages(
+      mcastFd_, ifaces, dstAddr, packet, ioProvider_.get());
 
-  if ((bytesSent < 0) || (static_cast<size_t>(bytesSent) != packet.size())) {
-    VLOG(1) << "Sending multicast to " << dstAddr.getAddressStr() << " on "
-            << ifName << " failed due to error " << folly::errnoStr(errno);
-    return;
+  size_t packetsSent{0};
+  for (size_t i = 0; i < bytesSent.size(); ++i) {
+    if ((bytesSent[i] < 0) ||
+        (static_cast<size_t>(bytesSent[i]) != packet.size())) {
+      VLOG(1) << "Sending multicast to " << dstAddr.getAddressStr() << " on "
+              << ifNames[i] << " failed";
+      continue;
+    }
+    ++packetsSent;
   }
 
   // update counters for number of pkts and total size of pkts sent
   fb303::fbData->addStatValue(
-      "spark.heartbeat.bytes_sent", packet.size(), fb303::SUM);
-  fb303::fbData->addStatValue("spark.heartbeat.packets_sent", 1, fb303::SUM);
+      "spark.heartbeat.bytes_sent", packetsSent * packet.size(), fb303::SUM);
+  fb303::fbData->addStatValue(
+      "spark.heartbeat.packets_sent", packetsSent, fb303::SUM);
+  fb303::fbData->addStatValue(
+      "spark.heartbeat.packets_per_send", ifaces.size(), fb303::AVG);
+  nextTxPacketId_ += packetsSent;
 }
 
 void
@@ -954,12 +1122,18 @@ Spark::neighborUpWrapper(
   neighbor.negotiateHoldTimer.reset();
 
   // create heartbeat hold timer when promote to "ESTABLISHED"
-  neighbor.heartbeatHoldTimer = folly::AsyncTimeout::make(
-      *getEvb(), [this, ifName, neighborName]() noexcept {
+  neighbor.heartbeatHoldTimer = WheelTimeout::make(
+      *timerWheel_, [this, ifName, neighborName]() noexcept {
         processHeartbeatTimeout(ifName, neighborName);
       });
   neighbor.heartbeatHoldTimer->scheduleTimeout(neighbor.heartbeatHoldTime);
 
+  // monitor neighbor with fast liveness as well, if both sides enable it
+  if (fastLiveness_ and neighbor.fastLivenessInterval.has_value()) {
+    fastLiveness_->addNeighbor(
+        ifName, neighborName, *neighbor.fastLivenessInterval);
+  }
+
   // add neighborName to collection
   ifNameToActiveNeighbors_[ifName].emplace(neighborName);
 
@@ -971,7 +1145,11 @@ Spark::neighborUpWrapper(
       neighbor.rtt.count(),
       neighbor.label,
       true /* support flood-optimization */,
-      neighbor.area);
+      neighbor.area,
+      enableHashTreeSync_ && neighbor.supportHashTreeSync,
+      enableValueCompression_ && neighbor.supportValueCompression,
+      neighbor.supportTtlRefreshBatch,
+      neighbor.supportNodeIdsBloom);
 }
 
 void
@@ -979,6 +1157,10 @@ Spark::neighborDownWrapper(
     SparkNeighbor const& neighbor,
     std::string const& ifName,
     std::string const& neighborName) {
+  if (fastLiveness_) {
+    fastLiveness_->removeNeighbor(ifName, neighborName);
+  }
+
   // notify LinkMonitor about neighbor DOWN state
   notifySparkNeighborEvent(
       thrift::SparkNeighborEventType::NEIGHBOR_DOWN,
@@ -1009,7 +1191,11 @@ Spark::notifySparkNeighborEvent(
     int64_t rttUs,
     int32_t label,
     bool supportFloodOptimization,
-    const std::string& area) {
+    const std::string& area,
+    bool supportHashTreeSync,
+    bool supportValueCompression,
+    bool supportTtlRefreshBatch,
+    bool supportNodeIdsBloom) {
   thrift::SparkNeighborEvent event;
   event.eventType = eventType;
   event.ifName = ifName;
@@ -1018,6 +1204,10 @@ Spark::notifySparkNeighborEvent(
   event.label = label;
   event.supportFloodOptimization = supportFloodOptimization;
   event.area = area;
+  event.supportHashTreeSync = supportHashTreeSync;
+  event.supportValueCompression = supportValueCompression;
+  event.supportTtlRefreshBatch = supportTtlRefreshBatch;
+  event.supportNodeIdsBloom = supportNodeIdsBloom;
   neighborUpdatesQueue_.push(std::move(event));
 }
 
@@ -1050,6 +1240,29 @@ Spark::processHeartbeatTimeout(
   neighborDownWrapper(neighbor, ifName, neighborName);
 }
 
+void
+Spark::processFastLivenessTimeout(
+    std::string const& ifName, std::string const& neighborName) {
+  // neighbor may have gone down since, or even come back up and be monitored
+  // again
+  auto ifIt = sparkNeighbors_.find(ifName);
+  if (ifIt == sparkNeighbors_.end()) {
+    return;
+  }
+  auto neighborIt = ifIt->second.find(neighborName);
+  if (neighborIt == ifIt->second.end() or
+      neighborIt->second.state != SparkNeighState::ESTABLISHED or
+      fastLiveness_->isMonitoring(ifName, neighborName)) {
+    return;
+  }
+
+  LOG(INFO) << "Fast liveness timer expired for: " << neighborName
+            << " on interface " << ifName;
+  fb303::fbData->addStatValue(
+      "spark.fast_liveness.heartbeat_timeouts", 1, fb303::SUM);
+  processHeartbeatTimeout(ifName, neighborName);
+}
+
 void
 Spark::processNegotiateTimeout(
     std::string const& ifName, std::string const& neighborName) {
@@ -1106,6 +1319,11 @@ Spark::processGRMsg(
     std::string const& neighborName,
     std::string const& ifName,
     SparkNeighbor& neighbor) {
+  // neighbor stops sending heartbeats while restarting, GR timer takes over
+  if (fastLiveness_) {
+    fastLiveness_->removeNeighbor(ifName, neighborName);
+  }
+
   // notify link-monitor for RESTARTING event
   notifySparkNeighborEvent(
       thrift::SparkNeighborEventType::NEIGHBOR_RESTARTING,
@@ -1117,8 +1335,8 @@ Spark::processGRMsg(
       neighbor.area);
 
   // start graceful-restart timer
-  neighbor.gracefulRestartHoldTimer = folly::AsyncTimeout::make(
-      *getEvb(), [this, ifName, neighborName]() noexcept {
+  neighbor.gracefulRestartHoldTimer = WheelTimeout::make(
+      *timerWheel_, [this, ifName, neighborName]() noexcept {
         // change the state back to IDLE
         processGRTimeout(ifName, neighborName);
       });
@@ -1138,7 +1356,8 @@ void
 Spark::processHelloMsg(
     thrift::SparkHelloMsg const& helloMsg,
     std::string const& ifName,
-    std::chrono::microseconds const& myRecvTimeInUs) {
+    std::chrono::microseconds const& myRecvTimeInUs,
+    std::optional<folly::IPAddress> const& srcAddr) {
   auto const& neighborName = helloMsg.nodeName;
   auto const& domainName = helloMsg.domainName;
   auto const& remoteIfName = helloMsg.ifName;
@@ -1176,8 +1395,7 @@ Spark::processHelloMsg(
     // TODO: Spark is yet to support area change due to dynamic configuration.
     //       To avoid running area deducing logic for every single helloMsg,
     //       ONLY deduce for unknown neighbors.
-    auto area =
-        getNeighborArea(neighborName, ifName, config_->getAreaConfiguration());
+    auto area = getCachedNeighborArea(neighborName, ifName);
     if (not area.has_value()) {
       return;
     }
@@ -1208,6 +1426,9 @@ Spark::processHelloMsg(
   // Up till now, node knows about this neighbor and perform SM check
   auto& neighbor = ifNeighbors.at(neighborName);
 
+  // Remember version to pick heartbeat encoding for neighbor
+  neighbor.remoteVersion = remoteVersion;
+
   // Update timestamps for received hello packet for neighbor
   neighbor.neighborTimestamp = nbrSentTimeInUs;
   neighbor.localTimestamp = myRecvTimeInUs;
@@ -1220,7 +1441,7 @@ Spark::processHelloMsg(
         // recvTime of neighbor helloPkt
         myRecvTimeInUs,
         // sentTime of my helloPkt recorded by neighbor
-        std::chrono::microseconds(ts.lastNbrMsgSentTsInUs),
+        getHelloTxTime(std::chrono::microseconds(ts.lastNbrMsgSentTsInUs)),
         // recvTime of my helloPkt recorded by neighbor
         std::chrono::microseconds(ts.lastMyMsgRcvdTsInUs),
         // sentTime of neighbor helloPkt
@@ -1234,9 +1455,12 @@ Spark::processHelloMsg(
           << toStr(neighbor.state) << "]";
 
   // for neighbor in fast initial state and does not see us yet,
-  // reply for quick convergence
+  // reply for quick convergence. Reply is unicast back to the neighbor, so
+  // that other neighbors on the link don't see unsolicited hellos
   if (helloMsg.solicitResponse) {
-    sendHelloMsg(ifName);
+    sendHelloMsg(ifName, false /* inFastInitState */, false, srcAddr);
+    fb303::fbData->addStatValue(
+        "spark.hello.solicited_replies_sent", 1, fb303::SUM);
 
     VLOG(3) << "Reply to neighbor's helloMsg since it is under fastInit";
   }
@@ -1273,8 +1497,8 @@ Spark::processHelloMsg(
 
     // Starts timer to periodically send hankshake msg
     const std::string neighborAreaId = neighbor.area;
-    neighbor.negotiateTimer = folly::AsyncTimeout::make(
-        *getEvb(), [this, ifName, neighborName, neighborAreaId]() noexcept {
+    neighbor.negotiateTimer = WheelTimeout::make(
+        *timerWheel_, [this, ifName, neighborName, neighborAreaId]() noexcept {
           sendHandshakeMsg(ifName, neighborName, neighborAreaId, false);
           // send out handshake msg periodically to this neighbor
           CHECK(sparkNeighbors_.count(ifName) > 0)
@@ -1286,11 +1510,13 @@ Spark::processHelloMsg(
               .at(neighborName)
               .negotiateTimer->scheduleTimeout(handshakeTime_);
         });
-    neighbor.negotiateTimer->scheduleTimeout(handshakeTime_);
+    // first handshake msg goes out right away instead of after a full
+    // handshakeTime_, to skip one round of waiting during bring-up
+    neighbor.negotiateTimer->scheduleTimeout(std::chrono::milliseconds(0));
 
     // Starts negotiate hold-timer
-    neighbor.negotiateHoldTimer = folly::AsyncTimeout::make(
-        *getEvb(), [this, ifName, neighborName]() noexcept {
+    neighbor.negotiateHoldTimer = WheelTimeout::make(
+        *timerWheel_, [this, ifName, neighborName]() noexcept {
           // prevent to stucking in NEGOTIATE forever
           processNegotiateTimeout(ifName, neighborName);
         });
@@ -1362,14 +1588,22 @@ Spark::processHelloMsg(
         neighbor.rtt.count(),
         neighbor.label,
         true /* support flood-optimization */,
-        neighbor.area);
+        neighbor.area,
+        enableHashTreeSync_ && neighbor.supportHashTreeSync,
+        enableValueCompression_ && neighbor.supportValueCompression,
+        neighbor.supportTtlRefreshBatch,
+        neighbor.supportNodeIdsBloom);
 
     // start heartbeat timer again to make sure neighbor is alive
-    neighbor.heartbeatHoldTimer = folly::AsyncTimeout::make(
-        *getEvb(), [this, ifName, neighborName]() noexcept {
+    neighbor.heartbeatHoldTimer = WheelTimeout::make(
+        *timerWheel_, [this, ifName, neighborName]() noexcept {
           processHeartbeatTimeout(ifName, neighborName);
         });
     neighbor.heartbeatHoldTimer->scheduleTimeout(neighbor.heartbeatHoldTime);
+    if (fastLiveness_ and neighbor.fastLivenessInterval.has_value()) {
+      fastLiveness_->addNeighbor(
+          ifName, neighborName, *neighbor.fastLivenessInterval);
+    }
 
     // stop the graceful-restart hold-timer
     neighbor.gracefulRestartHoldTimer.reset();
@@ -1437,7 +1671,7 @@ Spark::processHandshakeMsg(
   if (neighbor.heartbeatHoldTimer) {
     // Reset the hold-timer for neighbor as we have received a keep-alive msg
     LOG(INFO) << "Extend heartbeat timer for neighbor: " << neighborName;
-    neighbor.heartbeatHoldTimer->scheduleTimeout(neighbor.heartbeatHoldTime);
+    neighbor.heartbeatHoldTimer->extendTimeout(neighbor.heartbeatHoldTime);
   }
 
   // skip NEGOTIATE step if neighbor is NOT in state. This can happen:
@@ -1455,6 +1689,18 @@ Spark::processHandshakeMsg(
   neighbor.openrCtrlThriftPort = handshakeMsg.openrCtrlThriftPort;
   neighbor.transportAddressV4 = handshakeMsg.transportAddressV4;
   neighbor.transportAddressV6 = handshakeMsg.transportAddressV6;
+  neighbor.supportHashTreeSync =
+      handshakeMsg.supportHashTreeSync_ref().value_or(false);
+  neighbor.supportValueCompression =
+      handshakeMsg.supportValueCompression_ref().value_or(false);
+  neighbor.supportTtlRefreshBatch =
+      handshakeMsg.supportTtlRefreshBatch_ref().value_or(false);
+  neighbor.supportNodeIdsBloom =
+      handshakeMsg.supportNodeIdsBloom_ref().value_or(false);
+  neighbor.fastLivenessInterval.reset();
+  if (auto interval = handshakeMsg.fastLivenessIntervalMs_ref()) {
+    neighbor.fastLivenessInterval = std::chrono::milliseconds(*interval);
+  }
 
   // update neighbor holdTime as "NEGOTIATING" process
   neighbor.heartbeatHoldTime =
@@ -1553,24 +1799,56 @@ Spark::processHeartbeatMsg(
     return;
   }
 
-  // Reset the hold-timer for neighbor as we have received a keep-alive msg
-  neighbor.heartbeatHoldTimer->scheduleTimeout(neighbor.heartbeatHoldTime);
+  // Extend the hold-timer for neighbor as we have received a keep-alive msg.
+  // NOTE: This only records the new deadline, timer isn't rescheduled
+  neighbor.heartbeatHoldTimer->extendTimeout(neighbor.heartbeatHoldTime);
 }
 
 void
-Spark::processPacket() {
-  // receive and parse pkt
+Spark::processPackets() {
+  // error queue makes socket readable as well, hence drain it on every wakeup
+  processTxTimestamps();
+
+  // drain upto kMaxPacketsPerRead packets with single syscall
+  const auto messages =
+      IoProvider::recvMessages(mcastFd_, recvBuffers_, ioProvider_.get());
+  fb303::fbData->addStatValue(
+      "spark.hello_packet_recv_per_wakeup", messages.size(), fb303::AVG);
+  if (messages.size() == recvBuffers_.getMaxMessages()) {
+    // more packets are likely pending on socket
+    fb303::fbData->addStatValue(
+        "spark.hello_packet_recv_batch_full", 1, fb303::SUM);
+  }
+
+  for (size_t i = 0; i < messages.size(); ++i) {
+    try {
+      processPacket(recvBuffers_.getData(i), messages.at(i));
+    } catch (std::exception const& err) {
+      LOG(ERROR) << "Spark: error processing hello packet "
+                 << folly::exceptionStr(err);
+    }
+  }
+}
+
+void
+Spark::processPacket(
+    const unsigned char* buf, IoProvider::ReceivedMessage const& message) {
+  // parse pkt
   thrift::SparkHelloPacket helloPacket;
   std::string ifName;
-  std::chrono::microseconds myRecvTime;
+  const auto myRecvTime = std::get<4>(message);
 
-  if (!parsePacket(helloPacket, ifName, myRecvTime)) {
+  if (!parsePacket(buf, message, helloPacket, ifName)) {
     return;
   }
 
   // Spark specific msg processing
   if (helloPacket.helloMsg_ref().has_value()) {
-    processHelloMsg(helloPacket.helloMsg_ref().value(), ifName, myRecvTime);
+    processHelloMsg(
+        helloPacket.helloMsg_ref().value(),
+        ifName,
+        myRecvTime,
+        std::get<2>(message).getIPAddress());
   } else if (helloPacket.heartbeatMsg_ref().has_value()) {
     processHeartbeatMsg(helloPacket.heartbeatMsg_ref().value(), ifName);
   } else if (helloPacket.handshakeMsg_ref().has_value()) {
@@ -1580,7 +1858,10 @@ Spark::processPacket() {
 
 void
 Spark::sendHelloMsg(
-    std::string const& ifName, bool inFastInitState, bool restarting) {
+    std::string const& ifName,
+    bool inFastInitState,
+    bool restarting,
+    std::optional<folly::IPAddress> const& dstIp) {
   VLOG(3) << "Send hello packet called for " << ifName;
 
   if (interfaceDb_.count(ifName) == 0) {
@@ -1617,7 +1898,8 @@ Spark::sendHelloMsg(
   helloMsg.version = openrVer;
   helloMsg.solicitResponse = inFastInitState;
   helloMsg.restarting = restarting;
-  helloMsg.sentTsInUs = getCurrentTimeInUs().count();
+  const auto sentTsInUs = getCurrentTimeInUs().count();
+  helloMsg.sentTsInUs = sentTsInUs;
 
   // bake neighborInfo into helloMsg
   for (const auto& kv : sparkNeighbors_.at(ifName)) {
@@ -1637,7 +1919,9 @@ Spark::sendHelloMsg(
   // send the payload
   auto packet = fbzmq::util::writeThriftObjStr(helloPacket, serializer_);
   folly::SocketAddress dstAddr(
-      folly::IPAddress(Constants::kSparkMcastAddr.toString()),
+      dstIp.has_value()
+          ? dstIp.value()
+          : folly::IPAddress(Constants::kSparkMcastAddr.toString()),
       neighborDiscoveryPort_);
 
   if (kMinIpv6Mtu < packet.size()) {
@@ -1649,7 +1933,7 @@ Spark::sendHelloMsg(
       mcastFd_, ifIndex, v6Addr.asV6(), dstAddr, packet, ioProvider_.get());
 
   if ((bytesSent < 0) || (static_cast<size_t>(bytesSent) != packet.size())) {
-    VLOG(1) << "Sending multicast to " << dstAddr.getAddressStr() << " on "
+    VLOG(1) << "Sending hello to " << dstAddr.getAddressStr() << " on "
             << ifName << " failed due to error " << folly::errnoStr(errno);
     return;
   }
@@ -1659,9 +1943,42 @@ Spark::sendHelloMsg(
       "spark.hello.bytes_sent", packet.size(), fb303::SUM);
   fb303::fbData->addStatValue("spark.hello.packets_sent", 1, fb303::SUM);
 
+  // track hello for its tx timestamp
+  if (txTimestampingEnabled_) {
+    pendingTxHellos_.emplace_back(
+        nextTxPacketId_, std::chrono::microseconds(sentTsInUs));
+    if (pendingTxHellos_.size() > kMaxPendingTxTimestamps) {
+      pendingTxHellos_.pop_front();
+    }
+  }
+  ++nextTxPacketId_;
+
   VLOG(4) << "Sent " << bytesSent << " bytes in hello packet";
 }
 
+void
+Spark::processConfigUpdate(std::shared_ptr<const Config> config) {
+  // new config has been validated upon reload
+  const auto& sparkConfig = config->getSparkConfig();
+  helloTime_ = std::chrono::seconds(sparkConfig.hello_time_s);
+  fastInitHelloTime_ =
+      std::chrono::milliseconds(sparkConfig.fastinit_hello_time_ms);
+  handshakeTime_ =
+      std::chrono::milliseconds(sparkConfig.fastinit_hello_time_ms);
+  keepAliveTime_ = std::chrono::seconds(sparkConfig.keepalive_time_s);
+  handshakeHoldTime_ = std::chrono::seconds(sparkConfig.keepalive_time_s);
+  holdTime_ = std::chrono::seconds(sparkConfig.hold_time_s);
+  gracefulRestartTime_ =
+      std::chrono::seconds(sparkConfig.graceful_restart_time_s);
+
+  // areas of established neighbors are kept, cached ones are deduced again
+  neighborAreas_.clear();
+  config_ = std::move(config);
+  LOG(INFO) << "Applied reloaded config. helloTime: " << helloTime_.count()
+            << "ms, keepAliveTime: " << keepAliveTime_.count()
+            << "ms, holdTime: " << holdTime_.count() << "ms";
+}
+
 void
 Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
   decltype(interfaceDb_) newInterfaceDb{};
@@ -1719,16 +2036,33 @@ Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
         ifName, Interface(ifIndex, v4Network, v6LinkLocalNetwork));
   }
 
+  std::set<std::string> toAdd;
+  std::set<std::string> toDel;
+  std::set<std::string> toUpdate;
+
+  // delta only carries changed interfaces, compare just them
+  if (ifDb.isDelta) {
+    for (const auto& kv : ifDb.interfaces) {
+      const auto& ifName = kv.first;
+      const bool isValid = newInterfaceDb.count(ifName);
+      if (interfaceDb_.count(ifName)) {
+        (isValid ? toUpdate : toDel).emplace(ifName);
+      } else if (isValid) {
+        toAdd.emplace(ifName);
+      }
+    }
+    deleteInterfaceFromDb(toDel);
+    addInterfaceToDb(toAdd, newInterfaceDb);
+    updateInterfaceInDb(toUpdate, newInterfaceDb);
+    return;
+  }
+
   auto newIfaces = folly::gen::from(newInterfaceDb) | folly::gen::get<0>() |
       folly::gen::as<std::set<std::string>>();
 
   auto existingIfaces = folly::gen::from(interfaceDb_) | folly::gen::get<0>() |
       folly::gen::as<std::set<std::string>>();
 
-  std::set<std::string> toAdd;
-  std::set<std::string> toDel;
-  std::set<std::string> toUpdate;
-
   std::set_difference(
       newIfaces.begin(),
       newIfaces.end(),
@@ -1788,10 +2122,13 @@ Spark::deleteInterfaceFromDb(const std::set<std::string>& toDel) {
     }
     sparkNeighbors_.erase(ifName);
     ifNameToHeartbeatTimers_.erase(ifName);
+    if (fastLiveness_) {
+      fastLiveness_->removeInterface(ifName);
+    }
 
     // unsubscribe the socket from mcast group on this interface
     // On error, log and continue
-    if (!toggleMcastGroup(
+    if (!IoProvider::toggleMcastGroup(
             mcastFd_,
             folly::IPAddress(Constants::kSparkMcastAddr.toString()),
             interfaceDb_.at(ifName).ifIndex,
@@ -1819,7 +2156,7 @@ Spark::addInterfaceToDb(
 
     // subscribe the socket to mcast address on this interface
     // We throw an error on the first one to encounter a problem
-    if (!toggleMcastGroup(
+    if (!IoProvider::toggleMcastGroup(
             mcastFd_,
             folly::IPAddress(Constants::kSparkMcastAddr.toString()),
             ifIndex,
@@ -1834,6 +2171,11 @@ Spark::addInterfaceToDb(
       CHECK(result.second);
     }
 
+    if (fastLiveness_) {
+      fastLiveness_->addInterface(
+          ifName, ifIndex, newInterface.v6LinkLocalNetwork.first.asV6());
+    }
+
     {
       // create place-holders for newly added interface
       auto result = sparkNeighbors_.emplace(
@@ -1842,7 +2184,7 @@ Spark::addInterfaceToDb(
 
       // heartbeatTimers will start as soon as intf is in UP state
       auto heartbeatTimer =
-          folly::AsyncTimeout::make(*getEvb(), [this, ifName]() noexcept {
+          WheelTimeout::make(*timerWheel_, [this, ifName]() noexcept {
             sendHeartbeatMsg(ifName);
             // schedule heartbeatTimers periodically as soon as intf is UP
             ifNameToHeartbeatTimers_.at(ifName)->scheduleTimeout(
@@ -1871,8 +2213,8 @@ Spark::addInterfaceToDb(
     // this is due to the fact that it may not have yet configured a link-local
     // address. The hello packet will be sent later and will have good chances
     // of making it out if small delay is introduced.
-    auto helloTimer = folly::AsyncTimeout::make(
-        *getEvb(),
+    auto helloTimer = WheelTimeout::make(
+        *timerWheel_,
         [this, ifName, timePoint, roll, rollFast]() mutable noexcept {
           VLOG(3) << "Sending hello multicast packet on interface " << ifName;
           bool inFastInitState = false;
@@ -1919,7 +2261,7 @@ Spark::updateInterfaceInDb(
     if (newInterface.ifIndex != interface.ifIndex) {
       // unsubscribe the socket from mcast group on the old ifindex
       // On error, log and continue
-      if (!toggleMcastGroup(
+      if (!IoProvider::toggleMcastGroup(
               mcastFd_,
               folly::IPAddress(Constants::kSparkMcastAddr.toString()),
               interface.ifIndex,
@@ -1931,7 +2273,7 @@ Spark::updateInterfaceInDb(
 
       // subscribe the socket to mcast address on the new ifindex
       // We throw an error on the first one to encounter a problem
-      if (!toggleMcastGroup(
+      if (!IoProvider::toggleMcastGroup(
               mcastFd_,
               folly::IPAddress(Constants::kSparkMcastAddr.toString()),
               newInterface.ifIndex,
@@ -1950,6 +2292,10 @@ Spark::updateInterfaceInDb(
               << newInterface.v4Network.first << ")";
 
     interface = std::move(newInterface);
+    if (fastLiveness_) {
+      fastLiveness_->addInterface(
+          ifName, interface.ifIndex, interface.v6LinkLocalNetwork.first.asV6());
+    }
   }
 }
 
@@ -2015,6 +2361,17 @@ Spark::updateGlobalCounters() {
       "spark.tracked_adjacent_neighbors_diff",
       trackedNeighborCount - adjacentNeighborCount);
   fb303::fbData->setCounter("spark.my_seq_num", mySeqNum_);
+  if (socketFilter_ and socketFilter_->hasDropCounts()) {
+    const auto dropCounts = socketFilter_->getDropCounts();
+    for (size_t i = 0; i < dropCounts.size(); ++i) {
+      fb303::fbData->setCounter(
+          folly::sformat(
+              "spark.socket_filter.dropped.{}",
+              SparkSocketFilter::getDropReasonName(
+                  static_cast<SparkSocketFilter::DropReason>(i))),
+          dropCounts[i]);
+    }
+  }
   fb303::fbData->setCounter("spark.pending_timers", getEvb()->timer().count());
 }
 
@@ -2023,35 +2380,14 @@ std::optional<std::string>
 Spark::getNeighborArea(
     const std::string& peerNodeName,
     const std::string& localIfName,
-    const std::unordered_map<std::string /* areaId */, AreaConfiguration>&
-        areaConfigs) {
-  std::vector<std::string> candidateAreas{};
-
-  // looping through areaIdRegexList
-  for (const auto& t : areaConfigs) {
-    const auto& areaId = t.first;
-    const auto& neighborRegex = t.second.neighborRegexList;
-    const auto& interfaceRegex = t.second.interfaceRegexList;
-
-    if (neighborRegex and interfaceRegex) {
-      if (matchRegexSet(peerNodeName, neighborRegex) and
-          matchRegexSet(localIfName, interfaceRegex)) {
-        VLOG(1) << folly::sformat(
-            "Area: {} found for neighbor: {}, interface: {}",
-            areaId,
-            peerNodeName,
-            localIfName);
-        candidateAreas.emplace_back(areaId);
-      }
-    } else if (neighborRegex and matchRegexSet(peerNodeName, neighborRegex)) {
-      VLOG(1) << folly::sformat(
-          "Area: {} found for neighbor: {}", areaId, peerNodeName);
-      candidateAreas.emplace_back(areaId);
-    } else if (interfaceRegex and matchRegexSet(localIfName, interfaceRegex)) {
-      VLOG(1) << folly::sformat(
-          "Area: {} found for interface: {}", areaId, localIfName);
-      candidateAreas.emplace_back(areaId);
-    }
+    const AreaMatcher& areaMatcher) {
+  const auto candidateAreas = areaMatcher.match(peerNodeName, localIfName);
+  for (const auto& areaId : candidateAreas) {
+    VLOG(1) << folly::sformat(
+        "Area: {} found for neighbor: {}, interface: {}",
+        areaId,
+        peerNodeName,
+        localIfName);
   }
 
   if (candidateAreas.empty()) {
@@ -2067,4 +2403,20 @@ Spark::getNeighborArea(
   return candidateAreas.back();
 }
 
+std::optional<std::string>
+Spark::getCachedNeighborArea(
+    const std::string& peerNodeName, const std::string& ifName) {
+  auto key = std::make_pair(ifName, peerNodeName);
+  auto it = neighborAreas_.find(key);
+  if (it != neighborAreas_.end()) {
+    return it->second;
+  }
+  auto area = getNeighborArea(peerNodeName, ifName, config_->getAreaMatcher());
+  // failures are not cached, to keep reporting them
+  if (area.has_value()) {
+    neighborAreas_.set(std::move(key), *area);
+  }
+  return area;
+}
+
 } // namespace openr
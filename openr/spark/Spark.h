@@ -8,7 +8,9 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
 #include <functional>
+#include <optional>
 
 #include <boost/serialization/strong_typedef.hpp>
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
@@ -16,6 +18,7 @@
 #include <folly/SocketAddress.h>
 #include <folly/container/EvictingCacheMap.h>
 #include <folly/fibers/FiberManager.h>
+#include <folly/hash/Hash.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/stats/BucketedTimeSeries.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -24,13 +27,16 @@
 #include <openr/common/StepDetector.h>
 #include <openr/common/Types.h>
 #include <openr/common/Util.h>
+#include <openr/common/WheelTimeout.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/LinkMonitor_types.h>
 #include <openr/if/gen-cpp2/OpenrConfig_types.h>
 #include <openr/if/gen-cpp2/Spark_types.h>
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/spark/FastLiveness.h>
 #include <openr/spark/IoProvider.h>
+#include <openr/spark/SparkSocketFilter.h>
 
 namespace openr {
 
@@ -87,7 +93,10 @@ class Spark final : public OpenrEventBase {
       std::shared_ptr<IoProvider> ioProvider,
       std::shared_ptr<const Config> config,
       std::pair<uint32_t, uint32_t> version = std::make_pair(
-          Constants::kOpenrVersion, Constants::kOpenrSupportedVersion));
+          Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+      // Queue for receiving reloaded config, if reload is supported
+      std::optional<messaging::RQueue<std::shared_ptr<const Config>>>
+          configUpdatesQueue = std::nullopt);
 
   ~Spark() override = default;
 
@@ -146,15 +155,20 @@ class Spark final : public OpenrEventBase {
   bool shouldProcessHelloPacket(
       std::string const& ifName, folly::IPAddress const& addr);
 
+  // receive packets, upto kMaxPacketsPerRead, and process them
+  void processPackets();
+
   // process hello packet from a neighbor. we want to see if
   // the neighbor could be added as adjacent peer.
-  void processPacket();
+  void processPacket(
+      const unsigned char* buf, IoProvider::ReceivedMessage const& message);
 
   // process helloMsg in Spark context
   void processHelloMsg(
       thrift::SparkHelloMsg const& helloMsg,
       std::string const& ifName,
-      std::chrono::microseconds const& myRecvTimeInUs);
+      std::chrono::microseconds const& myRecvTimeInUs,
+      std::optional<folly::IPAddress> const& srcAddr = std::nullopt);
 
   // process heartbeatMsg in Spark context
   void processHeartbeatMsg(
@@ -164,11 +178,13 @@ class Spark final : public OpenrEventBase {
   void processHandshakeMsg(
       thrift::SparkHandshakeMsg const& handshakeMsg, std::string const& ifName);
 
-  // util call to send hello msg
+  // util call to send hello msg. Sent to multicast group unless dstIp,
+  // i.e. link-local address of a neighbor, is given
   void sendHelloMsg(
       std::string const& ifName,
       bool inFastInitState = false,
-      bool restarting = false);
+      bool restarting = false,
+      std::optional<folly::IPAddress> const& dstIp = std::nullopt);
 
   // util call to send handshake msg
   void sendHandshakeMsg(
@@ -177,13 +193,32 @@ class Spark final : public OpenrEventBase {
       std::string const& neighborAreaId,
       bool isAdjEstablished);
 
-  // util call to send heartbeat msg
+  // util call to queue heartbeat msg for the interface. Heartbeats queued
+  // within the same event loop iteration (e.g. by the timers firing in the
+  // same tick) are sent together right after
   void sendHeartbeatMsg(std::string const& ifName);
 
+  // util call to send heartbeat msg on all the queued interfaces
+  void sendPendingHeartbeatMsgs();
+
+  // util call to send heartbeat packet on the interfaces
+  void sendHeartbeatPacket(
+      std::string const& packet,
+      std::vector<std::string> const& ifNames,
+      std::vector<std::pair<int, folly::IPAddressV6>> const& ifaces);
+
+  // whether compact heartbeat encoding is supported by us and all the
+  // neighbors on the interface
+  bool supportsCompactHeartbeat(std::string const& ifName) const;
+
   // Function processes interface updates from LinkMonitor and appropriately
   // enable/disable neighbor discovery
   void processInterfaceUpdates(thrift::InterfaceDatabase&& interfaceUpdates);
 
+  // Apply reloaded config in place: timers take effect from their next
+  // scheduling and area regexes for neighbors discovered from now on
+  void processConfigUpdate(std::shared_ptr<const Config> config);
+
   // util function to delete interface in spark
   void deleteInterfaceFromDb(const std::set<std::string>& toDel);
 
@@ -232,19 +267,33 @@ class Spark final : public OpenrEventBase {
   static std::optional<std::string> getNeighborArea(
       const std::string& peerNodeName,
       const std::string& ifName,
-      const std::unordered_map<std::string /* areaId */, AreaConfiguration>&
-          areaConfigs);
+      const AreaMatcher& areaMatcher);
+
+  // getNeighborArea() with deduced area cached per <ifName, peerNodeName>,
+  // as area config doesn't change at runtime
+  std::optional<std::string> getCachedNeighborArea(
+      const std::string& peerNodeName, const std::string& ifName);
 
-  // function to receive and parse received pkt
+  // function to parse received pkt
   bool parsePacket(
+      const unsigned char* buf /* data of received pkt */,
+      IoProvider::ReceivedMessage const& message /* received pkt */,
       thrift::SparkHelloPacket& pkt /* packet( type will be renamed later) */,
-      std::string& ifName /* interface */,
-      std::chrono::microseconds& recvTime /* kernel timestamp when recved */);
+      std::string& ifName /* interface */);
 
   // function to validate v4Address with its subnet
   PacketValidationResult validateV4AddressSubnet(
       std::string const& ifName, thrift::BinaryAddress neighV4Addr);
 
+  // read transmit timestamps of sent packets from the socket error queue and
+  // record them for hello packets
+  void processTxTimestamps();
+
+  // kernel transmit time of hello packet sent at `sentTime` (as recorded in
+  // hello msg) if known, `sentTime` otherwise
+  std::chrono::microseconds getHelloTxTime(
+      std::chrono::microseconds const& sentTime);
+
   // function wrapper to update RTT for neighbor
   void updateNeighborRtt(
       std::chrono::microseconds const& myRecvTimeInUs,
@@ -298,25 +347,44 @@ class Spark final : public OpenrEventBase {
     // Last sequence number received from neighbor
     uint64_t seqNum{0};
 
+    // Openr version advertised by neighbor in hello msg
+    uint32_t remoteVersion{0};
+
     // neighbor state
     SparkNeighState state;
 
     // timer to periodically send out handshake pkt
-    std::unique_ptr<folly::AsyncTimeout> negotiateTimer{nullptr};
+    std::unique_ptr<WheelTimeout> negotiateTimer{nullptr};
 
     // negotiate stage hold-timer
-    std::unique_ptr<folly::AsyncTimeout> negotiateHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> negotiateHoldTimer{nullptr};
 
     // heartbeat hold-timer
-    std::unique_ptr<folly::AsyncTimeout> heartbeatHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> heartbeatHoldTimer{nullptr};
 
     // graceful restart hold-timer
-    std::unique_ptr<folly::AsyncTimeout> gracefulRestartHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> gracefulRestartHoldTimer{nullptr};
 
     // KvStore related port. Info passed to LinkMonitor for neighborEvent
     int32_t kvStoreCmdPort{0};
     int32_t openrCtrlThriftPort{0};
 
+    // neighbor supports hash-tree based KvStore full-sync
+    bool supportHashTreeSync{false};
+
+    // neighbor supports compressed KvStore values
+    bool supportValueCompression{false};
+
+    // neighbor supports compact KvStore TTL refreshes
+    bool supportTtlRefreshBatch{false};
+
+    // neighbor supports bloom filter of nodes traversed by KvStore
+    // publications
+    bool supportNodeIdsBloom{false};
+
+    // interval of fast liveness heartbeats of neighbor, if it has it enabled
+    std::optional<std::chrono::milliseconds> fastLivenessInterval;
+
     // hold time
     std::chrono::milliseconds heartbeatHoldTime{0};
     std::chrono::milliseconds gracefulRestartHoldTime{0};
@@ -380,7 +448,11 @@ class Spark final : public OpenrEventBase {
       int32_t label,
       bool supportFloodOptimization,
       const std::string& area =
-          openr::thrift::KvStore_constants::kDefaultArea());
+          openr::thrift::KvStore_constants::kDefaultArea(),
+      bool supportHashTreeSync = false,
+      bool supportValueCompression = false,
+      bool supportTtlRefreshBatch = false,
+      bool supportNodeIdsBloom = false);
 
   // callback function for rtt change
   void processRttChange(
@@ -398,6 +470,10 @@ class Spark final : public OpenrEventBase {
   void processHeartbeatTimeout(
       std::string const& ifName, std::string const& neighborName);
 
+  // process neighbor down detected by fast liveness
+  void processFastLivenessTimeout(
+      std::string const& ifName, std::string const& neighborName);
+
   // process timeout for negotiate stage
   void processNegotiateTimeout(
       std::string const& ifName, std::string const& neighborName);
@@ -427,26 +503,28 @@ class Spark final : public OpenrEventBase {
   // UDP port for send/recv of spark hello messages
   const uint16_t neighborDiscoveryPort_{6666};
 
+  // Timers below are updated with reloaded config
+
   // Spark hello msg sendout interval
-  const std::chrono::milliseconds helloTime_{0};
+  std::chrono::milliseconds helloTime_{0};
 
   // Spark hello msg sendout interval under fast-init case
-  const std::chrono::milliseconds fastInitHelloTime_{0};
+  std::chrono::milliseconds fastInitHelloTime_{0};
 
   // Spark handshake msg sendout interval
-  const std::chrono::milliseconds handshakeTime_{0};
+  std::chrono::milliseconds handshakeTime_{0};
 
   // Spark heartbeat msg sendout interval (keepAliveTime)
-  const std::chrono::milliseconds keepAliveTime_{0};
+  std::chrono::milliseconds keepAliveTime_{0};
 
   // Spark negotiate stage hold time
-  const std::chrono::milliseconds handshakeHoldTime_{0};
+  std::chrono::milliseconds handshakeHoldTime_{0};
 
   // Spark heartbeat msg hold time
-  const std::chrono::milliseconds holdTime_{0};
+  std::chrono::milliseconds holdTime_{0};
 
   // Spark hold time under graceful-restart mode
-  const std::chrono::milliseconds gracefulRestartTime_{0};
+  std::chrono::milliseconds gracefulRestartTime_{0};
 
   // This flag indicates that we will also exchange v4 transportAddress in
   // Spark HelloMessage
@@ -459,6 +537,9 @@ class Spark final : public OpenrEventBase {
   // the multicast socket we use
   int mcastFd_{-1};
 
+  // in-kernel filter of packets received on mcastFd_, if attached
+  std::unique_ptr<SparkSocketFilter> socketFilter_;
+
   // state transition matrix for Finite-State-Machine
   static const std::vector<std::vector<std::optional<SparkNeighState>>>
       stateMap_;
@@ -476,21 +557,30 @@ class Spark final : public OpenrEventBase {
   // enable dual or not
   const bool enableFloodOptimization_{false};
 
+  // enable hash-tree based KvStore full-sync or not
+  const bool enableHashTreeSync_{false};
+
+  // enable compressed KvStore values or not
+  const bool enableValueCompression_{false};
+
   // Map of interface entries keyed by ifName
   std::unordered_map<std::string, Interface> interfaceDb_{};
 
+  // Timer wheel shared by timers of all the interfaces and neighbors. There
+  // can be tens of thousands of them and they're frequently rescheduled.
+  folly::HHWheelTimer::UniquePtr timerWheel_;
+
   // Hello packet send timers for each interface
-  std::unordered_map<
-      std::string /* ifName */,
-      std::unique_ptr<folly::AsyncTimeout>>
+  std::unordered_map<std::string /* ifName */, std::unique_ptr<WheelTimeout>>
       ifNameToHelloTimers_{};
 
   // heartbeat packet send timers for each interface
-  std::unordered_map<
-      std::string /* ifName */,
-      std::unique_ptr<folly::AsyncTimeout>>
+  std::unordered_map<std::string /* ifName */, std::unique_ptr<WheelTimeout>>
       ifNameToHeartbeatTimers_{};
 
+  // interfaces with heartbeat msg queued for sending
+  std::set<std::string /* ifName */> pendingHeartbeatIfNames_{};
+
   // number of active neighbors for each interface
   std::unordered_map<
       std::string /* ifName */,
@@ -516,7 +606,39 @@ class Spark final : public OpenrEventBase {
   // global openr config
   std::shared_ptr<const Config> config_{nullptr};
 
+  // buffers to receive batch of packets from multicast socket
+  IoProvider::RecvBuffers recvBuffers_;
+
   // Timer for updating and submitting counters periodically
   std::unique_ptr<folly::AsyncTimeout> counterUpdateTimer_{nullptr};
+
+  // Whether kernel reports transmit timestamps of packets sent on mcastFd_
+  bool txTimestampingEnabled_{false};
+
+  // Id of next packet sent on mcastFd_, as counted by kernel for reporting
+  // its transmit timestamp (SOF_TIMESTAMPING_OPT_ID)
+  uint32_t nextTxPacketId_{0};
+
+  // Hello packets awaiting transmit timestamp in order of sending
+  std::deque<std::pair<uint32_t /* id */, std::chrono::microseconds>>
+      pendingTxHellos_;
+
+  // Transmit timestamps of hello packets keyed by their sentTsInUs
+  folly::EvictingCacheMap<int64_t, std::chrono::microseconds>
+      helloTxTimestamps_;
+
+  // Deduced area of neighbors by <ifName, neighborName>
+  folly::EvictingCacheMap<
+      std::pair<std::string, std::string>,
+      std::string,
+      folly::hasher<std::pair<std::string, std::string>>>
+      neighborAreas_;
+
+  // Timer for sending heartbeats queued in the current event loop iteration
+  std::unique_ptr<folly::AsyncTimeout> heartbeatSendTimer_{nullptr};
+
+  // Fast liveness detection of neighbors, if enabled. Declared last to stop
+  // its thread first, as it posts neighbor down events to this event base
+  std::unique_ptr<FastLiveness> fastLiveness_{nullptr};
 };
 } // namespace openr
@@ -0,0 +1,259 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SparkSocketFilter.h"
+
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <folly/String.h>
+#include <glog/logging.h>
+
+#ifndef SO_ATTACH_BPF
+#define SO_ATTACH_BPF 50
+#endif
+
+namespace openr {
+
+namespace {
+
+// packet data seen by socket filter of UDP socket starts with UDP header,
+// and IPv6 header is reached via offset relative to network header
+constexpr uint32_t kUdpHeaderSize{8};
+constexpr int32_t kHopLimitOffset{SKF_NET_OFF + 7};
+
+int
+bpfSyscall(int cmd, union bpf_attr* attr) {
+  return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+bpf_insn
+makeInsn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+  bpf_insn insn{};
+  insn.code = code;
+  insn.dst_reg = dst;
+  insn.src_reg = src;
+  insn.off = off;
+  insn.imm = imm;
+  return insn;
+}
+
+// same checks as eBPF program, return 0 drops the packet
+std::vector<sock_filter>
+makeClassicProgram(int hopLimit, uint32_t minLen, uint32_t maxLen) {
+  const auto hopLimitOffset = static_cast<uint32_t>(kHopLimitOffset);
+  return {
+      // 0: A = hop limit
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, hopLimitOffset),
+      // 1: drop unless A == hopLimit
+      BPF_JUMP(
+          BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(hopLimit), 0, 4),
+      // 2: A = length
+      BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+      // 3: drop if A > maxLen
+      BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, maxLen, 2, 0),
+      // 4: drop unless A >= minLen
+      BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, minLen, 0, 1),
+      // 5: accept whole packet
+      BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+      // 6: drop
+      BPF_STMT(BPF_RET | BPF_K, 0),
+  };
+}
+
+// eBPF program counting drops per reason in array map `mapFd`
+std::vector<bpf_insn>
+makeProgram(int mapFd, int hopLimit, uint32_t minLen, uint32_t maxLen) {
+  std::vector<bpf_insn> insns;
+  // jumps are patched once their target is known
+  auto jumpTo = [&](size_t jumpIndex, size_t target) {
+    insns.at(jumpIndex).off = static_cast<int16_t>(target - jumpIndex - 1);
+  };
+
+  // r6 = skb, as required for packet loads. r0 = hop limit
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0));
+  insns.emplace_back(
+      makeInsn(BPF_LD | BPF_B | BPF_ABS, 0, 0, 0, kHopLimitOffset));
+  const size_t hopLimitJump = insns.size();
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_JNE | BPF_K, 0, 0, 0, hopLimit));
+
+  // r7 = skb->len
+  insns.emplace_back(makeInsn(
+      BPF_LDX | BPF_W | BPF_MEM, 7, 6, offsetof(struct __sk_buff, len), 0));
+  const size_t tooLongJump = insns.size();
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_JGT | BPF_K, 7, 0, 0, maxLen));
+  const size_t acceptJump = insns.size();
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_JGE | BPF_K, 7, 0, 0, minLen));
+
+  // drop reason is stored at fp-4, as key of map lookup
+  std::vector<size_t> countJumps;
+  auto addDrop = [&](SparkSocketFilter::DropReason reason) {
+    insns.emplace_back(makeInsn(BPF_ST | BPF_W | BPF_MEM, 10, 0, -4, reason));
+    countJumps.emplace_back(insns.size());
+    insns.emplace_back(makeInsn(BPF_JMP | BPF_JA, 0, 0, 0, 0));
+  };
+  addDrop(SparkSocketFilter::TOO_SHORT);
+  jumpTo(tooLongJump, insns.size());
+  addDrop(SparkSocketFilter::TOO_LONG);
+  jumpTo(hopLimitJump, insns.size());
+  addDrop(SparkSocketFilter::HOP_LIMIT);
+
+  // r0 = map_lookup_elem(map, fp-4), and atomically increment its value
+  for (auto jump : countJumps) {
+    jumpTo(jump, insns.size());
+  }
+  insns.emplace_back(
+      makeInsn(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0, mapFd));
+  insns.emplace_back(makeInsn(0, 0, 0, 0, 0));
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_MOV | BPF_X, 2, 10, 0, 0));
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_ADD | BPF_K, 2, 0, 0, -4));
+  insns.emplace_back(
+      makeInsn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem));
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 2, 0));
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_MOV | BPF_K, 1, 0, 0, 1));
+  insns.emplace_back(makeInsn(BPF_STX | BPF_DW | BPF_XADD, 0, 1, 0, 0));
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, 0));
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+  // accept whole packet
+  jumpTo(acceptJump, insns.size());
+  insns.emplace_back(makeInsn(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, -1));
+  insns.emplace_back(makeInsn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+  return insns;
+}
+
+// Returns fd of array map of drop counts with eBPF filter attached to the
+// socket, or -1 on failure
+int
+attachProgram(
+    int fd,
+    IoProvider* ioProvider,
+    int hopLimit,
+    uint32_t minLen,
+    uint32_t maxLen) {
+  union bpf_attr mapAttr {};
+  mapAttr.map_type = BPF_MAP_TYPE_ARRAY;
+  mapAttr.key_size = sizeof(uint32_t);
+  mapAttr.value_size = sizeof(uint64_t);
+  mapAttr.max_entries = SparkSocketFilter::kNumDropReasons;
+  const int mapFd = bpfSyscall(BPF_MAP_CREATE, &mapAttr);
+  if (mapFd < 0) {
+    LOG(WARNING) << "Failed to create eBPF map of Spark socket filter. Error: "
+                 << folly::errnoStr(errno);
+    return -1;
+  }
+
+  const auto insns = makeProgram(mapFd, hopLimit, minLen, maxLen);
+  const char license[] = "MIT";
+  union bpf_attr progAttr {};
+  progAttr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+  progAttr.insns = reinterpret_cast<uint64_t>(insns.data());
+  progAttr.insn_cnt = insns.size();
+  progAttr.license = reinterpret_cast<uint64_t>(license);
+  const int progFd = bpfSyscall(BPF_PROG_LOAD, &progAttr);
+  if (progFd < 0) {
+    LOG(WARNING) << "Failed to load eBPF Spark socket filter. Error: "
+                 << folly::errnoStr(errno);
+    close(mapFd);
+    return -1;
+  }
+
+  // socket holds reference to the program once attached
+  const int ret = ioProvider->setsockopt(
+      fd, SOL_SOCKET, SO_ATTACH_BPF, &progFd, sizeof(progFd));
+  const auto savedErrno = errno;
+  close(progFd);
+  if (ret != 0) {
+    LOG(WARNING) << "Failed to attach eBPF Spark socket filter. Error: "
+                 << folly::errnoStr(savedErrno);
+    close(mapFd);
+    return -1;
+  }
+  return mapFd;
+}
+
+} // namespace
+
+constexpr size_t SparkSocketFilter::kNumDropReasons;
+
+std::unique_ptr<SparkSocketFilter>
+SparkSocketFilter::attach(
+    int fd,
+    IoProvider* ioProvider,
+    int hopLimit,
+    size_t minPayloadSize,
+    size_t maxPayloadSize) {
+  const uint32_t minLen = kUdpHeaderSize + minPayloadSize;
+  const uint32_t maxLen = kUdpHeaderSize + maxPayloadSize;
+
+  const int mapFd = attachProgram(fd, ioProvider, hopLimit, minLen, maxLen);
+  if (mapFd >= 0) {
+    LOG(INFO) << "Attached eBPF filter to Spark socket";
+    return std::unique_ptr<SparkSocketFilter>(new SparkSocketFilter(mapFd));
+  }
+
+  auto filter = makeClassicProgram(hopLimit, minLen, maxLen);
+  sock_fprog prog{};
+  prog.len = filter.size();
+  prog.filter = filter.data();
+  if (ioProvider->setsockopt(
+          fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0) {
+    LOG(ERROR) << "Failed to attach classic BPF filter to Spark socket. "
+               << "Error: " << folly::errnoStr(errno);
+    return nullptr;
+  }
+  LOG(INFO) << "Attached classic BPF filter to Spark socket, drops of the "
+            << "filter are not counted";
+  return std::unique_ptr<SparkSocketFilter>(new SparkSocketFilter(-1));
+}
+
+SparkSocketFilter::SparkSocketFilter(int mapFd) : mapFd_(mapFd) {}
+
+SparkSocketFilter::~SparkSocketFilter() {
+  if (mapFd_ >= 0) {
+    close(mapFd_);
+  }
+}
+
+std::array<uint64_t, SparkSocketFilter::kNumDropReasons>
+SparkSocketFilter::getDropCounts() const {
+  std::array<uint64_t, kNumDropReasons> counts{};
+  if (mapFd_ < 0) {
+    return counts;
+  }
+  for (uint32_t key = 0; key < kNumDropReasons; ++key) {
+    union bpf_attr attr {};
+    attr.map_fd = mapFd_;
+    attr.key = reinterpret_cast<uint64_t>(&key);
+    attr.value = reinterpret_cast<uint64_t>(&counts[key]);
+    if (bpfSyscall(BPF_MAP_LOOKUP_ELEM, &attr) != 0) {
+      LOG(ERROR) << "Failed to read drop count of Spark socket filter. Error: "
+                 << folly::errnoStr(errno);
+    }
+  }
+  return counts;
+}
+
+folly::StringPiece
+SparkSocketFilter::getDropReasonName(DropReason reason) {
+  switch (reason) {
+  case HOP_LIMIT:
+    return "hop_limit";
+  case TOO_SHORT:
+    return "too_short";
+  case TOO_LONG:
+    return "too_long";
+  }
+  return "unknown";
+}
+
+} // namespace openr
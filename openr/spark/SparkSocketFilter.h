@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <folly/Range.h>
+
+#include <openr/spark/IoProvider.h>
+
+namespace openr {
+
+/**
+ * Socket filter of Spark UDP socket, dropping in kernel the packets which
+ * Spark would reject anyway, before they cost a wakeup, syscall and copy:
+ * packets with hop limit other than the one of Spark (i.e. not sent by a
+ * direct neighbor), and with payload of unexpected size.
+ *
+ * Filter is attached as eBPF program counting drops per reason in an array
+ * map, which is read from userspace. If eBPF isn't permitted (e.g. lacking
+ * CAP_BPF), classic BPF with the same checks, but without counters, is
+ * attached instead. Filter stays attached for the lifetime of the socket.
+ */
+class SparkSocketFilter final {
+ public:
+  enum DropReason : uint32_t {
+    HOP_LIMIT = 0,
+    TOO_SHORT = 1,
+    TOO_LONG = 2,
+  };
+  static constexpr size_t kNumDropReasons{3};
+
+  /**
+   * Attach filter to UDP socket `fd`, accepting packets with `hopLimit`
+   * and payload size in [minPayloadSize, maxPayloadSize]. Returns nullptr
+   * if neither eBPF nor classic BPF filter could be attached.
+   */
+  static std::unique_ptr<SparkSocketFilter> attach(
+      int fd,
+      IoProvider* ioProvider,
+      int hopLimit,
+      size_t minPayloadSize,
+      size_t maxPayloadSize);
+
+  ~SparkSocketFilter();
+
+  // Whether drops are counted, i.e. filter is eBPF program
+  bool
+  hasDropCounts() const {
+    return mapFd_ >= 0;
+  }
+
+  // Number of packets dropped per reason since filter got attached. All
+  // zero without counters
+  std::array<uint64_t, kNumDropReasons> getDropCounts() const;
+
+  static folly::StringPiece getDropReasonName(DropReason reason);
+
+ private:
+  explicit SparkSocketFilter(int mapFd);
+
+  SparkSocketFilter(SparkSocketFilter const&) = delete;
+  SparkSocketFilter& operator=(SparkSocketFilter const&) = delete;
+
+  // array map of drop counts, -1 for classic BPF
+  const int mapFd_{-1};
+};
+
+} // namespace openr
@@ -7,6 +7,8 @@
 
 #include "SparkWrapper.h"
 
+#include <time.h>
+
 using namespace fbzmq;
 
 namespace openr {
@@ -57,7 +59,11 @@ bool
 SparkWrapper::updateInterfaceDb(
     const std::vector<SparkInterfaceEntry>& interfaceEntries) {
   thrift::InterfaceDatabase ifDb(
-      apache::thrift::FRAGILE, myNodeName_, {}, thrift::PerfEvents());
+      apache::thrift::FRAGILE,
+      myNodeName_,
+      {},
+      thrift::PerfEvents(),
+      false /* isDelta */);
   ifDb.perfEvents_ref().reset();
 
   for (const auto& interface : interfaceEntries) {
@@ -131,6 +137,16 @@ SparkWrapper::getSparkNeighState(
   return spark_->getSparkNeighState(ifName, neighborName);
 }
 
+std::chrono::nanoseconds
+SparkWrapper::getCpuTime() {
+  struct timespec ts {
+    0, 0
+  };
+  spark_->getEvb()->runInEventBaseThreadAndWait(
+      [&ts]() { ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts); });
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
 thrift::AreaConfig
 SparkWrapper::createAreaConfig(
     const std::string& areaId,
@@ -64,6 +64,9 @@ class SparkWrapper {
   std::optional<SparkNeighState> getSparkNeighState(
       std::string const& ifName, std::string const& neighborName);
 
+  // CPU time consumed by Spark thread so far
+  std::chrono::nanoseconds getCpuTime();
+
   static std::pair<folly::IPAddress, folly::IPAddress> getTransportAddrs(
       const thrift::SparkNeighborEvent& event);
 
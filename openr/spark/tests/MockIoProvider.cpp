@@ -62,16 +62,26 @@ MockIoProvider::fcntl(int sockFd, int /* cmd */, int /* arg */) {
 
 int
 MockIoProvider::bind(
-    int sockFd, const struct sockaddr* /* my_addr */, socklen_t /* addrlen */) {
+    int sockFd, const struct sockaddr* my_addr, socklen_t addrlen) {
   VLOG(4) << "MockIoProvider::bind called";
 
+  folly::SocketAddress sockAddr;
+  sockAddr.setFromSockaddr(my_addr, addrlen);
+
   std::lock_guard<std::mutex> lock(mutex_);
   CHECK(pipeFds_.count(sockFd));
+  fdToPort_[sockFd] = sockAddr.getPort();
   return 0;
 }
 
 ssize_t
-MockIoProvider::recvmsg(int sockFd, struct msghdr* msg, int /* flags */) {
+MockIoProvider::recvmsg(int sockFd, struct msghdr* msg, int flags) {
+  // transmit timestamps are not mocked, error queue is always empty
+  if (flags & MSG_ERRQUEUE) {
+    errno = EAGAIN;
+    return -1;
+  }
+
   std::lock_guard<std::mutex> lock(mutex_);
 
   SCOPE_FAIL {
@@ -98,12 +108,67 @@ MockIoProvider::recvmsg(int sockFd, struct msghdr* msg, int /* flags */) {
 
   // pull the addr and the message from queue
   auto const ioMessage = it->second.front(); // NOTE copy on purpose
-  auto const& srcAddr = ioMessage.srcAddr;
-  auto const& packet = ioMessage.data;
 
   // discard message from queue
   it->second.pop_front();
 
+  return fillRecvMessage(ioMessage, msg);
+}
+
+int
+MockIoProvider::recvmmsg(
+    int sockFd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int /* flags */,
+    struct timespec* /* timeout */) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  SCOPE_FAIL {
+    LOG(ERROR) << "MockIoProvider::recvmmsg failed";
+  };
+
+  VLOG(4) << "MockIoProvider::recvmmsg called ";
+
+  CHECK(pipeFds_.count(sockFd));
+
+  auto it = mailboxes_.find(sockFd);
+  CHECK_THROW(it != mailboxes_.end(), std::invalid_argument);
+  auto& mailbox = it->second;
+
+  // Deliver messages which are due, as they would have been queued on socket
+  unsigned int numMsgs = 0;
+  while (numMsgs < vlen and mailbox.size() and
+         (mailbox.front().clientNotified or mailbox.front().isActive())) {
+    // Read the signal byte of the message if it was sent
+    uint8_t buf;
+    if (mailbox.front().clientNotified and
+        read(sockFd, &buf, sizeof(buf)) > 0) {
+      CHECK_EQ(1, buf); // We must receive what we send
+    }
+
+    auto const ioMessage = mailbox.front(); // NOTE copy on purpose
+    mailbox.pop_front();
+    msgvec[numMsgs].msg_len =
+        fillRecvMessage(ioMessage, &msgvec[numMsgs].msg_hdr);
+    ++numMsgs;
+  }
+
+  if (numMsgs == 0) {
+    VLOG(4) << "No due messages for fd " << sockFd << " ifName "
+            << fdToIfName_[sockFd];
+    errno = EAGAIN;
+    return -1;
+  }
+  return numMsgs;
+}
+
+ssize_t
+MockIoProvider::fillRecvMessage(
+    const IoMessage& ioMessage, struct msghdr* msg) {
+  auto const& srcAddr = ioMessage.srcAddr;
+  auto const& packet = ioMessage.data;
+
   // deliver the address
   sockaddr_storage addrStorage;
   folly::SocketAddress sockAddr(srcAddr, kMockedUdpPort);
@@ -200,6 +265,15 @@ MockIoProvider::sendmsg(int sockFd, const struct msghdr* msg, int /* flags */) {
 
   auto srcIfName = ifIndexToIfName_.at(srcIfIndex);
 
+  // deliver to sockets bound to destination port, Spark's by default
+  int dstPort{kMockedUdpPort};
+  if (msg->msg_name != nullptr) {
+    folly::SocketAddress dstAddr;
+    dstAddr.setFromSockaddr(
+        static_cast<const struct sockaddr*>(msg->msg_name), msg->msg_namelen);
+    dstPort = dstAddr.getPort();
+  }
+
   VLOG(4) << "MockIoProvider::sendmsg sending message from iface " << srcIfName;
 
   // walk over all connected interfaces
@@ -219,7 +293,7 @@ MockIoProvider::sendmsg(int sockFd, const struct msghdr* msg, int /* flags */) {
     }
 
     try {
-      otherFd = ifIndexToFd_.at(dstIfIndex);
+      otherFd = ifIndexToFd_.at(std::make_pair(dstIfIndex, dstPort));
     } catch (std::out_of_range const& err) {
       LOG(ERROR) << "No sockets bound to " << dstIfName;
       continue;
@@ -254,6 +328,24 @@ MockIoProvider::sendmsg(int sockFd, const struct msghdr* msg, int /* flags */) {
   return -1;
 }
 
+int
+MockIoProvider::sendmmsg(
+    int sockFd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  VLOG(4) << "MockIoProvider::sendmmsg called";
+
+  unsigned int numSent{0};
+  for (; numSent < vlen; ++numSent) {
+    auto bytesSent = sendmsg(sockFd, &msgvec[numSent].msg_hdr, flags);
+    if (bytesSent < 0) {
+      break;
+    }
+    msgvec[numSent].msg_len = bytesSent;
+  }
+
+  // like sendmmsg, error is reported only if no message could be sent
+  return numSent ? numSent : -1;
+}
+
 //
 // Simply accept all setsockopts, and build fd to ifName mapping
 //
@@ -280,7 +372,10 @@ MockIoProvider::setsockopt(
       errno = ERANGE;
       return -1;
     }
-    ifIndexToFd_[ifIndex] = sockFd;
+    auto portIt = fdToPort_.find(sockFd);
+    const int port =
+        portIt != fdToPort_.end() ? portIt->second : kMockedUdpPort;
+    ifIndexToFd_[std::make_pair(static_cast<int>(ifIndex), port)] = sockFd;
     fdToIfName_[sockFd] = ifName;
   }
 
@@ -312,6 +407,17 @@ MockIoProvider::addIfNameIfIndex(const IfNameAndifIndex& entries) {
 // to spark (via linux pipe) to read the message if there is any active
 // message for it.
 //
+size_t
+MockIoProvider::getNumPendingMessages() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  size_t numMessages{0};
+  for (auto const& kv : mailboxes_) {
+    numMessages += kv.second.size();
+  }
+  return numMessages;
+}
+
 void
 MockIoProvider::processMailboxes() {
   VLOG(5) << "MockIoProvider::processMailboxes called";
@@ -96,8 +96,23 @@ class MockIoProvider final : public IoProvider {
 
   ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags) override;
 
+  // Receives all the messages which are due for delivery, upto vlen
+  int recvmmsg(
+      int sockfd,
+      struct mmsghdr* msgvec,
+      unsigned int vlen,
+      int flags,
+      struct timespec* timeout) override;
+
   ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags) override;
 
+  // Sends messages one by one with sendmsg, stopping at the first failure
+  int sendmmsg(
+      int sockfd,
+      struct mmsghdr* msgvec,
+      unsigned int vlen,
+      int flags) override;
+
   int setsockopt(
       int sockfd,
       int level,
@@ -110,6 +125,9 @@ class MockIoProvider final : public IoProvider {
   //
   void addIfNameIfIndex(const IfNameAndifIndex& entries);
 
+  // Number of messages sent but not yet received, across all the sockets
+  size_t getNumPendingMessages();
+
  private:
   // Boolean to keep track of running-state of MockIoProvider
   std::atomic<bool> isRunning_{false};
@@ -131,9 +149,14 @@ class MockIoProvider final : public IoProvider {
 
   std::map<std::string /* ifName */, int /* ifIndex */> ifNameToIfIndex_{};
 
+  // port each fd is bound to
+  std::map<int /* fd */, int /* port */> fdToPort_{};
+
   // maps the fds that have joined the interface: we can have same fd
-  // joining on multiple interfaces
-  std::map<int /* ifIndex */, int /* fd */> ifIndexToFd_{};
+  // joining on multiple interfaces, and fds bound to different ports
+  // joining the same interface
+  std::map<std::pair<int /* ifIndex */, int /* port */>, int /* fd */>
+      ifIndexToFd_{};
 
   struct IoMessage {
     IoMessage(
@@ -171,5 +194,9 @@ class MockIoProvider final : public IoProvider {
 
   // the list of messages pending per fd
   std::map<int /* fd */, std::list<IoMessage>> mailboxes_{};
+
+  // Fill message header with the data, sender address and control data of
+  // the message. Returns size of the message
+  ssize_t fillRecvMessage(const IoMessage& ioMessage, struct msghdr* msg);
 };
 } // namespace openr
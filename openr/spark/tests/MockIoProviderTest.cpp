@@ -1617,6 +1617,163 @@ TEST(MockIoProviderTestSetup, PartialMeshOfNodesTest) {
   mockIoProviderThread.join();
 }
 
+//
+// Messages which are due are received in batches with recvmmsg, upto size of
+// the batch.
+//
+TEST(MockIoProviderTestSetup, RecvMessagesTest) {
+  folly::IPAddressV6 ipAddr1V6("fe80::1");
+  std::string ifName1("iface1");
+  std::string ifName2("iface2");
+  int ifIndex1 = 1;
+  int ifIndex2 = 2;
+
+  auto mockIoProvider = std::make_shared<MockIoProvider>();
+  std::thread mockIoProviderThread([&]() { mockIoProvider->start(); });
+  mockIoProvider->waitUntilRunning();
+
+  mockIoProvider->addIfNameIfIndex({{ifName1, ifIndex1}, {ifName2, ifIndex2}});
+  mockIoProvider->setConnectedPairs({{ifName1, {{ifName2, 10}}}});
+
+  int fd1 = createSocketAndJoinGroup(
+      mockIoProvider, ifIndex1, folly::IPAddress(kDiscardMulticastAddr));
+  int fd2 = createSocketAndJoinGroup(
+      mockIoProvider, ifIndex2, folly::IPAddress(kDiscardMulticastAddr));
+
+  // Nothing to receive
+  IoProvider::RecvBuffers buffers(2, kMinIpv6PktSize);
+  EXPECT_TRUE(
+      IoProvider::recvMessages(fd2, buffers, mockIoProvider.get()).empty());
+
+  // Send 3 packets and wait for them to be due
+  const std::vector<std::string> packets{"packet #1", "packet #2", "#3"};
+  for (auto const& packet : packets) {
+    EXPECT_EQ(
+        packet.size(),
+        IoProvider::sendMessage(
+            fd1,
+            ifIndex1,
+            ipAddr1V6,
+            folly::SocketAddress(kDiscardMulticastAddr, kMockedUdpPort),
+            packet,
+            mockIoProvider.get()));
+  }
+  waitForDataToRead(fd2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // First two packets are received with first batch and third one with next
+  for (size_t i = 0; i < packets.size(); i += 2) {
+    auto messages =
+        IoProvider::recvMessages(fd2, buffers, mockIoProvider.get());
+    ASSERT_EQ(std::min<size_t>(2, packets.size() - i), messages.size());
+    for (size_t j = 0; j < messages.size(); ++j) {
+      auto const& packet = packets.at(i + j);
+      auto const& [size, ifIndex, srcAddr, hopLimit, recvTs, tsSource] =
+          messages.at(j);
+      EXPECT_EQ(packet.size(), size);
+      // mocked messages carry no kernel timestamp
+      EXPECT_EQ(IoProvider::TimestampSource::USER, tsSource);
+      EXPECT_EQ(ifIndex2, ifIndex);
+      EXPECT_EQ(folly::IPAddress(ipAddr1V6), srcAddr.getIPAddress());
+      EXPECT_EQ(
+          packet,
+          std::string(
+              reinterpret_cast<const char*>(buffers.getData(j)), size));
+    }
+  }
+  EXPECT_TRUE(
+      IoProvider::recvMessages(fd2, buffers, mockIoProvider.get()).empty());
+
+  // Transmit timestamps are not mocked
+  EXPECT_TRUE(
+      IoProvider::recvTxTimestamps(fd1, 16, mockIoProvider.get()).empty());
+
+  // Cleanup
+  mockIoProvider->stop();
+  mockIoProviderThread.join();
+}
+
+//
+// Same message is sent via multiple interfaces with sendmmsg. Interface via
+// which message can't be sent doesn't stop the rest from being sent.
+//
+TEST(MockIoProviderTestSetup, SendMessagesTest) {
+  folly::IPAddressV6 ipAddr1V6("fe80::1");
+  folly::IPAddressV6 ipAddr3V6("fe80::3");
+  folly::IPAddressV6 ipAddr4V6("fe80::4");
+  std::string ifName1("iface1");
+  std::string ifName2("iface2");
+  std::string ifName3("iface3");
+  std::string ifName4("iface4");
+  int ifIndex1 = 1;
+  int ifIndex2 = 2;
+  int ifIndex3 = 3;
+  int ifIndex4 = 4;
+
+  auto mockIoProvider = std::make_shared<MockIoProvider>();
+  std::thread mockIoProviderThread([&]() { mockIoProvider->start(); });
+  mockIoProvider->waitUntilRunning();
+
+  // iface4 isn't connected to anything
+  mockIoProvider->addIfNameIfIndex({{ifName1, ifIndex1},
+                                    {ifName2, ifIndex2},
+                                    {ifName3, ifIndex3},
+                                    {ifName4, ifIndex4}});
+  mockIoProvider->setConnectedPairs(
+      {{ifName1, {{ifName2, 10}}}, {ifName3, {{ifName2, 10}}}});
+
+  int fd1 = createSocketAndJoinGroup(
+      mockIoProvider, ifIndex1, folly::IPAddress(kDiscardMulticastAddr));
+  int fd2 = createSocketAndJoinGroup(
+      mockIoProvider, ifIndex2, folly::IPAddress(kDiscardMulticastAddr));
+
+  // Nothing to send
+  const std::string packet{"heartbeat"};
+  EXPECT_TRUE(IoProvider::sendMessages(
+                  fd1,
+                  {},
+                  folly::SocketAddress(kDiscardMulticastAddr, kMockedUdpPort),
+                  packet,
+                  mockIoProvider.get())
+                  .empty());
+
+  auto bytesSent = IoProvider::sendMessages(
+      fd1,
+      {{ifIndex1, ipAddr1V6}, {ifIndex4, ipAddr4V6}, {ifIndex3, ipAddr3V6}},
+      folly::SocketAddress(kDiscardMulticastAddr, kMockedUdpPort),
+      packet,
+      mockIoProvider.get());
+  EXPECT_EQ(
+      std::vector<ssize_t>(
+          {static_cast<ssize_t>(packet.size()),
+           -1,
+           static_cast<ssize_t>(packet.size())}),
+      bytesSent);
+
+  // Both the messages are received on iface2
+  waitForDataToRead(fd2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  IoProvider::RecvBuffers buffers(4, kMinIpv6PktSize);
+  auto messages = IoProvider::recvMessages(fd2, buffers, mockIoProvider.get());
+  ASSERT_EQ(2, messages.size());
+  const std::vector<folly::IPAddressV6> srcAddrs{ipAddr1V6, ipAddr3V6};
+  for (size_t i = 0; i < messages.size(); ++i) {
+    auto const& [size, ifIndex, srcAddr, hopLimit, recvTs, tsSource] =
+        messages.at(i);
+    EXPECT_EQ(packet.size(), size);
+    EXPECT_EQ(ifIndex2, ifIndex);
+    EXPECT_EQ(folly::IPAddress(srcAddrs.at(i)), srcAddr.getIPAddress());
+    EXPECT_EQ(
+        packet,
+        std::string(reinterpret_cast<const char*>(buffers.getData(i)), size));
+  }
+
+  // Cleanup
+  mockIoProvider->stop();
+  mockIoProviderThread.join();
+}
+
 int
 main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,476 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <unistd.h>
+#include <fstream>
+#include <thread>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/if/gen-cpp2/KvStore_constants.h>
+#include <openr/if/gen-cpp2/Spark_types.h>
+#include <openr/spark/IoProvider.h>
+#include <openr/spark/SparkWrapper.h>
+#include <openr/spark/tests/MockIoProvider.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes parameters to another one.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace {
+
+const std::string kDomainName("Fire_and_Blood");
+const std::string kNodeName("node-dut");
+
+// Spark doesn't fit neighbor infos of more neighbors per interface in hello
+const size_t kMaxNeighborsPerIface = 30;
+
+// Rounds of packets from all the neighbors are spaced so that per-source rate
+// limiting of Spark doesn't drop them
+const std::chrono::milliseconds kPacketRoundInterval{500};
+
+// Hold time advertised by simulated neighbors, so that adjacencies stay up
+// without heartbeats
+const std::chrono::milliseconds kNeighborHoldTime{std::chrono::hours(1)};
+
+// Resident memory of the process
+size_t
+getRssBytes() {
+  size_t totalPages{0}, residentPages{0};
+  std::ifstream statm("/proc/self/statm");
+  statm >> totalPages >> residentPages;
+  return residentPages * ::sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Network of a single Spark instance (DUT) with `numIfaces` interfaces, each
+ * connected to `neighborsPerIface` simulated neighbors over MockIoProvider.
+ *
+ * Simulated neighbors are open-loop: they don't run Spark, but send crafted
+ * hello/handshake/heartbeat packets which drive DUT through the neighbor
+ * state machine. Packets of the DUT are drained and discarded.
+ */
+class SparkSimulation {
+ public:
+  SparkSimulation(size_t numIfaces, size_t neighborsPerIface)
+      : numIfaces_(numIfaces), neighborsPerIface_(neighborsPerIface) {
+    CHECK_LE(neighborsPerIface_, kMaxNeighborsPerIface);
+
+    mockIoProviderThread_ = std::make_unique<std::thread>(
+        [this]() { mockIoProvider_->start(); });
+    mockIoProvider_->waitUntilRunning();
+
+    // DUT interface `dut-i` is connected to neighbor interface `nbr-i`
+    IfNameAndifIndex ifNameAndIfIndex;
+    ConnectedIfPairs connectedPairs;
+    for (size_t i = 0; i < numIfaces_; ++i) {
+      ifNameAndIfIndex.emplace_back(getIfName(i), getIfIndex(i));
+      ifNameAndIfIndex.emplace_back(getNbrIfName(i), getNbrIfIndex(i));
+      connectedPairs[getIfName(i)] = {{getNbrIfName(i), 0}};
+      connectedPairs[getNbrIfName(i)] = {{getIfName(i), 0}};
+    }
+    mockIoProvider_->addIfNameIfIndex(ifNameAndIfIndex);
+    mockIoProvider_->setConnectedPairs(connectedPairs);
+
+    // single socket for all the neighbors
+    nbrFd_ = mockIoProvider_->socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    for (size_t i = 0; i < numIfaces_; ++i) {
+      struct ipv6_mreq mreq;
+      mreq.ipv6mr_interface = getNbrIfIndex(i);
+      CHECK_EQ(
+          0,
+          mockIoProvider_->setsockopt(
+              nbrFd_, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq)));
+    }
+
+    auto tConfig = getBasicOpenrConfig(
+        kNodeName, kDomainName, std::nullopt, false /* enableV4 */);
+    config_ = std::make_shared<Config>(tConfig);
+    spark_ = std::make_unique<SparkWrapper>(
+        kNodeName,
+        std::make_pair(
+            Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+        mockIoProvider_,
+        config_);
+
+    std::vector<SparkInterfaceEntry> interfaceEntries;
+    for (size_t i = 0; i < numIfaces_; ++i) {
+      interfaceEntries.push_back(SparkInterfaceEntry{
+          getIfName(i),
+          getIfIndex(i),
+          folly::IPAddress::createNetwork(
+              folly::sformat("10.{}.{}.0/31", i / 256, i % 256)),
+          folly::IPAddress::createNetwork("fe80::1/128", -1, false)});
+    }
+    spark_->updateInterfaceDb(interfaceEntries);
+
+    // all the interfaces are added at once, hence first packet sent by DUT
+    // means that it's tracking all of them
+    while (not drainDutPackets()) {
+      std::this_thread::yield();
+    }
+  }
+
+  ~SparkSimulation() {
+    spark_.reset();
+    mockIoProvider_->stop();
+    mockIoProviderThread_->join();
+  }
+
+  size_t
+  getNumNeighbors() const {
+    return numIfaces_ * neighborsPerIface_;
+  }
+
+  // Send hello from every neighbor, reflecting DUT if `reflectDut` is set.
+  // First hello moves neighbors to WARM and reflecting one to NEGOTIATE.
+  void
+  sendHellos(bool reflectDut) {
+    forEachNeighbor([this, reflectDut](size_t i, size_t j) {
+      sendHello(i, j, reflectDut);
+    });
+  }
+
+  // Send handshake from every neighbor, moving them to ESTABLISHED
+  void
+  sendHandshakes() {
+    forEachNeighbor([this](size_t i, size_t j) { sendHandshake(i, j); });
+  }
+
+  // Wait for DUT to report all the neighbors up
+  void
+  waitForNeighborsUp() {
+    while (numUp_ < getNumNeighbors()) {
+      auto event = spark_->recvNeighborEvent(std::chrono::milliseconds(100));
+      if (event.hasValue() and
+          event->eventType == thrift::SparkNeighborEventType::NEIGHBOR_UP) {
+        ++numUp_;
+      }
+      drainDutPackets();
+    }
+  }
+
+  // Bring up adjacency with all the neighbors
+  void
+  establishNeighbors() {
+    sendHellos(false /* reflectDut */);
+    waitForIdle();
+    std::this_thread::sleep_for(kPacketRoundInterval);
+    sendHellos(true /* reflectDut */);
+    waitForIdle();
+    std::this_thread::sleep_for(kPacketRoundInterval);
+    sendHandshakes();
+    waitForNeighborsUp();
+  }
+
+  // Send heartbeat from every neighbor
+  void
+  sendHeartbeats() {
+    forEachNeighbor([this](size_t i, size_t j) { sendHeartbeat(i, j); });
+  }
+
+  // Wait for DUT to process all the packets sent to it
+  void
+  waitForIdle() {
+    while (true) {
+      drainDutPackets();
+      if (mockIoProvider_->getNumPendingMessages() == 0) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+    // packets are processed right after being read
+    spark_->getCpuTime();
+  }
+
+  std::chrono::nanoseconds
+  getDutCpuTime() {
+    return spark_->getCpuTime();
+  }
+
+ private:
+  static std::string
+  getIfName(size_t i) {
+    return folly::sformat("dut-{}", i);
+  }
+
+  static std::string
+  getNbrIfName(size_t i) {
+    return folly::sformat("nbr-{}", i);
+  }
+
+  static std::string
+  getNbrName(size_t i, size_t j) {
+    return folly::sformat("nbr-{}-{}", i, j);
+  }
+
+  static int
+  getIfIndex(size_t i) {
+    return i + 1;
+  }
+
+  int
+  getNbrIfIndex(size_t i) const {
+    return numIfaces_ + i + 1;
+  }
+
+  // unique address per neighbor for per-source rate limiting of DUT
+  static folly::IPAddressV6
+  getNbrAddr(size_t i, size_t j) {
+    return folly::IPAddressV6(folly::sformat("fe80::{:x}:{:x}", i + 1, j + 1));
+  }
+
+  template <typename Func>
+  void
+  forEachNeighbor(Func&& func) {
+    for (size_t i = 0; i < numIfaces_; ++i) {
+      for (size_t j = 0; j < neighborsPerIface_; ++j) {
+        func(i, j);
+      }
+    }
+  }
+
+  void
+  sendPacket(size_t i, size_t j, thrift::SparkHelloPacket const& pkt) {
+    auto packet = fbzmq::util::writeThriftObjStr(pkt, serializer_);
+    IoProvider::sendMessage(
+        nbrFd_,
+        getNbrIfIndex(i),
+        getNbrAddr(i, j),
+        folly::SocketAddress(
+            folly::IPAddress(Constants::kSparkMcastAddr.toString()),
+            Constants::kSparkMcastPort),
+        packet,
+        mockIoProvider_.get());
+  }
+
+  void
+  sendHello(size_t i, size_t j, bool reflectDut) {
+    thrift::SparkHelloMsg helloMsg;
+    helloMsg.domainName = kDomainName;
+    helloMsg.nodeName = getNbrName(i, j);
+    helloMsg.ifName = getNbrIfName(i);
+    helloMsg.seqNum = ++seqNum_;
+    helloMsg.version = Constants::kOpenrVersion;
+    helloMsg.sentTsInUs = getCurrentTimeInUs().count();
+    if (reflectDut) {
+      // seqNum of DUT seen by neighbor must be older than current one
+      auto& neighborInfo = helloMsg.neighborInfos[kNodeName];
+      neighborInfo.seqNum = 0;
+    }
+
+    thrift::SparkHelloPacket pkt;
+    pkt.helloMsg_ref() = std::move(helloMsg);
+    sendPacket(i, j, pkt);
+  }
+
+  void
+  sendHandshake(size_t i, size_t j) {
+    thrift::SparkHandshakeMsg handshakeMsg;
+    handshakeMsg.nodeName = getNbrName(i, j);
+    handshakeMsg.isAdjEstablished = true;
+    handshakeMsg.holdTime = kNeighborHoldTime.count();
+    handshakeMsg.gracefulRestartTime = kNeighborHoldTime.count();
+    handshakeMsg.transportAddressV6 = toBinaryAddress(getNbrAddr(i, j));
+    handshakeMsg.transportAddressV4 =
+        toBinaryAddress(folly::IPAddress("10.0.0.1"));
+    handshakeMsg.openrCtrlThriftPort = 2018;
+    handshakeMsg.kvStoreCmdPort = 10002;
+    handshakeMsg.area = thrift::KvStore_constants::kDefaultArea();
+    handshakeMsg.neighborNodeName_ref() = kNodeName;
+
+    thrift::SparkHelloPacket pkt;
+    pkt.handshakeMsg_ref() = std::move(handshakeMsg);
+    sendPacket(i, j, pkt);
+  }
+
+  void
+  sendHeartbeat(size_t i, size_t j) {
+    thrift::SparkHeartbeatMsg heartbeatMsg;
+    heartbeatMsg.nodeName = getNbrName(i, j);
+    heartbeatMsg.seqNum = ++seqNum_;
+
+    thrift::SparkHelloPacket pkt;
+    pkt.heartbeatMsg_ref() = std::move(heartbeatMsg);
+    sendPacket(i, j, pkt);
+  }
+
+  // Discard packets sent by DUT. Returns true if there was any
+  bool
+  drainDutPackets() {
+    bool drained{false};
+    while (not IoProvider::recvMessages(
+                   nbrFd_, recvBuffers_, mockIoProvider_.get())
+                   .empty()) {
+      drained = true;
+    }
+    return drained;
+  }
+
+  const size_t numIfaces_{0};
+  const size_t neighborsPerIface_{0};
+
+  // number of neighbors reported up by DUT
+  size_t numUp_{0};
+
+  std::shared_ptr<MockIoProvider> mockIoProvider_{
+      std::make_shared<MockIoProvider>()};
+  std::unique_ptr<std::thread> mockIoProviderThread_;
+
+  std::shared_ptr<Config> config_;
+  std::unique_ptr<SparkWrapper> spark_;
+
+  // socket of the simulated neighbors
+  int nbrFd_{-1};
+  IoProvider::RecvBuffers recvBuffers_{32, 1280};
+  apache::thrift::CompactSerializer serializer_;
+  int64_t seqNum_{0};
+};
+
+/**
+ * Benchmark for bringing up adjacencies
+ * 1. Start Spark with `numIfaces` interfaces
+ * 2. Bring up `neighborsPerIface` simulated neighbors on every interface
+ * 3. Report time to ESTABLISHED (excluding pacing between the rounds of
+ *    hellos/handshakes), CPU time of Spark thread per hello and handshake,
+ *    and memory per neighbor
+ */
+static void
+BM_SparkEstablish(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numIfaces,
+    size_t neighborsPerIface) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::chrono::nanoseconds totalTime{0};
+  std::chrono::nanoseconds helloCpuTime{0};
+  std::chrono::nanoseconds handshakeCpuTime{0};
+  int64_t memoryPerNeighbor{0};
+  size_t numNeighbors{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    SparkSimulation simulation(numIfaces, neighborsPerIface);
+    numNeighbors = simulation.getNumNeighbors();
+    const auto rssBefore = getRssBytes();
+
+    // Run the round of packets and record its wall and cpu time
+    auto runRound = [&](std::chrono::nanoseconds& cpuTime, auto&& round) {
+      const auto cpuTimeBefore = simulation.getDutCpuTime();
+      const auto startTime = std::chrono::steady_clock::now();
+      suspender.dismiss();
+      round();
+      suspender.rehire();
+      totalTime += std::chrono::steady_clock::now() - startTime;
+      cpuTime += simulation.getDutCpuTime() - cpuTimeBefore;
+    };
+
+    for (bool reflectDut : {false, true}) {
+      runRound(helloCpuTime, [&]() {
+        simulation.sendHellos(reflectDut);
+        simulation.waitForIdle();
+      });
+      std::this_thread::sleep_for(kPacketRoundInterval);
+    }
+    runRound(handshakeCpuTime, [&]() {
+      simulation.sendHandshakes();
+      simulation.waitForNeighborsUp();
+    });
+
+    memoryPerNeighbor += (static_cast<int64_t>(getRssBytes()) -
+                          static_cast<int64_t>(rssBefore)) /
+        static_cast<int64_t>(numNeighbors);
+  }
+
+  counters["time_to_established_ms"] =
+      std::chrono::duration_cast<std::chrono::milliseconds>(totalTime)
+          .count() /
+      iters;
+  counters["cpu_ns_per_hello"] =
+      helloCpuTime.count() / (2 * iters * numNeighbors);
+  counters["cpu_ns_per_handshake"] =
+      handshakeCpuTime.count() / (iters * numNeighbors);
+  counters["memory_per_nbr_bytes"] = memoryPerNeighbor / iters;
+}
+
+/**
+ * Benchmark for processing heartbeats of established neighbors
+ * 1. Bring up `numIfaces * neighborsPerIface` simulated neighbors
+ * 2. Send a heartbeat from every neighbor with every iteration
+ * 3. Report CPU time of Spark thread per heartbeat
+ */
+static void
+BM_SparkHeartbeat(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numIfaces,
+    size_t neighborsPerIface) {
+  auto suspender = folly::BenchmarkSuspender();
+  SparkSimulation simulation(numIfaces, neighborsPerIface);
+  simulation.establishNeighbors();
+  simulation.waitForIdle();
+
+  std::chrono::nanoseconds cpuTime{0};
+  for (uint32_t i = 0; i < iters; ++i) {
+    const auto roundStart = std::chrono::steady_clock::now();
+    const auto cpuTimeBefore = simulation.getDutCpuTime();
+
+    suspender.dismiss();
+    simulation.sendHeartbeats();
+    simulation.waitForIdle();
+    suspender.rehire();
+
+    cpuTime += simulation.getDutCpuTime() - cpuTimeBefore;
+    std::this_thread::sleep_until(roundStart + kPacketRoundInterval);
+  }
+
+  counters["cpu_ns_per_heartbeat"] =
+      cpuTime.count() / (iters * simulation.getNumNeighbors());
+}
+
+// 1k neighbors over 100 interfaces
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkEstablish, counters, 100_10, 100, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkHeartbeat, counters, 100_10, 100, 10);
+// 5k neighbors over 500 interfaces
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkEstablish, counters, 500_10, 500, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkHeartbeat, counters, 500_10, 500, 10);
+// 10k neighbors over 500 interfaces
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkEstablish, counters, 500_20, 500, 20);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkHeartbeat, counters, 500_20, 500, 20);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <netinet/in.h>
+#include <poll.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/spark/IoProvider.h>
+#include <openr/spark/SparkSocketFilter.h>
+
+namespace openr {
+
+namespace {
+
+const int kHopLimit{255};
+const size_t kMaxPayloadSize{1280};
+
+} // namespace
+
+//
+// Packets of unexpected hop limit or size sent over loopback are dropped by
+// the filter, and counted if eBPF is permitted
+//
+TEST(SparkSocketFilterTest, DropTest) {
+  IoProvider ioProvider;
+  const int rcvFd = ioProvider.socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  const int sndFd = ioProvider.socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  ASSERT_LE(0, rcvFd);
+  ASSERT_LE(0, sndFd);
+
+  auto filter = SparkSocketFilter::attach(
+      rcvFd, &ioProvider, kHopLimit, 1, kMaxPayloadSize);
+  ASSERT_NE(nullptr, filter);
+
+  sockaddr_in6 addr{};
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_loopback;
+  socklen_t addrLen = sizeof(addr);
+  ASSERT_EQ(0, bind(rcvFd, reinterpret_cast<sockaddr*>(&addr), addrLen));
+  ASSERT_EQ(
+      0, getsockname(rcvFd, reinterpret_cast<sockaddr*>(&addr), &addrLen));
+
+  auto send = [&](int hopLimit, size_t size) {
+    ASSERT_EQ(
+        0,
+        setsockopt(
+            sndFd,
+            IPPROTO_IPV6,
+            IPV6_UNICAST_HOPS,
+            &hopLimit,
+            sizeof(hopLimit)));
+    const std::string payload(size, 'x');
+    ASSERT_EQ(
+        size,
+        sendto(
+            sndFd,
+            payload.data(),
+            payload.size(),
+            0,
+            reinterpret_cast<sockaddr*>(&addr),
+            addrLen));
+  };
+  send(kHopLimit, 10);
+  send(64, 10);
+  send(kHopLimit, 0);
+  send(kHopLimit, kMaxPayloadSize + 1);
+  send(kHopLimit, kMaxPayloadSize);
+
+  // only packets of valid hop limit and size are received
+  std::vector<ssize_t> sizes;
+  std::vector<char> buf(2 * kMaxPayloadSize);
+  pollfd pfd{rcvFd, POLLIN, 0};
+  while (poll(&pfd, 1, 100) > 0) {
+    sizes.emplace_back(recv(rcvFd, buf.data(), buf.size(), MSG_DONTWAIT));
+  }
+  EXPECT_EQ(
+      std::vector<ssize_t>({10, static_cast<ssize_t>(kMaxPayloadSize)}),
+      sizes);
+
+  const auto counts = filter->getDropCounts();
+  if (filter->hasDropCounts()) {
+    EXPECT_EQ(1, counts.at(SparkSocketFilter::HOP_LIMIT));
+    EXPECT_EQ(1, counts.at(SparkSocketFilter::TOO_SHORT));
+    EXPECT_EQ(1, counts.at(SparkSocketFilter::TOO_LONG));
+  } else {
+    EXPECT_EQ(0, counts.at(SparkSocketFilter::HOP_LIMIT));
+  }
+
+  close(rcvFd);
+  close(sndFd);
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
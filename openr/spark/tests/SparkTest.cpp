@@ -10,6 +10,7 @@
 #include <mutex>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <folly/MapUtil.h>
 #include <folly/Memory.h>
 #include <folly/Optional.h>
@@ -32,6 +33,7 @@
 #include <openr/spark/tests/MockIoProvider.h>
 
 using namespace openr;
+using namespace std::chrono_literals;
 
 using apache::thrift::CompactSerializer;
 
@@ -381,6 +383,85 @@ TEST_F(SimpleSparkFixture, HeartbeatTimerExpireTest) {
   }
 }
 
+//
+// Start 2 Spark instances with fast liveness enabled and wait them forming
+// adj. Then remove connection between them, expect neighbor DOWN event well
+// before heartbeat hold time expires
+//
+TEST_F(SparkFixture, FastLivenessTest) {
+  mockIoProvider->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider->setConnectedPairs(connectedPairs);
+
+  thrift::SparkFastLivenessConfig livenessConfig;
+  livenessConfig.interval_ms = 20;
+  livenessConfig.detect_multiplier = 5;
+
+  auto tConfig1 = getBasicOpenrConfig("node-1", kDomainName);
+  tConfig1.spark_config.fast_liveness_config_ref() = livenessConfig;
+  auto config1 = std::make_shared<Config>(tConfig1);
+  auto tConfig2 = getBasicOpenrConfig("node-2", kDomainName);
+  tConfig2.spark_config.fast_liveness_config_ref() = livenessConfig;
+  auto config2 = std::make_shared<Config>(tConfig2);
+
+  auto node1 = createSpark(kDomainName, "node-1", 1, config1);
+  auto node2 = createSpark(kDomainName, "node-2", 2, config2);
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+  EXPECT_TRUE(node1->waitForEvent(NB_UP).has_value());
+  EXPECT_TRUE(node2->waitForEvent(NB_UP).has_value());
+
+  // neighbors stay up as long as fast liveness heartbeats are flowing
+  EXPECT_FALSE(node1->waitForEvent(NB_DOWN, 200ms, 500ms).has_value());
+
+  // remove underneath connections between to nodes
+  const auto startTime = std::chrono::steady_clock::now();
+  mockIoProvider->setConnectedPairs({});
+
+  EXPECT_TRUE(node1->waitForEvent(NB_DOWN).has_value());
+  EXPECT_TRUE(node2->waitForEvent(NB_DOWN).has_value());
+  EXPECT_GT(
+      std::chrono::seconds(node1->getSparkConfig().hold_time_s),
+      std::chrono::steady_clock::now() - startTime);
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_LE(2, counters.at("spark.fast_liveness.neighbor_down.sum"));
+}
+
+//
+// Start 2 Spark instances, only one with fast liveness enabled, and wait them
+// forming adj. Neighbor not sending fast liveness heartbeats must not be
+// declared down by it
+//
+TEST_F(SparkFixture, FastLivenessOneSidedTest) {
+  mockIoProvider->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider->setConnectedPairs(connectedPairs);
+
+  auto tConfig1 = getBasicOpenrConfig("node-1", kDomainName);
+  tConfig1.spark_config.fast_liveness_config_ref() =
+      thrift::SparkFastLivenessConfig{};
+  auto config1 = std::make_shared<Config>(tConfig1);
+  auto tConfig2 = getBasicOpenrConfig("node-2", kDomainName);
+  auto config2 = std::make_shared<Config>(tConfig2);
+
+  auto node1 = createSpark(kDomainName, "node-1", 1, config1);
+  auto node2 = createSpark(kDomainName, "node-2", 2, config2);
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+  EXPECT_TRUE(node1->waitForEvent(NB_UP).has_value());
+  EXPECT_TRUE(node2->waitForEvent(NB_UP).has_value());
+
+  EXPECT_FALSE(node1->waitForEvent(NB_DOWN, 200ms, 500ms).has_value());
+  EXPECT_FALSE(node2->waitForEvent(NB_DOWN, 200ms, 500ms).has_value());
+}
+
 //
 // Start 2 Spark instances and wait them forming adj. Then
 // remove/add interface from one instance's perspective
@@ -558,6 +639,63 @@ TEST_F(SparkFixture, VersionTest) {
   }
 }
 
+//
+// Start 2 Spark instances, one of them with version predating compact
+// heartbeat encoding. Make sure they form adjacency and keep it beyond the
+// heartbeat hold time, i.e. thrift encoded heartbeats are used between them.
+//
+TEST_F(SparkFixture, CompactHeartbeatVersionTest) {
+  // Define interface names for the test
+  mockIoProvider->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+
+  // connect interfaces directly
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider->setConnectedPairs(connectedPairs);
+
+  const std::string nodeName1 = "node-1";
+  const std::string nodeName2 = "node-2";
+
+  auto tConfig1 = getBasicOpenrConfig(nodeName1, kDomainName);
+  auto config1 = std::make_shared<Config>(tConfig1);
+
+  auto tConfig2 = getBasicOpenrConfig(nodeName2, kDomainName);
+  auto config2 = std::make_shared<Config>(tConfig2);
+
+  auto node1 = createSpark(kDomainName, nodeName1, 1, config1);
+  auto node2 = createSpark(
+      kDomainName,
+      nodeName2,
+      2,
+      config2,
+      std::make_pair(
+          Constants::kSparkCompactHeartbeatVersion - 1,
+          Constants::kOpenrSupportedVersion));
+
+  // start tracking interfaces
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+
+  {
+    EXPECT_TRUE(node1->waitForEvent(NB_UP).has_value());
+    EXPECT_TRUE(node2->waitForEvent(NB_UP).has_value());
+  }
+
+  // adjacency is kept alive by heartbeats
+  {
+    const auto holdTime =
+        std::chrono::seconds(config1->getSparkConfig().hold_time_s);
+    EXPECT_FALSE(
+        node1->waitForEvent(NB_DOWN, holdTime * 2, holdTime * 2).has_value());
+    EXPECT_FALSE(
+        node2->waitForEvent(NB_DOWN, holdTime * 2, holdTime * 2).has_value());
+    EXPECT_TRUE(node1->getSparkNeighState(iface1, nodeName2) == ESTABLISHED);
+    EXPECT_TRUE(node2->getSparkNeighState(iface2, nodeName1) == ESTABLISHED);
+  }
+}
+
 //
 // Start 2 Spark instances within different domains. Then
 // make sure they can't form adj as helloMsg being ignored.
@@ -766,6 +904,10 @@ TEST_F(SparkFixture, FastInitTest) {
         std::chrono::steady_clock::now() - startTime);
     EXPECT_GE(
         5 * config1->getSparkConfig().fastinit_hello_time_ms, duration.count());
+
+    // solicited hellos of fast-init neighbor are answered right away
+    auto counters = fb303::fbData->getCounters();
+    EXPECT_LT(0, counters.at("spark.hello.solicited_replies_sent.sum"));
   }
 
   // kill and restart node-2
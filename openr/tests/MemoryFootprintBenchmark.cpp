@@ -0,0 +1,356 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/decision/Decision.h>
+#include <openr/decision/LinkState.h>
+#include <openr/decision/PrefixState.h>
+#include <openr/if/gen-cpp2/KvStore_constants.h>
+#include <openr/kvstore/KvStore.h>
+#include <openr/kvstore/KvStoreHashTree.h>
+#include <openr/kvstore/KvStoreKeyIndex.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes parameters to another one, with a custom name for
+ * the parameters.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace {
+
+// Size of values of KvStore keys, about the one of a per prefix key
+const size_t kKvStoreValueSize{128};
+// Key-values are merged into KvStore in batches of this size, as by floods
+const size_t kKvStoreBatchSize{1000};
+// Number of neighbors advertising prefixes of Decision route database
+const size_t kNumOfRouteNodes{2};
+
+// Bytes of live heap allocations made through operator new, as accounted by
+// the allocator, i.e. including rounding up to its size classes
+std::atomic<int64_t> allocatedBytes{0};
+
+} // anonymous namespace
+
+// Account allocated bytes, reported by all the benchmarks
+void*
+operator new(size_t size) {
+  if (auto ptr = std::malloc(size)) {
+    allocatedBytes.fetch_add(
+        malloc_usable_size(ptr), std::memory_order_relaxed);
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept {
+  if (ptr) {
+    allocatedBytes.fetch_sub(
+        malloc_usable_size(ptr), std::memory_order_relaxed);
+    std::free(ptr);
+  }
+}
+
+void
+operator delete(void* ptr, size_t /* size */) noexcept {
+  operator delete(ptr);
+}
+
+namespace openr {
+
+namespace {
+
+std::string
+getNodeName(size_t index) {
+  return folly::sformat("node-{}", index);
+}
+
+thrift::IpPrefix
+getPrefix(size_t index) {
+  return toIpPrefix(folly::sformat(
+      "fc00:{:x}:{:x}::/64", (index >> 16) & 0xffff, index & 0xffff));
+}
+
+// Nodes are connected to `degree` following nodes in a ring, hence every
+// node has adjacencies to 2 * degree nodes
+thrift::AdjacencyDatabase
+createAdjacencyDb(size_t node, size_t numOfNodes, size_t degree) {
+  std::vector<thrift::Adjacency> adjs;
+  adjs.reserve(2 * degree);
+  for (size_t i = 1; i <= degree; ++i) {
+    for (const auto other :
+         {(node + i) % numOfNodes, (node + numOfNodes - i) % numOfNodes}) {
+      adjs.emplace_back(createAdjacency(
+          getNodeName(other),
+          folly::sformat("if_{}_{}", node, other),
+          folly::sformat("if_{}_{}", other, node),
+          "fe80::1",
+          "10.0.0.1",
+          10 /* metric */,
+          0 /* adjLabel */));
+    }
+  }
+  return createAdjDb(getNodeName(node), adjs, node + 1);
+}
+
+// Routes of node-0 to numOfPrefixes prefixes, all advertised by each of
+// its neighbors, hence ECMP routes
+std::optional<DecisionRouteDb>
+createRouteDb(size_t numOfPrefixes) {
+  LinkState linkState(thrift::KvStore_constants::kDefaultArea());
+  const size_t numOfNodes = kNumOfRouteNodes + 1;
+  for (size_t node = 0; node < numOfNodes; ++node) {
+    linkState.updateAdjacencyDatabase(
+        createAdjacencyDb(node, numOfNodes, 1 /* degree */));
+  }
+
+  PrefixState prefixState;
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  prefixEntries.reserve(numOfPrefixes);
+  for (size_t i = 0; i < numOfPrefixes; ++i) {
+    prefixEntries.emplace_back(createPrefixEntry(getPrefix(i)));
+  }
+  for (size_t node = 1; node < numOfNodes; ++node) {
+    prefixState.updatePrefixDatabase(
+        createPrefixDb(getNodeName(node), prefixEntries));
+  }
+
+  SpfSolver spfSolver(getNodeName(0), false /* enableV4 */, false /* lfa */);
+  return spfSolver.buildRouteDb(getNodeName(0), linkState, prefixState);
+}
+
+} // namespace
+
+/**
+ * Memory footprint benchmarks of major structures at controlled sizes, for
+ * sizing memory limits and tracking of memory reductions. Structures are built
+ * the way modules build them, and bytes held by them are reported per unit of
+ * their size, as accounted by the allocator. Benchmark time is the time to
+ * build the structure.
+ */
+
+/**
+ * KvStore key-values, merged in batches like floods do, along with the hash
+ * tree and key index maintained by KvStore
+ */
+void
+BM_KvStoreFootprint(
+    folly::UserCounters& counters, uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string value(kKvStoreValueSize, 'x');
+  int64_t bytes{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    const auto bytesBefore = allocatedBytes.load();
+    {
+      std::unordered_map<std::string, thrift::Value> kvStore;
+      KvStoreHashTree hashTree;
+      KvStoreKeyIndex keyIndex;
+      for (size_t key = 0; key < numOfKeys;) {
+        std::unordered_map<std::string, thrift::Value> keyVals;
+        for (; key < numOfKeys and keyVals.size() < kKvStoreBatchSize; ++key) {
+          const auto originatorId = getNodeName(key % 1000);
+          keyVals.emplace(
+              PrefixKey(originatorId, toIPNetwork(getPrefix(key)))
+                  .getPrefixKey(),
+              createThriftValue(
+                  1 /* version */,
+                  originatorId,
+                  value,
+                  Constants::kTtlInfinity,
+                  0 /* ttlVersion */,
+                  generateHash(1, originatorId, value)));
+        }
+        KvStore::mergeKeyValues(
+            kvStore, keyVals, std::nullopt, &hashTree, &keyIndex);
+      }
+      bytes += allocatedBytes.load() - bytesBefore;
+      suspender.rehire();
+    }
+  }
+
+  counters["bytes_per_key"] = bytes / (iters * numOfKeys);
+}
+
+/**
+ * LinkState of numOfNodes nodes, with numOfLinks links spread evenly over
+ * them. Adjacency databases are moved into LinkState, as Decision does
+ */
+void
+BM_LinkStateFootprint(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfNodes,
+    size_t numOfLinks) {
+  auto suspender = folly::BenchmarkSuspender();
+  const size_t degree = numOfLinks / numOfNodes;
+  int64_t bytes{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    const auto bytesBefore = allocatedBytes.load();
+    {
+      LinkState linkState(thrift::KvStore_constants::kDefaultArea());
+      for (size_t node = 0; node < numOfNodes; ++node) {
+        linkState.updateAdjacencyDatabase(
+            createAdjacencyDb(node, numOfNodes, degree));
+      }
+      bytes += allocatedBytes.load() - bytesBefore;
+      suspender.rehire();
+    }
+  }
+
+  counters["bytes_per_link"] = bytes / (iters * numOfNodes * degree);
+}
+
+/**
+ * PrefixState of numOfNodes nodes, each advertising prefixesPerNode prefixes
+ */
+void
+BM_PrefixStateFootprint(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfNodes,
+    size_t prefixesPerNode) {
+  auto suspender = folly::BenchmarkSuspender();
+  int64_t bytes{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    const auto bytesBefore = allocatedBytes.load();
+    {
+      PrefixState prefixState;
+      for (size_t node = 0; node < numOfNodes; ++node) {
+        std::vector<thrift::PrefixEntry> prefixEntries;
+        prefixEntries.reserve(prefixesPerNode);
+        for (size_t j = 0; j < prefixesPerNode; ++j) {
+          prefixEntries.emplace_back(
+              createPrefixEntry(getPrefix(node * prefixesPerNode + j)));
+        }
+        prefixState.updatePrefixDatabase(
+            createPrefixDb(getNodeName(node), prefixEntries));
+      }
+      bytes += allocatedBytes.load() - bytesBefore;
+      suspender.rehire();
+    }
+  }
+
+  counters["bytes_per_prefix"] =
+      bytes / (iters * numOfNodes * prefixesPerNode);
+}
+
+/**
+ * Route database built by Decision, of ECMP routes of numOfPrefixes prefixes
+ */
+void
+BM_DecisionRouteDbFootprint(
+    folly::UserCounters& counters, uint32_t iters, size_t numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  int64_t bytes{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    // LinkState, PrefixState and SpfSolver are released along with their
+    // caches, only route database is left allocated
+    const auto bytesBefore = allocatedBytes.load();
+    auto routeDb = createRouteDb(numOfPrefixes);
+    bytes += allocatedBytes.load() - bytesBefore;
+    suspender.rehire();
+    CHECK(routeDb.has_value());
+    CHECK_EQ(numOfPrefixes, routeDb->unicastEntries.size());
+  }
+
+  counters["bytes_per_route"] = bytes / (iters * numOfPrefixes);
+}
+
+/**
+ * Unicast routes of Fib route state, converted from route database of
+ * Decision as received by Fib. Fib keeps the state in its event loop, hence
+ * its major part, the routes keyed by prefix, is built here
+ */
+void
+BM_FibRouteStateFootprint(
+    folly::UserCounters& counters, uint32_t iters, size_t numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto routeDb = createRouteDb(numOfPrefixes);
+  CHECK(routeDb.has_value());
+  int64_t bytes{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss();
+    const auto bytesBefore = allocatedBytes.load();
+    {
+      std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastRoutes;
+      for (auto const& [prefix, entry] : routeDb->unicastEntries) {
+        unicastRoutes.emplace(prefix, entry.toTUnicastRoute());
+      }
+      bytes += allocatedBytes.load() - bytesBefore;
+      suspender.rehire();
+    }
+  }
+
+  counters["bytes_per_route"] = bytes / (iters * numOfPrefixes);
+}
+
+// The parameter is the number of keys
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreFootprint, counters, 100000, 100000);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreFootprint, counters, 1000000, 1000000);
+
+// The parameters are the number of nodes and links
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateFootprint, counters, 1000_10000, 1000, 10000);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateFootprint, counters, 10000_100000, 10000, 100000);
+
+// The parameters are the number of nodes and prefixes per node
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateFootprint, counters, 100_1000, 100, 1000);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateFootprint, counters, 1000_1000, 1000, 1000);
+
+// The parameter is the number of routes
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionRouteDbFootprint, counters, 100000, 100000);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionRouteDbFootprint, counters, 1000000, 1000000);
+
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_FibRouteStateFootprint, counters, 100000, 100000);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_FibRouteStateFootprint, counters, 1000000, 1000000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
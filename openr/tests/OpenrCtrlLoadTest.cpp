@@ -0,0 +1,671 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Load test of OpenrCtrl server. Runs an in-process Open/R (KvStore,
+ * Decision, Fib, PrefixManager, LinkMonitor and config store) behind
+ * OpenrThriftServerWrapper, and drives it for `duration_s` with a mix of
+ *
+ *  1). `num_pollers` clients calling every API of `poll_apis` in turn, every
+ *      `poll_interval_ms`, like monitoring does;
+ *  2). `num_stream_subscribers` KvStore stream subscribers;
+ *  3). `num_long_pollers` clients long-polling for adjacency changes,
+ *
+ * while KvStore holds `num_keys` keys, updated at `key_updates_per_s`, and an
+ * adjacency key is updated every `adj_update_interval_ms`.
+ *
+ * Reports percentiles of latency of every API called, of delivery of key
+ * updates to stream subscribers and of wake-up of long-polls on adjacency
+ * change. Impact on modules is reported as percentiles of their event-loop
+ * lag, i.e. time for a probe scheduled into their event loop to run.
+ */
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fbzmq/service/monitor/ZmqMonitor.h>
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/async/HeaderClientChannel.h>
+#include <thrift/lib/cpp2/async/RocketClientChannel.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <thrift/lib/cpp2/server/ThriftServer.h>
+#include <thrift/lib/cpp2/util/ScopedServerThread.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/LatencyHistogram.h>
+#include <openr/common/OpenrClient.h>
+#include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/decision/Decision.h>
+#include <openr/fib/Fib.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/link-monitor/LinkMonitor.h>
+#include <openr/link-monitor/tests/MockNetlinkSystemHandler.h>
+#include <openr/messaging/ReplicateQueue.h>
+#include <openr/prefix-manager/PrefixManager.h>
+#include <openr/tests/OpenrThriftServerWrapper.h>
+
+DEFINE_int32(duration_s, 30, "Duration of the load");
+DEFINE_int32(num_pollers, 8, "Number of clients polling ctrl APIs");
+DEFINE_int32(poll_interval_ms, 100, "Interval between calls of a poller");
+DEFINE_string(
+    poll_apis,
+    "getCounters,getKvStoreKeyValsFiltered,getRouteDb,"
+    "getDecisionAdjacencyDbs,getInterfaces",
+    "Comma separated APIs called by pollers in turn. Supported: getCounters, "
+    "getKvStoreKeyValsFiltered, getRouteDb, getRouteDbComputed, "
+    "getDecisionAdjacencyDbs, getInterfaces, getKvStorePeers, getPrefixes");
+DEFINE_int32(num_stream_subscribers, 16, "Number of KvStore subscribers");
+DEFINE_int32(num_long_pollers, 4, "Number of clients long-polling adj");
+DEFINE_int32(num_keys, 10000, "Number of keys loaded into KvStore");
+DEFINE_int32(value_size, 100, "Size of values of loaded keys");
+DEFINE_int32(key_updates_per_s, 100, "Rate of updates of loaded keys");
+DEFINE_int32(adj_update_interval_ms, 1000, "Interval of adjacency updates");
+DEFINE_int32(lag_probe_interval_ms, 10, "Interval of event-loop lag probes");
+
+namespace openr {
+
+namespace {
+
+const std::string kNodeName{"node-1"};
+const std::string kConfigStorePath{"/tmp/openr_ctrl_load_test.bin"};
+// Prefix of loaded keys, and originator of loaded and adjacency keys
+const std::string kLoadKeyPrefix{"load:"};
+const std::string kLoadNodeName{"load-node"};
+// Latencies are recorded in microseconds, up to a minute
+const int64_t kMaxLatencyUs{60 * 1000 * 1000};
+// Long-polls are held by server till adjacency change
+const std::chrono::seconds kLongPollTimeout{60};
+
+int64_t
+getSteadyTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Latency histograms and error counts, by name of measured API or event.
+ * Thread safe
+ */
+class LatencyRecorder {
+ public:
+  void
+  addLatency(std::string const& name, int64_t latencyUs) {
+    auto stats = stats_.wlock();
+    stats->try_emplace(name, kMaxLatencyUs).first->second.histogram.addValue(
+        latencyUs);
+  }
+
+  void
+  addError(std::string const& name) {
+    auto stats = stats_.wlock();
+    ++stats->try_emplace(name, kMaxLatencyUs).first->second.errors;
+  }
+
+  void
+  report() const {
+    auto stats = stats_.rlock();
+    LOG(INFO) << folly::sformat(
+        "{:<40} {:>9} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9}",
+        "name",
+        "count",
+        "errors",
+        "p50(us)",
+        "p90(us)",
+        "p99(us)",
+        "p99.9(us)",
+        "max(us)");
+    for (auto const& [name, stat] : *stats) {
+      auto const& histogram = stat.histogram;
+      LOG(INFO) << folly::sformat(
+          "{:<40} {:>9} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9}",
+          name,
+          histogram.getCount(),
+          stat.errors,
+          histogram.getPercentile(50),
+          histogram.getPercentile(90),
+          histogram.getPercentile(99),
+          histogram.getPercentile(99.9),
+          histogram.getMax());
+    }
+  }
+
+ private:
+  struct Stats {
+    explicit Stats(int64_t maxValue) : histogram(maxValue) {}
+
+    LatencyHistogram histogram;
+    uint64_t errors{0};
+  };
+
+  folly::Synchronized<std::map<std::string, Stats>> stats_;
+};
+
+using CtrlClient = thrift::OpenrCtrlCppAsyncClient;
+
+// Ctrl API called by pollers, by name
+std::map<std::string, std::function<void(CtrlClient&)>>
+getPollApis() {
+  return {
+      {"getCounters",
+       [](CtrlClient& client) {
+         std::map<std::string, int64_t> counters;
+         client.sync_getCounters(counters);
+       }},
+      {"getKvStoreKeyValsFiltered",
+       [](CtrlClient& client) {
+         thrift::KeyDumpParams params;
+         params.prefix = kLoadKeyPrefix;
+         thrift::Publication publication;
+         client.sync_getKvStoreKeyValsFiltered(publication, params);
+       }},
+      {"getRouteDb",
+       [](CtrlClient& client) {
+         thrift::RouteDatabase routeDb;
+         client.sync_getRouteDb(routeDb);
+       }},
+      {"getRouteDbComputed",
+       [](CtrlClient& client) {
+         thrift::RouteDatabase routeDb;
+         client.sync_getRouteDbComputed(routeDb, kNodeName);
+       }},
+      {"getDecisionAdjacencyDbs",
+       [](CtrlClient& client) {
+         thrift::AdjDbs adjDbs;
+         client.sync_getDecisionAdjacencyDbs(adjDbs);
+       }},
+      {"getInterfaces",
+       [](CtrlClient& client) {
+         thrift::DumpLinksReply reply;
+         client.sync_getInterfaces(reply);
+       }},
+      {"getKvStorePeers",
+       [](CtrlClient& client) {
+         thrift::PeersMap peers;
+         client.sync_getKvStorePeers(peers);
+       }},
+      {"getPrefixes",
+       [](CtrlClient& client) {
+         std::vector<thrift::PrefixEntry> prefixes;
+         client.sync_getPrefixes(prefixes);
+       }},
+  };
+}
+
+// Values of loaded keys carry the time they were set at
+std::string
+createLoadValue() {
+  return folly::sformat(
+      "{}:{}", getSteadyTimeUs(), std::string(FLAGS_value_size, 'x'));
+}
+
+std::optional<int64_t>
+getLoadValueTime(std::string const& value) {
+  folly::StringPiece piece(value);
+  auto result = folly::tryTo<int64_t>(piece.split_step(':'));
+  return result.hasValue() ? std::make_optional(result.value())
+                           : std::nullopt;
+}
+
+/**
+ * In-process Open/R, set up as in OpenrCtrlHandler tests, serving OpenrCtrl
+ * on a local port
+ */
+class OpenrCtrlLoadTest {
+ public:
+  OpenrCtrlLoadTest() {
+    auto tConfig = getBasicOpenrConfig(kNodeName);
+    tConfig.link_monitor_config.use_rtt_metric = false;
+    tConfig.link_monitor_config.include_interface_regexes = {"po.*"};
+    config_ = std::make_shared<Config>(tConfig);
+
+    zmqMonitor_ = std::make_unique<fbzmq::ZmqMonitor>(
+        monitorSubmitUrl_, "inproc://load-test-monitor-pub-url", context_);
+    zmqMonitorThread_ = std::thread([this]() { zmqMonitor_->run(); });
+
+    persistentStore_ = std::make_unique<PersistentStore>(
+        kNodeName, kConfigStorePath, context_, true /* dryrun */);
+    persistentStoreThread_ = std::thread([this]() { persistentStore_->run(); });
+
+    kvStoreWrapper_ = std::make_unique<KvStoreWrapper>(context_, config_);
+    kvStoreWrapper_->run();
+
+    decision_ = std::make_unique<Decision>(
+        config_,
+        true /* computeLfaPaths */,
+        false /* bgpDryRun */,
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(500),
+        kvStoreWrapper_->getReader(),
+        staticRoutesUpdatesQueue_.getReader(),
+        routeUpdatesQueue_,
+        decisionDbsUpdatesQueue_,
+        context_);
+    decisionThread_ = std::thread([this]() { decision_->run(); });
+
+    fib_ = std::make_unique<Fib>(
+        config_,
+        -1 /* thrift port */,
+        std::chrono::seconds(2),
+        routeUpdatesQueue_.getReader(),
+        interfaceUpdatesQueue_.getReader(),
+        fibUpdatesQueue_,
+        monitorSubmitUrl_,
+        kvStoreWrapper_->getKvStore(),
+        context_);
+    fibThread_ = std::thread([this]() { fib_->run(); });
+
+    prefixManager_ = std::make_unique<PrefixManager>(
+        prefixUpdatesQueue_.getReader(),
+        config_,
+        persistentStore_.get(),
+        kvStoreWrapper_->getKvStore(),
+        false /* enablePerfMeasurement */,
+        std::chrono::seconds(0));
+    prefixManagerThread_ = std::thread([this]() { prefixManager_->run(); });
+
+    mockNlHandler_ =
+        std::make_shared<MockNetlinkSystemHandler>(context_, platformPubUrl_);
+    systemServer_ = std::make_shared<apache::thrift::ThriftServer>();
+    systemServer_->setNumIOWorkerThreads(1);
+    systemServer_->setNumAcceptThreads(1);
+    systemServer_->setPort(0);
+    systemServer_->setInterface(mockNlHandler_);
+    systemThriftThread_.start(systemServer_);
+
+    linkMonitor_ = std::make_unique<LinkMonitor>(
+        context_,
+        config_,
+        systemThriftThread_.getAddress()->getPort(),
+        kvStoreWrapper_->getKvStore(),
+        std::vector<thrift::IpPrefix>{},
+        false /* enable perf measurement */,
+        interfaceUpdatesQueue_,
+        peerUpdatesQueue_,
+        neighborUpdatesQueue_.getReader(),
+        monitorSubmitUrl_,
+        persistentStore_.get(),
+        false /* assumeDrained */,
+        prefixUpdatesQueue_,
+        platformPubUrl_,
+        std::chrono::seconds(1));
+    linkMonitorThread_ = std::thread([this]() { linkMonitor_->run(); });
+
+    openrThriftServerWrapper_ = std::make_unique<OpenrThriftServerWrapper>(
+        kNodeName,
+        decision_.get(),
+        fib_.get(),
+        kvStoreWrapper_->getKvStore(),
+        linkMonitor_.get(),
+        persistentStore_.get(),
+        prefixManager_.get(),
+        config_,
+        monitorSubmitUrl_,
+        context_);
+    openrThriftServerWrapper_->run();
+  }
+
+  ~OpenrCtrlLoadTest() {
+    routeUpdatesQueue_.close();
+    staticRoutesUpdatesQueue_.close();
+    interfaceUpdatesQueue_.close();
+    fibUpdatesQueue_.close();
+    decisionDbsUpdatesQueue_.close();
+    peerUpdatesQueue_.close();
+    neighborUpdatesQueue_.close();
+    prefixUpdatesQueue_.close();
+    kvStoreWrapper_->closeQueue();
+
+    openrThriftServerWrapper_->stop();
+
+    linkMonitor_->stop();
+    linkMonitorThread_.join();
+
+    persistentStore_->stop();
+    persistentStoreThread_.join();
+
+    prefixManager_->stop();
+    prefixManagerThread_.join();
+
+    mockNlHandler_->stop();
+    systemThriftThread_.stop();
+
+    fib_->stop();
+    fibThread_.join();
+
+    decision_->stop();
+    decisionThread_.join();
+
+    kvStoreWrapper_->stop();
+
+    zmqMonitor_->stop();
+    zmqMonitorThread_.join();
+  }
+
+  void
+  run() {
+    loadKeys();
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([this]() { probeEventLoops(); });
+    threads.emplace_back([this]() { updateKeys(); });
+    for (int i = 0; i < FLAGS_num_pollers; ++i) {
+      threads.emplace_back([this]() { poll(); });
+    }
+    for (int i = 0; i < FLAGS_num_long_pollers; ++i) {
+      threads.emplace_back([this]() { longPoll(); });
+    }
+    subscribe();
+
+    LOG(INFO) << "Running load for " << FLAGS_duration_s << "s";
+    std::this_thread::sleep_for(std::chrono::seconds(FLAGS_duration_s));
+    stopped_ = true;
+
+    for (auto& cancel : cancelSubscriptions_) {
+      cancel();
+    }
+    // wake up long-polls, waiting for adjacency change
+    updateAdjacency();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    streamClients_.clear();
+
+    recorder_.report();
+  }
+
+ private:
+  std::unique_ptr<CtrlClient>
+  createClient(
+      folly::EventBase& evb,
+      std::chrono::milliseconds processingTimeout =
+          Constants::kServiceProcTimeout) {
+    return getOpenrCtrlPlainTextClient<apache::thrift::HeaderClientChannel>(
+        evb,
+        folly::IPAddress("::1"),
+        openrThriftServerWrapper_->getOpenrCtrlThriftPort(),
+        Constants::kServiceConnTimeout,
+        processingTimeout);
+  }
+
+  void
+  loadKeys() {
+    LOG(INFO) << "Loading " << FLAGS_num_keys << " keys into KvStore";
+    std::vector<std::pair<std::string, thrift::Value>> keyVals;
+    for (int i = 0; i < FLAGS_num_keys; ++i) {
+      keyVals.emplace_back(
+          folly::sformat("{}{}", kLoadKeyPrefix, i),
+          createThriftValue(1, kLoadNodeName, createLoadValue()));
+    }
+    CHECK(kvStoreWrapper_->setKeys(keyVals));
+    updateAdjacency();
+  }
+
+  // Update adjacency key, which wakes up long-polls
+  void
+  updateAdjacency() {
+    apache::thrift::CompactSerializer serializer;
+    auto adjDb = createAdjDb(kLoadNodeName, {}, 1 /* nodeLabel */);
+    const auto version = ++adjVersion_;
+    adjUpdateTimeUs_ = getSteadyTimeUs();
+    kvStoreWrapper_->setKey(
+        folly::sformat("{}{}", Constants::kAdjDbMarker, kLoadNodeName),
+        createThriftValue(
+            version,
+            kLoadNodeName,
+            fbzmq::util::writeThriftObjStr(adjDb, serializer)));
+  }
+
+  void
+  updateKeys() {
+    const auto keyInterval =
+        std::chrono::microseconds(1000000 / FLAGS_key_updates_per_s);
+    const auto adjInterval =
+        std::chrono::milliseconds(FLAGS_adj_update_interval_ms);
+    auto nextKeyUpdate = std::chrono::steady_clock::now();
+    auto nextAdjUpdate = nextKeyUpdate + adjInterval;
+    int64_t version{1};
+    for (size_t i = 0; not stopped_; ++i) {
+      if (i % FLAGS_num_keys == 0) {
+        ++version;
+      }
+      kvStoreWrapper_->setKey(
+          folly::sformat("{}{}", kLoadKeyPrefix, i % FLAGS_num_keys),
+          createThriftValue(version, kLoadNodeName, createLoadValue()));
+      if (std::chrono::steady_clock::now() >= nextAdjUpdate) {
+        updateAdjacency();
+        nextAdjUpdate += adjInterval;
+      }
+      nextKeyUpdate += keyInterval;
+      std::this_thread::sleep_until(nextKeyUpdate);
+    }
+  }
+
+  void
+  poll() {
+    const auto allApis = getPollApis();
+    std::vector<std::pair<std::string, std::function<void(CtrlClient&)>>>
+        apis;
+    std::vector<std::string> apiNames;
+    folly::split(',', FLAGS_poll_apis, apiNames, true /* ignoreEmpty */);
+    for (auto const& name : apiNames) {
+      auto it = allApis.find(name);
+      CHECK(it != allApis.end()) << "Unsupported API: " << name;
+      apis.emplace_back(*it);
+    }
+
+    folly::EventBase evb;
+    auto client = createClient(evb);
+    for (size_t i = 0; not stopped_ and not apis.empty(); ++i) {
+      auto const& [name, api] = apis.at(i % apis.size());
+      const auto startUs = getSteadyTimeUs();
+      try {
+        api(*client);
+        recorder_.addLatency(name, getSteadyTimeUs() - startUs);
+      } catch (std::exception const& e) {
+        LOG(ERROR) << name << " failed: " << folly::exceptionStr(e);
+        recorder_.addError(name);
+        client = createClient(evb);
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_poll_interval_ms));
+    }
+  }
+
+  void
+  longPoll() {
+    const std::string name{"longPollKvStoreAdjChange"};
+    folly::EventBase evb;
+    auto client = createClient(evb, kLongPollTimeout);
+    int64_t seqNum = client->sync_longPollKvStoreAdjChange(-1);
+    while (not stopped_) {
+      try {
+        const auto newSeqNum = client->sync_longPollKvStoreAdjChange(seqNum);
+        if (newSeqNum != seqNum) {
+          recorder_.addLatency(
+              name + ".wakeup", getSteadyTimeUs() - adjUpdateTimeUs_);
+        }
+        seqNum = newSeqNum;
+      } catch (std::exception const& e) {
+        LOG(ERROR) << name << " failed: " << folly::exceptionStr(e);
+        recorder_.addError(name);
+        client = createClient(evb, kLongPollTimeout);
+      }
+    }
+  }
+
+  // Subscribe to KvStore stream, every subscriber with own client thread.
+  // Delivery latency is measured for updates of loaded keys
+  void
+  subscribe() {
+    const std::string name{"subscribeAndGetKvStore"};
+    for (int i = 0; i < FLAGS_num_stream_subscribers; ++i) {
+      auto evbThread = std::make_unique<folly::ScopedEventBaseThread>();
+      auto client =
+          getOpenrCtrlPlainTextClient<apache::thrift::RocketClientChannel>(
+              *evbThread->getEventBase(),
+              folly::IPAddress("::1"),
+              openrThriftServerWrapper_->getOpenrCtrlThriftPort());
+
+      const auto startUs = getSteadyTimeUs();
+      auto response = client->semifuture_subscribeAndGetKvStore().get();
+      recorder_.addLatency(name, getSteadyTimeUs() - startUs);
+
+      auto subscription =
+          std::move(response.stream)
+              .subscribeExTry(
+                  folly::Executor::getKeepAliveToken(
+                      evbThread->getEventBase()),
+                  [this, name](folly::Try<thrift::Publication>&& pub) {
+                    if (pub.hasException()) {
+                      return;
+                    }
+                    const auto nowUs = getSteadyTimeUs();
+                    for (auto const& [key, value] : pub->keyVals) {
+                      if (key.find(kLoadKeyPrefix) != 0 or
+                          not value.value_ref().has_value()) {
+                        continue;
+                      }
+                      auto setAtUs = getLoadValueTime(*value.value_ref());
+                      if (setAtUs.has_value()) {
+                        recorder_.addLatency(
+                            name + ".delivery", nowUs - *setAtUs);
+                      }
+                    }
+                  });
+      cancelSubscriptions_.emplace_back(
+          [subscription = std::make_shared<decltype(subscription)>(
+               std::move(subscription))]() {
+            subscription->cancel();
+            std::move(*subscription).detach();
+          });
+      streamClients_.emplace_back(std::move(client), std::move(evbThread));
+    }
+  }
+
+  // Probe event loop of every module, with one probe in flight per module
+  void
+  probeEventLoops() {
+    struct Probe {
+      std::string name;
+      OpenrEventBase* evb{nullptr};
+      std::atomic<bool> pending{false};
+      std::atomic<int64_t> sentAtUs{0};
+    };
+    std::vector<std::shared_ptr<Probe>> probes;
+    for (auto const& [name, evb] :
+         std::vector<std::pair<std::string, OpenrEventBase*>>{
+             {"kvstore", kvStoreWrapper_->getKvStore()},
+             {"decision", decision_.get()},
+             {"fib", fib_.get()},
+             {"prefix_manager", prefixManager_.get()},
+             {"link_monitor", linkMonitor_.get()},
+             {"config_store", persistentStore_.get()}}) {
+      auto probe = std::make_shared<Probe>();
+      probe->name = folly::sformat("evb_lag.{}", name);
+      probe->evb = evb;
+      probes.emplace_back(std::move(probe));
+    }
+
+    while (not stopped_) {
+      for (auto& probe : probes) {
+        if (probe->pending.exchange(true)) {
+          continue;
+        }
+        probe->sentAtUs = getSteadyTimeUs();
+        probe->evb->runInEventBaseThread([this, probe]() noexcept {
+          recorder_.addLatency(
+              probe->name, getSteadyTimeUs() - probe->sentAtUs);
+          probe->pending = false;
+        });
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_lag_probe_interval_ms));
+    }
+    // wait for in-flight probes, referring to the recorder
+    for (auto& probe : probes) {
+      while (probe->pending) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  const MonitorSubmitUrl monitorSubmitUrl_{"inproc://load-test-monitor-url"};
+  const PlatformPublisherUrl platformPubUrl_{"inproc://load-test-pub-url"};
+
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> routeUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta>
+      staticRoutesUpdatesQueue_;
+
+  fbzmq::Context context_;
+  std::shared_ptr<Config> config_;
+
+  std::unique_ptr<fbzmq::ZmqMonitor> zmqMonitor_;
+  std::thread zmqMonitorThread_;
+  std::unique_ptr<PersistentStore> persistentStore_;
+  std::thread persistentStoreThread_;
+  std::unique_ptr<KvStoreWrapper> kvStoreWrapper_;
+  std::unique_ptr<Decision> decision_;
+  std::thread decisionThread_;
+  std::unique_ptr<Fib> fib_;
+  std::thread fibThread_;
+  std::unique_ptr<PrefixManager> prefixManager_;
+  std::thread prefixManagerThread_;
+  std::shared_ptr<MockNetlinkSystemHandler> mockNlHandler_;
+  std::shared_ptr<apache::thrift::ThriftServer> systemServer_;
+  apache::thrift::util::ScopedServerThread systemThriftThread_;
+  std::unique_ptr<LinkMonitor> linkMonitor_;
+  std::thread linkMonitorThread_;
+  std::unique_ptr<OpenrThriftServerWrapper> openrThriftServerWrapper_;
+
+  // clients of stream subscribers, along with their event-base threads
+  std::vector<std::pair<
+      std::unique_ptr<CtrlClient>,
+      std::unique_ptr<folly::ScopedEventBaseThread>>>
+      streamClients_;
+  std::vector<std::function<void()>> cancelSubscriptions_;
+
+  std::atomic<bool> stopped_{false};
+  std::atomic<int64_t> adjVersion_{0};
+  std::atomic<int64_t> adjUpdateTimeUs_{0};
+
+  LatencyRecorder recorder_;
+};
+
+} // namespace
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  openr::OpenrCtrlLoadTest loadTest;
+  loadTest.run();
+  return 0;
+}
@@ -0,0 +1,457 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Fabric-scale emulation of Open/R. Runs `num_nodes` in-process OpenrWrapper
+ * instances connected through MockIoProvider in a Clos, grid or random
+ * topology, and reports percentiles of per-node convergence time, as well as
+ * CPU time and memory per node, for
+ *
+ *  1). initial convergence: all nodes learn routes to loopback prefixes of
+ *      all other nodes;
+ *  2). failure: `num_failures` nodes are stopped at once and all surviving
+ *      nodes withdraw routes to their loopback prefixes.
+ *
+ * Every node runs threads of all its modules, hence number of threads grows
+ * with number of nodes. Nodes are started and stopped on a thread pool.
+ */
+
+#include "MockSystemHandler.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <set>
+#include <unordered_set>
+
+#include <fbzmq/service/monitor/SystemMetrics.h>
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Format.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <thrift/lib/cpp2/server/ThriftServer.h>
+#include <thrift/lib/cpp2/util/ScopedServerThread.h>
+
+#include <openr/common/Util.h>
+#include <openr/spark/tests/MockIoProvider.h>
+#include <openr/tests/OpenrWrapper.h>
+
+DEFINE_string(topology, "clos", "Topology to emulate: clos, grid or random");
+DEFINE_int32(num_nodes, 100, "Number of Open/R nodes");
+DEFINE_int32(num_spines, 4, "Clos: number of spines, connected to all leaves");
+DEFINE_int32(random_degree, 4, "Random: number of links per node");
+DEFINE_int32(link_latency_ms, 1, "Latency of every link");
+DEFINE_int32(num_failures, 1, "Number of nodes failed after convergence");
+DEFINE_int32(setup_threads, 16, "Threads starting and stopping nodes");
+DEFINE_int32(poll_interval_ms, 100, "Interval of polling FIB of nodes");
+DEFINE_int32(convergence_timeout_s, 300, "Max time to wait for convergence");
+DEFINE_int32(mem_limit_mb, 1000000, "Memory limit of watchdog of each node");
+DEFINE_int32(seed, 1, "Seed of random topology and failures");
+
+namespace openr {
+
+namespace {
+
+const std::chrono::seconds kKvStoreDbSyncInterval(1);
+const std::chrono::milliseconds kSpark2HelloTime(100);
+const std::chrono::milliseconds kSpark2FastInitHelloTime(20);
+const std::chrono::milliseconds kSpark2HandshakeTime(20);
+const std::chrono::milliseconds kSpark2HeartbeatTime(20);
+const std::chrono::milliseconds kSpark2HandshakeHoldTime(200);
+const std::chrono::milliseconds kSpark2HeartbeatHoldTime(500);
+const std::chrono::milliseconds kSpark2GRHoldTime(1000);
+const std::chrono::seconds kLinkMonitorAdjHoldTime(1);
+const std::chrono::milliseconds kLinkFlapInitialBackoff(1);
+const std::chrono::milliseconds kLinkFlapMaxBackoff(8);
+const std::chrono::seconds kFibColdStartDuration(1);
+
+using Links = std::vector<std::pair<size_t, size_t>>;
+
+std::string
+getNodeName(size_t node) {
+  return folly::sformat("node-{}", node);
+}
+
+std::string
+getIfName(size_t node, size_t otherNode) {
+  return folly::sformat("if_{}_{}", node, otherNode);
+}
+
+// loopback prefix advertised by the node
+std::string
+getLoopbackPrefix(size_t node) {
+  return folly::sformat("fc00:{:x}:{:x}::/64", node >> 16, node & 0xffff);
+}
+
+// First `numSpines` nodes are spines, connected to all other nodes (leaves)
+Links
+createClosLinks(size_t numNodes, size_t numSpines) {
+  CHECK_LT(numSpines, numNodes) << "Clos needs at least one leaf";
+  Links links;
+  for (size_t spine = 0; spine < numSpines; ++spine) {
+    for (size_t leaf = numSpines; leaf < numNodes; ++leaf) {
+      links.emplace_back(spine, leaf);
+    }
+  }
+  return links;
+}
+
+// Square grid, with remaining nodes on an incomplete last row
+Links
+createGridLinks(size_t numNodes) {
+  const size_t n = std::ceil(std::sqrt(numNodes));
+  Links links;
+  for (size_t node = 0; node < numNodes; ++node) {
+    if ((node % n) + 1 < n and node + 1 < numNodes) {
+      links.emplace_back(node, node + 1);
+    }
+    if (node + n < numNodes) {
+      links.emplace_back(node, node + n);
+    }
+  }
+  return links;
+}
+
+// Ring, to keep the topology connected, with random chords up to `degree`
+// links per node on average
+Links
+createRandomLinks(size_t numNodes, size_t degree, std::mt19937& gen) {
+  CHECK_GE(numNodes, 3) << "Random topology needs at least 3 nodes";
+  std::set<std::pair<size_t, size_t>> links;
+  for (size_t node = 0; node < numNodes; ++node) {
+    auto other = (node + 1) % numNodes;
+    links.emplace(std::min(node, other), std::max(node, other));
+  }
+  const size_t numLinks =
+      std::min(numNodes * degree / 2, numNodes * (numNodes - 1) / 2);
+  std::uniform_int_distribution<size_t> dist(0, numNodes - 1);
+  while (links.size() < numLinks) {
+    auto node = dist(gen), other = dist(gen);
+    if (node != other) {
+      links.emplace(std::min(node, other), std::max(node, other));
+    }
+  }
+  return Links(links.begin(), links.end());
+}
+
+// CPU time (user + system) of the whole process
+std::chrono::milliseconds
+getProcessCpuTime() {
+  struct rusage usage {};
+  CHECK_EQ(0, getrusage(RUSAGE_SELF, &usage));
+  auto toMs = [](const struct timeval& tv) {
+    return std::chrono::milliseconds(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+  };
+  return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+}
+
+void
+reportConvergence(
+    const std::string& phase,
+    std::vector<std::optional<std::chrono::milliseconds>> const& times,
+    std::chrono::milliseconds cpuTime,
+    size_t numNodes) {
+  std::vector<int64_t> convergedMs;
+  for (auto const& time : times) {
+    if (time.has_value()) {
+      convergedMs.emplace_back(time->count());
+    }
+  }
+  std::sort(convergedMs.begin(), convergedMs.end());
+  auto percentile = [&](double p) -> int64_t {
+    if (convergedMs.empty()) {
+      return -1;
+    }
+    auto idx = static_cast<size_t>(p * (convergedMs.size() - 1));
+    return convergedMs.at(idx);
+  };
+
+  fbzmq::SystemMetrics systemMetrics;
+  const auto rssBytes = systemMetrics.getRSSMemBytes();
+  LOG(INFO) << folly::sformat(
+      "[{}] converged nodes: {}/{}, convergence time p50: {}ms, p90: {}ms, "
+      "p99: {}ms, max: {}ms, cpu time per node: {}ms, rss per node: {}KB",
+      phase,
+      convergedMs.size(),
+      times.size(),
+      percentile(0.5),
+      percentile(0.9),
+      percentile(0.99),
+      percentile(1),
+      cpuTime.count() / numNodes,
+      rssBytes.has_value() ? rssBytes.value() / numNodes / 1000 : -1);
+}
+
+} // namespace
+
+/**
+ * Emulated fabric owning all the nodes, and the MockIoProvider and system
+ * service shared by them
+ */
+class ScaleEmulation {
+ public:
+  ScaleEmulation(size_t numNodes, Links links)
+      : numNodes_(numNodes),
+        links_(std::move(links)),
+        executor_(FLAGS_setup_threads) {
+    mockIoProvider_ = std::make_shared<MockIoProvider>();
+    mockIoProviderThread_ = std::thread([this]() { mockIoProvider_->start(); });
+    mockIoProvider_->waitUntilRunning();
+
+    server_ = std::make_shared<apache::thrift::ThriftServer>();
+    server_->setNumIOWorkerThreads(1);
+    server_->setNumAcceptThreads(1);
+    server_->setPort(0);
+    server_->setInterface(std::make_shared<MockSystemHandler>());
+    systemThriftThread_.start(server_);
+
+    // wire interfaces of all links
+    IfNameAndifIndex ifIndexes;
+    ConnectedIfPairs connectedPairs;
+    interfaces_.resize(numNodes_);
+    for (auto const& [node, otherNode] : links_) {
+      for (auto [a, b] : {std::make_pair(node, otherNode),
+                          std::make_pair(otherNode, node)}) {
+        const auto ifName = getIfName(a, b);
+        const int ifIndex = ifIndexes.size() + 1;
+        ifIndexes.emplace_back(ifName, ifIndex);
+        connectedPairs[ifName].emplace_back(
+            getIfName(b, a), FLAGS_link_latency_ms);
+        interfaces_.at(a).push_back(
+            {ifName,
+             ifIndex,
+             folly::IPAddress::createNetwork(folly::sformat(
+                 "10.{}.{}.1/32", (a >> 8) & 0xff, a & 0xff)),
+             folly::IPAddress::createNetwork(
+                 folly::sformat("fe80::{:x}/128", a + 1))});
+      }
+    }
+    mockIoProvider_->addIfNameIfIndex(ifIndexes);
+    mockIoProvider_->setConnectedPairs(connectedPairs);
+
+    const int32_t systemPort = systemThriftThread_.getAddress()->getPort();
+    for (size_t node = 0; node < numNodes_; ++node) {
+      nodes_.emplace_back(
+          std::make_unique<OpenrWrapper<apache::thrift::CompactSerializer>>(
+              context_,
+              getNodeName(node),
+              false /* v4Enabled */,
+              kKvStoreDbSyncInterval,
+              kSpark2HelloTime,
+              kSpark2FastInitHelloTime,
+              kSpark2HandshakeTime,
+              kSpark2HeartbeatTime,
+              kSpark2HandshakeHoldTime,
+              kSpark2HeartbeatHoldTime,
+              kSpark2GRHoldTime,
+              kLinkMonitorAdjHoldTime,
+              kLinkFlapInitialBackoff,
+              kLinkFlapMaxBackoff,
+              kFibColdStartDuration,
+              mockIoProvider_,
+              systemPort,
+              FLAGS_mem_limit_mb));
+    }
+  }
+
+  ~ScaleEmulation() {
+    forEachNode(allNodes(), [](auto& node) { node.stop(); });
+    nodes_.clear();
+    mockIoProvider_->stop();
+    mockIoProviderThread_.join();
+    systemThriftThread_.stop();
+  }
+
+  std::vector<size_t>
+  allNodes() const {
+    std::vector<size_t> nodes(numNodes_);
+    std::iota(nodes.begin(), nodes.end(), 0);
+    return nodes;
+  }
+
+  // start all nodes, then bring up their interfaces and advertise loopbacks
+  void
+  start() {
+    forEachNode(allNodes(), [](auto& node) { node.run(); });
+    for (size_t node = 0; node < numNodes_; ++node) {
+      nodes_.at(node)->sparkUpdateInterfaceDb(interfaces_.at(node));
+      nodes_.at(node)->addPrefixEntries(
+          {createPrefixEntry(toIpPrefix(getLoopbackPrefix(node)))});
+    }
+  }
+
+  void
+  stopNodes(std::vector<size_t> const& nodes) {
+    forEachNode(nodes, [](auto& node) { node.stop(); });
+  }
+
+  // Wait until FIB of every given node has routes to all `present` prefixes
+  // and none of `absent` ones. Returns time of convergence of each node,
+  // counted from now, or none if it didn't converge before timeout
+  std::vector<std::optional<std::chrono::milliseconds>>
+  waitForConvergence(
+      std::vector<size_t> const& nodes,
+      std::function<std::vector<std::string>(size_t)> const& present,
+      std::vector<std::string> const& absent) {
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto deadline =
+        startTime + std::chrono::seconds(FLAGS_convergence_timeout_s);
+    std::vector<std::optional<std::chrono::milliseconds>> times(nodes.size());
+    size_t numConverged{0};
+    while (numConverged < nodes.size() and
+           std::chrono::steady_clock::now() < deadline) {
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        if (times.at(i).has_value()) {
+          continue;
+        }
+        const auto routeDb = nodes_.at(nodes.at(i))->fibDumpRouteDatabase();
+        std::unordered_set<std::string> dests;
+        for (auto const& route : routeDb.unicastRoutes) {
+          dests.emplace(toString(route.dest));
+        }
+        auto isPresent = [&](auto const& prefix) {
+          return dests.count(prefix) > 0;
+        };
+        const auto presentPrefixes = present(nodes.at(i));
+        if (std::all_of(
+                presentPrefixes.begin(), presentPrefixes.end(), isPresent) and
+            std::none_of(absent.begin(), absent.end(), isPresent)) {
+          times.at(i) = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - startTime);
+          ++numConverged;
+        }
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_poll_interval_ms));
+    }
+    return times;
+  }
+
+ private:
+  // run `fn` on given nodes in parallel and wait for all of them
+  void
+  forEachNode(
+      std::vector<size_t> const& nodes,
+      std::function<void(OpenrWrapper<apache::thrift::CompactSerializer>&)>
+          fn) {
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    for (auto node : nodes) {
+      futures.emplace_back(
+          folly::via(&executor_, [this, node, &fn]() { fn(*nodes_.at(node)); })
+              .semi());
+    }
+    folly::collect(std::move(futures)).get();
+  }
+
+  const size_t numNodes_;
+  const Links links_;
+  folly::CPUThreadPoolExecutor executor_;
+
+  fbzmq::Context context_;
+  std::shared_ptr<MockIoProvider> mockIoProvider_{nullptr};
+  std::thread mockIoProviderThread_;
+  std::shared_ptr<apache::thrift::ThriftServer> server_;
+  apache::thrift::util::ScopedServerThread systemThriftThread_;
+
+  // interfaces of each node
+  std::vector<std::vector<SparkInterfaceEntry>> interfaces_;
+  std::vector<std::unique_ptr<OpenrWrapper<apache::thrift::CompactSerializer>>>
+      nodes_;
+};
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  using namespace openr;
+
+  const size_t numNodes = FLAGS_num_nodes;
+  std::mt19937 gen(FLAGS_seed);
+  Links links;
+  if (FLAGS_topology == "clos") {
+    links = createClosLinks(numNodes, FLAGS_num_spines);
+  } else if (FLAGS_topology == "grid") {
+    links = createGridLinks(numNodes);
+  } else if (FLAGS_topology == "random") {
+    links = createRandomLinks(numNodes, FLAGS_random_degree, gen);
+  } else {
+    LOG(FATAL) << "Unknown topology: " << FLAGS_topology;
+  }
+  LOG(INFO) << folly::sformat(
+      "Emulating {} topology of {} nodes and {} links",
+      FLAGS_topology,
+      numNodes,
+      links.size());
+
+  ScaleEmulation emulation(numNodes, links);
+
+  // initial convergence
+  auto cpuTime = getProcessCpuTime();
+  emulation.start();
+  auto allPrefixes = [numNodes](size_t node) {
+    std::vector<std::string> prefixes;
+    for (size_t other = 0; other < numNodes; ++other) {
+      if (other != node) {
+        prefixes.emplace_back(getLoopbackPrefix(other));
+      }
+    }
+    return prefixes;
+  };
+  auto times = emulation.waitForConvergence(
+      emulation.allNodes(), allPrefixes, {} /* absent */);
+  reportConvergence(
+      "initial", times, getProcessCpuTime() - cpuTime, numNodes);
+
+  // failure of random nodes, leaving spines of clos intact
+  const size_t firstFailNode =
+      FLAGS_topology == "clos" ? FLAGS_num_spines : 0;
+  auto candidates = emulation.allNodes();
+  candidates.erase(candidates.begin(), candidates.begin() + firstFailNode);
+  std::shuffle(candidates.begin(), candidates.end(), gen);
+  candidates.resize(std::min<size_t>(FLAGS_num_failures, candidates.size()));
+  if (candidates.empty()) {
+    return 0;
+  }
+  const std::set<size_t> failedNodes(candidates.begin(), candidates.end());
+  std::vector<std::string> failedPrefixes;
+  std::vector<size_t> survivingNodes;
+  for (auto node : emulation.allNodes()) {
+    if (failedNodes.count(node)) {
+      failedPrefixes.emplace_back(getLoopbackPrefix(node));
+    } else {
+      survivingNodes.emplace_back(node);
+    }
+  }
+
+  cpuTime = getProcessCpuTime();
+  emulation.stopNodes(candidates);
+  auto survivingPrefixes = [&](size_t node) {
+    std::vector<std::string> prefixes;
+    for (auto other : survivingNodes) {
+      if (other != node) {
+        prefixes.emplace_back(getLoopbackPrefix(other));
+      }
+    }
+    return prefixes;
+  };
+  times = emulation.waitForConvergence(
+      survivingNodes, survivingPrefixes, failedPrefixes);
+  reportConvergence(
+      folly::sformat("failure of {} nodes", failedNodes.size()),
+      times,
+      getProcessCpuTime() - cpuTime,
+      survivingNodes.size());
+  return 0;
+}
@@ -212,6 +212,7 @@ OpenrWrapper<Serializer>::OpenrWrapper(
       kvStoreUpdatesQueue_.getReader(),
       staticRoutesQueue_.getReader(),
       routeUpdatesQueue_,
+      decisionDbsUpdatesQueue_,
       context_);
 
   //
@@ -223,6 +224,7 @@ OpenrWrapper<Serializer>::OpenrWrapper(
       fibColdStartDuration,
       routeUpdatesQueue_.getReader(),
       interfaceUpdatesQueue_.getReader(),
+      fibUpdatesQueue_,
       MonitorSubmitUrl{monitorSubmitUrl_},
       kvStore_.get(),
       context_);
@@ -368,6 +370,11 @@ OpenrWrapper<Serializer>::run() {
 template <class Serializer>
 void
 OpenrWrapper<Serializer>::stop() {
+  if (stopped_) {
+    return;
+  }
+  stopped_ = true;
+
   // Close all queues
   routeUpdatesQueue_.close();
   peerUpdatesQueue_.close();
@@ -376,6 +383,8 @@ OpenrWrapper<Serializer>::stop() {
   prefixUpdatesQueue_.close();
   kvStoreUpdatesQueue_.close();
   staticRoutesQueue_.close();
+  fibUpdatesQueue_.close();
+  decisionDbsUpdatesQueue_.close();
 
   // stop all modules in reverse order
   eventBase_.stop();
@@ -452,7 +461,11 @@ bool
 OpenrWrapper<Serializer>::sparkUpdateInterfaceDb(
     const std::vector<SparkInterfaceEntry>& interfaceEntries) {
   thrift::InterfaceDatabase ifDb(
-      apache::thrift::FRAGILE, nodeId_, {}, thrift::PerfEvents());
+      apache::thrift::FRAGILE,
+      nodeId_,
+      {},
+      thrift::PerfEvents(),
+      false /* isDelta */);
   ifDb.perfEvents_ref().reset();
 
   for (const auto& interface : interfaceEntries) {
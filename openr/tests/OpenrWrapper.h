@@ -70,7 +70,7 @@ class OpenrWrapper {
   // start openr
   void run();
 
-  // stop openr
+  // stop openr, no-op if already stopped
   void stop();
 
   /**
@@ -163,8 +163,10 @@ class OpenrWrapper {
   messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
   messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue_;
+  messaging::ReplicateQueue<KvStorePublication> kvStoreUpdatesQueue_;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesQueue_;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue_;
+  messaging::ReplicateQueue<thrift::DecisionDbsDelta> decisionDbsUpdatesQueue_;
 
   // socket to publish platform events
   fbzmq::Socket<ZMQ_PUB, fbzmq::ZMQ_SERVER> platformPubSock_;
@@ -173,6 +175,9 @@ class OpenrWrapper {
 
   // create prefix keys for each prefix separately
   bool per_prefix_keys_{false};
+
+  // whether stop() was called already
+  bool stopped_{false};
 };
 
 } // namespace openr
@@ -7,9 +7,51 @@
 
 #include "Watchdog.h"
 
+#include <signal.h>
+
+#include <mutex>
+
+#include <fb303/ServiceData.h>
+#include <folly/experimental/symbolizer/Symbolizer.h>
+
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryAccounting.h>
 #include <openr/common/Util.h>
 
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+// number of largest module structures logged on critical memory usage
+const size_t kNumTopMemoryConsumers{10};
+
+// signal sent to a stalled module thread to log its stack
+const int kStackDumpSignal = SIGUSR2;
+
+// created before the signal handler is installed, as the handler can't
+// allocate
+std::unique_ptr<folly::symbolizer::SafeStackTracePrinter> stackPrinter;
+
+void
+stackDumpSignalHandler(int /* signum */) {
+  stackPrinter->printStackTrace(true /* symbolize */);
+}
+
+void
+installStackDumpSignalHandler() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    stackPrinter = std::make_unique<folly::symbolizer::SafeStackTracePrinter>();
+    struct sigaction sa {};
+    sa.sa_handler = stackDumpSignalHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    PCHECK(sigaction(kStackDumpSignal, &sa, nullptr) == 0);
+  });
+}
+
+} // namespace
+
 namespace openr {
 
 Watchdog::Watchdog(std::shared_ptr<const Config> config)
@@ -18,6 +60,12 @@ Watchdog::Watchdog(std::shared_ptr<const Config> config)
       threadTimeout_(config->getWatchdogConfig().thread_timeout_s),
       maxMemoryMB_(config->getWatchdogConfig().max_memory_mb),
       previousStatus_(true) {
+  if (auto thresholdMs =
+          config->getWatchdogConfig().stall_threshold_ms_ref()) {
+    stallThreshold_ = std::chrono::milliseconds(*thresholdMs);
+    installStackDumpSignalHandler();
+  }
+
   // Schedule periodic timer for checking thread health
   watchdogTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     updateCounters();
@@ -26,6 +74,13 @@ Watchdog::Watchdog(std::shared_ptr<const Config> config)
     watchdogTimer_->scheduleTimeout(interval_);
   });
   watchdogTimer_->scheduleTimeout(interval_);
+
+  // Schedule periodic timer for probing event-loop lag
+  lagProbeTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
+    probeEvbs();
+    lagProbeTimer_->scheduleTimeout(Constants::kEvbLagProbeInterval);
+  });
+  lagProbeTimer_->scheduleTimeout(Constants::kEvbLagProbeInterval);
 }
 
 void
@@ -34,6 +89,13 @@ Watchdog::addEvb(OpenrEventBase* evb, const std::string& name) {
   getEvb()->runInEventBaseThreadAndWait([this, evb, name]() {
     CHECK_EQ(monitorEvbs_.count(evb), 0);
     monitorEvbs_.emplace(evb, name);
+    lagProbes_.emplace(evb, std::make_shared<EvbLagProbe>(name));
+
+    const auto counter = folly::sformat("watchdog.evb_lag_ms.{}", name);
+    fb303::fbData->addHistogram(counter, 10, 0, 10000);
+    fb303::fbData->exportHistogramPercentile(counter, 50, 99, 100);
+    fb303::fbData->addStatExportType(
+        folly::sformat("watchdog.evb_stalls.{}", name), fb303::COUNT);
   });
 }
 
@@ -47,6 +109,8 @@ Watchdog::memoryLimitExceeded() {
 
 void
 Watchdog::monitorMemory() {
+  updateModuleArenaCounters();
+
   auto memInUse_ = systemMetrics_.getRSSMemBytes();
   if (not memInUse_.has_value()) {
     return;
@@ -56,6 +120,7 @@ Watchdog::monitorMemory() {
                  << " Memory limit:" << maxMemoryMB_ << " MB";
     if (not memExceedTime_.has_value()) {
       memExceedTime_ = std::chrono::steady_clock::now();
+      logTopMemoryConsumers();
       return;
     }
     // check for sustained critical memory usage
@@ -67,6 +132,7 @@ Watchdog::monitorMemory() {
           " Mem Limit:{}",
           memInUse_.value(),
           maxMemoryMB_);
+      logTopMemoryConsumers();
       fireCrash(msg);
     }
     return;
@@ -76,6 +142,14 @@ Watchdog::monitorMemory() {
   }
 }
 
+void
+Watchdog::logTopMemoryConsumers() {
+  for (auto const& [name, bytes] :
+       getTopMemoryConsumers(kNumTopMemoryConsumers)) {
+    LOG(WARNING) << "Memory consumer " << name << ": " << bytes << " bytes";
+  }
+}
+
 void
 Watchdog::updateCounters() {
   VLOG(2) << "Checking thread aliveness counters...";
@@ -118,6 +192,73 @@ Watchdog::updateCounters() {
   previousStatus_ = stuckThreads.size() == 0;
 }
 
+void
+Watchdog::probeEvbs() {
+  const auto now = std::chrono::steady_clock::now();
+  for (auto& [evb, probe] : lagProbes_) {
+    if (probe->pending.load()) {
+      // previous probe hasn't run yet, module's loop is blocked since
+      const auto lag = std::chrono::duration_cast<std::chrono::milliseconds>(
+          now -
+          std::chrono::steady_clock::time_point(
+              std::chrono::steady_clock::duration(probe->sentAt.load())));
+      if (stallThreshold_ and lag > *stallThreshold_ and
+          not probe->stallReported.exchange(true)) {
+        reportStall(*probe, lag);
+      }
+      continue;
+    }
+
+    probe->sentAt.store(now.time_since_epoch().count());
+    probe->stallReported.store(false);
+    probe->pending.store(true);
+    evb->getEvb()->runInEventBaseThread(
+        [probe = probe, stallThreshold = stallThreshold_]() noexcept {
+          const auto lag =
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch() -
+                  std::chrono::steady_clock::duration(probe->sentAt.load()));
+          if (not probe->hasThread.load()) {
+            probe->thread.store(pthread_self());
+            probe->hasThread.store(true);
+          }
+          fb303::fbData->addHistogramValue(
+              folly::sformat("watchdog.evb_lag_ms.{}", probe->name),
+              lag.count());
+          if (stallThreshold and lag > *stallThreshold and
+              not probe->stallReported.load()) {
+            // stall ended within a probe interval, stack is gone already
+            LOG(WARNING) << "Watchdog: " << probe->name
+                         << " event loop stalled for " << lag.count() << "ms";
+            fb303::fbData->addStatValue(
+                folly::sformat("watchdog.evb_stalls.{}", probe->name),
+                1,
+                fb303::COUNT);
+          }
+          probe->pending.store(false);
+        });
+  }
+}
+
+void
+Watchdog::reportStall(EvbLagProbe& probe, std::chrono::milliseconds lag) {
+  LOG(WARNING) << "Watchdog: " << probe.name << " event loop stalled for "
+               << lag.count() << "ms and counting, threshold "
+               << stallThreshold_->count() << "ms";
+  fb303::fbData->addStatValue(
+      folly::sformat("watchdog.evb_stalls.{}", probe.name), 1, fb303::COUNT);
+  if (not probe.hasThread.load()) {
+    return;
+  }
+  // interrupt module thread to log the stack it is stuck in
+  LOG(WARNING) << "Watchdog: Stack of " << probe.name << " thread follows";
+  const auto err = pthread_kill(probe.thread.load(), kStackDumpSignal);
+  if (err != 0) {
+    LOG(ERROR) << "Watchdog: Failed to signal " << probe.name
+               << " thread: " << folly::errnoStr(err);
+  }
+}
+
 void
 Watchdog::fireCrash(const std::string& msg) {
   SYSLOG(ERROR) << msg;
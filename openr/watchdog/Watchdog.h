@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <pthread.h>
+
+#include <atomic>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -36,9 +39,39 @@ class Watchdog final : public OpenrEventBase {
  private:
   void updateCounters();
 
+  /**
+   * State of the event-loop lag probe of a monitored module. Shared with the
+   * probe callback running in the module thread.
+   */
+  struct EvbLagProbe {
+    explicit EvbLagProbe(const std::string& name) : name(name) {}
+
+    const std::string name;
+
+    // steady clock time the in-flight probe was scheduled at
+    std::atomic<std::chrono::steady_clock::duration::rep> sentAt{0};
+    std::atomic<bool> pending{false};
+
+    // set once the stall of the in-flight probe has been reported
+    std::atomic<bool> stallReported{false};
+
+    // module thread, learnt from the first probe run
+    std::atomic<pthread_t> thread{};
+    std::atomic<bool> hasThread{false};
+  };
+
+  // schedule lag probes into monitored modules, report stalled ones
+  void probeEvbs();
+
+  // report module whose event loop is lagging by more than stall threshold
+  void reportStall(EvbLagProbe& probe, std::chrono::milliseconds lag);
+
   // monitor memory usage
   void monitorMemory();
 
+  // log module structures reported to hold the most memory
+  void logTopMemoryConsumers();
+
   void fireCrash(const std::string& msg);
 
   const std::string myNodeName_;
@@ -49,6 +82,13 @@ class Watchdog final : public OpenrEventBase {
   // mapping of thread name to eventloop pointer
   std::unordered_map<OpenrEventBase*, std::string> monitorEvbs_;
 
+  // Timer for probing event-loop lag of monitored modules
+  std::unique_ptr<folly::AsyncTimeout> lagProbeTimer_{nullptr};
+
+  // lag probe of every monitored module
+  std::unordered_map<OpenrEventBase*, std::shared_ptr<EvbLagProbe>>
+      lagProbes_;
+
   // thread healthcheck interval
   std::chrono::seconds interval_;
 
@@ -58,6 +98,9 @@ class Watchdog final : public OpenrEventBase {
   // critcal memory threhsold
   uint32_t maxMemoryMB_{0};
 
+  // soft event-loop lag threshold for logging stack of the module thread
+  std::optional<std::chrono::milliseconds> stallThreshold_;
+
   // boolean to indicate previous failure
   bool previousStatus_{true};
 